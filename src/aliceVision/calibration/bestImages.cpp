@@ -6,6 +6,7 @@
 
 #include "bestImages.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <limits>
 #include <numeric>
@@ -23,11 +24,16 @@ void precomputeCellIndexes(const std::vector<std::vector<cv::Point2f> >& imagePo
   float cellWidth = float(imageSize.width) / float(calibGridSize);
   float cellHeight = float(imageSize.height) / float(calibGridSize);
 
-  for (const auto& pointbuf : imagePoints)
+  const std::size_t firstImage = cellIndexesPerImage.size();
+  cellIndexesPerImage.resize(firstImage + imagePoints.size());
+
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(imagePoints.size()); ++i)
   {
-    std::vector<std::size_t> imageCellIndexes;
+    std::vector<std::size_t>& imageCellIndexes = cellIndexesPerImage[firstImage + i];
+    imageCellIndexes.reserve(imagePoints[i].size());
     // Points repartition in image
-    for (cv::Point2f point : pointbuf)
+    for (cv::Point2f point : imagePoints[i])
     {
       // Compute the index of the point
       std::size_t cellPointX = std::floor(point.x / cellWidth);
@@ -35,7 +41,6 @@ void precomputeCellIndexes(const std::vector<std::vector<cv::Point2f> >& imagePo
       std::size_t cellIndex = cellPointY * calibGridSize + cellPointX;
       imageCellIndexes.push_back(cellIndex);
     }
-    cellIndexesPerImage.push_back(imageCellIndexes);
   }
 }
 
@@ -68,8 +73,12 @@ void computeImageScores(const std::vector<std::size_t>& inputImagesIndexes,
                         const std::map<std::size_t, std::size_t>& cellsWeight,
                         std::vector<std::pair<float, std::size_t> >& imageScores)
 {
+  const std::size_t firstScore = imageScores.size();
+  imageScores.resize(firstScore + inputImagesIndexes.size());
+
   // Compute the score of each image
-  for (std::size_t i = 0; i < inputImagesIndexes.size(); ++i)
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(inputImagesIndexes.size()); ++i)
   {
     const std::vector<std::size_t>& imageCellIndexes = cellIndexesPerImage[inputImagesIndexes[i]];
     float imageScore = 0;
@@ -80,7 +89,7 @@ void computeImageScores(const std::vector<std::size_t>& inputImagesIndexes,
     // Normalize by the number of checker items.
     // If the detector support occlusions of the checker the number of items may vary.
     imageScore /= float(imageCellIndexes.size());
-    imageScores.emplace_back(imageScore, inputImagesIndexes[i]);
+    imageScores[firstScore + i] = std::make_pair(imageScore, inputImagesIndexes[i]);
   }
 }
 
@@ -20,7 +20,10 @@
 #endif
 
 #include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <ctime>
 #include <cctype>
@@ -30,6 +33,9 @@
 namespace aliceVision{
 namespace calibration{
 
+/// maximum size (width or height) of the image used to detect the chessboard corners
+#define ALICEVISION_CHESSBOARD_DETECTION_MAX_SIZE 1280.0
+
 std::istream& operator>>(std::istream &stream, Pattern &pattern)
 {
   std::string token;
@@ -87,8 +93,26 @@ bool findPattern(const Pattern& pattern, const cv::Mat& viewGray, const cv::Size
     {
       startCh = std::clock();
 
-      found = cv::findChessboardCorners(viewGray, boardSize, pointbuf,
-                                        cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
+      // the corners are detected on a downscaled image and refined at full resolution
+      const double scale = std::min(1.0, ALICEVISION_CHESSBOARD_DETECTION_MAX_SIZE / double(std::max(viewGray.cols, viewGray.rows)));
+      if(scale < 1.0)
+      {
+        cv::Mat viewGrayDownscaled;
+        cv::resize(viewGray, viewGrayDownscaled, cv::Size(), scale, scale, cv::INTER_AREA);
+        found = cv::findChessboardCorners(viewGrayDownscaled, boardSize, pointbuf,
+                                          cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
+        // corners in the full resolution image (pixel centers)
+        for(cv::Point2f& point : pointbuf)
+        {
+          point.x = (point.x + 0.5f) / scale - 0.5f;
+          point.y = (point.y + 0.5f) / scale - 0.5f;
+        }
+      }
+      else
+      {
+        found = cv::findChessboardCorners(viewGray, boardSize, pointbuf,
+                                          cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
+      }
       durationCh = (std::clock() - startCh) / (double) CLOCKS_PER_SEC;
       ALICEVISION_LOG_DEBUG("Find chessboard corners' duration: " << durationCh);
 
@@ -96,7 +120,9 @@ bool findPattern(const Pattern& pattern, const cv::Mat& viewGray, const cv::Size
       if (found)
       {
         startCh = std::clock();
-        cv::cornerSubPix(viewGray, pointbuf, cv::Size(11, 11), cv::Size(-1, -1),
+        // the search window covers the downscaling error
+        const int halfWindow = std::max(11, static_cast<int>(std::ceil(2.0 / scale)));
+        cv::cornerSubPix(viewGray, pointbuf, cv::Size(halfWindow, halfWindow), cv::Size(-1, -1),
                          cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER, 30, 0.1));
 
         durationCh = (std::clock() - startCh) / (double) CLOCKS_PER_SEC;
@@ -92,13 +92,9 @@ struct IntrinsicBase
   Mat2X residuals(const geometry::Pose3 & pose, const Mat3X & X, const Mat2X & x) const
   {
     assert(X.cols() == x.cols());
-    const std::size_t numPts = x.cols();
-    Mat2X residuals = Mat2X::Zero(2, numPts);
-    for(std::size_t i = 0; i < numPts; ++i)
-    {
-      residuals.col(i) = residual(pose, X.col(i), x.col(i));
-    }
-    return residuals;
+    Mat2X proj;
+    this->projectPoints(pose, X, proj);
+    return x - proj;
   }
 
   // --
@@ -138,6 +134,22 @@ struct IntrinsicBase
   /// Return the distorted pixel (with added distortion)
   virtual Vec2 get_d_pixel(const Vec2& p) const = 0;
 
+  /// Projection of 3D points into the camera plane (batch version of project, one point per column)
+  virtual void projectPoints(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion = true) const
+  {
+    out_pts2D.resize(2, pts3D.cols());
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+      out_pts2D.col(i) = project(pose, pts3D.col(i), applyDistortion);
+  }
+
+  /// Return the un-distorted pixels (batch version of get_ud_pixel, one point per column)
+  virtual void get_ud_pixels(const Mat2X& pts, Mat2X& out_pts) const
+  {
+    out_pts.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out_pts.col(i) = get_ud_pixel(pts.col(i));
+  }
+
   /// Normalize a given unit pixel error to the camera plane
   virtual double imagePlane_toCameraPlaneError(double value) const = 0;
 
@@ -174,6 +186,41 @@ struct IntrinsicBase
     _locked  = false;
   }
 
+protected:
+  /**
+   * @brief Implementation of projectPoints for the camera model Camera,
+   *        the members of Camera are called without virtual dispatch
+   */
+  template <class Camera>
+  static void projectPointsT(const Camera& camera, const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion)
+  {
+    const Mat3X X = pose(pts3D);
+    const bool disto = applyDistortion && camera.Camera::have_disto();
+    out_pts2D.resize(2, X.cols());
+    for(Mat3X::Index i = 0; i < X.cols(); ++i)
+    {
+      const Vec2 p = X.col(i).head<2>() / X(2, i);
+      out_pts2D.col(i) = camera.Camera::cam2ima(disto ? camera.Camera::add_disto(p) : p);
+    }
+  }
+
+  /**
+   * @brief Implementation of get_ud_pixels for the camera model Camera,
+   *        the members of Camera are called without virtual dispatch
+   */
+  template <class Camera>
+  static void get_ud_pixelsT(const Camera& camera, const Mat2X& pts, Mat2X& out_pts)
+  {
+    if(!camera.Camera::have_disto())
+    {
+      out_pts = pts;
+      return;
+    }
+    out_pts.resize(2, pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out_pts.col(i) = camera.Camera::cam2ima(camera.Camera::remove_disto(camera.Camera::ima2cam(pts.col(i))));
+  }
+
 private:
   /// intrinsic lock
   bool _locked = false;
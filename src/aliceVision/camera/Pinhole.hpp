@@ -152,6 +152,18 @@ class Pinhole : public IntrinsicBase
   /// Return the distorted pixel (with added distortion)
   virtual Vec2 get_d_pixel(const Vec2& p) const {return p;}
 
+  /// Projection of 3D points into the camera plane, without virtual dispatch per point
+  virtual void projectPoints(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion = true) const
+  {
+    projectPointsT(*this, pose, pts3D, out_pts2D, applyDistortion);
+  }
+
+  /// Return the un-distorted pixels, without virtual dispatch per point
+  virtual void get_ud_pixels(const Mat2X& pts, Mat2X& out_pts) const
+  {
+    get_ud_pixelsT(*this, pts, out_pts);
+  }
+
 private:
   // Focal & principal point are embed into the calibration matrix K
   Mat3 _K, _Kinv;
@@ -68,6 +68,18 @@ public:
   {
     return cam2ima( add_disto(ima2cam(p)) );
   }
+
+  /// Projection of 3D points into the camera plane, without virtual dispatch per point
+  virtual void projectPoints(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion = true) const
+  {
+    projectPointsT(*this, pose, pts3D, out_pts2D, applyDistortion);
+  }
+
+  /// Return the un-distorted pixels, without virtual dispatch per point
+  virtual void get_ud_pixels(const Mat2X& pts, Mat2X& out_pts) const
+  {
+    get_ud_pixelsT(*this, pts, out_pts);
+  }
 };
 
 } // namespace camera
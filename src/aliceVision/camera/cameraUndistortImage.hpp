@@ -14,12 +14,129 @@
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/camera/IntrinsicBase.hpp>
 #include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/stl/hash.hpp>
 
+#include <list>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace camera {
 
+/// Number of undistortion maps kept by getUndistortionMap
+#define ALICEVISION_UNDISTORTION_MAP_CACHE_SIZE 4
+
+/**
+ * @brief Distorted position of each pixel of the undistorted image,
+ *        for a given camera and image size
+ */
+struct UndistortionMap
+{
+  int width = 0;
+  int height = 0;
+  /// distorted (x, y) coordinates of each undistorted pixel, row major
+  std::vector<float> coords;
+};
+
+/// Compute the undistortion map of a camera for an image size
+inline void computeUndistortionMap(
+  const camera::IntrinsicBase* intrinsicPtr,
+  int width,
+  int height,
+  bool correctPrincipalPoint,
+  UndistortionMap& map)
+{
+  const Vec2 center(width * 0.5, height * 0.5);
+  Vec2 ppCorrection(0.0, 0.0);
+
+  if(correctPrincipalPoint)
+  {
+    if(camera::isPinhole(intrinsicPtr->getType()))
+    {
+      const camera::Pinhole* pinholePtr = dynamic_cast<const camera::Pinhole*>(intrinsicPtr);
+      ppCorrection = pinholePtr->principal_point() - center;
+    }
+  }
+
+  map.width = width;
+  map.height = height;
+  map.coords.resize(2 * static_cast<std::size_t>(width) * height);
+
+  #pragma omp parallel for
+  for (int j = 0; j < height; ++j)
+  {
+    float* coords = &map.coords[2 * static_cast<std::size_t>(j) * width];
+    for (int i = 0; i < width; ++i)
+    {
+      // compute coordinates with distortion
+      const Vec2 disto_pix = intrinsicPtr->get_d_pixel(Vec2(i, j)) + ppCorrection;
+      coords[2 * i] = static_cast<float>(disto_pix(0));
+      coords[2 * i + 1] = static_cast<float>(disto_pix(1));
+    }
+  }
+}
+
+/**
+ * @brief Get the undistortion map of a camera for an image size.
+ *
+ * The maps of the last used cameras (identified by IntrinsicBase::hashValue) are kept and shared
+ * between the threads, as the images of a dataset share a few intrinsics.
+ */
+inline std::shared_ptr<const UndistortionMap> getUndistortionMap(
+  const camera::IntrinsicBase* intrinsicPtr,
+  int width,
+  int height,
+  bool correctPrincipalPoint)
+{
+  using Entry = std::pair<std::size_t, std::shared_ptr<const UndistortionMap>>;
+  static std::mutex mutex;
+  static std::list<Entry> cache; // most recently used first
+
+  std::size_t key = intrinsicPtr->hashValue();
+  stl::hash_combine(key, width);
+  stl::hash_combine(key, height);
+  stl::hash_combine(key, correctPrincipalPoint);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for(auto it = cache.begin(); it != cache.end(); ++it)
+  {
+    if(it->first == key)
+    {
+      cache.splice(cache.begin(), cache, it);
+      return cache.front().second;
+    }
+  }
+
+  std::shared_ptr<UndistortionMap> map = std::make_shared<UndistortionMap>();
+  computeUndistortionMap(intrinsicPtr, width, height, correctPrincipalPoint, *map);
+  cache.emplace_front(key, map);
+  if(cache.size() > ALICEVISION_UNDISTORTION_MAP_CACHE_SIZE)
+    cache.pop_back();
+  return map;
+}
+
+/// Undistort an image with a precomputed undistortion map of the same size
+template <typename T>
+void UndistortImage(
+  const image::Image<T>& imageIn,
+  const UndistortionMap& map,
+  image::Image<T>& image_ud,
+  T fillcolor)
+{
+  image_ud.resize(map.width, map.height, true, fillcolor);
+  const image::Sampler2d<image::SamplerLinear> sampler;
+
+  #pragma omp parallel for
+  for (int j = 0; j < map.height; ++j)
+  {
+    // pick the pixels in the image domain, the others keep the fill color
+    const float* coords = &map.coords[2 * static_cast<std::size_t>(j) * map.width];
+    image::SampleSpan(sampler, imageIn, coords, map.width, &image_ud(j, 0));
+  }
+}
+
 /// Undistort an image according a given camera and its distortion model
 template <typename T>
 void UndistortImage(
@@ -35,34 +152,8 @@ void UndistortImage(
   }
   else // There is distortion
   {
-    const Vec2 center(imageIn.Width() * 0.5, imageIn.Height() * 0.5);
-    Vec2 ppCorrection(0.0, 0.0);
-
-    if(correctPrincipalPoint)
-    {
-      if(camera::isPinhole(intrinsicPtr->getType()))
-      {
-        const camera::Pinhole* pinholePtr = dynamic_cast<const camera::Pinhole*>(intrinsicPtr);
-        ppCorrection = pinholePtr->principal_point() - center;
-      }
-    }
-
-    image_ud.resize(imageIn.Width(), imageIn.Height(), true, fillcolor);
-    const image::Sampler2d<image::SamplerLinear> sampler;
-
-    #pragma omp parallel for
-    for (int j = 0; j < imageIn.Height(); ++j)
-      for (int i = 0; i < imageIn.Width(); ++i)
-      {
-        const Vec2 undisto_pix(i,j);
-
-        // compute coordinates with distortion
-        const Vec2 disto_pix = intrinsicPtr->get_d_pixel(undisto_pix) + ppCorrection;
-
-        // pick pixel if it is in the image domain
-        if ( imageIn.Contains(disto_pix(1), disto_pix(0)) )
-          image_ud( j, i ) = sampler(imageIn, disto_pix(1), disto_pix(0));
-      }
+    const std::shared_ptr<const UndistortionMap> map = getUndistortionMap(intrinsicPtr, imageIn.Width(), imageIn.Height(), correctPrincipalPoint);
+    UndistortImage(imageIn, *map, image_ud, fillcolor);
   }
 }
 
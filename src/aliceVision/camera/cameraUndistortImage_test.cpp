@@ -0,0 +1,60 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/camera/cameraUndistortImage.hpp>
+
+#define BOOST_TEST_MODULE cameraUndistortImage
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+//-----------------
+// Test summary:
+//-----------------
+// - Undistort an image through the cached undistortion map
+// - Assert that each pixel is sampled at its distorted position computed by the camera
+// - Assert that the map is shared by the cameras with the same intrinsics
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraUndistortImage_map)
+{
+  const int width = 120;
+  const int height = 80;
+  const PinholeRadialK3 cam(width, height, 100, 60, 40, -0.2, 0.05, 0.01);
+
+  image::Image<float> image(width, height);
+  for(int j = 0; j < height; ++j)
+    for(int i = 0; i < width; ++i)
+      image(j, i) = static_cast<float>(i * 2 + j * 3);
+
+  image::Image<float> image_ud;
+  UndistortImage(image, &cam, image_ud, -1.f);
+
+  BOOST_CHECK_EQUAL(image_ud.Width(), width);
+  BOOST_CHECK_EQUAL(image_ud.Height(), height);
+
+  int nbSampled = 0;
+  for(int j = 0; j < height; ++j)
+  {
+    for(int i = 0; i < width; ++i)
+    {
+      const Vec2 disto_pix = cam.get_d_pixel(Vec2(i, j));
+      if(disto_pix(0) < 0.5 || disto_pix(1) < 0.5 || disto_pix(0) > width - 1.5 || disto_pix(1) > height - 1.5)
+        continue;
+      // the image is linear: the bilinear sampling is exact
+      BOOST_CHECK_SMALL(image_ud(j, i) - static_cast<float>(disto_pix(0) * 2 + disto_pix(1) * 3), 1e-2f);
+      ++nbSampled;
+    }
+  }
+  BOOST_CHECK(nbSampled > width * height / 2);
+
+  const PinholeRadialK3 sameCam(width, height, 100, 60, 40, -0.2, 0.05, 0.01);
+  BOOST_CHECK(getUndistortionMap(&cam, width, height, false) == getUndistortionMap(&sameCam, width, height, false));
+  BOOST_CHECK(getUndistortionMap(&cam, width, height, false) != getUndistortionMap(&cam, width, height, true));
+}
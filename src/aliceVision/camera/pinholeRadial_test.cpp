@@ -78,3 +78,40 @@ BOOST_AUTO_TEST_CASE(cameraPinholeRadial_disto_undisto_K3) {
     BOOST_CHECK(! (cam.add_disto(ptCamera) == cam.remove_disto(cam.add_disto(ptCamera))) ) ;
   }
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera
+// - Project random 3D points and un-distort random pixels by batch
+// - Assert that the batch results are the per point results
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraPinholeRadial_batch_K3) {
+
+  const PinholeRadialK3 cam(1000, 1000, 1000, 500, 500,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+  const IntrinsicBase& intrinsic = cam;
+
+  const geometry::Pose3 pose(RotationAroundY(0.1), Vec3(0.2, -0.1, -1.0));
+  const int nbPoints = 20;
+  Mat3X pts3D(3, nbPoints);
+  Mat2X ptsImage(2, nbPoints);
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    pts3D.col(i) = Vec3::Random() * 0.5 + Vec3(0.0, 0.0, 2.0);
+    ptsImage.col(i) = (Vec2::Random() * 800./2.) + Vec2(500,500);
+  }
+
+  Mat2X projected;
+  intrinsic.projectPoints(pose, pts3D, projected);
+  Mat2X undistorted;
+  intrinsic.get_ud_pixels(ptsImage, undistorted);
+
+  const double epsilon = 1e-8;
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    EXPECT_MATRIX_NEAR( cam.project(pose, pts3D.col(i)), projected.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.get_ud_pixel(ptsImage.col(i)), undistorted.col(i), epsilon);
+  }
+}
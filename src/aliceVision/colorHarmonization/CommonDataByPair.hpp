@@ -10,6 +10,7 @@
 #include "aliceVision/image/all.hpp"
 #include "dependencies/histogram/histogram.hpp"
 #include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace colorHarmonization {
@@ -62,6 +63,39 @@ public:
     }
   }
 
+  /**
+   * Compute the histograms of the three channels for the masked data, in a single pass over the image
+   *
+   * \param[out] histos Histogram of each channel, 256 bins (one per value, as computeHisto with a [0, 255] histogram of 256 bins)
+   * \param[in] mask Binary image to determine acceptable zones
+   * \param[in] image RGB image
+   *
+   */
+  static void computeHistoRGB(
+    std::vector< size_t > (&histos)[3],
+    const image::Image< unsigned char >& mask,
+    const image::Image< image::RGBColor >& image )
+  {
+    for(int c = 0; c < 3; ++c)
+      histos[c].assign(256, 0);
+
+    const int width = mask.Width();
+    for(int j = 0; j < mask.Height(); ++j)
+    {
+      const unsigned char* maskRow = mask.data() + j * width;
+      const image::RGBColor* imageRow = image.data() + j * image.Width();
+      for(int i = 0; i < width; ++i)
+      {
+        if(maskRow[i] != 0)
+        {
+          ++histos[0][imageRow[i].r()];
+          ++histos[1][imageRow[i].g()];
+          ++histos[2][imageRow[i].b()];
+        }
+      }
+    }
+  }
+
   const std::string & getLeftImage()const{ return _sLeftImage; }
   const std::string & getRightImage()const{ return _sRightImage; }
 
@@ -68,12 +68,17 @@ void Encode_histo_relation(
   size_t rowPos = 0;
   double incrementPourcentile = 1./(double) nbQuantile;
 
+  // the sparse matrix is built at once from its coefficients (5 per row)
+  std::vector< Eigen::Triplet<double> > coefficients;
+  coefficients.reserve(Nconstraint * 5);
+  std::vector<double> ndf_I, ndf_J, cdf_I, cdf_J;
+  std::vector<double> vec_pourcentilePositionI, vec_pourcentilePositionJ;
+  vec_pourcentilePositionI.reserve(nbQuantile + 1);
+  vec_pourcentilePositionJ.reserve(nbQuantile + 1);
+
   for (size_t i = 0; i < Nrelative; ++i)
   {
-    std::vector<relativeColorHistogramEdge>::const_iterator iter = vec_relativeHistograms.begin();
-    std::advance(iter, i);
-
-    const relativeColorHistogramEdge & edge = *iter;
+    const relativeColorHistogramEdge & edge = vec_relativeHistograms[i];
 
     //-- compute the two cumulated and normalized histogram
 
@@ -83,21 +88,20 @@ void Encode_histo_relation(
     const size_t nBuckets = vec_histoI.size();
 
     // Normalize histogram
-    std::vector<double> ndf_I(nBuckets), ndf_J(nBuckets);
+    ndf_I.assign(nBuckets, 0.0);
+    ndf_J.assign(nBuckets, 0.0);
     histogram::normalizeHisto(vec_histoI, ndf_I);
     histogram::normalizeHisto(vec_histoJ, ndf_J);
 
     // Compute cumulative distribution functions (cdf)
-    std::vector<double> cdf_I(nBuckets), cdf_J(nBuckets);
     histogram::cdf(ndf_I, cdf_I);
     histogram::cdf(ndf_J, cdf_J);
 
     double currentPourcentile = 5./100.;
 
     //-- Compute pourcentile and their positions
-    std::vector<double> vec_pourcentilePositionI, vec_pourcentilePositionJ;
-    vec_pourcentilePositionI.reserve(1.0/incrementPourcentile);
-    vec_pourcentilePositionJ.reserve(1.0/incrementPourcentile);
+    vec_pourcentilePositionI.clear();
+    vec_pourcentilePositionJ.clear();
 
     std::vector<double>::const_iterator cdf_I_IterBegin = cdf_I.begin();
     std::vector<double>::const_iterator cdf_J_IterBegin = cdf_J.begin();
@@ -121,33 +125,34 @@ void Encode_histo_relation(
 
     for(size_t k = 0; k < vec_pourcentilePositionI.size(); ++k)
     {
-      A.coeffRef(rowPos, GVAR(edge.I)) = vec_pourcentilePositionI[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.I)) = 1.0;
+      coefficients.emplace_back(rowPos, GVAR(edge.I), vec_pourcentilePositionI[k]);
+      coefficients.emplace_back(rowPos, OFFSETVAR(edge.I), 1.0);
 
-      A.coeffRef(rowPos, GVAR(edge.J)) = - vec_pourcentilePositionJ[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.J)) = - 1.0;
+      coefficients.emplace_back(rowPos, GVAR(edge.J), - vec_pourcentilePositionJ[k]);
+      coefficients.emplace_back(rowPos, OFFSETVAR(edge.J), - 1.0);
 
       // - gamma (side change)
-      A.coeffRef(rowPos, GAMMAVAR) = -1;
+      coefficients.emplace_back(rowPos, GAMMAVAR, -1.0);
       // <= gamma
       vec_sign[rowPos] = linearProgramming::LPConstraints::LP_LESS_OR_EQUAL;
       C(rowPos) = 0;
       ++rowPos;
 
-      A.coeffRef(rowPos, GVAR(edge.I)) = vec_pourcentilePositionI[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.I)) = 1.0;
+      coefficients.emplace_back(rowPos, GVAR(edge.I), vec_pourcentilePositionI[k]);
+      coefficients.emplace_back(rowPos, OFFSETVAR(edge.I), 1.0);
 
-      A.coeffRef(rowPos, GVAR(edge.J)) = - vec_pourcentilePositionJ[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.J)) = - 1.0;
+      coefficients.emplace_back(rowPos, GVAR(edge.J), - vec_pourcentilePositionJ[k]);
+      coefficients.emplace_back(rowPos, OFFSETVAR(edge.J), - 1.0);
 
       // + gamma (side change)
-      A.coeffRef(rowPos, GAMMAVAR) = 1;
+      coefficients.emplace_back(rowPos, GAMMAVAR, 1.0);
       // >= - gamma
       vec_sign[rowPos] = linearProgramming::LPConstraints::LP_GREATER_OR_EQUAL;
       C(rowPos) = 0;
       ++rowPos;
     }
   }
+  A.setFromTriplets(coefficients.begin(), coefficients.end());
 #undef GVAR
 #undef OFFSETVAR
 #undef GAMMAVAR
@@ -13,6 +13,7 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/core/eigen.hpp>
 #include <opencv2/highgui.hpp>
+#include <opencv2/videoio.hpp>
 
 #include <iostream>
 #include <exception>
@@ -20,6 +21,29 @@
 namespace aliceVision{
 namespace dataio{
 
+/// maximum number of frames decoded to move forward in the video, a seek is used beyond
+#define ALICEVISION_VIDEOFEED_MAX_GRABBED_FRAMES 64
+
+/**
+ * @brief Open a video file, with the hardware decoding of the FFmpeg backend when OpenCV supports it
+ * @param[in,out] videoCapture the video capture to open
+ * @param[in] videoPath the video file path
+ * @return true if the video is opened
+ */
+static bool openVideo(cv::VideoCapture& videoCapture, const std::string& videoPath)
+{
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+  const std::vector<int> params = {cv::CAP_PROP_HW_ACCELERATION, cv::VIDEO_ACCELERATION_ANY};
+  if(videoCapture.open(videoPath, cv::CAP_FFMPEG, params))
+  {
+    ALICEVISION_LOG_DEBUG("Video " << videoPath << " opened with the hardware acceleration: "
+                          << static_cast<int>(videoCapture.get(cv::CAP_PROP_HW_ACCELERATION)));
+    return true;
+  }
+#endif
+  return videoCapture.open(videoPath);
+}
+
 class VideoFeed::FeederImpl
 {
 public:
@@ -66,8 +90,7 @@ VideoFeed::FeederImpl::FeederImpl(const std::string &videoPath, const std::strin
 : _isInit(false), _isLive(false), _withIntrinsics(false), _videoPath(videoPath)
 {
     // load the video
-  _videoCapture.open(videoPath);
-  if (!_videoCapture.isOpened())
+  if (!openVideo(_videoCapture, videoPath))
   {
     ALICEVISION_LOG_WARNING("Unable to open the video : " << videoPath);
     throw std::invalid_argument("Unable to open the video : "+videoPath);
@@ -119,21 +142,10 @@ bool VideoFeed::FeederImpl::readImage(image::Image<image::RGBColor> &imageRGB,
   
   if(frame.channels() == 3)
   {
-    cv::Mat color;
-    resize(frame, color, cv::Size(frame.cols, frame.rows));
-    
+    // convert directly into the image buffer
+    imageRGB.resize(frame.cols, frame.rows);
+    cv::Mat color(frame.rows, frame.cols, CV_8UC3, imageRGB.data());
     cv::cvtColor(frame, color, cv::COLOR_BGR2RGB);
-    imageRGB.resize(color.cols, color.rows);
-    
-    unsigned char* pixelPtr = (unsigned char*)color.data;
-    for(int i = 0; i < color.rows; i++)
-    {
-      for(int j = 0; j < color.cols; j++)
-      {
-        const size_t index = i*color.cols*3 + j*3;
-        imageRGB(i,j) = image::RGBColor(pixelPtr[index], pixelPtr[index + 1], pixelPtr[index + 2]);
-      }
-    }
   }
   else
   {
@@ -179,13 +191,10 @@ bool VideoFeed::FeederImpl::readImage(image::Image<unsigned char> &imageGray,
   
   if(frame.channels() == 3)
   {
-    // convert to gray
-    cv::Mat grey;
+    // convert to gray, directly into the image buffer
+    imageGray.resize(frame.cols, frame.rows);
+    cv::Mat grey(frame.rows, frame.cols, CV_8UC1, imageGray.data());
     cv::cvtColor(frame, grey, cv::COLOR_BGR2GRAY);
-    imageGray.resize(grey.cols, grey.rows);
-    cv::cv2eigen(grey, imageGray);
-//      ALICEVISION_LOG_DEBUG(grey.channels() << " " << grey.rows << " " << grey.cols);
-//      ALICEVISION_LOG_DEBUG(imageGray.Depth() << " " << imageGray.Height() << " " << imageGray.Width());
   }
   else
   {
@@ -220,7 +229,19 @@ bool VideoFeed::FeederImpl::goToFrame(const unsigned int frame)
   
   if(frame > 0)
   {
-    _videoCapture.set(cv::CAP_PROP_POS_FRAMES, frame);
+    // index of the next decoded frame
+    double nextFrame = _videoCapture.get(cv::CAP_PROP_POS_FRAMES);
+
+    // close frames ahead are only grabbed, a seek would decode from the previous keyframe of the video
+    if(frame >= nextFrame && frame - nextFrame < ALICEVISION_VIDEOFEED_MAX_GRABBED_FRAMES)
+    {
+      for(; nextFrame < frame; ++nextFrame)
+        _videoCapture.grab();
+    }
+    else
+    {
+      _videoCapture.set(cv::CAP_PROP_POS_FRAMES, frame);
+    }
     _videoCapture.grab();
     return true;
   }
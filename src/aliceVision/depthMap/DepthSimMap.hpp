@@ -6,7 +6,6 @@
 
 #pragma once
 
-#include <aliceVision/mvsData/Universe.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
@@ -0,0 +1,108 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DeviceScheduler.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+StaticVector<int> orderCamsBySharedTCams(mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams, int nbTCams)
+{
+    const int nbCams = cams.size();
+
+    // cameras used by each rc (itself and its tcams), and the rcs using each camera
+    std::vector<StaticVector<int>> usedCams(nbCams);
+    std::map<int, std::vector<int>> usingRcs;
+    for(int i = 0; i < nbCams; ++i)
+    {
+        usedCams[i] = pc->findNearestCamsFromSeeds(cams[i], nbTCams);
+        usedCams[i].push_back(cams[i]);
+        for(int c : usedCams[i])
+            usingRcs[c].push_back(i);
+    }
+
+    StaticVector<int> orderedCams;
+    orderedCams.reserve(nbCams);
+    std::vector<bool> isOrdered(nbCams, false);
+    std::vector<int> nbShared(nbCams, 0);
+    int firstRemaining = 0;
+    int current = 0;
+
+    while(true)
+    {
+        orderedCams.push_back(cams[current]);
+        isOrdered[current] = true;
+        while(firstRemaining < nbCams && isOrdered[firstRemaining])
+            ++firstRemaining;
+        if(firstRemaining == nbCams)
+            break;
+
+        // remaining rc sharing the most cameras with the current one
+        int next = firstRemaining;
+        std::vector<int> candidates;
+        for(int c : usedCams[current])
+        {
+            for(int i : usingRcs[c])
+            {
+                if(isOrdered[i])
+                    continue;
+                if(nbShared[i]++ == 0)
+                    candidates.push_back(i);
+            }
+        }
+        for(int i : candidates)
+        {
+            if(nbShared[i] > nbShared[next] || (nbShared[i] == nbShared[next] && i < next))
+                next = i;
+        }
+        for(int i : candidates)
+            nbShared[i] = 0;
+
+        current = next;
+    }
+
+    return orderedCams;
+}
+
+int getNbCUDADevicesToUse(int nbGPUsToUse)
+{
+    const int nbGPUs = listCUDADevices(true);
+    const int nbCPUThreads = omp_get_num_procs();
+    ALICEVISION_LOG_INFO("Number of GPU devices: " << nbGPUs << ", number of CPU threads: " << nbCPUThreads);
+
+    int nbDevices = std::min(nbGPUs, nbCPUThreads);
+    if(nbGPUsToUse > 0)
+        nbDevices = std::min(nbGPUsToUse, std::max(nbGPUs, 1));
+
+    return std::max(nbDevices, 1);
+}
+
+void runOnCUDADevices(int nbDevices, int defaultCUDADeviceNo, const std::function<void(int CUDADeviceNo)>& deviceJob)
+{
+    if(nbDevices <= 1)
+    {
+        deviceJob(defaultCUDADeviceNo);
+        return;
+    }
+
+    // one CPU thread per CUDA device
+#pragma omp parallel num_threads(nbDevices)
+    {
+        const int CUDADeviceNo = omp_get_thread_num();
+        ALICEVISION_LOG_INFO("CPU thread " << CUDADeviceNo << " (of " << nbDevices << ") uses CUDA device: " << CUDADeviceNo);
+        deviceJob(CUDADeviceNo);
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,94 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+
+#include <atomic>
+#include <functional>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Queue of reference cameras shared by all the CUDA devices.
+ *        Each device takes the next camera as soon as it is idle,
+ *        so faster devices process more cameras.
+ */
+class RcQueue
+{
+public:
+    explicit RcQueue(const StaticVector<int>& cams)
+        : _cams(cams)
+    {}
+
+    /**
+     * @brief Take the next reference camera of the queue (thread safe).
+     * @param[out] rc The reference camera
+     * @return false if the queue is empty
+     */
+    bool pop(int& rc)
+    {
+        const int index = _next++;
+        if(index >= _cams.size())
+            return false;
+        rc = _cams[index];
+        return true;
+    }
+
+    /**
+     * @brief Get the next reference camera of the queue without taking it.
+     * @note Only a hint: another device may take it first.
+     * @param[out] rc The reference camera
+     * @return false if the queue is empty
+     */
+    bool peek(int& rc) const
+    {
+        const int index = _next;
+        if(index >= _cams.size())
+            return false;
+        rc = _cams[index];
+        return true;
+    }
+
+    int size() const { return _cams.size(); }
+
+private:
+    const StaticVector<int>& _cams;
+    std::atomic<int> _next{0};
+};
+
+/**
+ * @brief Order the reference cameras so that consecutive cameras share their target cameras.
+ *        Greedy: the next camera is the one with the most cameras (itself and its target cameras)
+ *        in common with the previous one, the input order is kept on ties.
+ *        The cameras resident on the device (see PlaneSweepingCuda::setUpcomingCams) are reused by the next rc.
+ * @param[in] pc The cameras neighbourhood
+ * @param[in] cams The reference cameras
+ * @param[in] nbTCams The number of target cameras per reference camera
+ * @return the ordered reference cameras
+ */
+StaticVector<int> orderCamsBySharedTCams(mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams, int nbTCams);
+
+/**
+ * @brief Get the number of CUDA devices to use.
+ * @param[in] nbGPUsToUse The number of devices requested, all the detected devices if <= 0
+ * @return the number of devices to use (at least 1)
+ */
+int getNbCUDADevicesToUse(int nbGPUsToUse);
+
+/**
+ * @brief Run a job on several CUDA devices in parallel, one CPU thread per device.
+ * @param[in] nbDevices The number of CUDA devices to use
+ * @param[in] defaultCUDADeviceNo The device used if only one device is used
+ * @param[in] deviceJob The job to run, called with the CUDA device number
+ */
+void runOnCUDADevices(int nbDevices, int defaultCUDADeviceNo, const std::function<void(int CUDADeviceNo)>& deviceJob);
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -9,6 +9,9 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 
+#include <map>
+#include <vector>
+
 namespace aliceVision {
 namespace depthMap {
 
@@ -67,6 +70,60 @@ void RcTc::refineRcTcDepthSimMap(bool useTcOrRcPixSize, DepthSimMap* depthSimMap
     }
 }
 
+void RcTc::refineRcTcDepthSimMapAdaptive(bool useTcOrRcPixSize, DepthSimMap* depthSimMap, const StaticVector<int>& ndepthsToRefineMap,
+                                         int rc, int tc, int wsh, float gammaC, float gammaP, float epipShift)
+{
+    const int w = depthSimMap->w;
+    const int h = depthSimMap->h;
+
+    long t1 = clock();
+
+    // pixels grouped by number of depths to refine
+    std::map<int, std::vector<int>> pixelsPerBand;
+    for(int i = 0; i < w * h; i++)
+    {
+        if((ndepthsToRefineMap[i] > 0) && ((*depthSimMap->dsm)[i].depth > 0.0f))
+            pixelsPerBand[ndepthsToRefineMap[i]].push_back(i);
+    }
+
+    StaticVector<int> tcams;
+    tcams.push_back(tc);
+
+    for(const auto& band : pixelsPerBand)
+    {
+        const std::vector<int>& ids = band.second;
+        const int npixels = ids.size();
+
+        StaticVector<Pixel> pixels;
+        StaticVector<float> depths;
+        StaticVector<float> sims;
+        pixels.reserve(npixels);
+        depths.reserve(npixels);
+        sims.resize_with(npixels, 1.0f);
+        for(int i : ids)
+        {
+            pixels.push_back(Pixel((i % w) * depthSimMap->step, (i / w) * depthSimMap->step));
+            depths.push_back((*depthSimMap->dsm)[i].depth);
+        }
+
+        cps->refinePixelsAll(useTcOrRcPixSize, band.first, &depths, &sims, rc, wsh, gammaC, gammaP, &pixels,
+                             depthSimMap->scale, &tcams, epipShift);
+
+        for(int j = 0; j < npixels; j++)
+        {
+            DepthSim& depthSim = (*depthSimMap->dsm)[ids[j]];
+            if((depths[j] > 0.0f) && (sims[j] < depthSim.sim))
+                depthSim = DepthSim(depths[j], sims[j]);
+        }
+
+        if(verbose)
+            ALICEVISION_LOG_DEBUG("refineRcTcDepthSimMapAdaptive: " << npixels << " pixels with " << band.first << " depths.");
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1, "refineRcTcDepthSimMapAdaptive");
+}
+
 void RcTc::smoothDepthMap(DepthSimMap* depthSimMap, int rc, int wsh, float gammaC, float gammaP)
 {
     long t1 = clock();
@@ -25,6 +25,14 @@ public:
     void refineRcTcDepthSimMap(bool useTcOrRcPixSize, DepthSimMap* depthSimMap, int rc, int tc, int ndepthsToRefine,
                                int wsh, float gammaC, float gammaP, float epipShift);
 
+    /**
+     * @brief Refine the depth of each pixel in its own band of depths (see RefineRc adaptive depth band).
+     *        The pixels are refined per group of same band size.
+     * @param[in] ndepthsToRefineMap The number of depths to test around each pixel depth (0: not refined)
+     */
+    void refineRcTcDepthSimMapAdaptive(bool useTcOrRcPixSize, DepthSimMap* depthSimMap, const StaticVector<int>& ndepthsToRefineMap,
+                                       int rc, int tc, int wsh, float gammaC, float gammaP, float epipShift);
+
     void smoothDepthMap(DepthSimMap* depthSimMap, int rc, int wsh, float gammaC, float gammaP);
     void filterDepthMap(DepthSimMap* depthSimMap, int rc, int wsh, float gammaC);
 };
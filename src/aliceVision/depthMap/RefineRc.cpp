@@ -11,10 +11,13 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/depthMap/cuda/DeviceProfiler.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <cmath>
+
 namespace aliceVision {
 namespace depthMap {
 
@@ -27,6 +30,12 @@ RefineRc::RefineRc(int _rc, int _scale, int _step, SemiGlobalMatchingParams* _sp
     _ndepthsToRefine = sp->mp->_ini.get<int>("refineRc.ndepthsToRefine", 31);
     _sigma = (float)sp->mp->_ini.get<double>("refineRc.sigma", 15.0);
     _niters = sp->mp->_ini.get<int>("refineRc.niters", 100);
+    _convergenceThr = (float)sp->mp->_ini.get<double>("refineRc.convergenceThreshold", 0.0);
+    _convergenceStableIters = sp->mp->_ini.get<int>("refineRc.convergenceStableIters", 5);
+    _useHalfPrecision = sp->mp->_ini.get<bool>("refineRc.useHalfPrecision", false);
+    _adaptiveMinDepthsToRefine = sp->mp->_ini.get<int>("refineRc.adaptiveMinDepthsToRefine", 7);
+    _adaptiveConfidentSim = (float)sp->mp->_ini.get<double>("refineRc.adaptiveConfidentSim", -0.5);
+    _adaptiveUnconfidentSim = (float)sp->mp->_ini.get<double>("refineRc.adaptiveUnconfidentSim", 0.0);
 
     _userTcOrPixSize = sp->mp->_ini.get<bool>("refineRc.useTcOrRcPixSize", false);
     _wsh = sp->mp->_ini.get<int>("refineRc.wsh", 3);
@@ -102,7 +111,66 @@ DepthSimMap* RefineRc::getDepthPixSizeMapFromSGM()
     return depthSimMapScale1Step1;
 }
 
-DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis)
+StaticVector<int>* RefineRc::getDepthsToRefineMapFromSGM()
+{
+    if(!sp->refineAdaptiveDepthBand)
+        return nullptr;
+
+    if(!mvsUtils::FileExists(SGM_idSimMapFileName))
+    {
+        ALICEVISION_LOG_WARNING("refineRc: no SGM similarity map (" << SGM_idSimMapFileName << "), "
+                                "all the pixels are refined with " << _ndepthsToRefine << " depths.");
+        return nullptr;
+    }
+
+    int simMapWidth, simMapHeight;
+    std::vector<float> sgmSimMap;
+    imageIO::readImage(SGM_idSimMapFileName, simMapWidth, simMapHeight, sgmSimMap);
+
+    if(simMapWidth != w || simMapHeight != h)
+    {
+        ALICEVISION_LOG_WARNING("refineRc: invalid SGM similarity map size (" << SGM_idSimMapFileName << "), "
+                                "all the pixels are refined with " << _ndepthsToRefine << " depths.");
+        return nullptr;
+    }
+
+    const int w11 = sp->mp->getWidth(rc);
+    const int h11 = sp->mp->getHeight(rc);
+    const int scaleStep = scale * step;
+
+    // odd number of depths, centered on the SGM depth
+    const int maxNDepths = _ndepthsToRefine;
+    int minNDepths = std::max(1, std::min(_adaptiveMinDepthsToRefine, maxNDepths));
+    if(minNDepths % 2 == 0)
+        minNDepths = std::min(minNDepths + 1, maxNDepths);
+    const float simRange = std::max(_adaptiveUnconfidentSim - _adaptiveConfidentSim, 0.0001f);
+
+    StaticVector<int>* ndepthsToRefineMap = new StaticVector<int>();
+    ndepthsToRefineMap->resize(w11 * h11);
+
+    long nDepthsSum = 0;
+    for(int y = 0; y < h11; y++)
+    {
+        const int sgmY = std::min(y / scaleStep, h - 1);
+        for(int x = 0; x < w11; x++)
+        {
+            const int sgmX = std::min(x / scaleStep, w - 1);
+            const float sim = sgmSimMap[sgmY * w + sgmX];
+            const float t = std::min(1.0f, std::max(0.0f, (sim - _adaptiveConfidentSim) / simRange));
+            const int nDepths = std::min(maxNDepths, minNDepths + 2 * (int)std::round(t * (maxNDepths - minNDepths) / 2.0f));
+            (*ndepthsToRefineMap)[y * w11 + x] = nDepths;
+            nDepthsSum += nDepths;
+        }
+    }
+
+    if(sp->mp->verbose)
+        ALICEVISION_LOG_DEBUG("refineRc: adaptive depth band: " << (float)nDepthsSum / (float)(w11 * h11)
+                              << " depths per pixel on average (max: " << maxNDepths << ").");
+
+    return ndepthsToRefineMap;
+}
+
+DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis, const StaticVector<int>* ndepthsToRefineMap)
 {
     int w11 = sp->mp->getWidth(rc);
     int h11 = sp->mp->getHeight(rc);
@@ -120,8 +188,12 @@ DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMap
         depthSimMapC->initJustFromDepthMap(depthMap, 1.0f);
         delete depthMap;
 
-        sp->prt->refineRcTcDepthSimMap(_userTcOrPixSize, depthSimMapC, rc, tc, _ndepthsToRefine, _wsh, _gammaC, _gammaP,
-                                       0.0f);
+        if(ndepthsToRefineMap != nullptr)
+            sp->prt->refineRcTcDepthSimMapAdaptive(_userTcOrPixSize, depthSimMapC, *ndepthsToRefineMap, rc, tc, _wsh, _gammaC,
+                                                   _gammaP, 0.0f);
+        else
+            sp->prt->refineRcTcDepthSimMap(_userTcOrPixSize, depthSimMapC, rc, tc, _ndepthsToRefine, _wsh, _gammaC, _gammaP,
+                                           0.0f);
 
         dataMaps->push_back(depthSimMapC);
 
@@ -166,7 +238,7 @@ DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMap
         depthSimMapFusedHPart->resize_with(w11 * hPartHeight, DepthSim(-1.0f, 1.0f));
 
         sp->cps->fuseDepthSimMapsGaussianKernelVoting(w11, hPartHeight, depthSimMapFusedHPart, dataMapsHPart,
-                                                      _nSamplesHalf, _ndepthsToRefine, _sigma);
+                                                      _nSamplesHalf, _ndepthsToRefine, _sigma, _useHalfPrecision);
 
 #pragma omp parallel for
         for(int y = 0; y < hPartHeight; y++)
@@ -214,14 +286,25 @@ DepthSimMap* RefineRc::optimizeDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis,
 
         int nParts = 4;
         int hPart = h11 / nParts;
+        int maxNIters = 0;
+        float activeBlocksRatioSum = 0.0f;
         for(int part = 0; part < nParts; part++)
         {
             int yFrom = part * hPart;
             int hPartAct = std::min(hPart, h11 - yFrom);
+            int nIters = 0;
+            float activeBlocksRatio = 0.0f;
             sp->cps->optimizeDepthSimMapGradientDescent(depthSimMapOptimized->dsm, dataMapsPtrs, rc, _nSamplesHalf,
-                                                        _ndepthsToRefine, _sigma, _niters, yFrom, hPartAct);
+                                                        _ndepthsToRefine, _sigma, _niters, yFrom, hPartAct,
+                                                        _convergenceThr, _convergenceStableIters, &nIters, &activeBlocksRatio);
+            maxNIters = std::max(maxNIters, nIters);
+            activeBlocksRatioSum += activeBlocksRatio;
         }
 
+        ALICEVISION_LOG_INFO("refineRc: optimization of view " << sp->mp->getViewId(rc) << ": " << maxNIters << " of "
+                             << _niters << " iterations, "
+                             << (int)(100.0f * activeBlocksRatioSum / (float)nParts) << "% of the pixel blocks processed.");
+
         for(int i = 0; i < dataMaps->size(); i++)
         {
             (*dataMapsPtrs)[i] = nullptr;
@@ -263,7 +346,9 @@ bool RefineRc::refinercCUDA(bool checkIfExists)
     if(sp->visualizeDepthMaps)
         depthPixSizeMapVis->saveToImage(outDir + "refineRc_" + std::to_string(viewId) + "Vis.png", 0.0f);
 
-    DepthSimMap* depthSimMapPhoto = refineAndFuseDepthSimMapCUDA(depthPixSizeMapVis);
+    StaticVector<int>* ndepthsToRefineMap = getDepthsToRefineMapFromSGM();
+    DepthSimMap* depthSimMapPhoto = refineAndFuseDepthSimMapCUDA(depthPixSizeMapVis, ndepthsToRefineMap);
+    delete ndepthsToRefineMap;
 
     if(sp->visualizeDepthMaps)
         depthSimMapPhoto->saveToImage(outDir + "refineRc_" + std::to_string(viewId) + "Photo.png", 0.0f);
@@ -304,7 +389,7 @@ bool RefineRc::refinercCUDA(bool checkIfExists)
     return true;
 }
 
-void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, RcQueue& rcQueue)
 {
     const int fileScale = 1; // input images scale (should be one)
     int sgmScale = mp->_ini.get<int>("semiGlobalMatching.scale", -1);
@@ -328,10 +413,27 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
-    for(const int rc : cams)
+    const int nnearestcams = mp->_ini.get<int>("refineRc.maxTCams", 6);
+
+    int rc;
+    while(rcQueue.pop(rc))
     {
         if(!mvsUtils::FileExists(sp->getREFINE_opt_simMapFileName(mp->getViewId(rc), 1, 1)))
         {
+            // keep the cameras of this rc and of the next one on the device
+            StaticVector<int> upcomingCams = pc->findNearestCamsFromSeeds(rc, nnearestcams);
+            upcomingCams.push_back(rc);
+            int nextRc;
+            if(rcQueue.peek(nextRc))
+            {
+                StaticVector<int> nextTCams = pc->findNearestCamsFromSeeds(nextRc, nnearestcams);
+                upcomingCams.push_back_arr(&nextTCams);
+                upcomingCams.push_back(nextRc);
+            }
+            cps->setUpcomingCams(upcomingCams);
+            ic->prefetch(upcomingCams);
+
+            DeviceProfiler::RcScope profilerRcScope(mp->getViewId(rc));
             RefineRc* rrc = new RefineRc(rc, sgmScale, sgmStep, sp);
             rrc->refinercCUDA();
             delete rrc;
@@ -343,47 +445,34 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
     delete cps;
 }
 
-void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+/**
+ * @brief Order the reference cameras to reuse the target cameras on the device (refineRc.orderBySharedTCams)
+ */
+static StaticVector<int> getRefineCamsOrder(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
-    int num_gpus = listCUDADevices(true);
-    int num_cpu_threads = omp_get_num_procs();
-    ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
-    int numthreads = std::min(num_gpus, num_cpu_threads);
+    if(!mp->_ini.get<bool>("refineRc.orderBySharedTCams", true))
+        return cams;
+    return orderCamsBySharedTCams(pc, cams, mp->_ini.get<int>("refineRc.maxTCams", 6));
+}
 
-    int num_gpus_to_use = mp->_ini.get<int>("refineRc.num_gpus_to_use", 1);
-    if(num_gpus_to_use > 0)
-    {
-        numthreads = num_gpus_to_use;
-    }
+void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+{
+    const StaticVector<int> orderedCams = getRefineCamsOrder(mp, pc, cams);
+    RcQueue rcQueue(orderedCams);
+    refineDepthMaps(CUDADeviceNo, mp, pc, rcQueue);
+}
 
-    if(numthreads == 1)
-    {
-        refineDepthMaps(mp->CUDADeviceNo, mp, pc, cams);
-    }
-    else
-    {
-        omp_set_num_threads(numthreads); // create as many CPU threads as there are CUDA devices
-#pragma omp parallel
-        {
-            int cpu_thread_id = omp_get_thread_num();
-            int CUDADeviceNo = cpu_thread_id % numthreads;
-            ALICEVISION_LOG_INFO("CPU thread " << cpu_thread_id << " (of " << numthreads << ") uses CUDA device: " << CUDADeviceNo);
+void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+{
+    const int nbDevices = getNbCUDADevicesToUse(mp->_ini.get<int>("refineRc.num_gpus_to_use", 1));
 
-            int rcFrom = CUDADeviceNo * (cams.size() / numthreads);
-            int rcTo = (CUDADeviceNo + 1) * (cams.size() / numthreads);
-            if(CUDADeviceNo == numthreads - 1)
-            {
-                rcTo = cams.size();
-            }
-            StaticVector<int> subcams;
-            subcams.reserve(cams.size());
-            for(int rc = rcFrom; rc < rcTo; rc++)
-            {
-                subcams.push_back(cams[rc]);
-            }
-            refineDepthMaps(cpu_thread_id, mp, pc, subcams);
-        }
-    }
+    // all the devices take the reference cameras from the same queue
+    const StaticVector<int> orderedCams = getRefineCamsOrder(mp, pc, cams);
+    RcQueue rcQueue(orderedCams);
+    runOnCUDADevices(nbDevices, mp->CUDADeviceNo, [&](int CUDADeviceNo)
+    {
+        refineDepthMaps(CUDADeviceNo, mp, pc, rcQueue);
+    });
 }
 
 } // namespace depthMap
@@ -31,14 +31,34 @@ private:
     int _ndepthsToRefine;
     float _sigma;
     int _niters;
+    /// Depth step (in pixel size) under which the blocks of pixels are converged in the optimization (0: disabled)
+    float _convergenceThr;
+    /// Number of iterations under _convergenceThr before a block stops being optimized
+    int _convergenceStableIters;
+    bool _useHalfPrecision;
+    /// Number of depths refined around the most confident SGM pixels (adaptive depth band)
+    int _adaptiveMinDepthsToRefine;
+    /// SGM similarity at or below which a pixel is refined with _adaptiveMinDepthsToRefine depths
+    float _adaptiveConfidentSim;
+    /// SGM similarity at or above which a pixel is refined with _ndepthsToRefine depths
+    float _adaptiveUnconfidentSim;
 
     DepthSimMap* getDepthPixSizeMapFromSGM();
-    DepthSimMap* refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis);
+
+    /**
+     * @brief Number of depths to refine for each pixel, from the SGM similarity of its best depth:
+     *        the band narrows down from _ndepthsToRefine to _adaptiveMinDepthsToRefine as the SGM confidence grows.
+     * @return nullptr if the adaptive depth band is disabled or the SGM similarity map is not available
+     */
+    StaticVector<int>* getDepthsToRefineMapFromSGM();
+
+    DepthSimMap* refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis, const StaticVector<int>* ndepthsToRefineMap);
     DepthSimMap* optimizeDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis, DepthSimMap* depthSimMapPhoto);
 };
 
 void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams);
 void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams);
+void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, RcQueue& rcQueue);
 
 } // namespace depthMap
 } // namespace aliceVision
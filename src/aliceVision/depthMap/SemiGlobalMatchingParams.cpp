@@ -56,7 +56,12 @@ SemiGlobalMatchingParams::SemiGlobalMatchingParams(mvsUtils::MultiViewParams* _m
         mp->_ini.get<bool>("semiGlobalMatching.saveDepthsToSweepToTxtForVis", false);
 
     doSGMoptimizeVolume = mp->_ini.get<bool>("semiGlobalMatching.doSGMoptimizeVolume", true);
+    sgmTileSize = mp->_ini.get<int>("semiGlobalMatching.tileSize", 0);
+    sgmTileMargin = mp->_ini.get<int>("semiGlobalMatching.tileMargin", 32);
+    sgmTileDepthsFromSeeds = mp->_ini.get<bool>("semiGlobalMatching.tileDepthsFromSeeds", false);
+    sgmTileMinSeeds = mp->_ini.get<int>("semiGlobalMatching.tileMinSeeds", 20);
     doRefineRc = mp->_ini.get<bool>("semiGlobalMatching.doRefineRc", true);
+    refineAdaptiveDepthBand = mp->_ini.get<bool>("refineRc.adaptiveDepthBand", false);
 
     modalsMapDistLimit = mp->_ini.get<int>("semiGlobalMatching.modalsMapDistLimit", 2);
     minNumOfConsistentCams = mp->_ini.get<int>("semiGlobalMatching.minNumOfConsistentCams", 2);
@@ -119,6 +124,11 @@ std::string SemiGlobalMatchingParams::getSGM_idDepthMapFileName(IndexT viewId, i
     return mp->getDepthMapFolder() + std::to_string(viewId) + "_idDepthMap_scale" + mvsUtils::num2str(scale) + "_step" + mvsUtils::num2str(step) + "_SGM.png";
 }
 
+std::string SemiGlobalMatchingParams::getSGM_idSimMapFileName(IndexT viewId, int scale, int step)
+{
+    return mp->getDepthMapFolder() + std::to_string(viewId) + "_idSimMap_scale" + mvsUtils::num2str(scale) + "_step" + mvsUtils::num2str(step) + "_SGM.exr";
+}
+
 std::string SemiGlobalMatchingParams::getSGM_tcamsFileName(IndexT viewId)
 {
     return mp->getDepthMapFolder() + std::to_string(viewId) + "_tcams.bin";
@@ -53,7 +53,17 @@ public:
     float maxTcRcPixSizeInVoxRatio;
     int nSGGCIters;
     bool doSGMoptimizeVolume;
+    /// Size of the SGM tiles in volume pixels (0: the whole image in a single volume)
+    int sgmTileSize;
+    /// Overlap on each side of the SGM tiles, in volume pixels, for the path costs to converge before the tile core
+    int sgmTileMargin;
+    /// Sweep each SGM tile only in the depth range of the SfM seeds projected in it
+    bool sgmTileDepthsFromSeeds;
+    /// Minimal number of seeds in a tile to restrict its depth range
+    int sgmTileMinSeeds;
     bool doRefineRc;
+    /// Save the SGM similarity of each pixel and refine in a depth band adapted to it (refineRc.adaptiveDepthBand)
+    bool refineAdaptiveDepthBand;
     std::string SGMoutDirName;
     std::string SGMtmpDirName;
     bool useSilhouetteMaskCodedByColor;
@@ -72,6 +82,7 @@ public:
 
     std::string getSGMTmpDir();
     std::string getSGM_idDepthMapFileName(IndexT viewId, int scale, int step);
+    std::string getSGM_idSimMapFileName(IndexT viewId, int scale, int step);
     std::string getSGM_depthMapFileName(IndexT viewId, int scale, int step);
     std::string getSGM_simMapFileName(IndexT viewId, int scale, int step);
     std::string getSGM_tcamsFileName(IndexT viewId);
@@ -6,8 +6,10 @@
 
 #include "SemiGlobalMatchingRc.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingRcTc.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingVolume.hpp>
+#include <aliceVision/depthMap/cuda/DeviceProfiler.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/SeedPoint.hpp>
@@ -19,6 +21,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace aliceVision {
@@ -55,6 +58,7 @@ SemiGlobalMatchingRc::SemiGlobalMatchingRc(bool doComputeDepthsAndResetTCams, in
     SGM_depthMapFileName = sp->getSGM_depthMapFileName(viewId, scale, step);
     SGM_simMapFileName = sp->getSGM_simMapFileName(viewId, scale, step);
     SGM_idDepthMapFileName = sp->getSGM_idDepthMapFileName(viewId, scale, step);
+    SGM_idSimMapFileName = sp->getSGM_idSimMapFileName(viewId, scale, step);
 
     depths = nullptr;
     depthsTcamsLimits = nullptr;
@@ -539,13 +543,15 @@ void SemiGlobalMatchingRc::computeDepthsAndResetTCams()
     deleteArrayOfArrays<float>(&alldepths);
 }
 
-StaticVector<float>* SemiGlobalMatchingRc::getSubDepthsForTCam(int tcamid)
+/**
+ * @brief Depths in a range [limits.x, limits.x + limits.y) of a list of depths
+ */
+static StaticVector<float>* getSubDepths(const StaticVector<float>* depths, const Pixel& limits)
 {
     StaticVector<float>* out = new StaticVector<float>();
-    out->reserve((*depthsTcamsLimits)[tcamid].y);
+    out->reserve(limits.y);
 
-    for(int i = (*depthsTcamsLimits)[tcamid].x; i < (*depthsTcamsLimits)[tcamid].x + (*depthsTcamsLimits)[tcamid].y;
-        i++)
+    for(int i = limits.x; i < limits.x + limits.y; i++)
     {
         out->push_back((*depths)[i]);
     }
@@ -553,62 +559,210 @@ StaticVector<float>* SemiGlobalMatchingRc::getSubDepthsForTCam(int tcamid)
     return out;
 }
 
-bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
+StaticVector<float>* SemiGlobalMatchingRc::getSubDepthsForTCam(int tcamid)
 {
-    if(sp->mp->verbose)
-        ALICEVISION_LOG_DEBUG("sgmrc: processing " << (rc + 1) << " of " << sp->mp->ncams << ".");
+    return getSubDepths(depths, (*depthsTcamsLimits)[tcamid]);
+}
 
-    if(tcams->size() == 0)
+void SemiGlobalMatchingRc::computeSeedsVolumePositions()
+{
+    seedsVolumePositions.clear();
+
+    OrientedPoint rcplane;
+    rcplane.p = sp->mp->CArr[rc];
+    rcplane.n = sp->mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
+    rcplane.n = rcplane.n.normalize();
+
+    const float volumeScale = 1.0f / (float)(scale * step);
+
+    StaticVector<int> seedsCams;
+    seedsCams.reserve(tcams->size() + 1);
+    seedsCams.push_back(rc);
+    seedsCams.push_back_arr(tcams);
+
+    for(int c = 0; c < seedsCams.size(); c++)
     {
-        return false;
+        StaticVector<SeedPoint>* seeds;
+        mvsUtils::loadSeedsFromFile(&seeds, seedsCams[c], sp->mp, mvsUtils::EFileType::seeds);
+        for(int i = 0; i < seeds->size(); i++)
+        {
+            const Point3d& p = (*seeds)[i].op.p;
+            const float depth = pointPlaneDistance(p, rcplane.p, rcplane.n);
+            if(depth <= 0.0f)
+                continue;
+            Point2d pix;
+            sp->mp->getPixelFor3DPoint(&pix, p, rc);
+            if(!sp->mp->isPixelInImage(pix, rc))
+                continue;
+            seedsVolumePositions.push_back(Point3d(pix.x * volumeScale, pix.y * volumeScale, depth));
+        }
+        delete seeds;
     }
 
-    if((mvsUtils::FileExists(SGM_idDepthMapFileName)) && (checkIfExists))
+    if(sp->mp->verbose)
+        ALICEVISION_LOG_DEBUG("sgmrc: " << seedsVolumePositions.size() << " seeds to compute the depths of the tiles.");
+}
+
+bool SemiGlobalMatchingRc::getTileDepthsRangeFromSeeds(int tileX, int tileY, int tileW, int tileH, int& depthIdFrom, int& nDepths) const
+{
+    std::vector<float> tileSeedsDepths;
+    for(const Point3d& seed : seedsVolumePositions)
     {
-        return false;
+        if((seed.x >= tileX) && (seed.x < tileX + tileW) && (seed.y >= tileY) && (seed.y < tileY + tileH))
+            tileSeedsDepths.push_back(seed.z);
     }
 
-    long tall = clock();
+    if((int)tileSeedsDepths.size() < std::max(1, sp->sgmTileMinSeeds))
+        return false;
 
-    int volDimX = w;
-    int volDimY = h;
+    std::sort(tileSeedsDepths.begin(), tileSeedsDepths.end());
+    const int nSeeds = tileSeedsDepths.size();
+    const float minDepth = tileSeedsDepths[(int)(nSeeds * sp->seedsRangePercentile)] * (1.0f - sp->seedsRangeInflate);
+    const float maxDepth = tileSeedsDepths[std::min(nSeeds - 1, (int)(nSeeds * (1.0f - sp->seedsRangePercentile)))] *
+                           (1.0f + sp->seedsRangeInflate);
+
+    // depths are sorted
+    const int idFrom = std::lower_bound(depths->getData().begin(), depths->getData().end(), minDepth) - depths->getData().begin();
+    const int idTo = std::upper_bound(depths->getData().begin(), depths->getData().end(), maxDepth) - depths->getData().begin();
+
+    // keep enough depths for the SGM z reduction and borders
+    const int minNDepths = 16;
+    const int tileDepthIdFrom = std::max(0, std::min(idFrom, depths->size() - minNDepths));
+    const int tileNDepths = std::min(depths->size() - tileDepthIdFrom, std::max(idTo - tileDepthIdFrom, minNDepths));
+
+    if(tileNDepths >= depths->size())
+        return false;
+
+    depthIdFrom = tileDepthIdFrom;
+    nDepths = tileNDepths;
+    return true;
+}
+
+StaticVector<IdValue>* SemiGlobalMatchingRc::computeVolumeBestIdVal(int tileX, int tileY, int tileW, int tileH,
+                                                                  StaticVectorBool* rcSilhoueteMap, int zborder)
+{
+    int volDimX = tileW;
+    int volDimY = tileH;
     int volDimZ = depths->size();
     float volumeMBinGPUMem = 0.0f;
 
-    StaticVector<unsigned char>* simVolume = nullptr;
+    // depths and tcams to sweep in this tile
+    StaticVector<float>* volDepths = depths;
+    StaticVector<Pixel>* volDepthsTcamsLimits = depthsTcamsLimits;
+    StaticVector<int>* volTcams = tcams;
 
-    StaticVectorBool* rcSilhoueteMap = nullptr;
-    if(sp->useSilhouetteMaskCodedByColor)
+    int depthIdFrom = 0;
+    StaticVector<float> tileDepths;
+    StaticVector<Pixel> tileDepthsTcamsLimits;
+    StaticVector<int> tileTcams;
     {
-        rcSilhoueteMap = new StaticVectorBool();
-        rcSilhoueteMap->reserve(w * h);
-        rcSilhoueteMap->resize_with(w * h, true);
-        sp->cps->getSilhoueteMap(rcSilhoueteMap, scale, step, sp->silhouetteMaskColor, rc);
+        int nDepths = 0;
+        if(sp->sgmTileDepthsFromSeeds && getTileDepthsRangeFromSeeds(tileX, tileY, tileW, tileH, depthIdFrom, nDepths))
+        {
+            tileDepths.reserve(nDepths);
+            for(int i = depthIdFrom; i < depthIdFrom + nDepths; i++)
+                tileDepths.push_back((*depths)[i]);
+
+            // tcams depths limits clipped to the tile depths
+            tileTcams.reserve(tcams->size());
+            tileDepthsTcamsLimits.reserve(tcams->size());
+            for(int c = 0; c < tcams->size(); c++)
+            {
+                const Pixel& limits = (*depthsTcamsLimits)[c];
+                const int from = std::max(limits.x, depthIdFrom);
+                const int to = std::min(limits.x + limits.y, depthIdFrom + nDepths);
+                if(from < to)
+                {
+                    tileTcams.push_back((*tcams)[c]);
+                    tileDepthsTcamsLimits.push_back(Pixel(from - depthIdFrom, to - from));
+                }
+            }
+
+            if(tileTcams.size() > 0)
+            {
+                volDepths = &tileDepths;
+                volDepthsTcamsLimits = &tileDepthsTcamsLimits;
+                volTcams = &tileTcams;
+                volDimZ = nDepths;
+
+                if(sp->mp->verbose)
+                    ALICEVISION_LOG_DEBUG("sgmrc: tile (" << tileX << ", " << tileY << "): " << nDepths << " of "
+                                          << depths->size() << " depths.");
+            }
+            else
+            {
+                depthIdFrom = 0;
+            }
+        }
     }
 
+    StaticVector<unsigned char>* simVolume = nullptr;
+
+    // Sweep all the tcams at once when their images fit in the GPU memory:
+    // the second best similarity over the tcams is directly computed on the device.
+    if(volTcams->size() > 1)
     {
-        StaticVector<float>* subDepths = getSubDepthsForTCam(0);
-        SemiGlobalMatchingRcTc srt(subDepths, rc, (*tcams)[0], scale, step, sp, rcSilhoueteMap);
-        simVolume = srt.computeDepthSimMapVolume(volumeMBinGPUMem, wsh, gammaC, gammaP);
-        delete subDepths;
-    }
+        StaticVector<Voxel>* pixels = new StaticVector<Voxel>();
+        pixels->reserve(tileW * tileH);
+        for(int y = tileY; y < tileY + tileH; y++)
+        {
+            for(int x = tileX; x < tileX + tileW; x++)
+            {
+                if((rcSilhoueteMap == nullptr) || !(*rcSilhoueteMap)[y * w + x])
+                    pixels->push_back(Voxel(x * step, y * step, 0));
+            }
+        }
 
-    // recompute to all depths
-    volumeMBinGPUMem = ((volumeMBinGPUMem / (float)(*depthsTcamsLimits)[0].y) * (float)volDimZ);
+        simVolume = new StaticVector<unsigned char>();
+        simVolume->reserve(volDimX * volDimY * volDimZ);
+        simVolume->resize_with(volDimX * volDimY * volDimZ, 255);
+
+        volumeMBinGPUMem = sp->cps->sweepPixelsToVolumeAllTc(simVolume, volDimX, volDimY, volDimZ, step,
+                                                             tileX * step, tileY * step, volDepths, volDepthsTcamsLimits,
+                                                             rc, wsh, gammaC, gammaP, pixels, scale, volTcams, sp->P3);
+        delete pixels;
+
+        if(volumeMBinGPUMem < 0.0f)
+        {
+            delete simVolume;
+            simVolume = nullptr;
+        }
+    }
 
-    SemiGlobalMatchingVolume* svol = new SemiGlobalMatchingVolume(volumeMBinGPUMem, volDimX, volDimY, volDimZ, sp);
-    svol->copyVolume(simVolume, (*depthsTcamsLimits)[0].x, (*depthsTcamsLimits)[0].y);
-    delete simVolume;
+    SemiGlobalMatchingVolume* svol = nullptr;
 
-    for(int c = 1; c < tcams->size(); c++)
+    if(simVolume != nullptr)
     {
-        StaticVector<float>* subDepths = getSubDepthsForTCam(c);
-        SemiGlobalMatchingRcTc* srt = new SemiGlobalMatchingRcTc(subDepths, rc, (*tcams)[c], scale, step, sp, rcSilhoueteMap);
-        simVolume = srt->computeDepthSimMapVolume(volumeMBinGPUMem, wsh, gammaC, gammaP);
-        delete srt;
+        svol = new SemiGlobalMatchingVolume(volumeMBinGPUMem, volDimX, volDimY, volDimZ, sp);
+        svol->copyVolumeSecondBest(simVolume);
+        delete simVolume;
+    }
+    else
+    {
+        StaticVector<float>* subDepths = getSubDepths(volDepths, (*volDepthsTcamsLimits)[0]);
+        SemiGlobalMatchingRcTc srt(subDepths, rc, (*volTcams)[0], scale, step, sp, rcSilhoueteMap);
+        srt.setTile(tileX, tileY, tileW, tileH);
+        simVolume = srt.computeDepthSimMapVolume(volumeMBinGPUMem, wsh, gammaC, gammaP);
         delete subDepths;
-        svol->addVolumeSecondMin(simVolume,(*depthsTcamsLimits)[c].x,(*depthsTcamsLimits)[c].y);
+
+        // recompute to all depths
+        volumeMBinGPUMem = ((volumeMBinGPUMem / (float)(*volDepthsTcamsLimits)[0].y) * (float)volDimZ);
+
+        svol = new SemiGlobalMatchingVolume(volumeMBinGPUMem, volDimX, volDimY, volDimZ, sp);
+        svol->copyVolume(simVolume, (*volDepthsTcamsLimits)[0].x, (*volDepthsTcamsLimits)[0].y);
         delete simVolume;
+
+        for(int c = 1; c < volTcams->size(); c++)
+        {
+            StaticVector<float>* subDepths = getSubDepths(volDepths, (*volDepthsTcamsLimits)[c]);
+            SemiGlobalMatchingRcTc* srt = new SemiGlobalMatchingRcTc(subDepths, rc, (*volTcams)[c], scale, step, sp, rcSilhoueteMap);
+            srt->setTile(tileX, tileY, tileW, tileH);
+            simVolume = srt->computeDepthSimMapVolume(volumeMBinGPUMem, wsh, gammaC, gammaP);
+            delete srt;
+            delete subDepths;
+            svol->addVolumeSecondMin(simVolume,(*volDepthsTcamsLimits)[c].x,(*volDepthsTcamsLimits)[c].y);
+            delete simVolume;
+        }
     }
 
     // Reduction of 'volume' (X, Y, Z) into 'volumeStepZ' (X, Y, Z/step)
@@ -619,14 +773,106 @@ bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
     if(sp->doSGMoptimizeVolume) // this is here for experimental reason ... to show how SGGC work on non
                                 // optimized depthmaps ... it must equals to true in normal case
     {
-        svol->SGMoptimizeVolumeStepZ(rc, step, 0, 0, scale);
+        svol->SGMoptimizeVolumeStepZ(rc, step, tileX, tileY, scale);
     }
 
     // For each pixel: choose the voxel with the minimal similarity value
-    int zborder = 2;
     StaticVector<IdValue>* volumeBestIdVal = svol->getOrigVolumeBestIdValFromVolumeStepZ(zborder);
     delete svol;
 
+    // depth indexes of the tile to the depths of the whole image
+    if(depthIdFrom > 0)
+    {
+        for(int i = 0; i < volumeBestIdVal->size(); i++)
+        {
+            if((*volumeBestIdVal)[i].id >= 0)
+                (*volumeBestIdVal)[i].id += depthIdFrom;
+        }
+    }
+
+    return volumeBestIdVal;
+}
+
+bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
+{
+    ALICEVISION_PROFILE_ZONE("SemiGlobalMatchingRc::sgmrc");
+    if(sp->mp->verbose)
+        ALICEVISION_LOG_DEBUG("sgmrc: processing " << (rc + 1) << " of " << sp->mp->ncams << ".");
+
+    if(tcams->size() == 0)
+    {
+        return false;
+    }
+
+    if((mvsUtils::FileExists(SGM_idDepthMapFileName)) && (checkIfExists))
+    {
+        return false;
+    }
+
+    long tall = clock();
+
+    int volDimX = w;
+    int volDimY = h;
+
+    StaticVectorBool* rcSilhoueteMap = nullptr;
+    if(sp->useSilhouetteMaskCodedByColor)
+    {
+        rcSilhoueteMap = new StaticVectorBool();
+        rcSilhoueteMap->reserve(w * h);
+        rcSilhoueteMap->resize_with(w * h, true);
+        sp->cps->getSilhoueteMap(rcSilhoueteMap, scale, step, sp->silhouetteMaskColor, rc);
+    }
+
+    if(sp->sgmTileDepthsFromSeeds)
+        computeSeedsVolumePositions();
+
+    int zborder = 2;
+    StaticVector<IdValue>* volumeBestIdVal = nullptr;
+
+    if(sp->sgmTileSize <= 0 || (w <= sp->sgmTileSize && h <= sp->sgmTileSize))
+    {
+        volumeBestIdVal = computeVolumeBestIdVal(0, 0, w, h, rcSilhoueteMap, zborder);
+    }
+    else
+    {
+        // Process the volume per overlapping tiles and stitch the tile cores.
+        // The margin lets the SGM path costs entering a tile core converge as in the whole volume.
+        const int tileSize = sp->sgmTileSize;
+        const int tileMargin = std::max(1, sp->sgmTileMargin); // the volume borders are not evaluated
+
+        volumeBestIdVal = new StaticVector<IdValue>();
+        volumeBestIdVal->reserve(w * h);
+        volumeBestIdVal->resize_with(w * h, IdValue(-1, 1.0f));
+
+        if(sp->mp->verbose)
+            ALICEVISION_LOG_DEBUG("sgmrc: " << ((w + tileSize - 1) / tileSize) * ((h + tileSize - 1) / tileSize) << " tiles of "
+                                  << tileSize << "x" << tileSize << " (margin: " << tileMargin << ").");
+
+        for(int coreY = 0; coreY < h; coreY += tileSize)
+        {
+            for(int coreX = 0; coreX < w; coreX += tileSize)
+            {
+                const int coreW = std::min(tileSize, w - coreX);
+                const int coreH = std::min(tileSize, h - coreY);
+                const int tileX = std::max(0, coreX - tileMargin);
+                const int tileY = std::max(0, coreY - tileMargin);
+                const int tileW = std::min(w, coreX + coreW + tileMargin) - tileX;
+                const int tileH = std::min(h, coreY + coreH + tileMargin) - tileY;
+
+                StaticVector<IdValue>* tileBestIdVal = computeVolumeBestIdVal(tileX, tileY, tileW, tileH, rcSilhoueteMap, zborder);
+
+                for(int y = coreY; y < coreY + coreH; y++)
+                {
+                    for(int x = coreX; x < coreX + coreW; x++)
+                    {
+                        (*volumeBestIdVal)[y * w + x] = (*tileBestIdVal)[(y - tileY) * tileW + (x - tileX)];
+                    }
+                }
+                delete tileBestIdVal;
+            }
+        }
+    }
+
     if(rcSilhoueteMap != nullptr)
     {
         for(int i = 0; i < w * h; i++)
@@ -672,6 +918,16 @@ bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
             imageIO::writeImageScaledColors("visualize_" + SGM_idDepthMapFileName, volDimX, volDimY, 0, depths->size(), volumeBestId.data(), true);
     }
 
+    // similarity of the best depth index, for the adaptive depth band of the refinement
+    if(sp->refineAdaptiveDepthBand)
+    {
+        std::vector<float> volumeBestSim(volumeBestIdVal->size());
+        for(int i = 0; i < volumeBestIdVal->size(); i++)
+            volumeBestSim.at(i) = ((*volumeBestIdVal)[i].id > 0) ? (*volumeBestIdVal)[i].value : 1.0f;
+
+        imageIO::writeImage(SGM_idSimMapFileName, volDimX, volDimY, volumeBestSim);
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -689,7 +945,7 @@ bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
     return true;
 }
 
-void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, RcQueue& rcQueue)
 {
     const int fileScale = 1; // input images scale (should be one)
     int sgmScale = mp->_ini.get<int>("semiGlobalMatching.scale", -1);
@@ -718,12 +974,29 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
-    for(const int rc : cams)
+    const int nnearestcams = mp->_ini.get<int>("semiGlobalMatching.maxTCams", 10);
+
+    int rc;
+    while(rcQueue.pop(rc))
     {
+        // keep the cameras of this rc and of the next one on the device
+        StaticVector<int> upcomingCams = pc->findNearestCamsFromSeeds(rc, nnearestcams);
+        upcomingCams.push_back(rc);
+        int nextRc;
+        if(rcQueue.peek(nextRc))
+        {
+            StaticVector<int> nextTCams = pc->findNearestCamsFromSeeds(nextRc, nnearestcams);
+            upcomingCams.push_back_arr(&nextTCams);
+            upcomingCams.push_back(nextRc);
+        }
+        cps.setUpcomingCams(upcomingCams);
+        ic.prefetch(upcomingCams);
+
         std::string depthMapFilepath = sp.getSGM_idDepthMapFileName(mp->getViewId(rc), sgmScale, sgmStep);
         if(!mvsUtils::FileExists(depthMapFilepath))
         {
             ALICEVISION_LOG_INFO("Compute depth map: " << depthMapFilepath);
+            DeviceProfiler::RcScope profilerRcScope(mp->getViewId(rc));
             SemiGlobalMatchingRc psgr(true, rc, sgmScale, sgmStep, &sp);
             psgr.sgmrc();
         }
@@ -734,47 +1007,22 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
     }
 }
 
-void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
-    int num_gpus = listCUDADevices(true);
-    int num_cpu_threads = omp_get_num_procs();
-    ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
-    int numthreads = std::min(num_gpus, num_cpu_threads);
+    RcQueue rcQueue(cams);
+    computeDepthMapsPSSGM(CUDADeviceNo, mp, pc, rcQueue);
+}
 
-    int num_gpus_to_use = mp->_ini.get<int>("semiGlobalMatching.num_gpus_to_use", 1);
-    if(num_gpus_to_use > 0)
-    {
-        numthreads = num_gpus_to_use;
-    }
+void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
+{
+    const int nbDevices = getNbCUDADevicesToUse(mp->_ini.get<int>("semiGlobalMatching.num_gpus_to_use", 1));
 
-    if(numthreads == 1)
+    // all the devices take the reference cameras from the same queue
+    RcQueue rcQueue(cams);
+    runOnCUDADevices(nbDevices, mp->CUDADeviceNo, [&](int CUDADeviceNo)
     {
-        computeDepthMapsPSSGM(mp->CUDADeviceNo, mp, pc, cams);
-    }
-    else
-    {
-        omp_set_num_threads(numthreads); // create as many CPU threads as there are CUDA devices
-#pragma omp parallel
-        {
-            int cpu_thread_id = omp_get_thread_num();
-            int CUDADeviceNo = cpu_thread_id % numthreads;
-            ALICEVISION_LOG_INFO("CPU thread " << cpu_thread_id << " (of " << numthreads << ") uses CUDA device: " << CUDADeviceNo);
-
-            int rcFrom = CUDADeviceNo * (cams.size() / numthreads);
-            int rcTo = (CUDADeviceNo + 1) * (cams.size() / numthreads);
-            if(CUDADeviceNo == numthreads - 1)
-            {
-                rcTo = cams.size();
-            }
-            StaticVector<int> subcams;
-            subcams.reserve(cams.size());
-            for(int rc = rcFrom; rc < rcTo; rc++)
-            {
-                subcams.push_back(cams[rc]);
-            }
-            computeDepthMapsPSSGM(cpu_thread_id, mp, pc, subcams);
-        }
-    }
+        computeDepthMapsPSSGM(CUDADeviceNo, mp, pc, rcQueue);
+    });
 }
 
 } // namespace depthMap
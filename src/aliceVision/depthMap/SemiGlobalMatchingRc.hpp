@@ -7,8 +7,12 @@
 #pragma once
 
 #include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingParams.hpp>
+#include <aliceVision/depthMap/DeviceScheduler.hpp>
+
+#include <vector>
 
 namespace aliceVision {
 namespace depthMap {
@@ -36,6 +40,39 @@ protected:
 
     StaticVector<float>* getSubDepthsForTCam(int tcamid);
 
+    /**
+     * @brief Load the SfM seeds of rc and its tcams projected in the volume (x, y: volume pixels, z: rc plane distance)
+     *        for getTileDepthsRangeFromSeeds
+     */
+    void computeSeedsVolumePositions();
+
+    /**
+     * @brief Range of the depths to sweep in a tile of the reference image, from the seeds projected in it
+     *        (percentile and inflate as the depths of the whole image)
+     * @param[in] tileX The tile left coordinate (in volume pixels)
+     * @param[in] tileY The tile upper coordinate (in volume pixels)
+     * @param[in] tileW The tile width (in volume pixels)
+     * @param[in] tileH The tile height (in volume pixels)
+     * @param[out] depthIdFrom The first depth index to sweep
+     * @param[out] nDepths The number of depths to sweep
+     * @return false if there is not enough seeds in the tile to restrict its depths
+     */
+    bool getTileDepthsRangeFromSeeds(int tileX, int tileY, int tileW, int tileH, int& depthIdFrom, int& nDepths) const;
+
+    /**
+     * @brief Compute the similarity volume of a tile of the reference image with all the tcams,
+     *        optimize it with SGM and select the best depth index of each pixel.
+     * @param[in] tileX The tile left coordinate (in volume pixels)
+     * @param[in] tileY The tile upper coordinate (in volume pixels)
+     * @param[in] tileW The tile width (in volume pixels)
+     * @param[in] tileH The tile height (in volume pixels)
+     * @param[in] rcSilhoueteMap The background pixels of the whole reference image (optional)
+     * @param[in] zborder The num. of depths ignored at both ends of the volume
+     * @return The best depth index and similarity of each pixel of the tile
+     */
+    StaticVector<IdValue>* computeVolumeBestIdVal(int tileX, int tileY, int tileW, int tileH,
+                                                  StaticVectorBool* rcSilhoueteMap, int zborder);
+
     SemiGlobalMatchingParams* sp;
 
     int rc, scale, step;
@@ -43,6 +80,8 @@ protected:
     float gammaC, gammaP;
     StaticVector<float>* depths;
     StaticVector<Pixel>* depthsTcamsLimits;
+    /// SfM seeds in the volume, see computeSeedsVolumePositions
+    std::vector<Point3d> seedsVolumePositions;
     int w, h;
 
     std::string outDir;
@@ -53,10 +92,12 @@ protected:
     std::string SGM_depthMapFileName;
     std::string SGM_simMapFileName;
     std::string SGM_idDepthMapFileName;
+    std::string SGM_idSimMapFileName;
 };
 
 void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams);
 void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams);
+void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, RcQueue& rcQueue);
 
 } // namespace depthMap
 } // namespace aliceVision
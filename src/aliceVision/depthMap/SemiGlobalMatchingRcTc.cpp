@@ -26,6 +26,11 @@ SemiGlobalMatchingRcTc::SemiGlobalMatchingRcTc(StaticVector<float>* _rcTcDepths,
     w = sp->mp->getWidth(rc) / (scale * step);
     h = sp->mp->getHeight(rc) / (scale * step);
 
+    tileX = 0;
+    tileY = 0;
+    tileW = w;
+    tileH = h;
+
     rcSilhoueteMap = _rcSilhoueteMap;
 }
 
@@ -34,15 +39,23 @@ SemiGlobalMatchingRcTc::~SemiGlobalMatchingRcTc()
     //
 }
 
+void SemiGlobalMatchingRcTc::setTile(int x, int y, int width, int height)
+{
+    tileX = x;
+    tileY = y;
+    tileW = width;
+    tileH = height;
+}
+
 StaticVector<Voxel>* SemiGlobalMatchingRcTc::getPixels()
 {
     StaticVector<Voxel>* pixels = new StaticVector<Voxel>();
 
-    pixels->reserve(w * h);
+    pixels->reserve(tileW * tileH);
 
-    for(int y = 0; y < h; y++)
+    for(int y = tileY; y < tileY + tileH; y++)
     {
-        for(int x = 0; x < w; x++)
+        for(int x = tileX; x < tileX + tileW; x++)
         {
             if(rcSilhoueteMap == nullptr)
             {
@@ -67,8 +80,8 @@ StaticVector<unsigned char>* SemiGlobalMatchingRcTc::computeDepthSimMapVolume(fl
     long tall = clock();
 
     int volStepXY = step;
-    int volDimX = w;
-    int volDimY = h;
+    int volDimX = tileW;
+    int volDimY = tileH;
     int volDimZ = rcTcDepths->size();
 
     StaticVector<unsigned char>* volume = new StaticVector<unsigned char>();
@@ -82,7 +95,8 @@ StaticVector<unsigned char>* SemiGlobalMatchingRcTc::computeDepthSimMapVolume(fl
     StaticVector<Voxel>* pixels = getPixels();
 
     volumeMBinGPUMem =
-        sp->cps->sweepPixelsToVolume(rcTcDepths->size(), volume, volDimX, volDimY, volDimZ, volStepXY, 0, 0, 0,
+        sp->cps->sweepPixelsToVolume(rcTcDepths->size(), volume, volDimX, volDimY, volDimZ, volStepXY,
+                                     tileX * volStepXY, tileY * volStepXY, 0,
                                      rcTcDepths, rc, wsh, gammaC, gammaP, pixels, scale, 1, tcams, 0.0f);
     delete pixels;
     delete tcams;
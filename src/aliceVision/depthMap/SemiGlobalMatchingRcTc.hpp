@@ -20,6 +20,15 @@ public:
                 StaticVectorBool* _rcSilhoueteMap = NULL);
     ~SemiGlobalMatchingRcTc(void);
 
+    /**
+     * @brief Restrict the similarity volume to a tile of the reference image
+     * @param[in] x The tile left coordinate (in volume pixels)
+     * @param[in] y The tile upper coordinate (in volume pixels)
+     * @param[in] width The tile width (in volume pixels)
+     * @param[in] height The tile height (in volume pixels)
+     */
+    void setTile(int x, int y, int width, int height);
+
     StaticVector<unsigned char>* computeDepthSimMapVolume(float& volumeMBinGPUMem, int wsh, float gammaC, float gammaP);
 
 private:
@@ -31,6 +40,7 @@ private:
     StaticVector<float>* rcTcDepths;
     float epipShift;
     int w, h;
+    int tileX, tileY, tileW, tileH;
     StaticVectorBool* rcSilhoueteMap;
 };
 
@@ -6,9 +6,13 @@
 
 #include "SemiGlobalMatchingVolume.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace depthMap {
 
@@ -25,9 +29,11 @@ SemiGlobalMatchingVolume::SemiGlobalMatchingVolume(float _volGpuMB, int _volDimX
         Point3d dmi = sp->cps->getDeviceMemoryInfo();
         if(sp->mp->verbose)
             ALICEVISION_LOG_DEBUG("GPU memory : free: " << dmi.x << ", total: " << dmi.y << ", used: " << dmi.z);
+        // device memory available to the process
+        const float availableMB = system::ResourceBudget::get().getAvailableGpuMemory(dmi.x * 1024.0 * 1024.0) / (1024.0f * 1024.0f);
         volStepZ = 1;
         float volumeMB = volGpuMB;
-        while(4.0f * volumeMB > dmi.x)
+        while(4.0f * volumeMB > availableMB && volStepZ < volDimZ)
         {
             volStepZ++;
             volumeMB = (volGpuMB / (float)volDimZ) * (volDimZ / volStepZ);
@@ -149,6 +155,7 @@ void SemiGlobalMatchingVolume::cloneVolumeSecondStepZ()
  */
 void SemiGlobalMatchingVolume::SGMoptimizeVolumeStepZ(int rc, int volStepXY, int volLUX, int volLUY, int scale)
 {
+    ALICEVISION_PROFILE_ZONE("SemiGlobalMatchingVolume::optimize");
     long tall = clock();
 
     sp->cps->SGMoptimizeSimVolume(rc, _volumeStepZ, volDimX, volDimY, volDimZ / volStepZ, volStepXY, volLUX, volLUY,
@@ -290,6 +297,16 @@ void SemiGlobalMatchingVolume::addVolumeSecondMin(const StaticVector<unsigned ch
     }
 }
 
+/**
+ * @brief Copy the second best similarity volume computed with all the tcams at once
+ *        (see PlaneSweepingCuda::sweepPixelsToVolumeAllTc).
+ */
+void SemiGlobalMatchingVolume::copyVolumeSecondBest(const StaticVector<unsigned char>* volume)
+{
+    std::copy(volume->getData().begin(), volume->getData().begin() + volDimX * volDimY * volDimZ,
+              _volumeSecondBest->getDataWritable().begin());
+}
+
 void SemiGlobalMatchingVolume::addVolumeAvg(int n, const StaticVector<unsigned char>* volume, int zFrom, int nZSteps)
 {
     unsigned char* _volumePtr = _volume->getDataWritable().data();
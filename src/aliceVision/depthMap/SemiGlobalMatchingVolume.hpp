@@ -22,6 +22,7 @@ public:
     void copyVolume(const StaticVector<unsigned char>* volume, int zFrom, int nZSteps);
     void addVolumeMin(const StaticVector<unsigned char>* volume, int zFrom, int nZSteps);
     void addVolumeSecondMin(const StaticVector<unsigned char>* volume, int zFrom, int nZSteps);
+    void copyVolumeSecondBest(const StaticVector<unsigned char>* volume);
     void addVolumeAvg(int n, const StaticVector<unsigned char>* volume, int zFrom, int nZSteps);
 
     void cloneVolumeStepZ();
@@ -0,0 +1,659 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweepingCpu.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define ALICEVISION_PLANESWEEPING_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/// size (in pixels) of the reference image tiles swept in parallel
+const int sweepTileSize = 64;
+
+/// CIELAB lightness (0..255) of a linear RGB color (0..1), as the L channel of the CUDA textures
+inline float lightness(const Color& c)
+{
+    const float y = 0.2126729f * c.r + 0.7151522f * c.g + 0.0721750f * c.b;
+    const float f = (y > 216.0f / 24389.0f) ? std::cbrt(y) : (24389.0f / 27.0f * y + 16.0f) / 116.0f;
+    return (116.0f * f - 16.0f) * 2.55f;
+}
+
+/// similarity (-1..1) to volume value (0..255), as volume_slice_kernel
+inline unsigned char simToVolume(float sim)
+{
+    const float fsim = std::min(1.0f, std::max(0.0f, (sim + 1.0f) / 2.0f));
+    return static_cast<unsigned char>(fsim * 255.0f);
+}
+
+/// negated NCC of a window from its sums, 1 if a window is uniform
+inline float nccSim(double n, double sr, double srr, double st, double stt, double srt)
+{
+    const double varR = srr - sr * sr / n;
+    const double varT = stt - st * st / n;
+    const double d = varR * varT;
+    if(d <= 0.0)
+        return 1.0f;
+    const double sim = -(srt - sr * st / n) / std::sqrt(d);
+    return static_cast<float>(std::min(1.0, std::max(-1.0, sim)));
+}
+
+/// sum of an integral image over [x0, x1) x [y0, y1)
+inline double windowSum(const double* integral, int stride, int x0, int y0, int x1, int y1)
+{
+    return integral[y1 * stride + x1] - integral[y0 * stride + x1] - integral[y1 * stride + x0] + integral[y0 * stride + x0];
+}
+
+/// integral image of a row-major image: (width+1) x (height+1), the first row and column are 0
+void computeIntegral(const float* data, int width, int height, double* integral)
+{
+    const int stride = width + 1;
+    std::fill(integral, integral + stride, 0.0);
+    for(int y = 0; y < height; ++y)
+    {
+        const float* row = data + y * width;
+        double* out = integral + (y + 1) * stride;
+        out[0] = 0.0;
+        double rowSum = 0.0;
+        for(int x = 0; x < width; ++x)
+        {
+            rowSum += row[x];
+            out[x + 1] = rowSum + out[x + 1 - stride];
+        }
+    }
+}
+
+/**
+ * @brief Integral images of t, t^2 and r*t over a region (see computeIntegral).
+ *        The row prefix sums are sequential, the accumulation of the previous row is vectorized.
+ */
+void computeRegionIntegrals(const float* r, const float* t, int width, int height,
+                            double* st, double* stt, double* srt)
+{
+    const int stride = width + 1;
+    std::fill(st, st + stride, 0.0);
+    std::fill(stt, stt + stride, 0.0);
+    std::fill(srt, srt + stride, 0.0);
+
+    for(int y = 0; y < height; ++y)
+    {
+        const float* rRow = r + y * width;
+        const float* tRow = t + y * width;
+        double* outT = st + (y + 1) * stride;
+        double* outTT = stt + (y + 1) * stride;
+        double* outRT = srt + (y + 1) * stride;
+
+        double sumT = 0.0;
+        double sumTT = 0.0;
+        double sumRT = 0.0;
+        outT[0] = outTT[0] = outRT[0] = 0.0;
+        for(int x = 0; x < width; ++x)
+        {
+            const double tv = tRow[x];
+            sumT += tv;
+            sumTT += tv * tv;
+            sumRT += tv * rRow[x];
+            outT[x + 1] = sumT;
+            outTT[x + 1] = sumTT;
+            outRT[x + 1] = sumRT;
+        }
+
+        int x = 1;
+#ifdef ALICEVISION_PLANESWEEPING_SSE2
+        for(; x + 2 <= stride; x += 2)
+        {
+            _mm_storeu_pd(outT + x, _mm_add_pd(_mm_loadu_pd(outT + x), _mm_loadu_pd(outT + x - stride)));
+            _mm_storeu_pd(outTT + x, _mm_add_pd(_mm_loadu_pd(outTT + x), _mm_loadu_pd(outTT + x - stride)));
+            _mm_storeu_pd(outRT + x, _mm_add_pd(_mm_loadu_pd(outRT + x), _mm_loadu_pd(outRT + x - stride)));
+        }
+#endif
+        for(; x < stride; ++x)
+        {
+            outT[x] += outT[x - stride];
+            outTT[x] += outTT[x - stride];
+            outRT[x] += outRT[x - stride];
+        }
+    }
+}
+
+/// bilinear sample of an image, the coordinates are clamped in the image
+inline float sampleBilinear(const float* data, int width, int height, float x, float y)
+{
+    x = std::min(std::max(x, 0.0f), static_cast<float>(width - 1));
+    y = std::min(std::max(y, 0.0f), static_cast<float>(height - 1));
+    const int x0 = std::min(static_cast<int>(x), width - 2);
+    const int y0 = std::min(static_cast<int>(y), height - 2);
+    const float fx = x - x0;
+    const float fy = y - y0;
+    const float* p = data + y0 * width + x0;
+    const float top = p[0] + fx * (p[1] - p[0]);
+    const float bottom = p[width] + fx * (p[width + 1] - p[width]);
+    return top + fy * (bottom - top);
+}
+
+/**
+ * @brief Sample a row of the target image through a homography:
+ *        the pixel i of the row is sampled at (q + i * dq).xy / (q + i * dq).z
+ */
+void warpRow(const float* data, int width, int height, const Point3d& q, const Point3d& dq, int count, float* out)
+{
+    int i = 0;
+#ifdef ALICEVISION_PLANESWEEPING_SSE2
+    const __m128 lanes = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    const __m128 qx = _mm_set1_ps(static_cast<float>(q.x));
+    const __m128 qy = _mm_set1_ps(static_cast<float>(q.y));
+    const __m128 qz = _mm_set1_ps(static_cast<float>(q.z));
+    const __m128 dqx = _mm_set1_ps(static_cast<float>(dq.x));
+    const __m128 dqy = _mm_set1_ps(static_cast<float>(dq.y));
+    const __m128 dqz = _mm_set1_ps(static_cast<float>(dq.z));
+    const __m128 zero = _mm_setzero_ps();
+    // largest coordinates whose integer part is the last top left neighbor
+    const __m128 maxX = _mm_set1_ps(std::nextafter(static_cast<float>(width - 1), 0.0f));
+    const __m128 maxY = _mm_set1_ps(std::nextafter(static_cast<float>(height - 1), 0.0f));
+
+    for(; i + 4 <= count; i += 4)
+    {
+        const __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+        const __m128 hx = _mm_add_ps(qx, _mm_mul_ps(index, dqx));
+        const __m128 hy = _mm_add_ps(qy, _mm_mul_ps(index, dqy));
+        const __m128 hz = _mm_add_ps(qz, _mm_mul_ps(index, dqz));
+        const __m128 x = _mm_min_ps(_mm_max_ps(_mm_div_ps(hx, hz), zero), maxX);
+        const __m128 y = _mm_min_ps(_mm_max_ps(_mm_div_ps(hy, hz), zero), maxY);
+        const __m128i x0 = _mm_cvttps_epi32(x);
+        const __m128i y0 = _mm_cvttps_epi32(y);
+        const __m128 fx = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+        const __m128 fy = _mm_sub_ps(y, _mm_cvtepi32_ps(y0));
+
+        alignas(16) int xs[4];
+        alignas(16) int ys[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), x0);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), y0);
+        const float* p[4];
+        for(int k = 0; k < 4; ++k)
+            p[k] = data + ys[k] * width + xs[k];
+
+        const __m128 p00 = _mm_setr_ps(p[0][0], p[1][0], p[2][0], p[3][0]);
+        const __m128 p01 = _mm_setr_ps(p[0][1], p[1][1], p[2][1], p[3][1]);
+        const __m128 p10 = _mm_setr_ps(p[0][width], p[1][width], p[2][width], p[3][width]);
+        const __m128 p11 = _mm_setr_ps(p[0][width + 1], p[1][width + 1], p[2][width + 1], p[3][width + 1]);
+        const __m128 top = _mm_add_ps(p00, _mm_mul_ps(fx, _mm_sub_ps(p01, p00)));
+        const __m128 bottom = _mm_add_ps(p10, _mm_mul_ps(fx, _mm_sub_ps(p11, p10)));
+        _mm_storeu_ps(out + i, _mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bottom, top))));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        const Point3d h = q + dq * static_cast<double>(i);
+        out[i] = sampleBilinear(data, width, height, static_cast<float>(h.x / h.z), static_cast<float>(h.y / h.z));
+    }
+}
+
+/// true if the pixel is at least margin pixels away from the image borders (as compNCCby3DptsYK)
+inline bool isInside(double x, double y, int width, int height, double margin)
+{
+    return (x >= margin) && (x <= width - 1 - margin) && (y >= margin) && (y <= height - 1 - margin);
+}
+
+/// quadratic fit of the similarities of 3 consecutive depths, -1 if the middle one is not a minimum
+float refineDepthSubPixel(float depthM1, float depth, float depthP1, float simM1, float sim, float simP1)
+{
+    simM1 = (simM1 + 1.0f) / 2.0f;
+    simP1 = (simP1 + 1.0f) / 2.0f;
+    sim = (sim + 1.0f) / 2.0f;
+
+    if((simM1 > sim) && (simP1 > sim))
+    {
+        const float dispStep = -((simP1 - simM1) / (2.0f * (simP1 + simM1 - 2.0f * sim)));
+        const float b = (depthP1 + depthM1) / 2.0f;
+        const float a = b - depthM1;
+        return a * dispStep + b;
+    }
+    return -1.0f;
+}
+
+} // namespace
+
+PlaneSweepingCpu::PlaneSweepingCpu(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, int _scales, int nbMaxImages)
+    : mp(_mp)
+    , ic(_ic)
+    , _scales(_scales)
+    , _nbMaxImages(std::max(2, nbMaxImages))
+{
+    verbose = mp->verbose;
+    subPixel = mp->_ini.get<bool>("global.subPixel", true);
+}
+
+const PlaneSweepingCpu::CameraImage& PlaneSweepingCpu::getCameraImage(int cam, int scale, bool withIntegrals)
+{
+    CameraImage* image = nullptr;
+    for(const auto& cached : _images)
+    {
+        if(cached->cam == cam && cached->scale == scale)
+            image = cached.get();
+    }
+
+    if(image == nullptr)
+    {
+        if(static_cast<int>(_images.size()) < _nbMaxImages)
+        {
+            _images.emplace_back(new CameraImage());
+            image = _images.back().get();
+        }
+        else
+        {
+            // least recently used
+            image = std::min_element(_images.begin(), _images.end(),
+                                     [](const std::unique_ptr<CameraImage>& a, const std::unique_ptr<CameraImage>& b)
+                                     { return a->lastUse < b->lastUse; })->get();
+            image->sum.clear();
+            image->sum2.clear();
+        }
+
+        const mvsUtils::ImagesCache::ImgSharedPtr img = ic->getImg_sync(cam);
+        const int width = mp->getWidth(cam);
+        const int height = mp->getHeight(cam);
+
+        image->cam = cam;
+        image->scale = scale;
+        image->width = width / scale;
+        image->height = height / scale;
+        image->data.resize(image->width * image->height);
+
+        // mean of the scale x scale blocks
+        const float blockNorm = 1.0f / static_cast<float>(scale * scale);
+        #pragma omp parallel for
+        for(int y = 0; y < image->height; ++y)
+        {
+            for(int x = 0; x < image->width; ++x)
+            {
+                float value = 0.0f;
+                for(int by = 0; by < scale; ++by)
+                    for(int bx = 0; bx < scale; ++bx)
+                        value += lightness((*img)[ic->getPixelId(x * scale + bx, y * scale + by, cam)]);
+                image->data[y * image->width + x] = value * blockNorm;
+            }
+        }
+    }
+
+    if(withIntegrals && image->sum.empty())
+    {
+        const std::size_t integralSize = (image->width + 1) * (image->height + 1);
+        std::vector<float> squares(image->data.size());
+        std::transform(image->data.begin(), image->data.end(), squares.begin(), [](float v) { return v * v; });
+        image->sum.resize(integralSize);
+        image->sum2.resize(integralSize);
+        computeIntegral(image->data.data(), image->width, image->height, image->sum.data());
+        computeIntegral(squares.data(), image->width, image->height, image->sum2.data());
+    }
+
+    image->lastUse = ++_clock;
+    return *image;
+}
+
+PlaneSweepingCpu::CameraGeometry PlaneSweepingCpu::getCameraGeometry(int cam, int scale) const
+{
+    Matrix3x3 scaleM;
+    scaleM.m11 = 1.0 / static_cast<double>(scale);
+    scaleM.m12 = 0.0;
+    scaleM.m13 = 0.0;
+    scaleM.m21 = 0.0;
+    scaleM.m22 = 1.0 / static_cast<double>(scale);
+    scaleM.m23 = 0.0;
+    scaleM.m31 = 0.0;
+    scaleM.m32 = 0.0;
+    scaleM.m33 = 1.0;
+    const Matrix3x3 K = scaleM * mp->KArr[cam];
+
+    CameraGeometry geometry;
+    geometry.C = mp->CArr[cam];
+    geometry.KR = K * mp->RArr[cam];
+    geometry.iP = mp->iRArr[cam] * K.inverse();
+    geometry.zVect = Point3d(mp->RArr[cam].m31, mp->RArr[cam].m32, mp->RArr[cam].m33);
+    return geometry;
+}
+
+float PlaneSweepingCpu::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                            int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                            int volLUZ, StaticVector<float>* depths, int rc, int wsh, float gammaC,
+                                            float gammaP, StaticVector<Voxel>* pixels, int scale, int step,
+                                            StaticVector<int>* tcams, float epipShift)
+{
+    ALICEVISION_PROFILE_ZONE("PlaneSweepingCpu::sweepPixelsToVolume");
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("sweepPixelsVolume (CPU):" << std::endl
+                              << "\t- scale: " << scale << std::endl
+                              << "\t- npixels: " << pixels->size() << std::endl
+                              << "\t- volStepXY: " << volStepXY << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    if((tcams->size() == 0) || (pixels->size() == 0))
+        return -1.0f;
+
+    if(epipShift != 0.0f)
+        throw std::invalid_argument("PlaneSweepingCpu::sweepPixelsToVolume: epipolar shift is not supported.");
+
+    long t1 = clock();
+
+    const int tc = (*tcams)[0];
+    const CameraImage& rcImage = getCameraImage(rc, scale, true);
+    const CameraImage& tcImage = getCameraImage(tc, scale, false);
+    const CameraGeometry rcGeometry = getCameraGeometry(rc, scale);
+    const CameraGeometry tcGeometry = getCameraGeometry(tc, scale);
+
+    // target pixel of the reference pixel p on the fronto-parallel plane at depth d: d * A * p + b
+    const Matrix3x3 A = tcGeometry.KR * rcGeometry.iP;
+    const Point3d b = tcGeometry.KR * (rcGeometry.C - tcGeometry.C);
+    const Point3d Ax(A.m11, A.m21, A.m31);
+
+    const int width = rcImage.width;
+    const int height = rcImage.height;
+    const int rcStride = width + 1;
+    const double margin = wsh + 2.0;
+    const int ndepths = depths->size();
+    const int windowSize = 2 * wsh + 1;
+    const double n = static_cast<double>(windowSize * windowSize);
+
+    std::vector<unsigned char>& volumeData = volume->getDataWritable();
+    volumeData.assign(static_cast<std::size_t>(volDimX) * volDimY * volDimZ, 255);
+
+    // valid voxels sorted by tile of the reference image
+    const int nbTilesX = (width + sweepTileSize - 1) / sweepTileSize;
+    const int nbTilesY = (height + sweepTileSize - 1) / sweepTileSize;
+    std::vector<int> tileOffsets(nbTilesX * nbTilesY + 1, 0);
+    std::vector<int> tileVoxels;
+    {
+        std::vector<int> voxelTiles(pixels->size(), -1);
+        for(int i = 0; i < pixels->size(); ++i)
+        {
+            const Voxel& voxel = (*pixels)[i];
+            const int vx = (voxel.x - volLUX) / volStepXY;
+            const int vy = (voxel.y - volLUY) / volStepXY;
+            if(vx < 0 || vx >= volDimX || vy < 0 || vy >= volDimY || !isInside(voxel.x, voxel.y, width, height, margin))
+                continue;
+            voxelTiles[i] = (voxel.y / sweepTileSize) * nbTilesX + voxel.x / sweepTileSize;
+            ++tileOffsets[voxelTiles[i] + 1];
+        }
+        for(std::size_t t = 1; t < tileOffsets.size(); ++t)
+            tileOffsets[t] += tileOffsets[t - 1];
+        tileVoxels.resize(tileOffsets.back());
+        std::vector<int> tileFill(tileOffsets.begin(), tileOffsets.end() - 1);
+        for(int i = 0; i < pixels->size(); ++i)
+        {
+            if(voxelTiles[i] >= 0)
+                tileVoxels[tileFill[voxelTiles[i]]++] = i;
+        }
+    }
+
+    const int nbTiles = nbTilesX * nbTilesY;
+
+    #pragma omp parallel
+    {
+        std::vector<float> rcRegion;
+        std::vector<float> tcRegion;
+        std::vector<double> st, stt, srt;
+
+        #pragma omp for schedule(dynamic)
+        for(int tile = 0; tile < nbTiles; ++tile)
+        {
+            const int voxelsBegin = tileOffsets[tile];
+            const int voxelsEnd = tileOffsets[tile + 1];
+            if(voxelsBegin == voxelsEnd)
+                continue;
+
+            // region of the windows of the tile voxels and their depths
+            int x0 = width, y0 = height, x1 = 0, y1 = 0;
+            int depthFrom = ndepths, depthTo = 0;
+            for(int v = voxelsBegin; v < voxelsEnd; ++v)
+            {
+                const Voxel& voxel = (*pixels)[tileVoxels[v]];
+                x0 = std::min(x0, voxel.x);
+                y0 = std::min(y0, voxel.y);
+                x1 = std::max(x1, voxel.x);
+                y1 = std::max(y1, voxel.y);
+                depthFrom = std::min(depthFrom, voxel.z);
+                depthTo = std::max(depthTo, std::min(voxel.z + nDepthsToSearch, ndepths));
+            }
+            x0 -= wsh;
+            y0 -= wsh;
+            const int regionWidth = x1 + wsh + 1 - x0;
+            const int regionHeight = y1 + wsh + 1 - y0;
+            const int regionStride = regionWidth + 1;
+            const std::size_t integralSize = static_cast<std::size_t>(regionStride) * (regionHeight + 1);
+
+            rcRegion.resize(regionWidth * regionHeight);
+            tcRegion.resize(regionWidth * regionHeight);
+            st.resize(integralSize);
+            stt.resize(integralSize);
+            srt.resize(integralSize);
+
+            for(int y = 0; y < regionHeight; ++y)
+                std::copy_n(&rcImage.data[(y0 + y) * width + x0], regionWidth, &rcRegion[y * regionWidth]);
+
+            for(int depthId = depthFrom; depthId < depthTo; ++depthId)
+            {
+                const double depth = (*depths)[depthId];
+                const Point3d dq = Ax * depth;
+
+                for(int y = 0; y < regionHeight; ++y)
+                {
+                    const Point3d q = A * Point3d(x0, y0 + y, 1.0) * depth + b;
+                    warpRow(tcImage.data.data(), tcImage.width, tcImage.height, q, dq, regionWidth, &tcRegion[y * regionWidth]);
+                }
+                computeRegionIntegrals(rcRegion.data(), tcRegion.data(), regionWidth, regionHeight, st.data(), stt.data(), srt.data());
+
+                for(int v = voxelsBegin; v < voxelsEnd; ++v)
+                {
+                    const Voxel& voxel = (*pixels)[tileVoxels[v]];
+                    const int vz = depthId - volLUZ;
+                    if(depthId < voxel.z || depthId >= voxel.z + nDepthsToSearch || vz < 0 || vz >= volDimZ)
+                        continue;
+
+                    float sim = 1.0f;
+                    const Point3d h = A * Point3d(voxel.x, voxel.y, 1.0) * depth + b;
+                    if(h.z > 0.0 && isInside(h.x / h.z, h.y / h.z, tcImage.width, tcImage.height, margin))
+                    {
+                        const int wx0 = voxel.x - wsh;
+                        const int wy0 = voxel.y - wsh;
+                        const double sr = windowSum(rcImage.sum.data(), rcStride, wx0, wy0, wx0 + windowSize, wy0 + windowSize);
+                        const double srr = windowSum(rcImage.sum2.data(), rcStride, wx0, wy0, wx0 + windowSize, wy0 + windowSize);
+                        const int rx0 = wx0 - x0;
+                        const int ry0 = wy0 - y0;
+                        const double stw = windowSum(st.data(), regionStride, rx0, ry0, rx0 + windowSize, ry0 + windowSize);
+                        const double sttw = windowSum(stt.data(), regionStride, rx0, ry0, rx0 + windowSize, ry0 + windowSize);
+                        const double srtw = windowSum(srt.data(), regionStride, rx0, ry0, rx0 + windowSize, ry0 + windowSize);
+                        sim = nccSim(n, sr, srr, stw, sttw, srtw);
+                    }
+
+                    const int vx = (voxel.x - volLUX) / volStepXY;
+                    const int vy = (voxel.y - volLUY) / volStepXY;
+                    unsigned char& volumeSim = volumeData[(static_cast<std::size_t>(vz) * volDimY + vy) * volDimX + vx];
+                    volumeSim = std::min(volumeSim, simToVolume(sim));
+                }
+            }
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1, "PlaneSweepingCpu::sweepPixelsToVolume ");
+
+    return static_cast<float>(volumeData.size()) / (1024.0f * 1024.0f);
+}
+
+bool PlaneSweepingCpu::refinePixelsAll(bool useTcOrRcPixSize, int ndepthsToRefine, StaticVector<float>* pxsdepths,
+                                       StaticVector<float>* pxssims, int rc, int wsh, float igammaC, float igammaP,
+                                       StaticVector<Pixel>* pixels, int scale, StaticVector<int>* tcams,
+                                       float epipShift)
+{
+    ALICEVISION_PROFILE_ZONE("PlaneSweepingCpu::refinePixelsAll");
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("refinePixels (CPU): scale " << scale << ", npixels " << pixels->size() << ", wsh " << wsh);
+
+    if((tcams->size() == 0) || (pixels->size() == 0))
+        return false;
+
+    if(epipShift != 0.0f)
+        throw std::invalid_argument("PlaneSweepingCpu::refinePixelsAll: epipolar shift is not supported.");
+
+    long t1 = clock();
+
+    const int tc = (*tcams)[0];
+    const CameraImage& rcImage = getCameraImage(rc, scale, true);
+    const CameraImage& tcImage = getCameraImage(tc, scale, false);
+    const CameraGeometry rcGeometry = getCameraGeometry(rc, scale);
+    const CameraGeometry tcGeometry = getCameraGeometry(tc, scale);
+
+    const Matrix3x3 A = tcGeometry.KR * rcGeometry.iP;
+    const Point3d b = tcGeometry.KR * (rcGeometry.C - tcGeometry.C);
+    const Point3d Ax(A.m11, A.m21, A.m31);
+
+    const int width = rcImage.width;
+    const int height = rcImage.height;
+    const int rcStride = width + 1;
+    const double margin = wsh + 2.0;
+    const int windowSize = 2 * wsh + 1;
+    const double n = static_cast<double>(windowSize * windowSize);
+
+    pxssims->resize(pixels->size());
+
+    #pragma omp parallel
+    {
+        std::vector<float> window(windowSize * windowSize);
+        std::vector<float> candidateDepths(ndepthsToRefine);
+        std::vector<float> candidateSims(ndepthsToRefine);
+
+        #pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < pixels->size(); ++i)
+        {
+            const Pixel& pix = (*pixels)[i];
+            const float depth = (*pxsdepths)[i];
+
+            const Point3d rpv = (rcGeometry.iP * Point3d(pix.x, pix.y, 1.0)).normalize();
+            const Point3d prp = rcGeometry.C + rpv * depth;
+
+            // reference pixel size at the current depth
+            const Point3d hp = rcGeometry.KR * (prp - rcGeometry.C);
+            const Point3d rp1 = rcGeometry.iP * Point3d(hp.x / hp.z + 1.0, hp.y / hp.z, 1.0);
+            const double pixSize = pointLineDistance3D(prp, rcGeometry.C, rp1.normalize());
+
+            // target pixels along the reference ray: (tb + t * ta) for the distance t
+            const Point3d ta = tcGeometry.KR * rpv;
+            const Point3d tb = b;
+
+            for(int k = 0; k < ndepthsToRefine; ++k)
+            {
+                const float jump = static_cast<float>(k - ((ndepthsToRefine - 1) / 2));
+                double distance = depth + pixSize * jump;
+
+                if(useTcOrRcPixSize)
+                {
+                    // move the target pixel by jump pixels along the epipolar line
+                    const Point3d ho = tb + ta * depth;
+                    const Point3d hv = tb + ta * (depth * 0.5);
+                    const double tpox = ho.x / ho.z, tpoy = ho.y / ho.z;
+                    double dirx = hv.x / hv.z - tpox, diry = hv.y / hv.z - tpoy;
+                    const double dirNorm = std::sqrt(dirx * dirx + diry * diry);
+                    distance = depth;
+                    if(dirNorm > 0.0)
+                    {
+                        dirx /= dirNorm;
+                        diry /= dirNorm;
+                        const bool alongX = std::abs(dirx) > std::abs(diry);
+                        const double tpd = alongX ? tpox + dirx * jump : tpoy + diry * jump;
+                        const double hb = alongX ? tb.x : tb.y;
+                        const double ha = alongX ? ta.x : ta.y;
+                        const double denom = ha - tpd * ta.z;
+                        if(denom != 0.0)
+                            distance = (tpd * tb.z - hb) / denom;
+                    }
+                }
+
+                const Point3d p = rcGeometry.C + rpv * distance;
+                candidateDepths[k] = static_cast<float>((p - rcGeometry.C).size());
+
+                // similarity on the fronto-parallel plane of the candidate point
+                float sim = 1.0f;
+                const double planeDepth = dot(p - rcGeometry.C, rcGeometry.zVect);
+                const Point3d h = A * Point3d(pix.x, pix.y, 1.0) * planeDepth + b;
+                if(planeDepth > 0.0 && h.z > 0.0 &&
+                   isInside(pix.x, pix.y, width, height, margin) &&
+                   isInside(h.x / h.z, h.y / h.z, tcImage.width, tcImage.height, margin))
+                {
+                    const Point3d dq = Ax * planeDepth;
+                    double stw = 0.0, sttw = 0.0, srtw = 0.0;
+                    for(int y = 0; y < windowSize; ++y)
+                    {
+                        const int ry = pix.y - wsh + y;
+                        const Point3d q = A * Point3d(pix.x - wsh, ry, 1.0) * planeDepth + b;
+                        float* row = &window[y * windowSize];
+                        warpRow(tcImage.data.data(), tcImage.width, tcImage.height, q, dq, windowSize, row);
+                        const float* rcRow = &rcImage.data[ry * width + pix.x - wsh];
+                        for(int x = 0; x < windowSize; ++x)
+                        {
+                            stw += row[x];
+                            sttw += row[x] * row[x];
+                            srtw += row[x] * rcRow[x];
+                        }
+                    }
+                    const int wx0 = pix.x - wsh;
+                    const int wy0 = pix.y - wsh;
+                    const double sr = windowSum(rcImage.sum.data(), rcStride, wx0, wy0, wx0 + windowSize, wy0 + windowSize);
+                    const double srr = windowSum(rcImage.sum2.data(), rcStride, wx0, wy0, wx0 + windowSize, wy0 + windowSize);
+                    sim = nccSim(n, sr, srr, stw, sttw, srtw);
+                }
+                candidateSims[k] = sim;
+            }
+
+            // best depth, as getBest_kernel
+            float minSim = 1.0f;
+            int minDepthId = 0;
+            for(int k = 0; k < ndepthsToRefine; ++k)
+            {
+                if(candidateSims[k] < minSim)
+                {
+                    minSim = candidateSims[k];
+                    minDepthId = k;
+                }
+            }
+
+            float outDepth = candidateDepths[minDepthId];
+            if(subPixel && minDepthId > 0 && minDepthId < ndepthsToRefine - 1)
+            {
+                const float refinedDepth = refineDepthSubPixel(candidateDepths[minDepthId - 1], outDepth, candidateDepths[minDepthId + 1],
+                                                               candidateSims[minDepthId - 1], minSim, candidateSims[minDepthId + 1]);
+                if(refinedDepth > 0.0f)
+                    outDepth = refinedDepth;
+            }
+            (*pxsdepths)[i] = outDepth;
+            (*pxssims)[i] = minSim;
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1, "PlaneSweepingCpu::refinePixelsAll ");
+
+    return true;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
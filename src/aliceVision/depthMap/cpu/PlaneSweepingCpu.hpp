@@ -0,0 +1,112 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief CPU plane sweeping engine, for the machines without CUDA device.
+ *
+ * Same interface as PlaneSweepingCuda for the similarity volume and the pixels refinement.
+ * The similarity is the NCC of the luminance over a (2*wsh+1)^2 window warped by the plane
+ * fronto-parallel to the reference camera, computed from integral images:
+ * the mean/variance of the reference camera windows are precomputed once per image,
+ * the target camera terms once per tile and per depth plane.
+ * The tiles of the reference image are processed in parallel.
+ *
+ * @note Unlike the CUDA kernels, the window pixels are not weighted by their color and
+ *       distance to the window center (gammaC and gammaP are ignored) and the windows
+ *       are not aligned on the epipolar lines (epipShift must be 0).
+ *       The similarities have the same range: -1 (best) to 1.
+ */
+class PlaneSweepingCpu
+{
+public:
+    mvsUtils::MultiViewParams* mp;
+    mvsUtils::ImagesCache* ic;
+
+    bool verbose;
+    bool subPixel;
+
+    /**
+     * @param[in] _ic The images cache
+     * @param[in] _mp The multi-view parameters
+     * @param[in] _scales The number of image scales (as PlaneSweepingCuda)
+     * @param[in] nbMaxImages The maximum number of scaled camera images kept in memory
+     */
+    PlaneSweepingCpu(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, int _scales, int nbMaxImages = 16);
+
+    /**
+     * @brief Fill a similarity volume by sweeping the pixels with the first target camera.
+     * @see PlaneSweepingCuda::sweepPixelsToVolume
+     * @return the volume size in memory (MB), or a negative value if there is nothing to sweep
+     */
+    float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                              int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                              StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                              StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                              float epipShift);
+
+    /**
+     * @brief Refine the depth of the pixels with the first target camera,
+     *        by testing ndepthsToRefine depths around their current depth.
+     * @see PlaneSweepingCuda::refinePixelsAll
+     */
+    bool refinePixelsAll(bool useTcOrRcPixSize, int ndepthsToRefine, StaticVector<float>* pxsdepths,
+                         StaticVector<float>* pxssims, int rc, int wsh, float igammaC, float igammaP,
+                         StaticVector<Pixel>* pixels, int scale, StaticVector<int>* tcams, float epipShift = 0.0f);
+
+private:
+    /// Luminance of a camera image at a given scale
+    struct CameraImage
+    {
+        int cam = -1;
+        int scale = 0;
+        int width = 0;
+        int height = 0;
+        long lastUse = 0;
+        std::vector<float> data;
+        /// integral images of the luminance and its square ((width+1) x (height+1), only for the reference camera)
+        std::vector<double> sum;
+        std::vector<double> sum2;
+    };
+
+    /// Projection of a camera at a given scale
+    struct CameraGeometry
+    {
+        Point3d C;
+        /// K * R
+        Matrix3x3 KR;
+        /// inverse of K * R
+        Matrix3x3 iP;
+        /// optical axis
+        Point3d zVect;
+    };
+
+    const CameraImage& getCameraImage(int cam, int scale, bool withIntegrals);
+    CameraGeometry getCameraGeometry(int cam, int scale) const;
+
+    int _scales;
+    int _nbMaxImages;
+    long _clock = 0;
+    std::vector<std::unique_ptr<CameraImage>> _images;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,188 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DepthMapFilteringCuda.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/depthMap/cuda/commonStructures.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+extern void* ps_createDepthMapsCache(int CUDAdeviceNo, int capacity);
+extern void ps_destroyDepthMapsCache(void* depthMapsCache, int CUDAdeviceNo);
+extern bool ps_isInDepthMapsCache(void* depthMapsCache, int camId);
+extern void ps_addToDepthMapsCache(void* depthMapsCache, int camId, const float* depthMap, int width, int height);
+extern void ps_computeDepthMapsConsistency(void* depthMapsCache, const consistencyCameraStruct& rcam,
+                                           const float* rcDepthMap, const float* rcSimMap, const int* tcamIds,
+                                           const consistencyCameraStruct* tcams, int ntcams, int pixSizeBall,
+                                           int pixSizeBallWSP, int border, unsigned char* numOfModalsMap,
+                                           int CUDAdeviceNo, bool verbose);
+
+static void fillConsistencyCamera(consistencyCameraStruct* cam, int c, const mvsUtils::MultiViewParams* mp)
+{
+    // full resolution projection matrices (as used by fuseCut::Fuser), column major
+    const Matrix3x4& P = mp->camArr[c];
+    const Matrix3x3& iP = mp->iCamArr[c];
+
+    cam->C[0] = mp->CArr[c].x;
+    cam->C[1] = mp->CArr[c].y;
+    cam->C[2] = mp->CArr[c].z;
+
+    cam->P[0] = P.m11;
+    cam->P[1] = P.m21;
+    cam->P[2] = P.m31;
+    cam->P[3] = P.m12;
+    cam->P[4] = P.m22;
+    cam->P[5] = P.m32;
+    cam->P[6] = P.m13;
+    cam->P[7] = P.m23;
+    cam->P[8] = P.m33;
+    cam->P[9] = P.m14;
+    cam->P[10] = P.m24;
+    cam->P[11] = P.m34;
+
+    cam->iP[0] = iP.m11;
+    cam->iP[1] = iP.m21;
+    cam->iP[2] = iP.m31;
+    cam->iP[3] = iP.m12;
+    cam->iP[4] = iP.m22;
+    cam->iP[5] = iP.m32;
+    cam->iP[6] = iP.m13;
+    cam->iP[7] = iP.m23;
+    cam->iP[8] = iP.m33;
+
+    cam->width = mp->getWidth(c);
+    cam->height = mp->getHeight(c);
+    cam->depthMap = nullptr;
+    cam->depthMap_p = 0;
+}
+
+DepthMapFilteringCuda::DepthMapFilteringCuda(int CUDADeviceNo, const mvsUtils::MultiViewParams* mp,
+                                             mvsUtils::PreMatchCams* pc, int depthMapsCacheSize)
+  : _mp(mp)
+  , _pc(pc)
+  , _CUDADeviceNo(CUDADeviceNo)
+  , _depthMapsCacheSize(depthMapsCacheSize)
+{
+    _depthMapsCache = ps_createDepthMapsCache(_CUDADeviceNo, _depthMapsCacheSize);
+}
+
+DepthMapFilteringCuda::~DepthMapFilteringCuda()
+{
+    ps_destroyDepthMapsCache(_depthMapsCache, _CUDADeviceNo);
+}
+
+void DepthMapFilteringCuda::filterGroups(const StaticVector<int>& cams, int pixSizeBall, int pixSizeBallWSP, int nNearestCams)
+{
+    ALICEVISION_LOG_INFO("Precomputing groups (GPU).");
+    long t1 = clock();
+
+    // sequential: consecutive rcs share most of their nearest cameras, their depth maps stay on the device
+    for(int c = 0; c < cams.size(); c++)
+    {
+        filterGroupsRC(cams[c], pixSizeBall, pixSizeBallWSP, nNearestCams);
+    }
+
+    mvsUtils::printfElapsedTime(t1);
+}
+
+bool DepthMapFilteringCuda::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNearestCams)
+{
+    if(mvsUtils::FileExists(mv_getFileName(_mp, rc, mvsUtils::EFileType::nmodMap)))
+    {
+        return true;
+    }
+
+    long t1 = clock();
+    const int w = _mp->getWidth(rc);
+    const int h = _mp->getHeight(rc);
+
+    std::vector<float> depthMap;
+    std::vector<float> simMap;
+
+    {
+        int width, height;
+
+        // row major, no transposition needed on the device
+        imageIO::readImage(mv_getFileName(_mp, rc, mvsUtils::EFileType::depthMap, 1), width, height, depthMap);
+        imageIO::readImage(mv_getFileName(_mp, rc, mvsUtils::EFileType::simMap, 1), width, height, simMap);
+    }
+
+    if((depthMap.empty()) || (simMap.empty()) || (depthMap.size() != w * h) || (simMap.size() != w * h))
+    {
+        std::stringstream s;
+        s << "filterGroupsRC: bad image dimension for camera: " << _mp->getViewId(rc) << "\n";
+        s << "depthMap size: " << depthMap.size() << ", simMap size: " << simMap.size() << ", width: " << w << ", height: " << h;
+        throw std::runtime_error(s.str());
+    }
+
+    StaticVector<int> tcams = _pc->findNearestCamsFromSeeds(rc, nNearestCams);
+
+    if(tcams.size() > _depthMapsCacheSize)
+    {
+        std::stringstream s;
+        s << "filterGroupsRC: the depth maps cache (" << _depthMapsCacheSize << ") is smaller than the num. of nearest cameras (" << tcams.size() << ").";
+        throw std::runtime_error(s.str());
+    }
+
+    std::vector<int> tcamIds;
+    std::vector<consistencyCameraStruct> tcamsStruct;
+    tcamIds.reserve(tcams.size());
+    tcamsStruct.reserve(tcams.size());
+
+    for(int c = 0; c < tcams.size(); c++)
+    {
+        const int tc = tcams[c];
+
+        if(!ps_isInDepthMapsCache(_depthMapsCache, tc))
+        {
+            std::vector<float> tcDepthMap;
+            int width, height;
+
+            imageIO::readImage(mv_getFileName(_mp, tc, mvsUtils::EFileType::depthMap, 1), width, height, tcDepthMap);
+
+            if(tcDepthMap.empty())
+                continue;
+
+            ps_addToDepthMapsCache(_depthMapsCache, tc, tcDepthMap.data(), width, height);
+        }
+
+        consistencyCameraStruct tcam;
+        fillConsistencyCamera(&tcam, tc, _mp);
+        tcamIds.push_back(tc);
+        tcamsStruct.push_back(tcam);
+    }
+
+    consistencyCameraStruct rcam;
+    fillConsistencyCamera(&rcam, rc, _mp);
+
+    std::vector<unsigned char> numOfModalsMap(w * h, 0);
+
+    ps_computeDepthMapsConsistency(_depthMapsCache, rcam, depthMap.data(), simMap.data(), tcamIds.data(),
+                                   tcamsStruct.data(), tcamsStruct.size(), pixSizeBall, pixSizeBallWSP,
+                                   _mp->g_border, numOfModalsMap.data(), _CUDADeviceNo, _mp->verbose);
+
+    imageIO::writeImage(mv_getFileName(_mp, rc, mvsUtils::EFileType::nmodMap), w, h, numOfModalsMap);
+
+    if(_mp->verbose)
+        ALICEVISION_LOG_DEBUG(rc << " solved.");
+    if(_mp->verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,47 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief GPU version of the depth maps consistency step of the depth map filtering
+ *        (see fuseCut::Fuser::filterGroups), writing the same nmodMap files.
+ *
+ * The tc depth maps are uploaded once in a device cache and reused for all the rcs
+ * which have them as nearest cameras, so the cameras have to be processed sequentially.
+ */
+class DepthMapFilteringCuda
+{
+public:
+    /**
+     * @param[in] CUDADeviceNo the CUDA device to use
+     * @param[in] depthMapsCacheSize the max num. of depth maps kept on the device (at least nNearestCams)
+     */
+    DepthMapFilteringCuda(int CUDADeviceNo, const mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc,
+                          int depthMapsCacheSize);
+    ~DepthMapFilteringCuda();
+
+    void filterGroups(const StaticVector<int>& cams, int pixSizeBall, int pixSizeBallWSP, int nNearestCams);
+    bool filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNearestCams);
+
+private:
+    const mvsUtils::MultiViewParams* _mp;
+    mvsUtils::PreMatchCams* _pc;
+    int _CUDADeviceNo;
+    int _depthMapsCacheSize;
+    /// device depth maps cache (opaque, see ps_createDepthMapsCache)
+    void* _depthMapsCache;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,286 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DeviceMemoryPool.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/// shape of a buffer, the cached buffers are reused for the same shape only
+struct BlockShape
+{
+    bool isArray = false;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::size_t depth = 0;
+    int x = 0, y = 0, z = 0, w = 0;
+    int channelKind = 0;
+    unsigned int flags = 0;
+
+    bool operator<(const BlockShape& other) const
+    {
+        return std::tie(isArray, width, height, depth, x, y, z, w, channelKind, flags) <
+               std::tie(other.isArray, other.width, other.height, other.depth, other.x, other.y, other.z, other.w, other.channelKind, other.flags);
+    }
+};
+
+struct Block
+{
+    void* ptr = nullptr;
+    std::size_t pitch = 0;
+    std::size_t bytes = 0;
+    BlockShape shape;
+};
+
+struct DevicePool
+{
+    std::multimap<BlockShape, Block> cached;
+    std::unordered_map<void*, Block> inUse;
+    std::size_t inUseBytes = 0;
+    std::size_t cachedBytes = 0;
+    std::size_t highWaterMarkBytes = 0;
+    long nbAllocations = 0;
+    long nbReuses = 0;
+};
+
+std::atomic<bool> poolEnabled{true};
+std::mutex poolMutex;
+/// pool per CUDA device
+std::map<int, DevicePool> devicePools;
+
+/// pool of the current device (poolMutex locked)
+DevicePool& getCurrentPool()
+{
+    int CUDADeviceNo = 0;
+    cudaGetDevice(&CUDADeviceNo);
+    return devicePools[CUDADeviceNo];
+}
+
+void freeBlock(const Block& block)
+{
+    if(block.shape.isArray)
+        cudaFreeArray(static_cast<cudaArray*>(block.ptr));
+    else
+        cudaFree(block.ptr);
+}
+
+/// free the cached blocks (poolMutex locked)
+void releaseCachedBlocks(DevicePool& pool)
+{
+    for(const auto& cachedBlock : pool.cached)
+        freeBlock(cachedBlock.second);
+    pool.cached.clear();
+    pool.cachedBytes = 0;
+}
+
+bool allocateBlock(Block& block)
+{
+    const BlockShape& shape = block.shape;
+    cudaError_t err;
+
+    if(shape.isArray)
+    {
+        const cudaChannelFormatDesc desc = cudaCreateChannelDesc(shape.x, shape.y, shape.z, shape.w, static_cast<cudaChannelFormatKind>(shape.channelKind));
+        cudaArray* array = nullptr;
+        if(shape.depth == 0)
+            err = cudaMallocArray(&array, &desc, shape.width, shape.height, shape.flags);
+        else
+            err = cudaMalloc3DArray(&array, &desc, make_cudaExtent(shape.width, shape.height, shape.depth), shape.flags);
+        block.ptr = array;
+        block.bytes = (shape.x + shape.y + shape.z + shape.w) / 8 * shape.width * std::max<std::size_t>(shape.height, 1) * std::max<std::size_t>(shape.depth, 1);
+    }
+    else
+    {
+        if(shape.depth == 0)
+        {
+            err = cudaMallocPitch(&block.ptr, &block.pitch, shape.width, shape.height);
+        }
+        else
+        {
+            cudaPitchedPtr pitchDevPtr;
+            err = cudaMalloc3D(&pitchDevPtr, make_cudaExtent(shape.width, shape.height, shape.depth));
+            block.ptr = pitchDevPtr.ptr;
+            block.pitch = pitchDevPtr.pitch;
+        }
+        block.bytes = block.pitch * shape.height * std::max<std::size_t>(shape.depth, 1);
+    }
+    return err == cudaSuccess;
+}
+
+/// get a block of the given shape, from the cache or allocated
+void* acquireBlock(const BlockShape& shape, std::size_t& pitch)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    DevicePool& pool = getCurrentPool();
+
+    Block block;
+    const auto cachedIt = pool.cached.find(shape);
+    if(cachedIt != pool.cached.end())
+    {
+        block = cachedIt->second;
+        pool.cached.erase(cachedIt);
+        pool.cachedBytes -= block.bytes;
+        ++pool.nbReuses;
+    }
+    else
+    {
+        block.shape = shape;
+        if(!allocateBlock(block))
+        {
+            if(pool.cached.empty())
+                return nullptr;
+
+            // out of memory: give back the cached blocks and retry
+            cudaGetLastError();
+            releaseCachedBlocks(pool);
+            block = Block();
+            block.shape = shape;
+            if(!allocateBlock(block))
+                return nullptr;
+        }
+        ++pool.nbAllocations;
+    }
+
+    pool.inUse[block.ptr] = block;
+    pool.inUseBytes += block.bytes;
+    pool.highWaterMarkBytes = std::max(pool.highWaterMarkBytes, pool.inUseBytes + pool.cachedBytes);
+
+    pitch = block.pitch;
+    return block.ptr;
+}
+
+/// give back a block to the cache
+void releaseBlock(void* ptr)
+{
+    if(ptr == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    DevicePool& pool = getCurrentPool();
+
+    const auto inUseIt = pool.inUse.find(ptr);
+    if(inUseIt == pool.inUse.end())
+    {
+        ALICEVISION_LOG_WARNING("DeviceMemoryPool: release of an unknown device buffer.");
+        return;
+    }
+
+    const Block block = inUseIt->second;
+    pool.inUse.erase(inUseIt);
+    pool.inUseBytes -= block.bytes;
+
+    if(poolEnabled)
+    {
+        pool.cached.emplace(block.shape, block);
+        pool.cachedBytes += block.bytes;
+    }
+    else
+    {
+        freeBlock(block);
+    }
+}
+
+} // namespace
+
+void DeviceMemoryPool::setEnabled(bool enabled)
+{
+    poolEnabled = enabled;
+    if(!enabled)
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for(auto& pool : devicePools)
+        {
+            // the cached blocks must be freed on their device
+            int previousDevice = 0;
+            cudaGetDevice(&previousDevice);
+            cudaSetDevice(pool.first);
+            releaseCachedBlocks(pool.second);
+            cudaSetDevice(previousDevice);
+        }
+    }
+}
+
+bool DeviceMemoryPool::isEnabled()
+{
+    return poolEnabled;
+}
+
+void* DeviceMemoryPool::allocatePitched(std::size_t widthBytes, std::size_t height, std::size_t depth, std::size_t& pitch)
+{
+    BlockShape shape;
+    shape.width = widthBytes;
+    shape.height = height;
+    shape.depth = depth;
+    return acquireBlock(shape, pitch);
+}
+
+void DeviceMemoryPool::freePitched(void* buffer)
+{
+    releaseBlock(buffer);
+}
+
+cudaArray* DeviceMemoryPool::allocateArray(const cudaChannelFormatDesc& desc, const cudaExtent& extent, unsigned int flags)
+{
+    BlockShape shape;
+    shape.isArray = true;
+    shape.width = extent.width;
+    shape.height = extent.height;
+    shape.depth = extent.depth;
+    shape.x = desc.x;
+    shape.y = desc.y;
+    shape.z = desc.z;
+    shape.w = desc.w;
+    shape.channelKind = static_cast<int>(desc.f);
+    shape.flags = flags;
+    std::size_t pitch = 0;
+    return static_cast<cudaArray*>(acquireBlock(shape, pitch));
+}
+
+void DeviceMemoryPool::freeArray(cudaArray* array)
+{
+    releaseBlock(array);
+}
+
+void DeviceMemoryPool::releaseCache()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    releaseCachedBlocks(getCurrentPool());
+}
+
+double DeviceMemoryPool::getHighWaterMarkMB()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::size_t highWaterMarkBytes = 0;
+    for(const auto& pool : devicePools)
+        highWaterMarkBytes = std::max(highWaterMarkBytes, pool.second.highWaterMarkBytes);
+    return highWaterMarkBytes / (1024.0 * 1024.0);
+}
+
+void DeviceMemoryPool::logStatistics()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for(const auto& pool : devicePools)
+    {
+        ALICEVISION_LOG_INFO("GPU memory pool of the device " << pool.first << ":" << std::endl
+                             << "\t- allocations: " << pool.second.nbAllocations << std::endl
+                             << "\t- reuses: " << pool.second.nbReuses << std::endl
+                             << "\t- high-water mark: " << pool.second.highWaterMarkBytes / (1024.0 * 1024.0) << " MB" << std::endl
+                             << "\t- cached: " << pool.second.cachedBytes / (1024.0 * 1024.0) << " MB");
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,69 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cstddef>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Per device caching allocator of the CudaDeviceMemoryPitched and CudaArray buffers.
+ *
+ * A released buffer is kept in the cache of its device and given back to the next allocation
+ * of the same shape, so the ps_* functions called in the reference camera loop don't call
+ * cudaMalloc / cudaFree (which synchronize the device).
+ * The reuse is ordered by the legacy default stream: the buffers must only be used on the
+ * default stream or on blocking streams.
+ * When an allocation fails, the cache of the device is released and the allocation retried.
+ */
+class DeviceMemoryPool
+{
+public:
+    /// Enabled by default, a disabled pool allocates and frees each buffer
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /**
+     * @brief Allocate a pitched buffer on the current device
+     * @param[in] widthBytes The row size in bytes
+     * @param[in] height The number of rows
+     * @param[in] depth The number of slices (0 for a 2D buffer)
+     * @param[out] pitch The row pitch in bytes
+     * @return The device buffer, nullptr if the allocation failed
+     */
+    static void* allocatePitched(std::size_t widthBytes, std::size_t height, std::size_t depth, std::size_t& pitch);
+
+    /// Give back a buffer of allocatePitched
+    static void freePitched(void* buffer);
+
+    /**
+     * @brief Allocate a CUDA array on the current device
+     * @param[in] desc The channel format
+     * @param[in] extent The array size in elements (depth 0 for a 1D / 2D array)
+     * @param[in] flags The cudaMallocArray / cudaMalloc3DArray flags
+     * @return The array, nullptr if the allocation failed
+     */
+    static cudaArray* allocateArray(const cudaChannelFormatDesc& desc, const cudaExtent& extent, unsigned int flags);
+
+    /// Give back an array of allocateArray
+    static void freeArray(cudaArray* array);
+
+    /// Free the cached buffers of the current device
+    static void releaseCache();
+
+    /// Max. of the device memory allocated through the pool (in use + cached), in MB, over all the devices
+    static double getHighWaterMarkMB();
+
+    /// Log the allocation statistics of each device
+    static void logStatistics();
+};
+
+} // namespace depthMap
+} // namespace aliceVision
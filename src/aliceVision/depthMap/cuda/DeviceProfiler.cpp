@@ -0,0 +1,218 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DeviceProfiler.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+struct FunctionStats
+{
+    long calls = 0;
+    double gpuTimeMs = 0.0;
+    std::size_t hostToDeviceBytes = 0;
+    std::size_t deviceToHostBytes = 0;
+};
+
+struct RcStats
+{
+    double peakUsedMemoryMB = 0.0;
+    std::map<std::string, FunctionStats> functions;
+};
+
+std::atomic<bool> profilerEnabled{false};
+std::mutex profilerMutex;
+/// statistics per (viewId, CUDA device), viewId -1 for the calls made outside of a RcScope
+std::map<std::pair<int, int>, RcStats> profilerStats;
+
+thread_local int currentViewId = -1;
+thread_local const char* currentFunction = nullptr;
+
+/// Return the statistics of the current reference camera on the current device (profilerMutex locked)
+RcStats& getCurrentRcStats()
+{
+    int CUDADeviceNo = 0;
+    cudaGetDevice(&CUDADeviceNo);
+    return profilerStats[std::make_pair(currentViewId, CUDADeviceNo)];
+}
+
+/// Used memory of the whole device (MB)
+double getUsedDeviceMemoryMB()
+{
+    std::size_t availBytes = 0;
+    std::size_t totalBytes = 0;
+    cudaMemGetInfo(&availBytes, &totalBytes);
+    return (totalBytes - availBytes) / (1024.0 * 1024.0);
+}
+
+/// Name of the current ps_* function, "other" for the transfers made outside of them
+std::string getCurrentFunctionName()
+{
+    return (currentFunction != nullptr) ? currentFunction : "other";
+}
+
+} // namespace
+
+void DeviceProfiler::setEnabled(bool enabled)
+{
+    profilerEnabled = enabled;
+}
+
+bool DeviceProfiler::isEnabled()
+{
+    return profilerEnabled;
+}
+
+void DeviceProfiler::addTransfer(cudaMemcpyKind kind, std::size_t bytes)
+{
+    if(!profilerEnabled || (kind != cudaMemcpyHostToDevice && kind != cudaMemcpyDeviceToHost))
+        return;
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    FunctionStats& stats = getCurrentRcStats().functions[getCurrentFunctionName()];
+    if(kind == cudaMemcpyHostToDevice)
+        stats.hostToDeviceBytes += bytes;
+    else
+        stats.deviceToHostBytes += bytes;
+}
+
+void DeviceProfiler::onDeviceAllocation()
+{
+    if(!profilerEnabled)
+        return;
+
+    const double usedMemoryMB = getUsedDeviceMemoryMB();
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    RcStats& rcStats = getCurrentRcStats();
+    rcStats.peakUsedMemoryMB = std::max(rcStats.peakUsedMemoryMB, usedMemoryMB);
+}
+
+double DeviceProfiler::getPeakUsedMemoryMB()
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    double peakUsedMemoryMB = 0.0;
+    for(const auto& rcStats : profilerStats)
+        peakUsedMemoryMB = std::max(peakUsedMemoryMB, rcStats.second.peakUsedMemoryMB);
+    return peakUsedMemoryMB;
+}
+
+bool DeviceProfiler::writeReport(const std::string& filepath)
+{
+    std::ofstream file(filepath);
+    if(!file.is_open())
+    {
+        ALICEVISION_LOG_ERROR("Can't write the GPU profiling report: " << filepath);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+
+    if(boost::filesystem::path(filepath).extension().string() == ".json")
+    {
+        file << "{\n  \"rcs\": [";
+        bool firstRc = true;
+        for(const auto& rcStats : profilerStats)
+        {
+            file << (firstRc ? "\n" : ",\n");
+            firstRc = false;
+            file << "    {\"viewId\": " << rcStats.first.first << ", \"device\": " << rcStats.first.second
+                 << ", \"peakUsedMemoryMB\": " << rcStats.second.peakUsedMemoryMB << ", \"functions\": [";
+            bool firstFunction = true;
+            for(const auto& functionStats : rcStats.second.functions)
+            {
+                const FunctionStats& stats = functionStats.second;
+                file << (firstFunction ? "\n" : ",\n");
+                firstFunction = false;
+                file << "      {\"name\": \"" << functionStats.first << "\", \"calls\": " << stats.calls
+                     << ", \"gpuTimeMs\": " << stats.gpuTimeMs << ", \"hostToDeviceBytes\": " << stats.hostToDeviceBytes
+                     << ", \"deviceToHostBytes\": " << stats.deviceToHostBytes << "}";
+            }
+            file << "\n    ]}";
+        }
+        file << "\n  ]\n}\n";
+    }
+    else
+    {
+        file << "viewId,device,function,calls,gpuTimeMs,hostToDeviceBytes,deviceToHostBytes,peakUsedMemoryMB\n";
+        for(const auto& rcStats : profilerStats)
+        {
+            for(const auto& functionStats : rcStats.second.functions)
+            {
+                const FunctionStats& stats = functionStats.second;
+                file << rcStats.first.first << "," << rcStats.first.second << "," << functionStats.first << ","
+                     << stats.calls << "," << stats.gpuTimeMs << "," << stats.hostToDeviceBytes << ","
+                     << stats.deviceToHostBytes << "," << rcStats.second.peakUsedMemoryMB << "\n";
+            }
+        }
+    }
+
+    ALICEVISION_LOG_INFO("GPU profiling report written: " << filepath);
+    return true;
+}
+
+DeviceProfiler::RcScope::RcScope(int viewId)
+  : _previousViewId(currentViewId)
+{
+    currentViewId = viewId;
+}
+
+DeviceProfiler::RcScope::~RcScope()
+{
+    currentViewId = _previousViewId;
+}
+
+DeviceProfiler::FunctionScope::FunctionScope(const char* function)
+{
+    // nested ps_* functions are part of the outermost one
+    if(!profilerEnabled || currentFunction != nullptr)
+        return;
+
+    _function = function;
+    currentFunction = function;
+    cudaEventCreate(&_start);
+    cudaEventCreate(&_stop);
+    cudaEventRecord(_start, 0);
+}
+
+DeviceProfiler::FunctionScope::~FunctionScope()
+{
+    if(_function == nullptr)
+        return;
+
+    cudaEventRecord(_stop, 0);
+    cudaEventSynchronize(_stop);
+    float gpuTimeMs = 0.0f;
+    cudaEventElapsedTime(&gpuTimeMs, _start, _stop);
+    cudaEventDestroy(_start);
+    cudaEventDestroy(_stop);
+    currentFunction = nullptr;
+
+    // allocations made outside of the CudaDeviceMemoryPitched and CudaArray classes
+    const double usedMemoryMB = getUsedDeviceMemoryMB();
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    RcStats& rcStats = getCurrentRcStats();
+    rcStats.peakUsedMemoryMB = std::max(rcStats.peakUsedMemoryMB, usedMemoryMB);
+    FunctionStats& stats = rcStats.functions[_function];
+    ++stats.calls;
+    stats.gpuTimeMs += gpuTimeMs;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
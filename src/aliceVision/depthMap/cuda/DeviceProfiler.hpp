@@ -0,0 +1,79 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cstddef>
+#include <string>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Optional instrumentation of the ps_* host functions, disabled by default.
+ *
+ * For each reference camera (see RcScope) and each ps_* function, it records the num. of calls,
+ * the GPU time (CUDA events around the call), the host to device and device to host bytes,
+ * and the peak of used device memory.
+ * The current reference camera is per CPU thread, so each CUDA device thread has its own.
+ */
+class DeviceProfiler
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /// Count a memory transfer in the current ps_* function of the current reference camera
+    static void addTransfer(cudaMemcpyKind kind, std::size_t bytes);
+
+    /// Update the peak of used device memory of the current reference camera (called after each allocation)
+    static void onDeviceAllocation();
+
+    /// Peak of used device memory (MB) over all the reference cameras and devices
+    static double getPeakUsedMemoryMB();
+
+    /**
+     * @brief Write the report
+     * @param[in] filepath The output file, JSON if the extension is ".json", CSV otherwise
+     * @return false if the file can't be written
+     */
+    static bool writeReport(const std::string& filepath);
+
+    /**
+     * @brief Group the statistics of the calls made in its lifetime (by this thread) under a reference camera
+     */
+    class RcScope
+    {
+    public:
+        explicit RcScope(int viewId);
+        ~RcScope();
+
+    private:
+        int _previousViewId;
+    };
+
+    /**
+     * @brief Time a ps_* function on the default stream, only the outermost scope of a thread is recorded
+     */
+    class FunctionScope
+    {
+    public:
+        explicit FunctionScope(const char* function);
+        ~FunctionScope();
+
+    private:
+        const char* _function = nullptr;
+        cudaEvent_t _start;
+        cudaEvent_t _stop;
+    };
+};
+
+#define ALICEVISION_PROFILE_PS_FUNCTION() aliceVision::depthMap::DeviceProfiler::FunctionScope psFunctionScope(__FUNCTION__)
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -6,6 +6,7 @@
 
 #include "PlaneSweepingCuda.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
 #include <aliceVision/mvsData/Matrix3x3.hpp>
 #include <aliceVision/mvsData/Matrix3x4.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
@@ -13,6 +14,7 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/depthMap/cuda/commonStructures.hpp>
+#include <aliceVision/depthMap/cuda/DeviceMemoryPool.hpp>
 
 #include <iostream>
 
@@ -20,6 +22,8 @@ namespace aliceVision {
 namespace depthMap {
 
 extern float3 ps_getDeviceMemoryInfo();
+extern void ps_setCUDADevice(int CUDAdeviceNo);
+extern void ps_setUseCudaGraphs(bool useCudaGraphs);
 
 /*
 extern void ps_planeSweepingGPUPixels(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<float, 2>* odpt_hmh,
@@ -44,6 +48,13 @@ extern float ps_planeSweepingGPUPixelsVolume(
     int nDepthsToSearch, int slicesAtTime, int ntimes, int npixs, int wsh, int kernelSizeHalf, int nPlanes, int scale,
     int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, bool doUsePixelsDepths, int nbest,
     bool useTcOrRcPixSize, float gammaC, float gammaP, bool subPixel, float epipShift);
+extern float ps_planeSweepingGPUPixelsVolumeAllTc(
+    CudaArray<uchar4, 2>** ps_texs_arr, unsigned char* ovol_hmh, cameraStruct** cams, int ncams, int2* tcDepthsLimits,
+    int width, int height, int volStepXY, int volDimX, int volDimY, int volDimZ, int volLUX, int volLUY,
+    CudaHostMemoryHeap<int4, 2>& volPixs_hmh, CudaHostMemoryHeap<float, 2>& depths_hmh, int nDepthsToSearch,
+    int slicesAtTime, int ntimes, int npixs, int wsh, int nDepths, int scale, int CUDAdeviceNo, int scales,
+    bool verbose, float gammaC, float gammaP, float epipShift, unsigned char P3);
+
 /*
 
 extern void ps_computeRcVolumeForTcDepthSimMaps(
@@ -96,8 +107,10 @@ extern void ps_transposeVolume(CudaHostMemoryHeap<unsigned char, 3>* ovol_hmh,
 extern int ps_listCUDADevices(bool verbose);
 extern void ps_deviceAllocate(CudaArray<uchar4, 2>*** ps_texs_arr, int ncams, int width, int height, int scales,
                               int deviceId);
+extern void* ps_createUploadContext(int CUDAdeviceNo, int w, int h, int scales);
+extern void ps_destroyUploadContext(void* uploadContext, int CUDAdeviceNo);
 extern void ps_deviceUpdateCam(CudaArray<uchar4, 2>** ps_texs_arr, cameraStruct* cam, int camId, int CUDAdeviceNo,
-                               int ncamsAllocated, int scales, int w, int h, int varianceWsh);
+                               int ncamsAllocated, int scales, int w, int h, int varianceWsh, void* uploadContext);
 extern void ps_deviceDeallocate(CudaArray<uchar4, 2>*** ps_texs_arr, int CUDAdeviceNo, int ncams, int scales);
 
 /*
@@ -198,7 +211,7 @@ extern void ps_GC_K_aggregatePathVolume(CudaHostMemoryHeap<unsigned int, 2>* fti
 extern void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
                                                     CudaHostMemoryHeap<float2, 2>** depthSimMaps_hmh,
                                                     int ndepthSimMaps, int nSamplesHalf, int nDepthsToRefine,
-                                                    float sigma, int width, int height, bool verbose);
+                                                    float sigma, int width, int height, bool halfPrecision, bool verbose);
 
 extern void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
                                                   CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
@@ -206,7 +219,8 @@ extern void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs
                                                   int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
                                                   cameraStruct** cams, int ncams, int width, int height, int scale,
                                                   int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose,
-                                                  int yFrom);
+                                                  int yFrom, float convergenceThr, int nStableIters, int* oNIters,
+                                                  float* oActiveBlocksRatio);
 
 /*
 extern void ps_filterVisTVolume(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<unsigned int, 3>* iovol_hmh,
@@ -351,7 +365,7 @@ void cps_fillCameraData(mvsUtils::ImagesCache* ic, cameraStruct* cam, int c, mvs
     //	cam->tex_hmh_g->getBuffer(),
     //	cam->tex_hmh_b->getBuffer(), mp->indexes[c], mp, true, 1, 0);
 
-    ic->refreshData(c);
+    const mvsUtils::ImagesCache::ImgSharedPtr img = ic->getImg_sync(c);
 
     Pixel pix;
     for(pix.y = 0; pix.y < mp->getHeight(c); pix.y++)
@@ -359,7 +373,7 @@ void cps_fillCameraData(mvsUtils::ImagesCache* ic, cameraStruct* cam, int c, mvs
         for(pix.x = 0; pix.x < mp->getWidth(c); pix.x++)
         {
              uchar4& pix_rgba = ic->transposed ? (*cam->tex_rgba_hmh)(pix.x, pix.y) : (*cam->tex_rgba_hmh)(pix.y, pix.x);
-             const rgb& pc = ic->getPixelValue(pix, c);
+             const rgb pc = ic->getPixelValue(pix, *img, c);
              pix_rgba.x = pc.r;
              pix_rgba.y = pc.g;
              pix_rgba.z = pc.b;
@@ -396,15 +410,27 @@ PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _
 
     verbose = mp->verbose;
 
+    // GPU memory of one camera: image and all its scales
     float oneimagemb = 4.0f * (((float)(maxImageWidth * maxImageHeight) / 1024.0f) / 1024.0f);
     for(int scale = 2; scale <= scales; ++scale)
     {
         oneimagemb += 4.0 * (((float)((maxImageWidth / scale) * (maxImageHeight / scale)) / 1024.0) / 1024.0);
     }
-    float maxmbGPU = 100.0f;
+
+    // GPU memory budget for the cameras: user defined or a ratio of the device memory available to the process
+    ps_setCUDADevice(CUDADeviceNo);
+    const Point3d deviceMemoryInfo = getDeviceMemoryInfo(); // free, total, used (MB)
+    const float availableMB = system::ResourceBudget::get().getAvailableGpuMemory(deviceMemoryInfo.x * 1024.0 * 1024.0) / (1024.0f * 1024.0f);
+    float maxmbGPU = (float)mp->_ini.get<double>("global.gpuImagesMemoryMB", 0.0);
+    if(maxmbGPU <= 0.0f)
+        maxmbGPU = (float)mp->_ini.get<double>("global.gpuImagesMemoryRatio", 0.2) * availableMB;
     nImgsInGPUAtTime = (int)(maxmbGPU / oneimagemb);
     nImgsInGPUAtTime = std::max(2, std::min(mp->ncams, nImgsInGPUAtTime));
 
+    // the volumes are sized with the GPU memory left
+    _reservedGpuMemory = static_cast<std::size_t>(nImgsInGPUAtTime * oneimagemb * 1024.0 * 1024.0);
+    system::ResourceBudget::get().reserveGpuMemory(_reservedGpuMemory, deviceMemoryInfo.x * 1024.0 * 1024.0, true);
+
     // TODO remove nbest ... now must be 1
     nbest = 1;
     nbestkernelSizeHalf = 1;
@@ -417,7 +443,12 @@ PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _
 
     subPixel = mp->_ini.get<bool>("global.subPixel", true);
 
+    // replay the per-slice kernel launches of the volumes as CUDA graphs
+    ps_setUseCudaGraphs(mp->_ini.get<bool>("global.useCudaGraphs", false));
+
     ALICEVISION_LOG_INFO("PlaneSweepingCuda:" << std::endl
+                         << "\t- device free memory (MB): " << deviceMemoryInfo.x << std::endl
+                         << "\t- images memory (MB): " << nImgsInGPUAtTime * oneimagemb << std::endl
                          << "\t- nImgsInGPUAtTime: " << nImgsInGPUAtTime << std::endl
                          << "\t- scales: " << scales << std::endl
                          << "\t- subPixel: " << (subPixel ? "Yes" : "No") << std::endl
@@ -425,6 +456,8 @@ PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _
 
     // allocate global on the device
     ps_deviceAllocate((CudaArray<uchar4, 2>***)&ps_texs_arr, nImgsInGPUAtTime, maxImageWidth, maxImageHeight, scales, CUDADeviceNo);
+    // camera uploads are asynchronous, loading the next camera from the cache overlaps with the GPU work
+    ps_uploadContext = ps_createUploadContext(CUDADeviceNo, maxImageWidth, maxImageHeight, scales);
 
     cams = new StaticVector<void*>();
     cams->reserve(nImgsInGPUAtTime);
@@ -436,64 +469,98 @@ PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _
     camsTimes->reserve(nImgsInGPUAtTime);
     camsTimes->resize(nImgsInGPUAtTime);
 
-    for(int rc = 0; rc < nImgsInGPUAtTime; ++rc)
+    // slots are filled on demand
+    for(int i = 0; i < nImgsInGPUAtTime; ++i)
+    {
+        (*cams)[i] = new cameraStruct();
+        ((cameraStruct*)(*cams)[i])->tex_rgba_hmh =
+            new CudaHostMemoryHeap<uchar4, 2>(CudaSize<2>(maxImageWidth, maxImageHeight), true);
+        ((cameraStruct*)(*cams)[i])->H = NULL;
+        (*camsRcs)[i] = -1;
+        (*camsTimes)[i] = 0;
+    }
+}
+
+void PlaneSweepingCuda::setUpcomingCams(const StaticVector<int>& upcomingCams)
+{
+    _upcomingCams.assign(mp->ncams, false);
+    for(const int c : upcomingCams)
+        _upcomingCams[c] = true;
+}
+
+int PlaneSweepingCuda::getSlotToEvict() const
+{
+    // first free slot
+    {
+        const int id = camsRcs->indexOf(-1);
+        if(id != -1)
+            return id;
+    }
+
+    // least recently used slot, keeping the cameras of the upcoming reference camera if possible
+    int lruId = -1;
+    int lruNotUpcomingId = -1;
+    for(int i = 0; i < nImgsInGPUAtTime; ++i)
     {
-        (*cams)[rc] = new cameraStruct();
-        ((cameraStruct*)(*cams)[rc])->tex_rgba_hmh =
-            new CudaHostMemoryHeap<uchar4, 2>(CudaSize<2>(maxImageWidth, maxImageHeight));
+        if(lruId == -1 || (*camsTimes)[i] < (*camsTimes)[lruId])
+            lruId = i;
 
-        ((cameraStruct*)(*cams)[rc])->H = NULL;
-        cps_fillCamera((cameraStruct*)(*cams)[rc], rc, mp, NULL, 1);
-        cps_fillCameraData(ic, (cameraStruct*)(*cams)[rc], rc, mp);
-        (*camsRcs)[rc] = rc;
-        (*camsTimes)[rc] = clock();
-        ps_deviceUpdateCam((CudaArray<uchar4, 2>**)ps_texs_arr, (cameraStruct*)(*cams)[rc], rc, CUDADeviceNo,
-                           nImgsInGPUAtTime, scales, maxImageWidth, maxImageHeight, varianceWSH);
+        const int c = (*camsRcs)[i];
+        const bool isUpcoming = !_upcomingCams.empty() && _upcomingCams[c];
+        if(!isUpcoming && (lruNotUpcomingId == -1 || (*camsTimes)[i] < (*camsTimes)[lruNotUpcomingId]))
+            lruNotUpcomingId = i;
     }
+    return (lruNotUpcomingId != -1) ? lruNotUpcomingId : lruId;
 }
 
 int PlaneSweepingCuda::addCam(int rc, float** H, int scale)
 {
-    // fist is oldest
     int id = camsRcs->indexOf(rc);
     if(id == -1)
     {
-        // get oldest id
-        int oldestId = camsTimes->minValId();
+        ++_nbCamsCacheMiss;
+        id = getSlotToEvict();
 
         long t1 = clock();
 
-        cps_fillCamera((cameraStruct*)(*cams)[oldestId], rc, mp, H, scale);
-        cps_fillCameraData(ic, (cameraStruct*)(*cams)[oldestId], rc, mp);
-        ps_deviceUpdateCam((CudaArray<uchar4, 2>**)ps_texs_arr, (cameraStruct*)(*cams)[oldestId], oldestId,
-                           CUDADeviceNo, nImgsInGPUAtTime, scales, mp->getMaxImageWidth(), mp->getMaxImageHeight(), varianceWSH);
+        cps_fillCamera((cameraStruct*)(*cams)[id], rc, mp, H, scale);
+        cps_fillCameraData(ic, (cameraStruct*)(*cams)[id], rc, mp);
+        ps_deviceUpdateCam((CudaArray<uchar4, 2>**)ps_texs_arr, (cameraStruct*)(*cams)[id], id,
+                           CUDADeviceNo, nImgsInGPUAtTime, scales, mp->getMaxImageWidth(), mp->getMaxImageHeight(), varianceWSH,
+                           ps_uploadContext);
 
         if(verbose)
             mvsUtils::printfElapsedTime(t1, "copy image from disk to GPU ");
 
-        (*camsRcs)[oldestId] = rc;
-        (*camsTimes)[oldestId] = clock();
-        id = oldestId;
+        (*camsRcs)[id] = rc;
     }
     else
     {
+        ++_nbCamsCacheHit;
 
         cps_fillCamera((cameraStruct*)(*cams)[id], rc, mp, H, scale);
         // cps_fillCameraData((cameraStruct*)(*cams)[id], rc, mp, H, scales);
         // ps_deviceUpdateCam((cameraStruct*)(*cams)[id], id, scales);
 
-        (*camsTimes)[id] = clock();
         cps_updateCamH((cameraStruct*)(*cams)[id], H);
     }
+    (*camsTimes)[id] = ++_camsClock;
     return id;
 }
 
 PlaneSweepingCuda::~PlaneSweepingCuda(void)
 {
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ALICEVISION_LOG_INFO("PlaneSweepingCuda: GPU images cache: " << _nbCamsCacheHit << " hits, " << _nbCamsCacheMiss << " uploads.");
+
     // deallocate global on the device
+    ps_destroyUploadContext(ps_uploadContext, CUDADeviceNo);
     ps_deviceDeallocate((CudaArray<uchar4, 2>***)&ps_texs_arr, CUDADeviceNo, nImgsInGPUAtTime, scales);
 
+    // the buffers of the reference cameras are kept in the pool until the end of the device work
+    DeviceMemoryPool::releaseCache();
+    system::ResourceBudget::get().releaseGpuMemory(_reservedGpuMemory);
+
     for(int c = 0; c < cams->size(); c++)
     {
         delete((cameraStruct*)(*cams)[c])->tex_rgba_hmh;
@@ -1687,6 +1754,80 @@ float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<u
     return volumeMBinGPUMem;
 }
 
+float PlaneSweepingCuda::sweepPixelsToVolumeAllTc(StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                                    int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                                    StaticVector<float>* depths, StaticVector<Pixel>* depthsTcamsLimits,
+                                                    int rc, int wsh, float gammaC, float gammaP,
+                                                    StaticVector<Voxel>* pixels, int scale, StaticVector<int>* tcams,
+                                                    unsigned char P3)
+{
+    // all the images have to stay in the GPU memory during the sweep
+    if((tcams->size() == 0) || (pixels->size() == 0) || (tcams->size() + 1 > nImgsInGPUAtTime))
+        return -1.0f;
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("sweepPixelsToVolumeAllTc:" << std::endl
+                              << "\t- scale: " << scale << std::endl
+                              << "\t- npixels: " << pixels->size() << std::endl
+                              << "\t- ntcams: " << tcams->size() << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    int w = mp->getWidth(rc) / scale;
+    int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    std::vector<int> camsids;
+    camsids.reserve(tcams->size() + 1);
+    camsids.push_back(addCam(rc, NULL, scale));
+    for(int c = 0; c < tcams->size(); ++c)
+        camsids.push_back(addCam((*tcams)[c], NULL, scale));
+
+    std::vector<cameraStruct*> ttcams(camsids.size());
+    std::vector<int2> tcDepthsLimits(tcams->size());
+    int nDepthsToSearch = 0;
+    for(int i = 0; i < camsids.size(); i++)
+    {
+        ttcams[i] = (cameraStruct*)(*cams)[camsids[i]];
+        ttcams[i]->camId = camsids[i];
+        ttcams[i]->rc = (i == 0) ? rc : (*tcams)[i - 1];
+        if(i > 0)
+        {
+            const Pixel& limits = (*depthsTcamsLimits)[i - 1];
+            tcDepthsLimits[i - 1] = make_int2(limits.x, limits.y);
+            nDepthsToSearch = std::max(nDepthsToSearch, limits.x + limits.y);
+        }
+    }
+
+    const int npixs = pixels->size();
+    const int slicesAtTime = std::min(npixs, 4096);
+    const int ntimes = npixs / slicesAtTime + 1;
+
+    CudaHostMemoryHeap<int4, 2> volPixs_hmh(CudaSize<2>(slicesAtTime, ntimes));
+    for(int i = 0; i < npixs; ++i)
+    {
+        const Voxel& pixel = (*pixels)[i];
+        volPixs_hmh(i % slicesAtTime, i / slicesAtTime) = make_int4(pixel.x, pixel.y, pixel.z, 1);
+    }
+
+    CudaHostMemoryHeap<float, 2> depths_hmh(CudaSize<2>(depths->size(), 1));
+    for(int x = 0; x < depths->size(); x++)
+        depths_hmh(x, 0) = (*depths)[x];
+
+    float volumeMBinGPUMem = ps_planeSweepingGPUPixelsVolumeAllTc(
+        (CudaArray<uchar4, 2>**)ps_texs_arr, volume->getDataWritable().data(), ttcams.data(), ttcams.size(),
+        tcDepthsLimits.data(), w, h, volStepXY, volDimX, volDimY, volDimZ, volLUX, volLUY, volPixs_hmh, depths_hmh,
+        nDepthsToSearch, slicesAtTime, ntimes, npixs, wsh, depths->size(), scale - 1, CUDADeviceNo, scales, verbose,
+        gammaC, gammaP, 0.0f, P3);
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return volumeMBinGPUMem;
+}
+
 /**
  * @param[inout] volume input similarity volume (after Z reduction)
  */
@@ -2110,7 +2251,8 @@ bool PlaneSweepingCuda::SGGCoptimizeSimVolume(StaticVector<unsigned short>* ftid
 */
 bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
                                                                const StaticVector<StaticVector<DepthSim>*>* dataMaps,
-                                                               int nSamplesHalf, int nDepthsToRefine, float sigma)
+                                                               int nSamplesHalf, int nDepthsToRefine, float sigma,
+                                                               bool halfPrecision)
 {
     long t1 = clock();
 
@@ -2134,7 +2276,7 @@ bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, Stati
     CudaHostMemoryHeap<float2, 2> oDepthSimMap_hmh(CudaSize<2>(w, h));
 
     ps_fuseDepthSimMapsGaussianKernelVoting(&oDepthSimMap_hmh, dataMaps_hmh, dataMaps->size(), nSamplesHalf,
-                                            nDepthsToRefine, sigma, w, h, verbose);
+                                            nDepthsToRefine, sigma, w, h, halfPrecision, verbose);
 
     for(int y = 0; y < h; y++)
     {
@@ -2162,7 +2304,8 @@ bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, Stati
 bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
                                                              StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
                                                              int nSamplesHalf, int nDepthsToRefine, float sigma,
-                                                             int nIters, int yFrom, int hPart)
+                                                             int nIters, int yFrom, int hPart, float convergenceThr,
+                                                             int nStableIters, int* oNIters, float* oActiveBlocksRatio)
 {
     if(mp->verbose)
         ALICEVISION_LOG_DEBUG("optimizeDepthSimMapGradientDescent.");
@@ -2210,7 +2353,7 @@ bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim
     ps_optimizeDepthSimMapGradientDescent((CudaArray<uchar4, 2>**)ps_texs_arr, &oDepthSimMap_hmh, dataMaps_hmh,
                                           dataMaps->size(), nSamplesHalf, nDepthsToRefine, nIters, sigma, ttcams,
                                           camsids->size(), w, h, scale - 1, CUDADeviceNo, nImgsInGPUAtTime, scales,
-                                          verbose, yFrom);
+                                          verbose, yFrom, convergenceThr, nStableIters, oNIters, oActiveBlocksRatio);
 
     for(int y = 0; y < h; y++)
     {
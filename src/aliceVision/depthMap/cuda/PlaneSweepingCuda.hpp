@@ -19,6 +19,8 @@
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/depthMap/DepthSimMap.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace depthMap {
 
@@ -55,6 +57,8 @@ public:
 
     int CUDADeviceNo;
     void** ps_texs_arr;
+    /// upload stream and buffers of the device (opaque, see ps_createUploadContext)
+    void* ps_uploadContext;
 
     StaticVector<void*>* cams;
     StaticVector<int>* camsRcs;
@@ -78,8 +82,19 @@ public:
                         int _scales);
     ~PlaneSweepingCuda(void);
 
+    /**
+     * @brief Make a camera resident on the GPU (least recently used slot eviction).
+     * @return the GPU slot of the camera
+     */
     int addCam(int rc, float** H, int scale);
 
+    /**
+     * @brief Set the cameras needed by the next reference camera of the schedule,
+     *        they are evicted from the GPU only if there is no other choice.
+     * @param[in] upcomingCams The next reference camera and its target cameras
+     */
+    void setUpcomingCams(const StaticVector<int>& upcomingCams);
+
     void getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth, float& maxDepth);
     void getAverageMinMaxdepths(float& avMinDist, float& avMaxDist);
     StaticVector<float>* getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth, int scale,
@@ -116,6 +131,16 @@ public:
                               StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
                               StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
                               float epipShift);
+    /**
+     * @brief Sweep the pixels with all the tcams at once and keep the second best similarity of each voxel.
+     * @param[in] depthsTcamsLimits for each tcam, its first depth index and num. of depths in depths
+     * @return the volume size in GPU memory (MB), or a negative value if the tcams cannot be swept at once
+     *         (not enough images in the GPU memory or device without texture objects support)
+     */
+    float sweepPixelsToVolumeAllTc(StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                                   int volStepXY, int volLUX, int volLUY, StaticVector<float>* depths,
+                                   StaticVector<Pixel>* depthsTcamsLimits, int rc, int wsh, float gammaC, float gammaP,
+                                   StaticVector<Voxel>* pixels, int scale, StaticVector<int>* tcams, unsigned char P3);
     bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
                               int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2);
     Point3d getDeviceMemoryInfo();
@@ -139,10 +164,19 @@ public:
 
     bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim> *oDepthSimMap,
                                               const StaticVector<StaticVector<DepthSim> *> *dataMaps, int nSamplesHalf,
-                                              int nDepthsToRefine, float sigma);
+                                              int nDepthsToRefine, float sigma, bool halfPrecision = false);
+    /**
+     * @brief Gradient descent of the depth map between the visibility and photometric depth maps
+     * @param[in] convergenceThr Stop processing the blocks of pixels whose depths move less than this ratio
+     *            of the pixel size for nStableIters iterations (0: always run nIters iterations)
+     * @param[out] oNIters The number of iterations run (optional)
+     * @param[out] oActiveBlocksRatio The ratio of the blocks processed over the nIters iterations (optional)
+     */
     bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim> *oDepthSimMap,
                                             StaticVector<StaticVector<DepthSim> *> *dataMaps, int rc, int nSamplesHalf,
-                                            int nDepthsToRefine, float sigma, int nIters, int yFrom, int hPart);
+                                            int nDepthsToRefine, float sigma, int nIters, int yFrom, int hPart,
+                                            float convergenceThr = 0.0f, int nStableIters = 5, int* oNIters = nullptr,
+                                            float* oActiveBlocksRatio = nullptr);
     bool computeDP1Volume(StaticVector<int>* ovolume, StaticVector<unsigned int>* ivolume, int _volDimX, int volDimY,
                           int volDimZ, int xFrom, int xTo);
 
@@ -152,6 +186,19 @@ public:
     bool computeRcTcdepthMap(StaticVector<float>* iRcDepthMap_oRcTcDepthMap, StaticVector<float>* tcDdepthMap, int rc,
                              int tc, float pixSizeRatioThr);
     bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc);
+
+private:
+    /// Return the GPU slot to use for a new camera
+    int getSlotToEvict() const;
+
+    /// cameras needed by the next reference camera (indexed by camera)
+    std::vector<bool> _upcomingCams;
+    /// logical clock of the slots usage
+    long _camsClock = 0;
+    long _nbCamsCacheHit = 0;
+    long _nbCamsCacheMiss = 0;
+    /// GPU memory of the images, reserved in the resource budget of the process
+    std::size_t _reservedGpuMemory = 0;
 };
 
 int listCUDADevices(bool verbose);
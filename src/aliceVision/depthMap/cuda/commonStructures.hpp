@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <aliceVision/depthMap/cuda/DeviceMemoryPool.hpp>
+#include <aliceVision/depthMap/cuda/DeviceProfiler.hpp>
+
 #include <cuda_runtime.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -126,8 +129,22 @@ template <class Type, unsigned Dim> class CudaHostMemoryHeap
   Type* buffer;
   size_t sx, sy, sz;
   CudaSize<Dim> size;
+  bool pinned;
+
+  void freeBuffer()
+  {
+    if(pinned)
+      cudaFreeHost(buffer);
+    else
+      free(buffer);
+  }
 public:
-  explicit CudaHostMemoryHeap(const CudaSize<Dim> &_size)
+  /**
+   * @param _size buffer size
+   * @param _pinned allocate page-locked memory (faster transfers and asynchronous copies),
+   *        it falls back to pageable memory if the allocation fails
+   */
+  explicit CudaHostMemoryHeap(const CudaSize<Dim> &_size, bool _pinned = false)
   {
     size = _size;
     sx = 1;
@@ -136,11 +153,14 @@ public:
     if (Dim >= 1) sx = _size[0];
     if (Dim >= 2) sy = _size[1];
     if (Dim >= 3) sx = _size[2];
-    buffer = (Type*)malloc(sx * sy * sz * sizeof (Type));
+    pinned = _pinned && (cudaMallocHost((void**)&buffer, sx * sy * sz * sizeof (Type)) == cudaSuccess);
+    if(!pinned)
+      buffer = (Type*)malloc(sx * sy * sz * sizeof (Type));
     memset(buffer, 0, sx * sy * sz * sizeof (Type));
   }
   CudaHostMemoryHeap<Type,Dim>& operator=(const CudaHostMemoryHeap<Type,Dim>& rhs)
   {
+    freeBuffer();
     size = rhs.size;
     sx = 1;
     sy = 1;
@@ -148,13 +168,18 @@ public:
     if (Dim >= 1) sx = rhs.sx;
     if (Dim >= 2) sy = rhs.sy;
     if (Dim >= 3) sx = rhs.sz;
+    pinned = false;
     buffer = (Type*)malloc(sx * sy * sz * sizeof (Type));
     memcpy(buffer, rhs.buffer, sx * sy * sz * sizeof (Type));
     return *this;
   }
   ~CudaHostMemoryHeap()
   {
-    free(buffer);
+    freeBuffer();
+  }
+  bool isPinned() const
+  {
+    return pinned;
   }
   const CudaSize<Dim>& getSize() const
   {
@@ -196,7 +221,7 @@ public:
     if (Dim >= 3) sx = _size[2];
     if(Dim == 2)
     {
-      cudaMallocPitch<Type>(&buffer, &pitch, _size[0] * sizeof(Type), _size[1]);
+      buffer = (Type*)DeviceMemoryPool::allocatePitched(_size[0] * sizeof(Type), _size[1], 0, pitch);
     }
     if(Dim >= 3)
     {
@@ -206,15 +231,13 @@ public:
       extent.depth = _size[2];
       for(unsigned i = 3; i < Dim; ++i)
         extent.depth *= _size[i];
-      cudaPitchedPtr pitchDevPtr;
-      cudaMalloc3D(&pitchDevPtr, extent);
-      buffer = (Type*)pitchDevPtr.ptr;
-      pitch = pitchDevPtr.pitch;
+      buffer = (Type*)DeviceMemoryPool::allocatePitched(extent.width, extent.height, extent.depth, pitch);
     }
+    DeviceProfiler::onDeviceAllocation();
   }
   ~CudaDeviceMemoryPitched()
   {
-    cudaFree(buffer);
+    DeviceMemoryPool::freePitched(buffer);
   }
   explicit inline CudaDeviceMemoryPitched(const CudaHostMemoryHeap<Type, Dim> &rhs)
   {
@@ -227,7 +250,7 @@ public:
     if (Dim >= 3) sx = rhs.getSize()[2];
     if(Dim == 2)
     {
-      cudaMallocPitch<Type>(&buffer, &pitch, size[0] * sizeof(Type), size[1]);
+      buffer = (Type*)DeviceMemoryPool::allocatePitched(size[0] * sizeof(Type), size[1], 0, pitch);
     }
     if(Dim >= 3)
     {
@@ -237,11 +260,9 @@ public:
       extent.depth = size[2];
       for(unsigned i = 3; i < Dim; ++i)
         extent.depth *= size[i];
-      cudaPitchedPtr pitchDevPtr;
-      cudaMalloc3D(&pitchDevPtr, extent);
-      buffer = (Type*)pitchDevPtr.ptr;
-      pitch = pitchDevPtr.pitch;
+      buffer = (Type*)DeviceMemoryPool::allocatePitched(extent.width, extent.height, extent.depth, pitch);
     }
+    DeviceProfiler::onDeviceAllocation();
     copy(*this, rhs);
   }
   CudaDeviceMemoryPitched<Type,Dim> & operator=(const CudaDeviceMemoryPitched<Type,Dim> & rhs)
@@ -303,11 +324,11 @@ public:
     cudaChannelFormatDesc channelDesc = cudaCreateChannelDesc<Type>();
     if(Dim == 1)
     {
-      cudaMallocArray(&array, &channelDesc, _size[0], 1, cudaArraySurfaceLoadStore);
+      array = DeviceMemoryPool::allocateArray(channelDesc, make_cudaExtent(_size[0], 1, 0), cudaArraySurfaceLoadStore);
     }
     else if(Dim == 2)
     {
-      cudaMallocArray(&array, &channelDesc, _size[0], _size[1], cudaArraySurfaceLoadStore);
+      array = DeviceMemoryPool::allocateArray(channelDesc, make_cudaExtent(_size[0], _size[1], 0), cudaArraySurfaceLoadStore);
     }
     else
     {
@@ -317,8 +338,9 @@ public:
       extent.depth = _size[2];
       for(unsigned i = 3; i < Dim; ++i)
         extent.depth *= _size[i];
-      cudaMalloc3DArray(&array, &channelDesc, extent);
+      array = DeviceMemoryPool::allocateArray(channelDesc, extent, 0);
     }
+    DeviceProfiler::onDeviceAllocation();
   }
   explicit inline CudaArray(const CudaDeviceMemoryPitched<Type, Dim> &rhs)
   {
@@ -332,11 +354,11 @@ public:
     cudaChannelFormatDesc channelDesc = cudaCreateChannelDesc<Type>();
     if(Dim == 1)
     {
-      cudaMallocArray(&array, &channelDesc, size[0], 1, cudaArraySurfaceLoadStore);
+      array = DeviceMemoryPool::allocateArray(channelDesc, make_cudaExtent(size[0], 1, 0), cudaArraySurfaceLoadStore);
     }
     else if(Dim == 2)
     {
-      cudaMallocArray(&array, &channelDesc, size[0], size[1], cudaArraySurfaceLoadStore);
+      array = DeviceMemoryPool::allocateArray(channelDesc, make_cudaExtent(size[0], size[1], 0), cudaArraySurfaceLoadStore);
     }
     else
     {
@@ -346,8 +368,9 @@ public:
       extent.depth = size[2];
       for(unsigned i = 3; i < Dim; ++i)
         extent.depth *= size[i];
-      cudaMalloc3DArray(&array, &channelDesc, extent);
+      array = DeviceMemoryPool::allocateArray(channelDesc, extent, 0);
     }
+    DeviceProfiler::onDeviceAllocation();
     copy(*this, rhs);
   }
   explicit inline CudaArray(const CudaHostMemoryHeap<Type, Dim> &rhs)
@@ -362,11 +385,11 @@ public:
     cudaChannelFormatDesc channelDesc = cudaCreateChannelDesc<Type>();
     if(Dim == 1)
     {
-      cudaMallocArray(&array, &channelDesc, size[0], 1, cudaArraySurfaceLoadStore);
+      array = DeviceMemoryPool::allocateArray(channelDesc, make_cudaExtent(size[0], 1, 0), cudaArraySurfaceLoadStore);
     }
     else if(Dim == 2)
     {
-      cudaMallocArray(&array, &channelDesc, size[0], size[1], cudaArraySurfaceLoadStore);
+      array = DeviceMemoryPool::allocateArray(channelDesc, make_cudaExtent(size[0], size[1], 0), cudaArraySurfaceLoadStore);
     }
     else
     {
@@ -376,13 +399,14 @@ public:
       extent.depth = size[2];
       for(unsigned i = 3; i < Dim; ++i)
         extent.depth *= size[i];
-      cudaMalloc3DArray(&array, &channelDesc, extent);
+      array = DeviceMemoryPool::allocateArray(channelDesc, extent, 0);
     }
+    DeviceProfiler::onDeviceAllocation();
     copy(*this, rhs);
   }
   virtual ~CudaArray()
   {
-    cudaFreeArray(array);
+    DeviceMemoryPool::freeArray(array);
   }
   size_t getBytes() const
   {
@@ -413,6 +437,7 @@ public:
 template<class Type, unsigned Dim> void copy(CudaHostMemoryHeap<Type, Dim>& _dst, const CudaDeviceMemoryPitched<Type, Dim>& _src)
 {
   cudaMemcpyKind kind = cudaMemcpyDeviceToHost;
+  DeviceProfiler::addTransfer(kind, _dst.getSize().getSize() * sizeof(Type));
   if(Dim == 1) {
     cudaMemcpy(_dst.getBuffer(), _src.getBuffer(), _src.getBytes(), kind);
   }
@@ -430,6 +455,7 @@ template<class Type, unsigned Dim> void copy(CudaHostMemoryHeap<Type, Dim>& _dst
 template<class Type, unsigned Dim> void copy(CudaHostMemoryHeap<Type, Dim>& _dst, const CudaArray<Type, Dim>& _src)
 {
   cudaMemcpyKind kind = cudaMemcpyDeviceToHost;
+  DeviceProfiler::addTransfer(kind, _dst.getSize().getSize() * sizeof(Type));
   if(Dim == 1) {
     cudaMemcpyFromArray(_dst.getBuffer(), _src.getArray(), 0, 0, _dst.getSize()[0] * sizeof (Type), kind);
   }
@@ -459,6 +485,7 @@ template<class Type, unsigned Dim> void copy(CudaHostMemoryHeap<Type, Dim>& _dst
 template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>& _dst, const CudaHostMemoryHeap<Type, Dim>& _src)
 {
   cudaMemcpyKind kind = cudaMemcpyHostToDevice;
+  DeviceProfiler::addTransfer(kind, _src.getSize().getSize() * sizeof(Type));
   if(Dim == 1) {
     cudaMemcpy(_dst.getBuffer(), _src.getBuffer(), _src.getBytes(), kind);
   }
@@ -522,6 +549,7 @@ template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>&
 template<class Type, unsigned Dim> void copy(CudaArray<Type, Dim>& _dst, const CudaHostMemoryHeap<Type, Dim>& _src)
 {
   cudaMemcpyKind kind = cudaMemcpyHostToDevice;
+  DeviceProfiler::addTransfer(kind, _src.getSize().getSize() * sizeof(Type));
   if(Dim == 1) {
     cudaMemcpyToArray(_dst.getArray(), 0, 0, _src.getBuffer(), _src.getSize()[0] * sizeof (Type), kind);
   }
@@ -580,6 +608,7 @@ template<class Type, unsigned Dim> void copy(CudaArray<Type, Dim>& _dst, const C
 template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, const CudaDeviceMemoryPitched<Type, Dim>& _src)
 {
   if(Dim == 2) {
+    DeviceProfiler::addTransfer(cudaMemcpyDeviceToHost, sx * sy * sizeof(Type));
     cudaMemcpy2D(_dst, sx * sizeof (Type), _src.getBuffer(), _src.getPitch(), sx * sizeof (Type), sy, cudaMemcpyDeviceToHost);
   }
 }
@@ -587,6 +616,7 @@ template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, c
 template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>& _dst, const Type* _src, size_t sx, size_t sy)
 {
   if(Dim == 2) {
+    DeviceProfiler::addTransfer(cudaMemcpyHostToDevice, sx * sy * sizeof(Type));
     cudaMemcpy2D(_dst.getBuffer(), _dst.getPitch(), _src, sx * sizeof (Type), sx * sizeof(Type), sy, cudaMemcpyHostToDevice);
   }
 }
@@ -594,6 +624,7 @@ template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>&
 template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, size_t sz, const CudaDeviceMemoryPitched<Type, Dim>& _src)
 {
   if(Dim >= 3) {
+    DeviceProfiler::addTransfer(cudaMemcpyDeviceToHost, sx * sy * sz * sizeof(Type));
     for (unsigned int slice=0; slice<sz; slice++)
     {
       cudaMemcpy2D( _dst + sx * sy * slice, sx * sizeof (Type), &_src.getBuffer()[slice * _src.stride()[1]], _src.getPitch(), sx * sizeof (Type), sy, cudaMemcpyDeviceToHost);
@@ -604,6 +635,7 @@ template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, s
 template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>& _dst, const Type* _src, size_t sx, size_t sy, size_t sz)
 {
   if(Dim >= 3) {
+    DeviceProfiler::addTransfer(cudaMemcpyHostToDevice, sx * sy * sz * sizeof(Type));
     for (unsigned int slice=0; slice<sz; slice++)
     {
       cudaMemcpy2D( &_dst.getBuffer()[slice * _dst.stride()[1]], _dst.getPitch(), _src + sx * sy * slice, sx * sizeof (Type), sx * sizeof(Type), sy, cudaMemcpyHostToDevice);
@@ -622,6 +654,19 @@ struct cameraStruct
     int blurid;
 };
 
+/**
+ * @brief Camera of the depth maps consistency filter (see ps_computeDepthMapsConsistency)
+ */
+struct consistencyCameraStruct
+{
+    float P[12], iP[9], C[3];
+    int width;
+    int height;
+    /// device depth map of a target camera
+    const float* depthMap;
+    int depthMap_p;
+};
+
 struct ps_parameters
 {
     int epipShift;
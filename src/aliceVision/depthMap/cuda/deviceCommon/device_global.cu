@@ -112,6 +112,22 @@ __device__ __constant__ float3 sg_s_tXVect; // 3*4 bytes
 __device__ __constant__ float3 sg_s_tYVect; // 3*4 bytes
 __device__ __constant__ float3 sg_s_tZVect; // 3*4 bytes
 
+/**
+ * @brief Target camera of a batched sweep, read from the global memory.
+ *        The image is sampled through a texture object so all the target cameras
+ *        of a reference camera can be used in a single kernel launch.
+ */
+struct targetCameraStruct
+{
+    float P[12];
+    float3 C;
+    cudaTextureObject_t tex;
+    /// first depth index (in the reference camera depths) swept by this camera
+    int depthFrom;
+    /// num. of depths swept by this camera
+    int nDepths;
+};
+
 /*
 __device__ __constant__ struct shared_rCam_tCam
 {
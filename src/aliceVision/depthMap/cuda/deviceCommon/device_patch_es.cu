@@ -16,14 +16,14 @@
 namespace aliceVision {
 namespace depthMap {
 
-__device__ void computeRotCSEpip(patch& ptch, const float3& p)
+__device__ void computeRotCSEpip(patch& ptch, const float3& p, const float3& tC)
 {
     ptch.p = p;
 
     // Vector from the reference camera to the 3d point
     float3 v1 = sg_s_rC - p;
     // Vector from the target camera to the 3d point
-    float3 v2 = sg_s_tC - p;
+    float3 v2 = tC - p;
     normalize(v1);
     normalize(v2);
 
@@ -42,6 +42,11 @@ __device__ void computeRotCSEpip(patch& ptch, const float3& p)
     normalize(ptch.x);
 }
 
+__device__ void computeRotCSEpip(patch& ptch, const float3& p)
+{
+    computeRotCSEpip(ptch, p, sg_s_tC);
+}
+
 __device__ int angleBetwUnitV1andUnitV2(float3& V1, float3& V2)
 {
     return (int)fabs(acos(V1.x * V2.x + V1.y * V2.y + V1.z * V2.z) / (CUDART_PI_F / 180.0f));
@@ -350,6 +355,61 @@ __device__ float compNCCby3DptsYK(patch& ptch, int wsh, int width, int height, c
     return sst.sim;
 }
 
+/**
+ * @brief Same as compNCCby3DptsYK with the target camera given by a texture object,
+ *        used by the batched sweep over all the target cameras.
+ *        Texture objects require a device of compute capability 3.0.
+ */
+__device__ float compNCCby3DptsYK(patch& ptch, int wsh, int width, int height, const float gammaC, const float gammaP,
+                                  const float epipShift, targetCameraStruct& tcam)
+{
+#if __CUDA_ARCH__ >= 300
+    float3 p = ptch.p;
+    float2 rp = project3DPoint(sg_s_rP, p);
+    float2 tp = project3DPoint(tcam.P, p);
+
+    float3 pUp = p + ptch.y * (ptch.d * 10.0f); // assuming that ptch.y is ortogonal to epipolar plane
+    float2 tvUp = project3DPoint(tcam.P, pUp);
+    tvUp = tvUp - tp;
+    normalize(tvUp);
+    float2 vEpipShift = tvUp * epipShift;
+    tp = tp + vEpipShift;
+
+    const float dd = wsh + 2.0f;
+    if((rp.x < dd) || (rp.x > (float)(width  - 1) - dd) ||
+       (rp.y < dd) || (rp.y > (float)(height - 1) - dd) ||
+       (tp.x < dd) || (tp.x > (float)(width  - 1) - dd) ||
+       (tp.y < dd) || (tp.y > (float)(height - 1) - dd))
+    {
+        return 1.0f;
+    }
+
+    float4 gcr = 255.0f * tex2D(r4tex, rp.x + 0.5f, rp.y + 0.5f);
+    float4 gct = 255.0f * tex2D<float4>(tcam.tex, tp.x + 0.5f, tp.y + 0.5f);
+
+    simStat sst = simStat();
+    for(int yp = -wsh; yp <= wsh; yp++)
+    {
+        for(int xp = -wsh; xp <= wsh; xp++)
+        {
+            p = ptch.p + ptch.x * (float)(ptch.d * (float)xp) + ptch.y * (float)(ptch.d * (float)yp);
+            float2 rp1 = project3DPoint(sg_s_rP, p);
+            float2 tp1 = project3DPoint(tcam.P, p) + vEpipShift;
+
+            float4 gcr1 = 255.0f * tex2D(r4tex, rp1.x + 0.5f, rp1.y + 0.5f);
+            float4 gct1 = 255.0f * tex2D<float4>(tcam.tex, tp1.x + 0.5f, tp1.y + 0.5f);
+
+            float w = CostYKfromLab(xp, yp, gcr, gcr1, gammaC, gammaP) * CostYKfromLab(xp, yp, gct, gct1, gammaC, gammaP);
+            sst.update(gcr1.x, gct1.x, w);
+        }
+    }
+    sst.computeWSim();
+    return sst.sim;
+#else
+    return 1.0f;
+#endif
+}
+
 /*
 __device__ float compNCCby3DptsYK(patch &ptch, int wsh, int width, int height, const float gammaC, const float gammaP,
 const float epipShift)
@@ -54,6 +54,102 @@ __global__ void fuse_updateBestGaussianKernelVotingSampleMap_kernel(float2* best
     };
 }
 
+#ifdef ALICEVISION_DEPTHMAP_CUDA_FP16
+
+/**
+ * @brief Precompute the sample index and the similarity weight of a Tc depth/sim map for the Gaussian kernel voting.
+ *        They do not depend on the sample, so the voting only evaluates the Gaussian kernel.
+ * @param[out] out_offsetWeightMaps (sample index, weight) in half precision, one layer per Tc map
+ * @param[in] idCam layer of the Tc map in out_offsetWeightMaps
+ */
+__global__ void fuse_computeGaussianKernelVotingOffsetWeightMap_kernel(__half2* out_offsetWeightMaps,
+                                                                       int out_offsetWeightMaps_s,
+                                                                       int out_offsetWeightMaps_p,
+                                                                       float2* depthSimMap, int depthSimMap_p,
+                                                                       float2* midDepthPixSizeMap, int midDepthPixSizeMap_p,
+                                                                       int width, int height, int idCam,
+                                                                       float samplesPerPixSize)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x >= 0) && (y >= 0) && (x < width) && (y < height))
+    {
+        float2 midDepthPixSize = *get2DBufferAt(midDepthPixSizeMap, midDepthPixSizeMap_p, x, y);
+        float2 depthSim = *get2DBufferAt(depthSimMap, depthSimMap_p, x, y);
+        float i = 0.0f;
+        float sim = 0.0f; // no vote
+
+        if((midDepthPixSize.x > 0.0f) && (depthSim.x > 0.0f))
+        {
+            float depthStep = midDepthPixSize.y / samplesPerPixSize;
+            // clamp far from the samples to stay in the half range
+            i = fminf(fmaxf((midDepthPixSize.x - depthSim.x) / depthStep, -10000.0f), 10000.0f);
+            sim = -sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthSim.y);
+        }
+        *get3DBufferAt(out_offsetWeightMaps, out_offsetWeightMaps_s, out_offsetWeightMaps_p, x, y, idCam) =
+            __floats2half2_rn(i, sim);
+    }
+}
+
+/**
+ * @brief Gaussian kernel voting of all the Tc maps over all the samples in a single pass.
+ *        Two consecutive samples are evaluated at once in the two halves of a __half2,
+ *        the best sample being selected in float.
+ * @param[out] bestGsvSampleMap (best vote, best sample)
+ * @param[in] offsetWeightMaps (sample index, weight) of each Tc map
+ * @param[in] invSqrtTwoSigma 1 / (sqrt(2) * sigma)
+ */
+__global__ void fuse_computeBestGaussianKernelVotingSampleMapHalf_kernel(float2* bestGsvSampleMap, int bestGsvSampleMap_p,
+                                                                         const __half2* offsetWeightMaps,
+                                                                         int offsetWeightMaps_s, int offsetWeightMaps_p,
+                                                                         int width, int height, int nMaps,
+                                                                         int nSamplesHalf, float invSqrtTwoSigma)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x >= 0) && (y >= 0) && (x < width) && (y < height))
+    {
+        float2 bestGsvSample = make_float2(0.0f, (float)(-nSamplesHalf));
+
+        for(int s = -nSamplesHalf; s <= nSamplesHalf; s += 2)
+        {
+#if __CUDA_ARCH__ >= 530
+            const __half2 samples = __floats2half2_rn((float)s, (float)(s + 1));
+            const __half2 scale = __float2half2_rn(invSqrtTwoSigma);
+            __half2 gsv = __float2half2_rn(0.0f);
+            for(int c = 0; c < nMaps; c++)
+            {
+                const __half2 offsetWeight = *get3DBufferAt(offsetWeightMaps, offsetWeightMaps_s, offsetWeightMaps_p, x, y, c);
+                // scale before squaring to stay in the half range
+                const __half2 d = __hmul2(__hsub2(__low2half2(offsetWeight), samples), scale);
+                gsv = __hfma2(__high2half2(offsetWeight), h2exp(__hneg2(__hmul2(d, d))), gsv);
+            }
+            const float2 gsvSamples = __half22float2(gsv);
+#else
+            // no half arithmetic on this architecture, only the storage is in half precision
+            float2 gsvSamples = make_float2(0.0f, 0.0f);
+            for(int c = 0; c < nMaps; c++)
+            {
+                const float2 offsetWeight = __half22float2(*get3DBufferAt(offsetWeightMaps, offsetWeightMaps_s, offsetWeightMaps_p, x, y, c));
+                const float d0 = (offsetWeight.x - (float)s) * invSqrtTwoSigma;
+                const float d1 = (offsetWeight.x - (float)(s + 1)) * invSqrtTwoSigma;
+                gsvSamples.x += offsetWeight.y * expf(-d0 * d0);
+                gsvSamples.y += offsetWeight.y * expf(-d1 * d1);
+            }
+#endif
+            if(s == -nSamplesHalf || gsvSamples.x < bestGsvSample.x)
+                bestGsvSample = make_float2(gsvSamples.x, (float)s);
+            if(s + 1 <= nSamplesHalf && gsvSamples.y < bestGsvSample.x)
+                bestGsvSample = make_float2(gsvSamples.y, (float)(s + 1));
+        }
+        *get2DBufferAt(bestGsvSampleMap, bestGsvSampleMap_p, x, y) = bestGsvSample;
+    }
+}
+
+#endif
+
 __global__ void fuse_computeFusedDepthSimMapFromBestGaussianKernelVotingSampleMap_kernel(
     float2* oDepthSimMap, int oDepthSimMap_p, float2* bestGsvSampleMap, int bestGsvSampleMap_p,
     float2* midDepthPixSizeMap, int midDepthPixSizeMap_p, int width, int height, float samplesPerPixSize)
@@ -166,11 +262,21 @@ __device__ float2 getCellSmoothStepEnergy(const int2& cell0)
     return out;
 }
 
+/**
+ * @brief One gradient descent iteration of the depth map.
+ *        If blockActive is not null, the converged thread blocks (0 in blockActive) are skipped
+ *        and each block writes its largest depth step (in pixel size) in blockMaxStep.
+ */
 __global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int optDepthSimMap_p,
                                                 float2* midDepthPixSizeMap, int midDepthPixSizeMap_p,
                                                 float2* fusedDepthSimMap, int fusedDepthSimMap_p, int width, int height,
-                                                int iter, float samplesPerPixSize, int yFrom)
+                                                int iter, float samplesPerPixSize, int yFrom,
+                                                const unsigned char* blockActive, int blockActive_p,
+                                                float* blockMaxStep, int blockMaxStep_p)
 {
+    if((blockActive != NULL) && (*get2DBufferAt(blockActive, blockActive_p, blockIdx.x, blockIdx.y) == 0))
+        return;
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix = make_int2(x, y);
@@ -236,6 +342,13 @@ __global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int
 
             out_optDepthSim.x = depthOpt + depthOptStep;
 
+            if((blockMaxStep != NULL) && (midDepthPixSize.y > 0.0f))
+            {
+                // the float bits of positive values are ordered as integers
+                const float step = fabsf(depthOptStep) / midDepthPixSize.y;
+                atomicMax((int*)get2DBufferAt(blockMaxStep, blockMaxStep_p, blockIdx.x, blockIdx.y), __float_as_int(step));
+            }
+
             // archive: 
             // optDepthSim.y = -photoWeight * simWeight
             // 0.6:
@@ -246,5 +359,131 @@ __global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int
     };
 }
 
+/**
+ * @brief Update the active thread blocks of fuse_optimizeDepthSimMap_kernel (one thread per block).
+ *        A block is converged when the depth steps of the block and of its 4 neighbors stay below
+ *        convergenceThr for nStableIters iterations. It is reactivated if a neighbor moves again.
+ */
+__global__ void fuse_updateActiveBlocks_kernel(unsigned char* blockActive, int blockActive_p,
+                                               unsigned char* blockStableIters, int blockStableIters_p,
+                                               const float* blockMaxStep, int blockMaxStep_p, int nBlocksX,
+                                               int nBlocksY, float convergenceThr, int nStableIters, int* nActiveBlocks)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x >= nBlocksX) || (y >= nBlocksY))
+        return;
+
+    float maxStep = *get2DBufferAt(blockMaxStep, blockMaxStep_p, x, y);
+    if(x > 0)
+        maxStep = fmaxf(maxStep, *get2DBufferAt(blockMaxStep, blockMaxStep_p, x - 1, y));
+    if(x < nBlocksX - 1)
+        maxStep = fmaxf(maxStep, *get2DBufferAt(blockMaxStep, blockMaxStep_p, x + 1, y));
+    if(y > 0)
+        maxStep = fmaxf(maxStep, *get2DBufferAt(blockMaxStep, blockMaxStep_p, x, y - 1));
+    if(y < nBlocksY - 1)
+        maxStep = fmaxf(maxStep, *get2DBufferAt(blockMaxStep, blockMaxStep_p, x, y + 1));
+
+    unsigned char* stableIters = get2DBufferAt(blockStableIters, blockStableIters_p, x, y);
+    *stableIters = (maxStep < convergenceThr) ? min((int)*stableIters + 1, 255) : 0;
+
+    const bool active = (*stableIters < nStableIters);
+    *get2DBufferAt(blockActive, blockActive_p, x, y) = active ? 1 : 0;
+    if(active)
+        atomicAdd(nActiveBlocks, 1);
+}
+
+/**
+ * @brief Consistency of the rc depth map with a batch of tc depth maps (see fuseCut::Fuser::filterGroupsRC).
+ *        Each thread back projects a pixel of a tc depth map (one tc per grid z) and projects it into rc.
+ *        The bit of the tc is set in the mask of the rc pixels around the projection with a close depth.
+ */
+__global__ void fuse_computeConsistencyMask_kernel(unsigned int* mask, int mask_p, const float* rcDepthMap,
+                                                   int rcDepthMap_p, const float* rcSimMap, int rcSimMap_p,
+                                                   consistencyCameraStruct rcam, const consistencyCameraStruct* tcams,
+                                                   int pixSizeBall, int pixSizeBallWSP, int border)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    const int c = blockIdx.z;
+
+    consistencyCameraStruct tcam = tcams[c];
+    if((x >= tcam.width) || (y >= tcam.height))
+        return;
+
+    const float depth = *get2DBufferAt(tcam.depthMap, tcam.depthMap_p, x, y);
+    if(depth <= 0.0f)
+        return;
+
+    const float3 rC = make_float3(rcam.C[0], rcam.C[1], rcam.C[2]);
+    const float3 tC = make_float3(tcam.C[0], tcam.C[1], tcam.C[2]);
+
+    float3 tvect = M3x3mulV2(tcam.iP, make_float2((float)x, (float)y));
+    normalize(tvect);
+    const float3 p = tC + tvect * depth;
+
+    // projection in rc (as MultiViewParams::getPixelFor3DPoint)
+    const float3 rp = M3x4mulV3(rcam.P, p);
+    if(rp.z <= 0.0f)
+        return;
+    const float2 rpix = make_float2(rp.x / rp.z, rp.y / rp.z);
+    const int cellX = (int)floorf(rpix.x + 0.5f);
+    const int cellY = (int)floorf(rpix.y + 0.5f);
+    if((cellX < border) || (cellX >= rcam.width - border) || (cellY < border) || (cellY >= rcam.height - border))
+        return;
+
+    const float pixDepth = size(rC - p);
+    const float sim = *get2DBufferAt(rcSimMap, rcSimMap_p, cellX, cellY);
+    const int d = (sim >= 1.0f) ? pixSizeBallWSP : pixSizeBall;
+
+    // pixel size in rc (as MultiViewParams::getCamPixelSize)
+    float3 rvect = M3x3mulV2(rcam.iP, make_float2(rpix.x + 1.0f, rpix.y));
+    normalize(rvect);
+    const float rcPixSize = pointLineDistance3D(p, rC, rvect);
+
+    // distance along the rc ray for a 1 pixel shift on the tc epipolar line (as MultiViewParams::getCamPixelSizeRcTc)
+    float rcTcPixSize = rcPixSize;
+    {
+        float3 rdir = p - rC;
+        normalize(rdir);
+        const float2 tp = project3DPoint(tcam.P, p);
+        const float2 tp1 = project3DPoint(tcam.P, p + rdir * rcPixSize);
+        const float shift = size(tp1 - tp);
+        if(shift > 1e-6f)
+            rcTcPixSize = rcPixSize / shift;
+    }
+
+    // 2 * MultiViewParams::getCamPixelSizePlaneSweepAlpha
+    const float pixSize = rcPixSize + rcTcPixSize;
+
+    const unsigned int bit = 1u << c;
+    for(int ny = max(0, cellY - d); ny <= min(rcam.height - 1, cellY + d); ny++)
+    {
+        for(int nx = max(0, cellX - d); nx <= min(rcam.width - 1, cellX + d); nx++)
+        {
+            if(fabsf(pixDepth - *get2DBufferAt(rcDepthMap, rcDepthMap_p, nx, ny)) < pixSize)
+                atomicOr(get2DBufferAt(mask, mask_p, nx, ny), bit);
+        }
+    }
+}
+
+/**
+ * @brief Add the num. of consistent tcams of a batch to the num. of modals and reset the consistency mask
+ */
+__global__ void fuse_accumulateConsistencyMask_kernel(unsigned char* numOfModals, int numOfModals_p,
+                                                      unsigned int* mask, int mask_p, int width, int height)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x < width) && (y < height))
+    {
+        unsigned int* m = get2DBufferAt(mask, mask_p, x, y);
+        *get2DBufferAt(numOfModals, numOfModals_p, x, y) += __popc(*m);
+        *m = 0;
+    }
+}
+
 } // namespace depthMap
 } // namespace aliceVision
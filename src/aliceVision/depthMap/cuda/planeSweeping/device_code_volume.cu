@@ -21,6 +21,16 @@ __device__ void volume_computePatch(patch& ptch, int depthid, int2& pix)
     computeRotCSEpip(ptch, p);
 }
 
+__device__ void volume_computePatch(patch& ptch, int depthid, int2& pix, const float3& tC)
+{
+    float fpPlaneDepth = tex2D(depthsTex, depthid, 0);
+    float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
+
+    ptch.p = p;
+    ptch.d = computePixSize(p);
+    computeRotCSEpip(ptch, p, tC);
+}
+
 __global__ void volume_slice_kernel(unsigned char* slice, int slice_p,
                                     // float3* slicePts, int slicePts_p,
                                     int nsearchdepths, int ndepths, int slicesAtTime, int width, int height, int wsh,
@@ -57,6 +67,66 @@ __global__ void volume_slice_kernel(unsigned char* slice, int slice_p,
     }
 }
 
+/**
+ * @brief Similarity slice computed with all the target cameras in a single launch.
+ *        Each target camera only sweeps its own depth range and the result is the second best
+ *        similarity over the target cameras, as SemiGlobalMatchingVolume::addVolumeSecondMin
+ *        applied on the per target camera volumes.
+ * @param[in] P3 similarity of the last 4 depths of each target camera range (not used if 0)
+ */
+__global__ void volume_sliceAllTc_kernel(unsigned char* slice, int slice_p, targetCameraStruct* tcams, int ntcams,
+                                         int nsearchdepths, int ndepths, int slicesAtTime, int width, int height,
+                                         int wsh, int t, int npixs, const float gammaC, const float gammaP,
+                                         const float epipShift, unsigned char P3)
+{
+    int sdptid = blockIdx.x * blockDim.x + threadIdx.x;
+    int pixid = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((sdptid < nsearchdepths) && (pixid < slicesAtTime) && (slicesAtTime * t + pixid < npixs))
+    {
+        int4 volPix = tex2D(volPixsTex, pixid, t);
+        int2 pix = make_int2(volPix.x, volPix.y);
+        int depthid = sdptid + volPix.z;
+
+        if(depthid < ndepths)
+        {
+            unsigned char best = 255;
+            unsigned char secondBest = 255;
+
+            for(int c = 0; c < ntcams; c++)
+            {
+                targetCameraStruct& tcam = tcams[c];
+                if((depthid < tcam.depthFrom) || (depthid >= tcam.depthFrom + tcam.nDepths))
+                    continue;
+
+                unsigned char sim = P3;
+                if((P3 == 0) || (depthid < tcam.depthFrom + tcam.nDepths - 4))
+                {
+                    patch ptcho;
+                    volume_computePatch(ptcho, depthid, pix, tcam.C);
+
+                    float fsim = compNCCby3DptsYK(ptcho, wsh, width, height, gammaC, gammaP, epipShift, tcam);
+                    fsim = (fsim + 1.0f) / 2.0f;
+                    fsim = fminf(1.0f, fmaxf(0.0f, fsim));
+                    sim = (unsigned char)(fsim * 255.0f);
+                }
+
+                if(sim < best)
+                {
+                    secondBest = best;
+                    best = sim;
+                }
+                else if(sim < secondBest)
+                {
+                    secondBest = sim;
+                }
+            }
+
+            *get2DBufferAt(slice, slice_p, sdptid, pixid) = secondBest;
+        }
+    }
+}
+
 __global__ void volume_saveSliceToVolume_kernel(unsigned char* volume, int volume_s, int volume_p, unsigned char* slice,
                                                 int slice_p, int nsearchdepths, int ndepths, int slicesAtTime,
                                                 int width, int height, int t, int npixs, int volStepXY, int volDimX,
@@ -313,10 +383,10 @@ __global__ void volume_agregateCostVolumeAtZinSlices_kernel(unsigned int* xySlic
         {
             int z = doInvZ ? volDimZ - vz : vz;
             int z1 = doInvZ ? z + 1 : z - 1; // M1
-            int imX0 = volLUX + (dimTrnX == 0) ? vx : z; // current
-            int imY0 = volLUY + (dimTrnX == 0) ?  z : vx;
-            int imX1 = volLUX + (dimTrnX == 0) ? vx : z1; // M1
-            int imY1 = volLUY + (dimTrnX == 0) ? z1 : vx;
+            int imX0 = volLUX + ((dimTrnX == 0) ? vx : z); // current
+            int imY0 = volLUY + ((dimTrnX == 0) ?  z : vx);
+            int imX1 = volLUX + ((dimTrnX == 0) ? vx : z1); // M1
+            int imY1 = volLUY + ((dimTrnX == 0) ? z1 : vx);
             float4 gcr0 = 255.0f * tex2D(r4tex, (float)imX0 + 0.5f, (float)imY0 + 0.5f);
             float4 gcr1 = 255.0f * tex2D(r4tex, (float)imX1 + 0.5f, (float)imY1 + 0.5f);
             float deltaC = Euclidean3(gcr0, gcr1);
@@ -345,6 +415,134 @@ __global__ void volume_agregateCostVolumeAtZinSlices_kernel(unsigned int* xySlic
     }
 }
 
+/**
+ * @brief Minimum of a value over the threads of a block.
+ * @param[in] value the value of the current thread
+ * @param[in] sharedBuffer shared memory of blockDim.x values
+ * @param[out] sharedResult shared memory receiving the minimum
+ * @return the minimum (in all the threads)
+ */
+__device__ unsigned int volume_blockMinUInt(unsigned int value, unsigned int* sharedBuffer, unsigned int* sharedResult)
+{
+#if __CUDA_ARCH__ >= 300
+    // reduction in each warp with shuffles, then over the warps
+    for(int offset = warpSize / 2; offset > 0; offset /= 2)
+    {
+#if CUDART_VERSION >= 9000
+        value = min(value, __shfl_down_sync(0xffffffff, value, offset));
+#else
+        value = min(value, __shfl_down(value, offset));
+#endif
+    }
+    if((threadIdx.x % warpSize) == 0)
+        sharedBuffer[threadIdx.x / warpSize] = value;
+    const int nValues = (blockDim.x + warpSize - 1) / warpSize;
+#else
+    sharedBuffer[threadIdx.x] = value;
+    const int nValues = blockDim.x;
+#endif
+    __syncthreads();
+
+    if(threadIdx.x == 0)
+    {
+        unsigned int minValue = sharedBuffer[0];
+        for(int i = 1; i < nValues; i++)
+            minValue = min(minValue, sharedBuffer[i]);
+        *sharedResult = minValue;
+    }
+    __syncthreads();
+
+    return *sharedResult;
+}
+
+/**
+ * @brief Aggregate the SGM path costs along one direction directly in the (X, Y, Z) similarity volume.
+ *        Each block processes a whole scanline (an image row or column) pixel after pixel,
+ *        with its threads distributed over the depths. The path costs of the previous pixel
+ *        and their minimum stay in shared memory, so no transposition or per slice launch is needed.
+ * @param[inout] volAgr aggregated volume (running average of the paths)
+ * @param[in] volSim similarity volume
+ * @param[in] pathDir direction of the path: 0 (+x), 1 (-x), 2 (+y), 3 (-y)
+ * @param[in] lastN number of paths already aggregated in volAgr
+ */
+__global__ void volume_aggregateCostVolumeAlongPath_kernel(unsigned char* volAgr, int volAgr_s, int volAgr_p,
+                                                           const unsigned char* volSim, int volSim_s, int volSim_p,
+                                                           int volDimX, int volDimY, int volDimZ,
+                                                           int pathDir, unsigned int _P1, int volLUX, int volLUY,
+                                                           int lastN)
+{
+    // shared memory: path costs of the previous and current pixels (volDimZ each), reduction buffer (blockDim.x)
+    extern __shared__ unsigned int sharedMem[];
+    __shared__ unsigned int bestCostM1;
+
+    unsigned int* pathCostsM1 = sharedMem;
+    unsigned int* pathCosts = sharedMem + volDimZ;
+    unsigned int* reductionBuffer = sharedMem + 2 * volDimZ;
+
+    const bool alongX = (pathDir < 2);
+    const bool forward = (pathDir % 2 == 0);
+    const int line = blockIdx.x;
+    const int lineLength = alongX ? volDimX : volDimY;
+
+    if(line >= (alongX ? volDimY : volDimX))
+        return;
+
+    for(int i = 0; i < lineLength; i++)
+    {
+        const int t = forward ? i : lineLength - 1 - i;
+        const int vx = alongX ? t : line;
+        const int vy = alongX ? line : t;
+
+        unsigned int P2 = 0;
+        if(i > 0)
+        {
+            const int tM1 = forward ? t - 1 : t + 1;
+            const int vxM1 = alongX ? tM1 : vx;
+            const int vyM1 = alongX ? vy : tM1;
+            float4 gcr0 = 255.0f * tex2D(r4tex, (float)(volLUX + vx) + 0.5f, (float)(volLUY + vy) + 0.5f);
+            float4 gcr1 = 255.0f * tex2D(r4tex, (float)(volLUX + vxM1) + 0.5f, (float)(volLUY + vyM1) + 0.5f);
+            float deltaC = Euclidean3(gcr0, gcr1);
+            // 15.0 + (255.0 - 15.0) * (1.0 / (1.0 + exp(10.0 * ((x - 20.) / 80.))))
+            P2 = (unsigned int)sigmoid(15.0f, 255.0f, 80.0f, 20.0f, deltaC);
+        }
+
+        unsigned int localBestCost = 0xFFFFFFFF;
+        for(int vz = threadIdx.x; vz < volDimZ; vz += blockDim.x)
+        {
+            unsigned int sim = *get3DBufferAt(volSim, volSim_s, volSim_p, vx, vy, vz);
+            unsigned int pathCost = sim; // first pixel of the path
+            unsigned int outCost = 255;
+
+            if(i > 0)
+            {
+                pathCost = 255;
+                if((vz >= 1) && (vz < volDimZ - 1))
+                {
+                    unsigned int minCost = min(pathCostsM1[vz], pathCostsM1[vz - 1] + _P1);
+                    minCost              = min(minCost,         pathCostsM1[vz + 1] + _P1);
+                    minCost              = min(minCost,         bestCostM1 + P2);
+                    pathCost = sim + minCost - bestCostM1;
+                }
+                outCost = min(255, pathCost);
+            }
+            pathCosts[vz] = pathCost;
+            localBestCost = min(localBestCost, pathCost);
+
+            unsigned char* agr_zyx = get3DBufferAt(volAgr, volAgr_s, volAgr_p, vx, vy, vz);
+            float val = ((float)(*agr_zyx) * (float)lastN + (float)outCost) / (float)(lastN + 1);
+            *agr_zyx = (unsigned char)(fminf(255.0f, val));
+        }
+
+        // the minimum over the depths is needed for the next pixel,
+        // the synchronizations also protect pathCostsM1 and bestCostM1 before they are overwritten
+        volume_blockMinUInt(localBestCost, reductionBuffer, &bestCostM1);
+
+        unsigned int* tmp = pathCostsM1;
+        pathCostsM1 = pathCosts;
+        pathCosts = tmp;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 __global__ void volume_updateRcVolumeForTcDepthMap_kernel(unsigned int* volume, int volume_s, int volume_p,
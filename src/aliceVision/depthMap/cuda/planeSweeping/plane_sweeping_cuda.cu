@@ -5,6 +5,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/depthMap/cuda/commonStructures.hpp>
+
+#if CUDART_VERSION >= 7050
+#include <cuda_fp16.h>
+#define ALICEVISION_DEPTHMAP_CUDA_FP16
+#endif
+
+#if CUDART_VERSION >= 10020
+#define ALICEVISION_DEPTHMAP_CUDA_GRAPHS
+#endif
+
 #include <aliceVision/depthMap/cuda/deviceCommon/device_color.cu>
 #include <aliceVision/depthMap/cuda/deviceCommon/device_patch_es.cu>
 #include <aliceVision/depthMap/cuda/deviceCommon/device_eig33.cu>
@@ -16,6 +26,10 @@
 #include <math_constants.h>
 
 #include <algorithm>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <vector>
 
 namespace aliceVision {
 namespace depthMap {
@@ -237,6 +251,7 @@ int ps_listCUDADevices(bool verbose)
 void ps_deviceAllocate(CudaArray<uchar4, 2>*** ps_texs_arr, int ncams, int width, int height, int scales,
                        int deviceId)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     int num_gpus = 0;
     cudaGetDeviceCount(&num_gpus);
 
@@ -319,6 +334,11 @@ void ps_deviceAllocate(CudaArray<uchar4, 2>*** ps_texs_arr, int ncams, int width
     // printf("ps_deviceAllocate - done\n");
 }
 
+void ps_setCUDADevice(int CUDAdeviceNo)
+{
+    cudaSetDevice(CUDAdeviceNo);
+}
+
 void testCUDAdeviceNo(int CUDAdeviceNo)
 {
     int myCUDAdeviceNo;
@@ -329,31 +349,192 @@ void testCUDAdeviceNo(int CUDAdeviceNo)
     };
 }
 
+static bool ps_useCudaGraphs = false;
+
+void ps_setUseCudaGraphs(bool useCudaGraphs)
+{
+#ifdef ALICEVISION_DEPTHMAP_CUDA_GRAPHS
+    ps_useCudaGraphs = useCudaGraphs;
+#else
+    if(useCudaGraphs)
+        printf("WARNING CUDA graphs need CUDA 10.2, the kernels are launched one by one\n");
+#endif
+}
+
+#ifdef ALICEVISION_DEPTHMAP_CUDA_GRAPHS
+/**
+ * @brief Executable CUDA graphs of the current thread, per device and sequence configuration,
+ *        and the stream used to capture and replay them.
+ */
+struct ps_graphCache
+{
+    cudaStream_t stream = 0;
+    std::map<std::vector<int>, cudaGraphExec_t> graphs;
+
+    ~ps_graphCache()
+    {
+        for(auto& graph : graphs)
+            cudaGraphExecDestroy(graph.second);
+        if(stream != 0)
+            cudaStreamDestroy(stream);
+    }
+};
+
+static ps_graphCache& ps_getGraphCache()
+{
+    thread_local ps_graphCache cache;
+    if(cache.stream == 0)
+    {
+        // blocking stream: ordered with the work of the default stream
+        cudaStreamCreate(&cache.stream);
+    }
+    return cache;
+}
+#endif
+
+/**
+ * @brief Run a sequence of kernel launches and wait for it.
+ *
+ * With CUDA graphs enabled, the sequence is captured (the launches are only recorded)
+ * and replayed as a single graph launch. The executable graph is instantiated once per
+ * configuration, the next sequences of this configuration only update its kernel parameters.
+ * The configuration must identify the topology of the sequence: number and order of the
+ * kernels, grid and block sizes.
+ *
+ * @param[in] configuration the sequence name and sizes
+ * @param[in] launches enqueue the kernels on the given stream
+ */
+template <class Launches>
+void ps_runKernelSequence(std::vector<int> configuration, const Launches& launches)
+{
+#ifdef ALICEVISION_DEPTHMAP_CUDA_GRAPHS
+    if(ps_useCudaGraphs)
+    {
+        ps_graphCache& cache = ps_getGraphCache();
+
+        int CUDAdeviceNo = 0;
+        cudaGetDevice(&CUDAdeviceNo);
+        configuration.push_back(CUDAdeviceNo);
+
+        cudaGraph_t graph;
+        cudaStreamBeginCapture(cache.stream, cudaStreamCaptureModeThreadLocal);
+        launches(cache.stream);
+        cudaStreamEndCapture(cache.stream, &graph);
+
+        cudaGraphExec_t& graphExec = cache.graphs[configuration];
+        if(graphExec != nullptr)
+        {
+            cudaGraphNode_t errorNode;
+            cudaGraphExecUpdateResult updateResult;
+            if(cudaGraphExecUpdate(graphExec, graph, &errorNode, &updateResult) != cudaSuccess)
+            {
+                // topology changed: instantiate a new graph
+                cudaGetLastError();
+                cudaGraphExecDestroy(graphExec);
+                graphExec = nullptr;
+            }
+        }
+        if(graphExec == nullptr)
+            cudaGraphInstantiate(&graphExec, graph, nullptr, nullptr, 0);
+        cudaGraphDestroy(graph);
+
+        cudaGraphLaunch(graphExec, cache.stream);
+        cudaStreamSynchronize(cache.stream);
+        CHECK_CUDA_ERROR();
+        return;
+    }
+#endif
+    launches(cudaStream_t(0));
+    cudaThreadSynchronize();
+    CHECK_CUDA_ERROR();
+}
+
+/**
+ * @brief Per device resources used to upload the cameras:
+ *        an upload stream, a scratch buffer and the gaussian kernels of each scale.
+ *        They are allocated once, so no allocation (and no implicit device synchronization)
+ *        happens during an upload.
+ */
+struct ps_uploadContext
+{
+    cudaStream_t stream;
+    CudaDeviceMemoryPitched<uchar4, 2>* tex_lab_dmp;
+    std::vector<cudaArray*> gaussian_arr; // one per scale (radius: scale + 1)
+};
+
+void* ps_createUploadContext(int CUDAdeviceNo, int w, int h, int scales)
+{
+    testCUDAdeviceNo(CUDAdeviceNo);
+
+    ps_uploadContext* ctx = new ps_uploadContext();
+    // blocking stream: the work of the default stream waits for the uploads
+    cudaStreamCreate(&ctx->stream);
+    ctx->tex_lab_dmp = new CudaDeviceMemoryPitched<uchar4, 2>(CudaSize<2>(w, h));
+    ctx->gaussian_arr.resize(scales, nullptr);
+    for(int scale = 1; scale < scales; scale++)
+        ctx->gaussian_arr[scale] = ps_create_gaussian_arr(1.0f, scale + 1);
+
+    CHECK_CUDA_ERROR();
+    return ctx;
+}
+
+void ps_destroyUploadContext(void* uploadContext, int CUDAdeviceNo)
+{
+    testCUDAdeviceNo(CUDAdeviceNo);
+
+    ps_uploadContext* ctx = (ps_uploadContext*)uploadContext;
+    cudaStreamSynchronize(ctx->stream);
+    for(cudaArray* gaussian_arr : ctx->gaussian_arr)
+    {
+        if(gaussian_arr != nullptr)
+            cudaFreeArray(gaussian_arr);
+    }
+    delete ctx->tex_lab_dmp;
+    cudaStreamDestroy(ctx->stream);
+    delete ctx;
+
+    CHECK_CUDA_ERROR();
+}
+
 void ps_deviceUpdateCam(CudaArray<uchar4, 2>** ps_texs_arr, cameraStruct* cam, int camId, int CUDAdeviceNo,
-                        int ncamsAllocated, int scales, int w, int h, int varianceWsh)
+                        int ncamsAllocated, int scales, int w, int h, int varianceWsh, void* uploadContext)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
+    ps_uploadContext* ctx = (ps_uploadContext*)uploadContext;
+    cudaStream_t stream = ctx->stream;
+    CudaDeviceMemoryPitched<uchar4, 2>& tex_lab_dmp = *ctx->tex_lab_dmp;
+
+    // the previous upload uses the same scratch buffer and textures:
+    // wait for it, the host work done meanwhile (image loading) is overlapped with it
+    cudaStreamSynchronize(stream);
+
+    // the upload and the kernels are queued on the upload stream,
+    // the work submitted later on the default stream waits for them
+    const size_t rowBytes = w * sizeof(uchar4);
+
     // compute gradient
     {
-        CudaDeviceMemoryPitched<uchar4, 2> tex_lab_dmp(CudaSize<2>(w, h));
-        copy(tex_lab_dmp, (*cam->tex_rgba_hmh));
+        cudaMemcpy2DAsync(tex_lab_dmp.getBuffer(), tex_lab_dmp.getPitch(), cam->tex_rgba_hmh->getBuffer(), rowBytes,
+                          rowBytes, h, cudaMemcpyHostToDevice, stream);
+        DeviceProfiler::addTransfer(cudaMemcpyHostToDevice, rowBytes * h);
 
         int block_size = 8;
         dim3 block(block_size, block_size, 1);
         dim3 grid(divUp(w, block_size), divUp(h, block_size), 1);
-        rgb2lab_kernel<<<grid, block>>>(tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0], w, h);
-        cudaThreadSynchronize();
-        copy((*ps_texs_arr[camId * scales + 0]), tex_lab_dmp);
+        rgb2lab_kernel<<<grid, block, 0, stream>>>(tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0], w, h);
+        cudaMemcpy2DToArrayAsync(ps_texs_arr[camId * scales + 0]->getArray(), 0, 0, tex_lab_dmp.getBuffer(),
+                                 tex_lab_dmp.getPitch(), rowBytes, h, cudaMemcpyDeviceToDevice, stream);
 
         if(varianceWsh > 0)
         {
             cudaBindTextureToArray(r4tex, ps_texs_arr[camId * scales + 0]->getArray(), cudaCreateChannelDesc<uchar4>());
-            compute_varLofLABtoW_kernel<<<grid, block>>>(tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0], w, h,
-                                                         varianceWsh);
-            cudaThreadSynchronize();
+            compute_varLofLABtoW_kernel<<<grid, block, 0, stream>>>(tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0], w, h,
+                                                                    varianceWsh);
             cudaUnbindTexture(r4tex);
-            copy((*ps_texs_arr[camId * scales + 0]), tex_lab_dmp);
+            cudaMemcpy2DToArrayAsync(ps_texs_arr[camId * scales + 0]->getArray(), 0, 0, tex_lab_dmp.getBuffer(),
+                                     tex_lab_dmp.getPitch(), rowBytes, h, cudaMemcpyDeviceToDevice, stream);
         };
     }
 
@@ -363,38 +544,40 @@ void ps_deviceUpdateCam(CudaArray<uchar4, 2>** ps_texs_arr, cameraStruct* cam, i
     for(int scale = 1; scale < scales; scale++)
     {
         int radius = scale + 1;
-        cudaArray* gaussian_arr = ps_create_gaussian_arr(1.0f, radius);
-        cudaBindTextureToArray(gaussianTex, gaussian_arr, cudaCreateChannelDesc<float>());
+        cudaBindTextureToArray(gaussianTex, ctx->gaussian_arr[scale], cudaCreateChannelDesc<float>());
+
+        const int ws = w / (scale + 1);
+        const int hs = h / (scale + 1);
+        const size_t rowBytesScale = ws * sizeof(uchar4);
 
         int block_size = 8;
         dim3 block(block_size, block_size, 1);
-        dim3 grid(divUp(w / (scale + 1), block_size), divUp(h / (scale + 1), block_size), 1);
+        dim3 grid(divUp(ws, block_size), divUp(hs, block_size), 1);
 
-        CudaDeviceMemoryPitched<uchar4, 2> tex_lab_dmp(CudaSize<2>(w / (scale + 1), h / (scale + 1)));
+        // the scratch buffer is large enough for all the scales (same pitch)
         // downscale_bilateral_smooth_lab_kernel<<<grid, block>>>(
-        downscale_gauss_smooth_lab_kernel<<<grid, block>>>(
+        downscale_gauss_smooth_lab_kernel<<<grid, block, 0, stream>>>(
             // downscale_mean_smooth_lab_kernel<<<grid, block>>>(
-            tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0], w / (scale + 1), h / (scale + 1), scale + 1,
+            tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0], ws, hs, scale + 1,
             radius //, 15.5f
             );
-        cudaThreadSynchronize();
-        copy((*ps_texs_arr[camId * scales + scale]), tex_lab_dmp);
+        cudaMemcpy2DToArrayAsync(ps_texs_arr[camId * scales + scale]->getArray(), 0, 0, tex_lab_dmp.getBuffer(),
+                                 tex_lab_dmp.getPitch(), rowBytesScale, hs, cudaMemcpyDeviceToDevice, stream);
 
         if(varianceWsh > 0)
         {
             cudaUnbindTexture(r4tex);
             cudaBindTextureToArray(r4tex, ps_texs_arr[camId * scales + scale]->getArray(),
                                    cudaCreateChannelDesc<uchar4>());
-            compute_varLofLABtoW_kernel<<<grid, block>>>(tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0],
-                                                         w / (scale + 1), h / (scale + 1), varianceWsh);
-            cudaThreadSynchronize();
+            compute_varLofLABtoW_kernel<<<grid, block, 0, stream>>>(tex_lab_dmp.getBuffer(), tex_lab_dmp.stride()[0],
+                                                                    ws, hs, varianceWsh);
             cudaUnbindTexture(r4tex);
-            copy((*ps_texs_arr[camId * scales + scale]), tex_lab_dmp);
+            cudaMemcpy2DToArrayAsync(ps_texs_arr[camId * scales + scale]->getArray(), 0, 0, tex_lab_dmp.getBuffer(),
+                                     tex_lab_dmp.getPitch(), rowBytesScale, hs, cudaMemcpyDeviceToDevice, stream);
             cudaBindTextureToArray(r4tex, ps_texs_arr[camId * scales + 0]->getArray(), cudaCreateChannelDesc<uchar4>());
         };
 
         cudaUnbindTexture(gaussianTex);
-        cudaFreeArray(gaussian_arr);
     };
 
     cudaUnbindTexture(r4tex);
@@ -427,6 +610,7 @@ void ps_planeSweepingGPUPixels(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemor
                                CudaHostMemoryHeap<int,2>  &bdid_hmh*/
                                )
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -704,34 +888,31 @@ void ps_updateAggrVolume(CudaDeviceMemoryPitched<unsigned char, 3>& volAgr_dmp,
     // clock_t tall = tic();
     CudaDeviceMemoryPitched<unsigned char, 3> d_volSimT(
         CudaSize<3>(volDims[dimsTrn[0]], volDims[dimsTrn[1]], volDims[dimsTrn[2]]));
-    for(int z = 0; z < volDimZ; z++)
-    {
-        volume_transposeVolume_kernel<<<grid, block>>>(
-            d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0], // output
-            d_volSim.getBuffer(), d_volSim.stride()[1], d_volSim.stride()[0], // input
-            volDimX, volDimY, volDimZ,
-            dimTrnX, dimTrnY, dimTrnZ,
-            z);
-    };
-    cudaThreadSynchronize();
-    CHECK_CUDA_ERROR();
-    // if (verbose) printf("transpose volume gpu elapsed time: %f ms \n", toc(tall));
-    // pr_printfDeviceMemoryInfo();
-
-    if(doInvZ == true)
+    const int transposeSequenceId = 1;
+    ps_runKernelSequence({transposeSequenceId, volDimX, volDimY, volDimZ, dimTrnX, dimTrnY, dimTrnZ, doInvZ},
+                         [&](cudaStream_t stream)
     {
-        // clock_t tall = tic();
-        for(int z = 0; z < volDims[dimsTrn[2]] / 2; z++)
+        for(int z = 0; z < volDimZ; z++)
         {
-            volume_shiftZVolumeTempl_kernel<unsigned char><<<gridT, blockT>>>(
-                d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0],
-                volDims[dimsTrn[0]], volDims[dimsTrn[1]], volDims[dimsTrn[2]],
+            volume_transposeVolume_kernel<<<grid, block, 0, stream>>>(
+                d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0], // output
+                d_volSim.getBuffer(), d_volSim.stride()[1], d_volSim.stride()[0], // input
+                volDimX, volDimY, volDimZ,
+                dimTrnX, dimTrnY, dimTrnZ,
                 z);
         };
-        cudaThreadSynchronize();
-        CHECK_CUDA_ERROR();
-        // if (verbose) printf("shift z volume gpu elapsed time: %f ms \n", toc(tall));
-    };
+
+        if(doInvZ == true)
+        {
+            for(int z = 0; z < volDims[dimsTrn[2]] / 2; z++)
+            {
+                volume_shiftZVolumeTempl_kernel<unsigned char><<<gridT, blockT, 0, stream>>>(
+                    d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0],
+                    volDims[dimsTrn[0]], volDims[dimsTrn[1]], volDims[dimsTrn[2]],
+                    z);
+            };
+        };
+    });
 
     // clock_t tall = tic();
     ps_aggregatePathVolume(
@@ -742,38 +923,68 @@ void ps_updateAggrVolume(CudaDeviceMemoryPitched<unsigned char, 3>& volAgr_dmp,
     // if (verbose) printf("aggregate volume gpu elapsed time: %f ms \n", toc(tall));
     // pr_printfDeviceMemoryInfo();
 
-    if(doInvZ == true)
+    const int addAvgSequenceId = 2;
+    ps_runKernelSequence({addAvgSequenceId, volDimX, volDimY, volDimZ, dimTrnX, dimTrnY, dimTrnZ, doInvZ},
+                         [&](cudaStream_t stream)
     {
-        // clock_t tall = tic();
-        for(int z = 0; z < volDims[dimsTrn[2]] / 2; z++)
+        if(doInvZ == true)
         {
-            volume_shiftZVolumeTempl_kernel<unsigned char><<<gridT, blockT>>>(
-                d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0], volDims[dimsTrn[0]],
-                volDims[dimsTrn[1]], volDims[dimsTrn[2]], z);
+            for(int z = 0; z < volDims[dimsTrn[2]] / 2; z++)
+            {
+                volume_shiftZVolumeTempl_kernel<unsigned char><<<gridT, blockT, 0, stream>>>(
+                    d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0], volDims[dimsTrn[0]],
+                    volDims[dimsTrn[1]], volDims[dimsTrn[2]], z);
+            };
         };
-        cudaThreadSynchronize();
-        CHECK_CUDA_ERROR();
-        // if (verbose) printf("shift z volume gpu elapsed time: %f ms \n", toc(tall));
-    };
 
-    // clock_t tall = tic();
-    for(int zT = 0; zT < volDims[dimsTrn[2]]; zT++)
+        for(int zT = 0; zT < volDims[dimsTrn[2]]; zT++)
+        {
+            volume_transposeAddAvgVolume_kernel<<<gridT, blockT, 0, stream>>>(
+                volAgr_dmp.getBuffer(), volAgr_dmp.stride()[1], volAgr_dmp.stride()[0],
+                d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0],
+                volDims[dimsTrn[0]], volDims[dimsTrn[1]], volDims[dimsTrn[2]],
+                dimsTri[0], dimsTri[1], dimsTri[2], zT, lastN);
+        };
+    });
+
+    if(verbose)
+        printf("ps_updateAggrVolume done\n");
+};
+
+
+/**
+ * @brief Aggregate the SGM paths (+x, -x, +y, -y) of the similarity volume with one kernel launch per direction.
+ * @param[out] volAgr_dmp output volume with the average of the aggregated paths
+ * @param[in] volSim_dmp input similarity volume
+ */
+void ps_aggregatePathsVolume(CudaDeviceMemoryPitched<unsigned char, 3>& volAgr_dmp,
+                             const CudaDeviceMemoryPitched<unsigned char, 3>& volSim_dmp,
+                             int volDimX, int volDimY, int volDimZ,
+                             int volLUX, int volLUY,
+                             unsigned char P1, bool verbose)
+{
+    if(verbose)
+        printf("ps_aggregatePathsVolume\n");
+
+    const int block_size = 128;
+    const size_t sharedMemSize = (2 * volDimZ + block_size) * sizeof(unsigned int);
+
+    for(int pathDir = 0; pathDir < 4; pathDir++)
     {
-        volume_transposeAddAvgVolume_kernel<<<gridT, blockT>>>(
+        const int nLines = (pathDir < 2) ? volDimY : volDimX;
+        volume_aggregateCostVolumeAlongPath_kernel<<<nLines, block_size, sharedMemSize>>>(
             volAgr_dmp.getBuffer(), volAgr_dmp.stride()[1], volAgr_dmp.stride()[0],
-            d_volSimT.getBuffer(), d_volSimT.stride()[1], d_volSimT.stride()[0],
-            volDims[dimsTrn[0]], volDims[dimsTrn[1]], volDims[dimsTrn[2]],
-            dimsTri[0], dimsTri[1], dimsTri[2], zT, lastN);
-    };
+            volSim_dmp.getBuffer(), volSim_dmp.stride()[1], volSim_dmp.stride()[0],
+            volDimX, volDimY, volDimZ,
+            pathDir, P1, volLUX, volLUY,
+            pathDir); // lastN: one path per previous direction
+    }
     cudaThreadSynchronize();
     CHECK_CUDA_ERROR();
-    // if (verbose) printf("transpose volume gpu elapsed time: %f ms \n", toc(tall));
-    // pr_printfDeviceMemoryInfo();
 
     if(verbose)
-        printf("ps_updateAggrVolume done\n");
-};
-
+        printf("ps_aggregatePathsVolume done\n");
+}
 
 /**
 * @param[in] ps_texs_arr table of image (in Lab colorspace) for all scales
@@ -788,6 +999,7 @@ void ps_SGMoptimizeSimVolume(CudaArray<uchar4, 2>** ps_texs_arr,
                              bool verbose, unsigned char P1, unsigned char P2,
                              int scale, int CUDAdeviceNo, int ncamsAllocated, int scales)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
     if(verbose)
         printf("ps_SGMoptimizeSimVolume\n");
@@ -816,30 +1028,39 @@ void ps_SGMoptimizeSimVolume(CudaArray<uchar4, 2>** ps_texs_arr,
     // ps_updateAggrVolume multiplies the initial value by npaths, which is 0 at first call
     CudaDeviceMemoryPitched<unsigned char, 3> volAgr_dmp(CudaSize<3>(volDimX, volDimY, volDimZ));
     
-    // update aggregation volume
-    int npaths = 0;
-
-    const auto updateAggrVolume = [&](int dimTrnX, int dimTrnY, int dimTrnZ, bool invZ) 
-                                  {
-                                      ps_updateAggrVolume(volAgr_dmp,
-                                                          volSim_dmp,
-                                                          volDimX, volDimY, volDimZ,
-                                                          volStepXY, volLUX, volLUY,
-                                                          dimTrnX, dimTrnY, dimTrnZ,
-                                                          P1, P2, verbose,
-                                                          invZ,
-                                                          npaths);
-                                      npaths++;
-                                  };
-
-    // XYZ -> XZY
-    updateAggrVolume(0, 2, 1, false);
-    // XYZ -> XZ'Y
-    updateAggrVolume(0, 2, 1, true);
-    // XYZ -> YZX
-    updateAggrVolume(1, 2, 0, false);
-    // XYZ -> YZ'X
-    updateAggrVolume(1, 2, 0, true);
+    // Aggregate all the paths of a direction in a single launch when the path costs of a pixel fit in shared memory
+    const size_t maxSharedMemSize = 48 * 1024;
+    if((2 * volDimZ + 128) * sizeof(unsigned int) <= maxSharedMemSize)
+    {
+        ps_aggregatePathsVolume(volAgr_dmp, volSim_dmp, volDimX, volDimY, volDimZ, volLUX, volLUY, P1, verbose);
+    }
+    else
+    {
+        // update aggregation volume (transposed volume per direction, one launch per slice)
+        int npaths = 0;
+
+        const auto updateAggrVolume = [&](int dimTrnX, int dimTrnY, int dimTrnZ, bool invZ) 
+                                      {
+                                          ps_updateAggrVolume(volAgr_dmp,
+                                                              volSim_dmp,
+                                                              volDimX, volDimY, volDimZ,
+                                                              volStepXY, volLUX, volLUY,
+                                                              dimTrnX, dimTrnY, dimTrnZ,
+                                                              P1, P2, verbose,
+                                                              invZ,
+                                                              npaths);
+                                          npaths++;
+                                      };
+
+        // XYZ -> XZY
+        updateAggrVolume(0, 2, 1, false);
+        // XYZ -> XZ'Y
+        updateAggrVolume(0, 2, 1, true);
+        // XYZ -> YZX
+        updateAggrVolume(1, 2, 0, false);
+        // XYZ -> YZ'X
+        updateAggrVolume(1, 2, 0, true);
+    }
 
 
     if(verbose)
@@ -860,6 +1081,7 @@ void ps_transposeVolume(CudaHostMemoryHeap<unsigned char, 3>* ovol_hmh,
                         CudaHostMemoryHeap<unsigned char, 3>* ivol_hmh, int volDimX, int volDimY, int volDimZ,
                         int dimTrnX, int dimTrnY, int dimTrnZ, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
 
     CudaDeviceMemoryPitched<unsigned char, 3> volSim_dmp(*ivol_hmh);
@@ -984,31 +1206,35 @@ void ps_computeSimilarityVolume(CudaArray<uchar4, 2>** ps_texs_arr,
     cudaBindTextureToArray(t4tex, ps_texs_arr[cams[c]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
-    //--------------------------------------------------------------------------------------------------
-    // init similarity volume
-    for(int z = 0; z < volDimZ; z++)
-    {
-        volume_initVolume_kernel<unsigned char><<<gridvol, blockvol>>>(
-            vol_dmp.getBuffer(), vol_dmp.stride()[1], vol_dmp.stride()[0], volDimX, volDimY, volDimZ, z, 255);
-        cudaThreadSynchronize();
-    };
-
-    //--------------------------------------------------------------------------------------------------
-    // compute similarity volume
     CudaDeviceMemoryPitched<unsigned char, 2> slice_dmp(CudaSize<2>(nDepthsToSearch, slicesAtTime));
-    for(int t = 0; t < ntimes; t++)
+
+    // the launches of a slice only depend on the previous ones: no synchronization between them
+    const int sequenceId = 0;
+    ps_runKernelSequence({sequenceId, volDimX, volDimY, volDimZ, nDepthsToSearch, slicesAtTime, ntimes},
+                         [&](cudaStream_t stream)
     {
-        volume_slice_kernel<<<grid, block>>>(slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch, nDepths,
-                                             slicesAtTime, width, height, wsh, t, npixs, gammaC, gammaP, epipShift);
-        cudaThreadSynchronize();
+        //--------------------------------------------------------------------------------------------------
+        // init similarity volume
+        for(int z = 0; z < volDimZ; z++)
+        {
+            volume_initVolume_kernel<unsigned char><<<gridvol, blockvol, 0, stream>>>(
+                vol_dmp.getBuffer(), vol_dmp.stride()[1], vol_dmp.stride()[0], volDimX, volDimY, volDimZ, z, 255);
+        };
 
-        volume_saveSliceToVolume_kernel<<<grid, block>>>(vol_dmp.getBuffer(), vol_dmp.stride()[1], vol_dmp.stride()[0],
-                                                         slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch,
-                                                         nDepths, slicesAtTime, width, height, t, npixs, volStepXY,
-                                                         volDimX, volDimY, volDimZ, volLUX, volLUY, volLUZ);
-        cudaThreadSynchronize();
-        CHECK_CUDA_ERROR();
-    };
+        //--------------------------------------------------------------------------------------------------
+        // compute similarity volume
+        for(int t = 0; t < ntimes; t++)
+        {
+            volume_slice_kernel<<<grid, block, 0, stream>>>(slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch,
+                                                            nDepths, slicesAtTime, width, height, wsh, t, npixs, gammaC,
+                                                            gammaP, epipShift);
+
+            volume_saveSliceToVolume_kernel<<<grid, block, 0, stream>>>(
+                vol_dmp.getBuffer(), vol_dmp.stride()[1], vol_dmp.stride()[0], slice_dmp.getBuffer(),
+                slice_dmp.stride()[0], nDepthsToSearch, nDepths, slicesAtTime, width, height, t, npixs, volStepXY,
+                volDimX, volDimY, volDimZ, volLUX, volLUY, volLUZ);
+        };
+    });
 
     cudaUnbindTexture(r4tex);
     cudaUnbindTexture(t4tex);
@@ -1029,6 +1255,7 @@ float ps_planeSweepingGPUPixelsVolume(CudaArray<uchar4, 2>** ps_texs_arr,
                                       bool doUsePixelsDepths, int nbest, bool useTcOrRcPixSize, float gammaC,
                                       float gammaP, bool subPixel, float epipShift)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     CudaDeviceMemoryPitched<unsigned char, 3> volSim_dmp(CudaSize<3>(volDimX, volDimY, volDimZ));
@@ -1056,9 +1283,126 @@ float ps_planeSweepingGPUPixelsVolume(CudaArray<uchar4, 2>** ps_texs_arr,
     return (float)volSim_dmp.getBytes() / (1024.0f * 1024.0f);
 }
 
+/**
+ * @brief Compute the similarity volume of a reference camera with all its target cameras in a single sweep.
+ *        The target camera images are sampled through texture objects, so each slice of pixels
+ *        is computed in one launch instead of one launch per target camera.
+ *        The output volume is the second best similarity over the target cameras.
+ * @param[in] cams the reference camera followed by the target cameras
+ * @param[in] tcDepthsLimits for each target camera, its first depth index (x) and num. of depths (y)
+ * @return the volume size in GPU memory (MB), or a negative value if the device does not support texture objects
+ */
+float ps_planeSweepingGPUPixelsVolumeAllTc(CudaArray<uchar4, 2>** ps_texs_arr, unsigned char* ovol_hmh,
+                                           cameraStruct** cams, int ncams, int2* tcDepthsLimits, int width, int height,
+                                           int volStepXY, int volDimX, int volDimY, int volDimZ, int volLUX, int volLUY,
+                                           CudaHostMemoryHeap<int4, 2>& volPixs_hmh,
+                                           CudaHostMemoryHeap<float, 2>& depths_hmh, int nDepthsToSearch,
+                                           int slicesAtTime, int ntimes, int npixs, int wsh, int nDepths, int scale,
+                                           int CUDAdeviceNo, int scales, bool verbose, float gammaC, float gammaP,
+                                           float epipShift, unsigned char P3)
+{
+    ALICEVISION_PROFILE_PS_FUNCTION();
+    clock_t tall = tic();
+    testCUDAdeviceNo(CUDAdeviceNo);
+
+    cudaDeviceProp dprop;
+    cudaGetDeviceProperties(&dprop, CUDAdeviceNo);
+    if(dprop.major < 3)
+        return -1.0f;
+
+    const int ntcams = ncams - 1;
+
+    // target cameras with a texture object on their image
+    CudaHostMemoryHeap<targetCameraStruct, 2> tcams_hmh(CudaSize<2>(ntcams, 1));
+    for(int c = 0; c < ntcams; c++)
+    {
+        const cameraStruct* cam = cams[c + 1];
+        targetCameraStruct& tcam = tcams_hmh(c, 0);
+        memcpy(tcam.P, cam->P, sizeof(float) * 12);
+        tcam.C = make_float3(cam->C[0], cam->C[1], cam->C[2]);
+        tcam.depthFrom = tcDepthsLimits[c].x;
+        tcam.nDepths = tcDepthsLimits[c].y;
+
+        cudaResourceDesc resDesc;
+        memset(&resDesc, 0, sizeof(cudaResourceDesc));
+        resDesc.resType = cudaResourceTypeArray;
+        resDesc.res.array.array = ps_texs_arr[cam->camId * scales + scale]->getArray();
+
+        // same sampling as t4tex
+        cudaTextureDesc texDesc;
+        memset(&texDesc, 0, sizeof(cudaTextureDesc));
+        texDesc.addressMode[0] = cudaAddressModeClamp;
+        texDesc.addressMode[1] = cudaAddressModeClamp;
+        texDesc.filterMode = cudaFilterModeLinear;
+        texDesc.readMode = cudaReadModeNormalizedFloat;
+        texDesc.normalizedCoords = 0;
+
+        cudaCreateTextureObject(&tcam.tex, &resDesc, &texDesc, nullptr);
+    }
+    CudaDeviceMemoryPitched<targetCameraStruct, 2> tcams_dmp(tcams_hmh);
+
+    CudaArray<int4, 2> volPixs_arr(volPixs_hmh);
+    CudaArray<float, 2> depths_arr(depths_hmh);
+    cudaBindTextureToArray(volPixsTex, volPixs_arr.getArray(), cudaCreateChannelDesc<int4>());
+    cudaBindTextureToArray(depthsTex, depths_arr.getArray(), cudaCreateChannelDesc<float>());
+
+    ps_init_reference_camera_matrices(cams[0]->P, cams[0]->iP, cams[0]->R, cams[0]->iR, cams[0]->K, cams[0]->iK,
+                                      cams[0]->C);
+    cudaBindTextureToArray(r4tex, ps_texs_arr[cams[0]->camId * scales + scale]->getArray(),
+                           cudaCreateChannelDesc<uchar4>());
+
+    int block_size = 8;
+    dim3 block(block_size, block_size, 1);
+    dim3 grid(divUp(nDepthsToSearch, block_size), divUp(slicesAtTime, block_size), 1);
+    dim3 blockvol(block_size, block_size, 1);
+    dim3 gridvol(divUp(volDimX, block_size), divUp(volDimY, block_size), 1);
+
+    CudaDeviceMemoryPitched<unsigned char, 3> volSim_dmp(CudaSize<3>(volDimX, volDimY, volDimZ));
+
+    if(verbose)
+        printf("total size of volume map in GPU memory: %f\n", (float)volSim_dmp.getBytes() / (1024.0f * 1024.0f));
+
+    for(int z = 0; z < volDimZ; z++)
+    {
+        volume_initVolume_kernel<unsigned char><<<gridvol, blockvol>>>(
+            volSim_dmp.getBuffer(), volSim_dmp.stride()[1], volSim_dmp.stride()[0], volDimX, volDimY, volDimZ, z, 255);
+    }
+    cudaThreadSynchronize();
+
+    CudaDeviceMemoryPitched<unsigned char, 2> slice_dmp(CudaSize<2>(nDepthsToSearch, slicesAtTime));
+    for(int t = 0; t < ntimes; t++)
+    {
+        volume_sliceAllTc_kernel<<<grid, block>>>(slice_dmp.getBuffer(), slice_dmp.stride()[0], tcams_dmp.getBuffer(),
+                                                  ntcams, nDepthsToSearch, nDepths, slicesAtTime, width, height, wsh,
+                                                  t, npixs, gammaC, gammaP, epipShift, P3);
+
+        volume_saveSliceToVolume_kernel<<<grid, block>>>(volSim_dmp.getBuffer(), volSim_dmp.stride()[1],
+                                                         volSim_dmp.stride()[0], slice_dmp.getBuffer(),
+                                                         slice_dmp.stride()[0], nDepthsToSearch, nDepths,
+                                                         slicesAtTime, width, height, t, npixs, volStepXY, volDimX,
+                                                         volDimY, volDimZ, volLUX, volLUY, 0);
+    }
+    cudaThreadSynchronize();
+    CHECK_CUDA_ERROR();
+
+    cudaUnbindTexture(r4tex);
+    cudaUnbindTexture(volPixsTex);
+    cudaUnbindTexture(depthsTex);
+    for(int c = 0; c < ntcams; c++)
+        cudaDestroyTextureObject(tcams_hmh(c, 0).tex);
+
+    copy(ovol_hmh, volDimX, volDimY, volDimZ, volSim_dmp);
+
+    if(verbose)
+        printf("ps_planeSweepingGPUPixelsVolumeAllTc elapsed time: %f ms \n", toc(tall));
+
+    return (float)volSim_dmp.getBytes() / (1024.0f * 1024.0f);
+}
+
 void ps_filterVisTVolume(CudaHostMemoryHeap<unsigned int, 3>* iovol_hmh, int volDimX, int volDimY, int volDimZ,
                          bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     int block_size = 8;
     dim3 blockvol(block_size, block_size, 1);
@@ -1145,6 +1489,7 @@ void ps_enforceTweigthInVolumeInternal(CudaDeviceMemoryPitched<unsigned int, 3>&
 void ps_enforceTweigthInVolume(CudaHostMemoryHeap<unsigned int, 3>* iovol_hmh, int volDimX, int volDimY, int volDimZ,
                                bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
 
     CudaDeviceMemoryPitched<unsigned int, 3> ivol_dmp(*iovol_hmh);
@@ -1213,6 +1558,7 @@ void ps_enforceTweigthInVolume(CudaHostMemoryHeap<unsigned int, 3>* iovol_hmh, i
 void ps_computeDP1Volume(CudaHostMemoryHeap<int, 3>* ovol_hmh, CudaHostMemoryHeap<unsigned int, 3>* ivol_hmh,
                          int volDimX, int volDimY, int volDimZ, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     int block_size = 8;
     dim3 blockvol(block_size, block_size, 1);
@@ -1256,6 +1602,7 @@ void ps_computeDP1Volume(CudaHostMemoryHeap<int, 3>* ovol_hmh, CudaHostMemoryHea
 void ps_normalizeDP1Volume(CudaHostMemoryHeap<int, 3>** iovols_hmh, int nZparts, int volDimZpart, int volDimX,
                            int volDimY, int volDimZ, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     int block_size = 8;
     dim3 blockvol(block_size, block_size, 1);
@@ -1391,6 +1738,7 @@ void ps_computeRcVolumeForTcDepthSimMaps(CudaHostMemoryHeap<unsigned int, 3>** o
                                          CudaHostMemoryHeap<float2, 2>** rcTcsDepthSimMaps_hmh, bool verbose,
                                          float maxTcRcPixSizeInVoxRatio, bool considerNegativeDepthAsInfinity)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -1548,6 +1896,7 @@ void ps_filterRcIdDepthMapByTcDepthMap(CudaHostMemoryHeap<unsigned short, 2>* rc
                                        int CUDAdeviceNo, int ncamsAllocated, int scales,
                                        CudaHostMemoryHeap<float, 2>& tcDepthMap_hmh, bool verbose, int distLimit)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -1597,6 +1946,7 @@ void ps_filterRcIdDepthMapByTcDepthMaps(CudaHostMemoryHeap<unsigned short, 2>* n
                                         int CUDAdeviceNo, int ncamsAllocated, int scales,
                                         CudaHostMemoryHeap<float, 2>** tcDepthMaps_hmh, bool verbose, int distLimit)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -1655,6 +2005,7 @@ void ps_planeSweepingGPUPixelsFine(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostM
                                    int ncamsAllocated, int scales, bool verbose, float gammaC, float gammaP,
                                    float epipShift = 0.0f)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -1738,6 +2089,7 @@ void ps_planeSweepNPlanes(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap
                           int ncams, int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales,
                           bool verbose, int step)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -1834,6 +2186,7 @@ void ps_planeSweepAggr(CudaHostMemoryHeap<uchar4, 2>& rimg_hmh, CudaHostMemoryHe
                        float* depths, int ndepths, cameraStruct** rtcams, int width, int height, int scale, int scales,
                        bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -1973,6 +2326,7 @@ void ps_planeSweepAggr(CudaHostMemoryHeap<uchar4, 2>& rimg_hmh, CudaHostMemoryHe
 void ps_getTexture(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<uchar4, 2>* oimg_hmh, int camId,
                    int scale, int CUDAdeviceNo, int ncamsAllocated, int scales)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -1984,6 +2338,7 @@ void ps_smoothDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<fl
                        cameraStruct** cams, int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated,
                        int scales, int wsh, bool verbose, float gammaC, float gammaP)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -2027,6 +2382,7 @@ void ps_filterDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<fl
                        cameraStruct** cams, int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated,
                        int scales, int wsh, bool verbose, float gammaC, float minCostThr)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -2071,6 +2427,7 @@ void ps_computeNormalMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<
                          int scale, int CUDAdeviceNo, int ncamsAllocated, int scales, int wsh, bool verbose,
                          float gammaC, float gammaP)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -2118,6 +2475,7 @@ void ps_alignSourceDepthMapToTarget(CudaArray<uchar4, 2>** ps_texs_arr,
                                     int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales, int wsh,
                                     bool verbose, float gammaC, float maxPixelSizeDist)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -2304,6 +2662,7 @@ void ps_growDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<ucha
                      int ndepths, int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales,
                      bool verbose, int wsh, float gammaC, float gammaP, float simThr)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -2413,6 +2772,7 @@ void ps_refineDepthMapReproject(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemo
                                 int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose,
                                 int wsh, float gammaC, float gammaP, float simThr, int niters, bool moveByTcOrRc)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -2499,6 +2859,7 @@ void ps_computeRcTcPhotoErrMapReproject(
     int ncams, int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose,
     int wsh, float gammaC, float gammaP, float depthMapShift)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -2619,6 +2980,7 @@ void ps_computeSimMapsForNShiftsOfRcTcDepthMap(CudaArray<uchar4, 2>** ps_texs_ar
                                                int ncamsAllocated, int scales, bool verbose, int wsh, float gammaC,
                                                float gammaP, float epipShift)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -2661,6 +3023,7 @@ void ps_computeSimMapForRcTcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHos
                                      int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales,
                                      bool verbose, int wsh, float gammaC, float gammaP, float epipShift)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -2703,6 +3066,7 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
                          int scales, bool verbose, int wsh, float gammaC, float gammaP, float epipShift,
                          bool moveByTcOrRc, int xFrom)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -2782,13 +3146,15 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
  * @param sigma
  * @param width
  * @param height
+ * @param halfPrecision: vote in half precision (in a single pass) if supported
  * @param verbose
  */
 void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
                                              CudaHostMemoryHeap<float2, 2>** depthSimMaps_hmh, int ndepthSimMaps,
                                              int nSamplesHalf, int nDepthsToRefine, float sigma, int width, int height,
-                                             bool verbose)
+                                             bool halfPrecision, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
 
     float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
@@ -2812,22 +3178,46 @@ void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odep
         copy((*depthSimMaps_dmp[i]), (*depthSimMaps_hmh[i]));
     };
 
-    for(int s = -nSamplesHalf; s <= nSamplesHalf; s++) // (-150, 150)
+#ifdef ALICEVISION_DEPTHMAP_CUDA_FP16
+    if(halfPrecision && ndepthSimMaps > 1)
     {
+        // (sample index, weight) of each Tc map in half precision: half the memory traffic of the depth/sim maps
+        CudaDeviceMemoryPitched<__half2, 3> offsetWeightMaps_dmp(CudaSize<3>(width, height, ndepthSimMaps - 1));
         for(int c = 1; c < ndepthSimMaps; c++) // number of Tc cameras
         {
-            fuse_computeGaussianKernelVotingSampleMap_kernel<<<grid, block>>>(
-                gsvSampleMap_dmp.getBuffer(), gsvSampleMap_dmp.stride()[0],
+            fuse_computeGaussianKernelVotingOffsetWeightMap_kernel<<<grid, block>>>(
+                offsetWeightMaps_dmp.getBuffer(), offsetWeightMaps_dmp.stride()[1], offsetWeightMaps_dmp.stride()[0],
                 depthSimMaps_dmp[c]->getBuffer(), depthSimMaps_dmp[c]->stride()[0],
                 depthSimMaps_dmp[0]->getBuffer(), depthSimMaps_dmp[0]->stride()[0],
-                width, height, (float)s, c - 1, samplesPerPixSize, twoTimesSigmaPowerTwo);
+                width, height, c - 1, samplesPerPixSize);
+        }
+        fuse_computeBestGaussianKernelVotingSampleMapHalf_kernel<<<grid, block>>>(
+            bestGsvSampleMap_dmp.getBuffer(), bestGsvSampleMap_dmp.stride()[0],
+            offsetWeightMaps_dmp.getBuffer(), offsetWeightMaps_dmp.stride()[1], offsetWeightMaps_dmp.stride()[0],
+            width, height, ndepthSimMaps - 1, nSamplesHalf, 1.0f / (sqrtf(2.0f) * sigma));
+        cudaThreadSynchronize();
+        CHECK_CUDA_ERROR();
+    }
+    else
+#endif
+    {
+        for(int s = -nSamplesHalf; s <= nSamplesHalf; s++) // (-150, 150)
+        {
+            for(int c = 1; c < ndepthSimMaps; c++) // number of Tc cameras
+            {
+                fuse_computeGaussianKernelVotingSampleMap_kernel<<<grid, block>>>(
+                    gsvSampleMap_dmp.getBuffer(), gsvSampleMap_dmp.stride()[0],
+                    depthSimMaps_dmp[c]->getBuffer(), depthSimMaps_dmp[c]->stride()[0],
+                    depthSimMaps_dmp[0]->getBuffer(), depthSimMaps_dmp[0]->stride()[0],
+                    width, height, (float)s, c - 1, samplesPerPixSize, twoTimesSigmaPowerTwo);
+                cudaThreadSynchronize();
+            };
+            fuse_updateBestGaussianKernelVotingSampleMap_kernel<<<grid, block>>>(
+                bestGsvSampleMap_dmp.getBuffer(), bestGsvSampleMap_dmp.stride()[0], gsvSampleMap_dmp.getBuffer(),
+                gsvSampleMap_dmp.stride()[0], width, height, (float)s, s + nSamplesHalf);
             cudaThreadSynchronize();
         };
-        fuse_updateBestGaussianKernelVotingSampleMap_kernel<<<grid, block>>>(
-            bestGsvSampleMap_dmp.getBuffer(), bestGsvSampleMap_dmp.stride()[0], gsvSampleMap_dmp.getBuffer(),
-            gsvSampleMap_dmp.stride()[0], width, height, (float)s, s + nSamplesHalf);
-        cudaThreadSynchronize();
-    };
+    }
 
     fuse_computeFusedDepthSimMapFromBestGaussianKernelVotingSampleMap_kernel<<<grid, block>>>(
         bestDepthSimMap_dmp.getBuffer(), bestDepthSimMap_dmp.stride()[0], bestGsvSampleMap_dmp.getBuffer(),
@@ -2853,8 +3243,10 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
                                            CudaHostMemoryHeap<float2, 2>** dataMaps_hmh, int ndataMaps,
                                            int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
                                            cameraStruct** cams, int ncams, int width, int height, int scale,
-                                           int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, int yFrom)
+                                           int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, int yFrom,
+                                           float convergenceThr, int nStableIters, int* oNIters, float* oActiveBlocksRatio)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -2884,7 +3276,23 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
     CudaArray<float, 2> optDepthMap_arr(CudaSize<2>(width, height));
     copy(optDepthSimMap_dmp, (*dataMaps_dmp[0]));
 
-    for(int iter = 0; iter < nIters; iter++) // nIters: 100 by default
+    // convergence of the thread blocks (one element per block of the grid)
+    const bool trackConvergence = (convergenceThr > 0.0f);
+    const int nBlocks = grid.x * grid.y;
+    dim3 blocksGrid(divUp(grid.x, block_size), divUp(grid.y, block_size), 1);
+    CudaDeviceMemoryPitched<unsigned char, 2> blockActive_dmp(CudaSize<2>(grid.x, grid.y));
+    CudaDeviceMemoryPitched<unsigned char, 2> blockStableIters_dmp(CudaSize<2>(grid.x, grid.y));
+    CudaDeviceMemoryPitched<float, 2> blockMaxStep_dmp(CudaSize<2>(grid.x, grid.y));
+    CudaDeviceMemoryPitched<int, 2> nActiveBlocks_dmp(CudaSize<2>(1, 1));
+    CudaHostMemoryHeap<int, 2> nActiveBlocks_hmh(CudaSize<2>(1, 1));
+    cudaMemset2D(blockActive_dmp.getBuffer(), blockActive_dmp.stride()[0], 1, grid.x * sizeof(unsigned char), grid.y);
+    cudaMemset2D(blockStableIters_dmp.getBuffer(), blockStableIters_dmp.stride()[0], 0, grid.x * sizeof(unsigned char), grid.y);
+
+    int nActiveBlocks = nBlocks;
+    long long nProcessedBlocks = 0;
+    int iter = 0;
+
+    for(; (iter < nIters) && (nActiveBlocks > 0); iter++) // nIters: 100 by default
     {
         // Copy depths values from optDepthSimMap to optDepthMap
         fuse_getOptDeptMapFromOPtDepthSimMap_kernel<<<grid, block>>>(
@@ -2895,16 +3303,40 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
         // Bind those depth values as a texture
         cudaBindTextureToArray(depthsTex, optDepthMap_arr.getArray(), cudaCreateChannelDesc<float>());
 
+        if(trackConvergence)
+            cudaMemset2D(blockMaxStep_dmp.getBuffer(), blockMaxStep_dmp.stride()[0], 0, grid.x * sizeof(float), grid.y);
+
         // Adjust depth/sim by using previously computed depths (depthTex is accessed inside this kernel)
         fuse_optimizeDepthSimMap_kernel<<<grid, block>>>(optDepthSimMap_dmp.getBuffer(), optDepthSimMap_dmp.stride()[0],
                                                          dataMaps_dmp[0]->getBuffer(), dataMaps_dmp[0]->stride()[0],
                                                          dataMaps_dmp[1]->getBuffer(), dataMaps_dmp[1]->stride()[0],
-                                                         width, height, iter, samplesPerPixSize, yFrom);
+                                                         width, height, iter, samplesPerPixSize, yFrom,
+                                                         trackConvergence ? blockActive_dmp.getBuffer() : NULL,
+                                                         blockActive_dmp.stride()[0],
+                                                         trackConvergence ? blockMaxStep_dmp.getBuffer() : NULL,
+                                                         blockMaxStep_dmp.stride()[0]);
         cudaThreadSynchronize();
+        nProcessedBlocks += nActiveBlocks;
 
         cudaUnbindTexture(depthsTex);
+
+        if(trackConvergence)
+        {
+            cudaMemset2D(nActiveBlocks_dmp.getBuffer(), nActiveBlocks_dmp.stride()[0], 0, sizeof(int), 1);
+            fuse_updateActiveBlocks_kernel<<<blocksGrid, block>>>(
+                blockActive_dmp.getBuffer(), blockActive_dmp.stride()[0], blockStableIters_dmp.getBuffer(),
+                blockStableIters_dmp.stride()[0], blockMaxStep_dmp.getBuffer(), blockMaxStep_dmp.stride()[0], grid.x,
+                grid.y, convergenceThr, nStableIters, nActiveBlocks_dmp.getBuffer());
+            copy(nActiveBlocks_hmh, nActiveBlocks_dmp);
+            nActiveBlocks = nActiveBlocks_hmh(0, 0);
+        }
     };
 
+    if(oNIters != NULL)
+        *oNIters = iter;
+    if(oActiveBlocksRatio != NULL)
+        *oActiveBlocksRatio = (nIters > 0) ? (float)((double)nProcessedBlocks / ((double)nBlocks * nIters)) : 0.0f;
+
     copy((*odepthSimMap_hmh), optDepthSimMap_dmp);
 
     for(int i = 0; i < ndataMaps; i++)
@@ -2916,12 +3348,13 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
     cudaUnbindTexture(r4tex);
 
     if(verbose)
-        printf("gpu elapsed time: %f ms \n", toc(tall));
+        printf("gpu elapsed time: %f ms, %i iterations, %i active blocks of %i \n", toc(tall), iter, nActiveBlocks, nBlocks);
 };
 
 void ps_GC_aggregatePathVolume(CudaHostMemoryHeap<unsigned int, 2>* ftid_hmh, // f-irst t-label id
                                CudaHostMemoryHeap<unsigned int, 3>& ivol_hmh, int volDimX, int volDimY, int volDimZ)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     CudaDeviceMemoryPitched<unsigned int, 3> vol_dmp(ivol_hmh);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -2960,6 +3393,7 @@ void ps_GC_K_aggregatePathVolume(CudaHostMemoryHeap<unsigned int, 2>* ftid_hmh,
                                  CudaHostMemoryHeap<unsigned int, 3>& ivol_hmh, int volDimX, int volDimY, int volDimZ,
                                  int K)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     CudaDeviceMemoryPitched<unsigned int, 3> vol_dmp(ivol_hmh);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -3058,6 +3492,7 @@ void ps_computeSimMapReprojectByDepthMapMovedByStep(CudaArray<uchar4, 2>** ps_te
                                                     int ncamsAllocated, int scales, bool verbose, int wsh, float gammaC,
                                                     float gammaP, bool moveByTcOrRc, float step)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     testCUDAdeviceNo(CUDAdeviceNo);
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -3121,6 +3556,7 @@ void ps_reprojectRGBTcImageByDepthMap(CudaHostMemoryHeap<uchar4, 2>* iTcoRcRgbIm
                                       int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated,
                                       int scales, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -3162,6 +3598,7 @@ void ps_computeRcTcDepthMap(CudaHostMemoryHeap<float, 2>& iRcDepthMap_oRcTcDepth
                             int ncams, int width, int height, int scale, int CUDAdeviceNo, int ncamsAllocated,
                             int scales, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -3197,6 +3634,7 @@ void ps_getSilhoueteMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<b
                         int height, int scale, int CUDAdeviceNo, int ncamsAllocated, int scales, int step, int camId,
                         uchar4 maskColorRgb, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -3232,6 +3670,7 @@ void ps_retexture(CudaHostMemoryHeap<uchar4, 2>* bmpOrig_hmh, CudaHostMemoryHeap
                   CudaHostMemoryHeap<float4, 2>* retexturePixs_hmh, int wObj, int hObj, int wOrig, int hOrig,
                   int slicesAtTime, int ntimes, int npixs, int CUDAdeviceNo, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -3265,6 +3704,7 @@ void ps_retextureComputeNormalMap(CudaHostMemoryHeap<uchar4, 2>* bmpObj_hmh,
                                   CudaHostMemoryHeap<float3, 2>* retextureNorms_hmh, int wObj, int hObj,
                                   int slicesAtTime, int ntimes, int npixs, int CUDAdeviceNo, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -3292,6 +3732,7 @@ void ps_retextureComputeNormalMap(CudaHostMemoryHeap<uchar4, 2>* bmpObj_hmh,
 
 void ps_colorExtractionPushPull(CudaHostMemoryHeap<uchar4, 2>* bmp_hmh, int w, int h, int CUDAdeviceNo, bool verbose)
 {
+    ALICEVISION_PROFILE_PS_FUNCTION();
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
@@ -3368,5 +3809,149 @@ void ps_colorExtractionPushPull(CudaHostMemoryHeap<uchar4, 2>* bmp_hmh, int w, i
     delete[] pyramid_arr;
 }
 
+/**
+ * @brief Device depth maps of the consistency filter, the least recently used is removed when it is full
+ */
+struct ps_depthMapsCache
+{
+    int capacity;
+    /// camera id and depth map, the most recently used first
+    std::list<std::pair<int, CudaDeviceMemoryPitched<float, 2>*>> depthMaps;
+};
+
+void* ps_createDepthMapsCache(int CUDAdeviceNo, int capacity)
+{
+    testCUDAdeviceNo(CUDAdeviceNo);
+
+    ps_depthMapsCache* cache = new ps_depthMapsCache();
+    cache->capacity = std::max(1, capacity);
+    return cache;
+}
+
+void ps_destroyDepthMapsCache(void* depthMapsCache, int CUDAdeviceNo)
+{
+    testCUDAdeviceNo(CUDAdeviceNo);
+
+    ps_depthMapsCache* cache = (ps_depthMapsCache*)depthMapsCache;
+    for(auto& depthMap : cache->depthMaps)
+        delete depthMap.second;
+    delete cache;
+}
+
+static CudaDeviceMemoryPitched<float, 2>* ps_findInDepthMapsCache(ps_depthMapsCache* cache, int camId)
+{
+    for(auto it = cache->depthMaps.begin(); it != cache->depthMaps.end(); ++it)
+    {
+        if(it->first == camId)
+        {
+            cache->depthMaps.splice(cache->depthMaps.begin(), cache->depthMaps, it);
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+bool ps_isInDepthMapsCache(void* depthMapsCache, int camId)
+{
+    return ps_findInDepthMapsCache((ps_depthMapsCache*)depthMapsCache, camId) != nullptr;
+}
+
+void ps_addToDepthMapsCache(void* depthMapsCache, int camId, const float* depthMap, int width, int height)
+{
+    ps_depthMapsCache* cache = (ps_depthMapsCache*)depthMapsCache;
+
+    if(cache->depthMaps.size() >= cache->capacity)
+    {
+        delete cache->depthMaps.back().second;
+        cache->depthMaps.pop_back();
+    }
+
+    CudaHostMemoryHeap<float, 2> depthMap_hmh(CudaSize<2>(width, height));
+    std::copy(depthMap, depthMap + width * height, depthMap_hmh.getBuffer());
+    cache->depthMaps.emplace_front(camId, new CudaDeviceMemoryPitched<float, 2>(depthMap_hmh));
+}
+
+/**
+ * @brief Compute the num. of tcams consistent with each pixel of the rc depth map (see fuseCut::Fuser::filterGroupsRC).
+ *        The tc depth maps have to be in the depth maps cache, they are processed by batches of 32 tcams
+ *        (one bit of the consistency mask per tcam) in a single launch.
+ * @param[in] tcamIds the camera id of each tcam in the depth maps cache
+ * @param[out] numOfModalsMap the num. of consistent tcams of each rc pixel (width x height)
+ */
+void ps_computeDepthMapsConsistency(void* depthMapsCache, const consistencyCameraStruct& rcam,
+                                    const float* rcDepthMap, const float* rcSimMap, const int* tcamIds,
+                                    const consistencyCameraStruct* tcams, int ntcams, int pixSizeBall,
+                                    int pixSizeBallWSP, int border, unsigned char* numOfModalsMap, int CUDAdeviceNo,
+                                    bool verbose)
+{
+    ALICEVISION_PROFILE_PS_FUNCTION();
+    clock_t tall = tic();
+    testCUDAdeviceNo(CUDAdeviceNo);
+
+    ps_depthMapsCache* cache = (ps_depthMapsCache*)depthMapsCache;
+    const int width = rcam.width;
+    const int height = rcam.height;
+
+    CudaHostMemoryHeap<float, 2> rcDepthMap_hmh(CudaSize<2>(width, height));
+    CudaHostMemoryHeap<float, 2> rcSimMap_hmh(CudaSize<2>(width, height));
+    std::copy(rcDepthMap, rcDepthMap + width * height, rcDepthMap_hmh.getBuffer());
+    std::copy(rcSimMap, rcSimMap + width * height, rcSimMap_hmh.getBuffer());
+    CudaDeviceMemoryPitched<float, 2> rcDepthMap_dmp(rcDepthMap_hmh);
+    CudaDeviceMemoryPitched<float, 2> rcSimMap_dmp(rcSimMap_hmh);
+
+    CudaDeviceMemoryPitched<unsigned int, 2> mask_dmp(CudaSize<2>(width, height));
+    CudaDeviceMemoryPitched<unsigned char, 2> numOfModals_dmp(CudaSize<2>(width, height));
+    cudaMemset2D(mask_dmp.getBuffer(), mask_dmp.stride()[0], 0, width * sizeof(unsigned int), height);
+    cudaMemset2D(numOfModals_dmp.getBuffer(), numOfModals_dmp.stride()[0], 0, width * sizeof(unsigned char), height);
+
+    const int block_size = 16;
+    const int batchSize = 32; // bits of the consistency mask
+    dim3 block(block_size, block_size, 1);
+    dim3 gridRc(divUp(width, block_size), divUp(height, block_size), 1);
+
+    for(int batchFrom = 0; batchFrom < ntcams; batchFrom += batchSize)
+    {
+        const int nbatch = std::min(batchSize, ntcams - batchFrom);
+
+        CudaHostMemoryHeap<consistencyCameraStruct, 2> tcams_hmh(CudaSize<2>(nbatch, 1));
+        int maxWidth = 0;
+        int maxHeight = 0;
+        for(int c = 0; c < nbatch; c++)
+        {
+            consistencyCameraStruct& tcam = tcams_hmh(c, 0);
+            tcam = tcams[batchFrom + c];
+
+            const CudaDeviceMemoryPitched<float, 2>* depthMap_dmp = ps_findInDepthMapsCache(cache, tcamIds[batchFrom + c]);
+            if(depthMap_dmp == nullptr)
+                throw std::runtime_error("ps_computeDepthMapsConsistency: depth map not uploaded.");
+
+            tcam.depthMap = depthMap_dmp->getBuffer();
+            tcam.depthMap_p = depthMap_dmp->stride()[0];
+            maxWidth = std::max(maxWidth, tcam.width);
+            maxHeight = std::max(maxHeight, tcam.height);
+        }
+        CudaDeviceMemoryPitched<consistencyCameraStruct, 2> tcams_dmp(tcams_hmh);
+
+        dim3 grid(divUp(maxWidth, block_size), divUp(maxHeight, block_size), nbatch);
+        fuse_computeConsistencyMask_kernel<<<grid, block>>>(
+            mask_dmp.getBuffer(), mask_dmp.stride()[0], rcDepthMap_dmp.getBuffer(), rcDepthMap_dmp.stride()[0],
+            rcSimMap_dmp.getBuffer(), rcSimMap_dmp.stride()[0], rcam, tcams_dmp.getBuffer(), pixSizeBall,
+            pixSizeBallWSP, border);
+
+        fuse_accumulateConsistencyMask_kernel<<<gridRc, block>>>(numOfModals_dmp.getBuffer(),
+                                                                 numOfModals_dmp.stride()[0], mask_dmp.getBuffer(),
+                                                                 mask_dmp.stride()[0], width, height);
+        cudaThreadSynchronize();
+        CHECK_CUDA_ERROR();
+    }
+
+    CudaHostMemoryHeap<unsigned char, 2> numOfModals_hmh(CudaSize<2>(width, height));
+    copy(numOfModals_hmh, numOfModals_dmp);
+    std::copy(numOfModals_hmh.getBuffer(), numOfModals_hmh.getBuffer() + width * height, numOfModalsMap);
+
+    if(verbose)
+        printf("ps_computeDepthMapsConsistency elapsed time: %f ms \n", toc(tall));
+}
+
 } // namespace depthMap
 } // namespace aliceVision
@@ -0,0 +1,446 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+/**
+ * Benchmark of the host entry points of PlaneSweepingCuda used by the depth maps estimation:
+ * sweepPixelsToVolume and SGMoptimizeSimVolume (semi global matching), refinePixelsAll,
+ * fuseDepthSimMapsGaussianKernelVoting and optimizeDepthSimMapGradientDescent (refine).
+ *
+ * The scene is synthetic: cameras on a line in front of a textured plane, whose images are rendered
+ * in memory (see imageIO::MemoryImages), so only the mvs.ini file is written in a temporary folder.
+ * Each function is run once to upload the cameras, then timed over the repetitions,
+ * for each image resolution and number of depths. The results are written in a JSON file.
+ */
+
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#include <aliceVision/depthMap/cuda/DeviceProfiler.hpp>
+#include <aliceVision/imageIO/MemoryImages.hpp>
+#include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace {
+
+/// distance of the textured plane to the cameras
+const float planeDepth = 10.0f;
+/// distance between two consecutive cameras
+const float baseline = 0.5f;
+
+struct BenchmarkOptions
+{
+  std::regex filter;
+  int nbRepetitions = 5;
+  int sgmStep = 2;
+  int refineIters = 100;
+};
+
+struct BenchmarkResult
+{
+  std::string function;
+  int width = 0;
+  int height = 0;
+  int nbDepths = 0;
+  std::vector<double> timesMs;
+};
+
+/**
+ * @brief Texture of the plane, the same at a 3D point in all the images
+ */
+float planeTexture(float x, float y, const std::vector<float>& noise, int noiseSize)
+{
+  // smooth structures and a tiled random pattern for the similarity
+  const int nx = static_cast<int>(std::floor(x * 40.0f)) & (noiseSize - 1);
+  const int ny = static_cast<int>(std::floor(y * 40.0f)) & (noiseSize - 1);
+  const float value = 0.5f + 0.2f * std::sin(3.0f * x) * std::cos(2.0f * y) + 0.3f * (noise[ny * noiseSize + nx] - 0.5f);
+  return 255.0f * std::min(1.0f, std::max(0.0f, value));
+}
+
+/**
+ * @brief Synthetic dataset: the mvs.ini file in a temporary folder and the images in memory
+ */
+class SyntheticScene
+{
+public:
+  SyntheticScene(int width, int height, int nbCameras)
+    : _folder(fs::temp_directory_path() / fs::unique_path("aliceVision_planeSweepingCuda_%%%%%%%%"))
+  {
+    fs::create_directories(_folder);
+
+    std::ofstream ini((_folder / "mvs.ini").string());
+    ini << "[global]\nncams=" << nbCameras << "\nimgExt=exr\nverbose=FALSE\n\n[imageResolutions]\n";
+    for(int c = 0; c < nbCameras; ++c)
+      ini << c << "=" << width << "x" << height << "\n";
+    ini.close();
+
+    const int noiseSize = 256;
+    std::vector<float> noise(noiseSize * noiseSize);
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for(float& n : noise)
+      n = distribution(generator);
+
+    imageIO::MemoryImages::get().addFolder(_folder.string());
+
+    const double focal = width;
+    for(int c = 0; c < nbCameras; ++c)
+    {
+      // P = K [I | -C], looking at +z, C on the x axis
+      const double cx = c * baseline;
+      const double P[16] = {focal, 0.0, width / 2.0, -focal * cx,
+                            0.0, focal, height / 2.0, 0.0,
+                            0.0, 0.0, 1.0, 0.0,
+                            0.0, 0.0, 0.0, 1.0};
+
+      std::vector<Color> image(width * height);
+      for(int y = 0; y < height; ++y)
+      {
+        for(int x = 0; x < width; ++x)
+        {
+          // intersection of the pixel ray with the plane
+          const float px = static_cast<float>(cx + (x - width / 2.0) * planeDepth / focal);
+          const float py = static_cast<float>((y - height / 2.0) * planeDepth / focal);
+          const float value = planeTexture(px, py, noise, noiseSize);
+          image[y * width + x] = Color(value, value, value);
+        }
+      }
+
+      oiio::ImageSpec spec(width, height, 3, oiio::TypeDesc::FLOAT);
+      spec.attribute("AliceVision:downscale", 1);
+      spec.attribute("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), P);
+      imageIO::MemoryImages::get().store((_folder / (std::to_string(c) + ".exr")).string(), spec, image.data(), image.size() * sizeof(Color));
+    }
+  }
+
+  ~SyntheticScene()
+  {
+    imageIO::MemoryImages::get().removeFolder(_folder.string());
+    boost::system::error_code ec;
+    fs::remove_all(_folder, ec);
+  }
+
+  std::string getIniPath() const { return (_folder / "mvs.ini").string(); }
+
+private:
+  fs::path _folder;
+};
+
+/**
+ * @brief Run a function once (cameras upload), then time it over the repetitions
+ */
+void runBenchmark(const std::string& function, int width, int height, int nbDepths, const BenchmarkOptions& options,
+                  const std::function<void()>& func, std::vector<BenchmarkResult>& results)
+{
+  std::stringstream name;
+  name << function << "/" << width << "x" << height << "/depths:" << nbDepths;
+  if(!std::regex_search(name.str(), options.filter))
+    return;
+
+  func();
+
+  BenchmarkResult result;
+  result.function = function;
+  result.width = width;
+  result.height = height;
+  result.nbDepths = nbDepths;
+  for(int i = 0; i < options.nbRepetitions; ++i)
+  {
+    system::Timer timer;
+    func();
+    result.timesMs.push_back(timer.elapsedMs());
+  }
+
+  std::vector<double> sorted = result.timesMs;
+  std::sort(sorted.begin(), sorted.end());
+  std::cout << std::left << std::setw(56) << name.str() << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << sorted.front()
+            << std::setw(12) << sorted[sorted.size() / 2]
+            << std::setw(12) << sorted.back() << std::endl;
+
+  results.push_back(result);
+}
+
+void benchmarkResolution(int width, int height, const std::vector<int>& nbDepthsList, int device,
+                         const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  const SyntheticScene scene(width, height, 2);
+  mvsUtils::MultiViewParams mp(scene.getIniPath(), "", "", false, 1);
+  mvsUtils::PreMatchCams pc(&mp);
+  mvsUtils::ImagesCache ic(&mp, 0, true);
+  PlaneSweepingCuda cps(device, &ic, &mp, &pc, 1);
+
+  const int rc = 0;
+  StaticVector<int> tcams;
+  tcams.push_back(1);
+
+  // semi global matching parameters of depthMapEstimation
+  const int sgmWSH = 4;
+  const float sgmGammaC = 5.5f;
+  const float sgmGammaP = 8.0f;
+  const unsigned char sgmP1 = 10;
+  const unsigned char sgmP2 = 125;
+
+  // refine parameters of depthMapEstimation
+  const int refineWSH = 3;
+  const float refineGammaC = 15.5f;
+  const float refineGammaP = 8.0f;
+  const int refineNSamplesHalf = 150;
+  const float refineSigma = 15.0f;
+
+  const int volDimX = width / options.sgmStep;
+  const int volDimY = height / options.sgmStep;
+
+  StaticVector<Voxel> volumePixels;
+  volumePixels.reserve(volDimX * volDimY);
+  for(int y = 0; y < volDimY; ++y)
+    for(int x = 0; x < volDimX; ++x)
+      volumePixels.push_back(Voxel(x * options.sgmStep, y * options.sgmStep, 0));
+
+  const Point3d planeCenter(baseline / 2.0, 0.0, planeDepth);
+  const float pixSize = static_cast<float>(mp.getCamPixelSize(planeCenter, rc));
+
+  for(const int nbDepths : nbDepthsList)
+  {
+    // depths of the sweep around the plane
+    StaticVector<float> depths;
+    depths.reserve(nbDepths);
+    for(int d = 0; d < nbDepths; ++d)
+      depths.push_back(planeDepth * (0.75f + 0.5f * d / static_cast<float>(nbDepths)));
+
+    StaticVector<unsigned char> volume;
+    volume.resize_with(volDimX * volDimY * nbDepths, 255);
+
+    runBenchmark("sweepPixelsToVolume", width, height, nbDepths, options, [&]()
+    {
+      cps.sweepPixelsToVolume(nbDepths, &volume, volDimX, volDimY, nbDepths, options.sgmStep, 0, 0, 0,
+                              &depths, rc, sgmWSH, sgmGammaC, sgmGammaP, &volumePixels, 1, 1, &tcams, 0.0f);
+    }, results);
+
+    // the optimization is in place, start from the same volume
+    StaticVector<unsigned char> sweptVolume = volume;
+    runBenchmark("SGMoptimizeSimVolume", width, height, nbDepths, options, [&]()
+    {
+      volume = sweptVolume;
+      cps.SGMoptimizeSimVolume(rc, &volume, volDimX, volDimY, nbDepths, options.sgmStep, 0, 0, 1, sgmP1, sgmP2);
+    }, results);
+
+    // refine: the number of depths is the number of depths refined around each pixel
+    StaticVector<Pixel> refinePixels;
+    refinePixels.reserve(width * height);
+    for(int y = 0; y < height; ++y)
+      for(int x = 0; x < width; ++x)
+        refinePixels.push_back(Pixel(x, y));
+
+    runBenchmark("refinePixelsAll", width, height, nbDepths, options, [&]()
+    {
+      StaticVector<float> pixelsDepths;
+      StaticVector<float> pixelsSims;
+      pixelsDepths.resize_with(refinePixels.size(), planeDepth);
+      pixelsSims.resize_with(refinePixels.size(), 1.0f);
+      cps.refinePixelsAll(false, nbDepths, &pixelsDepths, &pixelsSims, rc, refineWSH, refineGammaC, refineGammaP,
+                          &refinePixels, 1, &tcams, 0.0f);
+    }, results);
+
+    // depth/sim maps of the rc and the tcams, noisy around the plane
+    std::mt19937 generator(nbDepths);
+    std::normal_distribution<float> depthNoise(0.0f, 2.0f * pixSize);
+    std::uniform_real_distribution<float> simDistribution(-1.0f, 0.0f);
+    std::vector<StaticVector<DepthSim>> maps(2);
+    for(StaticVector<DepthSim>& map : maps)
+    {
+      map.reserve(width * height);
+      for(int i = 0; i < width * height; ++i)
+        map.push_back(DepthSim(planeDepth + depthNoise(generator), simDistribution(generator)));
+    }
+
+    // processed in 4 parts, as RefineRc
+    const int nbParts = 4;
+    const int partHeight = height / nbParts;
+
+    runBenchmark("fuseDepthSimMapsGaussianKernelVoting", width, height, nbDepths, options, [&]()
+    {
+      StaticVector<StaticVector<DepthSim>*> dataMaps;
+      for(StaticVector<DepthSim>& map : maps)
+        dataMaps.push_back(&map);
+      for(int part = 0; part < nbParts; ++part)
+      {
+        StaticVector<DepthSim> fused;
+        fused.resize_with(width * partHeight, DepthSim(-1.0f, 1.0f));
+        cps.fuseDepthSimMapsGaussianKernelVoting(width, partHeight, &fused, &dataMaps, refineNSamplesHalf, nbDepths,
+                                                 refineSigma);
+      }
+    }, results);
+
+    // the visibility map (depth, pixSize) and the photometric map (depth, sim)
+    StaticVector<DepthSim> pixSizeMap;
+    pixSizeMap.reserve(width * height);
+    for(int i = 0; i < width * height; ++i)
+      pixSizeMap.push_back(DepthSim(maps[0][i].depth, pixSize));
+
+    runBenchmark("optimizeDepthSimMapGradientDescent", width, height, nbDepths, options, [&]()
+    {
+      StaticVector<StaticVector<DepthSim>*> dataMaps;
+      dataMaps.push_back(&pixSizeMap);
+      dataMaps.push_back(&maps[1]);
+      StaticVector<DepthSim> optimized;
+      optimized.resize_with(width * height, DepthSim(-1.0f, 1.0f));
+      for(int part = 0; part < nbParts; ++part)
+      {
+        const int yFrom = part * partHeight;
+        cps.optimizeDepthSimMapGradientDescent(&optimized, &dataMaps, rc, refineNSamplesHalf, nbDepths, refineSigma,
+                                               options.refineIters, yFrom, std::min(partHeight, height - yFrom));
+      }
+    }, results);
+  }
+}
+
+bool writeResults(const std::string& filepath, int device, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results)
+{
+  std::ofstream file(filepath);
+  if(!file.is_open())
+    return false;
+
+  file << "{\n  \"device\": " << device << ",\n  \"repetitions\": " << options.nbRepetitions
+       << ",\n  \"sgmStep\": " << options.sgmStep << ",\n  \"refineIters\": " << options.refineIters
+       << ",\n  \"peakUsedMemoryMB\": " << DeviceProfiler::getPeakUsedMemoryMB() << ",\n  \"results\": [";
+  for(std::size_t i = 0; i < results.size(); ++i)
+  {
+    const BenchmarkResult& result = results[i];
+    std::vector<double> sorted = result.timesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for(double t : sorted)
+      sum += t;
+
+    file << (i == 0 ? "\n" : ",\n");
+    file << "    {\"function\": \"" << result.function << "\", \"width\": " << result.width << ", \"height\": " << result.height
+         << ", \"depths\": " << result.nbDepths << ", \"minMs\": " << sorted.front()
+         << ", \"medianMs\": " << sorted[sorted.size() / 2] << ", \"maxMs\": " << sorted.back()
+         << ", \"meanMs\": " << sum / sorted.size() << ", \"timesMs\": [";
+    for(std::size_t t = 0; t < result.timesMs.size(); ++t)
+      file << (t == 0 ? "" : ", ") << result.timesMs[t];
+    file << "]}";
+  }
+  file << "\n  ]\n}\n";
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string filter = ".*";
+  std::string output = "planeSweepingCuda_benchmark.json";
+  int nbRepetitions = 5;
+  int device = 0;
+  int sgmStep = 2;
+  int refineIters = 100;
+  std::vector<int> widths = {640, 1280, 1920};
+  std::vector<int> nbDepthsList = {64, 128, 256};
+
+  po::options_description allParams("Benchmark of the PlaneSweepingCuda host functions on synthetic scenes");
+  allParams.add_options()
+    ("help,h", "Print this help.")
+    ("output,o", po::value<std::string>(&output)->default_value(output),
+      "Output JSON file of the results.")
+    ("filter", po::value<std::string>(&filter)->default_value(filter),
+      "Regular expression selecting the benchmarks to run by name "
+      "(e.g. \"SGMoptimizeSimVolume/\", \"/1920x1440/\", \"/depths:256\").")
+    ("repetitions,r", po::value<int>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of timed runs of each benchmark.")
+    ("widths,w", po::value<std::vector<int>>(&widths)->multitoken(),
+      "Widths of the images, in 4:3 (default: 640 1280 1920).")
+    ("depths,d", po::value<std::vector<int>>(&nbDepthsList)->multitoken(),
+      "Numbers of depths of the sweep, also used as numbers of depths to refine (default: 64 128 256).")
+    ("sgmStep", po::value<int>(&sgmStep)->default_value(sgmStep),
+      "Step in pixels of the similarity volume.")
+    ("refineIters", po::value<int>(&refineIters)->default_value(refineIters),
+      "Number of iterations of optimizeDepthSimMapGradientDescent.")
+    ("device", po::value<int>(&device)->default_value(device),
+      "CUDA device.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      std::cout << allParams << std::endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cout << "Usage:\n\n" << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  BenchmarkOptions options;
+  try
+  {
+    options.filter = std::regex(filter);
+  }
+  catch(const std::regex_error& e)
+  {
+    std::cerr << "ERROR: invalid filter: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  options.nbRepetitions = std::max(1, nbRepetitions);
+  options.sgmStep = std::max(1, sgmStep);
+  options.refineIters = std::max(1, refineIters);
+
+  system::Logger::get()->setLogLevel(system::EVerboseLevel::Warning);
+
+  // peak of used device memory
+  DeviceProfiler::setEnabled(true);
+
+  std::cout << std::left << std::setw(56) << "Benchmark (times in ms)" << std::right
+            << std::setw(12) << "min" << std::setw(12) << "median" << std::setw(12) << "max" << std::endl;
+
+  std::vector<BenchmarkResult> results;
+  for(const int width : widths)
+    benchmarkResolution(width, width * 3 / 4, nbDepthsList, device, options, results);
+
+  if(!writeResults(output, device, options, results))
+  {
+    std::cerr << "ERROR: can't write the results: " << output << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Results written: " << output << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DescriptorPCA.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <typeinfo>
+
+namespace aliceVision {
+namespace feature {
+
+const std::size_t DescriptorPCA::reducedLength;
+
+namespace {
+
+const char pcaFileMagic[8] = {'A', 'V', 'D', 'E', 'S', 'P', 'C', 'A'};
+
+/// number of descriptors projected with a single matrix product
+const std::size_t projectionBlockSize = 1024;
+
+template<typename T>
+void copyDescriptorsT(const T* data, std::size_t length, std::size_t first, std::size_t count, std::size_t step, Eigen::Ref<Eigen::MatrixXf> out)
+{
+  for(std::size_t k = 0; k < count; ++k)
+  {
+    const T* desc = data + (first + k * step) * length;
+    for(std::size_t d = 0; d < length; ++d)
+      out(d, k) = static_cast<float>(desc[d]);
+  }
+}
+
+/**
+ * @brief Copy the descriptors first, first + step, ... of the regions in the columns of a float matrix
+ */
+void copyDescriptors(const Regions& regions, std::size_t first, std::size_t count, std::size_t step, Eigen::Ref<Eigen::MatrixXf> out)
+{
+  if(count == 0)
+    return;
+
+  const std::size_t length = regions.DescriptorLength();
+  const std::string typeId = regions.Type_id();
+
+  if(typeId == typeid(unsigned char).name())
+    copyDescriptorsT(static_cast<const unsigned char*>(regions.DescriptorRawData()), length, first, count, step, out);
+  else if(typeId == typeid(float).name())
+    copyDescriptorsT(static_cast<const float*>(regions.DescriptorRawData()), length, first, count, step, out);
+  else if(typeId == typeid(double).name())
+    copyDescriptorsT(static_cast<const double*>(regions.DescriptorRawData()), length, first, count, step, out);
+  else
+    throw std::invalid_argument("Unsupported descriptor type for the PCA reduction (typeid: " + typeId + ").");
+}
+
+} // namespace
+
+void DescriptorPCA::learn(const std::vector<const Regions*>& regions, std::size_t maxNbDescriptors)
+{
+  if(regions.empty())
+    throw std::invalid_argument("Can't learn the descriptor PCA basis without regions.");
+
+  const std::size_t length = regions.front()->DescriptorLength();
+  if(!regions.front()->IsScalar() || length <= reducedLength)
+    throw std::invalid_argument("The descriptor PCA needs scalar descriptors longer than " + std::to_string(reducedLength) + ".");
+
+  std::size_t nbDescriptors = 0;
+  for(const Regions* r : regions)
+  {
+    if(r->DescriptorLength() != length || r->Type_id() != regions.front()->Type_id())
+      throw std::invalid_argument("Can't learn the descriptor PCA basis on different descriptor types.");
+    nbDescriptors += r->RegionCount();
+  }
+
+  // evenly sample the descriptors of all the images
+  const std::size_t step = std::max<std::size_t>(1, (nbDescriptors + maxNbDescriptors - 1) / std::max<std::size_t>(maxNbDescriptors, 1));
+  std::size_t nbSamples = 0;
+  for(const Regions* r : regions)
+    nbSamples += (r->RegionCount() + step - 1) / step;
+
+  if(nbSamples < 2)
+    throw std::invalid_argument("Not enough descriptors to learn the descriptor PCA basis.");
+
+  Eigen::MatrixXf samples(length, nbSamples);
+  std::size_t col = 0;
+  for(const Regions* r : regions)
+  {
+    const std::size_t count = (r->RegionCount() + step - 1) / step;
+    copyDescriptors(*r, 0, count, step, samples.middleCols(col, count));
+    col += count;
+  }
+
+  const Eigen::MatrixXd samplesD = samples.cast<double>();
+  const Eigen::VectorXd mean = samplesD.rowwise().mean();
+  const Eigen::MatrixXd centered = samplesD.colwise() - mean;
+  const Eigen::MatrixXd covariance = (centered * centered.transpose()) / static_cast<double>(nbSamples - 1);
+
+  // eigen values in increasing order
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(covariance);
+  if(solver.info() != Eigen::Success)
+    throw std::runtime_error("Descriptor PCA: the eigen decomposition failed.");
+
+  const Eigen::VectorXd& eigenValues = solver.eigenvalues();
+  const Eigen::MatrixXd& eigenVectors = solver.eigenvectors();
+
+  _mean = mean.cast<float>();
+  _basis.resize(reducedLength, length);
+  for(std::size_t k = 0; k < reducedLength; ++k)
+    _basis.row(k) = eigenVectors.col(length - 1 - k).transpose().cast<float>();
+
+  const double totalVariance = eigenValues.sum();
+  _explainedVariance = (totalVariance > 0.0) ? eigenValues.tail(reducedLength).sum() / totalVariance : 1.0;
+
+  // the first component, with the largest variance, is quantized on +/- 3 standard deviations
+  const double maxDeviation = 3.0 * std::sqrt(std::max(eigenValues(length - 1), 0.0));
+  _scale = (maxDeviation > 0.0) ? static_cast<float>(127.0 / maxDeviation) : 1.f;
+}
+
+std::unique_ptr<Regions> DescriptorPCA::project(const Regions& regions) const
+{
+  if(!isValid())
+    throw std::invalid_argument("Can't project the descriptors with an empty PCA basis.");
+
+  const FeatRegions<SIOPointFeature>* sioRegions = dynamic_cast<const FeatRegions<SIOPointFeature>*>(&regions);
+  if(sioRegions == nullptr || !regions.IsScalar() || regions.DescriptorLength() != descriptorLength())
+    throw std::invalid_argument("The regions don't match the descriptor PCA basis (descriptor length: " + std::to_string(regions.DescriptorLength()) + ").");
+
+  SIFT_PCA64_Regions* reducedRegions = new SIFT_PCA64_Regions;
+  std::unique_ptr<Regions> out(reducedRegions);
+
+  const std::size_t nbRegions = regions.RegionCount();
+  reducedRegions->Features() = sioRegions->Features();
+  reducedRegions->Descriptors().resize(nbRegions);
+
+  Eigen::MatrixXf block(descriptorLength(), std::min(nbRegions, projectionBlockSize));
+  Eigen::MatrixXf projected;
+
+  for(std::size_t first = 0; first < nbRegions; first += projectionBlockSize)
+  {
+    const std::size_t count = std::min(projectionBlockSize, nbRegions - first);
+    copyDescriptors(regions, first, count, 1, block.leftCols(count));
+    projected.noalias() = _scale * (_basis * (block.leftCols(count).colwise() - _mean));
+
+    for(std::size_t k = 0; k < count; ++k)
+    {
+      unsigned char* desc = reducedRegions->Descriptors()[first + k].getData();
+      for(std::size_t d = 0; d < reducedLength; ++d)
+        desc[d] = static_cast<unsigned char>(std::min(255.f, std::max(0.f, std::round(128.f + projected(d, k)))));
+    }
+  }
+  return out;
+}
+
+void DescriptorPCA::save(const std::string& filename) const
+{
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error("Can't save the descriptor PCA basis, can't open '" + filename + "' !");
+
+  const std::uint32_t length = static_cast<std::uint32_t>(descriptorLength());
+  const std::uint32_t reduced = static_cast<std::uint32_t>(reducedLength);
+
+  file.write(pcaFileMagic, sizeof(pcaFileMagic));
+  file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+  file.write(reinterpret_cast<const char*>(&reduced), sizeof(reduced));
+  file.write(reinterpret_cast<const char*>(&_scale), sizeof(_scale));
+  file.write(reinterpret_cast<const char*>(&_explainedVariance), sizeof(_explainedVariance));
+  file.write(reinterpret_cast<const char*>(_mean.data()), _mean.size() * sizeof(float));
+  file.write(reinterpret_cast<const char*>(_basis.data()), _basis.size() * sizeof(float));
+
+  if(!file.good())
+    throw std::runtime_error("Can't save the descriptor PCA basis, '" + filename + "' is incorrect !");
+}
+
+void DescriptorPCA::load(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error("Can't load the descriptor PCA basis, can't open '" + filename + "' !");
+
+  char magic[sizeof(pcaFileMagic)];
+  std::uint32_t length = 0;
+  std::uint32_t reduced = 0;
+
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&length), sizeof(length));
+  file.read(reinterpret_cast<char*>(&reduced), sizeof(reduced));
+
+  if(!file.good() || !std::equal(magic, magic + sizeof(magic), pcaFileMagic) || reduced != reducedLength || length <= reducedLength)
+    throw std::runtime_error("Can't load the descriptor PCA basis, '" + filename + "' is incorrect !");
+
+  _mean.resize(length);
+  _basis.resize(reducedLength, length);
+
+  file.read(reinterpret_cast<char*>(&_scale), sizeof(_scale));
+  file.read(reinterpret_cast<char*>(&_explainedVariance), sizeof(_explainedVariance));
+  file.read(reinterpret_cast<char*>(_mean.data()), _mean.size() * sizeof(float));
+  file.read(reinterpret_cast<char*>(_basis.data()), _basis.size() * sizeof(float));
+
+  if(!file.good())
+  {
+    _basis.resize(0, 0);
+    throw std::runtime_error("Can't load the descriptor PCA basis, '" + filename + "' is incorrect !");
+  }
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,72 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Compact storage of the scalar descriptors: PCA projection to 64 dimensions quantized on 8 bits.
+ *
+ * The basis is learned on a sample of descriptors of the dataset. The reduced descriptors
+ * use 2x less memory than the SIFT descriptors (8x less than SIFT_FLOAT) and are matched
+ * with the usual L2 matchers: the quantization uses the same scale for all the dimensions,
+ * so the distance ratios are kept.
+ */
+class DescriptorPCA
+{
+public:
+  /// Length of the reduced descriptors
+  static const std::size_t reducedLength = 64;
+
+  bool isValid() const { return _basis.rows() > 0; }
+
+  /// Length of the input descriptors
+  std::size_t descriptorLength() const { return static_cast<std::size_t>(_mean.size()); }
+
+  /// Fraction of the variance of the learning descriptors kept by the projection
+  double getExplainedVariance() const { return _explainedVariance; }
+
+  /**
+   * @brief Learn the projection basis from the descriptors of several images
+   * @param[in] regions The regions of the learning images, all with the same scalar descriptor type
+   * @param[in] maxNbDescriptors The max. number of descriptors used, evenly sampled in the images
+   * @throw std::invalid_argument if the descriptors can't be reduced
+   */
+  void learn(const std::vector<const Regions*>& regions, std::size_t maxNbDescriptors = 100000);
+
+  /**
+   * @brief Project the descriptors of the given regions
+   * @param[in] regions SIOPointFeature regions with a scalar descriptor of length descriptorLength()
+   * @return The regions with the same features and the reduced descriptors (SIFT_PCA64_Regions)
+   * @throw std::invalid_argument if the regions are not compatible with the basis
+   */
+  std::unique_ptr<Regions> project(const Regions& regions) const;
+
+  void save(const std::string& filename) const;
+  void load(const std::string& filename);
+
+private:
+  Eigen::VectorXf _mean;
+  /// reducedLength x descriptorLength projection matrix
+  Eigen::MatrixXf _basis;
+  /// quantization scale of the projected values, centered on 128
+  float _scale = 1.f;
+  double _explainedVariance = 0.0;
+};
+
+} // namespace feature
+} // namespace aliceVision
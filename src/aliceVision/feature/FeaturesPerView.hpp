@@ -89,6 +89,12 @@ public:
     _data[viewId][descType] = pointFeatures;
   }
 
+  void addFeatures(IndexT viewId, feature::EImageDescriberType descType, feature::PointFeatures&& pointFeatures)
+  {
+    assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+    _data[viewId][descType] = std::move(pointFeatures);
+  }
+
   /**
    * @brief Get a reference of private container data
    * @return MapFeaturesPerView reference
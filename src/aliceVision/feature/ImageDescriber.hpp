@@ -98,6 +98,13 @@ public:
    */
   virtual std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const = 0;
 
+  /**
+   * @brief Get the max. number of images a CUDA image describer can describe at the same time,
+   * from different threads (the other image describers are not shared between threads).
+   * @return number of concurrent describe() calls
+   */
+  virtual std::size_t getMaxConcurrentDescriptions() const { return 1; }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
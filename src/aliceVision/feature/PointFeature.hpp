@@ -11,6 +11,7 @@
 #include <iostream>
 #include <iterator>
 #include <fstream>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -144,6 +145,32 @@ inline void loadFeatsFromFile(
   fileIn.close();
 }
 
+/**
+ * @brief Read only the positions of the feats of a file, whatever the feature type
+ * @note Each line of a features file starts with the feature position, the end of the line is skipped.
+ */
+inline void loadFeatPositionsFromFile(
+  const std::string & sfileNameFeats,
+  std::vector<PointFeature> & vec_feat)
+{
+  vec_feat.clear();
+
+  std::ifstream fileIn(sfileNameFeats);
+
+  if(!fileIn.is_open())
+    throw std::runtime_error("Can't load features file, can't open '" + sfileNameFeats + "' !");
+
+  PointFeature feat;
+  while(fileIn >> feat)
+  {
+    vec_feat.push_back(feat);
+    fileIn.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  if(fileIn.bad() || !fileIn.eof())
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' is incorrect !");
+  fileIn.close();
+}
+
 /// Write feats to file
 template<typename FeaturesT >
 inline void saveFeatsToFile(
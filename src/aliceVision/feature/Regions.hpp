@@ -15,6 +15,7 @@
 
 #include <string>
 #include <cstddef>
+#include <cstring>
 #include <typeinfo>
 #include <memory>
 
@@ -99,6 +100,27 @@ public:
 
   virtual void clearDescriptors() = 0;
 
+  /**
+   * @brief Return a pointer to the first value of the features array.
+   *
+   * @note: Features are always stored as a flat array of FeatureT.
+   */
+  virtual const void* FeatureRawData() const = 0;
+
+  /// Return the size in bytes of one feature
+  virtual std::size_t FeatureByteSize() const = 0;
+
+  /// Return the size in bytes of one descriptor
+  virtual std::size_t DescriptorByteSize() const = 0;
+
+  /**
+   * @brief Replace the regions by a copy of raw binary data.
+   * @param[in] count the number of regions
+   * @param[in] featsData pointer to count * FeatureByteSize() bytes
+   * @param[in] descsData pointer to count * DescriptorByteSize() bytes, or nullptr to only set the features
+   */
+  virtual void setRawData(std::size_t count, const void* featsData, const void* descsData) = 0;
+
   /// Return the squared distance between two descriptors
   // A default metric is used according the descriptor type:
   // - Scalar: L2,
@@ -152,6 +174,10 @@ public:
   /// Return the number of defined regions
   std::size_t RegionCount() const {return _vec_feats.size();}
 
+  const void* FeatureRawData() const override { return _vec_feats.data(); }
+
+  std::size_t FeatureByteSize() const override { return sizeof(FeatureT); }
+
   /// Mutable and non-mutable FeatureT getters.
   inline std::vector<FeatureT> & Features() { return _vec_feats; }
   inline const std::vector<FeatureT> & Features() const { return _vec_feats; }
@@ -249,6 +275,25 @@ public:
 
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
+  std::size_t DescriptorByteSize() const override { return sizeof(DescriptorT); }
+
+  void setRawData(std::size_t count, const void* featsData, const void* descsData) override
+  {
+    this->_vec_feats.resize(count);
+    if(count > 0)
+      std::memcpy(this->_vec_feats.data(), featsData, count * sizeof(FeatT));
+
+    if(descsData == nullptr)
+    {
+      _vec_descs.clear();
+      return;
+    }
+
+    _vec_descs.resize(count);
+    if(count > 0)
+      std::memcpy(_vec_descs.data(), descsData, count * sizeof(DescriptorT));
+  }
+
   inline void swap(This& other)
   {
     this->_vec_feats.swap(other._vec_feats);
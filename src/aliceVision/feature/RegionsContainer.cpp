@@ -0,0 +1,230 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsContainer.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+const char regionsContainerMagic[8] = {'A', 'V', 'R', 'E', 'G', 'I', 'O', 'N'};
+const std::uint32_t regionsContainerVersion = 1;
+const std::uint64_t regionsContainerAlignment = 16;
+
+} // namespace
+
+std::string getRegionsContainerPath(const std::string& folder, EImageDescriberType describerType)
+{
+  return (fs::path(folder) / (EImageDescriberType_enumToString(describerType) + ".regions")).string();
+}
+
+RegionsContainerWriter::RegionsContainerWriter(const std::string& filepath, EImageDescriberType describerType)
+  : _stream(filepath, std::ios::out | std::ios::binary)
+  , _filepath(filepath)
+{
+  if(!_stream.is_open())
+    throw std::runtime_error("Can't save regions container, can't open '" + filepath + "' !");
+
+  std::memset(&_header, 0, sizeof(RegionsContainerHeader));
+  std::memcpy(_header.magic, regionsContainerMagic, sizeof(_header.magic));
+  _header.version = regionsContainerVersion;
+  _header.describerType = static_cast<std::uint32_t>(describerType);
+
+  // reserve the header, it will be written on close
+  _stream.write(reinterpret_cast<const char*>(&_header), sizeof(RegionsContainerHeader));
+  _isOpen = true;
+}
+
+RegionsContainerWriter::~RegionsContainerWriter()
+{
+  if(!_isOpen)
+    return;
+  try
+  {
+    close();
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+  }
+}
+
+void RegionsContainerWriter::align()
+{
+  const std::uint64_t pos = static_cast<std::uint64_t>(_stream.tellp());
+  const std::uint64_t padding = (regionsContainerAlignment - pos % regionsContainerAlignment) % regionsContainerAlignment;
+  const char zeros[regionsContainerAlignment] = {0};
+  _stream.write(zeros, padding);
+}
+
+void RegionsContainerWriter::add(IndexT viewId, const Regions& regions)
+{
+  if(!_isOpen)
+    throw std::runtime_error("Can't add regions to the closed container '" + _filepath + "' !");
+
+  if(_entries.empty())
+  {
+    _header.featureByteSize = regions.FeatureByteSize();
+    _header.descriptorByteSize = regions.DescriptorByteSize();
+  }
+  else if(_header.featureByteSize != regions.FeatureByteSize() ||
+          _header.descriptorByteSize != regions.DescriptorByteSize())
+  {
+    throw std::runtime_error("Can't add regions of view " + std::to_string(viewId) + " to the container '" + _filepath + "', incompatible regions type !");
+  }
+
+  RegionsContainerEntry entry;
+  entry.viewId = viewId;
+  entry.nbRegions = regions.RegionCount();
+
+  align();
+  entry.featuresOffset = static_cast<std::uint64_t>(_stream.tellp());
+  if(entry.nbRegions > 0)
+    _stream.write(static_cast<const char*>(regions.FeatureRawData()), entry.nbRegions * _header.featureByteSize);
+
+  align();
+  entry.descriptorsOffset = static_cast<std::uint64_t>(_stream.tellp());
+  if(entry.nbRegions > 0)
+    _stream.write(static_cast<const char*>(regions.DescriptorRawData()), entry.nbRegions * _header.descriptorByteSize);
+
+  if(!_stream.good())
+    throw std::runtime_error("Can't save regions container, '" + _filepath + "' is incorrect !");
+
+  _entries.push_back(entry);
+}
+
+void RegionsContainerWriter::close()
+{
+  if(!_isOpen)
+    return;
+  _isOpen = false;
+
+  align();
+  _header.nbViews = _entries.size();
+  _header.indexOffset = static_cast<std::uint64_t>(_stream.tellp());
+
+  if(!_entries.empty())
+    _stream.write(reinterpret_cast<const char*>(_entries.data()), _entries.size() * sizeof(RegionsContainerEntry));
+
+  _stream.seekp(0);
+  _stream.write(reinterpret_cast<const char*>(&_header), sizeof(RegionsContainerHeader));
+
+  if(!_stream.good())
+    throw std::runtime_error("Can't save regions container, '" + _filepath + "' is incorrect !");
+
+  _stream.close();
+}
+
+RegionsContainerReader::RegionsContainerReader(const std::string& filepath)
+  : _filepath(filepath)
+{
+  if(!fs::exists(filepath))
+    throw std::runtime_error("Can't load regions container, can't open '" + filepath + "' !");
+
+  _file.open(filepath);
+
+  if(!_file.is_open() || _file.size() < sizeof(RegionsContainerHeader))
+    throw std::runtime_error("Can't load regions container, '" + filepath + "' is incorrect !");
+
+  std::memcpy(&_header, _file.data(), sizeof(RegionsContainerHeader));
+
+  if(std::memcmp(_header.magic, regionsContainerMagic, sizeof(_header.magic)) != 0)
+    throw std::runtime_error("Can't load regions container, '" + filepath + "' is not a regions container !");
+
+  if(_header.version != regionsContainerVersion)
+    throw std::runtime_error("Can't load regions container, '" + filepath + "' has an unsupported version (" + std::to_string(_header.version) + ") !");
+
+  const std::uint64_t fileSize = _file.size();
+
+  if(_header.indexOffset + _header.nbViews * sizeof(RegionsContainerEntry) > fileSize)
+    throw std::runtime_error("Can't load regions container, '" + filepath + "' is truncated !");
+
+  const RegionsContainerEntry* entries = reinterpret_cast<const RegionsContainerEntry*>(_file.data() + _header.indexOffset);
+
+  for(std::uint64_t i = 0; i < _header.nbViews; ++i)
+  {
+    const RegionsContainerEntry& entry = entries[i];
+
+    if(entry.featuresOffset + entry.nbRegions * _header.featureByteSize > fileSize ||
+       entry.descriptorsOffset + entry.nbRegions * _header.descriptorByteSize > fileSize)
+      throw std::runtime_error("Can't load regions container, '" + filepath + "' is truncated !");
+
+    _entries.emplace(static_cast<IndexT>(entry.viewId), entry);
+  }
+
+  ALICEVISION_LOG_TRACE("Regions container '" << filepath << "': " << _entries.size() << " views.");
+}
+
+std::vector<IndexT> RegionsContainerReader::getViewIds() const
+{
+  std::vector<IndexT> viewIds;
+  viewIds.reserve(_entries.size());
+  for(const auto& entryPair : _entries)
+    viewIds.push_back(entryPair.first);
+  return viewIds;
+}
+
+const RegionsContainerEntry& RegionsContainerReader::getEntry(IndexT viewId) const
+{
+  const auto it = _entries.find(viewId);
+  if(it == _entries.end())
+    throw std::out_of_range("Can't find view " + std::to_string(viewId) + " in regions container '" + _filepath + "' !");
+  return it->second;
+}
+
+std::size_t RegionsContainerReader::getRegionCount(IndexT viewId) const
+{
+  return getEntry(viewId).nbRegions;
+}
+
+const void* RegionsContainerReader::getFeaturesData(IndexT viewId) const
+{
+  return _file.data() + getEntry(viewId).featuresOffset;
+}
+
+const void* RegionsContainerReader::getDescriptorsData(IndexT viewId) const
+{
+  return _file.data() + getEntry(viewId).descriptorsOffset;
+}
+
+void RegionsContainerReader::load(IndexT viewId, Regions& regions, bool withDescriptors) const
+{
+  if(regions.FeatureByteSize() != _header.featureByteSize ||
+     regions.DescriptorByteSize() != _header.descriptorByteSize)
+    throw std::runtime_error("Can't load view " + std::to_string(viewId) + " from regions container '" + _filepath + "', incompatible regions type !");
+
+  const RegionsContainerEntry& entry = getEntry(viewId);
+
+  regions.setRawData(entry.nbRegions,
+                     _file.data() + entry.featuresOffset,
+                     withDescriptors ? _file.data() + entry.descriptorsOffset : nullptr);
+}
+
+void RegionsContainerReader::loadPositions(IndexT viewId, PointFeatures& positions) const
+{
+  // all the feature types derive from PointFeature: the position is at the beginning of each feature
+  if(_header.featureByteSize < sizeof(PointFeature))
+    throw std::runtime_error("Can't load view " + std::to_string(viewId) + " positions from regions container '" + _filepath + "', incompatible regions type !");
+
+  const RegionsContainerEntry& entry = getEntry(viewId);
+  const char* featuresData = _file.data() + entry.featuresOffset;
+
+  positions.resize(entry.nbRegions);
+  for(std::size_t i = 0; i < entry.nbRegions; ++i)
+    std::memcpy(&positions[i], featuresData + i * _header.featureByteSize, sizeof(PointFeature));
+}
+
+} // namespace feature
+} // namespace aliceVision
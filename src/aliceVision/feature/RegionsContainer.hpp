@@ -0,0 +1,172 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Binary regions container file layout (version 1, native little-endian):
+ *
+ *   RegionsContainerHeader
+ *   [features block][descriptors block] for each view (16 bytes aligned)
+ *   RegionsContainerEntry * header.nbViews (index table)
+ *
+ * Each block is the raw memory of the std::vector of features / descriptors of a view,
+ * so a view can be accessed without any parsing, directly from the mapped file.
+ */
+struct RegionsContainerHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t describerType;
+  std::uint64_t featureByteSize;
+  std::uint64_t descriptorByteSize;
+  std::uint64_t nbViews;
+  std::uint64_t indexOffset;
+};
+
+/**
+ * @brief Index table entry of a view in a binary regions container
+ */
+struct RegionsContainerEntry
+{
+  std::uint64_t viewId;
+  std::uint64_t nbRegions;
+  std::uint64_t featuresOffset;
+  std::uint64_t descriptorsOffset;
+};
+
+/**
+ * @brief Get the filename of the binary regions container of a given describer type.
+ * @param[in] folder The features folder
+ * @param[in] describerType The describer type
+ * @return the container file path (<folder>/<describerType>.regions)
+ */
+std::string getRegionsContainerPath(const std::string& folder, EImageDescriberType describerType);
+
+/**
+ * @brief Write the regions of multiple views in a single binary container.
+ */
+class RegionsContainerWriter
+{
+public:
+
+  /**
+   * @brief RegionsContainerWriter constructor
+   * @param[in] filepath The output container file path
+   * @param[in] describerType The describer type of all the regions
+   */
+  RegionsContainerWriter(const std::string& filepath, EImageDescriberType describerType);
+
+  ~RegionsContainerWriter();
+
+  /**
+   * @brief Append the regions of a view to the container.
+   * @param[in] viewId The view id
+   * @param[in] regions The view regions (features and descriptors)
+   */
+  void add(IndexT viewId, const Regions& regions);
+
+  /**
+   * @brief Write the index table and the header, then close the container file.
+   * @note Called by the destructor if needed.
+   */
+  void close();
+
+private:
+  void align();
+
+  std::ofstream _stream;
+  std::string _filepath;
+  RegionsContainerHeader _header;
+  std::vector<RegionsContainerEntry> _entries;
+  bool _isOpen = false;
+};
+
+/**
+ * @brief Read view regions from a memory-mapped binary container.
+ */
+class RegionsContainerReader
+{
+public:
+
+  /**
+   * @brief RegionsContainerReader constructor
+   * @param[in] filepath The container file path
+   * @throw std::runtime_error if the container is not valid
+   */
+  explicit RegionsContainerReader(const std::string& filepath);
+
+  /// Return the describer type of all the regions of the container
+  EImageDescriberType getDescriberType() const
+  {
+    return static_cast<EImageDescriberType>(_header.describerType);
+  }
+
+  /// Return true if the container stores regions for the given view
+  bool hasView(IndexT viewId) const
+  {
+    return _entries.find(viewId) != _entries.end();
+  }
+
+  /// Return all the view ids stored in the container
+  std::vector<IndexT> getViewIds() const;
+
+  /// Return the number of regions of the given view
+  std::size_t getRegionCount(IndexT viewId) const;
+
+  /**
+   * @brief Zero-copy access to the features of the given view.
+   * @note The pointer is valid as long as the reader remains alive.
+   */
+  const void* getFeaturesData(IndexT viewId) const;
+
+  /**
+   * @brief Zero-copy access to the descriptors of the given view.
+   * @note The pointer is valid as long as the reader remains alive.
+   */
+  const void* getDescriptorsData(IndexT viewId) const;
+
+  /**
+   * @brief Fill the given regions with the data of a view.
+   * @param[in] viewId The view id
+   * @param[out] regions The regions to fill (allocated with the container describer type)
+   * @param[in] withDescriptors If false, only the features are loaded
+   */
+  void load(IndexT viewId, Regions& regions, bool withDescriptors = true) const;
+
+  /**
+   * @brief Read only the feature positions of a view, without allocating regions.
+   * @param[in] viewId The view id
+   * @param[out] positions The feature positions
+   */
+  void loadPositions(IndexT viewId, PointFeatures& positions) const;
+
+private:
+  const RegionsContainerEntry& getEntry(IndexT viewId) const;
+
+  std::string _filepath;
+  boost::iostreams::mapped_file_source _file;
+  RegionsContainerHeader _header;
+  std::map<IndexT, RegionsContainerEntry> _entries;
+};
+
+} // namespace feature
+} // namespace aliceVision
@@ -8,6 +8,10 @@
 #include "aliceVision/feature/akaze/AKAZE.hpp"
 #include <aliceVision/config.hpp>
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/feature/akaze/cuda/akazeScaleSpace.hpp>
+#endif
+
 namespace aliceVision {
 namespace feature {
 
@@ -239,6 +243,107 @@ void AKAZE::Compute_AKAZEScaleSpace(void)
   }
 }
 
+bool AKAZE::Compute_AKAZEScaleSpaceCUDA(void)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  if(!akazeCUDA_isAvailable())
+    return false;
+
+  const auto toFloatKernel = [](const Vec & kernel)
+  {
+    std::vector<float> res(kernel.size());
+    for(int i = 0; i < kernel.size(); ++i)
+      res[i] = static_cast<float>(kernel(i));
+    return res;
+  };
+
+  // same kernels as the CPU version (see ComputeAKAZESlice)
+  const std::vector<float> gaussianKernel = toFloatKernel(ComputeGaussianKernel(0, options_.fSigma0));
+  const std::vector<float> smoothingKernel = toFloatKernel(ComputeGaussianKernel(0, 1.f));
+
+  float contrast_factor = ComputeAutomaticContrastFactor( in_, 0.7f ) ;
+
+  std::vector<TEvolution> evolution;
+  std::vector<AKAZESliceCUDA> slices;
+  evolution.reserve(options_.iNbOctave * options_.iNbSlicePerOctave);
+  slices.reserve(options_.iNbOctave * options_.iNbSlicePerOctave);
+
+  int width = in_.Width();
+  int height = in_.Height();
+
+  for( int p = 0 ; p < options_.iNbOctave ; ++p )
+  {
+    contrast_factor *= (p == 0) ? 1.f : 0.75f;
+
+    for( int q = 0 ; q < options_.iNbSlicePerOctave ; ++q )
+    {
+      if(p > 0 && q == 0)
+      {
+        width /= 2;
+        height /= 2;
+      }
+
+      const float sigma_cur = Sigma( options_.fSigma0 , p , q , options_.iNbSlicePerOctave );
+      const int sigma_scale = MathTrait<float>::round(sigma_cur * fderivative_factor / static_cast<float>(1 << p));
+      const int derivative_size = 2 * sigma_scale + 1;
+      if(derivative_size > AKAZE_CUDA_MAX_KERNEL_SIZE)
+        return false;
+
+      AKAZESliceCUDA slice;
+      slice.width = width;
+      slice.height = height;
+      slice.halfSample = (p > 0 && q == 0);
+      slice.nonLinear = (p > 0 || q > 0);
+      slice.gaussianKernel = gaussianKernel;
+      slice.smoothingKernel = smoothingKernel;
+      slice.contrastFactor = contrast_factor;
+      slice.derivativeScale = sigma_scale;
+
+      if(slice.nonLinear)
+      {
+        const float sigma_prev = ( q == 0 ) ? Sigma( options_.fSigma0 , p - 1 , options_.iNbSlicePerOctave - 1 , options_.iNbSlicePerOctave )
+                                            : Sigma( options_.fSigma0 , p , q - 1 , options_.iNbSlicePerOctave ) ;
+        const float total_cycle_time = 0.5f * ( sigma_cur * sigma_cur ) - 0.5f * ( sigma_prev * sigma_prev ) ;
+        FEDCycleTimings( total_cycle_time , 0.25f , slice.tau ) ;
+      }
+
+      // scaled Scharr kernels (see ImageScaledScharrXDerivative)
+      const float w = 10.f / 3.f;
+      slice.derivativeKernel.assign(derivative_size, 0.f);
+      slice.derivativeKernel.front() = -1.f;
+      slice.derivativeKernel.back() = 1.f;
+      slice.derivativeSmoothingKernel.assign(derivative_size, 0.f);
+      slice.derivativeSmoothingKernel.front() = 1.f;
+      slice.derivativeSmoothingKernel[derivative_size / 2] = w;
+      slice.derivativeSmoothingKernel.back() = 1.f;
+      for(float& value : slice.derivativeSmoothingKernel)
+        value /= 2.f * sigma_scale * ( w + 2.f );
+
+      evolution.emplace_back(TEvolution());
+      TEvolution & evo = evolution.back();
+      evo.cur.resize(width, height, false);
+      evo.Lx.resize(width, height, false);
+      evo.Ly.resize(width, height, false);
+      evo.Lhess.resize(width, height, false);
+      slice.cur = evo.cur.data();
+      slice.Lx = evo.Lx.data();
+      slice.Ly = evo.Ly.data();
+      slice.Lhess = evo.Lhess.data();
+
+      slices.push_back(slice);
+    }
+  }
+
+  if(!akazeCUDA_computeScaleSpace(in_.data(), in_.Width(), in_.Height(), slices))
+    return false;
+
+  evolution_.swap(evolution);
+  return true;
+#else
+  return false;
+#endif
+}
+
 void detectDuplicates(
   std::vector<std::pair<AKAZEKeypoint, bool> > & previous,
   std::vector<std::pair<AKAZEKeypoint, bool> > & current)
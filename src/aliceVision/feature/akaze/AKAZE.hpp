@@ -104,6 +104,12 @@ public:
   /// Compute the AKAZE non linear diffusion scale space per slice
   void Compute_AKAZEScaleSpace(void);
 
+  /**
+   * @brief Compute the AKAZE non linear diffusion scale space on the GPU
+   * @return false if the scale space can not be computed on the GPU (the CPU version must be used)
+   */
+  bool Compute_AKAZEScaleSpaceCUDA(void);
+
   /// Detect AKAZE feature in the AKAZE scale space
   void Feature_Detection(std::vector<AKAZEKeypoint>& kpts) const;
 
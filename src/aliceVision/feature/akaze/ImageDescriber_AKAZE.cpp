@@ -22,7 +22,8 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
     : 11.f*sqrtf(2.f); // MLDB
 
   AKAZE akaze(image, _params._options);
-  akaze.Compute_AKAZEScaleSpace();
+  if(!_useCuda || !akaze.Compute_AKAZEScaleSpaceCUDA())
+    akaze.Compute_AKAZEScaleSpace();
   std::vector<AKAZEKeypoint> kpts;
   kpts.reserve(5000);
   akaze.Feature_Detection(kpts);
@@ -16,6 +16,10 @@
 #include <aliceVision/feature/akaze/descriptorMLDB.hpp>
 #include <aliceVision/feature/akaze/descriptorMSURF.hpp>
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/system/gpu.hpp>
+#endif
+
 using namespace std;
 
 namespace aliceVision {
@@ -47,7 +51,12 @@ public:
   ImageDescriber_AKAZE(
     const AKAZEParams & params = AKAZEParams(),
     bool bOrientation = true
-  ):ImageDescriber(), _params(params), _bOrientation(bOrientation) {}
+  ):ImageDescriber(), _params(params), _bOrientation(bOrientation)
+  {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    setUseCuda(system::gpuSupportCUDA(3,0));
+#endif
+  }
 
   /**
    * @brief Check if the image describer use CUDA
@@ -55,7 +64,21 @@ public:
    */
   bool useCuda() const override
   {
-    return false;
+    return _useCuda;
+  }
+
+  /**
+   * @brief Set if yes or no imageDescriber need to use cuda implementation
+   * (the nonlinear scale space is computed on the GPU, the detection and the description stay on the CPU)
+   * @param[in] useCuda
+   */
+  void setUseCuda(bool useCuda) override
+  {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    _useCuda = useCuda;
+#else
+    _useCuda = false;
+#endif
   }
 
   /**
@@ -164,6 +187,7 @@ public:
 private:
   AKAZEParams _params;
   bool _bOrientation;
+  bool _useCuda = false;
 };
 
 } // namespace feature
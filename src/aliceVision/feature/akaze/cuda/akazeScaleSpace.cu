@@ -0,0 +1,328 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/akaze/cuda/akazeScaleSpace.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace aliceVision {
+namespace feature {
+
+/// size of the 2D CUDA blocks
+#define AKAZE_BLOCK_SIZE 16
+
+/**
+ * @brief 1D kernel passed by value to the CUDA kernels
+ */
+struct KernelCUDA
+{
+    float weights[AKAZE_CUDA_MAX_KERNEL_SIZE];
+    int size;
+};
+
+/**
+ * @brief Device buffers of the current slice (all of the size of the slice)
+ */
+struct SliceBuffersCUDA
+{
+    float* cur = nullptr;
+    float* smoothed = nullptr;
+    float* tmp = nullptr;
+    float* Lx = nullptr;
+    float* Ly = nullptr;
+    float* Lxx = nullptr;
+    float* Lxy = nullptr;
+    float* Lyy = nullptr;
+
+    bool allocate(int nbPixels)
+    {
+        float** buffers[] = {&cur, &smoothed, &tmp, &Lx, &Ly, &Lxx, &Lxy, &Lyy};
+        for(float** buffer : buffers)
+        {
+            if(cudaMalloc(buffer, nbPixels * sizeof(float)) != cudaSuccess)
+                return false;
+        }
+        return true;
+    }
+
+    void release()
+    {
+        float** buffers[] = {&cur, &smoothed, &tmp, &Lx, &Ly, &Lxx, &Lxy, &Lyy};
+        for(float** buffer : buffers)
+        {
+            cudaFree(*buffer);
+            *buffer = nullptr;
+        }
+    }
+};
+
+static bool checkCudaError(const char* what)
+{
+    const cudaError_t err = cudaGetLastError();
+    if(err == cudaSuccess)
+        return true;
+    fprintf(stderr, "CUDA error during %s: %s\n", what, cudaGetErrorString(err));
+    return false;
+}
+
+static bool toKernelCUDA(const std::vector<float>& weights, KernelCUDA& kernel)
+{
+    if(weights.empty() || weights.size() > AKAZE_CUDA_MAX_KERNEL_SIZE)
+        return false;
+    std::copy(weights.begin(), weights.end(), kernel.weights);
+    kernel.size = static_cast<int>(weights.size());
+    return true;
+}
+
+/// mirrored index at the borders (the border pixel is not repeated), as the CPU convolution
+__device__ inline int mirrorIndex(int i, int size)
+{
+    if(i < 0)
+        i = -i;
+    if(i >= size)
+        i = 2 * (size - 1) - i;
+    return min(max(i, 0), size - 1);
+}
+
+/**
+ * @brief Vertical pass of a separable convolution
+ */
+__global__ void convolveVertical_kernel(const float* src, float* dst, int width, int height, KernelCUDA kernel)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if(x >= width || y >= height)
+        return;
+
+    const int half = kernel.size / 2;
+    float sum = 0.f;
+    for(int k = 0; k < kernel.size; ++k)
+        sum += kernel.weights[k] * src[mirrorIndex(y + k - half, height) * width + x];
+    dst[y * width + x] = sum;
+}
+
+/**
+ * @brief Horizontal pass of a separable convolution
+ */
+__global__ void convolveHorizontal_kernel(const float* src, float* dst, int width, int height, KernelCUDA kernel)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if(x >= width || y >= height)
+        return;
+
+    const int half = kernel.size / 2;
+    const float* row = src + y * width;
+    float sum = 0.f;
+    for(int k = 0; k < kernel.size; ++k)
+        sum += kernel.weights[k] * row[mirrorIndex(x + k - half, width)];
+    dst[y * width + x] = sum;
+}
+
+/**
+ * @brief dst(i, j) = src(2i + 1, 2j + 1), as image::ImageHalfSample
+ */
+__global__ void halfSample_kernel(const float* src, int srcWidth, float* dst, int width, int height)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if(x >= width || y >= height)
+        return;
+    dst[y * width + x] = src[(2 * y + 1) * srcWidth + 2 * x + 1];
+}
+
+/**
+ * @brief Perona and Malik G2 diffusion coefficient from the gradient of the smoothed image (3x3 Scharr, not normalized)
+ */
+__global__ void diffusionCoef_kernel(const float* smoothed, float* diff, int width, int height, float invK2)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if(x >= width || y >= height)
+        return;
+
+    const int xl = mirrorIndex(x - 1, width);
+    const int xr = mirrorIndex(x + 1, width);
+    const float* up = smoothed + mirrorIndex(y - 1, height) * width;
+    const float* cur = smoothed + y * width;
+    const float* down = smoothed + mirrorIndex(y + 1, height) * width;
+
+    const float Lx = 3.f * (up[xr] - up[xl]) + 10.f * (cur[xr] - cur[xl]) + 3.f * (down[xr] - down[xl]);
+    const float Ly = 3.f * (down[xl] - up[xl]) + 10.f * (down[x] - up[x]) + 3.f * (down[xr] - up[xr]);
+    diff[y * width + x] = 1.f / (1.f + (Lx * Lx + Ly * Ly) * invK2);
+}
+
+/**
+ * @brief One Fast Explicit Diffusion step: dst = src + step, no flux across the borders (as image::FEDRow)
+ */
+__global__ void fedStep_kernel(const float* src, const float* diff, float* dst, int width, int height, float halfT)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if(x >= width || y >= height)
+        return;
+
+    const int i = y * width + x;
+    const int iLeft = (x > 0) ? i - 1 : i;
+    const int iRight = (x < width - 1) ? i + 1 : i;
+    const int iUp = (y > 0) ? i - width : i;
+    const int iDown = (y < height - 1) ? i + width : i;
+
+    const float curSrc = src[i];
+    const float curDiff = diff[i];
+    const float a = (curDiff + diff[iRight]) * (src[iRight] - curSrc);
+    const float b = (curDiff + diff[iUp]) * (curSrc - src[iUp]);
+    const float c = (curDiff + diff[iLeft]) * (curSrc - src[iLeft]);
+    const float d = (curDiff + diff[iDown]) * (src[iDown] - curSrc);
+    dst[i] = curSrc + halfT * (a - c + d - b);
+}
+
+/**
+ * @brief Determinant of the Hessian and scale normalization of the first derivatives
+ */
+__global__ void hessian_kernel(float* Lx, float* Ly, const float* Lxx, const float* Lxy, const float* Lyy,
+                               float* Lhess, int width, int height, float scale)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if(x >= width || y >= height)
+        return;
+
+    const int i = y * width + x;
+    const float scale2 = scale * scale;
+    Lhess[i] = (Lxx[i] * Lyy[i] - Lxy[i] * Lxy[i]) * scale2 * scale2;
+    Lx[i] *= scale;
+    Ly[i] *= scale;
+}
+
+/**
+ * @brief Separable convolution with mirrored borders: vertical pass in tmp then horizontal pass in dst
+ */
+static void convolve(const float* src, float* tmp, float* dst, int width, int height,
+                     const KernelCUDA& horizontal, const KernelCUDA& vertical)
+{
+    const dim3 block(AKAZE_BLOCK_SIZE, AKAZE_BLOCK_SIZE);
+    const dim3 grid((width + block.x - 1) / block.x, (height + block.y - 1) / block.y);
+    convolveVertical_kernel<<<grid, block>>>(src, tmp, width, height, vertical);
+    convolveHorizontal_kernel<<<grid, block>>>(tmp, dst, width, height, horizontal);
+}
+
+bool akazeCUDA_isAvailable()
+{
+    int nbDevices = 0;
+    if(cudaGetDeviceCount(&nbDevices) != cudaSuccess)
+    {
+        cudaGetLastError(); // reset the error
+        return false;
+    }
+    return nbDevices > 0;
+}
+
+bool akazeCUDA_computeScaleSpace(const float* image, int width, int height,
+                                 const std::vector<AKAZESliceCUDA>& slices)
+{
+    if(slices.empty())
+        return true;
+
+    // the buffers are allocated at the size of the first slice and reused by the smaller octaves
+    SliceBuffersCUDA buffers;
+    float* prev = nullptr;
+    if(!buffers.allocate(width * height) || cudaMalloc(&prev, width * height * sizeof(float)) != cudaSuccess)
+    {
+        checkCudaError("scale space allocation");
+        buffers.release();
+        return false;
+    }
+    cudaMemcpy(prev, image, width * height * sizeof(float), cudaMemcpyHostToDevice);
+
+    bool success = checkCudaError("image upload");
+    int prevWidth = width;
+
+    const dim3 block(AKAZE_BLOCK_SIZE, AKAZE_BLOCK_SIZE);
+
+    for(std::size_t s = 0; s < slices.size() && success; ++s)
+    {
+        const AKAZESliceCUDA& slice = slices[s];
+        const int w = slice.width;
+        const int h = slice.height;
+        const dim3 grid((w + block.x - 1) / block.x, (h + block.y - 1) / block.y);
+
+        KernelCUDA smoothing, derivative, derivativeSmoothing;
+        if(!toKernelCUDA(slice.smoothingKernel, smoothing) ||
+           !toKernelCUDA(slice.derivativeKernel, derivative) ||
+           !toKernelCUDA(slice.derivativeSmoothingKernel, derivativeSmoothing))
+        {
+            success = false;
+            break;
+        }
+
+        if(!slice.nonLinear)
+        {
+            // first slice: gaussian filtering of the input image
+            KernelCUDA gaussian;
+            if(!toKernelCUDA(slice.gaussianKernel, gaussian))
+            {
+                success = false;
+                break;
+            }
+            convolve(prev, buffers.tmp, buffers.cur, w, h, gaussian, gaussian);
+            cudaMemcpy(buffers.smoothed, buffers.cur, w * h * sizeof(float), cudaMemcpyDeviceToDevice);
+        }
+        else
+        {
+            // input of the diffusion
+            if(slice.halfSample)
+                halfSample_kernel<<<grid, block>>>(prev, prevWidth, buffers.cur, w, h);
+            else
+                cudaMemcpy(buffers.cur, prev, w * h * sizeof(float), cudaMemcpyDeviceToDevice);
+
+            // diffusion coefficient (Lxx is used as diffusivity buffer)
+            convolve(buffers.cur, buffers.tmp, buffers.smoothed, w, h, smoothing, smoothing);
+            diffusionCoef_kernel<<<grid, block>>>(buffers.smoothed, buffers.Lxx, w, h,
+                                                  1.f / (slice.contrastFactor * slice.contrastFactor));
+
+            // FED cycle, the steps are computed alternatively in cur and tmp
+            for(std::size_t i = 0; i < slice.tau.size(); ++i)
+            {
+                fedStep_kernel<<<grid, block>>>(buffers.cur, buffers.Lxx, buffers.tmp, w, h, 0.5f * slice.tau[i]);
+                std::swap(buffers.cur, buffers.tmp);
+            }
+
+            // add a little smooth to the image for the robustness of the Scharr derivatives
+            convolve(buffers.cur, buffers.tmp, buffers.smoothed, w, h, smoothing, smoothing);
+        }
+
+        // first and second order scaled Scharr derivatives
+        convolve(buffers.smoothed, buffers.tmp, buffers.Lx, w, h, derivative, derivativeSmoothing);
+        convolve(buffers.smoothed, buffers.tmp, buffers.Ly, w, h, derivativeSmoothing, derivative);
+        convolve(buffers.Lx, buffers.tmp, buffers.Lxx, w, h, derivative, derivativeSmoothing);
+        convolve(buffers.Lx, buffers.tmp, buffers.Lxy, w, h, derivativeSmoothing, derivative);
+        convolve(buffers.Ly, buffers.tmp, buffers.Lyy, w, h, derivativeSmoothing, derivative);
+
+        // determinant of the Hessian (smoothed is not used anymore and stores it)
+        hessian_kernel<<<grid, block>>>(buffers.Lx, buffers.Ly, buffers.Lxx, buffers.Lxy, buffers.Lyy,
+                                        buffers.smoothed, w, h, static_cast<float>(slice.derivativeScale));
+
+        cudaMemcpy(slice.cur, buffers.cur, w * h * sizeof(float), cudaMemcpyDeviceToHost);
+        cudaMemcpy(slice.Lx, buffers.Lx, w * h * sizeof(float), cudaMemcpyDeviceToHost);
+        cudaMemcpy(slice.Ly, buffers.Ly, w * h * sizeof(float), cudaMemcpyDeviceToHost);
+        cudaMemcpy(slice.Lhess, buffers.smoothed, w * h * sizeof(float), cudaMemcpyDeviceToHost);
+
+        // the slice is the input of the next one
+        cudaMemcpy(prev, buffers.cur, w * h * sizeof(float), cudaMemcpyDeviceToDevice);
+        prevWidth = w;
+
+        success = checkCudaError("scale space slice");
+    }
+
+    buffers.release();
+    cudaFree(prev);
+    return success;
+}
+
+} // namespace feature
+} // namespace aliceVision
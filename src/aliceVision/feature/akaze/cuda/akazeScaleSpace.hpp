@@ -0,0 +1,72 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Maximal size of the 1D kernels used by the CUDA scale space
+ */
+const int AKAZE_CUDA_MAX_KERNEL_SIZE = 64;
+
+/**
+ * @brief Parameters and host outputs of one slice of the AKAZE nonlinear scale space.
+ *
+ * The slice is computed from the previous one (or from the input image for the first slice)
+ * the same way as AKAZE::ComputeAKAZESlice, with mirrored borders.
+ */
+struct AKAZESliceCUDA
+{
+  /// slice size
+  int width = 0;
+  int height = 0;
+  /// the input is the previous slice half sampled (first slice of an octave)
+  bool halfSample = false;
+  /// false for the first slice of the scale space (gaussian filtering only)
+  bool nonLinear = true;
+  /// gaussian kernel of sigma0 used to filter the input image (first slice only)
+  std::vector<float> gaussianKernel;
+  /// gaussian kernel of sigma 1 used to smooth the slice before the derivatives
+  std::vector<float> smoothingKernel;
+  /// Perona and Malik contrast factor
+  float contrastFactor = 0.f;
+  /// FED cycle timings
+  std::vector<float> tau;
+  /// scaled Scharr derivative kernels: derivative [-1 0 ... 0 1] and normalized smoothing [1 ... w ... 1]
+  std::vector<float> derivativeKernel;
+  std::vector<float> derivativeSmoothingKernel;
+  /// derivative scale (Lx, Ly and the Hessian are scale normalized)
+  int derivativeScale = 1;
+
+  /// host outputs (width x height row major buffers)
+  float* cur = nullptr;
+  float* Lx = nullptr;
+  float* Ly = nullptr;
+  float* Lhess = nullptr;
+};
+
+/**
+ * @brief Check if the CUDA scale space can be used (a device is available).
+ */
+bool akazeCUDA_isAvailable();
+
+/**
+ * @brief Compute the AKAZE nonlinear scale space on the current CUDA device.
+ * @param[in] image The input image (row major)
+ * @param[in] width The input image width
+ * @param[in] height The input image height
+ * @param[in,out] slices The slices parameters, the host outputs are filled
+ * @return false on CUDA error (out of memory, ...), the outputs are then undefined
+ */
+bool akazeCUDA_computeScaleSpace(const float* image, int width, int height,
+                                 const std::vector<AKAZESliceCUDA>& slices);
+
+} // namespace feature
+} // namespace aliceVision
@@ -10,6 +10,9 @@
 
 #include <cctag/ICCTag.hpp>
 #include <cctag/utils/LogTime.hpp>
+
+#include <algorithm>
+#include <memory>
 //#define CPU_ADAPT_OF_GPU_PART //todo: #ifdef depreciated
 #ifdef CPU_ADAPT_OF_GPU_PART    
   #include "cctag/progBase/MemoryPool.hpp"
@@ -92,6 +95,68 @@ void ImageDescriber_CCTAG::setUseCuda(bool useCuda)
   _params._internalParams->_useCuda = useCuda;
 }
 
+void ImageDescriber_CCTAG::setCudaPipe(int pipe)
+{
+  std::lock_guard<std::mutex> lock(_cudaPipesMutex);
+  if(pipe == _cudaPipe)
+    return;
+  _cudaPipe = pipe;
+  _cudaPipesInitialized = false;
+}
+
+void ImageDescriber_CCTAG::setNbCudaPipes(int nbPipes)
+{
+  std::lock_guard<std::mutex> lock(_cudaPipesMutex);
+  _nbCudaPipes = nbPipes;
+  _cudaPipesInitialized = false;
+}
+
+std::size_t ImageDescriber_CCTAG::getMaxConcurrentDescriptions() const
+{
+  return useCuda() ? static_cast<std::size_t>(getNbCudaPipes()) : 1;
+}
+
+int ImageDescriber_CCTAG::getNbCudaPipes() const
+{
+  if(_nbCudaPipes > 0)
+    return _nbCudaPipes;
+
+  int nbDevices = 0;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  if(cudaGetDeviceCount(&nbDevices) != cudaSuccess)
+    nbDevices = 0;
+#endif
+  return std::max(nbDevices, 1);
+}
+
+int ImageDescriber_CCTAG::acquireCudaPipe()
+{
+  std::unique_lock<std::mutex> lock(_cudaPipesMutex);
+  if(!_cudaPipesInitialized)
+  {
+    _freeCudaPipes.clear();
+    for(int i = getNbCudaPipes() - 1; i >= 0; --i)
+      _freeCudaPipes.push_back(_cudaPipe + i);
+    _cudaPipesInitialized = true;
+  }
+  _cudaPipeReleased.wait(lock, [this]{ return !_freeCudaPipes.empty(); });
+
+  const int pipe = _freeCudaPipes.back();
+  _freeCudaPipes.pop_back();
+  return pipe;
+}
+
+void ImageDescriber_CCTAG::releaseCudaPipe(int pipe)
+{
+  {
+    std::lock_guard<std::mutex> lock(_cudaPipesMutex);
+    // the pool may have been reset meanwhile
+    if(_cudaPipesInitialized && pipe >= _cudaPipe && pipe < _cudaPipe + getNbCudaPipes())
+      _freeCudaPipes.push_back(pipe);
+  }
+  _cudaPipeReleased.notify_one();
+}
+
 bool ImageDescriber_CCTAG::describe(const image::Image<unsigned char>& image,
     std::unique_ptr<Regions> &regions,
     const image::Image<unsigned char> * mask)
@@ -109,21 +174,38 @@ bool ImageDescriber_CCTAG::describe(const image::Image<unsigned char>& image,
   regionsCasted->Descriptors().reserve(regionsCasted->Descriptors().size() + 50);
 
   boost::ptr_list<cctag::ICCTag> cctags;
-  cctag::logtime::Mgmt* durations = new cctag::logtime::Mgmt( 25 );
+  std::unique_ptr<cctag::logtime::Mgmt> durations(new cctag::logtime::Mgmt( 25 ));
   // cctag::CCTagMarkersBank bank(_params._nCrowns);
 
+  // a free pipe of the pool, always on the same device
+  const int cudaPipe = acquireCudaPipe();
+  try
+  {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    int nbDevices = 0;
+    if(useCuda() && cudaGetDeviceCount(&nbDevices) == cudaSuccess && nbDevices > 1)
+      cudaSetDevice(cudaPipe % nbDevices);
+#endif
+
 #ifndef CPU_ADAPT_OF_GPU_PART
-  const cv::Mat graySrc(cv::Size(image.Width(), image.Height()), CV_8UC1, (unsigned char *) image.data(), cv::Mat::AUTO_STEP);
-  //// Invert the image
-  //cv::Mat invertImg;
-  //cv::bitwise_not(graySrc,invertImg);
-  cctag::cctagDetection(cctags, _cudaPipe, 1,graySrc, *_params._internalParams, durations);
+    const cv::Mat graySrc(cv::Size(image.Width(), image.Height()), CV_8UC1, (unsigned char *) image.data(), cv::Mat::AUTO_STEP);
+    //// Invert the image
+    //cv::Mat invertImg;
+    //cv::bitwise_not(graySrc,invertImg);
+    cctag::cctagDetection(cctags, cudaPipe, 1,graySrc, *_params._internalParams, durations.get());
 #else //todo: #ifdef depreciated
-  cctag::MemoryPool::instance().updateMemoryAuthorizedWithRAM();
-  cctag::View cctagView((const unsigned char *) image.data(), image.Width(), image.Height(), image.Depth()*image.Width());
-  boost::ptr_list<cctag::ICCTag> cctags;
-  cctag::cctagDetection(cctags, _cudaPipe, 1 ,cctagView._grayView ,*_params._internalParams, durations );
+    cctag::MemoryPool::instance().updateMemoryAuthorizedWithRAM();
+    cctag::View cctagView((const unsigned char *) image.data(), image.Width(), image.Height(), image.Depth()*image.Width());
+    cctag::cctagDetection(cctags, cudaPipe, 1 ,cctagView._grayView ,*_params._internalParams, durations.get() );
 #endif
+  }
+  catch(...)
+  {
+    releaseCudaPipe(cudaPipe);
+    throw;
+  }
+  releaseCudaPipe(cudaPipe);
+
   durations->print( std::cerr );
 
   for (const auto & cctag : cctags)
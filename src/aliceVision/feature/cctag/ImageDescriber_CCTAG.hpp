@@ -12,8 +12,11 @@
 #include <aliceVision/feature/regionsFactory.hpp>
 #include <aliceVision/types.hpp>
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <numeric>
+#include <vector>
 
 namespace cctag {
   class Parameters; // Hidden implementation
@@ -72,12 +75,23 @@ public:
 
   /**
    * @brief set the CUDA pipe
-   * @param[in] pipe The CUDA pipe id
+   * @param[in] pipe The CUDA pipe id, first pipe of the pool used by the concurrent detections
+   * @note Must not be changed while a detection is running.
    */
-  void setCudaPipe(int pipe) override
-  {
-    _cudaPipe = pipe;
-  }
+  void setCudaPipe(int pipe) override;
+
+  /**
+   * @brief Set the number of CUDA pipes of the pool, pipe i runs on the device (i % number of devices)
+   * @param[in] nbPipes The number of CUDA pipes (0: one per CUDA device)
+   * @note Must not be changed while a detection is running.
+   */
+  void setNbCudaPipes(int nbPipes);
+
+  /**
+   * @brief Get the max. number of images described at the same time, one per CUDA pipe
+   * @return number of concurrent describe() calls
+   */
+  std::size_t getMaxConcurrentDescriptions() const override;
 
   /**
    * @brief Use a preset to control the number of detected regions
@@ -93,6 +107,7 @@ public:
    * @param[in] mask 8-bit grayscale image for keypoint filtering (optional)
    *    Non-zero values depict the region of interest.
    * @return True if detection succed.
+   * @note Thread-safe: each call takes a free CUDA pipe of the pool, or waits for one.
    */
   bool describe(const image::Image<unsigned char>& image,
     std::unique_ptr<Regions> &regions,
@@ -116,10 +131,26 @@ public:
     std::unique_ptr<cctag::Parameters> _internalParams;
   };
 private:
+  /// Number of CUDA pipes of the pool
+  int getNbCudaPipes() const;
+
+  /// Take a free CUDA pipe of the pool, wait if all are used
+  int acquireCudaPipe();
+
+  /// Give back a CUDA pipe to the pool
+  void releaseCudaPipe(int pipe);
+
   //CCTag parameters
   CCTagParameters _params;
   bool _doAppend = false;
   int _cudaPipe = 0;
+  int _nbCudaPipes = 0;
+
+  std::mutex _cudaPipesMutex;
+  std::condition_variable _cudaPipeReleased;
+  /// pipes of the pool not used by a running detection
+  std::vector<int> _freeCudaPipes;
+  bool _cudaPipesInitialized = false;
 };
 
 /**
@@ -0,0 +1,137 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/feature/DescriptorPCA.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE descriptorPCA
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace {
+
+/// SIFT-like descriptors living close to a 32-dimensional subspace
+void makeRegions(std::mt19937& randomNumberGenerator, const Eigen::MatrixXf& subspace, std::size_t count, SIFT_Regions& regions)
+{
+  std::normal_distribution<float> latent(0.f, 20.f);
+  std::normal_distribution<float> noise(0.f, 1.f);
+
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    Eigen::VectorXf coefs(subspace.cols());
+    for(int k = 0; k < coefs.size(); ++k)
+      coefs(k) = latent(randomNumberGenerator);
+    const Eigen::VectorXf desc = subspace * coefs;
+
+    SIFT_Regions::DescriptorT descriptor;
+    for(std::size_t d = 0; d < 128; ++d)
+      descriptor[d] = static_cast<unsigned char>(std::min(255.f, std::max(0.f, 128.f + desc(d) + noise(randomNumberGenerator))));
+
+    regions.Features().emplace_back(float(i), float(i), 1.f, 0.f);
+    regions.Descriptors().push_back(descriptor);
+  }
+}
+
+std::size_t nearestNeighbor(const Regions& query, std::size_t i, const Regions& database)
+{
+  std::size_t best = 0;
+  for(std::size_t j = 1; j < database.RegionCount(); ++j)
+  {
+    if(query.SquaredDescriptorDistance(i, &database, j) < query.SquaredDescriptorDistance(i, &database, best))
+      best = j;
+  }
+  return best;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(descriptorPCA_nearestNeighbors)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+  Eigen::MatrixXf subspace(128, 32);
+  for(int i = 0; i < subspace.size(); ++i)
+    subspace(i) = distribution(randomNumberGenerator);
+
+  SIFT_Regions database;
+  makeRegions(randomNumberGenerator, subspace, 500, database);
+
+  DescriptorPCA pca;
+  pca.learn({&database}, 300);
+  BOOST_CHECK(pca.isValid());
+  BOOST_CHECK_EQUAL(pca.descriptorLength(), 128);
+  BOOST_CHECK_GT(pca.getExplainedVariance(), 0.95);
+
+  // queries: slightly modified database descriptors
+  SIFT_Regions query;
+  std::uniform_int_distribution<int> perturbation(-2, 2);
+  for(std::size_t i = 0; i < database.RegionCount(); i += 5)
+  {
+    SIFT_Regions::DescriptorT descriptor = database.Descriptors()[i];
+    for(std::size_t d = 0; d < 128; ++d)
+      descriptor[d] = static_cast<unsigned char>(std::min(255, std::max(0, descriptor[d] + perturbation(randomNumberGenerator))));
+    query.Features().push_back(database.Features()[i]);
+    query.Descriptors().push_back(descriptor);
+  }
+
+  const std::unique_ptr<Regions> reducedDatabase = pca.project(database);
+  const std::unique_ptr<Regions> reducedQuery = pca.project(query);
+
+  BOOST_CHECK_EQUAL(reducedDatabase->RegionCount(), database.RegionCount());
+  BOOST_CHECK_EQUAL(reducedDatabase->DescriptorLength(), DescriptorPCA::reducedLength);
+  BOOST_CHECK_EQUAL(2 * reducedDatabase->DescriptorByteSize(), database.DescriptorByteSize());
+  BOOST_CHECK(reducedDatabase->GetRegionPosition(10) == database.GetRegionPosition(10));
+
+  std::size_t nbSame = 0;
+  for(std::size_t i = 0; i < query.RegionCount(); ++i)
+  {
+    if(nearestNeighbor(*reducedQuery, i, *reducedDatabase) == nearestNeighbor(query, i, database))
+      ++nbSame;
+  }
+  BOOST_CHECK_EQUAL(nbSame, query.RegionCount());
+}
+
+BOOST_AUTO_TEST_CASE(descriptorPCA_saveLoad)
+{
+  std::mt19937 randomNumberGenerator(1);
+  std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+  Eigen::MatrixXf subspace(128, 16);
+  for(int i = 0; i < subspace.size(); ++i)
+    subspace(i) = distribution(randomNumberGenerator);
+
+  SIFT_Regions regions;
+  makeRegions(randomNumberGenerator, subspace, 200, regions);
+
+  DescriptorPCA pca;
+  pca.learn({&regions});
+
+  const std::string filename = "descriptorPCA_test.bin";
+  pca.save(filename);
+
+  DescriptorPCA loadedPCA;
+  loadedPCA.load(filename);
+  std::remove(filename.c_str());
+
+  BOOST_CHECK_EQUAL(loadedPCA.descriptorLength(), pca.descriptorLength());
+  BOOST_CHECK_EQUAL(loadedPCA.getExplainedVariance(), pca.getExplainedVariance());
+
+  const std::unique_ptr<Regions> reduced = pca.project(regions);
+  const std::unique_ptr<Regions> loadedReduced = loadedPCA.project(regions);
+  const SIFT_PCA64_Regions& a = dynamic_cast<const SIFT_PCA64_Regions&>(*reduced);
+  const SIFT_PCA64_Regions& b = dynamic_cast<const SIFT_PCA64_Regions&>(*loadedReduced);
+  BOOST_CHECK(a.Descriptors() == b.Descriptors());
+
+  // the descriptor length must match the basis
+  AKAZE_Float_Regions akazeRegions;
+  BOOST_CHECK_THROW(pca.project(akazeRegions), std::invalid_argument);
+}
@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/feature/feature.hpp"
+#include "aliceVision/feature/RegionsContainer.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -68,6 +69,14 @@ BOOST_AUTO_TEST_CASE(featureIO_ASCII) {
     BOOST_CHECK_EQUAL(vec_feats[i].scale(), vec_feats_read[i].scale());
     BOOST_CHECK_EQUAL(vec_feats[i].orientation(), vec_feats_read[i].orientation());
   }
+
+  // Read only the positions
+  std::vector<PointFeature> vec_positions_read;
+  BOOST_CHECK_NO_THROW(loadFeatPositionsFromFile("tempFeats.feat", vec_positions_read));
+  BOOST_CHECK_EQUAL(CARD, vec_positions_read.size());
+
+  for(int i = 0; i < CARD; ++i)
+    BOOST_CHECK_EQUAL(vec_feats[i].coords(), vec_positions_read[i].coords());
 }
 
 //--
@@ -122,3 +131,74 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//Test binary regions container
+BOOST_AUTO_TEST_CASE(regionsContainerIO_BINARY) {
+  typedef ScalarRegions<SIOPointFeature, float, DESC_LENGTH> Regions_T;
+
+  // Create regions for a few views
+  std::vector<Regions_T> vec_regions(3);
+  for(std::size_t v = 0; v < vec_regions.size(); ++v)
+  {
+    for(int i = 0; i < CARD * (v); ++i)
+    {
+      vec_regions[v].Features().push_back(Feature_T(i, i*2, i*3, v));
+      Desc_T desc;
+      for (int j = 0; j < DESC_LENGTH; ++j)
+        desc[j] = v*CARD*DESC_LENGTH + i*DESC_LENGTH + j;
+      vec_regions[v].Descriptors().push_back(desc);
+    }
+  }
+
+  //Save them to a container
+  {
+    RegionsContainerWriter writer("tempRegions.regions", EImageDescriberType::SIFT_FLOAT);
+    for(std::size_t v = 0; v < vec_regions.size(); ++v)
+      BOOST_CHECK_NO_THROW(writer.add(v * 10, vec_regions[v]));
+    BOOST_CHECK_NO_THROW(writer.close());
+  }
+
+  //Read the saved data and compare to input (to check write/read IO)
+  RegionsContainerReader reader("tempRegions.regions");
+  BOOST_CHECK(reader.getDescriberType() == EImageDescriberType::SIFT_FLOAT);
+  BOOST_CHECK_EQUAL(vec_regions.size(), reader.getViewIds().size());
+  BOOST_CHECK(!reader.hasView(1));
+
+  for(std::size_t v = 0; v < vec_regions.size(); ++v)
+  {
+    BOOST_CHECK(reader.hasView(v * 10));
+    BOOST_CHECK_EQUAL(vec_regions[v].RegionCount(), reader.getRegionCount(v * 10));
+
+    Regions_T regions_read;
+    BOOST_CHECK_NO_THROW(reader.load(v * 10, regions_read));
+    BOOST_CHECK_EQUAL(vec_regions[v].RegionCount(), regions_read.RegionCount());
+    BOOST_CHECK_EQUAL(vec_regions[v].RegionCount(), regions_read.Descriptors().size());
+
+    for(std::size_t i = 0; i < regions_read.RegionCount(); ++i)
+    {
+      BOOST_CHECK_EQUAL(vec_regions[v].Features()[i], regions_read.Features()[i]);
+      BOOST_CHECK(vec_regions[v].Descriptors()[i] == regions_read.Descriptors()[i]);
+    }
+
+    // features only
+    Regions_T features_read;
+    BOOST_CHECK_NO_THROW(reader.load(v * 10, features_read, false));
+    BOOST_CHECK_EQUAL(vec_regions[v].RegionCount(), features_read.RegionCount());
+    BOOST_CHECK(features_read.Descriptors().empty());
+
+    // positions only
+    PointFeatures positions_read;
+    BOOST_CHECK_NO_THROW(reader.loadPositions(v * 10, positions_read));
+    BOOST_CHECK_EQUAL(vec_regions[v].RegionCount(), positions_read.size());
+    for(std::size_t i = 0; i < positions_read.size(); ++i)
+      BOOST_CHECK_EQUAL(vec_regions[v].Features()[i].coords(), positions_read[i].coords());
+  }
+
+  // Incompatible regions type
+  BinaryRegions<SIOPointFeature, 64> binaryRegions;
+  BOOST_CHECK_THROW(reader.load(10, binaryRegions), std::exception);
+
+  // Not a container
+  BOOST_CHECK_THROW(RegionsContainerReader("tempDescsBin.desc"), std::exception);
+  BOOST_CHECK_THROW(RegionsContainerReader("x.regions"), std::exception);
+}
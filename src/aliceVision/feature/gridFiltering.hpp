@@ -0,0 +1,213 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/Regions.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+namespace detail {
+
+/// strict order of the features: biggest scale first, then smallest index
+template<typename FeatT>
+struct FeatureScaleGreater
+{
+  const std::vector<FeatT>& features;
+
+  bool operator()(IndexT a, IndexT b) const
+  {
+    const float scaleA = features[a].scale();
+    const float scaleB = features[b].scale();
+    return (scaleA > scaleB) || (scaleA == scaleB && a < b);
+  }
+};
+
+/**
+ * @brief Reorder the features and descriptors in place: element i is moved to newIndexes[i].
+ * @param[in,out] newIndexes A permutation of [0, size), modified during the reordering
+ */
+template<typename FeatT, typename DescT>
+void permuteInPlace(std::vector<FeatT>& features, std::vector<DescT>& descriptors, std::vector<IndexT>& newIndexes)
+{
+  for(IndexT i = 0; i < newIndexes.size(); ++i)
+  {
+    // follow the cycle of i, each element is swapped to its final position
+    while(newIndexes[i] != i)
+    {
+      const IndexT j = newIndexes[i];
+      std::swap(features[i], features[j]);
+      std::swap(descriptors[i], descriptors[j]);
+      std::swap(newIndexes[i], newIndexes[j]);
+    }
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Select the maxNbFeatures best features (biggest scales) with a uniform spatial repartition.
+ *
+ * Bucketed adaptive non-maximal suppression: the features are dispatched in the cells of a grid
+ * (about maxNbFeatures cells and at least minGridSize cells per side) in linear time,
+ * and every cell keeps the same number of its best features. The quota is raised until
+ * maxNbFeatures are selected, so the share of the empty cells is given to the other cells.
+ *
+ * @param[in] features The features (scale() is the score)
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] minGridSize The minimal number of cells per side of the grid
+ * @param[in] maxNbFeatures The number of features to select
+ * @return The indexes of the selected features, sorted by decreasing scale
+ */
+template<typename FeatT>
+std::vector<IndexT> getGridFilteringIndexes(const std::vector<FeatT>& features,
+                                            std::size_t width,
+                                            std::size_t height,
+                                            std::size_t minGridSize,
+                                            std::size_t maxNbFeatures)
+{
+  const detail::FeatureScaleGreater<FeatT> greater{features};
+
+  std::vector<IndexT> selected;
+  if(maxNbFeatures == 0)
+    return selected;
+  if(features.size() <= maxNbFeatures || width == 0 || height == 0)
+  {
+    selected.resize(features.size());
+    for(IndexT i = 0; i < selected.size(); ++i)
+      selected[i] = i;
+    std::sort(selected.begin(), selected.end(), greater);
+    return selected;
+  }
+
+  // about one cell per selected feature
+  const double cellSize = std::sqrt(double(width) * height / maxNbFeatures);
+  const std::size_t gridWidth = std::max(minGridSize, std::size_t(std::ceil(width / cellSize)));
+  const std::size_t gridHeight = std::max(minGridSize, std::size_t(std::ceil(height / cellSize)));
+  const double cellWidth = double(width) / gridWidth;
+  const double cellHeight = double(height) / gridHeight;
+
+  // bucket the features by cell (counting sort)
+  std::vector<IndexT> featureCell(features.size());
+  std::vector<IndexT> cellOffsets(gridWidth * gridHeight + 1, 0);
+  for(IndexT i = 0; i < features.size(); ++i)
+  {
+    // clamp the features outside the image
+    const double x = std::max(0.0, features[i].x() / cellWidth);
+    const double y = std::max(0.0, features[i].y() / cellHeight);
+    const std::size_t cellX = std::min(std::size_t(x), gridWidth - 1);
+    const std::size_t cellY = std::min(std::size_t(y), gridHeight - 1);
+    featureCell[i] = cellY * gridWidth + cellX;
+    ++cellOffsets[featureCell[i] + 1];
+  }
+  for(std::size_t c = 0; c < gridWidth * gridHeight; ++c)
+    cellOffsets[c + 1] += cellOffsets[c];
+
+  std::vector<IndexT> buckets(features.size());
+  {
+    std::vector<IndexT> cellFill(cellOffsets.begin(), cellOffsets.end() - 1);
+    for(IndexT i = 0; i < features.size(); ++i)
+      buckets[cellFill[featureCell[i]]++] = i;
+  }
+
+  // smallest quota per cell that selects maxNbFeatures features
+  const auto nbSelected = [&](std::size_t quota)
+  {
+    std::size_t count = 0;
+    for(std::size_t c = 0; c < gridWidth * gridHeight; ++c)
+      count += std::min(std::size_t(cellOffsets[c + 1] - cellOffsets[c]), quota);
+    return count;
+  };
+  std::size_t quotaMin = 0; // nbSelected(quotaMin) < maxNbFeatures
+  std::size_t quotaMax = maxNbFeatures; // nbSelected(quotaMax) >= maxNbFeatures
+  while(quotaMax - quotaMin > 1)
+  {
+    const std::size_t quota = (quotaMin + quotaMax) / 2;
+    if(nbSelected(quota) >= maxNbFeatures)
+      quotaMax = quota;
+    else
+      quotaMin = quota;
+  }
+  const std::size_t quota = quotaMax;
+
+  // every cell keeps its (quota - 1) best features,
+  // the remaining features are the best quota-th features of the cells
+  selected.reserve(maxNbFeatures);
+  std::vector<IndexT> candidates;
+  for(std::size_t c = 0; c < gridWidth * gridHeight; ++c)
+  {
+    const auto cellBegin = buckets.begin() + cellOffsets[c];
+    const auto cellEnd = buckets.begin() + cellOffsets[c + 1];
+    if(std::size_t(cellEnd - cellBegin) < quota)
+    {
+      selected.insert(selected.end(), cellBegin, cellEnd);
+      continue;
+    }
+    std::nth_element(cellBegin, cellBegin + (quota - 1), cellEnd, greater);
+    selected.insert(selected.end(), cellBegin, cellBegin + (quota - 1));
+    candidates.push_back(*(cellBegin + (quota - 1)));
+  }
+
+  const std::size_t nbRemaining = maxNbFeatures - selected.size();
+  std::nth_element(candidates.begin(), candidates.begin() + nbRemaining, candidates.end(), greater);
+  selected.insert(selected.end(), candidates.begin(), candidates.begin() + nbRemaining);
+
+  std::sort(selected.begin(), selected.end(), greater);
+  return selected;
+}
+
+/**
+ * @brief Keep in place the maxNbFeatures best regions (biggest scales) with a uniform spatial repartition,
+ * sorted by decreasing scale.
+ * @see getGridFilteringIndexes
+ * @param[in,out] regions The regions
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] minGridSize The minimal number of cells per side of the grid
+ * @param[in] maxNbFeatures The maximal number of regions to keep
+ */
+template<typename FeatT, typename T, std::size_t L, ERegionType regionType>
+void featuresGridFiltering(FeatDescRegions<FeatT, T, L, regionType>& regions,
+                           std::size_t width,
+                           std::size_t height,
+                           std::size_t minGridSize,
+                           std::size_t maxNbFeatures)
+{
+  std::vector<FeatT>& features = regions.Features();
+  auto& descriptors = regions.Descriptors();
+  assert(features.size() == descriptors.size());
+
+  const std::vector<IndexT> selected = getGridFilteringIndexes(features, width, height, minGridSize, maxNbFeatures);
+
+  // the selected regions are moved first, in their order, then the others are removed
+  const IndexT removed = UndefinedIndexT;
+  std::vector<IndexT> newIndexes(features.size(), removed);
+  for(IndexT i = 0; i < selected.size(); ++i)
+    newIndexes[selected[i]] = i;
+  IndexT nextIndex = selected.size();
+  for(IndexT& newIndex : newIndexes)
+  {
+    if(newIndex == removed)
+      newIndex = nextIndex++;
+  }
+
+  detail::permuteInPlace(features, descriptors, newIndexes);
+
+  features.resize(selected.size());
+  descriptors.resize(selected.size());
+}
+
+} // namespace feature
+} // namespace aliceVision
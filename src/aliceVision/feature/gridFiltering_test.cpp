@@ -0,0 +1,100 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/feature/gridFiltering.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE gridFiltering
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+BOOST_AUTO_TEST_CASE(gridFiltering_lessFeatures)
+{
+  std::vector<SIOPointFeature> features;
+  for(int i = 0; i < 10; ++i)
+    features.emplace_back(i, i, i % 3, 0.f);
+
+  const std::vector<IndexT> selected = getGridFilteringIndexes(features, 100, 100, 4, 100);
+
+  // all the features are kept, sorted by decreasing scale
+  BOOST_CHECK_EQUAL(selected.size(), features.size());
+  for(std::size_t i = 1; i < selected.size(); ++i)
+    BOOST_CHECK_GE(features[selected[i - 1]].scale(), features[selected[i]].scale());
+}
+
+BOOST_AUTO_TEST_CASE(gridFiltering_repartition)
+{
+  const std::size_t width = 1000;
+  const std::size_t height = 500;
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+  // many big features in the top left corner, a few small ones everywhere
+  std::vector<SIOPointFeature> features;
+  for(int i = 0; i < 5000; ++i)
+    features.emplace_back(100 * distribution(randomNumberGenerator), 50 * distribution(randomNumberGenerator), 10.f + distribution(randomNumberGenerator), 0.f);
+  for(int i = 0; i < 500; ++i)
+    features.emplace_back(width * distribution(randomNumberGenerator), height * distribution(randomNumberGenerator), distribution(randomNumberGenerator), 0.f);
+
+  const std::size_t maxNbFeatures = 400;
+  const std::vector<IndexT> selected = getGridFilteringIndexes(features, width, height, 4, maxNbFeatures);
+
+  BOOST_CHECK_EQUAL(selected.size(), maxNbFeatures);
+
+  // sorted by decreasing scale, without duplicates
+  std::vector<bool> isSelected(features.size(), false);
+  for(std::size_t i = 0; i < selected.size(); ++i)
+  {
+    if(i > 0)
+      BOOST_CHECK_GE(features[selected[i - 1]].scale(), features[selected[i]].scale());
+    BOOST_CHECK(!isSelected[selected[i]]);
+    isSelected[selected[i]] = true;
+  }
+
+  // the corner doesn't take all the features
+  std::size_t nbCorner = 0;
+  for(IndexT i : selected)
+  {
+    if(features[i].x() < 100 && features[i].y() < 50)
+      ++nbCorner;
+  }
+  BOOST_CHECK_LT(nbCorner, maxNbFeatures / 2);
+}
+
+BOOST_AUTO_TEST_CASE(gridFiltering_regions)
+{
+  SIFT_Regions regions;
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+  for(int i = 0; i < 1000; ++i)
+  {
+    regions.Features().emplace_back(640 * distribution(randomNumberGenerator), 480 * distribution(randomNumberGenerator), distribution(randomNumberGenerator), 0.f);
+    SIFT_Regions::DescriptorT descriptor;
+    // the descriptor identifies its feature
+    descriptor[0] = i % 256;
+    descriptor[1] = i / 256;
+    regions.Descriptors().push_back(descriptor);
+  }
+  const std::vector<SIOPointFeature> features = regions.Features();
+  const std::vector<IndexT> selected = getGridFilteringIndexes(features, 640, 480, 4, 100);
+
+  featuresGridFiltering(regions, 640, 480, 4, 100);
+
+  BOOST_CHECK_EQUAL(regions.RegionCount(), 100);
+  BOOST_CHECK_EQUAL(regions.Descriptors().size(), 100);
+  for(std::size_t i = 0; i < selected.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(regions.Features()[i].x(), features[selected[i]].x());
+    BOOST_CHECK_EQUAL(regions.Features()[i].scale(), features[selected[i]].scale());
+    BOOST_CHECK_EQUAL(regions.Descriptors()[i][0] + 256 * regions.Descriptors()[i][1], selected[i]);
+  }
+}
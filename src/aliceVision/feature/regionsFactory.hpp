@@ -24,6 +24,9 @@ typedef ScalarRegions<SIOPointFeature,float,64> AKAZE_Float_Regions;
 /// Define the AKAZE Keypoint (with a LIOP descriptor)
 typedef ScalarRegions<SIOPointFeature,unsigned char,144> AKAZE_Liop_Regions;
 
+/// Define the SIFT Keypoint with a descriptor reduced by PCA (see DescriptorPCA)
+typedef ScalarRegions<SIOPointFeature,unsigned char,64> SIFT_PCA64_Regions;
+
 /// Define the AKAZE Keypoint (with a binary descriptor saved in an uchar array)
 typedef BinaryRegions<SIOPointFeature,64> AKAZE_BinaryRegions;
 
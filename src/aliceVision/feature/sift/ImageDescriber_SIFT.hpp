@@ -77,6 +77,15 @@ public:
     return _imageDescriberImpl->getMemoryConsumption(width, height);
   }
 
+  /**
+   * @brief Get the max. number of images the image describer can describe at the same time
+   * @return number of concurrent describe() calls
+   */
+  std::size_t getMaxConcurrentDescriptions() const override
+  {
+    return _imageDescriberImpl->getMaxConcurrentDescriptions();
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -8,52 +8,85 @@
 #include "ImageDescriber_SIFT_popSIFT.hpp"
 #include <aliceVision/system/Logger.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace feature {
 
-std::unique_ptr<PopSift> ImageDescriber_SIFT_popSIFT::_popSift = nullptr;
+std::vector<std::unique_ptr<PopSift>> ImageDescriber_SIFT_popSIFT::_popSifts;
+std::mutex ImageDescriber_SIFT_popSIFT::_popSiftMutex;
+std::atomic<std::size_t> ImageDescriber_SIFT_popSIFT::_nextDevice(0);
+
+namespace {
+
+int getNbCudaDevices()
+{
+  int nbDevices = 0;
+  if(cudaGetDeviceCount(&nbDevices) != cudaSuccess)
+    return 1;
+  return std::max(nbDevices, 1);
+}
+
+} // namespace
+
+std::size_t ImageDescriber_SIFT_popSIFT::getMaxConcurrentDescriptions() const
+{
+  return 2 * static_cast<std::size_t>(getNbCudaDevices());
+}
 
 bool ImageDescriber_SIFT_popSIFT::describe(const image::Image<float>& image,
                                       std::unique_ptr<Regions>& regions,
                                       const image::Image<unsigned char>* mask)
 {
-  if(_popSift == nullptr)
-    resetConfiguration();
+  std::unique_ptr<SiftJob> job;
+  {
+    std::lock_guard<std::mutex> lock(_popSiftMutex);
+    if(_popSifts.empty())
+      resetConfiguration();
 
-  std::unique_ptr<SiftJob> job(_popSift->enqueue(image.Width(), image.Height(), &image(0,0)));
+    // the job keeps its own copy of the image, the next image can be enqueued while it is processed
+    PopSift& popSift = *_popSifts.at(_nextDevice++ % _popSifts.size());
+    job.reset(popSift.enqueue(image.Width(), image.Height(), &image(0,0)));
+  }
+
+  // wait for this image only, the other threads images are processed meanwhile
   std::unique_ptr<popsift::Features> popFeatures(job->get());
 
   allocate(regions);
 
   // Build alias to cached data
   SIFT_Regions * regionsCasted = dynamic_cast<SIFT_Regions*>(regions.get());
-  regionsCasted->Features().reserve(popFeatures->getDescriptorCount());
-  regionsCasted->Descriptors().reserve(popFeatures->getDescriptorCount());
+  const std::size_t nbDescriptors = popFeatures->getDescriptorCount();
+  std::vector<SIOPointFeature>& features = regionsCasted->Features();
+  std::vector<SIFT_Regions::DescriptorT>& descriptors = regionsCasted->Descriptors();
+  features.resize(nbDescriptors);
+  descriptors.resize(nbDescriptors);
 
-  ALICEVISION_LOG_TRACE("PopSIFT features count: " << popFeatures->getFeatureCount() << ", descriptors count: " << popFeatures->getDescriptorCount() << std::endl);
+  ALICEVISION_LOG_TRACE("PopSIFT features count: " << popFeatures->getFeatureCount() << ", descriptors count: " << nbDescriptors << std::endl);
 
+  std::size_t i = 0;
   for(const auto& popFeat: *popFeatures)
   {
-    for(int orientationIndex = 0; orientationIndex < popFeat.num_ori; ++orientationIndex)
+    for(int orientationIndex = 0; orientationIndex < popFeat.num_ori; ++orientationIndex, ++i)
     {
-      const popsift::Descriptor* popDesc = popFeat.desc[orientationIndex];
-      Descriptor<unsigned char, 128> desc;
+      const float* popDesc = popFeat.desc[orientationIndex]->features;
+      unsigned char* desc = descriptors[i].getData();
 
-      //convertSIFT<unsigned char>(*popDesc, desc, _params._root_sift);
       // root sift is done inside popsift, so we only need to cast the result
-      for (std::size_t k = 0; k < 128; ++k)
-        desc[k] = static_cast<unsigned char>(popDesc->features[k]);
-
-      regionsCasted->Features().emplace_back(
-        popFeat.xpos,
-        popFeat.ypos,
-        popFeat.sigma,
-        popFeat.orientation[orientationIndex]);
+      for(std::size_t k = 0; k < 128; ++k)
+        desc[k] = static_cast<unsigned char>(popDesc[k]);
 
-      regionsCasted->Descriptors().emplace_back(desc);
+      features[i] = SIOPointFeature(popFeat.xpos,
+                                    popFeat.ypos,
+                                    popFeat.sigma,
+                                    popFeat.orientation[orientationIndex]);
     }
   }
 
+  // in case the descriptor count doesn't match the orientations
+  features.resize(i);
+  descriptors.resize(i);
+
   ALICEVISION_LOG_TRACE("aliceVision PopSIFT feature count : " << regionsCasted->RegionCount() << std::endl);
 
   return true;
@@ -61,13 +94,6 @@ bool ImageDescriber_SIFT_popSIFT::describe(const image::Image<float>& image,
 
 void ImageDescriber_SIFT_popSIFT::resetConfiguration()
 {
-  // destroy all allocations and reset all state
-  // on the current device in the current process
-  cudaDeviceReset();
-
-  popsift::cuda::device_prop_t deviceInfo;
-  deviceInfo.set(0, true); // use only the first device & print informations
-
   // reset configuration
   popsift::Config config;
   config.setOctaves(_params._numOctaves);
@@ -80,7 +106,22 @@ void ImageDescriber_SIFT_popSIFT::resetConfiguration()
   config.setFilterMaxExtrema(_params._maxTotalKeypoints);
   config.setFilterSorting(popsift::Config::LargestScaleFirst);
 
-  _popSift.reset(new PopSift(config, popsift::Config::ExtractingMode, PopSift::FloatImages));
+  _popSifts.clear();
+
+  const int nbDevices = getNbCudaDevices();
+  for(int device = 0; device < nbDevices; ++device)
+  {
+    // destroy all allocations and reset all state
+    // on the device in the current process
+    cudaSetDevice(device);
+    cudaDeviceReset();
+
+    popsift::cuda::device_prop_t deviceInfo;
+    deviceInfo.set(device, true); // print informations
+
+    _popSifts.emplace_back(new PopSift(config, popsift::Config::ExtractingMode, PopSift::FloatImages, device));
+  }
+  ALICEVISION_LOG_DEBUG("PopSIFT: " << nbDevices << " device(s) used.");
 }
 
 } // namespace feature
@@ -18,8 +18,11 @@
 #include <popsift/sift_octave.h>
 #include <popsift/common/device_prop.h>
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <numeric>
+#include <vector>
 
 namespace aliceVision {
 namespace feature {
@@ -77,6 +80,14 @@ public:
     return 3 * width * height * sizeof(float); //  GPU only
   }
 
+  /**
+   * @brief Get the max. number of images described at the same time
+   * @note Two images per device: one is uploaded and extracted while the features of the other
+   *       are converted on the CPU.
+   * @return number of concurrent describe() calls
+   */
+  std::size_t getMaxConcurrentDescriptions() const override;
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -93,11 +104,14 @@ public:
   void setConfigurationPreset(EImageDescriberPreset preset) override
   {
     _params.setPreset(preset);
-    _popSift.reset(nullptr); // reset by describe method
+    std::lock_guard<std::mutex> lock(_popSiftMutex);
+    _popSifts.clear(); // reset by describe method
   }
 
   /**
    * @brief Detect regions on the 8-bit image and compute their attributes (description)
+   * @note Thread-safe: the images are enqueued on the devices in turn and processed
+   *       asynchronously, the calling thread converts the features of its image.
    * @param[in] image Image.
    * @param[out] regions The detected regions and attributes (the caller must delete the allocated data)
    * @param[in] mask 8-bit grayscale image for keypoint filtering (optional)
@@ -123,7 +137,13 @@ private:
 
   SiftParams _params;
   bool _isOriented = true;
-  static std::unique_ptr<PopSift> _popSift;
+
+  /// one PopSift instance per CUDA device
+  static std::vector<std::unique_ptr<PopSift>> _popSifts;
+  /// protects the PopSift instances creation and the jobs enqueue
+  static std::mutex _popSiftMutex;
+  /// device of the next enqueued image
+  static std::atomic<std::size_t> _nextDevice;
 };
 
 } // namespace feature
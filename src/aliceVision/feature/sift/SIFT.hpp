@@ -9,6 +9,7 @@
 
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/gridFiltering.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -17,10 +18,16 @@ extern "C" {
 #include "nonFree/sift/vl/sift.h"
 }
 
+#include <array>
 #include <iostream>
 #include <numeric>
 #include <stdexcept>
 
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define ALICEVISION_SIFT_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace aliceVision {
 namespace feature {
 
@@ -173,6 +180,105 @@ inline void convertSIFT<unsigned char>(
   }
 }
 
+#ifdef ALICEVISION_SIFT_SSE2
+/**
+ * @brief Sum of the 128 values of a descriptor, broadcast in a vector
+ */
+inline __m128 sumSIFT(const vl_sift_pix* descr)
+{
+  __m128 s0 = _mm_setzero_ps();
+  __m128 s1 = _mm_setzero_ps();
+  __m128 s2 = _mm_setzero_ps();
+  __m128 s3 = _mm_setzero_ps();
+  for(int k = 0; k < 128; k += 16)
+  {
+    s0 = _mm_add_ps(s0, _mm_loadu_ps(descr + k));
+    s1 = _mm_add_ps(s1, _mm_loadu_ps(descr + k + 4));
+    s2 = _mm_add_ps(s2, _mm_loadu_ps(descr + k + 8));
+    s3 = _mm_add_ps(s3, _mm_loadu_ps(descr + k + 12));
+  }
+  __m128 sum = _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3));
+  sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  return sum;
+}
+
+/**
+ * @brief Truncated 512 * sqrt(descr / sum) (rootSift) or 512 * descr of 4 values
+ */
+inline __m128i convertSIFT4(const vl_sift_pix* descr, __m128 sum, bool rootSift)
+{
+  __m128 values = _mm_loadu_ps(descr);
+  if(rootSift)
+    values = _mm_sqrt_ps(_mm_div_ps(values, sum));
+  return _mm_cvttps_epi32(_mm_mul_ps(_mm_set1_ps(512.f), values));
+}
+#endif
+
+/**
+ * @brief Convert all the VLFeat descriptors of a view in one pass.
+ * @param[in] descrs The nbDescriptors * 128 VLFeat descriptor values
+ * @param[in] nbDescriptors The number of descriptors
+ * @param[out] descriptors The output descriptors (nbDescriptors contiguous descriptors, in the Regions storage)
+ * @param[in] rootSift see [1]
+ */
+template < typename TOut >
+inline void convertSIFT(
+  const vl_sift_pix* descrs,
+  std::size_t nbDescriptors,
+  Descriptor<TOut,128>* descriptors,
+  bool rootSift);
+
+template <>
+inline void convertSIFT<float>(
+  const vl_sift_pix* descrs,
+  std::size_t nbDescriptors,
+  Descriptor<float,128>* descriptors,
+  bool rootSift)
+{
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(nbDescriptors); ++i)
+  {
+    const vl_sift_pix* descr = descrs + 128 * i;
+#ifdef ALICEVISION_SIFT_SSE2
+    // values are positive, the truncation is the floor
+    float* out = descriptors[i].getData();
+    const __m128 sum = rootSift ? sumSIFT(descr) : _mm_setzero_ps();
+    for(int k = 0; k < 128; k += 4)
+      _mm_storeu_ps(out + k, _mm_cvtepi32_ps(convertSIFT4(descr + k, sum, rootSift)));
+#else
+    convertSIFT<float>(descr, descriptors[i], rootSift);
+#endif
+  }
+}
+
+template <>
+inline void convertSIFT<unsigned char>(
+  const vl_sift_pix* descrs,
+  std::size_t nbDescriptors,
+  Descriptor<unsigned char,128>* descriptors,
+  bool rootSift)
+{
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(nbDescriptors); ++i)
+  {
+    const vl_sift_pix* descr = descrs + 128 * i;
+#ifdef ALICEVISION_SIFT_SSE2
+    // VLFeat values are below 0.2 (and below 0.04 relatively to their sum), the saturation never applies
+    unsigned char* out = descriptors[i].getData();
+    const __m128 sum = rootSift ? sumSIFT(descr) : _mm_setzero_ps();
+    for(int k = 0; k < 128; k += 16)
+    {
+      const __m128i low = _mm_packs_epi32(convertSIFT4(descr + k, sum, rootSift), convertSIFT4(descr + k + 4, sum, rootSift));
+      const __m128i high = _mm_packs_epi32(convertSIFT4(descr + k + 8, sum, rootSift), convertSIFT4(descr + k + 12, sum, rootSift));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k), _mm_packus_epi16(low, high));
+    }
+#else
+    convertSIFT<unsigned char>(descr, descriptors[i], rootSift);
+#endif
+  }
+}
+
 /**
  * @brief Get the total amount of RAM needed for a
  * feature extraction of an image of the given dimension.
@@ -206,9 +312,6 @@ bool extractSIFT(const image::Image<float>& image,
   if (params._peakThreshold >= 0)
     vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
 
-  Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
-  Descriptor<T, 128> descriptor;
-
   // Process SIFT computation
   vl_sift_process_first_octave(filt, image.data());
 
@@ -222,6 +325,11 @@ bool extractSIFT(const image::Image<float>& image,
   regionsCasted->Features().reserve(reserveSize);
   regionsCasted->Descriptors().reserve(reserveSize);
 
+  // VLFeat descriptors of the current octave, converted at once in the regions storage
+  std::vector<vl_sift_pix> vlFeatDescriptors;
+  std::vector<std::array<double, 4>> angles;
+  std::vector<int> descriptorOffsets;
+
   while (true)
   {
     vl_sift_detect(filt);
@@ -232,10 +340,13 @@ bool extractSIFT(const image::Image<float>& image,
     // Update gradient before launching parallel extraction
     vl_sift_update_gradient(filt);
 
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+    // orientations of the keypoints, the masked keypoints have no orientation
+    angles.assign(nkeys, std::array<double, 4>{{0.0, 0.0, 0.0, 0.0}});
+    descriptorOffsets.assign(nkeys + 1, 0);
+
+    #pragma omp parallel for
     for (int i = 0; i < nkeys; ++i)
     {
-
       // Feature masking
       if (mask)
       {
@@ -244,114 +355,47 @@ bool extractSIFT(const image::Image<float>& image,
           continue;
       }
 
-      double angles [4] = {0.0, 0.0, 0.0, 0.0};
       int nangles = 1; // by default (1 upright feature)
       if (orientation)
       { // compute from 1 to 4 orientations
-        nangles = vl_sift_calc_keypoint_orientations(filt, angles, keys+i);
+        nangles = vl_sift_calc_keypoint_orientations(filt, angles[i].data(), keys+i);
       }
+      descriptorOffsets[i + 1] = nangles;
+    }
+    std::partial_sum(descriptorOffsets.begin(), descriptorOffsets.end(), descriptorOffsets.begin());
+
+    // one descriptor per orientation, written in the order of the keypoints
+    const std::size_t firstDescriptor = regionsCasted->Features().size();
+    const std::size_t nbDescriptors = descriptorOffsets.back();
+    regionsCasted->Features().resize(firstDescriptor + nbDescriptors);
+    regionsCasted->Descriptors().resize(firstDescriptor + nbDescriptors);
+    vlFeatDescriptors.resize(nbDescriptors * 128);
 
-      for (int q=0 ; q < nangles ; ++q)
+    #pragma omp parallel for
+    for (int i = 0; i < nkeys; ++i)
+    {
+      for (int q = 0; q < descriptorOffsets[i + 1] - descriptorOffsets[i]; ++q)
       {
-        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
-        const SIOPointFeature fp(keys[i].x, keys[i].y,
-          keys[i].sigma, static_cast<float>(angles[q]));
-
-        convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
-        
-        #pragma omp critical
-        {
-          regionsCasted->Descriptors().push_back(descriptor);
-          regionsCasted->Features().push_back(fp);
-        }
-        
+        const int d = descriptorOffsets[i] + q;
+        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptors[d * 128], keys+i, angles[i][q]);
+        regionsCasted->Features()[firstDescriptor + d] = SIOPointFeature(keys[i].x, keys[i].y,
+          keys[i].sigma, static_cast<float>(angles[i][q]));
       }
     }
+
+    convertSIFT<T>(vlFeatDescriptors.data(), nbDescriptors, regionsCasted->Descriptors().data() + firstDescriptor, params._rootSift);
     
     if (vl_sift_process_next_octave(filt))
       break; // Last octave
   }
   vl_sift_delete(filt);
 
-  const auto& features = regionsCasted->Features();
-  const auto& descriptors = regionsCasted->Descriptors();
-  assert(features.size() == descriptors.size());
-  
-  //Sorting the extracted features according to their scale
-  {
-    std::vector<std::size_t> indexSort(features.size());
-    std::iota(indexSort.begin(), indexSort.end(), 0);
-    std::sort(indexSort.begin(), indexSort.end(), [&](std::size_t a, std::size_t b){ return features[a].scale() > features[b].scale(); });
-    
-    std::vector<typename SIFT_Region_T::FeatureT> sortedFeatures(features.size());
-    std::vector<typename SIFT_Region_T::DescriptorT> sortedDescriptors(features.size());
-    for(std::size_t i: indexSort)
-    {
-      sortedFeatures[i] = features[indexSort[i]];
-      sortedDescriptors[i] = descriptors[indexSort[i]];
-    }
-    regionsCasted->Features().swap(sortedFeatures);
-    regionsCasted->Descriptors().swap(sortedDescriptors);
-  }
-
-  // Grid filtering of the keypoints to ensure a global repartition
-  if(params._gridSize && params._maxTotalKeypoints)
-  {
-    // Only filter features if we have more features than the maxTotalKeypoints
-    if(features.size() > params._maxTotalKeypoints)
-    {
-      std::vector<IndexT> filtered_indexes;
-      std::vector<IndexT> rejected_indexes;
-      filtered_indexes.reserve(std::min(features.size(), params._maxTotalKeypoints));
-      rejected_indexes.reserve(features.size());
-
-      const std::size_t sizeMat = params._gridSize * params._gridSize;
-      std::vector<std::size_t> countFeatPerCell(sizeMat, 0);
-      for (int Indice = 0; Indice < sizeMat; Indice++)
-      {
-    	  countFeatPerCell[Indice] = 0;
-      }
-      const std::size_t keypointsPerCell = params._maxTotalKeypoints / sizeMat;
-      const double regionWidth = w / double(params._gridSize);
-      const double regionHeight = h / double(params._gridSize);
-
-      for(IndexT i = 0; i < features.size(); ++i)
-      {
-        const auto& keypoint = features.at(i);
-        
-        const std::size_t cellX = std::min(std::size_t(keypoint.x() / regionWidth), params._gridSize);
-        const std::size_t cellY = std::min(std::size_t(keypoint.y() / regionHeight), params._gridSize);
-
-        std::size_t &count = countFeatPerCell[cellX*params._gridSize + cellY];
-        ++count;
-
-        if(count < keypointsPerCell)
-          filtered_indexes.push_back(i);
-        else
-          rejected_indexes.push_back(i);
-      }
-      // If we don't have enough features (less than maxTotalKeypoints) after the grid filtering (empty regions in the grid for example).
-      // We add the best other ones, without repartition constraint.
-      if( filtered_indexes.size() < params._maxTotalKeypoints )
-      {
-        const std::size_t remainingElements = std::min(rejected_indexes.size(), params._maxTotalKeypoints - filtered_indexes.size());
-        ALICEVISION_LOG_TRACE("Grid filtering -- Copy remaining points: " << remainingElements);
-        filtered_indexes.insert(filtered_indexes.end(), rejected_indexes.begin(), rejected_indexes.begin() + remainingElements);
-      }
+  // Sort the keypoints by decreasing scale and keep the best ones
+  // with a grid filtering to ensure a global repartition
+  const std::size_t maxNbFeatures = (params._gridSize && params._maxTotalKeypoints) ? params._maxTotalKeypoints : regionsCasted->RegionCount();
+  featuresGridFiltering(*regionsCasted, w, h, params._gridSize, maxNbFeatures);
+  assert(regionsCasted->Features().size() == regionsCasted->Descriptors().size());
 
-      std::vector<typename SIFT_Region_T::FeatureT> filtered_features(filtered_indexes.size());
-      std::vector<typename SIFT_Region_T::DescriptorT> filtered_descriptors(filtered_indexes.size());
-      for(IndexT i = 0; i < filtered_indexes.size(); ++i)
-      {
-        filtered_features[i] = features[filtered_indexes[i]];
-        filtered_descriptors[i] = descriptors[filtered_indexes[i]];
-      }
-      regionsCasted->Features().swap(filtered_features);
-      regionsCasted->Descriptors().swap(filtered_descriptors);
-    }
-  }
-  assert(features.size() == descriptors.size());
-  
   return true;
 }
 
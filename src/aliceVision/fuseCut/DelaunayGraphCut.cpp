@@ -7,22 +7,33 @@
 #include "DelaunayGraphCut.hpp"
 // #include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
 #include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_PushRelabel.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
-#include <aliceVision/mvsData/Universe.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/stl/UnionFind.hpp>
 #include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/system/Determinism.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/TaskScheduler.hpp>
+#include <aliceVision/system/numa.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 
 #include "nanoflann.hpp"
 
-#include <geogram/points/kd_tree.h>
+#include <geogram/basic/process.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <unordered_map>
+
 // OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
 // OpenMP preprocessor version: https://github.com/jeffhammond/HPCInfo/wiki/Preprocessor-Macros
 #if defined _OPENMP && _OPENMP >= 201107 
@@ -39,11 +50,6 @@ namespace fuseCut {
 
 namespace bfs = boost::filesystem;
 
-// #define USE_GEOGRAM_KDTREE 1
-
-#ifdef USE_GEOGRAM_KDTREE
-#else
-
 // static const std::size_t MAX_LEAF_ELEMENTS = 64;
 static const std::size_t MAX_LEAF_ELEMENTS = 10;
 
@@ -71,7 +77,7 @@ struct PointVectorAdaptator
     //  "if/else's" are actually solved at compile time.
     inline T kdtree_get_pt(const size_t idx, int dim) const
     {
-        return _data.at(idx).m[dim];
+        return _data[idx].m[dim];
     }
 
     // Optional bounding-box computation: return false to default to a standard bbox computation loop.
@@ -87,6 +93,39 @@ typedef nanoflann::KDTreeSingleIndexAdaptor<
     3 /* dim */
     > KdTree;
 
+/**
+ * @brief KdTree of a point cloud, built once and shared by all the passes on the same point positions.
+ *        The removed points (pixSize == -1) stay in the index and are skipped by the searches,
+ *        so the points must only be removed (removeInvalidPoints) once the index is not used anymore.
+ */
+class PointCloudIndex
+{
+public:
+    explicit PointCloudIndex(const std::vector<Point3d>& points)
+        : _adaptor(points)
+        , _kdTree(3 /*dim*/, _adaptor, nanoflann::KDTreeSingleIndexAdaptorParams(MAX_LEAF_ELEMENTS))
+    {
+        if(!points.empty())
+            _kdTree.buildIndex();
+        ALICEVISION_LOG_INFO("KdTree created for " << points.size() << " points.");
+    }
+
+    PointCloudIndex(const PointCloudIndex&) = delete;
+    PointCloudIndex& operator=(const PointCloudIndex&) = delete;
+
+    const std::vector<Point3d>& points() const { return _adaptor._data; }
+
+    template <typename ResultSet>
+    bool findNeighbors(ResultSet& resultSet, const Point3d& p, const nanoflann::SearchParams& searchParams) const
+    {
+        return _kdTree.findNeighbors(resultSet, p.m, searchParams);
+    }
+
+private:
+    PointVectorAdaptator _adaptor;
+    KdTree _kdTree;
+};
+
 /**
  * A result-set class used when performing a radius based search.
  */
@@ -127,7 +166,8 @@ public:
      */
     inline bool addPoint(DistanceType dist, IndexType index)
     {
-        if(dist < radius)
+        // the removed points are still in the index
+        if(dist < radius && m_pixSizePrepare[index] != -1.0)
         {
             ++m_result;
             if(m_simScorePrepare[index] * m_pixSizePrepare[index] * m_pixSizePrepare[index] < m_simScorePrepare[m_i] * m_pixSizePrepare[m_i] * m_pixSizePrepare[m_i])
@@ -141,26 +181,52 @@ public:
 
     inline DistanceType worstDist() const { return radius; }
 };
-#endif
+
+/**
+ * A result-set class used when searching the nearest point not removed (pixSize != -1).
+ */
+template <typename DistanceType, typename IndexType = size_t>
+class NearestValidPoint
+{
+public:
+    const std::vector<double>& m_pixSizePrepare;
+    IndexType index = std::numeric_limits<IndexType>::max();
+    DistanceType dist = std::numeric_limits<DistanceType>::max();
+
+    explicit NearestValidPoint(const std::vector<double>& pixSizePrepare)
+        : m_pixSizePrepare(pixSizePrepare)
+    {}
+
+    inline size_t size() const { return full() ? 1 : 0; }
+
+    inline bool full() const { return index != std::numeric_limits<IndexType>::max(); }
+
+    inline bool addPoint(DistanceType d, IndexType i)
+    {
+        if(d < dist && m_pixSizePrepare[i] != -1.0)
+        {
+            dist = d;
+            index = i;
+        }
+        return true;
+    }
+
+    inline DistanceType worstDist() const { return dist; }
+};
 
 
-/// Filter by pixSize
-void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, double pixSizeMarginCoef, std::vector<float>& simScorePrepare)
+/**
+ * @brief Filter by pixSize: remove the points with a point of smaller score (simScore * pixSize^2) inside their volume
+ *        (squared radius: pixSizeMarginCoef * score). The points already removed are ignored.
+ *        The points are tested in parallel against the input pixSize, then removed: the result doesn't depend on the threads.
+ * @return the number of remaining points
+ */
+std::size_t filterByPixSize(const PointCloudIndex& index, std::vector<double>& pixSizePrepare, double pixSizeMarginCoef, std::vector<float>& simScorePrepare)
 {
-#ifdef USE_GEOGRAM_KDTREE
-    ALICEVISION_LOG_INFO("Build geogram KdTree index.");
-    GEO::AdaptiveKdTree kdTree(3);
-    kdTree.set_exact(false);
-    kdTree.set_points(verticesCoordsPrepare.size(), verticesCoordsPrepare[0].m);
-#else
-    ALICEVISION_LOG_INFO("Build nanoflann KdTree index.");
-    PointVectorAdaptator pointCloudRef(verticesCoordsPrepare);
-    KdTree kdTree(3 /*dim*/, pointCloudRef, nanoflann::KDTreeSingleIndexAdaptorParams(MAX_LEAF_ELEMENTS));
-    kdTree.buildIndex();
-#endif
-    ALICEVISION_LOG_INFO("KdTree created for " << verticesCoordsPrepare.size() << " points.");
+    const std::vector<Point3d>& verticesCoordsPrepare = index.points();
+    std::vector<char> toRemove(verticesCoordsPrepare.size(), 0);
 
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(dynamic, 1024)
     for(int vIndex = 0; vIndex < verticesCoordsPrepare.size(); ++vIndex)
     {
         if(pixSizePrepare[vIndex] == -1.0)
@@ -170,47 +236,243 @@ void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vec
         const double pixSizeScore = pixSizeMarginCoef * simScorePrepare[vIndex] * pixSizePrepare[vIndex] * pixSizePrepare[vIndex];
         if(pixSizeScore < std::numeric_limits<double>::epsilon())
         {
-            pixSizePrepare[vIndex] = -1.0;
+            toRemove[vIndex] = 1;
             continue;
         }
-#ifdef USE_GEOGRAM_KDTREE
-        static const std::size_t nbNeighbors = 20;
-        static const double nbNeighborsInv = 1.0 / (double)nbNeighbors;
-        std::array<GEO::index_t, nbNeighbors> nnIndex;
-        std::array<double, nbNeighbors> sqDist;
-        // kdTree.get_nearest_neighbors(nbNeighbors, verticesCoordsPrepare[i].m, &nnIndex.front(), &sqDist.front());
-        kdTree.get_nearest_neighbors(nbNeighbors, vIndex, &nnIndex.front(), &sqDist.front());
+        static const nanoflann::SearchParams searchParams(32, 0, false); // false: dont need to sort
+        SmallerPixSizeInRadius<double, std::size_t> resultSet(pixSizeScore, pixSizePrepare, simScorePrepare, vIndex);
+        index.findNeighbors(resultSet, verticesCoordsPrepare[vIndex], searchParams);
+        if(resultSet.found)
+            toRemove[vIndex] = 1;
+    }
+
+    std::size_t nbPoints = 0;
+    for(std::size_t vIndex = 0; vIndex < verticesCoordsPrepare.size(); ++vIndex)
+    {
+        if(toRemove[vIndex])
+            pixSizePrepare[vIndex] = -1.0;
+        else if(pixSizePrepare[vIndex] != -1.0)
+            ++nbPoints;
+    }
+    ALICEVISION_LOG_INFO("Filtering done: " << nbPoints << " points.");
+    return nbPoints;
+}
+
+/**
+ * @brief Streaming version of filterByPixSize, the points are filtered as they are inserted so only the kept points are stored.
+ *
+ * As in filterByPixSize, a point is removed if there is a point with a smaller score (simScore * pixSize^2)
+ * inside its volume (squared radius: pixSizeMarginCoef * score).
+ * Unlike filterByPixSize, the points already removed don't remove the next ones.
+ *
+ * The points are stored in hash grids, one per level of radius (radius in [2^level, 2^(level+1)), cells of 2^(level+1)),
+ * the grid of a level contains the points of this level and of all the lower ones.
+ * So the neighbors of a point inside its volume or inside the volume of a point of a given level are in the 27 cells around it.
+ */
+class PixSizeFilterGrid
+{
+public:
+    explicit PixSizeFilterGrid(double pixSizeMarginCoef)
+        : _pixSizeMarginCoef(pixSizeMarginCoef)
+    {}
+
+    void insert(const Point3d& p, double pixSize, float simScore);
+
+    std::size_t size() const { return _nbPoints; }
+
+    /// Get the kept points (the grid is cleared)
+    void extractPoints(std::vector<Point3d>& coords, std::vector<double>& pixSize, std::vector<float>& simScore);
+
+private:
+    struct CellKey
+    {
+        int x, y, z;
+        bool operator==(const CellKey& other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+    struct CellKeyHash
+    {
+        std::size_t operator()(const CellKey& k) const
+        {
+            return (std::size_t(k.x) * 73856093) ^ (std::size_t(k.y) * 19349663) ^ (std::size_t(k.z) * 83492791);
+        }
+    };
+    using Grid = std::unordered_map<CellKey, std::vector<std::size_t>, CellKeyHash>;
+
+    struct GridPoint
+    {
+        Point3d p;
+        double pixSize;
+        float simScore;
+        double score;
+        int level;
+    };
+
+    inline CellKey getCell(const Point3d& p, int level) const
+    {
+        const double cellSize = std::ldexp(1.0, level + 1);
+        return {static_cast<int>(std::floor(p.x / cellSize)), static_cast<int>(std::floor(p.y / cellSize)),
+                static_cast<int>(std::floor(p.z / cellSize))};
+    }
 
-        for(std::size_t n = 0; n < nbNeighbors; ++n)
+    /// Call f(pointIndex) for the points of the level grid in the 27 cells around p, f returns false to stop
+    template <typename F>
+    void forEachNeighbor(const Point3d& p, int level, F f) const;
+
+    void addToGrid(std::size_t index, int level);
+    void remove(std::size_t index);
+
+    double _pixSizeMarginCoef;
+    std::vector<GridPoint> _points;
+    std::vector<bool> _isValid;
+    std::vector<std::size_t> _freeIndexes;
+    std::size_t _nbPoints = 0;
+    /// grids of the levels [_minLevel, _minLevel + _grids.size())
+    int _minLevel = 0;
+    std::deque<Grid> _grids;
+};
+
+template <typename F>
+void PixSizeFilterGrid::forEachNeighbor(const Point3d& p, int level, F f) const
+{
+    const Grid& grid = _grids[level - _minLevel];
+    const CellKey cell = getCell(p, level);
+    for(int dz = -1; dz <= 1; ++dz)
+    {
+        for(int dy = -1; dy <= 1; ++dy)
         {
-            // NOTE: we don't need to test the distance regarding pixSizePrepare[nnIndex[vIndex]]
-            //       as we kill ourself only if our pixSize is bigger
-            if(sqDist[n] < pixSizeScore)
+            for(int dx = -1; dx <= 1; ++dx)
             {
-                if(pixSizePrepare[nnIndex[n]] < pixSizePrepare[vIndex] ||
-                   (pixSizePrepare[nnIndex[n]] == pixSizePrepare[vIndex] && nnIndex[n] < vIndex)
-                   )
+                const auto it = grid.find({cell.x + dx, cell.y + dy, cell.z + dz});
+                if(it == grid.end())
+                    continue;
+                for(std::size_t index : it->second)
                 {
-                    // Kill itself if inside our volume (defined by marginCoef*pixSize) there is another point with a smaller pixSize
-                    pixSizePrepare[vIndex] = -1.0;
-                    break;
+                    if(!f(index))
+                        return;
                 }
             }
-            // else
-            // {
-            //     break;
-            // }
         }
-#else
+    }
+}
 
-        static const nanoflann::SearchParams searchParams(32, 0, false); // false: dont need to sort
-        SmallerPixSizeInRadius<double, std::size_t> resultSet(pixSizeScore, pixSizePrepare, simScorePrepare, vIndex);
-        kdTree.findNeighbors(resultSet, verticesCoordsPrepare[vIndex].m, searchParams);
-        if(resultSet.found)
-            pixSizePrepare[vIndex] = -1.0;
-#endif
+void PixSizeFilterGrid::addToGrid(std::size_t index, int level)
+{
+    _grids[level - _minLevel][getCell(_points[index].p, level)].push_back(index);
+}
+
+void PixSizeFilterGrid::remove(std::size_t index)
+{
+    const GridPoint& point = _points[index];
+    for(int level = point.level, maxLevel = _minLevel + _grids.size(); level < maxLevel; ++level)
+    {
+        std::vector<std::size_t>& cellPoints = _grids[level - _minLevel][getCell(point.p, level)];
+        cellPoints.erase(std::find(cellPoints.begin(), cellPoints.end(), index));
+    }
+    _isValid[index] = false;
+    _freeIndexes.push_back(index);
+    --_nbPoints;
+}
+
+void PixSizeFilterGrid::insert(const Point3d& p, double pixSize, float simScore)
+{
+    const double score = simScore * pixSize * pixSize;
+    const double sqRadius = _pixSizeMarginCoef * score;
+    if(sqRadius < std::numeric_limits<double>::epsilon())
+        return;
+    const int level = static_cast<int>(std::floor(0.5 * std::log2(sqRadius)));
+
+    // create the missing levels
+    if(_grids.empty())
+    {
+        _minLevel = level;
+        _grids.emplace_back();
+    }
+    while(level < _minLevel)
+    {
+        // no point of a lower level
+        _grids.emplace_front();
+        --_minLevel;
+    }
+    while(level >= _minLevel + static_cast<int>(_grids.size()))
+    {
+        // all the points are of a lower level
+        const int newLevel = _minLevel + _grids.size();
+        _grids.emplace_back();
+        for(std::size_t index = 0; index < _points.size(); ++index)
+        {
+            if(_isValid[index])
+                addToGrid(index, newLevel);
+        }
+    }
+
+    // the points with a smaller score have a smaller radius, so a lower or equal level
+    bool isInsideSmallerPoint = false;
+    forEachNeighbor(p, level, [&](std::size_t index)
+    {
+        const GridPoint& other = _points[index];
+        isInsideSmallerPoint = (other.score < score) && ((other.p - p).size2() < sqRadius);
+        return !isInsideSmallerPoint;
+    });
+    if(isInsideSmallerPoint)
+        return;
+
+    // remove the points with a larger score containing the new one
+    std::vector<std::size_t> toRemove;
+    for(int otherLevel = level, maxLevel = _minLevel + _grids.size(); otherLevel < maxLevel; ++otherLevel)
+    {
+        forEachNeighbor(p, otherLevel, [&](std::size_t index)
+        {
+            const GridPoint& other = _points[index];
+            if(other.level == otherLevel && other.score > score && (other.p - p).size2() < _pixSizeMarginCoef * other.score)
+                toRemove.push_back(index);
+            return true;
+        });
+    }
+    for(std::size_t index : toRemove)
+        remove(index);
+
+    std::size_t index = _points.size();
+    if(_freeIndexes.empty())
+    {
+        _points.emplace_back();
+        _isValid.push_back(true);
+    }
+    else
+    {
+        index = _freeIndexes.back();
+        _freeIndexes.pop_back();
+        _isValid[index] = true;
+    }
+    _points[index] = {p, pixSize, simScore, score, level};
+    ++_nbPoints;
+
+    for(int gridLevel = level, maxLevel = _minLevel + _grids.size(); gridLevel < maxLevel; ++gridLevel)
+        addToGrid(index, gridLevel);
+}
+
+void PixSizeFilterGrid::extractPoints(std::vector<Point3d>& coords, std::vector<double>& pixSize, std::vector<float>& simScore)
+{
+    _grids.clear();
+
+    coords.clear();
+    pixSize.clear();
+    simScore.clear();
+    coords.reserve(_nbPoints);
+    pixSize.reserve(_nbPoints);
+    simScore.reserve(_nbPoints);
+    for(std::size_t index = 0; index < _points.size(); ++index)
+    {
+        if(!_isValid[index])
+            continue;
+        coords.push_back(_points[index].p);
+        pixSize.push_back(_points[index].pixSize);
+        simScore.push_back(_points[index].simScore);
     }
-    ALICEVISION_LOG_INFO("Filtering done.");
+
+    std::vector<GridPoint>().swap(_points);
+    std::vector<bool>().swap(_isValid);
+    std::vector<std::size_t>().swap(_freeIndexes);
+    _nbPoints = 0;
 }
 
 
@@ -265,123 +527,117 @@ void removeInvalidPoints(std::vector<Point3d>& verticesCoordsPrepare, std::vecto
     verticesAttrPrepare.swap(verticesAttrTmp);
 }
 
-void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare,
-                                    std::vector<GC_vertexInfo>& verticesAttrPrepare, mvsUtils::MultiViewParams* mp, float simFactor, float voteMarginFactor, float contributeMarginFactor, float simGaussianSize)
+/**
+ * @brief Vote of a depth map pixel for its nearest vertex
+ */
+struct VertexVote
+{
+    std::size_t vertexIndex;
+    int camera;
+    Point3d p;
+    /// the pixel contributes to the vertex position
+    bool contribute;
+};
+
+/**
+ * @brief Declare the cameras seeing the vertices and refine their positions with the depth map pixels voting for them.
+ *        Two phases per batch of cameras: the nearest vertices of the pixels are searched in parallel on the unchanged positions,
+ *        then the votes are applied in parallel per range of vertices, in the order of the cameras and pixels,
+ *        so the result doesn't depend on the threads.
+ * @param[in] index the index of verticesCoordsPrepare, the removed points (pixSize == -1) don't get votes.
+ *                  It is not valid anymore after the call (the positions are updated).
+ */
+void createVerticesWithVisibilities(const PointCloudIndex& index, const StaticVector<int>& cams, std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare,
+                                    std::vector<GC_vertexInfo>& verticesAttrPrepare, mvsUtils::MultiViewParams* mp, float voteMarginFactor, float contributeMarginFactor)
 {
-#ifdef USE_GEOGRAM_KDTREE
-    GEO::AdaptiveKdTree kdTree(3);
-    kdTree.set_points(verticesCoordsPrepare.size(), verticesCoordsPrepare[0].m);
-    ALICEVISION_LOG_INFO("GEOGRAM: KdTree created");
-#else
-    PointVectorAdaptator pointCloudRef(verticesCoordsPrepare);
-    KdTree kdTree(3 /*dim*/, pointCloudRef, nanoflann::KDTreeSingleIndexAdaptorParams(MAX_LEAF_ELEMENTS));
-    kdTree.buildIndex();
-    ALICEVISION_LOG_INFO("NANOFLANN: KdTree created.");
-#endif
-    // TODO FACA: update into new data structures
-    // std::vector<Point3d> newVerticesCoordsPrepare(verticesCoordsPrepare.size());
-    // std::vector<float> newSimScorePrepare(simScorePrepare.size());
-    // std::vector<double> newPixSizePrepare(pixSizePrepare.size());
-    std::vector<omp_lock_t> locks(verticesCoordsPrepare.size());
-    for (auto& lock: locks)
-        omp_init_lock(&lock);
-
-    omp_set_nested(1);
-    #pragma omp parallel for num_threads(3)
-    for(int c = 0; c < cams.size(); ++c)
-    {
-        ALICEVISION_LOG_INFO("Create visibilities (" << c << "/" << cams.size() << ")");
-        std::vector<float> depthMap;
-        std::vector<float> simMap;
-        int width, height;
-        {
-            const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
-            imageIO::readImage(depthMapFilepath, width, height, depthMap);
-            if(depthMap.empty())
-            {
-                ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
-                continue;
-            }
-            int wTmp, hTmp;
-            const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
-            imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
-            if(wTmp != width || hTmp != height)
-                throw std::runtime_error("Similarity map size doesn't match the depth map size: " + simMapFilepath + ", " + depthMapFilepath);
+    // the updated positions, the index keeps the initial ones
+    std::vector<Point3d> newVerticesCoordsPrepare(verticesCoordsPrepare);
+
+    // 3 depth maps in memory at the same time
+    const int nbCamerasPerBatch = 3;
+    std::vector<std::vector<VertexVote>> batchVotes(nbCamerasPerBatch);
+    const int nbRanges = std::max(1, std::min(static_cast<int>(verticesCoordsPrepare.size()), 8 * omp_get_max_threads()));
+    std::vector<std::vector<const VertexVote*>> rangeVotes(nbRanges);
+
+    for(int batchStart = 0; batchStart < cams.size(); batchStart += nbCamerasPerBatch)
+    {
+        const int batchEnd = std::min(batchStart + nbCamerasPerBatch, cams.size());
+
+        // nearest vertex of each pixel
+        system::parallelFor(batchStart, batchEnd, [&](int c)
+        {
+            std::vector<VertexVote>& votes = batchVotes[c - batchStart];
+            votes.clear();
+
+            ALICEVISION_LOG_INFO("Create visibilities (" << c << "/" << cams.size() << ")");
+            std::vector<float> depthMap;
+            int width, height;
             {
-                std::vector<float> simMapTmp(simMap.size());
-                imageIO::convolveImage(width, height, simMap, simMapTmp, "gaussian", simGaussianSize, simGaussianSize);
-                simMap.swap(simMapTmp);
+                const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
+                imageIO::readImage(depthMapFilepath, width, height, depthMap);
+                if(depthMap.empty())
+                {
+                    ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+                    return;
+                }
             }
-        }
-        // Add visibility
-        #pragma omp parallel for
-        for(int y = 0; y < height; ++y)
-        {
-            for(int x = 0; x < width; ++x)
+            std::vector<std::vector<VertexVote>> rowVotes(height);
+            system::parallelFor(0, height, [&](int y)
             {
-                const std::size_t index = y * width + x;
-                const float depth = depthMap[index];
-                if(depth <= 0.0f)
-                    continue;
-
-                const Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)x, (float)y)).normalize() * depth;
-                const double pixSize = mp->getCamPixelSize(p, c);
-#ifdef USE_GEOGRAM_KDTREE
-                const std::size_t nearestVertexIndex = kdTree.get_nearest_neighbor(p.m);
-                // NOTE: Could compute the distance between the line (camera to pixel) and the nearestVertex OR
-                //       the distance between the back-projected point and the nearestVertex
-                const double dist = (p - verticesCoordsPrepare[nearestVertexIndex]).size2();
-#else
-                nanoflann::KNNResultSet<double, std::size_t> resultSet(1);
-                std::size_t nearestVertexIndex = std::numeric_limits<std::size_t>::max();
-                double dist = std::numeric_limits<double>::max();
-                resultSet.init(&nearestVertexIndex, &dist);
-                if(!kdTree.findNeighbors(resultSet, p.m, nanoflann::SearchParams()))
+                for(int x = 0; x < width; ++x)
                 {
-                    ALICEVISION_LOG_WARNING("Failed to find Neighbors.");
-                    continue;
+                    const std::size_t pixIndex = y * width + x;
+                    const float depth = depthMap[pixIndex];
+                    if(depth <= 0.0f)
+                        continue;
+
+                    const Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)x, (float)y)).normalize() * depth;
+                    const double pixSize = mp->getCamPixelSize(p, c);
+
+                    NearestValidPoint<double, std::size_t> resultSet(pixSizePrepare);
+                    if(!index.findNeighbors(resultSet, p, nanoflann::SearchParams()))
+                        continue;
+                    const std::size_t nearestVertexIndex = resultSet.index;
+                    const double dist = resultSet.dist;
+
+                    const float pixSizeScoreI = simScorePrepare[nearestVertexIndex] * pixSize * pixSize;
+                    const float pixSizeScoreV = simScorePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex];
+
+                    if(dist < voteMarginFactor * std::max(pixSizeScoreI, pixSizeScoreV))
+                        rowVotes[y].push_back({nearestVertexIndex, c, p, dist < contributeMarginFactor * pixSizeScoreV});
                 }
-#endif
-                const float pixSizeScoreI = simScorePrepare[nearestVertexIndex] * pixSize * pixSize;
-                const float pixSizeScoreV = simScorePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex];
+            });
+            for(const std::vector<VertexVote>& row : rowVotes)
+                votes.insert(votes.end(), row.begin(), row.end());
+        });
 
-                if(dist < voteMarginFactor * std::max(pixSizeScoreI, pixSizeScoreV))
-                {
-                    GC_vertexInfo& va = verticesAttrPrepare[nearestVertexIndex];
-                    Point3d& vc = verticesCoordsPrepare[nearestVertexIndex];
-                    const float simValue = simMap[index];
-                    // remap similarity values from [-1;+1] to [+1;+simFactor]
-                    // interpretation is [goodSimilarity;badSimilarity]
-                    const float simScore = simValue < -1.0f ? 1.0f : 1.0f + (1.0f + simValue) * simFactor;
+        // split the votes by range of vertices, in the order of the cameras and pixels
+        for(std::vector<const VertexVote*>& votes : rangeVotes)
+            votes.clear();
+        for(int b = 0; b < batchEnd - batchStart; ++b)
+        {
+            for(const VertexVote& vote : batchVotes[b])
+                rangeVotes[vote.vertexIndex * nbRanges / verticesCoordsPrepare.size()].push_back(&vote);
+        }
 
-                    // Custom locks to limit it to the index: nearestVertexIndex
-                    // to avoid using "omp critical"
-                    omp_lock_t* lock = &locks[nearestVertexIndex];
-                    omp_set_lock(lock);
-                    {
-                        va.cams.push_back_distinct(c);
-                        if(dist < contributeMarginFactor * pixSizeScoreV)
-                        {
-                            vc = (vc * (double)va.nrc + p) / double(va.nrc + 1);
-//                            newVerticesCoordsPrepare[nearestVertexIndex] = (newVerticesCoordsPrepare[nearestVertexIndex] * double(va.nrc) + p) / double(va.nrc + 1);
-//                            newSimScorePrepare[nearestVertexIndex] = (newSimScorePrepare[nearestVertexIndex] * float(va.nrc) + simScore) / float(va.nrc + 1);
-//                            newPixSizePrepare[nearestVertexIndex] = (newPixSizePrepare[nearestVertexIndex] * double(va.nrc) + pixSize) / double(va.nrc + 1);
-                            va.nrc += 1;
-                        }
-                    }
-                    omp_unset_lock(lock);
+        // apply the votes
+        system::parallelFor(0, nbRanges, [&](int r)
+        {
+            for(const VertexVote* vote : rangeVotes[r])
+            {
+                GC_vertexInfo& va = verticesAttrPrepare[vote->vertexIndex];
+                va.cams.push_back_distinct(vote->camera);
+                if(vote->contribute)
+                {
+                    Point3d& vc = newVerticesCoordsPrepare[vote->vertexIndex];
+                    vc = (vc * (double)va.nrc + vote->p) / double(va.nrc + 1);
+                    va.nrc += 1;
                 }
             }
-        }
+        });
     }
-    omp_set_nested(0);
 
-    for(auto& lock: locks)
-        omp_destroy_lock(&lock);
-
-//    verticesCoordsPrepare.swap(newVerticesCoordsPrepare);
-//    simScorePrepare.swap(newSimScorePrepare);
-//    pixSizePrepare.swap(newPixSizePrepare);
+    verticesCoordsPrepare.swap(newVerticesCoordsPrepare);
     ALICEVISION_LOG_INFO("Visibilities created.");
 }
 
@@ -396,7 +652,13 @@ DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp, mvsUtils::Pre
     saveTemporaryBinFiles = mp->_ini.get<bool>("LargeScale.saveTemporaryBinFiles", false);
 
     GEO::initialize();
-    _tetrahedralization = GEO::Delaunay::create(3, "BDEL");
+
+    // multi-threaded tetrahedralization, if geogram is built with it
+    const bool parallelDelaunay = mp->_ini.get<bool>("delaunaycut.parallelDelaunay", false);
+    if(parallelDelaunay && !GEO::DelaunayFactory::has_creator("PDEL"))
+        ALICEVISION_LOG_WARNING("Parallel Delaunay tetrahedralization is not available in geogram, use the sequential one.");
+    const std::string delaunayAlgorithm = (parallelDelaunay && GEO::DelaunayFactory::has_creator("PDEL")) ? "PDEL" : "BDEL";
+    _tetrahedralization = GEO::Delaunay::create(3, delaunayAlgorithm);
     // _tetrahedralization->set_keeps_infinite(true);
     _tetrahedralization->set_stores_neighbors(true);
     // _tetrahedralization->set_stores_cicl(true);
@@ -462,17 +724,104 @@ void DelaunayGraphCut::computeDelaunay()
 
     assert(_verticesCoords.size() == _verticesAttr.size());
 
-    long tall = clock();
-    _tetrahedralization->set_vertices(_verticesCoords.size(), _verticesCoords.front().m);
-    mvsUtils::printfElapsedTime(tall, "GEOGRAM Delaunay tetrahedralization ");
+    // num. of threads of the parallel tetrahedralization (PDEL), all the cores if 0
+    const int nbThreads = mp->_ini.get<int>("delaunaycut.nbThreads", 0);
+    if(nbThreads > 0)
+        GEO::Process::set_max_threads(nbThreads);
+
+    {
+        // the tetrahedralization and the cells are read by all the threads of the graph cut
+        system::NumaInterleaveScope numaInterleave;
+
+        long tall = clock();
+        _tetrahedralization->set_vertices(_verticesCoords.size(), _verticesCoords.front().m);
+        mvsUtils::printfElapsedTime(tall, "GEOGRAM Delaunay tetrahedralization ");
 
-    initCells();
+        initCells();
 
-    updateVertexToCellsCache();
+        updateVertexToCellsCache();
+    }
+    updateMemoryCounter();
 
     ALICEVISION_LOG_DEBUG("computeDelaunay done\n");
 }
 
+void DelaunayGraphCut::updateVertexToCellsCache()
+{
+    const CellIndex nbCells = _tetrahedralization->nb_cells();
+    const std::size_t nbVertices = _verticesCoords.size();
+
+    // count the cells per vertex
+    std::vector<std::atomic<std::size_t>> cursors(nbVertices);
+    int coutInvalidVertices = 0;
+#pragma omp parallel for reduction(+:coutInvalidVertices)
+    for(int ci = 0; ci < nbCells; ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const VertexIndex vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi == GEO::NO_VERTEX || vi >= nbVertices)
+            {
+                ++coutInvalidVertices;
+                continue;
+            }
+            cursors[vi].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
+
+    // prefix sum
+    _neighboringCellsPerVertexOffsets.assign(nbVertices + 1, 0);
+    for(std::size_t vi = 0; vi < nbVertices; ++vi)
+    {
+        _neighboringCellsPerVertexOffsets[vi + 1] = _neighboringCellsPerVertexOffsets[vi] + cursors[vi];
+        cursors[vi] = _neighboringCellsPerVertexOffsets[vi];
+    }
+
+    // fill
+    _neighboringCellsPerVertex.clear();
+    _neighboringCellsPerVertex.shrink_to_fit();
+    _neighboringCellsPerVertex.resize(_neighboringCellsPerVertexOffsets.back());
+#pragma omp parallel for
+    for(int ci = 0; ci < nbCells; ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const VertexIndex vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi == GEO::NO_VERTEX || vi >= nbVertices)
+                continue;
+            _neighboringCellsPerVertex[cursors[vi].fetch_add(1, std::memory_order_relaxed)] = ci;
+        }
+    }
+
+    // same order of the cells whatever the num. of threads
+#pragma omp parallel for schedule(dynamic, 1024)
+    for(int vi = 0; vi < nbVertices; ++vi)
+    {
+        std::sort(_neighboringCellsPerVertex.begin() + _neighboringCellsPerVertexOffsets[vi],
+                  _neighboringCellsPerVertex.begin() + _neighboringCellsPerVertexOffsets[vi + 1]);
+    }
+
+    ALICEVISION_LOG_INFO("verticesCoords: " << nbVertices << ", neighboring cells: " << _neighboringCellsPerVertex.size());
+}
+
+void DelaunayGraphCut::updateMemoryCounter()
+{
+    if(!system::MemoryAccounting::isEnabled())
+        return;
+
+    // geogram stores the 4 vertices and the 4 neighbors of each cell
+    std::size_t size = _tetrahedralization->nb_cells() * 8 * sizeof(GEO::index_t);
+    size += _verticesCoords.capacity() * sizeof(Point3d) + _verticesAttr.capacity() * sizeof(GC_vertexInfo);
+    for(const GC_vertexInfo& v : _verticesAttr)
+        size += v.cams.capacity() * sizeof(int);
+    size += _cellsAttr.capacity() * sizeof(GC_cellInfo) + _cellIsFull.capacity() / 8;
+    size += _camsVertexes.capacity() * sizeof(int);
+    size += _neighboringCellsPerVertex.capacity() * sizeof(CellIndex) +
+            _neighboringCellsPerVertexOffsets.capacity() * sizeof(std::size_t);
+    _memoryCounter.set(size);
+}
+
 void DelaunayGraphCut::initCells()
 {
     ALICEVISION_LOG_DEBUG("initCells ...\n");
@@ -767,6 +1116,196 @@ void DelaunayGraphCut::addHelperPoints(int nGridHelperVolumePointsDim, Point3d v
 }
 
 
+/**
+ * @brief Get the bounding box of the projection of a voxel in a camera image
+ * @param[in] margin The margin added around the projection (in pixels)
+ * @param[out] x, y, w, h The image region (the whole image if the voxel is partially behind the camera)
+ * @return false if the voxel is not seen by the camera
+ */
+static bool getVoxelImageRegion(const mvsUtils::MultiViewParams* mp, int c, const Point3d voxel[8], int width, int height,
+                                int margin, int& x, int& y, int& w, int& h)
+{
+    x = 0;
+    y = 0;
+    w = width;
+    h = height;
+
+    double xMin = std::numeric_limits<double>::max();
+    double yMin = std::numeric_limits<double>::max();
+    double xMax = std::numeric_limits<double>::lowest();
+    double yMax = std::numeric_limits<double>::lowest();
+    for(int i = 0; i < 8; ++i)
+    {
+        if(!mp->is3DPointInFrontOfCam(&voxel[i], c))
+            return true;
+        Point2d pix;
+        mp->getPixelFor3DPoint(&pix, voxel[i], c);
+        xMin = std::min(xMin, pix.x);
+        yMin = std::min(yMin, pix.y);
+        xMax = std::max(xMax, pix.x);
+        yMax = std::max(yMax, pix.y);
+    }
+
+    const int xBegin = std::max(0, static_cast<int>(std::floor(xMin)) - margin);
+    const int yBegin = std::max(0, static_cast<int>(std::floor(yMin)) - margin);
+    const int xEnd = std::min(width, static_cast<int>(std::ceil(xMax)) + margin + 1);
+    const int yEnd = std::min(height, static_cast<int>(std::ceil(yMax)) + margin + 1);
+    if(xBegin >= xEnd || yBegin >= yEnd)
+        return false;
+
+    x = xBegin;
+    y = yBegin;
+    w = xEnd - xBegin;
+    h = yEnd - yBegin;
+    return true;
+}
+
+/**
+ * @brief Load the depth map of a camera and select the best point of each tile of step x step pixels
+ * @param[out] outCoords, outPixSize, outSimScore The points per tile (ceil(height / step) * ceil(width / step)),
+ *             outPixSize is -1 for the discarded tiles
+ */
+static void loadDepthMapPoints(const mvsUtils::MultiViewParams* mp, int c, const Point3d voxel[8], const FuseParams& params,
+                               int step, Point3d* outCoords, double* outPixSize, float* outSimScore)
+{
+    std::vector<float> depthMap;
+    std::vector<float> simMap;
+    std::vector<unsigned char> numOfModalsMap;
+    int width, height;
+    // region of the maps in memory, only the part seeing the voxel is read
+    int regionX = 0;
+    int regionY = 0;
+    int regionWidth, regionHeight;
+    {
+        const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
+        const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
+        const std::string nmodMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::nmodMap, 0);
+
+        int nchannels;
+        imageIO::readImageSpec(depthMapFilepath, width, height, nchannels);
+        const int nbTiles = std::ceil(height / step) * std::ceil(width / step);
+        regionWidth = width;
+        regionHeight = height;
+
+        // the margin keeps the similarity filtering unchanged inside the region
+        const int margin = static_cast<int>(std::ceil(params.simGaussianSizeInit)) + step;
+        if(voxel != nullptr && !getVoxelImageRegion(mp, c, voxel, width, height, margin, regionX, regionY, regionWidth, regionHeight))
+        {
+            // the voxel is not seen by the camera
+            std::fill(outPixSize, outPixSize + nbTiles, -1.0);
+            return;
+        }
+
+        int wTmp, hTmp;
+        if(regionWidth == width && regionHeight == height)
+        {
+            imageIO::readImage(depthMapFilepath, wTmp, hTmp, depthMap);
+            imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
+            if(wTmp != width || hTmp != height)
+                throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
+            imageIO::readImage(nmodMapFilepath, wTmp, hTmp, numOfModalsMap);
+            if(wTmp != width || hTmp != height)
+                throw std::runtime_error("Wrong nmod map dimensions: " + nmodMapFilepath);
+        }
+        else
+        {
+            imageIO::readImageRegion(depthMapFilepath, regionX, regionY, regionWidth, regionHeight, depthMap);
+            imageIO::readImageRegion(simMapFilepath, regionX, regionY, regionWidth, regionHeight, simMap);
+            imageIO::readImageRegion(nmodMapFilepath, regionX, regionY, regionWidth, regionHeight, numOfModalsMap);
+        }
+        if(depthMap.empty())
+        {
+            ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+            std::fill(outPixSize, outPixSize + nbTiles, -1.0);
+            return;
+        }
+        {
+            std::vector<float> simMapTmp(simMap.size());
+            imageIO::convolveImage(regionWidth, regionHeight, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
+            simMap.swap(simMapTmp);
+        }
+    }
+
+    int syMax = std::ceil(height/step);
+    int sxMax = std::ceil(width/step);
+    system::parallelFor(0, syMax, [&](int sy)
+    {
+        for(int sx = 0; sx < sxMax; ++sx)
+        {
+            const int index = sy * sxMax + sx;
+            float bestDepth = std::numeric_limits<float>::max();
+            float bestScore = 0;
+            float bestSimScore = 0;
+            int bestX = 0;
+            int bestY = 0;
+            for(int y = std::max(sy * step, regionY), ymax = std::min({(sy+1) * step, height, regionY + regionHeight});
+                y < ymax; ++y)
+            {
+                for(int x = std::max(sx * step, regionX), xmax = std::min({(sx+1) * step, width, regionX + regionWidth});
+                    x < xmax; ++x)
+                {
+                    const std::size_t index = (y - regionY) * regionWidth + (x - regionX);
+                    const float depth = depthMap[index];
+                    if(depth <= 0.0f)
+                        continue;
+
+                    int numOfModals = 0;
+                    const int scoreKernelSize = 1;
+                    for(int ly = std::max(y-scoreKernelSize, regionY), lyMax = std::min(y+scoreKernelSize, regionY+regionHeight-1); ly < lyMax; ++ly)
+                    {
+                        for(int lx = std::max(x-scoreKernelSize, regionX), lxMax = std::min(x+scoreKernelSize, regionX+regionWidth-1); lx < lxMax; ++lx)
+                        {
+                            const std::size_t lindex = (ly - regionY) * regionWidth + (lx - regionX);
+                            if(depthMap[lindex] > 0.0f)
+                            {
+                                numOfModals += 10 + int(numOfModalsMap[lindex]);
+                            }
+                        }
+                    }
+                    float sim = simMap[index];
+                    sim = sim < 0.0f ?  0.0f : sim; // clamp values < 0
+                    // remap similarity values from [-1;+1] to [+1;+simScale]
+                    // interpretation is [goodSimilarity;badSimilarity]
+                    const float simScore = 1.0f + sim * params.simFactor;
+
+                    const float score = numOfModals + (1.0f / simScore);
+                    if(score > bestScore)
+                    {
+                        bestDepth = depth;
+                        bestScore = score;
+                        bestSimScore = simScore;
+                        bestX = x;
+                        bestY = y;
+                    }
+                }
+            }
+            if(bestScore < 3*13)
+            {
+                // discard the point
+                outPixSize[index] = -1.0;
+            }
+            else
+            {
+                Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
+                
+                // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
+                if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel)) 
+                {
+                    outCoords[index] = p;
+                    outSimScore[index] = bestSimScore;
+                    outPixSize[index] = mp->getCamPixelSize(p, c);
+                }
+                else
+                {
+                    // discard the point
+                    // outCoords[index] = p;
+                    outPixSize[index] = -1.0;
+                }
+            }
+        }
+    });
+}
+
 void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Point3d voxel[8], const FuseParams& params)
 {
     ALICEVISION_LOG_INFO("fuseFromDepthMaps, maxVertices: " << params.maxPoints);
@@ -786,156 +1325,99 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     }
     int step = std::floor(std::sqrt(double(nbPixels) / double(params.maxInputPoints)));
     step = std::max(step, params.minStep);
-    std::size_t realMaxVertices = 0;
-    std::vector<int> startIndex(mp->getNbCameras(), 0);
-    for(int i = 0; i < mp->getNbCameras(); ++i)
-    {
-        const auto& imgParams = mp->getImageParams(i);
-        startIndex[i] = realMaxVertices;
-        realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
-    }
-    verticesCoordsPrepare.resize(realMaxVertices);
-    std::vector<double> pixSizePrepare(realMaxVertices);
-    std::vector<float> simScorePrepare(realMaxVertices);
+    std::vector<double> pixSizePrepare;
+    std::vector<float> simScorePrepare;
 
     ALICEVISION_LOG_INFO("simFactor: " << params.simFactor);
     ALICEVISION_LOG_INFO("nbPixels: " << nbPixels);
     ALICEVISION_LOG_INFO("maxVertices: " << params.maxPoints);
     ALICEVISION_LOG_INFO("step: " << step);
-    ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
 
-    ALICEVISION_LOG_INFO("Load depth maps and add points.");
+    if(params.streamingFuse)
     {
-        omp_set_nested(1);
-        #pragma omp parallel for num_threads(3)
-        for(int c = 0; c < cams.size(); c++)
-        {
-            std::vector<float> depthMap;
-            std::vector<float> simMap;
-            std::vector<unsigned char> numOfModalsMap;
-            int width, height;
-            {
-                const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
-                imageIO::readImage(depthMapFilepath, width, height, depthMap);
-                if(depthMap.empty())
-                {
-                    ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
-                    continue;
-                }
-                int wTmp, hTmp;
-                const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
-                imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
-                {
-                    std::vector<float> simMapTmp(simMap.size());
-                    imageIO::convolveImage(width, height, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
-                    simMap.swap(simMapTmp);
-                }
+        ALICEVISION_LOG_INFO("Load depth maps and filter the points by pixel size, by batch of " << params.nbCamerasPerBatch << " cameras.");
 
-                const std::string nmodMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::nmodMap, 0);
-                imageIO::readImage(nmodMapFilepath, wTmp, hTmp, numOfModalsMap);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong nmod map dimensions: " + nmodMapFilepath);
-            }
+        PixSizeFilterGrid filterGrid(params.pixSizeMarginInitCoef);
+        std::vector<std::vector<Point3d>> batchCoords(params.nbCamerasPerBatch);
+        std::vector<std::vector<double>> batchPixSize(params.nbCamerasPerBatch);
+        std::vector<std::vector<float>> batchSimScore(params.nbCamerasPerBatch);
+
+        for(int batchStart = 0; batchStart < cams.size(); batchStart += params.nbCamerasPerBatch)
+        {
+            const int batchEnd = std::min(batchStart + params.nbCamerasPerBatch, cams.size());
 
-            int syMax = std::ceil(height/step);
-            int sxMax = std::ceil(width/step);
-            #pragma omp parallel for
-            for(int sy = 0; sy < syMax; ++sy)
+            system::parallelFor(batchStart, batchEnd, [&](int c)
             {
-                for(int sx = 0; sx < sxMax; ++sx)
+                const auto& imgParams = mp->getImageParams(c);
+                const std::size_t nbTiles = std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
+                const int b = c - batchStart;
+                batchCoords[b].resize(nbTiles);
+                batchPixSize[b].assign(nbTiles, -1.0);
+                batchSimScore[b].resize(nbTiles);
+                loadDepthMapPoints(mp, c, voxel, params, step, batchCoords[b].data(), batchPixSize[b].data(), batchSimScore[b].data());
+            });
+
+            for(int b = 0; b < batchEnd - batchStart; ++b)
+            {
+                for(std::size_t i = 0; i < batchPixSize[b].size(); ++i)
                 {
-                    int index = startIndex[c] + sy * sxMax + sx;
-                    float bestDepth = std::numeric_limits<float>::max();
-                    float bestScore = 0;
-                    float bestSimScore = 0;
-                    int bestX = 0;
-                    int bestY = 0;
-                    for(int y = sy * step, ymax = std::min((sy+1) * step, height);
-                        y < ymax; ++y)
-                    {
-                        for(int x = sx * step, xmax = std::min((sx+1) * step, width);
-                            x < xmax; ++x)
-                        {
-                            const std::size_t index = y * width + x;
-                            const float depth = depthMap[index];
-                            if(depth <= 0.0f)
-                                continue;
-
-                            int numOfModals = 0;
-                            const int scoreKernelSize = 1;
-                            for(int ly = std::max(y-scoreKernelSize, 0), lyMax = std::min(y+scoreKernelSize, height-1); ly < lyMax; ++ly)
-                            {
-                                for(int lx = std::max(x-scoreKernelSize, 0), lxMax = std::min(x+scoreKernelSize, width-1); lx < lxMax; ++lx)
-                                {
-                                    if(depthMap[ly * width + lx] > 0.0f)
-                                    {
-                                        numOfModals += 10 + int(numOfModalsMap[ly * width + lx]);
-                                    }
-                                }
-                            }
-                            float sim = simMap[index];
-                            sim = sim < 0.0f ?  0.0f : sim; // clamp values < 0
-                            // remap similarity values from [-1;+1] to [+1;+simScale]
-                            // interpretation is [goodSimilarity;badSimilarity]
-                            const float simScore = 1.0f + sim * params.simFactor;
-
-                            const float score = numOfModals + (1.0f / simScore);
-                            if(score > bestScore)
-                            {
-                                bestDepth = depth;
-                                bestScore = score;
-                                bestSimScore = simScore;
-                                bestX = x;
-                                bestY = y;
-                            }
-                        }
-                    }
-                    if(bestScore < 3*13)
-                    {
-                        // discard the point
-                        pixSizePrepare[index] = -1.0;
-                    }
-                    else
-                    {
-                        Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
-                        
-                        // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
-                        if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel)) 
-                        {
-                            verticesCoordsPrepare[index] = p;
-                            simScorePrepare[index] = bestSimScore;
-                            pixSizePrepare[index] = mp->getCamPixelSize(p, c);
-                        }
-                        else
-                        {
-                            // discard the point
-                            // verticesCoordsPrepare[index] = p;
-                            pixSizePrepare[index] = -1.0;
-                        }
-                    }
+                    if(batchPixSize[b][i] != -1.0)
+                        filterGrid.insert(batchCoords[b][i], batchPixSize[b][i], batchSimScore[b][i]);
                 }
             }
+            ALICEVISION_LOG_DEBUG(batchEnd << " cameras loaded, " << filterGrid.size() << " points.");
         }
-        omp_set_nested(0);
+
+        filterGrid.extractPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
     }
+    else
+    {
+        std::size_t realMaxVertices = 0;
+        std::vector<int> startIndex(mp->getNbCameras(), 0);
+        for(int i = 0; i < mp->getNbCameras(); ++i)
+        {
+            const auto& imgParams = mp->getImageParams(i);
+            startIndex[i] = realMaxVertices;
+            realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
+        }
+        verticesCoordsPrepare.resize(realMaxVertices);
+        pixSizePrepare.resize(realMaxVertices);
+        simScorePrepare.resize(realMaxVertices);
 
-    ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
+        ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
 
-    filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
-    // remove points if pixSize == -1
-    removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+        ALICEVISION_LOG_INFO("Load depth maps and add points.");
+        {
+            // 3 depth maps in memory at the same time
+            system::parallelFor(0, cams.size(), [&](int c)
+            {
+                loadDepthMapPoints(mp, c, voxel, params, step, &verticesCoordsPrepare[startIndex[c]],
+                                   &pixSizePrepare[startIndex[c]], &simScorePrepare[startIndex[c]]);
+            }, 3);
+        }
 
-    ALICEVISION_LOG_INFO("3D points loaded and filtered to " << verticesCoordsPrepare.size() << " points.");
+        // remove the empty tiles (pixSize == -1) before indexing the points
+        removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+    }
 
-    ALICEVISION_LOG_INFO("Init visibilities to compute angle scores");
     std::vector<GC_vertexInfo> verticesAttrPrepare(verticesCoordsPrepare.size());
+    {
+        // a single index for the filtering and the visibilities, the filtered points are removed afterwards
+        const PointCloudIndex index(verticesCoordsPrepare);
+
+        if(!params.streamingFuse)
+        {
+            ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
+            filterByPixSize(index, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
+        }
+
+        ALICEVISION_LOG_INFO("Init visibilities to compute angle scores");
 
-    // Compute the vertices positions and simScore from all input depthMap/simMap images,
-    // and declare the visibility information (the cameras indexes seeing the vertex).
-    createVerticesWithVisibilities(cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
-                                   verticesAttrPrepare, mp, params.simFactor, params.voteMarginFactor, params.contributeMarginFactor, params.simGaussianSize);
+        // Compute the vertices positions from all input depthMap images,
+        // and declare the visibility information (the cameras indexes seeing the vertex).
+        createVerticesWithVisibilities(index, cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
+                                       verticesAttrPrepare, mp, params.voteMarginFactor, params.contributeMarginFactor);
+    }
 
     ALICEVISION_LOG_INFO("Compute max angle per point");
 
@@ -1003,40 +1485,48 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
 
     ALICEVISION_LOG_INFO("Filter by angle score and sim score");
 
-    // while more points than the max points (with a limit to 20 iterations).
-    double pixSizeMarginFinalCoef = params.pixSizeMarginFinalCoef;
-    for(int filteringIt = 0; filteringIt < 20; ++filteringIt)
     {
-        // Filter points with new simScore
-        filterByPixSize(verticesCoordsPrepare, pixSizePrepare, pixSizeMarginFinalCoef, simScorePrepare);
-        removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare, verticesAttrPrepare);
+        // the positions don't change until the final visibilities: a single index for all the filtering iterations,
+        // the filtered points are removed afterwards
+        const PointCloudIndex index(verticesCoordsPrepare);
 
-        if(verticesCoordsPrepare.size() < params.maxPoints)
+        // while more points than the max points (with a limit to 20 iterations).
+        double pixSizeMarginFinalCoef = params.pixSizeMarginFinalCoef;
+        for(int filteringIt = 0; filteringIt < 20; ++filteringIt)
         {
-            ALICEVISION_LOG_INFO("The number of points is below the max number of vertices.");
-            break;
+            // Filter points with new simScore
+            const std::size_t nbPoints = filterByPixSize(index, pixSizePrepare, pixSizeMarginFinalCoef, simScorePrepare);
+
+            if(nbPoints < params.maxPoints)
+            {
+                ALICEVISION_LOG_INFO("The number of points is below the max number of vertices.");
+                break;
+            }
+            else
+            {
+                pixSizeMarginFinalCoef *= 1.5;
+                ALICEVISION_LOG_INFO("Increase pixel size margin coef to " << pixSizeMarginFinalCoef << ", nb points: " << nbPoints << ", maxVertices: " << params.maxPoints);
+            }
         }
-        else
+
+        if(params.refineFuse)
         {
-            pixSizeMarginFinalCoef *= 1.5;
-            ALICEVISION_LOG_INFO("Increase pixel size margin coef to " << pixSizeMarginFinalCoef << ", nb points: " << verticesCoordsPrepare.size() << ", maxVertices: " << params.maxPoints);
+            ALICEVISION_LOG_INFO("Create final visibilities");
+            // Initialize the vertice attributes and declare the visibility information
+            createVerticesWithVisibilities(index, cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
+                                           verticesAttrPrepare, mp, params.voteMarginFactor, params.contributeMarginFactor);
         }
     }
+    removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare, verticesAttrPrepare);
     ALICEVISION_LOG_INFO("3D points loaded and filtered to " << verticesCoordsPrepare.size() << " points (maxVertices is " << params.maxPoints << ").");
-
-    if(params.refineFuse)
-    {
-        ALICEVISION_LOG_INFO("Create final visibilities");
-        // Initialize the vertice attributes and declare the visibility information
-        createVerticesWithVisibilities(cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
-                                       verticesAttrPrepare, mp, params.simFactor, params.voteMarginFactor, params.contributeMarginFactor, params.simGaussianSize);
-    }
     _verticesCoords.swap(verticesCoordsPrepare);
     _verticesAttr.swap(verticesAttrPrepare);
 
     if(_verticesCoords.size() == 0)
         throw std::runtime_error("Depth map fusion gives an empty result.");
 
+    updateMemoryCounter();
+
     ALICEVISION_LOG_INFO("fuseFromDepthMaps done: " << _verticesCoords.size() << " points created.");
 }
 
@@ -1116,19 +1606,20 @@ void DelaunayGraphCut::computeVerticesSegSize(bool allPoints, float alpha) // al
     float pointToJoinPixSizeDist = (float)mp->_ini.get<double>("delaunaycut.pointToJoinPixSizeDist", 2.0) *
                                    (float)scalePS * (float)step * 2.0f;
 
-    std::vector<Pixel> edges;
-    edges.reserve(_verticesAttr.size());
-
     if(alpha < 1.0f)
     {
         alpha = 2.0f * std::max(2.0f, pointToJoinPixSizeDist);
     }
 
-    // long t1 = mvsUtils::initEstimate();
     assert(_verticesCoords.size() == _verticesAttr.size());
 
-    for(VertexIndex vi = 0; vi < _verticesAttr.size(); ++vi)
+    // the neighbors are stored by the tetrahedralization, so they can be read concurrently
+    stl::concurrent_union_find<VertexIndex> universe(_verticesAttr.size());
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(_verticesAttr.size()); ++i)
     {
+        const VertexIndex vi = static_cast<VertexIndex>(i);
         const GC_vertexInfo& v = _verticesAttr[vi];
         const Point3d& p = _verticesCoords[vi];
         if((v.getNbCameras() > 0) && ((allPoints) || (v.isOnSurface)))
@@ -1143,52 +1634,45 @@ void DelaunayGraphCut::computeVerticesSegSize(bool allPoints, float alpha) // al
             {
                 const GC_vertexInfo& nv = _verticesAttr[nvi];
                 const Point3d& np = _verticesCoords[nvi];
-                if((vi != nvi) && ((allPoints) || (nv.isOnSurface)))
+                // vi < nvi to join each edge once
+                if((vi < nvi) && ((allPoints) || (nv.isOnSurface)))
                 {
                     if((p - np).size() <
                        alpha * mp->getCamPixelSize(p, rc)) // TODO FACA: why do we fuse again? And only based on the pixSize of the first camera??
                     {
-                        if(vi < nvi) // to remove duplicates
-                        {
-                            edges.emplace_back(vi, nvi);
-                        }
+                        universe.join(vi, nvi);
                     }
                 }
             }
         }
-        // mvsUtils::printfEstimate(vi, _verticesAttr.size(), t1);
     }
-    // mvsUtils::finishEstimate();
 
-    Universe* u = new Universe(_verticesAttr.size());
+    // segment sizes, the root of each segment is its smallest vertex index
+    std::vector<VertexIndex> roots(_verticesAttr.size());
+    std::vector<std::atomic<int>> segSizes(_verticesAttr.size());
 
-    // t1 = mvsUtils::initEstimate();
-    int s = (int)edges.size(); // Fuse all edges collected to be merged
-    for(int i = 0; i < s; i++)
+    #pragma omp parallel for
+    for(std::ptrdiff_t vi = 0; vi < static_cast<std::ptrdiff_t>(_verticesAttr.size()); ++vi)
     {
-        int a = u->find(edges[i].x);
-        int b = u->find(edges[i].y);
-        if(a != b) // TODO FACA: Are they not different in all cases?
-        {
-            u->join(a, b);
-        }
-        // mvsUtils::printfEstimate(i, s, t1);
+        segSizes[vi].store(0, std::memory_order_relaxed);
+        roots[vi] = universe.find(static_cast<VertexIndex>(vi));
     }
-    // mvsUtils::finishEstimate();
+    #pragma omp parallel for
+    for(std::ptrdiff_t vi = 0; vi < static_cast<std::ptrdiff_t>(_verticesAttr.size()); ++vi)
+        segSizes[roots[vi]].fetch_add(1, std::memory_order_relaxed);
 
     // Last loop over vertices to update segId
-    for(int vi = 0; vi < _verticesAttr.size(); ++vi)
+    #pragma omp parallel for
+    for(std::ptrdiff_t vi = 0; vi < static_cast<std::ptrdiff_t>(_verticesAttr.size()); ++vi)
     {
         GC_vertexInfo& v = _verticesAttr[vi];
         if(v.isVirtual())
             continue;
 
-        int a = u->find(vi);
-        v.segSize = u->elts[a].size;
-        v.segId = a;
+        v.segSize = segSizes[roots[vi]].load(std::memory_order_relaxed);
+        v.segId = roots[vi];
     }
 
-    delete u;
     ALICEVISION_LOG_DEBUG("creating universe done.");
 }
 
@@ -1528,6 +2012,7 @@ float DelaunayGraphCut::weightFcn(float nrc, bool labatutWeights, int  /*ncams*/
 void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind,
                                bool labatutWeights, bool fillOut, float distFcnHeight) // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 labatutWeights=0 fillOut=1 distFcnHeight=0
 {
+    ALICEVISION_PROFILE_ZONE("DelaunayGraphCut::fillGraph");
     ALICEVISION_LOG_INFO("Computing s-t graph weights.");
     long t1 = clock();
 
@@ -1547,8 +2032,29 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
         }
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    // vertices casting rays, sorted in Morton order: consecutive rays traverse neighboring cells
+    std::vector<int> verticesToProcess;
+    for(int iV = 0; iV < _verticesAttr.size(); ++iV)
+    {
+        const GC_vertexInfo& v = _verticesAttr[iV];
+        if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+            verticesToProcess.push_back(iV);
+    }
+    sortVerticesInMortonOrder(verticesToProcess);
+
+    // per-thread buffers of the cell weights contributions, bucketed by ranges of cells
+    const int nbThreads = omp_get_max_threads();
+    const int nbRanges = nbThreads * 4;
+    std::vector<CellWeightUpdatesBuffer> buffers(nbThreads);
+    for(CellWeightUpdatesBuffer& buffer : buffers)
+    {
+        buffer.cellsPerRange = std::max<std::size_t>(1, (_cellsAttr.size() + nbRanges - 1) / nbRanges);
+        buffer.ranges.resize(nbRanges);
+    }
+
+    // the buffers are applied after each batch of vertices to bound their memory
+    const int batchSize = 1000 * nbThreads;
+    const bool deterministic = system::Determinism::isEnabled();
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
@@ -1557,14 +2063,18 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     int avCams = 0;
     int nAvCams = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
+    for(int batchStart = 0; batchStart < verticesToProcess.size(); batchStart += batchSize)
     {
-        int iV = (*vetexesToProcessIdsRand)[i];
-        const GC_vertexInfo& v = _verticesAttr[iV];
+        const int batchEnd = std::min<int>(batchStart + batchSize, verticesToProcess.size());
 
-        if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
+        for(int i = batchStart; i < batchEnd; i++)
         {
+            const int iV = verticesToProcess[i];
+            const GC_vertexInfo& v = _verticesAttr[iV];
+            CellWeightUpdatesBuffer& updates = buffers[omp_get_thread_num()];
+            updates.order = i;
+
             for(int c = 0; c < v.cams.size(); c++)
             {
                 // "weight" is called alpha(p) in the paper
@@ -1575,8 +2085,8 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
                 int nstepsFront = 0;
                 int nstepsBehind = 0;
-                fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
-                                  allPoints, behind, fillOut, distFcnHeight);
+                fillGraphPartPtRc(nstepsFront, nstepsBehind, updates, iV, v.cams[c], weight, fixesSigma,
+                                  nPixelSizeBehind, allPoints, behind, fillOut, distFcnHeight);
 
                 avStepsFront += nstepsFront;
                 aAvStepsFront += 1;
@@ -1587,9 +2097,9 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
             avCams += v.cams.size();
             nAvCams += 1;
         }
-    }
 
-    delete vetexesToProcessIdsRand;
+        applyCellWeightUpdates(buffers, deterministic);
+    }
 
     ALICEVISION_LOG_DEBUG("avStepsFront " << avStepsFront);
     ALICEVISION_LOG_DEBUG("avStepsFront = " << mvsUtils::num2str(avStepsFront) << " // " << mvsUtils::num2str(aAvStepsFront));
@@ -1599,9 +2109,9 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     mvsUtils::printfElapsedTime(t1, "s-t graph weights computed : ");
 }
 
-void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam,
-                                       float weight, bool fixesSigma, float nPixelSizeBehind, bool allPoints,
-                                       bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
+void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, CellWeightUpdatesBuffer& updates,
+                                       int vertexIndex, int cam, float weight, bool fixesSigma, float nPixelSizeBehind,
+                                       bool allPoints, bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
 {
     out_nstepsFront = 0;
     out_nstepsBehind = 0;
@@ -1634,10 +2144,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = ci != GEO::NO_CELL;
         while(ok)
         {
-            {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].out += weight;
-            }
+            updates.add(ci, CellWeightUpdate::eOut, weight);
 
             ++out_nstepsFront;
             ++nsteps;
@@ -1654,10 +2161,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
             {
                 float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
 
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
-                }
+                updates.add(f1.cellIndex, CellWeightUpdate::eGEdgeVisWeight, weight * dist, f1.localVertexIndex);
 
                 if(f2.cellIndex == GEO::NO_CELL)
                     ok = false;
@@ -1669,8 +2173,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
         if(lastFinite != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_WRITE
-            _cellsAttr[lastFinite].cellSWeight = (float)maxint;
+            updates.add(lastFinite, CellWeightUpdate::eCellSWeight, (float)maxint);
         }
     }
 
@@ -1683,25 +2186,19 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         CellIndex ci = f1.cellIndex;
         if(ci != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_UPDATE
-            _cellsAttr[ci].on += weight;
+            updates.add(ci, CellWeightUpdate::eOn, weight);
         }
 
         Point3d p = po; // HAS TO BE HERE !!!
 
         bool ok = (ci != GEO::NO_CELL) && allPoints;
-        while(ok)
-        {
-            GC_cellInfo& c = _cellsAttr[ci];
-            {
-                if(behind)
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    c.cellTWeight += weight;
-                }
-#pragma OMP_ATOMIC_UPDATE
-                c.in += weight;
+        while(ok)
+        {
+            if(behind)
+            {
+                updates.add(ci, CellWeightUpdate::eCellTWeight, weight);
             }
+            updates.add(ci, CellWeightUpdate::eIn, weight);
 
             ++out_nstepsBehind;
             ++nsteps;
@@ -1730,8 +2227,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
                 }
                 else
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight * dist;
+                    updates.add(f2.cellIndex, CellWeightUpdate::eGEdgeVisWeight, weight * dist, f2.localVertexIndex);
                 }
                 ci = f2.cellIndex;
             }
@@ -1742,13 +2238,127 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         {
             if(ci != GEO::NO_CELL)
             {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].cellTWeight += weight;
+                updates.add(ci, CellWeightUpdate::eCellTWeight, weight);
+            }
+        }
+    }
+}
+
+void DelaunayGraphCut::applyCellWeightUpdates(std::vector<CellWeightUpdatesBuffer>& buffers, bool ordered)
+{
+    if(buffers.empty())
+        return;
+
+    const int nbRanges = buffers.front().ranges.size();
+
+    const auto apply = [&](std::vector<CellWeightUpdate>& updates)
+    {
+        for(const CellWeightUpdate& update : updates)
+        {
+            GC_cellInfo& c = _cellsAttr[update.cellIndex];
+            switch(update.field)
+            {
+                case CellWeightUpdate::eOut:
+                    c.out += update.value;
+                    break;
+                case CellWeightUpdate::eIn:
+                    c.in += update.value;
+                    break;
+                case CellWeightUpdate::eOn:
+                    c.on += update.value;
+                    break;
+                case CellWeightUpdate::eCellSWeight:
+                    c.cellSWeight = update.value;
+                    break;
+                case CellWeightUpdate::eCellTWeight:
+                    c.cellTWeight += update.value;
+                    break;
+                case CellWeightUpdate::eGEdgeVisWeight:
+                    c.gEdgeVisWeight[update.localVertexIndex] += update.value;
+                    break;
             }
         }
+        updates.clear();
+    };
+
+#pragma omp parallel for schedule(dynamic)
+    for(int r = 0; r < nbRanges; ++r)
+    {
+        if(!ordered)
+        {
+            for(CellWeightUpdatesBuffer& buffer : buffers)
+                apply(buffer.ranges[r]);
+            continue;
+        }
+
+        // all the contributions of an order are in the buffer of the thread which processed it:
+        // the stable sort of the concatenation gives the serial order, whatever the number of threads
+        std::size_t nbUpdates = 0;
+        for(const CellWeightUpdatesBuffer& buffer : buffers)
+            nbUpdates += buffer.ranges[r].size();
+
+        std::vector<CellWeightUpdate> mergedUpdates;
+        mergedUpdates.reserve(nbUpdates);
+        for(CellWeightUpdatesBuffer& buffer : buffers)
+        {
+            mergedUpdates.insert(mergedUpdates.end(), buffer.ranges[r].begin(), buffer.ranges[r].end());
+            buffer.ranges[r].clear();
+        }
+        std::stable_sort(mergedUpdates.begin(), mergedUpdates.end(),
+                         [](const CellWeightUpdate& a, const CellWeightUpdate& b) { return a.order < b.order; });
+        apply(mergedUpdates);
     }
 }
 
+void DelaunayGraphCut::sortVerticesInMortonOrder(std::vector<int>& verticesIndexes) const
+{
+    if(verticesIndexes.empty())
+        return;
+
+    Point3d bbMin = _verticesCoords[verticesIndexes.front()];
+    Point3d bbMax = bbMin;
+    for(int iV : verticesIndexes)
+    {
+        const Point3d& p = _verticesCoords[iV];
+        bbMin = Point3d(std::min(bbMin.x, p.x), std::min(bbMin.y, p.y), std::min(bbMin.z, p.z));
+        bbMax = Point3d(std::max(bbMax.x, p.x), std::max(bbMax.y, p.y), std::max(bbMax.z, p.z));
+    }
+
+    // 21 bits per axis interleaved in a 64 bits code
+    const double maxCoord = double((1 << 21) - 1);
+    const Point3d bbSize = bbMax - bbMin;
+    const auto quantize = [maxCoord](double x, double minX, double sizeX) -> std::uint64_t
+    {
+        return (sizeX > 0.0) ? static_cast<std::uint64_t>((x - minX) / sizeX * maxCoord) : 0;
+    };
+    const auto spreadBits = [](std::uint64_t x) -> std::uint64_t
+    {
+        x &= 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffff;
+        x = (x | x << 16) & 0x1f0000ff0000ff;
+        x = (x | x << 8) & 0x100f00f00f00f00f;
+        x = (x | x << 4) & 0x10c30c30c30c30c3;
+        x = (x | x << 2) & 0x1249249249249249;
+        return x;
+    };
+
+    std::vector<std::pair<std::uint64_t, int>> codes(verticesIndexes.size());
+#pragma omp parallel for
+    for(int i = 0; i < verticesIndexes.size(); ++i)
+    {
+        const Point3d& p = _verticesCoords[verticesIndexes[i]];
+        codes[i].first = spreadBits(quantize(p.x, bbMin.x, bbSize.x)) |
+                         (spreadBits(quantize(p.y, bbMin.y, bbSize.y)) << 1) |
+                         (spreadBits(quantize(p.z, bbMin.z, bbSize.z)) << 2);
+        codes[i].second = verticesIndexes[i];
+    }
+
+    std::sort(codes.begin(), codes.end());
+
+    for(int i = 0; i < codes.size(); ++i)
+        verticesIndexes[i] = codes[i].second;
+}
+
 void DelaunayGraphCut::forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind)
 {
     ALICEVISION_LOG_INFO("Forcing t-edges.");
@@ -1880,148 +2490,180 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSi
         // c.out = c.gEdgeVisWeight[0] + c.gEdgeVisWeight[1] + c.gEdgeVisWeight[2] + c.gEdgeVisWeight[3];
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    // the rays only read "out" and accumulate "on":
+    // in the deterministic mode, the vertices are processed in their index order and the "on" contributions are
+    // buffered per thread, then merged in this order; otherwise a random order prevents waiting on the atomics
+    const bool deterministic = system::Determinism::isEnabled();
+    StaticVector<int>* vetexesToProcessIdsRand = nullptr;
+    if(!deterministic)
+        vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+
+    const int nbThreads = omp_get_max_threads();
+    const int nbRanges = nbThreads * 4;
+    std::vector<CellWeightUpdatesBuffer> buffers(deterministic ? nbThreads : 0);
+    for(CellWeightUpdatesBuffer& buffer : buffers)
+    {
+        buffer.cellsPerRange = std::max<std::size_t>(1, (_cellsAttr.size() + nbRanges - 1) / nbRanges);
+        buffer.ranges.resize(nbRanges);
+    }
+    const int nbVertices = _verticesAttr.size();
+    const int batchSize = deterministic ? 1000 * nbThreads : nbVertices;
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
     int64_t avStepsBehind = 0;
     int64_t nAvStepsBehind = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); ++i)
+    for(int batchStart = 0; batchStart < nbVertices; batchStart += batchSize)
     {
-        int vi = (*vetexesToProcessIdsRand)[i];
-        GC_vertexInfo& v = _verticesAttr[vi];
-        if(v.isVirtual())
-            continue;
+        const int batchEnd = std::min(batchStart + batchSize, nbVertices);
 
-        const Point3d& po = _verticesCoords[vi];
-        for(int c = 0; c < v.cams.size(); ++c)
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind)
+        for(int i = batchStart; i < batchEnd; ++i)
         {
-            int nstepsFront = 0;
-            int nstepsBehind = 0;
+            int vi = deterministic ? i : (*vetexesToProcessIdsRand)[i];
+            GC_vertexInfo& v = _verticesAttr[vi];
+            if(v.isVirtual())
+                continue;
+            if(deterministic)
+                buffers[omp_get_thread_num()].order = i;
 
-            int cam = v.cams[c];
-            float maxDist = 0.0f;
-            if(fixesSigma)
-            {
-                maxDist = nPixelSizeBehind;
-            }
-            else
+            const Point3d& po = _verticesCoords[vi];
+            for(int c = 0; c < v.cams.size(); ++c)
             {
-                maxDist = nPixelSizeBehind * mp->getCamPixelSize(po, cam);
-            }
-
-            float minJump = 10000000.0f;
-            float minSilent = 10000000.0f;
-            float maxJump = 0.0f;
-            float maxSilent = 0.0f;
-            float midSilent = 10000000.0f;
+                int nstepsFront = 0;
+                int nstepsBehind = 0;
 
-            {
-                CellIndex ci = getFacetInFrontVertexOnTheRayToTheCam(vi, cam).cellIndex;
-                Point3d p = po; // HAS TO BE HERE !!!
-                bool ok = (ci != GEO::NO_CELL);
-                while(ok)
+                int cam = v.cams[c];
+                float maxDist = 0.0f;
+                if(fixesSigma)
+                {
+                    maxDist = nPixelSizeBehind;
+                }
+                else
                 {
-                    ++nstepsFront;
+                    maxDist = nPixelSizeBehind * mp->getCamPixelSize(po, cam);
+                }
 
-                    const GC_cellInfo& c = _cellsAttr[ci];
-                    if((p - po).size() > nsigmaFrontSilentPart * maxDist) // (p-po).size() > 2 * sigma
-                    {
-                        minJump = std::min(minJump, c.out);
-                        maxJump = std::max(maxJump, c.out);
-                    }
-                    else
-                    {
-                        minSilent = std::min(minSilent, c.out);
-                        maxSilent = std::max(maxSilent, c.out);
-                    }
+                float minJump = 10000000.0f;
+                float minSilent = 10000000.0f;
+                float maxJump = 0.0f;
+                float maxSilent = 0.0f;
+                float midSilent = 10000000.0f;
 
-                    Facet f1, f2;
-                    Point3d lpi;
-                    // find cell which is nearest to the cam and which intersect cam-p ray
-                    if(((p - po).size() > (nsigmaJumpPart + nsigmaFrontSilentPart) * maxDist) || // (2 + 2) * sigma
-                       (!nearestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi)))
-                    {
-                        ok = false;
-                    }
-                    else
+                {
+                    CellIndex ci = getFacetInFrontVertexOnTheRayToTheCam(vi, cam).cellIndex;
+                    Point3d p = po; // HAS TO BE HERE !!!
+                    bool ok = (ci != GEO::NO_CELL);
+                    while(ok)
                     {
-                        if(f2.cellIndex == GEO::NO_CELL)
+                        ++nstepsFront;
+
+                        const GC_cellInfo& c = _cellsAttr[ci];
+                        if((p - po).size() > nsigmaFrontSilentPart * maxDist) // (p-po).size() > 2 * sigma
+                        {
+                            minJump = std::min(minJump, c.out);
+                            maxJump = std::max(maxJump, c.out);
+                        }
+                        else
+                        {
+                            minSilent = std::min(minSilent, c.out);
+                            maxSilent = std::max(maxSilent, c.out);
+                        }
+
+                        Facet f1, f2;
+                        Point3d lpi;
+                        // find cell which is nearest to the cam and which intersect cam-p ray
+                        if(((p - po).size() > (nsigmaJumpPart + nsigmaFrontSilentPart) * maxDist) || // (2 + 2) * sigma
+                           (!nearestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi)))
+                        {
                             ok = false;
-                        ci = f2.cellIndex;
+                        }
+                        else
+                        {
+                            if(f2.cellIndex == GEO::NO_CELL)
+                                ok = false;
+                            ci = f2.cellIndex;
+                        }
                     }
                 }
-            }
-
-            {
-                CellIndex ci = getFacetBehindVertexOnTheRayToTheCam(vi, cam).cellIndex; // T1
-                Point3d p = po; // HAS TO BE HERE !!!
-                bool ok = (ci != GEO::NO_CELL);
-                if(ok)
-                {
-                    midSilent = _cellsAttr[ci].out;
-                }
 
-                while(ok)
                 {
-                    nstepsBehind++;
-                    const GC_cellInfo& c = _cellsAttr[ci];
-
-                    minSilent = std::min(minSilent, c.out);
-                    maxSilent = std::max(maxSilent, c.out);
-
-                    Facet f1, f2;
-                    Point3d lpi;
-                    // find cell which is farest to the cam and which intersect cam-p ray
-                    if(((p - po).size() > nsigmaBackSilentPart * maxDist) || // (p-po).size() > 2 * sigma
-                       (!farestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi)))
+                    CellIndex ci = getFacetBehindVertexOnTheRayToTheCam(vi, cam).cellIndex; // T1
+                    Point3d p = po; // HAS TO BE HERE !!!
+                    bool ok = (ci != GEO::NO_CELL);
+                    if(ok)
                     {
-                        ok = false;
+                        midSilent = _cellsAttr[ci].out;
                     }
-                    else
+
+                    while(ok)
                     {
-                        if(f2.cellIndex == GEO::NO_CELL)
+                        nstepsBehind++;
+                        const GC_cellInfo& c = _cellsAttr[ci];
+
+                        minSilent = std::min(minSilent, c.out);
+                        maxSilent = std::max(maxSilent, c.out);
+
+                        Facet f1, f2;
+                        Point3d lpi;
+                        // find cell which is farest to the cam and which intersect cam-p ray
+                        if(((p - po).size() > nsigmaBackSilentPart * maxDist) || // (p-po).size() > 2 * sigma
+                           (!farestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi)))
+                        {
                             ok = false;
-                        ci = f2.cellIndex;
+                        }
+                        else
+                        {
+                            if(f2.cellIndex == GEO::NO_CELL)
+                                ok = false;
+                            ci = f2.cellIndex;
+                        }
                     }
-                }
 
-                if(ci != GEO::NO_CELL)
-                {
-                    // Equation 6 in paper
-                    //   (g / B) < k_rel
-                    //   (B - g) > k_abs
-                    //   g < k_outl
-
-                    // In the paper:
-                    // B (beta): max value before point p
-                    // g (gamma): mid-range score behind point p
-
-                    // In the code:
-                    // maxJump: max score of emptiness in all the tetrahedron along the line of sight between camera c and 2*sigma before p
-                    // midSilent: score of the next tetrahedron directly after p (called T1 in the paper)
-                    // maxSilent: max score of emptiness for the tetrahedron around the point p (+/- 2*sigma around p)
-
-                    if(
-                       (midSilent / maxJump < delta) && // (g / B) < k_rel              //// k_rel=0.1
-                       (maxJump - midSilent > minJumpPartRange) && // (B - g) > k_abs   //// k_abs=10000 // 1000 in the paper
-                       (maxSilent < maxSilentPartRange)) // g < k_outl                  //// k_outl=100  // 400 in the paper
-                        //(maxSilent-minSilent<maxSilentPartRange))
+                    if(ci != GEO::NO_CELL)
                     {
+                        // Equation 6 in paper
+                        //   (g / B) < k_rel
+                        //   (B - g) > k_abs
+                        //   g < k_outl
+
+                        // In the paper:
+                        // B (beta): max value before point p
+                        // g (gamma): mid-range score behind point p
+
+                        // In the code:
+                        // maxJump: max score of emptiness in all the tetrahedron along the line of sight between camera c and 2*sigma before p
+                        // midSilent: score of the next tetrahedron directly after p (called T1 in the paper)
+                        // maxSilent: max score of emptiness for the tetrahedron around the point p (+/- 2*sigma around p)
+
+                        if(
+                           (midSilent / maxJump < delta) && // (g / B) < k_rel              //// k_rel=0.1
+                           (maxJump - midSilent > minJumpPartRange) && // (B - g) > k_abs   //// k_abs=10000 // 1000 in the paper
+                           (maxSilent < maxSilentPartRange)) // g < k_outl                  //// k_outl=100  // 400 in the paper
+                            //(maxSilent-minSilent<maxSilentPartRange))
+                        {
+                            if(deterministic)
+                            {
+                                buffers[omp_get_thread_num()].add(ci, CellWeightUpdate::eOn, maxJump - midSilent);
+                            }
+                            else
+                            {
 #pragma OMP_ATOMIC_UPDATE
-                        _cellsAttr[ci].on += (maxJump - midSilent);
+                                _cellsAttr[ci].on += (maxJump - midSilent);
+                            }
+                        }
                     }
                 }
-            }
 
-            avStepsFront += nstepsFront;
-            aAvStepsFront += 1;
-            avStepsBehind += nstepsBehind;
-            nAvStepsBehind += 1;
+                avStepsFront += nstepsFront;
+                aAvStepsFront += 1;
+                avStepsBehind += nstepsBehind;
+                nAvStepsBehind += 1;
+            }
         }
+
+        applyCellWeightUpdates(buffers, true);
     }
 
     delete vetexesToProcessIdsRand;
@@ -2201,11 +2843,13 @@ void DelaunayGraphCut::graphCutPostProcessing()
     ALICEVISION_LOG_INFO("Graph cut post-processing.");
     invertFullStatusForSmallLabels();
 
-    StaticVector<CellIndex> toDoInverse;
-    toDoInverse.reserve(_cellIsFull.size());
+    // the cells to inverse are found in parallel, _cellIsFull is a std::vector<bool> so it is updated sequentially
+    std::vector<char> toDoInverse(_cellIsFull.size(), 0);
 
-    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
+    #pragma omp parallel for
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(_cellIsFull.size()); ++i)
     {
+        const CellIndex ci = static_cast<CellIndex>(i);
         int count = 0;
         for(int k = 0; k < 4; ++k)
         {
@@ -2214,13 +2858,12 @@ void DelaunayGraphCut::graphCutPostProcessing()
                 continue;
             count += (_cellIsFull[nci] != _cellIsFull[ci]);
         }
-        if(count > 2)
-            toDoInverse.push_back(ci);
+        toDoInverse[ci] = (count > 2);
     }
-    for(std::size_t i = 0; i < toDoInverse.size(); ++i)
+    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
     {
-        CellIndex ci = toDoInverse[i];
-        _cellIsFull[ci] = !_cellIsFull[ci];
+        if(toDoInverse[ci])
+            _cellIsFull[ci] = !_cellIsFull[ci];
     }
     ALICEVISION_LOG_INFO("Graph cut post-processing done.");
 
@@ -2288,14 +2931,19 @@ void DelaunayGraphCut::freeUnwantedFullCells(const Point3d* hexah)
         ALICEVISION_LOG_DEBUG(nremoved << " removed cells outside hexahedron");
     }
 
-    if(doRemoveDust)
+    if(doRemoveDust || doLeaveLargestFullSegmentOnly)
     {
-        removeDust(minSegmentSize);
-    }
+        // a single segmentation: removing the dust frees whole full segments, the other ones are unchanged
+        CellsSegments segments;
+        segmentCells(false, segments);
 
-    if(doLeaveLargestFullSegmentOnly)
-    {
-        leaveLargestFullSegmentOnly();
+        if(doRemoveDust)
+            removeDust(minSegmentSize, segments);
+
+        if(doLeaveLargestFullSegmentOnly)
+            leaveLargestFullSegmentOnly(segments);
+
+        setIsOnSurface();
     }
 }
 
@@ -2304,69 +2952,23 @@ void DelaunayGraphCut::invertFullStatusForSmallLabels()
     ALICEVISION_LOG_DEBUG("filling small holes");
 
     const std::size_t nbCells = _cellIsFull.size();
-    StaticVector<int>* colorPerCell = new StaticVector<int>();
-    colorPerCell->reserve(nbCells);
-    colorPerCell->resize_with(nbCells, -1);
-
-    StaticVector<int>* nbCellsPerColor = new StaticVector<int>();
-    nbCellsPerColor->reserve(100);
-    nbCellsPerColor->resize_with(1, 0);
-    int lastColorId = 0;
-
-    StaticVector<CellIndex>* buff = new StaticVector<CellIndex>();
-    buff->reserve(nbCells);
-
-    for(CellIndex ci = 0; ci < nbCells; ++ci)
-    {
-        if((*colorPerCell)[ci] == -1)
-        {
-            // backtrack all connected interior cells
-            buff->resize(0);
-            buff->push_back(ci);
-
-            (*colorPerCell)[ci] = lastColorId;
-            (*nbCellsPerColor)[lastColorId] += 1;
-
-            while(buff->size() > 0)
-            {
-                CellIndex tmp_ci = buff->pop();
-
-                for(int k = 0; k < 4; ++k)
-                {
-                    const CellIndex nci = _tetrahedralization->cell_adjacent(tmp_ci, k);
-                    if(nci == GEO::NO_CELL)
-                        continue;
-                    if(((*colorPerCell)[nci] == -1) && (_cellIsFull[nci] == _cellIsFull[ci]))
-                    {
-                        (*colorPerCell)[nci] = lastColorId;
-                        (*nbCellsPerColor)[lastColorId] += 1;
-                        buff->push_back(nci);
-                    }
-                }
-            }
-            nbCellsPerColor->push_back(0); // add new color with 0 cell
-            ++lastColorId;
-            assert(lastColorId == nbCellsPerColor->size() - 1);
-        }
-    }
-    assert((*nbCellsPerColor)[nbCellsPerColor->size()-1] == 0);
-    nbCellsPerColor->resize(nbCellsPerColor->size()-1); // remove last empty element
+    CellsSegments segments;
+    segmentCells(true, segments);
 
+    int nbSegments = 0;
     int nfilled = 0;
     for(CellIndex ci = 0; ci < nbCells; ++ci)
     {
-        if((*nbCellsPerColor)[(*colorPerCell)[ci]] < 100)
+        const CellIndex segment = segments.segments[ci];
+        nbSegments += (segment == ci);
+        if(segments.sizes[segment] < 100)
         {
             _cellIsFull[ci] = !_cellIsFull[ci];
             ++nfilled;
         }
     }
 
-    ALICEVISION_LOG_DEBUG("Full number of cells: " << nbCells << ", Number of labels: " << nbCellsPerColor->size() << ", Number of cells changed: " << nfilled);
-
-    delete nbCellsPerColor;
-    delete colorPerCell;
-    delete buff;
+    ALICEVISION_LOG_DEBUG("Full number of cells: " << nbCells << ", Number of labels: " << nbSegments << ", Number of cells changed: " << nfilled);
 }
 
 void DelaunayGraphCut::reconstructVoxel(Point3d hexah[8], StaticVector<int>* voxelsIds, const std::string& folderName,
@@ -2477,9 +3079,26 @@ void DelaunayGraphCut::maxflow()
     long t_maxflow = clock();
 
     ALICEVISION_LOG_INFO("Maxflow: start allocation.");
-    // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
-    MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+    if(mp->_ini.get<bool>("delaunaycut.parallelMaxflow", false))
+    {
+        MaxFlow_PushRelabel maxFlowGraph(_cellsAttr.size());
+        maxflow(maxFlowGraph);
+    }
+    else
+    {
+        // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
+        MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+        maxflow(maxFlowGraph);
+    }
+
+    mvsUtils::printfElapsedTime(t_maxflow, "Full maxflow step");
+
+    ALICEVISION_LOG_INFO("Maxflow: done.");
+}
 
+template <typename MaxFlowGraph>
+void DelaunayGraphCut::maxflow(MaxFlowGraph& maxFlowGraph)
+{
     ALICEVISION_LOG_INFO("Maxflow: add nodes.");
     // fill s-t edges
     for(CellIndex ci = 0; ci < _cellsAttr.size(); ++ci)
@@ -2551,10 +3170,7 @@ void DelaunayGraphCut::maxflow()
     {
         _cellIsFull[ci] = maxFlowGraph.isTarget(ci);
     }
-
-    mvsUtils::printfElapsedTime(t_maxflow, "Full maxflow step");
-
-    ALICEVISION_LOG_INFO("Maxflow: done.");
+    updateMemoryCounter();
 }
 
 void DelaunayGraphCut::reconstructExpetiments(const StaticVector<int>& cams, const std::string& folderName,
@@ -2847,72 +3463,73 @@ mesh::Mesh* DelaunayGraphCut::createMesh(bool filterHelperPointsTriangles)
     return me;
 }
 
-void DelaunayGraphCut::segmentFullOrFree(bool full, StaticVector<int>** out_fullSegsColor, int& out_nsegments)
+void DelaunayGraphCut::segmentCells(bool withInfiniteCells, CellsSegments& out_segments) const
 {
-    ALICEVISION_LOG_DEBUG("segmentFullOrFree: segmenting connected space.");
+    ALICEVISION_LOG_DEBUG("segmentCells: segmenting connected full and free spaces.");
 
-    StaticVector<int>* colors = new StaticVector<int>();
-    colors->reserve(_cellIsFull.size());
-    colors->resize_with(_cellIsFull.size(), -1);
+    const std::size_t nbCells = _cellIsFull.size();
 
-    StaticVector<CellIndex>* buff = new StaticVector<CellIndex>();
-    buff->reserve(_cellIsFull.size());
-    int col = 0;
+    // the adjacency is stored by the tetrahedralization, so it can be read concurrently
+    stl::concurrent_union_find<CellIndex> universe(nbCells);
 
-    // segment connected free space
-    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(nbCells); ++i)
     {
-        if((!isInfiniteCell(ci)) && ((*colors)[ci] == -1) && (_cellIsFull[ci] == full))
-        {
-            // backtrack all connected interior cells
-            buff->resize(0);
-            buff->push_back(ci);
-
-            while(buff->size() > 0)
-            {
-                CellIndex tmp_ci = buff->pop();
-
-                (*colors)[tmp_ci] = col;
+        const CellIndex ci = static_cast<CellIndex>(i);
+        if(!withInfiniteCells && isInfiniteCell(ci))
+            continue;
 
-                for(int k = 0; k < 4; ++k)
-                {
-                    const CellIndex nci = _tetrahedralization->cell_adjacent(tmp_ci, k);
-                    if(nci == GEO::NO_CELL)
-                        continue;
-                    if((!isInfiniteCell(nci)) && ((*colors)[nci] == -1) &&
-                       (_cellIsFull[nci] == full))
-                    {
-                        buff->push_back(nci);
-                    }
-                }
-            }
-            ++col;
+        for(int k = 0; k < 4; ++k)
+        {
+            const CellIndex nci = _tetrahedralization->cell_adjacent(ci, k);
+            // ci < nci to join each facet once
+            if(nci == GEO::NO_CELL || nci < ci || (!withInfiniteCells && isInfiniteCell(nci)))
+                continue;
+            if(_cellIsFull[nci] == _cellIsFull[ci])
+                universe.join(ci, nci);
         }
     }
 
-    delete buff;
+    // segment sizes, the root of each segment is its smallest cell index
+    std::vector<CellIndex>& segments = out_segments.segments;
+    std::vector<int>& sizes = out_segments.sizes;
+    segments.resize(nbCells);
+    sizes.assign(nbCells, 0);
 
-    *out_fullSegsColor = colors;
-    out_nsegments = col;
+    #pragma omp parallel for
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(nbCells); ++i)
+    {
+        const CellIndex ci = static_cast<CellIndex>(i);
+        if(!withInfiniteCells && isInfiniteCell(ci))
+        {
+            segments[ci] = GEO::NO_CELL;
+            continue;
+        }
+        const CellIndex root = universe.find(ci);
+        segments[ci] = root;
+        OMP_ATOMIC_UPDATE
+        ++sizes[root];
+    }
 }
 
 int DelaunayGraphCut::removeBubbles()
 {
-    int nbEmptySegments = 0;
-    StaticVector<int>* emptySegColors = nullptr;
-    segmentFullOrFree(false, &emptySegColors, nbEmptySegments);
+    CellsSegments segments;
+    segmentCells(false, segments);
 
     ALICEVISION_LOG_DEBUG("removing bubbles.");
 
-    StaticVectorBool* colorsToFill = new StaticVectorBool();
-    colorsToFill->reserve(nbEmptySegments);
+    const std::size_t nbCells = _cellIsFull.size();
+
     // all free space segments which contains camera has to remain free all others full
-    colorsToFill->resize_with(nbEmptySegments, true);
+    std::vector<char> segmentsToKeepFree(nbCells, 0);
 
-    // all free space segments which contains camera has to remain free
-    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
+    #pragma omp parallel for
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(nbCells); ++i)
     {
-        if(isInfiniteCell(ci) || (*emptySegColors)[ci] < 0)
+        const CellIndex ci = static_cast<CellIndex>(i);
+        const CellIndex segment = segments.segments[ci];
+        if(segment == GEO::NO_CELL || _cellIsFull[ci])
             continue;
 
         const GC_vertexInfo& a = _verticesAttr[_tetrahedralization->cell_vertex(ci, 0)];
@@ -2922,30 +3539,27 @@ int DelaunayGraphCut::removeBubbles()
         if( a.isVirtual() || b.isVirtual() || c.isVirtual() || d.isVirtual())
         {
             // TODO FACA: check helper points are not connected to cameras?
-            (*colorsToFill)[(*emptySegColors)[ci]] = false;
+            OMP_ATOMIC_WRITE
+            segmentsToKeepFree[segment] = 1;
         }
     }
 
+    int nbEmptySegments = 0;
     int nbubbles = 0;
-    for(int i = 0; i < nbEmptySegments; ++i)
+    for(CellIndex ci = 0; ci < nbCells; ++ci)
     {
-        if((*colorsToFill)[i])
+        const CellIndex segment = segments.segments[ci];
+        if(segment == GEO::NO_CELL || _cellIsFull[ci])
+            continue;
+        if(segment == ci)
         {
-            ++nbubbles;
+            ++nbEmptySegments;
+            nbubbles += !segmentsToKeepFree[segment];
         }
-    }
-
-    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
-    {
-        if((!isInfiniteCell(ci)) && ((*emptySegColors)[ci] >= 0) && ((*colorsToFill)[(*emptySegColors)[ci]]))
-        {
+        if(!segmentsToKeepFree[segment])
             _cellIsFull[ci] = true;
-        }
     }
 
-    delete colorsToFill;
-    delete emptySegColors;
-
     ALICEVISION_LOG_DEBUG("nbubbles: " << nbubbles << ", all empty segments: " << nbEmptySegments);
 
     setIsOnSurface();
@@ -2955,89 +3569,77 @@ int DelaunayGraphCut::removeBubbles()
 
 int DelaunayGraphCut::removeDust(int minSegSize)
 {
-    ALICEVISION_LOG_DEBUG("removing dust.");
+    CellsSegments segments;
+    segmentCells(false, segments);
 
-    int nbFullSegments = 0;
-    StaticVector<int>* fullSegsColor = nullptr;
-    segmentFullOrFree(true, &fullSegsColor, nbFullSegments);
+    const int ndust = removeDust(minSegSize, segments);
 
-    StaticVector<int>* colorsSize = new StaticVector<int>();
-    colorsSize->reserve(nbFullSegments);
-    colorsSize->resize_with(nbFullSegments, 0);
+    setIsOnSurface();
 
-    // all free space segments which contains camera has to remain free
-    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
-    {
-        if((*fullSegsColor)[ci] >= 0) // if we have a valid color: non empty and non infinit cell
-        {
-            (*colorsSize)[(*fullSegsColor)[ci]] += 1; // count the number of cells in the segment
-        }
-    }
+    return ndust;
+}
+
+int DelaunayGraphCut::removeDust(int minSegSize, const CellsSegments& segments)
+{
+    ALICEVISION_LOG_DEBUG("removing dust.");
 
+    int nbFullSegments = 0;
     int ndust = 0;
     for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
     {
+        const CellIndex segment = segments.segments[ci];
+        // if we have a valid segment: full and non infinite cell
+        if(segment == GEO::NO_CELL || !_cellIsFull[ci])
+            continue;
+        nbFullSegments += (segment == ci);
         // if number of cells in the segment is too small, we change the status to "empty"
-        if(((*fullSegsColor)[ci] >= 0) && ((*colorsSize)[(*fullSegsColor)[ci]] < minSegSize))
+        if(segments.sizes[segment] < minSegSize)
         {
             _cellIsFull[ci] = false;
             ++ndust;
         }
     }
 
-    delete colorsSize;
-    delete fullSegsColor;
-
     ALICEVISION_LOG_DEBUG("Removed dust cells: " << ndust << ", Number of segments: " << nbFullSegments);
 
-    setIsOnSurface();
-
     return ndust;
 }
 
 void DelaunayGraphCut::leaveLargestFullSegmentOnly()
 {
-    ALICEVISION_LOG_DEBUG("Largest full segment only.");
+    CellsSegments segments;
+    segmentCells(false, segments);
 
-    int nsegments;
-    StaticVector<int>* colors = nullptr;
-    segmentFullOrFree(true, &colors, nsegments);
+    leaveLargestFullSegmentOnly(segments);
+
+    setIsOnSurface();
+}
 
-    StaticVector<int>* colorsSize = new StaticVector<int>();
-    colorsSize->reserve(nsegments);
-    colorsSize->resize_with(nsegments, 0);
+void DelaunayGraphCut::leaveLargestFullSegmentOnly(const CellsSegments& segments)
+{
+    ALICEVISION_LOG_DEBUG("Largest full segment only.");
 
-    // all free space segments which contains camera has to remain free
-    int largestColor = -1;
+    // the full segments are the segments of the cells still full
+    CellIndex largestSegment = GEO::NO_CELL;
     int maxn = 0;
     for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
     {
-        int color = (*colors)[ci];
-        if(color >= 0)
+        const CellIndex segment = segments.segments[ci];
+        if(segment == ci && _cellIsFull[ci] && segments.sizes[segment] > maxn)
         {
-            (*colorsSize)[color] += 1;
-            int n = (*colorsSize)[color];
-            if(n > maxn)
-            {
-                maxn = n;
-                largestColor = color;
-            }
+            maxn = segments.sizes[segment];
+            largestSegment = segment;
         }
     }
 
     for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
     {
-        if((*colors)[ci] != largestColor)
+        if(segments.segments[ci] != largestSegment)
         {
             _cellIsFull[ci] = false;
         }
     }
 
-    delete colorsSize;
-    delete colors;
-
-    setIsOnSurface();
-
     ALICEVISION_LOG_DEBUG("Largest full segment only done.");
 }
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
@@ -22,6 +23,7 @@
 #include <geogram/mesh/mesh.h>
 #include <geogram/basic/geometry_nd.h>
 
+#include <cstdint>
 #include <map>
 #include <set>
 
@@ -46,9 +48,15 @@ struct FuseParams
     float voteMarginFactor = 4.0f;
     float contributeMarginFactor = 2.0f;
     float simGaussianSizeInit = 10.0f;
+    /// Unused: the similarity maps don't change the visibilities
     float simGaussianSize = 10.0f;
     double minAngleThreshold = 0.1;
     bool refineFuse = true;
+    /// Filter the points by pixel size as the depth maps are loaded (by batch of cameras) instead of after loading all of them,
+    /// the memory is bounded by the num. of kept points
+    bool streamingFuse = false;
+    /// Num. of cameras loaded in parallel per batch with streamingFuse
+    int nbCamerasPerBatch = 3;
 };
 
 
@@ -71,6 +79,57 @@ public:
         VertexIndex localVertexIndex = GEO::NO_VERTEX;
     };
 
+    /// Weight contribution of a ray to a cell, see CellWeightUpdatesBuffer
+    struct CellWeightUpdate
+    {
+        enum EField : std::uint8_t
+        {
+            eOut,
+            eIn,
+            eOn,
+            eCellSWeight,
+            eCellTWeight,
+            eGEdgeVisWeight
+        };
+
+        CellIndex cellIndex;
+        std::uint8_t field;
+        /// local vertex index of the facet for eGEdgeVisWeight
+        std::uint8_t localVertexIndex;
+        float value;
+        /// index of the contribution in the serial order, for the ordered merge of the deterministic mode
+        std::uint32_t order;
+    };
+
+    /**
+     * @brief Per-thread buffer of the cell weight contributions of the rays, bucketed by ranges of cells.
+     *
+     * Each range of cells is then applied by a single thread, so no atomic is needed on _cellsAttr.
+     */
+    struct CellWeightUpdatesBuffer
+    {
+        std::size_t cellsPerRange = 1;
+        std::vector<std::vector<CellWeightUpdate>> ranges;
+        /// serial order of the next contributions (e.g. the index of the processed vertex)
+        std::uint32_t order = 0;
+
+        inline void add(CellIndex ci, CellWeightUpdate::EField field, float value, VertexIndex lvi = 0)
+        {
+            ranges[ci / cellsPerRange].push_back({ci, static_cast<std::uint8_t>(field), static_cast<std::uint8_t>(lvi), value, order});
+        }
+    };
+
+    /**
+     * @brief Connected segments of the cells with the same status (full or free), see segmentCells
+     */
+    struct CellsSegments
+    {
+        /// segment of each cell: the smallest cell index of the segment, GEO::NO_CELL for the ignored infinite cells
+        std::vector<CellIndex> segments;
+        /// number of cells of each segment, indexed by the segment
+        std::vector<int> sizes;
+    };
+
     mvsUtils::MultiViewParams* mp;
     mvsUtils::PreMatchCams* pc;
 
@@ -85,7 +144,12 @@ public:
     std::vector<bool> _cellIsFull;
 
     std::vector<int> _camsVertexes;
-    std::vector<std::vector<CellIndex>> _neighboringCellsPerVertex;
+    /// Neighboring cells of all vertices, the cells of vertex vi are in [offsets[vi], offsets[vi+1])
+    std::vector<CellIndex> _neighboringCellsPerVertex;
+    std::vector<std::size_t> _neighboringCellsPerVertexOffsets;
+
+    /// Estimated size of the tetrahedralization and of the attributes, for the system::MemoryAccounting
+    system::MemoryCounter _memoryCounter{"fuseCut.delaunayGraphCut"};
 
     bool saveTemporaryBinFiles;
 
@@ -183,36 +247,15 @@ public:
         return out;
     }
 
-    void updateVertexToCellsCache()
-    {
-        _neighboringCellsPerVertex.clear();
+    /**
+     * @brief Build the neighboring cells of each vertex (CSR layout, cells sorted by index)
+     */
+    void updateVertexToCellsCache();
 
-        std::map<VertexIndex, std::set<CellIndex>> neighboringCellsPerVertexTmp;
-        int coutInvalidVertices = 0;
-        for(CellIndex ci = 0, nbCells = _tetrahedralization->nb_cells(); ci < nbCells; ++ci)
-        {
-            for(VertexIndex k = 0; k < 4; ++k)
-            {
-                CellIndex vi = _tetrahedralization->cell_vertex(ci, k);
-                if(vi == GEO::NO_VERTEX || vi >= _verticesCoords.size())
-                {
-                    ++coutInvalidVertices;
-                    continue;
-                }
-                neighboringCellsPerVertexTmp[vi].insert(ci);
-            }
-        }
-        ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
-        ALICEVISION_LOG_INFO("neighboringCellsPerVertexTmp: " << neighboringCellsPerVertexTmp.size());
-        _neighboringCellsPerVertex.resize(_verticesCoords.size());
-        ALICEVISION_LOG_INFO("verticesCoords: " << _verticesCoords.size());
-        for(const auto& it: neighboringCellsPerVertexTmp)
-        {
-            const std::set<CellIndex>& input = it.second;
-            std::vector<CellIndex>& output = _neighboringCellsPerVertex[it.first];
-            output.assign(input.begin(), input.end());
-        }
-    }
+    /**
+     * @brief Report the estimated memory of the tetrahedralization and of the attributes to the system::MemoryAccounting
+     */
+    void updateMemoryCounter();
 
     /**
      * @brief vertexToCells
@@ -225,10 +268,10 @@ public:
      */
     CellIndex vertexToCells(VertexIndex vi, int lvi) const
     {
-        const std::vector<CellIndex>& localCells = _neighboringCellsPerVertex.at(vi);
-        if(lvi >= localCells.size())
+        const std::size_t begin = _neighboringCellsPerVertexOffsets.at(vi);
+        if(lvi >= _neighboringCellsPerVertexOffsets[vi + 1] - begin)
             return GEO::NO_CELL;
-        return localCells[lvi];
+        return _neighboringCellsPerVertex[begin + lvi];
     }
 
     void initVertices();
@@ -289,9 +332,18 @@ public:
 
     virtual void fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool labatutWeights,
                            bool fillOut, float distFcnHeight = 0.0f);
-    void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam, float weight,
-                           bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
-                           float distFcnHeight);
+    void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, CellWeightUpdatesBuffer& updates,
+                           int vertexIndex, int cam, float weight, bool fixesSigma, float nPixelSizeBehind,
+                           bool allPoints, bool behind, bool fillOut, float distFcnHeight);
+    /**
+     * @brief Apply the buffered contributions of all threads to _cellsAttr (one thread per range of cells) and clear them
+     * @param[in,out] buffers The per-thread buffers
+     * @param[in] ordered Merge the contributions of each range in their serial order, so the floating-point sums
+     *                    don't depend on the thread scheduling (deterministic mode)
+     */
+    void applyCellWeightUpdates(std::vector<CellWeightUpdatesBuffer>& buffers, bool ordered = false);
+    /// Sort vertices by the Morton code of their coordinates (Z-order curve in their bounding box)
+    void sortVerticesInMortonOrder(std::vector<int>& verticesIndexes) const;
 
     void forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind);
     void forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSizeBehind);
@@ -310,6 +362,9 @@ public:
     void reconstructGC(const Point3d* hexah);
 
     void maxflow();
+    /// Fill the graph from the cells weights, compute the cut and set _cellIsFull (MaxFlow_AdjList, MaxFlow_CSR or MaxFlow_PushRelabel)
+    template <typename MaxFlowGraph>
+    void maxflow(MaxFlowGraph& maxFlowGraph);
 
     void reconstructExpetiments(const StaticVector<int>& cams, const std::string& folderName,
                                 bool update, Point3d hexahInflated[8], const std::string& tmpCamsPtsFolderName,
@@ -332,10 +387,20 @@ public:
     void clearOutAddIn();
     StaticVector<int>* getNearestTrisFromMeshTris(mesh::Mesh* otherMesh);
 
-    void segmentFullOrFree(bool full, StaticVector<int>** inColors, int& nsegments);
+    /**
+     * @brief Label the connected segments of the full cells and of the free cells in a single pass,
+     *        in parallel with a concurrent union-find over the cell adjacency.
+     * @param[in] withInfiniteCells segment the infinite cells too, else they are ignored
+     * @param[out] out_segments the segment of each cell and the segment sizes
+     */
+    void segmentCells(bool withInfiniteCells, CellsSegments& out_segments) const;
     int removeBubbles();
     int removeDust(int minSegSize);
     void leaveLargestFullSegmentOnly();
+    /// Remove the full segments smaller than minSegSize, the other full segments are unchanged
+    int removeDust(int minSegSize, const CellsSegments& segments);
+    /// Free the cells out of the largest full segment, the segments may be labelled before removeDust
+    void leaveLargestFullSegmentOnly(const CellsSegments& segments);
 
     mesh::Mesh* createMesh(bool filterHelperPointsTriangles = true);
 };
@@ -0,0 +1,117 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DepthMapsCache.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace fuseCut {
+
+DepthMapsCache::DepthMapsCache(const mvsUtils::MultiViewParams* mp)
+  : _mp(mp)
+{
+    // memory budget, large enough for the rc and tc depth maps in use by each thread
+    const float oneDepthMapMB = (sizeof(float) * _mp->getMaxImageWidth() * _mp->getMaxImageHeight()) / 1024.f / 1024.f;
+    const float maxMB = std::max((float)_mp->_ini.get<int>("fuse.depthMapsCacheMaxMB", 4000),
+                                 oneDepthMapMB * 2 * omp_get_max_threads());
+    _maxBytes = static_cast<std::size_t>(maxMB * 1024.0 * 1024.0);
+
+    _depthMaps.resize(_mp->ncams);
+
+    ALICEVISION_LOG_DEBUG("DepthMapsCache: memory budget: " << maxMB << " MB.");
+}
+
+DepthMapsCache::~DepthMapsCache()
+{
+    ALICEVISION_LOG_INFO("DepthMapsCache: " << _nbHits << " hits, " << _nbMisses << " misses.");
+}
+
+bool DepthMapsCache::freeMemory(std::size_t nbBytes)
+{
+    while(_usedBytes + nbBytes > _maxBytes)
+    {
+        // least recently used depth map not referenced outside of the cache
+        int lruCamId = -1;
+        for(int c = 0; c < _depthMaps.size(); ++c)
+        {
+            const CachedDepthMap& cached = _depthMaps[c];
+            if(!cached.depthMap || cached.depthMap.use_count() > 1)
+                continue;
+            if(lruCamId == -1 || cached.lastUse < _depthMaps[lruCamId].lastUse)
+                lruCamId = c;
+        }
+        if(lruCamId == -1)
+            return false;
+
+        _usedBytes -= sizeof(float) * _depthMaps[lruCamId].depthMap->size();
+        _depthMaps[lruCamId].depthMap.reset();
+    }
+    return true;
+}
+
+DepthMapsCache::DepthMapSharedPtr DepthMapsCache::getDepthMap_sync(int camId)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    CachedDepthMap& cached = _depthMaps.at(camId);
+
+    if(cached.depthMap)
+    {
+        ++_nbHits;
+        cached.lastUse = ++_clock;
+        return cached.depthMap;
+    }
+
+    ++_nbMisses;
+
+    // read by another thread
+    while(cached.isLoading)
+        _depthMapLoaded.wait(lock);
+
+    if(cached.depthMap)
+    {
+        cached.lastUse = ++_clock;
+        return cached.depthMap;
+    }
+
+    cached.isLoading = true;
+    lock.unlock();
+
+    std::shared_ptr<std::vector<float>> depthMap = std::make_shared<std::vector<float>>();
+    try
+    {
+        int width, height;
+        imageIO::readImage(mv_getFileName(_mp, camId, mvsUtils::EFileType::depthMap, 1), width, height, *depthMap);
+        imageIO::transposeImage(width, height, *depthMap);
+    }
+    catch(...)
+    {
+        lock.lock();
+        cached.isLoading = false;
+        _depthMapLoaded.notify_all();
+        throw;
+    }
+
+    const std::size_t nbBytes = sizeof(float) * depthMap->size();
+
+    lock.lock();
+    // depth maps in use can't be evicted, go over the budget rather than fail
+    freeMemory(nbBytes);
+    _usedBytes += nbBytes;
+    cached.depthMap = depthMap;
+    cached.isLoading = false;
+    cached.lastUse = ++_clock;
+    _depthMapLoaded.notify_all();
+    return cached.depthMap;
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,71 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Thread safe cache of the full resolution depth maps in RAM, shared by the threads of the depth map filtering.
+ *
+ * The depth maps are stored transposed (x * height + y), as used by the Fuser.
+ * They are evicted in least recently used order to stay under a memory budget (fuse.depthMapsCacheMaxMB),
+ * depth maps still referenced by a caller are never evicted.
+ */
+class DepthMapsCache
+{
+public:
+    typedef std::shared_ptr<const std::vector<float>> DepthMapSharedPtr;
+
+    explicit DepthMapsCache(const mvsUtils::MultiViewParams* mp);
+    ~DepthMapsCache();
+
+    /**
+     * @brief Get the depth map of a camera, load it if needed (blocking).
+     * @note The depth map stays in memory as long as the returned pointer is alive.
+     * @param[in] camId The camera index
+     * @return the depth map
+     */
+    DepthMapSharedPtr getDepthMap_sync(int camId);
+
+private:
+    struct CachedDepthMap
+    {
+        std::shared_ptr<std::vector<float>> depthMap;
+        long lastUse = 0;
+        bool isLoading = false;
+    };
+
+    /**
+     * @brief Evict the least recently used depth maps not referenced outside of the cache
+     *        until the given size fits the memory budget.
+     * @return false if the size doesn't fit
+     */
+    bool freeMemory(std::size_t nbBytes);
+
+    const mvsUtils::MultiViewParams* _mp;
+
+    std::vector<CachedDepthMap> _depthMaps;
+    std::size_t _maxBytes = 0;
+    std::size_t _usedBytes = 0;
+    long _clock = 0;
+    long _nbHits = 0;
+    long _nbMisses = 0;
+
+    std::mutex _mutex;
+    std::condition_variable _depthMapLoaded;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
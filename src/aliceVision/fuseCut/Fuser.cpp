@@ -19,6 +19,7 @@
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace aliceVision {
@@ -60,6 +61,7 @@ unsigned long computeNumberOfAllPoints(const mvsUtils::MultiViewParams* mp, int
 Fuser::Fuser(const mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc)
   : mp(_mp)
   , pc(_pc)
+  , _depthMapsCache(new DepthMapsCache(_mp))
 {
 }
 
@@ -82,8 +84,8 @@ Fuser::~Fuser()
  * @param[in] scale
  */
 bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc, int tc,
-                           StaticVector<int>* numOfPtsMap, StaticVector<float>* depthMap, StaticVector<float>* simMap,
-                           int scale)
+                           StaticVector<int>* numOfPtsMap, const std::vector<float>& depthMap,
+                           const std::vector<float>& simMap, int scale)
 {
     int w = mp->getWidth(rc) / scale;
     int h = mp->getHeight(rc) / scale;
@@ -103,7 +105,7 @@ bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc
 
     int d = pixSizeBall;
 
-    float sim = (*simMap)[cell.x * h + cell.y];
+    float sim = simMap[cell.x * h + cell.y];
     if(sim >= 1.0f)
     {
         d = pixSizeBallWSP;
@@ -118,7 +120,7 @@ bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc
         for(ncell.y = std::max(0, cell.y - d); ncell.y <= std::min(h - 1, cell.y + d); ncell.y++)
         {
             // printf("%i %i %i %i %i %i %i %i\n",ncell.x,ncell.y,w,h,w*h,depthMap->size(),cam,scale);
-            float depth = (*depthMap)[ncell.x * h + ncell.y];
+            float depth = depthMap[ncell.x * h + ncell.y];
             // Point3d p1 = mp->CArr[rc] +
             // (mp->iCamArr[rc]*Point2d((float)ncell.x*(float)scale,(float)ncell.y*(float)scale)).normalize()*depth;
             // if ( (p1-p).size() < pixSize ) {
@@ -137,7 +139,8 @@ void Fuser::filterGroups(const StaticVector<int>& cams, int pixSizeBall, int pix
 {
     ALICEVISION_LOG_INFO("Precomputing groups.");
     long t1 = clock();
-#pragma omp parallel for
+    // dynamic: the threads work on consecutive rcs, which share most of their nearest cameras in the depth maps cache
+#pragma omp parallel for schedule(dynamic)
     for(int c = 0; c < cams.size(); c++)
     {
         int rc = cams[c];
@@ -159,17 +162,16 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
     int w = mp->getWidth(rc);
     int h = mp->getHeight(rc);
 
-    StaticVector<float> depthMap;
-    StaticVector<float> simMap;
+    // the rc depth map is also a tc depth map of its nearest cameras
+    const DepthMapsCache::DepthMapSharedPtr depthMapPtr = _depthMapsCache->getDepthMap_sync(rc);
+    const std::vector<float>& depthMap = *depthMapPtr;
+    std::vector<float> simMap;
 
     {
         int width, height;
 
-        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, 1), width, height, depthMap.getDataWritable());
-        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, 1), width, height, simMap.getDataWritable());
-
-        imageIO::transposeImage(width, height, depthMap.getDataWritable());
-        imageIO::transposeImage(width, height, simMap.getDataWritable());
+        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, 1), width, height, simMap);
+        imageIO::transposeImage(width, height, simMap);
     }
 
     std::vector<unsigned char> numOfModalsMap(w * h, 0);
@@ -191,23 +193,17 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
 
     for(int c = 0; c < tcams.size(); c++)
     {
-        numOfPtsMap->resize_with(w * h, 0);
+        // reset the counts of the previous tc (resize_with keeps the values of an already sized vector)
+        std::fill(numOfPtsMap->begin(), numOfPtsMap->end(), 0);
         int tc = tcams[c];
 
-        StaticVector<float> tcdepthMap;
-
-        {
-            int width, height;
-
-            imageIO::readImage(mv_getFileName(mp, tc, mvsUtils::EFileType::depthMap, 1), width, height, tcdepthMap.getDataWritable());
-
-            // transpose image in-place, width/height are no more valid after this function.
-            imageIO::transposeImage(width, height, tcdepthMap.getDataWritable());
-        }
+        // transposed, shared with the other threads
+        const DepthMapsCache::DepthMapSharedPtr tcdepthMapPtr = _depthMapsCache->getDepthMap_sync(tc);
+        const std::vector<float>& tcdepthMap = *tcdepthMapPtr;
 
         if(!tcdepthMap.empty())
         {
-            for(int i = 0; i < sizeOfStaticVector<float>(&tcdepthMap); i++)
+            for(int i = 0; i < static_cast<int>(tcdepthMap.size()); i++)
             {
                 int x = i / h;
                 int y = i % h;
@@ -215,7 +211,7 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
                 if(depth > 0.0f)
                 {
                     Point3d p = mp->CArr[tc] + (mp->iCamArr[tc] * Point2d((float)x, (float)y)).normalize() * depth;
-                    updateInSurr(pixSizeBall, pixSizeBallWSP, p, rc, tc, numOfPtsMap, &depthMap, &simMap, 1);
+                    updateInSurr(pixSizeBall, pixSizeBallWSP, p, rc, tc, numOfPtsMap, depthMap, simMap, 1);
                 }
             }
 
@@ -247,7 +243,7 @@ void Fuser::filterDepthMaps(const StaticVector<int>& cams, int minNumOfModals, i
     ALICEVISION_LOG_INFO("Filtering depth maps.");
     long t1 = clock();
 
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic)
     for(int c = 0; c < cams.size(); c++)
     {
         int rc = cams[c];
@@ -765,5 +761,10 @@ void deleteTempPtsSimsFiles(mvsUtils::MultiViewParams* mp, std::string depthMaps
     mvsUtils::DeleteDirectory(depthMapsPtsSimsTmpDir);
 }
 
+std::string getTempPtsSimsChunkFileName(const std::string& depthMapsPtsSimsTmpDir, int chunkId)
+{
+    return depthMapsPtsSimsTmpDir + "chunk" + std::to_string(chunkId) + "_ptsSims.bin";
+}
+
 } // namespace fuseCut
 } // namespace aliceVision
@@ -8,9 +8,11 @@
 
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
-#include <aliceVision/mvsData/Universe.hpp>
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/fuseCut/DepthMapsCache.hpp>
+
+#include <memory>
 
 namespace aliceVision {
 namespace fuseCut {
@@ -43,12 +45,26 @@ public:
 
 private:
     bool updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc, int tc, StaticVector<int>* numOfPtsMap,
-                      StaticVector<float>* depthMap, StaticVector<float>* simMap, int scale);
+                      const std::vector<float>& depthMap, const std::vector<float>& simMap, int scale);
+
+    /// depth maps shared by the threads of filterGroups, a tc is used by several rcs
+    std::unique_ptr<DepthMapsCache> _depthMapsCache;
+};
+
+/// A depth map point stored in the voxel chunks of the temporary pts/sims folder
+struct PtsSimsChunkItem
+{
+    Point3d p;
+    float sim;
+    int rc;
 };
 
 std::string generateTempPtsSimsFiles(std::string tmpDir, mvsUtils::MultiViewParams* mp, bool addRandomNoise = false,
                                      float percNoisePts = 0.0, int noisPixSizeDistHalfThr = 0);
 void deleteTempPtsSimsFiles(mvsUtils::MultiViewParams* mp, std::string depthMapsPtsSimsTmpDir);
 
+/// @brief Get the file of the points of all cameras falling in the given top-level voxel
+std::string getTempPtsSimsChunkFileName(const std::string& depthMapsPtsSimsTmpDir, int chunkId);
+
 } // namespace fuseCut
 } // namespace aliceVision
@@ -171,6 +171,9 @@ bool LargeScale::generateSpace(int maxPts, int ocTreeDim, bool generateTracks)
         std::string tmpdir = spaceFolderName + "tmp/";
         bfs::create_directory(tmpdir);
         VoxelsGrid* vg = new VoxelsGrid(dimensions, &space[0], mp, pc, tmpdir, doVisualize);
+        // read the depth maps points once instead of once per voxel
+        if(mp->_ini.get<bool>("LargeScale.usePtsSimsVoxelChunks", true))
+            vg->generatePtsSimsVoxelChunks(depthMapsPtsSimsTmpDir);
         int maxlevel = 0;
         vg->generateTracksForEachVoxel(ReconstructionPlan, maxOcTreeDim, maxPts, 1, maxlevel, depthMapsPtsSimsTmpDir);
         if(mp->verbose)
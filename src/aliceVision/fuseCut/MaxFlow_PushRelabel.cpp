@@ -0,0 +1,360 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlow_PushRelabel.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+template <typename T>
+inline void atomicAdd(std::atomic<T>& x, T value)
+{
+    T current = x.load(std::memory_order_relaxed);
+    while(!x.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+/// Concatenate the per-thread lists of nodes
+template <typename T>
+void mergeThreadsLists(std::vector<std::vector<T>>& threadsLists, std::vector<T>& output)
+{
+    output.clear();
+    for(std::vector<T>& list : threadsLists)
+    {
+        output.insert(output.end(), list.begin(), list.end());
+        list.clear();
+    }
+}
+
+} // namespace
+
+MaxFlow_PushRelabel::MaxFlow_PushRelabel(std::size_t numNodes)
+    : _numNodes(numNodes)
+    , _excess(numNodes, 0)
+    , _sinkResidual(numNodes, 0)
+{
+    ALICEVISION_LOG_INFO("MaxFlow constructor.");
+    _edges.reserve(numNodes * 4);
+}
+
+void MaxFlow_PushRelabel::buildArcs()
+{
+    // sequential to keep the same arcs order (so the same result) whatever the num. of threads
+    _arcsOffsets.assign(_numNodes + 1, 0);
+    for(const Edge& edge : _edges)
+    {
+        ++_arcsOffsets[edge.n1 + 1];
+        ++_arcsOffsets[edge.n2 + 1];
+    }
+    for(std::size_t n = 0; n < _numNodes; ++n)
+        _arcsOffsets[n + 1] += _arcsOffsets[n];
+
+    const std::size_t nbArcs = _arcsOffsets.back();
+    _arcsTarget.resize(nbArcs);
+    _arcsReverse.resize(nbArcs);
+    _arcsResidual = std::vector<std::atomic<ValueType>>(nbArcs);
+
+    std::vector<std::size_t> cursors(_arcsOffsets.begin(), _arcsOffsets.end() - 1);
+    for(const Edge& edge : _edges)
+    {
+        const std::size_t a = cursors[edge.n1]++;
+        const std::size_t reverseA = cursors[edge.n2]++;
+        _arcsTarget[a] = edge.n2;
+        _arcsReverse[a] = reverseA;
+        _arcsResidual[a].store(edge.capacity, std::memory_order_relaxed);
+        _arcsTarget[reverseA] = edge.n1;
+        _arcsReverse[reverseA] = a;
+        _arcsResidual[reverseA].store(edge.reverseCapacity, std::memory_order_relaxed);
+    }
+
+    std::vector<Edge>().swap(_edges); // force clear
+
+    ALICEVISION_LOG_INFO("# nodes: " << _numNodes << ", # arcs: " << nbArcs);
+}
+
+void MaxFlow_PushRelabel::globalRelabel()
+{
+    const int maxLabel = static_cast<int>(_numNodes) + 1;
+    std::vector<NodeType> frontier;
+
+    for(std::size_t n = 0; n < _numNodes; ++n)
+    {
+        if(_sinkResidual[n] > 0)
+        {
+            _labels[n] = 1;
+            _isDiscovered[n].store(true, std::memory_order_relaxed);
+            frontier.push_back(n);
+        }
+        else
+        {
+            _labels[n] = maxLabel;
+        }
+    }
+
+    std::vector<std::vector<NodeType>> threadsNext(omp_get_max_threads());
+
+    for(int label = 2; !frontier.empty(); ++label)
+    {
+#pragma omp parallel for schedule(dynamic, 256)
+        for(int i = 0; i < frontier.size(); ++i)
+        {
+            const NodeType w = frontier[i];
+            std::vector<NodeType>& next = threadsNext[omp_get_thread_num()];
+
+            for(std::size_t a = _arcsOffsets[w]; a < _arcsOffsets[w + 1]; ++a)
+            {
+                const NodeType v = _arcsTarget[a];
+                // residual arc from v to w
+                if(_arcsResidual[_arcsReverse[a]].load(std::memory_order_relaxed) <= 0)
+                    continue;
+                if(_isDiscovered[v].exchange(true, std::memory_order_relaxed))
+                    continue;
+                _labels[v] = label;
+                next.push_back(v);
+            }
+        }
+        mergeThreadsLists(threadsNext, frontier);
+    }
+
+#pragma omp parallel for
+    for(int n = 0; n < _numNodes; ++n)
+        _isDiscovered[n].store(false, std::memory_order_relaxed);
+}
+
+std::size_t MaxFlow_PushRelabel::dischargeRound(std::vector<NodeType>& workingSet)
+{
+    const int maxLabel = static_cast<int>(_numNodes) + 1;
+
+#pragma omp parallel for
+    for(int i = 0; i < workingSet.size(); ++i)
+    {
+        _isActive[workingSet[i]] = 1;
+        _isDiscovered[workingSet[i]].store(true, std::memory_order_relaxed);
+    }
+
+    std::vector<std::vector<NodeType>> threadsDiscovered(omp_get_max_threads());
+    double flowToSink = 0.0;
+    long long nbScannedArcs = 0;
+
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:flowToSink,nbScannedArcs)
+    for(int i = 0; i < workingSet.size(); ++i)
+    {
+        const NodeType v = workingSet[i];
+        std::vector<NodeType>& discovered = threadsDiscovered[omp_get_thread_num()];
+
+        const int label = _labels[v];
+        int newLabel = label;
+        ValueType excess = _excess[v];
+
+        while(excess > 0)
+        {
+            int minLabel = maxLabel;
+            bool skipped = false;
+
+            // implicit sink arc, the sink label is 0
+            if(_sinkResidual[v] > 0 && newLabel == 1)
+            {
+                const ValueType delta = std::min(excess, _sinkResidual[v]);
+                _sinkResidual[v] -= delta;
+                excess -= delta;
+                flowToSink += delta;
+            }
+
+            for(std::size_t a = _arcsOffsets[v]; a < _arcsOffsets[v + 1] && excess > 0; ++a)
+            {
+                ++nbScannedArcs;
+                const NodeType w = _arcsTarget[a];
+                const int labelW = _labels[w];
+                const bool admissible = (newLabel == labelW + 1);
+
+                if(_isActive[w])
+                {
+                    // only one of two active nodes can push on the arcs between them, based on the labels of the previous round
+                    const bool win = (label == labelW + 1) || (label < labelW - 1) || (label == labelW && v < w);
+                    if(admissible && !win)
+                    {
+                        skipped = true;
+                        continue;
+                    }
+                }
+
+                ValueType residual = _arcsResidual[a].load(std::memory_order_relaxed);
+                if(admissible && residual > 0)
+                {
+                    const ValueType delta = std::min(excess, residual);
+                    residual -= delta;
+                    _arcsResidual[a].store(residual, std::memory_order_relaxed);
+                    const std::size_t reverseA = _arcsReverse[a];
+                    _arcsResidual[reverseA].store(_arcsResidual[reverseA].load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+                    excess -= delta;
+                    atomicAdd(_addedExcess[w], delta);
+                    if(!_isDiscovered[w].exchange(true, std::memory_order_relaxed))
+                        discovered.push_back(w);
+                }
+                if(residual > 0 && labelW >= newLabel)
+                    minLabel = std::min(minLabel, labelW + 1);
+            }
+
+            if(excess <= 0 || skipped)
+                break;
+
+            // relabel
+            newLabel = minLabel;
+            if(newLabel >= maxLabel)
+                break;
+        }
+
+        // the excess of v is only read by v in this round, the pushes to v are in _addedExcess
+        _newLabels[v] = newLabel;
+        _excess[v] = excess;
+    }
+
+    _flowToSink += static_cast<ValueType>(flowToSink);
+
+    std::vector<NodeType> discoveredNodes;
+    mergeThreadsLists(threadsDiscovered, discoveredNodes);
+
+    // apply the new labels and excesses
+#pragma omp parallel for
+    for(int i = 0; i < workingSet.size(); ++i)
+    {
+        const NodeType v = workingSet[i];
+        _labels[v] = _newLabels[v];
+        _isActive[v] = 0;
+    }
+
+    std::vector<std::vector<NodeType>> threadsActive(omp_get_max_threads());
+    for(const std::vector<NodeType>* nodes : {&workingSet, &discoveredNodes})
+    {
+#pragma omp parallel for
+        for(int i = 0; i < nodes->size(); ++i)
+        {
+            const NodeType v = (*nodes)[i];
+            _excess[v] += _addedExcess[v].exchange(0, std::memory_order_relaxed);
+            _isDiscovered[v].store(false, std::memory_order_relaxed);
+            if(_excess[v] > 0 && _labels[v] < maxLabel)
+                threadsActive[omp_get_thread_num()].push_back(v);
+        }
+    }
+    mergeThreadsLists(threadsActive, workingSet);
+
+    return static_cast<std::size_t>(nbScannedArcs);
+}
+
+void MaxFlow_PushRelabel::computeCut()
+{
+    // the nodes with an excess are reachable from the source
+    std::vector<NodeType> frontier;
+    for(std::size_t n = 0; n < _numNodes; ++n)
+    {
+        if(_excess[n] > 0)
+        {
+            _isDiscovered[n].store(true, std::memory_order_relaxed);
+            frontier.push_back(n);
+        }
+    }
+
+    std::vector<std::vector<NodeType>> threadsNext(omp_get_max_threads());
+
+    while(!frontier.empty())
+    {
+#pragma omp parallel for schedule(dynamic, 256)
+        for(int i = 0; i < frontier.size(); ++i)
+        {
+            const NodeType v = frontier[i];
+            std::vector<NodeType>& next = threadsNext[omp_get_thread_num()];
+
+            for(std::size_t a = _arcsOffsets[v]; a < _arcsOffsets[v + 1]; ++a)
+            {
+                const NodeType w = _arcsTarget[a];
+                if(_arcsResidual[a].load(std::memory_order_relaxed) <= 0)
+                    continue;
+                if(_isDiscovered[w].exchange(true, std::memory_order_relaxed))
+                    continue;
+                next.push_back(w);
+            }
+        }
+        mergeThreadsLists(threadsNext, frontier);
+    }
+
+    _isTarget.resize(_numNodes);
+    for(std::size_t n = 0; n < _numNodes; ++n)
+        _isTarget[n] = !_isDiscovered[n].load(std::memory_order_relaxed);
+}
+
+MaxFlow_PushRelabel::ValueType MaxFlow_PushRelabel::compute()
+{
+    ALICEVISION_LOG_INFO("Compute parallel push-relabel max flow (" << omp_get_max_threads() << " threads).");
+
+    buildArcs();
+
+    const int maxLabel = static_cast<int>(_numNodes) + 1;
+    _labels.resize(_numNodes);
+    _newLabels.resize(_numNodes);
+    _addedExcess = std::vector<std::atomic<ValueType>>(_numNodes);
+    _isDiscovered = std::vector<std::atomic<bool>>(_numNodes);
+    _isActive.assign(_numNodes, 0);
+#pragma omp parallel for
+    for(int n = 0; n < _numNodes; ++n)
+    {
+        _addedExcess[n].store(0, std::memory_order_relaxed);
+        _isDiscovered[n].store(false, std::memory_order_relaxed);
+    }
+
+    // work (scanned arcs) between two global relabelings
+    const std::size_t globalRelabelWork = 6 * _numNodes + _arcsTarget.size();
+    std::size_t work = 0;
+    int nbRounds = 0;
+    int nbGlobalRelabels = 0;
+
+    std::vector<NodeType> workingSet;
+    while(true)
+    {
+        if(nbRounds == 0 || work >= globalRelabelWork)
+        {
+            globalRelabel();
+            ++nbGlobalRelabels;
+            work = 0;
+
+            workingSet.clear();
+            for(std::size_t n = 0; n < _numNodes; ++n)
+            {
+                if(_excess[n] > 0 && _labels[n] < maxLabel)
+                    workingSet.push_back(n);
+            }
+        }
+        if(workingSet.empty())
+            break;
+
+        work += dischargeRound(workingSet);
+        ++nbRounds;
+    }
+
+    ALICEVISION_LOG_INFO("Push-relabel: " << nbRounds << " rounds, " << nbGlobalRelabels << " global relabelings.");
+
+    computeCut();
+
+    // release the solver memory, only the cut is kept
+    std::vector<std::size_t>().swap(_arcsOffsets);
+    std::vector<NodeType>().swap(_arcsTarget);
+    std::vector<std::size_t>().swap(_arcsReverse);
+    std::vector<std::atomic<ValueType>>().swap(_arcsResidual);
+    std::vector<int>().swap(_newLabels);
+    std::vector<std::atomic<ValueType>>().swap(_addedExcess);
+    std::vector<std::atomic<bool>>().swap(_isDiscovered);
+    std::vector<char>().swap(_isActive);
+
+    return _flowToSink;
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
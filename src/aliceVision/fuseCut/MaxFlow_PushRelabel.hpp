@@ -0,0 +1,123 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Multi-threaded maxflow computation based on a synchronous parallel push-relabel algorithm
+ *        (Baumstark, Blelloch and Shun, "Efficient Implementation of a Synchronous Parallel Push-Relabel Algorithm", ESA 2015).
+ *
+ * The active nodes are discharged in parallel rounds, using the labels of the previous round,
+ * the conflicting pushes between two active nodes are resolved by a deterministic rule.
+ * The labels are periodically recomputed by a parallel breadth first search from the sink (global relabeling).
+ *
+ * The source and the sink are implicit: the source edges are saturated at initialization (node excess)
+ * and the sink edges are stored per node.
+ * Same interface as MaxFlow_AdjList and MaxFlow_CSR, the nodes reachable from the source in the final
+ * residual graph are the source side (empty), all the others are the target side (full) as the Boykov-Kolmogorov "free" nodes.
+ */
+class MaxFlow_PushRelabel
+{
+public:
+    using NodeType = unsigned int;
+    using ValueType = float;
+
+    explicit MaxFlow_PushRelabel(std::size_t numNodes);
+
+    inline void addNode(NodeType n, ValueType source, ValueType sink)
+    {
+        assert(source >= 0 && sink >= 0);
+        const ValueType score = source - sink;
+        if(score > 0)
+            _excess[n] += score;
+        else
+            _sinkResidual[n] += -score;
+    }
+
+    inline void addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity)
+    {
+        assert(capacity >= 0 && reverseCapacity >= 0);
+        _edges.push_back({n1, n2, capacity, reverseCapacity});
+    }
+
+    ValueType compute();
+
+    /// is empty
+    inline bool isSource(NodeType n) const
+    {
+        return !_isTarget[n];
+    }
+    /// is full
+    inline bool isTarget(NodeType n) const
+    {
+        return _isTarget[n];
+    }
+
+private:
+    struct Edge
+    {
+        NodeType n1;
+        NodeType n2;
+        ValueType capacity;
+        ValueType reverseCapacity;
+    };
+
+    /// Build the arcs of each node (CSR layout) from the edges list, and release it
+    void buildArcs();
+
+    /**
+     * @brief Set the labels to the exact distances to the sink in the residual graph (parallel breadth first search),
+     *        the nodes which can't reach the sink get the label _numNodes + 1
+     */
+    void globalRelabel();
+
+    /**
+     * @brief Discharge in parallel the nodes of the working set (one synchronous round)
+     * @param[in,out] workingSet the active nodes, replaced by the active nodes of the next round
+     * @return the num. of arcs scanned
+     */
+    std::size_t dischargeRound(std::vector<NodeType>& workingSet);
+
+    /// Set _isTarget: all the nodes not reachable from the source in the residual graph
+    void computeCut();
+
+    const std::size_t _numNodes;
+
+    std::vector<Edge> _edges;
+
+    // arcs per node, the arcs of node n are in [_arcsOffsets[n], _arcsOffsets[n+1])
+    std::vector<std::size_t> _arcsOffsets;
+    std::vector<NodeType> _arcsTarget;
+    std::vector<std::size_t> _arcsReverse;
+    /// residual capacities, written by a single node per round (relaxed atomics for the concurrent reads)
+    std::vector<std::atomic<ValueType>> _arcsResidual;
+
+    std::vector<ValueType> _excess;
+    std::vector<ValueType> _sinkResidual;
+    std::vector<int> _labels;
+
+    // per round buffers
+    std::vector<int> _newLabels;
+    std::vector<std::atomic<ValueType>> _addedExcess;
+    std::vector<std::atomic<bool>> _isDiscovered;
+    std::vector<char> _isActive;
+
+    ValueType _flowToSink = 0;
+    std::vector<bool> _isTarget;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -13,14 +13,24 @@
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 namespace aliceVision {
 namespace fuseCut {
 
-OctreeTracks::Node::Node(NodeType type)
+constexpr OctreeTracks::NodeIndex OctreeTracks::emptyNode;
+
+OctreeTracks::Branch::Branch()
+{
+    std::fill_n(children, 8, emptyNode);
+}
+
+/// Index of the child containing (x, y, z) in a branch whose children have the given size
+static inline int getChildIndex(int x, int y, int z, int childSize)
 {
-    type_ = type;
+    return (!((x & childSize) == 0)) * 4 + (!((y & childSize) == 0)) * 2 + (!((z & childSize) == 0));
 }
 
 OctreeTracks::trackStruct* OctreeTracks::getTrack(int x, int y, int z)
@@ -30,58 +40,76 @@ OctreeTracks::trackStruct* OctreeTracks::getTrack(int x, int y, int z)
         return nullptr;
     }
 
-    Node** n = &root_;
+    if(branches_.empty())
+    {
+        return nullptr;
+    }
+
+    NodeIndex n = 0;
     int size = size_;
 
     while(size != 1)
     {
-        if(*n == nullptr)
+        if(n == emptyNode)
         {
             return nullptr;
         }
 
         size /= 2;
-        n = &reinterpret_cast<Branch*>(*n)->children[!((x & size) == 0)][!((y & size) == 0)][!((z & size) == 0)];
+        n = branches_[n].children[getChildIndex(x, y, z, size)];
     }
 
-    if(*n == nullptr)
+    if(n == emptyNode)
     {
         return nullptr;
     }
 
-    return reinterpret_cast<trackStruct*>(*n);
+    return &tracks_[n];
 }
 
-void OctreeTracks::addPoint(int x, int y, int z, float sim, float pixSize, Point3d& p, int rc)
+OctreeTracks::NodeIndex& OctreeTracks::getOrCreateLeaf(int x, int y, int z)
 {
-    assert(x >= 0 && x < size_);
-    assert(y >= 0 && y < size_);
-    assert(z >= 0 && z < size_);
+    if(branches_.empty())
+    {
+        branches_.emplace_back();
+    }
 
-    Node** n = &root_;
-    int size = size_;
+    NodeIndex n = 0;
+    int size = size_ / 2;
 
     while(size != 1)
     {
-        if(*n == nullptr)
-        {
-            *n = new Branch();
-        }
-        else
+        const int childIndex = getChildIndex(x, y, z, size);
+        if(branches_[n].children[childIndex] == emptyNode)
         {
-            size /= 2;
-            n = &reinterpret_cast<Branch*>(*n)->children[!((x & size) == 0)][!((y & size) == 0)][!((z & size) == 0)];
+            branches_[n].children[childIndex] = static_cast<NodeIndex>(branches_.size());
+            branches_.emplace_back();
         }
+        n = branches_[n].children[childIndex];
+        size /= 2;
     }
 
-    if(*n == nullptr)
+    // no more branch allocation, the reference stays valid
+    return branches_[n].children[getChildIndex(x, y, z, size)];
+}
+
+void OctreeTracks::addPoint(int x, int y, int z, float sim, float pixSize, Point3d& p, int rc)
+{
+    assert(x >= 0 && x < size_);
+    assert(y >= 0 && y < size_);
+    assert(z >= 0 && z < size_);
+
+    NodeIndex& leaf = getOrCreateLeaf(x, y, z);
+
+    if(leaf == emptyNode)
     {
-        *n = new trackStruct(sim, pixSize, p, rc);
+        leaf = static_cast<NodeIndex>(tracks_.size());
+        tracks_.emplace_back(sim, pixSize, p, rc);
         leafsNumber_++;
     }
     else
     {
-        reinterpret_cast<trackStruct*>(*n)->addPoint(sim, pixSize, p, rc);
+        tracks_[leaf].addPoint(sim, pixSize, p, rc);
     }
 }
 
@@ -91,30 +119,17 @@ void OctreeTracks::addTrack(int x, int y, int z, OctreeTracks::trackStruct* t)
     assert(y >= 0 && y < size_);
     assert(z >= 0 && z < size_);
 
-    Node** n = &root_;
-    int size = size_;
+    NodeIndex& leaf = getOrCreateLeaf(x, y, z);
 
-    while(size != 1)
+    if(leaf == emptyNode)
     {
-        if(*n == nullptr)
-        {
-            *n = new Branch();
-        }
-        else
-        {
-            size /= 2;
-            n = &reinterpret_cast<Branch*>(*n)->children[!((x & size) == 0)][!((y & size) == 0)][!((z & size) == 0)];
-        }
-    }
-
-    if(*n == nullptr)
-    {
-        *n = new trackStruct(t);
+        leaf = static_cast<NodeIndex>(tracks_.size());
+        tracks_.emplace_back(t);
         leafsNumber_++;
     }
     else
     {
-        reinterpret_cast<trackStruct*>(*n)->addTrack(t);
+        tracks_[leaf].addTrack(t);
     }
 }
 
@@ -122,140 +137,58 @@ StaticVector<OctreeTracks::trackStruct*>* OctreeTracks::getAllPoints()
 {
     StaticVector<trackStruct*>* out = new StaticVector<trackStruct*>();
     out->reserve(leafsNumber_);
-    if(root_ != nullptr)
+    if(branches_.empty())
     {
-        getAllPointsRecursive(out, root_);
+        return out;
     }
-    return out;
-}
-
-void OctreeTracks::getAllPointsRecursive(StaticVector<trackStruct*>* out, Node* node)
-{
-    assert(node);
 
-    switch(node->type_)
+    // depth first traversal, (branch, size) to visit
+    std::vector<std::pair<NodeIndex, int>> stack;
+    stack.emplace_back(0, size_);
+    while(!stack.empty())
     {
-        case BranchNode:
-        {
-            Branch* b = reinterpret_cast<Branch*>(node);
-            for(int i = 0; i < 2; ++i)
-            {
-                for(int j = 0; j < 2; ++j)
-                {
-                    for(int k = 0; k < 2; ++k)
-                    {
-                        if(b->children[i][j][k] != nullptr)
-                        {
-                            getAllPointsRecursive(out, b->children[i][j][k]);
-                        }
-                    }
-                }
-            }
-        }
-        break;
-        case LeafNode:
-            out->push_back(reinterpret_cast<trackStruct*>(node));
-            break;
-    }
-}
+        const Branch& b = branches_[stack.back().first];
+        const int size = stack.back().second;
+        stack.pop_back();
 
-void OctreeTracks::getNPointsByLevelsRecursive(Node* node, int level, StaticVector<int>* nptsAtLevel)
-{
-    assert(node);
-
-    switch(node->type_)
-    {
-        case BranchNode:
+        if(size == 2)
         {
-            Branch* b = reinterpret_cast<Branch*>(node);
-            for(int i = 0; i < 2; ++i)
+            for(int c = 0; c < 8; ++c)
             {
-                for(int j = 0; j < 2; ++j)
-                {
-                    for(int k = 0; k < 2; ++k)
-                    {
-                        if(b->children[i][j][k] != nullptr)
-                        {
-                            (*nptsAtLevel)[level + 1] += 1;
-                            getNPointsByLevelsRecursive(b->children[i][j][k], level + 1, nptsAtLevel);
-                        }
-                    }
-                }
+                if(b.children[c] != emptyNode)
+                    out->push_back(&tracks_[b.children[c]]);
             }
         }
-        break;
-        case LeafNode:
-            //
-            break;
-    }
-}
-
-OctreeTracks::Branch::Branch()
-    : Node(BranchNode)
-{
-    for(int i = 0; i < 2; ++i)
-    {
-        for(int j = 0; j < 2; ++j)
+        else
         {
-            for(int k = 0; k < 2; ++k)
+            // in reverse order to visit the children in order
+            for(int c = 7; c >= 0; --c)
             {
-                children[i][j][k] = nullptr;
+                if(b.children[c] != emptyNode)
+                    stack.emplace_back(b.children[c], size / 2);
             }
         }
     }
+    return out;
 }
 
-OctreeTracks::Branch::~Branch()
+void OctreeTracks::getNPointsByLevelsRecursive(NodeIndex branch, int size, int level, StaticVector<int>* nptsAtLevel)
 {
-    for(int i = 0; i < 2; ++i)
+    assert(branch != emptyNode);
+
+    const Branch& b = branches_[branch];
+    for(int c = 0; c < 8; ++c)
     {
-        for(int j = 0; j < 2; ++j)
+        if(b.children[c] != emptyNode)
         {
-            for(int k = 0; k < 2; ++k)
-            {
-                assert(children[i][j][k] != this);
-                /*
-                Node *node = children[i][j][k];
-                if (node!=NULL) {
-                        if ( node->type_ == BranchNode ) {
-                                delete reinterpret_cast<Branch*>(node);
-                        }else {
-                                if ( node->type_ == LeafNode ) {
-                                        delete reinterpret_cast<trackStruct*>(node);
-                                }else{
-                                        printf("WARNING unknows node type\n");
-                                };
-                        }
-                        node = NULL;
-                        children[i][j][k] = NULL;
-                }
-                */
-                if(children[i][j][k] != nullptr)
-                {
-                    if(children[i][j][k]->type_ == BranchNode)
-                    {
-                        delete reinterpret_cast<Branch*>(children[i][j][k]);
-                    }
-                    else
-                    {
-                        if(children[i][j][k]->type_ == LeafNode)
-                        {
-                            delete reinterpret_cast<trackStruct*>(children[i][j][k]);
-                        }
-                        else
-                        {
-                            ALICEVISION_LOG_WARNING("Unknows node type.");
-                        }
-                    }
-                    children[i][j][k] = nullptr;
-                }
-            }
+            (*nptsAtLevel)[level + 1] += 1;
+            if(size > 2)
+                getNPointsByLevelsRecursive(b.children[c], size / 2, level + 1, nptsAtLevel);
         }
     }
 }
 
 OctreeTracks::trackStruct::trackStruct(float sim, float pixSize, const Point3d& p, int rc)
-    : Node(LeafNode)
 {
     npts = 1;
     point = p;
@@ -266,7 +199,6 @@ OctreeTracks::trackStruct::trackStruct(float sim, float pixSize, const Point3d&
 }
 
 OctreeTracks::trackStruct::trackStruct(trackStruct* t)
-    : Node(LeafNode)
 {
     npts = t->npts;
     point = t->point;
@@ -284,11 +216,7 @@ void OctreeTracks::trackStruct::addPoint(float sim, float pixSize, const Point3d
     int index = indexOf(rc);
     if(index == -1)
     {
-        cams.push_back(Pixel(rc, 1));
-        if(cams.size() > 1)
-        {
-            qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
-        }
+        insertCam(Pixel(rc, 1));
     }
     else
     {
@@ -341,11 +269,7 @@ void OctreeTracks::trackStruct::addDistinctNonzeroCamsFromTrackAsZeroCams(trackS
             int index = indexOf(rc);
             if(index == -1)
             {
-                cams.push_back(Pixel(rc, 0));
-                if(cams.size() > 1)
-                {
-                    qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
-                }
+                insertCam(Pixel(rc, 0));
             }
         }
     }
@@ -359,11 +283,7 @@ void OctreeTracks::trackStruct::addTrack(OctreeTracks::trackStruct* t)
         int index = indexOf(rc);
         if(index == -1)
         {
-            cams.push_back(t->cams[i]);
-            if(cams.size() > 1)
-            {
-                qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
-            }
+            insertCam(t->cams[i]);
         }
         else
         {
@@ -406,6 +326,13 @@ void OctreeTracks::trackStruct::addTrack(OctreeTracks::trackStruct* t)
     // else don't use the position information as it is less accurate.
 }
 
+void OctreeTracks::trackStruct::insertCam(const Pixel& cam)
+{
+    std::vector<Pixel>& data = cams.getDataWritable();
+    const auto it = std::upper_bound(data.begin(), data.end(), cam, [](const Pixel& a, const Pixel& b) { return a.x < b.x; });
+    data.insert(it, cam);
+}
+
 int OctreeTracks::trackStruct::indexOf(int val)
 {
     if(cams.size() == 0)
@@ -500,18 +427,11 @@ OctreeTracks::OctreeTracks(const Point3d* _voxel, mvsUtils::MultiViewParams* _mp
         size_ *= 2;
     }
 
-    root_ = nullptr;
     leafsNumber_ = 0;
 }
 
 OctreeTracks::~OctreeTracks()
 {
-    // printf("deleting octree\n");
-    if(root_ != nullptr)
-    {
-        delete reinterpret_cast<Branch*>(root_);
-    }
-    // printf("deleted\n");
 }
 
 bool OctreeTracks::getVoxelOfOctreeFor3DPoint(Voxel& out, Point3d& tp)
@@ -668,61 +588,87 @@ void OctreeTracks::filterOctreeTracks2(StaticVector<trackStruct*>* tracks)
     tracks->swap(tracksOut);
 }
 
-StaticVector<OctreeTracks::trackStruct*>* OctreeTracks::fillOctree(int maxPts, std::string depthMapsPtsSimsTmpDir)
+StaticVector<OctreeTracks::trackStruct*>* OctreeTracks::fillOctree(int maxPts, std::string depthMapsPtsSimsTmpDir, int ptsSimsChunkId)
 {
-    long t1 = clock();
-    StaticVector<int> cams = pc->findCamsWhichIntersectsHexahedron(vox, depthMapsPtsSimsTmpDir + "minMaxDepths.bin");
-    if(mp->verbose)
-        mvsUtils::printfElapsedTime(t1, "findCamsWhichIntersectsHexahedron");
-    if(mp->verbose)
-        ALICEVISION_LOG_DEBUG("ncams: " << cams.size());
+    // returns false if the octree has too many leafs
+    auto addDepthMapPoint = [&](Point3d p, float sim, int rc) -> bool
+    {
+        Voxel otVox;
+        if(((doUseWeaklySupportedPoints) || (sim < simWspThr)) && (getVoxelOfOctreeFor3DPoint(otVox, p))) // doUseWeaklySupportedPoints: false by default
+        {
+            if(doUseWeaklySupportedPointCam)
+            {
+                if(sim > 1.0f)
+                {
+                    sim -= 2.0f;
+                }
+            }
+            float pixSize = mp->getCamPixelSize(p, rc);
+            addPoint(otVox.x, otVox.y, otVox.z, sim, pixSize, p, rc);
+        }
+        return (leafsNumber_ <= 2 * maxPts);
+    };
 
-    t1 = clock();
+    long t1 = clock();
 
+    const std::string chunkFileName =
+        (ptsSimsChunkId >= 0) ? getTempPtsSimsChunkFileName(depthMapsPtsSimsTmpDir, ptsSimsChunkId) : "";
 
-    // long t1=initEstimate();
-    for(int camid = 0; camid < cams.size(); camid++)
+    if(!chunkFileName.empty() && mvsUtils::FileExists(chunkFileName))
     {
-        int rc = cams[camid];
-        StaticVector<Point3d>* pts =
-            loadArrayFromFile<Point3d>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "pts.bin");
-        StaticVector<float>* sims =
-            loadArrayFromFile<float>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "sims.bin");
+        // the points of all the cameras have already been bucketed in the top-level voxels
+        std::vector<PtsSimsChunkItem> items;
+        FILE* f = fopen(chunkFileName.c_str(), "rb");
+        if(f == nullptr)
+            throw std::runtime_error("fillOctree: can't open file " + chunkFileName);
+        fseek(f, 0, SEEK_END);
+        items.resize(ftell(f) / sizeof(PtsSimsChunkItem));
+        fseek(f, 0, SEEK_SET);
+        const size_t nread = fread(items.data(), sizeof(PtsSimsChunkItem), items.size(), f);
+        fclose(f);
+        if(nread != items.size())
+            throw std::runtime_error("fillOctree: can't read file " + chunkFileName);
+
+        if(mp->verbose)
+            ALICEVISION_LOG_DEBUG("chunk " << ptsSimsChunkId << " npts: " << items.size());
 
-        // long tpts=initEstimate();
-        for(int i = 0; i < pts->size(); i++)
+        for(const PtsSimsChunkItem& item : items)
         {
-            float sim = (*sims)[i];
-            Point3d p = (*pts)[i];
+            if(!addDepthMapPoint(item.p, item.sim, item.rc))
+                return nullptr;
+        }
+    }
+    else
+    {
+        StaticVector<int> cams = pc->findCamsWhichIntersectsHexahedron(vox, depthMapsPtsSimsTmpDir + "minMaxDepths.bin");
+        if(mp->verbose)
+            mvsUtils::printfElapsedTime(t1, "findCamsWhichIntersectsHexahedron");
+        if(mp->verbose)
+            ALICEVISION_LOG_DEBUG("ncams: " << cams.size());
 
-            Voxel otVox;
-            if(((doUseWeaklySupportedPoints) || (sim < simWspThr)) && (getVoxelOfOctreeFor3DPoint(otVox, p))) // doUseWeaklySupportedPoints: false by default
-            {
-                if(doUseWeaklySupportedPointCam)
-                {
-                    if(sim > 1.0f)
-                    {
-                        sim -= 2.0f;
-                    }
-                }
-                float pixSize = mp->getCamPixelSize(p, rc);
-                addPoint(otVox.x, otVox.y, otVox.z, sim, pixSize, p, rc);
-            }
-            if(leafsNumber_ > 2 * maxPts)
+        t1 = clock();
+
+        for(int camid = 0; camid < cams.size(); camid++)
+        {
+            int rc = cams[camid];
+            StaticVector<Point3d>* pts =
+                loadArrayFromFile<Point3d>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "pts.bin");
+            StaticVector<float>* sims =
+                loadArrayFromFile<float>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "sims.bin");
+
+            bool ok = true;
+            for(int i = 0; ok && i < pts->size(); i++)
             {
-                return nullptr;
+                ok = addDepthMapPoint((*pts)[i], (*sims)[i], rc);
             }
 
-            // printfEstimate(i, pts->size(), tpts);
-        } // for i
-          // finishEstimate();
+            delete pts;
+            delete sims;
 
-        delete pts;
-        delete sims;
-
-        // printfEstimate(camid, cams.size(), t1);
+            if(!ok)
+                return nullptr;
+        }
     }
-    // finishEstimate();
 
     StaticVector<trackStruct*>* tracks = getAllPoints();
     if(mp->verbose)
@@ -13,37 +13,16 @@
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/fuseCut/Fuser.hpp>
 
+#include <deque>
+#include <vector>
+
 namespace aliceVision {
 namespace fuseCut {
 
 class OctreeTracks : public Fuser
 {
 public:
-    enum NodeType
-    {
-        BranchNode,
-        LeafNode
-    };
-
-    class Node
-    {
-    public:
-        NodeType type_ : 2;
-
-        explicit Node(NodeType type);
-        ~Node(){};
-    };
-
-    class Branch : public Node
-    {
-    public:
-        Node* children[2][2][2];
-
-        Branch();
-        ~Branch();
-    };
-
-    class trackStruct : public Node
+    class trackStruct
     {
     public:
         int npts;
@@ -55,15 +34,33 @@ public:
         explicit trackStruct(trackStruct* t);
         trackStruct(float sim, float pixSize, const Point3d& p, int rc);
         ~trackStruct();
-        void resizeCamsAdd(int nadd);
         void addPoint(float sim, float pixSize, const Point3d& p, int rc);
         void addTrack(trackStruct* t);
         void addDistinctNonzeroCamsFromTrackAsZeroCams(trackStruct* t);
         int indexOf(int val);
         void doPrintf();
+
+    private:
+        /// Insert a new camera, keeping the cameras sorted by id
+        void insertCam(const Pixel& cam);
+    };
+
+    /// Index of a branch in branches_, or of a track in tracks_ for the children of the last level
+    using NodeIndex = unsigned int;
+    static constexpr NodeIndex emptyNode = 0xFFFFFFFF;
+
+    struct Branch
+    {
+        /// children indexes, child (i, j, k) at i * 4 + j * 2 + k
+        NodeIndex children[8];
+
+        Branch();
     };
 
-    Node* root_;
+    /// all the branches, the root is the first one (if any)
+    std::vector<Branch> branches_;
+    /// all the tracks, in chunks so the pointers returned by getTrack and getAllPoints stay valid
+    std::deque<trackStruct> tracks_;
     int size_;
     int leafsNumber_;
 
@@ -71,8 +68,8 @@ public:
     trackStruct* getTrack(int x, int y, int z);
     void addTrack(int x, int y, int z, trackStruct* t);
     void addPoint(int x, int y, int z, float sim, float pixSize, Point3d& p, int rc);
+    /// all the tracks in depth first order of the octree
     StaticVector<trackStruct*>* getAllPoints();
-    void getAllPointsRecursive(StaticVector<trackStruct*>* out, Node* node);
 
     Point3d O, vx, vy, vz;
     float sx, sy, sz, svx, svy, svz;
@@ -98,9 +95,19 @@ public:
     void filterOctreeTracks2(StaticVector<trackStruct*>* tracks);
     void updateOctreeTracksCams(StaticVector<trackStruct*>* tracks);
     StaticVector<trackStruct*>* fillOctreeFromTracks(StaticVector<trackStruct*>* tracksIn);
-    StaticVector<trackStruct*>* fillOctree(int maxPts, std::string depthMapsPtsSimsTmpDir);
+    /// @brief Fill the octree with the depth map points of the temporary pts/sims folder
+    /// @param ptsSimsChunkId top-level voxel containing this one: if its chunk exists, only this chunk is read
+    ///        instead of the pts/sims of all the intersecting cameras
+    StaticVector<trackStruct*>* fillOctree(int maxPts, std::string depthMapsPtsSimsTmpDir, int ptsSimsChunkId = -1);
     StaticVector<int>* getTracksCams(StaticVector<OctreeTracks::trackStruct*>* tracks);
-    void getNPointsByLevelsRecursive(Node* node, int level, StaticVector<int>* nptsAtLevel);
+    void getNPointsByLevelsRecursive(NodeIndex branch, int size, int level, StaticVector<int>* nptsAtLevel);
+
+private:
+    /**
+     * @brief Find the leaf of a voxel, the missing branches are created
+     * @return the leaf (the track index), emptyNode if the voxel has no track yet
+     */
+    NodeIndex& getOrCreateLeaf(int x, int y, int z);
 };
 
 } // namespace fuseCut
@@ -14,11 +14,17 @@
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace fuseCut {
 
 namespace bfs = boost::filesystem;
+namespace bpt = boost::property_tree;
 
 ReconstructionPlan::ReconstructionPlan(Voxel& dimmensions, Point3d* space, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
                                        std::string _spaceRootDir)
@@ -249,9 +255,33 @@ void ReconstructionPlan::getHexahedronForID(float dist, int id, Point3d* out)
     mvsUtils::inflateHexahedron(&(*voxels)[id * 8], out, dist);
 }
 
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls)
+/**
+ * @brief Thin hexahedron of the voxel i, the parts of the mesh of the next voxels inside it are removed
+ *        (the exclusion list of a voxel only depends on the voxels array, so each voxel can be reconstructed independently)
+ */
+static void addHexahToExclude(const StaticVector<Point3d>* voxelsArray, int i, StaticVector<Point3d>* hexahsToExclude)
+{
+    Point3d hexahThin[8];
+    mvsUtils::inflateHexahedron(&(*voxelsArray)[i * 8], hexahThin, 0.9);
+    for(int k = 0; k < 8; k++)
+    {
+        hexahsToExclude->push_back(hexahThin[k]);
+    }
+}
+
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls, int rangeStart,
+                                            int rangeSize)
 {
     StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+    const int nbVoxels = voxelsArray->size() / 8;
+
+    if(rangeStart < 0 || rangeStart > nbVoxels)
+    {
+        delete voxelsArray;
+        throw std::out_of_range("Invalid subrange of voxels to reconstruct, rangeStart: " + mvsUtils::num2str(rangeStart) +
+                                ", number of voxels: " + mvsUtils::num2str(nbVoxels));
+    }
+    const int rangeEnd = (rangeSize < 0) ? nbVoxels : std::min(rangeStart + rangeSize, nbVoxels);
 
     ReconstructionPlan* rp =
         new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->pc, ls->spaceVoxelsFolderName);
@@ -259,9 +289,13 @@ void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileNa
     StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = new StaticVector<Point3d>();
     hexahsToExcludeFromResultingMesh->reserve(voxelsArray->size());
 
-    for(int i = 0; i < voxelsArray->size() / 8; i++)
+    // the voxels before the range are reconstructed by other jobs
+    for(int i = 0; i < rangeStart; i++)
+        addHexahToExclude(voxelsArray, i, hexahsToExcludeFromResultingMesh);
+
+    for(int i = rangeStart; i < rangeEnd; i++)
     {
-        ALICEVISION_LOG_INFO("Reconstructing " << (voxelsArray->size() / 8) << "-th Voxel of " <<  i << ".");
+        ALICEVISION_LOG_INFO("Reconstructing " << i << "-th Voxel of " << nbVoxels << ".");
 
         const std::string folderName = ls->getReconstructionVoxelFolder(i);
         bfs::create_directory(folderName);
@@ -282,11 +316,12 @@ void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileNa
             StaticVector<int> usedCams = delaunayGC.getSortedUsedCams();
 
             mesh::meshPostProcessing(mesh, ptsCams, usedCams, *ls->mp, *ls->pc, ls->mp->mvDir, hexahsToExcludeFromResultingMesh, hexah);
-            mesh->saveToBin(folderName + "mesh.bin");
-            mesh->saveToObj(folderName + "mesh.obj");
 
+            // mesh.bin is written last: it marks the voxel as done
             saveArrayOfArraysToFile<int>(folderName + "meshPtsCamsFromDGC.bin", ptsCams);
             deleteArrayOfArrays<int>(&ptsCams);
+            mesh->saveToObj(folderName + "mesh.obj");
+            mesh->saveToBin(meshBinFilepath);
 
             delete mesh;
         }
@@ -298,18 +333,82 @@ void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileNa
             computeColoredMesh(resultFolderName, ls);
         }
         */
-        Point3d hexahThin[8];
-        mvsUtils::inflateHexahedron(&(*voxelsArray)[i * 8], hexahThin, 0.9);
-        for(int k = 0; k < 8; k++)
+        addHexahToExclude(voxelsArray, i, hexahsToExcludeFromResultingMesh);
+    }
+    delete hexahsToExcludeFromResultingMesh;
+    delete rp;
+    delete voxelsArray;
+}
+
+void exportVoxelsReconstructionJobs(const std::string& voxelsArrayFileName, LargeScale* ls, const std::string& jobsFilepath)
+{
+    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+    const std::vector<std::string> recsDirs = ls->getRecsDirs(voxelsArray);
+
+    bpt::ptree fileTree;
+    fileTree.put("nbVoxels", recsDirs.size());
+
+    // inputs shared by all the jobs, produced by the planning step
+    {
+        bpt::ptree inputsTree;
+        inputsTree.put("voxelsArray", voxelsArrayFileName);
+        inputsTree.put("spaceFolder", ls->spaceFolderName);
+        inputsTree.put("spaceCamsTracksFolder", ls->getSpaceCamsTracksDir());
+        fileTree.add_child("inputs", inputsTree);
+    }
+
+    bpt::ptree jobsTree;
+    for(int i = 0; i < recsDirs.size(); ++i)
+    {
+        bpt::ptree jobTree;
+        jobTree.put("rangeStart", i);
+        jobTree.put("rangeSize", 1);
+
+        bpt::ptree hexahTree;
+        for(int k = 0; k < 8; ++k)
         {
-            hexahsToExcludeFromResultingMesh->push_back(hexahThin[k]);
+            const Point3d& p = (*voxelsArray)[i * 8 + k];
+            bpt::ptree pointTree;
+            for(double v : {p.x, p.y, p.z})
+            {
+                bpt::ptree valueTree;
+                valueTree.put("", v);
+                pointTree.push_back(std::make_pair("", valueTree));
+            }
+            hexahTree.push_back(std::make_pair("", pointTree));
         }
-        delete hexahsToExcludeFromResultingMesh;
+        jobTree.add_child("hexahedron", hexahTree);
+
+        jobTree.put("outputFolder", recsDirs[i]);
+        bpt::ptree outputsTree;
+        for(const std::string& filename : {"mesh.bin", "mesh.obj", "meshPtsCamsFromDGC.bin"})
+        {
+            bpt::ptree outputTree;
+            outputTree.put("", recsDirs[i] + filename);
+            outputsTree.push_back(std::make_pair("", outputTree));
+        }
+        jobTree.add_child("outputs", outputsTree);
+
+        jobsTree.push_back(std::make_pair("", jobTree));
     }
-    delete rp;
+    fileTree.add_child("jobs", jobsTree);
+
+    bpt::write_json(jobsFilepath, fileTree);
     delete voxelsArray;
+
+    ALICEVISION_LOG_INFO(recsDirs.size() << " voxels reconstruction jobs written: " << jobsFilepath);
 }
 
+std::vector<int> getMissingVoxelsReconstructions(const std::vector<std::string>& recsDirs)
+{
+    std::vector<int> missingVoxels;
+    for(int i = 0; i < recsDirs.size(); ++i)
+    {
+        if(!mvsUtils::FileExists(recsDirs[i] + "mesh.bin") || !mvsUtils::FileExists(recsDirs[i] + "meshPtsCamsFromDGC.bin"))
+            missingVoxels.push_back(i);
+    }
+    return missingVoxels;
+}
 
 StaticVector<StaticVector<int>*>* loadLargeScalePtsCams(const std::vector<std::string>& recsDirs)
 {
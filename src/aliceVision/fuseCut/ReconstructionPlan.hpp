@@ -34,7 +34,28 @@ public:
 };
 
 void reconstructAccordingToOptimalReconstructionPlan(int gl, LargeScale* ls);
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls);
+
+/**
+ * @brief Reconstruct the voxels of the voxels array, each one in its own folder (see LargeScale::getReconstructionVoxelFolder)
+ * @param[in] voxelsArrayFileName the voxels array (8 points per voxel)
+ * @param[in] ls the large scale space
+ * @param[in] rangeStart the first voxel to reconstruct
+ * @param[in] rangeSize the num. of voxels to reconstruct, -1 for all the voxels from rangeStart
+ * @note A voxel only depends on the space and the voxels array, so the ranges can be reconstructed by independent processes.
+ *       The voxels already reconstructed (mesh.bin exists) are skipped.
+ */
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls, int rangeStart = 0,
+                                            int rangeSize = -1);
+
+/**
+ * @brief Write the JSON description of the voxels reconstruction jobs: the shared inputs,
+ *        and for each voxel its range, its hexahedron and its output files
+ */
+void exportVoxelsReconstructionJobs(const std::string& voxelsArrayFileName, LargeScale* ls, const std::string& jobsFilepath);
+
+/// Indexes of the voxels whose reconstruction outputs are missing
+std::vector<int> getMissingVoxelsReconstructions(const std::vector<std::string>& recsDirs);
+
 mesh::Mesh* joinMeshes(const std::vector<std::string>& recsDirs, StaticVector<Point3d>* voxelsArray, LargeScale* ls);
 mesh::Mesh* joinMeshes(int gl, LargeScale* ls);
 mesh::Mesh* joinMeshes(const std::string& voxelsArrayFileName, LargeScale* ls);
@@ -254,8 +254,86 @@ bool VoxelsGrid::saveTracksToVoxelFiles(StaticVector<int>* cams, StaticVector<Oc
     return true;
 }
 
+void VoxelsGrid::generatePtsSimsVoxelChunks(const std::string& depthMapsPtsSimsTmpDir)
+{
+    const std::string chunksFileMark = depthMapsPtsSimsTmpDir + "chunks.txt";
+    if(mvsUtils::FileExists(chunksFileMark))
+        return;
+
+    ALICEVISION_LOG_INFO("Bucketing depth map points in " << voxelDim.x << "x" << voxelDim.y << "x" << voxelDim.z << " voxels.");
+    long t1 = clock();
+
+    const int nvoxs = voxels->size() / 8;
+    // used only to locate the points in the grid
+    OctreeTracks grid(&space[0], mp, pc, voxelDim);
+
+    std::vector<std::vector<PtsSimsChunkItem>> chunks(nvoxs);
+    std::vector<bool> chunkCreated(nvoxs, false);
+    unsigned long npts = 0;
+
+    // cameras in increasing order, as the chunks items are added to the octree in this order
+    for(int rc = 0; rc < mp->ncams; rc++)
+    {
+        StaticVector<Point3d>* pts =
+            loadArrayFromFile<Point3d>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "pts.bin");
+        StaticVector<float>* sims =
+            loadArrayFromFile<float>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "sims.bin");
+
+        for(int i = 0; i < pts->size(); i++)
+        {
+            Voxel v;
+            if(grid.getVoxelOfOctreeFor3DPoint(v, (*pts)[i]))
+            {
+                PtsSimsChunkItem item;
+                item.p = (*pts)[i];
+                item.sim = (*sims)[i];
+                item.rc = rc;
+                chunks[getIdForVoxel(v)].push_back(item);
+            }
+        }
+        delete pts;
+        delete sims;
+
+        // append the points of this camera to the chunk files
+        for(int i = 0; i < nvoxs; i++)
+        {
+            if(chunks[i].empty())
+                continue;
+            const std::string fileName = getTempPtsSimsChunkFileName(depthMapsPtsSimsTmpDir, i);
+            FILE* f = fopen(fileName.c_str(), chunkCreated[i] ? "ab" : "wb");
+            if(f == nullptr)
+                throw std::runtime_error("generatePtsSimsVoxelChunks: can't open file " + fileName);
+            fwrite(chunks[i].data(), sizeof(PtsSimsChunkItem), chunks[i].size(), f);
+            fclose(f);
+            chunkCreated[i] = true;
+            npts += chunks[i].size();
+            chunks[i].clear();
+        }
+    }
+
+    // empty voxels have an empty chunk, so that they do not fall back to reading all the cameras
+    for(int i = 0; i < nvoxs; i++)
+    {
+        if(chunkCreated[i])
+            continue;
+        const std::string fileName = getTempPtsSimsChunkFileName(depthMapsPtsSimsTmpDir, i);
+        FILE* f = fopen(fileName.c_str(), "wb");
+        if(f == nullptr)
+            throw std::runtime_error("generatePtsSimsVoxelChunks: can't open file " + fileName);
+        fclose(f);
+    }
+
+    // mark the chunks as complete
+    FILE* f = fopen(chunksFileMark.c_str(), "w");
+    fclose(f);
+
+    ALICEVISION_LOG_INFO("Bucketing depth map points done: " << npts << " points in " << nvoxs << " voxels.");
+    mvsUtils::printfElapsedTime(t1, "generatePtsSimsVoxelChunks");
+}
+
 void VoxelsGrid::generateTracksForEachVoxel(StaticVector<Point3d>* ReconstructionPlan, int numSubVoxs, int maxPts,
-                                            int level, int& maxlevel, const std::string& depthMapsPtsSimsTmpDir)
+                                            int level, int& maxlevel, const std::string& depthMapsPtsSimsTmpDir,
+                                            int ptsSimsChunkId)
 {
     ALICEVISION_LOG_DEBUG("generateTracksForEachVoxel recursive "
                           << "\t- numSubVoxs: " << numSubVoxs << std::endl
@@ -281,7 +359,9 @@ void VoxelsGrid::generateTracksForEachVoxel(StaticVector<Point3d>* Reconstructio
 
         long t1 = clock();
         OctreeTracks* ott = new OctreeTracks(&(*voxels)[i * 8], mp, pc, Voxel(numSubVoxs, numSubVoxs, numSubVoxs));
-        StaticVector<OctreeTracks::trackStruct*>* tracks = ott->fillOctree(maxPts, depthMapsPtsSimsTmpDir);
+        // the sub-voxels read the chunk of their top-level voxel
+        const int chunkId = (ptsSimsChunkId >= 0) ? ptsSimsChunkId : i;
+        StaticVector<OctreeTracks::trackStruct*>* tracks = ott->fillOctree(maxPts, depthMapsPtsSimsTmpDir, chunkId);
         if(mp->verbose)
             mvsUtils::printfElapsedTime(t1, "fillOctree");
         if(tracks == nullptr)
@@ -350,7 +430,7 @@ void VoxelsGrid::generateTracksForEachVoxel(StaticVector<Point3d>* Reconstructio
 
         VoxelsGrid* vgnew = new VoxelsGrid(Voxel(2, 2, 2), &(*voxels)[i * 8], mp, pc, subfn, doVisualize);
         vgnew->generateTracksForEachVoxel(ReconstructionPlan, numSubVoxs / 2, maxPts, level + 1, maxlevel,
-                                          depthMapsPtsSimsTmpDir);
+                                          depthMapsPtsSimsTmpDir, (ptsSimsChunkId >= 0) ? ptsSimsChunkId : i);
         delete vgnew;
     }
 
@@ -45,8 +45,11 @@ public:
     StaticVector<OctreeTracks::trackStruct*>* loadTracksFromVoxelFiles(StaticVector<int>** cams, int id);
     void generateCamsPtsFromVoxelsTracks();
     void generateSpace(VoxelsGrid* vgnew, const Voxel& LU, const Voxel& RD, const std::string& depthMapsPtsSimsTmpDir);
+    /// @brief Bucket once the pts/sims of all the cameras into one chunk file per voxel of this grid,
+    ///        so that each voxel (and its sub-voxels) only reads its own points in generateTracksForEachVoxel
+    void generatePtsSimsVoxelChunks(const std::string& depthMapsPtsSimsTmpDir);
     void generateTracksForEachVoxel(StaticVector<Point3d>* ReconstructionPlan, int numSubVoxs, int maxPts, int level,
-                                    int& maxlevel, const std::string& depthMapsPtsSimsTmpDir);
+                                    int& maxlevel, const std::string& depthMapsPtsSimsTmpDir, int ptsSimsChunkId = -1);
     void vizualize();
 
     void cloneSpaceVoxel(int voxelId, int numSubVoxs, VoxelsGrid* newSpace);
@@ -132,7 +132,8 @@ bool ACRansac_FindRTS(const Mat &x1,
                              Vec3 &t,
                              Mat3 &R,
                              std::vector<std::size_t> &vec_inliers,
-                             bool refine)
+                             bool refine,
+                             bool useSPRT)
 {
   assert(3 == x1.rows());
   assert(3 <= x1.cols());
@@ -152,7 +153,7 @@ bool ACRansac_FindRTS(const Mat &x1,
   KernelType kernel = KernelType(x1, x2);
   // Robust estimation of the Projection matrix and its precision
   const std::pair<double, double> ACRansacOut =
-          robustEstimation::ACRANSAC(kernel, vec_inliers, numIterations, &RTS, dPrecision, true);
+          robustEstimation::ACRANSAC(kernel, vec_inliers, numIterations, &RTS, dPrecision, true, useSPRT);
 
   const bool good = decomposeRTS(RTS, S, t, R);
 
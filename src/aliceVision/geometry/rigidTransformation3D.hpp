@@ -274,6 +274,7 @@ private:
  * @param[out] R The 3x3 rotation.
  * @param[out] vec_inliers The vector containing the indices of inliers points.
  * @param[in] refine Enable/Disable refining of the found transformation.
+ * @param[in] useSPRT Reject early the models unlikely to have more inliers than the best one (for large sets of points)
  * @return true if the found transformation is a similarity
  * @see FindRTS()
  */
@@ -283,7 +284,8 @@ bool ACRansac_FindRTS(const Mat &x1,
                       Vec3 &t,
                       Mat3 &R,
                       std::vector<std::size_t> &vec_inliers,
-                      bool refine = false);
+                      bool refine = false,
+                      bool useSPRT = false);
 
 /**
  * @brief Uses AC ransac to robustly estimate the similarity between two sets of 
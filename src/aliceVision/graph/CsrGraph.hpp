@@ -0,0 +1,258 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
+#include <aliceVision/system/TaskScheduler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace graph {
+
+/**
+ * @brief Undirected simple graph in Compressed Sparse Row format:
+ *        the sorted neighbors of all the nodes are stored in a single array.
+ *
+ * The graph is read-only, built once from pairs of node ids (self-loops and duplicated pairs are ignored).
+ * The nodes are indexed in [0, nbNodes) in the ascending order of their ids.
+ * Compared to a lemon::ListGraph, it needs a few bytes per edge and its traversals are cache friendly,
+ * for the dense view graphs of the global SfM (millions of edges).
+ */
+class CsrGraph
+{
+public:
+  template <typename IterablePairs>
+  explicit CsrGraph(const IterablePairs& pairs)
+  {
+    for(const auto& pair : pairs)
+    {
+      if(pair.first == pair.second)
+        continue;
+      _nodeIds.push_back(pair.first);
+      _nodeIds.push_back(pair.second);
+    }
+    std::sort(_nodeIds.begin(), _nodeIds.end());
+    _nodeIds.erase(std::unique(_nodeIds.begin(), _nodeIds.end()), _nodeIds.end());
+
+    // both arcs of each edge, in node indexes
+    std::vector<std::pair<IndexT, IndexT>> arcs;
+    for(const auto& pair : pairs)
+    {
+      if(pair.first == pair.second)
+        continue;
+      const IndexT i = nodeIndex(pair.first);
+      const IndexT j = nodeIndex(pair.second);
+      arcs.emplace_back(i, j);
+      arcs.emplace_back(j, i);
+    }
+    std::sort(arcs.begin(), arcs.end());
+    arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+
+    _offsets.assign(_nodeIds.size() + 1, 0);
+    _neighbors.resize(arcs.size());
+    for(std::size_t a = 0; a < arcs.size(); ++a)
+    {
+      ++_offsets[arcs[a].first + 1];
+      _neighbors[a] = arcs[a].second;
+    }
+    for(std::size_t i = 0; i < _nodeIds.size(); ++i)
+      _offsets[i + 1] += _offsets[i];
+  }
+
+  std::size_t nbNodes() const { return _nodeIds.size(); }
+  std::size_t nbEdges() const { return _neighbors.size() / 2; }
+  std::size_t nbArcs() const { return _neighbors.size(); }
+
+  /// Id of a node, given in the input pairs
+  IndexT nodeId(IndexT node) const { return _nodeIds[node]; }
+
+  /// Index of a node from its id (the id must be in the graph)
+  IndexT nodeIndex(IndexT nodeId) const
+  {
+    return static_cast<IndexT>(std::lower_bound(_nodeIds.begin(), _nodeIds.end(), nodeId) - _nodeIds.begin());
+  }
+
+  std::size_t degree(IndexT node) const { return _offsets[node + 1] - _offsets[node]; }
+
+  /// First arc of a node: the arcs of the node are in [firstArc(node), firstArc(node + 1))
+  std::size_t firstArc(IndexT node) const { return _offsets[node]; }
+
+  /// Target node of an arc
+  IndexT target(std::size_t arc) const { return _neighbors[arc]; }
+
+  /// Sorted neighbors of a node
+  const IndexT* neighborsBegin(IndexT node) const { return _neighbors.data() + _offsets[node]; }
+  const IndexT* neighborsEnd(IndexT node) const { return _neighbors.data() + _offsets[node + 1]; }
+
+  /// Arc from a node to one of its neighbors
+  std::size_t arc(IndexT from, IndexT to) const
+  {
+    return static_cast<std::size_t>(std::lower_bound(neighborsBegin(from), neighborsEnd(from), to) - _neighbors.data());
+  }
+
+private:
+  /// sorted node ids
+  std::vector<IndexT> _nodeIds;
+  /// first arc of each node, and the number of arcs at the end
+  std::vector<std::size_t> _offsets;
+  /// target node of each arc
+  std::vector<IndexT> _neighbors;
+};
+
+/**
+ * @brief Split the nodes of a graph in ranges processed in parallel
+ * @param[in] nbNodes The number of nodes
+ * @return The number of ranges: a few per thread, for load balancing
+ */
+inline int getNbNodeRanges(std::size_t nbNodes)
+{
+  const std::size_t nbRanges = 8 * static_cast<std::size_t>(system::ResourceBudget::get().getNbThreads());
+  return static_cast<int>(std::max(std::size_t(1), std::min(nbNodes, nbRanges)));
+}
+
+/**
+ * @brief Label the connected components of a graph, in parallel (concurrent union-find)
+ * @param[in] graph The graph
+ * @param[in] removedArcs Optional arcs to ignore (both arcs of an edge must be set)
+ * @return The component of each node: the smallest node index of its component
+ */
+inline std::vector<IndexT> connectedComponents(const CsrGraph& graph, const std::vector<bool>* removedArcs = nullptr)
+{
+  const std::size_t nbNodes = graph.nbNodes();
+
+  // the root of each set is its smallest node: a root is always linked under a smaller one
+  std::vector<std::atomic<IndexT>> parents(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    parents[i].store(static_cast<IndexT>(i));
+
+  const auto findRoot = [&parents](IndexT node)
+  {
+    IndexT parent = parents[node].load();
+    while(parent != node)
+    {
+      // path halving
+      const IndexT grandParent = parents[parent].load();
+      if(grandParent != parent)
+        parents[node].compare_exchange_weak(parent, grandParent);
+      node = grandParent;
+      parent = parents[node].load();
+    }
+    return node;
+  };
+
+  const int nbRanges = getNbNodeRanges(nbNodes);
+  system::parallelFor(0, nbRanges, [&](int r)
+  {
+    const IndexT begin = static_cast<IndexT>(nbNodes * r / nbRanges);
+    const IndexT end = static_cast<IndexT>(nbNodes * (r + 1) / nbRanges);
+    for(IndexT node = begin; node < end; ++node)
+    {
+      for(std::size_t a = graph.firstArc(node); a < graph.firstArc(node + 1); ++a)
+      {
+        IndexT i = node;
+        IndexT j = graph.target(a);
+        // each edge once
+        if(j < i || (removedArcs != nullptr && (*removedArcs)[a]))
+          continue;
+
+        while(true)
+        {
+          i = findRoot(i);
+          j = findRoot(j);
+          if(i == j)
+            break;
+          if(i < j)
+            std::swap(i, j);
+          IndexT expected = i;
+          if(parents[i].compare_exchange_strong(expected, j))
+            break;
+        }
+      }
+    }
+  });
+
+  std::vector<IndexT> components(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    components[i] = findRoot(static_cast<IndexT>(i));
+  return components;
+}
+
+/**
+ * @brief Find the bridges of a graph: the edges whose removal disconnects their component
+ *        (iterative Tarjan algorithm, linear in the size of the graph)
+ * @param[in] graph The graph
+ * @param[out] bridgeArcs For each arc, true if its edge is a bridge
+ * @return The number of bridges
+ */
+inline std::size_t findBridges(const CsrGraph& graph, std::vector<bool>& bridgeArcs)
+{
+  const std::size_t nbNodes = graph.nbNodes();
+  bridgeArcs.assign(graph.nbArcs(), false);
+
+  std::vector<IndexT> discovery(nbNodes, UndefinedIndexT);
+  std::vector<IndexT> low(nbNodes);
+  std::vector<IndexT> parents(nbNodes, UndefinedIndexT);
+  std::vector<std::size_t> nextArcs(nbNodes);
+  std::vector<IndexT> stack;
+  IndexT time = 0;
+  std::size_t nbBridges = 0;
+
+  for(IndexT root = 0; root < nbNodes; ++root)
+  {
+    if(discovery[root] != UndefinedIndexT)
+      continue;
+
+    discovery[root] = low[root] = time++;
+    nextArcs[root] = graph.firstArc(root);
+    stack.push_back(root);
+
+    while(!stack.empty())
+    {
+      const IndexT node = stack.back();
+      if(nextArcs[node] < graph.firstArc(node + 1))
+      {
+        const IndexT neighbor = graph.target(nextArcs[node]++);
+        if(neighbor == parents[node])
+          continue;
+        if(discovery[neighbor] == UndefinedIndexT)
+        {
+          parents[neighbor] = node;
+          discovery[neighbor] = low[neighbor] = time++;
+          nextArcs[neighbor] = graph.firstArc(neighbor);
+          stack.push_back(neighbor);
+        }
+        else
+        {
+          low[node] = std::min(low[node], discovery[neighbor]);
+        }
+        continue;
+      }
+
+      stack.pop_back();
+      const IndexT parent = parents[node];
+      if(parent == UndefinedIndexT)
+        continue;
+      low[parent] = std::min(low[parent], low[node]);
+      if(low[node] > discovery[parent])
+      {
+        bridgeArcs[graph.arc(parent, node)] = true;
+        bridgeArcs[graph.arc(node, parent)] = true;
+        ++nbBridges;
+      }
+    }
+  }
+  return nbBridges;
+}
+
+} // namespace graph
+} // namespace aliceVision
@@ -9,10 +9,12 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/graph/graph.hpp>
+#include <aliceVision/graph/CsrGraph.hpp>
 
 #include <lemon/list_graph.h>
 
 #include <algorithm>
+#include <tuple>
 #include <vector>
 
 using namespace lemon;
@@ -119,30 +121,113 @@ bool List_Triplets(const GraphT & g, std::vector< Triplet > & vec_triplets)
   return (!vec_triplets.empty());
 }
 
-/// Return triplets contained in the graph build from IterablePairs
-template <typename IterablePairs>
-inline std::vector< graph::Triplet > tripletListing(
-  const IterablePairs & pairs)
+/**
+ * @brief List all the triplets (triangles) of a graph, in parallel.
+ *
+ * Each triangle is found once from its lowest node in the (degree, index) order:
+ * the edges are oriented from the lower to the higher node in this order, and the
+ * triangles of a node are the intersections of its out-neighbors with theirs.
+ * This bounds the work per node by the square root of the number of edges.
+ *
+ * @param[in] graph The graph
+ * @return The triplets of node ids (i < j < k), sorted
+ */
+inline std::vector<Triplet> listTriplets(const CsrGraph& graph)
 {
-  std::vector< graph::Triplet > vec_triplets;
+  const std::size_t nbNodes = graph.nbNodes();
+
+  // rank of the nodes in the (degree, index) order
+  std::vector<IndexT> order(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    order[i] = static_cast<IndexT>(i);
+  std::sort(order.begin(), order.end(), [&graph](IndexT a, IndexT b)
+  {
+    return std::make_pair(graph.degree(a), a) < std::make_pair(graph.degree(b), b);
+  });
+  std::vector<IndexT> ranks(nbNodes);
+  for(std::size_t r = 0; r < nbNodes; ++r)
+    ranks[order[r]] = static_cast<IndexT>(r);
+
+  // out-neighbors of the oriented graph, sorted by index
+  std::vector<std::size_t> outOffsets(nbNodes + 1, 0);
+  std::vector<IndexT> outNeighbors;
+  outNeighbors.reserve(graph.nbEdges());
+  for(IndexT node = 0; node < nbNodes; ++node)
+  {
+    for(const IndexT* it = graph.neighborsBegin(node); it != graph.neighborsEnd(node); ++it)
+    {
+      if(ranks[*it] > ranks[node])
+        outNeighbors.push_back(*it);
+    }
+    outOffsets[node + 1] = outNeighbors.size();
+  }
+
+  const int nbRanges = getNbNodeRanges(nbNodes);
+  std::vector<std::vector<Triplet>> trianglesPerRange(nbRanges);
+
+  system::parallelFor(0, nbRanges, [&](int r)
+  {
+    std::vector<Triplet>& triangles = trianglesPerRange[r];
+    const IndexT begin = static_cast<IndexT>(nbNodes * r / nbRanges);
+    const IndexT end = static_cast<IndexT>(nbNodes * (r + 1) / nbRanges);
+
+    for(IndexT u = begin; u < end; ++u)
+    {
+      const IndexT* uBegin = outNeighbors.data() + outOffsets[u];
+      const IndexT* uEnd = outNeighbors.data() + outOffsets[u + 1];
 
-  indexedGraph putativeGraph(pairs);
+      for(const IndexT* itV = uBegin; itV != uEnd; ++itV)
+      {
+        const IndexT v = *itV;
+        const IndexT* itU = uBegin;
+        const IndexT* itW = outNeighbors.data() + outOffsets[v];
+        const IndexT* vEnd = outNeighbors.data() + outOffsets[v + 1];
+
+        // sorted intersection of the out-neighbors of u and v
+        while(itU != uEnd && itW != vEnd)
+        {
+          if(*itU < *itW)
+            ++itU;
+          else if(*itW < *itU)
+            ++itW;
+          else
+          {
+            IndexT triplet[3] = {graph.nodeId(u), graph.nodeId(v), graph.nodeId(*itW)};
+            std::sort(&triplet[0], &triplet[3]);
+            triangles.emplace_back(triplet[0], triplet[1], triplet[2]);
+            ++itU;
+            ++itW;
+          }
+        }
+      }
+    }
+  });
 
-  graph::List_Triplets<indexedGraph::GraphT>(putativeGraph.g, vec_triplets);
+  std::size_t nbTriplets = 0;
+  for(const std::vector<Triplet>& triangles : trianglesPerRange)
+    nbTriplets += triangles.size();
 
-  //Change triplets to ImageIds
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  std::vector<Triplet> triplets;
+  triplets.reserve(nbTriplets);
+  for(std::vector<Triplet>& triangles : trianglesPerRange)
   {
-    graph::Triplet & triplet = vec_triplets[i];
-    IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-    I = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(I)];
-    J = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(J)];
-    K = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(K)];
-    IndexT triplet_[3] = { I, J, K };
-    std::sort(&triplet_[0], &triplet_[3]);
-    triplet = graph::Triplet(triplet_[0],triplet_[1],triplet_[2]);
+    triplets.insert(triplets.end(), triangles.begin(), triangles.end());
+    std::vector<Triplet>().swap(triangles);
   }
-  return vec_triplets;
+
+  std::sort(triplets.begin(), triplets.end(), [](const Triplet& a, const Triplet& b)
+  {
+    return std::tie(a.i, a.j, a.k) < std::tie(b.i, b.j, b.k);
+  });
+  return triplets;
+}
+
+/// Return triplets contained in the graph build from IterablePairs
+template <typename IterablePairs>
+inline std::vector< graph::Triplet > tripletListing(
+  const IterablePairs & pairs)
+{
+  return listTriplets(CsrGraph(pairs));
 }
 
 } // namespace graph
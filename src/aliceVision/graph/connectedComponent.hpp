@@ -11,7 +11,9 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/graph/graph.hpp>
+#include <aliceVision/graph/CsrGraph.hpp>
 
+#include <map>
 #include <set>
 
 namespace aliceVision {
@@ -50,84 +52,50 @@ std::set<IndexT> CleanGraph_KeepLargestBiEdge_Nodes(
   // - remove not biedge connected component,
   // - keep the largest connected component.
 
-  typedef lemon::ListGraph Graph;
-  graph::indexedGraph putativeGraph(edges);
+  const CsrGraph graph(edges);
 
   // Remove not bi-edge connected edges
-  typedef Graph::EdgeMap<bool> EdgeMapAlias;
-  EdgeMapAlias cutMap(putativeGraph.g);
-
-  if (lemon::biEdgeConnectedCutEdges(putativeGraph.g, cutMap) > 0)
-  {
-    // Some edges must be removed because they don't follow the biEdge condition.
-    typedef Graph::EdgeIt EdgeIterator;
-    EdgeIterator itEdge(putativeGraph.g);
-    for (EdgeMapAlias::MapIt it(cutMap); it!=lemon::INVALID; ++it, ++itEdge)
-    {
-      if (*it)
-        putativeGraph.g.erase(itEdge); // remove the not bi-edge element
-    }
-  }
+  std::vector<bool> cutArcs;
+  const std::size_t nbCutEdges = findBridges(graph, cutArcs);
 
   // Graph is bi-edge connected, but still many connected components can exist
   // Keep only the largest one
-  const int connectedComponentCount = lemon::countConnectedComponents(putativeGraph.g);
+  const std::vector<aliceVision::IndexT> components = connectedComponents(graph, &cutArcs);
+
+  std::map<aliceVision::IndexT, std::size_t> componentSizes;
+  for(const aliceVision::IndexT component : components)
+    ++componentSizes[component];
+
   ALICEVISION_LOG_DEBUG("CleanGraph_KeepLargestBiEdge_Nodes():: => connected Component: "
-    << connectedComponentCount);
-  if (connectedComponentCount >= 1)
+    << componentSizes.size());
+
+  std::size_t count = 0;
+  aliceVision::IndexT largestComponent = UndefinedIndexT;
+  for(const auto& componentSize : componentSizes)
   {
-    // Keep only the largest connected component
-    // - list all CC size
-    // - if the largest one is meet, keep all the edges that belong to this node
-
-    const std::map<IndexT, std::set<Graph::Node> > map_subgraphs = exportGraphToMapSubgraphs<Graph,IndexT>(putativeGraph.g);
-    size_t count = std::numeric_limits<size_t>::min();
-    typename std::map<IndexT, std::set<Graph::Node> >::const_iterator iterLargestCC = map_subgraphs.end();
-    for(typename std::map<IndexT, std::set<Graph::Node> >::const_iterator iter = map_subgraphs.begin();
-        iter != map_subgraphs.end(); ++iter)
+    if(componentSize.second > count)
     {
-      if (iter->second.size() > count)  {
-        count = iter->second.size();
-        iterLargestCC = iter;
-      }
-      ALICEVISION_LOG_DEBUG("Connected component of size: " << iter->second.size());
+      count = componentSize.second;
+      largestComponent = componentSize.first;
     }
+    ALICEVISION_LOG_DEBUG("Connected component of size: " << componentSize.second);
+  }
 
-    //-- Keep only the nodes that are in the largest CC
-    for(typename std::map<IndexT, std::set<lemon::ListGraph::Node> >::const_iterator iter = map_subgraphs.begin();
-        iter != map_subgraphs.end(); ++iter)
-    {
-      if (iter == iterLargestCC)
-      {
-        // list all nodes that belong to the current CC and update the Node Ids list
-        const std::set<lemon::ListGraph::Node> & ccSet = iter->second;
-        for (std::set<lemon::ListGraph::Node>::const_iterator iter2 = ccSet.begin();
-          iter2 != ccSet.end(); ++iter2)
-        {
-          const IndexT Id = (*putativeGraph.map_nodeMapIndex)[*iter2];
-          largestBiEdgeCC.insert(Id);
-        }
-      }
-      else
-      {
-        // remove the edges from the graph
-        const std::set<lemon::ListGraph::Node> & ccSet = iter->second;
-        for (std::set<lemon::ListGraph::Node>::const_iterator iter2 = ccSet.begin();
-          iter2 != ccSet.end(); ++iter2)
-        {
-          typedef Graph::OutArcIt OutArcIt;
-          for (OutArcIt e(putativeGraph.g, *iter2); e!=lemon::INVALID; ++e)
-          {
-            putativeGraph.g.erase(e);
-          }
-        }
-      }
-    }
+  // Keep only the nodes that are in the largest CC
+  std::size_t nbEdges = 0;
+  for(aliceVision::IndexT node = 0; node < graph.nbNodes(); ++node)
+  {
+    if(components[node] != largestComponent)
+      continue;
+    largestBiEdgeCC.insert(static_cast<IndexT>(graph.nodeId(node)));
+    for(std::size_t a = graph.firstArc(node); a < graph.firstArc(node + 1); ++a)
+      nbEdges += cutArcs[a] ? 0 : 1;
   }
 
   ALICEVISION_LOG_DEBUG(
-    "Cardinal of nodes: " << lemon::countNodes(putativeGraph.g) << "\n" <<
-    "Cardinal of edges: " << lemon::countEdges(putativeGraph.g)
+    "Cardinal of cut edges: " << nbCutEdges << "\n" <<
+    "Cardinal of nodes: " << largestBiEdgeCC.size() << "\n" <<
+    "Cardinal of edges: " << nbEdges / 2
     );
 
   return largestBiEdgeCC;
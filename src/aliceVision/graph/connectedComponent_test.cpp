@@ -110,3 +110,31 @@ BOOST_AUTO_TEST_CASE(exportGraphToMapSubgraphs_CC_Subgraph) {
   BOOST_CHECK_EQUAL(2, map_subgraphs.at(2).size());
   BOOST_CHECK_EQUAL(1, map_subgraphs.at(3).size());
 }
+
+/// Test the connected components and the bridges of a CSR graph
+// a-b  c-d-e
+//        |/
+//        f
+BOOST_AUTO_TEST_CASE(CsrGraph_CC_Bridges) {
+  const std::vector<aliceVision::Pair> pairs = {{1,2}, {3,4}, {4,5}, {5,6}, {6,4}, {4,3}, {7,7}};
+  const aliceVision::graph::CsrGraph graph(pairs);
+
+  BOOST_CHECK_EQUAL(6, graph.nbNodes());
+  BOOST_CHECK_EQUAL(5, graph.nbEdges());
+
+  const std::vector<aliceVision::IndexT> components = aliceVision::graph::connectedComponents(graph);
+  BOOST_CHECK_EQUAL(components[graph.nodeIndex(1)], components[graph.nodeIndex(2)]);
+  BOOST_CHECK_EQUAL(components[graph.nodeIndex(3)], components[graph.nodeIndex(6)]);
+  BOOST_CHECK_NE(components[graph.nodeIndex(1)], components[graph.nodeIndex(3)]);
+
+  std::vector<bool> bridgeArcs;
+  BOOST_CHECK_EQUAL(2, aliceVision::graph::findBridges(graph, bridgeArcs));
+  BOOST_CHECK(bridgeArcs[graph.arc(graph.nodeIndex(1), graph.nodeIndex(2))]);
+  BOOST_CHECK(bridgeArcs[graph.arc(graph.nodeIndex(4), graph.nodeIndex(3))]);
+  BOOST_CHECK(!bridgeArcs[graph.arc(graph.nodeIndex(4), graph.nodeIndex(5))]);
+
+  // the largest bi-edge connected component is d-e-f
+  const std::set<aliceVision::IndexT> largestBiEdgeCC =
+    aliceVision::graph::CleanGraph_KeepLargestBiEdge_Nodes<std::vector<aliceVision::Pair>, aliceVision::IndexT>(pairs);
+  BOOST_CHECK(largestBiEdgeCC == std::set<aliceVision::IndexT>({4, 5, 6}));
+}
@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace graph {
+
+/**
+ * @brief Select a sparse and redundant subset of a weighted pair graph.
+ *
+ * 1. A maximum spanning tree (Kruskal) is extracted using the pair weights (e.g. the number of matches),
+ * 2. each edge (i,j) of the tree is closed by the triangles (i,j,k) of the strongest common neighbors k,
+ *    the strength of a triangle being the weakest of its two added edges (i,k) and (j,k).
+ *
+ * Closing the tree edges with triangles avoids cut edges in the selection,
+ * so it survives the bi-edge connectivity and triplet based filters of the global SfM.
+ *
+ * @param[in] weightedPairs The pairs of the graph with their weight (the pair order is free)
+ * @param[in] nbTrianglesPerEdge The number of triangles used to close each tree edge
+ * @return The selected pairs (as given in weightedPairs)
+ */
+template<typename WeightT>
+PairSet selectSpanningPairs(const std::map<Pair, WeightT>& weightedPairs, std::size_t nbTrianglesPerEdge = 1)
+{
+  typedef std::pair<WeightT, Pair> WeightedEdge;
+
+  // Undirected edges (i < j) and the corresponding input pair
+  std::map<Pair, Pair> inputPairPerEdge;
+  std::map<IndexT, std::map<IndexT, WeightT>> adjacency;
+  std::vector<WeightedEdge> edges;
+  edges.reserve(weightedPairs.size());
+
+  for(const auto& weightedPair : weightedPairs)
+  {
+    const Pair& pair = weightedPair.first;
+    if(pair.first == pair.second)
+      continue;
+    const Pair edge(std::min(pair.first, pair.second), std::max(pair.first, pair.second));
+    if(!inputPairPerEdge.emplace(edge, pair).second)
+      continue;
+    adjacency[edge.first][edge.second] = weightedPair.second;
+    adjacency[edge.second][edge.first] = weightedPair.second;
+    edges.emplace_back(weightedPair.second, edge);
+  }
+
+  // Strongest edges first (ties are broken by the pair order to be deterministic)
+  std::sort(edges.begin(), edges.end(), [](const WeightedEdge& a, const WeightedEdge& b)
+  {
+    return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+  });
+
+  // Maximum spanning tree (union-find with path halving)
+  std::map<IndexT, IndexT> parent;
+  for(const auto& node : adjacency)
+    parent[node.first] = node.first;
+
+  const auto findRoot = [&parent](IndexT node)
+  {
+    while(parent[node] != node)
+    {
+      parent[node] = parent[parent[node]];
+      node = parent[node];
+    }
+    return node;
+  };
+
+  PairSet selectedEdges;
+  std::vector<Pair> treeEdges;
+  for(const WeightedEdge& edge : edges)
+  {
+    const IndexT rootI = findRoot(edge.second.first);
+    const IndexT rootJ = findRoot(edge.second.second);
+    if(rootI == rootJ)
+      continue;
+    parent[rootI] = rootJ;
+    treeEdges.push_back(edge.second);
+    selectedEdges.insert(edge.second);
+  }
+
+  // Close each tree edge with the strongest triangles
+  if(nbTrianglesPerEdge > 0)
+  {
+    std::vector<std::pair<WeightT, IndexT>> commonNeighbors;
+    for(const Pair& treeEdge : treeEdges)
+    {
+      const std::map<IndexT, WeightT>& neighborsI = adjacency.at(treeEdge.first);
+      const std::map<IndexT, WeightT>& neighborsJ = adjacency.at(treeEdge.second);
+
+      commonNeighbors.clear();
+      for(const auto& neighborI : neighborsI)
+      {
+        const auto neighborJIt = neighborsJ.find(neighborI.first);
+        if(neighborJIt != neighborsJ.end())
+          commonNeighbors.emplace_back(std::min(neighborI.second, neighborJIt->second), neighborI.first);
+      }
+
+      const std::size_t nbTriangles = std::min(nbTrianglesPerEdge, commonNeighbors.size());
+      std::partial_sort(commonNeighbors.begin(), commonNeighbors.begin() + nbTriangles, commonNeighbors.end(),
+        [](const std::pair<WeightT, IndexT>& a, const std::pair<WeightT, IndexT>& b)
+        {
+          return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+        });
+
+      for(std::size_t t = 0; t < nbTriangles; ++t)
+      {
+        const IndexT k = commonNeighbors[t].second;
+        selectedEdges.emplace(std::min(treeEdge.first, k), std::max(treeEdge.first, k));
+        selectedEdges.emplace(std::min(treeEdge.second, k), std::max(treeEdge.second, k));
+      }
+    }
+  }
+
+  PairSet selectedPairs;
+  for(const Pair& edge : selectedEdges)
+    selectedPairs.insert(inputPairPerEdge.at(edge));
+  return selectedPairs;
+}
+
+} // namespace graph
+} // namespace aliceVision
@@ -0,0 +1,81 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/graph/pairSelection.hpp"
+
+#include <iostream>
+#include <map>
+#include <set>
+
+#define BOOST_TEST_MODULE pairSelection
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::graph;
+
+BOOST_AUTO_TEST_CASE(PairSelection_spanningTree)
+{
+  // a_b_c_d chain: the tree is the whole graph, no triangle can be added
+  std::map<Pair, std::size_t> weightedPairs;
+  weightedPairs[Pair(0, 1)] = 10;
+  weightedPairs[Pair(1, 2)] = 20;
+  weightedPairs[Pair(3, 2)] = 30;
+
+  const PairSet selectedPairs = selectSpanningPairs(weightedPairs, 1);
+  BOOST_CHECK_EQUAL(selectedPairs.size(), 3);
+  BOOST_CHECK(selectedPairs.count(Pair(3, 2))); // input order is kept
+}
+
+BOOST_AUTO_TEST_CASE(PairSelection_maximumSpanningTree)
+{
+  // complete graph of 4 nodes, the tree is made of the edges linked to node 0
+  std::map<Pair, std::size_t> weightedPairs;
+  weightedPairs[Pair(0, 1)] = 100;
+  weightedPairs[Pair(0, 2)] = 90;
+  weightedPairs[Pair(0, 3)] = 80;
+  weightedPairs[Pair(1, 2)] = 10;
+  weightedPairs[Pair(1, 3)] = 5;
+  weightedPairs[Pair(2, 3)] = 1;
+
+  const PairSet tree = selectSpanningPairs(weightedPairs, 0);
+  BOOST_CHECK_EQUAL(tree.size(), 3);
+  BOOST_CHECK(tree.count(Pair(0, 1)));
+  BOOST_CHECK(tree.count(Pair(0, 2)));
+  BOOST_CHECK(tree.count(Pair(0, 3)));
+
+  // one triangle per tree edge: (0,1,2), (0,2,1) and (0,3,1)
+  const PairSet selectedPairs = selectSpanningPairs(weightedPairs, 1);
+  BOOST_CHECK_EQUAL(selectedPairs.size(), 5);
+  BOOST_CHECK(selectedPairs.count(Pair(1, 2)));
+  BOOST_CHECK(selectedPairs.count(Pair(1, 3)));
+  BOOST_CHECK(!selectedPairs.count(Pair(2, 3)));
+
+  // all the triangles: the whole graph
+  BOOST_CHECK_EQUAL(selectSpanningPairs(weightedPairs, 2).size(), weightedPairs.size());
+}
+
+BOOST_AUTO_TEST_CASE(PairSelection_denseGraph)
+{
+  // complete graph: the selection stays linear in the number of nodes
+  const IndexT nbNodes = 50;
+  std::map<Pair, std::size_t> weightedPairs;
+  for(IndexT i = 0; i < nbNodes; ++i)
+    for(IndexT j = i + 1; j < nbNodes; ++j)
+      weightedPairs[Pair(i, j)] = 1000 - (j - i) * 10 + (i % 7);
+
+  const PairSet selectedPairs = selectSpanningPairs(weightedPairs, 1);
+  BOOST_CHECK_LE(selectedPairs.size(), 3 * (nbNodes - 1));
+
+  // all the nodes are covered
+  std::set<IndexT> nodes;
+  for(const Pair& pair : selectedPairs)
+  {
+    nodes.insert(pair.first);
+    nodes.insert(pair.second);
+  }
+  BOOST_CHECK_EQUAL(nodes.size(), nbNodes);
+}
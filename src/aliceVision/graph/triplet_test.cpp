@@ -7,7 +7,10 @@
 
 #include "aliceVision/graph/Triplet.hpp"
 
+#include <cstdlib>
 #include <iostream>
+#include <set>
+#include <tuple>
 #include <vector>
 
 #define BOOST_TEST_MODULE tripletFinder
@@ -268,3 +271,43 @@ BOOST_AUTO_TEST_CASE(test_for_triplet) {
     BOOST_CHECK_EQUAL(4, vec_triplets.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(test_csr_triplet_listing) {
+
+  // random graph with duplicated pairs and self-loops
+  std::vector<std::pair<aliceVision::IndexT, aliceVision::IndexT>> pairs;
+  std::srand(0);
+  for (int e = 0; e < 2000; ++e)
+    pairs.emplace_back(10 + std::rand() % 100, 10 + std::rand() % 100);
+
+  // reference: lemon graph of the unique edges
+  std::set<aliceVision::Pair> uniquePairs;
+  for (const auto & pair : pairs)
+    if (pair.first != pair.second)
+      uniquePairs.insert(std::make_pair(std::min(pair.first, pair.second), std::max(pair.first, pair.second)));
+
+  indexedGraph putativeGraph(uniquePairs);
+  std::vector< Triplet > vec_expected;
+  List_Triplets<indexedGraph::GraphT>(putativeGraph.g, vec_expected);
+
+  const std::vector< Triplet > vec_triplets = tripletListing(pairs);
+  BOOST_CHECK_EQUAL(vec_expected.size(), vec_triplets.size());
+
+  std::set<std::tuple<aliceVision::IndexT, aliceVision::IndexT, aliceVision::IndexT>> expected, triplets;
+  for (const Triplet & t : vec_expected)
+  {
+    aliceVision::IndexT ids[3] = {
+      (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(t.i)],
+      (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(t.j)],
+      (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(t.k)]};
+    std::sort(&ids[0], &ids[3]);
+    expected.insert(std::make_tuple(ids[0], ids[1], ids[2]));
+  }
+  for (const Triplet & t : vec_triplets)
+  {
+    BOOST_CHECK(t.i < t.j && t.j < t.k);
+    triplets.insert(std::make_tuple(t.i, t.j, t.k));
+  }
+  BOOST_CHECK_EQUAL(vec_triplets.size(), triplets.size());
+  BOOST_CHECK(expected == triplets);
+}
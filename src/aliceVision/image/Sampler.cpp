@@ -0,0 +1,252 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Sampler.hpp"
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define ALICEVISION_SAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aliceVision {
+namespace image {
+
+namespace {
+
+/// bilinear neighborhood of a position whose 4 neighbors are in the image
+struct LinearTap
+{
+  std::size_t offset; // offset of the top left neighbor
+  float fx;
+  float fy;
+};
+
+inline bool isInterior(float x, float y, int width, int height)
+{
+  return x >= 0.f && y >= 0.f && x < width - 1 && y < height - 1;
+}
+
+inline LinearTap makeTap(float x, float y, int width)
+{
+  const int x0 = static_cast<int>(x);
+  const int y0 = static_cast<int>(y);
+  return LinearTap{static_cast<std::size_t>(y0) * width + x0, x - x0, y - y0};
+}
+
+// pixel conversions between the image and the float interpolation
+
+inline float toReal(float v) { return v; }
+inline float toReal(unsigned char v) { return v; }
+
+inline void fromReal(float v, float& out) { out = v; }
+inline void fromReal(float v, unsigned char& out)
+{
+  // same rounding as RealPixel<unsigned char>
+  out = (v < 0.f) ? 0 : ((v > 255.f) ? 255 : static_cast<unsigned char>(v + 0.5f));
+}
+
+/// bilinear interpolation of a single channel image
+template<typename T>
+inline void interpolate(const T* data, int width, const LinearTap& tap, T& out)
+{
+  const T* p = data + tap.offset;
+  const float top = toReal(p[0]) + tap.fx * (toReal(p[1]) - toReal(p[0]));
+  const float bottom = toReal(p[width]) + tap.fx * (toReal(p[width + 1]) - toReal(p[width]));
+  fromReal(top + tap.fy * (bottom - top), out);
+}
+
+/// bilinear interpolation of a RGB image
+template<typename T>
+inline void interpolate(const Rgb<T>* data, int width, const LinearTap& tap, Rgb<T>& out)
+{
+  const Rgb<T>* p = data + tap.offset;
+  for(int c = 0; c < 3; ++c)
+  {
+    const float top = toReal(p[0](c)) + tap.fx * (toReal(p[1](c)) - toReal(p[0](c)));
+    const float bottom = toReal(p[width](c)) + tap.fx * (toReal(p[width + 1](c)) - toReal(p[width](c)));
+    fromReal(top + tap.fy * (bottom - top), out(c));
+  }
+}
+
+#ifdef ALICEVISION_SAMPLER_SSE2
+
+inline __m128 gather(const float* p, const std::size_t* offsets, std::ptrdiff_t delta)
+{
+  return _mm_setr_ps(p[offsets[0] + delta], p[offsets[1] + delta], p[offsets[2] + delta], p[offsets[3] + delta]);
+}
+
+inline __m128 gather(const unsigned char* p, const std::size_t* offsets, std::ptrdiff_t delta)
+{
+  return _mm_cvtepi32_ps(_mm_setr_epi32(p[offsets[0] + delta], p[offsets[1] + delta], p[offsets[2] + delta], p[offsets[3] + delta]));
+}
+
+inline void store4(__m128 v, float* out)
+{
+  _mm_storeu_ps(out, v);
+}
+
+inline void store4(__m128 v, unsigned char* out)
+{
+  // the values are in [0, 255], the interpolation weights sum to 1
+  const __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+  const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(rounded, rounded), _mm_setzero_si128());
+  const int bytes = _mm_cvtsi128_si32(packed);
+  out[0] = static_cast<unsigned char>(bytes);
+  out[1] = static_cast<unsigned char>(bytes >> 8);
+  out[2] = static_cast<unsigned char>(bytes >> 16);
+  out[3] = static_cast<unsigned char>(bytes >> 24);
+}
+
+/// bilinear interpolation of 4 positions of a single channel image, the 4 lanes in parallel
+template<typename T>
+inline void interpolate4(const T* data, int width, const std::size_t* offsets, __m128 fx, __m128 fy, T* out)
+{
+  const __m128 p00 = gather(data, offsets, 0);
+  const __m128 p01 = gather(data, offsets, 1);
+  const __m128 p10 = gather(data, offsets, width);
+  const __m128 p11 = gather(data, offsets, width + 1);
+  const __m128 top = _mm_add_ps(p00, _mm_mul_ps(fx, _mm_sub_ps(p01, p00)));
+  const __m128 bottom = _mm_add_ps(p10, _mm_mul_ps(fx, _mm_sub_ps(p11, p10)));
+  store4(_mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bottom, top))), out);
+}
+
+inline __m128 loadRgb(const Rgb<float>& p)
+{
+  return _mm_setr_ps(p(0), p(1), p(2), 0.f);
+}
+
+inline __m128 loadRgb(const Rgb<unsigned char>& p)
+{
+  return _mm_cvtepi32_ps(_mm_setr_epi32(p(0), p(1), p(2), 0));
+}
+
+inline void storeRgb(__m128 v, Rgb<float>& out)
+{
+  alignas(16) float values[4];
+  _mm_store_ps(values, v);
+  out = Rgb<float>(values[0], values[1], values[2]);
+}
+
+inline void storeRgb(__m128 v, Rgb<unsigned char>& out)
+{
+  alignas(16) std::int32_t values[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f))));
+  out = Rgb<unsigned char>(values[0], values[1], values[2]);
+}
+
+/// bilinear interpolation of 4 positions of a RGB image, the channels of each position in parallel
+template<typename T>
+inline void interpolate4(const Rgb<T>* data, int width, const std::size_t* offsets, __m128 fx, __m128 fy, Rgb<T>* out)
+{
+  alignas(16) float fxs[4];
+  alignas(16) float fys[4];
+  _mm_store_ps(fxs, fx);
+  _mm_store_ps(fys, fy);
+
+  for(int lane = 0; lane < 4; ++lane)
+  {
+    const Rgb<T>* p = data + offsets[lane];
+    const __m128 vfx = _mm_set1_ps(fxs[lane]);
+    const __m128 vfy = _mm_set1_ps(fys[lane]);
+    const __m128 p00 = loadRgb(p[0]);
+    const __m128 p10 = loadRgb(p[width]);
+    const __m128 top = _mm_add_ps(p00, _mm_mul_ps(vfx, _mm_sub_ps(loadRgb(p[1]), p00)));
+    const __m128 bottom = _mm_add_ps(p10, _mm_mul_ps(vfx, _mm_sub_ps(loadRgb(p[width + 1]), p10)));
+    storeRgb(_mm_add_ps(top, _mm_mul_ps(vfy, _mm_sub_ps(bottom, top))), out[lane]);
+  }
+}
+
+#endif
+
+template<typename T>
+void sampleSpanLinear(const Sampler2d<SamplerLinear>& sampler, const Image<T>& src, const float* xy, int count, T* out)
+{
+  const int width = src.Width();
+  const int height = src.Height();
+  const T* data = src.data();
+
+  // positions at the borders or outside of the image: generic sampler
+  const auto sampleGeneric = [&](int i)
+  {
+    const float x = xy[2 * i];
+    const float y = xy[2 * i + 1];
+    if(isInterior(x, y, width, height))
+      interpolate(data, width, makeTap(x, y, width), out[i]);
+    else if(src.Contains(y, x))
+      out[i] = sampler(src, y, x);
+  };
+
+  int i = 0;
+#ifdef ALICEVISION_SAMPLER_SSE2
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 maxX = _mm_set1_ps(static_cast<float>(width - 1));
+  const __m128 maxY = _mm_set1_ps(static_cast<float>(height - 1));
+
+  for(; i + 4 <= count; i += 4)
+  {
+    // deinterleave the coordinates
+    const __m128 xy01 = _mm_loadu_ps(xy + 2 * i);
+    const __m128 xy23 = _mm_loadu_ps(xy + 2 * i + 4);
+    const __m128 x = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 y = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1));
+
+    const __m128 interior = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, zero), _mm_cmpge_ps(y, zero)),
+                                       _mm_and_ps(_mm_cmplt_ps(x, maxX), _mm_cmplt_ps(y, maxY)));
+    if(_mm_movemask_ps(interior) != 0xF)
+    {
+      for(int lane = 0; lane < 4; ++lane)
+        sampleGeneric(i + lane);
+      continue;
+    }
+
+    // the coordinates are positive: truncation is floor
+    const __m128i x0 = _mm_cvttps_epi32(x);
+    const __m128i y0 = _mm_cvttps_epi32(y);
+    const __m128 fx = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+    const __m128 fy = _mm_sub_ps(y, _mm_cvtepi32_ps(y0));
+
+    alignas(16) std::int32_t xs[4];
+    alignas(16) std::int32_t ys[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(xs), x0);
+    _mm_store_si128(reinterpret_cast<__m128i*>(ys), y0);
+    std::size_t offsets[4];
+    for(int lane = 0; lane < 4; ++lane)
+      offsets[lane] = static_cast<std::size_t>(ys[lane]) * width + xs[lane];
+
+    interpolate4(data, width, offsets, fx, fy, out + i);
+  }
+#endif
+  for(; i < count; ++i)
+    sampleGeneric(i);
+}
+
+} // namespace
+
+void SampleSpan(const Sampler2d<SamplerLinear>& sampler, const Image<float>& src, const float* xy, int count, float* out)
+{
+  sampleSpanLinear(sampler, src, xy, count, out);
+}
+
+void SampleSpan(const Sampler2d<SamplerLinear>& sampler, const Image<unsigned char>& src, const float* xy, int count, unsigned char* out)
+{
+  sampleSpanLinear(sampler, src, xy, count, out);
+}
+
+void SampleSpan(const Sampler2d<SamplerLinear>& sampler, const Image<RGBColor>& src, const float* xy, int count, RGBColor* out)
+{
+  sampleSpanLinear(sampler, src, xy, count, out);
+}
+
+void SampleSpan(const Sampler2d<SamplerLinear>& sampler, const Image<RGBfColor>& src, const float* xy, int count, RGBfColor* out)
+{
+  sampleSpanLinear(sampler, src, xy, count, out);
+}
+
+} // namespace image
+} // namespace aliceVision
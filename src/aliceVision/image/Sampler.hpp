@@ -493,5 +493,35 @@ private:
   const int _half_width ;
 };
 
+/**
+ ** Sample an image at a span of positions
+ ** The positions outside the image domain (see Image::Contains) are skipped: their output value is unchanged.
+ ** @param sampler Sampler
+ ** @param src Input image
+ ** @param xy Interleaved (x, y) coordinates of the count positions
+ ** @param count Number of positions
+ ** @param out Output values (count values)
+ **/
+template <typename SamplerFunc, typename T>
+void SampleSpan( const Sampler2d<SamplerFunc> & sampler , const Image<T> & src , const float * xy , int count , T * out )
+{
+  for( int i = 0 ; i < count ; ++i )
+  {
+    const float x = xy[ 2 * i ] ;
+    const float y = xy[ 2 * i + 1 ] ;
+    if( src.Contains( y , x ) )
+      out[ i ] = sampler( src , y , x ) ;
+  }
+}
+
+/**
+ ** Bilinear sampling of a span of positions, vectorized (SSE2) for the positions whose 4 neighbors are in the image.
+ ** Same results as the generic sampler, up to the float rounding (the generic sampler computes in double).
+ **/
+void SampleSpan( const Sampler2d<SamplerLinear> & sampler , const Image<float> & src , const float * xy , int count , float * out ) ;
+void SampleSpan( const Sampler2d<SamplerLinear> & sampler , const Image<unsigned char> & src , const float * xy , int count , unsigned char * out ) ;
+void SampleSpan( const Sampler2d<SamplerLinear> & sampler , const Image<RGBColor> & src , const float * xy , int count , RGBColor * out ) ;
+void SampleSpan( const Sampler2d<SamplerLinear> & sampler , const Image<RGBfColor> & src , const float * xy , int count , RGBfColor * out ) ;
+
 } // namespace image
 } // namespace aliceVision
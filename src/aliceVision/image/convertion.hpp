@@ -62,7 +62,7 @@ inline void Convert<RGBAColor, RGBColor>(
 template<typename ImageIn, typename ImageOut>
 void ConvertPixelType(const ImageIn& imaIn, ImageOut *imaOut)
 {
-  (*imaOut) = ImageOut(imaIn.Width(), imaIn.Height());
+  imaOut->resize(imaIn.Width(), imaIn.Height(), false);
   // Convert each input pixel to destination pixel
   for(int j = 0; j < imaIn.Height(); ++j)
     for(int i = 0; i < imaIn.Width(); ++i)
@@ -7,72 +7,259 @@
 
 #include "convolution.hpp"
 
+#include <algorithm>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define ALICEVISION_CONVOLUTION_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace aliceVision {
 namespace image {
 
+namespace {
+
+/// rows of a tile (a task of the parallel loop)
+const int tileRows = 64;
+/// columns of a tile, so that the input rows used by the vertical kernel stay in L2 cache
+const int tileCols = 1024;
+
+/// mirrored index at the borders (the border pixel is not repeated)
+inline int mirrorIndex(int i, int size)
+{
+  if(i < 0)
+    i = -i;
+  if(i >= size)
+    i = 2 * (size - 1) - i;
+  return std::min(std::max(i, 0), size - 1);
+}
+
+/// clamped index at the borders (the border pixel is repeated)
+inline int clampIndex(int i, int size)
+{
+  return std::min(std::max(i, 0), size - 1);
+}
+
+#ifdef ALICEVISION_CONVOLUTION_SSE2
+/// load 16 values as 4 float vectors
+inline void load16(const float* src, __m128& v0, __m128& v1, __m128& v2, __m128& v3)
+{
+  v0 = _mm_loadu_ps(src);
+  v1 = _mm_loadu_ps(src + 4);
+  v2 = _mm_loadu_ps(src + 8);
+  v3 = _mm_loadu_ps(src + 12);
+}
+
+inline void load16(const unsigned char* src, __m128& v0, __m128& v1, __m128& v2, __m128& v3)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+  const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+  v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+  v1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+  v2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+  v3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+}
+
+/**
+ * @brief dst[0..16) = sum_k kernel[k] * src(k)[0..16)
+ * The 16 sums are kept in registers during the accumulation.
+ */
+template<typename T, typename SourceFunctor>
+inline void convolve16(SourceFunctor src, const float* kernel, int kernelSize, float* dst)
+{
+  __m128 s0 = _mm_setzero_ps();
+  __m128 s1 = _mm_setzero_ps();
+  __m128 s2 = _mm_setzero_ps();
+  __m128 s3 = _mm_setzero_ps();
+  for(int k = 0; k < kernelSize; ++k)
+  {
+    const __m128 weight = _mm_set1_ps(kernel[k]);
+    __m128 v0, v1, v2, v3;
+    load16(static_cast<const T*>(src(k)), v0, v1, v2, v3);
+    s0 = _mm_add_ps(s0, _mm_mul_ps(weight, v0));
+    s1 = _mm_add_ps(s1, _mm_mul_ps(weight, v1));
+    s2 = _mm_add_ps(s2, _mm_mul_ps(weight, v2));
+    s3 = _mm_add_ps(s3, _mm_mul_ps(weight, v3));
+  }
+  _mm_storeu_ps(dst, s0);
+  _mm_storeu_ps(dst + 4, s1);
+  _mm_storeu_ps(dst + 8, s2);
+  _mm_storeu_ps(dst + 12, s3);
+}
+#endif
+
+/**
+ * @brief dst[i] = sum_k kernel[k] * src[k][i]
+ */
+template<typename T>
+inline void convolveRows(const T* const* src, const float* kernel, int kernelSize, int n, float* dst)
+{
+  int i = 0;
+#ifdef ALICEVISION_CONVOLUTION_SSE2
+  for(; i + 16 <= n; i += 16)
+    convolve16<T>([&](int k) { return src[k] + i; }, kernel, kernelSize, dst + i);
+#endif
+  for(; i < n; ++i)
+  {
+    float sum = 0.f;
+    for(int k = 0; k < kernelSize; ++k)
+      sum += src[k][i] * kernel[k];
+    dst[i] = sum;
+  }
+}
+
+/**
+ * @brief dst[i] = sum_k kernel[k] * line[i + k]
+ */
+inline void convolveLine(const float* line, const float* kernel, int kernelSize, int n, float* dst)
+{
+  int i = 0;
+#ifdef ALICEVISION_CONVOLUTION_SSE2
+  for(; i + 16 <= n; i += 16)
+    convolve16<float>([&](int k) { return line + i + k; }, kernel, kernelSize, dst + i);
+#endif
+  for(; i < n; ++i)
+  {
+    float sum = 0.f;
+    for(int k = 0; k < kernelSize; ++k)
+      sum += line[i + k] * kernel[k];
+    dst[i] = sum;
+  }
+}
+
+} // namespace
+
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
-                            RowMatrixXf* out) {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
+                            RowMatrixXf* out)
+{
+  const int rows = static_cast<int>(image.rows());
+  const int cols = static_cast<int>(image.cols());
+  const int sizeX = static_cast<int>(kernel_x.cols());
+  const int sizeY = static_cast<int>(kernel_y.cols());
+  const int halfX = sizeX / 2;
+  const int halfY = sizeY / 2;
+
+  out->resize(rows, cols);
+  if(rows == 0 || cols == 0)
+    return;
 
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
+  const int nbTileRows = (rows + tileRows - 1) / tileRows;
+  const int nbTileCols = (cols + tileCols - 1) / tileCols;
 
+  // The vertical filter is applied first on the (row, column range) of the tile and its
+  // horizontal halo, then the horizontal filter on this cached line. The borders are mirrored.
   #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < half_sigma_y; i++)
+  for(int tile = 0; tile < nbTileRows * nbTileCols; ++tile)
   {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row(i) = kernel_y.tail(forward_size) *
-                  image.block(0, 0, forward_size, image.cols()) +
-                  reverse_kernel_y.tail(reverse_size) *
-                  image.block(1, 0, reverse_size, image.cols());
-
-    // Apply the same technique for the end rows.
-    out->row(image.rows() - i - 1) =
-      kernel_y.head(forward_size) *
-      image.block(image.rows() - forward_size, 0, forward_size, image.cols())
-      +
-      reverse_kernel_y.head(reverse_size) *
-      image.block(image.rows() - reverse_size - 1, 0, reverse_size, image.cols());
+    const int rowBegin = (tile / nbTileCols) * tileRows;
+    const int rowEnd = std::min(rowBegin + tileRows, rows);
+    const int colBegin = (tile % nbTileCols) * tileCols;
+    const int colEnd = std::min(colBegin + tileCols, cols);
+    const int tileWidth = colEnd - colBegin;
+
+    // columns of the halo inside the image
+    const int innerBegin = std::max(colBegin - halfX, 0);
+    const int innerEnd = std::min(colEnd + halfX, cols);
+
+    std::vector<float> line(tileWidth + 2 * halfX);
+    std::vector<const float*> srcRows(sizeY);
+
+    for(int row = rowBegin; row < rowEnd; ++row)
+    {
+      for(int k = 0; k < sizeY; ++k)
+        srcRows[k] = image.data() + mirrorIndex(row + k - halfY, rows) * cols + innerBegin;
+
+      // vertical filter
+      const int lineOffset = colBegin - halfX;
+      convolveRows(srcRows.data(), kernel_y.data(), sizeY, innerEnd - innerBegin, &line[innerBegin - lineOffset]);
+
+      // halo outside the image
+      for(int i = 0; i < innerBegin - lineOffset; ++i)
+        line[i] = line[mirrorIndex(lineOffset + i, cols) - lineOffset];
+      for(int i = innerEnd - lineOffset; i < (int)line.size(); ++i)
+        line[i] = line[mirrorIndex(lineOffset + i, cols) - lineOffset];
+
+      // horizontal filter
+      convolveLine(line.data(), kernel_x.data(), sizeX, tileWidth, out->data() + row * cols + colBegin);
+    }
   }
+}
 
-  // Applying the rest of the y filter.
+void SeparableConvolution2d(const RowMatrixXuc& image,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                            RowMatrixXuc* out)
+{
+  const int rows = static_cast<int>(image.rows());
+  const int cols = static_cast<int>(image.cols());
+  const int sizeX = static_cast<int>(kernel_x.cols());
+  const int sizeY = static_cast<int>(kernel_y.cols());
+  const int halfX = sizeX / 2;
+  const int halfY = sizeY / 2;
+
+  out->resize(rows, cols);
+  if(rows == 0 || cols == 0)
+    return;
+
+  const int nbTileRows = (rows + tileRows - 1) / tileRows;
+  const int nbTileCols = (cols + tileCols - 1) / tileCols;
+
+  // The horizontal filter is applied first on the rows of the tile and its vertical halo,
+  // then the vertical filter on these cached rows. The borders are clamped and the
+  // intermediate result is stored in unsigned char, as with the generic implementation.
   #pragma omp parallel for schedule(dynamic)
-  for (int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
+  for(int tile = 0; tile < nbTileRows * nbTileCols; ++tile)
   {
-    out->row(row) =  kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
-  }
+    const int rowBegin = (tile / nbTileCols) * tileRows;
+    const int rowEnd = std::min(rowBegin + tileRows, rows);
+    const int colBegin = (tile % nbTileCols) * tileCols;
+    const int colEnd = std::min(colBegin + tileCols, cols);
+    const int tileWidth = colEnd - colBegin;
+    const int tileHeight = rowEnd - rowBegin;
 
-  const int sigma_x = static_cast<int>(kernel_x.cols());
-  const int half_sigma_x = static_cast<int>(kernel_x.cols() / 2);
+    // columns of the halo inside the image
+    const int innerBegin = std::max(colBegin - halfX, 0);
+    const int innerEnd = std::min(colEnd + halfX, cols);
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
+    std::vector<float> line(tileWidth + 2 * halfX);
+    std::vector<float> sums(tileWidth);
+    std::vector<unsigned char> horizontal((tileHeight + 2 * halfY) * tileWidth);
+    std::vector<const unsigned char*> srcRows(sizeY);
 
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
-  for (int row = 0; row < out->rows(); row++)
-  {
-    temp_row.head(half_sigma_x) =
-      out->row(row).segment(1, half_sigma_x).reverse();
-    temp_row.segment(half_sigma_x, image.cols()) = out->row(row);
-    temp_row.tail(half_sigma_x) =
-      out->row(row)
-      .segment(image.cols() - 2 - half_sigma_x, half_sigma_x)
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row(row) = kernel_x(0) * temp_row.head(image.cols());
-    for (int i = 1; i < sigma_x; i++) {
-      out->row(row) += kernel_x(i) * temp_row.segment(i, image.cols());
+    // horizontal filter
+    for(int i = 0; i < tileHeight + 2 * halfY; ++i)
+    {
+      const unsigned char* src = image.data() + clampIndex(rowBegin - halfY + i, rows) * cols;
+      const int lineOffset = colBegin - halfX;
+      for(int j = 0; j < innerBegin - lineOffset; ++j)
+        line[j] = src[0];
+      for(int j = innerBegin; j < innerEnd; ++j)
+        line[j - lineOffset] = src[j];
+      for(int j = innerEnd - lineOffset; j < (int)line.size(); ++j)
+        line[j] = src[cols - 1];
+
+      convolveLine(line.data(), kernel_x.data(), sizeX, tileWidth, sums.data());
+
+      unsigned char* dst = &horizontal[i * tileWidth];
+      for(int j = 0; j < tileWidth; ++j)
+        dst[j] = static_cast<unsigned char>(sums[j]);
+    }
+
+    // vertical filter
+    for(int row = rowBegin; row < rowEnd; ++row)
+    {
+      for(int k = 0; k < sizeY; ++k)
+        srcRows[k] = &horizontal[(row - rowBegin + k) * tileWidth];
+
+      convolveRows(srcRows.data(), kernel_y.data(), sizeY, tileWidth, sums.data());
+
+      unsigned char* dst = out->data() + row * cols + colBegin;
+      for(int j = 0; j < tileWidth; ++j)
+        dst[j] = static_cast<unsigned char>(sums[j]);
     }
   }
 }
@@ -13,6 +13,7 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/config.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 
@@ -93,6 +94,7 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
 
   std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
 
+  #pragma omp parallel for firstprivate(line) schedule(dynamic)
   for( int row = 0 ; row < rows ; ++row )
   {
     // Copy line
@@ -126,6 +128,7 @@ template< typename ImageTypeIn , typename ImageTypeOut, typename Kernel >
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out)
 {
   typedef typename ImageTypeIn::Tpixel pix_t ;
+  typedef typename Kernel::Scalar kernel_t ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
@@ -135,30 +138,28 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
 
   out.resize( cols , rows ) ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( rows + kernel_width );
+  // The rows are accumulated one by one (instead of walking the columns) for memory locality
+  std::vector<kernel_t> sums( cols );
 
-  for( int col = 0 ; col < cols ; ++col )
+  #pragma omp parallel for firstprivate(sums) schedule(dynamic)
+  for( int row = 0 ; row < rows ; ++row )
   {
-    // Copy column
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col ) ;
-    }
-    for( int k = 0 ; k < rows ; ++k )
+    std::fill( sums.begin() , sums.end() , kernel_t( 0 ) ) ;
+    for( int k = 0 ; k < kernel_width ; ++k )
     {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col ) ;
-    }
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col ) ;
+      // Border pixels are copied
+      const int src_row = std::min( std::max( row + k - half_kernel_width , 0 ) , rows - 1 ) ;
+      const pix_t * src = img.data() + src_row * cols ;
+      const kernel_t weight = kernel( k ) ;
+      for( int col = 0 ; col < cols ; ++col )
+      {
+        sums[ col ] += src[ col ] * weight ;
+      }
     }
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
-
-    for( int row = 0 ; row < rows ; ++row )
+    for( int col = 0 ; col < cols ; ++col )
     {
-      out.coeffRef( row , col ) = line[row];
+      out.coeffRef( row , col ) = pix_t( sums[ col ] ) ;
     }
   }
 }
@@ -189,13 +190,27 @@ void ImageSeparableConvolution( const ImageType & img ,
 }
 
 typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXf;
+typedef Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXuc;
 
-/// Specialization for Float based image (for arbitrary sized kernel)
+/**
+ ** Specialization for Float based image (for arbitrary sized kernel)
+ ** Cache-tiled and multithreaded, the borders are mirrored.
+ **/
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
                             RowMatrixXf* out);
 
+/**
+ ** Specialization for unsigned char based image (for arbitrary sized kernel)
+ ** Cache-tiled and multithreaded, same results as the generic ImageSeparableConvolution
+ ** (border pixels are copied, horizontal pass stored in unsigned char).
+ **/
+void SeparableConvolution2d(const RowMatrixXuc& image,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                            RowMatrixXuc* out);
+
 // Specialization for Image<float> in order to use SeparableConvolution2d
 template<typename Kernel>
 void ImageSeparableConvolution( const Image<float> & img ,
@@ -213,5 +228,22 @@ void ImageSeparableConvolution( const Image<float> & img ,
   SeparableConvolution2d(img.GetMat(), horiz_k_cast, vert_k_cast, &((Image<float>::Base&)out));
 }
 
+// Specialization for Image<unsigned char> in order to use SeparableConvolution2d
+template<typename Kernel>
+void ImageSeparableConvolution( const Image<unsigned char> & img ,
+                                const Kernel & horiz_k ,
+                                const Kernel & vert_k ,
+                                Image<unsigned char> & out)
+{
+  // Cast the Kernel to the appropriate type
+  typedef Image<unsigned char>::Tpixel pix_t;
+  typedef Eigen::Matrix<typename aliceVision::Accumulator<pix_t>::Type, Eigen::Dynamic, 1> VecKernel;
+  const VecKernel horiz_k_cast = horiz_k.template cast< typename aliceVision::Accumulator<pix_t>::Type >();
+  const VecKernel vert_k_cast = vert_k.template cast< typename aliceVision::Accumulator<pix_t>::Type >();
+
+  out.resize(img.Width(), img.Height());
+  SeparableConvolution2d(img.GetMat(), horiz_k_cast, vert_k_cast, &((Image<unsigned char>::Base&)out));
+}
+
 } // namespace image
 } // namespace aliceVision
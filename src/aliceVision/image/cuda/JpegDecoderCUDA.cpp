@@ -0,0 +1,163 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "JpegDecoderCUDA.hpp"
+
+#include <aliceVision/image/cuda/colorConversion.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cuda_runtime.h>
+#include <nvjpeg.h>
+
+#include <fstream>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace image {
+
+struct JpegDecoderCUDA::DeviceData
+{
+  nvjpegHandle_t handle = nullptr;
+  nvjpegJpegState_t state = nullptr;
+  cudaStream_t stream = nullptr;
+  /// decoded R, G and B planes
+  unsigned char* rgb_d = nullptr;
+  std::size_t rgbSize = 0;
+  float* gray_d = nullptr;
+  std::size_t graySize = 0;
+};
+
+namespace {
+
+/// Grow a device buffer if needed, its content is not kept
+template <typename T>
+bool reserveDeviceBuffer(T*& buffer_d, std::size_t& size, std::size_t requestedSize)
+{
+  if(requestedSize <= size)
+    return true;
+  cudaFree(buffer_d);
+  buffer_d = nullptr;
+  size = 0;
+  if(cudaMalloc(&buffer_d, requestedSize * sizeof(T)) != cudaSuccess)
+    return false;
+  size = requestedSize;
+  return true;
+}
+
+} // namespace
+
+JpegDecoderCUDA::JpegDecoderCUDA(int device)
+  : _device(device)
+  , _data(new DeviceData)
+{
+  if(cudaSetDevice(_device) != cudaSuccess ||
+     cudaStreamCreate(&_data->stream) != cudaSuccess ||
+     nvjpegCreateSimple(&_data->handle) != NVJPEG_STATUS_SUCCESS ||
+     nvjpegJpegStateCreate(_data->handle, &_data->state) != NVJPEG_STATUS_SUCCESS)
+  {
+    ALICEVISION_LOG_WARNING("Can't initialize the nvJPEG decoder on the CUDA device " << _device << ", the images are decoded on the CPU.");
+  }
+}
+
+JpegDecoderCUDA::~JpegDecoderCUDA()
+{
+  cudaSetDevice(_device);
+  if(_data->state != nullptr)
+    nvjpegJpegStateDestroy(_data->state);
+  if(_data->handle != nullptr)
+    nvjpegDestroy(_data->handle);
+  if(_data->stream != nullptr)
+    cudaStreamDestroy(_data->stream);
+  cudaFree(_data->rgb_d);
+  cudaFree(_data->gray_d);
+}
+
+bool JpegDecoderCUDA::isValid() const
+{
+  return _data->state != nullptr;
+}
+
+bool JpegDecoderCUDA::isJpegFile(const std::string& path)
+{
+  const std::string extension = boost::algorithm::to_lower_copy(fs::path(path).extension().string());
+  return extension == ".jpg" || extension == ".jpeg";
+}
+
+bool JpegDecoderCUDA::decodeGray(const std::string& path, Image<float>& image)
+{
+  if(!isValid())
+    return false;
+
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file.is_open())
+      return false;
+    _fileData.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if(!file.read(reinterpret_cast<char*>(_fileData.data()), _fileData.size()))
+      return false;
+  }
+
+  int nbComponents = 0;
+  nvjpegChromaSubsampling_t subsampling;
+  int widths[NVJPEG_MAX_COMPONENT];
+  int heights[NVJPEG_MAX_COMPONENT];
+  if(nvjpegGetImageInfo(_data->handle, _fileData.data(), _fileData.size(), &nbComponents, &subsampling, widths, heights) != NVJPEG_STATUS_SUCCESS ||
+     subsampling == NVJPEG_CSS_UNKNOWN)
+  {
+    ALICEVISION_LOG_DEBUG("nvJPEG can't decode the image '" << path << "'.");
+    return false;
+  }
+
+  const int width = widths[0];
+  const int height = heights[0];
+  const std::size_t nbPixels = static_cast<std::size_t>(width) * height;
+
+  cudaSetDevice(_device);
+  if(!reserveDeviceBuffer(_data->rgb_d, _data->rgbSize, 3 * nbPixels) ||
+     !reserveDeviceBuffer(_data->gray_d, _data->graySize, nbPixels))
+  {
+    ALICEVISION_LOG_WARNING("Can't allocate the GPU memory to decode the image '" << path << "'.");
+    return false;
+  }
+
+  // planar RGB output, the grayscale JPEGs are expanded by nvJPEG
+  nvjpegImage_t destination;
+  for(int c = 0; c < NVJPEG_MAX_COMPONENT; ++c)
+  {
+    destination.channel[c] = nullptr;
+    destination.pitch[c] = 0;
+  }
+  for(int c = 0; c < 3; ++c)
+  {
+    destination.channel[c] = _data->rgb_d + c * nbPixels;
+    destination.pitch[c] = width;
+  }
+
+  if(nvjpegDecode(_data->handle, _data->state, _fileData.data(), _fileData.size(), NVJPEG_OUTPUT_RGB, &destination, _data->stream) != NVJPEG_STATUS_SUCCESS)
+  {
+    ALICEVISION_LOG_DEBUG("nvJPEG failed to decode the image '" << path << "'.");
+    return false;
+  }
+
+  cuda_rgbPlanarToGray(_data->rgb_d, width, height, _data->gray_d, _data->stream);
+
+  image.resize(width, height, false);
+  cudaMemcpyAsync(image.data(), _data->gray_d, nbPixels * sizeof(float), cudaMemcpyDeviceToHost, _data->stream);
+  if(cudaStreamSynchronize(_data->stream) != cudaSuccess)
+  {
+    ALICEVISION_LOG_WARNING("CUDA error while decoding the image '" << path << "': " << cudaGetErrorString(cudaGetLastError()));
+    return false;
+  }
+  return true;
+}
+
+} // namespace image
+} // namespace aliceVision
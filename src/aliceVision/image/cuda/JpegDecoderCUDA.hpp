@@ -0,0 +1,62 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/image/Image.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace image {
+
+/**
+ * @brief JPEG decoding on the GPU with nvJPEG, for the GPU feature extraction.
+ *
+ * The image is decoded (IDCT and color conversion) and converted to grayscale on the device,
+ * with the luminance weights of readImage. Only the float grayscale image is downloaded.
+ * Not thread-safe: one decoder per decoding thread.
+ */
+class JpegDecoderCUDA
+{
+public:
+  /**
+   * @param[in] device The CUDA device used for the decoding
+   */
+  explicit JpegDecoderCUDA(int device = 0);
+  ~JpegDecoderCUDA();
+
+  JpegDecoderCUDA(const JpegDecoderCUDA&) = delete;
+  JpegDecoderCUDA& operator=(const JpegDecoderCUDA&) = delete;
+
+  /// false if nvJPEG can't be initialized on the device
+  bool isValid() const;
+
+  /// Return true if the file extension is a JPEG one
+  static bool isJpegFile(const std::string& path);
+
+  /**
+   * @brief Decode a JPEG file to a grayscale float image in [0, 1], as readImage(path, Image<float>&)
+   * @param[in] path The JPEG file path
+   * @param[out] image The grayscale image
+   * @return false if the file can't be decoded by nvJPEG (unsupported encoding or read error),
+   *         the caller can fallback on readImage
+   */
+  bool decodeGray(const std::string& path, Image<float>& image);
+
+private:
+  struct DeviceData;
+
+  int _device;
+  std::unique_ptr<DeviceData> _data;
+  /// the compressed file, reused between the images
+  std::vector<unsigned char> _fileData;
+};
+
+} // namespace image
+} // namespace aliceVision
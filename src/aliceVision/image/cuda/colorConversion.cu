@@ -0,0 +1,34 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/image/cuda/colorConversion.hpp>
+
+namespace aliceVision {
+namespace image {
+
+namespace {
+
+__global__ void rgbPlanarToGray_kernel(const unsigned char* rgb, int nbPixels, float* gray)
+{
+  const int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if(i >= nbPixels)
+    return;
+
+  // the weights of readImage, the 8-bit values are normalized as by OpenImageIO
+  gray[i] = (0.2126f * rgb[i] + 0.7152f * rgb[nbPixels + i] + 0.0722f * rgb[2 * nbPixels + i]) * (1.0f / 255.0f);
+}
+
+} // namespace
+
+void cuda_rgbPlanarToGray(const unsigned char* rgb_d, int width, int height, float* gray_d, cudaStream_t stream)
+{
+  const int nbPixels = width * height;
+  const int blockSize = 256;
+  rgbPlanarToGray_kernel<<<(nbPixels + blockSize - 1) / blockSize, blockSize, 0, stream>>>(rgb_d, nbPixels, gray_d);
+}
+
+} // namespace image
+} // namespace aliceVision
@@ -0,0 +1,25 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+namespace aliceVision {
+namespace image {
+
+/**
+ * @brief Convert a planar 8-bit RGB image to a float luminance image in [0, 1] (Rec709 weights, as readImage)
+ * @param[in] rgb_d The R, G and B planes of width * height pixels (device memory)
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[out] gray_d The width * height luminance image (device memory)
+ * @param[in] stream The CUDA stream of the conversion
+ */
+void cuda_rgbPlanarToGray(const unsigned char* rgb_d, int width, int height, float* gray_d, cudaStream_t stream);
+
+} // namespace image
+} // namespace aliceVision
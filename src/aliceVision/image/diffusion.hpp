@@ -10,6 +10,7 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 
+#include <algorithm>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -42,70 +43,79 @@ void ImagePeronaMalikG2DiffusionCoef( const Image & Lx , const Image & Ly , cons
 }
 
 /**
-** Apply Fast Explicit Diffusion to an Image (on central part)
-** @param src input image
-** @param diff diffusion coefficient image
+** Compute a Fast Explicit Diffusion step on an image row
+** The neighbors outside the image must be given as the pixel itself (no flux across the borders).
+** @param src_up, src_cur, src_down input image rows
+** @param diff_up, diff_cur, diff_down diffusion coefficient rows
+** @param width row width
 ** @param half_t Half diffusion time
-** @param out Output image
-** @param row_start Row range beginning (range is [row_start ; row_end [ )
-** @param row_end Row range end (range is [row_start ; row_end [ )
+** @param out output row: the step (or the source plus the step if AddSource)
 **/
-template< typename Image >
-void ImageFEDCentral( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out ,
-                      const int row_start , const int row_end )
+template< bool AddSource , typename Real >
+inline void FEDRow( const Real * src_up , const Real * src_cur , const Real * src_down ,
+                    const Real * diff_up , const Real * diff_cur , const Real * diff_down ,
+                    const int width , const Real half_t , Real * out )
 {
-  typedef typename Image::Tpixel Real ;
-  const int width = src.Width() ;
-  Real n_diff[4] ;
-  Real n_src[4] ;
-  // Compute FED step on general range
-  for( int i = row_start ; i < row_end ; ++i )
+  // Diffusion factor of the pixel j with its left neighbor j_left and right neighbor j_right
+  const auto fedValue = [&]( const int j , const int j_left , const int j_right )
   {
-    for( int j = 1 ; j < width - 1 ; ++j )
-    {
-      // Retrieve neighbors : TODO check if we need a cache efficient version ?
-      n_diff[0] = diff( i , j + 1 ) ;
-      n_diff[1] = diff( i - 1 , j ) ;
-      n_diff[2] = diff( i , j - 1 ) ;
-      n_diff[3] = diff( i + 1 , j ) ;
-      n_src[0] = src( i , j + 1 ) ;
-      n_src[1] = src( i - 1 , j ) ;
-      n_src[2] = src( i , j - 1 ) ;
-      n_src[3] = src( i + 1 , j ) ;
-
-      // Compute diffusion factor for given pixel
-      const Real cur_src = src( i , j ) ;
-      const Real cur_diff = diff( i , j ) ;
-      const Real a = ( cur_diff + n_diff[0] ) * ( n_src[0] - cur_src ) ;
-      const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] ) ;
-      const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] ) ;
-      const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src ) ;
-      const Real value = half_t * ( a - c + d - b ) ;
-      out( i , j ) = value ;
-    }
+    const Real cur_src = src_cur[ j ] ;
+    const Real cur_diff = diff_cur[ j ] ;
+    const Real a = ( cur_diff + diff_cur[ j_right ] ) * ( src_cur[ j_right ] - cur_src ) ;
+    const Real b = ( cur_diff + diff_up[ j ] ) * ( cur_src - src_up[ j ] ) ;
+    const Real c = ( cur_diff + diff_cur[ j_left ] ) * ( cur_src - src_cur[ j_left ] ) ;
+    const Real d = ( cur_diff + diff_down[ j ] ) * ( src_down[ j ] - cur_src ) ;
+    const Real value = half_t * ( a - c + d - b ) ;
+    return AddSource ? cur_src + value : value ;
+  } ;
+
+  out[ 0 ] = fedValue( 0 , 0 , std::min( 1 , width - 1 ) ) ;
+
+  // Central part: contiguous loads, vectorized by the compiler
+  for( int j = 1 ; j < width - 1 ; ++j )
+  {
+    const Real cur_src = src_cur[ j ] ;
+    const Real cur_diff = diff_cur[ j ] ;
+    const Real a = ( cur_diff + diff_cur[ j + 1 ] ) * ( src_cur[ j + 1 ] - cur_src ) ;
+    const Real b = ( cur_diff + diff_up[ j ] ) * ( cur_src - src_up[ j ] ) ;
+    const Real c = ( cur_diff + diff_cur[ j - 1 ] ) * ( cur_src - src_cur[ j - 1 ] ) ;
+    const Real d = ( cur_diff + diff_down[ j ] ) * ( src_down[ j ] - cur_src ) ;
+    const Real value = half_t * ( a - c + d - b ) ;
+    out[ j ] = AddSource ? cur_src + value : value ;
+  }
+
+  if( width > 1 )
+  {
+    out[ width - 1 ] = fedValue( width - 1 , width - 2 , width - 1 ) ;
   }
 }
 
 /**
-** Apply Fast Explicit Diffusion to an Image (on central part)
+** Apply a Fast Explicit Diffusion step on all the image rows (borders included), in parallel
 ** @param src input image
 ** @param diff diffusion coefficient image
 ** @param half_t Half diffusion time
-** @param out Output image
+** @param out output image (must be distinct from src)
 **/
-template< typename Image >
-void ImageFEDCentralCPPThread( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out )
+template< bool AddSource , typename Image >
+void ImageFEDRows( const Image & src , const Image & diff , const typename Image::Tpixel half_t , Image & out )
 {
-  const int nb_thread = omp_get_max_threads();
-
-  // Compute ranges
-  std::vector< int > range;
-  SplitRange( 1 , (int) ( src.rows() - 1 ) , nb_thread , range ) ;
+  typedef typename Image::Tpixel Real ;
+  const int width = src.Width() ;
+  const int height = src.Height() ;
+  if( out.Width() != width || out.Height() != height )
+  {
+    out.resize( width , height ) ;
+  }
 
-  #pragma omp parallel for schedule(dynamic)
-  for( int i = 1 ; i < static_cast<int>(range.size()) ; ++i )
+  #pragma omp parallel for schedule(static)
+  for( int i = 0 ; i < height ; ++i )
   {
-    ImageFEDCentral( src, diff, half_t, out, range[i-1] , range[i]) ;
+    const int i_up = ( i > 0 ) ? i - 1 : i ;
+    const int i_down = ( i < height - 1 ) ? i + 1 : i ;
+    FEDRow< AddSource , Real >( src.data() + i_up * width , src.data() + i * width , src.data() + i_down * width ,
+                                diff.data() + i_up * width , diff.data() + i * width , diff.data() + i_down * width ,
+                                width , half_t , out.data() + i * width ) ;
   }
 }
 
@@ -120,102 +130,21 @@ template< typename Image >
 void ImageFED( const Image & src , const Image & diff , const typename Image::Tpixel t , Image & out )
 {
   typedef typename Image::Tpixel Real ;
-  const int width = src.Width() ;
-  const int height = src.Height() ;
-  const Real half_t = t * static_cast<Real>( 0.5 ) ;
-  if( out.Width() != width || out.Height() != height )
-  {
-    out.resize( width , height ) ;
-  }
-  Real n_diff[4] ;
-  Real n_src[4] ;
-
-  // Take care of the central part
-  ImageFEDCentralCPPThread( src , diff , half_t , out ) ;
-
-  // Take care of the border
-  // - first/last row
-  // - first/last col
-
-  // Compute FED step on first row
-  for( int j = 1 ; j < width - 1 ; ++j )
-  {
-    n_diff[0] = diff( 0 , j + 1 ) ;
-    n_diff[2] = diff( 0 , j - 1 ) ;
-    n_diff[3] = diff( 1 , j ) ;
-    n_src[0] = src( 0 , j + 1 ) ;
-    n_src[2] = src( 0 , j - 1 ) ;
-    n_src[3] = src( 1 , j ) ;
-
-    // Compute diffusion factor for given pixel
-    const Real cur_src = src( 0 , j ) ;
-    const Real cur_diff = diff( 0 , j ) ;
-    const Real a = ( cur_diff + n_diff[0] ) * ( n_src[0] - cur_src ) ;
-    const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] ) ;
-    const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src ) ;
-    const Real value = half_t * ( a - c + d ) ;
-    out( 0 , j ) = value ;
-  }
-
-  // Compute FED step on last row
-  for( int j = 1 ; j < width - 1 ; ++j )
-  {
-    n_diff[0] = diff( height - 1 , j + 1 ) ;
-    n_diff[1] = diff( height - 2 , j ) ;
-    n_diff[2] = diff( height - 1 , j - 1 ) ;
-    n_src[0] = src( height - 1 , j + 1 ) ;
-    n_src[1] = src( height - 2 , j ) ;
-    n_src[2] = src( height - 1 , j - 1 ) ;
-
-    // Compute diffusion factor for given pixel
-    const Real cur_src = src( height - 1 , j ) ;
-    const Real cur_diff = diff( height - 1 , j ) ;
-    const Real a = ( cur_diff + n_diff[0] ) * ( n_src[0] - cur_src ) ;
-    const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] ) ;
-    const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] ) ;
-    const Real value = half_t * ( a - c - b ) ;
-    out( height - 1 , j ) = value ;
-  }
-
-  // Compute FED step on first col
-  for( int i = 1 ; i < height - 1 ; ++i )
-  {
-    n_diff[0] = diff( i , 1 ) ;
-    n_diff[1] = diff( i - 1 , 0 ) ;
-    n_diff[3] = diff( i + 1 , 0 ) ;
-    n_src[0] = src( i , 1 ) ;
-    n_src[1] = src( i - 1 , 0 ) ;
-    n_src[3] = src( i + 1 , 0 ) ;
-
-    // Compute diffusion factor for given pixel
-    const Real cur_src = src( i , 0 ) ;
-    const Real cur_diff = diff( i , 0 ) ;
-    const Real a = ( cur_diff + n_diff[0] ) * ( n_src[0] - cur_src ) ;
-    const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] ) ;
-    const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src ) ;
-    const Real value = half_t * ( a + d - b ) ;
-    out( i , 0 ) = value ;
-  }
+  ImageFEDRows< false >( src , diff , t * static_cast<Real>( 0.5 ) , out ) ;
+}
 
-  // Compute FED step on last col
-  for( int i = 1 ; i < height - 1 ; ++i )
-  {
-    n_diff[1] = diff( i - 1 , width - 1 ) ;
-    n_diff[2] = diff( i , width - 2 ) ;
-    n_diff[3] = diff( i + 1 , width - 1 ) ;
-    n_src[1] = src( i - 1 , width - 1 ) ;
-    n_src[2] = src( i , width - 2 ) ;
-    n_src[3] = src( i + 1 , width - 1 ) ;
-
-    // Compute diffusion factor for given pixel
-    const Real cur_src = src( i , width - 1 ) ;
-    const Real cur_diff = diff( i , width - 1 ) ;
-    const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] ) ;
-    const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] ) ;
-    const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src ) ;
-    const Real value = half_t * ( - c + d - b ) ;
-    out( i , width - 1 ) = value ;
-  }
+/**
+** Apply a Fast Explicit Diffusion step and add it to the image in one pass (out = src + FED step)
+** @param src input image
+** @param diff diffusion coefficient image
+** @param t diffusion time
+** @param out output image (must be distinct from src)
+**/
+template< typename Image >
+void ImageFEDStep( const Image & src , const Image & diff , const typename Image::Tpixel t , Image & out )
+{
+  typedef typename Image::Tpixel Real ;
+  ImageFEDRows< true >( src , diff , t * static_cast<Real>( 0.5 ) , out ) ;
 }
 
 /**
@@ -227,11 +156,12 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
 template< typename Image >
 void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau )
 {
-  Image tmp;
+  // the steps are computed alternatively in self and tmp
+  Image tmp( self.Width() , self.Height() , false ) ;
   for( int i = 0 ; i < tau.size() ; ++i )
   {
-    ImageFED( self , diff , tau[i] , tmp ) ;
-    self.array() += tmp.array();
+    ImageFEDStep( self , diff , tau[i] , tmp ) ;
+    self.swap( tmp ) ;
   }
 }
 
@@ -135,3 +135,38 @@ BOOST_AUTO_TEST_CASE(Image_Convolution_Sobel_X_Y)
   outFilteredCast = Image<unsigned char>(outFiltered.cast<unsigned char>());
   BOOST_CHECK_NO_THROW(writeImage("out_SobelY.png", outFilteredCast));
 }
+
+BOOST_AUTO_TEST_CASE(Image_Convolution_Separable_Tiled)
+{
+  // larger than a tile to check the tile borders
+  const int width = 1100;
+  const int height = 150;
+  Image<float> inFloat(width, height);
+  Image<unsigned char> inUChar(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+    {
+      inUChar(y, x) = rand() % 256;
+      inFloat(y, x) = inUChar(y, x);
+    }
+
+  Vec kernel(7);
+  kernel << 0.05, 0.1, 0.2, 0.3, 0.2, 0.1, 0.05;
+
+  // float: compare to the 2D convolution away from the borders (mirrored instead of copied)
+  Image<float> outSeparable;
+  ImageSeparableConvolution(inFloat, kernel, kernel, outSeparable);
+  Image<float> out2D;
+  ImageConvolution(inFloat, Mat(kernel * kernel.transpose()), out2D);
+  const int half = kernel.size() / 2;
+  BOOST_CHECK_SMALL((outSeparable - out2D).block(half, half, height - 2 * half, width - 2 * half).cwiseAbs().maxCoeff(), 1e-3f);
+
+  // unsigned char: same result as the generic horizontal and vertical convolutions
+  Image<unsigned char> outTiled;
+  ImageSeparableConvolution(inUChar, kernel, kernel, outTiled);
+  const Eigen::VectorXf kernelFloat = kernel.cast<float>();
+  Image<unsigned char> tmp, outGeneric;
+  ImageHorizontalConvolution(inUChar, kernelFloat, tmp);
+  ImageVerticalConvolution(tmp, kernelFloat, outGeneric);
+  BOOST_CHECK(outTiled == outGeneric);
+}
@@ -16,16 +16,21 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <cmath>
+#include <memory>
 
 namespace fs = boost::filesystem;
 
 namespace aliceVision {
 namespace image {
 
+/// tile size of the written openEXR pyramids
+static const int EXR_TILE_SIZE = 64;
+
 std::string EImageFileType_informations()
 {
   return "Image file type :\n"
@@ -73,6 +78,47 @@ std::istream& operator>>(std::istream& in, EImageFileType& imageFileType)
   return in;
 }
 
+std::string EStorageDataType_informations()
+{
+  return "Storage data type of the EXR images :\n"
+         "* float \n"
+         "* half";
+}
+
+EStorageDataType EStorageDataType_stringToEnum(const std::string& dataType)
+{
+  std::string type = dataType;
+  std::transform(type.begin(), type.end(), type.begin(), ::tolower); //tolower
+
+  if(type == "float") return EStorageDataType::Float;
+  if(type == "half")  return EStorageDataType::Half;
+
+  throw std::out_of_range("Invalid storage data type : " + dataType);
+}
+
+std::string EStorageDataType_enumToString(const EStorageDataType dataType)
+{
+  switch(dataType)
+  {
+    case EStorageDataType::Float: return "float";
+    case EStorageDataType::Half:  return "half";
+  }
+  throw std::out_of_range("Invalid EStorageDataType enum");
+}
+
+std::ostream& operator<<(std::ostream& os, EStorageDataType dataType)
+{
+  return os << EStorageDataType_enumToString(dataType);
+}
+
+std::istream& operator>>(std::istream& in, EStorageDataType& dataType)
+{
+  std::string token;
+  in >> token;
+  dataType = EStorageDataType_stringToEnum(token);
+  return in;
+}
+
 void readImageMetadata(const std::string& path, int& width, int& height, std::map<std::string, std::string>& metadata)
 {
   std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
@@ -168,7 +214,9 @@ void writeImage(const std::string& path,
                 oiio::TypeDesc typeDesc,
                 int nchannels,
                 const Image<T>& image,
-                const oiio::ParamValueList& metadata = oiio::ParamValueList())
+                const oiio::ParamValueList& metadata = oiio::ParamValueList(),
+                EStorageDataType storageDataType = EStorageDataType::Half,
+                bool mipmap = false)
 {
   const fs::path bPath = fs::path(path);
   const std::string extension = bPath.extension().string();
@@ -180,17 +228,62 @@ void writeImage(const std::string& path,
 
   if(isEXR)
   {
-    oiio::ImageBuf buf(imageSpec, const_cast<T*>(image.data()));
-
-    imageSpec.format = oiio::TypeDesc::HALF;     // override format
+    if(storageDataType == EStorageDataType::Half)
+      imageSpec.format = oiio::TypeDesc::HALF;   // override format
     imageSpec.attribute("compression", "piz");   // if possible, PIZ compression for openEXR
 
-    // conversion to half
-    oiio::ImageBuf outBuf(imageSpec);
-    outBuf.copy_pixels(buf);
+    // the pixels are converted to the file data type by the writer,
+    // without an intermediate copy of the whole image
+    std::unique_ptr<oiio::ImageOutput> out(oiio::ImageOutput::create(tmpPath));
 
-    // write image
-    if(!outBuf.write(tmpPath))
+    if(!out)
+      throw std::runtime_error("Can't write output image file '" + path + "'.");
+
+    mipmap = mipmap && out->supports("mipmap");
+
+    if(mipmap)
+    {
+      // tiled pyramid: all the MIP levels down to 1x1, each one is the box filtered half of the previous one
+      // (the openEXR rounding mode is down, as ImageBoxHalfSample)
+      imageSpec.tile_width = EXR_TILE_SIZE;
+      imageSpec.tile_height = EXR_TILE_SIZE;
+      imageSpec.tile_depth = 1;
+      imageSpec.attribute("textureformat", "Plain Texture");
+    }
+
+    bool success = out->open(tmpPath, imageSpec, oiio::ImageOutput::Create) && out->write_image(typeDesc, image.data());
+
+    if(mipmap)
+    {
+      const Image<T>* level = &image;
+      Image<T> halfLevels[2];
+      for(int l = 0; success && (level->Width() > 1 || level->Height() > 1); ++l)
+      {
+        Image<T>& halfLevel = halfLevels[l % 2];
+        if(level->Width() > 1 && level->Height() > 1)
+        {
+          ImageBoxHalfSample(*level, halfLevel);
+        }
+        else
+        {
+          // one of the dimensions is already 1: only the other one is halved
+          const int width = std::max(1, level->Width() / 2);
+          const int height = std::max(1, level->Height() / 2);
+          halfLevel.resize(width, height);
+          for(int y = 0; y < height; ++y)
+            for(int x = 0; x < width; ++x)
+              halfLevel(y, x) = (*level)(std::min(2 * y, level->Height() - 1), std::min(2 * x, level->Width() - 1));
+        }
+        level = &halfLevel;
+
+        oiio::ImageSpec levelSpec = imageSpec;
+        levelSpec.width = levelSpec.full_width = level->Width();
+        levelSpec.height = levelSpec.full_height = level->Height();
+        success = out->open(tmpPath, levelSpec, oiio::ImageOutput::AppendMIPLevel) && out->write_image(typeDesc, level->data());
+      }
+    }
+
+    if(!success || !out->close())
       throw std::runtime_error("Can't write output image file '" + path + "'.");
   }
   else
@@ -255,5 +348,10 @@ void writeImage(const std::string& path, const Image<RGBColor>& image, const oii
   writeImage(path, oiio::TypeDesc::UINT8, 3, image, metadata);
 }
 
+void writeImage(const std::string& path, const Image<RGBfColor>& image, EStorageDataType storageDataType, const oiio::ParamValueList& metadata, bool mipmap)
+{
+  writeImage(path, oiio::TypeDesc::FLOAT, 3, image, metadata, storageDataType, mipmap);
+}
+
 }  // namespace image
 }  // namespace aliceVision
@@ -66,6 +66,38 @@ std::ostream& operator<<(std::ostream& os, EImageFileType imageFileType);
  */
 std::istream& operator>>(std::istream& in, EImageFileType& imageFileType);
 
+/**
+ * @brief Available storage data types of the float images written in EXR
+ */
+enum class EStorageDataType
+{
+  Float,
+  Half
+};
+
+/**
+ * @brief get informations about each storage data type
+ * @return String
+ */
+std::string EStorageDataType_informations();
+
+/**
+ * @brief It returns the EStorageDataType enum from a string.
+ * @param[in] dataType the input string.
+ * @return the associated EStorageDataType enum.
+ */
+EStorageDataType EStorageDataType_stringToEnum(const std::string& dataType);
+
+/**
+ * @brief It converts a EStorageDataType enum to a string.
+ * @param[in] dataType the EStorageDataType enum to convert.
+ * @return the string associated to the EStorageDataType enum.
+ */
+std::string EStorageDataType_enumToString(const EStorageDataType dataType);
+
+std::ostream& operator<<(std::ostream& os, EStorageDataType dataType);
+std::istream& operator>>(std::istream& in, EStorageDataType& dataType);
+
 /**
  * @brief extract metadata from an image for a given path
  * @param[in] path The given path to the image
@@ -96,5 +128,14 @@ void writeImage(const std::string& path, const Image<RGBAColor>& image, const oi
 void writeImage(const std::string& path, const Image<RGBfColor>& image, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, const Image<RGBColor>& image, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 
+/**
+ * @brief write a float image with a given path, buffer and EXR storage data type
+ * @param[in] path The given path to the image
+ * @param[in] image The output image buffer
+ * @param[in] storageDataType The EXR pixel data type, converted while encoding (ignored for the other file types)
+ * @param[in] mipmap Write a tiled EXR with all the MIP levels, so the reduced resolutions can be read directly
+ */
+void writeImage(const std::string& path, const Image<RGBfColor>& image, EStorageDataType storageDataType, const oiio::ParamValueList& metadata = oiio::ParamValueList(), bool mipmap = false);
+
 }  // namespace image
 }  // namespace aliceVision
@@ -0,0 +1,135 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "resampling.hpp"
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define ALICEVISION_RESAMPLING_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace aliceVision {
+namespace image {
+
+namespace {
+
+/// even and odd elements of 8 consecutive floats
+#ifdef ALICEVISION_RESAMPLING_SSE2
+inline void deinterleave(const float* data, __m128& even, __m128& odd)
+{
+  const __m128 a = _mm_loadu_ps(data);
+  const __m128 b = _mm_loadu_ps(data + 4);
+  even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+  odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+#endif
+
+} // namespace
+
+void ImageBoxHalfSample(const Image<float>& src, Image<float>& out)
+{
+  const int newWidth = src.Width() / 2;
+  const int newHeight = src.Height() / 2;
+
+  out.resize(newWidth, newHeight, false);
+
+  #pragma omp parallel for if(newWidth * newHeight > 64 * 64)
+  for(int i = 0; i < newHeight; ++i)
+  {
+    const float* row0 = &src(2 * i, 0);
+    const float* row1 = &src(2 * i + 1, 0);
+    float* outRow = &out(i, 0);
+    int j = 0;
+
+#ifdef ALICEVISION_RESAMPLING_SSE2
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for(; j + 4 <= newWidth; j += 4)
+    {
+      __m128 even0, odd0, even1, odd1;
+      deinterleave(row0 + 2 * j, even0, odd0);
+      deinterleave(row1 + 2 * j, even1, odd1);
+      const __m128 sum = _mm_add_ps(_mm_add_ps(even0, odd0), _mm_add_ps(even1, odd1));
+      _mm_storeu_ps(outRow + j, _mm_mul_ps(sum, quarter));
+    }
+#endif
+
+    for(; j < newWidth; ++j)
+      outRow[j] = ((row0[2 * j] + row0[2 * j + 1]) + (row1[2 * j] + row1[2 * j + 1])) * 0.25f;
+  }
+}
+
+void ImageGaussianHalfSample(const Image<float>& src, Image<float>& out)
+{
+  const int width = src.Width();
+  const int height = src.Height();
+  const int newWidth = width / 2;
+  const int newHeight = height / 2;
+
+  out.resize(newWidth, newHeight, false);
+
+  #pragma omp parallel if(newWidth * newHeight > 64 * 64)
+  {
+    // vertical [1 3 3 1] pass of the 4 source rows of an output row
+    std::vector<float> columns(width);
+
+    #pragma omp for
+    for(int i = 0; i < newHeight; ++i)
+    {
+      const float* rows[4];
+      for(int k = 0; k < 4; ++k)
+        rows[k] = &src(std::min(std::max(2 * i - 1 + k, 0), height - 1), 0);
+
+      int x = 0;
+#ifdef ALICEVISION_RESAMPLING_SSE2
+      const __m128 three = _mm_set1_ps(3.f);
+      for(; x + 4 <= width; x += 4)
+      {
+        const __m128 outer = _mm_add_ps(_mm_loadu_ps(rows[0] + x), _mm_loadu_ps(rows[3] + x));
+        const __m128 inner = _mm_add_ps(_mm_loadu_ps(rows[1] + x), _mm_loadu_ps(rows[2] + x));
+        _mm_storeu_ps(&columns[x], _mm_add_ps(outer, _mm_mul_ps(inner, three)));
+      }
+#endif
+      for(; x < width; ++x)
+        columns[x] = (rows[0][x] + rows[3][x]) + (rows[1][x] + rows[2][x]) * 3.f;
+
+      // horizontal [1 3 3 1] pass, centered between the columns 2j and 2j+1
+      const float* c = columns.data();
+      float* outRow = &out(i, 0);
+      const auto horizontal = [&](int j)
+      {
+        const float outer = c[std::max(2 * j - 1, 0)] + c[std::min(2 * j + 2, width - 1)];
+        const float inner = c[2 * j] + c[2 * j + 1];
+        outRow[j] = (outer + inner * 3.f) * (1.f / 64.f);
+      };
+
+      int j = 0;
+#ifdef ALICEVISION_RESAMPLING_SSE2
+      if(newWidth > 0)
+        horizontal(j++);
+      const __m128 scale = _mm_set1_ps(1.f / 64.f);
+      // the loads read up to the column 2j+9
+      for(; j + 4 <= newWidth && 2 * j + 9 < width; j += 4)
+      {
+        __m128 previous, even, odd, next, unused;
+        deinterleave(c + 2 * j - 1, previous, unused);
+        deinterleave(c + 2 * j, even, odd);
+        deinterleave(c + 2 * j + 2, next, unused);
+        const __m128 outer = _mm_add_ps(previous, next);
+        const __m128 inner = _mm_add_ps(even, odd);
+        _mm_storeu_ps(outRow + j, _mm_mul_ps(_mm_add_ps(outer, _mm_mul_ps(inner, three)), scale));
+      }
+#endif
+      for(; j < newWidth; ++j)
+        horizontal(j);
+    }
+  }
+}
+
+} // namespace image
+} // namespace aliceVision
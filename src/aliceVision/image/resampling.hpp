@@ -9,11 +9,18 @@
 
 #include <aliceVision/image/Sampler.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
 namespace aliceVision {
 namespace image {
 
   /**
    ** Half sample an image (ie reduce it's size by a factor 2) using bilinear interpolation
+   ** @note The bilinear samples are taken at the odd pixel positions (2i+1, 2j+1),
+   **       so they are read directly from the source image
    ** @param src input image
    ** @param out output image
    **/
@@ -23,20 +30,191 @@ namespace image {
     const int new_width  = src.Width() / 2 ;
     const int new_height = src.Height() / 2 ;
 
-    out.resize( new_width , new_height ) ;
+    out.resize( new_width , new_height , false ) ;
+
+    #pragma omp parallel for if( new_width * new_height > 64 * 64 )
+    for( int i = 0 ; i < new_height ; ++i )
+    {
+      for( int j = 0 ; j < new_width ; ++j )
+      {
+        out( i , j ) = src( 2 * i + 1 , 2 * j + 1 ) ;
+      }
+    }
+  }
+
+  /**
+   ** Half sample an image (ie reduce it's size by a factor 2) by averaging each 2x2 block of pixels
+   ** @note Unlike ImageHalfSample, all the source pixels contribute, as in the MIP levels of an image pyramid
+   ** @param src input image
+   ** @param out output image
+   **/
+  template < typename Image >
+  void ImageBoxHalfSample( const Image & src , Image & out )
+  {
+    typedef RealPixel<typename Image::Tpixel> RealPixelT;
+
+    const int new_width  = src.Width() / 2 ;
+    const int new_height = src.Height() / 2 ;
+
+    out.resize( new_width , new_height , false ) ;
+
+    #pragma omp parallel for if( new_width * new_height > 64 * 64 )
+    for( int i = 0 ; i < new_height ; ++i )
+    {
+      for( int j = 0 ; j < new_width ; ++j )
+      {
+        typename RealPixelT::real_type sum = RealPixelT::convert_to_real( src( 2 * i , 2 * j ) ) ;
+        sum += RealPixelT::convert_to_real( src( 2 * i , 2 * j + 1 ) ) ;
+        sum += RealPixelT::convert_to_real( src( 2 * i + 1 , 2 * j ) ) ;
+        sum += RealPixelT::convert_to_real( src( 2 * i + 1 , 2 * j + 1 ) ) ;
+        const typename RealPixelT::real_type mean = sum * 0.25 ;
+        out( i , j ) = RealPixelT::convert_from_real( mean ) ;
+      }
+    }
+  }
+
+  /**
+   ** Float specialization of ImageBoxHalfSample (SSE2 when available)
+   **/
+  void ImageBoxHalfSample( const Image<float> & src , Image<float> & out ) ;
+
+  /**
+   ** Half sample an image (ie reduce it's size by a factor 2) with the separable binomial kernel [1 3 3 1] / 8
+   ** centered on each 2x2 block of pixels, the borders are clamped
+   ** @note Smoother than ImageBoxHalfSample (less aliasing), at the same sub-pixel position
+   ** @param src input image
+   ** @param out output image
+   **/
+  template < typename Image >
+  void ImageGaussianHalfSample( const Image & src , Image & out )
+  {
+    typedef RealPixel<typename Image::Tpixel> RealPixelT;
+    typedef typename RealPixelT::real_type RealT;
+
+    const int width  = src.Width() ;
+    const int height = src.Height() ;
+    const int new_width  = width / 2 ;
+    const int new_height = height / 2 ;
 
-    const Sampler2d<SamplerLinear> sampler;
+    out.resize( new_width , new_height , false ) ;
 
+    #pragma omp parallel for if( new_width * new_height > 64 * 64 )
     for( int i = 0 ; i < new_height ; ++i )
     {
+      int rows[4] ;
+      for( int k = 0 ; k < 4 ; ++k )
+        rows[k] = std::min( std::max( 2 * i - 1 + k , 0 ) , height - 1 ) ;
+
       for( int j = 0 ; j < new_width ; ++j )
       {
-        // Use .5f offset to ensure mid pixel and correct bilinear sampling
-        out( i , j ) =  sampler( src, 2.f * (i+.5f), 2.f * (j+.5f) );
+        RealT columns[4] ;
+        for( int l = 0 ; l < 4 ; ++l )
+        {
+          const int col = std::min( std::max( 2 * j - 1 + l , 0 ) , width - 1 ) ;
+          columns[l] = RealPixelT::convert_to_real( src( rows[0] , col ) ) ;
+          columns[l] += 3.0 * RealPixelT::convert_to_real( src( rows[1] , col ) ) ;
+          columns[l] += 3.0 * RealPixelT::convert_to_real( src( rows[2] , col ) ) ;
+          columns[l] += RealPixelT::convert_to_real( src( rows[3] , col ) ) ;
+        }
+        RealT sum = columns[0] ;
+        sum += 3.0 * columns[1] ;
+        sum += 3.0 * columns[2] ;
+        sum += columns[3] ;
+        const RealT mean = sum / 64.0 ;
+        out( i , j ) = RealPixelT::convert_from_real( mean ) ;
       }
     }
   }
 
+  /**
+   ** Float specialization of ImageGaussianHalfSample (SSE2 when available)
+   **/
+  void ImageGaussianHalfSample( const Image<float> & src , Image<float> & out ) ;
+
+  /// Filter used to build the levels of an ImagePyramid
+  enum class EImagePyramidFilter
+  {
+    POINT,   //< ImageHalfSample
+    BOX,     //< ImageBoxHalfSample
+    GAUSSIAN //< ImageGaussianHalfSample
+  };
+
+  /**
+   ** @brief Dyadic image pyramid: each level is half the size of the previous one.
+   ** The levels are kept between two builds, so building the pyramids of images of the same
+   ** size doesn't allocate anything. Each level is computed in parallel.
+   **/
+  template < typename ImageT >
+  class ImagePyramid
+  {
+  public:
+    /**
+     ** @brief Build the pyramid of an image
+     ** @param src The base level
+     ** @param nbLevels The number of levels, including the base level
+     ** @param filter The downsampling filter
+     **/
+    void build( const ImageT & src , std::size_t nbLevels , EImagePyramidFilter filter = EImagePyramidFilter::BOX )
+    {
+      base() = src ;
+      buildFromBase( nbLevels , filter ) ;
+    }
+
+    /**
+     ** @brief Build the pyramid from the image already written in base(), without copying it
+     ** @param nbLevels The number of levels, including the base level
+     ** @param filter The downsampling filter
+     ** @note Stops at the last level larger than 1x1
+     **/
+    void buildFromBase( std::size_t nbLevels , EImagePyramidFilter filter = EImagePyramidFilter::BOX )
+    {
+      assert( nbLevels > 0 ) ;
+      if( _levels.size() < nbLevels )
+        _levels.resize( nbLevels ) ;
+
+      _nbLevels = 1 ;
+      while( _nbLevels < nbLevels && _levels[_nbLevels - 1].Width() > 1 && _levels[_nbLevels - 1].Height() > 1 )
+      {
+        const ImageT & previous = _levels[_nbLevels - 1] ;
+        ImageT & level = _levels[_nbLevels] ;
+        switch( filter )
+        {
+          case EImagePyramidFilter::POINT:    ImageHalfSample( previous , level ) ;         break ;
+          case EImagePyramidFilter::BOX:      ImageBoxHalfSample( previous , level ) ;      break ;
+          case EImagePyramidFilter::GAUSSIAN: ImageGaussianHalfSample( previous , level ) ; break ;
+        }
+        ++_nbLevels ;
+      }
+    }
+
+    /// Base level, to fill before buildFromBase()
+    ImageT & base()
+    {
+      if( _levels.empty() )
+        _levels.resize( 1 ) ;
+      return _levels.front() ;
+    }
+
+    std::size_t getNbLevels() const { return _nbLevels ; }
+
+    const ImageT & getLevel( std::size_t level ) const
+    {
+      assert( level < _nbLevels ) ;
+      return _levels[level] ;
+    }
+
+    /// Release the memory of the levels
+    void clear()
+    {
+      _levels.clear() ;
+      _nbLevels = 0 ;
+    }
+
+  private:
+    std::vector<ImageT> _levels ;
+    std::size_t _nbLevels = 0 ;
+  };
+
   /**
    ** @brief Ressample an image using given sampling positions
    ** @param src Input image
@@ -8,8 +8,10 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/image/all.hpp>
 
+#include <cmath>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #define BOOST_TEST_MODULE ImageRessampling
 #include <boost/test/included/unit_test.hpp>
@@ -122,3 +124,150 @@ BOOST_AUTO_TEST_CASE(Ressampling_SampleRotate)
   BOOST_CHECK_NO_THROW(ImageRotation(image, Sampler2d< SamplerSpline16 >(), "SamplerSpline16"));
   BOOST_CHECK_NO_THROW(ImageRotation(image, Sampler2d< SamplerSpline64 >(), "SamplerSpline64"));
 }
+
+BOOST_AUTO_TEST_CASE(Ressampling_BoxHalfSample)
+{
+  // odd size: the last row and column are dropped, as in the MIP levels rounded down
+  Image<float> image(5, 3);
+  for(int i = 0; i < image.Height(); ++i)
+    for(int j = 0; j < image.Width(); ++j)
+      image(i, j) = i * image.Width() + j;
+
+  Image<float> half;
+  ImageBoxHalfSample(image, half);
+
+  BOOST_CHECK_EQUAL(half.Width(), 2);
+  BOOST_CHECK_EQUAL(half.Height(), 1);
+  BOOST_CHECK_CLOSE(half(0, 0), (0.f + 1.f + 5.f + 6.f) / 4.f, 1e-5);
+  BOOST_CHECK_CLOSE(half(0, 1), (2.f + 3.f + 7.f + 8.f) / 4.f, 1e-5);
+
+  // rounded average of the unsigned char color channels
+  Image<RGBColor> imageRGB(2, 2);
+  imageRGB(0, 0) = RGBColor(0, 10, 255);
+  imageRGB(0, 1) = RGBColor(1, 10, 255);
+  imageRGB(1, 0) = RGBColor(1, 20, 255);
+  imageRGB(1, 1) = RGBColor(1, 20, 255);
+
+  Image<RGBColor> halfRGB;
+  ImageBoxHalfSample(imageRGB, halfRGB);
+
+  BOOST_CHECK_EQUAL(halfRGB.Width(), 1);
+  BOOST_CHECK_EQUAL(halfRGB.Height(), 1);
+  BOOST_CHECK_EQUAL(int(halfRGB(0, 0).r()), 1);
+  BOOST_CHECK_EQUAL(int(halfRGB(0, 0).g()), 15);
+  BOOST_CHECK_EQUAL(int(halfRGB(0, 0).b()), 255);
+}
+
+template<typename T>
+void checkSampleSpan(const Image<T>& image, double tolerance)
+{
+  // positions inside, at the borders and outside of the image
+  std::vector<float> xy;
+  for(float y = -1.5f; y < image.Height() + 1.f; y += 0.37f)
+  {
+    for(float x = -1.5f; x < image.Width() + 1.f; x += 0.29f)
+    {
+      xy.push_back(x);
+      xy.push_back(y);
+    }
+  }
+  xy.push_back(image.Width() - 1.f);
+  xy.push_back(image.Height() - 1.f);
+
+  const int count = xy.size() / 2;
+  const Sampler2d<SamplerLinear> sampler;
+  std::vector<T> out(count, T());
+  SampleSpan(sampler, image, xy.data(), count, out.data());
+
+  for(int i = 0; i < count; ++i)
+  {
+    const float x = xy[2 * i];
+    const float y = xy[2 * i + 1];
+    const T expected = image.Contains(y, x) ? sampler(image, y, x) : T();
+    BOOST_CHECK_SMALL(std::abs(static_cast<double>(out[i]) - static_cast<double>(expected)), tolerance);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Ressampling_SampleSpan)
+{
+  const int width = 23;
+  const int height = 17;
+
+  Image<float> imageFloat(width, height);
+  Image<unsigned char> imageUChar(width, height);
+  for(int i = 0; i < height; ++i)
+  {
+    for(int j = 0; j < width; ++j)
+    {
+      imageFloat(i, j) = std::sin(0.3f * i) * std::cos(0.7f * j);
+      imageUChar(i, j) = (i * 37 + j * 101) % 256;
+    }
+  }
+
+  checkSampleSpan(imageFloat, 1e-5);
+  // the unsigned char values may be rounded differently
+  checkSampleSpan(imageUChar, 1.0 + 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(Ressampling_GaussianHalfSample)
+{
+  // odd sizes and a width larger than the vectorized blocks
+  const int width = 37;
+  const int height = 11;
+
+  Image<float> image(width, height);
+  for(int i = 0; i < height; ++i)
+    for(int j = 0; j < width; ++j)
+      image(i, j) = std::sin(0.3f * i) * std::cos(0.7f * j) + 0.01f * j;
+
+  // the float specializations match the generic implementations
+  Image<float> half;
+  Image<float> halfGeneric;
+  ImageGaussianHalfSample(image, half);
+  ImageGaussianHalfSample<Image<float> >(image, halfGeneric);
+  BOOST_CHECK_EQUAL(half.Width(), width / 2);
+  BOOST_CHECK_EQUAL(half.Height(), height / 2);
+  for(int i = 0; i < half.Height(); ++i)
+    for(int j = 0; j < half.Width(); ++j)
+      BOOST_CHECK_SMALL(half(i, j) - halfGeneric(i, j), 1e-5f);
+
+  ImageBoxHalfSample(image, half);
+  ImageBoxHalfSample<Image<float> >(image, halfGeneric);
+  for(int i = 0; i < half.Height(); ++i)
+    for(int j = 0; j < half.Width(); ++j)
+      BOOST_CHECK_SMALL(half(i, j) - halfGeneric(i, j), 1e-5f);
+
+  // a constant image is unchanged, including the clamped borders
+  Image<RGBColor> imageRGB(6, 4, true, RGBColor(10, 20, 30));
+  Image<RGBColor> halfRGB;
+  ImageGaussianHalfSample(imageRGB, halfRGB);
+  BOOST_CHECK_EQUAL(halfRGB.Width(), 3);
+  BOOST_CHECK_EQUAL(halfRGB.Height(), 2);
+  for(int i = 0; i < halfRGB.Height(); ++i)
+    for(int j = 0; j < halfRGB.Width(); ++j)
+      BOOST_CHECK(halfRGB(i, j) == RGBColor(10, 20, 30));
+}
+
+BOOST_AUTO_TEST_CASE(Ressampling_ImagePyramid)
+{
+  Image<float> image(40, 24, true, 1.f);
+
+  ImagePyramid<Image<float> > pyramid;
+  pyramid.build(image, 10, EImagePyramidFilter::GAUSSIAN);
+
+  // stops at the last level larger than 1x1: 40x24, 20x12, 10x6, 5x3, 2x1
+  BOOST_CHECK_EQUAL(pyramid.getNbLevels(), 5);
+  BOOST_CHECK_EQUAL(pyramid.getLevel(3).Width(), 5);
+  BOOST_CHECK_EQUAL(pyramid.getLevel(3).Height(), 3);
+  BOOST_CHECK_EQUAL(pyramid.getLevel(4).Width(), 2);
+  BOOST_CHECK_EQUAL(pyramid.getLevel(4).Height(), 1);
+  BOOST_CHECK_CLOSE(pyramid.getLevel(4)(0, 1), 1.f, 1e-4);
+
+  // the levels are reused for an image of the same size
+  const float* levelData = pyramid.getLevel(2).data();
+  image.fill(2.f);
+  pyramid.build(image, 3, EImagePyramidFilter::POINT);
+  BOOST_CHECK_EQUAL(pyramid.getNbLevels(), 3);
+  BOOST_CHECK_EQUAL(pyramid.getLevel(2).data(), levelData);
+  BOOST_CHECK_EQUAL(pyramid.getLevel(2)(1, 1), 2.f);
+}
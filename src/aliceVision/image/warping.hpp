@@ -9,6 +9,8 @@
 
 #include <aliceVision/config.hpp>
 
+#include <vector>
+
 namespace aliceVision{
 namespace image{
 
@@ -33,15 +35,26 @@ void Warp(const Image &im, const Mat3 & H, Image &out)
   const int hOut = static_cast<int>(out.Height());
 
   const Sampler2d<SamplerLinear> sampler;
-  for (int j = 0; j < hOut; ++j)
-    #pragma omp parallel for
-    for (int i = 0; i < wOut; ++i)
+
+  // the source positions of each row are sampled at once
+  #pragma omp parallel
+  {
+    std::vector<float> xy(2 * wOut);
+
+    #pragma omp for
+    for (int j = 0; j < hOut; ++j)
     {
-      double xT = i, yT = j;
-      if (ApplyH_AndCheckOrientation(H, xT, yT)
-          && im.Contains(yT,xT))
-        out(j,i) = sampler(im, (float)yT, (float)xT);
+      for (int i = 0; i < wOut; ++i)
+      {
+        double xT = i, yT = j;
+        if (!ApplyH_AndCheckOrientation(H, xT, yT))
+          xT = yT = -1.0; // outside of the image, skipped by the sampling
+        xy[2 * i] = static_cast<float>(xT);
+        xy[2 * i + 1] = static_cast<float>(yT);
+      }
+      SampleSpan(sampler, im, xy.data(), wOut, &out(j, 0));
     }
+  }
 }
 
 }; // namespace image
@@ -0,0 +1,145 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MemoryImages.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace aliceVision {
+namespace imageIO {
+
+namespace {
+
+bool isInFolder(const std::string& path, const std::string& folder)
+{
+  return path.size() > folder.size() && path.compare(0, folder.size(), folder) == 0;
+}
+
+} // namespace
+
+MemoryImages& MemoryImages::get()
+{
+  static MemoryImages images;
+  return images;
+}
+
+void MemoryImages::addFolder(const std::string& folder)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::string folderPath = folder;
+  if(!folderPath.empty() && folderPath.back() != '/')
+    folderPath += '/';
+  if(std::find(_folders.begin(), _folders.end(), folderPath) == _folders.end())
+    _folders.push_back(folderPath);
+  ALICEVISION_LOG_DEBUG("Images kept in memory: " << folderPath);
+}
+
+void MemoryImages::setWriteFiles(bool writeFiles)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _writeFiles = writeFiles;
+}
+
+bool MemoryImages::writeFiles() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _writeFiles;
+}
+
+bool MemoryImages::isInMemoryPath(const std::string& path) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(const std::string& folder : _folders)
+  {
+    if(isInFolder(path, folder))
+      return true;
+  }
+  return false;
+}
+
+bool MemoryImages::has(const std::string& path) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _images.count(path) > 0;
+}
+
+MemoryImages::ImageSharedPtr MemoryImages::getImage(const std::string& path) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _images.find(path);
+  return (it == _images.end()) ? nullptr : it->second;
+}
+
+void MemoryImages::store(const std::string& path, const oiio::ImageSpec& spec, const void* data, std::size_t nbBytes)
+{
+  // copy outside of the lock
+  std::shared_ptr<Image> image = std::make_shared<Image>();
+  image->spec = spec;
+  image->data.resize(nbBytes);
+  std::memcpy(image->data.data(), data, nbBytes);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ImageSharedPtr& entry = _images[path];
+    if(entry)
+      _size -= entry->data.size();
+    entry = image;
+    _size += nbBytes;
+  }
+  _imageStored.notify_all();
+}
+
+void MemoryImages::remove(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _images.find(path);
+  if(it == _images.end())
+    return;
+  _size -= it->second->data.size();
+  _images.erase(it);
+}
+
+void MemoryImages::removeFolder(const std::string& folder)
+{
+  std::string folderPath = folder;
+  if(!folderPath.empty() && folderPath.back() != '/')
+    folderPath += '/';
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(auto it = _images.lower_bound(folderPath); it != _images.end() && isInFolder(it->first, folderPath);)
+  {
+    _size -= it->second->data.size();
+    it = _images.erase(it);
+  }
+}
+
+void MemoryImages::setWriting(bool writing)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _writing = writing;
+  }
+  _imageStored.notify_all();
+}
+
+bool MemoryImages::waitImage(const std::string& path) const
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _imageStored.wait(lock, [&]{ return _images.count(path) > 0 || !_writing; });
+  return _images.count(path) > 0;
+}
+
+std::size_t MemoryImages::getSize() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _size;
+}
+
+} // namespace imageIO
+} // namespace aliceVision
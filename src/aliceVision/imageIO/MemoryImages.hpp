@@ -0,0 +1,121 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <OpenImageIO/imageio.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace oiio = OIIO;
+
+namespace aliceVision {
+namespace imageIO {
+
+/**
+ * @brief In-memory storage of the images written in some folders, for the pipelines chaining several steps
+ *        in the same process (depth maps estimation, filtering and meshing) without intermediate files.
+ *
+ * The images written by imageIO::writeImage in a registered folder are kept in memory (with their metadata)
+ * and read back by imageIO::readImage, readImageRegion, readImageSpec and readImageMetadata.
+ * The paths are compared as given: the producers and the consumers must build them from the same folder strings.
+ */
+class MemoryImages
+{
+public:
+  struct Image
+  {
+    /// size, pixel format and metadata
+    oiio::ImageSpec spec;
+    std::vector<char> data;
+  };
+
+  typedef std::shared_ptr<const Image> ImageSharedPtr;
+
+  /**
+   * @brief Get the storage of the process
+   */
+  static MemoryImages& get();
+
+  /**
+   * @brief Keep the images written in a folder (and its subfolders) in memory
+   */
+  void addFolder(const std::string& folder);
+
+  /**
+   * @brief Also write the images of the registered folders on disk (debug)
+   */
+  void setWriteFiles(bool writeFiles);
+
+  bool writeFiles() const;
+
+  /**
+   * @brief Return true if the image of this path is kept in memory when written
+   */
+  bool isInMemoryPath(const std::string& path) const;
+
+  bool has(const std::string& path) const;
+
+  /**
+   * @brief Get an image, nullptr if it is not in memory
+   */
+  ImageSharedPtr getImage(const std::string& path) const;
+
+  /**
+   * @brief Store (or replace) an image and wake up the threads waiting for it
+   * @param[in] path The image path
+   * @param[in] spec The image size, pixel format and metadata
+   * @param[in] data The image pixels
+   * @param[in] nbBytes The size of the image pixels
+   */
+  void store(const std::string& path, const oiio::ImageSpec& spec, const void* data, std::size_t nbBytes);
+
+  /**
+   * @brief Free an image (the readers still holding it keep it alive)
+   */
+  void remove(const std::string& path);
+
+  /**
+   * @brief Free all the images of a folder
+   */
+  void removeFolder(const std::string& folder);
+
+  /**
+   * @brief Tell the waiting threads if images are still being written
+   */
+  void setWriting(bool writing);
+
+  /**
+   * @brief Wait until an image is stored, or until no image is being written anymore
+   * @return false if the image will never be stored
+   */
+  bool waitImage(const std::string& path) const;
+
+  /**
+   * @brief Memory used by the images (in bytes)
+   */
+  std::size_t getSize() const;
+
+private:
+  MemoryImages() = default;
+
+  mutable std::mutex _mutex;
+  mutable std::condition_variable _imageStored;
+  std::vector<std::string> _folders;
+  std::map<std::string, ImageSharedPtr> _images;
+  std::size_t _size = 0;
+  bool _writeFiles = false;
+  bool _writing = true;
+};
+
+} // namespace imageIO
+} // namespace aliceVision
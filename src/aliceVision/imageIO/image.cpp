@@ -5,7 +5,9 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "image.hpp"
+#include "MemoryImages.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/DecodedImagesCache.hpp>
 #include <aliceVision/mvsData/Color.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
 
@@ -17,6 +19,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <memory>
 
@@ -25,6 +29,12 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace imageIO {
 
+/// tile size of the written openEXR files
+static const int EXR_TILE_SIZE = 64;
+
+/// num. of rows written at once by ImageRowsWriter in the files written by scanlines
+static const int ROWS_STRIP_HEIGHT = 64;
+
 std::string EImageQuality_informations()
 {
   return "Image quality :\n"
@@ -72,6 +82,16 @@ void readImageSpec(const std::string& path,
                    int& nchannels)
 {
   ALICEVISION_LOG_DEBUG("[IO] Read Image Spec: " << path);
+
+  const MemoryImages::ImageSharedPtr memoryImage = MemoryImages::get().getImage(path);
+  if(memoryImage)
+  {
+    width = memoryImage->spec.width;
+    height = memoryImage->spec.height;
+    nchannels = memoryImage->spec.nchannels;
+    return;
+  }
+
   std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
 
   if(!in)
@@ -89,6 +109,14 @@ void readImageSpec(const std::string& path,
 void readImageMetadata(const std::string& path, oiio::ParamValueList& metadata)
 {
   ALICEVISION_LOG_DEBUG("[IO] Read Image Metadata: " << path);
+
+  const MemoryImages::ImageSharedPtr memoryImage = MemoryImages::get().getImage(path);
+  if(memoryImage)
+  {
+    metadata = memoryImage->spec.extra_attribs;
+    return;
+  }
+
   std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
 
   if(!in)
@@ -103,15 +131,25 @@ template<typename T>
 void readImage(const std::string& path,
                oiio::TypeDesc typeDesc,
                int nchannels,
+               int downscale,
                int& width,
                int& height,
                std::vector<T>& buffer)
 {
-    ALICEVISION_LOG_DEBUG("[IO] Read Image: " << path);
+    ALICEVISION_LOG_DEBUG("[IO] Read Image: " << path << ((downscale > 1) ? " (downscale: " + std::to_string(downscale) + ")" : ""));
 
     // check requested channels number
     assert(nchannels == 1 || nchannels >= 3);
 
+    // the downscaled images are shared with the other processes through the on-disk cache
+    const system::DecodedImagesCache& cache = system::DecodedImagesCache::get();
+    const std::string cacheFormat = std::string(typeDesc.c_str()) + ":" + std::to_string(nchannels);
+    if(downscale > 1 && cache.load(path, downscale, cacheFormat, width, height, buffer))
+        return;
+
+    // images written in memory by a previous step of the process
+    const MemoryImages::ImageSharedPtr memoryImage = MemoryImages::get().getImage(path);
+
     oiio::ImageSpec configSpec;
 
     // libRAW configuration
@@ -120,7 +158,42 @@ void readImage(const std::string& path,
     configSpec.attribute("raw:ColorSpace", "sRGB");   // want colorspace sRGB
     configSpec.attribute("raw:use_camera_matrix", 3); // want to use embeded color profile
 
-    oiio::ImageBuf inBuf(path, 0, 0, NULL, &configSpec);
+    // reduced resolution read: use the smallest MIP level of the file not smaller than the output
+    int miplevel = 0;
+    int outWidth = 0;
+    int outHeight = 0;
+    bool exactLevel = false;
+    if(downscale > 1 && memoryImage)
+    {
+        outWidth = memoryImage->spec.width / downscale;
+        outHeight = memoryImage->spec.height / downscale;
+    }
+    else if(downscale > 1)
+    {
+        std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path, &configSpec));
+
+        if(!in)
+            throw std::runtime_error("Can't find/open image file '" + path + "'.");
+
+        outWidth = in->spec().width / downscale;
+        outHeight = in->spec().height / downscale;
+
+        oiio::ImageSpec levelSpec;
+        while(in->seek_subimage(0, miplevel + 1, levelSpec) &&
+              levelSpec.width >= outWidth && levelSpec.height >= outHeight)
+        {
+            ++miplevel;
+            exactLevel = (levelSpec.width == outWidth && levelSpec.height == outHeight);
+        }
+
+        in->close();
+    }
+
+    oiio::ImageBuf inBuf;
+    if(memoryImage)
+        inBuf.copy(oiio::ImageBuf(memoryImage->spec, const_cast<char*>(memoryImage->data.data())));
+    else
+        inBuf.reset(path, 0, miplevel, NULL, &configSpec);
 
     if(!inBuf.initialized())
         throw std::runtime_error("Can't find/open image file '" + path + "'.");
@@ -164,10 +237,19 @@ void readImage(const std::string& path,
         inBuf.copy(requestedBuf);
     }
 
-    width = inSpec.width;
-    height = inSpec.height;
+    // resize to the downscaled resolution
+    if(downscale > 1 && (inBuf.spec().width != outWidth || inBuf.spec().height != outHeight))
+    {
+        oiio::ImageBuf resizedBuf(oiio::ImageSpec(outWidth, outHeight, inBuf.nchannels(), typeDesc));
+        oiio::ImageBufAlgo::resize(resizedBuf, inBuf, "", 0, oiio::ROI::All());
+        inBuf.copy(resizedBuf);
+    }
+
+    width = inBuf.spec().width;
+    height = inBuf.spec().height;
 
-    buffer.resize(inSpec.width * inSpec.height * nchannels);
+    // T can be a pixel type (rgb, Color) or a channel type
+    buffer.resize(width * height * nchannels * typeDesc.size() / sizeof(T));
 
     {
         oiio::ROI exportROI = inBuf.roi();
@@ -176,31 +258,177 @@ void readImage(const std::string& path,
 
         inBuf.get_pixels(exportROI, typeDesc, buffer.data());
     }
+
+    // a MIP level of the requested size (see prepareDenseScene pyramids) is already as fast to read as the cache
+    if(downscale > 1 && !exactLevel && !memoryImage)
+        cache.store(path, downscale, cacheFormat, width, height, buffer.data(), buffer.size() * sizeof(T));
 }
 
 void readImage(const std::string& path, int& width, int& height, std::vector<unsigned char>& buffer)
 {
-    readImage(path, oiio::TypeDesc::UCHAR, 1, width, height, buffer);
+    readImage(path, oiio::TypeDesc::UCHAR, 1, 1, width, height, buffer);
+}
+
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<unsigned char>& buffer)
+{
+    readImage(path, oiio::TypeDesc::UCHAR, 1, downscale, width, height, buffer);
 }
 
 void readImage(const std::string& path, int& width, int& height, std::vector<unsigned short>& buffer)
 {
-    readImage(path, oiio::TypeDesc::UINT16, 1, width, height, buffer);
+    readImage(path, oiio::TypeDesc::UINT16, 1, 1, width, height, buffer);
+}
+
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<unsigned short>& buffer)
+{
+    readImage(path, oiio::TypeDesc::UINT16, 1, downscale, width, height, buffer);
 }
 
 void readImage(const std::string& path, int& width, int& height, std::vector<rgb>& buffer)
 {
-    readImage(path, oiio::TypeDesc::UCHAR, 3, width, height, buffer);
+    readImage(path, oiio::TypeDesc::UCHAR, 3, 1, width, height, buffer);
+}
+
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<rgb>& buffer)
+{
+    readImage(path, oiio::TypeDesc::UCHAR, 3, downscale, width, height, buffer);
 }
 
 void readImage(const std::string& path, int& width, int& height, std::vector<float>& buffer)
 {
-    readImage(path, oiio::TypeDesc::FLOAT, 1, width, height, buffer);
+    readImage(path, oiio::TypeDesc::FLOAT, 1, 1, width, height, buffer);
+}
+
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<float>& buffer)
+{
+    readImage(path, oiio::TypeDesc::FLOAT, 1, downscale, width, height, buffer);
 }
 
 void readImage(const std::string& path, int& width, int& height, std::vector<Color>& buffer)
 {
-    readImage(path, oiio::TypeDesc::FLOAT, 3, width, height, buffer);
+    readImage(path, oiio::TypeDesc::FLOAT, 3, 1, width, height, buffer);
+}
+
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<Color>& buffer)
+{
+    readImage(path, oiio::TypeDesc::FLOAT, 3, downscale, width, height, buffer);
+}
+
+template<typename T>
+void readImageRegion(const std::string& path,
+                     oiio::TypeDesc typeDesc,
+                     int nchannels,
+                     int downscale,
+                     int x,
+                     int y,
+                     int width,
+                     int height,
+                     std::vector<T>& buffer)
+{
+  ALICEVISION_LOG_DEBUG("[IO] Read Image Region: " << path << " (x: " << x << ", y: " << y << ", width: " << width << ", height: " << height
+                        << ((downscale > 1) ? ", downscale: " + std::to_string(downscale) : "") << ")");
+
+  // images written in memory: no MIP level, crop the whole image
+  const bool inMemory = MemoryImages::get().has(path);
+
+  std::unique_ptr<oiio::ImageInput> in(inMemory ? nullptr : oiio::ImageInput::open(path));
+
+  if(!in && !inMemory)
+    throw std::runtime_error("Can't find/open image file '" + path + "'.");
+
+  // find the MIP level of the requested resolution
+  bool levelFound = (downscale <= 1) && !inMemory;
+  if(!levelFound && !inMemory)
+  {
+    const int outWidth = in->spec().width / downscale;
+    const int outHeight = in->spec().height / downscale;
+
+    oiio::ImageSpec levelSpec;
+    for(int miplevel = 1; !levelFound && in->seek_subimage(0, miplevel, levelSpec) && levelSpec.width >= outWidth; ++miplevel)
+      levelFound = (levelSpec.width == outWidth && levelSpec.height == outHeight);
+  }
+
+  // no MIP level of the requested resolution or missing channels: crop the whole downscaled image
+  if(!levelFound || in->spec().nchannels < nchannels)
+  {
+    if(in)
+      in->close();
+
+    int fullWidth, fullHeight;
+    std::vector<T> fullBuffer;
+    readImage(path, typeDesc, nchannels, downscale, fullWidth, fullHeight, fullBuffer);
+
+    if(x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > fullWidth || y + height > fullHeight)
+      throw std::runtime_error("Invalid region of image file '" + path + "'.");
+
+    const std::size_t pixelSize = nchannels * typeDesc.size();
+    buffer.resize(width * height * pixelSize / sizeof(T));
+    const char* fullBufferPtr = reinterpret_cast<const char*>(fullBuffer.data());
+    char* bufferPtr = reinterpret_cast<char*>(buffer.data());
+    for(int row = 0; row < height; ++row)
+      std::memcpy(bufferPtr + row * width * pixelSize, fullBufferPtr + ((y + row) * fullWidth + x) * pixelSize, width * pixelSize);
+    return;
+  }
+
+  const oiio::ImageSpec& spec = in->spec();
+
+  if(x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > spec.width || y + height > spec.height)
+    throw std::runtime_error("Invalid region of image file '" + path + "'.");
+
+  // read the tiles covering the region or the region scanlines
+  int xbegin = 0;
+  int xend = spec.width;
+  int ybegin = y;
+  int yend = y + height;
+
+  if(spec.tile_width > 0)
+  {
+    xbegin = (x / spec.tile_width) * spec.tile_width;
+    xend = std::min(spec.width, ((x + width + spec.tile_width - 1) / spec.tile_width) * spec.tile_width);
+    ybegin = (y / spec.tile_height) * spec.tile_height;
+    yend = std::min(spec.height, ((y + height + spec.tile_height - 1) / spec.tile_height) * spec.tile_height);
+  }
+
+  const std::size_t pixelSize = nchannels * typeDesc.size();
+  std::vector<char> readBuffer((xend - xbegin) * (yend - ybegin) * pixelSize);
+
+  const bool success = (spec.tile_width > 0) ?
+    in->read_tiles(spec.x + xbegin, spec.x + xend, spec.y + ybegin, spec.y + yend, spec.z, spec.z + 1, 0, nchannels, typeDesc, readBuffer.data()) :
+    in->read_scanlines(spec.y + ybegin, spec.y + yend, spec.z, 0, nchannels, typeDesc, readBuffer.data());
+
+  in->close();
+
+  if(!success)
+    throw std::runtime_error("Can't read region of image file '" + path + "'.");
+
+  buffer.resize(width * height * pixelSize / sizeof(T));
+
+  char* bufferPtr = reinterpret_cast<char*>(buffer.data());
+  for(int row = 0; row < height; ++row)
+  {
+    const std::size_t readOffset = ((y - ybegin + row) * (xend - xbegin) + (x - xbegin)) * pixelSize;
+    std::memcpy(bufferPtr + row * width * pixelSize, readBuffer.data() + readOffset, width * pixelSize);
+  }
+}
+
+void readImageRegion(const std::string& path, int x, int y, int width, int height, std::vector<unsigned char>& buffer)
+{
+  readImageRegion(path, oiio::TypeDesc::UCHAR, 1, 1, x, y, width, height, buffer);
+}
+
+void readImageRegion(const std::string& path, int x, int y, int width, int height, std::vector<float>& buffer)
+{
+  readImageRegion(path, oiio::TypeDesc::FLOAT, 1, 1, x, y, width, height, buffer);
+}
+
+void readImageRegion(const std::string& path, int downscale, int x, int y, int width, int height, std::vector<float>& buffer)
+{
+  readImageRegion(path, oiio::TypeDesc::FLOAT, 1, downscale, x, y, width, height, buffer);
+}
+
+void readImageRegion(const std::string& path, int downscale, int x, int y, int width, int height, std::vector<Color>& buffer)
+{
+  readImageRegion(path, oiio::TypeDesc::FLOAT, 3, downscale, x, y, width, height, buffer);
 }
 
 template<typename T>
@@ -226,6 +454,15 @@ void writeImage(const std::string& path,
     oiio::ImageSpec imageSpec(width, height, nchannels, typeDesc);
     imageSpec.extra_attribs = metadata;
 
+    // kept in memory for the next steps of the process, in full precision
+    MemoryImages& memoryImages = MemoryImages::get();
+    if(memoryImages.isInMemoryPath(path))
+    {
+        memoryImages.store(path, imageSpec, buffer.data(), buffer.size() * sizeof(T));
+        if(!memoryImages.writeFiles())
+            return;
+    }
+
     if(isEXR)
     {
         imageSpec.attribute("compression", "piz");   // if possible, PIZ compression for openEXR
@@ -237,7 +474,11 @@ void writeImage(const std::string& path,
         imageSpec.attribute("compression", "none");       // if possible, no compression
     }
 
-    const oiio::ImageBuf outBuf(imageSpec, const_cast<T*>(buffer.data()));
+    oiio::ImageBuf outBuf(imageSpec, const_cast<T*>(buffer.data()));
+
+    // tiled openEXR, the regions can be read independently
+    if(isEXR)
+      outBuf.set_write_tiles(EXR_TILE_SIZE, EXR_TILE_SIZE);
 
     if(isEXR && imageQuality == EImageQuality::OPTIMIZED)
     {
@@ -247,6 +488,7 @@ void writeImage(const std::string& path,
         oiio::ImageBuf halfBuf(imageSpec);
         if(!halfBuf.copy_pixels(outBuf))
           throw std::runtime_error("Can't convert output image file to half '" + path + "'.");
+        halfBuf.set_write_tiles(EXR_TILE_SIZE, EXR_TILE_SIZE);
 
         // write image
         if(!halfBuf.write(tmpPath))
@@ -288,6 +530,197 @@ void writeImage(const std::string& path, int width, int height, const std::vecto
     writeImage(path, oiio::TypeDesc::FLOAT, width, height, 3, buffer, imageQuality, metadata);
 }
 
+struct ImageRowsWriter::Level
+{
+    std::string path;
+    std::string tmpPath;
+    std::unique_ptr<oiio::ImageOutput> output;
+    bool tiled = false;
+    bool closed = false;
+
+    /// num. of input rows (and columns) averaged in an output row (and column)
+    int factor = 1;
+    int inWidth = 0;
+    int width = 0;
+    int height = 0;
+
+    /// sum of the current input rows
+    std::vector<Color> rowSum;
+    int nbSummedRows = 0;
+
+    /// output rows not written yet, written by tiles rows or by strips of scanlines
+    std::vector<Color> strip;
+    int stripHeight = 1;
+    int nbStripRows = 0;
+    /// first row of the strip
+    int y = 0;
+
+    void flush()
+    {
+        if(nbStripRows == 0)
+            return;
+
+        const bool success = tiled ? output->write_tiles(0, width, y, y + nbStripRows, 0, 1, oiio::TypeDesc::FLOAT, strip.data())
+                                   : output->write_scanlines(y, y + nbStripRows, 0, oiio::TypeDesc::FLOAT, strip.data());
+        if(!success)
+            throw std::runtime_error("Can't write output image file '" + path + "'.");
+
+        y += nbStripRows;
+        nbStripRows = 0;
+    }
+};
+
+ImageRowsWriter::ImageRowsWriter(const std::string& path, int width, int height, int downscale, int nbLevels,
+                                 EImageQuality imageQuality)
+{
+    const fs::path bPath = fs::path(path);
+    const std::string extension = bPath.extension().string();
+    const bool isEXR = (extension == ".exr");
+
+    int inWidth = width;
+    int inHeight = height;
+    int factor = std::max(1, downscale);
+
+    for(int l = 0; l <= nbLevels; ++l)
+    {
+        std::unique_ptr<Level> level(new Level);
+        level->factor = factor;
+        level->inWidth = inWidth;
+        level->width = inWidth / factor;
+        level->height = inHeight / factor;
+
+        // the pyramid stops at one pixel
+        if(level->width == 0 || level->height == 0)
+            break;
+
+        level->path = (l == 0) ? path : (bPath.parent_path() / bPath.stem()).string() + "_lod" + std::to_string(l) + extension;
+        const fs::path levelPath = fs::path(level->path);
+        level->tmpPath = (levelPath.parent_path() / levelPath.stem()).string() + "." + fs::unique_path().string() + extension;
+
+        ALICEVISION_LOG_DEBUG("[IO] Write Image by rows: " << level->path << std::endl
+          << "\t- width: " << level->width << std::endl
+          << "\t- height: " << level->height);
+
+        level->output = std::unique_ptr<oiio::ImageOutput>(oiio::ImageOutput::create(level->tmpPath));
+        if(!level->output)
+            throw std::runtime_error("Can't write output image file '" + level->path + "'.");
+
+        oiio::ImageSpec imageSpec(level->width, level->height, 3, oiio::TypeDesc::FLOAT);
+        if(isEXR)
+        {
+            imageSpec.attribute("compression", "piz");   // if possible, PIZ compression for openEXR
+            if(imageQuality == EImageQuality::OPTIMIZED)
+                imageSpec.format = oiio::TypeDesc::HALF; // converted by the output
+        }
+        else
+        {
+            imageSpec.attribute("jpeg:subsampling", "4:4:4"); // if possible, always subsampling 4:4:4 for jpeg
+            imageSpec.attribute("CompressionQuality", 100);   // if possible, best compression quality
+            imageSpec.attribute("compression", "none");       // if possible, no compression
+        }
+
+        level->tiled = level->output->supports("tiles");
+        if(level->tiled)
+        {
+            imageSpec.tile_width = EXR_TILE_SIZE;
+            imageSpec.tile_height = EXR_TILE_SIZE;
+            imageSpec.tile_depth = 1;
+        }
+        level->stripHeight = level->tiled ? EXR_TILE_SIZE : ROWS_STRIP_HEIGHT;
+
+        if(!level->output->open(level->tmpPath, imageSpec))
+            throw std::runtime_error("Can't write output image file '" + level->path + "'.");
+
+        level->rowSum.resize(level->width);
+        level->strip.resize(level->width * level->stripHeight);
+
+        // the next level is computed from the output of this one
+        inWidth = level->width;
+        inHeight = level->height;
+        factor = 2;
+
+        _levels.push_back(std::move(level));
+    }
+}
+
+ImageRowsWriter::~ImageRowsWriter()
+{
+    // not closed: an error occured, remove the temporary files
+    for(std::unique_ptr<Level>& level : _levels)
+    {
+        if(level->closed)
+            continue;
+        level->output->close();
+        boost::system::error_code ec;
+        fs::remove(level->tmpPath, ec);
+    }
+}
+
+void ImageRowsWriter::writeRow(const Color* row)
+{
+    if(!_levels.empty())
+        writeRow(0, row);
+}
+
+void ImageRowsWriter::writeRow(std::size_t levelIndex, const Color* row)
+{
+    Level& level = *_levels[levelIndex];
+
+    // the last input rows are dropped if the height is not a multiple of the factor
+    if(level.y + level.nbStripRows >= level.height)
+        return;
+
+    Color* outRow = &level.strip[level.nbStripRows * level.width];
+
+    if(level.factor == 1)
+    {
+        std::copy(row, row + level.width, outRow);
+    }
+    else
+    {
+        if(level.nbSummedRows == 0)
+            std::fill(level.rowSum.begin(), level.rowSum.end(), Color(0.0f, 0.0f, 0.0f));
+
+        // box filter
+        for(int x = 0; x < level.width * level.factor; ++x)
+            level.rowSum[x / level.factor] = level.rowSum[x / level.factor] + row[x];
+
+        if(++level.nbSummedRows < level.factor)
+            return;
+        level.nbSummedRows = 0;
+
+        const float normalization = 1.0f / static_cast<float>(level.factor * level.factor);
+        for(int x = 0; x < level.width; ++x)
+            outRow[x] = level.rowSum[x] * normalization;
+    }
+    ++level.nbStripRows;
+
+    if(levelIndex + 1 < _levels.size())
+        writeRow(levelIndex + 1, outRow);
+
+    if(level.nbStripRows == level.stripHeight || level.y + level.nbStripRows == level.height)
+        level.flush();
+}
+
+void ImageRowsWriter::close()
+{
+    for(std::unique_ptr<Level>& level : _levels)
+    {
+        if(level->closed)
+            continue;
+
+        level->flush();
+        if(level->y != level->height)
+            throw std::runtime_error("Missing rows in the output image file '" + level->path + "'.");
+        if(!level->output->close())
+            throw std::runtime_error("Can't write output image file '" + level->path + "'.");
+        level->closed = true;
+
+        // rename temporay filename
+        fs::rename(level->tmpPath, level->path);
+    }
+}
+
 template<typename T>
 void transposeImage(oiio::TypeDesc typeDesc,
                     int width,
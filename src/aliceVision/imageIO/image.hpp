@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -94,8 +95,53 @@ void readImage(const std::string& path, int& width, int& height, std::vector<rgb
 void readImage(const std::string& path, int& width, int& height, std::vector<float>& buffer);
 void readImage(const std::string& path, int& width, int& height, std::vector<Color>& buffer);
 
+/**
+ * @brief read an image with a given path and buffer at a reduced resolution
+ * @note The smallest MIP level of the file not smaller than the output is read if the format supports it,
+ *       and the downscaled images are kept in the on-disk images cache if it is enabled (see system::DecodedImagesCache)
+ * @param[in] path The given path to the image
+ * @param[in] downscale The downscale factor (the output size is the image size divided by downscale)
+ * @param[out] width The output image width
+ * @param[out] height The output image height
+ * @param[out] buffer The output image buffer
+ */
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<unsigned char>& buffer);
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<unsigned short>& buffer);
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<rgb>& buffer);
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<float>& buffer);
+void readImage(const std::string& path, int downscale, int& width, int& height, std::vector<Color>& buffer);
+
+/**
+ * @brief read a region of a single channel image with a given path and buffer
+ * @note Only the tiles (or the scanlines for non tiled files) covering the region are read
+ * @param[in] path The given path to the image
+ * @param[in] x The region left coordinate
+ * @param[in] y The region top coordinate
+ * @param[in] width The region width
+ * @param[in] height The region height
+ * @param[out] buffer The output region buffer
+ */
+void readImageRegion(const std::string& path, int x, int y, int width, int height, std::vector<unsigned char>& buffer);
+void readImageRegion(const std::string& path, int x, int y, int width, int height, std::vector<float>& buffer);
+
+/**
+ * @brief read a region of an image with a given path and buffer at a reduced resolution
+ * @note The region is read from the MIP level of the requested resolution if the file has one,
+ *       otherwise it is cropped from the downscaled image (see readImage)
+ * @param[in] path The given path to the image
+ * @param[in] downscale The downscale factor of the image the region belongs to
+ * @param[in] x The region left coordinate, at the reduced resolution
+ * @param[in] y The region top coordinate, at the reduced resolution
+ * @param[in] width The region width
+ * @param[in] height The region height
+ * @param[out] buffer The output region buffer
+ */
+void readImageRegion(const std::string& path, int downscale, int x, int y, int width, int height, std::vector<float>& buffer);
+void readImageRegion(const std::string& path, int downscale, int x, int y, int width, int height, std::vector<Color>& buffer);
+
 /**
  * @brief write an image with a given path and buffer
+ * @note The EXR files are tiled so their regions can be read independently (see readImageRegion)
  * @param[in] path The given path to the image
  * @param[in] width The input image width
  * @param[in] height The input image height
@@ -107,6 +153,48 @@ void writeImage(const std::string& path, int width, int height, const std::vecto
 void writeImage(const std::string& path, int width, int height, const std::vector<float>& buffer, EImageQuality imageQuality = EImageQuality::OPTIMIZED, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, int width, int height, const std::vector<Color>& buffer, EImageQuality imageQuality = EImageQuality::OPTIMIZED, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 
+/**
+ * @brief Write a RGB float image row by row, without holding the full image in memory
+ *
+ * The formats supporting it (EXR, TIFF) are written by tiles, the others by scanlines.
+ * The image can be downscaled on the fly (box filter) and the additional levels of a pyramid,
+ * each one half the size of the previous one, can be written in the same pass
+ * in the files <stem>_lod<level><extension>.
+ * As writeImage, the files are written under a temporary name and renamed when closed.
+ */
+class ImageRowsWriter
+{
+public:
+    /**
+     * @param[in] path The output image path
+     * @param[in] width The input image width
+     * @param[in] height The input image height
+     * @param[in] downscale The downscale of the written image
+     * @param[in] nbLevels The num. of additional pyramid levels
+     * @param[in] imageQuality The output image quality
+     */
+    ImageRowsWriter(const std::string& path, int width, int height, int downscale = 1, int nbLevels = 0,
+                    EImageQuality imageQuality = EImageQuality::OPTIMIZED);
+    ~ImageRowsWriter();
+
+    /**
+     * @brief Write the next input row
+     * @param[in] row The row (width pixels)
+     */
+    void writeRow(const Color* row);
+
+    /**
+     * @brief Flush and close all the files, all the input rows must have been written
+     */
+    void close();
+
+private:
+    struct Level;
+    void writeRow(std::size_t levelIndex, const Color* row);
+
+    std::vector<std::unique_ptr<Level>> _levels;
+};
+
 /**
  * @brief transpose a given image buffer
  * @param[in] width The image buffer width
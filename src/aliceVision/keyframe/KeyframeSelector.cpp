@@ -9,9 +9,11 @@
 #include <aliceVision/sensorDB/parseDatabase.hpp>
 #include <aliceVision/feature/sift/ImageDescriber_SIFT.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <tuple>
 #include <cassert>
+#include <exception>
 
 namespace aliceVision {
 namespace keyframe {
@@ -74,8 +76,10 @@ KeyframeSelector::KeyframeSelector(const std::vector<std::string>& mediaPaths,
   // resize selection data vector
   _framesData.resize(nbFrames);
 
-  // create SIFT image describer
-  _imageDescriber.reset(new feature::ImageDescriber_SIFT());
+  // create SIFT image describers, one per media (the medias are processed in parallel)
+  for(std::size_t mediaIndex = 0; mediaIndex < _mediaPaths.size(); ++mediaIndex)
+    _imageDescribers.emplace_back(new feature::ImageDescriber_SIFT());
+  _mediaPyramids.resize(_mediaPaths.size());
 }
 
 void KeyframeSelector::process()
@@ -89,6 +93,11 @@ void KeyframeSelector::process()
   // process variables
   const unsigned int frameStep = _maxFrameStep - _minFrameStep;
   const unsigned int tileSharpSubset =  (_nbTileSide * _nbTileSide) / _sharpSubset;
+  const int nbMedias = static_cast<int>(_feeds.size());
+
+  // one image per media, the medias are read and evaluated in parallel (each feed by a single thread)
+  std::vector< image::Image<image::RGBColor> > mediaImages(nbMedias);
+  std::vector<char> mediaSelected(nbMedias);
   
   for(std::size_t mediaIndex = 0 ; mediaIndex < _feeds.size(); ++mediaIndex)
   {
@@ -125,33 +134,45 @@ void KeyframeSelector::process()
   for(std::size_t frameIndex = 0; frameIndex < _framesData.size(); ++frameIndex)
   {
     ALICEVISION_LOG_TRACE("frame : " << frameIndex);
-    bool frameSelected = true;
     auto& frameData = _framesData.at(frameIndex);
     frameData.mediasData.resize(_feeds.size());
 
-    for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
+    std::exception_ptr readError;
+
+    #pragma omp parallel for schedule(dynamic) if(nbMedias > 1)
+    for(int mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
     {
-      ALICEVISION_LOG_TRACE("media : " << _mediaPaths.at(mediaIndex));
       auto& feed = *_feeds.at(mediaIndex);
+      camera::PinholeRadialK3 mediaIntrinsics;
+      bool mediaHasIntrinsics = false;
+      std::string mediaImgName;
 
-      if(frameSelected) // false if a camera of a rig is not selected
+      if(feed.readImage(mediaImages.at(mediaIndex), mediaIntrinsics, mediaImgName, mediaHasIntrinsics))
       {
-        if(!feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics))
-        {
-          ALICEVISION_LOG_ERROR("Cannot read frame '" << currentImgName << "' !");
-          throw std::invalid_argument("Cannot read frame '" + currentImgName + "' !");
-        }
-
         // compute sharpness and sparse distance
-        if(!computeFrameData(image, frameIndex, mediaIndex, tileSharpSubset))
-        {
-          frameSelected = false;
-        }
+        mediaSelected.at(mediaIndex) = computeFrameData(mediaImages.at(mediaIndex), frameIndex, mediaIndex, tileSharpSubset);
+      }
+      else
+      {
+        ALICEVISION_LOG_ERROR("Cannot read frame '" << mediaImgName << "' !");
+        #pragma omp critical
+        readError = std::make_exception_ptr(std::invalid_argument("Cannot read frame '" + mediaImgName + "' !"));
       }
 
       feed.goToNextFrame();
     }
 
+    if(readError)
+      std::rethrow_exception(readError);
+
+    // false if a camera of a rig is not selected
+    bool frameSelected = true;
+    for(int mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
+    {
+      frameSelected = frameSelected && mediaSelected.at(mediaIndex);
+      frameData.maxDistScore = std::max(frameData.maxDistScore, frameData.mediasData.at(mediaIndex).distScore);
+    }
+
     {
       if(frameSelected)
       {
@@ -191,18 +212,39 @@ void KeyframeSelector::process()
         ALICEVISION_LOG_INFO("keyframe choice : " << keyframeIndex << std::endl);
 
         // write keyframe
-        for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
+        std::exception_ptr writeError;
+
+        #pragma omp parallel for schedule(dynamic) if(nbMedias > 1)
+        for(int mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
         {
           auto& feed = *_feeds.at(mediaIndex);
 
-          feed.goToFrame(keyframeIndex);
-
           if(_maxOutFrame == 0) // no limit of keyframes (direct evaluation)
           {
-            feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
-            writeKeyframe(image, keyframeIndex, mediaIndex);
+            camera::PinholeRadialK3 mediaIntrinsics;
+            bool mediaHasIntrinsics = false;
+            std::string mediaImgName;
+
+            feed.goToFrame(keyframeIndex);
+            feed.readImage(mediaImages.at(mediaIndex), mediaIntrinsics, mediaImgName, mediaHasIntrinsics);
+            try
+            {
+              writeKeyframe(mediaImages.at(mediaIndex), keyframeIndex, mediaIndex);
+            }
+            catch(...)
+            {
+              #pragma omp critical
+              writeError = std::current_exception();
+            }
           }
+
+          // the frames closer than minFrameStep to the keyframe are not evaluated
+          if(keyframeIndex + _minFrameStep < _framesData.size())
+            feed.goToFrame(keyframeIndex + _minFrameStep);
         }
+
+        if(writeError)
+          std::rethrow_exception(writeError);
         _framesData[keyframeIndex].keyframe = true;
         _keyframeIndexes.push_back(keyframeIndex);
 
@@ -236,17 +278,40 @@ void KeyframeSelector::process()
 
     const std::size_t nbOutFrames = std::min(static_cast<std::size_t>(_maxOutFrame), keyframes.size());
 
+    // the keyframes are sorted by frame index to read each media forward
+    std::vector<std::size_t> outFrameIndexes;
     for(std::size_t i = 0; i < nbOutFrames; ++i)
+      outFrameIndexes.push_back(std::get<2>(keyframes.at(i)));
+    std::sort(outFrameIndexes.begin(), outFrameIndexes.end());
+
+    std::exception_ptr writeError;
+
+    #pragma omp parallel for schedule(dynamic) if(nbMedias > 1)
+    for(int mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
     {
-      const std::size_t frameIndex = std::get<2>(keyframes.at(i));
-      for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
+      auto& feed = *_feeds.at(mediaIndex);
+      camera::PinholeRadialK3 mediaIntrinsics;
+      bool mediaHasIntrinsics = false;
+      std::string mediaImgName;
+
+      for(const std::size_t frameIndex : outFrameIndexes)
       {
-        auto& feed = *_feeds.at(mediaIndex);
         feed.goToFrame(frameIndex);
-        feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
-        writeKeyframe(image, frameIndex, mediaIndex);
+        feed.readImage(mediaImages.at(mediaIndex), mediaIntrinsics, mediaImgName, mediaHasIntrinsics);
+        try
+        {
+          writeKeyframe(mediaImages.at(mediaIndex), frameIndex, mediaIndex);
+        }
+        catch(...)
+        {
+          #pragma omp critical
+          writeError = std::current_exception();
+        }
       }
     }
+
+    if(writeError)
+      std::rethrow_exception(writeError);
   }
 }
 
@@ -265,16 +330,18 @@ float KeyframeSelector::computeSharpness(const image::Image<float>& imageGray,
   scharrYDer = scharrYDer.cwiseAbs(); // absolute value
 
   // image tiles
-  std::vector<float> averageTileIntensity;
+  const int nbTiles = static_cast<int>(_nbTileSide * _nbTileSide);
+  std::vector<float> averageTileIntensity(nbTiles);
   const float tileSizeInv = 1 / static_cast<float>(tileHeight * tileWidth);
 
-  for(std::size_t y =  0; y < (_nbTileSide * tileHeight); y += tileHeight)
+  // only parallel when a single media is processed (not nested in the per media loop)
+  #pragma omp parallel for
+  for(int tile = 0; tile < nbTiles; ++tile)
   {
-    for(std::size_t x =  0; x < (_nbTileSide * tileWidth); x += tileWidth)
-    {
-      const auto sum = scharrXDer.block(y, x, tileHeight, tileWidth).sum() + scharrYDer.block(y, x, tileHeight, tileWidth).sum();
-      averageTileIntensity.push_back(sum * tileSizeInv);
-    }
+    const std::size_t y = (tile / _nbTileSide) * tileHeight;
+    const std::size_t x = (tile % _nbTileSide) * tileWidth;
+    const auto sum = scharrXDer.block(y, x, tileHeight, tileWidth).sum() + scharrYDer.block(y, x, tileHeight, tileWidth).sum();
+    averageTileIntensity.at(tile) = sum * tileSizeInv;
   }
 
   // sort tiles average pixel intensity
@@ -290,16 +357,15 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
                                         std::size_t mediaIndex,
                                         unsigned int tileSharpSubset)
 {
-  image::Image<float> imageGray;                // grayscale image
-  image::Image<float> imageGrayHalfSample;      // half resolution grayscale image
-  
   const auto& currMediaInfo = _mediasInfo.at(mediaIndex);
   auto& currframeData = _framesData.at(frameIndex);
   auto& currMediaData = currframeData.mediasData.at(mediaIndex);
 
   // get grayscale image and resize
-  image::ConvertPixelType(image, &imageGray);
-  image::ImageHalfSample(imageGray, imageGrayHalfSample);
+  auto& pyramid = _mediaPyramids.at(mediaIndex);
+  image::ConvertPixelType(image, &pyramid.base());
+  pyramid.buildFromBase(2, image::EImagePyramidFilter::POINT);
+  const image::Image<float>& imageGrayHalfSample = pyramid.getLevel(1); // half resolution grayscale image
 
   // compute sharpness
   currMediaData.sharpness = computeSharpness(imageGrayHalfSample,
@@ -315,7 +381,7 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
 
     // compute current frame sparse histogram
     std::unique_ptr<feature::Regions> regions;
-    _imageDescriber->describe(imageGrayHalfSample, regions);
+    _imageDescribers.at(mediaIndex)->describe(imageGrayHalfSample, regions);
     currMediaData.histogram = voctree::SparseHistogram(_voctree->quantizeToSparse(dynamic_cast<feature::SIFT_Regions*>(regions.get())->Descriptors()));
 
     // compute sparseDistance
@@ -330,7 +396,6 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
           currMediaData.distScore = std::max(currMediaData.distScore, std::abs(voctree::sparseDistance(media.histogram, currMediaData.histogram, "strongCommonPoints")));
         }
       }
-      currframeData.maxDistScore = std::max(currframeData.maxDistScore, currMediaData.distScore);
       ALICEVISION_LOG_TRACE(" - distScore : " << currMediaData.distScore);
     }
 
@@ -9,6 +9,8 @@
 #include <aliceVision/feature/feature.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/resampling.hpp>
 
 #include <OpenImageIO/imageio.h>
 
@@ -21,13 +23,6 @@ namespace oiio = OIIO;
 
 namespace aliceVision {
 
-namespace image {
-
-template<typename T>
-class Image;
-
-} // namespace image
-
 namespace keyframe {
 
 class KeyframeSelector
@@ -214,8 +209,10 @@ private:
 
   // Tools
 
-  /// Image describer in order to extract describer
-  std::unique_ptr<feature::ImageDescriber> _imageDescriber;
+  /// Image describers in order to extract describer (one per media)
+  std::vector< std::unique_ptr<feature::ImageDescriber> > _imageDescribers;
+  /// Grayscale pyramids (one per media), their levels are reused from one frame to the next
+  std::vector< image::ImagePyramid< image::Image<float> > > _mediaPyramids;
   /// Voctree in order to compute sparseHistogram
   std::unique_ptr< aliceVision::voctree::VocabularyTree<DescriptorFloat> > _voctree;
   /// Feed provider for media paths images extraction
@@ -91,8 +91,13 @@ public:
   /// Get back solution. Call it after solve.
   virtual bool getSolution(std::vector<double> & estimatedParams) = 0;
 
+  /// Start each solve from the basis of the previous one (if supported by the solver).
+  /// Useful for a sequence of problems of the same dimensions, as the bisection steps.
+  void setWarmStart(bool warmStart) { _warmStart = warmStart; }
+
 protected :
   int _nbParams; // The number of parameter considered in constraint formulation.
+  bool _warmStart = false; // Reuse the previous basis.
 };
 
 } // namespace linearProgramming
@@ -19,7 +19,9 @@
 
 #include "CoinPackedMatrix.hpp"
 #include "CoinPackedVector.hpp"
+#include "CoinWarmStartBasis.hpp"
 
+#include <memory>
 #include <vector>
 
 namespace aliceVision   {
@@ -47,6 +49,7 @@ public :
 
 private :
   SOLVERINTERFACE *si;
+  std::unique_ptr<CoinWarmStart> _basis; // Basis of the last solve (warm start).
 };
 
 
@@ -284,7 +287,23 @@ bool OSIXSolver<SOLVERINTERFACE>::solve()
   if ( si != nullptr )
   {
     si->getModelPtr()->setPerturbation(50);
-    si->initialSolve();
+
+    // Warm start from the previous basis if the problem has the same dimensions
+    const CoinWarmStartBasis * basis = dynamic_cast<const CoinWarmStartBasis*>(_basis.get());
+    if (_warmStart && basis != nullptr &&
+        basis->getNumStructural() == si->getNumCols() &&
+        basis->getNumArtificial() == si->getNumRows() &&
+        si->setWarmStart(basis))
+    {
+      si->resolve();
+    }
+    else
+    {
+      si->initialSolve();
+    }
+
+    if (_warmStart)
+      _basis.reset(si->getWarmStart());
     return si->isProvenOptimal();
   }
   return false;
@@ -10,6 +10,7 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/linearProgramming/ISolver.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <vector>
@@ -23,9 +24,16 @@ namespace linearProgramming  {
 /// The bisection algorithm continue as long as
 ///  precision or max iteration number is not reach.
 ///
+/// Several gamma probes are evaluated in parallel at each round, one per solver:
+/// the interval is divided in solvers.size()+1 parts (the mid-point for one solver).
+/// The feasibility being monotonic in gamma, the first feasible probe gives the
+/// new upper bound and the previous probe the new lower bound.
+/// Each solver is warm started from its basis of the previous round.
+/// The constraint builder must support concurrent Build calls (read-only).
+///
 template <typename ConstraintBuilder, typename ConstraintType>
 bool BisectionLP(
-  ISolver & solver,
+  const std::vector<ISolver*> & solvers,
   ConstraintBuilder & cstraintBuilder,
   std::vector<double> * parameters,
   double gammaUp  = 1.0,  // Upper bound
@@ -35,29 +43,47 @@ bool BisectionLP(
   double * bestFeasibleGamma = nullptr, // value of best bisection found value
   bool bVerbose = false)
 {
+  const int nbProbes = static_cast<int>(solvers.size());
+  if (nbProbes == 0)
+    return false;
+
+  for (ISolver * solver : solvers)
+    solver->setWarmStart(true);
+
   int k = 0;
   bool bModelFound = false;
-  ConstraintType constraint;
+  std::vector<ConstraintType> constraints(nbProbes);
+  std::vector<double> gammas(nbProbes);
+  std::vector<char> feasible(nbProbes);
   do
   {
     ++k; // One more iteration
 
-    double gamma = (gammaLow + gammaUp) / 2.0;
+    for (int p = 0; p < nbProbes; ++p)
+      gammas[p] = gammaLow + (gammaUp - gammaLow) * (p + 1) / (nbProbes + 1);
 
-    //-- Setup constraint and solver
-    cstraintBuilder.Build(gamma, constraint);
-    solver.setup( constraint );
-    //--
-    // Solving
-    bool bFeasible = solver.solve();
-    //--
+    #pragma omp parallel for if(nbProbes > 1)
+    for (int p = 0; p < nbProbes; ++p)
+    {
+      //-- Setup constraint and solver
+      cstraintBuilder.Build(gammas[p], constraints[p]);
+      solvers[p]->setup( constraints[p] );
+      //--
+      // Solving
+      feasible[p] = solvers[p]->solve();
+      //--
+    }
 
-    if (bFeasible)
+    const int firstFeasible = static_cast<int>(std::find(feasible.begin(), feasible.end(), 1) - feasible.begin());
+    if (firstFeasible < nbProbes)
     {
+      const double gamma = gammas[firstFeasible];
       gammaUp = gamma;
+      if (firstFeasible > 0)
+        gammaLow = gammas[firstFeasible - 1];
       if (bestFeasibleGamma)
         *bestFeasibleGamma = gamma;
-      solver.getSolution(*parameters);
+      solvers[firstFeasible]->getSolution(*parameters);
       bModelFound = true;
 
       if(bVerbose)
@@ -67,14 +93,36 @@ bool BisectionLP(
     }
     else
     {
-      gammaLow = gamma;
+      gammaLow = gammas.back();
       if(bVerbose)
-        ALICEVISION_LOG_DEBUG("Not feasible with gamma: " << gamma);
+        ALICEVISION_LOG_DEBUG("Not feasible with gamma: " << gammaLow);
     }
   } while (k < maxIteration && gammaUp - gammaLow > eps);
 
+  for (ISolver * solver : solvers)
+    solver->setWarmStart(false);
+
   return bModelFound;
 }
 
+/// Bisection with a single solver: one mid-point probe per iteration,
+/// each LP is warm started from the basis of the previous iteration.
+template <typename ConstraintBuilder, typename ConstraintType>
+bool BisectionLP(
+  ISolver & solver,
+  ConstraintBuilder & cstraintBuilder,
+  std::vector<double> * parameters,
+  double gammaUp  = 1.0,  // Upper bound
+  double gammaLow = 0.0,  // lower bound
+  double eps      = 1e-8, // precision that stop dichotomy
+  const int maxIteration = 20, // max number of iteration
+  double * bestFeasibleGamma = nullptr, // value of best bisection found value
+  bool bVerbose = false)
+{
+  return BisectionLP<ConstraintBuilder, ConstraintType>(
+    std::vector<ISolver*>(1, &solver), cstraintBuilder, parameters,
+    gammaUp, gammaLow, eps, maxIteration, bestFeasibleGamma, bVerbose);
+}
+
 } // namespace linearProgramming
 } // namespace aliceVision
@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <iostream>
+#include <random>
 #include <vector>
 
 #include "aliceVision/multiview/NViewDataSet.hpp"
@@ -90,6 +91,62 @@ BOOST_AUTO_TEST_CASE(lInfinityCV_Triangulation_OSICLPSOLVER) {
   d2.ExportToPLY("test_After_Infinity_Triangulation_OSICLP.ply");
 }
 
+BOOST_AUTO_TEST_CASE(lInfinityCV_Triangulation_ParallelBisection_OSICLPSOLVER) {
+
+  NViewDataSet d = NRealisticCamerasRing(6, 10,
+    NViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  std::vector<Mat34> vec_Pi;
+  for (int i = 0; i < d._n; ++i)
+    vec_Pi.push_back(d.P(i));
+
+  // noisy observations, the optimal gamma is not 0
+  std::mt19937 randomNumberGenerator(42);
+  std::normal_distribution<double> noise(0.0, 1e-3);
+
+  for (int k = 0; k < d._x[0].cols(); ++k)
+  {
+    Mat2X x_ij;
+    x_ij.resize(2,d._n);
+    for (int i = 0; i < d._n; ++i)
+      x_ij.col(i) = d._x[i].col(k) + Vec2(noise(randomNumberGenerator), noise(randomNumberGenerator));
+
+    Triangulation_L1_ConstraintBuilder cstBuilder(vec_Pi, x_ij);
+
+    // one mid-point probe per iteration
+    std::vector<double> vec_solutionSerial(3);
+    double gammaSerial = -1.0;
+    OSI_CISolverWrapper wrapperOSICLPSolver(3);
+    BOOST_CHECK(
+      (BisectionLP<Triangulation_L1_ConstraintBuilder,LPConstraints>(
+      wrapperOSICLPSolver,
+      cstBuilder,
+      &vec_solutionSerial,
+      1.0, 0.0, 1e-8, 20, &gammaSerial))
+    );
+
+    // three probes per iteration
+    std::vector<double> vec_solutionParallel(3);
+    double gammaParallel = -1.0;
+    OSI_CISolverWrapper wrapper0(3), wrapper1(3), wrapper2(3);
+    const std::vector<ISolver*> solvers = {&wrapper0, &wrapper1, &wrapper2};
+    BOOST_CHECK(
+      (BisectionLP<Triangulation_L1_ConstraintBuilder,LPConstraints>(
+      solvers,
+      cstBuilder,
+      &vec_solutionParallel,
+      1.0, 0.0, 1e-8, 20, &gammaParallel))
+    );
+
+    // same optimum, up to the precision of the serial bisection (2^-20)
+    BOOST_CHECK_GT(gammaSerial, 0.0);
+    BOOST_CHECK_SMALL(gammaSerial - gammaParallel, 2e-6);
+
+    const Vec3 XParallel(vec_solutionParallel[0], vec_solutionParallel[1], vec_solutionParallel[2]);
+    BOOST_CHECK_SMALL(DistanceLInfinity(XParallel, Vec3(d._X.col(k))), 1e-1);
+  }
+}
+
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_MOSEK)
 BOOST_AUTO_TEST_CASE(computervision_Triangulation_MOSEK) {
 
@@ -11,7 +11,9 @@
 
 #include "aliceVision/linearProgramming/lInfinityCV/resection.hpp"
 #include "aliceVision/linearProgramming/lInfinityCV/resection_kernel.hpp"
+#include "aliceVision/multiview/resection/ResectionKernel.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 namespace aliceVision {
@@ -28,6 +30,34 @@ void translate(const Mat3X & X, const Vec3 & vecTranslation,
   }
 }
 
+/**
+ * @brief Compute the L-infinity residual (the gamma of the resection LP) of the
+ * linear least squares (DLT) resection, a feasible upper bound for the bisection.
+ * @param[in] pt2D The 2D points
+ * @param[in] XPoints The translated 3D points (X0 = (0,0,0))
+ * @param[out] P The DLT projection matrix, normalized as in the LP (P(2,3) = 1)
+ * @return the residual or a negative value if the DLT solution doesn't respect the LP constraints (cheirality)
+ */
+double l2ResectionGamma(const Mat &pt2D, const Mat3X & XPoints, Mat34 & P)
+{
+  std::vector<Mat34> Ps;
+  resection::kernel::SixPointResectionSolver::Solve(pt2D, XPoints, &Ps, false);
+  if (Ps.empty() || std::abs(Ps.front()(2,3)) < std::numeric_limits<double>::epsilon())
+    return -1.0;
+
+  P = Ps.front() / Ps.front()(2,3);
+  double gamma = 0.0;
+  for (Mat::Index i = 0; i < XPoints.cols(); ++i)
+  {
+    const Vec3 x = P * XPoints.col(i).homogeneous();
+    if (x(2) <= 0.0)
+      return -1.0;
+    gamma = std::max(gamma, std::abs(x(0) / x(2) - pt2D(0,i)));
+    gamma = std::max(gamma, std::abs(x(1) / x(2) - pt2D(1,i)));
+  }
+  return gamma;
+}
+
 void l1SixPointResectionSolver::Solve(const Mat &pt2D, const Mat &pt3d, vector<Mat34> *Ps) {
   assert(2 == pt2D.rows());
   assert(3 == pt3d.rows());
@@ -42,6 +72,11 @@ void l1SixPointResectionSolver::Solve(const Mat &pt2D, const Mat &pt3d, vector<M
   Mat3X XPoints;
   translate(pt3d, vecTranslation, &XPoints);
 
+  // the L2 solution gives a tighter initial upper bound
+  Mat34 P_L2;
+  const double gammaL2 = l2ResectionGamma(pt2D, XPoints, P_L2);
+  const double gammaUp = (gammaL2 >= 0.0) ? std::min(1.0, gammaL2 * (1.0 + 1e-6) + 1e-12) : 1.0;
+
   std::vector<double> vec_solution(11);
   OSI_CISolverWrapper wrapperLpSolve(vec_solution.size());
   Resection_L1_ConstraintBuilder cstBuilder(pt2D, XPoints);
@@ -50,7 +85,7 @@ void l1SixPointResectionSolver::Solve(const Mat &pt2D, const Mat &pt3d, vector<M
     wrapperLpSolve,
     cstBuilder,
     &vec_solution,
-    1.0,
+    gammaUp,
     0.0))
     )
   {
@@ -62,6 +97,11 @@ void l1SixPointResectionSolver::Solve(const Mat &pt2D, const Mat &pt3d, vector<M
     P = P * translationMatrix;
     Ps->push_back(P);
   }
+  else if (gammaUp < 1.0)
+  {
+    // the L2 solution is already optimal up to the bisection precision
+    Ps->push_back(P_L2 * translationMatrix);
+  }
 }
 
 }  // namespace kernel
@@ -25,6 +25,7 @@
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <exception>
 #include <sstream>
 
 namespace aliceVision {
@@ -399,22 +400,39 @@ bool CCTagLocalizer::localizeRig(const std::vector<image::Image<float>> & vec_im
   assert(numCams == vec_subPoses.size() + 1);
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
-  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
-  
-  //@todo parallelize?
-  for(size_t i = 0; i < numCams; ++i)
-  {
-    image::Image<unsigned char> imageGrayUChar; // cctag image describer don't support float image
-    imageGrayUChar = (vec_imageGrey.at(i).GetMat() * 255.f).cast<unsigned char>();
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize(numCams);
 
-    // extract descriptors and features from each image
-    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTag from query image...");
-    _imageDescriber.setConfigurationPreset(param->_featurePreset);
-    _imageDescriber.describe(imageGrayUChar, vec_queryRegions[i][_imageDescriber.getDescriberType()]);
-    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " <<  vec_queryRegions[i].at(_imageDescriber.getDescriberType())->RegionCount() << " features");
-    // add the image size for this image
-    vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+  _imageDescriber.setConfigurationPreset(param->_featurePreset);
+
+  // the cameras are detected at the same time, each one on a free CUDA pipe of the describer
+  const int nbThreads = static_cast<int>(std::max<std::size_t>(1, std::min(numCams, _imageDescriber.getMaxConcurrentDescriptions())));
+  std::exception_ptr describeException;
+
+  #pragma omp parallel for num_threads(nbThreads)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
+  {
+    try
+    {
+      image::Image<unsigned char> imageGrayUChar; // cctag image describer don't support float image
+      imageGrayUChar = (vec_imageGrey.at(i).GetMat() * 255.f).cast<unsigned char>();
+
+      // extract descriptors and features from each image
+      ALICEVISION_LOG_DEBUG("[features]\tExtract CCTag from query image " << i << "...");
+      _imageDescriber.describe(imageGrayUChar, vec_queryRegions[i][_imageDescriber.getDescriberType()]);
+      ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " <<  vec_queryRegions[i].at(_imageDescriber.getDescriberType())->RegionCount() << " features");
+      // add the image size for this image
+      vec_imageSize[i] = std::make_pair(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+    }
+    catch(...)
+    {
+      #pragma omp critical
+      describeException = std::current_exception();
+    }
   }
+
+  if(describeException)
+    std::rethrow_exception(describeException);
+
   assert(vec_imageSize.size() == vec_queryRegions.size());
           
   return localizeRig(vec_queryRegions,
@@ -491,10 +509,11 @@ bool CCTagLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsPer
   std::vector<Mat> vec_pts2D(numCams);
   std::vector<std::vector<voctree::DocMatch> > vec_matchedImages(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for( size_t i = 0; i < numCams; ++i )
+  // for each camera retrieve the associations in parallel,
+  // each camera has its own associations
+  std::size_t numAssociations = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:numAssociations)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
   {
     // this map is used to collect the 2d-3d associations as we go through the images
     // the key is a pair <Id3D, Id2d>
@@ -0,0 +1,275 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LandmarksDatabase.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+const char landmarksDatabaseMagic[8] = {'A', 'V', 'L', 'A', 'N', 'D', 'M', 'K'};
+const std::uint32_t landmarksDatabaseVersion = 1;
+const std::uint64_t landmarksDatabaseAlignment = 16;
+
+std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + landmarksDatabaseAlignment - 1) / landmarksDatabaseAlignment * landmarksDatabaseAlignment;
+}
+
+/// An observation of a landmark: a region of a view
+struct LandmarkObservation
+{
+  const feature::Regions* regions;
+  std::size_t index;
+};
+
+/// Return the observation with the smallest sum of squared descriptor distances to the others
+const LandmarkObservation& getMedoid(const std::vector<LandmarkObservation>& observations)
+{
+  if(observations.size() <= 2)
+    return observations.front();
+
+  std::size_t medoid = 0;
+  double medoidDistance = std::numeric_limits<double>::max();
+  for(std::size_t i = 0; i < observations.size(); ++i)
+  {
+    double distance = 0.0;
+    for(std::size_t j = 0; j < observations.size() && distance < medoidDistance; ++j)
+    {
+      if(i != j)
+        distance += observations[i].regions->SquaredDescriptorDistance(observations[i].index, observations[j].regions, observations[j].index);
+    }
+    if(distance < medoidDistance)
+    {
+      medoid = i;
+      medoidDistance = distance;
+    }
+  }
+  return observations[medoid];
+}
+
+} // namespace
+
+std::string getLandmarksDatabasePath(const std::string& folder, feature::EImageDescriberType describerType)
+{
+  return (fs::path(folder) / (feature::EImageDescriberType_enumToString(describerType) + ".landmarks")).string();
+}
+
+void saveLandmarksDatabase(const std::string& filepath,
+                           feature::EImageDescriberType describerType,
+                           const feature::RegionsPerView& regionsPerView,
+                           const ReconstructedRegionsMappingPerView& mappingPerView)
+{
+  LandmarksDatabaseHeader header;
+  std::memset(&header, 0, sizeof(LandmarksDatabaseHeader));
+  std::memcpy(header.magic, landmarksDatabaseMagic, sizeof(header.magic));
+  header.version = landmarksDatabaseVersion;
+  header.describerType = static_cast<std::uint32_t>(describerType);
+
+  // the landmarks, in the order of the first view observing them
+  std::vector<std::uint32_t> landmarkIds;
+  std::vector<std::vector<LandmarkObservation>> landmarkObservations;
+  std::unordered_map<IndexT, std::uint32_t> landmarkIndexes;
+
+  std::vector<LandmarksDatabaseView> views;
+  std::vector<const feature::Regions*> viewRegions;
+  std::vector<std::uint32_t> observations;
+
+  for(const auto& regionsPerDescIt : regionsPerView.getData())
+  {
+    const auto regionsIt = regionsPerDescIt.second.find(describerType);
+    if(regionsIt == regionsPerDescIt.second.end())
+      continue;
+
+    const IndexT viewId = regionsPerDescIt.first;
+    const feature::Regions& regions = *regionsIt->second;
+    const std::vector<IndexT>& associated3dPoint = mappingPerView.at(viewId).at(describerType)._associated3dPoint;
+
+    if(associated3dPoint.size() != regions.RegionCount())
+      throw std::runtime_error("Can't save landmarks database '" + filepath + "', invalid reconstructed regions of view " + std::to_string(viewId) + " !");
+
+    if(views.empty())
+    {
+      header.featureByteSize = regions.FeatureByteSize();
+      header.descriptorByteSize = regions.DescriptorByteSize();
+    }
+    else if(header.featureByteSize != regions.FeatureByteSize() ||
+            header.descriptorByteSize != regions.DescriptorByteSize())
+    {
+      throw std::runtime_error("Can't save landmarks database '" + filepath + "', incompatible regions type in view " + std::to_string(viewId) + " !");
+    }
+
+    views.push_back({viewId, regions.RegionCount(), observations.size()});
+    viewRegions.push_back(&regions);
+
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+    {
+      const auto landmarkIt = landmarkIndexes.emplace(associated3dPoint[i], static_cast<std::uint32_t>(landmarkIds.size()));
+      if(landmarkIt.second)
+      {
+        landmarkIds.push_back(associated3dPoint[i]);
+        landmarkObservations.emplace_back();
+      }
+      landmarkObservations[landmarkIt.first->second].push_back({&regions, i});
+      observations.push_back(landmarkIt.first->second);
+    }
+  }
+
+  header.nbLandmarks = landmarkIds.size();
+  header.nbViews = views.size();
+  header.nbObservations = observations.size();
+  header.landmarksOffset = alignOffset(sizeof(LandmarksDatabaseHeader));
+  header.descriptorsOffset = alignOffset(header.landmarksOffset + header.nbLandmarks * sizeof(std::uint32_t));
+  header.viewsOffset = alignOffset(header.descriptorsOffset + header.nbLandmarks * header.descriptorByteSize);
+  header.featuresOffset = alignOffset(header.viewsOffset + header.nbViews * sizeof(LandmarksDatabaseView));
+  header.observationsOffset = alignOffset(header.featuresOffset + header.nbObservations * header.featureByteSize);
+
+  std::ofstream stream(filepath, std::ios::out | std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Can't save landmarks database, can't open '" + filepath + "' !");
+
+  const auto writeBlock = [&](std::uint64_t offset, const void* data, std::uint64_t size)
+  {
+    const char zeros[landmarksDatabaseAlignment] = {0};
+    stream.write(zeros, offset - static_cast<std::uint64_t>(stream.tellp()));
+    if(size > 0)
+      stream.write(static_cast<const char*>(data), size);
+  };
+
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(LandmarksDatabaseHeader));
+  writeBlock(header.landmarksOffset, landmarkIds.data(), landmarkIds.size() * sizeof(std::uint32_t));
+
+  writeBlock(header.descriptorsOffset, nullptr, 0);
+  for(const std::vector<LandmarkObservation>& landmark : landmarkObservations)
+  {
+    const LandmarkObservation& representative = getMedoid(landmark);
+    stream.write(static_cast<const char*>(representative.regions->DescriptorRawData()) + representative.index * header.descriptorByteSize, header.descriptorByteSize);
+  }
+
+  writeBlock(header.viewsOffset, views.data(), views.size() * sizeof(LandmarksDatabaseView));
+
+  writeBlock(header.featuresOffset, nullptr, 0);
+  for(const feature::Regions* regions : viewRegions)
+  {
+    if(regions->RegionCount() > 0)
+      stream.write(static_cast<const char*>(regions->FeatureRawData()), regions->RegionCount() * header.featureByteSize);
+  }
+
+  writeBlock(header.observationsOffset, observations.data(), observations.size() * sizeof(std::uint32_t));
+
+  if(!stream.good())
+    throw std::runtime_error("Can't save landmarks database, '" + filepath + "' is incorrect !");
+
+  ALICEVISION_LOG_INFO("Landmarks database '" << filepath << "': " << header.nbLandmarks << " landmarks, "
+                       << header.nbObservations << " observations in " << header.nbViews << " views.");
+}
+
+LandmarksDatabaseReader::LandmarksDatabaseReader(const std::string& filepath)
+  : _filepath(filepath)
+{
+  if(!fs::exists(filepath))
+    throw std::runtime_error("Can't load landmarks database, can't open '" + filepath + "' !");
+
+  _file.open(filepath);
+
+  if(!_file.is_open() || _file.size() < sizeof(LandmarksDatabaseHeader))
+    throw std::runtime_error("Can't load landmarks database, '" + filepath + "' is incorrect !");
+
+  std::memcpy(&_header, _file.data(), sizeof(LandmarksDatabaseHeader));
+
+  if(std::memcmp(_header.magic, landmarksDatabaseMagic, sizeof(_header.magic)) != 0)
+    throw std::runtime_error("Can't load landmarks database, '" + filepath + "' is not a landmarks database !");
+
+  if(_header.version != landmarksDatabaseVersion)
+    throw std::runtime_error("Can't load landmarks database, '" + filepath + "' has an unsupported version (" + std::to_string(_header.version) + ") !");
+
+  // check that all the blocks are in the file
+  const std::uint64_t fileSize = _file.size();
+  const auto checkBlock = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t elementSize)
+  {
+    if(offset % landmarksDatabaseAlignment != 0 || offset > fileSize ||
+       (elementSize > 0 && count > (fileSize - offset) / elementSize))
+      throw std::runtime_error("Can't load landmarks database, '" + filepath + "' is truncated !");
+  };
+  checkBlock(_header.landmarksOffset, _header.nbLandmarks, sizeof(std::uint32_t));
+  checkBlock(_header.descriptorsOffset, _header.nbLandmarks, _header.descriptorByteSize);
+  checkBlock(_header.viewsOffset, _header.nbViews, sizeof(LandmarksDatabaseView));
+  checkBlock(_header.featuresOffset, _header.nbObservations, _header.featureByteSize);
+  checkBlock(_header.observationsOffset, _header.nbObservations, sizeof(std::uint32_t));
+
+  const LandmarksDatabaseView* views = reinterpret_cast<const LandmarksDatabaseView*>(_file.data() + _header.viewsOffset);
+
+  for(std::uint64_t i = 0; i < _header.nbViews; ++i)
+  {
+    const LandmarksDatabaseView& view = views[i];
+
+    if(view.firstObservation > _header.nbObservations ||
+       view.nbObservations > _header.nbObservations - view.firstObservation)
+      throw std::runtime_error("Can't load landmarks database, '" + filepath + "' is incorrect !");
+
+    _views.emplace(static_cast<IndexT>(view.viewId), view);
+  }
+
+  ALICEVISION_LOG_TRACE("Landmarks database '" << filepath << "': " << _header.nbLandmarks << " landmarks in " << _views.size() << " views.");
+}
+
+std::vector<IndexT> LandmarksDatabaseReader::getViewIds() const
+{
+  std::vector<IndexT> viewIds;
+  viewIds.reserve(_views.size());
+  for(const auto& viewPair : _views)
+    viewIds.push_back(viewPair.first);
+  return viewIds;
+}
+
+void LandmarksDatabaseReader::load(IndexT viewId, feature::Regions& regions, ReconstructedRegionsMapping& mapping) const
+{
+  if(regions.FeatureByteSize() != _header.featureByteSize ||
+     regions.DescriptorByteSize() != _header.descriptorByteSize)
+    throw std::runtime_error("Can't load view " + std::to_string(viewId) + " from landmarks database '" + _filepath + "', incompatible regions type !");
+
+  const auto viewIt = _views.find(viewId);
+  if(viewIt == _views.end())
+    throw std::out_of_range("Can't find view " + std::to_string(viewId) + " in landmarks database '" + _filepath + "' !");
+  const LandmarksDatabaseView& view = viewIt->second;
+
+  const std::uint32_t* landmarkIds = getLandmarkIds();
+  const char* descriptors = static_cast<const char*>(getDescriptorsData());
+  const std::uint32_t* observations = reinterpret_cast<const std::uint32_t*>(_file.data() + _header.observationsOffset) + view.firstObservation;
+
+  // gather the representative descriptors of the observed landmarks
+  std::vector<char> viewDescriptors(view.nbObservations * _header.descriptorByteSize);
+  mapping._associated3dPoint.resize(view.nbObservations);
+  mapping._mapFullToLocal.clear();
+
+  for(std::uint64_t i = 0; i < view.nbObservations; ++i)
+  {
+    if(observations[i] >= _header.nbLandmarks)
+      throw std::runtime_error("Can't load view " + std::to_string(viewId) + " from landmarks database '" + _filepath + "', invalid landmark index !");
+    std::memcpy(viewDescriptors.data() + i * _header.descriptorByteSize, descriptors + observations[i] * _header.descriptorByteSize, _header.descriptorByteSize);
+    mapping._associated3dPoint[i] = landmarkIds[observations[i]];
+  }
+
+  regions.setRawData(view.nbObservations,
+                     _file.data() + _header.featuresOffset + view.firstObservation * _header.featureByteSize,
+                     viewDescriptors.data());
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,155 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/localization/reconstructed_regions.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Landmarks database file layout (version 1, native little-endian), for one describer type:
+ *
+ *   LandmarksDatabaseHeader
+ *   uint32 * nbLandmarks (landmark ids)
+ *   descriptor * nbLandmarks (representative descriptor of each landmark)
+ *   LandmarksDatabaseView * nbViews
+ *   feature * nbObservations (features of the observations, view after view)
+ *   uint32 * nbObservations (landmark index of each observation)
+ *
+ * Each block is 16 bytes aligned and used in place in the memory-mapped file.
+ * The landmarks are ordered by the first view observing them, so the descriptors
+ * of a view are mostly contiguous.
+ */
+struct LandmarksDatabaseHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t describerType;
+  std::uint64_t featureByteSize;
+  std::uint64_t descriptorByteSize;
+  std::uint64_t nbLandmarks;
+  std::uint64_t nbViews;
+  std::uint64_t nbObservations;
+  std::uint64_t landmarksOffset;
+  std::uint64_t descriptorsOffset;
+  std::uint64_t viewsOffset;
+  std::uint64_t featuresOffset;
+  std::uint64_t observationsOffset;
+};
+
+/**
+ * @brief Observations of a view in a landmarks database
+ */
+struct LandmarksDatabaseView
+{
+  std::uint64_t viewId;
+  std::uint64_t nbObservations;
+  std::uint64_t firstObservation;
+};
+
+/**
+ * @brief Get the filename of the landmarks database of a given describer type.
+ * @param[in] folder The landmarks database folder
+ * @param[in] describerType The describer type
+ * @return the database file path (<folder>/<describerType>.landmarks)
+ */
+std::string getLandmarksDatabasePath(const std::string& folder, feature::EImageDescriberType describerType);
+
+/**
+ * @brief Save the reconstructed regions of all the views in a landmarks database.
+ *
+ * Each landmark is stored once with a representative descriptor: the medoid of the
+ * descriptors of its observations (the one with the smallest sum of squared distances
+ * to the others). The views keep the features of their observations.
+ *
+ * @param[in] filepath The output database file path
+ * @param[in] describerType The describer type to save
+ * @param[in] regionsPerView The reconstructed regions of each view
+ * @param[in] mappingPerView The landmark of each reconstructed region
+ * @throw std::runtime_error if the file can't be written
+ */
+void saveLandmarksDatabase(const std::string& filepath,
+                           feature::EImageDescriberType describerType,
+                           const feature::RegionsPerView& regionsPerView,
+                           const ReconstructedRegionsMappingPerView& mappingPerView);
+
+/**
+ * @brief Read the reconstructed regions of the views from a memory-mapped landmarks database.
+ */
+class LandmarksDatabaseReader
+{
+public:
+
+  /**
+   * @brief LandmarksDatabaseReader constructor
+   * @param[in] filepath The database file path
+   * @throw std::runtime_error if the database is not valid
+   */
+  explicit LandmarksDatabaseReader(const std::string& filepath);
+
+  /// Return the describer type of the database
+  feature::EImageDescriberType getDescriberType() const
+  {
+    return static_cast<feature::EImageDescriberType>(_header.describerType);
+  }
+
+  /// Return the number of landmarks of the database
+  std::size_t getNbLandmarks() const
+  {
+    return _header.nbLandmarks;
+  }
+
+  /**
+   * @brief Zero-copy access to the landmark ids.
+   * @note The pointer is valid as long as the reader remains alive.
+   */
+  const std::uint32_t* getLandmarkIds() const
+  {
+    return reinterpret_cast<const std::uint32_t*>(_file.data() + _header.landmarksOffset);
+  }
+
+  /**
+   * @brief Zero-copy access to the representative descriptors of the landmarks.
+   * @note The pointer is valid as long as the reader remains alive.
+   */
+  const void* getDescriptorsData() const
+  {
+    return _file.data() + _header.descriptorsOffset;
+  }
+
+  /// Return all the view ids stored in the database
+  std::vector<IndexT> getViewIds() const;
+
+  /**
+   * @brief Fill the reconstructed regions of a view.
+   * @param[in] viewId The view id
+   * @param[out] regions The regions to fill (allocated with the database describer type)
+   * @param[out] mapping The landmark of each region (the full feature indexes are not stored)
+   */
+  void load(IndexT viewId, feature::Regions& regions, ReconstructedRegionsMapping& mapping) const;
+
+private:
+  std::string _filepath;
+  boost::iostreams::mapped_file_source _file;
+  LandmarksDatabaseHeader _header;
+  std::map<IndexT, LandmarksDatabaseView> _views;
+};
+
+} // namespace localization
+} // namespace aliceVision
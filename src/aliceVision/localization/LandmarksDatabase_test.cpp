@@ -0,0 +1,112 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LandmarksDatabase.hpp"
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#define BOOST_TEST_MODULE LandmarksDatabase
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+const feature::EImageDescriberType describerType = feature::EImageDescriberType::SIFT;
+
+/// Add to a view a region observing a landmark, its descriptor is filled with value
+void addObservation(feature::RegionsPerView& regionsPerView,
+                    localization::ReconstructedRegionsMappingPerView& mappingPerView,
+                    IndexT viewId,
+                    IndexT landmarkId,
+                    unsigned char value)
+{
+  std::unique_ptr<feature::Regions>& regions = regionsPerView.getData()[viewId][describerType];
+  if(!regions)
+    regions.reset(new feature::SIFT_Regions);
+  feature::SIFT_Regions& siftRegions = static_cast<feature::SIFT_Regions&>(*regions);
+
+  siftRegions.Features().emplace_back(viewId * 100.f + landmarkId, landmarkId, 1.f, 0.f);
+  siftRegions.Descriptors().emplace_back(value);
+  mappingPerView[viewId][describerType]._associated3dPoint.push_back(landmarkId);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(LandmarksDatabase_saveLoad)
+{
+  feature::RegionsPerView regionsPerView;
+  localization::ReconstructedRegionsMappingPerView mappingPerView;
+
+  // landmark 7 is seen by the 3 views, its medoid descriptor is the one of view 2
+  addObservation(regionsPerView, mappingPerView, 1, 7, 10);
+  addObservation(regionsPerView, mappingPerView, 1, 3, 50);
+  addObservation(regionsPerView, mappingPerView, 2, 7, 12);
+  addObservation(regionsPerView, mappingPerView, 2, 9, 90);
+  addObservation(regionsPerView, mappingPerView, 5, 9, 91);
+  addObservation(regionsPerView, mappingPerView, 5, 7, 15);
+  // a view without observation
+  regionsPerView.getData()[6][describerType].reset(new feature::SIFT_Regions);
+  mappingPerView[6][describerType];
+
+  const std::string filepath = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%%%.landmarks")).string();
+  localization::saveLandmarksDatabase(filepath, describerType, regionsPerView, mappingPerView);
+
+  {
+    const localization::LandmarksDatabaseReader reader(filepath);
+    BOOST_CHECK(reader.getDescriberType() == describerType);
+
+    // the landmarks are ordered by their first view
+    BOOST_REQUIRE_EQUAL(reader.getNbLandmarks(), 3);
+    BOOST_CHECK_EQUAL(reader.getLandmarkIds()[0], 7);
+    BOOST_CHECK_EQUAL(reader.getLandmarkIds()[1], 3);
+    BOOST_CHECK_EQUAL(reader.getLandmarkIds()[2], 9);
+
+    const std::vector<IndexT> viewIds = reader.getViewIds();
+    BOOST_CHECK_EQUAL(viewIds.size(), 4);
+
+    // one descriptor per landmark, shared by all its observations
+    const unsigned char representatives[] = {12, 50, 90};
+    for(IndexT viewId : viewIds)
+    {
+      feature::SIFT_Regions regions;
+      localization::ReconstructedRegionsMapping mapping;
+      reader.load(viewId, regions, mapping);
+
+      const feature::SIFT_Regions& savedRegions = static_cast<const feature::SIFT_Regions&>(*regionsPerView.getData().at(viewId).at(describerType));
+      const std::vector<IndexT>& savedLandmarks = mappingPerView.at(viewId).at(describerType)._associated3dPoint;
+      BOOST_REQUIRE_EQUAL(regions.RegionCount(), savedRegions.RegionCount());
+      BOOST_CHECK(mapping._associated3dPoint == savedLandmarks);
+
+      for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+      {
+        BOOST_CHECK_EQUAL(regions.Features()[i].x(), savedRegions.Features()[i].x());
+        BOOST_CHECK_EQUAL(regions.Features()[i].y(), savedRegions.Features()[i].y());
+        const std::size_t landmarkIndex = (savedLandmarks[i] == 7) ? 0 : ((savedLandmarks[i] == 3) ? 1 : 2);
+        BOOST_CHECK_EQUAL(int(regions.Descriptors()[i][0]), int(representatives[landmarkIndex]));
+        BOOST_CHECK_EQUAL(int(regions.Descriptors()[i][127]), int(representatives[landmarkIndex]));
+      }
+    }
+
+    feature::SIFT_Float_Regions floatRegions;
+    localization::ReconstructedRegionsMapping mapping;
+    BOOST_CHECK_THROW(reader.load(1, floatRegions, mapping), std::runtime_error);
+    feature::SIFT_Regions regions;
+    BOOST_CHECK_THROW(reader.load(3, regions, mapping), std::out_of_range);
+  }
+
+  // truncated file
+  boost::filesystem::resize_file(filepath, boost::filesystem::file_size(filepath) - 4);
+  BOOST_CHECK_THROW(localization::LandmarksDatabaseReader reader(filepath), std::runtime_error);
+
+  boost::filesystem::remove(filepath);
+}
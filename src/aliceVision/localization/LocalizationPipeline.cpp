@@ -0,0 +1,288 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationPipeline.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+double elapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+void LatencyHistogram::add(double latency)
+{
+  const std::size_t bin = std::min(static_cast<std::size_t>(std::max(0.0, latency)), _bins.size() - 1);
+  ++_bins[bin];
+  ++_count;
+  _sum += latency;
+  _max = std::max(_max, latency);
+}
+
+double LatencyHistogram::percentile(double ratio) const
+{
+  if(_count == 0)
+    return 0.0;
+
+  const std::size_t rank = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(ratio * _count)));
+  std::size_t count = 0;
+  for(std::size_t bin = 0; bin + 1 < _bins.size(); ++bin)
+  {
+    count += _bins[bin];
+    if(count >= rank)
+      return std::min(static_cast<double>(bin + 1), _max);
+  }
+  return _max;
+}
+
+std::ostream& operator<<(std::ostream& os, const LatencyHistogram& histogram)
+{
+  os << "mean: " << histogram.mean() << " ms, "
+     << "median: " << histogram.percentile(0.5) << " ms, "
+     << "90%: " << histogram.percentile(0.9) << " ms, "
+     << "99%: " << histogram.percentile(0.99) << " ms, "
+     << "max: " << histogram.max() << " ms";
+  return os;
+}
+
+LocalizationPipeline::LocalizationPipeline(ILocalizer& localizer,
+                                           const LocalizerParameters& param,
+                                           const std::vector<feature::EImageDescriberType>& describerTypes,
+                                           std::size_t nbExtractionThreads)
+  : _localizer(localizer)
+  , _param(param)
+  , _describerTypes(describerTypes)
+  , _nbExtractionThreads(nbExtractionThreads)
+{
+  if(_nbExtractionThreads == 0)
+    _nbExtractionThreads = std::max(1, omp_get_num_procs() - 2); // the decoding and the localization threads
+}
+
+void LocalizationPipeline::run(const FrameReader& frameReader, const ResultCallback& resultCallback)
+{
+  _decodedFrames.clear();
+  _extractedFrames.clear();
+  _nbFramesInFlight = 0;
+  _nbDecodedFrames = 0;
+  _decodingDone = false;
+  _stopped = false;
+  _exception = nullptr;
+
+  // one frame waits for each worker, and one for the localization
+  _maxFramesInFlight = 2 * _nbExtractionThreads + 1;
+
+  // the image describers are not thread safe, each worker has its own
+  std::vector<Describers> describers(_nbExtractionThreads);
+  for(Describers& workerDescribers : describers)
+  {
+    for(const feature::EImageDescriberType describerType : _describerTypes)
+    {
+      workerDescribers.push_back(feature::createImageDescriber(describerType));
+      workerDescribers.back()->setConfigurationPreset(_param._featurePreset);
+    }
+  }
+
+  ALICEVISION_LOG_DEBUG("Localization pipeline: " << _nbExtractionThreads << " feature extraction thread(s).");
+
+  std::vector<std::thread> threads;
+  threads.emplace_back(&LocalizationPipeline::decodeFrames, this, std::cref(frameReader));
+  for(Describers& workerDescribers : describers)
+    threads.emplace_back(&LocalizationPipeline::runExtractionWorker, this, std::ref(workerDescribers));
+  threads.emplace_back(&LocalizationPipeline::localizeFrames, this, std::cref(resultCallback));
+
+  for(std::thread& thread : threads)
+    thread.join();
+
+  if(_exception)
+    std::rethrow_exception(_exception);
+}
+
+void LocalizationPipeline::decodeFrames(const FrameReader& frameReader)
+{
+  for(std::size_t frameId = 0; ; ++frameId)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _frameDone.wait(lock, [&]{ return _stopped || _nbFramesInFlight < _maxFramesInFlight; });
+      if(_stopped)
+        break;
+    }
+
+    std::unique_ptr<PipelineFrame> frame(new PipelineFrame);
+    frame->frameId = frameId;
+    frame->imageGrey = std::make_shared<image::Image<float>>();
+    frame->readTime = std::chrono::steady_clock::now();
+
+    bool hasFrame = false;
+    try
+    {
+      hasFrame = frameReader(*frame->imageGrey, frame->intrinsics, frame->imagePath, frame->hasIntrinsics);
+    }
+    catch(...)
+    {
+      stop(std::current_exception());
+      break;
+    }
+    if(!hasFrame)
+      break;
+
+    frame->decodeLatency = elapsedMs(frame->readTime);
+    frame->imageSize = std::make_pair(frame->imageGrey->Width(), frame->imageGrey->Height());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _decodedFrames.push_back(std::move(frame));
+    ++_nbFramesInFlight;
+    ++_nbDecodedFrames;
+    _frameDecoded.notify_one();
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _decodingDone = true;
+  _frameDecoded.notify_all();
+  _frameExtracted.notify_all();
+}
+
+void LocalizationPipeline::runExtractionWorker(Describers& describers)
+{
+  while(true)
+  {
+    std::unique_ptr<PipelineFrame> frame;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _frameDecoded.wait(lock, [&]{ return _stopped || !_decodedFrames.empty() || _decodingDone; });
+      if(_stopped || _decodedFrames.empty())
+        return;
+      frame = std::move(_decodedFrames.front());
+      _decodedFrames.pop_front();
+    }
+
+    try
+    {
+      const auto extractionStart = std::chrono::steady_clock::now();
+      extractRegions(describers, *frame);
+      frame->extractionLatency = elapsedMs(extractionStart);
+    }
+    catch(...)
+    {
+      stop(std::current_exception());
+      return;
+    }
+    // the image is not needed anymore
+    frame->imageGrey.reset();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const std::size_t frameId = frame->frameId;
+    _extractedFrames[frameId] = std::move(frame);
+    _frameExtracted.notify_all();
+  }
+}
+
+void LocalizationPipeline::extractRegions(Describers& describers, PipelineFrame& frame)
+{
+  // same extraction as VoctreeLocalizer::localize
+  image::Image<unsigned char> imageGrayUChar; // uchar image copy for uchar image describer
+
+  for(const std::unique_ptr<feature::ImageDescriber>& imageDescriber : describers)
+  {
+    const feature::EImageDescriberType descType = imageDescriber->getDescriberType();
+    std::unique_ptr<feature::Regions>& regions = frame.regions[descType];
+
+    imageDescriber->allocate(regions);
+
+    std::unique_lock<std::mutex> gpuLock(_gpuMutex, std::defer_lock);
+    if(imageDescriber->useCuda())
+      gpuLock.lock();
+
+    if(imageDescriber->useFloatImage())
+    {
+      imageDescriber->describe(*frame.imageGrey, regions, nullptr);
+    }
+    else
+    {
+      // image descriptor can't use float image
+      if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
+        imageGrayUChar = (frame.imageGrey->GetMat() * 255.f).cast<unsigned char>();
+      imageDescriber->describe(imageGrayUChar, regions, nullptr);
+    }
+  }
+}
+
+void LocalizationPipeline::localizeFrames(const ResultCallback& resultCallback)
+{
+  for(std::size_t frameId = 0; ; ++frameId)
+  {
+    std::unique_ptr<PipelineFrame> frame;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _frameExtracted.wait(lock, [&]{
+        return _stopped ||
+               _extractedFrames.count(frameId) ||
+               (_decodingDone && frameId >= _nbDecodedFrames);
+      });
+      if(_stopped || !_extractedFrames.count(frameId))
+        return;
+      auto it = _extractedFrames.find(frameId);
+      frame = std::move(it->second);
+      _extractedFrames.erase(it);
+    }
+
+    try
+    {
+      const auto localizationStart = std::chrono::steady_clock::now();
+      frame->isLocalized = _localizer.localize(frame->regions,
+                                               frame->imageSize,
+                                               &_param,
+                                               frame->hasIntrinsics,
+                                               frame->intrinsics,
+                                               frame->localizationResult,
+                                               frame->imagePath);
+      frame->localizationLatency = elapsedMs(localizationStart);
+      frame->poseLatency = elapsedMs(frame->readTime);
+
+      _decodeLatencies.add(frame->decodeLatency);
+      _extractionLatencies.add(frame->extractionLatency);
+      _localizationLatencies.add(frame->localizationLatency);
+      _poseLatencies.add(frame->poseLatency);
+
+      resultCallback(*frame);
+    }
+    catch(...)
+    {
+      stop(std::current_exception());
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_nbFramesInFlight;
+    _frameDone.notify_all();
+  }
+}
+
+void LocalizationPipeline::stop(std::exception_ptr exception)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!_exception)
+    _exception = exception;
+  _stopped = true;
+  _frameDecoded.notify_all();
+  _frameExtracted.notify_all();
+  _frameDone.notify_all();
+}
+
+} // namespace localization
+} // namespace aliceVision
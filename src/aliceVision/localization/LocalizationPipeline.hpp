@@ -0,0 +1,223 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/localization/ILocalizer.hpp>
+#include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/camera/PinholeRadial.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Histogram of latencies, with 1 ms bins up to maxLatency ms
+ */
+class LatencyHistogram
+{
+public:
+  explicit LatencyHistogram(std::size_t maxLatency = 1000)
+    : _bins(maxLatency + 1, 0)
+  {}
+
+  /// Add a latency (in ms)
+  void add(double latency);
+
+  std::size_t count() const
+  {
+    return _count;
+  }
+
+  double mean() const
+  {
+    return (_count > 0) ? _sum / _count : 0.0;
+  }
+
+  double max() const
+  {
+    return _max;
+  }
+
+  /**
+   * @brief Get the latency under which a ratio of the measures are (upper bound of its bin)
+   * @param[in] ratio In [0, 1], 0.5 for the median
+   */
+  double percentile(double ratio) const;
+
+private:
+  /// the last bin counts the latencies bigger than the max latency
+  std::vector<std::size_t> _bins;
+  std::size_t _count = 0;
+  double _sum = 0.0;
+  double _max = 0.0;
+};
+
+std::ostream& operator<<(std::ostream& os, const LatencyHistogram& histogram);
+
+/**
+ * @brief A frame of the localization pipeline
+ */
+struct PipelineFrame
+{
+  /// the index of the frame in the feed
+  std::size_t frameId = 0;
+  std::string imagePath;
+  bool hasIntrinsics = false;
+  camera::PinholeRadialK3 intrinsics;
+  std::shared_ptr<image::Image<float>> imageGrey;
+  std::pair<std::size_t, std::size_t> imageSize;
+  feature::MapRegionsPerDesc regions;
+  LocalizationResult localizationResult;
+  bool isLocalized = false;
+
+  /// the frame is read
+  std::chrono::steady_clock::time_point readTime;
+  /// latencies of the stages (in ms)
+  double decodeLatency = 0.0;
+  double extractionLatency = 0.0;
+  double localizationLatency = 0.0;
+  /// from the beginning of the decoding to the pose
+  double poseLatency = 0.0;
+};
+
+/**
+ * @brief Pipelined localization of a feed of frames.
+ *
+ * The stages run concurrently on different frames:
+ *  - a decoding thread reads the frames from the feed,
+ *  - the feature extraction workers compute the regions of several frames on a thread pool,
+ *    the image describers using the GPU are shared by the workers one frame at a time,
+ *  - the localization thread localizes the frames (voctree query, matching and resection)
+ *    in the frame order, as the localizer keeps the previous frames for the matching.
+ *
+ * The frames waiting for a stage are bounded, so the latency of a frame stays bounded
+ * when the feed is faster than the pipeline. The results are given in the frame order.
+ */
+class LocalizationPipeline
+{
+public:
+  /**
+   * @brief Read the next frame of the feed.
+   * @param[out] imageGrey The frame
+   * @param[out] intrinsics The frame intrinsics, if hasIntrinsics
+   * @param[out] imagePath The frame path (or name)
+   * @param[out] hasIntrinsics The intrinsics of the frame are known
+   * @return false at the end of the feed
+   */
+  using FrameReader = std::function<bool(image::Image<float>& imageGrey,
+                                         camera::PinholeRadialK3& intrinsics,
+                                         std::string& imagePath,
+                                         bool& hasIntrinsics)>;
+
+  /// Called for each localized frame, in the frame order
+  using ResultCallback = std::function<void(const PipelineFrame& frame)>;
+
+  /**
+   * @param[in] localizer The localizer, used by the localization thread only
+   * @param[in] param The parameters of the localization
+   * @param[in] describerTypes The image describers to extract
+   * @param[in] nbExtractionThreads The number of feature extraction workers (0 for the number of cores)
+   */
+  LocalizationPipeline(ILocalizer& localizer,
+                       const LocalizerParameters& param,
+                       const std::vector<feature::EImageDescriberType>& describerTypes,
+                       std::size_t nbExtractionThreads = 0);
+
+  /**
+   * @brief Localize all the frames of the feed.
+   * @param[in] frameReader Read the frames, called by the decoding thread only
+   * @param[in] resultCallback Called for each frame in order, by the localization thread
+   * @throw the first error of a stage
+   */
+  void run(const FrameReader& frameReader, const ResultCallback& resultCallback);
+
+  const LatencyHistogram& getDecodeLatencies() const
+  {
+    return _decodeLatencies;
+  }
+
+  const LatencyHistogram& getExtractionLatencies() const
+  {
+    return _extractionLatencies;
+  }
+
+  const LatencyHistogram& getLocalizationLatencies() const
+  {
+    return _localizationLatencies;
+  }
+
+  const LatencyHistogram& getPoseLatencies() const
+  {
+    return _poseLatencies;
+  }
+
+private:
+  using Describers = std::vector<std::unique_ptr<feature::ImageDescriber>>;
+
+  void decodeFrames(const FrameReader& frameReader);
+  void runExtractionWorker(Describers& describers);
+  void localizeFrames(const ResultCallback& resultCallback);
+
+  /// Extract the regions of the frame with the describers of a worker
+  void extractRegions(Describers& describers, PipelineFrame& frame);
+
+  /**
+   * @brief Stop all the stages on the first error.
+   * @param[in] exception The error rethrown by run()
+   */
+  void stop(std::exception_ptr exception);
+
+  ILocalizer& _localizer;
+  const LocalizerParameters& _param;
+  std::vector<feature::EImageDescriberType> _describerTypes;
+  std::size_t _nbExtractionThreads;
+
+  std::mutex _mutex;
+  /// a frame is decoded
+  std::condition_variable _frameDecoded;
+  /// a frame is extracted
+  std::condition_variable _frameExtracted;
+  /// a frame is localized
+  std::condition_variable _frameDone;
+  /// the decoded frames, waiting for the extraction
+  std::deque<std::unique_ptr<PipelineFrame>> _decodedFrames;
+  /// the extracted frames, waiting for the localization in the frame order
+  std::map<std::size_t, std::unique_ptr<PipelineFrame>> _extractedFrames;
+  /// the number of frames decoded and not localized yet
+  std::size_t _nbFramesInFlight = 0;
+  std::size_t _maxFramesInFlight = 0;
+  std::size_t _nbDecodedFrames = 0;
+  bool _decodingDone = false;
+  bool _stopped = false;
+  std::exception_ptr _exception;
+
+  /// the image describers using the GPU are used by one worker at a time
+  std::mutex _gpuMutex;
+
+  LatencyHistogram _decodeLatencies;
+  LatencyHistogram _extractionLatencies;
+  LatencyHistogram _localizationLatencies;
+  LatencyHistogram _poseLatencies;
+};
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,165 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationPipeline.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE LocalizationPipeline
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+struct Parameters : public localization::LocalizerParameters
+{
+};
+
+/**
+ * @brief Localizer checking that the frames are localized one at a time in the frame order,
+ * the frames of width 0 are not localized
+ */
+class OrderedLocalizer : public localization::ILocalizer
+{
+public:
+  std::vector<std::string> localizedFrames;
+  bool isConcurrent = false;
+  bool isRunning = false;
+  int failingFrame = -1;
+
+  bool localize(const image::Image<float>& imageGrey,
+                const localization::LocalizerParameters* param,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3& queryIntrinsics,
+                localization::LocalizationResult& localizationResult,
+                const std::string& imagePath) override
+  {
+    return false;
+  }
+
+  bool localize(const feature::MapRegionsPerDesc& queryRegions,
+                const std::pair<std::size_t, std::size_t>& imageSize,
+                const localization::LocalizerParameters* param,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3& queryIntrinsics,
+                localization::LocalizationResult& localizationResult,
+                const std::string& imagePath) override
+  {
+    isConcurrent = isConcurrent || isRunning;
+    isRunning = true;
+    if(std::to_string(failingFrame) == imagePath)
+      throw std::runtime_error("localization error");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    localizedFrames.push_back(imagePath);
+    isRunning = false;
+    return imageSize.first > 0;
+  }
+
+  bool localizeRig(const std::vector<image::Image<float>>& vec_imageGrey,
+                   const localization::LocalizerParameters* param,
+                   std::vector<camera::PinholeRadialK3>& vec_queryIntrinsics,
+                   const std::vector<geometry::Pose3>& vec_subPoses,
+                   geometry::Pose3& rigPose,
+                   std::vector<localization::LocalizationResult>& vec_locResults) override
+  {
+    return false;
+  }
+
+  bool localizeRig(const std::vector<feature::MapRegionsPerDesc>& vec_queryRegions,
+                   const std::vector<std::pair<std::size_t, std::size_t>>& imageSize,
+                   const localization::LocalizerParameters* param,
+                   std::vector<camera::PinholeRadialK3>& vec_queryIntrinsics,
+                   const std::vector<geometry::Pose3>& vec_subPoses,
+                   geometry::Pose3& rigPose,
+                   std::vector<localization::LocalizationResult>& vec_locResults) override
+  {
+    return false;
+  }
+};
+
+/// Feed of nbFrames frames, named by their index, the frames multiple of 3 have a width of 0
+localization::LocalizationPipeline::FrameReader makeFeed(std::size_t nbFrames)
+{
+  std::shared_ptr<std::size_t> frameId = std::make_shared<std::size_t>(0);
+  return [=](image::Image<float>& imageGrey, camera::PinholeRadialK3& intrinsics, std::string& imagePath, bool& hasIntrinsics)
+  {
+    if(*frameId == nbFrames)
+      return false;
+    imageGrey = image::Image<float>((*frameId % 3 == 0) ? 0 : 8, 8);
+    imagePath = std::to_string(*frameId);
+    hasIntrinsics = false;
+    ++(*frameId);
+    return true;
+  };
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(LocalizationPipeline_latencyHistogram)
+{
+  localization::LatencyHistogram histogram(100);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 0.0);
+
+  for(int i = 0; i < 100; ++i)
+    histogram.add(i + 0.5);
+  histogram.add(250.0);
+
+  BOOST_CHECK_EQUAL(histogram.count(), 101);
+  BOOST_CHECK_EQUAL(histogram.max(), 250.0);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 51.0);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.9), 91.0);
+  BOOST_CHECK_EQUAL(histogram.percentile(1.0), 250.0);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationPipeline_frameOrder)
+{
+  const std::size_t nbFrames = 50;
+  OrderedLocalizer localizer;
+  Parameters param;
+
+  for(std::size_t nbThreads : {1, 4})
+  {
+    localizer.localizedFrames.clear();
+    localization::LocalizationPipeline pipeline(localizer, param, {}, nbThreads);
+
+    std::vector<std::size_t> resultFrames;
+    pipeline.run(makeFeed(nbFrames), [&](const localization::PipelineFrame& frame)
+    {
+      resultFrames.push_back(frame.frameId);
+      BOOST_CHECK_EQUAL(frame.imagePath, std::to_string(frame.frameId));
+      BOOST_CHECK_EQUAL(frame.isLocalized, frame.frameId % 3 != 0);
+      BOOST_CHECK_GE(frame.poseLatency, frame.localizationLatency);
+    });
+
+    BOOST_CHECK(!localizer.isConcurrent);
+    BOOST_REQUIRE_EQUAL(resultFrames.size(), nbFrames);
+    BOOST_REQUIRE_EQUAL(localizer.localizedFrames.size(), nbFrames);
+    for(std::size_t i = 0; i < nbFrames; ++i)
+    {
+      BOOST_CHECK_EQUAL(resultFrames[i], i);
+      BOOST_CHECK_EQUAL(localizer.localizedFrames[i], std::to_string(i));
+    }
+    BOOST_CHECK_EQUAL(pipeline.getPoseLatencies().count(), nbFrames);
+    BOOST_CHECK_GE(pipeline.getLocalizationLatencies().mean(), 1.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationPipeline_error)
+{
+  OrderedLocalizer localizer;
+  localizer.failingFrame = 10;
+  Parameters param;
+  localization::LocalizationPipeline pipeline(localizer, param, {}, 2);
+
+  std::size_t nbResults = 0;
+  BOOST_CHECK_THROW(pipeline.run(makeFeed(100), [&](const localization::PipelineFrame&) { ++nbResults; }), std::runtime_error);
+  BOOST_CHECK_EQUAL(nbResults, 10);
+}
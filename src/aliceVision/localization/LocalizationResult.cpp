@@ -6,18 +6,197 @@
 
 #include "LocalizationResult.hpp"
 #include <aliceVision/sfm/sfmDataIO_json.hpp>
+#include <aliceVision/system/Logger.hpp>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace localization {
 
 namespace bpt = boost::property_tree;
 
+namespace {
+
+/// binary file header: magic and format version
+const char binaryMagic[8] = {'A', 'V', 'L', 'O', 'C', 'R', 'E', 'S'};
+const std::uint32_t binaryVersion = 1;
+
+template <typename T>
+void writeBinary(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void readBinary(std::istream& stream, T& value)
+{
+  stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template <typename MatrixT>
+void writeBinaryMatrix(std::ostream& stream, const MatrixT& matrix)
+{
+  writeBinary(stream, static_cast<std::uint32_t>(matrix.rows()));
+  writeBinary(stream, static_cast<std::uint32_t>(matrix.cols()));
+  stream.write(reinterpret_cast<const char*>(matrix.data()), matrix.size() * sizeof(double));
+}
+
+template <typename MatrixT>
+void readBinaryMatrix(std::istream& stream, MatrixT& matrix)
+{
+  std::uint32_t rows = 0;
+  std::uint32_t cols = 0;
+  readBinary(stream, rows);
+  readBinary(stream, cols);
+  matrix.resize(rows, cols);
+  stream.read(reinterpret_cast<char*>(matrix.data()), matrix.size() * sizeof(double));
+}
+
+void writeBinaryRecord(std::ostream& stream, const LocalizationResult& lr)
+{
+  const sfm::ImageLocalizerMatchData& matchData = lr.getMatchData();
+
+  writeBinary(stream, static_cast<std::uint8_t>(lr.isValid()));
+  writeBinaryMatrix(stream, lr.getPose().rotation());
+  writeBinaryMatrix(stream, lr.getPose().center());
+
+  // intrinsics
+  {
+    const camera::PinholeRadialK3& intrinsics = lr.getIntrinsics();
+    const std::vector<double> params = intrinsics.getParams();
+    writeBinary(stream, static_cast<std::uint32_t>(intrinsics.w()));
+    writeBinary(stream, static_cast<std::uint32_t>(intrinsics.h()));
+    writeBinary(stream, static_cast<std::uint32_t>(params.size()));
+    stream.write(reinterpret_cast<const char*>(params.data()), params.size() * sizeof(double));
+  }
+
+  // match data
+  writeBinaryMatrix(stream, matchData.projection_matrix);
+  writeBinaryMatrix(stream, matchData.pt3D);
+  writeBinaryMatrix(stream, matchData.pt2D);
+  writeBinary(stream, matchData.error_max);
+  writeBinary(stream, static_cast<std::uint64_t>(matchData.max_iteration));
+
+  writeBinary(stream, static_cast<std::uint64_t>(matchData.vec_inliers.size()));
+  for(std::size_t inlier : matchData.vec_inliers)
+    writeBinary(stream, static_cast<std::uint64_t>(inlier));
+
+  writeBinary(stream, static_cast<std::uint64_t>(matchData.vec_descType.size()));
+  for(feature::EImageDescriberType descType : matchData.vec_descType)
+    writeBinary(stream, static_cast<std::int32_t>(descType));
+
+  // indMatch3D2D
+  writeBinary(stream, static_cast<std::uint64_t>(lr.getIndMatch3D2D().size()));
+  for(const IndMatch3D2D& indMatch : lr.getIndMatch3D2D())
+  {
+    writeBinary(stream, indMatch.landmarkId);
+    writeBinary(stream, static_cast<std::int32_t>(indMatch.descType));
+    writeBinary(stream, indMatch.featId);
+  }
+
+  // matchedImages
+  writeBinary(stream, static_cast<std::uint64_t>(lr.getMatchedImages().size()));
+  for(const voctree::DocMatch& docMatch : lr.getMatchedImages())
+  {
+    writeBinary(stream, docMatch.id);
+    writeBinary(stream, docMatch.score);
+  }
+}
+
+void readBinaryRecord(std::istream& stream, LocalizationResult& lr)
+{
+  sfm::ImageLocalizerMatchData matchData;
+  std::vector<IndMatch3D2D> indMatch3D2D;
+  geometry::Pose3 pose;
+  camera::PinholeRadialK3 intrinsics;
+  std::vector<voctree::DocMatch> matchedImages;
+
+  std::uint8_t isValid = 0;
+  readBinary(stream, isValid);
+  readBinaryMatrix(stream, pose.rotation());
+  readBinaryMatrix(stream, pose.center());
+
+  // intrinsics
+  {
+    std::uint32_t w = 0;
+    std::uint32_t h = 0;
+    std::uint32_t nbParams = 0;
+    readBinary(stream, w);
+    readBinary(stream, h);
+    readBinary(stream, nbParams);
+    std::vector<double> params(nbParams);
+    stream.read(reinterpret_cast<char*>(params.data()), params.size() * sizeof(double));
+    intrinsics = camera::PinholeRadialK3(w, h);
+    intrinsics.updateFromParams(params);
+  }
+
+  // match data
+  readBinaryMatrix(stream, matchData.projection_matrix);
+  readBinaryMatrix(stream, matchData.pt3D);
+  readBinaryMatrix(stream, matchData.pt2D);
+  readBinary(stream, matchData.error_max);
+  std::uint64_t maxIteration = 0;
+  readBinary(stream, maxIteration);
+  matchData.max_iteration = maxIteration;
+
+  std::uint64_t nbInliers = 0;
+  readBinary(stream, nbInliers);
+  matchData.vec_inliers.resize(nbInliers);
+  for(std::size_t& inlier : matchData.vec_inliers)
+  {
+    std::uint64_t index = 0;
+    readBinary(stream, index);
+    inlier = index;
+  }
+
+  std::uint64_t nbDescTypes = 0;
+  readBinary(stream, nbDescTypes);
+  matchData.vec_descType.resize(nbDescTypes);
+  for(feature::EImageDescriberType& descType : matchData.vec_descType)
+  {
+    std::int32_t type = 0;
+    readBinary(stream, type);
+    descType = static_cast<feature::EImageDescriberType>(type);
+  }
+
+  // indMatch3D2D
+  std::uint64_t nbIndMatches = 0;
+  readBinary(stream, nbIndMatches);
+  indMatch3D2D.resize(nbIndMatches);
+  for(IndMatch3D2D& indMatch : indMatch3D2D)
+  {
+    std::int32_t descType = 0;
+    readBinary(stream, indMatch.landmarkId);
+    readBinary(stream, descType);
+    readBinary(stream, indMatch.featId);
+    indMatch.descType = static_cast<feature::EImageDescriberType>(descType);
+  }
+
+  // matchedImages
+  std::uint64_t nbMatchedImages = 0;
+  readBinary(stream, nbMatchedImages);
+  matchedImages.resize(nbMatchedImages);
+  for(voctree::DocMatch& docMatch : matchedImages)
+  {
+    readBinary(stream, docMatch.id);
+    readBinary(stream, docMatch.score);
+  }
+
+  if(!stream)
+    throw std::runtime_error("Invalid localization result record.");
+
+  lr = LocalizationResult(matchData, indMatch3D2D, pose, intrinsics, matchedImages, isValid != 0);
+}
+
+} // namespace
+
 LocalizationResult::LocalizationResult() : _isValid(false) {}
 LocalizationResult::LocalizationResult(
         const sfm::ImageLocalizerMatchData& matchData,
@@ -48,12 +227,8 @@ const Mat LocalizationResult::retrieveUndistortedPt2D() const
   {
     return getPt2D();
   }
-  const std::size_t numPts = distorted.cols();
-  Mat pt2Dundistorted = Mat2X(2, numPts);
-  for(std::size_t iPoint = 0; iPoint < numPts; ++iPoint)
-  {
-    pt2Dundistorted.col(iPoint) = intrinsics.get_ud_pixel(distorted.col(iPoint));
-  }
+  Mat2X pt2Dundistorted;
+  intrinsics.get_ud_pixels(distorted, pt2Dundistorted);
   return pt2Dundistorted;
 }
 
@@ -334,6 +509,96 @@ void LocalizationResult::save(const std::vector<LocalizationResult>& localizatio
   bpt::write_json(filename, fileTree);
 }
 
+LocalizationResultWriter::LocalizationResultWriter(const std::string& filename)
+  : _file(filename, std::ios::binary | std::ios::trunc)
+{
+  if(!_file.is_open())
+    throw std::runtime_error("Unable to create the localization results file: " + filename);
+
+  _file.write(binaryMagic, sizeof(binaryMagic));
+  writeBinary(_file, binaryVersion);
+  _file.flush();
+}
+
+std::size_t LocalizationResultWriter::append(const LocalizationResult& localizationResult)
+{
+  std::ostringstream record;
+  writeBinaryRecord(record, localizationResult);
+  const std::string data = record.str();
+
+  // the record size first, to skip it without parsing it
+  writeBinary(_file, static_cast<std::uint64_t>(data.size()));
+  _file.write(data.data(), data.size());
+  _file.flush();
+
+  if(!_file)
+    throw std::runtime_error("Unable to write the localization result of the frame " + std::to_string(_nbFrames));
+
+  return _nbFrames++;
+}
+
+LocalizationResultReader::LocalizationResultReader(const std::string& filename)
+  : _file(filename, std::ios::binary)
+{
+  if(!_file.is_open())
+    throw std::runtime_error("Unable to open the localization results file: " + filename);
+
+  _file.seekg(0, std::ios::end);
+  const std::uint64_t fileSize = _file.tellg();
+  _file.seekg(0, std::ios::beg);
+
+  char magic[sizeof(binaryMagic)];
+  std::uint32_t version = 0;
+  _file.read(magic, sizeof(magic));
+  readBinary(_file, version);
+
+  if(!_file || std::memcmp(magic, binaryMagic, sizeof(binaryMagic)) != 0 || version != binaryVersion)
+    throw std::runtime_error("Invalid localization results file: " + filename);
+
+  // index the records, only their size is read
+  std::uint64_t offset = _file.tellg();
+  while(offset + sizeof(std::uint64_t) <= fileSize)
+  {
+    std::uint64_t recordSize = 0;
+    _file.seekg(offset);
+    readBinary(_file, recordSize);
+    if(!_file || offset + sizeof(std::uint64_t) + recordSize > fileSize)
+      break;
+    _recordOffsets.push_back(offset);
+    offset += sizeof(std::uint64_t) + recordSize;
+  }
+
+  if(offset != fileSize)
+    ALICEVISION_LOG_WARNING("The last localization result of " << filename << " is incomplete, it is ignored.");
+
+  _file.clear();
+}
+
+void LocalizationResultReader::read(std::size_t frameId, LocalizationResult& localizationResult)
+{
+  if(frameId >= _recordOffsets.size())
+    throw std::out_of_range("No localization result for the frame " + std::to_string(frameId));
+
+  std::uint64_t recordSize = 0;
+  _file.seekg(_recordOffsets[frameId]);
+  readBinary(_file, recordSize);
+
+  std::string data(recordSize, '\0');
+  _file.read(&data[0], recordSize);
+  if(!_file)
+    throw std::runtime_error("Unable to read the localization result of the frame " + std::to_string(frameId));
+
+  std::istringstream record(data);
+  readBinaryRecord(record, localizationResult);
+}
+
+void LocalizationResultReader::readAll(std::vector<LocalizationResult>& localizationResults)
+{
+  localizationResults.resize(_recordOffsets.size());
+  for(std::size_t frameId = 0; frameId < _recordOffsets.size(); ++frameId)
+    read(frameId, localizationResults[frameId]);
+}
+
 void updateRigPoses(std::vector<LocalizationResult>& vec_localizationResults,
                     const geometry::Pose3 &rigPose,
                     const std::vector<geometry::Pose3 > &vec_subPoses)
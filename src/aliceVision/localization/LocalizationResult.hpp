@@ -9,6 +9,8 @@
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
 #include <aliceVision/voctree/Database.hpp>
 
+#include <cstdint>
+#include <fstream>
 #include <vector>
 #include <utility>
 #include <string>
@@ -199,6 +201,73 @@ private:
   bool _isValid; 
 };
 
+/**
+ * @brief Write the localization results in a binary file, one record per frame,
+ * as they are produced.
+ *
+ * Each record is written and flushed on its own, so the results of the frames
+ * already localized are kept if the job is interrupted.
+ */
+class LocalizationResultWriter
+{
+public:
+  /**
+   * @brief Create the file, an existing file is overwritten
+   * @param[in] filename The binary file
+   */
+  explicit LocalizationResultWriter(const std::string& filename);
+
+  /**
+   * @brief Append the result of the next frame
+   * @param[in] localizationResult The frame localization
+   * @return the frame index in the file
+   */
+  std::size_t append(const LocalizationResult& localizationResult);
+
+  /// The number of frames written
+  std::size_t getNbFrames() const { return _nbFrames; }
+
+private:
+  std::ofstream _file;
+  std::size_t _nbFrames = 0;
+};
+
+/**
+ * @brief Read a binary file written by LocalizationResultWriter frame by frame.
+ *
+ * The record offsets are indexed when the file is opened, so any frame can be read
+ * without reading the previous ones. A record truncated by an interrupted job is ignored.
+ */
+class LocalizationResultReader
+{
+public:
+  /**
+   * @brief Open the file and index its records
+   * @param[in] filename The binary file
+   */
+  explicit LocalizationResultReader(const std::string& filename);
+
+  /// The number of complete frames in the file
+  std::size_t getNbFrames() const { return _recordOffsets.size(); }
+
+  /**
+   * @brief Read the result of a frame
+   * @param[in] frameId The frame index in the file
+   * @param[out] localizationResult The frame localization
+   */
+  void read(std::size_t frameId, LocalizationResult& localizationResult);
+
+  /**
+   * @brief Read the results of all the frames
+   * @param[out] localizationResults The localization of each frame
+   */
+  void readAll(std::vector<LocalizationResult>& localizationResults);
+
+private:
+  std::ifstream _file;
+  std::vector<std::uint64_t> _recordOffsets;
+};
+
 /**
  * @brief It recompute the pose of each camera in Localization results according
  * to the rigPose given as input. The camera in position 0 is supposed to be the 
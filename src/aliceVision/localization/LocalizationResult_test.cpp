@@ -11,6 +11,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cstdint>
+#include <fstream>
 #include <vector>
 #include <chrono>
 #include <random>
@@ -151,3 +153,66 @@ BOOST_AUTO_TEST_CASE(LocalizationResult_LoadSaveVector)
     fs::remove(filename);
   }
 }
+
+BOOST_AUTO_TEST_CASE(LocalizationResult_BinaryAppend)
+{
+  const double threshold = 1e-10;
+  const std::size_t numResults = 10;
+  const std::string filename = "test_localizationResults.bin";
+
+  std::vector<localization::LocalizationResult> resGT;
+  {
+    localization::LocalizationResultWriter writer(filename);
+    for(std::size_t i = 0; i < numResults; ++i)
+    {
+      resGT.push_back(generateRandomResult(i + 1));
+      BOOST_CHECK_EQUAL(writer.append(resGT.back()), i);
+    }
+  }
+
+  // simulate an interrupted job: the last record is incomplete
+  {
+    std::ofstream file(filename, std::ios::binary | std::ios::app);
+    const std::uint64_t recordSize = 1000;
+    file.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    file.write("abc", 3);
+  }
+
+  localization::LocalizationResultReader reader(filename);
+  BOOST_CHECK_EQUAL(reader.getNbFrames(), numResults);
+
+  // read the frames in any order
+  for(std::size_t i = numResults; i-- > 0;)
+  {
+    const localization::LocalizationResult& res = resGT[i];
+    localization::LocalizationResult check;
+    reader.read(i, check);
+
+    BOOST_CHECK(res.isValid() == check.isValid());
+    EXPECT_MATRIX_NEAR(res.getPose().rotation(), check.getPose().rotation(), threshold);
+    EXPECT_MATRIX_NEAR(res.getPose().center(), check.getPose().center(), threshold);
+    BOOST_CHECK(res.getIntrinsics().getParams() == check.getIntrinsics().getParams());
+    BOOST_CHECK(res.getInliers() == check.getInliers());
+    EXPECT_MATRIX_NEAR(res.getPt3D(), check.getPt3D(), threshold);
+    EXPECT_MATRIX_NEAR(res.getPt2D(), check.getPt2D(), threshold);
+    EXPECT_MATRIX_NEAR(res.getProjection(), check.getProjection(), threshold);
+
+    BOOST_CHECK_EQUAL(res.getIndMatch3D2D().size(), check.getIndMatch3D2D().size());
+    for(std::size_t j = 0; j < res.getIndMatch3D2D().size(); ++j)
+    {
+      BOOST_CHECK_EQUAL(res.getIndMatch3D2D()[j].landmarkId, check.getIndMatch3D2D()[j].landmarkId);
+      BOOST_CHECK_EQUAL(res.getIndMatch3D2D()[j].featId, check.getIndMatch3D2D()[j].featId);
+      BOOST_CHECK(res.getIndMatch3D2D()[j].descType == check.getIndMatch3D2D()[j].descType);
+    }
+
+    BOOST_CHECK_EQUAL(res.getMatchedImages().size(), check.getMatchedImages().size());
+    for(std::size_t j = 0; j < res.getMatchedImages().size(); ++j)
+    {
+      BOOST_CHECK(res.getMatchedImages()[j] == check.getMatchedImages()[j]);
+    }
+  }
+
+  BOOST_CHECK_THROW(reader.read(numResults, resGT.front()), std::out_of_range);
+
+  fs::remove(filename);
+}
@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SequenceRefiner.hpp"
+#include <aliceVision/localization/optimization.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <exception>
+
+namespace aliceVision {
+namespace localization {
+
+SequenceRefiner::SequenceRefiner(std::size_t windowSize,
+                                 std::size_t nbLockedFrames,
+                                 std::size_t minPointVisibility)
+  : _windowSize(std::max<std::size_t>(windowSize, 1))
+  , _nbLockedFrames(nbLockedFrames)
+  , _minPointVisibility(minPointVisibility)
+{
+  _thread = std::thread(&SequenceRefiner::refineFrames, this);
+}
+
+SequenceRefiner::~SequenceRefiner()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+  }
+  _frameAdded.notify_all();
+  _thread.join();
+}
+
+void SequenceRefiner::addFrame(const LocalizationResult& localizationResult)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frames.push_back(localizationResult);
+    ++_nbFrames;
+  }
+  _frameAdded.notify_all();
+}
+
+void SequenceRefiner::getRefinedPoses(std::vector<std::pair<std::size_t, geometry::Pose3>>& out_refinedPoses)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  out_refinedPoses.clear();
+  out_refinedPoses.swap(_refinedPoses);
+}
+
+void SequenceRefiner::flush()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _framesRefined.wait(lock, [this]{ return _nbRefinedFrames == _nbFrames; });
+}
+
+std::size_t SequenceRefiner::getNbRefinements() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbRefinements;
+}
+
+void SequenceRefiner::refineFrames()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while(true)
+  {
+    _frameAdded.wait(lock, [this]{ return _stopped || _nbRefinedFrames < _nbFrames; });
+    if(_stopped)
+      return;
+
+    // the window and the locked frames before it
+    const std::size_t nbFrames = _nbFrames;
+    const std::size_t windowBegin = nbFrames - std::min(nbFrames, _windowSize);
+    const std::size_t begin = windowBegin - std::min(windowBegin, _nbLockedFrames);
+
+    // the older frames are not used anymore
+    while(_firstFrameId < begin)
+    {
+      _frames.pop_front();
+      ++_firstFrameId;
+    }
+    std::vector<LocalizationResult> frames(_frames.begin(), _frames.begin() + (nbFrames - begin));
+    lock.unlock();
+
+    const std::size_t nbLocked = windowBegin - begin;
+    std::size_t nbValidLocked = 0;
+    std::size_t nbValidWindow = 0;
+    for(std::size_t i = 0; i < frames.size(); ++i)
+    {
+      if(frames[i].isValid())
+        ++((i < nbLocked) ? nbValidLocked : nbValidWindow);
+    }
+
+    // the poses of the window and the 3D points are refined, the intrinsics of the frames are kept
+    bool refined = false;
+    if(nbValidWindow > 0 && nbValidLocked + nbValidWindow > 1)
+    {
+      try
+      {
+        refined = refineSequence(frames, false, false, false, true, true, "", _minPointVisibility, nbLocked);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_WARNING("Sequence refinement of the frames [" << windowBegin << ", " << nbFrames << ") failed: " << e.what());
+      }
+    }
+
+    lock.lock();
+    if(refined)
+    {
+      ++_nbRefinements;
+      for(std::size_t i = nbLocked; i < frames.size(); ++i)
+      {
+        if(!frames[i].isValid())
+          continue;
+        const std::size_t frameId = begin + i;
+        _frames[frameId - _firstFrameId].setPose(frames[i].getPose());
+        _refinedPoses.emplace_back(frameId, frames[i].getPose());
+      }
+    }
+    _nbRefinedFrames = nbFrames;
+    _framesRefined.notify_all();
+  }
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,89 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/geometry/Pose3.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Sliding window refinement of a sequence during the streaming localization.
+ *
+ * The frames are added as they are localized. A background thread refines the poses
+ * of the last frames of the sequence (the window) and the 3D points they share,
+ * with the poses of the frames just before the window kept constant: the older frames
+ * are not part of the problem anymore, so the refinement time does not grow with the
+ * length of the sequence. When several frames are added during a refinement, the next
+ * refinement includes all of them.
+ */
+class SequenceRefiner
+{
+public:
+  /**
+   * @param[in] windowSize The number of last frames refined
+   * @param[in] nbLockedFrames The number of frames before the window with a constant pose
+   * @param[in] minPointVisibility The min. number of frames of the window seeing a 3D point to use it
+   */
+  explicit SequenceRefiner(std::size_t windowSize,
+                           std::size_t nbLockedFrames = 2,
+                           std::size_t minPointVisibility = 2);
+
+  /// Wait for the running refinement
+  ~SequenceRefiner();
+
+  /**
+   * @brief Add the next frame of the sequence and wake up the refinement
+   * @param[in] localizationResult The frame localization, the invalid frames are not refined
+   */
+  void addFrame(const LocalizationResult& localizationResult);
+
+  /**
+   * @brief Get the poses refined since the last call
+   * @param[out] out_refinedPoses The frame index in the sequence and its refined pose
+   */
+  void getRefinedPoses(std::vector<std::pair<std::size_t, geometry::Pose3>>& out_refinedPoses);
+
+  /// Wait until all the added frames are refined
+  void flush();
+
+  /// The number of bundle adjustments done
+  std::size_t getNbRefinements() const;
+
+private:
+  void refineFrames();
+
+  std::size_t _windowSize;
+  std::size_t _nbLockedFrames;
+  std::size_t _minPointVisibility;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _frameAdded;
+  std::condition_variable _framesRefined;
+  /// the last frames of the sequence, the first one is the frame _firstFrameId
+  std::deque<LocalizationResult> _frames;
+  std::size_t _firstFrameId = 0;
+  std::size_t _nbFrames = 0;
+  std::size_t _nbRefinedFrames = 0;
+  std::size_t _nbRefinements = 0;
+  std::vector<std::pair<std::size_t, geometry::Pose3>> _refinedPoses;
+  bool _stopped = false;
+
+  std::thread _thread;
+};
+
+} // namespace localization
+} // namespace aliceVision
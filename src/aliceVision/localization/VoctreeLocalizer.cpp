@@ -7,6 +7,7 @@
 #include "VoctreeLocalizer.hpp"
 #include "rigResection.hpp"
 #include "optimization.hpp"
+#include "LandmarksDatabase.hpp"
 #include <aliceVision/config.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/sfm/pipeline/RelativePoseInfo.hpp>
@@ -29,10 +30,21 @@
 
 #include <algorithm>
 #include <chrono>
+#include <set>
 
 namespace aliceVision {
 namespace localization {
 
+namespace {
+
+/// Return the path of the voctree database of an exported landmarks database
+std::string getVoctreeDatabasePath(const std::string& folder)
+{
+  return (boost::filesystem::path(folder) / "voctree.database").string();
+}
+
+} // namespace
+
 std::ostream& operator<<( std::ostream& os, const voctree::Document &doc )	
 {
   os << "[ ";
@@ -121,7 +133,8 @@ VoctreeLocalizer::VoctreeLocalizer(const sfm::SfMData &sfmData,
                                    const std::string &descriptorsFolder,
                                    const std::string &vocTreeFilepath,
                                    const std::string &weightsFilepath,
-                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes)
+                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                                   const std::string &landmarksDatabaseFolder)
   : ILocalizer()
   , _frameBuffer(5)
 {
@@ -141,7 +154,7 @@ VoctreeLocalizer::VoctreeLocalizer(const sfm::SfMData &sfmData,
   // then we can store only those associated to 3D points
   //? can we use Feature_Provider to load the features and filter them later?
 
-  _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder);
+  _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder, landmarksDatabaseFolder);
 }
 
 bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
@@ -265,7 +278,8 @@ bool VoctreeLocalizer::loadReconstructionDescriptors(const sfm::SfMData & sfm_da
  */
 bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
                                     const std::string & weightsFilepath,
-                                    const std::string & featFolder)
+                                    const std::string & featFolder,
+                                    const std::string & landmarksDatabaseFolder)
 {
 
   bool withWeights = !weightsFilepath.empty();
@@ -278,6 +292,12 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
   ALICEVISION_LOG_DEBUG("tree loaded with " << _voctree->levels() << " levels and "
           << _voctree->splits() << " branching factors");
 
+  if(!landmarksDatabaseFolder.empty())
+  {
+    loadLandmarksDatabase(landmarksDatabaseFolder);
+    return true;
+  }
+
   ALICEVISION_LOG_DEBUG("Creating the database...");
   // Add each object (document) to the database
   _database = voctree::Database(_voctree->words());
@@ -382,9 +402,73 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
       ++my_progress_bar;
     }
   }
+
+  initLandmarksPerView();
   return true;
 }
 
+void VoctreeLocalizer::initLandmarksPerView()
+{
+  // the landmarks of each view, to group the covisible views
+  _landmarksPerView.clear();
+  for(const auto& mappingPerView : _reconstructedRegionsMappingPerView)
+  {
+    std::vector<IndexT>& landmarks = _landmarksPerView[mappingPerView.first];
+    for(const auto& mappingPerDesc : mappingPerView.second)
+      landmarks.insert(landmarks.end(), mappingPerDesc.second._associated3dPoint.begin(), mappingPerDesc.second._associated3dPoint.end());
+    std::sort(landmarks.begin(), landmarks.end());
+    landmarks.erase(std::unique(landmarks.begin(), landmarks.end()), landmarks.end());
+  }
+}
+
+void VoctreeLocalizer::exportLandmarksDatabase(const std::string & folder) const
+{
+  namespace bfs = boost::filesystem;
+  if(!bfs::exists(folder))
+    bfs::create_directories(folder);
+
+  for(const auto& imageDescriber : _imageDescribers)
+  {
+    const feature::EImageDescriberType descType = imageDescriber->getDescriberType();
+    saveLandmarksDatabase(getLandmarksDatabasePath(folder, descType), descType, _regionsPerView, _reconstructedRegionsMappingPerView);
+  }
+  _database.save(getVoctreeDatabasePath(folder));
+}
+
+void VoctreeLocalizer::loadLandmarksDatabase(const std::string & folder)
+{
+  ALICEVISION_LOG_DEBUG("Loading the landmarks database...");
+  system::Timer timer;
+
+  _database.load(getVoctreeDatabasePath(folder));
+  if(_database.numWords() != _voctree->words())
+    throw std::runtime_error("The voctree database of '" + folder + "' doesn't match the vocabulary tree.");
+
+  for(const auto& imageDescriber : _imageDescribers)
+  {
+    const feature::EImageDescriberType descType = imageDescriber->getDescriberType();
+    const LandmarksDatabaseReader reader(getLandmarksDatabasePath(folder, descType));
+
+    // the landmarks must be the ones of the reconstruction
+    const std::uint32_t* landmarkIds = reader.getLandmarkIds();
+    for(std::size_t i = 0; i < reader.getNbLandmarks(); ++i)
+    {
+      if(_sfm_data.structure.count(landmarkIds[i]) == 0)
+        throw std::runtime_error("The landmarks database of '" + folder + "' doesn't match the reconstruction.");
+    }
+
+    for(const IndexT viewId : reader.getViewIds())
+    {
+      std::unique_ptr<feature::Regions>& regions = _regionsPerView.getData()[viewId][descType];
+      imageDescriber->allocate(regions);
+      reader.load(viewId, *regions, _reconstructedRegionsMappingPerView[viewId][descType]);
+    }
+  }
+  initLandmarksPerView();
+
+  ALICEVISION_LOG_DEBUG("Landmarks database loaded in " << timer.elapsedMs() << " [ms]");
+}
+
 bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc &queryRegions,
                                                const std::pair<std::size_t, std::size_t> &queryImageSize,
                                                const Parameters &param,
@@ -670,6 +754,7 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                                  param._visualDebug + "/" + bfs::path(imagePath).stem().string() + ".associations.svg");
     }
     localizationResult = LocalizationResult(resectionData, associationIDs, pose, queryIntrinsics, matchedImages, bResection);
+    _hasLastPose = false;
     return localizationResult.isValid();
   }
   ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection SUCCEDED");
@@ -716,6 +801,11 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
 
   localizationResult = LocalizationResult(resectionData, associationIDs, pose, queryIntrinsics, matchedImages, refineStatus);
 
+  // keep the pose to restrict the candidate images of the next frame
+  _hasLastPose = localizationResult.isValid();
+  _lastPose = pose;
+  _lastIntrinsics = queryIntrinsics;
+
   {
     // just debugging this block can be safely removed or commented out
     ALICEVISION_LOG_DEBUG("R refined\n" << pose.rotation());
@@ -785,142 +875,149 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
 
   std::map< std::pair<IndexT, IndexT>, std::size_t > repeated;
   
-  // B. for each found similar image, try to find the correspondences between the 
-  // query image adn the similar image
-  // stop when param._maxResults successful matches have been found
-  std::size_t goodMatches = 0;
-  for(const voctree::DocMatch& matchedImage : out_matchedImages)
+  if(param._useCovisibilityMatching)
   {
-    // minimum number of points that allows a reliable 3D reconstruction
-    const size_t minNum3DPoints = 5;
-
-    const auto matchedViewId = matchedImage.id;
-    // the handler to the current view
-    const std::shared_ptr<sfm::View> matchedView = _sfm_data.views.at(matchedViewId);
-    // its associated reconstructed regions
-    const feature::MapRegionsPerDesc& matchedRegions = _regionsPerView.getRegionsPerDesc(matchedViewId);
-    
-    // safeguard: we should match the query image with an image that has at least
-    // some 3D points visible --> if this is not true it is likely that it is an
-    // image of the dataset that was not reconstructed
-    if(matchedRegions.getNbAllRegions() < minNum3DPoints)
+    getAssociationsFromCovisibleViews(matchers, out_matchedImages, imageSize, param, useInputIntrinsics, queryIntrinsics, out_occurences);
+  }
+  else
+  {
+    // B. for each found similar image, try to find the correspondences between the 
+    // query image adn the similar image
+    // stop when param._maxResults successful matches have been found
+    std::size_t goodMatches = 0;
+    for(const voctree::DocMatch& matchedImage : out_matchedImages)
     {
-      ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points");
-      continue;
-    }
-    ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
-    ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
+      // minimum number of points that allows a reliable 3D reconstruction
+      const size_t minNum3DPoints = 5;
+
+      const auto matchedViewId = matchedImage.id;
+      // the handler to the current view
+      const std::shared_ptr<sfm::View> matchedView = _sfm_data.views.at(matchedViewId);
+      // its associated reconstructed regions
+      const feature::MapRegionsPerDesc& matchedRegions = _regionsPerView.getRegionsPerDesc(matchedViewId);
     
-    // its associated intrinsics
-    // this is just ugly!
-    const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
-    if ( !isPinhole(matchedIntrinsicsBase->getType()) )
-    {
-      //@fixme maybe better to throw something here
-      ALICEVISION_CERR("Only Pinhole cameras are supported!");
-      return;
-    }
-    const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
-
-    matching::MatchesPerDescType featureMatches;
-    const bool matchWorked = robustMatching(matchers,
-                                      // pass the input intrinsic if they are valid, null otherwise
-                                      (useInputIntrinsics) ? &queryIntrinsics : nullptr,
-                                      matchedRegions,
-                                      matchedIntrinsics,
-                                      param._fDistRatio,
-                                      param._matchingError,
-                                      param._useRobustMatching,
-                                      param._useGuidedMatching,
-                                      imageSize,
-                                      std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
-                                      featureMatches,
-                                      param._matchingEstimator);
-    if (!matchWorked)
-    {
-//      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
-      continue;
-    }
-
-    ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
-    assert(featureMatches.getNbAllMatches() > 0);
-
-    // if debug is enable save the matches between the query image and the current matching image
-    // It saves the feature matches in a folder with the same name as the query
-    // image, if it does not exist it will create it. The final svg file will have
-    // a name like this: queryImage_matchedImage.svg placed in the following directory:
-    // param._visualDebug/queryImage/
-    if(!param._visualDebug.empty() && !imagePath.empty())
-    {
-      namespace bfs = boost::filesystem;
-      const sfm::View *mview = _sfm_data.getViews().at(matchedViewId).get();
-      // the current query image without extension
-      const auto queryImage = bfs::path(imagePath).stem();
-      // the matching image without extension
-      const auto matchedImage = bfs::path(mview->getImagePath()).stem();
-      // the full path of the matching image
-      const auto matchedPath = mview->getImagePath();
-
-      // the directory where to save the feature matches
-      const auto baseDir = bfs::path(param._visualDebug) / queryImage;
-      if((!bfs::exists(baseDir)))
+      // safeguard: we should match the query image with an image that has at least
+      // some 3D points visible --> if this is not true it is likely that it is an
+      // image of the dataset that was not reconstructed
+      if(matchedRegions.getNbAllRegions() < minNum3DPoints)
       {
-        ALICEVISION_LOG_DEBUG("created " << baseDir.string());
-        bfs::create_directories(baseDir);
+        ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points");
+        continue;
+      }
+      ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
+      ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
+    
+      // its associated intrinsics
+      // this is just ugly!
+      const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
+      if ( !isPinhole(matchedIntrinsicsBase->getType()) )
+      {
+        //@fixme maybe better to throw something here
+        ALICEVISION_CERR("Only Pinhole cameras are supported!");
+        return;
+      }
+      const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
+
+      matching::MatchesPerDescType featureMatches;
+      const bool matchWorked = robustMatching(matchers,
+                                        // pass the input intrinsic if they are valid, null otherwise
+                                        (useInputIntrinsics) ? &queryIntrinsics : nullptr,
+                                        matchedRegions,
+                                        matchedIntrinsics,
+                                        param._fDistRatio,
+                                        param._matchingError,
+                                        param._useRobustMatching,
+                                        param._useGuidedMatching,
+                                        imageSize,
+                                        std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
+                                        featureMatches,
+                                        param._matchingEstimator);
+      if (!matchWorked)
+      {
+  //      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
+        continue;
       }
-      
-      // damn you, boost, what does it take to make the operator "+"?
-      // the final filename for the output svg file as a composition of the query
-      // image and the matched image
-      auto outputName = baseDir / queryImage;
-      outputName += "_";
-      outputName += matchedImage;
-      outputName += ".svg";
-
-      feature::saveMatches2SVG(imagePath,
-                                imageSize,
-                                queryRegions,
-                                matchedPath,
-                                std::make_pair(mview->getWidth(), mview->getHeight()),
-                                _regionsPerView.getRegionsPerDesc(matchedViewId),
-                                featureMatches,
-                                outputName.string()); 
-    }
 
-    const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
+      ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
+      assert(featureMatches.getNbAllMatches() > 0);
 
-    // C. recover the 2D-3D associations from the matches 
-    // Each matched feature in the current similar image is associated to a 3D point
-    for(const auto& featureMatchesIt : featureMatches)
-    {
-      feature::EImageDescriberType descType = featureMatchesIt.first;
-      const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
-      for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
+      // if debug is enable save the matches between the query image and the current matching image
+      // It saves the feature matches in a folder with the same name as the query
+      // image, if it does not exist it will create it. The final svg file will have
+      // a name like this: queryImage_matchedImage.svg placed in the following directory:
+      // param._visualDebug/queryImage/
+      if(!param._visualDebug.empty() && !imagePath.empty())
       {
-        // the ID of the 3D point
-        const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
-        const IndexT pt2D_id = featureMatch._i;
-
-        const OccurenceKey key(pt3D_id, descType, pt2D_id);
-        if(out_occurences.count(key))
+        namespace bfs = boost::filesystem;
+        const sfm::View *mview = _sfm_data.getViews().at(matchedViewId).get();
+        // the current query image without extension
+        const auto queryImage = bfs::path(imagePath).stem();
+        // the matching image without extension
+        const auto matchedImage = bfs::path(mview->getImagePath()).stem();
+        // the full path of the matching image
+        const auto matchedPath = mview->getImagePath();
+
+        // the directory where to save the feature matches
+        const auto baseDir = bfs::path(param._visualDebug) / queryImage;
+        if((!bfs::exists(baseDir)))
         {
-          out_occurences[key]++;
+          ALICEVISION_LOG_DEBUG("created " << baseDir.string());
+          bfs::create_directories(baseDir);
         }
-        else
+      
+        // damn you, boost, what does it take to make the operator "+"?
+        // the final filename for the output svg file as a composition of the query
+        // image and the matched image
+        auto outputName = baseDir / queryImage;
+        outputName += "_";
+        outputName += matchedImage;
+        outputName += ".svg";
+
+        feature::saveMatches2SVG(imagePath,
+                                  imageSize,
+                                  queryRegions,
+                                  matchedPath,
+                                  std::make_pair(mview->getWidth(), mview->getHeight()),
+                                  _regionsPerView.getRegionsPerDesc(matchedViewId),
+                                  featureMatches,
+                                  outputName.string()); 
+      }
+
+      const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
+
+      // C. recover the 2D-3D associations from the matches 
+      // Each matched feature in the current similar image is associated to a 3D point
+      for(const auto& featureMatchesIt : featureMatches)
+      {
+        feature::EImageDescriberType descType = featureMatchesIt.first;
+        const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
+        for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
         {
-          out_occurences[key] = 1;
+          // the ID of the 3D point
+          const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
+          const IndexT pt2D_id = featureMatch._i;
+
+          const OccurenceKey key(pt3D_id, descType, pt2D_id);
+          if(out_occurences.count(key))
+          {
+            out_occurences[key]++;
+          }
+          else
+          {
+            out_occurences[key] = 1;
+          }
         }
       }
-    }
-    ++goodMatches;
-    if((param._maxResults !=0) && (goodMatches == param._maxResults))
-    { 
-      // let's say we have enough features
-      ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << param._maxResults << " images");
-      break;
+      ++goodMatches;
+      if((param._maxResults !=0) && (goodMatches == param._maxResults))
+      { 
+        // let's say we have enough features
+        ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << param._maxResults << " images");
+        break;
+      }
     }
   }
-  
+
   if(param._nbFrameBufferMatching > 0)
   {
     ALICEVISION_LOG_DEBUG("[matching]\tUsing frameBuffer matching: matching with the past " 
@@ -975,6 +1072,216 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
   
 }
 
+void VoctreeLocalizer::getAssociationsFromCovisibleViews(matching::RegionsDatabaseMatcherPerDesc& matchers,
+                                                         const std::vector<voctree::DocMatch>& matchedImages,
+                                                         const std::pair<std::size_t, std::size_t>& imageSize,
+                                                         const Parameters& param,
+                                                         bool useInputIntrinsics,
+                                                         const camera::PinholeRadialK3& queryIntrinsics,
+                                                         OccurenceMap& out_occurences) const
+{
+  // minimum number of points that allows a reliable 3D reconstruction
+  const std::size_t minNum3DPoints = 5;
+
+  // the candidate images that have some 3D points visible
+  std::vector<IndexT> candidates;
+  candidates.reserve(matchedImages.size());
+  for(const voctree::DocMatch& matchedImage : matchedImages)
+  {
+    if(_regionsPerView.getRegionsPerDesc(matchedImage.id).getNbAllRegions() >= minNum3DPoints)
+      candidates.push_back(matchedImage.id);
+  }
+
+  // while tracking, keep the candidates seeing the frustum of the last frame
+  if(_hasLastPose)
+  {
+    std::vector<IndexT> candidatesInFrustum;
+    for(const IndexT viewId : candidates)
+    {
+      if(getNbLandmarksInLastFrustum(viewId) >= param._minCovisibleLandmarks)
+        candidatesInFrustum.push_back(viewId);
+    }
+    ALICEVISION_LOG_DEBUG("[matching]\t" << candidatesInFrustum.size() << "/" << candidates.size() << " candidate images in the frustum of the last frame");
+
+    // if none, the camera has moved too much since the last frame: keep all the candidates
+    if(!candidatesInFrustum.empty())
+      candidates.swap(candidatesInFrustum);
+  }
+
+  // group the candidates with the best candidate of a group they are covisible with
+  std::vector<std::vector<IndexT>> groups;
+  for(const IndexT viewId : candidates)
+  {
+    const auto groupIt = std::find_if(groups.begin(), groups.end(), [&](const std::vector<IndexT>& group)
+    {
+      return getNbCommonLandmarks(group.front(), viewId) >= param._minCovisibleLandmarks;
+    });
+    if(groupIt == groups.end())
+      groups.emplace_back(1, viewId);
+    else
+      groupIt->push_back(viewId);
+  }
+  ALICEVISION_LOG_DEBUG("[matching]\t" << candidates.size() << " candidate images in " << groups.size() << " covisibility groups");
+
+  // match each group once, stop when param._maxResults images have been successfully matched
+  std::size_t goodMatches = 0;
+  for(const std::vector<IndexT>& group : groups)
+  {
+    const std::shared_ptr<sfm::View> matchedView = _sfm_data.views.at(group.front());
+    matching::MatchesPerDescType featureMatches;
+    feature::MapRegionsPerDesc mergedRegions;
+    ReconstructedRegionsMappingPerDesc mergedRegionsMapping;
+    const ReconstructedRegionsMappingPerDesc* matchedRegionsMapping = nullptr;
+    bool matchWorked = false;
+
+    if(group.size() == 1)
+    {
+      // same matching as the independent candidates
+      matchWorked = robustMatching(matchers,
+                                   // pass the input intrinsic if they are valid, null otherwise
+                                   (useInputIntrinsics) ? &queryIntrinsics : nullptr,
+                                   _regionsPerView.getRegionsPerDesc(group.front()),
+                                   _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get(),
+                                   param._fDistRatio,
+                                   param._matchingError,
+                                   param._useRobustMatching,
+                                   param._useGuidedMatching,
+                                   imageSize,
+                                   std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
+                                   featureMatches,
+                                   param._matchingEstimator);
+      matchedRegionsMapping = &_reconstructedRegionsMappingPerView.at(group.front());
+    }
+    else
+    {
+      createMergedRegions(group, mergedRegions, mergedRegionsMapping);
+      ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << group.size() << " covisible images ("
+                            << mergedRegions.getNbAllRegions() << " landmarks)");
+
+      // the merged regions have no epipolar geometry with the query image,
+      // the wrong associations are removed by the robust resection
+      matchWorked = robustMatching(matchers,
+                                   nullptr,
+                                   mergedRegions,
+                                   nullptr,
+                                   param._fDistRatio,
+                                   param._matchingError,
+                                   false /*useGeometricFiltering*/,
+                                   false /*useGuidedMatching*/,
+                                   imageSize,
+                                   std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
+                                   featureMatches,
+                                   param._matchingEstimator);
+      matchedRegionsMapping = &mergedRegionsMapping;
+    }
+
+    if(!matchWorked)
+      continue;
+
+    ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " matches with " << group.size() << " covisible images");
+
+    // recover the 2D-3D associations from the matches
+    for(const auto& featureMatchesIt : featureMatches)
+    {
+      const feature::EImageDescriberType descType = featureMatchesIt.first;
+      const auto& matchedRegionsMappingType = matchedRegionsMapping->at(descType);
+      for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
+      {
+        const OccurenceKey key(matchedRegionsMappingType._associated3dPoint[featureMatch._j], descType, featureMatch._i);
+        ++out_occurences[key];
+      }
+    }
+
+    goodMatches += group.size();
+    if((param._maxResults != 0) && (goodMatches >= param._maxResults))
+    {
+      ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << goodMatches << " images");
+      break;
+    }
+  }
+}
+
+void VoctreeLocalizer::createMergedRegions(const std::vector<IndexT>& viewIds,
+                                           feature::MapRegionsPerDesc& out_regions,
+                                           ReconstructedRegionsMappingPerDesc& out_mapping) const
+{
+  std::map<feature::EImageDescriberType, std::set<IndexT>> mergedLandmarks;
+
+  for(const IndexT viewId : viewIds)
+  {
+    const ReconstructedRegionsMappingPerDesc& regionsMapping = _reconstructedRegionsMappingPerView.at(viewId);
+
+    for(const auto& regionsIt : _regionsPerView.getRegionsPerDesc(viewId))
+    {
+      const feature::EImageDescriberType descType = regionsIt.first;
+      const feature::Regions& regions = *regionsIt.second;
+      const std::vector<IndexT>& associated3dPoint = regionsMapping.at(descType)._associated3dPoint;
+
+      std::unique_ptr<feature::Regions>& mergedRegions = out_regions[descType];
+      if(!mergedRegions)
+        mergedRegions.reset(regions.EmptyClone());
+      std::vector<IndexT>& mergedAssociated3dPoint = out_mapping[descType]._associated3dPoint;
+      std::set<IndexT>& landmarks = mergedLandmarks[descType];
+
+      for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+      {
+        // keep one descriptor per landmark
+        if(!landmarks.insert(associated3dPoint[i]).second)
+          continue;
+        regions.CopyRegion(i, mergedRegions.get());
+        mergedAssociated3dPoint.push_back(associated3dPoint[i]);
+      }
+    }
+  }
+}
+
+std::size_t VoctreeLocalizer::getNbCommonLandmarks(IndexT viewIdA, IndexT viewIdB) const
+{
+  const auto itA = _landmarksPerView.find(viewIdA);
+  const auto itB = _landmarksPerView.find(viewIdB);
+  if(itA == _landmarksPerView.end() || itB == _landmarksPerView.end())
+    return 0;
+
+  // the landmarks are sorted
+  std::size_t nbCommonLandmarks = 0;
+  auto a = itA->second.begin();
+  auto b = itB->second.begin();
+  while(a != itA->second.end() && b != itB->second.end())
+  {
+    if(*a < *b)
+      ++a;
+    else if(*b < *a)
+      ++b;
+    else
+    {
+      ++nbCommonLandmarks;
+      ++a;
+      ++b;
+    }
+  }
+  return nbCommonLandmarks;
+}
+
+std::size_t VoctreeLocalizer::getNbLandmarksInLastFrustum(IndexT viewId) const
+{
+  const auto it = _landmarksPerView.find(viewId);
+  if(!_hasLastPose || it == _landmarksPerView.end())
+    return 0;
+
+  const sfm::Landmarks& landmarks = _sfm_data.getLandmarks();
+  std::size_t nbLandmarks = 0;
+  for(const IndexT landmarkId : it->second)
+  {
+    const Vec3& X = landmarks.at(landmarkId).X;
+    if(_lastPose.depth(X) <= 0.0)
+      continue;
+    const Vec2 x = _lastIntrinsics.project(_lastPose, X, false);
+    if(x(0) >= 0.0 && x(1) >= 0.0 && x(0) < _lastIntrinsics.w() && x(1) < _lastIntrinsics.h())
+      ++nbLandmarks;
+  }
+  return nbLandmarks;
+}
+
 void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc & matchers,
                                                  const std::pair<std::size_t, std::size_t> & queryImageSize,
                                                  const Parameters &param,
@@ -1174,7 +1481,6 @@ bool VoctreeLocalizer::localizeRig(const std::vector<image::Image<float>> & vec_
     for(auto& imageDescriber: _imageDescribers)
     {
       ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image...");
-      imageDescriber->describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
 
       if(imageDescriber->useFloatImage())
       {
@@ -1269,10 +1575,11 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
   std::vector<Mat> vec_pts3D(numCams);
   std::vector<Mat> vec_pts2D(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for(std::size_t camID = 0; camID < numCams; ++camID)
+  // for each camera retrieve the associations in parallel,
+  // each camera has its own matchers and associations
+  std::size_t numAssociations = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:numAssociations)
+  for(int camID = 0; camID < static_cast<int>(numCams); ++camID)
   {
 
     // this map is used to collect the 2d-3d associations as we go through the images
@@ -1518,10 +1825,12 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   vec_localizationResults.resize(numCams);
     
   // this is basic, just localize each camera alone
-  //@todo parallelize?
+  // the cameras are localized one after the other, as localize() updates the frame buffer
   std::vector<bool> isLocalized(numCams, false);
   for(size_t i = 0; i < numCams; ++i)
   {
+    // the last pose is the one of another camera of the rig
+    _hasLastPose = false;
     isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], parameters, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
     assert(isLocalized[i] == vec_localizationResults[i].isValid());
     if(!isLocalized[i])
@@ -55,6 +55,8 @@ public:
       , _ccTagUseCuda(true)
       , _matchingError(std::numeric_limits<double>::infinity())
       , _nbFrameBufferMatching(10)
+      , _useCovisibilityMatching(false)
+      , _minCovisibleLandmarks(30)
     {}
     
     /// Enable/disable guided matching when matching images
@@ -75,6 +77,12 @@ public:
     double _matchingError;
     /// maximum capacity of the frame buffer
     std::size_t _nbFrameBufferMatching;
+    /// for algorithm AllResults, match the query once against the merged landmarks of the
+    /// covisible matching images instead of each matching image independently
+    bool _useCovisibilityMatching;
+    /// minimum number of common landmarks for two matching images to be merged, and
+    /// minimum number of landmarks of a matching image in the frustum of the previous frame
+    std::size_t _minCovisibleLandmarks;
   };
   
 public:
@@ -92,6 +100,9 @@ public:
    * when all the documents are added.
    * @param[in] matchingDescTypes List of descriptor types to use for feature matching.
    * @param[in] voctreeDescType Descriptor type used for image matching with voctree.
+   * @param[in] landmarksDatabaseFolder Optional path to a landmarks database exported
+   * with exportLandmarksDatabase(), if provided the reconstructed regions and the voctree
+   * database are loaded from it instead of the features of the views.
    *
    * It enable the use of combined SIFT and CCTAG features.
    */
@@ -99,8 +110,17 @@ public:
                    const std::string &descriptorsFolder,
                    const std::string &vocTreeFilepath,
                    const std::string &weightsFilepath,
-                   const std::vector<feature::EImageDescriberType>& matchingDescTypes
+                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                   const std::string &landmarksDatabaseFolder = std::string()
                   );
+
+  /**
+   * @brief Export the reconstructed regions (one representative descriptor per landmark)
+   * and the voctree database, to initialize the localizer faster.
+   * @see saveLandmarksDatabase
+   * @param[in] folder The output folder
+   */
+  void exportLandmarksDatabase(const std::string &folder) const;
   
   void setCudaPipe( int i ) override
   {
@@ -275,11 +295,25 @@ private:
    * when all the documents are added.
    * @param[in] feat_directory The path to the directory containing the features 
    * of the scene (.desc and .feat files).
+   * @param[in] landmarksDatabaseFolder Optional path to an exported landmarks database
    * @return true if everything went ok
    */
   bool initDatabase(const std::string & vocTreeFilepath,
                     const std::string & weightsFilepath,
-                    const std::string & featFolder);
+                    const std::string & featFolder,
+                    const std::string & landmarksDatabaseFolder);
+
+  /**
+   * @brief Load the reconstructed regions and the voctree database from an exported
+   * landmarks database.
+   * @param[in] folder The landmarks database folder
+   */
+  void loadLandmarksDatabase(const std::string & folder);
+
+  /**
+   * @brief Initialize the landmarks of each view from the reconstructed regions.
+   */
+  void initLandmarksPerView();
 
   /**
    * @brief robustMatching
@@ -311,6 +345,51 @@ private:
                       matching::MatchesPerDescType & out_featureMatches,
                       robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC) const;
   
+  /**
+   * @brief Match the query against the candidate images grouped by covisibility:
+   * the candidate images sharing landmarks are merged in one set of regions with
+   * one descriptor per landmark, and each group is matched once with the query matchers.
+   * While tracking, the candidates are first restricted to the images seeing the
+   * frustum of the last localized frame.
+   *
+   * @param[in] matchers The matchers of the query regions
+   * @param[in] matchedImages The candidate images, sorted by decreasing score
+   * @param[in] imageSize The size of the query image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in] queryIntrinsics The intrinsics of the query image
+   * @param[out] out_occurences The 2D-3D associations found
+   */
+  void getAssociationsFromCovisibleViews(matching::RegionsDatabaseMatcherPerDesc& matchers,
+                                         const std::vector<voctree::DocMatch>& matchedImages,
+                                         const std::pair<std::size_t, std::size_t>& imageSize,
+                                         const Parameters& param,
+                                         bool useInputIntrinsics,
+                                         const camera::PinholeRadialK3& queryIntrinsics,
+                                         OccurenceMap& out_occurences) const;
+
+  /**
+   * @brief Merge the reconstructed regions of several views, keeping the first
+   * descriptor of each landmark.
+   * @param[in] viewIds The views to merge
+   * @param[out] out_regions The merged regions per describer type
+   * @param[out] out_mapping The landmark of each merged region
+   */
+  void createMergedRegions(const std::vector<IndexT>& viewIds,
+                           feature::MapRegionsPerDesc& out_regions,
+                           ReconstructedRegionsMappingPerDesc& out_mapping) const;
+
+  /**
+   * @brief Get the number of landmarks observed by both views.
+   */
+  std::size_t getNbCommonLandmarks(IndexT viewIdA, IndexT viewIdB) const;
+
+  /**
+   * @brief Get the number of landmarks of a view projected in the image of the last
+   * localized frame.
+   */
+  std::size_t getNbLandmarksInLastFrustum(IndexT viewId) const;
+
   void getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc& matchers,
                                  const std::pair<std::size_t, std::size_t> & imageSize,
                                  const Parameters &param,
@@ -334,6 +413,8 @@ public:
   /// associated 3D point
   feature::RegionsPerView _regionsPerView;
   ReconstructedRegionsMappingPerView _reconstructedRegionsMappingPerView;
+  /// for each view index, the sorted ids of its reconstructed landmarks
+  std::map<IndexT, std::vector<IndexT>> _landmarksPerView;
   
   /// the feature extractor
   std::vector<std::unique_ptr<feature::ImageDescriber>> _imageDescribers;
@@ -354,6 +435,11 @@ public:
   /// Last frames buffer
   BoundedBuffer<FrameData> _frameBuffer;
 
+  /// the pose of the last frame, if it has been localized
+  bool _hasLastPose = false;
+  geometry::Pose3 _lastPose;
+  camera::PinholeRadialK3 _lastIntrinsics;
+
   matching::EMatcherType _matcherType = matching::ANN_L2;
 };
 
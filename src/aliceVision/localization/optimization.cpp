@@ -30,7 +30,8 @@ bool refineSequence(std::vector<LocalizationResult> & vec_localizationResult,
                     bool b_refine_pose /*= true*/,
                     bool b_refine_structure /*= false*/,
                     const std::string & outputFilename /*= ""*/,
-                    std::size_t minPointVisibility /*=0*/)
+                    std::size_t minPointVisibility /*=0*/,
+                    std::size_t nbLockedResults /*=0*/)
 {
   
   const std::size_t numViews = vec_localizationResult.size();
@@ -115,7 +116,7 @@ bool refineSequence(std::vector<LocalizationResult> & vec_localizationResult,
     std::shared_ptr<sfm::View> view = std::make_shared<sfm::View>("",viewID, intrinsicID, viewID);
     tinyScene.views.insert( std::make_pair(viewID, view));
     // pose
-    tinyScene.setPose(*view, sfm::CameraPose(currResult.getPose()));
+    tinyScene.setPose(*view, sfm::CameraPose(currResult.getPose(), viewID < nbLockedResults));
 
     
     if(!allTheSameIntrinsics)
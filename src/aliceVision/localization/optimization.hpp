@@ -38,6 +38,8 @@ namespace localization{
  * @param[in] minPointVisibility if > 0 it allows to use only the 3D points that 
  * are seen in at least \p minPointVisibility views/frames, all the other 
  * points (and associated 2D features) will be discarded.
+ * @param[in] nbLockedResults The poses of the first \p nbLockedResults results
+ * are kept constant, to anchor the refinement of a part of a sequence.
  * @return true if the bundle adjustment has success.
  */
 bool refineSequence(std::vector<LocalizationResult> & vec_localizationResult,
@@ -47,7 +49,8 @@ bool refineSequence(std::vector<LocalizationResult> & vec_localizationResult,
                     bool b_refine_pose = true,
                     bool b_refine_structure = false,
                     const std::string & outputFilename = "",
-                    std::size_t minPointVisibility = 0);
+                    std::size_t minPointVisibility = 0,
+                    std::size_t nbLockedResults = 0);
 
 /**
  * @brief refine the pose of a camera rig by minimizing the reprojection error in
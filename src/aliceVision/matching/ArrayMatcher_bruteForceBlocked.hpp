@@ -0,0 +1,204 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/numeric/numeric.hpp"
+#include "aliceVision/matching/ArrayMatcher.hpp"
+#include "aliceVision/matching/metric.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Brute force L2 matcher computing the distance matrix tile by tile.
+ *
+ * The squared distances are computed as |a|^2 + |b|^2 - 2 a.b with a matrix product
+ * (float, or double for double descriptors) on blocks of queries and database rows
+ * that fit in cache, followed by a streaming selection of the nearest candidates.
+ * The selected candidates are re-ranked with the exact Metric, so the returned
+ * distances (and the ratio test) are the same as with ArrayMatcher_bruteForce.
+ *
+ * @note For unsigned char descriptors up to 258 dimensions, all the float partial sums are
+ *       integers below 2^24, so the blocked distances are exact.
+ */
+template < typename Scalar = float, typename Metric = L2_Vectorized<Scalar> >
+class ArrayMatcher_bruteForceBlocked  : public ArrayMatcher<Scalar, Metric>
+{
+  public:
+  typedef typename Metric::ResultType DistanceType;
+
+  ArrayMatcher_bruteForceBlocked()   {}
+  virtual ~ArrayMatcher_bruteForceBlocked() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    if (nbRows < 1) {
+      _dataset = nullptr;
+      return false;
+    }
+    _dataset = dataset;
+    _nbRows = nbRows;
+    _dimension = dimension;
+    _database = Eigen::Map<const BaseMat>(dataset, nbRows, dimension).template cast<ComputeT>();
+    _databaseNorms = _database.rowwise().squaredNorm();
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour( const Scalar * query,
+                        int * indice, DistanceType * distance)
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices[0]._j;
+    *distance = distances[0];
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+    if (_dataset == nullptr)  {
+      return false;
+    }
+
+    if (NN > _nbRows || nbQuery < 1) {
+      return false;
+    }
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    // tile sizes: a distance tile of 128 x 512 floats (256KB) stays in L2 cache
+    const int queryBlockSize = 128;
+    const int databaseBlockSize = 512;
+
+    // keep a few more candidates than requested for the exact re-ranking
+    const int nbCandidates = std::min(static_cast<int>(NN) + 2, _nbRows);
+    const int nbQueryBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int queryBlock = 0; queryBlock < nbQueryBlocks; ++queryBlock)
+    {
+      const int queryBegin = queryBlock * queryBlockSize;
+      const int queryCount = std::min(queryBlockSize, nbQuery - queryBegin);
+
+      const ComputeMat queries = Eigen::Map<const BaseMat>(query + queryBegin * _dimension, queryCount, _dimension).template cast<ComputeT>();
+      const ComputeVec queryNorms = queries.rowwise().squaredNorm();
+
+      // sorted candidates (distance, database index) of each query of the block
+      std::vector<Candidate> candidates(queryCount * nbCandidates, Candidate(std::numeric_limits<ComputeT>::max(), -1));
+      ComputeMat dots;
+
+      for (int databaseBegin = 0; databaseBegin < _nbRows; databaseBegin += databaseBlockSize)
+      {
+        const int databaseCount = std::min(databaseBlockSize, _nbRows - databaseBegin);
+        dots.noalias() = queries * _database.middleRows(databaseBegin, databaseCount).transpose();
+
+        for (int q = 0; q < queryCount; ++q)
+        {
+          Candidate* queryCandidates = &candidates[q * nbCandidates];
+          for (int j = 0; j < databaseCount; ++j)
+          {
+            const ComputeT distance = queryNorms(q) + _databaseNorms(databaseBegin + j) - ComputeT(2) * dots(q, j);
+            if (distance >= queryCandidates[nbCandidates - 1].first)
+              continue;
+            // insertion in the sorted candidates
+            int k = nbCandidates - 1;
+            for (; k > 0 && queryCandidates[k - 1].first > distance; --k)
+              queryCandidates[k] = queryCandidates[k - 1];
+            queryCandidates[k] = Candidate(distance, databaseBegin + j);
+          }
+        }
+      }
+
+      // exact re-ranking of the candidates with the metric
+      Metric metric;
+      std::vector<std::pair<DistanceType, int> > exactCandidates(nbCandidates);
+      for (int q = 0; q < queryCount; ++q)
+      {
+        const int queryIndex = queryBegin + q;
+        const Scalar * queryPtr = query + queryIndex * _dimension;
+        const Candidate* queryCandidates = &candidates[q * nbCandidates];
+        for (int k = 0; k < nbCandidates; ++k)
+        {
+          const int index = queryCandidates[k].second;
+          exactCandidates[k] = std::make_pair(metric(queryPtr, _dataset + index * _dimension, _dimension), index);
+        }
+        std::sort(exactCandidates.begin(), exactCandidates.end());
+
+        for (int i = 0; i < NN; ++i)
+        {
+          (*pvec_distances)[queryIndex*NN+i] = exactCandidates[i].first;
+          (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, exactCandidates[i].second);
+        }
+      }
+    }
+    return true;
+  };
+
+private:
+  /// double descriptors are matched in double, others in float
+  typedef typename std::conditional<std::is_same<Scalar, double>::value, double, float>::type ComputeT;
+  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BaseMat;
+  typedef Eigen::Matrix<ComputeT, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ComputeMat;
+  typedef Eigen::Matrix<ComputeT, Eigen::Dynamic, 1> ComputeVec;
+  typedef std::pair<ComputeT, int> Candidate;
+
+  const Scalar* _dataset = nullptr;
+  int _nbRows = 0;
+  int _dimension = 0;
+  /// Database converted to the compute type
+  ComputeMat _database;
+  /// Squared norm of each database row
+  ComputeVec _databaseNorms;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -0,0 +1,456 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/matching/ArrayMatcher.hpp"
+#include "aliceVision/matching/metric.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Approximate nearest neighbor matcher on a Hierarchical Navigable Small World graph.
+ *
+ * Each database row is a node of a multi-layer proximity graph: a search descends greedily
+ * the sparse upper layers, then explores the dense layer 0 with a beam of efSearch candidates.
+ * The graph is built once in parallel and reused by all the queries of the database (see RegionsMatcher),
+ * the distances returned are exact distances of the Metric (squared L2 or Hamming).
+ *
+ *  Malkov, Y. A., Yashunin, D. A. (2016). "Efficient and robust approximate nearest neighbor
+ *  search using Hierarchical Navigable Small World graphs". arXiv:1603.09320
+ */
+template < typename Scalar = float, typename Metric = L2_Vectorized<Scalar> >
+class ArrayMatcher_hnsw : public ArrayMatcher<Scalar, Metric>
+{
+  public:
+  typedef typename Metric::ResultType DistanceType;
+
+  /**
+   * @param[in] M The number of neighbors of a node in the upper layers (2 * M in layer 0)
+   * @param[in] efConstruction The number of candidates explored to link a new node
+   * @param[in] efSearch The number of candidates explored by a query (at least the number of neighbors searched)
+   */
+  explicit ArrayMatcher_hnsw(int M = 16, int efConstruction = 128, int efSearch = 64)
+    : _M(std::max(2, M))
+    , _M0(2 * _M)
+    , _efConstruction(std::max(efConstruction, _M))
+    , _efSearch(efSearch)
+  {}
+
+  virtual ~ArrayMatcher_hnsw() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    if (nbRows < 1) {
+      _dataset = nullptr;
+      return false;
+    }
+    _dataset = dataset;
+    _nbRows = nbRows;
+    _dimension = dimension;
+
+    // random levels, with an exponentially decaying probability
+    const double levelMult = 1.0 / std::log(static_cast<double>(_M));
+    std::mt19937 generator(100);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    _levels.resize(nbRows);
+    _upperLinks.assign(nbRows, std::vector<int>());
+    for (int i = 0; i < nbRows; ++i)
+    {
+      const double u = std::max(distribution(generator), 1e-12);
+      _levels[i] = static_cast<int>(-std::log(u) * levelMult);
+      if (_levels[i] > 0)
+        _upperLinks[i].assign(_levels[i] * (_M + 1), 0);
+    }
+    _links0.assign(static_cast<std::size_t>(nbRows) * (_M0 + 1), 0);
+    _nodeMutexes.reset(new std::mutex[nbRows]);
+
+    _entryPoint = 0;
+    _maxLevel = _levels[0];
+
+    #pragma omp parallel
+    {
+      VisitedList visited(nbRows);
+      #pragma omp for schedule(dynamic, 64)
+      for (int i = 1; i < nbRows; ++i)
+        insert(i, visited);
+    }
+
+    _nodeMutexes.reset();
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour( const Scalar * query,
+                        int * indice, DistanceType * distance)
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices[0]._j;
+    *distance = distances[0];
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+    if (_dataset == nullptr)  {
+      return false;
+    }
+
+    if (NN > static_cast<std::size_t>(_nbRows) || nbQuery < 1) {
+      return false;
+    }
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    const int ef = std::max(_efSearch, static_cast<int>(NN));
+
+    #pragma omp parallel
+    {
+      VisitedList visited(_nbRows);
+      std::vector<Candidate> candidates;
+
+      #pragma omp for schedule(dynamic, 64)
+      for (int q = 0; q < nbQuery; ++q)
+      {
+        const Scalar * queryPtr = query + static_cast<std::size_t>(q) * _dimension;
+
+        int entry = _entryPoint;
+        for (int level = _maxLevel; level > 0; --level)
+          entry = searchClosest(queryPtr, entry, level, false);
+        searchLayer(queryPtr, entry, ef, 0, visited, false, candidates);
+
+        // a disconnected part of the graph may hide some neighbors
+        if (candidates.size() < NN)
+          searchExhaustive(queryPtr, NN, candidates);
+
+        for (std::size_t i = 0; i < NN; ++i)
+        {
+          (*pvec_distances)[q*NN+i] = candidates[i].first;
+          (*pvec_indices)[q*NN+i] = IndMatch(q, candidates[i].second);
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  /// (distance, node) ordered by distance then by node
+  typedef std::pair<DistanceType, int> Candidate;
+
+  /// Nodes visited by a search, reset in constant time
+  struct VisitedList
+  {
+    explicit VisitedList(int size) : marks(size, 0) {}
+
+    void reset()
+    {
+      if (++tag == 0)
+      {
+        std::fill(marks.begin(), marks.end(), 0);
+        tag = 1;
+      }
+    }
+
+    /// Return false if the node has already been visited
+    bool visit(int node)
+    {
+      if (marks[node] == tag)
+        return false;
+      marks[node] = tag;
+      return true;
+    }
+
+    std::vector<unsigned int> marks;
+    unsigned int tag = 0;
+  };
+
+  const Scalar* row(int node) const
+  {
+    return _dataset + static_cast<std::size_t>(node) * _dimension;
+  }
+
+  DistanceType distance(const Scalar * a, int node) const
+  {
+    return _metric(a, row(node), _dimension);
+  }
+
+  int maxNeighbors(int level) const
+  {
+    return (level == 0) ? _M0 : _M;
+  }
+
+  /// Neighbors of a node at a level: their number, then the nodes
+  int* links(int node, int level)
+  {
+    if (level == 0)
+      return &_links0[static_cast<std::size_t>(node) * (_M0 + 1)];
+    return &_upperLinks[node][(level - 1) * (_M + 1)];
+  }
+
+  const int* links(int node, int level) const
+  {
+    return const_cast<ArrayMatcher_hnsw*>(this)->links(node, level);
+  }
+
+  /// Copy the neighbors of a node, locked during the construction
+  void getNeighbors(int node, int level, bool lock, std::vector<int>& neighbors) const
+  {
+    std::unique_lock<std::mutex> nodeLock;
+    if (lock)
+      nodeLock = std::unique_lock<std::mutex>(_nodeMutexes[node]);
+    const int* nodeLinks = links(node, level);
+    neighbors.assign(nodeLinks + 1, nodeLinks + 1 + nodeLinks[0]);
+  }
+
+  /// Greedy search of the closest node of a layer
+  int searchClosest(const Scalar * point, int entry, int level, bool lock) const
+  {
+    DistanceType bestDistance = distance(point, entry);
+    std::vector<int> neighbors;
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      getNeighbors(entry, level, lock, neighbors);
+      for (const int neighbor : neighbors)
+      {
+        const DistanceType d = distance(point, neighbor);
+        if (d < bestDistance)
+        {
+          bestDistance = d;
+          entry = neighbor;
+          changed = true;
+        }
+      }
+    }
+    return entry;
+  }
+
+  /// Beam search of the ef closest nodes of a layer, sorted by distance
+  void searchLayer(const Scalar * point, int entry, int ef, int level, VisitedList& visited, bool lock,
+                   std::vector<Candidate>& results) const
+  {
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > candidates;
+    std::priority_queue<Candidate> best;
+    std::vector<int> neighbors;
+
+    visited.reset();
+    visited.visit(entry);
+    const Candidate first(distance(point, entry), entry);
+    candidates.push(first);
+    best.push(first);
+
+    while (!candidates.empty())
+    {
+      const Candidate current = candidates.top();
+      if (current.first > best.top().first && static_cast<int>(best.size()) >= ef)
+        break;
+      candidates.pop();
+
+      getNeighbors(current.second, level, lock, neighbors);
+      for (const int neighbor : neighbors)
+      {
+        if (!visited.visit(neighbor))
+          continue;
+        const DistanceType d = distance(point, neighbor);
+        if (static_cast<int>(best.size()) < ef || d < best.top().first)
+        {
+          candidates.emplace(d, neighbor);
+          best.emplace(d, neighbor);
+          if (static_cast<int>(best.size()) > ef)
+            best.pop();
+        }
+      }
+    }
+
+    results.resize(best.size());
+    for (std::size_t i = results.size(); i > 0; --i)
+    {
+      results[i - 1] = best.top();
+      best.pop();
+    }
+  }
+
+  /// Exact search of the NN closest nodes
+  void searchExhaustive(const Scalar * point, std::size_t NN, std::vector<Candidate>& results) const
+  {
+    results.resize(_nbRows);
+    for (int i = 0; i < _nbRows; ++i)
+      results[i] = Candidate(distance(point, i), i);
+    std::partial_sort(results.begin(), results.begin() + NN, results.end());
+    results.resize(NN);
+  }
+
+  /**
+   * Keep the candidates closer to the point than to the selected neighbors (diversity heuristic),
+   * so the graph keeps links between the clusters of descriptors.
+   */
+  void selectNeighbors(std::vector<Candidate>& candidates, int M) const
+  {
+    if (static_cast<int>(candidates.size()) <= M)
+      return;
+
+    std::vector<Candidate> selected;
+    selected.reserve(M);
+    for (const Candidate& candidate : candidates)
+    {
+      if (static_cast<int>(selected.size()) >= M)
+        break;
+      bool isDiverse = true;
+      for (const Candidate& neighbor : selected)
+      {
+        if (_metric(row(candidate.second), row(neighbor.second), _dimension) < candidate.first)
+        {
+          isDiverse = false;
+          break;
+        }
+      }
+      if (isDiverse)
+        selected.push_back(candidate);
+    }
+    candidates.swap(selected);
+  }
+
+  /// Link a node to its neighbors in the graph
+  void insert(int node, VisitedList& visited)
+  {
+    const int level = _levels[node];
+    const Scalar * point = row(node);
+
+    // a node above the current top layer becomes the entry point, the other insertions wait for it
+    std::unique_lock<std::mutex> globalLock(_globalMutex);
+    int entry = _entryPoint;
+    const int maxLevel = _maxLevel;
+    if (level <= maxLevel)
+      globalLock.unlock();
+
+    for (int l = maxLevel; l > level; --l)
+      entry = searchClosest(point, entry, l, true);
+
+    std::vector<Candidate> candidates;
+    std::vector<Candidate> neighborCandidates;
+    for (int l = std::min(level, maxLevel); l >= 0; --l)
+    {
+      searchLayer(point, entry, _efConstruction, l, visited, true, candidates);
+      entry = candidates.front().second;
+      selectNeighbors(candidates, _M);
+
+      {
+        std::lock_guard<std::mutex> nodeLock(_nodeMutexes[node]);
+        int* nodeLinks = links(node, l);
+        nodeLinks[0] = static_cast<int>(candidates.size());
+        for (std::size_t i = 0; i < candidates.size(); ++i)
+          nodeLinks[i + 1] = candidates[i].second;
+      }
+
+      // reverse links, the neighbors with too many links are pruned
+      const int maxM = maxNeighbors(l);
+      for (const Candidate& candidate : candidates)
+      {
+        const int neighbor = candidate.second;
+        std::lock_guard<std::mutex> neighborLock(_nodeMutexes[neighbor]);
+        int* neighborLinks = links(neighbor, l);
+        if (neighborLinks[0] < maxM)
+        {
+          neighborLinks[++neighborLinks[0]] = node;
+          continue;
+        }
+        neighborCandidates.clear();
+        neighborCandidates.emplace_back(candidate.first, node);
+        for (int i = 1; i <= neighborLinks[0]; ++i)
+          neighborCandidates.emplace_back(_metric(row(neighbor), row(neighborLinks[i]), _dimension), neighborLinks[i]);
+        std::sort(neighborCandidates.begin(), neighborCandidates.end());
+        selectNeighbors(neighborCandidates, maxM);
+        neighborLinks[0] = static_cast<int>(neighborCandidates.size());
+        for (std::size_t i = 0; i < neighborCandidates.size(); ++i)
+          neighborLinks[i + 1] = neighborCandidates[i].second;
+      }
+    }
+
+    if (level > maxLevel)
+    {
+      _entryPoint = node;
+      _maxLevel = level;
+    }
+  }
+
+  const int _M;
+  const int _M0;
+  const int _efConstruction;
+  const int _efSearch;
+  Metric _metric;
+
+  const Scalar* _dataset = nullptr;
+  int _nbRows = 0;
+  int _dimension = 0;
+
+  /// top layer of each node
+  std::vector<int> _levels;
+  /// layer 0 links: (_M0 + 1) values per node
+  std::vector<int> _links0;
+  /// upper layers links of each node: (_M + 1) values per layer above 0
+  std::vector<std::vector<int> > _upperLinks;
+  int _entryPoint = 0;
+  int _maxLevel = 0;
+
+  /// locks of the nodes and of the entry point, during the construction only
+  std::unique_ptr<std::mutex[]> _nodeMutexes;
+  std::mutex _globalMutex;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
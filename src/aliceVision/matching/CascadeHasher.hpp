@@ -12,8 +12,10 @@
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/stl/DynamicBitset.hpp"
 #include <iostream>
+#include <fstream>
 #include <random>
 #include <cmath>
+#include <cstdint>
 
 namespace aliceVision {
 namespace matching {
@@ -69,28 +71,36 @@ private:
   int nb_bucket_groups_;
   // The number of buckets in each group.
   int nb_buckets_per_group_;
+  // The seed of the hashing projections (-1 if random).
+  int seed_ = -1;
 
 public:
   CascadeHasher() {}
 
-  // Creates the hashing projections (cascade of two level of hash codes)
+  /**
+   * @brief Creates the hashing projections (cascade of two level of hash codes)
+   * @param[in] seed The seed of the projections, the hashes of two hashers with the
+   *            same parameters and a positive seed are the same (-1: random projections)
+   */
   bool Init
   (
     const uint8_t nb_hash_code = 128,
     const uint8_t nb_bucket_groups = 6,
-    const uint8_t nb_bits_per_bucket = 10)
+    const uint8_t nb_bits_per_bucket = 10,
+    const int seed = -1)
   {
     nb_bucket_groups_= nb_bucket_groups;
     nb_hash_code_ = nb_hash_code;
     nb_bits_per_bucket_ = nb_bits_per_bucket;
     nb_buckets_per_group_= 1 << nb_bits_per_bucket;
+    seed_ = seed;
 
     //
     // Box Muller transform is used in the original paper to get fast random number
     // from a normal distribution with <mean = 0> and <variance = 1>.
     // Here we use C++11 normal distribution random number generator
     std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed < 0 ? rd() : static_cast<std::mt19937::result_type>(seed));
     std::normal_distribution<> d(0,1);
 
     primary_hash_projection_.resize(nb_hash_code, nb_hash_code);
@@ -197,22 +207,129 @@ public:
         }
       }
     }
-    // Build the Buckets
+    BuildBuckets(hashed_descriptions);
+    return hashed_descriptions;
+  }
+
+  // Build the buckets from the bucket ids of the hashed descriptions.
+  void BuildBuckets(HashedDescriptions& hashed_descriptions) const
+  {
+    hashed_descriptions.buckets.clear();
+    hashed_descriptions.buckets.resize(nb_bucket_groups_);
+    for (int i = 0; i < nb_bucket_groups_; ++i)
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
-      for (int i = 0; i < nb_bucket_groups_; ++i)
+      hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+
+      // Add the descriptor ID to the proper bucket group and id.
+      for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
       {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+        const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
+        hashed_descriptions.buckets[i][bucket_id].push_back(j);
+      }
+    }
+  }
 
-        // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+  /**
+   * @brief Save hashed descriptions (hash codes and bucket ids) in a binary file.
+   * @note Only the hashes of a hasher with a fixed seed can be reused.
+   * @param[in] path The output file
+   * @param[in] hashed_descriptions The hashed descriptions
+   * @param[in] zero_mean_descriptor The zero mean descriptor used to compute the hashes
+   * @param[in] descriptionsChecksum A checksum of the hashed descriptions
+   * @return false if the file can't be written
+   */
+  bool SaveHashedDescriptions
+  (
+    const std::string& path,
+    const HashedDescriptions& hashed_descriptions,
+    const Eigen::VectorXf& zero_mean_descriptor,
+    std::uint64_t descriptionsChecksum
+  ) const
+  {
+    std::ofstream stream(path, std::ios::out | std::ios::binary);
+    if (!stream.is_open())
+      return false;
+
+    const std::int32_t header[] = {nb_hash_code_, nb_bucket_groups_, nb_bits_per_bucket_, seed_,
+      static_cast<std::int32_t>(zero_mean_descriptor.size()),
+      static_cast<std::int32_t>(hashed_descriptions.hashed_desc.size())};
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&descriptionsChecksum), sizeof(descriptionsChecksum));
+    stream.write(reinterpret_cast<const char*>(zero_mean_descriptor.data()), zero_mean_descriptor.size() * sizeof(float));
+
+    for (const HashedDescription& hashed_desc : hashed_descriptions.hashed_desc)
+    {
+      stream.write(reinterpret_cast<const char*>(hashed_desc.hash_code.data()), hashed_desc.hash_code.num_blocks());
+      stream.write(reinterpret_cast<const char*>(hashed_desc.bucket_ids.data()), nb_bucket_groups_ * sizeof(uint16_t));
+    }
+    return stream.good();
+  }
+
+  /**
+   * @brief Load hashed descriptions saved with SaveHashedDescriptions.
+   * @param[in] path The input file
+   * @param[in] zero_mean_descriptor The zero mean descriptor that should have been used
+   * @param[in] nbDescriptions The expected number of descriptions
+   * @param[in] descriptionsChecksum The expected checksum of the descriptions
+   * @param[out] hashed_descriptions The hashed descriptions (with their buckets)
+   * @return false if the file doesn't exist or doesn't match this hasher and these descriptions
+   */
+  bool LoadHashedDescriptions
+  (
+    const std::string& path,
+    const Eigen::VectorXf& zero_mean_descriptor,
+    std::size_t nbDescriptions,
+    std::uint64_t descriptionsChecksum,
+    HashedDescriptions& hashed_descriptions
+  ) const
+  {
+    if (seed_ < 0)
+      return false;
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      return false;
+
+    std::int32_t header[6];
+    std::uint64_t savedChecksum = 0;
+    stream.read(reinterpret_cast<char*>(header), sizeof(header));
+    stream.read(reinterpret_cast<char*>(&savedChecksum), sizeof(savedChecksum));
+    if (!stream || savedChecksum != descriptionsChecksum ||
+        header[0] != nb_hash_code_ || header[1] != nb_bucket_groups_ ||
+        header[2] != nb_bits_per_bucket_ || header[3] != seed_ ||
+        header[4] != zero_mean_descriptor.size() || header[5] != static_cast<std::int32_t>(nbDescriptions))
+      return false;
+
+    Eigen::VectorXf saved_zero_mean(zero_mean_descriptor.size());
+    stream.read(reinterpret_cast<char*>(saved_zero_mean.data()), saved_zero_mean.size() * sizeof(float));
+    if (!stream || saved_zero_mean != zero_mean_descriptor)
+      return false;
+
+    hashed_descriptions.hashed_desc.resize(nbDescriptions);
+    for (HashedDescription& hashed_desc : hashed_descriptions.hashed_desc)
+    {
+      hashed_desc.hash_code = stl::dynamic_bitset(zero_mean_descriptor.size());
+      hashed_desc.bucket_ids.resize(nb_bucket_groups_);
+      stream.read(reinterpret_cast<char*>(hashed_desc.hash_code.data()), hashed_desc.hash_code.num_blocks());
+      stream.read(reinterpret_cast<char*>(hashed_desc.bucket_ids.data()), nb_bucket_groups_ * sizeof(uint16_t));
+    }
+    if (!stream)
+    {
+      hashed_descriptions = HashedDescriptions();
+      return false;
+    }
+    for (const HashedDescription& hashed_desc : hashed_descriptions.hashed_desc)
+    {
+      for (const uint16_t bucket_id : hashed_desc.bucket_ids)
+      {
+        if (bucket_id >= nb_buckets_per_group_)
         {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
+          hashed_descriptions = HashedDescriptions();
+          return false;
         }
       }
     }
-    return hashed_descriptions;
+    BuildBuckets(hashed_descriptions);
+    return true;
   }
 
   // Matches two collection of hashed descriptions with a fast matching scheme
@@ -254,8 +371,13 @@ public:
     // feature for matching (i.e., prevents duplicates).
     std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
 
-    typedef matching::Hamming<stl::dynamic_bitset::BlockType> HammingMetricType;
-    static const HammingMetricType metricH = {};
+    // Preallocated unique candidates, their hash codes and hamming distances.
+    std::vector<int> unique_candidates;
+    std::vector<const unsigned char*> unique_candidate_codes;
+    std::vector<unsigned int> unique_candidate_distances;
+    unique_candidates.reserve(hashed_descriptions2.hashed_desc.size());
+    unique_candidate_codes.reserve(hashed_descriptions2.hashed_desc.size());
+    unique_candidate_distances.reserve(hashed_descriptions2.hashed_desc.size());
     for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
     {
       candidate_descriptors.clear();
@@ -285,22 +407,35 @@ public:
       // Compute the hamming distance of all candidates based on the comp hash
       // code. Put the descriptors into buckets corresponding to their hamming
       // distance.
+      unique_candidates.clear();
+      unique_candidate_codes.clear();
       for (const int candidate_id : candidate_descriptors)
       {
         if (!used_descriptor[candidate_id]) // avoid selecting the same candidate multiple times
         {
           used_descriptor[candidate_id] = true;
-
-          const HammingMetricType::ResultType hamming_distance = metricH(
-            hashed_desc.hash_code.data(),
-            hashed_descriptions2.hashed_desc[candidate_id].hash_code.data(),
-            hashed_desc.hash_code.num_blocks());
-          candidate_hamming_distances(
-              num_descriptors_with_hamming_distance(hamming_distance)++,
-              hamming_distance) = candidate_id;
+          unique_candidates.emplace_back(candidate_id);
+          unique_candidate_codes.emplace_back(hashed_descriptions2.hashed_desc[candidate_id].hash_code.data());
         }
       }
 
+      // all the candidates at once: the hash codes are short, a call per candidate is not worth it
+      unique_candidate_distances.resize(unique_candidates.size());
+      simd::hammingDistances(
+        hashed_desc.hash_code.data(),
+        unique_candidate_codes.data(),
+        unique_candidate_codes.size(),
+        hashed_desc.hash_code.num_blocks(),
+        unique_candidate_distances.data());
+
+      for (std::size_t k = 0; k < unique_candidates.size(); ++k)
+      {
+        const unsigned int hamming_distance = unique_candidate_distances[k];
+        candidate_hamming_distances(
+            num_descriptors_with_hamming_distance(hamming_distance)++,
+            hamming_distance) = unique_candidates[k];
+      }
+
       // Compute the euclidean distance of the k descriptors with the best hamming
       // distance.
       candidate_euclidean_distances.reserve(kNumTopCandidates);
@@ -0,0 +1,70 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <map>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Type of the model estimated by the geometric filtering of an image pair
+ */
+enum class EGeometricModel
+{
+  FUNDAMENTAL_MATRIX = 0,
+  ESSENTIAL_MATRIX,
+  HOMOGRAPHY_MATRIX
+};
+
+/**
+ * @brief Model estimated by the geometric filtering of an image pair,
+ *        saved with the matches so the SfM can reuse it instead of estimating it again.
+ *        The model relates the undistorted pixel coordinates of the first view to the second one.
+ */
+struct PairGeometricModel
+{
+  EGeometricModel type = EGeometricModel::FUNDAMENTAL_MATRIX;
+  Mat3 matrix = Mat3::Identity();
+  /// number of inliers of the model
+  std::size_t nbInliers = 0;
+  /// max. error of the inliers in pixels (threshold found by the A Contrario estimation)
+  double threshold = std::numeric_limits<double>::infinity();
+};
+
+typedef std::map<Pair, PairGeometricModel> PairGeometricModels;
+
+/**
+ * @brief Get the essential matrix of an image pair from its geometric model
+ * @param[in] model The geometric model of the pair
+ * @param[in] K1 The intrinsics of the first view
+ * @param[in] K2 The intrinsics of the second view
+ * @param[out] E The essential matrix
+ * @return false if the model type has no essential matrix (homography)
+ */
+inline bool getEssentialMatrix(const PairGeometricModel& model, const Mat3& K1, const Mat3& K2, Mat3& E)
+{
+  switch(model.type)
+  {
+    case EGeometricModel::ESSENTIAL_MATRIX:
+      E = model.matrix;
+      return true;
+    case EGeometricModel::FUNDAMENTAL_MATRIX:
+      E = K2.transpose() * model.matrix * K1;
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace matching
+} // namespace aliceVision
@@ -9,7 +9,9 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <set>
@@ -56,9 +58,10 @@ struct IndMatch
   /// Remove duplicates ((_i, _j) that appears multiple times)
   static bool getDeduplicated(std::vector<IndMatch> & vec_match)
   {
+    // sort-unique (stable to keep the first occurrence, as a std::set)
     const size_t sizeBefore = vec_match.size();
-    std::set<IndMatch> set_deduplicated( vec_match.begin(), vec_match.end());
-    vec_match.assign(set_deduplicated.begin(), set_deduplicated.end());
+    std::stable_sort(vec_match.begin(), vec_match.end());
+    vec_match.erase(std::unique(vec_match.begin(), vec_match.end()), vec_match.end());
     return sizeBefore != vec_match.size();
   }
 
@@ -114,5 +117,18 @@ inline PairSet getImagePairs(const PairwiseMatches & matches)
   return pairs;
 }
 
+/// Estimated memory used by the pairwise matches (bytes), for the system::MemoryAccounting
+inline std::size_t getMemorySize(const PairwiseMatches& matches)
+{
+  std::size_t size = matches.size() * (sizeof(PairwiseMatches::value_type) + system::mapNodeOverhead);
+  for(const auto& matchesPerDesc : matches)
+  {
+    size += matchesPerDesc.second.size() * (sizeof(MatchesPerDescType::value_type) + system::mapNodeOverhead);
+    for(const auto& descMatches : matchesPerDesc.second)
+      size += descMatches.second.capacity() * sizeof(IndMatch);
+  }
+  return size;
+}
+
 }  // namespace matching
 }  // namespace aliceVision
@@ -7,10 +7,16 @@
 
 #pragma once
 
-#include <iostream>
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/feature/feature.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
 namespace aliceVision {
 namespace matching {
 
@@ -31,20 +37,6 @@ class IndMatchDecorator
       index = ind;
     }
 
-    /// Lexicographical ordering of matches. Used to remove duplicates.
-    friend bool operator<(const IndMatchDecoratorStruct& m1,
-      const IndMatchDecoratorStruct& m2)  {
-
-      if (m1 == m2) return false;
-
-      if (m1.x1 < m2.x1)
-        return m1.y1 < m2.y1;
-      else
-        if (m1.x1 > m2.x1)
-          return m1.y1 < m2.y1;
-      return m1.x1 < m2.x1;
-    }
-
     /// Comparison Operator
     friend bool operator==(const IndMatchDecoratorStruct& m1,
       const IndMatchDecoratorStruct& m2)  {
@@ -56,6 +48,34 @@ class IndMatchDecorator
     T x1,y1, x2,y2;
     IndMatch index;
   };
+
+  /// The coordinates of a match packed in two integers, sorted to find the duplicates
+  struct PackedMatch
+  {
+    std::uint64_t left, right;
+    std::size_t position;
+
+    friend bool operator<(const PackedMatch& m1, const PackedMatch& m2) {
+      if (m1.left != m2.left)
+        return m1.left < m2.left;
+      if (m1.right != m2.right)
+        return m1.right < m2.right;
+      return m1.position < m2.position;
+    }
+  };
+
+  /// Pack two coordinates (as float) in an integer with the same equality
+  static std::uint64_t pack(T x, T y)
+  {
+    // +0.0f to merge 0 and -0
+    const float fx = static_cast<float>(x) + 0.0f;
+    const float fy = static_cast<float>(y) + 0.0f;
+    std::uint32_t bx, by;
+    std::memcpy(&bx, &fx, sizeof(float));
+    std::memcpy(&by, &fy, sizeof(float));
+    return (static_cast<std::uint64_t>(bx) << 32) | by;
+  }
+
 public:
 
   IndMatchDecorator(const std::vector<IndMatch> & vec_matches,
@@ -63,6 +83,7 @@ public:
     const std::vector<feature::SIOPointFeature> & rightFeat)
     :_vec_matches(vec_matches)
   {
+    _vecDecoredMatches.reserve(vec_matches.size());
     for (size_t i = 0; i < vec_matches.size(); ++i) {
       const size_t I = vec_matches[i]._i;
       const size_t J = vec_matches[i]._j;
@@ -77,6 +98,7 @@ public:
     const std::vector<feature::PointFeature> & rightFeat)
     :_vec_matches(vec_matches)
   {
+    _vecDecoredMatches.reserve(vec_matches.size());
     for (size_t i = 0; i < vec_matches.size(); ++i) {
       const size_t I = vec_matches[i]._i;
       const size_t J = vec_matches[i]._j;
@@ -86,11 +108,28 @@ public:
     }
   }
 
+  /// Read the coordinates of the matched regions only (no copy of all the regions positions)
+  IndMatchDecorator(const std::vector<IndMatch> & vec_matches,
+    const feature::Regions & leftRegions,
+    const feature::Regions & rightRegions)
+    :_vec_matches(vec_matches)
+  {
+    _vecDecoredMatches.reserve(vec_matches.size());
+    for (size_t i = 0; i < vec_matches.size(); ++i) {
+      const Vec2 left = leftRegions.GetRegionPosition(vec_matches[i]._i);
+      const Vec2 right = rightRegions.GetRegionPosition(vec_matches[i]._j);
+      _vecDecoredMatches.push_back(
+        IndMatchDecoratorStruct(left(0), left(1),
+        right(0), right(1), vec_matches[i]));
+    }
+  }
+
   IndMatchDecorator(const std::vector<IndMatch> & vec_matches,
     const Mat & leftFeat,
     const Mat & rightFeat)
     :_vec_matches(vec_matches)
   {
+    _vecDecoredMatches.reserve(vec_matches.size());
     for (size_t i = 0; i < vec_matches.size(); ++i) {
       const size_t I = vec_matches[i]._i;
       const size_t J = vec_matches[i]._j;
@@ -100,13 +139,39 @@ public:
     }
   }
 
-  /// Remove duplicates (same (x1,y1) coords that appears multiple times)
+  /**
+   * @brief Remove duplicates (same (x1,y1,x2,y2) coords that appears multiple times).
+   * The first occurrence of each match is kept and the order of the matches is preserved.
+   * The coordinates are compared as float.
+   * @param[out] vec_matches The deduplicated matches
+   * @return non-zero if some matches have been removed
+   */
   size_t getDeduplicated(std::vector<IndMatch> & vec_matches)
   {
-    size_t sizeBefore = _vecDecoredMatches.size();
-    std::set<IndMatchDecoratorStruct> set_deduplicated(
-      _vecDecoredMatches.begin(),_vecDecoredMatches.end());
-    _vecDecoredMatches.assign(set_deduplicated.begin(), set_deduplicated.end());
+    const size_t sizeBefore = _vecDecoredMatches.size();
+
+    // sort-unique on a flat array of packed coordinates
+    std::vector<PackedMatch> packedMatches(sizeBefore);
+    for (size_t i = 0; i < sizeBefore; ++i) {
+      const IndMatchDecoratorStruct & m = _vecDecoredMatches[i];
+      packedMatches[i] = {pack(m.x1, m.y1), pack(m.x2, m.y2), i};
+    }
+    std::sort(packedMatches.begin(), packedMatches.end());
+
+    std::vector<char> keep(sizeBefore, 0);
+    for (size_t i = 0; i < sizeBefore; ++i) {
+      if (i == 0 ||
+          packedMatches[i].left != packedMatches[i-1].left ||
+          packedMatches[i].right != packedMatches[i-1].right)
+        keep[packedMatches[i].position] = 1;
+    }
+
+    size_t nbKept = 0;
+    for (size_t i = 0; i < sizeBefore; ++i) {
+      if (keep[i])
+        _vecDecoredMatches[nbKept++] = _vecDecoredMatches[i];
+    }
+    _vecDecoredMatches.erase(_vecDecoredMatches.begin() + nbKept, _vecDecoredMatches.end());
 
     vec_matches.resize(_vecDecoredMatches.size());
     for (size_t i = 0; i < _vecDecoredMatches.size(); ++i)  {
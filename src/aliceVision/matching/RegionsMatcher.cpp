@@ -8,8 +8,10 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matching/RegionsMatcher.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/ArrayMatcher_hnsw.hpp"
 
 #include <aliceVision/system/Logger.hpp>
 
@@ -61,9 +63,10 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
   std::unique_ptr<IRegionsMatcher> out;
 
   // Handle invalid request
-  if (regions.IsScalar() && matcherType == BRUTE_FORCE_HAMMING)
+  const bool isHammingMatcher = (matcherType == BRUTE_FORCE_HAMMING || matcherType == HNSW_HAMMING);
+  if (regions.IsScalar() && isHammingMatcher)
     return out;
-  if (regions.IsBinary() && matcherType != BRUTE_FORCE_HAMMING)
+  if (regions.IsBinary() && !isHammingMatcher)
     return out;
 
   // Switch regions type ID, matcher & Metric: initialize the Matcher interface
@@ -81,12 +84,27 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BLOCKED_BRUTE_FORCE_L2:
+        case CUDA_BRUTE_FORCE_L2: // pairs matched one by one on CPU
+        {
+          typedef L2_Vectorized<unsigned char> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<unsigned char, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<unsigned char> MatcherT;
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case HNSW_L2:
+        {
+          typedef L2_Vectorized<unsigned char> MetricT;
+          typedef ArrayMatcher_hnsw<unsigned char, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case CASCADE_HASHING_L2:
         {
           typedef L2_Vectorized<unsigned char> MetricT;
@@ -110,12 +128,27 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BLOCKED_BRUTE_FORCE_L2:
+        case CUDA_BRUTE_FORCE_L2: // pairs matched one by one on CPU
+        {
+          typedef L2_Vectorized<float> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<float, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<float> MatcherT;
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case HNSW_L2:
+        {
+          typedef L2_Vectorized<float> MetricT;
+          typedef ArrayMatcher_hnsw<float, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case CASCADE_HASHING_L2:
         {
           typedef L2_Vectorized<float> MetricT;
@@ -139,12 +172,27 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BLOCKED_BRUTE_FORCE_L2:
+        case CUDA_BRUTE_FORCE_L2: // pairs matched one by one on CPU
+        {
+          typedef L2_Vectorized<double> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<double, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<double> MatcherT;
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case HNSW_L2:
+        {
+          typedef L2_Vectorized<double> MetricT;
+          typedef ArrayMatcher_hnsw<double, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case CASCADE_HASHING_L2:
         {
           ALICEVISION_LOG_WARNING("Not yet implemented");
@@ -166,6 +214,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
         out.reset(new matching::RegionsMatcher<MatcherT>(regions, false));
       }
       break;
+      case HNSW_HAMMING:
+      {
+        typedef Hamming<unsigned char> Metric;
+        typedef ArrayMatcher_hnsw<unsigned char, Metric> MatcherT;
+        out.reset(new matching::RegionsMatcher<MatcherT>(regions, false));
+      }
+      break;
       default:
           ALICEVISION_LOG_WARNING("Using unknown matcher type");
     }
@@ -85,6 +85,64 @@ public:
 inline IRegionsMatcher::~IRegionsMatcher()
 {}
 
+/**
+ * @brief Filter the 2 nearest neighbours of each query descriptor with the distance ratio test,
+ * then remove the duplicated matches.
+ *
+ * @param[in] distRatio The threshold for the ratio test.
+ * @param[in] squaredMetric Whether the distances are squared.
+ * @param[in] nnIndices The (query, database) indices of the 2 nearest neighbours of each query descriptor.
+ * @param[in] nnDistances The distances of the 2 nearest neighbours of each query descriptor.
+ * @param[in] databaseRegions The database Regions.
+ * @param[in] queryRegions The query Regions.
+ * @param[out] matches It contains the indices of the matching features
+ * of the database and the query Regions.
+ */
+template <typename DistanceType>
+void distanceRatioFilter(float distRatio,
+                         bool squaredMetric,
+                         const matching::IndMatches& nnIndices,
+                         const std::vector<DistanceType>& nnDistances,
+                         const feature::Regions& databaseRegions,
+                         const feature::Regions& queryRegions,
+                         matching::IndMatches& matches)
+{
+  const size_t NNN__ = 2;
+
+  std::vector<int> vec_nn_ratio_idx;
+  std::vector<float> vec_distanceRatio;
+  // Filter the matches using a distance ratio test:
+  //   The probability that a match is correct is determined by taking
+  //   the ratio of distance from the closest neighbor to the distance
+  //   of the second closest.
+  matching::NNdistanceRatio(
+    nnDistances.begin(), // distance start
+    nnDistances.end(),   // distance end
+    NNN__, // Number of neighbor in iterator sequence (minimum required 2)
+    vec_nn_ratio_idx, // output (indices that respect the distance Ratio)
+    squaredMetric ? Square(distRatio) : distRatio,
+    &vec_distanceRatio);
+
+  matches.reserve(vec_nn_ratio_idx.size());
+  for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
+  {
+    const size_t index = vec_nn_ratio_idx[k];
+    matches.emplace_back(nnIndices[index*NNN__]._j, nnIndices[index*NNN__]._i
+        , vec_distanceRatio[k]
+#ifdef ALICEVISION_DEBUG_MATCHING
+        , (float) nnDistances[vec_nn_ratio_idx[0]]
+#endif
+    );
+  }
+
+  // Remove duplicates
+  matching::IndMatch::getDeduplicated(matches);
+
+  // Remove matches that have the same (X,Y) coordinates
+  matching::IndMatchDecorator<float> matchDeduplicator(matches, databaseRegions, queryRegions);
+  matchDeduplicator.getDeduplicated(matches);
+}
+
 /**
  * Match two Regions with one stored as a "database" according a Template ArrayMatcher.
  */
@@ -145,39 +203,8 @@ public:
     if (!matcher_.SearchNeighbours(queries, queryregions_.RegionCount(), &vec_nIndice, &vec_fDistance, NNN__))
       return false;
 
-    std::vector<int> vec_nn_ratio_idx;
-    std::vector<float> vec_distanceRatio;
-    // Filter the matches using a distance ratio test:
-    //   The probability that a match is correct is determined by taking
-    //   the ratio of distance from the closest neighbor to the distance
-    //   of the second closest.
-    matching::NNdistanceRatio(
-      vec_fDistance.begin(), // distance start
-      vec_fDistance.end(),   // distance end
-      NNN__, // Number of neighbor in iterator sequence (minimum required 2)
-      vec_nn_ratio_idx, // output (indices that respect the distance Ratio)
-      b_squared_metric_ ? Square(f_dist_ratio) : f_dist_ratio,
-      &vec_distanceRatio);
-
-    vec_putative_matches.reserve(vec_nn_ratio_idx.size());
-    for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
-    {
-      const size_t index = vec_nn_ratio_idx[k];
-      vec_putative_matches.emplace_back(vec_nIndice[index*NNN__]._j, vec_nIndice[index*NNN__]._i
-          , vec_distanceRatio[k]
-  #ifdef ALICEVISION_DEBUG_MATCHING
-          , (float) vec_fDistance[vec_nn_ratio_idx[0]]
-  #endif
-      );
-    }
-
-    // Remove duplicates
-    matching::IndMatch::getDeduplicated(vec_putative_matches);
-
-    // Remove matches that have the same (X,Y) coordinates
-    matching::IndMatchDecorator<float> matchDeduplicator(vec_putative_matches,
-      regions_.GetRegionsPositions(), queryregions_.GetRegionsPositions());
-    matchDeduplicator.getDeduplicated(vec_putative_matches);
+    distanceRatioFilter(f_dist_ratio, b_squared_metric_, vec_nIndice, vec_fDistance,
+                        regions_, queryregions_, vec_putative_matches);
 
     return (!vec_putative_matches.empty());
   }
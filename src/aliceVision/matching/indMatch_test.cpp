@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/matching/IndMatchDecorator.hpp"
 #include "aliceVision/matching/io.hpp"
 
 #include <boost/filesystem/operations.hpp>
@@ -87,6 +88,150 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_BINARY)
+{
+  const std::string testFolder = "matchingBinTest";
+  boost::filesystem::create_directory(testFolder);
+  {
+    std::set<IndexT> viewsKeys = {0, 1, 2};
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+    matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{4,5}};
+    matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}, {2,2}};
+
+    // Test export of a global file
+    BOOST_CHECK(Save(matches, testFolder, "bin", false));
+
+    // Random access
+    const MatchesFileReader reader((fs::path(testFolder) / "matches.bin").string());
+    BOOST_CHECK_EQUAL(2, reader.getNbPairs());
+    BOOST_CHECK(reader.hasPair(std::make_pair(0,1)));
+    BOOST_CHECK(!reader.hasPair(std::make_pair(0,2)));
+
+    MatchesPerDescType matchesPerDesc;
+    BOOST_CHECK(reader.loadPair(std::make_pair(1,2), matchesPerDesc));
+    BOOST_CHECK_EQUAL(1, matchesPerDesc.size());
+    BOOST_CHECK(matchesPerDesc.at(EImageDescriberType::UNKNOWN) == matches.at(std::make_pair(1,2)).at(EImageDescriberType::UNKNOWN));
+
+    BOOST_CHECK(reader.loadPair(std::make_pair(0,1), matchesPerDesc, {EImageDescriberType::SIFT}));
+    BOOST_CHECK_EQUAL(1, matchesPerDesc.size());
+    BOOST_CHECK_EQUAL(IndMatch(4,5), matchesPerDesc.at(EImageDescriberType::SIFT).front());
+
+    // Streaming iteration with top matches filter
+    std::size_t nbVisitedPairs = 0;
+    reader.visitPairs([&](const Pair& pair, const MatchesPerDescType& m)
+      {
+        ++nbVisitedPairs;
+        BOOST_CHECK_EQUAL(1, m.getNbMatches(EImageDescriberType::UNKNOWN));
+      }, viewsKeys, {}, 1);
+    BOOST_CHECK_EQUAL(2, nbVisitedPairs);
+
+    // Load with filters
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, {0, 1}, {testFolder}, {EImageDescriberType::UNKNOWN}));
+    BOOST_CHECK_EQUAL(1, loadedMatches.size());
+    BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN).size());
+    BOOST_CHECK_EQUAL(0, loadedMatches.at(std::make_pair(0,1)).count(EImageDescriberType::SIFT));
+  }
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+  {
+    std::set<IndexT> viewsKeys = {0, 1, 2};
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+    matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}, {2,2}};
+
+    // Test export of one file per image
+    BOOST_CHECK(Save(matches, testFolder, "bin", true));
+    BOOST_CHECK_EQUAL(2, getBinaryMatchFiles(viewsKeys, {testFolder}).size());
+
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, viewsKeys, {testFolder}, {EImageDescriberType::UNKNOWN}));
+    BOOST_CHECK_EQUAL(2, loadedMatches.size());
+    BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN).size());
+    BOOST_CHECK_EQUAL(3, loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::UNKNOWN).size());
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_SHARDS)
+{
+  const std::string testFolder = "matchingShardsTest";
+  boost::filesystem::create_directory(testFolder);
+  {
+    std::set<IndexT> viewsKeys = {0, 1, 2, 3};
+    PairwiseMatches shard0;
+    shard0[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+    shard0[std::make_pair(2,3)][EImageDescriberType::SIFT] = {{4,5}};
+    PairwiseMatches shard1;
+    shard1[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}, {2,2}};
+
+    // Test export of one shard per range
+    BOOST_CHECK(Save(shard0, testFolder, "bin", false, getMatchesShardBasename(0)));
+    BOOST_CHECK(Save(shard1, testFolder, "bin", false, getMatchesShardBasename(2)));
+    const std::vector<std::string> shardFiles = getMatchesShardFiles(testFolder);
+    BOOST_CHECK_EQUAL(2, shardFiles.size());
+    BOOST_CHECK_EQUAL(2, getBinaryMatchFiles(viewsKeys, {testFolder}).size());
+
+    // Shards are loaded without being merged
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, viewsKeys, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(3, loadedMatches.size());
+
+    // Merged file
+    const std::string mergedFile = (fs::path(testFolder) / "matches.bin").string();
+    mergeBinaryMatchFiles(shardFiles, mergedFile);
+    const MatchesFileReader reader(mergedFile);
+    BOOST_CHECK_EQUAL(3, reader.getNbPairs());
+
+    MatchesPerDescType matchesPerDesc;
+    BOOST_CHECK(reader.loadPair(std::make_pair(1,2), matchesPerDesc));
+    BOOST_CHECK(matchesPerDesc.at(EImageDescriberType::UNKNOWN) == shard1.at(std::make_pair(1,2)).at(EImageDescriberType::UNKNOWN));
+    BOOST_CHECK(reader.loadPair(std::make_pair(2,3), matchesPerDesc));
+    BOOST_CHECK_EQUAL(IndMatch(4,5), matchesPerDesc.at(EImageDescriberType::SIFT).front());
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_GEOMETRIC_MODELS)
+{
+  const std::string testFolder = "matchingModelsTest";
+  boost::filesystem::create_directory(testFolder);
+  {
+    PairGeometricModels models;
+    PairGeometricModel& essential = models[std::make_pair(0,1)];
+    essential.type = EGeometricModel::ESSENTIAL_MATRIX;
+    essential.matrix = Mat3::Random();
+    essential.nbInliers = 120;
+    essential.threshold = 1.25;
+    PairGeometricModel& homography = models[std::make_pair(1,2)];
+    homography.type = EGeometricModel::HOMOGRAPHY_MATRIX;
+    homography.nbInliers = 30;
+
+    // Models of the global file and of a shard
+    BOOST_CHECK(saveGeometricModels({*models.begin()}, testFolder));
+    BOOST_CHECK(saveGeometricModels({*models.rbegin()}, testFolder, getMatchesShardBasename(1)));
+
+    PairGeometricModels loadedModels;
+    BOOST_CHECK(loadGeometricModels(loadedModels, {testFolder}));
+    BOOST_CHECK_EQUAL(2, loadedModels.size());
+
+    const PairGeometricModel& loadedEssential = loadedModels.at(std::make_pair(0,1));
+    BOOST_CHECK(loadedEssential.type == EGeometricModel::ESSENTIAL_MATRIX);
+    BOOST_CHECK(loadedEssential.matrix.isApprox(essential.matrix));
+    BOOST_CHECK_EQUAL(120, loadedEssential.nbInliers);
+    BOOST_CHECK_EQUAL(1.25, loadedEssential.threshold);
+
+    const PairGeometricModel& loadedHomography = loadedModels.at(std::make_pair(1,2));
+    BOOST_CHECK(loadedHomography.type == EGeometricModel::HOMOGRAPHY_MATRIX);
+    BOOST_CHECK(std::isinf(loadedHomography.threshold));
+
+    Mat3 E;
+    BOOST_CHECK(!getEssentialMatrix(loadedHomography, Mat3::Identity(), Mat3::Identity(), E));
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
@@ -141,3 +286,63 @@ BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval)
   BOOST_CHECK_EQUAL(IndMatch(2,3), vec_indMatch[3]);
   BOOST_CHECK_EQUAL(IndMatch(3,3), vec_indMatch[4]);
 }
+
+BOOST_AUTO_TEST_CASE(IndMatchDecorator_DuplicateRemoval)
+{
+  const std::vector<PointFeature> featsL = {PointFeature(0.f, 0.f), PointFeature(1.f, 2.f), PointFeature(1.f, 2.f), PointFeature(3.f, 4.f)};
+  const std::vector<PointFeature> featsR = {PointFeature(5.f, 6.f), PointFeature(7.f, 8.f), PointFeature(0.f, 0.f)};
+
+  std::vector<IndMatch> vec_indMatch;
+  vec_indMatch.push_back(IndMatch(3,1));
+  vec_indMatch.push_back(IndMatch(1,0));
+  vec_indMatch.push_back(IndMatch(2,0)); // same coordinates as (1,0)
+  vec_indMatch.push_back(IndMatch(2,1));
+  vec_indMatch.push_back(IndMatch(0,2));
+  vec_indMatch.push_back(IndMatch(0,2)); // same indexes as the previous one
+
+  IndMatchDecorator<float> matchDeduplicator(vec_indMatch, featsL, featsR);
+  BOOST_CHECK(matchDeduplicator.getDeduplicated(vec_indMatch));
+
+  // the first occurrences are kept in the input order
+  BOOST_CHECK_EQUAL(4, vec_indMatch.size());
+  BOOST_CHECK_EQUAL(IndMatch(3,1), vec_indMatch[0]);
+  BOOST_CHECK_EQUAL(IndMatch(1,0), vec_indMatch[1]);
+  BOOST_CHECK_EQUAL(IndMatch(2,1), vec_indMatch[2]);
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_indMatch[3]);
+
+  IndMatchDecorator<float> noDuplicate(vec_indMatch, featsL, featsR);
+  BOOST_CHECK(!noDuplicate.getDeduplicated(vec_indMatch));
+  BOOST_CHECK_EQUAL(4, vec_indMatch.size());
+}
+
+BOOST_AUTO_TEST_CASE(IndMatchDecorator_Regions)
+{
+  std::vector<SIOPointFeature> featsL;
+  std::vector<SIOPointFeature> featsR;
+  for(int i = 0; i < 10; ++i)
+  {
+    featsL.emplace_back(float(i % 2), float(i % 3), 1.f, 0.f);
+    featsR.emplace_back(float(i % 2), float(i % 4), 1.f, 0.f);
+  }
+  SIFT_Regions regionsL;
+  SIFT_Regions regionsR;
+  regionsL.setRawData(featsL.size(), featsL.data(), nullptr);
+  regionsR.setRawData(featsR.size(), featsR.data(), nullptr);
+
+  std::vector<IndMatch> matches;
+  for(IndexT i = 0; i < 10; ++i)
+    for(IndexT j = 0; j < 10; ++j)
+      matches.emplace_back(i, j);
+
+  // same result with the regions positions as with the features
+  std::vector<IndMatch> matchesFeatures = matches;
+  IndMatchDecorator<float> featuresDeduplicator(matchesFeatures, featsL, featsR);
+  featuresDeduplicator.getDeduplicated(matchesFeatures);
+
+  IndMatchDecorator<float> regionsDeduplicator(matches, regionsL, regionsR);
+  BOOST_CHECK(regionsDeduplicator.getDeduplicated(matches));
+
+  // 6 distinct left positions, 4 distinct right positions
+  BOOST_CHECK_EQUAL(6 * 4, matches.size());
+  BOOST_CHECK(matches == matchesFeatures);
+}
@@ -12,9 +12,15 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <fstream>
+#include <iomanip>
 #include <iterator>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -23,6 +29,306 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace matching {
 
+namespace {
+
+const char matchesFileMagic[8] = {'A', 'V', 'M', 'A', 'T', 'C', 'H', 'S'};
+const std::uint32_t matchesFileVersion = 1;
+const std::string matchesShardPrefix = "matches.shard_";
+const std::string geometricModelsExtension = ".models.txt";
+
+bool isDescTypeFiltered(const std::vector<feature::EImageDescriberType>& descTypesFilter, feature::EImageDescriberType descType)
+{
+  return !descTypesFilter.empty() &&
+         std::find(descTypesFilter.begin(), descTypesFilter.end(), descType) == descTypesFilter.end();
+}
+
+} // namespace
+
+MatchesFileReader::MatchesFileReader(const std::string& filepath)
+  : _filepath(filepath)
+{
+  if(!fs::exists(filepath))
+    throw std::runtime_error("Can't load matches file, can't open '" + filepath + "' !");
+
+  _file.open(filepath);
+
+  if(!_file.is_open() || _file.size() < sizeof(MatchesFileHeader))
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' is incorrect !");
+
+  std::memcpy(&_header, _file.data(), sizeof(MatchesFileHeader));
+
+  if(std::memcmp(_header.magic, matchesFileMagic, sizeof(_header.magic)) != 0)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' is not a binary matches file !");
+
+  if(_header.version != matchesFileVersion)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' has an unsupported version (" + std::to_string(_header.version) + ") !");
+
+  const std::uint64_t fileSize = _file.size();
+
+  if(_header.pairsOffset + _header.nbPairs * sizeof(MatchesFilePairEntry) > fileSize ||
+     _header.blocksOffset + _header.nbBlocks * sizeof(MatchesFileBlockEntry) > fileSize)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' is truncated !");
+
+  _pairs = reinterpret_cast<const MatchesFilePairEntry*>(_file.data() + _header.pairsOffset);
+  _blocks = reinterpret_cast<const MatchesFileBlockEntry*>(_file.data() + _header.blocksOffset);
+
+  for(std::uint64_t i = 0; i < _header.nbBlocks; ++i)
+  {
+    if(_blocks[i].offset + 2 * _blocks[i].nbMatches * sizeof(std::uint32_t) > fileSize)
+      throw std::runtime_error("Can't load matches file, '" + filepath + "' is truncated !");
+  }
+}
+
+PairSet MatchesFileReader::getPairs() const
+{
+  PairSet pairs;
+  for(std::uint64_t i = 0; i < _header.nbPairs; ++i)
+    pairs.emplace_hint(pairs.end(), _pairs[i].I, _pairs[i].J);
+  return pairs;
+}
+
+const MatchesFilePairEntry* MatchesFileReader::findPair(const Pair& pair) const
+{
+  const MatchesFilePairEntry* begin = _pairs;
+  const MatchesFilePairEntry* end = _pairs + _header.nbPairs;
+
+  // pairs are sorted in the file
+  const MatchesFilePairEntry* it = std::lower_bound(begin, end, pair,
+    [](const MatchesFilePairEntry& entry, const Pair& p)
+    {
+      return (entry.I < p.first) || (entry.I == p.first && entry.J < p.second);
+    });
+
+  if(it == end || it->I != pair.first || it->J != pair.second)
+    return nullptr;
+  return it;
+}
+
+void MatchesFileReader::readPair(const MatchesFilePairEntry& entry,
+                                 MatchesPerDescType& matchesPerDesc,
+                                 const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                                 int maxNbMatches) const
+{
+  for(std::uint64_t b = entry.firstBlock; b < entry.firstBlock + entry.nbBlocks; ++b)
+  {
+    const MatchesFileBlockEntry& block = _blocks[b];
+    const feature::EImageDescriberType descType = static_cast<feature::EImageDescriberType>(block.describerType);
+
+    if(isDescTypeFiltered(descTypesFilter, descType))
+      continue;
+
+    std::size_t nbMatches = static_cast<std::size_t>(block.nbMatches);
+    if(maxNbMatches > 0)
+      nbMatches = std::min(nbMatches, static_cast<std::size_t>(maxNbMatches));
+
+    // columnar storage: all I indexes then all J indexes
+    const std::uint32_t* columnI = reinterpret_cast<const std::uint32_t*>(_file.data() + block.offset);
+    const std::uint32_t* columnJ = columnI + block.nbMatches;
+
+    IndMatches& matches = matchesPerDesc[descType];
+    matches.resize(nbMatches);
+    for(std::size_t i = 0; i < nbMatches; ++i)
+    {
+      matches[i]._i = columnI[i];
+      matches[i]._j = columnJ[i];
+    }
+  }
+}
+
+bool MatchesFileReader::loadPair(const Pair& pair,
+                                 MatchesPerDescType& matchesPerDesc,
+                                 const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                                 int maxNbMatches) const
+{
+  const MatchesFilePairEntry* entry = findPair(pair);
+  if(entry == nullptr)
+    return false;
+
+  matchesPerDesc.clear();
+  readPair(*entry, matchesPerDesc, descTypesFilter, maxNbMatches);
+  return true;
+}
+
+void MatchesFileReader::visitPairs(const PairVisitor& visitor,
+                                   const std::set<IndexT>& viewsKeysFilter,
+                                   const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                                   int maxNbMatches) const
+{
+  MatchesPerDescType matchesPerDesc;
+
+  for(std::uint64_t i = 0; i < _header.nbPairs; ++i)
+  {
+    const MatchesFilePairEntry& entry = _pairs[i];
+
+    if(!viewsKeysFilter.empty() &&
+       (viewsKeysFilter.find(entry.I) == viewsKeysFilter.end() ||
+        viewsKeysFilter.find(entry.J) == viewsKeysFilter.end()))
+      continue;
+
+    matchesPerDesc.clear();
+    readPair(entry, matchesPerDesc, descTypesFilter, maxNbMatches);
+
+    if(!matchesPerDesc.empty())
+      visitor(Pair(entry.I, entry.J), matchesPerDesc);
+  }
+}
+
+std::string getMatchesShardBasename(int rangeStart)
+{
+  return matchesShardPrefix + std::to_string(rangeStart);
+}
+
+std::vector<std::string> getMatchesShardFiles(const std::string& folder)
+{
+  std::vector<std::string> files;
+  if(!fs::is_directory(folder))
+    return files;
+
+  for(fs::directory_iterator it(folder), end; it != end; ++it)
+  {
+    const std::string filename = it->path().filename().string();
+    if(filename.compare(0, matchesShardPrefix.size(), matchesShardPrefix) == 0 &&
+       it->path().extension() == ".bin")
+      files.push_back(it->path().string());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+void mergeBinaryMatchFiles(const std::vector<std::string>& inputFiles, const std::string& outputFile)
+{
+  std::vector<std::unique_ptr<MatchesFileReader>> readers;
+  readers.reserve(inputFiles.size());
+  for(const std::string& inputFile : inputFiles)
+    readers.emplace_back(new MatchesFileReader(inputFile));
+
+  // output pairs must be sorted, the last file wins for a pair in several files
+  std::map<Pair, std::pair<const MatchesFileReader*, const MatchesFilePairEntry*>> pairEntries;
+  for(const auto& reader : readers)
+  {
+    for(std::uint64_t i = 0; i < reader->_header.nbPairs; ++i)
+    {
+      const MatchesFilePairEntry& entry = reader->_pairs[i];
+      pairEntries[Pair(entry.I, entry.J)] = std::make_pair(reader.get(), &entry);
+    }
+  }
+
+  const fs::path bPath = fs::path(outputFile);
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+  // write temporary file
+  {
+    std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+    if(!stream.is_open())
+      throw std::runtime_error("Can't save matches file, can't open '" + tmpPath + "' !");
+
+    MatchesFileHeader header;
+    std::memset(&header, 0, sizeof(MatchesFileHeader));
+    std::memcpy(header.magic, matchesFileMagic, sizeof(header.magic));
+    header.version = matchesFileVersion;
+
+    // reserve the header, it will be written at the end
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesFileHeader));
+
+    std::vector<MatchesFilePairEntry> pairs;
+    std::vector<MatchesFileBlockEntry> blocks;
+    pairs.reserve(pairEntries.size());
+
+    for(const auto& pairEntry : pairEntries)
+    {
+      const MatchesFileReader& reader = *pairEntry.second.first;
+      const MatchesFilePairEntry& inputEntry = *pairEntry.second.second;
+
+      MatchesFilePairEntry entry = inputEntry;
+      entry.firstBlock = blocks.size();
+      pairs.push_back(entry);
+
+      for(std::uint64_t b = inputEntry.firstBlock; b < inputEntry.firstBlock + inputEntry.nbBlocks; ++b)
+      {
+        MatchesFileBlockEntry block = reader._blocks[b];
+        const char* columns = reader._file.data() + block.offset;
+        block.offset = static_cast<std::uint64_t>(stream.tellp());
+        blocks.push_back(block);
+
+        // copy the I and J columns as is
+        stream.write(columns, 2 * block.nbMatches * sizeof(std::uint32_t));
+      }
+    }
+
+    header.nbPairs = pairs.size();
+    header.pairsOffset = static_cast<std::uint64_t>(stream.tellp());
+    stream.write(reinterpret_cast<const char*>(pairs.data()), pairs.size() * sizeof(MatchesFilePairEntry));
+
+    header.nbBlocks = blocks.size();
+    header.blocksOffset = static_cast<std::uint64_t>(stream.tellp());
+    stream.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(MatchesFileBlockEntry));
+
+    stream.seekp(0);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesFileHeader));
+
+    if(!stream.good())
+      throw std::runtime_error("Can't save matches file, '" + tmpPath + "' is incorrect !");
+  }
+
+  // rename temporary file
+  fs::rename(tmpPath, outputFile);
+}
+
+std::vector<std::string> getBinaryMatchFiles(const std::set<IndexT>& viewsKeys,
+                                             const std::vector<std::string>& folders)
+{
+  std::vector<std::string> files;
+  const std::string fileName = "matches.bin";
+
+  for(const std::string& folder : folders)
+  {
+    const fs::path filePath = fs::path(folder) / fileName;
+
+    if(fs::exists(filePath))
+    {
+      files.push_back(filePath.string());
+      continue;
+    }
+
+    const std::vector<std::string> shardFiles = getMatchesShardFiles(folder);
+    if(!shardFiles.empty())
+    {
+      files.insert(files.end(), shardFiles.begin(), shardFiles.end());
+      continue;
+    }
+
+    for(const IndexT viewId : viewsKeys)
+    {
+      const fs::path viewFilePath = fs::path(folder) / (std::to_string(viewId) + "." + fileName);
+      if(fs::exists(viewFilePath))
+        files.push_back(viewFilePath.string());
+    }
+  }
+  return files;
+}
+
+bool loadBinaryMatchFile(PairwiseMatches& matches,
+                         const std::string& filepath,
+                         const std::set<IndexT>& viewsKeysFilter = std::set<IndexT>(),
+                         const std::vector<feature::EImageDescriberType>& descTypesFilter = std::vector<feature::EImageDescriberType>(),
+                         int maxNbMatches = 0)
+{
+  try
+  {
+    const MatchesFileReader reader(filepath);
+    reader.visitPairs([&matches](const Pair& pair, const MatchesPerDescType& matchesPerDesc)
+      {
+        matches[pair] = matchesPerDesc;
+      }, viewsKeysFilter, descTypesFilter, maxNbMatches);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING(e.what());
+    return false;
+  }
+  return true;
+}
+
 bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
 {
   const std::string ext = fs::extension(filepath);
@@ -70,6 +376,10 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
     stream.close();
     return true;
   }
+  else if(ext == ".bin")
+  {
+    return loadBinaryMatchFile(matches, filepath);
+  }
   else
   {
     ALICEVISION_LOG_WARNING("Unknown matching file format: " << ext);
@@ -78,6 +388,87 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
 }
 
 
+bool saveGeometricModels(const PairGeometricModels& models,
+                         const std::string& folder,
+                         const std::string& basename)
+{
+  const fs::path filepath = fs::path(folder) / (basename + geometricModelsExtension);
+  const std::string tmpPath = (fs::path(folder) / (basename + "." + fs::unique_path().string() + geometricModelsExtension)).string();
+
+  // write temporary file
+  {
+    std::ofstream stream(tmpPath.c_str(), std::ios::out);
+    if(!stream.is_open())
+      return false;
+
+    // I J modelType nbInliers threshold m00 m01 m02 m10 ... m22
+    // (threshold -1: unknown)
+    stream << std::setprecision(17);
+    for(const auto& modelIt : models)
+    {
+      const PairGeometricModel& model = modelIt.second;
+      stream << modelIt.first.first << " " << modelIt.first.second << " "
+             << static_cast<int>(model.type) << " " << model.nbInliers << " "
+             << (std::isfinite(model.threshold) ? model.threshold : -1.0);
+      for(int r = 0; r < 3; ++r)
+        for(int c = 0; c < 3; ++c)
+          stream << " " << model.matrix(r, c);
+      stream << '\n';
+    }
+
+    if(!stream.good())
+      return false;
+  }
+
+  // rename temporary file
+  fs::rename(tmpPath, filepath);
+  return true;
+}
+
+bool loadGeometricModels(PairGeometricModels& models,
+                         const std::vector<std::string>& folders)
+{
+  bool loaded = false;
+
+  for(const std::string& folder : folders)
+  {
+    if(!fs::is_directory(folder))
+      continue;
+
+    // global file and shards
+    for(fs::directory_iterator it(folder), end; it != end; ++it)
+    {
+      const std::string filename = it->path().filename().string();
+      if(filename.compare(0, 7, "matches") != 0 ||
+         filename.size() < geometricModelsExtension.size() ||
+         filename.compare(filename.size() - geometricModelsExtension.size(), geometricModelsExtension.size(), geometricModelsExtension) != 0)
+        continue;
+
+      std::ifstream stream(it->path().string());
+      if(!stream.is_open())
+        continue;
+
+      IndexT I = 0;
+      IndexT J = 0;
+      int type = 0;
+      PairGeometricModel model;
+      while(stream >> I >> J >> type >> model.nbInliers >> model.threshold)
+      {
+        model.type = static_cast<EGeometricModel>(type);
+        if(model.threshold < 0.0)
+          model.threshold = std::numeric_limits<double>::infinity();
+        for(int r = 0; r < 3; ++r)
+          for(int c = 0; c < 3; ++c)
+            stream >> model.matrix(r, c);
+        models[Pair(I, J)] = model;
+      }
+      loaded = true;
+    }
+  }
+  return loaded;
+}
+
+
 void filterMatchesByViews(
   PairwiseMatches & matches,
   const std::set<IndexT> & viewsKeys)
@@ -193,15 +584,38 @@ bool Load(
 {
   bool res = false;
   const std::string fileName = "matches.txt";
+  const std::string binFileName = "matches.bin";
 
   for(const std::string& folder : folders)
   {
     const fs::path filePath = fs::path(folder) / fileName;
+    const fs::path binFilePath = fs::path(folder) / binFileName;
+    const std::vector<std::string> shardFiles = getMatchesShardFiles(folder);
 
-    if(fs::exists(filePath))
+    if(fs::exists(binFilePath))
+    {
+      // filters are applied while reading the binary file
+      res = loadBinaryMatchFile(matches, binFilePath.string(), viewsKeysFilter, descTypesFilter, maxNbMatches);
+    }
+    else if(fs::exists(filePath))
+    {
       res = LoadMatchFile(matches, filePath.string());
+    }
+    else if(!shardFiles.empty())
+    {
+      // shards of a matching split by ranges, not merged yet
+      res = true;
+      for(const std::string& shardFile : shardFiles)
+        res = loadBinaryMatchFile(matches, shardFile, viewsKeysFilter, descTypesFilter, maxNbMatches) && res;
+    }
     else
-      res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, fileName);
+    {
+      const bool hasBinFilePerImage = std::any_of(viewsKeysFilter.begin(), viewsKeysFilter.end(), [&](IndexT viewId)
+        {
+          return fs::exists(fs::path(folder) / (std::to_string(viewId) + "." + binFileName));
+        });
+      res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, hasBinFilePerImage ? binFileName : fileName);
+    }
   }
 
   if(!res)
@@ -267,6 +681,81 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    // write temporary file
+    {
+      std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+      if(!stream.is_open())
+        throw std::runtime_error("Can't save matches file, can't open '" + tmpPath + "' !");
+
+      MatchesFileHeader header;
+      std::memset(&header, 0, sizeof(MatchesFileHeader));
+      std::memcpy(header.magic, matchesFileMagic, sizeof(header.magic));
+      header.version = matchesFileVersion;
+
+      // reserve the header, it will be written at the end
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesFileHeader));
+
+      std::vector<MatchesFilePairEntry> pairs;
+      std::vector<MatchesFileBlockEntry> blocks;
+      std::vector<std::uint32_t> column;
+
+      for(PairwiseMatches::const_iterator match = matchBegin;
+        match != matchEnd;
+        ++match)
+      {
+        MatchesFilePairEntry pairEntry;
+        pairEntry.I = match->first.first;
+        pairEntry.J = match->first.second;
+        pairEntry.firstBlock = blocks.size();
+        pairEntry.nbBlocks = match->second.size();
+        pairs.push_back(pairEntry);
+
+        for(const auto& m: match->second)
+        {
+          MatchesFileBlockEntry blockEntry;
+          blockEntry.describerType = static_cast<std::uint32_t>(m.first);
+          blockEntry.reserved = 0;
+          blockEntry.nbMatches = m.second.size();
+          blockEntry.offset = static_cast<std::uint64_t>(stream.tellp());
+          blocks.push_back(blockEntry);
+
+          column.resize(2 * m.second.size());
+          for(std::size_t i = 0; i < m.second.size(); ++i)
+          {
+            column[i] = m.second[i]._i;
+            column[m.second.size() + i] = m.second[i]._j;
+          }
+          stream.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(std::uint32_t));
+        }
+      }
+
+      header.nbPairs = pairs.size();
+      header.pairsOffset = static_cast<std::uint64_t>(stream.tellp());
+      stream.write(reinterpret_cast<const char*>(pairs.data()), pairs.size() * sizeof(MatchesFilePairEntry));
+
+      header.nbBlocks = blocks.size();
+      header.blocksOffset = static_cast<std::uint64_t>(stream.tellp());
+      stream.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(MatchesFileBlockEntry));
+
+      stream.seekp(0);
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesFileHeader));
+
+      if(!stream.good())
+        throw std::runtime_error("Can't save matches file, '" + tmpPath + "' is incorrect !");
+    }
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
@@ -287,6 +776,8 @@ public:
 
     if(m_ext == ".txt")
       saveTxt(filepath, m_matches.begin(), m_matches.end());
+    else if(m_ext == ".bin")
+      saveBin(filepath, m_matches.begin(), m_matches.end());
     else
       throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
   }
@@ -312,6 +803,8 @@ public:
       
       if(m_ext == ".txt")
         saveTxt(filepath, matchBegin, match);
+      else if(m_ext == ".bin")
+        saveBin(filepath, matchBegin, match);
       else
         throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
 
@@ -331,9 +824,10 @@ bool Save(
   const PairwiseMatches & matches,
   const std::string & folder,
   const std::string & extension,
-  bool matchFilePerImage)
+  bool matchFilePerImage,
+  const std::string& basename)
 {
-  const std::string filename = "matches." + extension;
+  const std::string filename = basename + "." + extension;
   MatchExporter exporter(matches, folder, filename);
 
   if(matchFilePerImage)
@@ -8,13 +8,161 @@
 #pragma once
 
 #include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/matching/GeometricModel.hpp>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
 
-  
+/**
+ * @brief Binary matches file layout (version 1, native little-endian):
+ *
+ *   MatchesFileHeader
+ *   for each pair and each describer type: I feature indexes column, J feature indexes column (uint32)
+ *   MatchesFilePairEntry * header.nbPairs (sorted by pair)
+ *   MatchesFileBlockEntry * header.nbBlocks
+ */
+struct MatchesFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+  std::uint64_t nbPairs;
+  std::uint64_t nbBlocks;
+  std::uint64_t pairsOffset;
+  std::uint64_t blocksOffset;
+};
+
+/**
+ * @brief Index table entry of an image pair in a binary matches file
+ */
+struct MatchesFilePairEntry
+{
+  std::uint32_t I;
+  std::uint32_t J;
+  std::uint64_t firstBlock;
+  std::uint64_t nbBlocks;
+};
+
+/**
+ * @brief Matches of one describer type of an image pair in a binary matches file
+ */
+struct MatchesFileBlockEntry
+{
+  std::uint32_t describerType;
+  std::uint32_t reserved;
+  std::uint64_t nbMatches;
+  std::uint64_t offset;
+};
+
+/**
+ * @brief Read a binary matches file (*.bin) from a memory mapping,
+ *        with random access to an image pair and streaming iteration over all the pairs.
+ */
+class MatchesFileReader
+{
+public:
+
+  /// Callback used to visit image pair matches
+  typedef std::function<void(const Pair&, const MatchesPerDescType&)> PairVisitor;
+
+  /**
+   * @brief MatchesFileReader constructor
+   * @param[in] filepath The binary matches file path
+   * @throw std::runtime_error if the file is not valid
+   */
+  explicit MatchesFileReader(const std::string& filepath);
+
+  /// Return the number of image pairs stored in the file
+  std::size_t getNbPairs() const { return static_cast<std::size_t>(_header.nbPairs); }
+
+  /// Return the image pairs stored in the file
+  PairSet getPairs() const;
+
+  /// Return true if the file stores matches for the given image pair
+  bool hasPair(const Pair& pair) const { return findPair(pair) != nullptr; }
+
+  /**
+   * @brief Load the matches of one image pair.
+   * @param[in] pair The image pair
+   * @param[out] matchesPerDesc The matches of the pair
+   * @param[in] descTypesFilter Load only these describer types (all if empty)
+   * @param[in] maxNbMatches Load only the N first matches for each describer type (all if 0)
+   * @return false if the pair is not in the file
+   */
+  bool loadPair(const Pair& pair,
+                MatchesPerDescType& matchesPerDesc,
+                const std::vector<feature::EImageDescriberType>& descTypesFilter = std::vector<feature::EImageDescriberType>(),
+                int maxNbMatches = 0) const;
+
+  /**
+   * @brief Visit the image pairs one by one, without loading all the matches in memory.
+   * @param[in] visitor The callback called for each image pair
+   * @param[in] viewsKeysFilter Visit only pairs with both views in this set (all if empty)
+   * @param[in] descTypesFilter Visit only these describer types (all if empty)
+   * @param[in] maxNbMatches Visit only the N first matches for each describer type (all if 0)
+   */
+  void visitPairs(const PairVisitor& visitor,
+                  const std::set<IndexT>& viewsKeysFilter = std::set<IndexT>(),
+                  const std::vector<feature::EImageDescriberType>& descTypesFilter = std::vector<feature::EImageDescriberType>(),
+                  int maxNbMatches = 0) const;
+
+private:
+  friend void mergeBinaryMatchFiles(const std::vector<std::string>& inputFiles, const std::string& outputFile);
+
+  const MatchesFilePairEntry* findPair(const Pair& pair) const;
+  void readPair(const MatchesFilePairEntry& entry,
+                MatchesPerDescType& matchesPerDesc,
+                const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                int maxNbMatches) const;
+
+  std::string _filepath;
+  boost::iostreams::mapped_file_source _file;
+  MatchesFileHeader _header;
+  const MatchesFilePairEntry* _pairs = nullptr;
+  const MatchesFileBlockEntry* _blocks = nullptr;
+};
+
+/**
+ * @brief Get the base name (without the .bin extension) of the binary matches shard of a range of image pairs.
+ *        Each chunk of a matching job split by ranges writes its own shard, merged afterwards.
+ * @param[in] rangeStart The first index of the range
+ * @return the shard base name
+ */
+std::string getMatchesShardBasename(int rangeStart);
+
+/**
+ * @brief Find the binary matches shards in a folder.
+ * @param[in] folder The folder containing the shards
+ * @return the shard file paths, sorted
+ */
+std::vector<std::string> getMatchesShardFiles(const std::string& folder);
+
+/**
+ * @brief Merge binary matches files in a single one.
+ *        The match columns are copied without being decoded,
+ *        if an image pair is in several files the last one is kept.
+ * @param[in] inputFiles The binary matches files to merge
+ * @param[in] outputFile The merged binary matches file
+ * @throw std::runtime_error if an input file is not valid or the output file can't be written
+ */
+void mergeBinaryMatchFiles(const std::vector<std::string>& inputFiles, const std::string& outputFile);
+
+/**
+ * @brief Find the binary matches files (global file, shards or one file per image) in the given folders.
+ * @param[in] viewsKeys The views used to look for files per image
+ * @param[in] folders The folders containing the match files
+ * @return the binary matches file paths (empty if there is no binary matches file)
+ */
+std::vector<std::string> getBinaryMatchFiles(const std::set<IndexT>& viewsKeys,
+                                             const std::vector<std::string>& folders);
+
 /**
  * @brief Load a match file.
  *
@@ -52,6 +200,25 @@ bool Load(PairwiseMatches& matches,
   const std::vector<feature::EImageDescriberType>& descTypesFilter,
   const int maxNbMatches = 0);
 
+/**
+ * @brief Save the geometric models of the image pairs (<basename>.models.txt), next to their matches.
+ * @param[in] models The geometric models of the image pairs
+ * @param[in] folder The folder of the match files
+ * @param[in] basename The base name of the match files (see getMatchesShardBasename)
+ */
+bool saveGeometricModels(const PairGeometricModels& models,
+                         const std::string& folder,
+                         const std::string& basename = "matches");
+
+/**
+ * @brief Load the geometric models of the image pairs saved with the matches (shards included).
+ * @param[out] models The geometric models of the image pairs
+ * @param[in] folders The folders of the match files
+ * @return false if no geometric models file was found
+ */
+bool loadGeometricModels(PairGeometricModels& models,
+                         const std::vector<std::string>& folders);
+
 /**
  * @brief Filter to keep only specific viewIds.
  */
@@ -73,14 +240,17 @@ void filterTopMatches(
  * @param[in] sfm_data
  * @param[in] folder: folder containing the match files
  * @param[in] extension: txt or bin file format
+ *            (bin: one index table and columnar IndMatch arrays, see MatchesFileReader)
  * @param[in] matchFilePerImage: do we store a global match file
  *            or one match file per image
+ * @param[in] basename: base name of the match files (see getMatchesShardBasename)
  */
 bool Save(
   const PairwiseMatches& matches,
   const std::string& folder,
   const std::string& extension,
-  bool matchFilePerImage);
+  bool matchFilePerImage,
+  const std::string& basename = "matches");
 
 }  // namespace matching
 }  // namespace aliceVision
@@ -15,6 +15,7 @@
 
 #include "kvld.h"
 #include "algorithm.h"
+#include <algorithm>
 #include <functional>
 #include <numeric>
 #include <aliceVision/image/all.hpp>
@@ -198,16 +199,158 @@ VLD::VLD( const ImageScale& series, T const& P1, T const& P2 ) : contrast( 0.0 )
   normalize_weight( weight );
 }
 
-float KVLD( const Image< float >& I1,
-            const Image< float >& I2,
-            const std::vector<feature::SIOPointFeature> & F1,
-            const std::vector<feature::SIOPointFeature> & F2,
-            const vector< Pair >& matches,
-            vector< Pair >& matchesFiltered,
-            vector< double >& score,
-            aliceVision::Mat& E,
-            vector< bool >& valide,
-            KvldParameters& kvldParameters )
+namespace {
+
+//====== Uniform grid over the positions of the matches in one image, to find the nearest matches ======//
+class MatchesGrid
+{
+public:
+  MatchesGrid( const std::vector< Vec2f >& points, size_t nbPerCell ) : _points( points )
+  {
+    _min = _max = points.empty() ? Vec2f( 0.f, 0.f ) : points.front();
+    for( const Vec2f& p : points )
+    {
+      _min = _min.cwiseMin( p );
+      _max = _max.cwiseMax( p );
+    }
+    // about nbPerCell points per cell if they are uniformly distributed
+    const Vec2f extent = _max - _min;
+    const float area = max( extent.x(), 1.f ) * max( extent.y(), 1.f );
+    _cellSize = max( 1.f, sqrt( area * float( nbPerCell ) / float( max( points.size(), size_t( 1 ) ) ) ) );
+    _width  = int( extent.x() / _cellSize ) + 1;
+    _height = int( extent.y() / _cellSize ) + 1;
+
+    // counting sort of the points by cell
+    _cellStart.assign( _width * _height + 1, 0 );
+    for( const Vec2f& p : points )
+      ++_cellStart[ cellIndex( cellX( p ), cellY( p ) ) + 1 ];
+    partial_sum( _cellStart.begin(), _cellStart.end(), _cellStart.begin() );
+    _indexes.resize( points.size() );
+    vector< int > cellFill( _cellStart.begin(), _cellStart.end() - 1 );
+    for( int i = 0; i < int( points.size() ); ++i )
+      _indexes[ cellFill[ cellIndex( cellX( points[ i ] ), cellY( points[ i ] ) ) ]++ ] = i;
+  }
+
+  // append to neighbors the k nearest points of the ith point, with a distance in ]minDist, maxDist[
+  void kNearest( int i, size_t k, float minDist, float maxDist, vector< int >& neighbors ) const
+  {
+    const Vec2f& p = _points[ i ];
+    const int cx = cellX( p );
+    const int cy = cellY( p );
+    // max-heap of the k nearest (distance, index)
+    vector< pair< float, int > > heap;
+
+    const auto visitCell = [&]( int x, int y )
+    {
+      if( x < 0 || y < 0 || x >= _width || y >= _height )
+        return;
+      const int cell = cellIndex( x, y );
+      for( int c = _cellStart[ cell ]; c < _cellStart[ cell + 1 ]; ++c )
+      {
+        const int j = _indexes[ c ];
+        const float d = ( _points[ j ] - p ).norm();
+        if( j == i || d <= minDist || d >= maxDist )
+          continue;
+        if( heap.size() < k )
+        {
+          heap.emplace_back( d, j );
+          push_heap( heap.begin(), heap.end() );
+        }
+        else if( d < heap.front().first )
+        {
+          pop_heap( heap.begin(), heap.end() );
+          heap.back() = make_pair( d, j );
+          push_heap( heap.begin(), heap.end() );
+        }
+      }
+    };
+
+    const int maxRing = max( _width, _height );
+    for( int r = 0; r <= maxRing; ++r )
+    {
+      // the points of the ring r are at least (r - 1) cells away
+      const float ringDist = float( r - 1 ) * _cellSize;
+      if( ringDist >= maxDist || ( heap.size() == k && heap.front().first <= ringDist ) )
+        break;
+      if( r == 0 )
+      {
+        visitCell( cx, cy );
+        continue;
+      }
+      for( int x = cx - r; x <= cx + r; ++x )
+      {
+        visitCell( x, cy - r );
+        visitCell( x, cy + r );
+      }
+      for( int y = cy - r + 1; y <= cy + r - 1; ++y )
+      {
+        visitCell( cx - r, y );
+        visitCell( cx + r, y );
+      }
+    }
+
+    for( const auto& neighbor : heap )
+      neighbors.push_back( neighbor.second );
+  }
+
+private:
+  inline int cellX( const Vec2f& p ) const { return min( _width - 1, int( ( p.x() - _min.x() ) / _cellSize ) ); }
+  inline int cellY( const Vec2f& p ) const { return min( _height - 1, int( ( p.y() - _min.y() ) / _cellSize ) ); }
+  inline int cellIndex( int x, int y ) const { return y * _width + x; }
+
+  const std::vector< Vec2f >& _points;
+  Vec2f _min, _max;
+  float _cellSize;
+  int _width, _height;
+  vector< int > _cellStart;
+  vector< int > _indexes;
+};
+
+// whether two matches are multiple matches to a same point
+inline bool isMultipleMatch( const std::vector<feature::SIOPointFeature> & F1,
+                             const std::vector<feature::SIOPointFeature> & F2,
+                             const Pair& m1, const Pair& m2 )
+{
+  const size_t a1 = m1.first, b1 = m1.second;
+  const size_t a2 = m2.first, b2 = m2.second;
+
+  return ( a1 == a2 || b1 == b2
+           || ( F1[ a1 ].x() == F1[ a2 ].x() && F1[ a1 ].y() == F1[ a2 ].y() &&
+              ( F2[ b1 ].x() != F2[ b2 ].x() || F2[ b1 ].y() != F2[ b2 ].y() ) )
+           || ( ( F1[ a1 ].x() != F1[ a2 ].x() || F1[ a1 ].y() != F1[ a2 ].y() ) &&
+                  F2[ b1 ].x() == F2[ b2 ].x() && F2[ b1 ].y() == F2[ b2 ].y() ) );
+}
+
+// add the multiple matches among the matches with the same key, keys are (key, match index)
+template< typename Key, typename IsConflict >
+void addConflicts( vector< pair< Key, int > >& keys, const IsConflict& isConflict, vector< vector< int > >& conflicts )
+{
+  sort( keys.begin(), keys.end() );
+  size_t begin = 0;
+  while( begin < keys.size() )
+  {
+    size_t end = begin + 1;
+    while( end < keys.size() && keys[ end ].first == keys[ begin ].first )
+      ++end;
+    // sorted by match index in the group
+    for( size_t i = begin; i < end; ++i )
+      for( size_t j = i + 1; j < end; ++j )
+        if( isConflict( keys[ i ].second, keys[ j ].second ) )
+          conflicts[ keys[ i ].second ].push_back( keys[ j ].second );
+    begin = end;
+  }
+}
+
+float KVLDImpl( const Image< float >& I1,
+                const Image< float >& I2,
+                const std::vector<feature::SIOPointFeature> & F1,
+                const std::vector<feature::SIOPointFeature> & F2,
+                const vector< Pair >& matches,
+                vector< Pair >& matchesFiltered,
+                vector< double >& score,
+                aliceVision::Mat* E,
+                vector< bool >& valide,
+                KvldParameters& kvldParameters )
 {
   matchesFiltered.clear();
   score.clear();
@@ -219,26 +362,106 @@ float KVLD( const Image< float >& I1,
   const float range1 = getRange( I1, min( F1.size(), matches.size() ), kvldParameters.inlierRate );
   const float range2 = getRange( I2, min( F2.size(), matches.size() ), kvldParameters.inlierRate );
 
-  const size_t size = matches.size();
+  const int size = int( matches.size() );
+
+  vector< Vec2f > points1( size ), points2( size );
+  for( int it = 0; it < size; ++it )
+  {
+    points1[ it ] = F1[ matches[ it ].first ].coords();
+    points2[ it ] = F2[ matches[ it ].second ].coords();
+  }
 
-  //================distance map construction, foruse of selecting neighbors===============//
-  cout << "computing distance maps" << endl;
+  // the neighbors of a match are the matches in range, they don't change during the iterations
+  const auto isNeighbor = [&]( int it1, int it2 )
+  {
+    const float d1 = ( points1[ it1 ] - points1[ it2 ] ).norm();
+    const float d2 = ( points2[ it1 ] - points2[ it2 ] ).norm();
+    return d1 > min_dist && d2 > min_dist && ( d1 < range1 || d2 < range2 );
+  };
 
-  bool bPrecomputedDist = false;
+  //================neighbors construction (sorted indexes, symmetric)===============//
+  cout << "computing neighbors" << endl;
 
-  aliceVision::Matf dist1, dist2;
-  if( bPrecomputedDist )
+  vector< vector< int > > neighbors( size );
+  if( kvldParameters.maxNeighbors == 0 )
+  {
+    #pragma omp parallel for schedule(dynamic)
+    for( int it1 = 0; it1 < size; ++it1 )
+      for( int it2 = 0; it2 < size; ++it2 )
+        if( it1 != it2 && isNeighbor( it1, it2 ) )
+          neighbors[ it1 ].push_back( it2 );
+  }
+  else
   {
-    dist1 = aliceVision::Matf::Zero( F1.size(), F1.size() );
-    dist2 = aliceVision::Matf::Zero( F2.size(), F2.size() );
+    // nearest matches in each image
+    const MatchesGrid grid1( points1, kvldParameters.maxNeighbors );
+    const MatchesGrid grid2( points2, kvldParameters.maxNeighbors );
 
-    for( int a1 = 0; a1 < F1.size(); ++a1 )
-      for( int a2 = a1; a2 < F1.size(); ++a2 )
-        dist1( a1, a2 ) = dist1( a2, a1 ) = point_distance( F1[ a1 ], F1[ a2 ] );
+    vector< vector< int > > nearest( size );
+    #pragma omp parallel for
+    for( int it1 = 0; it1 < size; ++it1 )
+    {
+      vector< int >& candidates = nearest[ it1 ];
+      grid1.kNearest( it1, kvldParameters.maxNeighbors, min_dist, range1, candidates );
+      grid2.kNearest( it1, kvldParameters.maxNeighbors, min_dist, range2, candidates );
+      candidates.erase( remove_if( candidates.begin(), candidates.end(),
+                                   [&]( int it2 ){ return !isNeighbor( it1, it2 ); } ), candidates.end() );
+    }
 
-    for( int b1 = 0; b1 < F2.size(); ++b1 )
-      for( int b2 = b1; b2 < F2.size(); ++b2 )
-        dist2( b1, b2 ) = dist2( b2, b1 ) = point_distance( F2[ b1 ], F2[ b2 ] );
+    for( int it1 = 0; it1 < size; ++it1 )
+      for( int it2 : nearest[ it1 ] )
+      {
+        neighbors[ it1 ].push_back( it2 );
+        neighbors[ it2 ].push_back( it1 );
+      }
+
+    #pragma omp parallel for
+    for( int it = 0; it < size; ++it )
+    {
+      sort( neighbors[ it ].begin(), neighbors[ it ].end() );
+      neighbors[ it ].erase( unique( neighbors[ it ].begin(), neighbors[ it ].end() ), neighbors[ it ].end() );
+    }
+  }
+
+  // gvld-consistency of the lines to the neighbors with a greater index: >0 consistency value, -1=unknow, -2=false
+  vector< int > firstUpper( size );
+  vector< vector< float > > lineErrors( size );
+  for( int it1 = 0; it1 < size; ++it1 )
+  {
+    firstUpper[ it1 ] = int( upper_bound( neighbors[ it1 ].begin(), neighbors[ it1 ].end(), it1 ) - neighbors[ it1 ].begin() );
+    lineErrors[ it1 ].resize( neighbors[ it1 ].size(), -1.f );
+    if( E != nullptr )
+      for( size_t n = firstUpper[ it1 ]; n < neighbors[ it1 ].size(); ++n )
+        lineErrors[ it1 ][ n ] = float( ( *E )( it1, neighbors[ it1 ][ n ] ) );
+  }
+
+  //================multiple matches to a same point, for each match the ones with a greater index===============//
+  vector< vector< int > > conflicts( size );
+  if( uniqueMatch )
+  {
+    const auto isConflict = [&]( int it1, int it2 ){ return isMultipleMatch( F1, F2, matches[ it1 ], matches[ it2 ] ); };
+
+    vector< pair< size_t, int > > indexKeys( size );
+    for( int it = 0; it < size; ++it )
+      indexKeys[ it ] = make_pair( matches[ it ].first, it );
+    addConflicts( indexKeys, isConflict, conflicts );
+    for( int it = 0; it < size; ++it )
+      indexKeys[ it ] = make_pair( matches[ it ].second, it );
+    addConflicts( indexKeys, isConflict, conflicts );
+
+    vector< pair< pair< float, float >, int > > pointKeys( size );
+    for( int it = 0; it < size; ++it )
+      pointKeys[ it ] = make_pair( make_pair( points1[ it ].x(), points1[ it ].y() ), it );
+    addConflicts( pointKeys, isConflict, conflicts );
+    for( int it = 0; it < size; ++it )
+      pointKeys[ it ] = make_pair( make_pair( points2[ it ].x(), points2[ it ].y() ), it );
+    addConflicts( pointKeys, isConflict, conflicts );
+
+    for( int it = 0; it < size; ++it )
+    {
+      sort( conflicts[ it ].begin(), conflicts[ it ].end() );
+      conflicts[ it ].erase( unique( conflicts[ it ].begin(), conflicts[ it ].end() ), conflicts[ it ].end() );
+    }
   }
 
   fill( valide.begin(), valide.end(), true );
@@ -257,57 +480,56 @@ float KVLD( const Image< float >& I1,
     fill( scoretable.begin(), scoretable.end(), 0.0 );
     fill( result.begin(), result.end(), 0 );
     //========substep 1: search foreach match its neighbors and verify if they are gvld-consistent ============//
-    for( int it1 = 0; it1 < size - 1; it1++ )
+    // the unknown lines between valid matches are verified in parallel
+    #pragma omp parallel for schedule(dynamic)
+    for( int it1 = 0; it1 < size; it1++ )
     {
-      if( valide[ it1 ] )
-      {
-        size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+      if( !valide[ it1 ] )
+        continue;
+      const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
 
-        for( int it2 = it1 + 1; it2 < size; it2++ )
-          if(valide[ it2 ])
-          {
-            size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
-
-            bool bOk = false;
-            if( bPrecomputedDist )
-              bOk = ( dist1( a1, a2 ) > min_dist && dist2( b1, b2 ) > min_dist
-                 && ( dist1( a1, a2 ) < range1   || dist2( b1, b2 ) < range2 ) );
-            else
-              bOk = ( point_distance( F1[ a1 ], F1[ a2 ] ) > min_dist && point_distance( F2[ b1 ], F2[ b2 ] ) > min_dist &&
-                    ( point_distance( F1[ a1 ], F1[ a2 ] ) < range1   || point_distance( F2[ b1 ], F2[ b2 ] ) < range2 ) );
-            if( bOk )
-            {
-              if( E( it1, it2 ) == -1 )
-              { //update E ifunknow
-                E( it1, it2 ) = -2;
-                E( it2, it1 ) = -2;
+      for( size_t n = firstUpper[ it1 ]; n < neighbors[ it1 ].size(); ++n )
+      {
+        const int it2 = neighbors[ it1 ][ n ];
+        float& error = lineErrors[ it1 ][ n ];
+        if( !valide[ it2 ] || error != -1 )
+          continue;
+
+        const size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
+        error = -2;
+        if( !kvldParameters.geometry || consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] ) < distance_thres )
+        {
+          VLD vld1( Chaine1, F1[ a1 ], F1[ a2 ] );
+          VLD vld2( Chaine2, F2[ b1 ], F2[ b2 ] );
+          const double difference = vld1.difference( vld2 );
+          if( difference < juge )
+            error = float( difference );
+        }
+        if( E != nullptr )
+        {
+          ( *E )( it1, it2 ) = error;
+          ( *E )( it2, it1 ) = error;
+        }
+      }
+    }
 
-                if( !kvldParameters.geometry || consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] ) < distance_thres )
-                {
-                  VLD vld1( Chaine1, F1[ a1 ], F1[ a2 ] );
-                  VLD vld2( Chaine2, F2[ b1 ], F2[ b2 ] );
-                  //vld1.test();
-                  double error = vld1.difference( vld2 );
-                  //cout<<endl<<it1<<" "<<it2<<" "<<dist1(a1,a2)<<" "<< dist2(b1,b2)<<" "<<error<<endl;
-                  if( error < juge )
-                  {
-                    E( it1, it2 ) = ( float ) error;
-                    E( it2, it1 ) = ( float ) error;
-                    //cout<<E(it2,it1)<<endl;
-                  }
-                }
-              }
-              if( E( it1, it2 ) >= 0 )
-              {
-                result[ it1 ] += 1;
-                result[ it2 ] += 1;
-                scoretable[ it1 ] += double( E( it1, it2 ) );
-                scoretable[ it2 ] += double( E( it1, it2 ) );
-                if( result[ it1 ] >= max_connection )
-                  break;
-              }
-            }
-          }
+    for( int it1 = 0; it1 + 1 < size; it1++ )
+    {
+      if( !valide[ it1 ] )
+        continue;
+      for( size_t n = firstUpper[ it1 ]; n < neighbors[ it1 ].size(); ++n )
+      {
+        const int it2 = neighbors[ it1 ][ n ];
+        const float error = lineErrors[ it1 ][ n ];
+        if( valide[ it2 ] && error >= 0 )
+        {
+          result[ it1 ] += 1;
+          result[ it2 ] += 1;
+          scoretable[ it1 ] += double( error );
+          scoretable[ it2 ] += double( error );
+          if( result[ it1 ] >= max_connection )
+            break;
+        }
       }
     }
 
@@ -322,47 +544,35 @@ float KVLD( const Image< float >& I1,
     }
     //========substep 3: remove multiple matches to a same point by keeping the one with the best average gvld-consistency score ============//
     if( uniqueMatch )
-      for( int it1 = 0; it1 < size - 1; it1++ )
-        if( valide[ it1 ]) {
-          size_t a1 = matches[ it1 ].first;
-          size_t b1 = matches[ it1 ].second;
-
-          for( int it2 = it1 + 1; it2 < size; it2++ )
+      for( int it1 = 0; it1 + 1 < size; it1++ )
+        if( valide[ it1 ] )
+        {
+          for( int it2 : conflicts[ it1 ] )
             if( valide[ it2 ] )
             {
-              size_t a2 = matches[ it2 ].first;
-              size_t b2 = matches[ it2 ].second;
-
-              if( a1 == a2 || b1 == b2
-                  || ( F1[ a1 ].x() == F1[ a2 ].x() && F1[ a1 ].y() == F1[ a2 ].y() &&
-                     ( F2[ b1 ].x() != F2[ b2 ].x() || F2[ b1 ].y() != F2[ b2 ].y() ) )
-                  || ( ( F1[ a1 ].x() != F1[ a2 ].x() || F1[ a1 ].y() != F1[ a2 ].y() ) &&
-                         F2[ b1 ].x() == F2[ b2 ].x() && F2[ b1 ].y() == F2[ b2 ].y() ) )
+              //cardinal comparison
+              if( result[ it1 ] > result[ it2 ] )
               {
-                //cardinal comparison
-                if( result[ it1 ] > result[ it2 ] )
-                {
-                  valide[ it2 ] = false;
-                  change = true;
-                }
-                else if( result[ it1 ] < result[ it2 ] )
+                valide[ it2 ] = false;
+                change = true;
+              }
+              else if( result[ it1 ] < result[ it2 ] )
+              {
+                valide[ it1 ] = false;
+                change = true;
+              }
+              else if( result[ it1 ] == result[ it2 ] )
+              {
+                //score comparison
+                if( scoretable[ it1 ] > scoretable[ it2 ] )
                 {
                   valide[ it1 ] = false;
                   change = true;
                 }
-                else if( result[ it1 ] == result[ it2 ] )
+                else if( scoretable[ it1 ] < scoretable[ it2 ] )
                 {
-                  //score comparison
-                  if( scoretable[ it1 ] > scoretable[ it2 ] )
-                  {
-                    valide[ it1 ] = false;
-                    change = true;
-                  }
-                  else if( scoretable[ it1 ] < scoretable[ it2 ] )
-                  {
-                    valide[ it2 ] = false;
-                    change = true;
-                  }
+                  valide[ it2 ] = false;
+                  change = true;
                 }
               }
             }
@@ -370,55 +580,42 @@ float KVLD( const Image< float >& I1,
     //========substep 4: ifgeometric verification is set, re-score matches by geometric-consistency, and remove poorly scored ones ============================//
     if( uniqueMatch && kvldParameters.geometry )
     {
-      for( int i = 0; i < size; i++ )
-        scoretable[ i ]=0;
-
-      vector< bool > switching;
-      for( int i = 0; i < size; i++ )
-        switching.push_back( false );
+      fill( scoretable.begin(), scoretable.end(), 0.0 );
+      vector< char > switching( size, false );
 
+      #pragma omp parallel for schedule(dynamic)
       for( int it1 = 0; it1 < size; it1++ )
       {
         if( valide[ it1 ] )
         {
-          size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+          const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
           float index = 0.0f;
           int good_index = 0;
-          for( int it2 = 0; it2 < size; it2++ )
+          for( int it2 : neighbors[ it1 ] )
           {
-            if( it1 != it2 && valide[ it2 ] )
+            if( valide[ it2 ] )
             {
-              size_t a2 = matches[ it2 ].first;
-              size_t b2 = matches[ it2 ].second;
-
-              bool bOk = false;
-              if( bPrecomputedDist )
-                bOk = ( dist1( a1, a2 ) > min_dist && dist2( b1, b2 ) > min_dist &&
-                      ( dist1( a1, a2 ) < range1   || dist2( b1, b2 ) < range2 ) );
-              else
-                bOk = ( point_distance( F1[ a1 ], F1[ a2 ] ) > min_dist && point_distance( F2[ b1 ], F2[ b2 ] ) > min_dist &&
-                      ( point_distance( F1[ a1 ], F1[ a2 ] ) < range1   || point_distance( F2[ b1 ], F2[ b2 ] ) < range2 ) );
-              if( bOk )
-              {
-                float d = consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] );
-                scoretable[ it1 ] += d;
-                index += 1;
-                if( d < distance_thres )
-                  good_index++;
-              }
+              const size_t a2 = matches[ it2 ].first;
+              const size_t b2 = matches[ it2 ].second;
+
+              const float d = consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] );
+              scoretable[ it1 ] += d;
+              index += 1;
+              if( d < distance_thres )
+                good_index++;
             }
           }
           scoretable[ it1 ] /= index;
           if( good_index < 0.3f * float( index ) && scoretable[ it1 ] > 1.2 )
-          {
             switching[ it1 ] = true;
-            change = true;
-          }
         }
       }
       for( int it1 = 0; it1 < size; it1++ )
         if( switching[ it1 ] )
+        {
           valide[ it1 ] = false;
+          change = true;
+        }
     }
   }
   //=============== generating output list ===================//
@@ -431,3 +628,31 @@ float KVLD( const Image< float >& I1,
   return float( matchesFiltered.size() ) / matches.size();
 }
 
+} // namespace
+
+float KVLD( const Image< float >& I1,
+            const Image< float >& I2,
+            const std::vector<feature::SIOPointFeature> & F1,
+            const std::vector<feature::SIOPointFeature> & F2,
+            const vector< Pair >& matches,
+            vector< Pair >& matchesFiltered,
+            vector< double >& score,
+            aliceVision::Mat& E,
+            vector< bool >& valide,
+            KvldParameters& kvldParameters )
+{
+  return KVLDImpl( I1, I2, F1, F2, matches, matchesFiltered, score, &E, valide, kvldParameters );
+}
+
+float KVLD( const Image< float >& I1,
+            const Image< float >& I2,
+            const std::vector<feature::SIOPointFeature> & F1,
+            const std::vector<feature::SIOPointFeature> & F2,
+            const vector< Pair >& matches,
+            vector< Pair >& matchesFiltered,
+            vector< double >& score,
+            vector< bool >& valide,
+            KvldParameters& kvldParameters )
+{
+  return KVLDImpl( I1, I2, F1, F2, matches, matchesFiltered, score, nullptr, valide, kvldParameters );
+}
@@ -44,12 +44,15 @@
 // K: the minimum number of gvld-consistent (or vld-consistent) neighbors to select a match as correct one
 // geometry: if true, KVLD will also take geometric verification into account. c.f. paper
 //           if false, KVLD execute a pure photometric verification
+// maxNeighbors: if not 0, each match is only verified with its maxNeighbors nearest matches in each image (found with a grid),
+//               instead of all the matches in range. It bounds the number of VLD lines to verify for large sets of putative matches.
 struct KvldParameters
 {
   float inlierRate;
   size_t K;
   bool geometry;
-  KvldParameters(): inlierRate( 0.04 ), K( 3 ), geometry( true ){};
+  size_t maxNeighbors;
+  KvldParameters(): inlierRate( 0.04 ), K( 3 ), geometry( true ), maxNeighbors( 0 ){};
 };
 
 //====== Pyramid of scale images ======//
@@ -174,4 +177,15 @@ float KVLD(const aliceVision::image::Image< float >& I1,
   std::vector< bool >& valide,
   KvldParameters& kvldParameters );
 
+//KVLD without the gvld-consistency matrix output, the consistency of the verified lines is only kept during the call
+float KVLD(const aliceVision::image::Image< float >& I1,
+  const aliceVision::image::Image< float >& I2,
+  const std::vector<aliceVision::feature::SIOPointFeature> & F1,
+  const std::vector<aliceVision::feature::SIOPointFeature> & F2,
+  const std::vector< aliceVision::Pair >& matches,
+  std::vector< aliceVision::Pair >& matchesFiltered,
+  std::vector< double >& score,
+  std::vector< bool >& valide,
+  KvldParameters& kvldParameters );
+
 #endif //KVLD_H
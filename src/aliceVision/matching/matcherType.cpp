@@ -21,6 +21,10 @@ std::string EMatcherType_enumToString(EMatcherType matcherType)
     case EMatcherType::CASCADE_HASHING_L2:      return "CASCADE_HASHING_L2";
     case EMatcherType::FAST_CASCADE_HASHING_L2: return "FAST_CASCADE_HASHING_L2";
     case EMatcherType::BRUTE_FORCE_HAMMING:     return "BRUTE_FORCE_HAMMING";
+    case EMatcherType::BLOCKED_BRUTE_FORCE_L2:  return "BLOCKED_BRUTE_FORCE_L2";
+    case EMatcherType::CUDA_BRUTE_FORCE_L2:     return "CUDA_BRUTE_FORCE_L2";
+    case EMatcherType::HNSW_L2:                 return "HNSW_L2";
+    case EMatcherType::HNSW_HAMMING:            return "HNSW_HAMMING";
   }
   throw std::out_of_range("Invalid matcherType enum");
 }
@@ -32,6 +36,10 @@ EMatcherType EMatcherType_stringToEnum(const std::string& matcherType)
   if(matcherType == "CASCADE_HASHING_L2")       return EMatcherType::CASCADE_HASHING_L2;
   if(matcherType == "FAST_CASCADE_HASHING_L2")  return EMatcherType::FAST_CASCADE_HASHING_L2;
   if(matcherType == "BRUTE_FORCE_HAMMING")      return EMatcherType::BRUTE_FORCE_HAMMING;
+  if(matcherType == "BLOCKED_BRUTE_FORCE_L2")   return EMatcherType::BLOCKED_BRUTE_FORCE_L2;
+  if(matcherType == "CUDA_BRUTE_FORCE_L2")      return EMatcherType::CUDA_BRUTE_FORCE_L2;
+  if(matcherType == "HNSW_L2")                  return EMatcherType::HNSW_L2;
+  if(matcherType == "HNSW_HAMMING")             return EMatcherType::HNSW_HAMMING;
   throw std::out_of_range("Invalid matcherType : " + matcherType);
 }
 
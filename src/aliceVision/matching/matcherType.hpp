@@ -18,7 +18,11 @@ enum EMatcherType
   ANN_L2,
   CASCADE_HASHING_L2,
   FAST_CASCADE_HASHING_L2,
-  BRUTE_FORCE_HAMMING
+  BRUTE_FORCE_HAMMING,
+  BLOCKED_BRUTE_FORCE_L2,
+  CUDA_BRUTE_FORCE_L2,
+  HNSW_L2,
+  HNSW_HAMMING
 };
 
 /**
@@ -7,8 +7,11 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/ArrayMatcher_hnsw.hpp"
+#include <cstdlib>
 #include <iostream>
 
 #define BOOST_TEST_MODULE matching
@@ -82,6 +85,69 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_Dim4)
   BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8); //distance
 }
 
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_NN)
+{
+  const float array[] = {0, 1, 2, 5, 6};
+  ArrayMatcher_bruteForceBlocked<float> matcher;
+  BOOST_CHECK( matcher.Build(array, 5, 1) );
+
+  const float query[] = {2};
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query,1, &vec_nIndice, &vec_fDistance, 5) );
+
+  BOOST_CHECK_EQUAL( 5, vec_nIndice.size());
+  BOOST_CHECK_EQUAL( 5, vec_fDistance.size());
+
+  // Check distances:
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[0]- Square(2.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[1]- Square(1.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[2]- Square(0.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[3]- Square(5.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[4]- Square(6.0f-2.0f)), 1e-6);
+
+  // Check indexes:
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(0,0), vec_nIndice[2]);
+  BOOST_CHECK_EQUAL(IndMatch(0,3), vec_nIndice[3]);
+  BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_SameAsBruteForce)
+{
+  // more rows than one block of queries and database rows
+  const int dimension = 128;
+  const int nbRows = 1100;
+  const int nbQuery = 300;
+
+  std::srand(0);
+  std::vector<unsigned char> database(nbRows * dimension);
+  std::vector<unsigned char> queries(nbQuery * dimension);
+  for(unsigned char& value : database)
+    value = std::rand() % 256;
+  for(unsigned char& value : queries)
+    value = std::rand() % 256;
+
+  typedef L2_Vectorized<unsigned char> MetricT;
+  ArrayMatcher_bruteForce<unsigned char, MetricT> matcher;
+  ArrayMatcher_bruteForceBlocked<unsigned char, MetricT> blockedMatcher;
+  BOOST_CHECK( matcher.Build(database.data(), nbRows, dimension) );
+  BOOST_CHECK( blockedMatcher.Build(database.data(), nbRows, dimension) );
+
+  IndMatches indices, blockedIndices;
+  vector<float> distances, blockedDistances;
+  BOOST_CHECK( matcher.SearchNeighbours(queries.data(), nbQuery, &indices, &distances, 2) );
+  BOOST_CHECK( blockedMatcher.SearchNeighbours(queries.data(), nbQuery, &blockedIndices, &blockedDistances, 2) );
+
+  BOOST_CHECK_EQUAL(indices.size(), blockedIndices.size());
+  for(std::size_t i = 0; i < indices.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(distances[i], blockedDistances[i]);
+    BOOST_CHECK_EQUAL(indices[i], blockedIndices[i]);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -114,6 +180,98 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
   BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
 }
 
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_hnsw_Simple__NN)
+{
+  const float array[] = {0, 1, 2, 5, 6};
+
+  ArrayMatcher_hnsw<float> matcher;
+  BOOST_CHECK( matcher.Build(array, 5, 1) );
+
+  const float query[] = {2};
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query, 1, &vec_nIndice, &vec_fDistance, 5) );
+
+  BOOST_CHECK_EQUAL( 5, vec_nIndice.size());
+  BOOST_CHECK_EQUAL( 5, vec_fDistance.size());
+
+  // Check indexes:
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(0,0), vec_nIndice[2]);
+  BOOST_CHECK_EQUAL(IndMatch(0,3), vec_nIndice[3]);
+  BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_hnsw_Recall)
+{
+  const int dimension = 128;
+  const int nbRows = 3000;
+  const int nbQuery = 500;
+
+  // the queries are noisy copies of database rows, as the descriptors of matching features
+  std::srand(0);
+  std::vector<unsigned char> database(nbRows * dimension);
+  std::vector<unsigned char> queries(nbQuery * dimension);
+  for(unsigned char& value : database)
+    value = std::rand() % 256;
+  for(int q = 0; q < nbQuery; ++q)
+  {
+    const int row = std::rand() % nbRows;
+    for(int d = 0; d < dimension; ++d)
+      queries[q * dimension + d] = static_cast<unsigned char>(std::max(0, std::min(255, database[row * dimension + d] + std::rand() % 41 - 20)));
+  }
+
+  typedef L2_Vectorized<unsigned char> MetricT;
+  ArrayMatcher_bruteForce<unsigned char, MetricT> matcher;
+  ArrayMatcher_hnsw<unsigned char, MetricT> hnswMatcher;
+  BOOST_CHECK( matcher.Build(database.data(), nbRows, dimension) );
+  BOOST_CHECK( hnswMatcher.Build(database.data(), nbRows, dimension) );
+
+  IndMatches indices, hnswIndices;
+  vector<MetricT::ResultType> distances, hnswDistances;
+  BOOST_CHECK( matcher.SearchNeighbours(queries.data(), nbQuery, &indices, &distances, 2) );
+  BOOST_CHECK( hnswMatcher.SearchNeighbours(queries.data(), nbQuery, &hnswIndices, &hnswDistances, 2) );
+  BOOST_CHECK_EQUAL(indices.size(), hnswIndices.size());
+
+  int nbFound = 0;
+  for(int q = 0; q < nbQuery; ++q)
+  {
+    // exact distances, sorted
+    BOOST_CHECK_EQUAL(hnswDistances[2 * q], MetricT()(queries.data() + q * dimension, database.data() + hnswIndices[2 * q]._j * dimension, dimension));
+    BOOST_CHECK(hnswDistances[2 * q] <= hnswDistances[2 * q + 1]);
+    nbFound += (hnswIndices[2 * q] == indices[2 * q]);
+  }
+  BOOST_CHECK(nbFound >= 0.95 * nbQuery);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_hnsw_Hamming)
+{
+  const int nbBytes = 64;
+  const int nbRows = 2000;
+
+  std::srand(0);
+  std::vector<unsigned char> database(nbRows * nbBytes);
+  for(unsigned char& value : database)
+    value = std::rand() % 256;
+
+  typedef Hamming<unsigned char> MetricT;
+  ArrayMatcher_hnsw<unsigned char, MetricT> matcher;
+  BOOST_CHECK( matcher.Build(database.data(), nbRows, nbBytes) );
+
+  // each database row is its own nearest neighbor
+  IndMatches indices;
+  vector<MetricT::ResultType> distances;
+  BOOST_CHECK( matcher.SearchNeighbours(database.data(), nbRows, &indices, &distances, 2) );
+  int nbFound = 0;
+  for(int i = 0; i < nbRows; ++i)
+  {
+    nbFound += (indices[2 * i]._j == i);
+    BOOST_CHECK(distances[2 * i + 1] > 0);
+  }
+  BOOST_CHECK(nbFound >= 0.99 * nbRows);
+}
+
 //-- Test LIMIT case (empty arrays)
 
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_EmptyArrays)
@@ -138,6 +296,17 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple_EmptyArrays)
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
 
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_hnsw_Simple_EmptyArrays)
+{
+  std::vector<float> array;
+  ArrayMatcher_hnsw<float> matcher;
+  BOOST_CHECK(! matcher.Build(&array[0], 0, 4) );
+
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
+}
+
 BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
 {
   std::vector<float> array;
@@ -148,3 +317,39 @@ BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
   float fDistance = -1.0f;
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
+
+BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_SaveLoad)
+{
+  typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixT;
+  std::srand(0);
+  const MatrixT descriptions = MatrixT::Random(50, 16);
+  const Eigen::VectorXf zeroMean = CascadeHasher::GetZeroMeanDescriptor(descriptions);
+  const std::uint64_t checksum = 42;
+  const std::string path = "cascadeHashing_saveLoad.hash";
+
+  CascadeHasher hasher;
+  hasher.Init(16, 6, 10, 0);
+  const HashedDescriptions hashed = hasher.CreateHashedDescriptions(descriptions, zeroMean);
+  BOOST_CHECK(hasher.SaveHashedDescriptions(path, hashed, zeroMean, checksum));
+
+  // Same projections with the same seed
+  CascadeHasher otherHasher;
+  otherHasher.Init(16, 6, 10, 0);
+  HashedDescriptions loaded;
+  BOOST_CHECK(otherHasher.LoadHashedDescriptions(path, zeroMean, descriptions.rows(), checksum, loaded));
+  BOOST_CHECK_EQUAL(hashed.hashed_desc.size(), loaded.hashed_desc.size());
+  for(std::size_t i = 0; i < hashed.hashed_desc.size(); ++i)
+  {
+    BOOST_CHECK(hashed.hashed_desc[i].bucket_ids == loaded.hashed_desc[i].bucket_ids);
+    for(std::size_t b = 0; b < 16; ++b)
+      BOOST_CHECK_EQUAL(hashed.hashed_desc[i].hash_code[b], loaded.hashed_desc[i].hash_code[b]);
+  }
+  BOOST_CHECK(hashed.buckets == loaded.buckets);
+
+  // Outdated hashes are rejected
+  BOOST_CHECK(!otherHasher.LoadHashedDescriptions(path, zeroMean, descriptions.rows(), checksum + 1, loaded));
+  BOOST_CHECK(!otherHasher.LoadHashedDescriptions(path, zeroMean, descriptions.rows() + 1, checksum, loaded));
+  CascadeHasher otherSeedHasher;
+  otherSeedHasher.Init(16, 6, 10, 1);
+  BOOST_CHECK(!otherSeedHasher.LoadHashedDescriptions(path, zeroMean, descriptions.rows(), checksum, loaded));
+}
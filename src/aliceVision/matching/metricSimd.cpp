@@ -0,0 +1,624 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "metricSimd.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// the x86 kernels are compiled with function target attributes and selected at runtime,
+// so the library doesn't need to be built with -mavx2 / -mavx512*
+#if (defined __GNUC__ || defined __clang__) && (defined __x86_64__ || defined __i386__)
+#define ALICEVISION_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined __ARM_NEON || defined __ARM_NEON__
+#define ALICEVISION_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+
+namespace {
+
+typedef float (*L2FloatKernel)(const float*, const float*, std::size_t);
+typedef unsigned int (*L2UCharKernel)(const unsigned char*, const unsigned char*, std::size_t);
+typedef unsigned int (*HammingKernel)(const unsigned char*, const unsigned char*, std::size_t);
+typedef void (*HammingBatchKernel)(const unsigned char*, const unsigned char* const*, std::size_t, std::size_t, unsigned int*);
+
+struct Kernels
+{
+  ESimdLevel level;
+  L2FloatKernel l2Float;
+  L2UCharKernel l2UChar;
+  HammingKernel hamming;
+  HammingBatchKernel hammingBatch;
+};
+
+// generic kernels
+
+float l2FloatGeneric(const float* a, const float* b, std::size_t size)
+{
+  float result = 0.f;
+  std::size_t i = 0;
+  for(; i + 4 <= size; i += 4)
+  {
+    const float diff0 = a[i] - b[i];
+    const float diff1 = a[i + 1] - b[i + 1];
+    const float diff2 = a[i + 2] - b[i + 2];
+    const float diff3 = a[i + 3] - b[i + 3];
+    result += diff0 * diff0 + diff1 * diff1 + diff2 * diff2 + diff3 * diff3;
+  }
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+unsigned int l2UCharGeneric(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  unsigned int result = 0;
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const int diff = int(a[i]) - int(b[i]);
+    result += diff * diff;
+  }
+  return result;
+}
+
+inline unsigned int popcount64(std::uint64_t n)
+{
+#if defined __GNUC__ || defined __clang__
+  return __builtin_popcountll(n);
+#else
+  n -= ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  return (((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+inline unsigned int hammingTail(const unsigned char* a, const unsigned char* b, std::size_t begin, std::size_t nbBytes)
+{
+  unsigned int result = 0;
+  for(std::size_t i = begin; i < nbBytes; ++i)
+    result += popcount64(a[i] ^ b[i]);
+  return result;
+}
+
+unsigned int hammingGeneric(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  unsigned int result = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= nbBytes; i += 8)
+  {
+    std::uint64_t va, vb;
+    std::memcpy(&va, a + i, 8);
+    std::memcpy(&vb, b + i, 8);
+    result += popcount64(va ^ vb);
+  }
+  return result + hammingTail(a, b, i, nbBytes);
+}
+
+void hammingBatchGeneric(const unsigned char* query, const unsigned char* const* candidates,
+                         std::size_t nbCandidates, std::size_t nbBytes, unsigned int* distances)
+{
+  for(std::size_t c = 0; c < nbCandidates; ++c)
+    distances[c] = hammingGeneric(query, candidates[c], nbBytes);
+}
+
+#ifdef ALICEVISION_SIMD_X86
+
+// SSE kernels
+
+__attribute__((target("sse2")))
+float l2FloatSSE(const float* a, const float* b, std::size_t size)
+{
+  __m128 sum = _mm_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 4 <= size; i += 4)
+  {
+    const __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    sum = _mm_add_ps(sum, _mm_mul_ps(diff, diff));
+  }
+  float sums[4];
+  _mm_storeu_ps(sums, sum);
+  float result = sums[0] + sums[1] + sums[2] + sums[3];
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+__attribute__((target("sse2")))
+unsigned int l2UCharSSE(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = _mm_setzero_si128();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const __m128i diffLo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+    const __m128i diffHi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(diffLo, diffLo));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(diffHi, diffHi));
+  }
+  std::uint32_t sums[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), sum);
+  unsigned int result = sums[0] + sums[1] + sums[2] + sums[3];
+  return result + l2UCharGeneric(a + i, b + i, size - i);
+}
+
+__attribute__((target("popcnt")))
+unsigned int hammingPopcnt(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  unsigned int result = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= nbBytes; i += 8)
+  {
+    std::uint64_t va, vb;
+    std::memcpy(&va, a + i, 8);
+    std::memcpy(&vb, b + i, 8);
+    result += __builtin_popcountll(va ^ vb);
+  }
+  for(; i < nbBytes; ++i)
+    result += __builtin_popcount(a[i] ^ b[i]);
+  return result;
+}
+
+__attribute__((target("popcnt")))
+void hammingBatchPopcnt(const unsigned char* query, const unsigned char* const* candidates,
+                        std::size_t nbCandidates, std::size_t nbBytes, unsigned int* distances)
+{
+  // 128 bits hash codes of the cascade hashing
+  if(nbBytes == 16)
+  {
+    std::uint64_t q[2];
+    std::memcpy(q, query, 16);
+    for(std::size_t c = 0; c < nbCandidates; ++c)
+    {
+      std::uint64_t v[2];
+      std::memcpy(v, candidates[c], 16);
+      distances[c] = __builtin_popcountll(q[0] ^ v[0]) + __builtin_popcountll(q[1] ^ v[1]);
+    }
+    return;
+  }
+  for(std::size_t c = 0; c < nbCandidates; ++c)
+    distances[c] = hammingPopcnt(query, candidates[c], nbBytes);
+}
+
+// AVX2 kernels
+
+__attribute__((target("avx2,fma")))
+float l2FloatAVX2(const float* a, const float* b, std::size_t size)
+{
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m256 diff0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    const __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    sum0 = _mm256_fmadd_ps(diff0, diff0, sum0);
+    sum1 = _mm256_fmadd_ps(diff1, diff1, sum1);
+  }
+  for(; i + 8 <= size; i += 8)
+  {
+    const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    sum0 = _mm256_fmadd_ps(diff, diff, sum0);
+  }
+  const __m256 sum = _mm256_add_ps(sum0, sum1);
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+  float result = _mm_cvtss_f32(sum4);
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+__attribute__((target("avx2")))
+unsigned int l2UCharAVX2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m256i sum = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    const __m256i diffLo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(va)),
+                                            _mm256_cvtepu8_epi16(_mm256_castsi256_si128(vb)));
+    const __m256i diffHi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(va, 1)),
+                                            _mm256_cvtepu8_epi16(_mm256_extracti128_si256(vb, 1)));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(diffLo, diffLo));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(diffHi, diffHi));
+  }
+  __m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+  const unsigned int result = static_cast<unsigned int>(_mm_cvtsi128_si32(sum4));
+  return result + l2UCharGeneric(a + i, b + i, size - i);
+}
+
+// popcount of each byte with a nibble lookup table (W. Mula)
+__attribute__((target("avx2,popcnt")))
+unsigned int hammingAVX2(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  __m256i sum = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 32 <= nbBytes; i += 32)
+  {
+    const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i lo = _mm256_and_si256(v, lowMask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+    const __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+  }
+  std::uint64_t sums[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), sum);
+  const unsigned int result = static_cast<unsigned int>(sums[0] + sums[1] + sums[2] + sums[3]);
+  return result + hammingPopcnt(a + i, b + i, nbBytes - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+void hammingBatchAVX2(const unsigned char* query, const unsigned char* const* candidates,
+                      std::size_t nbCandidates, std::size_t nbBytes, unsigned int* distances)
+{
+  // the lookup table kernel is only faster than popcnt on full registers
+  if(nbBytes < 32)
+  {
+    hammingBatchPopcnt(query, candidates, nbCandidates, nbBytes, distances);
+    return;
+  }
+  for(std::size_t c = 0; c < nbCandidates; ++c)
+    distances[c] = hammingAVX2(query, candidates[c], nbBytes);
+}
+
+// AVX-512 kernels
+
+__attribute__((target("avx512f")))
+float l2FloatAVX512(const float* a, const float* b, std::size_t size)
+{
+  __m512 sum = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    sum = _mm512_fmadd_ps(diff, diff, sum);
+  }
+  float result = _mm512_reduce_add_ps(sum);
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+unsigned int l2UCharAVX512(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i sum = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    const __m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m512i diff = _mm512_sub_epi16(va, vb);
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(diff, diff));
+  }
+  const unsigned int result = static_cast<unsigned int>(_mm512_reduce_add_epi32(sum));
+  return result + l2UCharGeneric(a + i, b + i, size - i);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+unsigned int hammingAVX512(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  const __m512i lookup = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+  const __m512i lowMask = _mm512_set1_epi8(0x0f);
+  __m512i sum = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 64 <= nbBytes; i += 64)
+  {
+    const __m512i v = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    const __m512i lo = _mm512_and_si512(v, lowMask);
+    const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), lowMask);
+    const __m512i count = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, lo), _mm512_shuffle_epi8(lookup, hi));
+    sum = _mm512_add_epi64(sum, _mm512_sad_epu8(count, _mm512_setzero_si512()));
+  }
+  const unsigned int result = static_cast<unsigned int>(_mm512_reduce_add_epi64(sum));
+  return result + hammingPopcnt(a + i, b + i, nbBytes - i);
+}
+
+// with the VPOPCNTDQ extension (Ice Lake and later)
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+unsigned int hammingAVX512Vpopcnt(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  __m512i sum = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 64 <= nbBytes; i += 64)
+  {
+    const __m512i v = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(v));
+  }
+  const unsigned int result = static_cast<unsigned int>(_mm512_reduce_add_epi64(sum));
+  return result + hammingPopcnt(a + i, b + i, nbBytes - i);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+void hammingBatchAVX512Vpopcnt(const unsigned char* query, const unsigned char* const* candidates,
+                               std::size_t nbCandidates, std::size_t nbBytes, unsigned int* distances)
+{
+  if(nbBytes != 16)
+  {
+    if(nbBytes < 64)
+    {
+      hammingBatchPopcnt(query, candidates, nbCandidates, nbBytes, distances);
+      return;
+    }
+    for(std::size_t c = 0; c < nbCandidates; ++c)
+      distances[c] = hammingAVX512Vpopcnt(query, candidates[c], nbBytes);
+    return;
+  }
+
+  // 4 hash codes of 128 bits per register
+  const __m512i q = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(query)));
+  std::size_t c = 0;
+  for(; c + 4 <= nbCandidates; c += 4)
+  {
+    __m512i v = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates[c])));
+    v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates[c + 1])), 1);
+    v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates[c + 2])), 2);
+    v = _mm512_inserti32x4(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates[c + 3])), 3);
+    const __m512i count = _mm512_popcnt_epi64(_mm512_xor_si512(v, q));
+    // add the two 64 bits counts of each code
+    const __m512i codeCount = _mm512_add_epi64(count, _mm512_shuffle_epi32(count, _MM_PERM_BADC));
+    std::uint64_t counts[8];
+    _mm512_storeu_si512(counts, codeCount);
+    distances[c] = static_cast<unsigned int>(counts[0]);
+    distances[c + 1] = static_cast<unsigned int>(counts[2]);
+    distances[c + 2] = static_cast<unsigned int>(counts[4]);
+    distances[c + 3] = static_cast<unsigned int>(counts[6]);
+  }
+  hammingBatchPopcnt(query, candidates + c, nbCandidates - c, nbBytes, distances + c);
+}
+
+#endif // ALICEVISION_SIMD_X86
+
+#ifdef ALICEVISION_SIMD_NEON
+
+float l2FloatNEON(const float* a, const float* b, std::size_t size)
+{
+  float32x4_t sum = vdupq_n_f32(0.f);
+  std::size_t i = 0;
+  for(; i + 4 <= size; i += 4)
+  {
+    const float32x4_t diff = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+    sum = vmlaq_f32(sum, diff, diff);
+  }
+  float result = vgetq_lane_f32(sum, 0) + vgetq_lane_f32(sum, 1) + vgetq_lane_f32(sum, 2) + vgetq_lane_f32(sum, 3);
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+unsigned int l2UCharNEON(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  uint32x4_t sum = vdupq_n_u32(0);
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+    const uint8x8_t diffLo = vget_low_u8(diff);
+    const uint8x8_t diffHi = vget_high_u8(diff);
+    sum = vpadalq_u16(sum, vmull_u8(diffLo, diffLo));
+    sum = vpadalq_u16(sum, vmull_u8(diffHi, diffHi));
+  }
+  const unsigned int result = vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+  return result + l2UCharGeneric(a + i, b + i, size - i);
+}
+
+unsigned int hammingNEON(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  uint32x4_t sum = vdupq_n_u32(0);
+  std::size_t i = 0;
+  for(; i + 16 <= nbBytes; i += 16)
+  {
+    const uint8x16_t count = vcntq_u8(veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    sum = vpadalq_u16(sum, vpaddlq_u8(count));
+  }
+  const unsigned int result = vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+  return result + hammingTail(a, b, i, nbBytes);
+}
+
+void hammingBatchNEON(const unsigned char* query, const unsigned char* const* candidates,
+                      std::size_t nbCandidates, std::size_t nbBytes, unsigned int* distances)
+{
+  if(nbBytes != 16)
+  {
+    for(std::size_t c = 0; c < nbCandidates; ++c)
+      distances[c] = hammingNEON(query, candidates[c], nbBytes);
+    return;
+  }
+  const uint8x16_t q = vld1q_u8(query);
+  for(std::size_t c = 0; c < nbCandidates; ++c)
+  {
+    const uint8x16_t count = vcntq_u8(veorq_u8(q, vld1q_u8(candidates[c])));
+    const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(count)));
+    distances[c] = static_cast<unsigned int>(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+  }
+}
+
+#endif // ALICEVISION_SIMD_NEON
+
+bool isSupported(ESimdLevel level)
+{
+  switch(level)
+  {
+    case ESimdLevel::GENERIC:
+      return true;
+#ifdef ALICEVISION_SIMD_X86
+    case ESimdLevel::SSE:
+      return __builtin_cpu_supports("sse2");
+    case ESimdLevel::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("popcnt");
+    case ESimdLevel::AVX512:
+      return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt");
+#endif
+#ifdef ALICEVISION_SIMD_NEON
+    case ESimdLevel::NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+Kernels getKernelsFor(ESimdLevel level)
+{
+  Kernels kernels = {ESimdLevel::GENERIC, &l2FloatGeneric, &l2UCharGeneric, &hammingGeneric, &hammingBatchGeneric};
+  kernels.level = level;
+
+  switch(level)
+  {
+#ifdef ALICEVISION_SIMD_X86
+    case ESimdLevel::SSE:
+      kernels.l2Float = &l2FloatSSE;
+      kernels.l2UChar = &l2UCharSSE;
+      if(__builtin_cpu_supports("popcnt"))
+      {
+        kernels.hamming = &hammingPopcnt;
+        kernels.hammingBatch = &hammingBatchPopcnt;
+      }
+      break;
+    case ESimdLevel::AVX2:
+      kernels.l2Float = &l2FloatAVX2;
+      kernels.l2UChar = &l2UCharAVX2;
+      kernels.hamming = &hammingAVX2;
+      kernels.hammingBatch = &hammingBatchAVX2;
+      break;
+    case ESimdLevel::AVX512:
+      kernels.l2Float = &l2FloatAVX512;
+      kernels.l2UChar = &l2UCharAVX512;
+      kernels.hamming = &hammingAVX512;
+      kernels.hammingBatch = &hammingBatchAVX2;
+      if(__builtin_cpu_supports("avx512vpopcntdq"))
+      {
+        kernels.hamming = &hammingAVX512Vpopcnt;
+        kernels.hammingBatch = &hammingBatchAVX512Vpopcnt;
+      }
+      break;
+#endif
+#ifdef ALICEVISION_SIMD_NEON
+    case ESimdLevel::NEON:
+      kernels.l2Float = &l2FloatNEON;
+      kernels.l2UChar = &l2UCharNEON;
+      kernels.hamming = &hammingNEON;
+      kernels.hammingBatch = &hammingBatchNEON;
+      break;
+#endif
+    default:
+      kernels.level = ESimdLevel::GENERIC;
+      break;
+  }
+  return kernels;
+}
+
+Kernels detectKernels()
+{
+#ifdef ALICEVISION_SIMD_X86
+  __builtin_cpu_init();
+#endif
+  const ESimdLevel levels[] = {ESimdLevel::AVX512, ESimdLevel::AVX2, ESimdLevel::NEON, ESimdLevel::SSE};
+  for(const ESimdLevel level : levels)
+  {
+    if(isSupported(level))
+      return getKernelsFor(level);
+  }
+  return getKernelsFor(ESimdLevel::GENERIC);
+}
+
+Kernels& getKernels()
+{
+  // selected once, on the first distance computation
+  static Kernels kernels = detectKernels();
+  return kernels;
+}
+
+} // namespace
+
+std::string ESimdLevel_enumToString(ESimdLevel level)
+{
+  switch(level)
+  {
+    case ESimdLevel::GENERIC: return "generic";
+    case ESimdLevel::SSE:     return "SSE";
+    case ESimdLevel::AVX2:    return "AVX2";
+    case ESimdLevel::AVX512:  return "AVX-512";
+    case ESimdLevel::NEON:    return "NEON";
+  }
+  throw std::out_of_range("Invalid SIMD level enum");
+}
+
+ESimdLevel getSimdLevel()
+{
+  return getKernels().level;
+}
+
+bool setSimdLevel(ESimdLevel level)
+{
+  if(!isSupported(level))
+    return false;
+  getKernels() = getKernelsFor(level);
+  return true;
+}
+
+float l2(const float* a, const float* b, std::size_t size)
+{
+  return getKernels().l2Float(a, b, size);
+}
+
+unsigned int l2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  return getKernels().l2UChar(a, b, size);
+}
+
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  return getKernels().hamming(a, b, nbBytes);
+}
+
+void hammingDistances(const unsigned char* query,
+                      const unsigned char* const* candidates,
+                      std::size_t nbCandidates,
+                      std::size_t nbBytes,
+                      unsigned int* distances)
+{
+  getKernels().hammingBatch(query, candidates, nbCandidates, nbBytes, distances);
+}
+
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
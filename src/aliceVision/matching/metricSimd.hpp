@@ -0,0 +1,77 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+
+/**
+ * @brief Instruction sets of the distance kernels
+ */
+enum class ESimdLevel
+{
+  GENERIC = 0,
+  SSE,
+  AVX2,
+  AVX512,
+  NEON
+};
+
+std::string ESimdLevel_enumToString(ESimdLevel level);
+
+/**
+ * @brief Get the instruction set used by the distance kernels.
+ * @note The best instruction set supported by the CPU is selected on the first call.
+ */
+ESimdLevel getSimdLevel();
+
+/**
+ * @brief Force the instruction set used by the distance kernels.
+ * @note Not thread safe, only meant to be called at startup or in tests.
+ * @param[in] level The instruction set
+ * @return false if the instruction set is not supported by the CPU (the kernels are unchanged)
+ */
+bool setSimdLevel(ESimdLevel level);
+
+/**
+ * @brief Squared Euclidean distance between two float vectors.
+ */
+float l2(const float* a, const float* b, std::size_t size);
+
+/**
+ * @brief Squared Euclidean distance between two unsigned char vectors.
+ */
+unsigned int l2(const unsigned char* a, const unsigned char* b, std::size_t size);
+
+/**
+ * @brief Hamming distance between two binary descriptors.
+ * @param[in] nbBytes The size of the descriptors in bytes
+ */
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t nbBytes);
+
+/**
+ * @brief Hamming distances between a binary descriptor and a set of candidates.
+ * @note Faster than a hamming() call per candidate for the short descriptors (hash codes).
+ * @param[in] query The query descriptor
+ * @param[in] candidates The candidate descriptors
+ * @param[in] nbCandidates The number of candidates
+ * @param[in] nbBytes The size of the descriptors in bytes
+ * @param[out] distances The distance of each candidate (nbCandidates values)
+ */
+void hammingDistances(const unsigned char* query,
+                      const unsigned char* const* candidates,
+                      std::size_t nbCandidates,
+                      std::size_t nbBytes,
+                      unsigned int* distances);
+
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
@@ -6,8 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/matching/metric.hpp"
+#include "aliceVision/stl/DynamicBitset.hpp"
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 #include <boost/test/included/unit_test.hpp>
@@ -133,3 +136,88 @@ BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET_RAW_MEMORY_32BITS)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(Metric_SIMD_kernels)
+{
+  // sizes of the SIFT (128), AKAZE MLDB (61) and odd descriptors
+  const std::size_t sizes[] = {1, 7, 61, 64, 128, 131};
+  std::srand(0);
+
+  const simd::ESimdLevel defaultLevel = simd::getSimdLevel();
+  const simd::ESimdLevel levels[] = {simd::ESimdLevel::SSE, simd::ESimdLevel::AVX2,
+                                     simd::ESimdLevel::AVX512, simd::ESimdLevel::NEON};
+
+  for(const std::size_t size : sizes)
+  {
+    std::vector<float> af(size), bf(size);
+    std::vector<unsigned char> au(size), bu(size);
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      af[i] = std::rand() / float(RAND_MAX);
+      bf[i] = std::rand() / float(RAND_MAX);
+      au[i] = std::rand() % 256;
+      bu[i] = std::rand() % 256;
+    }
+
+    BOOST_CHECK(simd::setSimdLevel(simd::ESimdLevel::GENERIC));
+    const float l2Float = simd::l2(af.data(), bf.data(), size);
+    const unsigned int l2UChar = simd::l2(au.data(), bu.data(), size);
+    const unsigned int hamming = simd::hamming(au.data(), bu.data(), size);
+
+    BOOST_CHECK_EQUAL(l2UChar, L2_Simple<int>()(au.data(), bu.data(), size));
+
+    for(const simd::ESimdLevel level : levels)
+    {
+      if(!simd::setSimdLevel(level))
+        continue;
+      BOOST_TEST_MESSAGE("SIMD level: " << simd::ESimdLevel_enumToString(level) << ", size: " << size);
+      BOOST_CHECK_CLOSE(l2Float, simd::l2(af.data(), bf.data(), size), 1e-3);
+      BOOST_CHECK_EQUAL(l2UChar, simd::l2(au.data(), bu.data(), size));
+      BOOST_CHECK_EQUAL(hamming, simd::hamming(au.data(), bu.data(), size));
+    }
+  }
+  simd::setSimdLevel(defaultLevel);
+}
+
+BOOST_AUTO_TEST_CASE(Metric_SIMD_hammingDistances)
+{
+  // sizes of the cascade hashing codes (16), AKAZE MLDB (61) and odd descriptors
+  const std::size_t sizes[] = {3, 16, 32, 61, 64, 131};
+  const std::size_t nbCandidates = 11;
+  std::srand(0);
+
+  const simd::ESimdLevel defaultLevel = simd::getSimdLevel();
+  const simd::ESimdLevel levels[] = {simd::ESimdLevel::GENERIC, simd::ESimdLevel::SSE, simd::ESimdLevel::AVX2,
+                                     simd::ESimdLevel::AVX512, simd::ESimdLevel::NEON};
+
+  for(const std::size_t size : sizes)
+  {
+    std::vector<unsigned char> query(size);
+    std::vector<std::vector<unsigned char>> candidates(nbCandidates, std::vector<unsigned char>(size));
+    std::vector<const unsigned char*> candidatesPtr;
+    for(std::size_t i = 0; i < size; ++i)
+      query[i] = std::rand() % 256;
+    for(auto& candidate : candidates)
+    {
+      for(std::size_t i = 0; i < size; ++i)
+        candidate[i] = std::rand() % 256;
+      candidatesPtr.push_back(candidate.data());
+    }
+
+    for(const simd::ESimdLevel level : levels)
+    {
+      if(!simd::setSimdLevel(level))
+        continue;
+      BOOST_TEST_MESSAGE("SIMD level: " << simd::ESimdLevel_enumToString(level) << ", size: " << size);
+
+      std::vector<unsigned int> distances(nbCandidates);
+      simd::hammingDistances(query.data(), candidatesPtr.data(), nbCandidates, size, distances.data());
+      for(std::size_t c = 0; c < nbCandidates; ++c)
+      {
+        const stl::dynamic_bitset::BlockType* a = query.data();
+        BOOST_CHECK_EQUAL(distances[c], stl::dynamic_bitset::xor_count_blocks(a, candidates[c].data(), size));
+      }
+    }
+  }
+  simd::setSimdLevel(defaultLevel);
+}
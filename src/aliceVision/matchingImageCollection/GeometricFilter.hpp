@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
@@ -15,6 +16,8 @@
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <map>
 
@@ -35,6 +38,7 @@ using namespace aliceVision::matching;
  * @param[in] putativeMatches
  * @param[in] guidedMatching
  * @param[in] distanceRatio
+ * @param[out] out_geometricModels The models of the kept pairs (not returned if null)
  */
 template<typename GeometryFunctor>
 void robustModelEstimation(
@@ -44,21 +48,38 @@ void robustModelEstimation(
   const GeometryFunctor& functor,
   const PairwiseMatches& putativeMatches,
   const bool guidedMatching = false,
-  const double distanceRatio = 0.6)
+  const double distanceRatio = 0.6,
+  PairGeometricModels* out_geometricModels = nullptr)
 {
   out_geometricMatches.clear();
+  if(out_geometricModels)
+    out_geometricModels->clear();
+
+  // schedule the pairs with the most putative matches first to balance the threads load
+  std::vector<PairwiseMatches::const_iterator> pairsToFilter;
+  pairsToFilter.reserve(putativeMatches.size());
+  for(PairwiseMatches::const_iterator iter = putativeMatches.begin(); iter != putativeMatches.end(); ++iter)
+    pairsToFilter.push_back(iter);
+
+  std::stable_sort(pairsToFilter.begin(), pairsToFilter.end(),
+                   [](const PairwiseMatches::const_iterator& a, const PairwiseMatches::const_iterator& b)
+                   {
+                     return a->second.getNbAllMatches() > b->second.getNbAllMatches();
+                   });
 
   boost::progress_display progressBar(putativeMatches.size(), std::cout, "Robust Model Estimation\n");
-  
+  // filtered pairs, only the master thread updates the progress display
+  std::atomic<unsigned long> nbFilteredPairs(0);
+
+  // geometric matches of each thread, merged at the end
+  std::vector<std::vector<std::pair<Pair, MatchesPerDescType>>> threadsGeometricMatches(omp_get_max_threads());
+  std::vector<std::vector<std::pair<Pair, PairGeometricModel>>> threadsGeometricModels(omp_get_max_threads());
+
 #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < (int)putativeMatches.size(); ++i)
+  for (int i = 0; i < (int)pairsToFilter.size(); ++i)
   {
-    PairwiseMatches::const_iterator iter = putativeMatches.begin();
-    std::advance(iter, i);
-
-    const Pair currentPair = iter->first;
-    const MatchesPerDescType& putativeMatchesPerType = iter->second;
-    const Pair& imagePair = iter->first;
+    const Pair& imagePair = pairsToFilter[i]->first;
+    const MatchesPerDescType& putativeMatchesPerType = pairsToFilter[i]->second;
 
     // apply the geometric filter (robust model estimation)
     {
@@ -67,6 +88,13 @@ void robustModelEstimation(
       const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, inliers);
       if(state.hasStrongSupport)
       {
+        PairGeometricModel model;
+        if(out_geometricModels && geometricFilter.getGeometricModel(model))
+        {
+          model.nbInliers = inliers.getNbAllMatches();
+          threadsGeometricModels[omp_get_thread_num()].emplace_back(imagePair, model);
+        }
+
         if(guidedMatching)
         {
           MatchesPerDescType guidedGeometricInliers;
@@ -75,18 +103,26 @@ void robustModelEstimation(
           std::swap(inliers, guidedGeometricInliers);
         }
 
-#pragma omp critical
-        {
-          out_geometricMatches.emplace(currentPair, std::move(inliers));
-        }
-
+        threadsGeometricMatches[omp_get_thread_num()].emplace_back(imagePair, std::move(inliers));
       }
     }
 
-#pragma omp critical
-    {
-      ++progressBar;
-    }
+    ++nbFilteredPairs;
+    if(omp_get_thread_num() == 0)
+      progressBar += nbFilteredPairs - progressBar.count();
+  }
+  progressBar += nbFilteredPairs - progressBar.count();
+
+  for(auto& threadGeometricMatches : threadsGeometricMatches)
+  {
+    for(auto& geometricMatches : threadGeometricMatches)
+      out_geometricMatches.emplace(geometricMatches.first, std::move(geometricMatches.second));
+  }
+
+  if(out_geometricModels)
+  {
+    for(const auto& threadGeometricModels : threadsGeometricModels)
+      out_geometricModels->insert(threadGeometricModels.begin(), threadGeometricModels.end());
   }
 }
 
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <aliceVision/matching/GeometricModel.hpp>
+
 namespace aliceVision {
 
 
@@ -54,6 +56,15 @@ struct GeometricFilterMatrix
     matching::MatchesPerDescType & matches
   ) = 0;
 
+  /**
+   * @brief Get the model found by the last geometric estimation
+   * @param[out] model The model (type, matrix and threshold, the inliers are counted by the caller)
+   * @return false if the filter has no model to save
+   */
+  virtual bool getGeometricModel(matching::PairGeometricModel& model) const
+  {
+    return false;
+  }
 
   double m_dPrecision;  //upper_bound precision used for robust estimation
   double m_dPrecision_robust;
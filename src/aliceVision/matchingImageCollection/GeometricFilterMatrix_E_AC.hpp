@@ -160,9 +160,8 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
       Mat3 F;
       FundamentalFromEssential(m_E, ptrPinhole_I->K(), ptrPinhole_J->K(), &F);
 
-      robustEstimation::GuidedMatching<Mat3,
+      robustEstimation::GuidedMatching_Epipolar<
             aliceVision::fundamental::kernel::EpipolarDistanceError>(
-            //aliceVision::fundamental::kernel::SymmetricEpipolarDistanceError>(
         F,
         cam_I, regionsPerView.getAllRegions(viewId_I),
         cam_J, regionsPerView.getAllRegions(viewId_J),
@@ -172,6 +171,14 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
     return matches.getNbAllMatches() != 0;
   }
 
+  bool getGeometricModel(matching::PairGeometricModel& model) const override
+  {
+    model.type = matching::EGeometricModel::ESSENTIAL_MATRIX;
+    model.matrix = m_E;
+    model.threshold = m_dPrecision_robust;
+    return true;
+  }
+
   //
   //-- Stored data
   Mat3 m_E;
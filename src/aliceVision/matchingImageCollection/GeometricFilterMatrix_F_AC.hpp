@@ -253,7 +253,7 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
           sfmData->getIntrinsics().at(view_J->getIntrinsicId()).get() : nullptr;
 
       // Check the features correspondences that agree in the geometric and photometric domain
-      robustEstimation::GuidedMatching<Mat3,
+      robustEstimation::GuidedMatching_Epipolar<
                                      fundamental::kernel::EpipolarDistanceError>(
         m_F,
         cam_I, // camera::IntrinsicBase
@@ -266,6 +266,14 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
     return matches.getNbAllMatches() != 0;
   }
   
+  bool getGeometricModel(matching::PairGeometricModel& model) const override
+  {
+    model.type = matching::EGeometricModel::FUNDAMENTAL_MATRIX;
+    model.matrix = m_F;
+    model.threshold = m_dPrecision_robust;
+    return true;
+  }
+
   //
   //-- Stored data
   Mat3 m_F;
@@ -5,8 +5,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/feature/svgVisualization.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include "GeometricFilterMatrix_HGrowing.hpp"
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -78,6 +81,7 @@ bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
   const feature::SIOPointFeature & seedFeatureJ = featuresJ.at(seedMatch._j);
 
   double currTolerance;
+  std::set<IndexT> previousMatchesIndices;
 
   for (IndexT iRefineStep = 0; iRefineStep < param._nbRefiningIterations; ++iRefineStep)
   {
@@ -102,6 +106,16 @@ bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
     if (planarMatchesIndices.size() < param._minInliersToRefine)
       return false;
 
+    // the inliers did not grow: the next estimations of the same model would give
+    // the same transformation and inliers, go to the homography or stop
+    if (iRefineStep > 0 && planarMatchesIndices == previousMatchesIndices)
+    {
+      if (iRefineStep >= 5)
+        break;
+      iRefineStep = 4;
+    }
+    previousMatchesIndices = planarMatchesIndices;
+
     // Note: the following statement is present in the MATLAB code but not implemented in YASM
 //      if (planarMatchesIndices.size() >= param._maxFractionPlanarMatches * matches.size())
 //        break;
@@ -125,46 +139,57 @@ void filterMatchesByHGrowing(const std::vector<feature::SIOPointFeature>& siofea
   IndMatches remainingMatches = putativeMatches;
   GeometricFilterMatrix_HGrowing dummy;
 
+  // the seeds are grown in parallel by chunks, then merged in order,
+  // so the result is the same as growing them one after the other
+  const int chunkSize = 4 * omp_get_max_threads();
+
   for(IndexT iH = 0; iH < param._maxNbHomographies; ++iH)
   {
     std::set<IndexT> usedMatchesId, bestMatchesId;
-    Mat3 bestHomography;
+    Mat3 bestHomography = Mat3::Identity();
+
+    std::vector<std::set<IndexT>> chunkPlanarMatchesId(chunkSize);
+    std::vector<Mat3> chunkHomographies(chunkSize);
+    std::vector<char> chunkGrown(chunkSize);
 
     // -- Estimate H using homography-growing approach
-    #pragma omp parallel for // (huge optimization but modify results a little)
-    for(int iMatch = 0; iMatch < remainingMatches.size(); ++iMatch)
+    for(int chunkStart = 0; chunkStart < remainingMatches.size(); chunkStart += chunkSize)
     {
-      // Growing a homography from one match ([F.Srajer, 2016] algo. 1, p. 20)
-      // each match is used once only per homography estimation (increases computation time) [1st improvement ([F.Srajer, 2016] p. 20) ]
-      if (usedMatchesId.find(iMatch) != usedMatchesId.end())
-        continue;
-      std::set<IndexT> planarMatchesId; // be careful: it contains the id. in the 'remainingMatches' vector not 'putativeMatches' vector.
-      Mat3 homography;
-
-      if (!growHomography(siofeatures_I,
-                          siofeatures_J,
-                          remainingMatches,
-                          iMatch,
-                          planarMatchesId,
-                          homography,
-                          param._growParam))
+      const int chunkEnd = std::min(chunkStart + chunkSize, static_cast<int>(remainingMatches.size()));
+
+      #pragma omp parallel for schedule(dynamic)
+      for(int iMatch = chunkStart; iMatch < chunkEnd; ++iMatch)
       {
-        continue;
+        // Growing a homography from one match ([F.Srajer, 2016] algo. 1, p. 20)
+        // each match is used once only per homography estimation (increases computation time) [1st improvement ([F.Srajer, 2016] p. 20) ]
+        const int iChunk = iMatch - chunkStart;
+        chunkGrown[iChunk] = (usedMatchesId.find(iMatch) == usedMatchesId.end()) &&
+                             growHomography(siofeatures_I,
+                                            siofeatures_J,
+                                            remainingMatches,
+                                            iMatch,
+                                            chunkPlanarMatchesId[iChunk], // be careful: it contains the id. in the 'remainingMatches' vector not 'putativeMatches' vector.
+                                            chunkHomographies[iChunk],
+                                            param._growParam);
       }
 
-      #pragma omp critical
-      usedMatchesId.insert(planarMatchesId.begin(), planarMatchesId.end());
-
-      if (planarMatchesId.size() > bestMatchesId.size())
+      for(int iMatch = chunkStart; iMatch < chunkEnd; ++iMatch)
       {
-        #pragma omp critical
+        const int iChunk = iMatch - chunkStart;
+        // skip the seeds used by a previous seed of the chunk
+        if(!chunkGrown[iChunk] || usedMatchesId.find(iMatch) != usedMatchesId.end())
+          continue;
+
+        const std::set<IndexT>& planarMatchesId = chunkPlanarMatchesId[iChunk];
+        usedMatchesId.insert(planarMatchesId.begin(), planarMatchesId.end());
+
+        if (planarMatchesId.size() > bestMatchesId.size())
         {
-          if(iH == 3) std::cout << "best iMatch" << iMatch << std::endl;
           bestMatchesId = planarMatchesId; // be careful: it contains the id. in the 'remainingMatches' vector not 'putativeMatches' vector.
-          bestHomography = homography;
+          bestHomography = chunkHomographies[iChunk];
         }
       }
-    } // 'iMatch'
+    } // 'chunkStart'
 
     // -- Refine H using Ceres minimizer
     refineHomography(siofeatures_I, siofeatures_J, remainingMatches, bestHomography, bestMatchesId, param._growParam._homographyTolerance);
@@ -191,11 +216,15 @@ void filterMatchesByHGrowing(const std::vector<feature::SIOPointFeature>& siofea
     }
 
     // update remaining matches (/!\ Keep ordering)
-    std::size_t cpt = 0;
-    for (IndexT id : bestMatchesId)
     {
-      remainingMatches.erase(remainingMatches.begin() + id - cpt);
-      ++cpt;
+      IndMatches notUsedMatches;
+      notUsedMatches.reserve(remainingMatches.size() - bestMatchesId.size());
+      for (IndexT id = 0; id < remainingMatches.size(); ++id)
+      {
+        if (bestMatchesId.find(id) == bestMatchesId.end())
+          notUsedMatches.push_back(remainingMatches[id]);
+      }
+      remainingMatches.swap(notUsedMatches);
     }
 
     // stop when the number of remaining matches is too small
@@ -0,0 +1,102 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_HGrowing.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <algorithm>
+#include <random>
+
+#define BOOST_TEST_MODULE matchingImageCollectionHGrowing
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+
+/**
+ * @brief Add the matches of a plane seen with a similarity and a small perspective distortion
+ * @return the ids of the matches of the plane
+ */
+std::set<IndexT> addPlane(std::mt19937& generator, double angle, double scale, const Vec2& translation,
+                          float xMin, float xMax, std::size_t nbMatches,
+                          std::vector<feature::SIOPointFeature>& featuresI,
+                          std::vector<feature::SIOPointFeature>& featuresJ)
+{
+  Mat3 H;
+  H << scale * std::cos(angle), -scale * std::sin(angle), translation(0),
+       scale * std::sin(angle),  scale * std::cos(angle), translation(1),
+       1e-5, 0., 1.;
+
+  std::uniform_real_distribution<float> distributionX(xMin, xMax);
+  std::uniform_real_distribution<float> distributionY(0.f, 800.f);
+  std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+
+  std::set<IndexT> matchesId;
+  for(std::size_t i = 0; i < nbMatches; ++i)
+  {
+    const Vec2 ptI(distributionX(generator), distributionY(generator));
+    const Vec2 ptJ = (H * ptI.homogeneous()).hnormalized();
+    matchesId.insert(featuresI.size());
+    featuresI.emplace_back(ptI(0), ptI(1), 2.f, 0.3f);
+    featuresJ.emplace_back(ptJ(0) + noise(generator), ptJ(1) + noise(generator), 2.f * scale, 0.3f + angle);
+  }
+  return matchesId;
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_filterMatchesByHGrowing)
+{
+  std::mt19937 generator(42);
+  std::vector<feature::SIOPointFeature> featuresI;
+  std::vector<feature::SIOPointFeature> featuresJ;
+
+  const std::size_t nbMatchesPerPlane = 500;
+  const std::set<IndexT> plane0 = addPlane(generator, 0.1, 1.1, Vec2(20., -10.), 0.f, 500.f, nbMatchesPerPlane, featuresI, featuresJ);
+  const std::set<IndexT> plane1 = addPlane(generator, -0.05, 0.9, Vec2(-30., 25.), 500.f, 1000.f, nbMatchesPerPlane, featuresI, featuresJ);
+
+  // outliers
+  std::uniform_real_distribution<float> distribution(0.f, 800.f);
+  for(std::size_t i = 0; i < nbMatchesPerPlane / 2; ++i)
+  {
+    featuresI.emplace_back(distribution(generator), distribution(generator), 2.f, 0.f);
+    featuresJ.emplace_back(distribution(generator), distribution(generator), 2.f, 1.f);
+  }
+
+  matching::IndMatches putativeMatches;
+  for(IndexT i = 0; i < featuresI.size(); ++i)
+    putativeMatches.emplace_back(i, i);
+  std::shuffle(putativeMatches.begin(), putativeMatches.end(), generator);
+
+  const matchingImageCollection::HGrowingFilteringParam param;
+
+  std::vector<std::pair<Mat3, matching::IndMatches>> homographiesAndMatches;
+  matching::IndMatches geometricInliers;
+
+  system::Timer timer;
+  matchingImageCollection::filterMatchesByHGrowing(featuresI, featuresJ, putativeMatches, homographiesAndMatches, geometricInliers, param);
+  ALICEVISION_LOG_INFO("Homography growing on " << putativeMatches.size() << " matches: " << timer.elapsedMs() << " ms");
+
+  // one homography per plane, supported by the matches of the plane
+  BOOST_CHECK_EQUAL(homographiesAndMatches.size(), 2);
+  BOOST_CHECK_EQUAL(geometricInliers.size(), 2 * nbMatchesPerPlane);
+
+  for(const auto& homographyAndMatches : homographiesAndMatches)
+  {
+    std::set<IndexT> matchesId;
+    for(const matching::IndMatch& match : homographyAndMatches.second)
+      matchesId.insert(match._i);
+    BOOST_CHECK(matchesId == plane0 || matchesId == plane1);
+  }
+
+  // the parallel growing gives the same result at each run
+  std::vector<std::pair<Mat3, matching::IndMatches>> homographiesAndMatches2;
+  matching::IndMatches geometricInliers2;
+  matchingImageCollection::filterMatchesByHGrowing(featuresI, featuresJ, putativeMatches, homographiesAndMatches2, geometricInliers2, param);
+
+  BOOST_CHECK(geometricInliers == geometricInliers2);
+  BOOST_REQUIRE_EQUAL(homographiesAndMatches.size(), homographiesAndMatches2.size());
+  for(std::size_t i = 0; i < homographiesAndMatches.size(); ++i)
+    BOOST_CHECK(homographiesAndMatches.at(i).first.isApprox(homographiesAndMatches2.at(i).first));
+}
@@ -236,8 +236,8 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
       else
       {
         // Filtering based on region positions and regions descriptors
-        robustEstimation::GuidedMatching
-          <Mat3, aliceVision::homography::kernel::AsymmetricError>(
+        robustEstimation::GuidedMatching_Homography
+          <aliceVision::homography::kernel::AsymmetricError>(
           m_H,
           cam_I, regionsPerView.getAllRegions(viewId_I),
           cam_J, regionsPerView.getAllRegions(viewId_J),
@@ -248,6 +248,14 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
     return matches.getNbAllMatches() != 0;
   }
 
+  bool getGeometricModel(matching::PairGeometricModel& model) const override
+  {
+    model.type = matching::EGeometricModel::HOMOGRAPHY_MATRIX;
+    model.matrix = m_H;
+    model.threshold = m_dPrecision_robust;
+    return true;
+  }
+
   //
   //-- Stored data
   Mat3 m_H;
@@ -10,25 +10,78 @@
 #include <aliceVision/matching/IndMatchDecorator.hpp>
 #include <aliceVision/matching/filters.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace matchingImageCollection {
 
 using namespace aliceVision::matching;
 using namespace aliceVision::feature;
+namespace fs = boost::filesystem;
 
 ImageCollectionMatcher_cascadeHashing
 ::ImageCollectionMatcher_cascadeHashing
 (
-  float distRatio
-):IImageCollectionMatcher(), f_dist_ratio_(distRatio)
+  float distRatio,
+  const std::string& hashesFolder
+):IImageCollectionMatcher(), f_dist_ratio_(distRatio), hashesFolder_(hashesFolder)
 {
 }
 
 namespace impl
 {
+
+/// seed of the hashing projections when the hashes are saved
+const int persistentHashesSeed = 0;
+
+/// FNV-1a hash of the descriptors, to detect the outdated hashes
+std::uint64_t descriptorsChecksum(const feature::Regions& regions)
+{
+  const unsigned char* data = reinterpret_cast<const unsigned char*>(regions.DescriptorRawData());
+  const std::size_t nbBytes = regions.RegionCount() * regions.DescriptorByteSize();
+  std::uint64_t checksum = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < nbBytes; ++i)
+  {
+    checksum ^= data[i];
+    checksum *= 1099511628211ULL;
+  }
+  return checksum;
+}
+
+bool loadZeroMeanDescriptor(const std::string& path, std::size_t dimension, Eigen::VectorXf& zeroMeanDescriptor)
+{
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    return false;
+  std::int32_t size = 0;
+  stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (!stream || size != static_cast<std::int32_t>(dimension))
+    return false;
+  zeroMeanDescriptor.resize(size);
+  stream.read(reinterpret_cast<char*>(zeroMeanDescriptor.data()), size * sizeof(float));
+  return static_cast<bool>(stream);
+}
+
+bool saveZeroMeanDescriptor(const std::string& path, const Eigen::VectorXf& zeroMeanDescriptor)
+{
+  std::ofstream stream(path, std::ios::out | std::ios::binary);
+  if (!stream.is_open())
+    return false;
+  const std::int32_t size = zeroMeanDescriptor.size();
+  stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  stream.write(reinterpret_cast<const char*>(zeroMeanDescriptor.data()), size * sizeof(float));
+  return stream.good();
+}
+
 template <typename ScalarT>
 void Match
 (
@@ -36,10 +89,15 @@ void Match
   const PairSet & pairs,
   EImageDescriberType descType,
   float fDistRatio,
+  const std::string& hashesFolder,
   PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
 )
 {
   boost::progress_display my_progress_bar( pairs.size() );
+  // matched pairs, only the master thread updates the progress display
+  std::atomic<unsigned long> nbMatchedPairs(0);
+  // matches of each thread, merged after each database view
+  std::vector<std::vector<std::pair<Pair, IndMatches>>> threadsMatches(omp_get_max_threads());
 
   // Collect used view indexes
   std::set<IndexT> used_index;
@@ -62,13 +120,25 @@ void Match
     const IndexT I = *used_index.begin();
     const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
     const size_t dimension = regionsI.DescriptorLength();
-    cascade_hasher.Init(dimension);
+    if (hashesFolder.empty())
+      cascade_hasher.Init(dimension);
+    else
+      cascade_hasher.Init(dimension, 6, 10, persistentHashesSeed);
   }
 
+  const std::string describerName = EImageDescriberType_enumToString(descType);
+  const std::string zeroMeanPath = (fs::path(hashesFolder) / (describerName + ".zeroMean")).string();
+
+  // the entries are created before the parallel indexing
   std::map<IndexT, HashedDescriptions> hashed_base_;
+  for (const IndexT I : used_index)
+    hashed_base_[I];
 
   // Compute the zero mean descriptor that will be used for hashing (one for all the image regions)
   Eigen::VectorXf zero_mean_descriptor;
+  // reuse the zero mean descriptor of the saved hashes
+  if (hashesFolder.empty() || used_index.empty() ||
+      !loadZeroMeanDescriptor(zeroMeanPath, regionsPerView.getRegions(*used_index.begin(), descType).DescriptorLength(), zero_mean_descriptor))
   {
     Eigen::MatrixXf matForZeroMean;
     for (int i =0; i < used_index.size(); ++i)
@@ -92,28 +162,44 @@ void Match
       }
     }
     zero_mean_descriptor = CascadeHasher::GetZeroMeanDescriptor(matForZeroMean);
+
+    if (!hashesFolder.empty() && !saveZeroMeanDescriptor(zeroMeanPath, zero_mean_descriptor))
+      ALICEVISION_LOG_WARNING("Can't save the zero mean descriptor in '" << zeroMeanPath << "'.");
   }
 
-  // Index the input regions
+  // Index the input regions (once per view, shared by all the pairs)
+  std::atomic<int> nbLoadedHashes(0);
+  const std::vector<IndexT> used_index_vec(used_index.begin(), used_index.end());
   #pragma omp parallel for schedule(dynamic)
-  for (int i =0; i < used_index.size(); ++i)
+  for (int i =0; i < used_index_vec.size(); ++i)
   {
-    std::set<IndexT>::const_iterator iter = used_index.begin();
-    std::advance(iter, i);
-    const IndexT I = *iter;
+    const IndexT I = used_index_vec[i];
     const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
+    HashedDescriptions& hashedDescriptions = hashed_base_.at(I);
+
+    const std::string hashesPath = (fs::path(hashesFolder) / (std::to_string(I) + "." + describerName + ".hash")).string();
+    const std::uint64_t checksum = hashesFolder.empty() ? 0 : descriptorsChecksum(regionsI);
+    if (!hashesFolder.empty() &&
+        cascade_hasher.LoadHashedDescriptions(hashesPath, zero_mean_descriptor, regionsI.RegionCount(), checksum, hashedDescriptions))
+    {
+      ++nbLoadedHashes;
+      continue;
+    }
+
     const ScalarT * tabI =
       reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
     const size_t dimension = regionsI.DescriptorLength();
 
     Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
-    HashedDescriptions hashed_description = cascade_hasher.CreateHashedDescriptions(mat_I,
+    hashedDescriptions = cascade_hasher.CreateHashedDescriptions(mat_I,
       zero_mean_descriptor);
-    #pragma omp critical
-    {
-      hashed_base_[I] = std::move(hashed_description);
-    }
+
+    if (!hashesFolder.empty() && !cascade_hasher.SaveHashedDescriptions(hashesPath, hashedDescriptions, zero_mean_descriptor, checksum))
+      ALICEVISION_LOG_WARNING("Can't save the hashed descriptions in '" << hashesPath << "'.");
   }
+  if (!hashesFolder.empty())
+    ALICEVISION_LOG_INFO(nbLoadedHashes << " hashed descriptions loaded from '" << hashesFolder << "', "
+      << used_index.size() - nbLoadedHashes << " computed.");
 
   // Perform matching between all the pairs
   for (Map_vectorT::const_iterator iter = map_Pairs.begin();
@@ -125,11 +211,10 @@ void Match
     const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
     if (regionsI.RegionCount() == 0)
     {
-      my_progress_bar += indexToCompare.size();
+      nbMatchedPairs += indexToCompare.size();
       continue;
     }
 
-    const std::vector<feature::PointFeature> pointFeaturesI = regionsI.GetRegionsPositions();
     const ScalarT * tabI =
       reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
     const size_t dimension = regionsI.DescriptorLength();
@@ -137,16 +222,15 @@ void Match
     #pragma omp parallel for schedule(dynamic)
     for (int j = 0; j < (int)indexToCompare.size(); ++j)
     {
-      size_t J = indexToCompare[j];
-      const feature::Regions &regionsJ = regionsPerView.getRegions(I, descType);
+      const IndexT J = indexToCompare[j];
 
       if (!regionsPerView.viewExist(J)
-          || regionsI.Type_id() != regionsJ.Type_id())
+          || regionsI.Type_id() != regionsPerView.getRegions(J, descType).Type_id())
       {
-        #pragma omp critical
-        ++my_progress_bar;
+        ++nbMatchedPairs;
         continue;
       }
+      const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
 
       // Matrix representation of the query input data;
       const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ.DescriptorRawData());
@@ -160,8 +244,8 @@ void Match
 
       // Match the query descriptors to the database
       cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
-        hashed_base_[J], mat_J,
-        hashed_base_[I], mat_I,
+        hashed_base_.at(J), mat_J,
+        hashed_base_.at(I), mat_I,
         &pvec_indices, &pvec_distances);
 
       std::vector<int> vec_nn_ratio_idx;
@@ -188,22 +272,29 @@ void Match
       matching::IndMatch::getDeduplicated(vec_putative_matches);
 
       // Remove matches that have the same (X,Y) coordinates
-      const std::vector<feature::PointFeature> pointFeaturesJ = regionsJ.GetRegionsPositions();
-      matching::IndMatchDecorator<float> matchDeduplicator(vec_putative_matches,
-        pointFeaturesI, pointFeaturesJ);
+      matching::IndMatchDecorator<float> matchDeduplicator(vec_putative_matches, regionsI, regionsJ);
       matchDeduplicator.getDeduplicated(vec_putative_matches);
 
-      #pragma omp critical
+      if (!vec_putative_matches.empty())
+        threadsMatches[omp_get_thread_num()].emplace_back(std::make_pair(I,J), std::move(vec_putative_matches));
+
+      ++nbMatchedPairs;
+      if (omp_get_thread_num() == 0)
+        my_progress_bar += nbMatchedPairs - my_progress_bar.count();
+    }
+
+    // Merge the matches of all the threads
+    for (std::vector<std::pair<Pair, IndMatches>>& threadMatches : threadsMatches)
+    {
+      for (auto& pairMatches : threadMatches)
       {
-        ++my_progress_bar;
-        if (!vec_putative_matches.empty())
-        {
-          assert(map_PutativesMatches.count(std::make_pair(I,J)) == 0);
-          map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putative_matches));
-        }
+        assert(map_PutativesMatches.count(pairMatches.first) == 0);
+        map_PutativesMatches[pairMatches.first].emplace(descType, std::move(pairMatches.second));
       }
+      threadMatches.clear();
     }
   }
+  my_progress_bar += nbMatchedPairs - my_progress_bar.count();
 }
 } // namespace impl
 
@@ -234,6 +325,7 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      hashesFolder_,
       map_PutativesMatches);
   }
   else
@@ -244,6 +336,7 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      hashesFolder_,
       map_PutativesMatches);
   }
   else
@@ -19,14 +19,21 @@ namespace matchingImageCollection {
  * a threshold over the distance ratio of the 2 nearest neighbours.
  *
  * @note: Cascade hashing tables are computed once and used for all the regions.
+ * If a hashes folder is given, the hashed descriptions of each view are saved in it
+ * and reused by the next runs (the zero mean descriptor of the first run is kept).
  * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
  */
 class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
 {
   public:
+  /**
+   * @param[in] dist_ratio The distance ratio threshold
+   * @param[in] hashesFolder The folder of the persistent hashed descriptions (disabled if empty)
+   */
   ImageCollectionMatcher_cascadeHashing
   (
-    float dist_ratio
+    float dist_ratio,
+    const std::string& hashesFolder = ""
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -40,6 +47,8 @@ class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
   private:
   // Distance ratio used to discard spurious correspondence
   float f_dist_ratio_;
+  // Folder of the persistent hashed descriptions
+  std::string hashesFolder_;
 };
 
 } // namespace aliceVision
@@ -0,0 +1,277 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matchingImageCollection/ImageCollectionMatcher_cuda.hpp>
+#include <aliceVision/matchingImageCollection/ImageCollectionMatcher_generic.hpp>
+#include <aliceVision/matchingImageCollection/cuda/descriptorsMatching.hpp>
+#include <aliceVision/matching/RegionsMatcher.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Profiler.hpp>
+
+#include <boost/progress.hpp>
+
+#include <map>
+#include <stdexcept>
+#include <typeinfo>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+using namespace aliceVision::matching;
+using namespace aliceVision::feature;
+
+namespace {
+
+/// maximal number of query descriptors matched in one kernel launch
+const int maxQueriesPerBatch = 1 << 20;
+
+/// ratio of the free device memory used to keep the descriptors resident
+const double deviceMemoryRatio = 0.8;
+
+bool isMatchedOnDevice(const Regions& regions)
+{
+  return regions.IsScalar()
+      && regions.Type_id() == typeid(unsigned char).name()
+      && regions.DescriptorLength() % 4 == 0
+      && regions.DescriptorLength() <= MATCHING_CUDA_MAX_DESCRIPTOR_LENGTH;
+}
+
+/**
+ * @brief Descriptors of the views resident on the device, released in least recently used order.
+ * The views used by the current batch are pinned and never released.
+ */
+class DeviceDescriptorsCache
+{
+public:
+  explicit DeviceDescriptorsCache(std::size_t maxBytes)
+    : _maxBytes(maxBytes)
+  {}
+
+  ~DeviceDescriptorsCache()
+  {
+    for(auto& descriptors : _descriptors)
+      matchingCUDA_free(descriptors.second.data);
+  }
+
+  /**
+   * @brief Get the device descriptors of a view, upload them if needed.
+   * @return nullptr if they don't fit next to the pinned views
+   */
+  const void* get(IndexT viewId, const Regions& regions)
+  {
+    auto it = _descriptors.find(viewId);
+    if(it != _descriptors.end())
+    {
+      it->second.lastUse = ++_clock;
+      it->second.pinned = true;
+      return it->second.data;
+    }
+
+    const std::size_t nbBytes = regions.RegionCount() * regions.DescriptorLength();
+    void* data = nullptr;
+    while(data == nullptr)
+    {
+      if(_usedBytes + nbBytes <= _maxBytes)
+        data = matchingCUDA_upload(regions.DescriptorRawData(), nbBytes);
+      if(data == nullptr && !releaseOne())
+        return nullptr;
+    }
+
+    DeviceDescriptors& descriptors = _descriptors[viewId];
+    descriptors.data = data;
+    descriptors.nbBytes = nbBytes;
+    descriptors.lastUse = ++_clock;
+    descriptors.pinned = true;
+    _usedBytes += nbBytes;
+    return data;
+  }
+
+  void unpinAll()
+  {
+    for(auto& descriptors : _descriptors)
+      descriptors.second.pinned = false;
+  }
+
+private:
+  struct DeviceDescriptors
+  {
+    void* data = nullptr;
+    std::size_t nbBytes = 0;
+    long lastUse = 0;
+    bool pinned = false;
+  };
+
+  bool releaseOne()
+  {
+    auto lru = _descriptors.end();
+    for(auto it = _descriptors.begin(); it != _descriptors.end(); ++it)
+    {
+      if(!it->second.pinned && (lru == _descriptors.end() || it->second.lastUse < lru->second.lastUse))
+        lru = it;
+    }
+    if(lru == _descriptors.end())
+      return false;
+
+    matchingCUDA_free(lru->second.data);
+    _usedBytes -= lru->second.nbBytes;
+    _descriptors.erase(lru);
+    return true;
+  }
+
+  std::map<IndexT, DeviceDescriptors> _descriptors;
+  std::size_t _maxBytes;
+  std::size_t _usedBytes = 0;
+  long _clock = 0;
+};
+
+struct BatchPair
+{
+  Pair pair;
+  const Regions* regionsI;
+  const Regions* regionsJ;
+};
+
+} // namespace
+
+ImageCollectionMatcher_cuda::ImageCollectionMatcher_cuda(float distRatio)
+  : IImageCollectionMatcher()
+  , _f_dist_ratio(distRatio)
+{
+}
+
+void ImageCollectionMatcher_cuda::Match(
+  const feature::RegionsPerView& regionsPerView,
+  const PairSet & pairs,
+  feature::EImageDescriberType descType,
+  matching::PairwiseMatches & map_PutativesMatches)const // the pairwise photometric corresponding points
+{
+  ALICEVISION_PROFILE_ZONE("ImageCollectionMatcher::match");
+  PairSet cpuPairs;
+  std::vector<BatchPair> devicePairs;
+
+  for(const Pair& pair : pairs)
+  {
+    const Regions& regionsI = regionsPerView.getRegions(pair.first, descType);
+    const Regions& regionsJ = regionsPerView.getRegions(pair.second, descType);
+    // the ratio test needs 2 neighbours in the database
+    if(regionsI.RegionCount() < 2 || regionsJ.RegionCount() == 0 || regionsI.Type_id() != regionsJ.Type_id())
+      continue;
+    if(isMatchedOnDevice(regionsI))
+      devicePairs.push_back({pair, &regionsI, &regionsJ});
+    else
+      cpuPairs.insert(pair);
+  }
+
+  if(!devicePairs.empty() && !matchingCUDA_setDevice(0))
+  {
+    ALICEVISION_LOG_WARNING("No CUDA device found, the pairs are matched on CPU.");
+    for(const BatchPair& batchPair : devicePairs)
+      cpuPairs.insert(batchPair.pair);
+    devicePairs.clear();
+  }
+
+  if(!devicePairs.empty())
+  {
+    const std::size_t maxBytes = static_cast<std::size_t>(deviceMemoryRatio * matchingCUDA_getFreeMemory());
+    ALICEVISION_LOG_DEBUG("CUDA matching: " << maxBytes / (1024 * 1024) << " MB for the descriptors.");
+
+    DeviceDescriptorsCache deviceDescriptors(maxBytes);
+    boost::progress_display my_progress_bar(devicePairs.size());
+
+    std::vector<BatchPair> batch;
+    std::vector<MatchingTaskCUDA> tasks;
+    std::vector<NearestNeighborsCUDA> results;
+    int nbBatchQueries = 0;
+
+    // match the pairs of the batch and filter the nearest neighbours with the ratio test
+    auto matchBatch = [&]()
+    {
+      if(batch.empty())
+        return;
+      if(!matchingCUDA_match(tasks, batch.front().regionsI->DescriptorLength(), results))
+        throw std::runtime_error("Can't match the descriptors on the CUDA device.");
+
+      #pragma omp parallel for schedule(dynamic)
+      for(int b = 0; b < (int)batch.size(); ++b)
+      {
+        const MatchingTaskCUDA& task = tasks[b];
+
+        IndMatches nnIndices(2 * task.nbQueries);
+        std::vector<unsigned int> nnDistances(2 * task.nbQueries);
+        for(int q = 0; q < task.nbQueries; ++q)
+        {
+          const NearestNeighborsCUDA& nn = results[task.outputOffset + q];
+          nnIndices[2 * q] = IndMatch(q, nn.index);
+          nnIndices[2 * q + 1] = IndMatch(q, nn.secondIndex);
+          nnDistances[2 * q] = nn.distance;
+          nnDistances[2 * q + 1] = nn.secondDistance;
+        }
+
+        IndMatches vec_putatives_matches;
+        distanceRatioFilter(_f_dist_ratio, true, nnIndices, nnDistances,
+                            *batch[b].regionsI, *batch[b].regionsJ, vec_putatives_matches);
+        #pragma omp critical
+        {
+          ++my_progress_bar;
+          if(!vec_putatives_matches.empty())
+          {
+            map_PutativesMatches[batch[b].pair].emplace(descType, std::move(vec_putatives_matches));
+          }
+        }
+      }
+
+      batch.clear();
+      tasks.clear();
+      nbBatchQueries = 0;
+      deviceDescriptors.unpinAll();
+    };
+
+    for(const BatchPair& batchPair : devicePairs)
+    {
+      const int nbQueries = batchPair.regionsJ->RegionCount();
+      if(nbBatchQueries + nbQueries > maxQueriesPerBatch)
+        matchBatch();
+
+      const void* database = deviceDescriptors.get(batchPair.pair.first, *batchPair.regionsI);
+      const void* queries = deviceDescriptors.get(batchPair.pair.second, *batchPair.regionsJ);
+      if(database == nullptr || queries == nullptr)
+      {
+        // not enough device memory next to the descriptors of the current batch
+        matchBatch();
+        database = deviceDescriptors.get(batchPair.pair.first, *batchPair.regionsI);
+        queries = deviceDescriptors.get(batchPair.pair.second, *batchPair.regionsJ);
+        if(database == nullptr || queries == nullptr)
+        {
+          cpuPairs.insert(batchPair.pair);
+          deviceDescriptors.unpinAll();
+          ++my_progress_bar;
+          continue;
+        }
+      }
+
+      MatchingTaskCUDA task;
+      task.database = database;
+      task.nbDatabase = batchPair.regionsI->RegionCount();
+      task.queries = queries;
+      task.nbQueries = nbQueries;
+      task.outputOffset = nbBatchQueries;
+      tasks.push_back(task);
+      batch.push_back(batchPair);
+      nbBatchQueries += nbQueries;
+    }
+    matchBatch();
+  }
+
+  if(!cpuPairs.empty())
+  {
+    ALICEVISION_LOG_INFO(cpuPairs.size() << " pair(s) can't be matched on the CUDA device, matching them on CPU.");
+    ImageCollectionMatcher_generic cpuMatcher(_f_dist_ratio, BLOCKED_BRUTE_FORCE_L2);
+    cpuMatcher.Match(regionsPerView, cpuPairs, descType, map_PutativesMatches);
+  }
+}
+
+} // namespace aliceVision
+} // namespace matchingImageCollection
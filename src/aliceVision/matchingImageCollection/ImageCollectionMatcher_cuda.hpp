@@ -0,0 +1,45 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp"
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Compute putative matches between a collection of pictures on the GPU.
+ *
+ * The descriptors of each view are uploaded once and stay resident on the device
+ * (least recently used views are released when the device memory is full),
+ * the 2 nearest neighbours of many pairs are computed in one kernel launch.
+ * Spurious correspondences are then discarded with the same distance ratio test
+ * as ImageCollectionMatcher_generic.
+ *
+ * @note Only unsigned char descriptors are matched on the GPU (length multiple of 4, up to 256),
+ *       the other pairs are matched on the CPU with BLOCKED_BRUTE_FORCE_L2.
+ */
+class ImageCollectionMatcher_cuda : public IImageCollectionMatcher
+{
+  public:
+  explicit ImageCollectionMatcher_cuda(float distRatio);
+
+  /// Find corresponding points between some pair of view Ids
+  void Match(
+    const feature::RegionsPerView& regionsPerView,
+    const PairSet & pairs,
+    feature::EImageDescriberType descType,
+    matching::PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
+    ) const;
+
+  private:
+  // Distance ratio used to discard spurious correspondence
+  float _f_dist_ratio;
+};
+
+} // namespace aliceVision
+} // namespace matchingImageCollection
@@ -11,16 +11,38 @@
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/RegionsMatcher.hpp>
 #include <aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp>
+#include <aliceVision/matchingImageCollection/pairBuilder.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/Timer.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
 using namespace aliceVision::matching;
 using namespace aliceVision::feature;
 
+namespace {
+
+/// Matches and statistics of the pairs matched by one thread
+struct ThreadMatches
+{
+  std::vector<std::pair<Pair, IndMatches>> matches;
+  double matchTime = 0.0;
+  std::size_t nbSwappedPairs = 0;
+};
+
+} // namespace
+
 ImageCollectionMatcher_generic::ImageCollectionMatcher_generic(
   float distRatio, EMatcherType matcherType)
   : IImageCollectionMatcher()
@@ -35,6 +57,7 @@ void ImageCollectionMatcher_generic::Match(
   feature::EImageDescriberType descType,
   matching::PairwiseMatches & map_PutativesMatches)const // the pairwise photometric corresponding points
 {
+  ALICEVISION_PROFILE_ZONE("ImageCollectionMatcher::match");
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENMP)
   ALICEVISION_LOG_DEBUG("Using the OPENMP thread interface");
 #endif
@@ -42,58 +65,88 @@ void ImageCollectionMatcher_generic::Match(
   // -> set to true for CASCADE_HASHING_L2, since OpenMP instructions are not used in this matcher
 
   boost::progress_display my_progress_bar( pairs.size() );
+  // matched pairs, only the master thread updates the progress display
+  std::atomic<unsigned long> nbMatchedPairs(0);
 
-  // Sort pairs according the first index to minimize the MatcherT build operations
-  typedef std::map<size_t, std::vector<size_t> > Map_vectorT;
-  Map_vectorT map_Pairs;
-  for (PairSet::const_iterator iter = pairs.begin(); iter != pairs.end(); ++iter)
-  {
-    map_Pairs[iter->first].push_back(iter->second);
-  }
+  // Group the pairs by database view to minimize the MatcherT build operations
+  const std::map<IndexT, std::vector<Pair>> pairsPerDatabase = groupPairsByDatabase(pairs);
+
+  double buildTime = 0.0;
+  std::vector<ThreadMatches> threadsMatches(omp_get_max_threads());
 
   // Perform matching between all the pairs
-  for (Map_vectorT::const_iterator iter = map_Pairs.begin();
-    iter != map_Pairs.end(); ++iter)
+  for (const auto& databasePairs : pairsPerDatabase)
   {
-    const size_t I = iter->first;
-    const std::vector<size_t> & indexToCompare = iter->second;
+    const IndexT I = databasePairs.first;
+    const std::vector<Pair> & pairsToCompare = databasePairs.second;
 
     const feature::Regions & regionsI = regionsPerView.getRegions(I, descType);
     if (regionsI.RegionCount() == 0)
     {
-      my_progress_bar += indexToCompare.size();
+      nbMatchedPairs += pairsToCompare.size();
       continue;
     }
 
     // Initialize the matching interface
+    system::Timer buildTimer;
     matching::RegionsDatabaseMatcher matcher(_matcherType, regionsI);
+    buildTime += buildTimer.elapsed();
 
     #pragma omp parallel for schedule(dynamic) if(b_multithreaded_pair_search)
-    for (int j = 0; j < (int)indexToCompare.size(); ++j)
+    for (int j = 0; j < (int)pairsToCompare.size(); ++j)
     {
-      const size_t J = indexToCompare[j];
+      ThreadMatches& threadMatches = threadsMatches[omp_get_thread_num()];
+      const Pair& pair = pairsToCompare[j];
+      // the database view may be the second view of the pair
+      const bool swapped = (pair.first != I);
+      const IndexT J = swapped ? pair.first : pair.second;
 
       const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
-      if (regionsJ.RegionCount() == 0
-          || regionsI.Type_id() != regionsJ.Type_id())
-      {
-        #pragma omp critical
-        ++my_progress_bar;
-        continue;
-      }
-
-      IndMatches vec_putatives_matches;
-      matcher.Match(_f_dist_ratio, regionsJ, vec_putatives_matches);
-      #pragma omp critical
+      if (regionsJ.RegionCount() != 0
+          && regionsI.Type_id() == regionsJ.Type_id())
       {
-        ++my_progress_bar;
-        if (!vec_putatives_matches.empty())
+        system::Timer matchTimer;
+        IndMatches vec_putatives_matches;
+        matcher.Match(_f_dist_ratio, regionsJ, vec_putatives_matches);
+        if (swapped)
         {
-          map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
+          for (IndMatch& match : vec_putatives_matches)
+            std::swap(match._i, match._j);
+          ++threadMatches.nbSwappedPairs;
         }
+        threadMatches.matchTime += matchTimer.elapsed();
+        if (!vec_putatives_matches.empty())
+          threadMatches.matches.emplace_back(pair, std::move(vec_putatives_matches));
       }
+
+      ++nbMatchedPairs;
+      if (omp_get_thread_num() == 0)
+        my_progress_bar += nbMatchedPairs - my_progress_bar.count();
+    }
+
+    // Merge the matches of all the threads
+    for (ThreadMatches& threadMatches : threadsMatches)
+    {
+      for (auto& pairMatches : threadMatches.matches)
+        map_PutativesMatches[pairMatches.first].emplace(descType, std::move(pairMatches.second));
+      threadMatches.matches.clear();
     }
   }
+  my_progress_bar += nbMatchedPairs - my_progress_bar.count();
+
+  double matchTime = 0.0;
+  std::size_t nbSwappedPairs = 0;
+  for (const ThreadMatches& threadMatches : threadsMatches)
+  {
+    matchTime += threadMatches.matchTime;
+    nbSwappedPairs += threadMatches.nbSwappedPairs;
+  }
+
+  ALICEVISION_LOG_INFO("Matching statistics:" << std::endl
+    << "\t- # databases built: " << pairsPerDatabase.size() << " for " << pairs.size() << " pairs"
+    << " (" << nbSwappedPairs << " pairs matched from their second view)" << std::endl
+    << "\t- databases build time: " << buildTime << " s" << std::endl
+    << "\t- queries time (cumulated over threads): " << matchTime << " s");
 }
 
 } // namespace aliceVision
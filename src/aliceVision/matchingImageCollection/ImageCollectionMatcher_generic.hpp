@@ -17,6 +17,8 @@ namespace matchingImageCollection {
  *
  * Spurious correspondences are discarded by using the
  * a threshold over the distance ratio of the 2 nearest neighbours.
+ * The pairs are grouped by database view (see groupPairsByDatabase) so that
+ * each matching structure (kd-tree, hashing) is built once for all its pairs.
  *
  * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
  */
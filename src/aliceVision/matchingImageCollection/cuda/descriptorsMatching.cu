@@ -0,0 +1,224 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matchingImageCollection/cuda/descriptorsMatching.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/// number of queries (threads) of a CUDA block
+#define MATCHING_QUERIES_PER_BLOCK 128
+/// number of database descriptors loaded in shared memory at once
+#define MATCHING_DATABASE_TILE 32
+
+/**
+ * @brief The queries of a task handled by one CUDA block
+ */
+struct MatchingBlockCUDA
+{
+    const unsigned int* database;
+    int nbDatabase;
+    const unsigned int* queries;
+    int nbQueries;
+    int outputOffset;
+};
+
+static bool checkCudaError(const char* what)
+{
+    const cudaError_t err = cudaGetLastError();
+    if(err == cudaSuccess)
+        return true;
+    fprintf(stderr, "CUDA error during %s: %s\n", what, cudaGetErrorString(err));
+    return false;
+}
+
+/**
+ * @brief Sum of the squared differences of the 4 bytes packed in a word
+ */
+__device__ inline unsigned int squaredDiff4(unsigned int a, unsigned int b)
+{
+    unsigned int sum = 0;
+#pragma unroll
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+        const int d = (int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF);
+        sum += d * d;
+    }
+    return sum;
+}
+
+/**
+ * @brief One thread per query: scan the database tile by tile and keep the 2 nearest neighbours.
+ *
+ * The queries are stored in shared memory with a padded stride to avoid bank conflicts,
+ * all the threads read the same database word at once (broadcast).
+ */
+__global__ void nearestNeighbors_kernel(const MatchingBlockCUDA* blocks, int nbWords, NearestNeighborsCUDA* results)
+{
+    extern __shared__ unsigned int sharedMem[];
+    const int queryStride = nbWords + 1;
+    unsigned int* sQueries = sharedMem;
+    unsigned int* sDatabase = sharedMem + MATCHING_QUERIES_PER_BLOCK * queryStride;
+
+    const MatchingBlockCUDA block = blocks[blockIdx.x];
+    const int q = threadIdx.x;
+
+    for(int i = threadIdx.x; i < block.nbQueries * nbWords; i += blockDim.x)
+        sQueries[(i / nbWords) * queryStride + (i % nbWords)] = block.queries[i];
+
+    unsigned int bestDistance = UINT_MAX;
+    unsigned int secondDistance = UINT_MAX;
+    int bestIndex = -1;
+    int secondIndex = -1;
+
+    for(int tileBegin = 0; tileBegin < block.nbDatabase; tileBegin += MATCHING_DATABASE_TILE)
+    {
+        const int tileSize = min(MATCHING_DATABASE_TILE, block.nbDatabase - tileBegin);
+
+        __syncthreads();
+        for(int i = threadIdx.x; i < tileSize * nbWords; i += blockDim.x)
+            sDatabase[i] = block.database[tileBegin * nbWords + i];
+        __syncthreads();
+
+        if(q >= block.nbQueries)
+            continue;
+
+        const unsigned int* query = sQueries + q * queryStride;
+        for(int d = 0; d < tileSize; ++d)
+        {
+            const unsigned int* desc = sDatabase + d * nbWords;
+            unsigned int distance = 0;
+            for(int w = 0; w < nbWords; ++w)
+                distance += squaredDiff4(query[w], desc[w]);
+
+            if(distance < bestDistance)
+            {
+                secondDistance = bestDistance;
+                secondIndex = bestIndex;
+                bestDistance = distance;
+                bestIndex = tileBegin + d;
+            }
+            else if(distance < secondDistance)
+            {
+                secondDistance = distance;
+                secondIndex = tileBegin + d;
+            }
+        }
+    }
+
+    if(q < block.nbQueries)
+    {
+        NearestNeighborsCUDA& result = results[block.outputOffset + q];
+        result.index = bestIndex;
+        result.secondIndex = secondIndex;
+        result.distance = bestDistance;
+        result.secondDistance = secondDistance;
+    }
+}
+
+bool matchingCUDA_setDevice(int cudaDeviceNo)
+{
+    int nbDevices = 0;
+    if(cudaGetDeviceCount(&nbDevices) != cudaSuccess || cudaDeviceNo >= nbDevices)
+    {
+        cudaGetLastError(); // reset the error
+        return false;
+    }
+    cudaSetDevice(cudaDeviceNo);
+    return checkCudaError("device selection");
+}
+
+std::size_t matchingCUDA_getFreeMemory()
+{
+    size_t freeMemory = 0;
+    size_t totalMemory = 0;
+    cudaMemGetInfo(&freeMemory, &totalMemory);
+    return freeMemory;
+}
+
+void* matchingCUDA_upload(const void* data, std::size_t nbBytes)
+{
+    void* deviceData = nullptr;
+    if(cudaMalloc(&deviceData, nbBytes) != cudaSuccess)
+    {
+        cudaGetLastError(); // out of memory is handled by the caller
+        return nullptr;
+    }
+    cudaMemcpy(deviceData, data, nbBytes, cudaMemcpyHostToDevice);
+    if(!checkCudaError("descriptors upload"))
+    {
+        cudaFree(deviceData);
+        return nullptr;
+    }
+    return deviceData;
+}
+
+void matchingCUDA_free(void* deviceData)
+{
+    cudaFree(deviceData);
+}
+
+bool matchingCUDA_match(const std::vector<MatchingTaskCUDA>& tasks,
+                        int descriptorLength,
+                        std::vector<NearestNeighborsCUDA>& results)
+{
+    results.clear();
+    if(descriptorLength % 4 != 0 || descriptorLength > MATCHING_CUDA_MAX_DESCRIPTOR_LENGTH)
+        return false;
+
+    const int nbWords = descriptorLength / 4;
+
+    // split the queries of all the tasks in CUDA blocks
+    std::vector<MatchingBlockCUDA> blocks;
+    int nbResults = 0;
+    for(const MatchingTaskCUDA& task : tasks)
+    {
+        if(task.nbDatabase == 0)
+            continue;
+        for(int queryBegin = 0; queryBegin < task.nbQueries; queryBegin += MATCHING_QUERIES_PER_BLOCK)
+        {
+            MatchingBlockCUDA block;
+            block.database = static_cast<const unsigned int*>(task.database);
+            block.nbDatabase = task.nbDatabase;
+            block.queries = static_cast<const unsigned int*>(task.queries) + queryBegin * nbWords;
+            block.nbQueries = std::min(MATCHING_QUERIES_PER_BLOCK, task.nbQueries - queryBegin);
+            block.outputOffset = task.outputOffset + queryBegin;
+            blocks.push_back(block);
+        }
+        nbResults = std::max(nbResults, task.outputOffset + task.nbQueries);
+    }
+    results.resize(nbResults);
+    if(blocks.empty())
+        return true;
+
+    MatchingBlockCUDA* blocksDev = nullptr;
+    NearestNeighborsCUDA* resultsDev = nullptr;
+    if(cudaMalloc(&blocksDev, blocks.size() * sizeof(MatchingBlockCUDA)) != cudaSuccess ||
+       cudaMalloc(&resultsDev, results.size() * sizeof(NearestNeighborsCUDA)) != cudaSuccess)
+    {
+        checkCudaError("matching buffers allocation");
+        cudaFree(blocksDev);
+        return false;
+    }
+    cudaMemcpy(blocksDev, blocks.data(), blocks.size() * sizeof(MatchingBlockCUDA), cudaMemcpyHostToDevice);
+
+    const size_t sharedMemSize = (MATCHING_QUERIES_PER_BLOCK * (nbWords + 1) + MATCHING_DATABASE_TILE * nbWords) * sizeof(unsigned int);
+    nearestNeighbors_kernel<<<blocks.size(), MATCHING_QUERIES_PER_BLOCK, sharedMemSize>>>(blocksDev, nbWords, resultsDev);
+    cudaMemcpy(results.data(), resultsDev, results.size() * sizeof(NearestNeighborsCUDA), cudaMemcpyDeviceToHost);
+
+    const bool success = checkCudaError("descriptors matching");
+
+    cudaFree(blocksDev);
+    cudaFree(resultsDev);
+    return success;
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
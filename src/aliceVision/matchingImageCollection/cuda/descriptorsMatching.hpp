@@ -0,0 +1,82 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Maximal descriptor length (in bytes) supported by the CUDA matcher
+ */
+const int MATCHING_CUDA_MAX_DESCRIPTOR_LENGTH = 256;
+
+/**
+ * @brief One pair to match on the device: all the queries are matched against the database.
+ */
+struct MatchingTaskCUDA
+{
+  /// device pointer to the database descriptors
+  const void* database = nullptr;
+  int nbDatabase = 0;
+  /// device pointer to the query descriptors
+  const void* queries = nullptr;
+  int nbQueries = 0;
+  /// index of the first query result in the output
+  int outputOffset = 0;
+};
+
+/**
+ * @brief The 2 nearest neighbours of a query descriptor (squared L2 distances)
+ */
+struct NearestNeighborsCUDA
+{
+  int index;
+  int secondIndex;
+  unsigned int distance;
+  unsigned int secondDistance;
+};
+
+/**
+ * @brief Select the CUDA device used by the current thread.
+ * @return false if there is no such device
+ */
+bool matchingCUDA_setDevice(int cudaDeviceNo);
+
+/**
+ * @brief Get the free memory of the current CUDA device (in bytes).
+ */
+std::size_t matchingCUDA_getFreeMemory();
+
+/**
+ * @brief Upload descriptors on the current CUDA device.
+ * @param[in] data The host descriptors
+ * @param[in] nbBytes The size of the descriptors in bytes
+ * @return the device pointer, nullptr if the allocation failed
+ */
+void* matchingCUDA_upload(const void* data, std::size_t nbBytes);
+
+/**
+ * @brief Free descriptors allocated with matchingCUDA_upload.
+ */
+void matchingCUDA_free(void* deviceData);
+
+/**
+ * @brief Find the 2 nearest neighbours of the queries of all the tasks in one launch.
+ * @param[in] tasks The pairs to match, with unsigned char descriptors
+ * @param[in] descriptorLength The descriptor length in bytes (multiple of 4, up to MATCHING_CUDA_MAX_DESCRIPTOR_LENGTH)
+ * @param[out] results The nearest neighbours of each query, at the task outputOffset
+ * @return false on CUDA error
+ */
+bool matchingCUDA_match(const std::vector<MatchingTaskCUDA>& tasks,
+                        int descriptorLength,
+                        std::vector<NearestNeighborsCUDA>& results);
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
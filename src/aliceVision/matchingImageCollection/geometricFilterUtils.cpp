@@ -244,11 +244,10 @@ void findTransformationInliers(const std::vector<feature::SIOPointFeature> &feat
   inliersId.clear();
   const double squaredTolerance = Square(tolerance);
 
-#pragma omp parallel for
-  for (int iMatch = 0; iMatch < matches.size(); ++iMatch)
+  for (IndexT iMatch = 0; iMatch < matches.size(); ++iMatch)
   {
-    const feature::SIOPointFeature & featI = featuresI.at(matches.at(iMatch)._i);
-    const feature::SIOPointFeature & featJ = featuresJ.at(matches.at(iMatch)._j);
+    const feature::SIOPointFeature & featI = featuresI[matches[iMatch]._i];
+    const feature::SIOPointFeature & featJ = featuresJ[matches[iMatch]._j];
 
     const Vec2 ptI(featI.x(), featI.y());
     const Vec2 ptJ(featJ.x(), featJ.y());
@@ -257,11 +256,9 @@ void findTransformationInliers(const std::vector<feature::SIOPointFeature> &feat
 
     const double dist = (ptJ - ptIp_hom.hnormalized()).squaredNorm();
 
+    // increasing ids: constant time insertion at the end
     if (dist < squaredTolerance)
-    {
-#pragma omp critical
-      inliersId.insert(iMatch);
-    }
+      inliersId.insert(inliersId.end(), iMatch);
   }
 }
 
@@ -275,10 +272,9 @@ void findTransformationInliers(const Mat2X& featuresI,
   inliersId.clear();
   const double squaredTolerance = Square(tolerance);
 
-#pragma omp parallel for
-  for (int iMatch = 0; iMatch < matches.size(); ++iMatch)
+  for (IndexT iMatch = 0; iMatch < matches.size(); ++iMatch)
   {
-    const matching::IndMatch& match = matches.at(iMatch);
+    const matching::IndMatch& match = matches[iMatch];
     const Vec2 & ptI = featuresI.col(match._i);
     const Vec2 & ptJ = featuresJ.col(match._j);
 
@@ -286,11 +282,9 @@ void findTransformationInliers(const Mat2X& featuresI,
 
     const double dist = (ptJ - ptIp_hom.hnormalized()).squaredNorm();
 
+    // increasing ids: constant time insertion at the end
     if (dist < squaredTolerance)
-    {
-#pragma omp critical
-      inliersId.insert(iMatch);
-    }
+      inliersId.insert(inliersId.end(), iMatch);
   }
 }
 
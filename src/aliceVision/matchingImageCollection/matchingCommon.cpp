@@ -9,15 +9,21 @@
 
 #include "aliceVision/matchingImageCollection/ImageCollectionMatcher_generic.hpp"
 #include "aliceVision/matchingImageCollection/ImageCollectionMatcher_cascadeHashing.hpp"
+#include "aliceVision/config.hpp"
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include "aliceVision/matchingImageCollection/ImageCollectionMatcher_cuda.hpp"
+#endif
 
 #include <exception>
+#include <stdexcept>
 #include <cassert>
 
 namespace aliceVision {
 namespace matchingImageCollection {
   
 
-std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio)
+std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio, const std::string& hashesFolder)
 {
   std::unique_ptr<IImageCollectionMatcher> matcherPtr;
   
@@ -26,8 +32,17 @@ std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::
     case matching::BRUTE_FORCE_L2:          matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BRUTE_FORCE_L2)); break;
     case matching::ANN_L2:                  matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::ANN_L2)); break;
     case matching::CASCADE_HASHING_L2:      matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::CASCADE_HASHING_L2)); break;
-    case matching::FAST_CASCADE_HASHING_L2: matcherPtr.reset(new ImageCollectionMatcher_cascadeHashing(distRatio)); break;
+    case matching::FAST_CASCADE_HASHING_L2: matcherPtr.reset(new ImageCollectionMatcher_cascadeHashing(distRatio, hashesFolder)); break;
     case matching::BRUTE_FORCE_HAMMING:     matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BRUTE_FORCE_HAMMING)); break;
+    case matching::BLOCKED_BRUTE_FORCE_L2:  matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BLOCKED_BRUTE_FORCE_L2)); break;
+    case matching::HNSW_L2:                 matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::HNSW_L2)); break;
+    case matching::HNSW_HAMMING:            matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::HNSW_HAMMING)); break;
+    case matching::CUDA_BRUTE_FORCE_L2:
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+      matcherPtr.reset(new ImageCollectionMatcher_cuda(distRatio)); break;
+#else
+      throw std::runtime_error("Can't use CUDA_BRUTE_FORCE_L2, AliceVision is built without CUDA.");
+#endif
     
     default: throw std::out_of_range("Invalid matcherType enum");
   }
@@ -16,9 +16,11 @@ namespace matchingImageCollection {
 /**
  * 
  * @param matcherType
+ * @param distRatio The distance ratio threshold
+ * @param hashesFolder The folder of the persistent cascade hashes (FAST_CASCADE_HASHING_L2 only, disabled if empty)
  * @return 
  */
-std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio);
+std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio, const std::string& hashesFolder = "");
 
 
 } // namespace matching
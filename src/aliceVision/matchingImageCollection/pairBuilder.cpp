@@ -11,6 +11,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <iterator>
 #include <set>
 #include <iostream>
 #include <fstream>
@@ -123,4 +124,59 @@ bool savePairs(const std::string &sFileName, const PairSet & pairs)
   return bOk;
 }
 
+PairSet filterPairsWithViews(const PairSet & pairs, const std::set<IndexT> & viewIds)
+{
+  PairSet filteredPairs;
+  for(const Pair& pair : pairs)
+  {
+    if(viewIds.count(pair.first) || viewIds.count(pair.second))
+      filteredPairs.insert(filteredPairs.end(), pair);
+  }
+  return filteredPairs;
+}
+
+std::map<IndexT, std::vector<Pair>> groupPairsByDatabase(const PairSet & pairs)
+{
+  // remaining pairs of each view
+  std::map<IndexT, std::set<Pair>> pairsPerView;
+  for(const Pair& pair : pairs)
+  {
+    pairsPerView[pair.first].insert(pair);
+    pairsPerView[pair.second].insert(pair);
+  }
+
+  // views sorted by number of remaining pairs, then by decreasing view id
+  auto compare = [](const std::pair<std::size_t, IndexT>& a, const std::pair<std::size_t, IndexT>& b)
+  {
+    return (a.first < b.first || (a.first == b.first && a.second > b.second));
+  };
+  std::set<std::pair<std::size_t, IndexT>, decltype(compare)> viewsByNbPairs(compare);
+  for(const auto& viewPairs : pairsPerView)
+    viewsByNbPairs.emplace(viewPairs.second.size(), viewPairs.first);
+
+  std::map<IndexT, std::vector<Pair>> pairsPerDatabase;
+  while(!viewsByNbPairs.empty())
+  {
+    const auto last = std::prev(viewsByNbPairs.end());
+    const IndexT view = last->second;
+    viewsByNbPairs.erase(last);
+
+    std::set<Pair>& viewPairs = pairsPerView.at(view);
+    for(const Pair& pair : viewPairs)
+    {
+      const IndexT otherView = (pair.first == view) ? pair.second : pair.first;
+      if(otherView == view)
+        continue;
+      std::set<Pair>& otherPairs = pairsPerView.at(otherView);
+      viewsByNbPairs.erase(std::make_pair(otherPairs.size(), otherView));
+      otherPairs.erase(pair);
+      if(!otherPairs.empty())
+        viewsByNbPairs.emplace(otherPairs.size(), otherView);
+    }
+    pairsPerDatabase[view].assign(viewPairs.begin(), viewPairs.end());
+    viewPairs.clear();
+  }
+  return pairsPerDatabase;
+}
+
 }; // namespace aliceVision
@@ -11,6 +11,9 @@
 #include <aliceVision/sfm/SfMData.hpp>
 
 #include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
 
 namespace aliceVision {
 
@@ -30,4 +33,26 @@ bool loadPairs(
 /// I K
 bool savePairs(const std::string &sFileName, const PairSet & pairs);
 
+/**
+ * @brief Keep only the pairs involving at least one of the given views,
+ * used to match only the new views of a project (new x (old + new) pairs).
+ *
+ * @param[in] pairs The image pairs
+ * @param[in] viewIds The views to keep
+ * @return the filtered pairs
+ */
+PairSet filterPairsWithViews(const PairSet & pairs, const std::set<IndexT> & viewIds);
+
+/**
+ * @brief Group the pairs by the view used as matching database, so that as few views
+ * as possible are used as database (each database is built once and queried by its views).
+ *
+ * Views involved in the most remaining pairs are selected first, ties are broken by the
+ * lowest view id (so exhaustive pairs keep their first view as database).
+ *
+ * @param[in] pairs The image pairs
+ * @return For each database view, the original pairs it is involved in
+ */
+std::map<IndexT, std::vector<Pair>> groupPairsByDatabase(const PairSet & pairs);
+
 }; // namespace aliceVision
@@ -79,3 +79,55 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_IO)
   BOOST_CHECK( loadPairs("pairsT_IO.txt", loaded_Pairs));
   BOOST_CHECK( std::equal(loaded_Pairs.begin(), loaded_Pairs.end(), pairSetGTsorted.begin()) );
 }
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_groupPairsByDatabase)
+{
+  {
+    // Exhaustive pairs keep their first view as database
+    PairSet pairSet;
+    for(IndexT i = 0; i < 5; ++i)
+      for(IndexT j = i + 1; j < 5; ++j)
+        pairSet.insert(std::make_pair(i, j));
+
+    const std::map<IndexT, std::vector<Pair>> pairsPerDatabase = groupPairsByDatabase(pairSet);
+    BOOST_CHECK_EQUAL(4, pairsPerDatabase.size());
+    std::size_t nbPairs = 0;
+    for(const auto& databasePairs : pairsPerDatabase)
+    {
+      for(const Pair& pair : databasePairs.second)
+        BOOST_CHECK_EQUAL(databasePairs.first, pair.first);
+      nbPairs += databasePairs.second.size();
+    }
+    BOOST_CHECK_EQUAL(pairSet.size(), nbPairs);
+  }
+  {
+    // Star: the central view is the only database
+    PairSet pairSet;
+    pairSet.insert(std::make_pair(0, 5));
+    pairSet.insert(std::make_pair(1, 5));
+    pairSet.insert(std::make_pair(2, 5));
+    pairSet.insert(std::make_pair(5, 7));
+
+    const std::map<IndexT, std::vector<Pair>> pairsPerDatabase = groupPairsByDatabase(pairSet);
+    BOOST_CHECK_EQUAL(1, pairsPerDatabase.size());
+    BOOST_CHECK_EQUAL(5, pairsPerDatabase.begin()->first);
+    BOOST_CHECK_EQUAL(4, pairsPerDatabase.begin()->second.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_filterPairsWithViews)
+{
+  PairSet pairSet;
+  for(IndexT i = 0; i < 5; ++i)
+    for(IndexT j = i + 1; j < 5; ++j)
+      pairSet.insert(std::make_pair(i, j));
+
+  // new views 3 and 4: 3 x {0,1,2} + 4 x {0,1,2} + (3,4)
+  const std::set<IndexT> newViews = {3, 4};
+  const PairSet newPairs = filterPairsWithViews(pairSet, newViews);
+  BOOST_CHECK_EQUAL(7, newPairs.size());
+  for(const Pair& pair : newPairs)
+    BOOST_CHECK(newViews.count(pair.first) || newViews.count(pair.second));
+
+  BOOST_CHECK(filterPairsWithViews(pairSet, std::set<IndexT>()).empty());
+}
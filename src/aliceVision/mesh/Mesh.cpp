@@ -5,21 +5,190 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include "MeshAdjacency.hpp"
+#include "meshIO.hpp"
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/filesystem.hpp>
-
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/mesh/cuda/texturingRasterization.hpp>
+#include <aliceVision/mesh/cuda/visibilityRasterization.hpp>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <map>
+#include <sstream>
 
 namespace aliceVision {
 namespace mesh {
 
 namespace bfs = boost::filesystem;
 
+namespace {
+
+/// Projection matrix of a camera for a z-buffer downscaled by scale
+Matrix3x4 getZBufferProjection(const mvsUtils::MultiViewParams& mp, int rc, int scale)
+{
+    Matrix3x4 P = mp.camArr[rc];
+    for(int i = 0; i < 8; ++i)
+        P.m[i] /= static_cast<double>(scale);
+    return P;
+}
+
+/**
+ * @brief Z-buffer of the triangle indexes of a camera: the closest triangle at each pixel center.
+ * Same rasterization as the CUDA visibility (cuda/visibilityRasterization.cu).
+ */
+class TrianglesZBuffer
+{
+public:
+    TrianglesZBuffer(const StaticVector<Point3d>& pts, const StaticVector<Mesh::triangle>& tris)
+        : _pts(pts)
+        , _tris(tris)
+    {}
+
+    /// Render the z-buffer of a camera and list its visible triangles, sorted
+    void getVisibleTriangles(const Matrix3x4& P, int width, int height, std::vector<int>& visibleTris)
+    {
+        _width = width;
+        _height = height;
+        _keys.assign(static_cast<std::size_t>(width) * height, emptyPixel);
+        visibleTris.clear();
+
+        // keep the closest triangle at each pixel center
+        for(int triId = 0; triId < _tris.size(); ++triId)
+        {
+            if(!projectTriangle(P, triId))
+                continue;
+            rasterize([&](std::size_t pixel, double invDepth)
+            {
+                _keys[pixel] = std::min(_keys[pixel], depthKey(invDepth, triId));
+            });
+        }
+
+        // the triangles closest at one of their pixels, or whose center is not hidden if they cover no pixel center
+        for(int triId = 0; triId < _tris.size(); ++triId)
+        {
+            if(!projectTriangle(P, triId))
+                continue;
+            int nbPixels = 0;
+            bool visible = false;
+            rasterize([&](std::size_t pixel, double)
+            {
+                ++nbPixels;
+                visible = visible || (static_cast<std::uint32_t>(_keys[pixel] & 0xFFFFFFFFu) == static_cast<std::uint32_t>(triId));
+            });
+            if(nbPixels == 0)
+            {
+                const int px = static_cast<int>(std::floor((_x[0] + _x[1] + _x[2]) / 3.0 + 0.5));
+                const int py = static_cast<int>(std::floor((_y[0] + _y[1] + _y[2]) / 3.0 + 0.5));
+                if(px >= 0 && px < width && py >= 0 && py < height)
+                {
+                    const std::uint64_t key = _keys[static_cast<std::size_t>(py) * width + px];
+                    const float depth = static_cast<float>(3.0 / (1.0 / _z[0] + 1.0 / _z[1] + 1.0 / _z[2]));
+                    visible = (key == emptyPixel) || (depth <= keyDepth(key) * 1.001f);
+                }
+            }
+            if(visible)
+                visibleTris.push_back(triId);
+        }
+    }
+
+private:
+    /// empty pixel of the z-buffer
+    static const std::uint64_t emptyPixel = std::numeric_limits<std::uint64_t>::max();
+
+    /// the depth is the high part of the key, so the closest triangle has the smallest key
+    static std::uint64_t depthKey(double invDepth, int triId)
+    {
+        const float depth = static_cast<float>(1.0 / invDepth);
+        std::uint32_t depthBits;
+        std::memcpy(&depthBits, &depth, sizeof(depth));
+        return (static_cast<std::uint64_t>(depthBits) << 32) | static_cast<std::uint32_t>(triId);
+    }
+
+    static float keyDepth(std::uint64_t key)
+    {
+        const std::uint32_t depthBits = static_cast<std::uint32_t>(key >> 32);
+        float depth;
+        std::memcpy(&depth, &depthBits, sizeof(depth));
+        return depth;
+    }
+
+    /// Project the points of a triangle, false if a point is behind the camera
+    bool projectTriangle(const Matrix3x4& P, int triId)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            const Point3d& X = _pts[_tris[triId].v[k]];
+            const double xt = P.m11 * X.x + P.m12 * X.y + P.m13 * X.z + P.m14;
+            const double yt = P.m21 * X.x + P.m22 * X.y + P.m23 * X.z + P.m24;
+            const double zt = P.m31 * X.x + P.m32 * X.y + P.m33 * X.z + P.m34;
+            if(zt <= 0.0)
+                return false;
+            _x[k] = xt / zt;
+            _y[k] = yt / zt;
+            _z[k] = zt;
+        }
+        return true;
+    }
+
+    /// Visit the pixel centers covered by the projected triangle, with the inverse depth at the pixel
+    template <class PixelFunctor>
+    void rasterize(PixelFunctor f) const
+    {
+        const double area = (_x[1] - _x[0]) * (_y[2] - _y[0]) - (_x[2] - _x[0]) * (_y[1] - _y[0]);
+        if(area == 0.0)
+            return;
+
+        const int xmin = std::max(0, static_cast<int>(std::ceil(std::min({_x[0], _x[1], _x[2]}))));
+        const int xmax = std::min(_width - 1, static_cast<int>(std::floor(std::max({_x[0], _x[1], _x[2]}))));
+        const int ymin = std::max(0, static_cast<int>(std::ceil(std::min({_y[0], _y[1], _y[2]}))));
+        const int ymax = std::min(_height - 1, static_cast<int>(std::floor(std::max({_y[0], _y[1], _y[2]}))));
+
+        for(int py = ymin; py <= ymax; ++py)
+        {
+            for(int px = xmin; px <= xmax; ++px)
+            {
+                // barycentric coordinates of the pixel center
+                const double l0 = ((_x[1] - px) * (_y[2] - py) - (_x[2] - px) * (_y[1] - py)) / area;
+                const double l1 = ((_x[2] - px) * (_y[0] - py) - (_x[0] - px) * (_y[2] - py)) / area;
+                const double l2 = 1.0 - l0 - l1;
+                if(l0 < 0.0 || l1 < 0.0 || l2 < 0.0)
+                    continue;
+                f(static_cast<std::size_t>(py) * _width + px, l0 / _z[0] + l1 / _z[1] + l2 / _z[2]);
+            }
+        }
+    }
+
+    const StaticVector<Point3d>& _pts;
+    const StaticVector<Mesh::triangle>& _tris;
+    int _width = 0;
+    int _height = 0;
+    std::vector<std::uint64_t> _keys;
+    /// the projected triangle
+    double _x[3];
+    double _y[3];
+    double _z[3];
+};
+
+const std::uint64_t TrianglesZBuffer::emptyPixel;
+
+} // namespace
+
 Mesh::Mesh()
 {
 }
@@ -43,38 +212,94 @@ void Mesh::saveToObj(const std::string& filename)
   fprintf(f, "# Created with AliceVision\n");
   fprintf(f, "# \n");
   fprintf(f, "g Mesh\n");
-  for(int i = 0; i < pts->size(); i++)
-      fprintf(f, "v %f %f %f\n", (*pts)[i].x, (*pts)[i].y, (*pts)[i].z);
+  writeLinesParallel(f, pts->size(), [&](int i, std::string& buffer)
+  {
+      appendFormat(buffer, "v %f %f %f\n", (*pts)[i].x, (*pts)[i].y, (*pts)[i].z);
+  });
 
-  for(int i = 0; i < tris->size(); i++)
+  writeLinesParallel(f, tris->size(), [&](int i, std::string& buffer)
   {
-      Mesh::triangle& t = (*tris)[i];
-      fprintf(f, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1);
-  }
+      const Mesh::triangle& t = (*tris)[i];
+      appendFormat(buffer, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1);
+  });
   fclose(f);
   ALICEVISION_LOG_INFO("Save mesh to obj done.");
 }
 
+void Mesh::save(const std::string& filepath)
+{
+    const std::string extension = boost::to_lower_copy(bfs::path(filepath).extension().string());
+    if(extension == ".ply")
+        saveToPly(filepath);
+    else if(extension == ".bin")
+        saveToBin(filepath);
+    else
+        saveToObj(filepath);
+}
+
+bool Mesh::load(const std::string& filepath)
+{
+    const std::string extension = boost::to_lower_copy(bfs::path(filepath).extension().string());
+    if(extension == ".ply")
+        return loadFromPly(filepath);
+    if(extension == ".bin")
+        return loadFromBin(filepath);
+
+    int nmtls = 0;
+    StaticVector<int> trisMtlIds;
+    StaticVector<Point3d> normals;
+    StaticVector<Voxel> trisNormalsIds;
+    StaticVector<Point2d> uvCoords;
+    StaticVector<Voxel> trisUvIds;
+    return loadFromObjAscii(nmtls, trisMtlIds, normals, trisNormalsIds, uvCoords, trisUvIds, filepath);
+}
+
 bool Mesh::loadFromBin(std::string binFileName)
 {
-    FILE* f = fopen(binFileName.c_str(), "rb");
+    if(!bfs::exists(binFileName) || bfs::file_size(binFileName) < 2 * sizeof(int))
+    {
+        return false;
+    }
 
-    if(f == nullptr)
+    // map the file, the pages are read on demand while copying
+    boost::iostreams::mapped_file_source file(binFileName);
+    if(!file.is_open())
     {
         return false;
     }
 
+    const char* data = file.data();
+    const std::size_t fileSize = file.size();
+
     int npts;
-    fread(&npts, sizeof(int), 1, f);
+    std::memcpy(&npts, data, sizeof(int));
+    const std::size_t ptsOffset = sizeof(int);
+    const std::size_t ntrisOffset = ptsOffset + std::size_t(std::max(npts, 0)) * sizeof(Point3d);
+    if(npts < 0 || ntrisOffset + sizeof(int) > fileSize)
+    {
+        ALICEVISION_LOG_ERROR("Invalid mesh file: " << binFileName);
+        return false;
+    }
+
+    int ntris;
+    std::memcpy(&ntris, data + ntrisOffset, sizeof(int));
+    const std::size_t trisOffset = ntrisOffset + sizeof(int);
+    if(ntris < 0 || trisOffset + std::size_t(ntris) * sizeof(Mesh::triangle) > fileSize)
+    {
+        ALICEVISION_LOG_ERROR("Invalid mesh file: " << binFileName);
+        return false;
+    }
+
     pts = new StaticVector<Point3d>();
     pts->resize(npts);
-    fread(&(*pts)[0], sizeof(Point3d), npts, f);
-    int ntris;
-    fread(&ntris, sizeof(int), 1, f);
+    if(npts > 0)
+        std::memcpy(&(*pts)[0], data + ptsOffset, npts * sizeof(Point3d));
+
     tris = new StaticVector<Mesh::triangle>();
     tris->resize(ntris);
-    fread(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
-    fclose(f);
+    invalidateAdjacency();
+    if(ntris > 0)
+        std::memcpy(&(*tris)[0], data + trisOffset, ntris * sizeof(Mesh::triangle));
 
     return true;
 }
@@ -83,26 +308,392 @@ void Mesh::saveToBin(std::string binFileName)
 {
     long t = std::clock();
     ALICEVISION_LOG_DEBUG("Save mesh to bin.");
-    // printf("open\n");
-    FILE* f = fopen(binFileName.c_str(), "wb");
-    int npts = pts->size();
-    // printf("write npts %i\n",npts);
-    fwrite(&npts, sizeof(int), 1, f);
-    // printf("write pts\n");
-    fwrite(&(*pts)[0], sizeof(Point3d), npts, f);
-    int ntris = tris->size();
-    // printf("write ntris %i\n",ntris);
-    fwrite(&ntris, sizeof(int), 1, f);
-    // printf("write tris\n");
-    fwrite(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
-    // printf("close\n");
-    fclose(f);
-    // printf("done\n");
+
+    const int npts = sizeOfStaticVector<Point3d>(pts);
+    const int ntris = sizeOfStaticVector<Mesh::triangle>(tris);
+    const std::size_t ptsOffset = sizeof(int);
+    const std::size_t ntrisOffset = ptsOffset + std::size_t(npts) * sizeof(Point3d);
+    const std::size_t trisOffset = ntrisOffset + sizeof(int);
+
+    // create the file at its final size and write it through a mapping
+    boost::iostreams::mapped_file_params params(binFileName);
+    params.new_file_size = trisOffset + std::size_t(ntris) * sizeof(Mesh::triangle);
+    params.flags = boost::iostreams::mapped_file::readwrite;
+    boost::iostreams::mapped_file_sink file(params);
+
+    char* data = file.data();
+    std::memcpy(data, &npts, sizeof(int));
+    if(npts > 0)
+        std::memcpy(data + ptsOffset, &(*pts)[0], npts * sizeof(Point3d));
+    std::memcpy(data + ntrisOffset, &ntris, sizeof(int));
+    if(ntris > 0)
+        std::memcpy(data + trisOffset, &(*tris)[0], ntris * sizeof(Mesh::triangle));
+    file.close();
+
     mvsUtils::printfElapsedTime(t, "Save mesh to bin ");
 }
 
+namespace {
+
+/// binary PLY scalar types
+enum class EPlyType
+{
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64,
+    UNKNOWN
+};
+
+EPlyType plyTypeFromString(const std::string& type)
+{
+    if(type == "char" || type == "int8")
+        return EPlyType::INT8;
+    if(type == "uchar" || type == "uint8")
+        return EPlyType::UINT8;
+    if(type == "short" || type == "int16")
+        return EPlyType::INT16;
+    if(type == "ushort" || type == "uint16")
+        return EPlyType::UINT16;
+    if(type == "int" || type == "int32")
+        return EPlyType::INT32;
+    if(type == "uint" || type == "uint32")
+        return EPlyType::UINT32;
+    if(type == "float" || type == "float32")
+        return EPlyType::FLOAT32;
+    if(type == "double" || type == "float64")
+        return EPlyType::FLOAT64;
+    return EPlyType::UNKNOWN;
+}
+
+std::size_t plyTypeSize(EPlyType type)
+{
+    switch(type)
+    {
+        case EPlyType::INT8:
+        case EPlyType::UINT8: return 1;
+        case EPlyType::INT16:
+        case EPlyType::UINT16: return 2;
+        case EPlyType::INT32:
+        case EPlyType::UINT32:
+        case EPlyType::FLOAT32: return 4;
+        case EPlyType::FLOAT64: return 8;
+        case EPlyType::UNKNOWN: break;
+    }
+    return 0;
+}
+
+template <typename T>
+inline T readPlyScalar(const char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/// value stored in little endian, as the host byte order
+double readPlyValue(const char* data, EPlyType type)
+{
+    switch(type)
+    {
+        case EPlyType::INT8: return readPlyScalar<std::int8_t>(data);
+        case EPlyType::UINT8: return readPlyScalar<std::uint8_t>(data);
+        case EPlyType::INT16: return readPlyScalar<std::int16_t>(data);
+        case EPlyType::UINT16: return readPlyScalar<std::uint16_t>(data);
+        case EPlyType::INT32: return readPlyScalar<std::int32_t>(data);
+        case EPlyType::UINT32: return readPlyScalar<std::uint32_t>(data);
+        case EPlyType::FLOAT32: return readPlyScalar<float>(data);
+        case EPlyType::FLOAT64: return readPlyScalar<double>(data);
+        case EPlyType::UNKNOWN: break;
+    }
+    return 0.0;
+}
+
+struct PlyProperty
+{
+    std::string name;
+    EPlyType type = EPlyType::UNKNOWN;
+    /// type of the number of items, UNKNOWN if the property is not a list
+    EPlyType countType = EPlyType::UNKNOWN;
+
+    bool isList() const { return countType != EPlyType::UNKNOWN; }
+};
+
+struct PlyElement
+{
+    std::string name;
+    std::size_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+} // namespace
+
+void Mesh::saveToPly(const std::string& filename)
+{
+    ALICEVISION_LOG_INFO("Save mesh to ply: " << filename);
+
+    const int npts = sizeOfStaticVector<Point3d>(pts);
+    const int ntris = sizeOfStaticVector<Mesh::triangle>(tris);
+
+    FILE* f = fopen(filename.c_str(), "wb");
+    if(f == nullptr)
+    {
+        ALICEVISION_LOG_ERROR("Unable to write the mesh file: " << filename);
+        return;
+    }
+
+    // the data are written in the host byte order, little endian on the supported platforms
+    fprintf(f, "ply\n");
+    fprintf(f, "format binary_little_endian 1.0\n");
+    fprintf(f, "comment Created with AliceVision\n");
+    fprintf(f, "element vertex %i\n", npts);
+    fprintf(f, "property double x\n");
+    fprintf(f, "property double y\n");
+    fprintf(f, "property double z\n");
+    fprintf(f, "element face %i\n", ntris);
+    fprintf(f, "property list uchar int vertex_indices\n");
+    fprintf(f, "end_header\n");
+
+    static_assert(sizeof(Point3d) == 3 * sizeof(double), "Point3d is written as 3 doubles");
+    if(npts > 0)
+        fwrite(&(*pts)[0], sizeof(Point3d), npts, f);
+
+    // faces by blocks: number of points (uchar) and points indices (int)
+    const std::size_t faceSize = 1 + 3 * sizeof(int);
+    const int blockSize = 1 << 20;
+    std::vector<char> buffer;
+    for(int blockStart = 0; blockStart < ntris; blockStart += blockSize)
+    {
+        const int n = std::min(blockSize, ntris - blockStart);
+        buffer.resize(n * faceSize);
+
+        #pragma omp parallel for
+        for(int i = 0; i < n; ++i)
+        {
+            char* face = &buffer[i * faceSize];
+            face[0] = 3;
+            std::memcpy(face + 1, (*tris)[blockStart + i].v, 3 * sizeof(int));
+        }
+        fwrite(buffer.data(), 1, buffer.size(), f);
+    }
+    fclose(f);
+
+    ALICEVISION_LOG_INFO("Save mesh to ply done.");
+}
+
+bool Mesh::loadFromPly(const std::string& filename)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from ply file: " << filename);
+
+    if(!bfs::exists(filename) || bfs::file_size(filename) == 0)
+        return false;
+
+    boost::iostreams::mapped_file_source file(filename);
+    if(!file.is_open())
+        return false;
+
+    const char* data = file.data();
+    const std::size_t fileSize = file.size();
+
+    // header
+    const std::string endHeader = "end_header";
+    const char* headerEnd = std::search(data, data + fileSize, endHeader.begin(), endHeader.end());
+    const char* bodyBegin = (headerEnd == data + fileSize) ? nullptr :
+                            static_cast<const char*>(std::memchr(headerEnd, '\n', data + fileSize - headerEnd));
+    if(bodyBegin == nullptr)
+    {
+        ALICEVISION_LOG_ERROR("Invalid ply file: " << filename);
+        return false;
+    }
+
+    std::istringstream header(std::string(data, headerEnd));
+    std::vector<PlyElement> elements;
+    bool isBinaryLittleEndian = false;
+    std::string line;
+    while(std::getline(header, line))
+    {
+        std::istringstream lineStream(line);
+        std::string keyword;
+        lineStream >> keyword;
+        if(keyword == "format")
+        {
+            std::string format;
+            lineStream >> format;
+            isBinaryLittleEndian = (format == "binary_little_endian");
+        }
+        else if(keyword == "element")
+        {
+            elements.emplace_back();
+            lineStream >> elements.back().name >> elements.back().count;
+        }
+        else if(keyword == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            std::string type;
+            lineStream >> type;
+            if(type == "list")
+            {
+                std::string countType;
+                lineStream >> countType >> type;
+                property.countType = plyTypeFromString(countType);
+                if(property.countType == EPlyType::UNKNOWN)
+                    type.clear();
+            }
+            property.type = plyTypeFromString(type);
+            lineStream >> property.name;
+            if(property.type == EPlyType::UNKNOWN)
+            {
+                ALICEVISION_LOG_ERROR("Unsupported ply property: \"" << line << "\" in file: " << filename);
+                return false;
+            }
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    if(!isBinaryLittleEndian)
+    {
+        ALICEVISION_LOG_ERROR("Unsupported ply format, only binary little endian is supported: " << filename);
+        return false;
+    }
+
+    invalidateAdjacency();
+    pts = new StaticVector<Point3d>();
+    tris = new StaticVector<Mesh::triangle>();
+
+    std::size_t offset = bodyBegin + 1 - data;
+    for(const PlyElement& element : elements)
+    {
+        const bool hasList = std::any_of(element.properties.begin(), element.properties.end(),
+                                         [](const PlyProperty& p) { return p.isList(); });
+
+        if(!hasList)
+        {
+            // fixed size elements
+            std::size_t stride = 0;
+            std::size_t coordOffsets[3] = {0, 0, 0};
+            EPlyType coordTypes[3] = {EPlyType::UNKNOWN, EPlyType::UNKNOWN, EPlyType::UNKNOWN};
+            for(const PlyProperty& property : element.properties)
+            {
+                for(int k = 0; k < 3; ++k)
+                {
+                    if(property.name == std::string(1, 'x' + k))
+                    {
+                        coordOffsets[k] = stride;
+                        coordTypes[k] = property.type;
+                    }
+                }
+                stride += plyTypeSize(property.type);
+            }
+            if(offset + element.count * stride > fileSize)
+            {
+                ALICEVISION_LOG_ERROR("Invalid ply file: " << filename);
+                return false;
+            }
+
+            if(element.name == "vertex")
+            {
+                if(coordTypes[0] == EPlyType::UNKNOWN || coordTypes[1] == EPlyType::UNKNOWN || coordTypes[2] == EPlyType::UNKNOWN)
+                {
+                    ALICEVISION_LOG_ERROR("Missing vertex coordinates in ply file: " << filename);
+                    return false;
+                }
+                const int npts = element.count;
+                pts->resize(npts);
+
+                #pragma omp parallel for
+                for(int i = 0; i < npts; ++i)
+                {
+                    const char* vertex = data + offset + i * stride;
+                    (*pts)[i] = Point3d(readPlyValue(vertex + coordOffsets[0], coordTypes[0]),
+                                        readPlyValue(vertex + coordOffsets[1], coordTypes[1]),
+                                        readPlyValue(vertex + coordOffsets[2], coordTypes[2]));
+                }
+            }
+            offset += element.count * stride;
+            continue;
+        }
+
+        // variable size elements: the faces are polygons, triangulated as fans
+        const bool isFace = (element.name == "face");
+        std::vector<std::size_t> indicesOffsets(isFace ? element.count : 0);
+        std::vector<int> trisOffsets(isFace ? element.count + 1 : 0, 0);
+        for(std::size_t i = 0; i < element.count; ++i)
+        {
+            for(const PlyProperty& property : element.properties)
+            {
+                if(!property.isList())
+                {
+                    offset += plyTypeSize(property.type);
+                    continue;
+                }
+                if(offset + plyTypeSize(property.countType) > fileSize)
+                {
+                    ALICEVISION_LOG_ERROR("Invalid ply file: " << filename);
+                    return false;
+                }
+                const int n = static_cast<int>(readPlyValue(data + offset, property.countType));
+                if(isFace && (property.name == "vertex_indices" || property.name == "vertex_index"))
+                {
+                    indicesOffsets[i] = offset;
+                    trisOffsets[i + 1] = std::max(0, n - 2);
+                }
+                offset += plyTypeSize(property.countType) + std::max(0, n) * plyTypeSize(property.type);
+            }
+            if(offset > fileSize)
+            {
+                ALICEVISION_LOG_ERROR("Invalid ply file: " << filename);
+                return false;
+            }
+        }
+        if(!isFace)
+            continue;
+
+        const auto indicesProperty = std::find_if(element.properties.begin(), element.properties.end(), [](const PlyProperty& p)
+        {
+            return p.isList() && (p.name == "vertex_indices" || p.name == "vertex_index");
+        });
+        if(indicesProperty == element.properties.end())
+        {
+            ALICEVISION_LOG_ERROR("Missing face vertex indices in ply file: " << filename);
+            return false;
+        }
+        for(std::size_t i = 0; i < element.count; ++i)
+            trisOffsets[i + 1] += trisOffsets[i];
+        tris->resize(trisOffsets.back());
+
+        const std::size_t countSize = plyTypeSize(indicesProperty->countType);
+        const std::size_t indexSize = plyTypeSize(indicesProperty->type);
+        const int nfaces = element.count;
+
+        #pragma omp parallel for
+        for(int i = 0; i < nfaces; ++i)
+        {
+            const int n = trisOffsets[i + 1] - trisOffsets[i] + 2;
+            if(n < 3)
+                continue;
+            const char* indices = data + indicesOffsets[i] + countSize;
+            const int first = static_cast<int>(readPlyValue(indices, indicesProperty->type));
+            for(int k = 1; k < n - 1; ++k)
+            {
+                (*tris)[trisOffsets[i] + k - 1] = Mesh::triangle(first,
+                                                                 static_cast<int>(readPlyValue(indices + k * indexSize, indicesProperty->type)),
+                                                                 static_cast<int>(readPlyValue(indices + (k + 1) * indexSize, indicesProperty->type)));
+            }
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << pts->size() << "\n\t- # triangles: " << tris->size());
+    return !pts->empty() && !tris->empty();
+}
+
 void Mesh::addMesh(Mesh* me)
 {
+    invalidateAdjacency();
+
     int npts = sizeOfStaticVector<Point3d>(pts);
     int ntris = sizeOfStaticVector<Mesh::triangle>(tris);
     int npts1 = sizeOfStaticVector<Point3d>(me->pts);
@@ -491,147 +1082,108 @@ bool Mesh::doesTriangleIntersectsRectangle(Mesh::triangle_proj* tp, Mesh::rectan
     */
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles()
+void Mesh::getPtsNeighborTriangles(PointsNeighborhood& out_ptsNeighTris) const
 {
-    // array of tuples <x: vertexIndex, y: triangleIndex, z: numberOfNeighbors>
-    StaticVector<Voxel> vertexNeighborhoodPairs;
-    vertexNeighborhoodPairs.reserve(tris->size() * 3);
-    for(int i = 0; i < tris->size(); ++i)
-    {
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[0], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[1], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[2], i, 0));
-    }
-    qsort(&vertexNeighborhoodPairs[0], vertexNeighborhoodPairs.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    const int npts = pts->size();
+    const int ntris = tris->size();
+
+    // count the triangles of each point
+    std::vector<std::atomic<int>> nbNeighbors(npts);
+    #pragma omp parallel for
+    for(int i = 0; i < npts; ++i)
+        nbNeighbors[i].store(0, std::memory_order_relaxed);
 
-    int i = 0; // index of the unique pair of <vertex, neighborhood>
-    int j = 0; // index of the vertex
-    int k = 0; // number of neighbors
-    int firstid = 0;
-    while(i < vertexNeighborhoodPairs.size())
+    #pragma omp parallel for
+    for(int i = 0; i < ntris; ++i)
     {
-        k++;
-        // (*vertexNeighborhoodPairs)[i].z = j;
-        if((i == vertexNeighborhoodPairs.size() - 1) || (vertexNeighborhoodPairs[i].x != vertexNeighborhoodPairs[i + 1].x))
+        for(int k = 0; k < 3; ++k)
         {
-            vertexNeighborhoodPairs[firstid].z = k; // store the number of neighbors
-            ++j;
-            firstid = i + 1;
-            k = 0;
+            const int ptId = (*tris)[i].v[k];
+            if(ptId >= 0 && ptId < npts)
+                nbNeighbors[ptId].fetch_add(1, std::memory_order_relaxed);
         }
-        ++i;
     }
-    int npts = j;
 
-    StaticVector<StaticVector<int>*>* out_ptsNeighTris = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighTris->reserve(pts->size());
-    out_ptsNeighTris->resize_with(pts->size(), nullptr);
+    std::vector<int>& offsets = out_ptsNeighTris.offsets;
+    offsets.resize(npts + 1);
+    offsets[0] = 0;
+    for(int i = 0; i < npts; ++i)
+        offsets[i + 1] = offsets[i] + nbNeighbors[i].load(std::memory_order_relaxed);
 
-    i = 0;
-    for(j = 0; j < npts; ++j)
-    {
-        int middlePtId = vertexNeighborhoodPairs[i].x;
-        int nbNeighbors = vertexNeighborhoodPairs[i].z;
-        int i0 = i;
-        int i1 = i + nbNeighbors;
-        i = i1;
+    // fill, nbNeighbors is reused as the insertion position of each point
+    #pragma omp parallel for
+    for(int i = 0; i < npts; ++i)
+        nbNeighbors[i].store(offsets[i], std::memory_order_relaxed);
 
-        StaticVector<int>* triTmp = new StaticVector<int>();
-        triTmp->reserve(nbNeighbors);
-        for(int l = i0; l < i1; ++l)
+    std::vector<int>& ids = out_ptsNeighTris.ids;
+    ids.resize(offsets[npts]);
+    #pragma omp parallel for
+    for(int i = 0; i < ntris; ++i)
+    {
+        for(int k = 0; k < 3; ++k)
         {
-            triTmp->push_back(vertexNeighborhoodPairs[l].y); // index of triangle
+            const int ptId = (*tris)[i].v[k];
+            if(ptId >= 0 && ptId < npts)
+                ids[nbNeighbors[ptId].fetch_add(1, std::memory_order_relaxed)] = i;
         }
-
-        (*out_ptsNeighTris)[middlePtId] = triTmp;
     }
 
-    return out_ptsNeighTris;
+    // the fill order depends on the threads scheduling
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < npts; ++i)
+        std::sort(ids.begin() + offsets[i], ids.begin() + offsets[i + 1]);
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered()
+MeshAdjacency& Mesh::getAdjacency()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighborTriangles = getPtsNeighborTriangles();
+    if(_adjacency == nullptr || !_adjacency->isValid())
+        _adjacency.reset(new MeshAdjacency(*this));
+    return *_adjacency;
+}
 
-    StaticVector<StaticVector<int>*>* out_ptsNeighPts = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighPts->resize_with(pts->size(), nullptr);
+void Mesh::invalidateAdjacency()
+{
+    _adjacency.reset();
+}
 
-    for(int middlePtId = 0; middlePtId < pts->size(); ++middlePtId)
+/// Convert a CSR neighborhood to an array of arrays (nullptr for the points without neighbors)
+static StaticVector<StaticVector<int>*>* toArrayOfArrays(const Mesh::PointsNeighborhood& neighborhood, int npts)
+{
+    StaticVector<StaticVector<int>*>* out = new StaticVector<StaticVector<int>*>();
+    out->reserve(npts);
+    out->resize_with(npts, nullptr);
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < npts; ++i)
     {
-        StaticVector<int>* neighborTriangles = (*ptsNeighborTriangles)[middlePtId];
-        if((neighborTriangles == nullptr) || neighborTriangles->empty())
+        const int nbNeighbors = neighborhood.size(i);
+        if(nbNeighbors == 0)
             continue;
 
-        StaticVector<int> vhid;
-        vhid.reserve(neighborTriangles->size() * 2);
-        int currentTriPtId = (*tris)[(*neighborTriangles)[0]].v[0];
-        int firstTriPtId = currentTriPtId;
-        vhid.push_back(currentTriPtId);
-
-        bool isThereTWithCurrentTriPtId = true;
-        while(!neighborTriangles->empty() && isThereTWithCurrentTriPtId)
-        {
-            isThereTWithCurrentTriPtId = false;
-
-            // find triangle with middlePtId and currentTriPtId and get remaining point id
-            for(int n = 0; n < neighborTriangles->size(); ++n)
-            {
-                bool ok_middlePtId = false;
-                bool ok_actTriPtId = false;
-                int remainingPtId = -1; // remaining pt id
-                for(int k = 0; k < 3; ++k)
-                {
-                    int triPtId = (*tris)[(*neighborTriangles)[n]].v[k];
-                    double length = ((*pts)[middlePtId] - (*pts)[triPtId]).size();
-                    if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
-                    {
-                        remainingPtId = triPtId;
-                    }
-                    if(triPtId == middlePtId)
-                    {
-                        ok_middlePtId = true;
-                    }
-                    if(triPtId == currentTriPtId)
-                    {
-                        ok_actTriPtId = true;
-                    }
-                }
-
-                if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
-                {
-                    currentTriPtId = remainingPtId;
-                    neighborTriangles->remove(n);
-                    vhid.push_back(currentTriPtId);
-                    isThereTWithCurrentTriPtId = true; // we removed one, so we try again
-                    break;
-                }
-            }
-        }
+        StaticVector<int>* neighbors = new StaticVector<int>();
+        neighbors->getDataWritable().assign(neighborhood.begin(i), neighborhood.end(i));
+        (*out)[i] = neighbors;
+    }
+    return out;
+}
 
-        if(!vhid.empty())
-        {
-            if(currentTriPtId == firstTriPtId)
-            {
-                vhid.pop(); // remove last ... which is first
-            }
+StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles()
+{
+    return toArrayOfArrays(getAdjacency().getPtsNeighTris(), pts->size());
+}
 
-            // remove duplicates
-            StaticVector<int>* vhid1 = new StaticVector<int>();
-            vhid1->reserve(vhid.size());
-            for(int k1 = 0; k1 < vhid.size(); k1++)
-            {
-                if(vhid1->indexOf(vhid[k1]) == -1)
-                {
-                    vhid1->push_back(vhid[k1]);
-                }
-            }
+StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered()
+{
+    StaticVector<StaticVector<int>*>* out_ptsNeighPts = toArrayOfArrays(getAdjacency().getPtsNeighPtsOrdered(), pts->size());
 
-            (*out_ptsNeighPts)[middlePtId] = vhid1;
-        }
+    // the points with triangles have an array, even if empty
+    const PointsNeighborhood& ptsNeighTris = getAdjacency().getPtsNeighTris();
+    for(int i = 0; i < pts->size(); ++i)
+    {
+        if((*out_ptsNeighPts)[i] == nullptr && ptsNeighTris.size(i) > 0)
+            (*out_ptsNeighPts)[i] = new StaticVector<int>();
     }
 
-    deleteArrayOfArrays<int>(&ptsNeighborTriangles);
-
     return out_ptsNeighPts;
 }
 
@@ -988,6 +1540,14 @@ StaticVector<int>* Mesh::getVisibleTrianglesIndexes(StaticVector<float>* depthMa
     return out;
 }
 
+void Mesh::getVisibleTrianglesZBuffer(const mvsUtils::MultiViewParams& mp, int rc, int scale, std::vector<int>& out_visTris) const
+{
+    const int w = (mp.getWidth(rc) + scale - 1) / scale;
+    const int h = (mp.getHeight(rc) + scale - 1) / scale;
+    TrianglesZBuffer zbuffer(*pts, *tris);
+    zbuffer.getVisibleTriangles(getZBufferProjection(mp, rc, scale), w, h, out_visTris);
+}
+
 StaticVector<int>* Mesh::getVisibleTrianglesIndexes(StaticVector<StaticVector<int>*>* trisMap,
                                                        StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc,
                                                        int w, int h)
@@ -1145,131 +1705,87 @@ Mesh* Mesh::generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, St
 void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris,
                                   StaticVector<Pixel>** edgesPointsPairs)
 {
-    // printf("getNotOrientedEdges\n");
-    StaticVector<Voxel>* edges = new StaticVector<Voxel>();
-    edges->reserve(tris->size() * 3);
+    MeshAdjacency& adjacency = getAdjacency();
+    const std::vector<Pixel>& edges = adjacency.getEdgesPointsPairs();
 
-    for(int i = 0; i < tris->size(); i++)
-    {
-        int a = (*tris)[i].v[0];
-        int b = (*tris)[i].v[1];
-        int c = (*tris)[i].v[2];
-        edges->push_back(Voxel(std::min(a, b), std::max(a, b), i));
-        edges->push_back(Voxel(std::min(b, c), std::max(b, c), i));
-        edges->push_back(Voxel(std::min(c, a), std::max(c, a), i));
-    }
+    StaticVector<Pixel>* _edgesPointsPairs = new StaticVector<Pixel>();
+    _edgesPointsPairs->getDataWritable() = edges;
 
-    qsort(&(*edges)[0], edges->size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    (*edgesNeighTris) = toArrayOfArrays(adjacency.getEdgesNeighTris(), edges.size());
+    (*edgesPointsPairs) = _edgesPointsPairs;
+}
 
-    StaticVector<StaticVector<int>*>* _edgesNeighTris = new StaticVector<StaticVector<int>*>();
-    StaticVector<Pixel>* _edgesPointsPairs = new StaticVector<Pixel>();
+/// Laplacian smoothing vector of a point
+static Point3d getLaplacianSmoothingVector(const StaticVector<Point3d>& pts, int ptId, const int* neighs, int nneighs,
+                                           double maximalNeighDist)
+{
+    if(nneighs == 0)
+        return Point3d(0.0, 0.0, 0.0);
 
-    _edgesNeighTris->reserve(tris->size() * 3);
-    _edgesPointsPairs->reserve(tris->size() * 3);
-    // remove duplicities
-    int i0 = 0;
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < edges->size(); i++)
+    const Point3d& p = pts[ptId];
+    double maxNeighDist = 0.0f;
+    // laplacian smoothing vector
+    Point3d n = Point3d(0.0, 0.0, 0.0);
+    for(int j = 0; j < nneighs; j++)
     {
-        if((i == edges->size() - 1) || ((*edges)[i].x != (*edges)[i + 1].x))
-        {
-            StaticVector<Voxel>* edges1 = new StaticVector<Voxel>();
-            edges1->reserve(i - i0 + 1);
-            for(int j = i0; j <= i; j++)
-            {
-                edges1->push_back((*edges)[j]);
-            }
-            qsort(&(*edges1)[0], edges1->size(), sizeof(Voxel), qSortCompareVoxelByYAsc);
+        n = n + pts[neighs[j]];
+        maxNeighDist = std::max(maxNeighDist, (p - pts[neighs[j]]).size());
+    }
+    n = ((n / (float)nneighs) - p);
 
-            int j0 = 0;
-            for(int j = 0; j < edges1->size(); j++)
-            {
-                if((j == edges1->size() - 1) || ((*edges1)[j].y != (*edges1)[j + 1].y))
-                {
-                    _edgesPointsPairs->push_back(Pixel((*edges1)[j].x, (*edges1)[j].y));
-                    StaticVector<int>* neighTris = new StaticVector<int>();
-                    neighTris->reserve(j - j0 + 1);
-                    for(int k = j0; k <= j; k++)
-                    {
-                        neighTris->push_back((*edges1)[k].z);
-                    }
-                    _edgesNeighTris->push_back(neighTris);
-                    j0 = j + 1;
-                }
-            }
+    float d = n.size();
+    n = n.normalize();
 
-            delete edges1;
-            i0 = i + 1;
-        }
+    if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
+       (n.y != n.y) || (n.z != n.z)) // check if is not NaN
+    {
+        n = Point3d(0.0, 0.0, 0.0);
+    }
+    else
+    {
+        n = n * d;
+    }
 
-        mvsUtils::printfEstimate(i, edges->size(), t1);
+    if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
+       (n.y != n.y) || (n.z != n.z)) // check if is not NaN
+    {
+        n = Point3d(0.0, 0.0, 0.0);
     }
-    mvsUtils::finishEstimate();
 
-    (*edgesNeighTris) = _edgesNeighTris;
-    (*edgesPointsPairs) = _edgesPointsPairs;
+    if((maximalNeighDist > 0.0f) && (maxNeighDist > maximalNeighDist))
+    {
+        n = Point3d(0.0, 0.0, 0.0);
+    }
 
-    delete edges;
+    return n;
 }
 
 StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
                                                              double maximalNeighDist)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
+    nms->resize(pts->size());
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        Point3d p = (*pts)[i];
         StaticVector<int>* nei = (*ptsNeighPts)[i];
-        int nneighs = 0;
-        if(nei != nullptr)
-        {
-            nneighs = nei->size();
-        }
-
-        if(nneighs == 0)
-        {
-            nms->push_back(Point3d(0.0, 0.0, 0.0));
-        }
-        else
-        {
-            double maxNeighDist = 0.0f;
-            // laplacian smoothing vector
-            Point3d n = Point3d(0.0, 0.0, 0.0);
-            for(int j = 0; j < nneighs; j++)
-            {
-                n = n + (*pts)[(*nei)[j]];
-                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[(*nei)[j]]).size());
-            }
-            n = ((n / (float)nneighs) - p);
-
-            float d = n.size();
-            n = n.normalize();
-
-            if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-               (n.y != n.y) || (n.z != n.z)) // check if is not NaN
-            {
-                n = Point3d(0.0, 0.0, 0.0);
-            }
-            else
-            {
-                n = n * d;
-            }
+        const int nneighs = sizeOfStaticVector<int>(nei);
+        (*nms)[i] = getLaplacianSmoothingVector(*pts, i, (nneighs > 0) ? &(*nei)[0] : nullptr, nneighs, maximalNeighDist);
+    }
 
-            if(std::isnan(d) || std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (d != d) || (n.x != n.x) ||
-               (n.y != n.y) || (n.z != n.z)) // check if is not NaN
-            {
-                n = Point3d(0.0, 0.0, 0.0);
-            }
+    return nms;
+}
 
-            if((maximalNeighDist > 0.0f) && (maxNeighDist > maximalNeighDist))
-            {
-                n = Point3d(0.0, 0.0, 0.0);
-            }
+StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(const PointsNeighborhood& ptsNeighPts, double maximalNeighDist)
+{
+    StaticVector<Point3d>* nms = new StaticVector<Point3d>();
+    nms->resize(pts->size());
 
-            nms->push_back(n);
-        }
+    #pragma omp parallel for
+    for(int i = 0; i < pts->size(); i++)
+    {
+        (*nms)[i] = getLaplacianSmoothingVector(*pts, i, ptsNeighPts.begin(i), ptsNeighPts.size(i), maximalNeighDist);
     }
 
     return nms;
@@ -1277,9 +1793,15 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
 
 void Mesh::laplacianSmoothPts(float maximalNeighDist)
 {
-    StaticVector<StaticVector<int>*>* ptsNei = getPtsNeighPtsOrdered();
-    laplacianSmoothPts(ptsNei, maximalNeighDist);
-    deleteArrayOfArrays<int>(&ptsNei);
+    StaticVector<Point3d>* nms = getLaplacianSmoothingVectors(getAdjacency().getPtsNeighPtsOrdered(), maximalNeighDist);
+
+    // smooth
+    for(int i = 0; i < pts->size(); i++)
+    {
+        (*pts)[i] = (*pts)[i] + (*nms)[i];
+    }
+
+    delete nms;
 }
 
 void Mesh::laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist)
@@ -1314,11 +1836,51 @@ double Mesh::computeTriangleMaxEdgeLength(int idTri) const
                     ((*pts)[(*tris)[idTri].v[2]] - (*pts)[(*tris)[idTri].v[0]]).size());
 }
 
+/// Average normal of the given triangles, (0, 0, 0) if not defined
+static Point3d computePtNormal(Mesh& mesh, const int* triIds, int ntris)
+{
+    Point3d n = Point3d(0.0f, 0.0f, 0.0f);
+    float nn = 0.0f;
+    for(int j = 0; j < ntris; j++)
+    {
+        Point3d n1 = mesh.computeTriangleNormal(triIds[j]);
+        n1 = n1.normalize();
+        if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z) || (n1.x != n1.x) || (n1.y != n1.y) ||
+           (n1.z != n1.z)) // check if is not NaN
+        {
+            //
+        }
+        else
+        {
+            n = n + mesh.computeTriangleNormal(triIds[j]);
+            nn += 1.0f;
+        }
+    }
+    n = n / nn;
+
+    n = n.normalize();
+    if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (n.x != n.x) || (n.y != n.y) ||
+       (n.z != n.z)) // check if is not NaN
+    {
+        n = Point3d(0.0f, 0.0f, 0.0f);
+    }
+    return n;
+}
+
 StaticVector<Point3d>* Mesh::computeNormalsForPts()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighTris = getPtsNeighborTriangles();
-    StaticVector<Point3d>* nms = computeNormalsForPts(ptsNeighTris);
-    deleteArrayOfArrays<int>(&ptsNeighTris);
+    const PointsNeighborhood& ptsNeighTris = getAdjacency().getPtsNeighTris();
+
+    StaticVector<Point3d>* nms = new StaticVector<Point3d>();
+    nms->reserve(pts->size());
+    nms->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
+
+    #pragma omp parallel for
+    for(int i = 0; i < pts->size(); i++)
+    {
+        if(ptsNeighTris.size(i) > 0)
+            (*nms)[i] = computePtNormal(*this, ptsNeighTris.begin(i), ptsNeighTris.size(i));
+    }
     return nms;
 }
 
@@ -1328,39 +1890,12 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
     nms->reserve(pts->size());
     nms->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         StaticVector<int>* triTmp = (*ptsNeighTris)[i];
         if((triTmp != nullptr) && (triTmp->size() > 0))
-        {
-            Point3d n = Point3d(0.0f, 0.0f, 0.0f);
-            float nn = 0.0f;
-            for(int j = 0; j < triTmp->size(); j++)
-            {
-                Point3d n1 = computeTriangleNormal((*triTmp)[j]);
-                n1 = n1.normalize();
-                if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z) || (n1.x != n1.x) || (n1.y != n1.y) ||
-                   (n1.z != n1.z)) // check if is not NaN
-                {
-                    //
-                }
-                else
-                {
-                    n = n + computeTriangleNormal((*triTmp)[j]);
-                    nn += 1.0f;
-                }
-            }
-            n = n / nn;
-
-            n = n.normalize();
-            if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (n.x != n.x) || (n.y != n.y) ||
-               (n.z != n.z)) // check if is not NaN
-            {
-                n = Point3d(0.0f, 0.0f, 0.0f);
-            }
-
-            (*nms)[i] = n;
-        }
+            (*nms)[i] = computePtNormal(*this, &(*triTmp)[0], triTmp->size());
     }
 
     return nms;
@@ -1413,6 +1948,7 @@ void Mesh::removeFreePointsFromMesh(StaticVector<int>** out_ptIdToNewPtId)
 
     std::swap(cleanedMesh->pts, pts);
     std::swap(cleanedMesh->tris, tris);
+    invalidateAdjacency();
 
     delete cleanedMesh;
 }
@@ -1499,117 +2035,64 @@ StaticVector<Voxel>* Mesh::getTrianglesEdgesIds(StaticVector<StaticVector<int>*>
     return out;
 }
 
-void Mesh::subdivideMeshCase1(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId,
-                                 StaticVector<Mesh::triangle>* tris1)
+/**
+ * @brief Split a triangle along its split edges (1 to 3), the orientation is kept
+ * @param[in] t the triangle
+ * @param[in] edgesNewPts the new point of each edge (v[k], v[k+1]) or -1 if the edge is not split
+ * @param[out] out the 2 to 4 new triangles
+ * @return the number of new triangles
+ */
+static int splitTriangle(const Mesh::triangle& t, const int edgesNewPts[3], Mesh::triangle* out)
 {
-    int ii[5];
-    ii[0] = (*tris)[i].v[0];
-    ii[1] = (*tris)[i].v[1];
-    ii[2] = (*tris)[i].v[2];
-    ii[3] = (*tris)[i].v[0];
-    ii[4] = (*tris)[i].v[1];
-    for(int k = 0; k < 3; k++)
-    {
-        int a = ii[k];
-        int b = ii[k + 1];
-        int c = ii[k + 2];
-        if((((*edgesi)[neptIdEdgeId.y].x == a) && ((*edgesi)[neptIdEdgeId.y].y == b)) ||
-           (((*edgesi)[neptIdEdgeId.y].y == a) && ((*edgesi)[neptIdEdgeId.y].x == b)))
-        {
-            Mesh::triangle t;
-            t.alive = true;
-            t.v[0] = a;
-            t.v[1] = neptIdEdgeId.x;
-            t.v[2] = c;
-            tris1->push_back(t);
+    const auto makeTriangle = [](int a, int b, int c) {
+        Mesh::triangle tri;
+        tri.alive = true;
+        tri.v[0] = a;
+        tri.v[1] = b;
+        tri.v[2] = c;
+        return tri;
+    };
 
-            t.v[0] = neptIdEdgeId.x;
-            t.v[1] = b;
-            t.v[2] = c;
-            tris1->push_back(t);
-        }
+    const int n = (edgesNewPts[0] > -1) + (edgesNewPts[1] > -1) + (edgesNewPts[2] > -1);
+    if(n == 3)
+    {
+        const int m0 = edgesNewPts[0];
+        const int m1 = edgesNewPts[1];
+        const int m2 = edgesNewPts[2];
+        out[0] = makeTriangle(t.v[0], m0, m2);
+        out[1] = makeTriangle(m0, t.v[1], m1);
+        out[2] = makeTriangle(m1, t.v[2], m2);
+        out[3] = makeTriangle(m0, m1, m2);
+        return 4;
     }
-}
-
-void Mesh::subdivideMeshCase2(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId1, Pixel& neptIdEdgeId2,
-                                 StaticVector<Mesh::triangle>* tris1)
-{
-    int ii[5];
-    ii[0] = (*tris)[i].v[0];
-    ii[1] = (*tris)[i].v[1];
-    ii[2] = (*tris)[i].v[2];
-    ii[3] = (*tris)[i].v[0];
-    ii[4] = (*tris)[i].v[1];
-    for(int k = 0; k < 3; k++)
+    for(int k = 0; k < 3; ++k)
     {
-        int a = ii[k];
-        int b = ii[k + 1];
-        int c = ii[k + 2];
-        if(((((*edgesi)[neptIdEdgeId1.y].x == a) && ((*edgesi)[neptIdEdgeId1.y].y == b)) ||
-            (((*edgesi)[neptIdEdgeId1.y].y == a) && ((*edgesi)[neptIdEdgeId1.y].x == b))) &&
-           ((((*edgesi)[neptIdEdgeId2.y].x == b) && ((*edgesi)[neptIdEdgeId2.y].y == c)) ||
-            (((*edgesi)[neptIdEdgeId2.y].y == b) && ((*edgesi)[neptIdEdgeId2.y].x == c))))
+        const int a = t.v[k];
+        const int b = t.v[(k + 1) % 3];
+        const int c = t.v[(k + 2) % 3];
+        const int mab = edgesNewPts[k];
+        const int mbc = edgesNewPts[(k + 1) % 3];
+        if(n == 1 && mab > -1)
         {
-            Mesh::triangle t;
-            t.alive = true;
-            t.v[0] = a;
-            t.v[1] = neptIdEdgeId1.x;
-            t.v[2] = neptIdEdgeId2.x;
-            tris1->push_back(t);
-
-            t.v[0] = neptIdEdgeId1.x;
-            t.v[1] = b;
-            t.v[2] = neptIdEdgeId2.x;
-            tris1->push_back(t);
-
-            t.v[0] = neptIdEdgeId2.x;
-            t.v[1] = c;
-            t.v[2] = a;
-            tris1->push_back(t);
+            out[0] = makeTriangle(a, mab, c);
+            out[1] = makeTriangle(mab, b, c);
+            return 2;
+        }
+        if(n == 2 && mab > -1 && mbc > -1)
+        {
+            out[0] = makeTriangle(a, mab, mbc);
+            out[1] = makeTriangle(mab, b, mbc);
+            out[2] = makeTriangle(mbc, c, a);
+            return 3;
         }
     }
+    out[0] = t;
+    return 1;
 }
 
-void Mesh::subdivideMeshCase3(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId1, Pixel& neptIdEdgeId2,
-                                 Pixel& neptIdEdgeId3, StaticVector<Mesh::triangle>* tris1)
-{
-    int a = (*tris)[i].v[0];
-    int b = (*tris)[i].v[1];
-    int c = (*tris)[i].v[2];
-    if(((((*edgesi)[neptIdEdgeId1.y].x == a) && ((*edgesi)[neptIdEdgeId1.y].y == b)) ||
-        (((*edgesi)[neptIdEdgeId1.y].y == a) && ((*edgesi)[neptIdEdgeId1.y].x == b))) &&
-       ((((*edgesi)[neptIdEdgeId2.y].x == b) && ((*edgesi)[neptIdEdgeId2.y].y == c)) ||
-        (((*edgesi)[neptIdEdgeId2.y].y == b) && ((*edgesi)[neptIdEdgeId2.y].x == c))) &&
-       ((((*edgesi)[neptIdEdgeId3.y].x == c) && ((*edgesi)[neptIdEdgeId3.y].y == a)) ||
-        (((*edgesi)[neptIdEdgeId3.y].y == c) && ((*edgesi)[neptIdEdgeId3.y].x == a))))
-    {
-        Mesh::triangle t;
-        t.alive = true;
-        t.v[0] = a;
-        t.v[1] = neptIdEdgeId1.x;
-        t.v[2] = neptIdEdgeId3.x;
-        tris1->push_back(t);
-
-        t.v[0] = neptIdEdgeId1.x;
-        t.v[1] = b;
-        t.v[2] = neptIdEdgeId2.x;
-        tris1->push_back(t);
-
-        t.v[0] = neptIdEdgeId2.x;
-        t.v[1] = c;
-        t.v[2] = neptIdEdgeId3.x;
-        tris1->push_back(t);
-
-        t.v[0] = neptIdEdgeId1.x;
-        t.v[1] = neptIdEdgeId2.x;
-        t.v[2] = neptIdEdgeId3.x;
-        tris1->push_back(t);
-    }
-}
-
-void Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, std::string tmpDir, int maxMeshPts)
+void Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, int maxMeshPts)
 {
-    StaticVector<StaticVector<int>*>* trisCams = computeTrisCams(mp, tmpDir);
+    StaticVector<StaticVector<int>*>* trisCams = computeTrisCams(mp, 1);
     StaticVector<StaticVector<int>*>* trisCams1 = subdivideMesh(mp, maxTriArea, 0.0f, true, trisCams, maxMeshPts);
     deleteArrayOfArrays<int>(&trisCams);
     deleteArrayOfArrays<int>(&trisCams1);
@@ -1761,103 +2244,108 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
                            bool useMaxTrisAreaOrAvEdgeLength, StaticVector<StaticVector<int>*>* trisCams,
                            StaticVector<int>** trisCamsId)
 {
-
-    StaticVector<StaticVector<int>*>* edgesNeighTris;
-    StaticVector<Pixel>* edgesPointsPairs;
-    getNotOrientedEdges(&edgesNeighTris, &edgesPointsPairs);
-    StaticVector<Voxel>* trisEdges = getTrianglesEdgesIds(edgesNeighTris);
+    // the edges shared by the triangles, sorted by point ids
+    MeshAdjacency& adjacency = getAdjacency();
+    const std::vector<Pixel>& edgesPointsPairs = adjacency.getEdgesPointsPairs();
+    const PointsNeighborhood& edgesNeighTris = adjacency.getEdgesNeighTris();
+    const int nbTris = tris->size();
+    const int nbEdges = edgesPointsPairs.size();
+    const int nbPts = pts->size();
 
     // which triangles should be subdivided
-    int nTrisToSubdivide = 0;
-    StaticVectorBool* trisToSubdivide = new StaticVectorBool();
-    trisToSubdivide->reserve(tris->size());
-    for(int i = 0; i < tris->size(); i++)
+    std::vector<char> trisToSubdivide(nbTris, 0);
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < nbTris; ++i)
     {
-        int tcid = (*(*trisCamsId))[i];
+        const int tcid = (*(*trisCamsId))[i];
         bool subdivide = false;
 
         if(useMaxTrisAreaOrAvEdgeLength)
         {
-            for(int j = 0; j < sizeOfStaticVector<int>((*trisCams)[tcid]); j++)
+            for(int j = 0; j < sizeOfStaticVector<int>((*trisCams)[tcid]) && !subdivide; ++j)
             {
-                int rc = (*(*trisCams)[tcid])[j];
-                int w = mp->getWidth(rc);
-                int h = mp->getHeight(rc);
-                triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-                if(computeTriangleProjectionArea(tp) > maxTriArea)
-                {
-                    subdivide = true;
-                }
+                const int rc = (*(*trisCams)[tcid])[j];
+                triangle_proj tp = getTriangleProjection(i, mp, rc, mp->getWidth(rc), mp->getHeight(rc));
+                subdivide = (computeTriangleProjectionArea(tp) > maxTriArea);
             }
         }
         else
         {
-            if(computeTriangleMaxEdgeLength(i) > maxEdgeLength)
-            {
-                subdivide = true;
-            }
+            subdivide = (computeTriangleMaxEdgeLength(i) > maxEdgeLength);
         }
-
-        (*trisToSubdivide)[i] = subdivide;
-        nTrisToSubdivide += static_cast<int>(subdivide);
+        trisToSubdivide[i] = subdivide;
     }
 
-    // which edges are going to be subdivided
-    StaticVector<int>* edgesToSubdivide = new StaticVector<int>();
-    edgesToSubdivide->reserve(edgesNeighTris->size());
-    for(int i = 0; i < edgesNeighTris->size(); i++)
+    // which edges are going to be subdivided: the edges of the triangles to subdivide
+    std::vector<int> edgesNewPts(nbEdges, -1);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbEdges; ++i)
     {
-        bool hasNeigTriToSubdivide = false;
-        for(int j = 0; j < (*edgesNeighTris)[i]->size(); j++)
+        for(const int* it = edgesNeighTris.begin(i); it != edgesNeighTris.end(i); ++it)
         {
-            int idTri = (*(*edgesNeighTris)[i])[j];
-            if((*trisToSubdivide)[idTri])
+            if(trisToSubdivide[*it])
             {
-                hasNeigTriToSubdivide = true;
+                edgesNewPts[i] = 0;
+                break;
             }
         }
-        edgesToSubdivide->push_back((int)(hasNeigTriToSubdivide)-1);
     }
 
-    // assing id-s
-    int id = pts->size();
-    for(int i = 0; i < edgesToSubdivide->size(); i++)
+    // assign the ids of the new points
+    int id = nbPts;
+    for(int i = 0; i < nbEdges; ++i)
     {
-        if((*edgesToSubdivide)[i] > -1)
-        {
-            (*edgesToSubdivide)[i] = id;
-            id++;
-        }
+        if(edgesNewPts[i] > -1)
+            edgesNewPts[i] = id++;
     }
-    int nEdgesToSubdivide = id - pts->size();
+    const int nEdgesToSubdivide = id - nbPts;
 
-    // copy old pts
+    // new points ... middle of edge
     StaticVector<Point3d>* pts1 = new StaticVector<Point3d>();
-    pts1->reserve(pts->size() + nEdgesToSubdivide);
-    for(int i = 0; i < pts->size(); i++)
+    pts1->reserve(nbPts + nEdgesToSubdivide);
+    pts1->getDataWritable().assign(pts->getData().begin(), pts->getData().end());
+    pts1->resize(nbPts + nEdgesToSubdivide);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbEdges; ++i)
     {
-        pts1->push_back((*pts)[i]);
+        if(edgesNewPts[i] > -1)
+            (*pts1)[edgesNewPts[i]] = ((*pts)[edgesPointsPairs[i].x] + (*pts)[edgesPointsPairs[i].y]) / 2.0f;
     }
 
-    // add new pts ... middle of edge
-    for(int i = 0; i < edgesToSubdivide->size(); i++)
+    // the new point of each triangle edge (v[k], v[k+1]), the triangles with a split edge are subdivided
+    const auto getEdgeNewPt = [&](int a, int b) {
+        const Pixel edge(std::min(a, b), std::max(a, b));
+        const auto it = std::lower_bound(edgesPointsPairs.begin(), edgesPointsPairs.end(), edge,
+                                         [](const Pixel& e1, const Pixel& e2) { return e1.x < e2.x || (e1.x == e2.x && e1.y < e2.y); });
+        return edgesNewPts[it - edgesPointsPairs.begin()];
+    };
+
+    std::vector<int> trisEdgesNewPts(nbTris * 3);
+    std::vector<int> newTrisOffsets(nbTris + 1, 0);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
     {
-        if((*edgesToSubdivide)[i] > -1)
+        const Mesh::triangle& t = (*tris)[i];
+        int n = 0;
+        for(int k = 0; k < 3; ++k)
         {
-            Point3d p = ((*pts)[(*edgesPointsPairs)[i].x] + (*pts)[(*edgesPointsPairs)[i].y]) / 2.0f;
-            pts1->push_back(p);
+            const int newPt = getEdgeNewPt(t.v[k], t.v[(k + 1) % 3]);
+            trisEdgesNewPts[i * 3 + k] = newPt;
+            n += (newPt > -1);
         }
+        // 1 split edge: 2 triangles, 2: 3 triangles, 3: 4 triangles
+        newTrisOffsets[i + 1] = 1 + n;
     }
 
-    // there might be needed to subdivide more triangles ... find them
-    nTrisToSubdivide = 0;
-    for(int i = 0; i < tris->size(); i++)
+    int nTrisToSubdivide = 0;
+    for(int i = 0; i < nbTris; ++i)
     {
-        bool subdivide =
-            (((*edgesToSubdivide)[(*trisEdges)[i].x] > -1) || ((*edgesToSubdivide)[(*trisEdges)[i].y] > -1) ||
-             ((*edgesToSubdivide)[(*trisEdges)[i].z] > -1));
-        (*trisToSubdivide)[i] = subdivide;
-        nTrisToSubdivide += static_cast<int>(subdivide);
+        nTrisToSubdivide += (newTrisOffsets[i + 1] > 1);
+        newTrisOffsets[i + 1] += newTrisOffsets[i];
     }
 
     ALICEVISION_LOG_INFO("\t- # triangles to subdivide: " << nTrisToSubdivide);
@@ -1865,89 +2353,28 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
 
     StaticVector<int>* trisCamsId1 = new StaticVector<int>();
     StaticVector<Mesh::triangle>* tris1 = new StaticVector<Mesh::triangle>();
+    trisCamsId1->resize(newTrisOffsets[nbTris]);
+    tris1->resize(newTrisOffsets[nbTris]);
 
-    trisCamsId1->reserve(tris->size() - nTrisToSubdivide + 4 * nTrisToSubdivide);
-    tris1->reserve(tris->size() - nTrisToSubdivide + 4 * nTrisToSubdivide);
-
-    for(int i = 0; i < tris->size(); i++)
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
     {
-        if((*trisToSubdivide)[i])
-        {
-            Pixel newPtsIds[3];
-            newPtsIds[0].x = (*edgesToSubdivide)[(*trisEdges)[i].x]; // new pt id
-            newPtsIds[0].y = (*trisEdges)[i].x;                      // edge id
-            newPtsIds[1].x = (*edgesToSubdivide)[(*trisEdges)[i].y];
-            newPtsIds[1].y = (*trisEdges)[i].y;
-            newPtsIds[2].x = (*edgesToSubdivide)[(*trisEdges)[i].z];
-            newPtsIds[2].y = (*trisEdges)[i].z;
-
-            qsort(&newPtsIds[0], 3, sizeof(Pixel), qSortComparePixelByXDesc);
-
-            int n = 0;
-            while((n < 3) && (newPtsIds[n].x > -1))
-            {
-                n++;
-            }
-
-            if(n == 0)
-            {
-                ALICEVISION_LOG_ERROR("subdivideMesh: Bad condition.");
-            }
-
-            if(n == 1)
-            {
-                subdivideMeshCase1(i, edgesPointsPairs, newPtsIds[0], tris1);
-
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-            }
-
-            if(n == 2)
-            {
-                subdivideMeshCase2(i, edgesPointsPairs, newPtsIds[0], newPtsIds[1], tris1);
-                subdivideMeshCase2(i, edgesPointsPairs, newPtsIds[1], newPtsIds[0], tris1);
-
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-            }
-
-            if(n == 3)
-            {
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[0], newPtsIds[1], newPtsIds[2], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[0], newPtsIds[2], newPtsIds[1], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[1], newPtsIds[0], newPtsIds[2], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[1], newPtsIds[2], newPtsIds[0], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[2], newPtsIds[0], newPtsIds[1], tris1);
-                subdivideMeshCase3(i, edgesPointsPairs, newPtsIds[2], newPtsIds[1], newPtsIds[0], tris1);
-
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-                trisCamsId1->push_back((*(*trisCamsId))[i]);
-            }
-        }
-        else
-        {
-            tris1->push_back((*tris)[i]);
-            trisCamsId1->push_back((*(*trisCamsId))[i]);
-        }
+        const int nbNewTris = splitTriangle((*tris)[i], &trisEdgesNewPts[i * 3], &(*tris1)[newTrisOffsets[i]]);
+        if(nbNewTris != newTrisOffsets[i + 1] - newTrisOffsets[i])
+            ALICEVISION_LOG_ERROR("subdivideMesh: Bad condition.");
+        for(int j = newTrisOffsets[i]; j < newTrisOffsets[i + 1]; ++j)
+            (*trisCamsId1)[j] = (*(*trisCamsId))[i];
     }
 
     delete pts;
     delete tris;
     pts = pts1;
     tris = tris1;
+    invalidateAdjacency();
 
     delete(*trisCamsId);
     (*trisCamsId) = trisCamsId1;
 
-    deleteArrayOfArrays<int>(&edgesNeighTris);
-    delete edgesPointsPairs;
-    delete trisEdges;
-    delete trisToSubdivide;
-    delete edgesToSubdivide;
-
     return nTrisToSubdivide;
 }
 
@@ -1982,6 +2409,7 @@ void Mesh::letJustTringlesIdsInMesh(StaticVector<int>* trisIdsToStay)
 
     delete tris;
     tris = trisTmp;
+    invalidateAdjacency();
 }
 
 StaticVector<StaticVector<int>*>* Mesh::computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir)
@@ -2047,12 +2475,85 @@ StaticVector<StaticVector<int>*>* Mesh::computeTrisCams(const mvsUtils::MultiVie
     return trisCams;
 }
 
+StaticVector<StaticVector<int>*>* Mesh::computeTrisCams(const mvsUtils::MultiViewParams* mp, int scale, bool useGpu) const
+{
+    ALICEVISION_LOG_INFO("Computing the visible triangles of " << mp->ncams << " cameras (z-buffers downscale: " << scale << ").");
+
+    // visible triangles of each camera
+    std::vector<std::vector<int>> camsVisTris(mp->ncams);
+    bool done = false;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    if(useGpu && texturingCUDA_isAvailable())
+    {
+        std::vector<double> points;
+        points.reserve(pts->size() * 3);
+        for(const Point3d& p : *pts)
+            points.insert(points.end(), {p.x, p.y, p.z});
+        std::vector<int> triangles;
+        triangles.reserve(tris->size() * 3);
+        for(const Mesh::triangle& t : *tris)
+            triangles.insert(triangles.end(), {t.v[0], t.v[1], t.v[2]});
+
+        // the mesh is uploaded once for all the cameras
+        VisibilityMeshCUDA mesh;
+        done = mesh.upload(points, triangles);
+        for(int rc = 0; done && rc < mp->ncams; ++rc)
+        {
+            const Matrix3x4 P = getZBufferProjection(*mp, rc, scale);
+            done = mesh.getVisibleTriangles(P.m, (mp->getWidth(rc) + scale - 1) / scale, (mp->getHeight(rc) + scale - 1) / scale,
+                                            camsVisTris[rc]);
+        }
+        if(!done)
+            ALICEVISION_LOG_WARNING("CUDA error during the visibility rasterization, switching to the CPU.");
+    }
+#endif
+
+    if(!done)
+    {
+        #pragma omp parallel for schedule(dynamic)
+        for(int rc = 0; rc < mp->ncams; ++rc)
+            getVisibleTrianglesZBuffer(*mp, rc, scale, camsVisTris[rc]);
+    }
+
+    // cameras of each triangle, in ascending order
+    std::vector<int> ntrisCams(tris->size(), 0);
+    for(const std::vector<int>& visTris : camsVisTris)
+    {
+        for(int idTri : visTris)
+            ++ntrisCams[idTri];
+    }
+
+    StaticVector<StaticVector<int>*>* trisCams = new StaticVector<StaticVector<int>*>();
+    trisCams->reserve(tris->size());
+    for(int i = 0; i < tris->size(); ++i)
+    {
+        StaticVector<int>* cams = nullptr;
+        if(ntrisCams[i] > 0)
+        {
+            cams = new StaticVector<int>();
+            cams->reserve(ntrisCams[i]);
+        }
+        trisCams->push_back(cams);
+    }
+
+    for(int rc = 0; rc < mp->ncams; ++rc)
+    {
+        for(int idTri : camsVisTris[rc])
+            (*trisCams)[idTri]->push_back(rc);
+    }
+
+    return trisCams;
+}
+
 StaticVector<StaticVector<int>*>* Mesh::computeTrisCamsFromPtsCams(StaticVector<StaticVector<int>*>* ptsCams) const
 {
     // TODO: try intersection
     StaticVector<StaticVector<int>*>* trisCams = new StaticVector<StaticVector<int>*>();
     trisCams->reserve(tris->size());
+    trisCams->resize_with(tris->size(), nullptr);
 
+#pragma omp parallel for
     for(int idTri = 0; idTri < tris->size(); idTri++)
     {
         int maxcams = sizeOfStaticVector<int>((*ptsCams)[(*tris)[idTri].v[0]]) +
@@ -2067,7 +2568,7 @@ StaticVector<StaticVector<int>*>* Mesh::computeTrisCamsFromPtsCams(StaticVector<
                 cams->push_back_distinct((*(*ptsCams)[(*tris)[idTri].v[k]])[i]);
             }
         }
-        trisCams->push_back(cams);
+        (*trisCams)[idTri] = cams;
     }
 
     return trisCams;
@@ -2089,6 +2590,7 @@ void Mesh::initFromDepthMap(int stepDetail, const mvsUtils::MultiViewParams* mp,
     int w = mp->getWidth(rc) / (scale * step);
     int h = mp->getHeight(rc) / (scale * step);
 
+    invalidateAdjacency();
     pts = new StaticVector<Point3d>();
     pts->reserve(w * h);
     StaticVectorBool* usedMap = new StaticVectorBool();
@@ -2260,6 +2762,7 @@ void Mesh::invertTriangleOrientations()
         Mesh::triangle& t = (*tris)[i];
         std::swap(t.v[1], t.v[2]);
     }
+    invalidateAdjacency();
 }
 
 void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
@@ -2271,6 +2774,7 @@ void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
             (*tris)[triId].v[k] = newPtId;
         }
     }
+    invalidateAdjacency();
 }
 
 int Mesh::getTriPtIndex(int triId, int ptId, bool failIfDoesNotExists)
@@ -2338,7 +2842,7 @@ bool Mesh::isTriangleObtuse(int triId)
 
 StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighPtsOrdered = getPtsNeighPtsOrdered();
+    const PointsNeighborhood& ptsNeighPtsOrdered = getAdjacency().getPtsNeighPtsOrdered();
 
     StaticVector<int>* colors = new StaticVector<int>();
     colors->reserve(pts->size());
@@ -2370,13 +2874,12 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
                 {
                     delete colors;
                     delete buff;
-                    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
                     throw std::runtime_error("getLargestConnectedComponentTrisIds: bad condition.");
                 }
             }
-            for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[ptid]); ++j)
+            for(int j = 0; j < ptsNeighPtsOrdered.size(ptid); ++j)
             {
-                int nptid = (*(*ptsNeighPtsOrdered)[ptid])[j];
+                int nptid = ptsNeighPtsOrdered.begin(ptid)[j];
                 if((nptid > -1) && ((*colors)[nptid] == -1))
                 {
                     if(buff->size() >= buff->capacity()) // should not happen but no problem
@@ -2412,56 +2915,213 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
 
     delete colors;
     delete buff;
-    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
 
     return out;
 }
 
+namespace {
+
+enum class EObjLine
+{
+    OTHER,
+    MATERIAL,
+    VERTEX,
+    NORMAL,
+    UV_COORD,
+    FACET
+};
+
+EObjLine getObjLineType(const std::string& line)
+{
+    if(line.size() < 3 || line[0] == '#')
+        return EObjLine::OTHER;
+    if(mvsUtils::findNSubstrsInString(line, "usemtl") == 1)
+        return EObjLine::MATERIAL;
+    if((line[0] == 'v') && (line[1] == ' '))
+        return EObjLine::VERTEX;
+    if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
+        return EObjLine::NORMAL;
+    if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
+        return EObjLine::UV_COORD;
+    if((line[0] == 'f') && (line[1] == ' '))
+        return EObjLine::FACET;
+    return EObjLine::OTHER;
+}
+
+/**
+ * @brief Syntax of an OBJ facet line
+ * @param[out] nbTris number of triangles: 1 for a triangle, 2 for a quad, 0 if not recognized
+ */
+void getObjFacetSyntax(const std::string& line, int& nbTris, bool& withUV, bool& withNormal)
+{
+    const int n1 = mvsUtils::findNSubstrsInString(line, "/");
+    const int n2 = mvsUtils::findNSubstrsInString(line, "//");
+    nbTris = 0;
+    withUV = false;
+    withNormal = false;
+    if(n2 == 0)
+    {
+        if(n1 == 0 || n1 == 3 || n1 == 6)
+            nbTris = 1;
+        else if(n1 == 4 || n1 == 8)
+            nbTris = 2;
+        withUV = (nbTris != 0) && (n1 != 0);
+        withNormal = (n1 == 6) || (n1 == 8);
+    }
+    else
+    {
+        if(n2 == 3)
+            nbTris = 1;
+        else if(n2 == 4)
+            nbTris = 2;
+        withNormal = (nbTris != 0);
+    }
+}
+
+/**
+ * @brief Part of an OBJ file, made of whole lines, counted then parsed by a thread
+ */
+struct ObjChunk
+{
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    int nbPts = 0;
+    int nbNormals = 0;
+    int nbUVs = 0;
+    int nbTris = 0;
+    int nbTrisWithUV = 0;
+    int nbTrisWithNormal = 0;
+    /// materials used in the chunk, in order
+    std::vector<std::string> materials;
+    /// material at the beginning of the chunk
+    int mtlId = -1;
+
+    /// call f(line) on each line of the chunk
+    template <typename F>
+    void forEachLine(const char* data, F f) const
+    {
+        std::string line;
+        std::size_t pos = begin;
+        while(pos < end)
+        {
+            const char* eol = static_cast<const char*>(std::memchr(data + pos, '\n', end - pos));
+            const std::size_t lineEnd = eol ? (eol - data) : end;
+            line.assign(data + pos, lineEnd - pos);
+            pos = lineEnd + 1;
+            f(line);
+        }
+    }
+};
+
+std::string getObjMaterialName(const std::string& line)
+{
+    char buff[5000];
+    sscanf(line.c_str(), "usemtl %s", buff);
+    return buff;
+}
+
+} // namespace
+
 bool Mesh::loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVector<Point3d>& normals,
                                StaticVector<Voxel>& trisNormalsIds, StaticVector<Point2d>& uvCoords,
                                StaticVector<Voxel>& trisUvIds, std::string objAsciiFileName)
 {
     ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
-    // read number of points, triangles, uvcoords
+
+    if(!bfs::exists(objAsciiFileName) || bfs::file_size(objAsciiFileName) == 0)
+        return false;
+
+    // map the file, it is split in chunks of whole lines counted then parsed in parallel
+    boost::iostreams::mapped_file_source file(objAsciiFileName);
+    if(!file.is_open())
+        return false;
+
+    const char* data = file.data();
+    const std::size_t fileSize = file.size();
+    const std::size_t chunkSize = 4 * 1024 * 1024;
+
+    std::vector<ObjChunk> chunks((fileSize + chunkSize - 1) / chunkSize);
+    for(std::size_t i = 1; i < chunks.size(); ++i)
+    {
+        // a chunk starts after the end of line preceding its nominal start
+        const std::size_t start = std::max(i * chunkSize - 1, chunks[i - 1].begin);
+        const char* eol = static_cast<const char*>(std::memchr(data + start, '\n', fileSize - start));
+        chunks[i].begin = eol ? (eol - data + 1) : fileSize;
+        chunks[i - 1].end = chunks[i].begin;
+    }
+    chunks.back().end = fileSize;
+
+    // count the elements of each chunk
+    bool hasInvalidFacet = false;
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < chunks.size(); ++c)
+    {
+        ObjChunk& chunk = chunks[c];
+        chunk.forEachLine(data, [&](const std::string& line)
+        {
+            switch(getObjLineType(line))
+            {
+                case EObjLine::MATERIAL: chunk.materials.push_back(getObjMaterialName(line)); break;
+                case EObjLine::VERTEX: ++chunk.nbPts; break;
+                case EObjLine::NORMAL: ++chunk.nbNormals; break;
+                case EObjLine::UV_COORD: ++chunk.nbUVs; break;
+                case EObjLine::FACET:
+                {
+                    int nbTris;
+                    bool withUV;
+                    bool withNormal;
+                    getObjFacetSyntax(line, nbTris, withUV, withNormal);
+                    if(nbTris == 0)
+                        hasInvalidFacet = true;
+                    chunk.nbTris += nbTris;
+                    chunk.nbTrisWithUV += withUV ? nbTris : 0;
+                    chunk.nbTrisWithNormal += withNormal ? nbTris : 0;
+                    break;
+                }
+                case EObjLine::OTHER: break;
+            }
+        });
+    }
+
+    if(hasInvalidFacet)
+    {
+        throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
+    }
+
+    // materials in order of appearance and elements offsets of each chunk
+    std::map<std::string, int> materialCache;
+    int mtlId = -1;
     int npts = 0;
     int ntris = 0;
     int nuvs = 0;
     int nnorms = 0;
-    int nlines = 0;
-
+    int ntrisWithUV = 0;
+    int ntrisWithNormal = 0;
+    for(ObjChunk& chunk : chunks)
     {
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-        while(getline(in, line))
+        chunk.mtlId = mtlId;
+        for(const std::string& material : chunk.materials)
         {
-            if((line[0] == 'v') && (line[1] == ' '))
-            {
-                npts += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                nnorms += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                nuvs += 1;
-            }
-            if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                if((n1 == 3 && n2 == 0) ||
-                   (n1 == 0 && n2 == 3) ||
-                   (n1 == 0 && n2 == 0))
-                    ntris += 1;
-                else if((n1 == 4 && n2 == 0) ||
-                        (n1 == 8 && n2 == 0) ||
-                        (n1 == 0 && n2 == 4))
-                    ntris += 2;
-            }
-            nlines++;
-        }
-        in.close();
+            auto it = materialCache.find(material);
+            if(it == materialCache.end())
+                materialCache.emplace(material, ++mtlId); // new material
+            else
+                mtlId = it->second;                       // already known material
+        }
+        std::swap(npts, chunk.nbPts);
+        std::swap(nnorms, chunk.nbNormals);
+        std::swap(nuvs, chunk.nbUVs);
+        std::swap(ntris, chunk.nbTris);
+        std::swap(ntrisWithUV, chunk.nbTrisWithUV);
+        std::swap(ntrisWithNormal, chunk.nbTrisWithNormal);
+        // the chunk now holds its offsets and the counters the offsets of the next chunk
+        npts += chunk.nbPts;
+        nnorms += chunk.nbNormals;
+        nuvs += chunk.nbUVs;
+        ntris += chunk.nbTris;
+        ntrisWithUV += chunk.nbTrisWithUV;
+        ntrisWithNormal += chunk.nbTrisWithNormal;
     }
 
     ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
@@ -2469,198 +3129,142 @@ bool Mesh::loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVec
       << "\t- # uv coordinates: " << nuvs << std::endl
       << "\t- # triangles: " << ntris);
 
+    invalidateAdjacency();
     pts = new StaticVector<Point3d>();
-    pts->reserve(npts);
+    pts->resize(npts);
     tris = new StaticVector<Mesh::triangle>();
-    tris->reserve(ntris);
-    uvCoords.reserve(nuvs);
-    trisUvIds.reserve(ntris);
-    normals.reserve(nnorms);
-    trisNormalsIds.reserve(ntris);
-    trisMtlIds.reserve(ntris);
-
-    std::map<std::string, int> materialCache;
-
-    {
-        int mtlId = -1;
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
+    tris->resize(ntris);
 
-        long t1 = mvsUtils::initEstimate();
-        int idline = 0;
-        while(getline(in, line))
-        {
-            if(line.size() < 3 || line[0] == '#')
-            {
-                // nothing to do
-            }
-            else if(mvsUtils::findNSubstrsInString(line, "usemtl") == 1)
-            {
-                char buff[5000];
-                sscanf(line.c_str(), "usemtl %s", buff);
-                auto it = materialCache.find(buff);
-                if(it == materialCache.end())
-                    materialCache.emplace(buff, ++mtlId); // new material
-                else
-                    mtlId = it->second;                   // already known material
-            }
-            else if((line[0] == 'v') && (line[1] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                pts->push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                // printf("%f %f %f\n", pt.x, pt.y, pt.z);
-                normals.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                Point2d pt;
-                sscanf(line.c_str(), "vt %lf %lf", &pt.x, &pt.y);
-                uvCoords.push_back(pt);
-            }
-            else if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                Voxel vertex, uvCoord, vertexNormal;
-                Voxel vertex2, uvCoord2, vertexNormal2;
-                bool ok = false;
-                bool withNormal = false;
-                bool withUV = false;
-                bool withQuad = false;
-                if(n2 == 0)
+    // the elements are appended to the given arrays
+    const int uvsStart = uvCoords.size();
+    const int trisUvsStart = trisUvIds.size();
+    const int normalsStart = normals.size();
+    const int trisNormalsStart = trisNormalsIds.size();
+    const int trisMtlStart = trisMtlIds.size();
+    uvCoords.resize(uvsStart + nuvs);
+    trisUvIds.resize(trisUvsStart + ntrisWithUV);
+    normals.resize(normalsStart + nnorms);
+    trisNormalsIds.resize(trisNormalsStart + ntrisWithNormal);
+    trisMtlIds.resize(trisMtlStart + ntris);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < chunks.size(); ++c)
+    {
+        const ObjChunk& chunk = chunks[c];
+        int mtlId = chunk.mtlId;
+        int ptId = chunk.nbPts;
+        int normalId = normalsStart + chunk.nbNormals;
+        int uvId = uvsStart + chunk.nbUVs;
+        int triId = chunk.nbTris;
+        int triUvId = trisUvsStart + chunk.nbTrisWithUV;
+        int triNormalId = trisNormalsStart + chunk.nbTrisWithNormal;
+
+        chunk.forEachLine(data, [&](const std::string& line)
+        {
+            switch(getObjLineType(line))
+            {
+                case EObjLine::MATERIAL:
+                {
+                    mtlId = materialCache.at(getObjMaterialName(line));
+                    break;
+                }
+                case EObjLine::VERTEX:
+                {
+                    Point3d& pt = (*pts)[ptId++];
+                    sscanf(line.c_str(), "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
+                    break;
+                }
+                case EObjLine::NORMAL:
+                {
+                    Point3d& pt = normals[normalId++];
+                    sscanf(line.c_str(), "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
+                    break;
+                }
+                case EObjLine::UV_COORD:
                 {
-                    if(n1 == 0)
+                    Point2d& pt = uvCoords[uvId++];
+                    sscanf(line.c_str(), "vt %lf %lf", &pt.x, &pt.y);
+                    break;
+                }
+                case EObjLine::FACET:
+                {
+                    int nbTris;
+                    bool withUV;
+                    bool withNormal;
+                    getObjFacetSyntax(line, nbTris, withUV, withNormal);
+                    const bool withQuad = (nbTris == 2);
+                    Voxel vertex, uvCoord, vertexNormal;
+                    Voxel vertex2, uvCoord2, vertexNormal2;
+
+                    if(!withUV && !withNormal)
                     {
                         sscanf(line.c_str(), "f %i %i %i", &vertex.x, &vertex.y, &vertex.z);
-                        ok = true;
                     }
-                    else if(n1 == 3)
+                    else if(withUV && !withNormal && !withQuad)
                     {
                         sscanf(line.c_str(), "f %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z);
-                        ok = true;
-                        withUV = true;
                     }
-                    else if(n1 == 6)
+                    else if(withUV && withNormal && !withQuad)
                     {
                         sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i", &vertex.x, &uvCoord.x, &vertexNormal.x, &vertex.y, &uvCoord.y, &vertexNormal.y,
                                &vertex.z, &uvCoord.z, &vertexNormal.z);
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
                     }
-                    else if(n1 == 4)
+                    else if(withUV && !withNormal)
                     {
                         sscanf(line.c_str(), "f %i/%i %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z, &vertex2.z, &uvCoord2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        ok = true;
-                        withUV = true;
-                        withQuad = true;
                     }
-                    else if(n1 == 8)
+                    else if(withUV)
                     {
                         sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i",
                                &vertex.x, &uvCoord.x, &vertexNormal.x,
                                &vertex.y, &uvCoord.y, &vertexNormal.y,
                                &vertex.z, &uvCoord.z, &vertexNormal.z,
                                &vertex2.z, &uvCoord2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                        withQuad = true;
                     }
-                }
-                else
-                {
-                    if(n2 == 3)
+                    else if(!withQuad)
                     {
                         sscanf(line.c_str(), "f %i//%i %i//%i %i//%i", &vertex.x, &vertexNormal.x, &vertex.y, &vertexNormal.y, &vertex.z, &vertexNormal.z);
-                        ok = true;
-                        withNormal = true;
                     }
-                    else if(n2 == 4)
+                    else
                     {
                         sscanf(line.c_str(), "f %i//%i %i//%i %i//%i %i//%i",
                                &vertex.x, &vertexNormal.x,
                                &vertex.y, &vertexNormal.y,
                                &vertex.z, &vertexNormal.z,
                                &vertex2.z, &vertexNormal2.z);
+                    }
+
+                    if(withQuad)
+                    {
                         vertex2.x = vertex.x; // same first point
+                        uvCoord2.x = uvCoord.x;
                         vertexNormal2.x = vertexNormal.x;
                         vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
+                        uvCoord2.y = uvCoord.z;
                         vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                if(!ok)
-                {
-                    throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
-                }
-
-                // 1st triangle
-                {
-                    triangle t;
-                    t.v[0] = vertex.x - 1;
-                    t.v[1] = vertex.y - 1;
-                    t.v[2] = vertex.z - 1;
-                    t.alive = true;
-                    tris->push_back(t);
-                    trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal - Voxel(1, 1, 1));
                     }
-                }
 
-                // potential 2nd triangle
-                if(withQuad)
-                {
-                    triangle t;
-                    t.v[0] = vertex2.x - 1;
-                    t.v[1] = vertex2.y - 1;
-                    t.v[2] = vertex2.z - 1;
-                    t.alive = true;
-                    tris->push_back(t);
-                    trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord2 - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
+                    // 1st triangle and potential 2nd triangle
+                    for(int k = 0; k < nbTris; ++k)
                     {
-                        trisNormalsIds.push_back(vertexNormal2 - Voxel(1, 1, 1));
+                        const Voxel& v = (k == 0) ? vertex : vertex2;
+                        (*tris)[triId] = triangle(v.x - 1, v.y - 1, v.z - 1);
+                        trisMtlIds[trisMtlStart + triId] = mtlId;
+                        ++triId;
+                        if(withUV)
+                            trisUvIds[triUvId++] = ((k == 0) ? uvCoord : uvCoord2) - Voxel(1, 1, 1);
+                        if(withNormal)
+                            trisNormalsIds[triNormalId++] = ((k == 0) ? vertexNormal : vertexNormal2) - Voxel(1, 1, 1);
                     }
+                    break;
                 }
+                case EObjLine::OTHER: break;
             }
+        });
+    }
 
-            mvsUtils::printfEstimate(idline, nlines, t1);
-            idline++;
-        }
-        mvsUtils::finishEstimate();
+    nmtls = materialCache.size();
 
-        in.close();
-        nmtls = materialCache.size();
-    }
     ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
     return npts != 0 && ntris != 0;
 }
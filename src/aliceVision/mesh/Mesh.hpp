@@ -14,9 +14,14 @@
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
+class MeshAdjacency;
+
 class Mesh
 {
 public:
@@ -102,6 +107,20 @@ public:
         }
     };
 
+    /**
+     * @brief Compressed neighborhood of the points (CSR layout):
+     *        the neighbors of the point i are ids[offsets[i]] to ids[offsets[i + 1] - 1]
+     */
+    struct PointsNeighborhood
+    {
+        std::vector<int> offsets;
+        std::vector<int> ids;
+
+        int size(int ptId) const { return offsets[ptId + 1] - offsets[ptId]; }
+        const int* begin(int ptId) const { return ids.data() + offsets[ptId]; }
+        const int* end(int ptId) const { return ids.data() + offsets[ptId + 1]; }
+    };
+
 public:
     StaticVector<Point3d>* pts = nullptr;
     StaticVector<Mesh::triangle>* tris = nullptr;
@@ -110,8 +129,18 @@ public:
     Mesh();
     ~Mesh();
 
+    /// Save as OBJ, binary PLY or native BIN depending on the file extension (OBJ by default)
+    void save(const std::string& filepath);
+    /// Load from OBJ, PLY or BIN depending on the file extension, the OBJ materials, normals and UVs are ignored
+    bool load(const std::string& filepath);
+
     void saveToObj(const std::string& filename);
 
+    /// Binary little endian PLY, the points are written as doubles
+    void saveToPly(const std::string& filename);
+    /// Binary little endian PLY, the polygons are triangulated as fans
+    bool loadFromPly(const std::string& filename);
+
     bool loadFromBin(std::string binFileName);
     void saveToBin(std::string binFileName);
     bool loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVector<Point3d>& normals,
@@ -127,6 +156,16 @@ public:
     void getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp, int rc,
                      int scale, int w, int h);
 
+    /// Triangles of each point sorted by index, built in parallel
+    void getPtsNeighborTriangles(PointsNeighborhood& out_ptsNeighTris) const;
+
+    /**
+     * @brief Adjacency cache, shared by the post-processings and rebuilt after a modification of the triangles
+     * @note The Mesh methods invalidate it, call invalidateAdjacency after a direct modification of the triangles
+     *       which keeps their number
+     */
+    MeshAdjacency& getAdjacency();
+    void invalidateAdjacency();
     StaticVector<StaticVector<int>*>* getPtsNeighborTriangles();
     StaticVector<StaticVector<int>*>* getPtsNeighPtsOrdered();
 
@@ -139,6 +178,17 @@ public:
     StaticVector<int>* getVisibleTrianglesIndexes(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w,
                                                   int h);
 
+    /**
+     * @brief Get the triangles visible in a camera from the z-buffer of the triangle indexes, rendered in memory:
+     *        a triangle is visible if it is the closest one at a pixel center, or if its center of gravity
+     *        is not hidden (triangles smaller than a pixel). The triangles behind the camera are not visible.
+     * @param[in] mp the cameras
+     * @param[in] rc the camera index
+     * @param[in] scale the downscale of the z-buffer relative to the image
+     * @param[out] out_visTris the visible triangles, sorted
+     */
+    void getVisibleTrianglesZBuffer(const mvsUtils::MultiViewParams& mp, int rc, int scale, std::vector<int>& out_visTris) const;
+
     Mesh* generateMeshFromTrianglesSubset(const StaticVector<int> &visTris, StaticVector<int>** out_ptIdToNewPtId) const;
 
     void getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris, StaticVector<Pixel>** edgesPointsPairs);
@@ -146,6 +196,8 @@ public:
 
     StaticVector<Point3d>* getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
                                                         double maximalNeighDist = -1.0f);
+    StaticVector<Point3d>* getLaplacianSmoothingVectors(const PointsNeighborhood& ptsNeighPts,
+                                                        double maximalNeighDist = -1.0f);
     void laplacianSmoothPts(float maximalNeighDist = -1.0f);
     void laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist = -1.0f);
     StaticVector<Point3d>* computeNormalsForPts();
@@ -180,22 +232,31 @@ public:
 
     Point2d getTrianglePixelInternalPoint(Mesh::triangle_proj* tp, Mesh::rectangle* re);
 
-    void subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, std::string tmpDir, int maxMeshPts);
+    void subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, int maxMeshPts);
     void subdivideMeshMaxEdgeLengthUpdatePtsCams(const mvsUtils::MultiViewParams* mp, float maxEdgeLength,
                                                  StaticVector<StaticVector<int>*>* ptsCams, int maxMeshPts);
     StaticVector<StaticVector<int>*>* subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, float maxEdgeLength,
                                                     bool useMaxTrisAreaOrAvEdgeLength,
                                                     StaticVector<StaticVector<int>*>* trisCams, int maxMeshPts);
+    /**
+     * @brief Subdivide once (one level) the triangles too large and their neighbors, in memory and in parallel.
+     *        Each split edge of the shared edges gets a single middle point.
+     * @return the number of subdivided triangles
+     */
     int subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, float maxEdgeLength, bool useMaxTrisAreaOrAvEdgeLength,
                       StaticVector<StaticVector<int>*>* trisCams, StaticVector<int>** trisCamsId);
-    void subdivideMeshCase1(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId,
-                            StaticVector<Mesh::triangle>* tris1);
-    void subdivideMeshCase2(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId1, Pixel& neptIdEdgeId2,
-                            StaticVector<Mesh::triangle>* tris1);
-    void subdivideMeshCase3(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId1, Pixel& neptIdEdgeId2,
-                            Pixel& neptIdEdgeId3, StaticVector<Mesh::triangle>* tris1);
 
     StaticVector<StaticVector<int>*>* computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir);
+
+    /**
+     * @brief Compute the cameras seeing each triangle from the z-buffers of all the cameras (see getVisibleTrianglesZBuffer),
+     *        rendered on the GPU if a CUDA device is available, else on the CPU with the cameras in parallel.
+     * @param[in] mp the cameras
+     * @param[in] scale the downscale of the z-buffers relative to the images
+     * @param[in] useGpu render on the GPU if available
+     * @return the cameras of each triangle in ascending order, nullptr for the triangles seen by no camera
+     */
+    StaticVector<StaticVector<int>*>* computeTrisCams(const mvsUtils::MultiViewParams* mp, int scale, bool useGpu = true) const;
     StaticVector<StaticVector<int>*>* computeTrisCamsFromPtsCams(StaticVector<StaticVector<int>*>* ptsCams) const;
 
     void initFromDepthMap(const mvsUtils::MultiViewParams* mp, float* depthMap, int rc, int scale, int step, float alpha);
@@ -218,6 +279,9 @@ public:
     bool getEdgeNeighTrisInterval(Pixel& itr, Pixel edge, StaticVector<Voxel>* edgesXStat,
                                   StaticVector<Voxel>* edgesXYStat);
     void Transform(Matrix3x3 Rs, Point3d t);
+
+private:
+    std::unique_ptr<MeshAdjacency> _adjacency;
 };
 
 } // namespace mesh
@@ -0,0 +1,270 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshAdjacency.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+std::size_t getMemorySize(const Mesh::PointsNeighborhood& neighborhood)
+{
+    return (neighborhood.offsets.capacity() + neighborhood.ids.capacity()) * sizeof(int);
+}
+
+} // namespace
+
+MeshAdjacency::MeshAdjacency(const Mesh& mesh)
+    : _mesh(mesh)
+    , _pts(mesh.pts)
+    , _tris(mesh.tris)
+    , _nbPts(sizeOfStaticVector<Point3d>(mesh.pts))
+    , _nbTris(sizeOfStaticVector<Mesh::triangle>(mesh.tris))
+{
+}
+
+bool MeshAdjacency::isValid() const
+{
+    return (_mesh.pts == _pts) && (_mesh.tris == _tris) && (sizeOfStaticVector<Point3d>(_mesh.pts) == _nbPts) &&
+           (sizeOfStaticVector<Mesh::triangle>(_mesh.tris) == _nbTris);
+}
+
+const Mesh::PointsNeighborhood& MeshAdjacency::getPtsNeighTris()
+{
+    if(!_hasPtsNeighTris)
+    {
+        _mesh.getPtsNeighborTriangles(_ptsNeighTris);
+        _hasPtsNeighTris = true;
+        updateMemoryCounter();
+    }
+    return _ptsNeighTris;
+}
+
+const Mesh::PointsNeighborhood& MeshAdjacency::getPtsNeighPtsOrdered()
+{
+    if(!_hasPtsNeighPtsOrdered)
+    {
+        buildPtsNeighPtsOrdered();
+        _hasPtsNeighPtsOrdered = true;
+        updateMemoryCounter();
+    }
+    return _ptsNeighPtsOrdered;
+}
+
+const std::vector<Pixel>& MeshAdjacency::getEdgesPointsPairs()
+{
+    if(!_hasEdges)
+    {
+        buildEdges();
+        _hasEdges = true;
+        updateMemoryCounter();
+    }
+    return _edgesPointsPairs;
+}
+
+const Mesh::PointsNeighborhood& MeshAdjacency::getEdgesNeighTris()
+{
+    if(!_hasEdges)
+    {
+        buildEdges();
+        _hasEdges = true;
+        updateMemoryCounter();
+    }
+    return _edgesNeighTris;
+}
+
+void MeshAdjacency::updateMemoryCounter()
+{
+    _memoryCounter.set(getMemorySize(_ptsNeighTris) + getMemorySize(_ptsNeighPtsOrdered) +
+                       _edgesPointsPairs.capacity() * sizeof(Pixel) + getMemorySize(_edgesNeighTris));
+}
+
+void MeshAdjacency::buildPtsNeighPtsOrdered()
+{
+    const Mesh::PointsNeighborhood& ptsNeighTris = getPtsNeighTris();
+    const StaticVector<Point3d>& pts = *_pts;
+    const StaticVector<Mesh::triangle>& tris = *_tris;
+
+    // the fan of a point has at most one point more than its triangles,
+    // the fans are written in these slots then compacted
+    std::vector<int> slotsOffsets(_nbPts + 1);
+    for(int i = 0; i <= _nbPts; ++i)
+        slotsOffsets[i] = ptsNeighTris.offsets[i] + i;
+    std::vector<int> slots(slotsOffsets[_nbPts]);
+    std::vector<int> nbNeighbors(_nbPts, 0);
+
+    #pragma omp parallel
+    {
+        std::vector<int> neighborTriangles;
+        std::vector<int> vhid;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(int middlePtId = 0; middlePtId < _nbPts; ++middlePtId)
+        {
+            neighborTriangles.assign(ptsNeighTris.begin(middlePtId), ptsNeighTris.end(middlePtId));
+            if(neighborTriangles.empty())
+                continue;
+
+            vhid.clear();
+            int currentTriPtId = tris[neighborTriangles[0]].v[0];
+            const int firstTriPtId = currentTriPtId;
+            vhid.push_back(currentTriPtId);
+
+            bool isThereTWithCurrentTriPtId = true;
+            while(!neighborTriangles.empty() && isThereTWithCurrentTriPtId)
+            {
+                isThereTWithCurrentTriPtId = false;
+
+                // find triangle with middlePtId and currentTriPtId and get remaining point id
+                for(int n = 0; n < neighborTriangles.size(); ++n)
+                {
+                    bool ok_middlePtId = false;
+                    bool ok_actTriPtId = false;
+                    int remainingPtId = -1;
+                    for(int k = 0; k < 3; ++k)
+                    {
+                        const int triPtId = tris[neighborTriangles[n]].v[k];
+                        const double length = (pts[middlePtId] - pts[triPtId]).size();
+                        if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
+                            remainingPtId = triPtId;
+                        if(triPtId == middlePtId)
+                            ok_middlePtId = true;
+                        if(triPtId == currentTriPtId)
+                            ok_actTriPtId = true;
+                    }
+
+                    if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
+                    {
+                        currentTriPtId = remainingPtId;
+                        neighborTriangles.erase(neighborTriangles.begin() + n);
+                        vhid.push_back(currentTriPtId);
+                        isThereTWithCurrentTriPtId = true; // we removed one, so we try again
+                        break;
+                    }
+                }
+            }
+
+            if(currentTriPtId == firstTriPtId)
+                vhid.pop_back(); // remove last ... which is first
+
+            // remove duplicates
+            int* slot = &slots[slotsOffsets[middlePtId]];
+            int nb = 0;
+            for(int id : vhid)
+            {
+                if(std::find(slot, slot + nb, id) == slot + nb)
+                    slot[nb++] = id;
+            }
+            nbNeighbors[middlePtId] = nb;
+        }
+    }
+
+    std::vector<int>& offsets = _ptsNeighPtsOrdered.offsets;
+    offsets.resize(_nbPts + 1);
+    offsets[0] = 0;
+    for(int i = 0; i < _nbPts; ++i)
+        offsets[i + 1] = offsets[i] + nbNeighbors[i];
+
+    std::vector<int>& ids = _ptsNeighPtsOrdered.ids;
+    ids.resize(offsets[_nbPts]);
+    #pragma omp parallel for
+    for(int i = 0; i < _nbPts; ++i)
+        std::copy_n(slots.begin() + slotsOffsets[i], nbNeighbors[i], ids.begin() + offsets[i]);
+}
+
+void MeshAdjacency::buildEdges()
+{
+    const Mesh::PointsNeighborhood& ptsNeighTris = getPtsNeighTris();
+    const StaticVector<Mesh::triangle>& tris = *_tris;
+
+    // each edge is stored by its smallest point id, with its triangles
+    const auto getPtEdges = [&](int ptId, std::vector<std::pair<int, int>>& ptEdges) {
+        ptEdges.clear();
+        int lastTriId = -1;
+        for(const int* it = ptsNeighTris.begin(ptId); it != ptsNeighTris.end(ptId); ++it)
+        {
+            // a triangle is listed once per occurrence of the point
+            if(*it == lastTriId)
+                continue;
+            lastTriId = *it;
+            const Mesh::triangle& t = tris[*it];
+            for(int k = 0; k < 3; ++k)
+            {
+                const int a = t.v[k];
+                const int b = t.v[(k + 1) % 3];
+                if(std::min(a, b) == ptId)
+                    ptEdges.emplace_back(std::max(a, b), *it);
+            }
+        }
+        std::sort(ptEdges.begin(), ptEdges.end());
+    };
+
+    std::vector<int> nbEdges(_nbPts, 0);
+    std::vector<int> nbEdgesTris(_nbPts, 0);
+
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, int>> ptEdges;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(int i = 0; i < _nbPts; ++i)
+        {
+            getPtEdges(i, ptEdges);
+            for(std::size_t j = 0; j < ptEdges.size(); ++j)
+            {
+                if(j == 0 || ptEdges[j].first != ptEdges[j - 1].first)
+                    ++nbEdges[i];
+            }
+            nbEdgesTris[i] = ptEdges.size();
+        }
+    }
+
+    std::vector<int> edgesOffsets(_nbPts + 1);
+    std::vector<int> edgesTrisOffsets(_nbPts + 1);
+    edgesOffsets[0] = 0;
+    edgesTrisOffsets[0] = 0;
+    for(int i = 0; i < _nbPts; ++i)
+    {
+        edgesOffsets[i + 1] = edgesOffsets[i] + nbEdges[i];
+        edgesTrisOffsets[i + 1] = edgesTrisOffsets[i] + nbEdgesTris[i];
+    }
+
+    _edgesPointsPairs.resize(edgesOffsets[_nbPts]);
+    _edgesNeighTris.offsets.resize(edgesOffsets[_nbPts] + 1);
+    _edgesNeighTris.offsets[edgesOffsets[_nbPts]] = edgesTrisOffsets[_nbPts];
+    _edgesNeighTris.ids.resize(edgesTrisOffsets[_nbPts]);
+
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, int>> ptEdges;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(int i = 0; i < _nbPts; ++i)
+        {
+            getPtEdges(i, ptEdges);
+            int edgeId = edgesOffsets[i] - 1;
+            int edgeTriId = edgesTrisOffsets[i];
+            for(std::size_t j = 0; j < ptEdges.size(); ++j)
+            {
+                if(j == 0 || ptEdges[j].first != ptEdges[j - 1].first)
+                {
+                    ++edgeId;
+                    _edgesPointsPairs[edgeId] = Pixel(i, ptEdges[j].first);
+                    _edgesNeighTris.offsets[edgeId] = edgeTriId;
+                }
+                _edgesNeighTris.ids[edgeTriId++] = ptEdges[j].second;
+            }
+        }
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
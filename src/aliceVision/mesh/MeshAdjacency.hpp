@@ -0,0 +1,72 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Adjacency of a mesh in CSR layout, each neighborhood is built in parallel on its first request.
+ *
+ * It is owned by the mesh (see Mesh::getAdjacency) and shared by the post-processings,
+ * the Mesh methods changing the triangles invalidate it.
+ */
+class MeshAdjacency
+{
+public:
+    explicit MeshAdjacency(const Mesh& mesh);
+
+    /// false if the points or the triangles have been reallocated or resized since the construction
+    bool isValid() const;
+
+    /// Triangles of each point, sorted by index
+    const Mesh::PointsNeighborhood& getPtsNeighTris();
+
+    /**
+     * @brief Neighboring points of each point, ordered along the triangles fan (as Mesh::getPtsNeighPtsOrdered)
+     * @note the degenerated edges are detected from the points positions at build time
+     */
+    const Mesh::PointsNeighborhood& getPtsNeighPtsOrdered();
+
+    /// Not oriented edges (point ids pairs, x < y), sorted by x then y
+    const std::vector<Pixel>& getEdgesPointsPairs();
+
+    /// Triangles of each edge of getEdgesPointsPairs, sorted by index
+    const Mesh::PointsNeighborhood& getEdgesNeighTris();
+
+private:
+    void buildPtsNeighPtsOrdered();
+    void buildEdges();
+    /// Report the size of the built neighborhoods to the system::MemoryAccounting
+    void updateMemoryCounter();
+
+    const Mesh& _mesh;
+    const StaticVector<Point3d>* _pts;
+    const StaticVector<Mesh::triangle>* _tris;
+    int _nbPts;
+    int _nbTris;
+
+    bool _hasPtsNeighTris = false;
+    bool _hasPtsNeighPtsOrdered = false;
+    bool _hasEdges = false;
+
+    Mesh::PointsNeighborhood _ptsNeighTris;
+    Mesh::PointsNeighborhood _ptsNeighPtsOrdered;
+    std::vector<Pixel> _edgesPointsPairs;
+    Mesh::PointsNeighborhood _edgesNeighTris;
+
+    system::MemoryCounter _memoryCounter{"mesh.adjacency"};
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -7,6 +7,10 @@
 #include "MeshClean.hpp"
 #include <aliceVision/system/Logger.hpp>
 
+#include <exception>
+#include <set>
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -888,17 +892,116 @@ void MeshClean::testPtsNeighPtsOrdered()
     }
 }
 
+void MeshClean::getPtNeighPtsGreaterThan(int ptId, int maxPtId, std::vector<int>& out_ptsIds)
+{
+    out_ptsIds.clear();
+    StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[ptId];
+    for(int i = 0; i < sizeOfStaticVector<int>(ptNeighTris); i++)
+    {
+        const Mesh::triangle& t = (*tris)[(*ptNeighTris)[i]];
+        for(int k = 0; k < 3; k++)
+        {
+            if((t.v[k] > ptId) && (t.v[k] < maxPtId))
+                out_ptsIds.push_back(t.v[k]);
+        }
+    }
+}
+
 int MeshClean::cleanMesh()
 {
+    // The points are cleaned as if they were processed sequentially by increasing index:
+    // a point is only modified by the splitting of the points sharing a triangle with it,
+    // so the points without a wrong point of lower index in their triangles are independent
+    // and processed in parallel, the others are processed sequentially in the same order.
     int nWrongPts = 0;
-    int nv = pts->size();
+    const int nv = pts->size();
+
+    std::exception_ptr exception;
+
+    // find the points to split from the current state
+    std::vector<char> isDependent(nv, 0);
+    {
+        std::vector<char> isWrong(nv, 0);
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for(int i = 0; i < nv; i++)
+        {
+            try
+            {
+                path pth(this, i);
+                isWrong[i] = (sizeOfStaticVector<int>((*ptsNeighTrisSortedAsc)[i]) > 0) && pth.isWrongPt();
+            }
+            catch(...)
+            {
+                #pragma omp critical
+                exception = std::current_exception();
+            }
+        }
+        if(exception)
+            std::rethrow_exception(exception);
+
+        std::vector<int> neighPts;
+        for(int i = 0; i < nv; i++)
+        {
+            if(!isWrong[i])
+                continue;
+            isDependent[i] = 1;
+            getPtNeighPtsGreaterThan(i, nv, neighPts);
+            for(int neighPtId : neighPts)
+                isDependent[neighPtId] = 1;
+        }
+    }
+
+    // independent points: only their own neighborhood is updated
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < nv; i++)
+    {
+        if(isDependent[i])
+            continue;
+        try
+        {
+            path pth(this, i);
+            pth.deployAll();
+        }
+        catch(...)
+        {
+            #pragma omp critical
+            exception = std::current_exception();
+        }
+    }
+    if(exception)
+        std::rethrow_exception(exception);
+
+    // dependent points, by increasing index
+    std::set<int> toProcess;
+    int nDependentPts = 0;
     for(int i = 0; i < nv; i++)
     {
-        path pth(this, i);
-        nWrongPts += static_cast<int>(pth.deployAll() > 0);
+        if(isDependent[i])
+            toProcess.insert(i);
+    }
+
+    std::vector<int> neighPts;
+    while(!toProcess.empty())
+    {
+        const int ptId = *toProcess.begin();
+        toProcess.erase(toProcess.begin());
+        ++nDependentPts;
+
+        getPtNeighPtsGreaterThan(ptId, nv, neighPts);
+
+        path pth(this, ptId);
+        if(pth.deployAll() > 0)
+        {
+            ++nWrongPts;
+            // a point that became wrong after the splitting of a neighbor modifies its next neighbors too
+            toProcess.insert(neighPts.begin(), neighPts.end());
+        }
     }
+
     ALICEVISION_LOG_INFO("cleanMesh:" << std::endl
                       << "\t- # wrong points: " << nWrongPts << std::endl
+                      << "\t- # sequentially processed points: " << nDependentPts << std::endl
                       << "\t- # new points: " << (pts->size() - nv));
 
     return pts->size() - nv;
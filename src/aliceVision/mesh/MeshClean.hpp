@@ -10,6 +10,8 @@
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mesh/Mesh.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -92,10 +94,14 @@ public:
     void deallocateCleaningAttributes();
     void init();
 
+    /// Points of the triangles of ptId with an index in ]ptId, maxPtId[ (may contain duplicates)
+    void getPtNeighPtsGreaterThan(int ptId, int maxPtId, std::vector<int>& out_ptsIds);
+
     void testPtsNeighTrisSortedAsc();
     void testEdgesNeighTris();
     void testPtsNeighPtsOrdered();
 
+    /// @brief Split the non-manifold points, the independent points are processed in parallel
     int cleanMesh();
     int cleanMesh(int maxIters);
 };
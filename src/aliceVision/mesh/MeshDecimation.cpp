@@ -0,0 +1,432 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshDecimation.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// weight of the boundary planes relative to the triangles planes
+const double BOUNDARY_WEIGHT = 1000.0;
+
+/**
+ * @brief Symmetric 4x4 error quadric, stored as a2 ab ac ad b2 bc bd c2 cd d2
+ */
+struct Quadric
+{
+    double q[10] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    /// add the squared distance to the plane n.x + d = 0 (n unit)
+    void addPlane(const Point3d& n, double d, double weight)
+    {
+        q[0] += weight * n.x * n.x;
+        q[1] += weight * n.x * n.y;
+        q[2] += weight * n.x * n.z;
+        q[3] += weight * n.x * d;
+        q[4] += weight * n.y * n.y;
+        q[5] += weight * n.y * n.z;
+        q[6] += weight * n.y * d;
+        q[7] += weight * n.z * n.z;
+        q[8] += weight * n.z * d;
+        q[9] += weight * d * d;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for(int i = 0; i < 10; ++i)
+            q[i] += other.q[i];
+        return *this;
+    }
+
+    double evaluate(const Point3d& p) const
+    {
+        return q[0] * p.x * p.x + 2.0 * q[1] * p.x * p.y + 2.0 * q[2] * p.x * p.z + 2.0 * q[3] * p.x +
+               q[4] * p.y * p.y + 2.0 * q[5] * p.y * p.z + 2.0 * q[6] * p.y +
+               q[7] * p.z * p.z + 2.0 * q[8] * p.z + q[9];
+    }
+
+    /// position minimizing the error, false if the system is singular
+    bool optimize(Point3d& p) const
+    {
+        // cofactors of the symmetric 3x3 matrix
+        const double c00 = q[4] * q[7] - q[5] * q[5];
+        const double c01 = q[2] * q[5] - q[1] * q[7];
+        const double c02 = q[1] * q[5] - q[2] * q[4];
+        const double c11 = q[0] * q[7] - q[2] * q[2];
+        const double c12 = q[1] * q[2] - q[0] * q[5];
+        const double c22 = q[0] * q[4] - q[1] * q[1];
+        const double det = q[0] * c00 + q[1] * c01 + q[2] * c02;
+        const double trace = q[0] + q[4] + q[7];
+        if(std::abs(det) <= 1e-10 * trace * trace * trace)
+            return false;
+
+        p.x = -(c00 * q[3] + c01 * q[6] + c02 * q[8]) / det;
+        p.y = -(c01 * q[3] + c11 * q[6] + c12 * q[8]) / det;
+        p.z = -(c02 * q[3] + c12 * q[6] + c22 * q[8]) / det;
+        return true;
+    }
+};
+
+/**
+ * @brief An edge collapse: b is merged into a at pos
+ */
+struct Collapse
+{
+    double cost;
+    int a;
+    int b;
+    int nbTris;
+    Point3d pos;
+
+    bool operator<(const Collapse& other) const
+    {
+        if(cost != other.cost)
+            return cost < other.cost;
+        if(a != other.a)
+            return a < other.a;
+        return b < other.b;
+    }
+};
+
+/**
+ * @brief Neighboring points of a point with the number of alive triangles of each edge, sorted by point id
+ */
+void getPointRing(int ptId, const Mesh::PointsNeighborhood& ptsTris, const StaticVector<Mesh::triangle>& tris,
+                  std::vector<int>& tmp, std::vector<std::pair<int, int>>& out_ring)
+{
+    tmp.clear();
+    int lastTriId = -1;
+    for(const int* it = ptsTris.begin(ptId); it != ptsTris.end(ptId); ++it)
+    {
+        // a triangle is listed once per occurrence of the point
+        if(*it == lastTriId || !tris[*it].alive)
+            continue;
+        lastTriId = *it;
+        for(int k = 0; k < 3; ++k)
+        {
+            if(tris[*it].v[k] != ptId)
+                tmp.push_back(tris[*it].v[k]);
+        }
+    }
+    std::sort(tmp.begin(), tmp.end());
+
+    out_ring.clear();
+    for(int id : tmp)
+    {
+        if(out_ring.empty() || out_ring.back().first != id)
+            out_ring.emplace_back(id, 1);
+        else
+            ++out_ring.back().second;
+    }
+}
+
+/// true if no triangle moved by the collapse is flipped
+bool isCollapseWithoutFlip(int a, int b, const Point3d& pos, const Mesh::PointsNeighborhood& ptsTris,
+                           const StaticVector<Mesh::triangle>& tris, const StaticVector<Point3d>& pts)
+{
+    for(int ptId : {a, b})
+    {
+        for(const int* it = ptsTris.begin(ptId); it != ptsTris.end(ptId); ++it)
+        {
+            const Mesh::triangle& t = tris[*it];
+            if(!t.alive)
+                continue;
+            // the triangles of the edge are removed
+            if((t.v[0] == a || t.v[1] == a || t.v[2] == a) && (t.v[0] == b || t.v[1] == b || t.v[2] == b))
+                continue;
+
+            Point3d p[3];
+            for(int k = 0; k < 3; ++k)
+                p[k] = (t.v[k] == ptId) ? pos : pts[t.v[k]];
+            const Point3d nOld = cross(pts[t.v[1]] - pts[t.v[0]], pts[t.v[2]] - pts[t.v[0]]);
+            const Point3d nNew = cross(p[1] - p[0], p[2] - p[0]);
+            if(dot(nOld, nNew) <= 0.0)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void decimateMesh(Mesh& mesh, const DecimationParams& params)
+{
+    if(params.maxNbPts <= 0 && params.maxNbTris <= 0 && params.maxError <= 0.0)
+    {
+        ALICEVISION_LOG_WARNING("Mesh decimation: no stop criterion, the mesh is unchanged.");
+        return;
+    }
+
+    StaticVector<Point3d>& pts = *mesh.pts;
+    StaticVector<Mesh::triangle>& tris = *mesh.tris;
+    const int nbPts = pts.size();
+
+    Mesh::PointsNeighborhood ptsTris;
+    mesh.getPtsNeighborTriangles(ptsTris);
+
+    // initial quadrics: triangles planes weighted by their area, and boundary planes
+    std::vector<Quadric> quadrics(nbPts);
+    int nbAlivePts = 0;
+    int nbAliveTris = 0;
+
+    #pragma omp parallel
+    {
+        std::vector<int> tmp;
+        std::vector<std::pair<int, int>> ring;
+
+        #pragma omp for schedule(dynamic, 1024) reduction(+:nbAlivePts)
+        for(int a = 0; a < nbPts; ++a)
+        {
+            getPointRing(a, ptsTris, tris, tmp, ring);
+            if(ring.empty())
+                continue;
+            ++nbAlivePts;
+
+            Quadric& q = quadrics[a];
+            int lastTriId = -1;
+            for(const int* it = ptsTris.begin(a); it != ptsTris.end(a); ++it)
+            {
+                if(*it == lastTriId || !tris[*it].alive)
+                    continue;
+                lastTriId = *it;
+                const Mesh::triangle& t = tris[*it];
+                Point3d n = cross(pts[t.v[1]] - pts[t.v[0]], pts[t.v[2]] - pts[t.v[0]]);
+                const double area2 = n.size();
+                if(area2 <= 0.0)
+                    continue;
+                n = n / area2;
+                q.addPlane(n, -dot(n, pts[t.v[0]]), area2 * 0.5);
+            }
+
+            for(const auto& neighbor : ring)
+            {
+                if(neighbor.second != 1)
+                    continue;
+                // boundary edge: plane through the edge, orthogonal to its triangle
+                const int b = neighbor.first;
+                for(const int* it = ptsTris.begin(a); it != ptsTris.end(a); ++it)
+                {
+                    const Mesh::triangle& t = tris[*it];
+                    if(!t.alive || (t.v[0] != b && t.v[1] != b && t.v[2] != b))
+                        continue;
+                    const Point3d nt = cross(pts[t.v[1]] - pts[t.v[0]], pts[t.v[2]] - pts[t.v[0]]);
+                    const Point3d e = pts[b] - pts[a];
+                    Point3d n = cross(e, nt);
+                    const double len = n.size();
+                    if(len > 0.0)
+                    {
+                        n = n / len;
+                        q.addPlane(n, -dot(n, pts[a]), BOUNDARY_WEIGHT * dot(e, e));
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    for(int i = 0; i < tris.size(); ++i)
+    {
+        if(tris[i].alive)
+            ++nbAliveTris;
+    }
+
+    ALICEVISION_LOG_INFO("Mesh decimation: " << nbAlivePts << " points and " << nbAliveTris << " triangles.");
+
+    const auto isTargetReached = [&]()
+    {
+        return (params.maxNbPts > 0 && nbAlivePts <= params.maxNbPts) ||
+               (params.maxNbTris > 0 && nbAliveTris <= params.maxNbTris);
+    };
+
+    std::vector<char> isBoundary(nbPts);
+    std::vector<char> isLocked(nbPts);
+    std::vector<Collapse> candidates;
+    std::vector<Collapse> collapses;
+    int pass = 0;
+
+    while(!isTargetReached())
+    {
+        if(pass > 0)
+            mesh.getPtsNeighborTriangles(ptsTris);
+
+        // boundary points
+        #pragma omp parallel
+        {
+            std::vector<int> tmp;
+            std::vector<std::pair<int, int>> ring;
+
+            #pragma omp for schedule(dynamic, 1024)
+            for(int a = 0; a < nbPts; ++a)
+            {
+                getPointRing(a, ptsTris, tris, tmp, ring);
+                isBoundary[a] = std::any_of(ring.begin(), ring.end(), [](const std::pair<int, int>& n) { return n.second == 1; });
+            }
+        }
+
+        // valid collapses of each edge, listed from its smallest point id
+        candidates.clear();
+        #pragma omp parallel
+        {
+            std::vector<int> tmp;
+            std::vector<std::pair<int, int>> ringA;
+            std::vector<std::pair<int, int>> ringB;
+            std::vector<Collapse> localCandidates;
+
+            #pragma omp for schedule(dynamic, 1024) nowait
+            for(int a = 0; a < nbPts; ++a)
+            {
+                getPointRing(a, ptsTris, tris, tmp, ringA);
+                for(const auto& neighbor : ringA)
+                {
+                    const int b = neighbor.first;
+                    const int nbEdgeTris = neighbor.second;
+                    if(b < a || nbEdgeTris > 2)
+                        continue;
+                    // a boundary point only moves along the boundary
+                    if((isBoundary[a] || isBoundary[b]) && nbEdgeTris != 1)
+                        continue;
+
+                    // link condition: the common neighbors are the opposite points of the edge triangles
+                    getPointRing(b, ptsTris, tris, tmp, ringB);
+                    int nbCommon = 0;
+                    for(std::size_t i = 0, j = 0; i < ringA.size() && j < ringB.size();)
+                    {
+                        if(ringA[i].first < ringB[j].first)
+                            ++i;
+                        else if(ringB[j].first < ringA[i].first)
+                            ++j;
+                        else
+                        {
+                            ++nbCommon;
+                            ++i;
+                            ++j;
+                        }
+                    }
+                    if(nbCommon != nbEdgeTris)
+                        continue;
+
+                    Quadric q = quadrics[a];
+                    q += quadrics[b];
+                    Collapse collapse;
+                    collapse.a = a;
+                    collapse.b = b;
+                    collapse.nbTris = nbEdgeTris;
+                    if(q.optimize(collapse.pos))
+                    {
+                        collapse.cost = q.evaluate(collapse.pos);
+                    }
+                    else
+                    {
+                        // best of the edge points and middle
+                        const Point3d middle = (pts[a] + pts[b]) * 0.5;
+                        collapse.pos = middle;
+                        collapse.cost = q.evaluate(middle);
+                        for(const Point3d& p : {pts[a], pts[b]})
+                        {
+                            const double cost = q.evaluate(p);
+                            if(cost < collapse.cost)
+                            {
+                                collapse.pos = p;
+                                collapse.cost = cost;
+                            }
+                        }
+                    }
+                    if(params.maxError > 0.0 && collapse.cost > params.maxError)
+                        continue;
+                    if(!isCollapseWithoutFlip(a, b, collapse.pos, ptsTris, tris, pts))
+                        continue;
+                    localCandidates.push_back(collapse);
+                }
+            }
+
+            #pragma omp critical
+            candidates.insert(candidates.end(), localCandidates.begin(), localCandidates.end());
+        }
+
+        if(candidates.empty())
+            break;
+        std::sort(candidates.begin(), candidates.end());
+
+        // independent set of collapses: the 1-rings of the collapsed edges don't overlap
+        collapses.clear();
+        std::fill(isLocked.begin(), isLocked.end(), 0);
+        {
+            std::vector<int> tmp;
+            std::vector<std::pair<int, int>> ring;
+
+            for(const Collapse& collapse : candidates)
+            {
+                if(isLocked[collapse.a] || isLocked[collapse.b])
+                    continue;
+                collapses.push_back(collapse);
+                for(int ptId : {collapse.a, collapse.b})
+                {
+                    isLocked[ptId] = 1;
+                    getPointRing(ptId, ptsTris, tris, tmp, ring);
+                    for(const auto& neighbor : ring)
+                        isLocked[neighbor.first] = 1;
+                }
+                nbAlivePts -= 1;
+                nbAliveTris -= collapse.nbTris;
+                if(isTargetReached())
+                    break;
+            }
+        }
+
+        // apply the collapses, their triangles are disjoint
+        #pragma omp parallel for
+        for(int i = 0; i < collapses.size(); ++i)
+        {
+            const Collapse& collapse = collapses[i];
+            pts[collapse.a] = collapse.pos;
+            quadrics[collapse.a] += quadrics[collapse.b];
+            for(const int* it = ptsTris.begin(collapse.b); it != ptsTris.end(collapse.b); ++it)
+            {
+                Mesh::triangle& t = tris[*it];
+                if(!t.alive)
+                    continue;
+                if(t.v[0] == collapse.a || t.v[1] == collapse.a || t.v[2] == collapse.a)
+                {
+                    t.alive = false;
+                    continue;
+                }
+                for(int k = 0; k < 3; ++k)
+                {
+                    if(t.v[k] == collapse.b)
+                        t.v[k] = collapse.a;
+                }
+            }
+        }
+
+        ++pass;
+        ALICEVISION_LOG_DEBUG("Mesh decimation pass " << pass << ": " << collapses.size() << " collapses, "
+                              << nbAlivePts << " points and " << nbAliveTris << " triangles.");
+    }
+
+    // remove the collapsed triangles and points
+    StaticVector<int> trisIdsToStay;
+    trisIdsToStay.reserve(nbAliveTris);
+    for(int i = 0; i < tris.size(); ++i)
+    {
+        if(tris[i].alive)
+            trisIdsToStay.push_back(i);
+    }
+    mesh.letJustTringlesIdsInMesh(&trisIdsToStay);
+    mesh.removeFreePointsFromMesh();
+
+    ALICEVISION_LOG_INFO("Mesh decimation done in " << pass << " passes: " << mesh.pts->size() << " points and "
+                         << mesh.tris->size() << " triangles.");
+}
+
+} // namespace mesh
+} // namespace aliceVision
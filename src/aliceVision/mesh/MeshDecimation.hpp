@@ -0,0 +1,41 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Stop criteria of the mesh decimation, the decimation stops as soon as one of them is reached
+ */
+struct DecimationParams
+{
+    /// stop when the mesh has at most this number of points (0: not used)
+    int maxNbPts = 0;
+    /// stop when the mesh has at most this number of triangles (0: not used)
+    int maxNbTris = 0;
+    /// quadric error bound of a collapse, the edges with a larger error are not collapsed (0: not used)
+    double maxError = 0.0;
+};
+
+/**
+ * @brief Quadric error decimation (Garland and Heckbert) of the mesh, in place.
+ *
+ * The edges are collapsed by passes: the valid collapses are sorted by error and an independent set
+ * (collapses whose 1-rings don't overlap) is selected greedily, then applied in parallel.
+ * The boundaries are kept by penalty quadrics, the collapses changing the topology or flipping
+ * a triangle are rejected. The free points are removed at the end.
+ *
+ * @param[in,out] mesh the mesh to decimate
+ * @param[in] params the stop criteria, the mesh is unchanged if none is given
+ */
+void decimateMesh(Mesh& mesh, const DecimationParams& params);
+
+} // namespace mesh
+} // namespace aliceVision
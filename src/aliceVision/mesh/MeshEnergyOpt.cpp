@@ -9,6 +9,10 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -23,58 +27,166 @@ MeshEnergyOpt::MeshEnergyOpt(mvsUtils::MultiViewParams* _mp)
 
 MeshEnergyOpt::~MeshEnergyOpt() = default;
 
-StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
+struct MeshEnergyOpt::SmoothingBuffers
+{
+    /// ordered neighbors of point i are in [neighOffsets[i], neighOffsets[i+1])
+    std::vector<int> neighOffsets;
+    std::vector<int> neighIds;
+    /// 1/v factor of the bi-laplacian operator, 0 for the points which can't move
+    std::vector<float> biLapFactor;
+
+    std::vector<double> x, y, z;
+    std::vector<double> lapX, lapY, lapZ;
+};
+
+void MeshEnergyOpt::initSmoothingBuffers(SmoothingBuffers& buffers, StaticVectorBool* ptsCanMove) const
 {
-    StaticVector<Point3d>* lapPts = new StaticVector<Point3d>();
-    lapPts->reserve(pts->size());
-    lapPts->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.f));
-    int nlabpts = 0;
+    const int nbPts = pts->size();
+
+    buffers.neighOffsets.resize(nbPts + 1);
+    buffers.neighOffsets[0] = 0;
+    for(int i = 0; i < nbPts; ++i)
+        buffers.neighOffsets[i + 1] = buffers.neighOffsets[i] + sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[i]);
+
+    buffers.neighIds.resize(buffers.neighOffsets[nbPts]);
+    buffers.biLapFactor.resize(nbPts);
+    buffers.x.resize(nbPts);
+    buffers.y.resize(nbPts);
+    buffers.z.resize(nbPts);
+    buffers.lapX.resize(nbPts);
+    buffers.lapY.resize(nbPts);
+    buffers.lapZ.resize(nbPts);
 
 #pragma omp parallel for
-    for(int i = 0; i < pts->size(); i++)
+    for(int i = 0; i < nbPts; ++i)
     {
-        Point3d lapPt;
-        if(getLaplacianSmoothingVector(i, lapPt))
+        const StaticVector<int>* ptNeighPtsOrdered = (*ptsNeighPtsOrdered)[i];
+        const int nbNeighbors = buffers.neighOffsets[i + 1] - buffers.neighOffsets[i];
+        if(nbNeighbors > 0)
+            std::copy_n(ptNeighPtsOrdered->getData().begin(), nbNeighbors, buffers.neighIds.begin() + buffers.neighOffsets[i]);
+
+        buffers.x[i] = (*pts)[i].x;
+        buffers.y[i] = (*pts)[i].y;
+        buffers.z[i] = (*pts)[i].z;
+
+        // same operator as MeshAnalyze::getBiLaplacianSmoothingVector
+        buffers.biLapFactor[i] = 0.0f;
+        if((nbNeighbors == 0) || ((*ptsNeighTrisSortedAsc)[i] == nullptr) || ((ptsCanMove != nullptr) && !(*ptsCanMove)[i]))
+            continue;
+
+        float sum = 0.0f;
+        for(int k = 0; k < nbNeighbors; ++k)
         {
-            (*lapPts)[i] = lapPt;
-            nlabpts++;
+            const int neighValence = sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[(*ptNeighPtsOrdered)[k]]);
+            if(neighValence > 0)
+                sum += 1.0f / (float)neighValence;
         }
+        const float v = 1.0f + (1.0f / (float)nbNeighbors) * sum;
+        buffers.biLapFactor[i] = 1.0f / v;
     }
-
-    return lapPts;
 }
 
-void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
-                                                const Point3d& RD, StaticVectorBool* ptsCanMove)
+void MeshEnergyOpt::computeLaplacianPtsParallel(SmoothingBuffers& buffers) const
 {
-    // printf("nlabpts %i of %i\n",nlabpts,pts->size());
-    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel();
-
-    StaticVector<Point3d>* newPts = new StaticVector<Point3d>();
-    newPts->reserve(pts->size());
-    newPts->push_back_arr(pts);
+    const int nbPts = pts->size();
+    const int* offsets = buffers.neighOffsets.data();
+    const int* ids = buffers.neighIds.data();
+    const double* x = buffers.x.data();
+    const double* y = buffers.y.data();
+    const double* z = buffers.z.data();
+
+    // same operator as MeshAnalyze::getLaplacianSmoothingVector, the failures give a null vector
+#pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        double lx = 0.0;
+        double ly = 0.0;
+        double lz = 0.0;
+        bool valid = (offsets[i] != offsets[i + 1]);
+        for(int k = offsets[i]; valid && (k < offsets[i + 1]); ++k)
+        {
+            const int n = ids[k];
+            valid = (x[n] != 0.0) || (y[n] != 0.0) || (z[n] != 0.0);
+            lx += x[n];
+            ly += y[n];
+            lz += z[n];
+        }
+        if(valid)
+        {
+            const double nbNeighbors = offsets[i + 1] - offsets[i];
+            lx = lx / nbNeighbors - x[i];
+            ly = ly / nbNeighbors - y[i];
+            lz = lz / nbNeighbors - z[i];
+            valid = std::isfinite(lx) && std::isfinite(ly) && std::isfinite(lz);
+        }
+        buffers.lapX[i] = valid ? lx : 0.0;
+        buffers.lapY[i] = valid ? ly : 0.0;
+        buffers.lapZ[i] = valid ? lz : 0.0;
+    }
+}
 
+void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, SmoothingBuffers& buffers) const
+{
+    computeLaplacianPtsParallel(buffers);
+
+    const int nbPts = pts->size();
+    const int* offsets = buffers.neighOffsets.data();
+    const int* ids = buffers.neighIds.data();
+    const float* biLapFactor = buffers.biLapFactor.data();
+    const double* lapX = buffers.lapX.data();
+    const double* lapY = buffers.lapY.data();
+    const double* lapZ = buffers.lapZ.data();
+    double* x = buffers.x.data();
+    double* y = buffers.y.data();
+    double* z = buffers.z.data();
+
+    // the new position of a point only depends on its position and on the laplacian vectors,
+    // so the points are updated in place
 #pragma omp parallel for
-    for(int i = 0; i < pts->size(); ++i)
+    for(int i = 0; i < nbPts; ++i)
     {
-        if((ptsCanMove == nullptr) || ((*ptsCanMove)[i]))
+        if(biLapFactor[i] == 0.0f)
+            continue;
+
+        double bx = 0.0;
+        double by = 0.0;
+        double bz = 0.0;
+        bool valid = true;
+        for(int k = offsets[i]; valid && (k < offsets[i + 1]); ++k)
         {
-            Point3d n;
-
-            if(getBiLaplacianSmoothingVector(i, lapPts, n))
-            {
-                Point3d p = (*newPts)[i] + n * lambda;
-                if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
-                {
-                    (*newPts)[i] = p;
-                }
-            }
+            const int n = ids[k];
+            valid = (lapX[n] != 0.0) || (lapY[n] != 0.0) || (lapZ[n] != 0.0);
+            bx += lapX[n];
+            by += lapY[n];
+            bz += lapZ[n];
+        }
+        if(!valid)
+            continue;
+
+        const double nbNeighbors = offsets[i + 1] - offsets[i];
+        bx = -(bx / nbNeighbors - lapX[i]) * biLapFactor[i];
+        by = -(by / nbNeighbors - lapY[i]) * biLapFactor[i];
+        bz = -(bz / nbNeighbors - lapZ[i]) * biLapFactor[i];
+        if(!std::isfinite(bx) || !std::isfinite(by) || !std::isfinite(bz))
+            continue;
+
+        const double px = x[i] + bx * lambda;
+        const double py = y[i] + by * lambda;
+        const double pz = z[i] + bz * lambda;
+        if((px > LU.x) && (py > LU.y) && (pz > LU.z) && (px < RD.x) && (py < RD.y) && (pz < RD.z))
+        {
+            x[i] = px;
+            y[i] = py;
+            z[i] = pz;
         }
     }
+}
 
-    delete pts;
-    pts = newPts;
-    delete lapPts;
+void MeshEnergyOpt::copySmoothedPts(const SmoothingBuffers& buffers)
+{
+#pragma omp parallel for
+    for(int i = 0; i < pts->size(); ++i)
+        (*pts)[i] = Point3d(buffers.x[i], buffers.y[i], buffers.z[i]);
 }
 
 bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove)
@@ -103,14 +215,22 @@ bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* pt
                          << "\t- lamda: " << lambda << std::endl
                          << "\t- niters: " << niter << std::endl);
 
+    SmoothingBuffers buffers;
+    initSmoothingBuffers(buffers, ptsCanMove);
+
     for(int i = 0; i < niter; i++)
     {
         ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << i);
-        updateGradientParallel(lambda, LU, RD, ptsCanMove);
+        updateGradientParallel(lambda, LU, RD, buffers);
         if(saveDebug)
+        {
+            copySmoothedPts(buffers);
             saveToObj(mp->mvDir + "mesh_smoothed_" + std::to_string(i) + ".obj");
+        }
     }
 
+    copySmoothedPts(buffers);
+
     return true;
 }
 
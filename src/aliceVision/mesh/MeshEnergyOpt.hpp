@@ -22,8 +22,13 @@ public:
     bool optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove);
 
 private:
-    StaticVector<Point3d>* computeLaplacianPtsParallel();
-    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove);
+    /// Smoothing state allocated once per optimizeSmooth: neighbors in CSR layout, coordinates in SoA layout
+    struct SmoothingBuffers;
+
+    void initSmoothingBuffers(SmoothingBuffers& buffers, StaticVectorBool* ptsCanMove) const;
+    void computeLaplacianPtsParallel(SmoothingBuffers& buffers) const;
+    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, SmoothingBuffers& buffers) const;
+    void copySmoothedPts(const SmoothingBuffers& buffers);
 };
 
 } // namespace mesh
@@ -6,18 +6,28 @@
 
 #include "Texturing.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/mvsData/Color.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/imageIO/image.hpp>
 #include <aliceVision/mesh/UVAtlas.hpp>
+#include <aliceVision/mesh/meshIO.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/mesh/cuda/texturingRasterization.hpp>
+#endif
 
 #include <geogram/basic/geometry_nd.h>
 #include <geogram/mesh/mesh.h>
 #include <geogram/mesh/mesh_io.h>
 #include <geogram/parameterization/mesh_atlas_maker.h>
 
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <algorithm>
 #include <map>
 #include <set>
 
@@ -231,15 +241,6 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
     deleteArrayOfArrays<int>(&updatedPointsCams);
 }
 
-void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
-                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
-{
-    mvsUtils::ImagesCache imageCache(&mp, 0, false);
-    for(size_t atlasID = 0; atlasID < _atlases.size(); ++atlasID)
-        generateTexture(mp, atlasID, imageCache, outPath, textureFileType);
-}
-
-
 /// accumulates colors and keeps count for providing average
 struct AccuColor {
     Color colorSum;
@@ -268,16 +269,159 @@ struct AccuColor {
 };
 
 
+/// color accumulation buffers of an atlas being generated
+struct Texturing::AtlasTexture
+{
+    size_t atlasID;
+    /// triangles of the atlas seen by each camera
+    std::vector<std::vector<unsigned int>> camTriangles;
+    std::vector<int> colorIDs;
+    std::vector<AccuColor> perPixelColors;
+};
+
+
+void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
+                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
+{
+    // each atlas being generated keeps its accumulation buffers (and its color and alpha buffers to fill the holes),
+    // the textures are written row by row
+    const std::size_t textureSize = texParams.textureSide * texParams.textureSide;
+    const std::size_t atlasMemSize = textureSize * (sizeof(int) + sizeof(AccuColor) +
+                                                    (texParams.fillHoles ? sizeof(Color) + sizeof(float) : 0));
+
+    std::size_t nbParallelAtlases = texParams.nbParallelAtlases;
+    if(nbParallelAtlases == 0)
+    {
+        // keep some free memory for the images cache
+        const std::size_t freeRam = system::getMemoryInfo().freeRam;
+        nbParallelAtlases = std::max(std::size_t(1), static_cast<std::size_t>(freeRam * 0.8) / atlasMemSize);
+    }
+    nbParallelAtlases = std::min(nbParallelAtlases, _atlases.size());
+
+    ALICEVISION_LOG_INFO("Generating " << _atlases.size() << " texture atlases, " << nbParallelAtlases << " at a time.");
+
+    mvsUtils::ImagesCache imageCache(&mp, 0, false);
+    for(size_t firstAtlasID = 0; firstAtlasID < _atlases.size(); firstAtlasID += nbParallelAtlases)
+    {
+        std::vector<size_t> atlasIDs;
+        for(size_t atlasID = firstAtlasID; atlasID < std::min(firstAtlasID + nbParallelAtlases, _atlases.size()); ++atlasID)
+            atlasIDs.push_back(atlasID);
+        generateTextures(mp, atlasIDs, imageCache, outPath, textureFileType);
+    }
+}
+
+
 void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
                                 size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
 {
-    if(atlasID >= _atlases.size())
-        throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
+    generateTextures(mp, std::vector<size_t>(1, atlasID), imageCache, outPath, textureFileType);
+}
+
+
+void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                                 mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+{
+    ALICEVISION_PROFILE_ZONE("Texturing::generateTextures");
+    for(size_t atlasID : atlasIDs)
+    {
+        if(atlasID >= _atlases.size())
+            throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
+    }
+
+    const int nbAtlases = atlasIDs.size();
+    std::vector<AtlasTexture> atlasTextures(nbAtlases);
+
+#pragma omp parallel for
+    for(int i = 0; i < nbAtlases; ++i)
+        initAtlasTexture(mp, atlasIDs[i], atlasTextures[i]);
+
+    ALICEVISION_LOG_INFO("Reading pixel color.");
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    bool useCuda = texParams.useCuda && texturingCUDA_isAvailable();
+    if(useCuda)
+        ALICEVISION_LOG_INFO("Rasterizing the textures on the GPU.");
+#endif
+
+    // cameras seen by at least one of the atlases, each image is decoded once for all of them
+    std::vector<int> cams;
+    for(int camId = 0; camId < mp.ncams; ++camId)
+    {
+        for(const AtlasTexture& atlasTexture : atlasTextures)
+        {
+            if(!atlasTexture.camTriangles[camId].empty())
+            {
+                cams.push_back(camId);
+                break;
+            }
+        }
+    }
+
+    for(std::size_t c = 0; c < cams.size(); ++c)
+    {
+        const int camId = cams[c];
+        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams);
+
+        // decode the next camera while this one is processed
+        StaticVector<int> nextCams;
+        if(c + 1 < cams.size())
+            nextCams.push_back(cams[c + 1]);
+        imageCache.prefetch(nextCams);
+
+        const mvsUtils::ImagesCache::ImgSharedPtr img = imageCache.getImg_sync(camId);
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+        if(useCuda)
+        {
+            // the image is uploaded once for all the atlases
+            TexturingCameraCUDA camera;
+            useCuda = camera.upload(reinterpret_cast<const float*>(img->data()), mp.getWidth(camId), mp.getHeight(camId),
+                                    mp.camArr[camId].m, mp.g_border);
+            if(useCuda)
+            {
+                std::vector<char> cudaFailed(nbAtlases, 0);
+
+#pragma omp parallel for schedule(dynamic)
+                for(int i = 0; i < nbAtlases; ++i)
+                {
+                    const std::size_t nbAccumulated = accumulateCameraColorsCUDA(camera, camId, atlasTextures[i]);
+                    if(nbAccumulated < atlasTextures[i].camTriangles[camId].size())
+                    {
+                        cudaFailed[i] = 1;
+                        accumulateCameraColors(mp, camId, *img, imageCache, atlasTextures[i], nbAccumulated);
+                    }
+                }
+
+                useCuda = std::find(cudaFailed.begin(), cudaFailed.end(), 1) == cudaFailed.end();
+                if(!useCuda)
+                    ALICEVISION_LOG_WARNING("CUDA error during the texture rasterization, switching to the CPU.");
+                continue;
+            }
+            ALICEVISION_LOG_WARNING("Can't upload the image of camera " << camId << " on the GPU, switching to the CPU.");
+        }
+#endif
+
+#pragma omp parallel for schedule(dynamic)
+        for(int i = 0; i < nbAtlases; ++i)
+            accumulateCameraColors(mp, camId, *img, imageCache, atlasTextures[i]);
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < nbAtlases; ++i)
+    {
+        writeAtlasTexture(atlasTextures[i], outPath, textureFileType);
+    }
+}
 
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
-    std::vector<int> colorIDs(textureSize, -1);
 
-    std::vector<std::vector<unsigned int>> camTriangles(mp.ncams);
+void Texturing::initAtlasTexture(const mvsUtils::MultiViewParams& mp, size_t atlasID, AtlasTexture& atlasTexture) const
+{
+    const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+
+    atlasTexture.atlasID = atlasID;
+    atlasTexture.colorIDs.assign(textureSize, -1);
+    atlasTexture.perPixelColors.assign(textureSize, AccuColor());
+    atlasTexture.camTriangles.assign(mp.ncams, std::vector<unsigned int>());
 
     ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
               << " (" << _atlases[atlasID].size() << " triangles).");
@@ -300,87 +444,171 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
         }
         // register this triangle in cameras seeing it
         for(int camId : triCams)
-            camTriangles[camId].push_back(triangleId);
+            atlasTexture.camTriangles[camId].push_back(triangleId);
     }
+}
 
-    ALICEVISION_LOG_INFO("Reading pixel color.");
 
-    std::vector<AccuColor> perPixelColors(textureSize);
+void Texturing::getTriangleInTexture(int triangleId, Point3d* triPts, Point2d* triPixs, Pixel& LU, Pixel& RD) const
+{
+    for(int k = 0; k < 3; k++)
+    {
+        const int pointIndex = (*me->tris)[triangleId].v[k];
+        triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+        const int uvPointIndex = trisUvIds[triangleId].m[k];
+        triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+    }
 
-    // iterate over triangles for each camera
-    int camId = 0;
-    for(const std::vector<unsigned int>& triangles : camTriangles)
+    // compute triangle bounding box in pixel indexes
+    // min values: floor(value)
+    // max values: ceil(value)
+    LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+    LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+    RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+    RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+    // sanity check: clamp values to [0; textureSide]
+    int texSide = static_cast<int>(texParams.textureSide);
+    LU.x = clamp(LU.x, 0, texSide);
+    LU.y = clamp(LU.y, 0, texSide);
+    RD.x = clamp(RD.x, 0, texSide);
+    RD.y = clamp(RD.y, 0, texSide);
+}
+
+
+void Texturing::accumulateCameraColors(const mvsUtils::MultiViewParams& mp, int camId, const mvsUtils::ImagesCache::Img& img,
+                                       const mvsUtils::ImagesCache& imageCache, AtlasTexture& atlasTexture,
+                                       std::size_t firstTriangle) const
+{
+    std::vector<int>& colorIDs = atlasTexture.colorIDs;
+    std::vector<AccuColor>& perPixelColors = atlasTexture.perPixelColors;
+    const std::vector<unsigned int>& triangles = atlasTexture.camTriangles[camId];
+
+    for(std::size_t t = firstTriangle; t < triangles.size(); ++t)
     {
-        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
+        const int triangleId = triangles[t];
+        // retrieve triangle 3D and UV coordinates, and its bounding box in the texture
+        Point2d triPixs[3];
+        Point3d triPts[3];
+        Pixel LU, RD;
+        getTriangleInTexture(triangleId, triPts, triPixs, LU, RD);
+
+        // iterate over bounding box's pixels
+        for(int y = LU.y; y < RD.y; y++)
+        {
+            for(int x = LU.x; x < RD.x; x++)
+            {
+                Pixel pix(x, y); // top-left corner of the pixel
+                Point2d barycCoords;
+
+                // test if the pixel is inside triangle
+                // and retrieve its barycentric coordinates
+                if(!isPixelInTriangle(triPixs, pix, barycCoords))
+                {
+                    continue;
+                }
 
-        for(const auto& triangleId : triangles)
+                // remap 'y' to image coordinates system (inverted Y axis)
+                const unsigned int y_ = (texParams.textureSide - 1) - y;
+                // 1D pixel index
+                unsigned int xyoffset = y_ * texParams.textureSide + x;
+                // get 3D coordinates
+                Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+                // get 2D coordinates in source image
+                Point2d pixRC;
+                mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+                // exclude out of bounds pixels
+                if(!mp.isPixelInImage(pixRC, camId))
+                    continue;
+                // fill the colorID map
+                colorIDs[xyoffset] = xyoffset;
+                // fill the accumulated color map for this pixel
+                perPixelColors[xyoffset] += imageCache.getPixelValueInterpolated(&pixRC, img, camId);
+            }
+        }
+    }
+}
+
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+std::size_t Texturing::accumulateCameraColorsCUDA(const TexturingCameraCUDA& camera, int camId, AtlasTexture& atlasTexture) const
+{
+    // max num. of bounding boxes pixels rasterized at once, bounds the device and host buffers
+    const int maxNbPixels = 1 << 24;
+
+    std::vector<int>& colorIDs = atlasTexture.colorIDs;
+    std::vector<AccuColor>& perPixelColors = atlasTexture.perPixelColors;
+    const std::vector<unsigned int>& triangles = atlasTexture.camTriangles[camId];
+
+    std::vector<TexturingTriangleCUDA> chunk;
+    std::vector<float> colors;
+    std::size_t nbAccumulated = 0;
+
+    while(nbAccumulated < triangles.size())
+    {
+        // next chunk of triangles, at least one
+        chunk.clear();
+        int nbPixels = 0;
+        for(std::size_t t = nbAccumulated; t < triangles.size(); ++t)
         {
-            // retrieve triangle 3D and UV coordinates
             Point2d triPixs[3];
             Point3d triPts[3];
+            Pixel LU, RD;
+            getTriangleInTexture(triangles[t], triPts, triPixs, LU, RD);
 
-            for(int k = 0; k < 3; k++)
+            TexturingTriangleCUDA triangle;
+            for(int k = 0; k < 3; ++k)
             {
-                const int pointIndex = (*me->tris)[triangleId].v[k];
-                triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                const int uvPointIndex = trisUvIds[triangleId].m[k];
-                triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+                std::copy(std::begin(triPts[k].m), std::end(triPts[k].m), triangle.pts + 3 * k);
+                triangle.pixs[2 * k] = triPixs[k].x;
+                triangle.pixs[2 * k + 1] = triPixs[k].y;
             }
+            triangle.LUx = LU.x;
+            triangle.LUy = LU.y;
+            triangle.RDx = std::max(LU.x, RD.x);
+            triangle.RDy = std::max(LU.y, RD.y);
+
+            if(!chunk.empty() && nbPixels + triangle.nbPixels() > maxNbPixels)
+                break;
+            nbPixels += triangle.nbPixels();
+            chunk.push_back(triangle);
+        }
 
-            // compute triangle bounding box in pixel indexes
-            // min values: floor(value)
-            // max values: ceil(value)
-            Pixel LU, RD;
-            LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-            RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-            // sanity check: clamp values to [0; textureSide]
-            int texSide = static_cast<int>(texParams.textureSide);
-            LU.x = clamp(LU.x, 0, texSide);
-            LU.y = clamp(LU.y, 0, texSide);
-            RD.x = clamp(RD.x, 0, texSide);
-            RD.y = clamp(RD.y, 0, texSide);
-
-            // iterate over bounding box's pixels
-            for(int y = LU.y; y < RD.y; y++)
+        if(!camera.rasterize(chunk, colors))
+            return nbAccumulated;
+
+        // accumulate in the same order as the CPU rasterization
+        std::size_t i = 0;
+        for(const TexturingTriangleCUDA& triangle : chunk)
+        {
+            for(int y = triangle.LUy; y < triangle.RDy; ++y)
             {
-                for(int x = LU.x; x < RD.x; x++)
+                // remap 'y' to image coordinates system (inverted Y axis)
+                const unsigned int yoffset = ((texParams.textureSide - 1) - y) * texParams.textureSide;
+                for(int x = triangle.LUx; x < triangle.RDx; ++x, i += 4)
                 {
-                    Pixel pix(x, y); // top-left corner of the pixel
-                    Point2d barycCoords;
-
-                    // test if the pixel is inside triangle
-                    // and retrieve its barycentric coordinates
-                    if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                    {
+                    if(colors[i + 3] == 0.f)
                         continue;
-                    }
-
-                    // remap 'y' to image coordinates system (inverted Y axis)
-                    const unsigned int y_ = (texParams.textureSide - 1) - y;
-                    // 1D pixel index
-                    unsigned int xyoffset = y_ * texParams.textureSide + x;
-                    // get 3D coordinates
-                    Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                    // get 2D coordinates in source image
-                    Point2d pixRC;
-                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                    // exclude out of bounds pixels
-                    if(!mp.isPixelInImage(pixRC, camId))
-                        continue;
-                    // fill the colorID map
+                    const unsigned int xyoffset = yoffset + x;
                     colorIDs[xyoffset] = xyoffset;
-                    // fill the accumulated color map for this pixel
-                    perPixelColors[xyoffset] += imageCache.getPixelValueInterpolated(&pixRC, camId);
+                    perPixelColors[xyoffset] += Color(colors[i], colors[i + 1], colors[i + 2]);
                 }
             }
         }
-        // increment current cam index
-        camId++;
+        nbAccumulated += chunk.size();
     }
-    camTriangles.clear();
+    return nbAccumulated;
+}
+#endif
+
+
+void Texturing::writeAtlasTexture(AtlasTexture& atlasTexture, const bfs::path& outPath, EImageFileType textureFileType) const
+{
+    const size_t atlasID = atlasTexture.atlasID;
+    const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+    std::vector<int>& colorIDs = atlasTexture.colorIDs;
+    std::vector<AccuColor>& perPixelColors = atlasTexture.perPixelColors;
+    std::vector<std::vector<unsigned int>>().swap(atlasTexture.camTriangles);
 
     if(!texParams.fillHoles && texParams.padding > 0)
     {
@@ -422,13 +650,39 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
         }
     }
 
+    std::string textureName = "texture_" + std::to_string(atlasID) + "." + EImageFileType_enumToString(textureFileType);
+    bfs::path texturePath = outPath / textureName;
+    ALICEVISION_LOG_INFO("Writing texture file: " << texturePath.string());
+
+    // downscale texture if required, the pyramid levels are written in the same pass
+    if(texParams.downscale > 1)
+        ALICEVISION_LOG_INFO("Downscaling texture (" << texParams.downscale << "x).");
+    imageIO::ImageRowsWriter writer(texturePath.string(), texParams.textureSide, texParams.textureSide,
+                                    texParams.downscale, texParams.nbLods);
+
     ALICEVISION_LOG_INFO("Computing final (average) color.");
 
-    // save texture image
+    if(!texParams.fillHoles)
+    {
+        // the final colors are written row by row, the full texture is never stored
+        std::vector<Color> row(texParams.textureSide);
+        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+        {
+            unsigned int yoffset = yp * texParams.textureSide;
+            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+            {
+                int colorID = colorIDs[yoffset + xp];
+                row[xp] = (colorID >= 0) ? perPixelColors[colorID].average() : Color();
+            }
+            writer.writeRow(row.data());
+        }
+        writer.close();
+        return;
+    }
+
+    // texture holes filling needs the full texture
     std::vector<Color> colorBuffer(texParams.textureSide * texParams.textureSide);
-    std::vector<float> alphaBuffer;
-    if(texParams.fillHoles)
-        alphaBuffer.resize(colorBuffer.size(), 0.0f);
+    std::vector<float> alphaBuffer(colorBuffer.size(), 0.0f);
 
     for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
     {
@@ -441,40 +695,23 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
             if(colorID >= 0)
             {
                 color = perPixelColors[colorID].average();
-                if(texParams.fillHoles)
-                    alphaBuffer[xyoffset] = 1.0f;
+                alphaBuffer[xyoffset] = 1.0f;
             }
             colorBuffer[xyoffset] = color;
         }
     }
 
-    perPixelColors.clear();
-    colorIDs.clear();
+    // release the accumulation buffers before the holes filling
+    std::vector<AccuColor>().swap(perPixelColors);
+    std::vector<int>().swap(colorIDs);
 
-    std::string textureName = "texture_" + std::to_string(atlasID) + "." + EImageFileType_enumToString(textureFileType);
-    bfs::path texturePath = outPath / textureName;
-    ALICEVISION_LOG_INFO("Writing texture file: " << texturePath.string());
+    ALICEVISION_LOG_INFO("Filling texture holes.");
+    imageIO::fillHoles(texParams.textureSide, texParams.textureSide, colorBuffer, alphaBuffer);
+    alphaBuffer.clear();
 
-    unsigned int outTextureSide = texParams.textureSide;
-
-    // texture holes filling
-    if(texParams.fillHoles)
-    {
-        ALICEVISION_LOG_INFO("Filling texture holes.");
-        imageIO::fillHoles(texParams.textureSide, texParams.textureSide, colorBuffer, alphaBuffer);
-        alphaBuffer.clear();
-    }
-    // downscale texture if required
-    if(texParams.downscale > 1)
-    {
-        std::vector<Color> resizedColorBuffer;
-        outTextureSide = texParams.textureSide / texParams.downscale;
-
-        ALICEVISION_LOG_INFO("Downscaling texture (" << texParams.downscale << "x).");
-        imageIO::resizeImage(texParams.textureSide, texParams.textureSide, texParams.downscale, colorBuffer, resizedColorBuffer);
-        std::swap(resizedColorBuffer, colorBuffer);
-    }
-    imageIO::writeImage(texturePath.string(), outTextureSide, outTextureSide, colorBuffer);
+    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+        writer.writeRow(&colorBuffer[yp * texParams.textureSide]);
+    writer.close();
 }
 
 
@@ -523,6 +760,30 @@ void Texturing::loadFromOBJ(const std::string& filename, bool flipNormals)
     }
 }
 
+void Texturing::loadMesh(const std::string& filename, bool flipNormals)
+{
+    if(boost::to_lower_copy(bfs::path(filename).extension().string()) == ".obj")
+    {
+        loadFromOBJ(filename, flipNormals);
+        return;
+    }
+
+    clear();
+    me = new Mesh();
+    if(!me->load(filename))
+    {
+        throw std::runtime_error("Unable to load: " + filename);
+    }
+
+    if(flipNormals)
+        me->invertTriangleOrientations();
+
+    // no material, one atlas with all triangles
+    _atlases.resize(1);
+    for(int triangleID = 0; triangleID < me->tris->size(); triangleID++)
+        _atlases[0].push_back(triangleID);
+}
+
 void Texturing::loadFromMeshing(const std::string& meshFilepath, const std::string& visibilitiesFilepath)
 {
     clear();
@@ -544,8 +805,8 @@ void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
     // set pointers to null to avoid deallocation by 'loadFromObj'
     me = nullptr;
     pointsVisibilities = nullptr;
-    // load input obj file
-    loadFromOBJ(otherMeshPath, flipNormals);
+    // load input mesh file
+    loadMesh(otherMeshPath, flipNormals);
     // allocate pointsVisibilities for new internal mesh
     pointsVisibilities = new PointsVisibility();
     // remap visibilities from reconstruction onto input mesh
@@ -614,20 +875,26 @@ void Texturing::saveAsOBJ(const bfs::path& dir, const std::string& basename, EIm
     fprintf(fobj, "g TexturedMesh\n");
 
     // write vertices
-    auto vertices = me->pts;
-    for(int i = 0; i < vertices->size(); ++i)
-        fprintf(fobj, "v %f %f %f\n", (*vertices)[i].x, (*vertices)[i].y, (*vertices)[i].z);
+    const auto& vertices = *me->pts;
+    writeLinesParallel(fobj, vertices.size(), [&](int i, std::string& buffer)
+    {
+        appendFormat(buffer, "v %f %f %f\n", vertices[i].x, vertices[i].y, vertices[i].z);
+    });
 
     // write UV coordinates
-    for(int i=0; i < uvCoords.size(); ++i)
-        fprintf(fobj, "vt %f %f\n", uvCoords[i].x, uvCoords[i].y);
+    writeLinesParallel(fobj, uvCoords.size(), [&](int i, std::string& buffer)
+    {
+        appendFormat(buffer, "vt %f %f\n", uvCoords[i].x, uvCoords[i].y);
+    });
 
     // write faces per texture atlas
     for(size_t atlasID=0; atlasID < _atlases.size(); ++atlasID)
     {
         fprintf(fobj, "usemtl TextureAtlas_%i\n", atlasID);
-        for(const auto triangleID : _atlases[atlasID])
+        const auto& atlas = _atlases[atlasID];
+        writeLinesParallel(fobj, atlas.size(), [&](int i, std::string& buffer)
         {
+            const auto triangleID = atlas[i];
             // vertex IDs
             int vertexID1 = (*me->tris)[triangleID].v[0];
             int vertexID2 = (*me->tris)[triangleID].v[1];
@@ -637,8 +904,8 @@ void Texturing::saveAsOBJ(const bfs::path& dir, const std::string& basename, EIm
             int uvID2 = trisUvIds[triangleID].m[1];
             int uvID3 = trisUvIds[triangleID].m[2];
 
-            fprintf(fobj, "f %i/%i %i/%i %i/%i\n", vertexID1 + 1, uvID1 + 1, vertexID2 + 1, uvID2 + 1, vertexID3 + 1, uvID3 + 1); // indexed from 1
-        }
+            appendFormat(buffer, "f %i/%i %i/%i %i/%i\n", vertexID1 + 1, uvID1 + 1, vertexID2 + 1, uvID2 + 1, vertexID3 + 1, uvID3 + 1); // indexed from 1
+        });
     }
     fclose(fobj);
 
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/mvsData/image.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
@@ -51,9 +52,19 @@ struct TexturingParams
     unsigned int textureSide = 8192;
     unsigned int padding = 15;
     unsigned int downscale = 2;
+    /// num. of additional texture levels, each one half the size of the previous one (texture_<atlas>_lod<level> files)
+    unsigned int nbLods = 0;
     bool fillHoles = false;
+    /// max num. of atlases generated at the same time, 0 to deduce it from the free memory
+    unsigned int nbParallelAtlases = 0;
+    /// rasterize the triangles and sample the images on the GPU if a CUDA device is available
+    bool useCuda = true;
 };
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+class TexturingCameraCUDA;
+#endif
+
 struct Texturing
 {
     TexturingParams texParams;
@@ -85,6 +96,12 @@ public:
     /// Load a mesh from a .obj file and initialize internal structures
     void loadFromOBJ(const std::string& filename, bool flipNormals=false);
 
+    /**
+     * @brief Load a mesh from an OBJ, PLY or BIN file (see Mesh::load) and initialize internal structures
+     * @note Only the OBJ files provide materials and UV coordinates, the other formats give a single atlas
+     */
+    void loadMesh(const std::string& filename, bool flipNormals=false);
+
     /**
      * @brief Load a mesh from a dense reconstruction.
      *
@@ -130,8 +147,48 @@ public:
                          size_t atlasID, mvsUtils::ImagesCache& imageCache,
                          const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
 
+    /**
+     * @brief Generate texture files for the given texture atlas indexes at the same time
+     *
+     * The cameras are visited once for all the atlases: each source image is decoded once
+     * and its colors are accumulated in the atlases in parallel.
+     * The accumulation buffers of all the atlases stay in memory until the end.
+     */
+    void generateTextures(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                          mvsUtils::ImagesCache& imageCache,
+                          const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
+
     /// Save textured mesh as an OBJ + MTL file
     void saveAsOBJ(const bfs::path& dir, const std::string& basename, EImageFileType textureFileType = EImageFileType::PNG);
+
+private:
+    /// Color accumulation buffers of an atlas being generated
+    struct AtlasTexture;
+
+    /// Allocate the buffers of an atlas and list its triangles seen by each camera
+    void initAtlasTexture(const mvsUtils::MultiViewParams& mp, size_t atlasID, AtlasTexture& atlasTexture) const;
+
+    /// Get the 3D points, the texture pixels and the bounding box in the texture (LU included, RD excluded) of a triangle
+    void getTriangleInTexture(int triangleId, Point3d* triPts, Point2d* triPixs, Pixel& LU, Pixel& RD) const;
+
+    /**
+     * @brief Accumulate the colors of a camera image in the pixels of the atlas triangles it sees
+     * @param[in] firstTriangle the index of the first camera triangle to accumulate
+     */
+    void accumulateCameraColors(const mvsUtils::MultiViewParams& mp, int camId, const mvsUtils::ImagesCache::Img& img,
+                                const mvsUtils::ImagesCache& imageCache, AtlasTexture& atlasTexture,
+                                std::size_t firstTriangle = 0) const;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    /**
+     * @brief Same as accumulateCameraColors, the triangles are rasterized and the image is sampled on the GPU
+     * @return the num. of camera triangles accumulated, less than all of them on CUDA error
+     */
+    std::size_t accumulateCameraColorsCUDA(const TexturingCameraCUDA& camera, int camId, AtlasTexture& atlasTexture) const;
+#endif
+
+    /// Compute the final colors of an atlas (padding, holes filling, downscale) and write its texture file
+    void writeAtlasTexture(AtlasTexture& atlasTexture, const bfs::path& outPath, EImageFileType textureFileType) const;
 };
 
 } // namespace mesh
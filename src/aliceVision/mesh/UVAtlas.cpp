@@ -6,8 +6,11 @@
 
 #include "UVAtlas.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
 
+#include <cstdint>
 #include <iostream>
+#include <numeric>
 
 namespace aliceVision {
 namespace mesh {
@@ -21,18 +24,26 @@ UVAtlas::UVAtlas(const Mesh& mesh, mvsUtils::MultiViewParams& mp, StaticVector<S
     , _mesh(mesh)
 {
     vector<Chart> charts;
+    system::Timer timer;
 
     // create texture charts
     createCharts(charts, mp, ptsCams);
+    ALICEVISION_LOG_INFO("Texture charts created in " << timer.elapsed() << " s.");
 
     // pack texture charts
+    timer.reset();
     packCharts(charts, mp);
+    ALICEVISION_LOG_INFO("Texture charts merged in " << timer.elapsed() << " s.");
 
     // finalize charts
+    timer.reset();
     finalizeCharts(charts, mp);
+    ALICEVISION_LOG_INFO("Texture charts finalized in " << timer.elapsed() << " s.");
 
     // create texture atlases
+    timer.reset();
     createTextureAtlases(charts, mp);
+    ALICEVISION_LOG_INFO("Texture atlases created in " << timer.elapsed() << " s.");
 }
 
 void UVAtlas::createCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp, StaticVector<StaticVector<int>*>* ptsCams)
@@ -44,9 +55,12 @@ void UVAtlas::createCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp,
 
     // create one chart per triangle
     _triangleCameraIDs.resize(_mesh.tris->size());
+    charts.resize(trisCams->size());
+
+    #pragma omp parallel for schedule(dynamic, 1024)
     for(int i = 0; i < trisCams->size(); ++i)
     {
-        Chart chart;
+        Chart& chart = charts[i];
         // project triangle in all cams
         auto cameras = (*trisCams)[i];
         for(int c = 0; c < cameras->size(); ++c)
@@ -66,8 +80,6 @@ void UVAtlas::createCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp,
         sort(chart.commonCameraIDs.begin(), chart.commonCameraIDs.end());
         // store triangle ID
         chart.triangleIDs.emplace_back(i);
-        // store chart
-        charts.emplace_back(chart);
     }
     deleteArrayOfArrays<int>(&trisCams);
 }
@@ -88,52 +100,30 @@ void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
         return cid;
     };
 
-    // list mesh edges (with duplicates)
-    vector<Edge> alledges;
-    for(int i = 0; i < _mesh.tris->size(); ++i)
-    {
-        int a = (*_mesh.tris)[i].v[0];
-        int b = (*_mesh.tris)[i].v[1];
-        int c = (*_mesh.tris)[i].v[2];
-        Edge e1;
-        e1.pointIDs = make_pair(min(a, b), max(a, b));
-        e1.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e1);
-        Edge e2;
-        e2.pointIDs = make_pair(min(b, c), max(b, c));
-        e2.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e2);
-        Edge e3;
-        e3.pointIDs = make_pair(min(c, a), max(c, a));
-        e3.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e3);
-    }
-    sort(alledges.begin(), alledges.end());
+    // list mesh edges (with duplicates) with their triangle, sorted by edge then by triangle
+    const int nbTriangles = _mesh.tris->size();
+    vector<pair<uint64_t, int>> edgesTriangles(nbTriangles * 3);
 
-    // merge edges (no duplicate)
-    vector<Edge> edges;
-    auto eit = alledges.begin() + 1;
-    while(eit != alledges.end())
+    #pragma omp parallel for
+    for(int i = 0; i < nbTriangles; ++i)
     {
-        auto& a = *(eit-1);
-        auto& b = *eit;
-        if(a == b)
+        for(int k = 0; k < 3; ++k)
         {
-            a.triangleIDs.insert(a.triangleIDs.end(), b.triangleIDs.begin(), b.triangleIDs.end());
-            sort(a.triangleIDs.begin(), a.triangleIDs.end());
-            edges.push_back(a);
+            const uint32_t a = (*_mesh.tris)[i].v[k];
+            const uint32_t b = (*_mesh.tris)[i].v[(k + 1) % 3];
+            const uint64_t edge = (uint64_t(min(a, b)) << 32) | max(a, b);
+            edgesTriangles[i * 3 + k] = make_pair(edge, i);
         }
-        ++eit;
     }
-    alledges.clear();
+    sort(edgesTriangles.begin(), edgesTriangles.end());
 
-    // merge charts
-    for(auto& e : edges)
+    // merge the charts of the consecutive triangles sharing an edge
+    for(size_t e = 1; e < edgesTriangles.size(); ++e)
     {
-        if(e.triangleIDs.size() != 2)
+        if(edgesTriangles[e].first != edgesTriangles[e - 1].first)
             continue;
-        int chartIDA = findChart(e.triangleIDs[0]);
-        int chartIDB = findChart(e.triangleIDs[1]);
+        int chartIDA = findChart(edgesTriangles[e - 1].second);
+        int chartIDB = findChart(edgesTriangles[e].second);
         if(chartIDA == chartIDB)
             continue;
         Chart& a = charts[chartIDA];
@@ -150,6 +140,7 @@ void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
             // merge b in a
             a.commonCameraIDs = cameraIntersection;
             a.triangleIDs.insert(a.triangleIDs.end(), b.triangleIDs.begin(), b.triangleIDs.end());
+            vector<int>().swap(b.triangleIDs);
             b.mergedWith = chartIDA;
         }
         else
@@ -157,10 +148,11 @@ void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
             // merge a in b
             b.commonCameraIDs = cameraIntersection;
             b.triangleIDs.insert(b.triangleIDs.end(), a.triangleIDs.begin(), a.triangleIDs.end());
+            vector<int>().swap(a.triangleIDs);
             a.mergedWith = chartIDB;
         }
     }
-    edges.clear();
+    edgesTriangles.clear();
 
     // remove merged charts
     charts.erase(remove_if(charts.begin(), charts.end(), [](Chart& c)
@@ -173,8 +165,10 @@ void UVAtlas::finalizeCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& m
 {
     ALICEVISION_LOG_INFO("Finalize packed charts (" <<  charts.size() << " charts).");
 
-    for(auto&c : charts)
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < charts.size(); ++i)
     {
+        Chart& c = charts[i];
         // select reference cam
         if(c.commonCameraIDs.empty())
             continue; // skip triangles without visibility information
@@ -202,140 +196,141 @@ void UVAtlas::createTextureAtlases(vector<Chart>& charts, mvsUtils::MultiViewPar
 {
     ALICEVISION_LOG_INFO("Creating texture atlases.");
 
-    // sort charts by size, descending
+    // sort charts by size, descending (height first for the skyline packing)
     sort(charts.begin(), charts.end(), [](const Chart& a, const Chart& b)
     {
-        int wa = a.width();
-        int wb = b.width();
-        if(wa == wb)
-            return a.height() > b.height();
-        return wa > wb;
+        int ha = a.height();
+        int hb = b.height();
+        if(ha == hb)
+            return a.width() > b.width();
+        return ha > hb;
     });
 
-    size_t i = 0; // forward index
-    size_t j = charts.size() - 1; // backward index
+    // charts not inserted yet, by decreasing size
+    vector<size_t> remaining(charts.size());
+    iota(remaining.begin(), remaining.end(), 0);
+    vector<size_t> notInserted;
     size_t texCount = 0;
 
     // insert charts into one or more texture atlas
-    while(i <= j)
+    while(!remaining.empty())
     {
         texCount++;
         // create a texture atlas
         ALICEVISION_LOG_INFO("\t- texture atlas " << texCount);
         vector<Chart> atlas;
-        // create a tree root
-        ChartRect* root = new ChartRect();
-        root->LU.x = 0;
-        root->LU.y = 0;
-        root->RD.x = _textureSide - 1;
-        root->RD.y = _textureSide - 1;
-
-        const auto insertChart = [&](size_t idx) -> bool
+        Skyline skyline(_textureSide - 1);
+        notInserted.clear();
+
+        // insert as many charts as possible (largest to smallest)
+        for(size_t idx : remaining)
         {
             Chart& chart = charts[idx];
-            ChartRect* rect = root->insert(chart, _gutterSize);
-            if(!rect)
-                return false;
-
+            Pixel LU;
+            if(!skyline.insert(chart.width() + _gutterSize * 2, chart.height() + _gutterSize * 2, LU))
+            {
+                notInserted.push_back(idx);
+                continue;
+            }
             // store the final position
-            chart.targetLU = rect->LU;
+            chart.targetLU = LU;
             chart.targetLU.x += _gutterSize;
             chart.targetLU.y += _gutterSize;
             // add to the current texture atlas
-            atlas.emplace_back(chart);
-            return true;
-        };
-        // insert as many charts as possible in forward direction (largest to smallest)
-        while(i <= j && insertChart(i)) { ++i; }
-        // fill potential empty space (i != j) in backward direction
-        while(j > i && insertChart(j)) { --j; }
+            atlas.emplace_back(std::move(chart));
+        }
+
+        if(atlas.empty())
+        {
+            // the largest chart doesn't fit in an empty texture, it is clipped in its own atlas
+            Chart& chart = charts[notInserted.front()];
+            ALICEVISION_LOG_WARNING("Texture chart larger than the texture (" << chart.width() << "x" << chart.height() << "), it is clipped.");
+            chart.targetLU = Pixel(_gutterSize, _gutterSize);
+            atlas.emplace_back(std::move(chart));
+            notInserted.erase(notInserted.begin());
+        }
 
         // atlas is full or all charts have been handled
         ALICEVISION_LOG_INFO("Filled with " << atlas.size() << " charts.");
         // store this texture
-        _atlases.emplace_back(atlas);
-        // clear the whole tree
-        root->clear();
-        delete root;
+        _atlases.emplace_back(std::move(atlas));
+        std::swap(remaining, notInserted);
     }
 }
 
-void UVAtlas::ChartRect::clear()
+UVAtlas::Skyline::Skyline(int side)
+    : _side(side)
 {
-    if(child[0])
-        child[0]->clear();
-    if(child[1])
-        child[1]->clear();
-    delete child[0];
-    delete child[1];
+    _segments.push_back({0, 0, side});
 }
 
-UVAtlas::ChartRect* UVAtlas::ChartRect::insert(Chart& chart, size_t gutter)
+bool UVAtlas::Skyline::insert(int width, int height, Pixel& LU)
 {
-    if(child[0] || child[1]) // not a leaf
+    if(width > _side || height > _side)
+        return false;
+    if(width <= 0 || height <= 0)
     {
-        if(child[0])
-            if(ChartRect* rect = child[0]->insert(chart, gutter))
-                return rect;
-        if(child[1])
-            if(ChartRect* rect = child[1]->insert(chart, gutter))
-                return rect;
-        return nullptr;
+        // nothing to place
+        LU = Pixel(0, 0);
+        return true;
     }
-    else
+
+    // lowest top, then leftmost position
+    int bestIndex = -1;
+    int bestTop = std::numeric_limits<int>::max();
+    int bestY = 0;
+    for(size_t i = 0; i < _segments.size(); ++i)
     {
-        size_t chartWidth = chart.width() + gutter * 2;
-        size_t chartHeight = chart.height() + gutter * 2;
-        // if there is already a chart here
-        if(c) return nullptr;
-        // not enough space
-        if(chartWidth > (RD.x - LU.x))
-            return nullptr;
-        if(chartHeight > (RD.y - LU.y))
-            return nullptr;
-        // split & create children
-        if(chartWidth >= chartHeight)
-        {
-            if(chartWidth < (RD.x - LU.x))
-            {
-                child[0] = new ChartRect();
-                child[0]->LU.x = LU.x + chartWidth;
-                child[0]->LU.y = LU.y;
-                child[0]->RD.x = RD.x;
-                child[0]->RD.y = LU.y + chartHeight;
-            }
-            if(chartHeight < (RD.y - LU.y))
-            {
-                child[1] = new ChartRect();
-                child[1]->LU.x = LU.x;
-                child[1]->LU.y = LU.y + chartHeight;
-                child[1]->RD.x = RD.x;
-                child[1]->RD.y = RD.y;
-            }
-        }
-        else 
+        const int x = _segments[i].x;
+        if(x + width > _side)
+            break;
+
+        // the rectangle lies on the highest segment under it
+        int y = 0;
+        int remainingWidth = width;
+        for(size_t j = i; remainingWidth > 0 && y + height <= _side; ++j)
         {
-            if(chartHeight < (RD.y - LU.y))
-            {
-                child[0] = new ChartRect();
-                child[0]->LU.x = LU.x;
-                child[0]->LU.y = LU.y + chartHeight;
-                child[0]->RD.x = LU.x + chartWidth;
-                child[0]->RD.y = RD.y;
-            }
-            if(chartWidth < (RD.x - LU.x))
-            {
-                child[1] = new ChartRect();
-                child[1]->LU.x = LU.x + chartWidth;
-                child[1]->LU.y = LU.y;
-                child[1]->RD.x = RD.x;
-                child[1]->RD.y = RD.y;
-            }
+            y = max(y, _segments[j].y);
+            remainingWidth -= _segments[j].width;
         }
-        // insert chart
-        c = &chart;
-        return this;
+        if(y + height > _side || y + height >= bestTop)
+            continue;
+        bestIndex = i;
+        bestTop = y + height;
+        bestY = y;
+    }
+    if(bestIndex < 0)
+        return false;
+
+    const int x = _segments[bestIndex].x;
+    LU = Pixel(x, bestY);
+
+    // remove the segments under the rectangle, shrink the last one if partially covered
+    const int end = x + width;
+    size_t last = bestIndex;
+    while(last < _segments.size() && _segments[last].x + _segments[last].width <= end)
+        ++last;
+    if(last < _segments.size() && _segments[last].x < end)
+    {
+        _segments[last].width -= end - _segments[last].x;
+        _segments[last].x = end;
+    }
+    _segments.erase(_segments.begin() + bestIndex, _segments.begin() + last);
+    _segments.insert(_segments.begin() + bestIndex, {x, bestTop, width});
+
+    // merge with the neighbors at the same height
+    size_t i = bestIndex;
+    if(i + 1 < _segments.size() && _segments[i + 1].y == _segments[i].y)
+    {
+        _segments[i].width += _segments[i + 1].width;
+        _segments.erase(_segments.begin() + i + 1);
+    }
+    if(i > 0 && _segments[i - 1].y == _segments[i].y)
+    {
+        _segments[i - 1].width += _segments[i].width;
+        _segments.erase(_segments.begin() + i);
     }
+    return true;
 }
 
 } // namespace mesh
@@ -38,14 +38,33 @@ public:
         int height() const { return sourceRD.y - sourceLU.y; }
     };
 
-    struct ChartRect
+    /**
+     * @brief Skyline bin packer: the charts are placed at the lowest position (then leftmost) above the skyline,
+     *        the upper envelope of the charts already placed.
+     */
+    class Skyline
     {
-        Chart* c = nullptr;
-        ChartRect* child[2] {nullptr, nullptr};
-        Pixel LU;
-        Pixel RD;
-        void clear();
-        ChartRect* insert(Chart& chart, size_t gutter);
+    public:
+        explicit Skyline(int side);
+
+        /**
+         * @brief Find the position of a rectangle and add it to the skyline
+         * @param[in] width the rectangle width
+         * @param[in] height the rectangle height
+         * @param[out] LU the left-up corner of the rectangle
+         * @return false if the rectangle doesn't fit
+         */
+        bool insert(int width, int height, Pixel& LU);
+
+    private:
+        struct Segment
+        {
+            int x;
+            int y;
+            int width;
+        };
+        int _side;
+        std::vector<Segment> _segments;
     };
 
 public:
@@ -0,0 +1,274 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/cuda/texturingRasterization.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+
+namespace aliceVision {
+namespace mesh {
+
+/// size of the 1D CUDA blocks
+#define TEXTURING_BLOCK_SIZE 256
+
+/**
+ * @brief 3x4 projection matrix passed by value to the CUDA kernels
+ */
+struct ProjectionCUDA
+{
+    double m[12];
+};
+
+static bool checkCudaError(const char* what)
+{
+    const cudaError_t err = cudaGetLastError();
+    if(err == cudaSuccess)
+        return true;
+    fprintf(stderr, "CUDA error during %s: %s\n", what, cudaGetErrorString(err));
+    return false;
+}
+
+/// closest point of the segment [a, b] to p: a + t * (b - a), returns the squared distance
+__device__ inline double closestPointOnSegment(double ax, double ay, double bx, double by, double px, double py, double& t)
+{
+    const double ex = bx - ax;
+    const double ey = by - ay;
+    const double len2 = ex * ex + ey * ey;
+    t = (len2 > 0.0) ? fmin(fmax(((px - ax) * ex + (py - ay) * ey) / len2, 0.0), 1.0) : 0.0;
+    const double dx = ax + t * ex - px;
+    const double dy = ay + t * ey - py;
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Same test as isPixelInTriangle (Texturing.cpp): the pixel center is closer than sqrt(0.5) to the triangle
+ * @param[out] l2, l3 the barycentric coordinates of the closest point relative to the 2nd and 3rd points
+ */
+static __device__ bool isPixelInTriangle(const double* tri, int x, int y, double& l2, double& l3)
+{
+    const double px = x + 0.5;
+    const double py = y + 0.5;
+
+    const double e0x = tri[2] - tri[0];
+    const double e0y = tri[3] - tri[1];
+    const double e1x = tri[4] - tri[0];
+    const double e1y = tri[5] - tri[1];
+    const double vx = px - tri[0];
+    const double vy = py - tri[1];
+
+    const double d00 = e0x * e0x + e0y * e0y;
+    const double d01 = e0x * e1x + e0y * e1y;
+    const double d11 = e1x * e1x + e1y * e1y;
+    const double d20 = vx * e0x + vy * e0y;
+    const double d21 = vx * e1x + vy * e1y;
+    const double denom = d00 * d11 - d01 * d01;
+
+    if(denom != 0.0)
+    {
+        l2 = (d11 * d20 - d01 * d21) / denom;
+        l3 = (d00 * d21 - d01 * d20) / denom;
+        if(l2 >= 0.0 && l3 >= 0.0 && (1.0 - l2 - l3) >= 0.0)
+            return true;
+    }
+
+    // the closest point is on an edge
+    double t;
+    double dist = closestPointOnSegment(tri[0], tri[1], tri[2], tri[3], px, py, t);
+    l2 = t;
+    l3 = 0.0;
+
+    double d = closestPointOnSegment(tri[0], tri[1], tri[4], tri[5], px, py, t);
+    if(d < dist)
+    {
+        dist = d;
+        l2 = 0.0;
+        l3 = t;
+    }
+
+    d = closestPointOnSegment(tri[2], tri[3], tri[4], tri[5], px, py, t);
+    if(d < dist)
+    {
+        dist = d;
+        l2 = 1.0 - t;
+        l3 = t;
+    }
+
+    return dist < 0.5 + DBL_EPSILON;
+}
+
+/**
+ * @brief One thread per pixel of the triangles bounding boxes, the pixels of triangle t are in [offsets[t], offsets[t+1])
+ */
+__global__ void rasterize_kernel(cudaTextureObject_t image, ProjectionCUDA P, int width, int height, int border,
+                                 const TexturingTriangleCUDA* triangles, const int* offsets, int nbTriangles,
+                                 int nbPixels, float4* colors)
+{
+    const int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if(i >= nbPixels)
+        return;
+
+    // triangle of the pixel: last offset <= i
+    int lo = 0;
+    int hi = nbTriangles - 1;
+    while(lo < hi)
+    {
+        const int mid = (lo + hi + 1) / 2;
+        if(offsets[mid] <= i)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    const TexturingTriangleCUDA& tri = triangles[lo];
+    const int bboxWidth = tri.RDx - tri.LUx;
+    const int x = tri.LUx + (i - offsets[lo]) % bboxWidth;
+    const int y = tri.LUy + (i - offsets[lo]) / bboxWidth;
+
+    float4 color = make_float4(0.f, 0.f, 0.f, 0.f);
+    double l2, l3;
+    if(isPixelInTriangle(tri.pixs, x, y, l2, l3))
+    {
+        // 3D point (as barycentricToCartesian) projected in the camera (as MultiViewParams::getPixelFor3DPoint)
+        double X[3];
+        for(int k = 0; k < 3; ++k)
+            X[k] = tri.pts[k] + (tri.pts[6 + k] - tri.pts[k]) * l3 + (tri.pts[3 + k] - tri.pts[k]) * l2;
+
+        const double xt = P.m[0] * X[0] + P.m[1] * X[1] + P.m[2] * X[2] + P.m[3];
+        const double yt = P.m[4] * X[0] + P.m[5] * X[1] + P.m[6] * X[2] + P.m[7];
+        const double zt = P.m[8] * X[0] + P.m[9] * X[1] + P.m[10] * X[2] + P.m[11];
+        if(zt > 0.0)
+        {
+            const double px = xt / zt;
+            const double py = yt / zt;
+            const int ix = static_cast<int>(floor(px + 0.5));
+            const int iy = static_cast<int>(floor(py + 0.5));
+            if(ix >= border && ix < width - border && iy >= border && iy < height - border)
+            {
+                // the image is column major: the texture x is the image y
+                color = tex2D<float4>(image, static_cast<float>(py) + 0.5f, static_cast<float>(px) + 0.5f);
+                color.w = 1.f;
+            }
+        }
+    }
+    colors[i] = color;
+}
+
+bool texturingCUDA_isAvailable()
+{
+    int nbDevices = 0;
+    if(cudaGetDeviceCount(&nbDevices) != cudaSuccess)
+    {
+        cudaGetLastError(); // reset the error
+        return false;
+    }
+    return nbDevices > 0;
+}
+
+TexturingCameraCUDA::~TexturingCameraCUDA()
+{
+    release();
+}
+
+void TexturingCameraCUDA::release()
+{
+    if(_texture != 0)
+        cudaDestroyTextureObject(static_cast<cudaTextureObject_t>(_texture));
+    if(_array != nullptr)
+        cudaFreeArray(static_cast<cudaArray_t>(_array));
+    _texture = 0;
+    _array = nullptr;
+}
+
+bool TexturingCameraCUDA::upload(const float* rgb, int width, int height, const double* P, int border)
+{
+    release();
+
+    _width = width;
+    _height = height;
+    _border = border;
+    std::copy(P, P + 12, _P);
+
+    // float4 texels for the hardware filtering
+    std::vector<float4> texels(static_cast<std::size_t>(width) * height);
+    for(std::size_t i = 0; i < texels.size(); ++i)
+        texels[i] = make_float4(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], 0.f);
+
+    // the image is column major: the texture is height x width
+    const cudaChannelFormatDesc channelDesc = cudaCreateChannelDesc<float4>();
+    cudaArray_t array = nullptr;
+    if(cudaMallocArray(&array, &channelDesc, height, width) != cudaSuccess)
+        return checkCudaError("camera image allocation");
+    _array = array;
+
+    cudaMemcpy2DToArray(array, 0, 0, texels.data(), height * sizeof(float4), height * sizeof(float4), width,
+                        cudaMemcpyHostToDevice);
+
+    cudaResourceDesc resDesc;
+    memset(&resDesc, 0, sizeof(resDesc));
+    resDesc.resType = cudaResourceTypeArray;
+    resDesc.res.array.array = array;
+
+    cudaTextureDesc texDesc;
+    memset(&texDesc, 0, sizeof(texDesc));
+    texDesc.addressMode[0] = cudaAddressModeClamp;
+    texDesc.addressMode[1] = cudaAddressModeClamp;
+    texDesc.filterMode = cudaFilterModeLinear;
+    texDesc.readMode = cudaReadModeElementType;
+    texDesc.normalizedCoords = 0;
+
+    cudaTextureObject_t texture = 0;
+    cudaCreateTextureObject(&texture, &resDesc, &texDesc, nullptr);
+    _texture = texture;
+
+    return checkCudaError("camera image upload");
+}
+
+bool TexturingCameraCUDA::rasterize(const std::vector<TexturingTriangleCUDA>& triangles, std::vector<float>& colors) const
+{
+    std::vector<int> offsets(triangles.size() + 1);
+    offsets[0] = 0;
+    for(std::size_t i = 0; i < triangles.size(); ++i)
+        offsets[i + 1] = offsets[i] + triangles[i].nbPixels();
+    const int nbPixels = offsets.back();
+
+    colors.resize(static_cast<std::size_t>(nbPixels) * 4);
+    if(nbPixels == 0)
+        return true;
+
+    TexturingTriangleCUDA* triangles_d = nullptr;
+    int* offsets_d = nullptr;
+    float4* colors_d = nullptr;
+    bool success = (cudaMalloc(&triangles_d, triangles.size() * sizeof(TexturingTriangleCUDA)) == cudaSuccess) &&
+                   (cudaMalloc(&offsets_d, offsets.size() * sizeof(int)) == cudaSuccess) &&
+                   (cudaMalloc(&colors_d, nbPixels * sizeof(float4)) == cudaSuccess);
+
+    if(success)
+    {
+        cudaMemcpy(triangles_d, triangles.data(), triangles.size() * sizeof(TexturingTriangleCUDA), cudaMemcpyHostToDevice);
+        cudaMemcpy(offsets_d, offsets.data(), offsets.size() * sizeof(int), cudaMemcpyHostToDevice);
+
+        ProjectionCUDA P;
+        std::copy(_P, _P + 12, P.m);
+
+        const int nbBlocks = (nbPixels + TEXTURING_BLOCK_SIZE - 1) / TEXTURING_BLOCK_SIZE;
+        rasterize_kernel<<<nbBlocks, TEXTURING_BLOCK_SIZE>>>(static_cast<cudaTextureObject_t>(_texture), P,
+                                                            _width, _height, _border, triangles_d, offsets_d,
+                                                            static_cast<int>(triangles.size()), nbPixels, colors_d);
+
+        cudaMemcpy(colors.data(), colors_d, nbPixels * sizeof(float4), cudaMemcpyDeviceToHost);
+    }
+    success = checkCudaError("triangles rasterization") && success;
+
+    cudaFree(triangles_d);
+    cudaFree(offsets_d);
+    cudaFree(colors_d);
+    return success;
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,89 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief A triangle of a texture atlas to rasterize on the GPU
+ */
+struct TexturingTriangleCUDA
+{
+    /// 3D coordinates of the triangle points
+    double pts[9];
+    /// texture pixel coordinates of the triangle points
+    double pixs[6];
+    /// bounding box of the triangle in the texture, LU included, RD excluded
+    int LUx = 0;
+    int LUy = 0;
+    int RDx = 0;
+    int RDy = 0;
+
+    inline int nbPixels() const { return (RDx - LUx) * (RDy - LUy); }
+};
+
+/**
+ * @brief Check if the CUDA texturing can be used (a device is available).
+ */
+bool texturingCUDA_isAvailable();
+
+/**
+ * @brief Camera image uploaded on the current CUDA device as a linearly filtered texture,
+ *        to rasterize the atlases triangles seen by the camera.
+ *
+ * Can be shared by several host threads once uploaded.
+ */
+class TexturingCameraCUDA
+{
+public:
+    TexturingCameraCUDA() = default;
+    TexturingCameraCUDA(const TexturingCameraCUDA&) = delete;
+    TexturingCameraCUDA& operator=(const TexturingCameraCUDA&) = delete;
+    ~TexturingCameraCUDA();
+
+    /**
+     * @brief Upload a camera image
+     * @param[in] rgb the image, 3 floats per pixel, column major (as mvsUtils::ImagesCache)
+     * @param[in] width the image width
+     * @param[in] height the image height
+     * @param[in] P the 3x4 projection matrix, row major
+     * @param[in] border the image border excluded from the sampling (as MultiViewParams::isPixelInImage)
+     * @return false on CUDA error (out of memory, ...)
+     */
+    bool upload(const float* rgb, int width, int height, const double* P, int border);
+
+    /**
+     * @brief Rasterize triangles in the texture and sample their colors in the camera image.
+     *
+     * Same tests as the CPU texturing: the pixels centers closer than sqrt(0.5) to the triangle are rasterized,
+     * the pixels projected out of the image or behind the camera are invalid.
+     *
+     * @param[in] triangles the triangles
+     * @param[out] colors the sampled color (r, g, b) and validity (1 or 0) of each pixel of the triangles
+     *             bounding boxes, in triangles order then row major order inside the bounding box
+     * @return false on CUDA error, the outputs are then undefined
+     */
+    bool rasterize(const std::vector<TexturingTriangleCUDA>& triangles, std::vector<float>& colors) const;
+
+private:
+    void release();
+
+    int _width = 0;
+    int _height = 0;
+    int _border = 0;
+    double _P[12];
+    /// cudaArray_t
+    void* _array = nullptr;
+    /// cudaTextureObject_t
+    unsigned long long _texture = 0;
+};
+
+} // namespace mesh
+} // namespace aliceVision
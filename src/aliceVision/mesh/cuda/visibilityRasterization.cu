@@ -0,0 +1,265 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/cuda/visibilityRasterization.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace aliceVision {
+namespace mesh {
+
+/// size of the 1D CUDA blocks
+#define VISIBILITY_BLOCK_SIZE 256
+
+namespace {
+
+/**
+ * @brief 3x4 projection matrix passed by value to the CUDA kernels
+ */
+struct VisibilityProjectionCUDA
+{
+    double m[12];
+};
+
+/// empty pixel of the z-buffer
+const unsigned long long emptyPixel = 0xFFFFFFFFFFFFFFFFull;
+
+bool checkCudaError(const char* what)
+{
+    const cudaError_t err = cudaGetLastError();
+    if(err == cudaSuccess)
+        return true;
+    fprintf(stderr, "CUDA error during %s: %s\n", what, cudaGetErrorString(err));
+    return false;
+}
+
+/**
+ * @brief Project the points of a triangle (as MultiViewParams::getPixelFor3DPoint)
+ * @return false if a point is behind the camera
+ */
+__device__ bool projectTriangle(const VisibilityProjectionCUDA& P, const double3* points, int3 tri, double* x, double* y, double* z)
+{
+    const int ids[3] = {tri.x, tri.y, tri.z};
+    for(int k = 0; k < 3; ++k)
+    {
+        const double3 X = points[ids[k]];
+        const double xt = P.m[0] * X.x + P.m[1] * X.y + P.m[2] * X.z + P.m[3];
+        const double yt = P.m[4] * X.x + P.m[5] * X.y + P.m[6] * X.z + P.m[7];
+        const double zt = P.m[8] * X.x + P.m[9] * X.y + P.m[10] * X.z + P.m[11];
+        if(zt <= 0.0)
+            return false;
+        x[k] = xt / zt;
+        y[k] = yt / zt;
+        z[k] = zt;
+    }
+    return true;
+}
+
+/// the depth is the high part of the key, so the closest triangle has the smallest key
+__device__ unsigned long long depthKey(double invDepth, int triId)
+{
+    const float depth = static_cast<float>(1.0 / invDepth);
+    return (static_cast<unsigned long long>(__float_as_uint(depth)) << 32) | static_cast<unsigned int>(triId);
+}
+
+/**
+ * @brief Visit the pixel centers covered by a projected triangle, with the inverse depth at the pixel
+ *        (interpolated linearly in the image)
+ */
+template <class PixelFunctor>
+__device__ void rasterizeTriangle(const double* x, const double* y, const double* z, int width, int height, PixelFunctor& f)
+{
+    const double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if(area == 0.0)
+        return;
+
+    const int xmin = max(0, static_cast<int>(ceil(fmin(x[0], fmin(x[1], x[2])))));
+    const int xmax = min(width - 1, static_cast<int>(floor(fmax(x[0], fmax(x[1], x[2])))));
+    const int ymin = max(0, static_cast<int>(ceil(fmin(y[0], fmin(y[1], y[2])))));
+    const int ymax = min(height - 1, static_cast<int>(floor(fmax(y[0], fmax(y[1], y[2])))));
+
+    for(int py = ymin; py <= ymax; ++py)
+    {
+        for(int px = xmin; px <= xmax; ++px)
+        {
+            // barycentric coordinates of the pixel center
+            const double l0 = ((x[1] - px) * (y[2] - py) - (x[2] - px) * (y[1] - py)) / area;
+            const double l1 = ((x[2] - px) * (y[0] - py) - (x[0] - px) * (y[2] - py)) / area;
+            const double l2 = 1.0 - l0 - l1;
+            if(l0 < 0.0 || l1 < 0.0 || l2 < 0.0)
+                continue;
+            f(py * width + px, l0 / z[0] + l1 / z[1] + l2 / z[2]);
+        }
+    }
+}
+
+struct DepthTest
+{
+    unsigned long long* zbuffer;
+    int triId;
+
+    __device__ void operator()(int pixel, double invDepth)
+    {
+        atomicMin(&zbuffer[pixel], depthKey(invDepth, triId));
+    }
+};
+
+struct VisibilityTest
+{
+    const unsigned long long* zbuffer;
+    int triId;
+    int nbPixels = 0;
+    bool visible = false;
+
+    __device__ void operator()(int pixel, double /*invDepth*/)
+    {
+        ++nbPixels;
+        visible = visible || (static_cast<unsigned int>(zbuffer[pixel] & 0xFFFFFFFFull) == static_cast<unsigned int>(triId));
+    }
+};
+
+/**
+ * @brief One thread per triangle: keep the closest triangle at each pixel center
+ */
+__global__ void depthTest_kernel(VisibilityProjectionCUDA P, const double3* points, const int3* triangles, int nbTriangles,
+                                 int width, int height, unsigned long long* zbuffer)
+{
+    const int triId = blockIdx.x * blockDim.x + threadIdx.x;
+    if(triId >= nbTriangles)
+        return;
+
+    double x[3], y[3], z[3];
+    if(!projectTriangle(P, points, triangles[triId], x, y, z))
+        return;
+
+    DepthTest f;
+    f.zbuffer = zbuffer;
+    f.triId = triId;
+    rasterizeTriangle(x, y, z, width, height, f);
+}
+
+/**
+ * @brief One thread per triangle: list the triangles closest at one of their pixels,
+ *        or whose center is not hidden if they cover no pixel center
+ */
+__global__ void visibility_kernel(VisibilityProjectionCUDA P, const double3* points, const int3* triangles, int nbTriangles,
+                                  int width, int height, const unsigned long long* zbuffer, int* visibleTris, int* nbVisibleTris)
+{
+    const int triId = blockIdx.x * blockDim.x + threadIdx.x;
+    if(triId >= nbTriangles)
+        return;
+
+    double x[3], y[3], z[3];
+    if(!projectTriangle(P, points, triangles[triId], x, y, z))
+        return;
+
+    VisibilityTest f;
+    f.zbuffer = zbuffer;
+    f.triId = triId;
+    rasterizeTriangle(x, y, z, width, height, f);
+
+    if(f.nbPixels == 0)
+    {
+        const int px = static_cast<int>(floor((x[0] + x[1] + x[2]) / 3.0 + 0.5));
+        const int py = static_cast<int>(floor((y[0] + y[1] + y[2]) / 3.0 + 0.5));
+        if(px >= 0 && px < width && py >= 0 && py < height)
+        {
+            const unsigned long long key = zbuffer[py * width + px];
+            const float depth = static_cast<float>(3.0 / (1.0 / z[0] + 1.0 / z[1] + 1.0 / z[2]));
+            f.visible = (key == emptyPixel) || (depth <= __uint_as_float(static_cast<unsigned int>(key >> 32)) * 1.001f);
+        }
+    }
+
+    if(f.visible)
+        visibleTris[atomicAdd(nbVisibleTris, 1)] = triId;
+}
+
+} // namespace
+
+VisibilityMeshCUDA::~VisibilityMeshCUDA()
+{
+    release();
+}
+
+void VisibilityMeshCUDA::release()
+{
+    cudaFree(_points);
+    cudaFree(_triangles);
+    cudaFree(_zbuffer);
+    cudaFree(_visibleTris);
+    cudaFree(_nbVisibleTris);
+    _points = nullptr;
+    _triangles = nullptr;
+    _zbuffer = nullptr;
+    _zbufferSize = 0;
+    _visibleTris = nullptr;
+    _nbVisibleTris = nullptr;
+    _nbTriangles = 0;
+}
+
+bool VisibilityMeshCUDA::upload(const std::vector<double>& points, const std::vector<int>& triangles)
+{
+    release();
+
+    _nbTriangles = static_cast<int>(triangles.size() / 3);
+    const bool success = (cudaMalloc(&_points, std::max<std::size_t>(points.size(), 3) * sizeof(double)) == cudaSuccess) &&
+                         (cudaMalloc(&_triangles, std::max<std::size_t>(triangles.size(), 3) * sizeof(int)) == cudaSuccess) &&
+                         (cudaMalloc(&_visibleTris, std::max(_nbTriangles, 1) * sizeof(int)) == cudaSuccess) &&
+                         (cudaMalloc(&_nbVisibleTris, sizeof(int)) == cudaSuccess);
+    if(!success)
+        return checkCudaError("mesh allocation");
+
+    cudaMemcpy(_points, points.data(), points.size() * sizeof(double), cudaMemcpyHostToDevice);
+    cudaMemcpy(_triangles, triangles.data(), triangles.size() * sizeof(int), cudaMemcpyHostToDevice);
+    return checkCudaError("mesh upload");
+}
+
+bool VisibilityMeshCUDA::getVisibleTriangles(const double* P, int width, int height, std::vector<int>& visibleTris)
+{
+    visibleTris.clear();
+    if(_nbTriangles == 0 || width <= 0 || height <= 0)
+        return true;
+
+    const std::size_t nbPixels = static_cast<std::size_t>(width) * height;
+    if(nbPixels > _zbufferSize)
+    {
+        cudaFree(_zbuffer);
+        _zbuffer = nullptr;
+        _zbufferSize = 0;
+        if(cudaMalloc(&_zbuffer, nbPixels * sizeof(unsigned long long)) != cudaSuccess)
+            return checkCudaError("z-buffer allocation");
+        _zbufferSize = nbPixels;
+    }
+
+    VisibilityProjectionCUDA projection;
+    std::copy(P, P + 12, projection.m);
+
+    unsigned long long* zbuffer = static_cast<unsigned long long*>(_zbuffer);
+    const double3* points = static_cast<const double3*>(_points);
+    const int3* triangles = static_cast<const int3*>(_triangles);
+    int* nbVisibleTris_d = static_cast<int*>(_nbVisibleTris);
+
+    cudaMemset(zbuffer, 0xFF, nbPixels * sizeof(unsigned long long));
+    cudaMemset(nbVisibleTris_d, 0, sizeof(int));
+
+    const int nbBlocks = (_nbTriangles + VISIBILITY_BLOCK_SIZE - 1) / VISIBILITY_BLOCK_SIZE;
+    depthTest_kernel<<<nbBlocks, VISIBILITY_BLOCK_SIZE>>>(projection, points, triangles, _nbTriangles, width, height, zbuffer);
+    visibility_kernel<<<nbBlocks, VISIBILITY_BLOCK_SIZE>>>(projection, points, triangles, _nbTriangles, width, height, zbuffer,
+                                                           static_cast<int*>(_visibleTris), nbVisibleTris_d);
+
+    int nbVisibleTris = 0;
+    cudaMemcpy(&nbVisibleTris, nbVisibleTris_d, sizeof(int), cudaMemcpyDeviceToHost);
+    visibleTris.resize(nbVisibleTris);
+    if(nbVisibleTris > 0)
+        cudaMemcpy(visibleTris.data(), _visibleTris, nbVisibleTris * sizeof(int), cudaMemcpyDeviceToHost);
+    std::sort(visibleTris.begin(), visibleTris.end());
+
+    return checkCudaError("visibility rasterization");
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,65 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Mesh uploaded on the current CUDA device, to render the z-buffer of the triangle indexes of the cameras
+ *        and list their visible triangles, without reading back the z-buffers.
+ *
+ * Same visibility as Mesh::getVisibleTrianglesZBuffer: a triangle is visible if it is the closest one
+ * at a pixel center, or if its center of gravity is not hidden (triangles smaller than a pixel).
+ */
+class VisibilityMeshCUDA
+{
+public:
+    VisibilityMeshCUDA() = default;
+    VisibilityMeshCUDA(const VisibilityMeshCUDA&) = delete;
+    VisibilityMeshCUDA& operator=(const VisibilityMeshCUDA&) = delete;
+    ~VisibilityMeshCUDA();
+
+    /**
+     * @brief Upload the mesh
+     * @param[in] points the 3D coordinates of the points (x, y, z)
+     * @param[in] triangles the 3 point indexes of each triangle
+     * @return false on CUDA error (out of memory, ...)
+     */
+    bool upload(const std::vector<double>& points, const std::vector<int>& triangles);
+
+    /**
+     * @brief Render the z-buffer of a camera and list its visible triangles
+     * @param[in] P the 3x4 projection matrix of the z-buffer, row major
+     * @param[in] width the z-buffer width
+     * @param[in] height the z-buffer height
+     * @param[out] visibleTris the visible triangles, sorted
+     * @return false on CUDA error, the output is then undefined
+     */
+    bool getVisibleTriangles(const double* P, int width, int height, std::vector<int>& visibleTris);
+
+private:
+    void release();
+
+    int _nbTriangles = 0;
+    /// double3 per point
+    void* _points = nullptr;
+    /// int3 per triangle
+    void* _triangles = nullptr;
+    /// (depth, triangle) key per pixel, reused by the cameras
+    void* _zbuffer = nullptr;
+    std::size_t _zbufferSize = 0;
+    /// visible triangles of the last camera and their number
+    void* _visibleTris = nullptr;
+    void* _nbVisibleTris = nullptr;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,78 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Append a printf formatted string to a buffer
+ */
+inline void appendFormat(std::string& buffer, const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    const int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if(length < 0)
+        return;
+    if(length < static_cast<int>(sizeof(line)))
+    {
+        buffer.append(line, length);
+        return;
+    }
+    // longer line
+    std::vector<char> longLine(length + 1);
+    va_start(args, format);
+    std::vsnprintf(longLine.data(), longLine.size(), format, args);
+    va_end(args);
+    buffer.append(longLine.data(), length);
+}
+
+/**
+ * @brief Write text lines to a file, formatted in parallel by blocks and written in order
+ * @param[in] file the output file
+ * @param[in] nbLines the number of lines
+ * @param[in] formatLine void(int lineId, std::string& buffer), appends the line to the buffer
+ */
+template <typename FormatLine>
+void writeLinesParallel(std::FILE* file, int nbLines, const FormatLine& formatLine)
+{
+    const int blockSize = 16384;
+    // number of blocks in memory at once
+    const int groupSize = 64;
+    std::vector<std::string> blocks(groupSize);
+
+    for(int groupStart = 0; groupStart < nbLines; groupStart += blockSize * groupSize)
+    {
+        const int nbBlocks = std::min(groupSize, (nbLines - groupStart + blockSize - 1) / blockSize);
+
+        #pragma omp parallel for
+        for(int b = 0; b < nbBlocks; ++b)
+        {
+            std::string& block = blocks[b];
+            block.clear();
+            const int begin = groupStart + b * blockSize;
+            const int end = std::min(nbLines, begin + blockSize);
+            for(int i = begin; i < end; ++i)
+                formatLine(i, block);
+        }
+
+        for(int b = 0; b < nbBlocks; ++b)
+            std::fwrite(blocks[b].data(), 1, blocks[b].size(), file);
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -9,56 +9,178 @@
 
 #include <geogram/points/kd_tree.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
-int getNearestVertices(const Mesh& refMesh, const Mesh& mesh, StaticVector<int>& out_nearestVertex)
+namespace {
+
+/// number of bits per axis of the grid used to order the queries
+const int QUERY_GRID_BITS = 7;
+
+/// interleave the bits of a value on 3 * QUERY_GRID_BITS bits
+inline std::uint32_t spreadBits(std::uint32_t v)
 {
-    ALICEVISION_LOG_DEBUG("getNearestVertices start.");
-    out_nearestVertex.resize(mesh.pts->size(), -1);
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+/**
+ * @brief Order of the points along a Morton curve on a coarse grid of their bounding box (counting sort),
+ *        so that consecutive queries visit the same kd-tree nodes
+ */
+void getSpatialOrder(const StaticVector<Point3d>& pts, std::vector<int>& out_order)
+{
+    const int npts = pts.size();
+    double minX = std::numeric_limits<double>::max();
+    double minY = minX;
+    double minZ = minX;
+    double maxX = std::numeric_limits<double>::lowest();
+    double maxY = maxX;
+    double maxZ = maxX;
+
+    #pragma omp parallel for reduction(min:minX, minY, minZ) reduction(max:maxX, maxY, maxZ)
+    for(int i = 0; i < npts; ++i)
+    {
+        minX = std::min(minX, pts[i].x);
+        minY = std::min(minY, pts[i].y);
+        minZ = std::min(minZ, pts[i].z);
+        maxX = std::max(maxX, pts[i].x);
+        maxY = std::max(maxY, pts[i].y);
+        maxZ = std::max(maxZ, pts[i].z);
+    }
 
-    GEO::AdaptiveKdTree refMesh_kdTree(3);
-    refMesh_kdTree.set_points(refMesh.pts->size(), refMesh.pts->front().m);
+    const int gridSize = 1 << QUERY_GRID_BITS;
+    const double extent = std::max(std::max(maxX - minX, maxY - minY), std::max(maxZ - minZ, 1e-12));
+    const double scale = (gridSize - 1) / extent;
 
+    std::vector<std::uint32_t> codes(npts);
     #pragma omp parallel for
-    for(int i = 0; i < mesh.pts->size(); ++i)
+    for(int i = 0; i < npts; ++i)
     {
-        out_nearestVertex[i] = refMesh_kdTree.get_nearest_neighbor((*mesh.pts)[i].m);
+        const std::uint32_t x = static_cast<std::uint32_t>((pts[i].x - minX) * scale);
+        const std::uint32_t y = static_cast<std::uint32_t>((pts[i].y - minY) * scale);
+        const std::uint32_t z = static_cast<std::uint32_t>((pts[i].z - minZ) * scale);
+        codes[i] = spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
     }
-    ALICEVISION_LOG_DEBUG("getNearestVertices done.");
-    return 0;
-}
 
+    // counting sort on the grid cells
+    std::vector<int> cellsOffset((1 << (3 * QUERY_GRID_BITS)) + 1, 0);
+    for(int i = 0; i < npts; ++i)
+        ++cellsOffset[codes[i] + 1];
+    for(std::size_t c = 1; c < cellsOffset.size(); ++c)
+        cellsOffset[c] += cellsOffset[c - 1];
 
-void remapMeshVisibilities(
-    const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
-    const Mesh& mesh, PointsVisibility& out_ptsVisibilities)
+    out_order.resize(npts);
+    for(int i = 0; i < npts; ++i)
+        out_order[cellsOffset[codes[i]]++] = i;
+}
+
+/**
+ * @brief Index of the nearest reference point of each query point (-1 if there is no reference point),
+ *        the queries are done in parallel by batches of spatially close points
+ */
+void getNearestPoints(const StaticVector<Point3d>& refPts, const StaticVector<Point3d>& queryPts, StaticVector<int>& out_nearest)
 {
-    ALICEVISION_LOG_DEBUG("remapMeshVisibility start.");
+    out_nearest.resize(queryPts.size(), -1);
+    if(refPts.empty() || queryPts.empty())
+        return;
 
-    GEO::AdaptiveKdTree refMesh_kdTree(3);
-    refMesh_kdTree.set_points(refMesh.pts->size(), refMesh.pts->front().m);
+    GEO::AdaptiveKdTree kdTree(3);
+    kdTree.set_points(refPts.size(), refPts.front().m);
 
-    out_ptsVisibilities.resize(mesh.pts->size());
+    std::vector<int> order;
+    getSpatialOrder(queryPts, order);
+
+    const int nqueries = queryPts.size();
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(int j = 0; j < nqueries; ++j)
+    {
+        const int i = order[j];
+        out_nearest[i] = kdTree.get_nearest_neighbor(queryPts[i].m);
+    }
+}
+
+/// copy the visibility of the nearest reference element of each element
+void copyNearestVisibilities(const PointsVisibility& refVisibilities, const StaticVector<int>& nearest,
+                             PointsVisibility& out_visibilities)
+{
+    out_visibilities.resize(nearest.size());
 
     #pragma omp parallel for
-    for(int i = 0; i < mesh.pts->size(); ++i)
+    for(int i = 0; i < nearest.size(); ++i)
     {
         PointVisibility* pOut = new StaticVector<int>();
-        out_ptsVisibilities[i] = pOut; // give ownership
+        out_visibilities[i] = pOut; // give ownership
 
-        int iRef = refMesh_kdTree.get_nearest_neighbor((*mesh.pts)[i].m);
+        const int iRef = nearest[i];
         if(iRef == -1)
             continue;
-        PointVisibility* pRef = refPtsVisibilities[iRef];
+        const PointVisibility* pRef = refVisibilities[iRef];
         if(pRef == nullptr)
             continue;
 
         *pOut = *pRef;
     }
+}
+
+void getTrianglesCenters(const Mesh& mesh, StaticVector<Point3d>& out_centers)
+{
+    out_centers.resize(mesh.tris->size());
+
+    #pragma omp parallel for
+    for(int i = 0; i < mesh.tris->size(); ++i)
+        out_centers[i] = mesh.computeTriangleCenterOfGravity(i);
+}
+
+} // namespace
+
+int getNearestVertices(const Mesh& refMesh, const Mesh& mesh, StaticVector<int>& out_nearestVertex)
+{
+    ALICEVISION_LOG_DEBUG("getNearestVertices start.");
+    getNearestPoints(*refMesh.pts, *mesh.pts, out_nearestVertex);
+    ALICEVISION_LOG_DEBUG("getNearestVertices done.");
+    return 0;
+}
+
+
+void remapMeshVisibilities(
+    const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
+    const Mesh& mesh, PointsVisibility& out_ptsVisibilities)
+{
+    ALICEVISION_LOG_DEBUG("remapMeshVisibility start.");
+
+    StaticVector<int> nearestVertex;
+    getNearestPoints(*refMesh.pts, *mesh.pts, nearestVertex);
+    copyNearestVisibilities(refPtsVisibilities, nearestVertex, out_ptsVisibilities);
 
     ALICEVISION_LOG_DEBUG("remapMeshVisibility done.");
 }
 
+void remapMeshTrianglesVisibilities(
+    const Mesh& refMesh, const PointsVisibility& refTrisVisibilities,
+    const Mesh& mesh, PointsVisibility& out_trisVisibilities)
+{
+    ALICEVISION_LOG_DEBUG("remapMeshTrianglesVisibilities start.");
+
+    StaticVector<Point3d> refCenters;
+    StaticVector<Point3d> centers;
+    getTrianglesCenters(refMesh, refCenters);
+    getTrianglesCenters(mesh, centers);
+
+    StaticVector<int> nearestTriangle;
+    getNearestPoints(refCenters, centers, nearestTriangle);
+    copyNearestVisibilities(refTrisVisibilities, nearestTriangle, out_trisVisibilities);
+
+    ALICEVISION_LOG_DEBUG("remapMeshTrianglesVisibilities done.");
+}
+
 } // namespace mesh
 } // namespace aliceVision
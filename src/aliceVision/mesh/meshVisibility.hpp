@@ -17,6 +17,7 @@ using PointsVisibility = StaticVector<PointVisibility*>;
 
 /**
  * @brief Retrieve the nearest neighbor vertex in @p refMesh for each vertex in @p mesh.
+ * The queries are done in parallel, by batches of spatially close vertices.
  * @param[in] refMesh input reference mesh
  * @param[in] mesh input target mesh
  * @param[out] out_nearestVertex index of the nearest vertex in @p refMesh for each vertex in @p mesh
@@ -38,5 +39,19 @@ void remapMeshVisibilities(
     const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
     const Mesh& mesh, PointsVisibility& out_ptsVisibilities);
 
+/**
+ * @brief Transfer the visibility per triangle from one mesh to another.
+ * For each triangle of the @p mesh, we search the reference triangle with the nearest center of gravity
+ * and copy its visibility information.
+ *
+ * @param[in] refMesh input reference mesh
+ * @param[in] refTrisVisibilities visibility array per triangle of @p refMesh
+ * @param[in] mesh input target mesh
+ * @param[out] out_trisVisibilities visibility array per triangle of @p mesh
+ */
+void remapMeshTrianglesVisibilities(
+    const Mesh& refMesh, const PointsVisibility& refTrisVisibilities,
+    const Mesh& mesh, PointsVisibility& out_trisVisibilities);
+
 } // namespace mesh
 } // namespace aliceVision
@@ -13,7 +13,11 @@
 
 namespace aliceVision {
 
-Mat FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2) {
+namespace {
+
+// Nullspace of the epipolar constraints (A is square, padded with zeros if needed).
+template<typename TMatX>
+Eigen::Matrix<double, 9, 4> nullspaceBasis(const TMatX &x1, const TMatX &x2) {
   Eigen::Matrix<double,9, 9> A;
   A.setZero();  // Make A square until Eigen supports rectangular SVD.
   fundamental::kernel::EncodeEpipolarEquation(x1, x2, &A);
@@ -21,8 +25,55 @@ Mat FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2) {
   return svd.matrixV().topRightCorner<9,4>();
 }
 
-Vec o1(const Vec &a, const Vec &b) {
-  Vec res = Vec::Zero(20);
+// Solve the polynomial system from the nullspace basis (steps 2 to 4).
+void FivePointsRelativePoseFromBasis(const Eigen::Matrix<double, 9, 4> &E_basis,
+                                     vector<Mat3> *Es) {
+  // Step 2: Constraint Expansion.
+  const Eigen::Matrix<double, 10, 20> E_constraints = FivePointsPolynomialConstraints(E_basis);
+
+  // Step 3: Gauss-Jordan Elimination (done thanks to a LU decomposition).
+  typedef Eigen::Matrix<double, 10, 10> Mat10;
+  Eigen::FullPivLU<Mat10> c_lu(E_constraints.block<10, 10>(0, 0));
+  const Mat10 M = c_lu.solve(E_constraints.block<10, 10>(0, 10));
+
+  // For next steps we follow the matlab code given in Stewenius et al [1].
+
+  // Build action matrix.
+
+  const Mat10 & B = M.topRightCorner<10,10>();
+  Mat10 At = Mat10::Zero(10,10);
+  At.block<3, 10>(0, 0) = B.block<3, 10>(0, 0);
+  At.row(3) = B.row(4);
+  At.row(4) = B.row(5);
+  At.row(5) = B.row(7);
+  At(6,0) = At(7,1) = At(8,3) = At(9,6) = -1;
+
+  Eigen::EigenSolver<Mat10> eigensolver(At);
+  const auto& eigenvectors = eigensolver.eigenvectors();
+  const auto& eigenvalues = eigensolver.eigenvalues();
+
+  // Build essential matrices for the real solutions.
+  Es->reserve(Es->size() + 10);
+  for (int s = 0; s < 10; ++s) {
+    // Only consider real solutions.
+    if (eigenvalues(s).imag() != 0) {
+      continue;
+    }
+    Mat3 E;
+    Eigen::Map<Vec9 >(E.data()) =
+        E_basis * eigenvectors.col(s).tail<4>().real();
+    Es->emplace_back(E.transpose());
+  }
+}
+
+} // namespace
+
+Eigen::Matrix<double, 9, 4> FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2) {
+  return nullspaceBasis(x1, x2);
+}
+
+Vec20 o1(const Vec20 &a, const Vec20 &b) {
+  Vec20 res = Vec20::Zero();
 
   res(coef_xx) = a(coef_x) * b(coef_x);
   res(coef_xy) = a(coef_x) * b(coef_y)
@@ -44,8 +95,8 @@ Vec o1(const Vec &a, const Vec &b) {
   return res;
 }
 
-Vec o2(const Vec &a, const Vec &b) {
-  Vec res(20);
+Vec20 o2(const Vec20 &a, const Vec20 &b) {
+  Vec20 res;
 
   res(coef_xxx) = a(coef_xx) * b(coef_x);
   res(coef_xxy) = a(coef_xx) * b(coef_y)
@@ -91,12 +142,12 @@ Vec o2(const Vec &a, const Vec &b) {
   return res;
 }
 
-Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
+Eigen::Matrix<double, 10, 20> FivePointsPolynomialConstraints(const Eigen::Matrix<double, 9, 4> &E_basis) {
   // Build the polynomial form of E (equation (8) in Stewenius et al. [1])
-  Vec E[3][3];
+  Vec20 E[3][3];
   for (int i = 0; i < 3; ++i) {
     for (int j = 0; j < 3; ++j) {
-      E[i][j] = Vec::Zero(20);
+      E[i][j] = Vec20::Zero();
       E[i][j](coef_x) = E_basis(3 * i + j, 0);
       E[i][j](coef_y) = E_basis(3 * i + j, 1);
       E[i][j](coef_z) = E_basis(3 * i + j, 2);
@@ -105,7 +156,7 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
   }
 
   // The constraint matrix.
-  Mat M(10, 20);
+  Eigen::Matrix<double, 10, 20> M;
   int mrow = 0;
 
   // Determinant constraint det(E) = 0; equation (19) of Nister [2].
@@ -115,7 +166,7 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
 
   // Cubic singular values constraint.
   // Equation (20).
-  Vec EET[3][3];
+  Vec20 EET[3][3];
   for (int i = 0; i < 3; ++i) {    // Since EET is symmetric, we only compute
     for (int j = 0; j < 3; ++j) {  // its upper triangular part.
       if (i <= j) {
@@ -129,8 +180,8 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
   }
 
   // Equation (21).
-  Vec (&L)[3][3] = EET;
-  Vec trace  = 0.5 * (EET[0][0] + EET[1][1] + EET[2][2]);
+  Vec20 (&L)[3][3] = EET;
+  const Vec20 trace  = 0.5 * (EET[0][0] + EET[1][1] + EET[2][2]);
   for (int i = 0; i < 3; ++i) {
     L[i][i] -= trace;
   }
@@ -138,7 +189,7 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
   // Equation (23).
   for (int i = 0; i < 3; ++i) {
     for (int j = 0; j < 3; ++j) {
-      Vec LEij = o2(L[i][0], E[0][j])
+      const Vec20 LEij = o2(L[i][0], E[0][j])
                + o2(L[i][1], E[1][j])
                + o2(L[i][2], E[2][j]);
       M.row(mrow++) = LEij;
@@ -152,43 +203,27 @@ void FivePointsRelativePose(const Mat2X &x1,
                             const Mat2X &x2,
                             vector<Mat3> *Es) {
   // Step 1: Nullspace Extraction.
-  const Eigen::Matrix<double, 9, 4> E_basis = FivePointsNullspaceBasis(x1, x2);
-
-  // Step 2: Constraint Expansion.
-  const Eigen::Matrix<double, 10, 20> E_constraints = FivePointsPolynomialConstraints(E_basis);
-
-  // Step 3: Gauss-Jordan Elimination (done thanks to a LU decomposition).
-  typedef Eigen::Matrix<double, 10, 10> Mat10;
-  Eigen::FullPivLU<Mat10> c_lu(E_constraints.block<10, 10>(0, 0));
-  const Mat10 M = c_lu.solve(E_constraints.block<10, 10>(0, 10));
-
-  // For next steps we follow the matlab code given in Stewenius et al [1].
-
-  // Build action matrix.
-
-  const Mat10 & B = M.topRightCorner<10,10>();
-  Mat10 At = Mat10::Zero(10,10);
-  At.block<3, 10>(0, 0) = B.block<3, 10>(0, 0);
-  At.row(3) = B.row(4);
-  At.row(4) = B.row(5);
-  At.row(5) = B.row(7);
-  At(6,0) = At(7,1) = At(8,3) = At(9,6) = -1;
+  FivePointsRelativePoseFromBasis(nullspaceBasis(x1, x2), Es);
+}
 
-  Eigen::EigenSolver<Mat10> eigensolver(At);
-  const auto& eigenvectors = eigensolver.eigenvectors();
-  const auto& eigenvalues = eigensolver.eigenvalues();
+void FivePointsRelativePose(const Mat25 &x1,
+                            const Mat25 &x2,
+                            vector<Mat3> *Es) {
+  // Step 1: Nullspace Extraction.
+  FivePointsRelativePoseFromBasis(nullspaceBasis(x1, x2), Es);
+}
 
-  // Build essential matrices for the real solutions.
-  Es->reserve(10);
-  for (int s = 0; s < 10; ++s) {
-    // Only consider real solutions.
-    if (eigenvalues(s).imag() != 0) {
-      continue;
-    }
-    Mat3 E;
-    Eigen::Map<Vec9 >(E.data()) =
-        E_basis * eigenvectors.col(s).tail<4>().real();
-    Es->emplace_back(E.transpose());
+void FivePointsRelativePoseBatch(const Mat2X &x1,
+                                 const Mat2X &x2,
+                                 vector<vector<Mat3> > *Es) {
+  assert(x1.cols() == x2.cols());
+  assert(x1.cols() % 5 == 0);
+  const Mat2X::Index nbSamples = x1.cols() / 5;
+  Es->resize(nbSamples);
+  for (Mat2X::Index i = 0; i < nbSamples; ++i) {
+    (*Es)[i].clear();
+    FivePointsRelativePose(Mat25(x1.block<2, 5>(0, 5 * i)),
+                           Mat25(x2.block<2, 5>(0, 5 * i)), &(*Es)[i]);
   }
 }
 
@@ -15,6 +15,11 @@
 namespace aliceVision {
   using namespace std;
 
+/// Five correspondences in one image (one point per column)
+typedef Eigen::Matrix<double, 2, 5> Mat25;
+/// Polynomial of degree 3 in x, y, z (see the monomial basis below)
+typedef Eigen::Matrix<double, 20, 1> Vec20;
+
 /** Computes the relative pose of two calibrated cameras from 5 correspondences.
  *
  * \param x1 Points in the first image.  One per column.
@@ -24,17 +29,32 @@ namespace aliceVision {
 void FivePointsRelativePose(const Mat2X &x1, const Mat2X &x2,
                             vector<Mat3> *E);
 
+/** Computes the relative pose of two calibrated cameras from exactly 5 correspondences.
+ *  All the computations use fixed-size matrices: no heap allocation except for the output.
+ */
+void FivePointsRelativePose(const Mat25 &x1, const Mat25 &x2,
+                            vector<Mat3> *E);
+
+/** Solves several minimal samples at once.
+ *
+ * \param x1 Points in the first image, 5 columns per sample.
+ * \param x2 Corresponding points in the second image, 5 columns per sample.
+ * \param Es The candidate essential matrices of each sample.
+ */
+void FivePointsRelativePoseBatch(const Mat2X &x1, const Mat2X &x2,
+                                 vector<vector<Mat3> > *Es);
+
 // Compute the nullspace of the linear constraints given by the matches.
-Mat FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2);
+Eigen::Matrix<double, 9, 4> FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2);
 
 // Multiply two polynomials of degree 1.
-Vec o1(const Vec &a, const Vec &b);
+Vec20 o1(const Vec20 &a, const Vec20 &b);
 
 // Multiply a polynomial of degree 2, a, by a polynomial of degree 1, b.
-Vec o2(const Vec &a, const Vec &b);
+Vec20 o2(const Vec20 &a, const Vec20 &b);
 
 // Builds the polynomial constraint matrix M.
-Mat FivePointsPolynomialConstraints(const Mat &E_basis);
+Eigen::Matrix<double, 10, 20> FivePointsPolynomialConstraints(const Eigen::Matrix<double, 9, 4> &E_basis);
 
 // In the following code, polynomials are expressed as vectors containing
 // their coeficients in the basis of monomials:
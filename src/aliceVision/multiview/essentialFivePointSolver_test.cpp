@@ -247,6 +247,36 @@ BOOST_AUTO_TEST_CASE(FivePointsRelativePose_test_data_sets) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(FivePointsRelativePose_Batch) {
+
+  //-- Solve the pairs (0, i) of a camera ring at once
+  const int iNviews = 5;
+  NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    NViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  Mat2X x1(2, 5 * (iNviews - 1));
+  Mat2X x2(2, 5 * (iNviews - 1));
+  for (int i = 1; i < iNviews; ++i) {
+    x1.block<2, 5>(0, 5 * (i - 1)) = d._x[0];
+    x2.block<2, 5>(0, 5 * (i - 1)) = d._x[i];
+  }
+
+  vector<vector<Mat3> > batchEs;
+  FivePointsRelativePoseBatch(x1, x2, &batchEs);
+  BOOST_CHECK_EQUAL(batchEs.size(), iNviews - 1);
+
+  // Same solutions as the sample by sample solver
+  for (int i = 1; i < iNviews; ++i) {
+    vector<Mat3> Es;
+    FivePointsRelativePose(d._x[0], d._x[i], &Es);
+    const vector<Mat3> & sampleEs = batchEs[i - 1];
+    BOOST_CHECK_EQUAL(sampleEs.size(), Es.size());
+    for (size_t s = 0; s < std::min(Es.size(), sampleEs.size()); ++s) {
+      EXPECT_MATRIX_NEAR(Es[s], sampleEs[s], 1e-8);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(FivePointsNullspaceBasis_SatisfyEpipolarConstraint) {
 
   TestData d = SomeTestData();
@@ -51,7 +51,10 @@ void FivePointSolver::Solve(const Mat &x1, const Mat &x2, vector<Mat3> *E) {
   assert(x1.rows() == x2.rows());
   assert(x1.cols() == x2.cols());
 
-  FivePointsRelativePose(x1, x2, E);
+  if (x1.cols() == 5)
+    FivePointsRelativePose(Mat25(x1), Mat25(x2), E); // minimal sample: fixed-size, allocation-free path
+  else
+    FivePointsRelativePose(Mat2X(x1), Mat2X(x2), E);
 }
 
 }  // namespace kernel
@@ -77,9 +77,8 @@ void solveQuartic(const Vec5 & factors, Vec4 & realRoots)
  *                    false if world points aligned
  */
 
-bool compute_P3P_Poses(const Mat3 & featureVectors, const Mat3 & worldPoints, Mat & solutions)
+bool compute_P3P_Poses(const Mat3 & featureVectors, const Mat3 & worldPoints, P3PSolutions & solutions)
 {
-  solutions = Mat(3, 4 * 4);
 
   // Extraction of world points
 
@@ -255,21 +254,25 @@ bool compute_P3P_Poses(const Mat3 & featureVectors, const Mat3 & worldPoints, Ma
 
 void P3PSolver::Solve(const Mat &pt2D, const Mat &pt3D, std::vector<Mat34> *models)
 {
-  Mat3 R;
-  Vec3 t;
-  Mat34 P;
   assert(2 == pt2D.rows());
   assert(3 == pt3D.rows());
   assert(pt2D.cols() == pt3D.cols());
-  Mat solutions = Mat(3, 4 * 4);
+  Solve(Mat23(pt2D.leftCols<3>()), Mat3(pt3D.leftCols<3>()), models);
+}
+
+void P3PSolver::Solve(const Mat23 &pt2D, const Mat3 &pt3D, std::vector<Mat34> *models)
+{
+  Mat3 R;
+  Vec3 t;
+  Mat34 P;
+  P3PSolutions solutions;
   Mat3 pt2D_3x3;
   pt2D_3x3.block<2, 3>(0, 0) = pt2D;
   pt2D_3x3.row(2).fill(1);
   pt2D_3x3.col(0).normalize();
   pt2D_3x3.col(1).normalize();
   pt2D_3x3.col(2).normalize();
-  Mat3 pt3D_3x3 = pt3D;
-  if(compute_P3P_Poses(pt2D_3x3, pt3D_3x3, solutions))
+  if(compute_P3P_Poses(pt2D_3x3, pt3D, solutions))
   {
     for(size_t i = 0; i < 4; ++i)
     {
@@ -281,6 +284,19 @@ void P3PSolver::Solve(const Mat &pt2D, const Mat &pt3D, std::vector<Mat34> *mode
   }
 }
 
+void P3PSolver::SolveBatch(const Mat2X &pt2D, const Mat3X &pt3D, std::vector<std::vector<Mat34> > *models)
+{
+  assert(pt2D.cols() == pt3D.cols());
+  assert(pt2D.cols() % 3 == 0);
+  const Mat2X::Index nbSamples = pt2D.cols() / 3;
+  models->resize(nbSamples);
+  for(Mat2X::Index i = 0; i < nbSamples; ++i)
+  {
+    (*models)[i].clear();
+    Solve(Mat23(pt2D.block<2, 3>(0, 3 * i)), Mat3(pt3D.block<3, 3>(0, 3 * i)), &(*models)[i]);
+  }
+}
+
 // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
 
 double P3PSolver::Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D)
@@ -302,9 +318,15 @@ P3P_ResectionKernel_K::P3P_ResectionKernel_K(const Mat2X &x_camera, const Mat3X
 
 void P3P_ResectionKernel_K::Fit(const std::vector<size_t> &samples, std::vector<Model> *models) const
 {
-  const Mat3 pt2D_3x3(ExtractColumns(x_camera_, samples));
-  const Mat3 pt3D_3x3(ExtractColumns(X_, samples));
-  Mat solutions(3, 4 * 4);
+  assert(samples.size() == 3);
+  Mat3 pt2D_3x3;
+  Mat3 pt3D_3x3;
+  for(size_t i = 0; i < 3; ++i)
+  {
+    pt2D_3x3.col(i) = x_camera_.col(samples[i]);
+    pt3D_3x3.col(i) = X_.col(samples[i]);
+  }
+  P3PSolutions solutions;
   if(compute_P3P_Poses(pt2D_3x3, pt3D_3x3, solutions))
   {
     Mat34 P;
@@ -323,8 +345,7 @@ void P3P_ResectionKernel_K::Fit(const std::vector<size_t> &samples, std::vector<
 double P3P_ResectionKernel_K::Error(size_t sample, const Model &model) const
 {
   const Vec3 X = X_.col(sample);
-  const Mat2X error = Project(model, X) - x_image_.col(sample);
-  return error.col(0).norm();
+  return (Project(model, X) - x_image_.col(sample)).norm();
 }
 
 size_t P3P_ResectionKernel_K::NumSamples() const
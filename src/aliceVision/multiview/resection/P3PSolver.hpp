@@ -16,6 +16,8 @@ namespace aliceVision {
 namespace resection {
 
 typedef Eigen::Matrix<double, 5, 1> Vec5;
+/// The 4 solutions of the P3P problem: [ C1,R1, C2,R2 ... ]
+typedef Eigen::Matrix<double, 3, 16> P3PSolutions;
 
 void solveQuartic(const Vec5 & factors, Vec4 & realRoots);
 
@@ -38,7 +40,7 @@ void solveQuartic(const Vec5 & factors, Vec4 & realRoots);
  * Author: Laurent Kneip, adapted to the project by Pierre Moulon
  */
 
-bool compute_P3P_Poses(const Mat3 & featureVectors, const Mat3 & worldPoints, Mat & solutions);
+bool compute_P3P_Poses(const Mat3 & featureVectors, const Mat3 & worldPoints, P3PSolutions & solutions);
 
 struct P3PSolver
 {
@@ -55,6 +57,12 @@ struct P3PSolver
   // Solve the problem of camera pose.
   static void Solve(const Mat &pt2D, const Mat &pt3D, std::vector<Mat34> *models);
 
+  // Solve the problem of camera pose for exactly 3 points (fixed-size, allocation-free except for the output).
+  static void Solve(const Mat23 &pt2D, const Mat3 &pt3D, std::vector<Mat34> *models);
+
+  // Solve several samples at once: 3 columns per sample, models[i] are the solutions of the sample i.
+  static void SolveBatch(const Mat2X &pt2D, const Mat3X &pt3D, std::vector<std::vector<Mat34> > *models);
+
   // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
   static double Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D);
 };
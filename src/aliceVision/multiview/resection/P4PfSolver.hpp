@@ -8,6 +8,7 @@
 
 #include <aliceVision/numeric/numeric.hpp>
 
+#include <complex>
 #include <iostream>
 
 namespace aliceVision {
@@ -16,9 +17,16 @@ namespace resection {
 /**
  * @brief The structure p4fSolution contain one output model
  */
+/// 2D points of a P4Pf sample (one per column)
+typedef Eigen::Matrix<double, 2, 4> Mat24;
+/// 3D points of a P4Pf sample (one per column)
+typedef Eigen::Matrix<double, 3, 4> Mat34Points;
+/// Real solutions of the P4Pf polynomial system (at most 10 columns, stored on the stack)
+typedef Eigen::Matrix<double, 4, Eigen::Dynamic, Eigen::ColMajor, 4, 10> P4PfRealSolutions;
+
 struct p4fSolution
 {
-  p4fSolution(Mat R, Vec3 t, double f)
+  p4fSolution(const Mat3 &R, const Vec3 &t, double f)
     : _R(R)
     , _t(t)
     , _f(f)
@@ -27,30 +35,19 @@ struct p4fSolution
   Mat34 getP() const
   {
     Mat34 P;
-    Mat K = Mat(3, 3);
-
-    K << _f, 0, 0,
-         0, _f, 0,
-         0,  0, 1;
+    const Vec3 K(_f, _f, 1.0);
 
-    P.block(0, 0, 3, 3) = K*_R;
-    P.block(0, 3, 3, 1) = K*_t;
+    P.block<3, 3>(0, 0) = K.asDiagonal() * _R;
+    P.block<3, 1>(0, 3) = K.asDiagonal() * _t;
 
     return P;
   }
 
-  Mat _R;
+  Mat3 _R;
   Vec3 _t;
   double _f;
 };
 
-/**
- * @brief  Compute the absolute pose and focal length of a camera using three 3D-to-2D correspondences
- * @author Martin Bujnak, adapted to aliceVision by Michal Polic
- * @ref [1] A general solution to the p4p
- *          Bujnak, M., Kukelova, Z., and Pajdla T.
- *          CVPR 2008
- */
 struct P4PfSolver
 {
   enum
@@ -81,6 +78,24 @@ struct P4PfSolver
                     const Mat &pt3Dx,
                     std::vector<p4fSolution> *models);
 
+  /**
+   * @brief Solve the problem of camera pose for exactly 4 points.
+   *        Fixed-size computations: no heap allocation except for the output.
+   */
+  static void solve(const Mat24 &pt2Dx,
+                    const Mat34Points &pt3Dx,
+                    std::vector<p4fSolution> *models);
+
+  /**
+   * @brief Solve several samples at once.
+   * @param[in] pt2Dx 2D points, 4 columns per sample
+   * @param[in] pt3Dx corresponding 3D points, 4 columns per sample
+   * @param[out] models models[i] are the solutions of the sample i
+   */
+  static void solveBatch(const Mat2X &pt2Dx,
+                         const Mat3X &pt3Dx,
+                         std::vector<std::vector<p4fSolution> > *models);
+
   /**
    * @brief Compute the residual of the projection distance(pt2D, Project(P,pt3D)).
    * @param[in] solution
@@ -139,15 +154,15 @@ void computeP4pfPoses(const double *glab,
  * @brief isNan
  * @param[in] A matrix
  */
-bool isNan(const Eigen::MatrixXcd &A);
+bool isNan(const Eigen::Matrix<std::complex<double>, 4, 10> &A);
 
 /**
  * @brief validSol
  * @param[in] sol
  * @param[out] vSol
  */
-bool validSol(const Eigen::MatrixXcd &sol,
-              Mat &vSol);
+bool validSol(const Eigen::Matrix<std::complex<double>, 4, 10> &sol,
+              P4PfRealSolutions &vSol);
 
 /**
  * @brief Get the rigid transformation
@@ -156,9 +171,9 @@ bool validSol(const Eigen::MatrixXcd &sol,
  * @param[out] R
  * @param[out] t
  */
-void getRigidTransform(const Mat &pp1,
-                       const Mat &pp2,
-                       Mat &R,
+void getRigidTransform(const Mat34Points &pp1,
+                       const Mat34Points &pp2,
+                       Mat3 &R,
                        Vec3 &t);
 
 } // namespace resection
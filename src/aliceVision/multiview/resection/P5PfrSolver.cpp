@@ -17,24 +17,22 @@ namespace resection {
 
 /**
  * @brief Compute the nullspace, choose the algorithm based on input matrix size
+ *        The result has a bounded size: no heap allocation for fixed (or bounded) size inputs.
  * @param A matrix
  */
-Mat nullspace(const Mat &A)
+template<typename TMat>
+Eigen::Matrix<double, TMat::ColsAtCompileTime, Eigen::Dynamic, Eigen::ColMajor, TMat::MaxColsAtCompileTime, TMat::MaxColsAtCompileTime>
+nullspace(const TMat &A)
 {
-  Mat N;
   if(A.rows() < A.cols())
   {
     // LU decomposition
-    Eigen::FullPivLU<Mat> lu(A);
-    N = lu.kernel();
+    Eigen::FullPivLU<TMat> lu(A);
+    return lu.kernel();
   }
-  else
-  {
-    // SVD decomposition
-    Eigen::JacobiSVD<Mat> svd(A, Eigen::ComputeFullU | Eigen::ComputeFullV);
-    N = svd.matrixV();
-  }
-  return N;
+  // SVD decomposition
+  Eigen::JacobiSVD<TMat> svd(A, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  return svd.matrixV();
 }
 
 Mat divisionToPolynomialModelDistortion(const p5pfrModel &divisionModel,
@@ -80,33 +78,30 @@ Mat divisionToPolynomialModelDistortion(const p5pfrModel &divisionModel,
   return A.jacobiSvd(Eigen::ComputeThinU | Eigen::ComputeThinV).solve(b);
 }
 
-bool computeP5PfrPosesRD(const Mat &featureVectors,
-                            const Mat &worldPoints,
+bool computeP5PfrPosesRD(const Mat25 &featureVectors,
+                            const Mat35 &worldPoints,
                             int numOfRadialCoeff,
                             std::vector<p5pfrModel> *solutions)
 {
   // Eliminate all linear stuff
-  Mat A = Mat(5, 8);
-  for(Vec::Index i = 0; i < 5; ++i)
+  Eigen::Matrix<double, 5, 8> A;
+  for(int i = 0; i < 5; ++i)
   {
-    Mat X = Mat(1, 8);
-    X << -featureVectors(1, i) * worldPoints(0, i),
-         -featureVectors(1, i) * worldPoints(1, i),
-         -featureVectors(1, i) * worldPoints(2, i),
-         -featureVectors(1, i),
-          featureVectors(0, i) * worldPoints(0, i),
-          featureVectors(0, i) * worldPoints(1, i),
-          featureVectors(0, i) * worldPoints(2, i),
-          featureVectors(0, i);
-
-    A.block(i, 0, 1, 8) = X;
+    A.row(i) << -featureVectors(1, i) * worldPoints(0, i),
+                -featureVectors(1, i) * worldPoints(1, i),
+                -featureVectors(1, i) * worldPoints(2, i),
+                -featureVectors(1, i),
+                 featureVectors(0, i) * worldPoints(0, i),
+                 featureVectors(0, i) * worldPoints(1, i),
+                 featureVectors(0, i) * worldPoints(2, i),
+                 featureVectors(0, i);
   }
 
-  // 3D Nullspace    
-  const Mat N = nullspace(A);
+  // 3D Nullspace
+  const auto N = nullspace(A);
 
   // Construct the matrix C
-  Mat C = Mat(2, 6);
+  Eigen::Matrix<double, 2, 6> C;
   C << N.block(0, 0, 3, 1).transpose() * N.block(4, 0, 3, 1),
        N.block(0, 0, 3, 1).transpose() * N.block(4, 1, 3, 1) + N.block(0, 1, 3, 1).transpose() * N.block(4, 0, 3, 1),
        N.block(0, 0, 3, 1).transpose() * N.block(4, 2, 3, 1) + N.block(0, 2, 3, 1).transpose() * N.block(4, 0, 3, 1),
@@ -121,14 +116,11 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
        N.block(0, 2, 3, 1).transpose() * N.block(0, 2, 3, 1) - N.block(4, 2, 3, 1).transpose() * N.block(4, 2, 3, 1);
 
   // Normalize C to get reasonable numbers when computing d
-  const Vec &c1 = C.row(0);
-  const Vec &c2 = C.row(1);
-  Mat sC = Mat(2, 2);
-  sC << (6 / c1.norm()), 0, 0, (6 / c2.norm());
-  C = sC * C;
+  C.row(0) *= 6 / C.row(0).norm();
+  C.row(1) *= 6 / C.row(1).norm();
 
   // Determinant coefficients
-  Mat d = Mat(5, 1);
+  Eigen::Matrix<double, 5, 1> d;
   d << C(0, 0) * C(0, 0) * C(1, 3) * C(1, 3) - C(0, 0) * C(0, 1) * C(1, 1) * C(1, 3) - 2 * C(0, 0) * C(0, 3) * C(1, 0) * C(1, 3) + C(0, 0) * C(0, 3) * C(1, 1) * C(1, 1) + C(0, 1) * C(0, 1) * C(1, 0) * C(1, 3) - C(0, 1) * C(0, 3) * C(1, 0) * C(1, 1) + C(0, 3) * C(0, 3) * C(1, 0) * C(1, 0),
       -C(0, 0) * C(0, 1) * C(1, 3) * C(1, 4) + 2 * C(0, 0) * C(0, 2) * C(1, 3) * C(1, 3) + 2 * C(0, 0) * C(0, 3) * C(1, 1) * C(1, 4) - 2 * C(0, 0) * C(0, 3) * C(1, 2) * C(1, 3) - C(0, 0) * C(0, 4) * C(1, 1) * C(1, 3) + C(0, 1) * C(0, 1) * C(1, 2) * C(1, 3) - C(0, 1) * C(0, 2) * C(1, 1) * C(1, 3) - C(0, 1) * C(0, 3) * C(1, 0) * C(1, 4) - C(0, 1) * C(0, 3) * C(1, 1) * C(1, 2) + 2 * C(0, 1) * C(0, 4) * C(1, 0) * C(1, 3) - 2 * C(0, 2) * C(0, 3) * C(1, 0) * C(1, 3) + C(0, 2) * C(0, 3) * C(1, 1) * C(1, 1) + 2 * C(0, 3) * C(0, 3) * C(1, 0) * C(1, 2) - C(0, 3) * C(0, 4) * C(1, 0) * C(1, 1),
       -2 * C(0, 0) * C(0, 3) * C(1, 3) * C(1, 5) + C(0, 0) * C(0, 3) * C(1, 4) * C(1, 4) - C(0, 0) * C(0, 4) * C(1, 3) * C(1, 4) + 2 * C(0, 0) * C(0, 5) * C(1, 3) * C(1, 3) + C(0, 1) * C(0, 1) * C(1, 3) * C(1, 5) - C(0, 1) * C(0, 2) * C(1, 3) * C(1, 4) - C(0, 1) * C(0, 3) * C(1, 1) * C(1, 5) - C(0, 1) * C(0, 3) * C(1, 2) * C(1, 4) + 2 * C(0, 1) * C(0, 4) * C(1, 2) * C(1, 3) - C(0, 1) * C(0, 5) * C(1, 1) * C(1, 3) + C(0, 2) * C(0, 2) * C(1, 3) * C(1, 3) + 2 * C(0, 2) * C(0, 3) * C(1, 1) * C(1, 4) - 2 * C(0, 2) * C(0, 3) * C(1, 2) * C(1, 3) - C(0, 2) * C(0, 4) * C(1, 1) * C(1, 3) + 2 * C(0, 3) * C(0, 3) * C(1, 0) * C(1, 5) + C(0, 3) * C(0, 3) * C(1, 2) * C(1, 2) - C(0, 3) * C(0, 4) * C(1, 0) * C(1, 4) - C(0, 3) * C(0, 4) * C(1, 1) * C(1, 2) - 2 * C(0, 3) * C(0, 5) * C(1, 0) * C(1, 3) + C(0, 3) * C(0, 5) * C(1, 1) * C(1, 1) + C(0, 4) * C(0, 4) * C(1, 0) * C(1, 3),
@@ -137,38 +129,40 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
 
   // Companion matrix
   d = d * (1.0 / d(0, 0));
-  Mat M = Mat(4, 4);
+  Mat4 M;
   M << 0, 0, 0, -d(4, 0),
        1, 0, 0, -d(3, 0),
        0, 1, 0, -d(2, 0),
        0, 0, 1, -d(1, 0);
 
   // solve it
-  Eigen::EigenSolver<Mat> es(M);
-  Mat g1_im = es.eigenvalues().imag();
-  Mat g1_re = es.eigenvalues().real();
+  Eigen::EigenSolver<Mat4> es(M);
+  const Vec4 g1_im = es.eigenvalues().imag();
+  const Vec4 g1_re = es.eigenvalues().real();
 
   // separate real solutions
   const double eps = 2.2204e-16;
-  std::vector<double> vec_g1_real;
-  for(Mat::Index i = 0; i < 4; ++i)
+  typedef Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, 4, 1> VecUpTo4;
+  VecUpTo4 g1(4);
+  int nbRealSolutions = 0;
+  for(int i = 0; i < 4; ++i)
   {
-    if(std::abs(g1_im(i, 0)) < eps)
-      vec_g1_real.push_back(g1_re(i, 0));
+    if(std::abs(g1_im(i)) < eps)
+      g1(nbRealSolutions++) = g1_re(i);
   }
-  if(vec_g1_real.size() == 0)
+  if(nbRealSolutions == 0)
     return false;
-  Vec g1 = Map<Vec>(vec_g1_real.data(), vec_g1_real.size());
+  g1.conservativeResize(nbRealSolutions);
 
   //get g2 : Sg1 * <g2 ^ 3, g2 ^ 2, g2, 1 >= 0
   //   SG1 : = << C14 | C12*g1 + C15  | C11*g1 ^ 2 + C13*g1 + C16 | 0              >,
   //             <  0 | C14      | C12*g1 + C15        | C11*g1 ^ 2 + C13*g1 + C16  >,
   //             <C24 | C22*g1 + C25  | C21*g1 ^ 2 + C23*g1 + C26 | 0              >,
   //             <  0 | C24      | C22*g1 + C25        | C21*g1 ^ 2 + C23*g1 + C26 >> ;
-  Mat g2 = Mat(g1.rows(), g1.cols());
-  for(Mat::Index i = 0; i < g1.rows(); ++i)
+  VecUpTo4 g2(g1.rows());
+  for(int i = 0; i < g1.rows(); ++i)
   {
-    Mat M2G = Mat(4, 4);
+    Mat4 M2G;
     M2G <<  C(0, 3),
             C(0, 1) * g1(i) + C(0, 4),
             C(0, 0) * g1(i) * g1(i) + C(0, 2) * g1(i) + C(0, 5),
@@ -184,7 +178,7 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
             C(1, 1) * g1(i) + C(1, 4),
             C(1, 0) * g1(i) * g1(i) + C(1, 2) * g1(i) + C(1, 5);
 
-    Mat NM2G = nullspace(M2G);
+    const auto NM2G = nullspace(M2G);
 
     g2(i) = NM2G(2, NM2G.cols() - 1) / NM2G(3, NM2G.cols() - 1);
   }
@@ -202,8 +196,8 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
     P.row(2) << P(0, 1) * P(1, 2) - P(0, 2) * P(1, 1), -P(0, 0) * P(1, 2) + P(0, 2) * P(1, 0), P(0, 0) * P(1, 1) - P(0, 1) * P(1, 0), 0;
 
     // Form equations on k p34 and t = 1 / f: B <p34, t, k1, k2 ^ 2, k3 ^ 3, 1> = 0
-    Mat B = Mat(5, 6);
-    for(Mat::Index j = 0; j < 5; ++j)
+    Eigen::Matrix<double, 5, 6> B;
+    for(int j = 0; j < 5; ++j)
     { // for all point pairs[u, X]
       const double r2 = featureVectors(0, j) * featureVectors(0, j) + featureVectors(1, j) * featureVectors(1, j); // temporary vals
       const double ee11 = (P.block(0, 0, 1, 3) * worldPoints.col(j))(0, 0) + P(0, 3);
@@ -222,61 +216,35 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
       }
     }
 
-    // select columns
-    Mat U;
-    switch(numOfRadialCoeff)
+    // select columns: <p34, t, k1, ..., k_numOfRadialCoeff, 1>
+    if(numOfRadialCoeff < 1 || numOfRadialCoeff > 3)
     {
-    case 1:
-      U = Mat(6, 4);
-      U << 1, 0, 0, 0,
-           0, 1, 0, 0,
-           0, 0, 1, 0,
-           0, 0, 0, 0,
-           0, 0, 0, 0,
-           0, 0, 0, 1;
-      break;
-
-    case 2:
-      U = Mat(6, 5);
-      U << 1, 0, 0, 0, 0,
-           0, 1, 0, 0, 0,
-           0, 0, 1, 0, 0,
-           0, 0, 0, 1, 0,
-           0, 0, 0, 0, 0,
-           0, 0, 0, 0, 1;
-      break;
-
-    case 3:
-      U = Mat::Identity(6, 6);
-      break;
-
-      default:
-        std::cerr << "\nError: the number of radial parameters must be between 1 to 3!\n";
+      std::cerr << "\nError: the number of radial parameters must be between 1 to 3!\n";
       return false;
     }
-    B = B * U;
+    Eigen::Matrix<double, 5, Eigen::Dynamic, Eigen::ColMajor, 5, 6> BU(5, numOfRadialCoeff + 3);
+    BU.leftCols(numOfRadialCoeff + 2) = B.leftCols(numOfRadialCoeff + 2);
+    BU.rightCols<1>() = B.rightCols<1>();
 
     // find the right 1D null space
-    const Mat NBfull = nullspace(B);
-    const Mat NB = NBfull.col(NBfull.cols() - 1);
-    const Mat V = NB.col(NB.cols() - 1);
-    Mat tk = V * (1 / V(V.rows() - 1, V.cols() - 1));
+    const auto NBfull = nullspace(BU);
+    Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, 6, 1> tk = NBfull.col(NBfull.cols() - 1);
+    tk *= 1 / tk(tk.rows() - 1);
 
     // make f positive
-    if(tk(1, 0) < 0)
+    if(tk(1) < 0)
     {
-      tk.block(0, 0, 2, 1) = -tk.block(0, 0, 2, 1);
-      P.block(0, 0, 2, 4) = -P.block(0, 0, 2, 4);
+      tk.head<2>() = -tk.head<2>();
+      P.block<2, 4>(0, 0) = -P.block<2, 4>(0, 0);
     }
 
-    P(2, 3) = tk(0, 0) / tk(1, 0);
-    Mat K = Mat(3, 3);
-    K << 1.0 / tk(1, 0), 0, 0, 0, 1.0 / tk(1, 0), 0, 0, 0, 1;
-    Mat R = P.block(0, 0, 3, 3);
+    P(2, 3) = tk(0) / tk(1);
+    const double f = 1.0 / tk(1);
+    const Mat3 R = P.block<3, 3>(0, 0);
 
     //Mat C = -R.transpose() * P.block(0, 3, 3, 1);
     Vec r = Vec(numOfRadialCoeff);
-    r << tk.block(tk.rows() - numOfRadialCoeff - 1, 0, numOfRadialCoeff, 1);
+    r << tk.segment(tk.rows() - numOfRadialCoeff - 1, numOfRadialCoeff);
 
     // In[1] we have
     // [u - u0][f 0 0]
@@ -289,18 +257,17 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
 
     // instead not deal with f dependent r
     for(Mat::Index j = 0; j < numOfRadialCoeff; ++j) // f^2, f^4, f^6
-      r(j) *= pow(K(0, 0), 2 * (j + 1));
+      r(j) *= pow(f, 2 * (j + 1));
 
     // output
-    const Vec3 t = P.block(0, 3, 3, 1);
-    const double f = (1.0 / tk(1, 0));
+    const Vec3 t = P.block<3, 1>(0, 3);
     solutions->emplace_back(R, t, r, f);
   }
   return true;
 }
 
-bool computeP5PfrPosesRP(const Mat &featureVectors,
-                            const Mat &worldPoints,
+bool computeP5PfrPosesRP(const Mat25 &featureVectors,
+                            const Mat35 &worldPoints,
                             int numOfRadialCoeff,
                             std::vector<p5pfrModel> *solutions)
 {
@@ -378,6 +345,14 @@ void P5PfrSolver::solve(const Mat &pt2Dx,
   assert(5 == pt3Dx.cols());
   assert(5 == pt2Dx.cols());
 
+  solve(Mat25(pt2Dx), Mat35(pt3Dx), numR, models);
+}
+
+void P5PfrSolver::solve(const Mat25 &pt2Dx,
+                        const Mat35 &pt3Dx,
+                        const int numR,
+                        std::vector<p5pfrModel> *models)
+{
   // The radial distorision is represented by: the radial division undistortion
   if(!computeP5PfrPosesRD(pt2Dx, pt3Dx, numR, models))
     models->clear();
@@ -387,6 +362,22 @@ void P5PfrSolver::solve(const Mat &pt2Dx,
           models->clear();*/
 }
 
+void P5PfrSolver::solveBatch(const Mat2X &pt2Dx,
+                             const Mat3X &pt3Dx,
+                             const int numR,
+                             std::vector<std::vector<p5pfrModel> > *models)
+{
+  assert(pt2Dx.cols() == pt3Dx.cols());
+  assert(pt2Dx.cols() % 5 == 0);
+  const Mat2X::Index nbSamples = pt2Dx.cols() / 5;
+  models->resize(nbSamples);
+  for(Mat2X::Index i = 0; i < nbSamples; ++i)
+  {
+    (*models)[i].clear();
+    solve(Mat25(pt2Dx.block<2, 5>(0, 5 * i)), Mat35(pt3Dx.block<3, 5>(0, 5 * i)), numR, &(*models)[i]);
+  }
+}
+
 // Compute the residual of the projection distance(pt2D, Project(M,pt3D))
 
 double P5PfrSolver::error(const p5pfrModel &m,
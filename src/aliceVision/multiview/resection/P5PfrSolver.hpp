@@ -16,16 +16,21 @@ namespace resection {
 /**
  * @brief The structure p5pfrModel contain one output model
  */
+/// 2D points of a P5Pfr sample (one per column)
+typedef Eigen::Matrix<double, 2, 5> Mat25;
+/// 3D points of a P5Pfr sample (one per column)
+typedef Eigen::Matrix<double, 3, 5> Mat35;
+
 struct p5pfrModel
 {
-  p5pfrModel(Mat R, Vec3 t, Vec r, double f)
+  p5pfrModel(const Mat3 &R, const Vec3 &t, const Vec &r, double f)
     : _R(R)
     , _t(t)
     , _r(r)
     , _f(f)
   {}
 
-  Mat _R;
+  Mat3 _R;
   Vec3 _t;
   Vec _r;
   double _f;
@@ -71,6 +76,27 @@ struct P5PfrSolver
                     const int num_r,
                     std::vector<p5pfrModel> *models);
 
+  /**
+   * @brief Solve the problem of camera pose for exactly 5 points.
+   *        Fixed-size computations: no heap allocation except for the output.
+   */
+  static void solve(const Mat25 &pt2Dx,
+                    const Mat35 &pt3Dx,
+                    const int num_r,
+                    std::vector<p5pfrModel> *models);
+
+  /**
+   * @brief Solve several samples at once.
+   * @param pt2Dx 2D points, 5 columns per sample
+   * @param pt3Dx corresponding 3D points, 5 columns per sample
+   * @param num_r number of radial distortion parameters [min 1, max 3]
+   * @param models models[i] are the solutions of the sample i
+   */
+  static void solveBatch(const Mat2X &pt2Dx,
+                         const Mat3X &pt3Dx,
+                         const int num_r,
+                         std::vector<std::vector<p5pfrModel> > *models);
+
   /**
    * @brief Compute the residual of the projection distance(pt2D, Project(P,pt3D))
    * @param model solution
@@ -102,8 +128,8 @@ Mat divisionToPolynomialModelDistortion(const p5pfrModel &divisionModel,
  * @param numOfRadialCoeff
  * @param solutions
  */
-bool computeP5PfrPosesRD(const Mat &featureVectors,
-                         const Mat &worldPoints,
+bool computeP5PfrPosesRD(const Mat25 &featureVectors,
+                         const Mat35 &worldPoints,
                          int numOfRadialCoeff,
                          std::vector<p5pfrModel> *solutions);
 
@@ -114,8 +140,8 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
  * @param numOfRadialCoeff
  * @param solutions
  */
-bool computeP5PfrPosesRP(const Mat &featureVectors,
-                         const Mat &worldPoints,
+bool computeP5PfrPosesRP(const Mat25 &featureVectors,
+                         const Mat35 &worldPoints,
                          int numOfRadialCoeff,
                          std::vector<p5pfrModel> *solutions);
 
@@ -115,3 +115,30 @@ BOOST_AUTO_TEST_CASE(Resection_P4Pf_AssignmentWithNoResults)
     pass = false;
   BOOST_CHECK(pass);
 }
+
+BOOST_AUTO_TEST_CASE(Resection_P4Pf_Batch)
+{
+  // DATA: the samples of the previous tests (1, 3 and 0 solutions)
+  Mat2X pt2D(2, 12);
+  pt2D << -493.1500, 1051.9100, 176.9500, -1621.9800, 774.88000, -772.31000, -1661.63300, -1836.57300, 774.88000, -570.41000, -1881.86960, 1529.54000,
+          -878.4550, -984.7530, -381.4300, -543.3450, -534.74500, -554.09400, -585.53300, -430.03000, -534.74500, -834.63100, -167.32000, -1203.28000;
+  Mat3X pt3D(3, 12);
+  pt3D << 2.7518, 2.2375, 1.1940, 2.5778, 2.01852, 1.00709, 0.74051, 0.61962, 2.01852, 1.28149, 0.55264, 2.29633,
+          0.1336, -0.3709, 0.2048, -0.9147, 0.02133, 0.30770, 0.16656, 0.11249, 0.02133, 0.26101, 0.14578, -1.80998,
+          -0.5491, -2.0511, 1.1480, -1.6151, -1.68077, 0.81502, 1.21056, 1.22624, -1.68077, 0.70813, 1.22217, -1.76850;
+
+  // PROCESS
+  std::vector<std::vector<resection::p4fSolution> > models;
+  resection::P4PfSolver::solveBatch(pt2D, pt3D, &models);
+
+  // Same solutions as the sample by sample solver
+  BOOST_CHECK_EQUAL(models.size(), 3);
+  for(std::size_t i = 0; i < 3; ++i)
+  {
+    std::vector<resection::p4fSolution> sampleModels;
+    resection::P4PfSolver::solve(Mat(pt2D.block(0, 4 * i, 2, 4)), Mat(pt3D.block(0, 4 * i, 3, 4)), &sampleModels);
+    BOOST_CHECK_EQUAL(models.at(i).size(), sampleModels.size());
+    for(std::size_t j = 0; j < std::min(models.at(i).size(), sampleModels.size()); ++j)
+      BOOST_CHECK(isEqual(models.at(i).at(j), sampleModels.at(j)));
+  }
+}
@@ -6,6 +6,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "l1.hpp"
+#include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #ifdef ALICEVISION_ROTATION_AVERAGING_WITH_BOOST
@@ -30,6 +32,8 @@
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
 
+#include <Eigen/SparseCholesky>
+
 #include <map>
 #include <queue>
 #include <stdint.h>
@@ -44,6 +48,21 @@ namespace aliceVision   {
 namespace rotationAveraging  {
 namespace l1  {
 
+// Symmetric positive definite solver used for the normal equations At*D*A,
+// the system is kept sparse (sparse Cholesky) when A is sparse
+template<typename MATRIX_TYPE>
+struct TNormalEquations
+{
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef Eigen::LDLT<Matrix> Solver;
+};
+template<>
+struct TNormalEquations< Eigen::SparseMatrix<REAL, Eigen::ColMajor> >
+{
+  typedef Eigen::SparseMatrix<REAL, Eigen::ColMajor> Matrix;
+  typedef Eigen::SimplicialLDLT<Matrix> Solver;
+};
+
 // Minimum l1 error approximation:
 //
 // Let A be a M x N matrix with full rank. Given y of R^M, the problem
@@ -67,7 +86,8 @@ inline bool TRobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& xp,
   REAL pdtol, unsigned pdmaxiter)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef typename TNormalEquations<MATRIX_TYPE>::Matrix Matrix;
+  typedef typename TNormalEquations<MATRIX_TYPE>::Solver Solver;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned M = (unsigned)y.size();
   const unsigned N = (unsigned)xp.size();
@@ -131,7 +151,10 @@ inline bool TRobustRegressionL1PD(
     w1p = At*(tmpM4 - tmpM3 - (sig2.cwiseQuotient(sig1).cwiseProduct(w2)));
 
     // optimized solver as A is positive definite and symmetric
-    dx = H11p.ldlt().solve(w1p);
+    const Solver solver(H11p);
+    if (solver.info() != Eigen::Success)
+      return false;
+    dx = solver.solve(w1p);
 
     Adx = A*dx;
 
@@ -232,7 +255,8 @@ inline bool TIterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef typename TNormalEquations<MATRIX_TYPE>::Matrix Matrix;
+  typedef typename TNormalEquations<MATRIX_TYPE>::Solver Solver;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned m = (unsigned)b.size();
   const unsigned n = (unsigned)x.size();
@@ -255,7 +279,7 @@ inline bool TIterativelyReweightedLeastSquares(
     }
     // solve the linear system using l2 norm
     const MATRIX_TYPE AtF(A.transpose()*e.asDiagonal());
-    const Eigen::LDLT<Matrix> solver(AtF*A); // compute the Cholesky decomposition
+    const Solver solver(Matrix(AtF*A)); // compute the Cholesky decomposition
     if (solver.info() != Eigen::Success) {
       ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
       return false;
@@ -434,6 +458,7 @@ unsigned int FilterRelativeRotations(
   assert(threshold >= 0);
   // compute errors for each relative rotation
   std::vector<float> errors(RelRs.size());
+  #pragma omp parallel for
   for(int r= 0; r<RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
@@ -605,7 +630,8 @@ inline void _FillErrorMatrix(
   const Matrix3x3Arr& Rs,
   Eigen::Matrix<REAL,Eigen::Dynamic,1>& b)
 {
-  for (size_t r = 0; r < RelRs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
     const Matrix3x3& Rj = Rs[relR.j];
@@ -623,7 +649,8 @@ inline void _CorrectMatrix(
   const size_t nMainViewID,
   Matrix3x3Arr& Rs)
 {
-  for (size_t r = 0; r < Rs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < Rs.size(); ++r) {
     if (r == nMainViewID)
       continue;
     Matrix3x3& Ri = Rs[r];
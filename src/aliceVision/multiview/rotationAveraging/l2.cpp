@@ -10,8 +10,11 @@
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 
+#include <Eigen/SparseCholesky>
+
 #include <vector>
 #include <map>
+#include <queue>
 
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
@@ -45,15 +48,75 @@ Mat3 ClosestSVDRotationMatrix(const Mat3 & rotMat)
   return U*V.transpose();
 }
 
-// <eigenvalue, eigenvector> pair comparator
-bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> const &y)
+// Chain the relative rotations along a maximum spanning tree of the view graph
+// (weighted by the relative rotation weights) to get a first estimate of the
+// global rotations. Each connected component is rooted on its first camera.
+void InitRotationsMaximumSpanningTree(size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  std::vector<Mat3>& vec_rotation)
+{
+  // adjacency: <neighbor camera, relative rotation index>
+  std::vector<std::vector<std::pair<size_t, size_t> > > adjacency(nCamera);
+  for(size_t r = 0; r < vec_relativeRot.size(); ++r)
+  {
+    adjacency[vec_relativeRot[r].i].push_back(std::make_pair(vec_relativeRot[r].j, r));
+    adjacency[vec_relativeRot[r].j].push_back(std::make_pair(vec_relativeRot[r].i, r));
+  }
+
+  vec_rotation.assign(nCamera, Mat3::Identity());
+  std::vector<bool> visited(nCamera, false);
+
+  // <weight, <relative rotation index, camera to reach> >
+  typedef std::pair<double, std::pair<size_t, size_t> > Candidate;
+
+  for(size_t root = 0; root < nCamera; ++root)
+  {
+    if(visited[root])
+      continue;
+
+    std::priority_queue<Candidate> candidates;
+    const auto addCandidates = [&](size_t camera)
+    {
+      visited[camera] = true;
+      for(const auto& neighbor : adjacency[camera])
+      {
+        if(!visited[neighbor.first])
+          candidates.push(Candidate(vec_relativeRot[neighbor.second].weight, std::make_pair(neighbor.second, neighbor.first)));
+      }
+    };
+
+    addCandidates(root);
+    while(!candidates.empty())
+    {
+      const size_t r = candidates.top().second.first;
+      const size_t camera = candidates.top().second.second;
+      candidates.pop();
+
+      if(visited[camera])
+        continue;
+
+      // Rj = Rij * Ri
+      const RelativeRotation& relR = vec_relativeRot[r];
+      if(relR.j == camera)
+        vec_rotation[camera] = relR.Rij * vec_rotation[relR.i];
+      else
+        vec_rotation[camera] = relR.Rij.transpose() * vec_rotation[relR.j];
+
+      addCandidates(camera);
+    }
+  }
+}
+
+// Orthonormalize the columns of X (thin Q of its QR decomposition)
+void Orthonormalize(Mat& X)
 {
- return fabs(x.first) < fabs(y.first);
+  const Eigen::HouseholderQR<Mat> qr(X);
+  X = qr.householderQ() * Mat::Identity(X.rows(), X.cols());
 }
 
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
-//    [1] formula 6.62 page 100. Dense formulation.
+//    [1] formula 6.62 page 100. Sparse formulation.
 //- nCamera:               The number of camera to solve
 //- vec_rotationEstimate:  The relative rotation i->j
 //- vec_ApprRotMatrix:     The output global rotation
@@ -83,36 +146,26 @@ bool L2RotationAveraging( size_t nCamera,
   //--
   // Setup the Action Matrix
   //--
-  std::vector<Eigen::Triplet<double> > tripletList;
-  tripletList.reserve(nRotationEstimation*12); // 3*3 + 3
+  std::vector<Eigen::Triplet<double> > tripletList(nRotationEstimation*12); // 3*3 + 3
   //-- Encode constraint (6.62 Martinec Thesis page 100):
-  sMat::Index cpt = 0;
-  for(RelativeRotations::const_iterator
-    iter = vec_relativeRot.begin();
-    iter != vec_relativeRot.end();
-    iter++, cpt++)
+  #pragma omp parallel for
+  for(int cpt = 0; cpt < nRotationEstimation; ++cpt)
   {
-   const RelativeRotation & Elem = *iter;
-
-   //-- Encode weight * ( rj - Rij * ri ) = 0
-   const size_t i = iter->i;
-   const size_t j = iter->j;
-
-   // A.block<3,3>(3 * cpt, 3 * i) = - Rij * weight;
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * i, - iter->Rij(0,0) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * i + 1, - iter->Rij(0,1) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * i + 2, - iter->Rij(0,2) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * i, - iter->Rij(1,0) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * i + 1, - iter->Rij(1,1) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * i + 2, - iter->Rij(1,2) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * i, - iter->Rij(2,0) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * i + 1, - iter->Rij(2,1) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * i + 2, - iter->Rij(2,2) * iter->weight));
-
-   // A.block<3,3>(3 * cpt, 3 * j) = Id * weight;
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * j, 1.0 * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * j + 1, 1.0 * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * j + 2, 1.0 * iter->weight));
+    const RelativeRotation & Elem = vec_relativeRot[cpt];
+    Eigen::Triplet<double>* triplets = &tripletList[12 * cpt];
+
+    //-- Encode weight * ( rj - Rij * ri ) = 0
+    const sMat::Index i = Elem.i;
+    const sMat::Index j = Elem.j;
+
+    // A.block<3,3>(3 * cpt, 3 * i) = - Rij * weight;
+    for(int r = 0; r < 3; ++r)
+      for(int c = 0; c < 3; ++c)
+        triplets[3 * r + c] = Eigen::Triplet<double>(3 * cpt + r, 3 * i + c, - Elem.Rij(r,c) * Elem.weight);
+
+    // A.block<3,3>(3 * cpt, 3 * j) = Id * weight;
+    for(int r = 0; r < 3; ++r)
+      triplets[9 + r] = Eigen::Triplet<double>(3 * cpt + r, 3 * j + r, 1.0 * Elem.weight);
   }
 
   // nCamera * 3 because each columns have 3 elements.
@@ -120,65 +173,75 @@ bool L2RotationAveraging( size_t nCamera,
   A.setFromTriplets(tripletList.begin(), tripletList.end());
   tripletList.clear();
 
-  sMat AtAsparse = A.transpose() * A;
-  const Mat AtA = Mat(AtAsparse); // convert to dense
+  const sMat AtA = A.transpose() * A;
 
-  // You can use either SVD or eigen solver (eigen solver will be faster) to solve Ax=0
+  // The solution is the nullspace of AtA: its 3 eigen vectors of smallest eigenvalues.
+  // They are found by inverse subspace iteration on the sparse matrix,
+  // starting from the rotations chained along a maximum spanning tree.
+  Mat X(3 * nCamera, 3);
+  {
+    std::vector<Mat3> vec_initRotation;
+    InitRotationsMaximumSpanningTree(nCamera, vec_relativeRot, vec_initRotation);
+    for(size_t i = 0; i < nCamera; ++i)
+      X.block<3,3>(3 * i, 0) = vec_initRotation[i];
+  }
+  Orthonormalize(X);
 
-  // Solve Ax=0 => SVD
-  //Eigen::JacobiSVD<Mat> svd(A,Eigen::ComputeFullV);
-  //const Vec & NullspaceVector0 = svd.matrixV().col(A.cols()-1);
-  //const Vec & NullspaceVector1 = svd.matrixV().col(A.cols()-2);
-  //const Vec & NullspaceVector2 = svd.matrixV().col(A.cols()-3);
+  // AtA is singular by construction, shift it slightly to get a definite matrix
+  const double shift = 1e-8 * std::max(AtA.diagonal().mean(), 1.0);
+  sMat identity(AtA.rows(), AtA.cols());
+  identity.setIdentity();
 
-  // Solve Ax=0 => eigen vectors
-  Eigen::SelfAdjointEigenSolver<Mat> es(AtA, Eigen::ComputeEigenvectors);
+  const Eigen::SimplicialLDLT<sMat> solver(AtA + shift * identity);
+  if(solver.info() != Eigen::Success)
+    return false;
 
-  if (es.info() != Eigen::Success)
+  const int maxIterations = 100;
+  for(int iteration = 0; iteration < maxIterations; ++iteration)
   {
-    return false;
+    Mat Y(X.rows(), 3);
+    #pragma omp parallel for
+    for(int c = 0; c < 3; ++c)
+      Y.col(c) = solver.solve(Vec(X.col(c)));
+
+    Orthonormalize(Y);
+
+    // distance between the two subspaces
+    const double change = (Y - X * (X.transpose() * Y)).norm();
+    X.swap(Y);
+    if(change < 1e-12)
+      break;
   }
-  else
+
+  const auto NullspaceVector0 = X.col(0);
+  const auto NullspaceVector1 = X.col(1);
+  const auto NullspaceVector2 = X.col(2);
+
+  //--
+  // Search the closest matrix :
+  //  - From solution of SVD get back column and reconstruct Rotation matrix
+  //  - Enforce the orthogonality constraint
+  //     (approximate rotation in the Frobenius norm using SVD).
+  //--
+  vec_ApprRotMatrix.resize(nCamera);
+  #pragma omp parallel for
+  for(int i = 0; i < nCamera; ++i)
   {
-    // Sort abs(eigenvalues)
-    std::vector<std::pair<double, Vec> > eigs(AtA.cols());
-    for (size_t i = 0; i < AtA.cols(); ++i)
-    {
-      eigs[i] = std::make_pair(es.eigenvalues()[i], es.eigenvectors().col(i));
-    }
-    std::stable_sort(eigs.begin(), eigs.end(), &compare_first_abs);
-
-    const Vec & NullspaceVector0 = eigs[0].second;
-    const Vec & NullspaceVector1 = eigs[1].second;
-    const Vec & NullspaceVector2 = eigs[2].second;
-
-    //--
-    // Search the closest matrix :
-    //  - From solution of SVD get back column and reconstruct Rotation matrix
-    //  - Enforce the orthogonality constraint
-    //     (approximate rotation in the Frobenius norm using SVD).
-    //--
-    vec_ApprRotMatrix.clear();
-    vec_ApprRotMatrix.reserve(nCamera);
-    for(size_t i=0; i < nCamera; ++i)
-    {
-      Mat3 Rotation;
-      Rotation << NullspaceVector0.segment(3 * i, 3),
-                  NullspaceVector1.segment(3 * i, 3),
-                  NullspaceVector2.segment(3 * i, 3);
-
-      //-- Compute the closest SVD rotation matrix
-      Rotation = ClosestSVDRotationMatrix(Rotation);
-      vec_ApprRotMatrix.push_back(Rotation);
-    }
-    // Force R0 to be Identity
-    const Mat3 R0T = vec_ApprRotMatrix[0].transpose();
-    for(size_t i = 0; i < nCamera; ++i) {
-      vec_ApprRotMatrix[i] *= R0T;
-    }
+    Mat3 Rotation;
+    Rotation << NullspaceVector0.segment(3 * i, 3),
+                NullspaceVector1.segment(3 * i, 3),
+                NullspaceVector2.segment(3 * i, 3);
 
-    return true;
+    //-- Compute the closest SVD rotation matrix
+    vec_ApprRotMatrix[i] = ClosestSVDRotationMatrix(Rotation);
   }
+  // Force R0 to be Identity
+  const Mat3 R0T = vec_ApprRotMatrix[0].transpose();
+  for(size_t i = 0; i < nCamera; ++i) {
+    vec_ApprRotMatrix[i] *= R0T;
+  }
+
+  return true;
 }
 
 // Ceres Functor to minimize global rotation regarding fixed relative rotation
@@ -103,6 +103,36 @@ BOOST_AUTO_TEST_CASE ( rotationAveraging_RotationLeastSquare_3_Camera)
   BOOST_CHECK_SMALL(FrobeniusDistance( R20, R), 1e-2);
 }
 
+// Rotation averaging on a large sparse view graph:
+// a loop of cameras with some extra links between distant cameras
+BOOST_AUTO_TEST_CASE ( rotationAveraging_RotationLeastSquare_SparseGraph)
+{
+  const int iNviews = 500;
+
+  std::vector<Mat3> vec_globalRGT(iNviews);
+  for(int i = 0; i < iNviews; ++i)
+    vec_globalRGT[i] = RotationAroundZ(0.01 * i) * RotationAroundX(0.3 * std::sin(0.1 * i));
+
+  std::vector<RelativeRotation> vec_relativeRotEstimate;
+  for(int i = 0; i < iNviews; ++i)
+  {
+    for(int k : {1, 7})
+    {
+      const int j = (i + k) % iNviews;
+      // Rj = Rij * Ri
+      vec_relativeRotEstimate.push_back(RelativeRotation(i, j, vec_globalRGT[j] * vec_globalRGT[i].transpose()));
+    }
+  }
+
+  std::vector<Mat3> vec_globalR;
+  BOOST_CHECK(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR));
+  BOOST_CHECK_EQUAL(iNviews, vec_globalR.size());
+
+  // The solution is known up to the global frame set by the first camera
+  for(int i = 0; i < iNviews; ++i)
+    EXPECT_MATRIX_NEAR(vec_globalRGT[i] * vec_globalRGT[0].transpose(), vec_globalR[i], 1e-6);
+}
+
 BOOST_AUTO_TEST_CASE ( rotationAveraging_RefineRotationsAvgL1IRLS_SimpleTriplet)
 {
   using namespace std;
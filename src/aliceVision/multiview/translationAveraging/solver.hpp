@@ -64,5 +64,43 @@ solve_translations_problem_softl1
   const double d_l1_loss_threshold = 0.01
 );
 
+/**
+ * @brief Registration of relative translations to global translations without any LP or non-linear solver.
+ *
+ * 1. Outlier relative translations are rejected as in 1DSfM [1]: the translation directions are
+ *    projected on random 1D directions, each projection is ordered by a Minimum Feedback Arc Set
+ *    heuristic and the directions that are often inconsistent with the orderings are discarded.
+ *    The projections are processed in parallel.
+ * 2. The global translations and the scale of each relative translation group are found by
+ *    Iteratively Reweighted Least Squares (approximating a L1 norm) of:
+ *    t_j - R_ij * t_i - s_ij * t_ij = 0
+ *    on a sparse linear system, with t_0 = 0 and s_ij >= 1 (as in LUD) to avoid the trivial solution.
+ *
+ * The relative rotations are expected to be consistent (i.e. to come from averaged global rotations),
+ * they are chained to express the translation directions in a common frame for the 1DSfM filtering.
+ *
+ * @param[in] vec_initial_estimates relative motion information
+ * @param[in] b_translation_triplets tell if relative motion comes 3 or 2 views
+ *   false: 2-view estimates -> 1 relativeInfo per 2 view estimates,
+ *   true:  3-view estimates -> triplet of translations: 3 relativeInfo per triplet.
+ * @param[in] nb_poses the number of camera nodes in the relative motion graph
+ * @param[out] translations found global camera translations
+ * @param[out] vec_inliers (optional) relative motions kept by the 1DSfM filtering
+ * @param[in] d_outlier_threshold ratio of inconsistent projections above which a direction is an outlier (<= 0: no filtering)
+ * @param[in] nb_projections number of 1D projections used by the outlier filtering
+ * @return True if the registration can be solved
+ */
+bool
+solve_translations_problem_irls
+(
+  const std::vector<relativeInfo> & vec_initial_estimates,
+  const bool b_translation_triplets,
+  const int nb_poses,
+  std::vector<Eigen::Vector3d> & translations,
+  std::vector<bool> * vec_inliers = nullptr,
+  const double d_outlier_threshold = 0.1,
+  const int nb_projections = 48
+);
+
 } // namespace translationAveraging
 } // namespace aliceVision
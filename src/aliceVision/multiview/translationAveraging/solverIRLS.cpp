@@ -0,0 +1,441 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/multiview/translationAveraging/common.hpp>
+#include <aliceVision/multiview/translationAveraging/solver.hpp>
+#include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <Eigen/SparseCholesky>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace aliceVision {
+namespace translationAveraging {
+
+namespace {
+
+// Express the relative rotations in a common frame by chaining them
+// over a breadth first traversal of the relative motion graph (R_j = R_ij * R_i).
+void chainGlobalRotations(
+  const std::vector<relativeInfo> & vec_initial_estimates,
+  const int nb_poses,
+  std::vector<Mat3> & rotations)
+{
+  // adjacency: <neighbor pose, relative motion index>
+  std::vector<std::vector<std::pair<IndexT, std::size_t> > > adjacency(nb_poses);
+  for (std::size_t e = 0; e < vec_initial_estimates.size(); ++e)
+  {
+    const Pair & ids = vec_initial_estimates[e].first;
+    adjacency[ids.first].emplace_back(ids.second, e);
+    adjacency[ids.second].emplace_back(ids.first, e);
+  }
+
+  rotations.assign(nb_poses, Mat3::Identity());
+  std::vector<bool> visited(nb_poses, false);
+  for (int root = 0; root < nb_poses; ++root)
+  {
+    if (visited[root])
+      continue;
+    visited[root] = true;
+    std::queue<IndexT> queue;
+    queue.push(root);
+    while (!queue.empty())
+    {
+      const IndexT pose = queue.front();
+      queue.pop();
+      for (const auto & neighbor : adjacency[pose])
+      {
+        if (visited[neighbor.first])
+          continue;
+        visited[neighbor.first] = true;
+        const relativeInfo & rel = vec_initial_estimates[neighbor.second];
+        const Mat3 & Rij = rel.second.first;
+        rotations[neighbor.first] = (rel.first.second == neighbor.first) ?
+          Mat3(Rij * rotations[pose]) : Mat3(Rij.transpose() * rotations[pose]);
+        queue.push(neighbor.first);
+      }
+    }
+  }
+}
+
+// Order the poses along a 1D projection with the greedy Minimum Feedback Arc Set heuristic of 1DSfM
+// and accumulate the weight of the projected directions that are not consistent with this ordering.
+void accumulateMFASInconsistency(
+  const std::vector<relativeInfo> & vec_initial_estimates,
+  const std::vector<Vec3> & directions,
+  const Vec3 & axis,
+  const int nb_poses,
+  std::vector<double> & brokenWeights,
+  std::vector<double> & totalWeights)
+{
+  // projected edges oriented from the pose with the lowest to the highest coordinate
+  std::vector<std::vector<std::pair<IndexT, double> > > outEdges(nb_poses), inEdges(nb_poses);
+  std::vector<double> outWeight(nb_poses, 0.0), inWeight(nb_poses, 0.0);
+  std::vector<int> inCount(nb_poses, 0);
+  std::vector<double> projections(directions.size());
+
+  for (std::size_t e = 0; e < directions.size(); ++e)
+  {
+    projections[e] = directions[e].dot(axis);
+    IndexT from = vec_initial_estimates[e].first.first;
+    IndexT to = vec_initial_estimates[e].first.second;
+    if (projections[e] < 0.0)
+      std::swap(from, to);
+    const double weight = std::abs(projections[e]);
+    outEdges[from].emplace_back(to, weight);
+    inEdges[to].emplace_back(from, weight);
+    outWeight[from] += weight;
+    inWeight[to] += weight;
+    ++inCount[to];
+  }
+
+  // sources (no remaining incoming edge) first, then the most source-like pose
+  const auto score = [&](IndexT pose)
+  {
+    return (inCount[pose] == 0) ?
+      std::numeric_limits<double>::max() : (outWeight[pose] + 1.0) / (inWeight[pose] + 1.0);
+  };
+
+  std::vector<int> order(nb_poses, -1);
+  std::priority_queue<std::pair<double, IndexT> > candidates;
+  for (int pose = 0; pose < nb_poses; ++pose)
+    candidates.emplace(score(pose), pose);
+
+  int position = 0;
+  while (!candidates.empty())
+  {
+    const double candidateScore = candidates.top().first;
+    const IndexT pose = candidates.top().second;
+    candidates.pop();
+    // skip outdated entries
+    if (order[pose] >= 0 || candidateScore != score(pose))
+      continue;
+    order[pose] = position++;
+
+    for (const auto & edge : outEdges[pose])
+    {
+      if (order[edge.first] >= 0)
+        continue;
+      inWeight[edge.first] -= edge.second;
+      --inCount[edge.first];
+      candidates.emplace(score(edge.first), edge.first);
+    }
+    for (const auto & edge : inEdges[pose])
+    {
+      if (order[edge.first] >= 0)
+        continue;
+      outWeight[edge.first] -= edge.second;
+      candidates.emplace(score(edge.first), edge.first);
+    }
+  }
+
+  for (std::size_t e = 0; e < directions.size(); ++e)
+  {
+    const IndexT i = vec_initial_estimates[e].first.first;
+    const IndexT j = vec_initial_estimates[e].first.second;
+    const double weight = std::abs(projections[e]);
+    totalWeights[e] += weight;
+    if ((projections[e] >= 0.0) != (order[i] < order[j]))
+      brokenWeights[e] += weight;
+  }
+}
+
+} // anonymous namespace
+
+bool
+solve_translations_problem_irls
+(
+  const std::vector<relativeInfo> & vec_initial_estimates,
+  const bool b_translation_triplets,
+  const int nb_poses,
+  std::vector<Eigen::Vector3d> & translations,
+  std::vector<bool> * vec_inliers,
+  const double d_outlier_threshold,
+  const int nb_projections
+)
+{
+  const std::size_t nb_relatives = vec_initial_estimates.size();
+  const std::size_t group_size = b_translation_triplets ? 3 : 1;
+  const std::size_t nb_groups = nb_relatives / group_size;
+
+  if (nb_poses < 2 || nb_groups == 0)
+    return false;
+
+  //--
+  // 1. Outlier rejection of the translation directions (1DSfM)
+  //--
+  std::vector<bool> groupInliers(nb_groups, true);
+  if (d_outlier_threshold > 0.0 && nb_projections > 0)
+  {
+    std::vector<Mat3> rotations;
+    chainGlobalRotations(vec_initial_estimates, nb_poses, rotations);
+
+    // direction from C_i to C_j in the common frame
+    std::vector<Vec3> directions(nb_relatives);
+    #pragma omp parallel for
+    for (int e = 0; e < nb_relatives; ++e)
+    {
+      const relativeInfo & rel = vec_initial_estimates[e];
+      directions[e] = -(rotations[rel.first.second].transpose() * rel.second.second.normalized());
+    }
+
+    // the projection axes are sampled from the directions distribution, as in 1DSfM
+    std::vector<Vec3> axes(nb_projections);
+    {
+      std::mt19937 generator(std::mt19937::default_seed);
+      std::uniform_int_distribution<std::size_t> distribution(0, nb_relatives - 1);
+      std::normal_distribution<double> jitter(0.0, 0.1);
+      for (Vec3 & axis : axes)
+      {
+        axis = directions[distribution(generator)] + Vec3(jitter(generator), jitter(generator), jitter(generator));
+        axis.normalize();
+      }
+    }
+
+    std::vector<double> brokenWeights(nb_relatives, 0.0);
+    std::vector<double> totalWeights(nb_relatives, 0.0);
+    #pragma omp parallel
+    {
+      std::vector<double> threadBrokenWeights(nb_relatives, 0.0);
+      std::vector<double> threadTotalWeights(nb_relatives, 0.0);
+
+      #pragma omp for schedule(dynamic)
+      for (int p = 0; p < nb_projections; ++p)
+        accumulateMFASInconsistency(vec_initial_estimates, directions, axes[p], nb_poses, threadBrokenWeights, threadTotalWeights);
+
+      #pragma omp critical
+      {
+        for (std::size_t e = 0; e < nb_relatives; ++e)
+        {
+          brokenWeights[e] += threadBrokenWeights[e];
+          totalWeights[e] += threadTotalWeights[e];
+        }
+      }
+    }
+
+    // a group is rejected as soon as one of its directions is inconsistent
+    std::vector<double> groupInconsistency(nb_groups, 0.0);
+    for (std::size_t e = 0; e < nb_groups * group_size; ++e)
+    {
+      if (totalWeights[e] > 0.0)
+        groupInconsistency[e / group_size] = std::max(groupInconsistency[e / group_size], brokenWeights[e] / totalWeights[e]);
+    }
+    for (std::size_t g = 0; g < nb_groups; ++g)
+      groupInliers[g] = (groupInconsistency[g] <= d_outlier_threshold);
+
+    // the rejection must not split the graph: the least inconsistent rejected groups
+    // are restored until the inlier graph has the connectivity of the input graph
+    std::vector<IndexT> components(nb_poses);
+    std::iota(components.begin(), components.end(), 0);
+    const std::function<IndexT(IndexT)> findComponent = [&](IndexT pose)
+    {
+      while (components[pose] != pose)
+        pose = components[pose] = components[components[pose]];
+      return pose;
+    };
+    const auto unionGroup = [&](std::size_t g)
+    {
+      bool merged = false;
+      for (std::size_t e = g * group_size; e < (g + 1) * group_size; ++e)
+      {
+        const IndexT ci = findComponent(vec_initial_estimates[e].first.first);
+        const IndexT cj = findComponent(vec_initial_estimates[e].first.second);
+        if (ci != cj)
+        {
+          components[ci] = cj;
+          merged = true;
+        }
+      }
+      return merged;
+    };
+
+    std::vector<std::size_t> rejectedGroups;
+    for (std::size_t g = 0; g < nb_groups; ++g)
+    {
+      if (groupInliers[g])
+        unionGroup(g);
+      else
+        rejectedGroups.push_back(g);
+    }
+    std::sort(rejectedGroups.begin(), rejectedGroups.end(), [&](std::size_t a, std::size_t b)
+    {
+      return groupInconsistency[a] < groupInconsistency[b];
+    });
+    for (const std::size_t g : rejectedGroups)
+    {
+      if (unionGroup(g))
+        groupInliers[g] = true;
+    }
+  }
+
+  if (vec_inliers)
+  {
+    vec_inliers->resize(nb_relatives);
+    for (std::size_t e = 0; e < nb_relatives; ++e)
+      (*vec_inliers)[e] = groupInliers[e / group_size];
+  }
+
+  // index of the scale of each inlier group
+  std::vector<int> groupScaleIndex(nb_groups, -1);
+  std::size_t nb_scales = 0;
+  for (std::size_t g = 0; g < nb_groups; ++g)
+  {
+    if (groupInliers[g])
+      groupScaleIndex[g] = nb_scales++;
+  }
+  ALICEVISION_LOG_DEBUG("Translation averaging IRLS: " << nb_scales << "/" << nb_groups << " relative translation groups kept by the 1DSfM filtering.");
+
+  //--
+  // 2. IRLS over the sparse linear system
+  //--
+  // unknowns: t_1..t_{n-1} (t_0 is the origin), then the scales of the inlier groups
+  std::vector<std::size_t> relatives;
+  relatives.reserve(nb_relatives);
+  for (std::size_t e = 0; e < nb_groups * group_size; ++e)
+  {
+    if (groupInliers[e / group_size])
+      relatives.push_back(e);
+  }
+
+  const std::size_t nb_rows = 3 * relatives.size() + nb_scales;
+  const std::size_t nb_cols = 3 * (nb_poses - 1) + nb_scales;
+  const std::size_t scaleRow = 3 * relatives.size();
+  const std::size_t scaleCol = 3 * (nb_poses - 1);
+  const auto translationColumn = [](IndexT pose) { return 3 * (static_cast<int>(pose) - 1); };
+
+  // 9 (R_ij) + 3 (identity) + 3 (t_ij) coefficients per relative translation
+  std::vector<Eigen::Triplet<double> > tripletList(15 * relatives.size());
+  std::vector<int> tripletCount(relatives.size(), 0);
+  #pragma omp parallel for
+  for (int r = 0; r < relatives.size(); ++r)
+  {
+    const relativeInfo & rel = vec_initial_estimates[relatives[r]];
+    const IndexT i = rel.first.first;
+    const IndexT j = rel.first.second;
+    const Mat3 & Rij = rel.second.first;
+    const Vec3 & tij = rel.second.second;
+    const int groupScaleCol = scaleCol + groupScaleIndex[relatives[r] / group_size];
+    Eigen::Triplet<double> * triplets = &tripletList[15 * r];
+    int & count = tripletCount[r];
+
+    //-- Encode t_j - R_ij * t_i - s_ij * t_ij = 0
+    for (int row = 0; row < 3; ++row)
+    {
+      if (j != 0)
+        triplets[count++] = Eigen::Triplet<double>(3 * r + row, translationColumn(j) + row, 1.0);
+      if (i != 0)
+      {
+        for (int col = 0; col < 3; ++col)
+          triplets[count++] = Eigen::Triplet<double>(3 * r + row, translationColumn(i) + col, -Rij(row, col));
+      }
+      triplets[count++] = Eigen::Triplet<double>(3 * r + row, groupScaleCol, -tij(row));
+    }
+  }
+  // compact the coefficients of the relative translations involving t_0
+  std::size_t nbTriplets = 0;
+  for (std::size_t r = 0; r < relatives.size(); ++r)
+  {
+    std::copy(tripletList.begin() + 15 * r, tripletList.begin() + 15 * r + tripletCount[r], tripletList.begin() + nbTriplets);
+    nbTriplets += tripletCount[r];
+  }
+  tripletList.resize(nbTriplets);
+  // s_ij = 1, used to enforce s_ij >= 1 (it prevents the trivial solution t = 0 and fixes the scale)
+  for (std::size_t s = 0; s < nb_scales; ++s)
+    tripletList.emplace_back(scaleRow + s, scaleCol + s, 1.0);
+
+  sMat A(nb_rows, nb_cols);
+  A.setFromTriplets(tripletList.begin(), tripletList.end());
+  tripletList.clear();
+
+  Vec b = Vec::Zero(nb_rows);
+  b.tail(nb_scales).setOnes();
+
+  const sMat At = A.transpose();
+  Eigen::SimplicialLDLT<sMat> solver;
+  Vec weights = Vec::Ones(nb_rows);
+  Vec x = Vec::Zero(nb_cols);
+  Vec residuals(nb_rows);
+  double epsilon = 0.0;
+
+  const int maxIterations = 32;
+  for (int iteration = 0; iteration < maxIterations; ++iteration)
+  {
+    sMat AtWA = At * weights.asDiagonal() * A;
+    // small damping: keeps the system definite if the filtering has split the graph
+    const double damping = 1e-10 * std::max(AtWA.diagonal().mean(), 1.0);
+    for (int c = 0; c < nb_cols; ++c)
+      AtWA.coeffRef(c, c) += damping;
+
+    if (iteration == 0)
+      solver.analyzePattern(AtWA);
+    solver.factorize(AtWA);
+    if (solver.info() != Eigen::Success)
+    {
+      ALICEVISION_LOG_WARNING("Translation averaging IRLS: cannot factorize the linear system.");
+      return false;
+    }
+
+    const Vec xp = x;
+    x = solver.solve(At * weights.asDiagonal() * b);
+    if (solver.info() != Eigen::Success)
+    {
+      ALICEVISION_LOG_WARNING("Translation averaging IRLS: cannot solve the linear system.");
+      return false;
+    }
+
+    if (iteration == 0)
+    {
+      // residual floor of the L1 weights, relative to the scene scale
+      double meanLength = 0.0;
+      for (const std::size_t e : relatives)
+        meanLength += x(scaleCol + groupScaleIndex[e / group_size]) * vec_initial_estimates[e].second.second.norm();
+      epsilon = std::max(1e-3 * std::abs(meanLength) / relatives.size(), 1e-12);
+    }
+    else if ((x - xp).norm() <= 1e-8 * x.norm())
+    {
+      break;
+    }
+
+    // L1 weights of each relative translation: 1 / ||t_j - R_ij * t_i - s_ij * t_ij||
+    residuals = A * x - b;
+    #pragma omp parallel for
+    for (int r = 0; r < relatives.size(); ++r)
+    {
+      const double weight = 1.0 / std::max(residuals.segment<3>(3 * r).norm(), epsilon);
+      weights.segment<3>(3 * r).setConstant(weight);
+    }
+
+    // s_ij >= 1: the violated constraints become (heavily weighted) equalities.
+    // A constraint that holds a scale is solved slightly below 1, so it stays active,
+    // and it is released as soon as the relative translations pull the scale above 1.
+    // The smallest scale is always constrained to fix the gauge.
+    const Vec scales = x.tail(nb_scales);
+    std::size_t smallestScale = 0;
+    scales.minCoeff(&smallestScale);
+    const double scaleWeight = 100.0 * weights.head(scaleRow).maxCoeff();
+    for (std::size_t s = 0; s < nb_scales; ++s)
+      weights(scaleRow + s) = (s == smallestScale || scales(s) < 1.0) ? scaleWeight : 0.0;
+  }
+
+  // Fill the global translations array
+  translations.resize(nb_poses);
+  translations[0].setZero();
+  for (int i = 1; i < nb_poses; ++i)
+    translations[i] = x.segment<3>(translationColumn(i));
+
+  return true;
+}
+
+} // namespace translationAveraging
+} // namespace aliceVision
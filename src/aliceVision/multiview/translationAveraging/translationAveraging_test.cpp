@@ -72,6 +72,59 @@ BOOST_AUTO_TEST_CASE(translation_averaging_globalTi_from_tijs_Triplets_softL1_Ce
   }
 }
 
+BOOST_AUTO_TEST_CASE(translation_averaging_globalTi_from_tijs_Triplets_IRLS) {
+
+  const int focal = 1000;
+  const int principal_Point = 500;
+  //-- Setup a circular camera rig or "cardioid".
+  const int iNviews = 12;
+  const int iNbPoints = 6;
+
+  const bool bCardiod = true;
+  const bool bRelative_Translation_PerTriplet = true;
+  std::vector<aliceVision::translationAveraging::relativeInfo > vec_relative_estimates;
+
+  const NViewDataSet d =
+    Setup_RelativeTranslations_AndNviewDataset
+    (
+      vec_relative_estimates,
+      focal, principal_Point, iNviews, iNbPoints,
+      bCardiod, bRelative_Translation_PerTriplet
+    );
+
+  d.ExportToPLY("global_translations_from_triplets_IRLS_GT.ply");
+  visibleCamPosToSVGSurface(d._C, "global_translations_from_triplets_IRLS_GT.svg");
+
+  // Solve the translation averaging problem:
+  std::vector<Vec3> vec_translations;
+  std::vector<bool> vec_inliers;
+  BOOST_CHECK(solve_translations_problem_irls(
+    vec_relative_estimates, bRelative_Translation_PerTriplet, iNviews, vec_translations, &vec_inliers));
+
+  // No outlier in the synthetic relative translations
+  BOOST_CHECK(std::find(vec_inliers.begin(), vec_inliers.end(), false) == vec_inliers.end());
+
+  BOOST_CHECK_EQUAL(iNviews, vec_translations.size());
+
+  // Check accuracy of the found translations
+  for (unsigned i = 0; i < iNviews; ++i)
+  {
+    const Vec3 t = vec_translations[i];
+    const Mat3 & Ri = d._R[i];
+    const Vec3 C_computed = - Ri.transpose() * t;
+
+    const Vec3 C_GT = d._C[i] - d._C[0];
+
+    //-- Check that found camera position is equal to GT value
+    if (i==0)  {
+      EXPECT_MATRIX_NEAR(C_computed, C_GT, 1e-6);
+    }
+    else  {
+     BOOST_CHECK_SMALL(DistanceLInfinity(C_computed.normalized(), C_GT.normalized()), 1e-6);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(translation_averaging_globalTi_from_tijs_softl1_Ceres) {
 
   const int focal = 1000;
@@ -12,6 +12,9 @@
 #include <aliceVision/robustEstimation/LORansac.hpp>
 #include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
 
+#include <algorithm>
+#include <limits>
+
 namespace aliceVision {
 
 void TriangulateNView(const Mat2X &x,
@@ -35,6 +38,26 @@ void TriangulateNView(const Mat2X &x,
   *X = X_and_alphas.head(4);
 }
 
+namespace {
+
+template<typename TMat>
+void fillAlgebraicDesign(const Mat2X &x,
+                         const std::vector< Mat34 > &Ps,
+                         const std::vector<double> *weights,
+                         TMat &design)
+{
+  for(Mat2X::Index i = 0; i < x.cols(); ++i)
+  {
+    design.template block<2, 4>(2 * i, 0) = SkewMatMinimal(x.col(i)) * Ps[i];
+    if(weights != nullptr)
+    {
+      design.template block<2, 4>(2 * i, 0) *= (*weights)[i];
+    }
+  }
+}
+
+} // namespace
+
 void TriangulateNViewAlgebraic(const Mat2X &x,
                                const std::vector< Mat34 > &Ps,
                                Vec4 *X, 
@@ -44,15 +67,18 @@ void TriangulateNViewAlgebraic(const Mat2X &x,
   Mat2X::Index nviews = x.cols();
   assert(static_cast<std::size_t>(nviews) == Ps.size());
 
-  Mat design(2 * nviews, 4);
-  for(Mat2X::Index i = 0; i < nviews; ++i)
+  // small tracks use a design matrix of bounded size, stored on the stack
+  const Mat2X::Index maxFixedViews = 8;
+  if(nviews <= maxFixedViews)
   {
-    design.block<2, 4>(2 * i, 0) = SkewMatMinimal(x.col(i)) * Ps[i];
-    if(weights != nullptr)
-    {
-      design.block<2, 4>(2 * i, 0) *= (*weights)[i];
-    }
+    Eigen::Matrix<double, Eigen::Dynamic, 4, Eigen::ColMajor, 2 * maxFixedViews, 4> design(2 * nviews, 4);
+    fillAlgebraicDesign(x, Ps, weights, design);
+    Nullspace(&design, X);
+    return;
   }
+
+  Mat design(2 * nviews, 4);
+  fillAlgebraicDesign(x, Ps, weights, design);
   Nullspace(&design, X);
 }
 
@@ -68,6 +94,48 @@ void TriangulateNViewLORANSAC(const Mat2X &x,
   *X = robustEstimation::LO_RANSAC(kernel, scorer, inliersIndex);
 }
 
+Vec3 TriangulateIterative(const Mat34* const* Ps,
+                          const Vec2* xs,
+                          std::size_t nbViews,
+                          double* minDepth,
+                          int iter)
+{
+  assert(nbViews >= 2);
+
+  // Iterative weighted linear least squares (see Triangulation::compute),
+  // the weights are the inverse depths of the previous estimate
+  Mat3 AtA;
+  Vec3 Atb;
+  Vec3 X = Vec3::Zero();
+  double zmin = std::numeric_limits<double>::max();
+  for(int it = 0; it < iter; ++it)
+  {
+    AtA.fill(0.0);
+    Atb.fill(0.0);
+    for(std::size_t i = 0; i < nbViews; ++i)
+    {
+      const Mat34& PMat = *Ps[i];
+      const Vec2& p = xs[i];
+      const double w = (it == 0) ? 1.0 : 1.0 / (PMat.row(2).head<3>().dot(X) + PMat(2, 3));
+
+      const Vec3 v1 = w * (PMat.row(0).head<3>() - p(0) * PMat.row(2).head<3>()).transpose();
+      const Vec3 v2 = w * (PMat.row(1).head<3>() - p(1) * PMat.row(2).head<3>()).transpose();
+      Atb += w * (v1 * (p(0) * PMat(2, 3) - PMat(0, 3)) + v2 * (p(1) * PMat(2, 3) - PMat(1, 3)));
+      AtA += v1 * v1.transpose() + v2 * v2.transpose();
+    }
+
+    X = AtA.inverse() * Atb;
+  }
+
+  if(minDepth != nullptr)
+  {
+    for(std::size_t i = 0; i < nbViews; ++i)
+      zmin = std::min(zmin, Ps[i]->row(2).head<3>().dot(X) + (*Ps[i])(2, 3));
+    *minDepth = zmin;
+  }
+  return X;
+}
+
 double Triangulation::error(const Vec3 &X) const
 {
   double squared_reproj_error = 0.0;
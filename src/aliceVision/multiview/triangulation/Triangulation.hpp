@@ -66,6 +66,25 @@ void TriangulateNViewLORANSAC(const Mat2X &x,
                               std::vector<std::size_t> *inliersIndex = NULL,
                               const double & thresholdError = 4.0);                               
 
+/**
+ * @brief Compute a 3D position of a point from several images of it with the
+ * iterated weighted linear method of Triangulation::compute.
+ * It works on the 3x3 normal equations: there is no heap allocation, so it can be
+ * called for many tracks with projection matrices gathered once per view.
+ *
+ * @param[in] Ps the projection matrix of each observation
+ * @param[in] xs the undistorted 2D point of each observation
+ * @param[in] nbViews the number of observations (at least 2)
+ * @param[out] minDepth (optional) the minimal depth of the point in the views
+ * @param[in] iter the number of iterations
+ * @return the estimated 3D point
+ */
+Vec3 TriangulateIterative(const Mat34* const* Ps,
+                          const Vec2* xs,
+                          std::size_t nbViews,
+                          double* minDepth = nullptr,
+                          int iter = 3);
+
 //Iterated linear method
 
 class Triangulation
@@ -165,6 +165,39 @@ BOOST_AUTO_TEST_CASE(Triangulate_NViewIterative_FiveViews)
   }
 }
 
+BOOST_AUTO_TEST_CASE(Triangulate_Iterative_SameAsTriangulationObject)
+{
+  const int nviews = 5;
+  const int npoints = 6;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints);
+
+  // Projection matrices gathered once per view
+  std::vector<Mat34> Ps(nviews);
+  for (int j = 0; j < nviews; ++j)
+    Ps[j] = d.P(j);
+
+  for (int i = 0; i < npoints; ++i)
+  {
+    Triangulation triangulationObj;
+    std::vector<const Mat34*> PsPtr(nviews);
+    std::vector<Vec2> xs(nviews);
+    for (int j = 0; j < nviews; ++j)
+    {
+      // add some noise to compare the weighted iterations
+      xs[j] = d._x[j].col(i) + Vec2::Random() * 0.5;
+      PsPtr[j] = &Ps[j];
+      triangulationObj.add(Ps[j], xs[j]);
+    }
+
+    double minDepth = 0.0;
+    const Vec3 X = TriangulateIterative(PsPtr.data(), xs.data(), nviews, &minDepth);
+    const Vec3 expectedX = triangulationObj.compute();
+
+    BOOST_CHECK_SMALL((X - expectedX).norm(), 1e-9);
+    BOOST_CHECK_SMALL(minDepth - triangulationObj.minDepth(), 1e-9);
+  }
+}
+
 //// Test triangulation as algebric problem, it generates some random projection
 //// matrices, a random 3D points and its corresponding 2d image points. Some of these
 //// points are considered as outliers. Inliers are assigned a max weight, outliers
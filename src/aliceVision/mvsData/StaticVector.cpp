@@ -6,6 +6,9 @@
 
 #include "StaticVector.hpp"
 
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <cstdint>
 #include <cstdio>
 
 namespace aliceVision {
@@ -21,7 +24,7 @@ int getArrayLengthFromFile(std::string fileName)
 
     int n = 0;
     fread(&n, sizeof(int), 1, f);
-    if(n == -1)
+    if(n == -1 || n == -2)
     {
         fread(&n, sizeof(int), 1, f);
     }
@@ -29,4 +32,95 @@ int getArrayLengthFromFile(std::string fileName)
     return n;
 }
 
+void writeCompressedChunks(FILE* f, const unsigned char* data, std::size_t size)
+{
+    const std::uint64_t chunkSize = ARRAY_FILE_CHUNK_SIZE;
+    const int nbChunks = static_cast<int>((size + chunkSize - 1) / chunkSize);
+    fwrite(&chunkSize, sizeof(std::uint64_t), 1, f);
+    fwrite(&nbChunks, sizeof(int), 1, f);
+
+    // compress a batch of chunks in parallel and write it before the next one
+    const int batchSize = omp_get_max_threads();
+    std::vector<std::vector<Bytef>> compressedChunks(batchSize);
+    std::vector<uLong> compressedSizes(batchSize);
+
+    for(int batchFrom = 0; batchFrom < nbChunks; batchFrom += batchSize)
+    {
+        const int batchTo = std::min(nbChunks, batchFrom + batchSize);
+
+        #pragma omp parallel for
+        for(int c = batchFrom; c < batchTo; ++c)
+        {
+            const std::size_t from = c * chunkSize;
+            const uLong uncompressedSize = static_cast<uLong>(std::min<std::size_t>(chunkSize, size - from));
+            std::vector<Bytef>& compressed = compressedChunks[c - batchFrom];
+            uLong& compressedSize = compressedSizes[c - batchFrom];
+
+            compressedSize = compressBound(uncompressedSize);
+            compressed.resize(compressedSize);
+            const int err = compress2(compressed.data(), &compressedSize, data + from, uncompressedSize, Z_BEST_SPEED);
+            if(err != Z_OK)
+                compressedSize = 0;
+        }
+
+        for(int c = batchFrom; c < batchTo; ++c)
+        {
+            const std::uint64_t compressedSize = compressedSizes[c - batchFrom];
+            if(compressedSize == 0)
+                throw std::runtime_error("writeCompressedChunks: compression failed");
+            fwrite(&compressedSize, sizeof(std::uint64_t), 1, f);
+            fwrite(compressedChunks[c - batchFrom].data(), sizeof(Bytef), compressedSize, f);
+        }
+    }
+}
+
+void readCompressedChunks(FILE* f, unsigned char* data, std::size_t size)
+{
+    std::uint64_t chunkSize = 0;
+    int nbChunks = 0;
+    fread(&chunkSize, sizeof(std::uint64_t), 1, f);
+    fread(&nbChunks, sizeof(int), 1, f);
+
+    if(chunkSize == 0 || nbChunks != static_cast<int>((size + chunkSize - 1) / chunkSize))
+        throw std::runtime_error("readCompressedChunks: invalid chunks header");
+
+    // read a batch of chunks and uncompress it in parallel
+    const int batchSize = omp_get_max_threads();
+    std::vector<std::vector<Bytef>> compressedChunks(batchSize);
+    std::vector<char> isValid(batchSize);
+
+    for(int batchFrom = 0; batchFrom < nbChunks; batchFrom += batchSize)
+    {
+        const int batchTo = std::min(nbChunks, batchFrom + batchSize);
+
+        for(int c = batchFrom; c < batchTo; ++c)
+        {
+            std::uint64_t compressedSize = 0;
+            fread(&compressedSize, sizeof(std::uint64_t), 1, f);
+            std::vector<Bytef>& compressed = compressedChunks[c - batchFrom];
+            compressed.resize(compressedSize);
+            if(fread(compressed.data(), sizeof(Bytef), compressedSize, f) != compressedSize)
+                throw std::runtime_error("readCompressedChunks: unexpected end of file");
+        }
+
+        #pragma omp parallel for
+        for(int c = batchFrom; c < batchTo; ++c)
+        {
+            const std::size_t from = c * chunkSize;
+            const uLong expectedSize = static_cast<uLong>(std::min<std::size_t>(chunkSize, size - from));
+            const std::vector<Bytef>& compressed = compressedChunks[c - batchFrom];
+
+            uLong uncompressedSize = expectedSize;
+            const int err = uncompress(data + from, &uncompressedSize, compressed.data(), compressed.size());
+            isValid[c - batchFrom] = (err == Z_OK && uncompressedSize == expectedSize);
+        }
+
+        for(int c = batchFrom; c < batchTo; ++c)
+        {
+            if(!isValid[c - batchFrom])
+                throw std::runtime_error("readCompressedChunks: uncompression failed");
+        }
+    }
+}
+
 } // namespace aliceVision
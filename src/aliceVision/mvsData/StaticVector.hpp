@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <cstdio>
 #include <cstdlib>
 #include <sstream>
 #include <vector>
@@ -248,64 +249,64 @@ StaticVector<StaticVector<T>*>* loadArrayOfArraysFromFile(std::string fileName)
     return aa;
 }
 
+/// Chunk size (in bytes) of the compressed array files, the chunks are compressed independently
+static const std::size_t ARRAY_FILE_CHUNK_SIZE = 4 * 1024 * 1024;
+
+/**
+ * @brief Write a buffer as zlib compressed chunks, each batch of chunks is compressed in parallel
+ *        and written before the next one is compressed.
+ * @param[in] f The file opened for writing
+ * @param[in] data The buffer to write
+ * @param[in] size The buffer size (in bytes)
+ */
+void writeCompressedChunks(FILE* f, const unsigned char* data, std::size_t size);
+
+/**
+ * @brief Read a buffer written by writeCompressedChunks, each batch of chunks is uncompressed in parallel
+ * @param[in] f The file opened for reading
+ * @param[out] data The output buffer
+ * @param[in] size The expected buffer size (in bytes)
+ */
+void readCompressedChunks(FILE* f, unsigned char* data, std::size_t size);
+
+/**
+ * @brief Save an array to a file
+ * @note The compressed file is: -2, the num. of elements and the compressed chunks (see writeCompressedChunks).
+ *       The files with a single zlib compressed buffer (-1 header) of the previous versions can still be loaded.
+ */
 template <class T>
 void saveArrayToFile(std::string fileName, StaticVector<T>* a, bool docompress = true)
 {
     ALICEVISION_LOG_DEBUG("[IO] saveArrayToFile: " << fileName);
 
+    FILE* f = fopen(fileName.c_str(), "wb");
+    if(f == NULL)
+        throw std::runtime_error("saveArrayToFile: can't open file " + fileName);
+
+    int n = a->size();
+
     if((docompress == false) || (a->size() < 1000))
     {
-        FILE* f = fopen(fileName.c_str(), "wb");
-        int n = a->size();
         fwrite(&n, sizeof(int), 1, f);
         fwrite(&(*a)[0], sizeof(T), n, f);
-        fclose(f);
     }
     else
     {
-
-        /* ===========================================================================
-        //from zlib - compress.c
-             Compresses the source buffer into the destination buffer. The level
-           parameter has the same meaning as in deflateInit.  sourceLen is the byte
-           length of the source buffer. Upon entry, destLen is the total size of the
-           destination buffer, which must be at least 0.1% larger than sourceLen plus
-           12 bytes. Upon exit, destLen is the actual size of the compressed buffer.
-
-             compress2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
-           memory, Z_BUF_ERROR if there was not enough room in the output buffer,
-           Z_STREAM_ERROR if the level parameter is invalid.
-        */
-
-        // uLong comprLen = sizeof(T)*a->size();
-        uLong comprLen = uLong((double)(sizeof(T) * a->size()) * 1.02) + 12;
-        Byte* compr = (Byte*)calloc((uInt)comprLen, 1);
-        int err = compress(compr, &comprLen, (const Bytef*)(&(*a)[0]), sizeof(T) * a->size());
-
-        if(err != Z_OK)
+        const int compressedHeader = -2;
+        fwrite(&compressedHeader, sizeof(int), 1, f);
+        fwrite(&n, sizeof(int), 1, f);
+        try
         {
-            ALICEVISION_LOG_ERROR("compress error " << err << " : " << (sizeof(T) * a->size()) << " -> " << comprLen << ", n " << a->size());
-
-            FILE* f = fopen(fileName.c_str(), "wb");
-            int n = a->size();
-            fwrite(&n, sizeof(int), 1, f);
-            fwrite(&(*a)[0], sizeof(T), n, f);
-            fclose(f);
+            writeCompressedChunks(f, reinterpret_cast<const unsigned char*>(&(*a)[0]), sizeof(T) * a->size());
         }
-        else
+        catch(const std::exception& e)
         {
-            FILE* f = fopen(fileName.c_str(), "wb");
-            int n = -1;
-            fwrite(&n, sizeof(int), 1, f);
-            n = a->size();
-            fwrite(&n, sizeof(int), 1, f);
-            fwrite(&comprLen, sizeof(uLong), 1, f);
-            fwrite(compr, sizeof(Byte), comprLen, f);
             fclose(f);
-        };
+            throw std::runtime_error(std::string(e.what()) + ": " + fileName);
+        }
+    }
 
-        free(compr);
-    };
+    fclose(f);
 }
 
 template <class T>
@@ -324,7 +325,23 @@ StaticVector<T>* loadArrayFromFile(std::string fileName, bool printfWarning = fa
         fread(&n, sizeof(int), 1, f);
         StaticVector<T>* a = NULL;
 
-        if(n == -1)
+        if(n == -2)
+        {
+            fread(&n, sizeof(int), 1, f);
+            a = new StaticVector<T>();
+            a->resize(n);
+            try
+            {
+                readCompressedChunks(f, reinterpret_cast<unsigned char*>(&(*a)[0]), sizeof(T) * n);
+            }
+            catch(const std::exception& e)
+            {
+                delete a;
+                fclose(f);
+                throw std::runtime_error(std::string(e.what()) + ": " + fileName);
+            }
+        }
+        else if(n == -1)
         {
             fread(&n, sizeof(int), 1, f);
             a = new StaticVector<T>();
@@ -378,7 +395,27 @@ void loadArrayFromFileIntoArray(StaticVector<T>* a, std::string fileName, bool p
     int n = 0;
     fread(&n, sizeof(int), 1, f);
  
-    if(n == -1)
+    if(n == -2)
+    {
+        fread(&n, sizeof(int), 1, f);
+        if(a->size() != n)
+        {
+            std::stringstream s;
+            s << "loadArrayFromFileIntoArray: expected length " << a->size() << " loaded length " << n;
+            fclose(f);
+            throw std::runtime_error(s.str());
+        }
+        try
+        {
+            readCompressedChunks(f, reinterpret_cast<unsigned char*>(&(*a)[0]), sizeof(T) * n);
+        }
+        catch(const std::exception& e)
+        {
+            fclose(f);
+            throw std::runtime_error(std::string(e.what()) + ": " + fileName);
+        }
+    }
+    else if(n == -1)
     {
         fread(&n, sizeof(int), 1, f);
         if(a->size() != n)
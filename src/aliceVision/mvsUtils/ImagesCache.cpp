@@ -5,13 +5,17 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "ImagesCache.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace mvsUtils {
 
-int ImagesCache::getPixelId(int x, int y, int imgid)
+int ImagesCache::getPixelId(int x, int y, int imgid) const
 {
     if(!transposed)
         return x * mp->getHeight(imgid) + y;
@@ -39,10 +43,15 @@ ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<
 void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
                              bool _transposed)
 {
-    float oneimagemb = (sizeof(Color) * mp->getMaxImageWidth() * mp->getMaxImageHeight()) / 1024.f / 1024.f;
+    // memory budget, within the memory available to the process,
+    // but large enough to keep the minimal set of consistent cameras
+    const float oneimagemb = (sizeof(Color) * mp->getMaxImageWidth() * mp->getMaxImageHeight()) / 1024.f / 1024.f;
+    const float availablemb = system::ResourceBudget::get().getAvailableMemory() / 1024.f / 1024.f;
     float maxmbCPU = (float)mp->_ini.get<int>("images_cache.maxmbCPU", 5000);
-    int _npreload = std::max((int)(maxmbCPU / oneimagemb), mp->_ini.get<int>("grow.minNumOfConsistentCams", 10));
-    N_PRELOADED_IMAGES = std::min(mp->ncams, _npreload);
+    if(availablemb > 0.0f)
+        maxmbCPU = std::min(maxmbCPU, 0.5f * availablemb);
+    maxmbCPU = std::max(maxmbCPU, oneimagemb * mp->_ini.get<int>("grow.minNumOfConsistentCams", 10));
+    _maxBytes = static_cast<std::size_t>(maxmbCPU * 1024.0 * 1024.0);
 
     transposed = _transposed;
     bandType = _bandType;
@@ -52,87 +61,195 @@ void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
         imagesNames.push_back(_imagesNames[rc]);
     }
 
-    imgs = new Color*[N_PRELOADED_IMAGES];
+    _images.resize(mp->ncams);
+
+    const int nbIOThreads = std::min(mp->ncams, mp->_ini.get<int>("images_cache.nbIOThreads", 2));
+    for(int i = 0; i < nbIOThreads; ++i)
+        _ioThreads.emplace_back(&ImagesCache::ioThreadLoop, this);
 
-    camIdMapId = new StaticVector<int>();
-    camIdMapId->reserve(mp->ncams);
-    mapIdCamId = new StaticVector<int>();
-    mapIdCamId->reserve(N_PRELOADED_IMAGES);
-    mapIdClock = new StaticVector<long>();
-    mapIdClock->reserve(N_PRELOADED_IMAGES);
+    ALICEVISION_LOG_DEBUG("ImagesCache: memory budget: " << maxmbCPU << " MB, " << nbIOThreads << " I/O thread(s).");
+}
 
-    for(int i = 0; i < mp->ncams; ++i)
+ImagesCache::~ImagesCache()
+{
     {
-        camIdMapId->push_back(-1);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopIOThreads = true;
     }
+    _prefetchRequested.notify_all();
+    for(std::thread& ioThread : _ioThreads)
+        ioThread.join();
+
+    ALICEVISION_LOG_INFO("ImagesCache: " << _nbHits << " hits, " << _nbMisses << " misses, " << _nbPrefetched << " prefetched images.");
+}
 
-    for (int ni = 0; ni < N_PRELOADED_IMAGES; ++ni)
+bool ImagesCache::freeMemory(std::size_t nbBytes)
+{
+    while(_usedBytes + nbBytes > _maxBytes)
     {
-        imgs[ni] = nullptr;
+        // least recently used image not referenced outside of the cache
+        int lruCamId = -1;
+        for(int c = 0; c < _images.size(); ++c)
+        {
+            const CachedImage& cached = _images[c];
+            if(!cached.img || cached.img.use_count() > 1)
+                continue;
+            if(lruCamId == -1 || cached.lastUse < _images[lruCamId].lastUse)
+                lruCamId = c;
+        }
+        if(lruCamId == -1)
+            return false;
 
-        (*camIdMapId)[ni] = -1;
-        mapIdCamId->push_back(-1);
-        mapIdClock->push_back(clock());
+        _usedBytes -= sizeof(Color) * _images[lruCamId].img->size();
+        _images[lruCamId].img.reset();
     }
+    return true;
 }
 
-ImagesCache::~ImagesCache()
+bool ImagesCache::loadImage(int camId, std::unique_lock<std::mutex>& lock, bool isPrefetch)
+{
+    CachedImage& cached = _images[camId];
+    const std::size_t nbPixels = mp->getWidth(camId) * mp->getHeight(camId);
+    const std::size_t nbBytes = sizeof(Color) * nbPixels;
+
+    // the prefetch waits when the process is short of memory
+    if(isPrefetch && system::ResourceBudget::get().getAvailableMemory() < nbBytes)
+        return false;
+
+    // images in use can't be evicted, go over the budget rather than fail (except for prefetch)
+    if(!freeMemory(nbBytes) && isPrefetch)
+        return false;
+
+    cached.isLoading = true;
+    _usedBytes += nbBytes;
+    const std::string imagePath = imagesNames.at(camId);
+
+    lock.unlock();
+
+    long t1 = clock();
+    std::shared_ptr<Img> img;
+    try
+    {
+        img = std::make_shared<Img>(nbPixels);
+        memcpyRGBImageFromFileToArr(camId, img->data(), imagePath, mp, transposed, bandType);
+    }
+    catch(...)
+    {
+        lock.lock();
+        cached.isLoading = false;
+        _usedBytes -= nbBytes;
+        _imageLoaded.notify_all();
+        throw;
+    }
+
+    if(mp->verbose)
+    {
+        std::string basename = imagePath.substr(imagePath.find_last_of("/\\") + 1);
+        printfElapsedTime(t1, "add "+ basename +" to image cache");
+    }
+
+    lock.lock();
+    cached.img = img;
+    cached.isLoading = false;
+    cached.lastUse = ++_clock;
+    _imageLoaded.notify_all();
+    return true;
+}
+
+ImagesCache::ImgSharedPtr ImagesCache::getImg_sync(int camId)
 {
-    for(int ni = 0; ni < N_PRELOADED_IMAGES; ni++)
+    std::unique_lock<std::mutex> lock(_mutex);
+    CachedImage& cached = _images.at(camId);
+
+    if(cached.img)
+        ++_nbHits;
+    else
+        ++_nbMisses;
+
+    // the image may be evicted again while we wait for the lock
+    while(!cached.img)
     {
-        delete[] imgs[ni];
+        if(cached.isLoading)
+            _imageLoaded.wait(lock); // decoded by another thread
+        else
+            loadImage(camId, lock, false);
     }
-    delete[] imgs;
 
-    delete camIdMapId;
-    delete mapIdCamId;
-    delete mapIdClock;
+    cached.lastUse = ++_clock;
+    return cached.img;
 }
 
 void ImagesCache::refreshData(int camId)
 {
-    // printf("camId %i\n",camId);
-    // test if the image is in the memory
-    if((*camIdMapId)[camId] == -1)
+    getImg_sync(camId);
+}
+
+void ImagesCache::prefetch(const StaticVector<int>& camIds)
+{
+    if(_ioThreads.empty())
+        return;
     {
-        // remove the oldest one
-        int mapId = mapIdClock->minValId();
-        int oldCamId = (*mapIdCamId)[mapId];
-        if(oldCamId>=0)
-            (*camIdMapId)[oldCamId] = -1;
-
-        // replace with new new
-        (*camIdMapId)[camId] = mapId;
-        (*mapIdCamId)[mapId] = camId;
-        (*mapIdClock)[mapId] = clock();
-
-        // reload data from files
-        long t1 = clock();
-        if (imgs[mapId] == nullptr)
+        std::lock_guard<std::mutex> lock(_mutex);
+        _prefetchQueue.clear();
+        for(const int camId : camIds)
         {
-            const std::size_t maxSize = mp->getMaxImageWidth() * mp->getMaxImageHeight();
-            imgs[mapId] = new Color[maxSize];
+            const CachedImage& cached = _images.at(camId);
+            if(!cached.img && !cached.isLoading)
+                _prefetchQueue.push_back(camId);
         }
+    }
+    _prefetchRequested.notify_all();
+}
+
+void ImagesCache::ioThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true)
+    {
+        _prefetchRequested.wait(lock, [this]{ return _stopIOThreads || !_prefetchQueue.empty(); });
+        if(_stopIOThreads)
+            return;
+
+        const int camId = _prefetchQueue.front();
+        _prefetchQueue.pop_front();
 
-        std::string imagePath = imagesNames.at(camId);
-        memcpyRGBImageFromFileToArr(camId, imgs[mapId], imagePath, mp, transposed, bandType);
+        const CachedImage& cached = _images[camId];
+        if(cached.img || cached.isLoading)
+            continue;
 
-        if(mp->verbose)
+        try
         {
-            std::string basename = imagePath.substr(imagePath.find_last_of("/\\") + 1);
-            printfElapsedTime(t1, "add "+ basename +" to image cache");
+            if(loadImage(camId, lock, true))
+                ++_nbPrefetched;
+        }
+        catch(const std::exception& e)
+        {
+            // the error will be raised again when the image is requested
+            ALICEVISION_LOG_WARNING("Can't prefetch image '" << imagesNames.at(camId) << "': " << e.what());
         }
     }
 }
 
+long ImagesCache::getNbHits() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _nbHits;
+}
+
+long ImagesCache::getNbMisses() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _nbMisses;
+}
+
 Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
 {
-    refreshData(camId);
+    const ImgSharedPtr img = getImg_sync(camId);
+    return getPixelValueInterpolated(pix, *img, camId);
+}
 
-    // get the image index in the memory
-    const int i = (*camIdMapId)[camId];
-    const Color* img = imgs[i];
-    
+Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, const Img& img, int camId) const
+{
     const int xp = static_cast<int>(pix->x);
     const int yp = static_cast<int>(pix->y);
 
@@ -155,11 +272,12 @@ Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
 
 rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
 {
-    refreshData(camId);
+    const ImgSharedPtr img = getImg_sync(camId);
+    return getPixelValue(pix, *img, camId);
+}
 
-    // get the image index in the memory
-    const int imageId = (*camIdMapId)[camId];
-    const Color* img = imgs[imageId];
+rgb ImagesCache::getPixelValue(const Pixel& pix, const Img& img, int camId) const
+{
     const Color floatRGB = img[getPixelId(pix.x, pix.y, camId)] * 255.0f;
 
     return rgb(static_cast<unsigned char>(floatRGB.r),
@@ -12,20 +12,31 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace aliceVision {
 namespace mvsUtils {
 
+/**
+ * @brief Thread safe cache of the camera images in RAM.
+ *
+ * The images are evicted in least recently used order to stay under a memory budget
+ * (images_cache.maxmbCPU), images still referenced by a caller are never evicted.
+ * Background I/O threads (images_cache.nbIOThreads) decode the images requested with prefetch().
+ */
 class ImagesCache
 {
 public:
-    const MultiViewParams* mp;
+    typedef std::vector<Color> Img;
+    typedef std::shared_ptr<const Img> ImgSharedPtr;
 
-    int N_PRELOADED_IMAGES;
-    Color** imgs;
+    const MultiViewParams* mp;
 
-    StaticVector<int>* camIdMapId;
-    StaticVector<int>* mapIdCamId;
-    StaticVector<long>* mapIdClock;
     std::vector<std::string> imagesNames;
 
     int bandType;
@@ -37,10 +48,82 @@ public:
     void initIC(int _bandType, std::vector<std::string>& _imagesNames, bool _transposed);
     ~ImagesCache();
 
-    int getPixelId(int x, int y, int imgid);
+    int getPixelId(int x, int y, int imgid) const;
+
+    /**
+     * @brief Get the image of a camera, load it if needed (blocking).
+     * @note The image stays in memory as long as the returned pointer is alive.
+     * @param[in] camId The camera index
+     * @return the image
+     */
+    ImgSharedPtr getImg_sync(int camId);
+
+    /**
+     * @brief Make sure the image of a camera is in memory (blocking).
+     * @param[in] camId The camera index
+     */
     void refreshData(int camId);
+
+    /**
+     * @brief Ask the I/O threads to load the images of the given cameras in the background.
+     * @note Replaces the previous pending requests.
+     * @param[in] camIds The cameras needed next, in order of priority
+     */
+    void prefetch(const StaticVector<int>& camIds);
+
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
+    Color getPixelValueInterpolated(const Point2d* pix, const Img& img, int camId) const;
     rgb getPixelValue(const Pixel& pix, int camId);
+    rgb getPixelValue(const Pixel& pix, const Img& img, int camId) const;
+
+    /// Return the number of requests served from memory
+    long getNbHits() const;
+
+    /// Return the number of requests that had to wait for an image to be decoded
+    long getNbMisses() const;
+
+private:
+    struct CachedImage
+    {
+        std::shared_ptr<Img> img;
+        long lastUse = 0;
+        bool isLoading = false;
+    };
+
+    /**
+     * @brief Load the image of a camera in the cache.
+     * @note The lock is released while the image is decoded.
+     * @param[in] camId The camera index
+     * @param[in,out] lock The locked cache mutex
+     * @param[in] isPrefetch If true, give up instead of going over the memory budget
+     * @return false if the image was not loaded (prefetch only)
+     */
+    bool loadImage(int camId, std::unique_lock<std::mutex>& lock, bool isPrefetch);
+
+    /**
+     * @brief Evict the least recently used images not referenced outside of the cache
+     *        until the given size fits the memory budget.
+     * @return false if the size doesn't fit
+     */
+    bool freeMemory(std::size_t nbBytes);
+
+    void ioThreadLoop();
+
+    std::vector<CachedImage> _images;
+    std::size_t _maxBytes = 0;
+    std::size_t _usedBytes = 0;
+    long _clock = 0;
+    long _nbHits = 0;
+    long _nbMisses = 0;
+    long _nbPrefetched = 0;
+
+    std::deque<int> _prefetchQueue;
+    std::vector<std::thread> _ioThreads;
+    bool _stopIOThreads = false;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _imageLoaded;
+    std::condition_variable _prefetchRequested;
 };
 
 } // namespace mvsUtils
@@ -154,6 +154,12 @@ public:
         return _imagesParams.at(i);
     }
 
+    /// downscale of the image file of a camera, relative to the original resolution (see prepareDenseScene)
+    inline int getImageScale(int index) const
+    {
+        return _imagesScale.at(index);
+    }
+
     inline int getDownscaleFactor(int index) const
     {
         return _imagesScale.at(index) * _processDownscale;
@@ -10,18 +10,180 @@
 #include <aliceVision/mvsData/SeedPoint.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace aliceVision {
 namespace mvsUtils {
 
+namespace {
+
+// a minimum of 10 common points is required (10*2 because points are stored in both rc/tc combinations)
+const int minNbSharedSeeds = 10 * 2;
+
+std::vector<std::vector<int>> computeNeighborsFromCamPairsMatrix(const StaticVector<int>& camsmatrix, int ncams)
+{
+    std::vector<std::vector<int>> neighbors(ncams);
+
+    #pragma omp parallel for
+    for(int rc = 0; rc < ncams; ++rc)
+    {
+        const auto nbSharedSeeds = [&](int tc) { return camsmatrix[std::min(rc, tc) * ncams + std::max(rc, tc)]; };
+
+        std::vector<int>& rcNeighbors = neighbors[rc];
+        for(int tc = 0; tc < ncams; ++tc)
+        {
+            if(nbSharedSeeds(tc) > minNbSharedSeeds)
+                rcNeighbors.push_back(tc);
+        }
+        std::stable_sort(rcNeighbors.begin(), rcNeighbors.end(), [&](int a, int b) { return nbSharedSeeds(a) > nbSharedSeeds(b); });
+    }
+    return neighbors;
+}
+
+struct CamsPairSeeds
+{
+    int rc;
+    int tc;
+    int nbSeeds;
+};
+
+/**
+ * @brief Compute the neighbors of each camera from the seeds, as computeNeighborsFromCamPairsMatrix
+ *        but with the sparse camera pairs: the per camera seeds observations are sorted and counted in parallel,
+ *        then the (min, max) camera pairs of all the cameras are sort-merged.
+ */
+std::vector<std::vector<int>> computeNeighborsFromSeeds(const MultiViewParams& mp)
+{
+    const int ncams = mp.ncams;
+    std::vector<std::vector<CamsPairSeeds>> camsPairs(ncams);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int rc = 0; rc < ncams; ++rc)
+    {
+        StaticVector<SeedPoint>* seeds;
+        loadSeedsFromFile(&seeds, rc, &mp, EFileType::seeds);
+
+        std::vector<int> tcs;
+        for(int i = 0; i < seeds->size(); ++i)
+        {
+            const SeedPoint& sp = (*seeds)[i];
+            for(int c = 0; c < sp.cams.size(); ++c)
+                tcs.push_back(sp.cams[c]);
+        }
+        delete seeds;
+
+        std::sort(tcs.begin(), tcs.end());
+        std::vector<CamsPairSeeds>& rcPairs = camsPairs[rc];
+        for(std::size_t i = 0; i < tcs.size();)
+        {
+            std::size_t j = i;
+            while(j < tcs.size() && tcs[j] == tcs[i])
+                ++j;
+            rcPairs.push_back({std::min(rc, tcs[i]), std::max(rc, tcs[i]), static_cast<int>(j - i)});
+            i = j;
+        }
+    }
+
+    std::vector<CamsPairSeeds> pairs;
+    {
+        std::size_t nbPairs = 0;
+        for(const std::vector<CamsPairSeeds>& rcPairs : camsPairs)
+            nbPairs += rcPairs.size();
+        pairs.reserve(nbPairs);
+        for(std::vector<CamsPairSeeds>& rcPairs : camsPairs)
+        {
+            pairs.insert(pairs.end(), rcPairs.begin(), rcPairs.end());
+            std::vector<CamsPairSeeds>().swap(rcPairs);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const CamsPairSeeds& a, const CamsPairSeeds& b) {
+        return a.rc < b.rc || (a.rc == b.rc && a.tc < b.tc);
+    });
+
+    // merge the seeds of the 2 cameras of each pair
+    std::vector<std::vector<std::pair<int, int>>> neighborsSeeds(ncams);
+    for(std::size_t i = 0; i < pairs.size();)
+    {
+        const CamsPairSeeds& pair = pairs[i];
+        int nbSeeds = 0;
+        for(; i < pairs.size() && pairs[i].rc == pair.rc && pairs[i].tc == pair.tc; ++i)
+            nbSeeds += pairs[i].nbSeeds;
+        if(nbSeeds <= minNbSharedSeeds)
+            continue;
+        neighborsSeeds[pair.rc].emplace_back(pair.tc, nbSeeds);
+        if(pair.tc != pair.rc)
+            neighborsSeeds[pair.tc].emplace_back(pair.rc, nbSeeds);
+    }
+    std::vector<CamsPairSeeds>().swap(pairs);
+
+    std::vector<std::vector<int>> neighbors(ncams);
+
+    #pragma omp parallel for
+    for(int rc = 0; rc < ncams; ++rc)
+    {
+        // sorted by decreasing number of shared seeds, then by camera index
+        std::vector<std::pair<int, int>>& rcNeighborsSeeds = neighborsSeeds[rc];
+        std::sort(rcNeighborsSeeds.begin(), rcNeighborsSeeds.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+            return a.second > b.second || (a.second == b.second && a.first < b.first);
+        });
+        neighbors[rc].reserve(rcNeighborsSeeds.size());
+        for(const std::pair<int, int>& neighborSeeds : rcNeighborsSeeds)
+            neighbors[rc].push_back(neighborSeeds.first);
+    }
+    return neighbors;
+}
+
+// file layout: ncams, the (ncams + 1) offsets of the neighbors lists, the neighbors lists
+void saveNeighbors(const std::string& fn, const std::vector<std::vector<int>>& neighbors)
+{
+    StaticVector<int> graph;
+    std::size_t nbNeighbors = 0;
+    for(const std::vector<int>& rcNeighbors : neighbors)
+        nbNeighbors += rcNeighbors.size();
+    graph.reserve(2 + neighbors.size() + nbNeighbors);
+
+    graph.push_back(neighbors.size());
+    int offset = 0;
+    graph.push_back(offset);
+    for(const std::vector<int>& rcNeighbors : neighbors)
+    {
+        offset += rcNeighbors.size();
+        graph.push_back(offset);
+    }
+    for(const std::vector<int>& rcNeighbors : neighbors)
+    {
+        for(int tc : rcNeighbors)
+            graph.push_back(tc);
+    }
+    saveArrayToFile<int>(fn, &graph);
+}
+
+bool loadNeighbors(const std::string& fn, int ncams, std::vector<std::vector<int>>& neighbors)
+{
+    StaticVector<int>* graph = loadArrayFromFile<int>(fn);
+    const bool valid = (graph != nullptr) && (graph->size() >= ncams + 2) && ((*graph)[0] == ncams) &&
+                       ((*graph)[ncams + 1] == graph->size() - ncams - 2);
+    if(valid)
+    {
+        const int* ids = &(*graph)[ncams + 2];
+        neighbors.resize(ncams);
+        for(int rc = 0; rc < ncams; ++rc)
+            neighbors[rc].assign(ids + (*graph)[rc + 1], ids + (*graph)[rc + 2]);
+    }
+    delete graph;
+    return valid;
+}
+
+} // namespace
+
 PreMatchCams::PreMatchCams(MultiViewParams* _mp)
 {
     mp = _mp;
     minang = (float)mp->_ini.get<double>("prematching.minAngle", 2.0);
     maxang = (float)mp->_ini.get<double>("prematching.maxAngle", 70.0); // WARNING: may be too low, especially when using seeds from SFM
-    minCamsDistance = computeMinCamsDistance();
 }
 
 float PreMatchCams::computeMinCamsDistance()
@@ -74,6 +236,12 @@ bool PreMatchCams::overlap(int rc, int tc)
 
 StaticVector<int> PreMatchCams::findNearestCams(int rc, int _nnearestcams)
 {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(minCamsDistance < 0.0f)
+            minCamsDistance = computeMinCamsDistance();
+    }
+
     StaticVector<int> out;
     out.reserve(_nnearestcams);
     StaticVector<SortedId>* ids = new StaticVector<SortedId>();
@@ -118,35 +286,27 @@ StaticVector<int> PreMatchCams::findNearestCams(int rc, int _nnearestcams)
     return out;
 }
 
-StaticVector<int>* PreMatchCams::precomputeIncidentMatrixCamsFromSeeds()
+void PreMatchCams::precomputeIncidentMatrixCamsFromSeeds()
 {
-    std::string fn = mp->mvDir + "camsPairsMatrixFromSeeds.bin";
-    if(FileExists(fn))
+    const std::string neighborsFn = mp->mvDir + "camsNeighborsFromSeeds.bin";
+    if(FileExists(neighborsFn))
     {
-        ALICEVISION_LOG_INFO("Camera pairs matrix file already computed: " << fn);
-        return loadArrayFromFile<int>(fn);
+        ALICEVISION_LOG_INFO("Camera neighbors graph file already computed: " << neighborsFn);
+        return;
     }
-    ALICEVISION_LOG_INFO("Compute camera pairs matrix file: " << fn);
-    StaticVector<int>* camsmatrix = new StaticVector<int>();
-    camsmatrix->reserve(mp->ncams * mp->ncams);
-    camsmatrix->resize_with(mp->ncams * mp->ncams, 0);
-    for(int rc = 0; rc < mp->ncams; ++rc)
+    const std::string camPairsMatrixFn = mp->mvDir + "camsPairsMatrixFromSeeds.bin";
+    if(FileExists(camPairsMatrixFn))
     {
-        StaticVector<SeedPoint>* seeds;
-        loadSeedsFromFile(&seeds, rc, mp, EFileType::seeds);
-        for(int i = 0; i < seeds->size(); i++)
-        {
-            SeedPoint* sp = &(*seeds)[i];
-            for(int c = 0; c < sp->cams.size(); c++)
-            {
-                int tc = sp->cams[c];
-                (*camsmatrix)[std::min(rc, tc) * mp->ncams + std::max(rc, tc)] += 1;
-            }
-        }
-        delete seeds;
+        // computed by a previous version
+        ALICEVISION_LOG_INFO("Compute camera neighbors graph file from the camera pairs matrix: " << neighborsFn);
+        StaticVector<int>* camsmatrix = loadCamPairsMatrix();
+        saveNeighbors(neighborsFn, computeNeighborsFromCamPairsMatrix(*camsmatrix, mp->ncams));
+        delete camsmatrix;
+        return;
     }
-    saveArrayToFile<int>(fn, camsmatrix);
-    return camsmatrix;    
+
+    ALICEVISION_LOG_INFO("Compute camera neighbors graph file: " << neighborsFn);
+    saveNeighbors(neighborsFn, computeNeighborsFromSeeds(*mp));
 }
 
 StaticVector<int>* PreMatchCams::loadCamPairsMatrix()
@@ -178,34 +338,39 @@ StaticVector<int> PreMatchCams::findNearestCamsFromSeeds(int rc, int nnearestcam
     }
     else
     {
-        StaticVector<int>* camsmatrix = loadCamPairsMatrix();
-        StaticVector<SortedId> ids;
-        ids.reserve(mp->ncams);
-        for(int tc = 0; tc < mp->ncams; tc++)
-        {
-            ids.push_back(SortedId(tc, (float)(*camsmatrix)[std::min(rc, tc) * mp->ncams + std::max(rc, tc)]));
-        }
-        qsort(&ids[0], ids.size(), sizeof(SortedId), qsortCompareSortedIdDesc);
-        
-        // Ensure the ideal number of target cameras is not superior to the actual number of cameras
-        const int maxNumTC = std::min(mp->ncams, nnearestcams);
+        // neighbors with enough shared seeds, sorted by decreasing number of shared seeds
+        const std::vector<int>& rcNeighbors = getNeighborsFromSeeds()[rc];
+
+        const int maxNumTC = std::min(static_cast<int>(rcNeighbors.size()), nnearestcams);
         out.reserve(maxNumTC);
 
         for(int i = 0; i < maxNumTC; i++)
-        {
-            // a minimum of 10 common points is required (10*2 because points are stored in both rc/tc combinations)
-            if(ids[i].value > (10 * 2)) 
-                out.push_back(ids[i].id);
-        }
+            out.push_back(rcNeighbors[i]);
 
-        delete camsmatrix;
-        
         if(out.size() < nnearestcams)
             ALICEVISION_LOG_WARNING("rc: " << rc << " - found only " << out.size() << "/" << nnearestcams << " tc by seeds" );
     }
     return out;
 }
 
+const std::vector<std::vector<int>>& PreMatchCams::getNeighborsFromSeeds()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_neighborsFromSeedsLoaded)
+        return _neighborsFromSeeds;
+
+    const std::string neighborsFn = mp->mvDir + "camsNeighborsFromSeeds.bin";
+    if(!FileExists(neighborsFn) || !loadNeighbors(neighborsFn, mp->ncams, _neighborsFromSeeds))
+    {
+        // computed by a previous version or invalid: use the camera pairs matrix
+        StaticVector<int>* camsmatrix = loadCamPairsMatrix();
+        _neighborsFromSeeds = computeNeighborsFromCamPairsMatrix(*camsmatrix, mp->ncams);
+        delete camsmatrix;
+    }
+    _neighborsFromSeedsLoaded = true;
+    return _neighborsFromSeeds;
+}
+
 // hexahedron format ... 0-3 frontal face, 4-7 back face
 StaticVector<int> PreMatchCams::findCamsWhichIntersectsHexahedron(const Point3d hexah[8],
                                                                   const std::string& minMaxDepthsFileName)
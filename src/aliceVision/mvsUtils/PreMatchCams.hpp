@@ -10,6 +10,9 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
+#include <mutex>
+#include <vector>
+
 namespace aliceVision {
 namespace mvsUtils {
 
@@ -19,7 +22,8 @@ public:
     MultiViewParams* mp;
     float minang;
     float maxang;
-    float minCamsDistance;
+    /// computed at the first call of findNearestCams (quadratic in the number of cameras)
+    float minCamsDistance = -1.0f;
 
     explicit PreMatchCams(MultiViewParams* _mp);
 
@@ -30,9 +34,25 @@ public:
     StaticVector<int> findCamsWhichIntersectsHexahedron(const Point3d hexah[8], const std::string& minMaxDepthsFileName);
     StaticVector<int> findCamsWhichIntersectsHexahedron(const Point3d hexah[8]);
 
-    StaticVector<int>* precomputeIncidentMatrixCamsFromSeeds();
+    /**
+     * @brief Compute the camera neighbors graph (cameras sorted by decreasing number of shared seeds)
+     *        from the sparse camera pairs, and save it in the mvs folder
+     */
+    void precomputeIncidentMatrixCamsFromSeeds();
+    /// load the dense camera pairs matrix computed by a previous version
     StaticVector<int>* loadCamPairsMatrix();
     StaticVector<int> findNearestCamsFromSeeds(int rc, int nnearestcams);
+
+private:
+    /**
+     * @brief Get the neighbors of each camera, sorted by decreasing number of shared seeds.
+     *        Loaded once from the camera neighbors graph file, or computed from the camera pairs matrix.
+     */
+    const std::vector<std::vector<int>>& getNeighborsFromSeeds();
+
+    std::vector<std::vector<int>> _neighborsFromSeeds;
+    bool _neighborsFromSeedsLoaded = false;
+    std::mutex _mutex;
 };
 
 } // namespace mvsUtils
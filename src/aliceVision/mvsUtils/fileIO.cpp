@@ -9,6 +9,7 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/imageIO/MemoryImages.hpp>
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
@@ -18,7 +19,8 @@ namespace mvsUtils {
 
 bool FileExists(const std::string& filePath)
 {
-    return boost::filesystem::exists(filePath);
+    // the depth maps can be kept in memory between the steps of a process
+    return imageIO::MemoryImages::get().has(filePath) || boost::filesystem::exists(filePath);
 }
 
 bool FolderExists(const std::string& folderPath)
@@ -348,17 +350,17 @@ Matrix3x4 load3x4MatrixFromFile(FILE* fi)
 
 void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fileNameOrigStr, const MultiViewParams* mp, bool transpose, int bandType)
 {
-    int origWidth, origHeight;
-    std::vector<Color> cimg;
-    imageIO::readImage(fileNameOrigStr, origWidth, origHeight, cimg);
+    int origWidth, origHeight, origChannels;
+    imageIO::readImageSpec(fileNameOrigStr, origWidth, origHeight, origChannels);
 
-    // check image size
-    if((mp->getOriginalWidth(camId) != origWidth) || (mp->getOriginalHeight(camId) != origHeight))
+    // check image size, the image file can be downscaled (see prepareDenseScene)
+    const int imageScale = mp->getImageScale(camId);
+    if((mp->getOriginalWidth(camId) / imageScale != origWidth) || (mp->getOriginalHeight(camId) / imageScale != origHeight))
     {
         std::stringstream s;
         s << "Bad image dimension for camera : " << camId << "\n";
         s << "\t- image path : " << fileNameOrigStr << "\n";
-        s << "\t- expected dimension : " << mp->getOriginalWidth(camId) << "x" << mp->getOriginalHeight(camId) << "\n";
+        s << "\t- expected dimension : " << mp->getOriginalWidth(camId) / imageScale << "x" << mp->getOriginalHeight(camId) / imageScale << "\n";
         s << "\t- real dimension : " << origWidth << "x" << origHeight << "\n";
         throw std::runtime_error(s.str());
     }
@@ -368,13 +370,10 @@ void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fi
     const int width = mp->getWidth(camId);
     const int height = mp->getHeight(camId);
 
-    if(processScale > 1)
-    {
-        ALICEVISION_LOG_DEBUG("Downscale (x" << processScale << ") image: " << mp->getViewId(camId) << ".");
-        std::vector<Color> bmpr;
-        imageIO::resizeImage(origWidth, origHeight, processScale, cimg, bmpr);
-        cimg = bmpr;
-    }
+    // read the image at the process scale (reduced resolution read and images cache if available)
+    int readWidth, readHeight;
+    std::vector<Color> cimg;
+    imageIO::readImage(fileNameOrigStr, processScale, readWidth, readHeight, cimg);
 
     if(bandType == 1)
     {
@@ -419,6 +418,34 @@ void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fi
     }
 }
 
+namespace {
+
+/// image file of a camera and its downscale factor for the requested downscale of the original resolution
+std::string getCameraImagePath(const MultiViewParams* mp, int camId, int downscale, int& fileDownscale)
+{
+    const int imageScale = mp->getImageScale(camId);
+    if(downscale < imageScale || downscale % imageScale != 0)
+        throw std::runtime_error("Can't read the image of camera " + std::to_string(camId) + " at downscale " + std::to_string(downscale) +
+                                 ", the image file is at downscale " + std::to_string(imageScale) + ".");
+    fileDownscale = downscale / imageScale;
+    return mv_getFileNamePrefix(mp->mvDir, mp, camId) + "." + mp->getImageExtension();
+}
+
+} // namespace
+
+void readCameraImage(const MultiViewParams* mp, int camId, int downscale, int& width, int& height, std::vector<Color>& buffer)
+{
+    int fileDownscale;
+    const std::string path = getCameraImagePath(mp, camId, downscale, fileDownscale);
+    imageIO::readImage(path, fileDownscale, width, height, buffer);
+}
+
+void readCameraImageRegion(const MultiViewParams* mp, int camId, int downscale, int x, int y, int width, int height, std::vector<Color>& buffer)
+{
+    int fileDownscale;
+    const std::string path = getCameraImagePath(mp, camId, downscale, fileDownscale);
+    imageIO::readImageRegion(path, fileDownscale, x, y, width, height, buffer);
+}
 
 void saveSeedsToFile(StaticVector<SeedPoint>* seeds, const std::string& fileName)
 {
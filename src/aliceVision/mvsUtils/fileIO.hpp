@@ -28,6 +28,27 @@ FILE* mv_openFile(const MultiViewParams* mp, int index, EFileType mv_file_type,
 Matrix3x4 load3x4MatrixFromFile(FILE* fi);
 void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fileNameOrigStr, const MultiViewParams* mp,
                                  bool transpose, int bandType);
+
+/**
+ * @brief Read the image of a camera at a given downscale of the original resolution.
+ * @note The MIP level of the requested resolution is read directly if the image file has one (see prepareDenseScene)
+ * @param[in] mp The multi-view parameters
+ * @param[in] camId The camera index
+ * @param[in] downscale The downscale factor, relative to the original resolution (a multiple of the image file scale)
+ * @param[out] width The output image width
+ * @param[out] height The output image height
+ * @param[out] buffer The output image buffer
+ */
+void readCameraImage(const MultiViewParams* mp, int camId, int downscale, int& width, int& height, std::vector<Color>& buffer);
+
+/**
+ * @brief Read a region of the image of a camera at a given downscale of the original resolution.
+ * @note Only the tiles of the MIP level covering the region are read if the image file has this level
+ * @param[in] x The region left coordinate, at the downscaled resolution
+ * @param[in] y The region top coordinate, at the downscaled resolution
+ * @see readCameraImage
+ */
+void readCameraImageRegion(const MultiViewParams* mp, int camId, int downscale, int x, int y, int width, int height, std::vector<Color>& buffer);
 struct seed_io_block            // 80 bytes
 {
     OrientedPoint op;           // 28 bytes
@@ -10,9 +10,13 @@
 #include <aliceVision/camera/PinholeRadial.hpp> //todo: not generic
                          // only PinholeRadialK3 is currently supported
                          // todo: allows internal parameters refinement
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
 
+#include <algorithm>
+#include <vector>
+
 
 namespace aliceVision {
 namespace rig {
@@ -391,5 +395,120 @@ private :
                                   // in angle axis format the main camera
 };
 
+/**
+ * @brief Ceres cost function with analytic Jacobians of the main camera,
+ * same residual as ResidualErrorMainCameraFunctor.
+ *
+ *  Data parameter blocks are the following <2,6>
+ *  - 2 => dimension of the residuals,
+ *  - 6 => the rig pose [R;t], rotation(angle axis) and translation.
+ */
+class ResidualErrorMainCameraCostFunction : public ceres::SizedCostFunction<2, 6>
+{
+public:
+  ResidualErrorMainCameraCostFunction(const camera::PinholeRadialK3 & intrinsics,
+                                      const Vec2 & pt2d,
+                                      const Vec3 & pt3d)
+    : _point(pt3d)
+  {
+    // {focal, principal point x, principal point y, K1, K2, K3}
+    const std::vector<double> params = intrinsics.getParams();
+    std::copy(params.begin(), params.end(), _intrinsics);
+
+    _observation[0] = pt2d(0);
+    _observation[1] = pt2d(1);
+  }
+
+  bool Evaluate(double const* const* parameters, double* out_residuals, double** jacobians) const override
+  {
+    const double* const cam_Rt = parameters[0];
+
+    Mat3 R, dP_dR;
+    const Vec3 pos_proj = sfm::angleAxisRotatePoint(cam_Rt, _point, R, dP_dR) + Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    Mat23 dRes_dP;
+    sfm::projectAndDifferentiate<sfm::Distortion_RadialK3>(_intrinsics, pos_proj, _observation, out_residuals, nullptr, dRes_dP);
+
+    if(jacobians != nullptr && jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[0]);
+      J.leftCols<3>() = dRes_dP * dP_dR;
+      J.rightCols<3>() = dRes_dP;
+    }
+    return true;
+  }
+
+private:
+  double _intrinsics[6];
+  aliceVision::Vec3 _point;       // 3D point
+  double _observation[2];         // its image location
+};
+
+/**
+ * @brief Ceres cost function with analytic Jacobians of a witness camera,
+ * same residual as ResidualErrorSecondaryCameraFunctor.
+ *
+ *  Data parameter blocks are the following <2,6,6>
+ *  - 2 => dimension of the residuals,
+ *  - 6 => the rig pose [R;t], rotation(angle axis) and translation,
+ *  - 6 => the relative pose of the witness camera wrt the main camera [R;t].
+ */
+class ResidualErrorSecondaryCameraCostFunction : public ceres::SizedCostFunction<2, 6, 6>
+{
+public:
+  ResidualErrorSecondaryCameraCostFunction(const camera::PinholeRadialK3 & intrinsics,
+                                           const Vec2 & pt2d,
+                                           const Vec3 & pt3d)
+    : _point(pt3d)
+  {
+    // {focal, principal point x, principal point y, K1, K2, K3}
+    const std::vector<double> params = intrinsics.getParams();
+    std::copy(params.begin(), params.end(), _intrinsics);
+
+    _observation[0] = pt2d(0);
+    _observation[1] = pt2d(1);
+  }
+
+  bool Evaluate(double const* const* parameters, double* out_residuals, double** jacobians) const override
+  {
+    const double* const cam_Rt_main = parameters[0];
+    const double* const cam_Rt_relative = parameters[1];
+
+    // Apply the main camera pose
+    Mat3 RMain, dPMain_dRMain;
+    const Vec3 pos_main = sfm::angleAxisRotatePoint(cam_Rt_main, _point, RMain, dPMain_dRMain) + Vec3(cam_Rt_main[3], cam_Rt_main[4], cam_Rt_main[5]);
+
+    // Apply the relative pose
+    Mat3 RRelative, dP_dRRelative;
+    const Vec3 pos_proj = sfm::angleAxisRotatePoint(cam_Rt_relative, pos_main, RRelative, dP_dRRelative) + Vec3(cam_Rt_relative[3], cam_Rt_relative[4], cam_Rt_relative[5]);
+
+    Mat23 dRes_dP;
+    sfm::projectAndDifferentiate<sfm::Distortion_RadialK3>(_intrinsics, pos_proj, _observation, out_residuals, nullptr, dRes_dP);
+
+    if(jacobians == nullptr)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      const Mat23 dRes_dPMain = dRes_dP * RRelative;
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[0]);
+      J.leftCols<3>() = dRes_dPMain * dPMain_dRMain;
+      J.rightCols<3>() = dRes_dPMain;
+    }
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = dRes_dP * dP_dRRelative;
+      J.rightCols<3>() = dRes_dP;
+    }
+    return true;
+  }
+
+private:
+  double _intrinsics[6];
+  aliceVision::Vec3 _point;       // 3D point
+  double _observation[2];         // its image location
+};
+
 }
 }
\ No newline at end of file
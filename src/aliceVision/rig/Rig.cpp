@@ -8,9 +8,11 @@
 #include "ResidualError.hpp"
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <ceres/rotation.h>
 
+#include <algorithm>
 #include <fstream>
 #include <exception>
 
@@ -165,12 +167,13 @@ void Rig::findBestRelativePose(
   const std::vector<localization::LocalizationResult> & resMainCamera = _vLocalizationResults[0];
   const std::vector<localization::LocalizationResult> & resWitnessCamera = _vLocalizationResults[iLocalizer];
   
-  double minReprojError = std::numeric_limits<double>::max();
-  std::size_t iMin = 0;
-  
   assert(vPoses.size() > 0);
   
-  for(std::size_t i=0 ; i < vPoses.size() ; ++i)
+  // the candidates are evaluated independently over all the frames
+  std::vector<double> vErrors(vPoses.size(), 0.0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(vPoses.size()); ++i)
   {
     const geometry::Pose3 & relativePose = vPoses[i];
 
@@ -185,12 +188,11 @@ void Rig::findBestRelativePose(
         error += reprojectionError(resWitnessCamera[j], poseWitnessCamera);
       }
     }
-    if ( error < minReprojError )
-    {
-      iMin = i;
-      minReprojError = error;
-    }           
+    vErrors[i] = error;
   }
+
+  // the first candidate with the min. error, as the sequential evaluation
+  const std::size_t iMin = std::min_element(vErrors.begin(), vErrors.end()) - vErrors.begin();
   result = vPoses[iMin];
   
   displayRelativePoseReprojection(geometry::Pose3(aliceVision::Mat3::Identity(), aliceVision::Vec3::Zero()), 0);
@@ -328,7 +330,7 @@ bool Rig::optimizeCalibration()
 
   for(auto &elem : vMainPoses)
   {
-    auto pose = elem.second;
+    auto& pose = elem.second;
     double * parameter_block = &pose[0];
     assert(parameter_block && "parameter_block is null in vMainPoses");
     problem.AddParameterBlock(parameter_block, 6);
@@ -430,8 +432,7 @@ bool Rig::optimizeCalibration()
         if ( iLocalizer == 0 )
         {
           // Vector-2 residual, pose of the rig parameterized by 6 parameters
-          cost_function = new ceres::AutoDiffCostFunction<ResidualErrorMainCameraFunctor, 2, 6>(
-          new ResidualErrorMainCameraFunctor(currentResult[iView].getIntrinsics(), points2D.col(iPoint), points3D.col(iPoint) ));
+          cost_function = new ResidualErrorMainCameraCostFunction(currentResult[iView].getIntrinsics(), points2D.col(iPoint), points3D.col(iPoint));
             
           if (cost_function)
           {
@@ -450,8 +451,7 @@ bool Rig::optimizeCalibration()
             // Vector-2 residual, pose of the rig parameterized by 6 parameters
             //                  + relative pose of the secondary camera parameterized by 6 parameters
             
-            cost_function = new ceres::AutoDiffCostFunction<ResidualErrorSecondaryCameraFunctor, 2, 6, 6>(
-          new ResidualErrorSecondaryCameraFunctor(currentResult[iView].getIntrinsics(), points2D.col(iPoint), points3D.col(iPoint)));
+            cost_function = new ResidualErrorSecondaryCameraCostFunction(currentResult[iView].getIntrinsics(), points2D.col(iPoint), points3D.col(iPoint));
           
           if (cost_function)
           {
@@ -482,8 +482,8 @@ bool Rig::optimizeCalibration()
   options.sparse_linear_algebra_library_type = aliceVision_options._sparse_linear_algebra_library_type;
   options.minimizer_progress_to_stdout = aliceVision_options._bVerbose;
   options.logging_type = ceres::SILENT;
-  options.num_threads = 1;//aliceVision_options._nbThreads;
-  options.num_linear_solver_threads = 1;//aliceVision_options._nbThreads;
+  options.num_threads = aliceVision_options._nbThreads;
+  options.num_linear_solver_threads = aliceVision_options._nbThreads;
   
   // Solve BA
   ceres::Solver::Summary summary;
@@ -37,13 +37,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <vector>
 
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/robustEstimation/SPRT.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 namespace aliceVision {
@@ -144,6 +148,168 @@ inline ErrorIndex bestNFA(
   return bestIndex;
 }
 
+/**
+ * @brief Find the best NFA of the residuals of a model without sorting all of them.
+ *
+ * The residuals are distributed in buckets ordered by value (the keys are made of the exponent
+ * and of the 4 most significant mantissa bits of their float value, which preserves the order).
+ * A lower bound of the NFA in each bucket is computed from its smallest residual, so only the
+ * buckets that may contain an NFA below the current best one are sorted.
+ * The result is the same as sorting all the residuals and calling bestNFA().
+ */
+class BestNFASelector
+{
+public:
+  BestNFASelector(int startIndex,
+                  double logalpha0,
+                  double loge0,
+                  double maxThreshold,
+                  const std::vector<float>& logc_n,
+                  const std::vector<float>& logc_k,
+                  double multError = 1.0)
+    : _startIndex(startIndex)
+    , _logalpha0(logalpha0)
+    , _loge0(loge0)
+    , _maxThreshold(maxThreshold)
+    , _logc_n(logc_n)
+    , _logc_k(logc_k)
+    , _multError(multError)
+  {}
+
+  /**
+   * @brief Find the best NFA below a given value.
+   * @param[in] residuals The residuals of the model (square errors)
+   * @param[in] nfaToBeat Only the NFA strictly below this value are searched
+   * @return the best NFA and its index (number of inliers), infinity if no NFA is below nfaToBeat
+   * @note If an NFA was found, sortedResiduals() begins with the sorted inliers.
+   */
+  ErrorIndex operator()(const std::vector<double>& residuals, double nfaToBeat)
+  {
+    const std::size_t n = residuals.size();
+    _residuals.resize(n);
+
+    // small sets: sorting is faster than the buckets setup
+    if(n < 256)
+    {
+      for(std::size_t i = 0; i < n; ++i)
+        _residuals[i] = ErrorIndex(residuals[i], i);
+      std::sort(_residuals.begin(), _residuals.end());
+      const ErrorIndex best = bestNFA(_startIndex, _logalpha0, _residuals, _loge0, _maxThreshold, _logc_n, _logc_k, _multError);
+      return (best.first < nfaToBeat) ? best : ErrorIndex(std::numeric_limits<double>::infinity(), _startIndex);
+    }
+
+    // distribute the residuals in the buckets (counting sort on the keys)
+    _keys.resize(n);
+    std::uint32_t minKey = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t maxKey = 0;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      _keys[i] = bucketKey(residuals[i]);
+      minKey = std::min(minKey, _keys[i]);
+      maxKey = std::max(maxKey, _keys[i]);
+    }
+    const std::size_t nbBuckets = maxKey - minKey + 1;
+    _bucketBegin.assign(nbBuckets + 1, 0);
+    _bucketMin.assign(nbBuckets, std::numeric_limits<double>::infinity());
+    _bucketSorted.assign(nbBuckets, false);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      const std::size_t b = _keys[i] - minKey;
+      ++_bucketBegin[b + 1];
+      _bucketMin[b] = std::min(_bucketMin[b], residuals[i]);
+    }
+    for(std::size_t b = 0; b < nbBuckets; ++b)
+      _bucketBegin[b + 1] += _bucketBegin[b];
+    _cursor.assign(_bucketBegin.begin(), _bucketBegin.end() - 1);
+    for(std::size_t i = 0; i < n; ++i)
+      _residuals[_cursor[_keys[i] - minKey]++] = ErrorIndex(residuals[i], i);
+
+    ErrorIndex bestIndex(std::numeric_limits<double>::infinity(), _startIndex);
+    for(std::size_t b = 0; b < nbBuckets; ++b)
+    {
+      const std::size_t begin = _bucketBegin[b];
+      const std::size_t end = _bucketBegin[b + 1];
+      if(begin == end)
+        continue;
+      if(_bucketMin[b] > _maxThreshold)
+        break;
+
+      // k such as e[k - 1] is in the bucket
+      const std::size_t firstK = std::max(begin + 1, static_cast<std::size_t>(_startIndex + 1));
+      if(end < firstK)
+        continue;
+
+      // lower bound of the NFA of the bucket, the NFA increases with the error
+      const double logalphaMin = _logalpha0 + _multError * log10(_bucketMin[b] + std::numeric_limits<float>::epsilon());
+      double lowerBound = std::numeric_limits<double>::infinity();
+      for(std::size_t k = firstK; k <= end; ++k)
+        lowerBound = std::min(lowerBound, _loge0 + logalphaMin * (double) (k - _startIndex) + _logc_n[k] + _logc_k[k]);
+      if(lowerBound >= std::min(nfaToBeat, bestIndex.first))
+        continue;
+
+      std::sort(_residuals.begin() + begin, _residuals.begin() + end);
+      _bucketSorted[b] = true;
+
+      bool aboveThreshold = false;
+      for(std::size_t k = firstK; k <= end; ++k)
+      {
+        if(_residuals[k - 1].first > _maxThreshold)
+        {
+          aboveThreshold = true;
+          break;
+        }
+        const double logalpha = _logalpha0 +
+          _multError * log10(_residuals[k - 1].first + std::numeric_limits<float>::epsilon());
+        const double nfa = _loge0 + logalpha * (double) (k - _startIndex) + _logc_n[k] + _logc_k[k];
+        if(nfa < bestIndex.first && nfa < nfaToBeat)
+          bestIndex = ErrorIndex(nfa, k);
+      }
+      if(aboveThreshold)
+        break;
+    }
+
+    // sort the inliers of the skipped buckets
+    if(bestIndex.first < nfaToBeat)
+    {
+      for(std::size_t b = 0; b < nbBuckets && _bucketBegin[b] < bestIndex.second; ++b)
+      {
+        if(!_bucketSorted[b])
+          std::sort(_residuals.begin() + _bucketBegin[b], _residuals.begin() + _bucketBegin[b + 1]);
+      }
+    }
+    return bestIndex;
+  }
+
+  /// The residuals and their indices, sorted up to the last inlier of the last NFA found
+  const std::vector<ErrorIndex>& sortedResiduals() const { return _residuals; }
+
+private:
+  static std::uint32_t bucketKey(double residual)
+  {
+    const float value = static_cast<float>(residual);
+    if(!(value > 0.f))
+      return 0;
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits >> 19;
+  }
+
+  const int _startIndex;
+  const double _logalpha0;
+  const double _loge0;
+  const double _maxThreshold;
+  const std::vector<float>& _logc_n;
+  const std::vector<float>& _logc_k;
+  const double _multError;
+
+  // workspace reused by all the models
+  std::vector<ErrorIndex> _residuals;
+  std::vector<std::uint32_t> _keys;
+  std::vector<std::size_t> _bucketBegin;
+  std::vector<std::size_t> _cursor;
+  std::vector<double> _bucketMin;
+  std::vector<bool> _bucketSorted;
+};
 
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
@@ -154,6 +320,8 @@ inline ErrorIndex bestNFA(
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
  * @param[in] bVerbose display console log
+ * @param[in] useSPRT once a model is found, reject the models that are unlikely to have as many
+ *            inliers at its error threshold with a sequential probability ratio test (faster, approximate)
  *
  * @return (errorMax, minNFA)
  */
@@ -163,7 +331,8 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   size_t nIter = 1024,
   typename Kernel::Model * model = nullptr,
   double precision = std::numeric_limits<double>::infinity(),
-  bool bVerbose = false)
+  bool bVerbose = false,
+  bool useSPRT = false)
 {
   vec_inliers.clear();
 
@@ -176,7 +345,6 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
   std::vector<double> vec_residuals_(nData);
 
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
@@ -188,6 +356,13 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   std::vector<float> vec_logc_n, vec_logc_k;
   makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
 
+  std::unique_ptr<SPRT> sprt;
+  if (useSPRT)
+    sprt.reset(new SPRT(nData, 0.1, 0.01, 200.0, Kernel::MAX_MODELS));
+
+  BestNFASelector nfaSelector(sizeSample, kernel.logalpha0(), loge0, maxThreshold,
+                              vec_logc_n, vec_logc_k, kernel.multError());
+
   // Output parameters
   double minNFA = std::numeric_limits<double>::infinity();
   double errorMax = std::numeric_limits<double>::infinity();
@@ -214,6 +389,10 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     bool better = false;
     for (size_t k = 0; k < vec_models.size(); ++k)
     {
+      // Early rejection of the bad models at the error threshold of the best model so far
+      if (sprt && !vec_inliers.empty() && !sprt->isGoodModel(kernel, vec_models[k], errorMax))
+        continue;
+
       // Residuals computation and ordering
       kernel.Errors(vec_models[k], vec_residuals_);
 
@@ -230,26 +409,13 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
       }
       if (bACRansacMode)
       {
-        for (size_t i = 0; i < nData; ++i)
-        {
-          const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
-        }
-        std::sort(vec_residuals.begin(), vec_residuals.end());
-
         // Most meaningful discrimination inliers/outliers
-        const ErrorIndex best = bestNFA(
-          sizeSample,
-          kernel.logalpha0(),
-          vec_residuals,
-          loge0,
-          maxThreshold,
-          vec_logc_n,
-          vec_logc_k,
-          kernel.multError());
+        // (only the residuals that may give a better NFA than minNFA are sorted)
+        const ErrorIndex best = nfaSelector(vec_residuals_, minNFA);
 
         if (best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
         {
+          const std::vector<ErrorIndex>& vec_residuals = nfaSelector.sortedResiduals();
           // A better model was found
           better = true;
           minNFA = best.first;
@@ -258,6 +424,7 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
             vec_inliers[i] = vec_residuals[i].second;
           errorMax = vec_residuals[best.second-1].first; // Error threshold
           if(model) *model = vec_models[k];
+          if(sprt) sprt->setEpsilon(best.second / (double) nData);
 
           if(bVerbose)
           {
@@ -299,6 +466,9 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     }
   }
 
+  if(sprt && bVerbose)
+    ALICEVISION_LOG_DEBUG("SPRT: " << sprt->getNbRejected() << " models rejected early.");
+
   if(minNFA >= 0)
     vec_inliers.clear();
 
@@ -9,7 +9,9 @@
 #include "aliceVision/robustEstimation/randSampling.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
 #include "aliceVision/robustEstimation/ransacTools.hpp"
+#include "aliceVision/robustEstimation/SPRT.hpp"
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <iostream>
 #include <vector>
@@ -379,6 +381,8 @@ double localOptimization(const Kernel &kernel,
  * @param[in] bVerbose Enable/Disable log messages
  * @param[in] max_iterations Maximum number of iterations for the ransac part.
  * @param[in] outliers_probability The wanted probability of picking outliers.
+ * @param[in] useSPRT once a model is found, reject the models that are unlikely to have as many
+ *            inliers with a sequential probability ratio test (faster, approximate)
  * @return The best model found.
  */
 template<typename Kernel, typename Scorer>
@@ -388,7 +392,8 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
                                 double *best_score = NULL,
                                 bool bVerbose = false,
                                 std::size_t max_iterations = 100,
-                                double outliers_probability = 1e-2)
+                                double outliers_probability = 1e-2,
+                                bool useSPRT = false)
 {
   assert(outliers_probability < 1.0);
   assert(outliers_probability > 0.0);
@@ -416,6 +421,10 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
   std::vector<std::size_t> all_samples(total_samples);
   std::iota(all_samples.begin(), all_samples.end(), 0);
 
+  std::unique_ptr<SPRT> sprt;
+  if(useSPRT)
+    sprt.reset(new SPRT(total_samples));
+
   for(iteration = 0; iteration < max_iterations; ++iteration) 
   {
     std::vector<std::size_t> sample;
@@ -427,6 +436,10 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
     // Compute the inlier list for each fit.
     for(std::size_t i = 0; i < models.size(); ++i) 
     {
+      // Early rejection of the bad models
+      if(sprt && bestNumInliers > 0 && !sprt->isGoodModel(kernel, models[i], scorer.getThreshold()))
+        continue;
+
       std::vector<std::size_t> inliers;
       double score = scorer.Score(kernel, models[i], all_samples, &inliers);
       if(bVerbose)
@@ -463,6 +476,8 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
         
         bestNumInliers = inliers.size();
         bestInlierRatio = inliers.size() / double(total_samples);
+        if(sprt)
+          sprt->setEpsilon(bestInlierRatio);
 
         if (best_inliers) 
         {
@@ -0,0 +1,147 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation {
+
+/**
+ * @brief Wald's Sequential Probability Ratio Test for the early rejection of bad models.
+ *
+ * The data are checked in a random order against the model, the test stops as soon as
+ * the likelihood ratio between the "bad model" and the "good model" hypotheses exceeds
+ * the decision threshold A. Good models are verified on all the data.
+ *
+ * Implementation is based on the paper:
+ * [1] "Randomized RANSAC with Sequential Probability Ratio Test"
+ * Authors: Jiri Matas, Ondrej Chum.
+ * Date: 2005.
+ * Conference: ICCV.
+ *
+ * @note The probabilities are updated during the estimation: epsilon with the inlier ratio
+ *       of the best model so far, delta with the inlier ratio of the rejected models.
+ */
+class SPRT
+{
+public:
+  /**
+   * @param[in] nbData The number of data
+   * @param[in] epsilon The initial probability that a datum is an inlier of a good model
+   * @param[in] delta The initial probability that a datum is an inlier of a bad model
+   * @param[in] timeModel The time to compute a model, in units of the time to verify a datum
+   * @param[in] nbModelsPerSample The average number of models computed from a sample
+   */
+  explicit SPRT(std::size_t nbData,
+                double epsilon = 0.1,
+                double delta = 0.01,
+                double timeModel = 200.0,
+                double nbModelsPerSample = 1.0)
+    : _epsilon(epsilon)
+    , _delta(delta)
+    , _timeModel(timeModel)
+    , _nbModelsPerSample(nbModelsPerSample)
+    , _order(nbData)
+  {
+    std::iota(_order.begin(), _order.end(), 0);
+    std::mt19937 generator(std::mt19937::default_seed);
+    std::shuffle(_order.begin(), _order.end(), generator);
+    updateDecisionThreshold();
+  }
+
+  /**
+   * @brief Verify a model on the data in a random order.
+   * @param[in] kernel The kernel providing Error(sample, model)
+   * @param[in] model The model to verify
+   * @param[in] threshold The errors below this threshold are inliers
+   * @return false if the model has been rejected
+   */
+  template <typename Kernel>
+  bool isGoodModel(const Kernel& kernel, const typename Kernel::Model& model, double threshold)
+  {
+    const double inlierRatio = _delta / _epsilon;
+    const double outlierRatio = (1.0 - _delta) / (1.0 - _epsilon);
+
+    double lambda = 1.0;
+    std::size_t nbInliers = 0;
+    for(std::size_t j = 0; j < _order.size(); ++j)
+    {
+      if(kernel.Error(_order[j], model) < threshold)
+      {
+        ++nbInliers;
+        lambda *= inlierRatio;
+      }
+      else
+      {
+        lambda *= outlierRatio;
+      }
+
+      if(lambda > _decisionThreshold)
+      {
+        // rejected: update the estimation of delta with the tested data
+        ++_nbRejected;
+        const double delta = nbInliers / static_cast<double>(j + 1);
+        _delta = std::min(0.99 * _epsilon, std::max(1e-4, _delta + (delta - _delta) / _nbRejected));
+        updateDecisionThreshold();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Update the probability that a datum is an inlier of a good model.
+   * @param[in] inlierRatio The inlier ratio of the best model so far
+   */
+  void setEpsilon(double inlierRatio)
+  {
+    _epsilon = std::min(0.99, std::max(inlierRatio, 1.01 * _delta));
+    updateDecisionThreshold();
+  }
+
+  /// Return the number of rejected models
+  std::size_t getNbRejected() const { return _nbRejected; }
+
+private:
+  /**
+   * @brief Compute the decision threshold A from the current probabilities (equation 2 of [1]).
+   */
+  void updateDecisionThreshold()
+  {
+    const double C = (1.0 - _delta) * std::log((1.0 - _delta) / (1.0 - _epsilon))
+                   + _delta * std::log(_delta / _epsilon);
+    const double K = _timeModel * C / _nbModelsPerSample + 1.0;
+
+    // fixed point iteration A = K + log(A)
+    double A = K;
+    for(int i = 0; i < 10; ++i)
+    {
+      const double nextA = K + std::log(A);
+      if(std::abs(nextA - A) < 1e-5)
+        break;
+      A = nextA;
+    }
+    _decisionThreshold = A;
+  }
+
+  double _epsilon;
+  double _delta;
+  const double _timeModel;
+  const double _nbModelsPerSample;
+  double _decisionThreshold = 1.0;
+  std::size_t _nbRejected = 0;
+  /// random verification order of the data
+  std::vector<std::size_t> _order;
+};
+
+} // namespace robustEstimation
+} // namespace aliceVision
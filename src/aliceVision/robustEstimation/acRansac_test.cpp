@@ -248,6 +248,41 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_RealisticCase)
   BOOST_CHECK_SMALL(GTModel(1)-line[1], 1e-9);
 }
 
+BOOST_AUTO_TEST_CASE(RansacLineFitter_RealisticCase_SPRT)
+{
+  const int NbPoints = 1000;
+  const float outlierRatio = .5;
+  Mat2X xy(2, NbPoints);
+
+  Vec2 GTModel; // y = 6.3 x + (-2.0)
+  GTModel << -2.0, 6.3;
+
+  for(Mat::Index i = 0; i < NbPoints; ++i)
+  {
+    xy.col(i) << i, (double) i * GTModel[1] + GTModel[0];
+  }
+
+  std::mt19937 gen;
+  std::normal_distribution<> d(0, 5);
+
+  const int nbPtToNoise = (int) NbPoints * outlierRatio;
+  for(int i = 0; i < nbPtToNoise; ++i)
+  {
+    xy.col(i) << d(gen), d(gen);
+  }
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(xy, 12, 12);
+
+  // The early rejection of the bad models must not change the result
+  std::vector<std::size_t> vec_inliers;
+  Vec2 line;
+  ACRANSAC(lineKernel, vec_inliers, 300, &line, std::numeric_limits<double>::infinity(), false, true);
+
+  BOOST_CHECK_EQUAL(NbPoints - nbPtToNoise, vec_inliers.size());
+  BOOST_CHECK_SMALL(GTModel(0)-line[0], 1e-9);
+  BOOST_CHECK_SMALL(GTModel(1)-line[1], 1e-9);
+}
+
 // Generate nbPoints along a line and add gaussian noise.
 // Move some point in the dataset to create outlier contamined data
 
@@ -362,3 +397,54 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+BOOST_AUTO_TEST_CASE(ACRansac_BestNFASelector_SameAsSort)
+{
+  std::mt19937 gen(std::mt19937::default_seed);
+  const std::size_t sizeSample = 2;
+
+  for(const std::size_t nData : {100, 3000})
+  {
+    const double loge0 = log10((double)(nData - sizeSample));
+    std::vector<float> vec_logc_n, vec_logc_k;
+    makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
+
+    for(const double maxThreshold : {std::numeric_limits<double>::infinity(), 0.01})
+    {
+      BestNFASelector selector(sizeSample, -2.0, loge0, maxThreshold, vec_logc_n, vec_logc_k);
+      double minNFA = std::numeric_limits<double>::infinity();
+
+      for(int model = 0; model < 20; ++model)
+      {
+        // inliers with a small error and uniform outliers
+        const std::size_t nbInliers = nData * (model + 1) / 25;
+        std::uniform_real_distribution<double> inlierError(0.0, 1e-4 * (model % 5 + 1));
+        std::uniform_real_distribution<double> outlierError(0.0, 1.0);
+        std::vector<double> residuals(nData);
+        for(std::size_t i = 0; i < nData; ++i)
+          residuals[i] = (i < nbInliers) ? inlierError(gen) : outlierError(gen);
+        std::shuffle(residuals.begin(), residuals.end(), gen);
+
+        std::vector<ErrorIndex> sorted(nData);
+        for(std::size_t i = 0; i < nData; ++i)
+          sorted[i] = ErrorIndex(residuals[i], i);
+        std::sort(sorted.begin(), sorted.end());
+        const ErrorIndex expected = bestNFA(sizeSample, -2.0, sorted, loge0, maxThreshold, vec_logc_n, vec_logc_k);
+
+        const ErrorIndex best = selector(residuals, minNFA);
+        if(expected.first < minNFA)
+        {
+          BOOST_CHECK_EQUAL(expected.first, best.first);
+          BOOST_CHECK_EQUAL(expected.second, best.second);
+          for(std::size_t i = 0; i < best.second; ++i)
+            BOOST_CHECK(sorted[i] == selector.sortedResiduals()[i]);
+          minNFA = best.first;
+        }
+        else
+        {
+          BOOST_CHECK(!(best.first < minNFA));
+        }
+      }
+    }
+  }
+}
@@ -14,11 +14,33 @@
 #include "aliceVision/feature/Regions.hpp"
 #include "aliceVision/camera/IntrinsicBase.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace aliceVision {
 namespace robustEstimation {
 
+/**
+ * @brief Get the positions of the regions, un-distorted in a single batch if a valid camera is given
+ * @param[in] cam optional camera (can be NULL)
+ * @param[in] regions the regions
+ * @return the (un-distorted) positions, one per column
+ */
+inline Mat2X getUndistortedRegionsPositions(const camera::IntrinsicBase* cam, const feature::Regions& regions)
+{
+  Mat2X positions(2, regions.RegionCount());
+  for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+    positions.col(i) = regions.GetRegionPosition(i);
+
+  if(!cam || !cam->isValid())
+    return positions;
+
+  Mat2X udPositions;
+  cam->get_ud_pixels(positions, udPositions);
+  return udPositions;
+}
+
 /**
  * @brief Guided Matching (features only):
  *   Use a model to find valid correspondences:
@@ -199,29 +221,8 @@ void GuidedMatching(
   //   2. a distance ratio between descriptors of valid geometric correspondencess
 
   // Build region positions arrays (in order to un-distord on-demand point position once)
-  std::vector<Vec2> lRegionsPos(lRegions.RegionCount());
-  std::vector<Vec2> rRegionsPos(rRegions.RegionCount());
-
-  if(camL && camL->isValid())
-  {
-    for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
-      lRegionsPos[i] = camL->get_ud_pixel(lRegions.GetRegionPosition(i));
-  }
-  else
-  {
-    for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
-      lRegionsPos[i] = lRegions.GetRegionPosition(i);
-  }
-  if(camR && camR->isValid())
-  {
-    for(std::size_t i = 0; i < rRegions.RegionCount(); ++i)
-      rRegionsPos[i] = camR->get_ud_pixel(rRegions.GetRegionPosition(i));
-  }
-  else
-  {
-    for(std::size_t i = 0; i < rRegions.RegionCount(); ++i)
-      rRegionsPos[i] = rRegions.GetRegionPosition(i);
-  }
+  const Mat2X lRegionsPos = getUndistortedRegionsPositions(camL, lRegions);
+  const Mat2X rRegionsPos = getUndistortedRegionsPositions(camR, rRegions);
 
   for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
   {
@@ -231,8 +232,8 @@ void GuidedMatching(
       // Compute the geometric error: error to the model
       const double geomErr = ErrorArg::Error(mod, // The model
                                              // The corresponding points
-                                             lRegionsPos[i],
-                                             rRegionsPos[j]);
+                                             lRegionsPos.col(i),
+                                             rRegionsPos.col(j));
       if(geomErr < errorTh)
       {
         // Update the corresponding points & distance (if required)
@@ -282,6 +283,313 @@ void GuidedMatching(
   }
 }
 
+/**
+ * @brief Index of the regions of an image for guided matching.
+ * The (un-distorted) positions are computed once and stored in a uniform grid,
+ * so a guided matching query only evaluates the features of the cells crossed
+ * by the area allowed by the model (epipolar band or disk around the transferred point).
+ * The index can be reused for several models and queried in parallel.
+ */
+class GuidedMatchingIndex
+{
+public:
+  /**
+   * @param[in] cam optional camera (in order to undistord the feature positions, can be NULL)
+   * @param[in] regions the regions (point features & corresponding descriptors), must outlive the index
+   * @param[in] nbPerCell the mean number of features per cell
+   */
+  GuidedMatchingIndex(const camera::IntrinsicBase* cam, const feature::Regions& regions, std::size_t nbPerCell = 4)
+    : _regions(regions)
+    , _positions(getUndistortedRegionsPositions(cam, regions))
+  {
+    const Mat2X::Index nbPoints = _positions.cols();
+    _min.setZero();
+    Vec2 extent = Vec2::Zero();
+    if(nbPoints > 0)
+    {
+      _min = _positions.rowwise().minCoeff();
+      extent = _positions.rowwise().maxCoeff() - _min;
+    }
+    const double area = std::max(extent(0), 1.0) * std::max(extent(1), 1.0);
+    _cellSize = std::max(1.0, std::sqrt(area * nbPerCell / std::max<Mat2X::Index>(nbPoints, 1)));
+    _width = static_cast<int>(extent(0) / _cellSize) + 1;
+    _height = static_cast<int>(extent(1) / _cellSize) + 1;
+
+    // counting sort of the features per cell
+    _cellStart.assign(_width * _height + 1, 0);
+    std::vector<int> cells(nbPoints);
+    for(Mat2X::Index i = 0; i < nbPoints; ++i)
+    {
+      cells[i] = cellIndex(_positions.col(i));
+      ++_cellStart[cells[i] + 1];
+    }
+    for(std::size_t c = 1; c < _cellStart.size(); ++c)
+      _cellStart[c] += _cellStart[c - 1];
+    _indexes.resize(nbPoints);
+    std::vector<IndexT> cellFill(_cellStart.begin(), _cellStart.end() - 1);
+    for(Mat2X::Index i = 0; i < nbPoints; ++i)
+      _indexes[cellFill[cells[i]]++] = static_cast<IndexT>(i);
+  }
+
+  const feature::Regions& getRegions() const { return _regions; }
+
+  /// the (un-distorted) positions of the regions, one per column
+  const Mat2X& getPositions() const { return _positions; }
+
+  /**
+   * @brief Append the features that can be closer than halfWidth to a line (a superset, by cells)
+   * @param[in] line the line (a, b, c): a*x + b*y + c = 0
+   * @param[in] halfWidth the half width of the band around the line
+   * @param[in,out] candidates the indexes of the features
+   */
+  void getCandidatesAlongLine(const Vec3& line, double halfWidth, std::vector<IndexT>& candidates) const
+  {
+    const double norm = line.head<2>().norm();
+    if(norm == 0.0)
+      return;
+    const double a = line(0) / norm;
+    const double b = line(1) / norm;
+    const double c = line(2) / norm;
+
+    // walk along the main direction of the line, cell column by cell column (or row by row)
+    const bool horizontal = std::abs(b) >= std::abs(a);
+    const double u = horizontal ? a : b;
+    const double v = horizontal ? b : a;
+    const int nbSteps = horizontal ? _width : _height;
+    const int nbOther = horizontal ? _height : _width;
+    const double originStep = _min(horizontal ? 0 : 1);
+    const double originOther = _min(horizontal ? 1 : 0);
+    const double halfSpan = halfWidth / std::abs(v);
+
+    for(int step = 0; step < nbSteps; ++step)
+    {
+      const double s0 = originStep + step * _cellSize;
+      const double s1 = s0 + _cellSize;
+      const double t0 = -(u * s0 + c) / v;
+      const double t1 = -(u * s1 + c) / v;
+      int begin, end;
+      if(!cellRange(std::min(t0, t1) - halfSpan, std::max(t0, t1) + halfSpan, originOther, nbOther, begin, end))
+        continue;
+      for(int other = begin; other <= end; ++other)
+        appendCell(horizontal ? cellIndex(step, other) : cellIndex(other, step), candidates);
+    }
+  }
+
+  /**
+   * @brief Append the features that can be closer than radius to a point (a superset, by cells)
+   * @param[in] point the point
+   * @param[in] radius the radius of the disk around the point
+   * @param[in,out] candidates the indexes of the features
+   */
+  void getCandidatesAroundPoint(const Vec2& point, double radius, std::vector<IndexT>& candidates) const
+  {
+    int xBegin, xEnd, yBegin, yEnd;
+    if(!cellRange(point(0) - radius, point(0) + radius, _min(0), _width, xBegin, xEnd) ||
+       !cellRange(point(1) - radius, point(1) + radius, _min(1), _height, yBegin, yEnd))
+      return;
+    for(int y = yBegin; y <= yEnd; ++y)
+      for(int x = xBegin; x <= xEnd; ++x)
+        appendCell(cellIndex(x, y), candidates);
+  }
+
+private:
+  inline int cellIndex(int x, int y) const { return y * _width + x; }
+
+  inline int cellIndex(const Vec2& position) const
+  {
+    const int x = static_cast<int>((position(0) - _min(0)) / _cellSize);
+    const int y = static_cast<int>((position(1) - _min(1)) / _cellSize);
+    return cellIndex(std::min(std::max(x, 0), _width - 1), std::min(std::max(y, 0), _height - 1));
+  }
+
+  /// range [begin, end] of the cells covering [v0, v1] along an axis, false if outside the grid
+  inline bool cellRange(double v0, double v1, double origin, int size, int& begin, int& end) const
+  {
+    const double c0 = std::floor((v0 - origin) / _cellSize);
+    const double c1 = std::floor((v1 - origin) / _cellSize);
+    if(!(c1 >= 0.0 && c0 < size)) // also false for NaN
+      return false;
+    begin = static_cast<int>(std::max(c0, 0.0));
+    end = static_cast<int>(std::min(c1, size - 1.0));
+    return true;
+  }
+
+  inline void appendCell(int cell, std::vector<IndexT>& candidates) const
+  {
+    candidates.insert(candidates.end(), _indexes.begin() + _cellStart[cell], _indexes.begin() + _cellStart[cell + 1]);
+  }
+
+  const feature::Regions& _regions;
+  Mat2X _positions;
+  Vec2 _min;
+  double _cellSize;
+  int _width;
+  int _height;
+  /// features of the cell c: _indexes[_cellStart[c]] to _indexes[_cellStart[c+1]]
+  std::vector<IndexT> _cellStart;
+  std::vector<IndexT> _indexes;
+};
+
+/**
+ * @brief Guided Matching (features + descriptors with distance ratio) with an index of the right regions,
+ * the left features are matched in parallel.
+ * Same results as the exhaustive GuidedMatching if the candidates given by getCandidates
+ * contain all the features under the error threshold.
+ * @param[in] getCandidates void(const Vec2& leftPosition, std::vector<IndexT>& candidates)
+ */
+template<
+  typename ModelArg,     // The used model type
+  typename ErrorArg,     // The metric to compute distance to the model
+  typename GetCandidates // The query of the candidate right features
+  >
+void GuidedMatchingWithIndex(
+  const ModelArg & mod, // The model
+  const Mat2X & lRegionsPos, // The (un-distorted) left positions
+  const feature::Regions & lRegions, // regions (point features & corresponding descriptors)
+  const GuidedMatchingIndex & rIndex, // index of the right regions
+  double errorTh,       // Maximal authorized error threshold
+  double distRatio,     // Maximal authorized distance ratio
+  const GetCandidates & getCandidates,
+  matching::IndMatches & out_matches) // Ouput corresponding index
+{
+  const feature::Regions& rRegions = rIndex.getRegions();
+  const Mat2X& rRegionsPos = rIndex.getPositions();
+  const int nbLeft = static_cast<int>(lRegions.RegionCount());
+  std::vector<IndexT> bestMatches(nbLeft, UndefinedIndexT);
+
+  #pragma omp parallel
+  {
+    std::vector<IndexT> candidates;
+
+    #pragma omp for schedule(dynamic, 64)
+    for(int i = 0; i < nbLeft; ++i)
+    {
+      const Vec2 lPos = lRegionsPos.col(i);
+      candidates.clear();
+      getCandidates(lPos, candidates);
+      // same order as the exhaustive search, for the same result in case of equal distances
+      std::sort(candidates.begin(), candidates.end());
+
+      distanceRatio<double> dR;
+      for(const IndexT j : candidates)
+      {
+        // Compute the geometric error: error to the model
+        const double geomErr = ErrorArg::Error(mod, lPos, rRegionsPos.col(j));
+        if(geomErr < errorTh)
+          dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+      }
+      // Add correspondence only iff the distance ratio is valid
+      if(dR.isValid(distRatio))
+        bestMatches[i] = dR.idx;
+    }
+  }
+
+  for(int i = 0; i < nbLeft; ++i)
+  {
+    if(bestMatches[i] != UndefinedIndexT)
+      out_matches.emplace_back(i, bestMatches[i]);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(out_matches);
+}
+
+/**
+ * @brief Guided Matching with a fundamental matrix, the candidates of a left feature
+ * are the right features in the band of half width sqrt(errorTh) around its epipolar line.
+ * ErrorArg must not be smaller than the squared distance to the epipolar line in the
+ * right image (e.g. EpipolarDistanceError) to give the same results as GuidedMatching.
+ */
+template<typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Epipolar(
+  const Mat3 & F,       // The fundamental matrix
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const GuidedMatchingIndex & rIndex, // index of the right regions
+  double errorTh,       // Maximal authorized error threshold (squared)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & out_matches) // Ouput corresponding index
+{
+  const double halfWidth = std::sqrt(errorTh);
+  GuidedMatchingWithIndex<Mat3, ErrorArg>(F, getUndistortedRegionsPositions(camL, lRegions), lRegions, rIndex, errorTh, distRatio,
+    [&](const Vec2& x, std::vector<IndexT>& candidates)
+    {
+      rIndex.getCandidatesAlongLine(F * x.homogeneous(), halfWidth, candidates);
+    },
+    out_matches);
+}
+
+/**
+ * @brief Guided Matching with a homography, the candidates of a left feature
+ * are the right features closer than sqrt(errorTh) to its transfer.
+ * ErrorArg must not be smaller than the squared transfer distance in the
+ * right image (e.g. AsymmetricError) to give the same results as GuidedMatching.
+ */
+template<typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Homography(
+  const Mat3 & H,       // The homography
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const GuidedMatchingIndex & rIndex, // index of the right regions
+  double errorTh,       // Maximal authorized error threshold (squared)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & out_matches) // Ouput corresponding index
+{
+  const double radius = std::sqrt(errorTh);
+  GuidedMatchingWithIndex<Mat3, ErrorArg>(H, getUndistortedRegionsPositions(camL, lRegions), lRegions, rIndex, errorTh, distRatio,
+    [&](const Vec2& x, std::vector<IndexT>& candidates)
+    {
+      const Vec3 transfer = H * x.homogeneous();
+      if(transfer(2) != 0.0)
+        rIndex.getCandidatesAroundPoint(transfer.head<2>() / transfer(2), radius, candidates);
+    },
+    out_matches);
+}
+
+/**
+ * @brief Guided Matching with a fundamental matrix for each common describer type,
+ * see GuidedMatching_Epipolar.
+ */
+template<typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Epipolar(
+  const Mat3 & F,       // The fundamental matrix
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & lRegions,  // regions (point features & corresponding descriptors)
+  const camera::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold (squared)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::MatchesPerDescType & out_matchesPerDesc) // Ouput corresponding index
+{
+  for(const feature::EImageDescriberType descType: getCommonDescTypes(lRegions, rRegions))
+  {
+    const GuidedMatchingIndex rIndex(camR, *rRegions.at(descType));
+    GuidedMatching_Epipolar<ErrorArg>(F, camL, *lRegions.at(descType), rIndex, errorTh, distRatio, out_matchesPerDesc[descType]);
+  }
+}
+
+/**
+ * @brief Guided Matching with a homography for each common describer type,
+ * see GuidedMatching_Homography.
+ */
+template<typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Homography(
+  const Mat3 & H,       // The homography
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & lRegions,  // regions (point features & corresponding descriptors)
+  const camera::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold (squared)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::MatchesPerDescType & out_matchesPerDesc) // Ouput corresponding index
+{
+  for(const feature::EImageDescriberType descType: getCommonDescTypes(lRegions, rRegions))
+  {
+    const GuidedMatchingIndex rIndex(camR, *rRegions.at(descType));
+    GuidedMatching_Homography<ErrorArg>(H, camL, *lRegions.at(descType), rIndex, errorTh, distRatio, out_matchesPerDesc[descType]);
+  }
+}
+
 /// Compute a bucket index from an epipolar point
 ///  (the one that is closer to image border intersection)
 inline unsigned int pix_to_bucket(const Vec2i &x, int W, int H)
@@ -383,11 +691,14 @@ void GuidedMatching_Fundamental_Fast(
   typedef std::vector<Bucket_vec> Buckets_vec;
   const int nb_buckets = 2 * (widthR + heightR - 2);
 
+  const Mat2X lRegionsPos = getUndistortedRegionsPositions(camL, lRegions);
+  const Mat2X rRegionsPos = getUndistortedRegionsPositions(camR, rRegions);
+
   Buckets_vec buckets(nb_buckets);
   for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
   {
     // Compute epipolar line
-    const Vec2 l_pt = (camL && camL->isValid()) ? camL->get_ud_pixel(lRegions.GetRegionPosition(i)) : lRegions.GetRegionPosition(i);
+    const Vec2 l_pt = lRegionsPos.col(i);
     const Vec3 line = F * Vec3(l_pt(0), l_pt(1), 1.);
     // If the epipolar line exists in Right image
     Vec2 x0, x1;
@@ -408,7 +719,7 @@ void GuidedMatching_Fundamental_Fast(
     // - compute the range of possible bucket by computing
     //    the epipolar line gauge limitation introduced by the tolerated pixel error
 
-    const Vec2 xR = (camR && camR->isValid()) ? camR->get_ud_pixel(rRegions.GetRegionPosition(j)) : rRegions.GetRegionPosition(j);
+    const Vec2 xR = rRegionsPos.col(j);
     const Vec3 l2 = ep2.cross(Vec3(xR(0), xR(1), 1.));
     const Vec2 n = l2.head<2>() * (sqrt(errorTh) / l2.head<2>().norm());
 
@@ -0,0 +1,448 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+/**
+ * Benchmark of the robust estimators (ACRansac, LORansac, MaxConsensus) on the
+ * Fundamental, Essential, Homography and resection kernels.
+ *
+ * The correspondences come from synthetic NViewDataSet scenes, with a controlled
+ * number of points and ratio of outliers. For each configuration, it reports the
+ * time to solution, the number of hypotheses (models estimated from minimal samples)
+ * per second and the recall/precision of the inliers against the ground truth.
+ *
+ * Note: there is no LORansac kernel for the Essential matrix.
+ */
+
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/multiview/projection.hpp>
+#include <aliceVision/multiview/conditioning.hpp>
+#include <aliceVision/multiview/essential.hpp>
+#include <aliceVision/multiview/fundamentalKernelSolver.hpp>
+#include <aliceVision/multiview/essentialKernelSolver.hpp>
+#include <aliceVision/multiview/homographyKernelSolver.hpp>
+#include <aliceVision/multiview/resection/P3PSolver.hpp>
+#include <aliceVision/multiview/resection/ResectionKernel.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp>
+#include <aliceVision/robustEstimation/LORansac.hpp>
+#include <aliceVision/robustEstimation/LORansacKernelAdaptor.hpp>
+#include <aliceVision/robustEstimation/maxConsensus.hpp>
+#include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+namespace po = boost::program_options;
+
+namespace {
+
+/**
+ * @brief Kernel wrapper counting the minimal samples and the hypotheses they give
+ */
+template <typename KernelArg>
+class CountingKernel : public KernelArg
+{
+public:
+  template <typename... Args>
+  explicit CountingKernel(Args&&... args)
+    : KernelArg(std::forward<Args>(args)...)
+  {}
+
+  void Fit(const std::vector<std::size_t>& samples, std::vector<typename KernelArg::Model>* models) const
+  {
+    KernelArg::Fit(samples, models);
+    ++_nbSamples;
+    _nbHypotheses += models->size();
+  }
+
+  void resetCounters() const
+  {
+    _nbSamples = 0;
+    _nbHypotheses = 0;
+  }
+
+  std::size_t getNbSamples() const { return _nbSamples; }
+  std::size_t getNbHypotheses() const { return _nbHypotheses; }
+
+private:
+  mutable std::size_t _nbSamples = 0;
+  mutable std::size_t _nbHypotheses = 0;
+};
+
+/**
+ * @brief Least squares homography solver for the LORansac kernel
+ * @note the 4 points DLT is not weighted, the weights are ignored
+ */
+struct HomographyLSSolver
+{
+  enum
+  {
+    MINIMUM_SAMPLES = homography::kernel::FourPointSolver::MINIMUM_SAMPLES
+  };
+
+  enum
+  {
+    MAX_MODELS = homography::kernel::FourPointSolver::MAX_MODELS
+  };
+
+  static void Solve(const Mat& x1, const Mat& x2, std::vector<Mat3>* Hs, const std::vector<double>* weights = nullptr)
+  {
+    homography::kernel::FourPointSolver::Solve(x1, x2, Hs);
+  }
+};
+
+struct ResectionSquaredResidualError
+{
+  // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
+  // Return the squared error
+  static double Error(const Mat34& P, const Vec2& pt2D, const Vec3& pt3D)
+  {
+    const Vec2 x = Project(P, pt3D);
+    return (x - pt2D).squaredNorm();
+  }
+};
+
+struct BenchmarkOptions
+{
+  std::regex filter;
+  int nbRepetitions;
+  /// inlier threshold in pixels (LORansac and MaxConsensus)
+  double threshold;
+};
+
+/**
+ * @brief Synthetic correspondences with their ground truth
+ */
+struct Scene
+{
+  std::string name;
+  int width;
+  int height;
+  /// 2D points in the first view (two-view models)
+  Mat x1;
+  /// 2D points in the second view (two-view models) or in the localized view (resection)
+  Mat x2;
+  /// 3D points (resection)
+  Mat pt3D;
+  Mat3 K1;
+  Mat3 K2;
+  std::vector<char> isInlier;
+  std::size_t nbInliers;
+};
+
+/**
+ * @brief Build a two views scene from a NViewDataSet, the outliers are
+ *        uniformly distributed in the second image.
+ * @param[in] planar put all the 3D points on a plane (Homography)
+ */
+Scene makeScene(const std::string& modelName, std::size_t nbPoints, double outliersRatio, bool planar, unsigned int seed)
+{
+  // NViewDataSet uses Eigen setRandom
+  std::srand(seed);
+  std::mt19937 generator(seed);
+
+  const NViewDatasetConfigurator config(1000, 1000, 500, 500, 1.5, 0.01);
+  NViewDataSet d = NRealisticCamerasRing(5, nbPoints, config);
+
+  if(planar)
+  {
+    d._X.row(2).setZero();
+    for(std::size_t i = 0; i < d._n; ++i)
+      d._x[i] = Project(d.P(i), d._X);
+  }
+
+  Scene scene;
+  {
+    std::ostringstream os;
+    os << "/" << modelName << "/points:" << nbPoints << "/outliers:" << std::lround(outliersRatio * 100.0) << "%";
+    scene.name = os.str();
+  }
+  scene.width = 2 * config._cx;
+  scene.height = 2 * config._cy;
+  scene.x1 = d._x[0];
+  scene.x2 = d._x[1];
+  scene.pt3D = d._X;
+  scene.K1 = d._K[0];
+  scene.K2 = d._K[1];
+
+  // image noise
+  std::normal_distribution<double> noise(0.0, 0.5);
+  for(Mat::Index i = 0; i < scene.x1.cols(); ++i)
+  {
+    scene.x1.col(i) += Vec2(noise(generator), noise(generator));
+    scene.x2.col(i) += Vec2(noise(generator), noise(generator));
+  }
+
+  // outliers
+  std::vector<std::size_t> indices(nbPoints);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::shuffle(indices.begin(), indices.end(), generator);
+
+  const std::size_t nbOutliers = static_cast<std::size_t>(outliersRatio * nbPoints);
+  std::uniform_real_distribution<double> randX(0.0, scene.width);
+  std::uniform_real_distribution<double> randY(0.0, scene.height);
+
+  scene.isInlier.assign(nbPoints, 1);
+  for(std::size_t i = 0; i < nbOutliers; ++i)
+  {
+    scene.x2.col(indices[i]) = Vec2(randX(generator), randY(generator));
+    scene.isInlier[indices[i]] = 0;
+  }
+  scene.nbInliers = nbPoints - nbOutliers;
+
+  return scene;
+}
+
+void printHeader()
+{
+  std::cout << std::string(110, '-') << "\n"
+            << std::left << std::setw(48) << "Benchmark"
+            << std::right << std::setw(12) << "Time (ms)"
+            << std::setw(12) << "Samples"
+            << std::setw(14) << "Hypotheses"
+            << std::setw(10) << "Hyp/s"
+            << std::setw(14) << "Recall/Prec." << "\n"
+            << std::string(110, '-') << std::endl;
+}
+
+/**
+ * @brief Run a robust estimation several times and print its statistics
+ * @param[in] estimate void(std::vector<std::size_t>& inliers), runs the robust estimation
+ */
+template <typename Kernel, typename Estimate>
+void runBenchmark(const std::string& name,
+                  const Scene& scene,
+                  const Kernel& kernel,
+                  const Estimate& estimate,
+                  const BenchmarkOptions& options)
+{
+  if(!std::regex_search(name, options.filter))
+    return;
+
+  double totalMs = 0.0;
+  std::size_t totalSamples = 0;
+  std::size_t totalHypotheses = 0;
+  double totalRecall = 0.0;
+  double totalPrecision = 0.0;
+
+  for(int r = 0; r < options.nbRepetitions; ++r)
+  {
+    std::vector<std::size_t> inliers;
+    kernel.resetCounters();
+
+    system::Timer timer;
+    estimate(inliers);
+    totalMs += timer.elapsedMs();
+
+    totalSamples += kernel.getNbSamples();
+    totalHypotheses += kernel.getNbHypotheses();
+
+    std::size_t nbTrueInliers = 0;
+    for(std::size_t i : inliers)
+      nbTrueInliers += scene.isInlier[i];
+    totalRecall += (scene.nbInliers == 0) ? 1.0 : nbTrueInliers / static_cast<double>(scene.nbInliers);
+    totalPrecision += inliers.empty() ? 0.0 : nbTrueInliers / static_cast<double>(inliers.size());
+  }
+
+  const double n = options.nbRepetitions;
+  const double hypothesesPerSecond = (totalMs > 0.0) ? totalHypotheses / (totalMs / 1000.0) : 0.0;
+
+  std::ostringstream quality;
+  quality << std::fixed << std::setprecision(2) << totalRecall / n << "/" << totalPrecision / n;
+
+  std::cout << std::left << std::setw(48) << name
+            << std::right << std::fixed << std::setprecision(3) << std::setw(12) << totalMs / n
+            << std::setprecision(0) << std::setw(12) << totalSamples / n
+            << std::setw(14) << totalHypotheses / n
+            << std::setw(10) << hypothesesPerSecond
+            << std::setw(14) << quality.str() << std::endl;
+}
+
+void benchmarkFundamental(const Scene& scene, const BenchmarkOptions& options)
+{
+  typedef CountingKernel<ACKernelAdaptor<fundamental::kernel::SevenPointSolver,
+                                         fundamental::kernel::SimpleError,
+                                         UnnormalizerT,
+                                         Mat3>> ACKernel;
+
+  typedef CountingKernel<KernelAdaptorLoRansac<fundamental::kernel::SevenPointSolver,
+                                               fundamental::kernel::SymmetricEpipolarDistanceError,
+                                               UnnormalizerT,
+                                               Mat3,
+                                               fundamental::kernel::EightPointSolver>> LOKernel;
+
+  const ACKernel acKernel(scene.x1, scene.width, scene.height, scene.x2, scene.width, scene.height, true);
+  const LOKernel loKernel(scene.x1, scene.width, scene.height, scene.x2, scene.width, scene.height, true);
+  const ScoreEvaluator<LOKernel> scorer(Square(options.threshold * loKernel.normalizer2()(0, 0)));
+
+  runBenchmark("ACRansac" + scene.name, scene, acKernel,
+               [&](std::vector<std::size_t>& inliers) { ACRANSAC(acKernel, inliers); }, options);
+  runBenchmark("LORansac" + scene.name, scene, loKernel,
+               [&](std::vector<std::size_t>& inliers) { LO_RANSAC(loKernel, scorer, &inliers); }, options);
+  runBenchmark("MaxConsensus" + scene.name, scene, loKernel,
+               [&](std::vector<std::size_t>& inliers) { MaxConsensus(loKernel, scorer, &inliers); }, options);
+}
+
+void benchmarkEssential(const Scene& scene, const BenchmarkOptions& options)
+{
+  typedef CountingKernel<ACKernelAdaptorEssential<essential::kernel::FivePointSolver,
+                                                  fundamental::kernel::EpipolarDistanceError,
+                                                  UnnormalizerT,
+                                                  Mat3>> ACKernel;
+
+  const ACKernel acKernel(scene.x1, scene.width, scene.height, scene.x2, scene.width, scene.height, scene.K1, scene.K2);
+  // the Essential kernel errors are in pixels
+  const ScoreEvaluator<ACKernel> scorer(Square(options.threshold));
+
+  runBenchmark("ACRansac" + scene.name, scene, acKernel,
+               [&](std::vector<std::size_t>& inliers) { ACRANSAC(acKernel, inliers); }, options);
+  runBenchmark("MaxConsensus" + scene.name, scene, acKernel,
+               [&](std::vector<std::size_t>& inliers) { MaxConsensus(acKernel, scorer, &inliers); }, options);
+}
+
+void benchmarkHomography(const Scene& scene, const BenchmarkOptions& options)
+{
+  typedef CountingKernel<ACKernelAdaptor<homography::kernel::FourPointSolver,
+                                         homography::kernel::AsymmetricError,
+                                         UnnormalizerI,
+                                         Mat3>> ACKernel;
+
+  typedef CountingKernel<KernelAdaptorLoRansac<homography::kernel::FourPointSolver,
+                                               homography::kernel::AsymmetricError,
+                                               UnnormalizerI,
+                                               Mat3,
+                                               HomographyLSSolver>> LOKernel;
+
+  // point to point error model
+  const ACKernel acKernel(scene.x1, scene.width, scene.height, scene.x2, scene.width, scene.height, false);
+  const LOKernel loKernel(scene.x1, scene.width, scene.height, scene.x2, scene.width, scene.height, false);
+  const ScoreEvaluator<LOKernel> scorer(Square(options.threshold * loKernel.normalizer2()(0, 0)));
+
+  runBenchmark("ACRansac" + scene.name, scene, acKernel,
+               [&](std::vector<std::size_t>& inliers) { ACRANSAC(acKernel, inliers); }, options);
+  runBenchmark("LORansac" + scene.name, scene, loKernel,
+               [&](std::vector<std::size_t>& inliers) { LO_RANSAC(loKernel, scorer, &inliers); }, options);
+  runBenchmark("MaxConsensus" + scene.name, scene, loKernel,
+               [&](std::vector<std::size_t>& inliers) { MaxConsensus(loKernel, scorer, &inliers); }, options);
+}
+
+void benchmarkResection(const Scene& scene, const BenchmarkOptions& options)
+{
+  typedef CountingKernel<ACKernelAdaptorResection_K<resection::P3PSolver,
+                                                    ResectionSquaredResidualError,
+                                                    UnnormalizerResection,
+                                                    Mat34>> ACKernel;
+
+  typedef CountingKernel<KernelAdaptorResectionLORansac_K<resection::P3PSolver,
+                                                          ResectionSquaredResidualError,
+                                                          UnnormalizerResection,
+                                                          resection::kernel::SixPointResectionSolver,
+                                                          Mat34>> LOKernel;
+
+  const ACKernel acKernel(scene.x2, scene.pt3D, scene.K2);
+  const LOKernel loKernel(scene.x2, scene.pt3D, scene.K2);
+  const ScoreEvaluator<LOKernel> scorer(Square(options.threshold * loKernel.normalizer2()(0, 0)));
+
+  runBenchmark("ACRansac" + scene.name, scene, acKernel,
+               [&](std::vector<std::size_t>& inliers) { ACRANSAC(acKernel, inliers); }, options);
+  runBenchmark("LORansac" + scene.name, scene, loKernel,
+               [&](std::vector<std::size_t>& inliers) { LO_RANSAC(loKernel, scorer, &inliers); }, options);
+  runBenchmark("MaxConsensus" + scene.name, scene, loKernel,
+               [&](std::vector<std::size_t>& inliers) { MaxConsensus(loKernel, scorer, &inliers); }, options);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string filter = ".*";
+  int nbRepetitions = 10;
+  double threshold = 4.0;
+  unsigned int seed = 0;
+  std::vector<std::size_t> nbPointsList = {100, 1000};
+  std::vector<double> outliersRatioList = {0.1, 0.3, 0.5, 0.7};
+
+  po::options_description allParams("Benchmark of the robust estimators on synthetic scenes");
+  allParams.add_options()
+    ("help,h", "Print this help.")
+    ("filter", po::value<std::string>(&filter)->default_value(filter),
+      "Regular expression selecting the benchmarks to run by name "
+      "(e.g. \"ACRansac/F/\", \"/H/points:1000/\").")
+    ("repetitions,r", po::value<int>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of runs of each benchmark.")
+    ("points,n", po::value<std::vector<std::size_t>>(&nbPointsList)->multitoken(),
+      "Number of correspondences of the scenes (default: 100 1000).")
+    ("outliers,o", po::value<std::vector<double>>(&outliersRatioList)->multitoken(),
+      "Ratios of outliers of the scenes (default: 0.1 0.3 0.5 0.7).")
+    ("threshold", po::value<double>(&threshold)->default_value(threshold),
+      "Inlier threshold in pixels for LORansac and MaxConsensus.")
+    ("seed", po::value<unsigned int>(&seed)->default_value(seed),
+      "Seed of the scenes generation.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      std::cout << allParams << std::endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cout << "Usage:\n\n" << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  BenchmarkOptions options;
+  try
+  {
+    options.filter = std::regex(filter);
+  }
+  catch(const std::regex_error& e)
+  {
+    std::cerr << "ERROR: invalid filter: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  options.nbRepetitions = std::max(1, nbRepetitions);
+  options.threshold = threshold;
+
+  printHeader();
+
+  for(std::size_t nbPoints : nbPointsList)
+  {
+    for(double outliersRatio : outliersRatioList)
+    {
+      benchmarkFundamental(makeScene("F", nbPoints, outliersRatio, false, seed), options);
+      benchmarkEssential(makeScene("E", nbPoints, outliersRatio, false, seed), options);
+      benchmarkHomography(makeScene("H", nbPoints, outliersRatio, true, seed), options);
+      benchmarkResection(makeScene("P", nbPoints, outliersRatio, false, seed), options);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -10,6 +10,7 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <vector>
 #include <string>
@@ -54,6 +55,18 @@ bool parseDatabase(const std::string& databaseFilePath, std::vector<Datasheet>&
   return true;
 }
 
+namespace {
+
+/// same normalization as Datasheet::operator==: lower case, without punctuation
+std::string normalize(const std::string& str)
+{
+  std::string out = boost::algorithm::to_lower_copy(str);
+  out.erase(std::remove_if(out.begin(), out.end(), ::ispunct), out.end());
+  return out;
+}
+
+} // namespace
+
 bool getInfo(const std::string& brand, const std::string& model, const std::vector<Datasheet>& databaseStructure, Datasheet& datasheetContent)
 {
   Datasheet refDatasheet(brand, model, -1.);
@@ -66,5 +79,75 @@ bool getInfo(const std::string& brand, const std::string& model, const std::vect
   return true;
 }
 
+bool SensorDatabase::load(const std::string& databaseFilePath)
+{
+  std::vector<Datasheet> databaseStructure;
+  if(!parseDatabase(databaseFilePath, databaseStructure))
+    return false;
+
+  setDatasheets(databaseStructure);
+  return true;
+}
+
+void SensorDatabase::setDatasheets(const std::vector<Datasheet>& databaseStructure)
+{
+  _datasheets = databaseStructure;
+  _brandIndex.clear();
+
+  for(std::size_t i = 0; i < _datasheets.size(); ++i)
+    _brandIndex[normalize(_datasheets[i]._brand)].emplace_back(normalize(_datasheets[i]._model), i);
+
+  std::lock_guard<std::mutex> lock(_cacheMutex);
+  _cache.clear();
+}
+
+bool SensorDatabase::getInfo(const std::string& brand, const std::string& model, Datasheet& datasheetContent) const
+{
+  // '\n' can't be in a brand: unambiguous key
+  const std::string key = brand + '\n' + model;
+  int index = -1;
+  bool cached = false;
+
+  {
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    const auto it = _cache.find(key);
+    if(it != _cache.end())
+    {
+      index = it->second;
+      cached = true;
+    }
+  }
+
+  if(!cached)
+  {
+    const auto brandIt = _brandIndex.find(normalize(brand));
+    if(brandIt != _brandIndex.end())
+    {
+      const std::string normalizedModel = normalize(model);
+
+      // first datasheet of the brand in the database order, as Datasheet::operator==
+      for(const auto& entry : brandIt->second)
+      {
+        if((entry.first == normalizedModel) ||
+           (boost::algorithm::ends_with(entry.first, normalizedModel)) ||
+           (boost::algorithm::ends_with(normalizedModel, entry.first)))
+        {
+          index = static_cast<int>(entry.second);
+          break;
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    _cache.emplace(key, index);
+  }
+
+  if(index < 0)
+    return false;
+
+  datasheetContent = _datasheets.at(index);
+  return true;
+}
+
 } // namespace sensorDB
 } // namespace aliceVision
@@ -9,8 +9,11 @@
 
 #include <aliceVision/sensorDB/Datasheet.hpp>
 
-#include <vector>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace sensorDB {
@@ -33,5 +36,50 @@ bool parseDatabase(const std::string& databaseFilePath, std::vector<Datasheet>&
  */
 bool getInfo(const std::string& brand, const std::string& model, const std::vector<Datasheet>& databaseStructure, Datasheet& datasheetContent);
 
+/**
+ * @brief Sensor database loaded once and indexed by normalized brand.
+ *
+ * getInfo() gives the same datasheet as the linear search above, but only scans
+ * the datasheets of the camera brand, and each brand / model query is cached.
+ * getInfo() is thread-safe.
+ */
+class SensorDatabase
+{
+public:
+  /**
+   * @brief Parse and index the given sensor database
+   * @param[in] databaseFilePath The file path of the given database
+   * @return True if ok
+   */
+  bool load(const std::string& databaseFilePath);
+
+  /**
+   * @brief Index the given datasheets
+   * @param[in] databaseStructure The datasheets, in the database order
+   */
+  void setDatasheets(const std::vector<Datasheet>& databaseStructure);
+
+  /**
+   * @brief Get information for the given camera brand / model
+   * @param[in] brand The camera brand
+   * @param[in] model The camera model
+   * @param[out] datasheetContent The corresponding datasheet
+   * @return True if ok
+   */
+  bool getInfo(const std::string& brand, const std::string& model, Datasheet& datasheetContent) const;
+
+  const std::vector<Datasheet>& getDatasheets() const { return _datasheets; }
+
+private:
+  /// datasheets in the database order
+  std::vector<Datasheet> _datasheets;
+  /// normalized brand -> (normalized model, datasheet index) in the database order
+  std::unordered_map<std::string, std::vector<std::pair<std::string, std::size_t>>> _brandIndex;
+
+  mutable std::mutex _cacheMutex;
+  /// brand / model query -> datasheet index (-1 if not found)
+  mutable std::unordered_map<std::string, int> _cache;
+};
+
 } // namespace sensorDB
 } // namespace aliceVision
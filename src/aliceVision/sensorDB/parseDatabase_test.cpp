@@ -111,3 +111,41 @@ BOOST_AUTO_TEST_CASE(ParseDatabaseCanon_EOS_1100D)
   BOOST_CHECK( getInfo( sBrand, sModel, vec_database, datasheet ) );
   BOOST_CHECK_EQUAL( 22.2, datasheet._sensorSize );
 }
+
+BOOST_AUTO_TEST_CASE(SensorDatabaseSameAsLinearSearch)
+{
+  std::vector<Datasheet> vec_database;
+  BOOST_CHECK( parseDatabase( sDatabase, vec_database ) );
+
+  SensorDatabase sensorDatabase;
+  BOOST_CHECK( sensorDatabase.load( sDatabase ) );
+  BOOST_CHECK_EQUAL( sensorDatabase.getDatasheets().size(), vec_database.size() );
+
+  std::vector<std::pair<std::string, std::string>> queries = {
+    {"Canon", "Canon PowerShot SD900"},
+    {"CANON", "canon eos 5d mark ii"},
+    {"Canon", "EOS 550D"},
+    {"NotExistBrand", "NotExistModel"},
+    {"Canon", "NotExistModel"}
+  };
+  for(const Datasheet& datasheet : vec_database)
+    queries.emplace_back(datasheet._brand, datasheet._model);
+
+  // twice: the second time from the cache
+  for(int pass = 0; pass < 2; ++pass)
+  {
+    for(const auto& query : queries)
+    {
+      Datasheet expected;
+      Datasheet datasheet;
+      const bool found = getInfo( query.first, query.second, vec_database, expected );
+      BOOST_CHECK_EQUAL( sensorDatabase.getInfo( query.first, query.second, datasheet ), found );
+      if(found)
+      {
+        BOOST_CHECK_EQUAL( expected._brand, datasheet._brand );
+        BOOST_CHECK_EQUAL( expected._model, datasheet._model );
+        BOOST_CHECK_EQUAL( expected._sensorSize, datasheet._sensorSize );
+      }
+    }
+  }
+}
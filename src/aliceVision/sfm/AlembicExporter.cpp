@@ -243,7 +243,7 @@ std::string AlembicExporter::getFilename() const
   return _dataImpl->_archive.getName();
 }
 
-void AlembicExporter::addSfM(const SfMData& sfmData, ESfMData flagsPart)
+void AlembicExporter::addSfM(const SfMData& sfmData, ESfMData flagsPart, bool camerasBatch)
 {
   OCompoundProperty userProps = _dataImpl->_mvgRoot.getProperties();
 
@@ -259,8 +259,12 @@ void AlembicExporter::addSfM(const SfMData& sfmData, ESfMData flagsPart)
               (flagsPart & sfm::ESfMData::OBSERVATIONS));
   }
 
-  if(flagsPart & ESfMData::VIEWS ||
-     flagsPart & ESfMData::EXTRINSICS)
+  if(camerasBatch)
+  {
+    addSfMCamerasBatch(sfmData, flagsPart);
+  }
+  else if(flagsPart & ESfMData::VIEWS ||
+          flagsPart & ESfMData::EXTRINSICS)
   {
     std::map<IndexT, std::map<IndexT, std::vector<IndexT>>> rigsViewIds; //map<rigId,map<poseId,viewId>>
 
@@ -390,21 +394,28 @@ void AlembicExporter::addLandmarks(const Landmarks& landmarks, const sfm::Landma
   if(landmarks.empty())
     return;
 
+  // random access to the landmarks for the parallel encoding
+  std::vector<Landmarks::const_iterator> landmarksIts;
+  landmarksIts.reserve(landmarks.size());
+  for(Landmarks::const_iterator it = landmarks.begin(); it != landmarks.end(); ++it)
+    landmarksIts.push_back(it);
+
+  const int nbLandmarks = static_cast<int>(landmarksIts.size());
+
   // Fill vector with the values taken from AliceVision
-  std::vector<V3f> positions;
-  std::vector<Imath::C3f> colors;
-  std::vector<Alembic::Util::uint32_t> descTypes;
-  positions.reserve(landmarks.size());
-  descTypes.reserve(landmarks.size());
-
-  // For all the 3d points in the hash_map
-  for(const auto& landmark : landmarks)
+  std::vector<V3f> positions(nbLandmarks);
+  std::vector<Imath::C3f> colors(nbLandmarks);
+  std::vector<Alembic::Util::uint32_t> descTypes(nbLandmarks);
+
+  #pragma omp parallel for
+  for(int i = 0; i < nbLandmarks; ++i)
   {
-    const Vec3& pt = landmark.second.X;
-    const image::RGBColor& color = landmark.second.rgb;
-    positions.emplace_back(pt[0], pt[1], pt[2]);
-    colors.emplace_back(color.r()/255.f, color.g()/255.f, color.b()/255.f);
-    descTypes.emplace_back(static_cast<Alembic::Util::uint8_t>(landmark.second.descType));
+    const Landmark& landmark = landmarksIts[i]->second;
+    const Vec3& pt = landmark.X;
+    const image::RGBColor& color = landmark.rgb;
+    positions[i] = V3f(pt[0], pt[1], pt[2]);
+    colors[i] = Imath::C3f(color.r()/255.f, color.g()/255.f, color.b()/255.f);
+    descTypes[i] = static_cast<Alembic::Util::uint8_t>(landmark.descType);
   }
 
   std::vector<Alembic::Util::uint64_t> ids(positions.size());
@@ -430,33 +441,35 @@ void AlembicExporter::addLandmarks(const Landmarks& landmarks, const sfm::Landma
 
   if(withVisibility)
   {
-    std::vector<::uint32_t> visibilitySize;
-    visibilitySize.reserve(positions.size());
-    for(const auto& landmark : landmarks)
+    std::vector<::uint32_t> visibilitySize(nbLandmarks);
+    // first observation index of each landmark
+    std::vector<std::size_t> visibilityOffsets(nbLandmarks + 1, 0);
+    for(int i = 0; i < nbLandmarks; ++i)
     {
-      visibilitySize.emplace_back(landmark.second.observations.size());
+      visibilitySize[i] = landmarksIts[i]->second.observations.size();
+      visibilityOffsets[i + 1] = visibilityOffsets[i] + visibilitySize[i];
     }
-    std::size_t nbObservations = std::accumulate(visibilitySize.begin(), visibilitySize.end(), 0);
+    const std::size_t nbObservations = visibilityOffsets.back();
 
     // Use std::vector<::uint32_t> and std::vector<float> instead of std::vector<V2i> and std::vector<V2f>
     // Because Maya don't import them correctly
-    std::vector<::uint32_t> visibilityIds;
-    visibilityIds.reserve(nbObservations*2);
-    std::vector<float>featPos2d;
-    featPos2d.reserve(nbObservations*2);
+    std::vector<::uint32_t> visibilityIds(nbObservations * 2);
+    std::vector<float> featPos2d(nbObservations * 2);
 
-    for (const auto &landmark : landmarks)
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
     {
-      const Observations& observations = landmark.second.observations;
-      for(const auto& vObs: observations )
+      std::size_t obsIndex = 2 * visibilityOffsets[i];
+      for(const auto& vObs : landmarksIts[i]->second.observations)
       {
         const Observation& obs = vObs.second;
         // (View ID, Feature ID)
-        visibilityIds.emplace_back(vObs.first);
-        visibilityIds.emplace_back(obs.id_feat);
+        visibilityIds[obsIndex] = vObs.first;
+        visibilityIds[obsIndex + 1] = obs.id_feat;
         // Feature 2D position (x, y))
-        featPos2d.emplace_back(obs.x[0]);
-        featPos2d.emplace_back(obs.x[1]);
+        featPos2d[obsIndex] = obs.x[0];
+        featPos2d[obsIndex + 1] = obs.x[1];
+        obsIndex += 2;
       }
     }
 
@@ -466,14 +479,13 @@ void AlembicExporter::addLandmarks(const Landmarks& landmarks, const sfm::Landma
   }
   if(!landmarksUncertainty.empty())
   {
-    std::vector<V3d> uncertainties;
+    std::vector<V3d> uncertainties(nbLandmarks);
 
-    std::size_t indexLandmark = 0;
-    for (Landmarks::const_iterator itLandmark = landmarks.begin(); itLandmark != landmarks.end(); ++itLandmark, ++indexLandmark)
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
     {
-      const IndexT idLandmark = itLandmark->first;
-      const Vec3& u = landmarksUncertainty.at(idLandmark);
-      uncertainties.emplace_back(u[0], u[1], u[2]);
+      const Vec3& u = landmarksUncertainty.at(landmarksIts[i]->first);
+      uncertainties[i] = V3d(u[0], u[1], u[2]);
     }
     // Uncertainty eigen values (x,y,z)
     OV3dArrayProperty propUncertainty(userProps, "mvg_uncertaintyEigenValues");
@@ -481,6 +493,195 @@ void AlembicExporter::addLandmarks(const Landmarks& landmarks, const sfm::Landma
   }
 }
 
+void AlembicExporter::addSfMCamerasBatch(const SfMData& sfmData, ESfMData flagsPart)
+{
+  OObject camerasBatch(_dataImpl->_mvgRoot, "mvgCamerasBatch");
+  OCompoundProperty userProps = camerasBatch.getProperties();
+
+  if(flagsPart & ESfMData::VIEWS)
+  {
+    std::vector<const View*> views;
+    views.reserve(sfmData.getViews().size());
+    for(const auto& viewPair : sfmData.getViews())
+      views.push_back(viewPair.second.get());
+
+    const int nbViews = static_cast<int>(views.size());
+
+    std::vector<::uint32_t> viewIds(nbViews);
+    std::vector<::uint32_t> poseIds(nbViews);
+    std::vector<::uint32_t> intrinsicIds(nbViews);
+    std::vector<::uint32_t> resectionIds(nbViews);
+    std::vector<::uint32_t> rigIds(nbViews);
+    std::vector<::uint32_t> subPoseIds(nbViews);
+    std::vector<::uint32_t> sizes(nbViews * 2);
+    std::vector<std::string> imagePaths(nbViews);
+
+    // metadata are stored in a single array: (key, value) pairs of all the views
+    std::vector<::uint32_t> metadataSize(nbViews);
+    std::vector<std::size_t> metadataOffsets(nbViews + 1, 0);
+    for(int i = 0; i < nbViews; ++i)
+    {
+      metadataSize[i] = views[i]->getMetadata().size();
+      metadataOffsets[i + 1] = metadataOffsets[i] + metadataSize[i];
+    }
+    std::vector<std::string> rawMetadata(metadataOffsets.back() * 2);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbViews; ++i)
+    {
+      const View& view = *views[i];
+
+      viewIds[i] = view.getViewId();
+      poseIds[i] = view.getPoseId();
+      intrinsicIds[i] = view.getIntrinsicId();
+      resectionIds[i] = view.getResectionId();
+      rigIds[i] = view.isPartOfRig() ? view.getRigId() : UndefinedIndexT;
+      subPoseIds[i] = view.isPartOfRig() ? view.getSubPoseId() : UndefinedIndexT;
+      sizes[2 * i] = view.getWidth();
+      sizes[2 * i + 1] = view.getHeight();
+      imagePaths[i] = view.getImagePath();
+
+      std::size_t metadataIndex = 2 * metadataOffsets[i];
+      for(const auto& metadataPair : view.getMetadata())
+      {
+        rawMetadata[metadataIndex++] = metadataPair.first;
+        rawMetadata[metadataIndex++] = metadataPair.second;
+      }
+    }
+
+    OUInt32ArrayProperty(userProps, "mvg_viewIds").set(viewIds);
+    OUInt32ArrayProperty(userProps, "mvg_viewPoseIds").set(poseIds);
+    OUInt32ArrayProperty(userProps, "mvg_viewIntrinsicIds").set(intrinsicIds);
+    OUInt32ArrayProperty(userProps, "mvg_viewResectionIds").set(resectionIds);
+    OUInt32ArrayProperty(userProps, "mvg_viewRigIds").set(rigIds);
+    OUInt32ArrayProperty(userProps, "mvg_viewSubPoseIds").set(subPoseIds);
+    OUInt32ArrayProperty(userProps, "mvg_viewSizes").set(sizes); // (width, height)
+    OStringArrayProperty(userProps, "mvg_viewImagePaths").set(imagePaths);
+    OUInt32ArrayProperty(userProps, "mvg_viewMetadataSize").set(metadataSize);
+    OStringArrayProperty(userProps, "mvg_viewMetadata").set(rawMetadata); // (key, value)
+  }
+
+  if(flagsPart & ESfMData::INTRINSICS)
+  {
+    std::vector<::uint32_t> intrinsicIds;
+    std::vector<std::string> intrinsicTypes;
+    std::vector<::uint32_t> sensorSizes;
+    std::vector<double> initialFocalLengths;
+    std::vector<::uint32_t> paramsSize;
+    std::vector<double> params;
+    std::vector<Alembic::Util::uint8_t> locked;
+
+    for(const auto& intrinsicPair : sfmData.getIntrinsics())
+    {
+      const camera::IntrinsicBase& intrinsic = *(intrinsicPair.second);
+
+      if(!camera::isPinhole(intrinsic.getType()))
+        continue;
+
+      const std::vector<double> intrinsicParams = intrinsic.getParams();
+
+      intrinsicIds.push_back(intrinsicPair.first);
+      intrinsicTypes.push_back(camera::EINTRINSIC_enumToString(intrinsic.getType()));
+      sensorSizes.push_back(intrinsic.w());
+      sensorSizes.push_back(intrinsic.h());
+      initialFocalLengths.push_back(intrinsic.initialFocalLengthPix());
+      paramsSize.push_back(intrinsicParams.size());
+      params.insert(params.end(), intrinsicParams.begin(), intrinsicParams.end());
+      locked.push_back(intrinsic.isLocked());
+    }
+
+    OUInt32ArrayProperty(userProps, "mvg_intrinsicIds").set(intrinsicIds);
+    OStringArrayProperty(userProps, "mvg_intrinsicTypes").set(intrinsicTypes);
+    OUInt32ArrayProperty(userProps, "mvg_intrinsicSensorSizesPix").set(sensorSizes); // (width, height)
+    ODoubleArrayProperty(userProps, "mvg_intrinsicInitialFocalLengthsPix").set(initialFocalLengths);
+    OUInt32ArrayProperty(userProps, "mvg_intrinsicParamsSize").set(paramsSize);
+    ODoubleArrayProperty(userProps, "mvg_intrinsicParams").set(params);
+    OUcharArrayProperty(userProps, "mvg_intrinsicLocked").set(locked);
+  }
+
+  if(flagsPart & ESfMData::EXTRINSICS)
+  {
+    // the transforms are stored as (rotation (row-major), center),
+    // without the Alembic camera orientation correction
+    const auto encodeTransform = [](const geometry::Pose3& pose, double* transform)
+    {
+      const Mat3& R = pose.rotation();
+      const Vec3& center = pose.center();
+      for(int i = 0; i < 9; ++i)
+        transform[i] = R(i / 3, i % 3);
+      for(int i = 0; i < 3; ++i)
+        transform[9 + i] = center(i);
+    };
+
+    // poses
+    {
+      std::vector<Poses::const_iterator> posesIts;
+      posesIts.reserve(sfmData.getPoses().size());
+      for(Poses::const_iterator it = sfmData.getPoses().begin(); it != sfmData.getPoses().end(); ++it)
+        posesIts.push_back(it);
+
+      const int nbPoses = static_cast<int>(posesIts.size());
+
+      std::vector<::uint32_t> poseIds(nbPoses);
+      std::vector<double> transforms(nbPoses * 12);
+      std::vector<Alembic::Util::uint8_t> locked(nbPoses);
+
+      #pragma omp parallel for
+      for(int i = 0; i < nbPoses; ++i)
+      {
+        poseIds[i] = posesIts[i]->first;
+        encodeTransform(posesIts[i]->second.getTransform(), &transforms[12 * i]);
+        locked[i] = posesIts[i]->second.isLocked();
+      }
+
+      OUInt32ArrayProperty(userProps, "mvg_poseIds").set(poseIds);
+      ODoubleArrayProperty(userProps, "mvg_poseTransforms").set(transforms);
+      OUcharArrayProperty(userProps, "mvg_poseLocked").set(locked);
+    }
+
+    // rigs
+    {
+      std::vector<::uint32_t> rigIds;
+      std::vector<::uint32_t> nbSubPoses;
+      std::vector<::uint32_t> subPosesStatus;
+      std::vector<double> subPosesTransforms;
+
+      for(const auto& rigPair : sfmData.getRigs())
+      {
+        rigIds.push_back(rigPair.first);
+        nbSubPoses.push_back(rigPair.second.getNbSubPoses());
+
+        for(const RigSubPose& subPose : rigPair.second.getSubPoses())
+        {
+          subPosesStatus.push_back(static_cast<::uint32_t>(subPose.status));
+          subPosesTransforms.resize(subPosesTransforms.size() + 12);
+          encodeTransform(subPose.pose, &subPosesTransforms[subPosesTransforms.size() - 12]);
+        }
+      }
+
+      OUInt32ArrayProperty(userProps, "mvg_rigIds").set(rigIds);
+      OUInt32ArrayProperty(userProps, "mvg_rigNbSubPoses").set(nbSubPoses);
+      OUInt32ArrayProperty(userProps, "mvg_rigSubPosesStatus").set(subPosesStatus);
+      ODoubleArrayProperty(userProps, "mvg_rigSubPosesTransforms").set(subPosesTransforms);
+    }
+  }
+
+  if(flagsPart & ESfMData::POSES_UNCERTAINTY)
+  {
+    std::vector<::uint32_t> poseIds;
+    std::vector<double> uncertainties;
+
+    for(const auto& uncertaintyPair : sfmData._posesUncertainty)
+    {
+      poseIds.push_back(uncertaintyPair.first);
+      uncertainties.insert(uncertainties.end(), uncertaintyPair.second.data(), uncertaintyPair.second.data() + 6);
+    }
+
+    OUInt32ArrayProperty(userProps, "mvg_uncertaintyPoseIds").set(poseIds);
+    ODoubleArrayProperty(userProps, "mvg_uncertaintyEigenValues").set(uncertainties);
+  }
+}
+
 void AlembicExporter::addCamera(const std::string& name,
                                 const View& view,
                                 const CameraPose* pose,
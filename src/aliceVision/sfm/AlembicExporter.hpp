@@ -37,8 +37,20 @@ public:
    * @brief Add SfM Data
    * @param[in] sfmdata SfMData container
    * @param[in] flagsPart filter the elements to add
+   * @param[in] camerasBatch if true, add the cameras with addSfMCamerasBatch
+   *            instead of one Alembic object per camera
    */
-  void addSfM(const sfm::SfMData& sfmdata, ESfMData flagsPart = ESfMData::ALL);
+  void addSfM(const sfm::SfMData& sfmdata, ESfMData flagsPart = ESfMData::ALL, bool camerasBatch = false);
+
+  /**
+   * @brief Add all the SfM views, intrinsics, poses and rigs in a single "mvgCamerasBatch" object.
+   *        Each field is stored as one array property for all the cameras,
+   *        which is much faster to write and read than the camera hierarchy
+   *        but cannot be displayed by DCC applications.
+   * @param[in] sfmData The input SfMData
+   * @param[in] flagsPart filter the elements to add
+   */
+  void addSfMCamerasBatch(const SfMData& sfmData, ESfMData flagsPart = ESfMData::ALL);
 
   /**
    * @brief Add a SfM single camera
@@ -553,12 +553,217 @@ bool readXform(IXform& xform, M44d& mat, sfm::SfMData& sfmData, sfm::ESfMData fl
   return true;
 }
 
+/**
+ * @brief Read the cameras batch object written by AlembicExporter::addSfMCamerasBatch
+ */
+bool readCamerasBatch(IObject iObj, sfm::SfMData& sfmData, sfm::ESfMData flagsPart)
+{
+  using namespace aliceVision::geometry;
+  using namespace aliceVision::camera;
+  using namespace aliceVision::sfm;
+
+  ICompoundProperty userProps = iObj.getProperties();
+  const index_t sampleFrame = 0;
+
+  const auto decodeTransform = [](const double* transform)
+  {
+    Mat3 R;
+    Vec3 center;
+    for(int i = 0; i < 9; ++i)
+      R(i / 3, i % 3) = transform[i];
+    for(int i = 0; i < 3; ++i)
+      center(i) = transform[9 + i];
+    return Pose3(R, center);
+  };
+
+  if((flagsPart & ESfMData::VIEWS) && userProps.getPropertyHeader("mvg_viewIds"))
+  {
+    std::vector<::uint32_t> viewIds;
+    std::vector<::uint32_t> poseIds;
+    std::vector<::uint32_t> intrinsicIds;
+    std::vector<::uint32_t> resectionIds;
+    std::vector<::uint32_t> rigIds;
+    std::vector<::uint32_t> subPoseIds;
+    std::vector<::uint32_t> sizes;
+    std::vector<std::string> imagePaths;
+    std::vector<::uint32_t> metadataSize;
+    std::vector<std::string> rawMetadata;
+
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewIds", sampleFrame, viewIds);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewPoseIds", sampleFrame, poseIds);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewIntrinsicIds", sampleFrame, intrinsicIds);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewResectionIds", sampleFrame, resectionIds);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewRigIds", sampleFrame, rigIds);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewSubPoseIds", sampleFrame, subPoseIds);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewSizes", sampleFrame, sizes);
+    getAbcArrayProp<IStringArrayProperty>(userProps, "mvg_viewImagePaths", sampleFrame, imagePaths);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_viewMetadataSize", sampleFrame, metadataSize);
+    getAbcArrayProp<IStringArrayProperty>(userProps, "mvg_viewMetadata", sampleFrame, rawMetadata);
+
+    const int nbViews = static_cast<int>(viewIds.size());
+
+    // first metadata index of each view
+    std::vector<std::size_t> metadataOffsets(nbViews + 1, 0);
+    for(int i = 0; i < nbViews; ++i)
+      metadataOffsets[i + 1] = metadataOffsets[i] + metadataSize.at(i);
+
+    if(rawMetadata.size() != 2 * metadataOffsets.back())
+    {
+      ALICEVISION_LOG_WARNING("ABC Error: views metadata size is " << rawMetadata.size() << ", " << 2 * metadataOffsets.back() << " expected.");
+      return false;
+    }
+
+    std::vector<std::shared_ptr<View>> views(nbViews);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbViews; ++i)
+    {
+      std::shared_ptr<View> view = std::make_shared<View>(imagePaths[i],
+                                                          viewIds[i],
+                                                          intrinsicIds[i],
+                                                          poseIds[i],
+                                                          sizes[2 * i],
+                                                          sizes[2 * i + 1],
+                                                          rigIds[i],
+                                                          subPoseIds[i]);
+      view->setResectionId(resectionIds[i]);
+
+      for(std::size_t m = 2 * metadataOffsets[i]; m < 2 * metadataOffsets[i + 1]; m += 2)
+        view->addMetadata(rawMetadata[m], rawMetadata[m + 1]);
+
+      views[i] = view;
+    }
+
+    for(const std::shared_ptr<View>& view : views)
+      sfmData.views[view->getViewId()] = view;
+  }
+
+  if((flagsPart & ESfMData::INTRINSICS) && userProps.getPropertyHeader("mvg_intrinsicIds"))
+  {
+    std::vector<::uint32_t> intrinsicIds;
+    std::vector<std::string> intrinsicTypes;
+    std::vector<::uint32_t> sensorSizes;
+    std::vector<double> initialFocalLengths;
+    std::vector<::uint32_t> paramsSize;
+    std::vector<double> params;
+    std::vector<Alembic::Util::uint8_t> locked;
+
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_intrinsicIds", sampleFrame, intrinsicIds);
+    getAbcArrayProp<IStringArrayProperty>(userProps, "mvg_intrinsicTypes", sampleFrame, intrinsicTypes);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_intrinsicSensorSizesPix", sampleFrame, sensorSizes);
+    getAbcArrayProp<IDoubleArrayProperty>(userProps, "mvg_intrinsicInitialFocalLengthsPix", sampleFrame, initialFocalLengths);
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_intrinsicParamsSize", sampleFrame, paramsSize);
+    getAbcArrayProp<IDoubleArrayProperty>(userProps, "mvg_intrinsicParams", sampleFrame, params);
+    getAbcArrayProp<IUcharArrayProperty>(userProps, "mvg_intrinsicLocked", sampleFrame, locked);
+
+    std::size_t paramIndex = 0;
+    for(std::size_t i = 0; i < intrinsicIds.size(); ++i)
+    {
+      std::shared_ptr<Pinhole> pinholeIntrinsic = createPinholeIntrinsic(EINTRINSIC_stringToEnum(intrinsicTypes.at(i)));
+
+      pinholeIntrinsic->setWidth(sensorSizes.at(2 * i));
+      pinholeIntrinsic->setHeight(sensorSizes.at(2 * i + 1));
+      pinholeIntrinsic->updateFromParams(std::vector<double>(params.begin() + paramIndex, params.begin() + paramIndex + paramsSize.at(i)));
+      pinholeIntrinsic->setInitialFocalLengthPix(initialFocalLengths.at(i));
+      paramIndex += paramsSize.at(i);
+
+      if(locked.at(i))
+        pinholeIntrinsic->lock();
+      else
+        pinholeIntrinsic->unlock();
+
+      sfmData.intrinsics[intrinsicIds.at(i)] = pinholeIntrinsic;
+    }
+  }
+
+  if((flagsPart & ESfMData::EXTRINSICS) && userProps.getPropertyHeader("mvg_poseIds"))
+  {
+    // poses
+    {
+      std::vector<::uint32_t> poseIds;
+      std::vector<double> transforms;
+      std::vector<Alembic::Util::uint8_t> locked;
+
+      getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_poseIds", sampleFrame, poseIds);
+      getAbcArrayProp<IDoubleArrayProperty>(userProps, "mvg_poseTransforms", sampleFrame, transforms);
+      getAbcArrayProp<IUcharArrayProperty>(userProps, "mvg_poseLocked", sampleFrame, locked);
+
+      if(transforms.size() != 12 * poseIds.size() || locked.size() != poseIds.size())
+      {
+        ALICEVISION_LOG_WARNING("ABC Error: invalid poses array sizes.");
+        return false;
+      }
+
+      for(std::size_t i = 0; i < poseIds.size(); ++i)
+        sfmData.getPoses()[poseIds[i]] = CameraPose(decodeTransform(&transforms[12 * i]), locked[i] != 0);
+    }
+
+    // rigs
+    {
+      std::vector<::uint32_t> rigIds;
+      std::vector<::uint32_t> nbSubPoses;
+      std::vector<::uint32_t> subPosesStatus;
+      std::vector<double> subPosesTransforms;
+
+      getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_rigIds", sampleFrame, rigIds);
+      getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_rigNbSubPoses", sampleFrame, nbSubPoses);
+      getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_rigSubPosesStatus", sampleFrame, subPosesStatus);
+      getAbcArrayProp<IDoubleArrayProperty>(userProps, "mvg_rigSubPosesTransforms", sampleFrame, subPosesTransforms);
+
+      if(subPosesTransforms.size() != 12 * subPosesStatus.size())
+      {
+        ALICEVISION_LOG_WARNING("ABC Error: invalid rigs array sizes.");
+        return false;
+      }
+
+      std::size_t subPoseIndex = 0;
+      for(std::size_t i = 0; i < rigIds.size(); ++i)
+      {
+        Rig rig(nbSubPoses.at(i));
+        for(IndexT subPoseId = 0; subPoseId < nbSubPoses.at(i); ++subPoseId, ++subPoseIndex)
+        {
+          rig.setSubPose(subPoseId, RigSubPose(decodeTransform(&subPosesTransforms.at(12 * subPoseIndex)),
+                                               static_cast<ERigSubPoseStatus>(subPosesStatus.at(subPoseIndex))));
+        }
+        sfmData.getRigs()[rigIds[i]] = rig;
+      }
+    }
+  }
+
+  if((flagsPart & ESfMData::POSES_UNCERTAINTY) && userProps.getPropertyHeader("mvg_uncertaintyPoseIds"))
+  {
+    std::vector<::uint32_t> poseIds;
+    std::vector<double> uncertainties;
+
+    getAbcArrayProp<IUInt32ArrayProperty>(userProps, "mvg_uncertaintyPoseIds", sampleFrame, poseIds);
+    getAbcArrayProp<IDoubleArrayProperty>(userProps, "mvg_uncertaintyEigenValues", sampleFrame, uncertainties);
+
+    if(uncertainties.size() != 6 * poseIds.size())
+    {
+      ALICEVISION_LOG_WARNING("ABC Error: invalid poses uncertainty array sizes.");
+      return false;
+    }
+
+    for(std::size_t i = 0; i < poseIds.size(); ++i)
+      sfmData._posesUncertainty[poseIds[i]] = Eigen::Map<const Vec6>(&uncertainties[6 * i]);
+  }
+
+  return true;
+}
+
 // Top down read of 3d objects
 void visitObject(IObject iObj, M44d mat, sfm::SfMData& sfmdata, sfm::ESfMData flagsPart, bool isReconstructed = true)
 {
   // ALICEVISION_LOG_DEBUG("ABC visit: " << iObj.getFullName());
   if(iObj.getName() == "mvgCamerasUndefined")
     isReconstructed = false;
+
+  // all the cameras are stored in the properties of this object, it has no children
+  if(iObj.getName() == "mvgCamerasBatch")
+  {
+    readCamerasBatch(iObj, sfmdata, flagsPart);
+    return;
+  }
   
   const MetaData& md = iObj.getMetaData();
   if(IPoints::matches(md) && (flagsPart & sfm::ESfMData::STRUCTURE))
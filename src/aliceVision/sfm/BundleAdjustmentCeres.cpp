@@ -6,76 +6,63 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 
 #include <ceres/rotation.h>
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 namespace aliceVision {
 namespace sfm {
 
 using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
-/// Create the appropriate cost functor according the provided input camera intrinsic model
+/// Create the appropriate cost function according the provided input camera intrinsic model
+/// (analytic Jacobians, see ResidualErrorFunctor.hpp for the equivalent autodiff functors)
 ceres::CostFunction * createCostFunctionFromIntrinsics(IntrinsicBase * intrinsic, const Vec2 & observation)
 {
   switch(intrinsic->getType())
   {
     case PINHOLE_CAMERA:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Pinhole, 2, 3, 6, 3>(
-        new ResidualErrorFunctor_Pinhole(observation.data()));
-    break;
+      return new ResidualErrorCostFunction_Pinhole(observation.data());
     case PINHOLE_CAMERA_RADIAL1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK1, 2, 4, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK1(observation.data()));
-    break;
+      return new ResidualErrorCostFunction_PinholeRadialK1(observation.data());
     case PINHOLE_CAMERA_RADIAL3:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK3, 2, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK3(observation.data()));
-    break;
+      return new ResidualErrorCostFunction_PinholeRadialK3(observation.data());
     case PINHOLE_CAMERA_BROWN:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeBrownT2, 2, 8, 6, 3>(
-        new ResidualErrorFunctor_PinholeBrownT2(observation.data()));
-    break;
+      return new ResidualErrorCostFunction_PinholeBrownT2(observation.data());
     case PINHOLE_CAMERA_FISHEYE:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye(observation.data()));
+      return new ResidualErrorCostFunction_PinholeFisheye(observation.data());
     case PINHOLE_CAMERA_FISHEYE1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye1(observation.data()));
+      return new ResidualErrorCostFunction_PinholeFisheye1(observation.data());
     default:
       throw std::logic_error("Unrecognized intrinsic type in BA.");
   }
 }
 
-/// Create the appropriate cost functor according the provided input rig camera intrinsic model
+/// Create the appropriate cost function according the provided input rig camera intrinsic model
 ceres::CostFunction * createRigCostFunctionFromIntrinsics(IntrinsicBase * intrinsic, const Vec2 & observation)
 {
   switch(intrinsic->getType())
   {
     case PINHOLE_CAMERA:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Pinhole, 2, 3, 6, 6, 3>(
-        new ResidualErrorFunctor_Pinhole(observation.data()));
-    break;
+      return new ResidualErrorRigCostFunction_Pinhole(observation.data());
     case PINHOLE_CAMERA_RADIAL1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK1, 2, 4, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK1(observation.data()));
-    break;
+      return new ResidualErrorRigCostFunction_PinholeRadialK1(observation.data());
     case PINHOLE_CAMERA_RADIAL3:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK3, 2, 6, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK3(observation.data()));
-    break;
+      return new ResidualErrorRigCostFunction_PinholeRadialK3(observation.data());
     case PINHOLE_CAMERA_BROWN:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeBrownT2, 2, 8, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeBrownT2(observation.data()));
-    break;
+      return new ResidualErrorRigCostFunction_PinholeBrownT2(observation.data());
     case PINHOLE_CAMERA_FISHEYE:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye(observation.data()));
+      return new ResidualErrorRigCostFunction_PinholeFisheye(observation.data());
     case PINHOLE_CAMERA_FISHEYE1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye1(observation.data()));
+      return new ResidualErrorRigCostFunction_PinholeFisheye1(observation.data());
     default:
       throw std::logic_error("Unrecognized intrinsic type in BA.");
   }
@@ -140,6 +127,83 @@ void addPose(ceres::Problem& problem,
   }
 }
 
+namespace {
+
+bool isSparseBAAvailable()
+{
+  return ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
+         ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::CX_SPARSE) ||
+         ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE);
+}
+
+/// Return the num. of threads to process nbBlocks blocks, each thread having at least minNbBlocksPerThread blocks
+unsigned int getNbThreads(std::size_t nbBlocks, std::size_t minNbBlocksPerThread, unsigned int maxNbThreads)
+{
+  const std::size_t nbThreads = nbBlocks / std::max<std::size_t>(1, minNbBlocksPerThread);
+  return static_cast<unsigned int>(std::max<std::size_t>(1, std::min<std::size_t>(nbThreads, maxNbThreads)));
+}
+
+} // namespace
+
+BundleAdjustmentCeres::BA_problemSize::BA_problemSize(const SfMData& sfmData)
+{
+  // dense indexes of the poses observing each landmark
+  HashMap<IndexT, std::size_t> poseIndexes;
+  std::vector<std::vector<std::size_t>> posesPerLandmark;
+  std::vector<std::vector<std::size_t>> landmarksPerPose;
+
+  posesPerLandmark.reserve(sfmData.getLandmarks().size());
+
+  for(const auto& landmarkIt : sfmData.getLandmarks())
+  {
+    std::vector<std::size_t> poses;
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const View& view = *sfmData.getViews().at(observationIt.first);
+      if(!sfmData.isPoseAndIntrinsicDefined(&view))
+        continue;
+
+      const auto poseIt = poseIndexes.emplace(view.getPoseId(), poseIndexes.size()).first;
+      if(poseIt->second == landmarksPerPose.size())
+        landmarksPerPose.emplace_back();
+      landmarksPerPose[poseIt->second].push_back(posesPerLandmark.size());
+      poses.push_back(poseIt->second);
+      ++_nbResidualBlocks;
+    }
+    posesPerLandmark.push_back(std::move(poses));
+  }
+
+  _nbPoses = sfmData.getPoses().size();
+  for(const auto& rigIt : sfmData.getRigs())
+    _nbPoses += rigIt.second.getNbSubPoses();
+  _nbLandmarks = sfmData.getLandmarks().size();
+
+  // count the distinct covisible pose pairs (i, j) with i < j,
+  // lastPose[j] == i if the pair has already been counted
+  std::vector<std::size_t> lastPose(landmarksPerPose.size(), landmarksPerPose.size());
+  for(std::size_t i = 0; i < landmarksPerPose.size(); ++i)
+  {
+    for(std::size_t landmark : landmarksPerPose[i])
+    {
+      for(std::size_t j : posesPerLandmark[landmark])
+      {
+        if(j > i && lastPose[j] != i)
+        {
+          lastPose[j] = i;
+          ++_nbCovisiblePosePairs;
+        }
+      }
+    }
+  }
+}
+
+double BundleAdjustmentCeres::BA_problemSize::getReducedCameraDensity() const
+{
+  if(_nbPoses < 2)
+    return 1.0;
+  return static_cast<double>(_nbCovisiblePosePairs) / (0.5 * _nbPoses * (_nbPoses - 1));
+}
+
 BundleAdjustmentCeres::BA_options::BA_options(const bool bVerbose, bool bmultithreaded)
   :_bVerbose(bVerbose)
 {
@@ -149,6 +213,9 @@ BundleAdjustmentCeres::BA_options::BA_options(const bool bVerbose, bool bmultith
   if (!bmultithreaded)
     _nbThreads = 1;
 
+  _nbJacobianThreads = _nbThreads;
+  _nbLinearSolverThreads = _nbThreads;
+
   _bCeres_Summary = false;
   
   // Use dense BA by default
@@ -193,6 +260,86 @@ void BundleAdjustmentCeres::BA_options::setSparseBA()
   }
 }
 
+void BundleAdjustmentCeres::BA_options::setIterativeBA()
+{
+  // The reduced camera system is never built,
+  // the conjugate gradients use its block diagonal as preconditioner
+  _preconditioner_type = ceres::SCHUR_JACOBI;
+  _linear_solver_type = ceres::ITERATIVE_SCHUR;
+  ALICEVISION_LOG_DEBUG("BundleAdjustmentCeres: ITERATIVE_SCHUR, SCHUR_JACOBI");
+}
+
+void BundleAdjustmentCeres::BA_options::setAdaptiveBA(const BA_problemSize& problemSize)
+{
+  const double density = problemSize.getReducedCameraDensity();
+
+  ALICEVISION_LOG_DEBUG("BundleAdjustmentCeres: problem size:\n"
+                        "\t- # poses: " << problemSize._nbPoses << "\n"
+                        "\t- # landmarks: " << problemSize._nbLandmarks << "\n"
+                        "\t- # residual blocks: " << problemSize._nbResidualBlocks << "\n"
+                        "\t- reduced camera system density: " << density);
+
+  if(problemSize._nbPoses <= _maxNbPosesDenseBA)
+    setDenseBA();
+  else if(isSparseBAAvailable() &&
+          (problemSize._nbPoses <= _maxNbPosesSparseBA || density <= _maxReducedCameraDensity))
+    setSparseBA();
+  else
+    setIterativeBA();
+
+  // The residuals & Jacobians are evaluated per residual block,
+  // the Schur elimination is done per landmark
+  _nbJacobianThreads = getNbThreads(problemSize._nbResidualBlocks, _minNbBlocksPerThread, _nbThreads);
+  _nbLinearSolverThreads = getNbThreads(problemSize._nbLandmarks, _minNbBlocksPerThread, _nbThreads);
+}
+
+void BundleAdjustmentCeres::BA_statistics::setFromSummary(const ceres::Solver::Summary& summary)
+{
+  _linearSolverType = summary.linear_solver_type_used;
+  _preconditionerType = summary.preconditioner_type_used;
+  _nbJacobianThreads = summary.num_threads_used;
+  _nbLinearSolverThreads = summary.num_linear_solver_threads_used;
+  _time = summary.total_time_in_seconds;
+  _jacobianEvaluationTime = summary.jacobian_evaluation_time_in_seconds;
+  _linearSolverTime = summary.linear_solver_time_in_seconds;
+
+  _iterations.clear();
+  _iterations.reserve(summary.iterations.size());
+  for(const ceres::IterationSummary& iterationSummary : summary.iterations)
+  {
+    BA_iterationStatistics iteration;
+    iteration._time = iterationSummary.iteration_time_in_seconds;
+    iteration._linearSolverTime = iterationSummary.step_solver_time_in_seconds;
+    iteration._cost = iterationSummary.cost;
+    iteration._nbLinearSolverIterations = iterationSummary.linear_solver_iterations;
+    iteration._isSuccessful = iterationSummary.step_is_successful;
+    _iterations.push_back(iteration);
+  }
+}
+
+void BundleAdjustmentCeres::BA_statistics::show() const
+{
+  std::ostringstream os;
+  os << "Bundle Adjustment solver statistics:\n"
+     << "\t- linear solver: " << ceres::LinearSolverTypeToString(_linearSolverType)
+     << " (" << ceres::PreconditionerTypeToString(_preconditionerType) << ")\n"
+     << "\t- # threads: " << _nbJacobianThreads << " (Jacobians), " << _nbLinearSolverThreads << " (linear solver)\n"
+     << "\t- time (s): " << _time << " (Jacobians: " << _jacobianEvaluationTime << ", linear solver: " << _linearSolverTime << ")\n"
+     << "\t- iterations:\n"
+     << "\t  iter   time (s)   solver (s)   solver iter   cost";
+
+  for(std::size_t i = 0; i < _iterations.size(); ++i)
+  {
+    const BA_iterationStatistics& iteration = _iterations[i];
+    os << "\n\t  " << std::setw(4) << i
+       << "   " << std::setw(8) << iteration._time
+       << "   " << std::setw(10) << iteration._linearSolverTime
+       << "   " << std::setw(11) << iteration._nbLinearSolverIterations
+       << "   " << iteration._cost << (iteration._isSuccessful ? "" : " (rejected)");
+  }
+  ALICEVISION_LOG_DEBUG(os.str());
+}
+
 
 BundleAdjustmentCeres::BundleAdjustmentCeres(
   BundleAdjustmentCeres::BA_options options)
@@ -424,7 +571,7 @@ void BundleAdjustmentCeres::createJacobian(SfMData & sfm_data, BA_Refine refineO
   double cost = 0.0;
   ceres::Problem::EvaluateOptions evalOpt;
   evalOpt.parameter_blocks = parameterBlocks;
-  evalOpt.num_threads = 8;
+  evalOpt.num_threads = _aliceVision_options._nbJacobianThreads;
   evalOpt.apply_loss_function = true;
 
   // create Jacobain
@@ -435,6 +582,8 @@ bool BundleAdjustmentCeres::Adjust(
   SfMData & sfm_data,     // the SfM scene to refine
   BA_Refine refineOptions)
 {
+  ALICEVISION_PROFILE_ZONE("BundleAdjustmentCeres::adjust");
+
   ceres::Problem problem;
   createProblem(sfm_data, refineOptions, problem);
 
@@ -446,8 +595,8 @@ bool BundleAdjustmentCeres::Adjust(
   options.sparse_linear_algebra_library_type = _aliceVision_options._sparse_linear_algebra_library_type;
   options.minimizer_progress_to_stdout = _aliceVision_options._bVerbose;
   options.logging_type = ceres::SILENT;
-  options.num_threads = _aliceVision_options._nbThreads;
-  options.num_linear_solver_threads = _aliceVision_options._nbThreads;
+  options.num_threads = _aliceVision_options._nbJacobianThreads;
+  options.num_linear_solver_threads = _aliceVision_options._nbLinearSolverThreads;
 
   // Solve BA
   ceres::Solver::Summary summary;
@@ -455,6 +604,8 @@ bool BundleAdjustmentCeres::Adjust(
   if (_aliceVision_options._bCeres_Summary)
     ALICEVISION_LOG_DEBUG(summary.FullReport());
 
+  _statistics.setFromSummary(summary);
+
   // If no error, get back refined parameters
   if (!summary.IsSolutionUsable())
   {
@@ -476,6 +627,7 @@ bool BundleAdjustmentCeres::Adjust(
       "\t- initial RMSE: " << std::sqrt( summary.initial_cost / summary.num_residuals) << "\n"
       "\t- final RMSE: " << std::sqrt( summary.final_cost / summary.num_residuals) << "\n"
       "\t- time (s): " << summary.total_time_in_seconds);
+    _statistics.show();
   }
 
   // Update camera poses with refined data
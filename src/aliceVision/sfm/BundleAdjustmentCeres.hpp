@@ -12,6 +12,8 @@
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
 #include <ceres/ceres.h>
 
+#include <vector>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -22,21 +24,86 @@ ceres::CostFunction * createRigCostFunctionFromIntrinsics(camera::IntrinsicBase
 class BundleAdjustmentCeres : public BundleAdjustment
 {
 public:
+  /// Size and sparsity of a bundle adjustment problem, used to select the solver
+  struct BA_problemSize
+  {
+    BA_problemSize() = default;
+
+    /// Compute the size of the bundle adjustment problem of all the reconstructed views
+    explicit BA_problemSize(const SfMData& sfmData);
+
+    std::size_t _nbPoses = 0;              ///< The num. of poses, i.e. the camera blocks of the reduced camera system
+    std::size_t _nbLandmarks = 0;          ///< The num. of landmarks, eliminated by the Schur complement
+    std::size_t _nbResidualBlocks = 0;     ///< The num. of observations
+    std::size_t _nbCovisiblePosePairs = 0; ///< The num. of pose pairs sharing a landmark, i.e. the off-diagonal blocks of the reduced camera system
+
+    /// Return the ratio of non-zero off-diagonal blocks in the reduced camera system
+    double getReducedCameraDensity() const;
+  };
+
   struct BA_options
   {
     bool _bVerbose;
-    unsigned int _nbThreads;
+    unsigned int _nbThreads;             ///< The max. num. of threads
+    unsigned int _nbJacobianThreads;     ///< The num. of threads for the residuals & Jacobians evaluation
+    unsigned int _nbLinearSolverThreads; ///< The num. of threads for the linear solver
     bool _bCeres_Summary;
     ceres::LinearSolverType _linear_solver_type;
     ceres::PreconditionerType _preconditioner_type;
     ceres::SparseLinearAlgebraLibraryType _sparse_linear_algebra_library_type;
 
+    // Adaptive solver selection (see setAdaptiveBA):
+    std::size_t _maxNbPosesDenseBA = 100;     ///< Max. num. of poses solved with DENSE_SCHUR
+    std::size_t _maxNbPosesSparseBA = 2000;   ///< Max. num. of poses always solved with SPARSE_SCHUR
+    double _maxReducedCameraDensity = 0.05;   ///< Max. reduced camera system density solved with SPARSE_SCHUR above _maxNbPosesSparseBA poses
+    std::size_t _minNbBlocksPerThread = 1000; ///< Min. num. of residual blocks (or landmarks) given to each thread
+
     BA_options(const bool bVerbose = true, bool bmultithreaded = true);
     void setDenseBA();
     void setSparseBA();
+    void setIterativeBA();
+
+    /**
+     * @brief Select the linear solver and the threads according to the problem size:
+     * - DENSE_SCHUR for small problems
+     * - SPARSE_SCHUR if a sparse library is available, up to _maxNbPosesSparseBA poses
+     *   or on a sparse reduced camera system (e.g. video sequences)
+     * - ITERATIVE_SCHUR with SCHUR_JACOBI otherwise, it never stores the reduced camera system
+     * @param[in] problemSize The size of the problem to solve
+     */
+    void setAdaptiveBA(const BA_problemSize& problemSize);
   };
+
+  /// Contains the statistics of a solver iteration
+  struct BA_iterationStatistics
+  {
+    double _time = 0.0;                ///< The iteration duration (s)
+    double _linearSolverTime = 0.0;    ///< The time spent to solve the linear system (s)
+    double _cost = 0.0;                ///< The cost at the end of the iteration
+    int _nbLinearSolverIterations = 0; ///< The num. of linear solver iterations (ITERATIVE_SCHUR)
+    bool _isSuccessful = false;        ///< The step has been accepted
+  };
+
+  /// Contains the solver informations relating to the last BA performed
+  struct BA_statistics
+  {
+    ceres::LinearSolverType _linearSolverType = ceres::DENSE_SCHUR;
+    ceres::PreconditionerType _preconditionerType = ceres::JACOBI;
+    int _nbJacobianThreads = 0;           ///< The num. of threads used for the Jacobians evaluation
+    int _nbLinearSolverThreads = 0;       ///< The num. of threads used by the linear solver
+    double _time = 0.0;                   ///< The spent time to solve the BA (s)
+    double _jacobianEvaluationTime = 0.0; ///< The spent time in the Jacobians evaluation (s)
+    double _linearSolverTime = 0.0;       ///< The spent time in the linear solver (s)
+    std::vector<BA_iterationStatistics> _iterations; ///< The statistics of each iteration
+
+    /// Fill the statistics from the Ceres summary
+    void setFromSummary(const ceres::Solver::Summary& summary);
+    void show() const;
+  };
+
 private:
     BA_options _aliceVision_options;
+    BA_statistics _statistics;
     // Data wrapper for refinement:
     HashMap<IndexT, std::vector<double> > map_poses;
     // Setup rig sub-poses
@@ -57,6 +124,12 @@ public:
   bool Adjust(
     SfMData & sfm_data,
     BA_Refine refineOptions = BA_REFINE_ALL);
+
+  /// Return the solver statistics of the last adjustment
+  const BA_statistics& getStatistics() const
+  {
+    return _statistics;
+  }
 };
 
 } // namespace sfm
@@ -0,0 +1,70 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DenseSfMData.hpp"
+
+namespace aliceVision {
+namespace sfm {
+
+const std::uint32_t DenseSfMData::UndefinedSlot;
+
+DenseSfMData::DenseSfMData(const SfMData& sfmData)
+{
+  // views
+  _viewIds.reserve(sfmData.getViews().size());
+  _posePerView.reserve(sfmData.getViews().size());
+  _intrinsicPerView.reserve(sfmData.getViews().size());
+
+  for(const auto& viewIt : sfmData.getViews())
+  {
+    const View* view = viewIt.second.get();
+    _slotPerViewId[viewIt.first] = static_cast<std::uint32_t>(_viewIds.size());
+    _viewIds.push_back(viewIt.first);
+
+    if(sfmData.isPoseAndIntrinsicDefined(view))
+    {
+      _posePerView.push_back(sfmData.getPose(*view).getTransform());
+      _intrinsicPerView.push_back(sfmData.getIntrinsics().at(view->getIntrinsicId()).get());
+    }
+    else
+    {
+      _posePerView.emplace_back();
+      _intrinsicPerView.push_back(nullptr);
+    }
+  }
+
+  // landmarks & observations
+  const Landmarks& landmarks = sfmData.getLandmarks();
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkIt : landmarks)
+    nbObservations += landmarkIt.second.observations.size();
+
+  _landmarkIds.reserve(landmarks.size());
+  _landmarkPositions.resize(3, landmarks.size());
+  _observationOffsets.reserve(landmarks.size() + 1);
+  _observationViews.reserve(nbObservations);
+  _observationPoints.resize(2, nbObservations);
+  _observationFeatures.reserve(nbObservations);
+
+  _observationOffsets.push_back(0);
+  for(const auto& landmarkIt : landmarks)
+  {
+    _landmarkPositions.col(_landmarkIds.size()) = landmarkIt.second.X;
+    _slotPerLandmarkId[landmarkIt.first] = static_cast<std::uint32_t>(_landmarkIds.size());
+    _landmarkIds.push_back(landmarkIt.first);
+
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      _observationPoints.col(_observationViews.size()) = observationIt.second.x;
+      _observationViews.push_back(getViewSlot(observationIt.first));
+      _observationFeatures.push_back(observationIt.second.id_feat);
+    }
+    _observationOffsets.push_back(_observationViews.size());
+  }
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,122 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfm/SfMData.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Dense and read-only index of a SfMData scene.
+ *
+ * The views and the landmarks are associated to contiguous slots (id -> slot remap),
+ * the pose (with its rig sub-pose) and the intrinsic of each view are resolved once
+ * and all the observations are stored in a single CSR array, grouped by landmark.
+ *
+ * The SfMData stays the owner of the scene: the index is built from it to be used by the
+ * algorithms visiting all the observations, without any map lookup or pose copy per observation.
+ * It must be rebuilt when the scene is modified.
+ */
+class DenseSfMData
+{
+public:
+  /// Slot of an id not present in the index
+  static const std::uint32_t UndefinedSlot = std::numeric_limits<std::uint32_t>::max();
+
+  /**
+   * @brief Build the index of the given scene
+   * @param[in] sfmData The scene, must outlive the index (the intrinsics are not copied)
+   */
+  explicit DenseSfMData(const SfMData& sfmData);
+
+  std::size_t getNbViews() const {return _viewIds.size();}
+  std::size_t getNbLandmarks() const {return _landmarkIds.size();}
+  std::size_t getNbObservations() const {return _observationViews.size();}
+
+  IndexT getViewId(std::uint32_t viewSlot) const {return _viewIds[viewSlot];}
+  IndexT getLandmarkId(std::uint32_t landmarkSlot) const {return _landmarkIds[landmarkSlot];}
+
+  /**
+   * @brief Get the slot of a view
+   * @return the view slot or UndefinedSlot
+   */
+  std::uint32_t getViewSlot(IndexT viewId) const
+  {
+    const auto it = _slotPerViewId.find(viewId);
+    return (it == _slotPerViewId.end()) ? UndefinedSlot : it->second;
+  }
+
+  /**
+   * @brief Get the slot of a landmark
+   * @return the landmark slot or UndefinedSlot
+   */
+  std::uint32_t getLandmarkSlot(IndexT landmarkId) const
+  {
+    const auto it = _slotPerLandmarkId.find(landmarkId);
+    return (it == _slotPerLandmarkId.end()) ? UndefinedSlot : it->second;
+  }
+
+  /**
+   * @brief Check if the view has a defined pose and intrinsic
+   * @param[in] viewSlot The view slot (can be UndefinedSlot)
+   */
+  bool isPoseAndIntrinsicDefined(std::uint32_t viewSlot) const
+  {
+    return viewSlot != UndefinedSlot && _intrinsicPerView[viewSlot] != nullptr;
+  }
+
+  /// Pose of a view with a defined pose and intrinsic (with its rig sub-pose)
+  const geometry::Pose3& getPose(std::uint32_t viewSlot) const {return _posePerView[viewSlot];}
+
+  /// Intrinsic of a view with a defined pose and intrinsic
+  const camera::IntrinsicBase* getIntrinsic(std::uint32_t viewSlot) const {return _intrinsicPerView[viewSlot];}
+
+  /// 3D position of a landmark
+  Vec3 getLandmarkPosition(std::uint32_t landmarkSlot) const {return _landmarkPositions.col(landmarkSlot);}
+
+  /// First observation of a landmark
+  std::size_t getObservationsBegin(std::uint32_t landmarkSlot) const {return _observationOffsets[landmarkSlot];}
+
+  /// End of the observations of a landmark
+  std::size_t getObservationsEnd(std::uint32_t landmarkSlot) const {return _observationOffsets[landmarkSlot + 1];}
+
+  /// View slot of an observation (UndefinedSlot if the view is not in the scene)
+  std::uint32_t getObservationView(std::size_t observation) const {return _observationViews[observation];}
+
+  /// 2D point of an observation
+  Vec2 getObservationPoint(std::size_t observation) const {return _observationPoints.col(observation);}
+
+  /// Feature id of an observation
+  IndexT getObservationFeature(std::size_t observation) const {return _observationFeatures[observation];}
+
+private:
+  // Views
+  std::vector<IndexT> _viewIds;
+  HashMap<IndexT, std::uint32_t> _slotPerViewId;
+  std::vector<geometry::Pose3> _posePerView;
+  std::vector<const camera::IntrinsicBase*> _intrinsicPerView;
+
+  // Landmarks
+  std::vector<IndexT> _landmarkIds;
+  HashMap<IndexT, std::uint32_t> _slotPerLandmarkId;
+  Mat3X _landmarkPositions;
+
+  // Observations (CSR: the observations of the landmark i are in [_observationOffsets[i], _observationOffsets[i+1]))
+  std::vector<std::size_t> _observationOffsets;
+  std::vector<std::uint32_t> _observationViews;
+  Mat2X _observationPoints;
+  std::vector<IndexT> _observationFeatures;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -11,10 +11,13 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/geometry/HalfPlane.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <numeric>
 
 namespace aliceVision {
 namespace sfm {
@@ -23,6 +26,108 @@ using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 using namespace aliceVision::geometry::halfPlane;
 
+namespace {
+
+/**
+ * @brief Bounding volume hierarchy of axis-aligned boxes
+ */
+class BoxTree
+{
+public:
+
+  void build(const std::vector<Eigen::AlignedBox3d> & boxes)
+  {
+    _boxes = &boxes;
+    _nodes.clear();
+    _items.resize(boxes.size());
+    std::iota(_items.begin(), _items.end(), 0);
+    if (!boxes.empty())
+      buildNode(0, _items.size());
+  }
+
+  /// Call f(index) for each box overlapping the query box
+  template <typename F>
+  void query(const Eigen::AlignedBox3d & box, F f) const
+  {
+    if (_nodes.empty())
+      return;
+    std::vector<int> stack(1, 0);
+    while (!stack.empty())
+    {
+      const Node & node = _nodes[stack.back()];
+      stack.pop_back();
+      if (!node.box.intersects(box))
+        continue;
+      if (node.left < 0)
+      {
+        for (std::size_t k = node.begin; k < node.end; ++k)
+          if ((*_boxes)[_items[k]].intersects(box))
+            f(_items[k]);
+      }
+      else
+      {
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+      }
+    }
+  }
+
+private:
+
+  struct Node
+  {
+    Eigen::AlignedBox3d box;
+    /// children nodes, -1 for a leaf
+    int left = -1;
+    int right = -1;
+    /// range of the leaf items
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  static const std::size_t maxLeafSize = 4;
+
+  int buildNode(std::size_t begin, std::size_t end)
+  {
+    const int nodeIndex = _nodes.size();
+    _nodes.emplace_back();
+
+    Eigen::AlignedBox3d box;
+    Eigen::AlignedBox3d centers;
+    for (std::size_t k = begin; k < end; ++k)
+    {
+      box.extend((*_boxes)[_items[k]]);
+      centers.extend((*_boxes)[_items[k]].center());
+    }
+    _nodes[nodeIndex].box = box;
+    _nodes[nodeIndex].begin = begin;
+    _nodes[nodeIndex].end = end;
+
+    if (end - begin <= maxLeafSize)
+      return nodeIndex;
+
+    // median split along the largest extent of the box centers
+    int axis;
+    centers.sizes().maxCoeff(&axis);
+    const std::size_t middle = begin + (end - begin) / 2;
+    std::nth_element(_items.begin() + begin, _items.begin() + middle, _items.begin() + end,
+      [&](int a, int b) { return (*_boxes)[a].center()(axis) < (*_boxes)[b].center()(axis); });
+
+    // no reference on _nodes: it grows while building the children
+    const int left = buildNode(begin, middle);
+    const int right = buildNode(middle, end);
+    _nodes[nodeIndex].left = left;
+    _nodes[nodeIndex].right = right;
+    return nodeIndex;
+  }
+
+  const std::vector<Eigen::AlignedBox3d> * _boxes = nullptr;
+  std::vector<Node> _nodes;
+  std::vector<int> _items;
+};
+
+} // namespace
+
 // Constructor
 FrustumFilter::FrustumFilter(const SfMData & sfm_data,
   const double zNear, const double zFar)
@@ -71,37 +176,75 @@ void FrustumFilter::initFrustum(const SfMData & sfm_data)
 
 PairSet FrustumFilter::getFrustumIntersectionPairs() const
 {
-  PairSet pairs;
-  // List active view Id
+  // List the views with a frustum, sorted to get the pairs in (smallest, largest) view id order
   std::vector<IndexT> viewIds;
-  viewIds.reserve(z_near_z_far_perView.size());
-  std::transform(z_near_z_far_perView.begin(), z_near_z_far_perView.end(),
+  viewIds.reserve(frustum_perView.size());
+  std::transform(frustum_perView.begin(), frustum_perView.end(),
     std::back_inserter(viewIds), stl::RetrieveKey());
+  std::sort(viewIds.begin(), viewIds.end());
+
+  std::vector<const Frustum*> frustums;
+  frustums.reserve(viewIds.size());
+  bool allTruncated = true;
+  for (const IndexT viewId : viewIds)
+  {
+    frustums.push_back(&frustum_perView.at(viewId));
+    allTruncated = allTruncated && frustums.back()->isTruncated();
+  }
+
+  // The truncated frustums are bounded: only test the pairs whose bounding boxes overlap.
+  // The infinite frustums can't be pruned, all the pairs are tested.
+  std::vector<Eigen::AlignedBox3d> boxes;
+  BoxTree boxTree;
+  if (allTruncated)
+  {
+    boxes.resize(frustums.size());
+    for (std::size_t i = 0; i < frustums.size(); ++i)
+    {
+      for (const Vec3 & point : frustums[i]->frustum_points())
+        boxes[i].extend(point);
+      // margin for the tolerance of the exact intersection test
+      const double margin = 1e-6 * boxes[i].diagonal().norm();
+      boxes[i].extend(boxes[i].min() - Vec3::Constant(margin));
+      boxes[i].extend(boxes[i].max() + Vec3::Constant(margin));
+    }
+    boxTree.build(boxes);
+  }
 
   boost::progress_display my_progress_bar(
-    viewIds.size() * (viewIds.size()-1)/2,
+    viewIds.size(),
     std::cout, "\nCompute frustum intersection\n");
 
-  // Exhaustive comparison (use the fact that the intersect function is symmetric)
-  #pragma omp parallel for
+  // intersecting pairs found by each thread
+  std::vector<PairVec> pairsPerThread(omp_get_max_threads());
+
+  // Use the fact that the intersect function is symmetric: only test the pairs (i, j > i)
+  #pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < (int)viewIds.size(); ++i)
   {
-    for (size_t j = i+1; j < viewIds.size(); ++j)
+    PairVec & threadPairs = pairsPerThread[omp_get_thread_num()];
+    const auto testPair = [&](int j)
     {
-      if (frustum_perView.at(viewIds[i]).intersect(frustum_perView.at(viewIds[j])))
-      {
-        #pragma omp critical
-        {
-          pairs.insert(std::make_pair(viewIds[i], viewIds[j]));
-        }
-      }
-      // Progress bar update
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-      }
+      if (j > i && frustums[i]->intersect(*frustums[j]))
+        threadPairs.emplace_back(viewIds[i], viewIds[j]);
+    };
+
+    if (allTruncated)
+      boxTree.query(boxes[i], testPair);
+    else
+      for (int j = i + 1; j < (int)viewIds.size(); ++j)
+        testPair(j);
+
+    // Progress bar update
+    #pragma omp critical
+    {
+      ++my_progress_bar;
     }
   }
+
+  PairSet pairs;
+  for (const PairVec & threadPairs : pairsPerThread)
+    pairs.insert(threadPairs.begin(), threadPairs.end());
   return pairs;
 }
 
@@ -28,7 +28,11 @@ public:
   // Init a frustum for each valid views of the SfM scene
   void initFrustum(const SfMData & sfm_data);
 
+  // Return the frustum of each valid view
+  const FrustumsT & getFrustums() const { return frustum_perView; }
+
   // Return intersecting View frustum pairs
+  // (truncated frustums: only the pairs with overlapping bounding boxes are tested)
   PairSet getFrustumIntersectionPairs() const;
 
   // Export defined frustum in PLY file for viewing
@@ -56,6 +56,7 @@ void LocalBundleAdjustmentCeres::LocalBA_statistics::show()
                         << "|- initial RMSE = " << _RMSEinitial << "\n"
                         << "|- final RMSE = " << _RMSEfinal << "\n"
                         << "---------------------------------------");
+  _solverStatistics.show();
 }
 
 LocalBundleAdjustmentCeres::LocalBundleAdjustmentCeres(const LocalBundleAdjustmentData& localBA_data,
@@ -102,12 +103,25 @@ bool LocalBundleAdjustmentCeres::Adjust(SfMData& sfm_data, const LocalBundleAdju
   ceres::LossFunction * p_LossFunction = new ceres::HuberLoss(Square(4.0));
   // TODO: make the LOSS function and the parameter an option
   
+  // In Local BA, only the landmarks of the active region have residuals
+  std::vector<IndexT> landmarkIds;
+  if (_LBAOptions.isLocalBAEnabled())
+  {
+    landmarkIds = localBA_data.getActiveLandmarks();
+  }
+  else
+  {
+    landmarkIds.reserve(sfm_data.structure.size());
+    for(const auto& landmarkIt: sfm_data.structure)
+      landmarkIds.push_back(landmarkIt.first);
+  }
+
   // For all visibility add reprojections errors:
-  for(auto& landmarkIt: sfm_data.structure)
+  for(const IndexT landmarkId: landmarkIds)
   {             
-    IndexT landmarkId = landmarkIt.first;
+    Landmark& landmark = sfm_data.structure.at(landmarkId);
     
-    const Observations & observations = landmarkIt.second.observations;
+    const Observations & observations = landmark.observations;
     // Iterate over 2D observation associated to the 3D landmark
     for (const auto& observationIt: observations)
     {
@@ -139,7 +153,7 @@ bool LocalBundleAdjustmentCeres::Adjust(SfMData& sfm_data, const LocalBundleAdju
         // Needed parameters to create a residual block (K, pose & landmark)
         double* intrinsicBlock = &map_intrinsicsBlocks[intrinsicId][0];
         double* poseBlock = &map_posesBlocks[poseId][0];
-        double* landmarkBlock = landmarkIt.second.X.data();
+        double* landmarkBlock = landmark.X.data();
         
         // Apply a specific parameter ordering: 
         if (_LBAOptions.isParameterOrderingEnabled()) 
@@ -199,6 +213,7 @@ bool LocalBundleAdjustmentCeres::Adjust(SfMData& sfm_data, const LocalBundleAdju
   _LBAStatistics._numResidualBlocks = summary.num_residuals;
   _LBAStatistics._RMSEinitial = std::sqrt( summary.initial_cost / summary.num_residuals);
   _LBAStatistics._RMSEfinal = std::sqrt( summary.final_cost / summary.num_residuals);
+  _LBAStatistics._solverStatistics.setFromSummary(summary);
   
   _LBAStatistics.show();
   
@@ -228,6 +243,7 @@ bool LocalBundleAdjustmentCeres::exportStatistics(const std::string& dir, const
     // If the file does't exist: add a header.
     std::vector<std::string> header;
     header.push_back("Time/BA(s)");
+    header.push_back("JacobianTime(s)"); header.push_back("LinearSolverTime(s)");
     header.push_back("RefinedPose"); header.push_back("ConstPose");  header.push_back("IgnoredPose");
     header.push_back("RefinedPts");  header.push_back("ConstPts");   header.push_back("IgnoredPts");
     header.push_back("RefinedK");    header.push_back("ConstK");     header.push_back("IgnoredK");
@@ -258,6 +274,8 @@ bool LocalBundleAdjustmentCeres::exportStatistics(const std::string& dir, const
   }
   
   os << _LBAStatistics._time << "\t"
+     << _LBAStatistics._solverStatistics._jacobianEvaluationTime << "\t"
+     << _LBAStatistics._solverStatistics._linearSolverTime << "\t"
         
      << _LBAStatistics._numRefinedPoses << "\t"
      << _LBAStatistics._numConstantPoses << "\t"
@@ -422,8 +440,8 @@ void LocalBundleAdjustmentCeres::setSolverOptions(ceres::Solver::Options& solver
   solver_options.sparse_linear_algebra_library_type = _LBAOptions._sparse_linear_algebra_library_type;
   solver_options.minimizer_progress_to_stdout = _LBAOptions._bVerbose;
   solver_options.logging_type = ceres::SILENT;
-  solver_options.num_threads = _LBAOptions._nbThreads;
-  solver_options.num_linear_solver_threads = _LBAOptions._nbThreads;
+  solver_options.num_threads = _LBAOptions._nbJacobianThreads;
+  solver_options.num_linear_solver_threads = _LBAOptions._nbLinearSolverThreads;
 }
 
 bool LocalBundleAdjustmentCeres::solveBA(
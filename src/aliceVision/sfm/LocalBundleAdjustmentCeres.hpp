@@ -70,6 +70,8 @@ public:
     std::map<int, std::size_t> _numCamerasPerDistance; ///< The distribution of the cameras for each graph distance <distance, numOfCam>
     
     std::set<IndexT> _newViewsId;               ///< The index of the new views (newly resected)
+
+    BundleAdjustmentCeres::BA_statistics _solverStatistics; ///< The linear solver, threads & per-iteration timings
     
     void show();
   };
@@ -9,9 +9,8 @@
 
 #include <boost/filesystem.hpp>
 
-#include <lemon/bfs.h>
-
 #include <fstream>
+#include <queue>
 
 namespace fs = boost::filesystem;
 
@@ -42,6 +41,10 @@ std::map<int, std::size_t> LocalBundleAdjustmentData::getDistancesHistogram() co
     else
       hist.at(x.second)++;
   }
+
+  // the views not reached by the graph-distances computation
+  if (!_mapDistancePerViewId.empty() && _mapNodePerViewId.size() > _mapDistancePerViewId.size())
+    hist[-1] = _mapNodePerViewId.size() - _mapDistancePerViewId.size();
   
   return hist;
 }
@@ -50,27 +53,24 @@ void LocalBundleAdjustmentData::setAllParametersToRefine(const SfMData& sfm_data
 {
   _mapDistancePerViewId.clear();
   _mapDistancePerPoseId.clear();
-  _mapLBAStatePerPoseId.clear();
-  _mapLBAStatePerIntrinsicId.clear();
-  _mapLBAStatePerLandmarkId.clear();
-  resetParametersCounter();
+  resetStates();
   
   // -- Poses
   for (Poses::const_iterator itPose = sfm_data.getPoses().begin(); itPose != sfm_data.getPoses().end(); ++itPose)
   {
-    _mapLBAStatePerPoseId[itPose->first] = EState::refined;
+    _posesState.set(itPose->first, EState::refined);
     _parametersCounter.at(std::make_pair(EParameter::pose, EState::refined))++;
   }
   // -- Instrinsics
   for(const auto& itIntrinsic: sfm_data.getIntrinsics())
   {
-    _mapLBAStatePerIntrinsicId[itIntrinsic.first] = EState::refined;
+    _intrinsicsState.set(itIntrinsic.first, EState::refined);
     _parametersCounter.at(std::make_pair(EParameter::intrinsic, EState::refined))++;
   }
   // -- Landmarks
   for(const auto& itLandmark: sfm_data.structure)
   {
-    _mapLBAStatePerLandmarkId[itLandmark.first] = EState::refined;
+    _landmarksState.set(itLandmark.first, EState::refined);
     _parametersCounter.at(std::make_pair(EParameter::landmark, EState::refined))++;
   }
 }
@@ -158,9 +158,9 @@ bool LocalBundleAdjustmentData::removeViewsToTheGraph(const std::set<IndexT>& re
     auto it = _mapNodePerViewId.find(viewId);
     if (it != _mapNodePerViewId.end())
     {
+      _viewIdPerNode.at(_graph.id(it->second)) = UndefinedIndexT;
       _graph.erase(it->second); // this function erase a node with its incident arcs
-      _mapNodePerViewId.erase(it->first);
-      _mapViewIdPerNode.erase(it->second);
+      _mapNodePerViewId.erase(it);
 
       numRemovedNode++;
       ALICEVISION_LOG_DEBUG("The view #" << viewId << " has been successfully removed to the distance graph.");
@@ -174,22 +174,16 @@ bool LocalBundleAdjustmentData::removeViewsToTheGraph(const std::set<IndexT>& re
 
 int LocalBundleAdjustmentData::getPoseDistance(const IndexT poseId) const
 {
-  if (_mapDistancePerPoseId.find(poseId) == _mapDistancePerPoseId.end())
-  {
-    ALICEVISION_LOG_DEBUG("The pose #" << poseId << " does not exist in the '_mapDistancePerPoseId' (map size: " << _mapDistancePerPoseId.size() << ") \n");
-    return -1;
-  }
-  return _mapDistancePerPoseId.at(poseId);
+  // the poses not reached by the graph-distances computation are not stored
+  const auto it = _mapDistancePerPoseId.find(poseId);
+  return (it == _mapDistancePerPoseId.end()) ? -1 : it->second;
 }
 
 int LocalBundleAdjustmentData::getViewDistance(const IndexT viewId) const
 {
-  if (_mapDistancePerViewId.find(viewId) == _mapDistancePerViewId.end())
-  {
-    ALICEVISION_LOG_DEBUG("Cannot get the graph-distance of the view #" << viewId << ": does not exist in the '_mapDistancePerViewId':\n");
-    return -1;
-  }
-  return _mapDistancePerViewId.at(viewId);
+  // the views not reached by the graph-distances computation are not stored
+  const auto it = _mapDistancePerViewId.find(viewId);
+  return (it == _mapDistancePerViewId.end()) ? -1 : it->second;
 }
 
 void LocalBundleAdjustmentData::resetParametersCounter()
@@ -206,6 +200,14 @@ void LocalBundleAdjustmentData::resetParametersCounter()
   _parametersCounter[std::make_pair(EParameter::landmark, EState::ignored)] = 0;
 }
 
+void LocalBundleAdjustmentData::resetStates()
+{
+  _posesState.reset();
+  _intrinsicsState.reset();
+  _landmarksState.reset();
+  resetParametersCounter();
+}
+
 void LocalBundleAdjustmentData::updateGraphWithNewViews(
     const SfMData& sfm_data, 
     const track::TracksPerView& map_tracksPerView,
@@ -259,8 +261,12 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
     }
      
     lemon::ListGraph::Node newNode = _graph.addNode();
-    _mapNodePerViewId[viewId] = newNode;  
-    _mapViewIdPerNode[newNode] = viewId;
+    _mapNodePerViewId[viewId] = newNode;
+    // lemon reuses the ids of the erased nodes
+    const std::size_t nodeId = _graph.id(newNode);
+    if (nodeId >= _viewIdPerNode.size())
+      _viewIdPerNode.resize(nodeId + 1, UndefinedIndexT);
+    _viewIdPerNode[nodeId] = viewId;
     ++nbAddedNodes;
   }
   
@@ -295,62 +301,81 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
 void LocalBundleAdjustmentData::computeGraphDistances(const SfMData& sfm_data, const std::set<IndexT>& newReconstructedViews)
 { 
   ALICEVISION_LOG_DEBUG("Computing graph-distances...");
-  // reset the maps
+  // reset the maps & the distances of the nodes reached by the previous computation
   _mapDistancePerViewId.clear();
   _mapDistancePerPoseId.clear();
-  
-  // -- Setup Breadth First Search using Lemon
-  lemon::Bfs<lemon::ListGraph> bfs(_graph);
-  bfs.init();
-  
+  for (int nodeId : _reachedNodes)
+    _distancePerNode[nodeId] = -1;
+  _reachedNodes.clear();
+  _distancePerNode.resize(_graph.maxNodeId() + 1, -1);
+
+  // -- Breadth First Search from the new views.
+  // The views farther than D+1 are ignored by the Local BA: the visit is stopped at this distance,
+  // so its cost only depends on the size of the active region.
+  const int maxDistance = static_cast<int>(_graphDistanceLimit) + 1;
+  std::queue<lemon::ListGraph::Node> nodesToVisit;
+
   // -- Add source views for the bfs visit of the _graph
   for(const IndexT viewId: newReconstructedViews)
   {
     auto it = _mapNodePerViewId.find(viewId);
     if (it == _mapNodePerViewId.end())
+    {
       ALICEVISION_LOG_WARNING("The reconstructed view #" << viewId << " cannot be added as source for the BFS: does not exist in the graph.");
-    else
-      bfs.addSource(it->second);
+      continue;
+    }
+    const int nodeId = _graph.id(it->second);
+    if (_distancePerNode[nodeId] == 0)
+      continue;
+    _distancePerNode[nodeId] = 0;
+    _reachedNodes.push_back(nodeId);
+    nodesToVisit.push(it->second);
   }
-  bfs.start();
-  
-  // -- Handle bfs results (distances)
-  for(const auto& x : _mapNodePerViewId) // each node in the graph
+
+  while (!nodesToVisit.empty())
   {
-    auto& node = x.second;
-    int d = -1; 
-    
-    if (bfs.reached(node))
+    const lemon::ListGraph::Node node = nodesToVisit.front();
+    nodesToVisit.pop();
+
+    const int dist = _distancePerNode[_graph.id(node)];
+    if (dist >= maxDistance)
+      continue;
+
+    for (lemon::ListGraph::IncEdgeIt e(_graph, node); e != lemon::INVALID; ++e)
     {
-      d = bfs.dist(node);
-      // dist(): "If node v is not reached from the root(s), then the return value of this function is undefined."
-      // This is why the distance is previously set to -1.
+      const lemon::ListGraph::Node neighbor = _graph.oppositeNode(node, e);
+      const int neighborId = _graph.id(neighbor);
+      if (_distancePerNode[neighborId] != -1) // already reached
+        continue;
+      _distancePerNode[neighborId] = dist + 1;
+      _reachedNodes.push_back(neighborId);
+      nodesToVisit.push(neighbor);
     }
-    _mapDistancePerViewId[x.first] = d;
   }
-  
-  // -- Re-mapping from <ViewId, distance> to <PoseId, distance>:
-  for(auto x: _mapDistancePerViewId)
+
+  // -- Handle bfs results (distances)
+  for (int nodeId : _reachedNodes)
   {
-    // Get the poseId of the camera no. viewId
-    IndexT idPose = sfm_data.getViews().at(x.first)->getPoseId(); // PoseId of a resected camera
+    const IndexT viewId = _viewIdPerNode[nodeId];
+    const int dist = _distancePerNode[nodeId];
+    _mapDistancePerViewId[viewId] = dist;
+
+    // Re-mapping from <ViewId, distance> to <PoseId, distance>:
+    IndexT idPose = sfm_data.getViews().at(viewId)->getPoseId(); // PoseId of a resected camera
     
     auto poseIt = _mapDistancePerPoseId.find(idPose);
     // If multiple views share the same pose
     if(poseIt != _mapDistancePerPoseId.end())
-      poseIt->second = std::min(poseIt->second, x.second);
+      poseIt->second = std::min(poseIt->second, dist);
     else
-      _mapDistancePerPoseId[idPose] = x.second;
+      _mapDistancePerPoseId[idPose] = dist;
   } 
 }
 
-void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_data)
+void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_data, const track::TracksPerView& map_tracksPerView)
 {
-  // reset the maps
-  _mapLBAStatePerPoseId.clear();
-  _mapLBAStatePerIntrinsicId.clear();
-  _mapLBAStatePerLandmarkId.clear();
-  resetParametersCounter();
+  // reset the states
+  resetStates();
   
   const std::size_t kWindowSize = 25;   // nb of the last value in which compute the variation
   const double kStdevPercentage = 1.0;  // limit percentage of the Std deviation according to the range of all the parameters (e.i. focal)
@@ -372,26 +397,26 @@ void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_
   //    - Refined <=> its connected to a refined camera
   // ----------------------------------------------------
   // -- Poses
-  for (Poses::const_iterator itPose = sfm_data.getPoses().begin(); itPose != sfm_data.getPoses().end(); ++itPose)
+  // The poses not reached by the graph-distances computation are ignored.
+  for (const auto& x : _mapDistancePerPoseId)
   {
-    const IndexT poseId = itPose->first;
-    int dist = getPoseDistance(poseId);
+    const IndexT poseId = x.first;
+    int dist = x.second;
     if (dist >= 0 && dist <= _graphDistanceLimit) // [0; D]
     {
-      _mapLBAStatePerPoseId[poseId] = EState::refined;
+      _posesState.set(poseId, EState::refined);
       _parametersCounter.at(std::make_pair(EParameter::pose, EState::refined))++;
     }
     else if (dist == _graphDistanceLimit + 1)  // {D+1}
     {
-      _mapLBAStatePerPoseId[poseId] = EState::constant;
+      _posesState.set(poseId, EState::constant);
       _parametersCounter.at(std::make_pair(EParameter::pose, EState::constant))++;
     }
-    else // [-inf; 0[ U [D+2; +inf.[  (-1: not connected to the new views)
-    {
-      _mapLBAStatePerPoseId[poseId] = EState::ignored;
-      _parametersCounter.at(std::make_pair(EParameter::pose, EState::ignored))++;
-    }
   }
+  // [-inf; 0[ U [D+2; +inf.[  (-1: not connected to the new views)
+  _parametersCounter.at(std::make_pair(EParameter::pose, EState::ignored)) = sfm_data.getPoses().size()
+      - _parametersCounter.at(std::make_pair(EParameter::pose, EState::refined))
+      - _parametersCounter.at(std::make_pair(EParameter::pose, EState::constant));
   
   // -- Instrinsics
   checkFocalLengthsConsistency(kWindowSize, kStdevPercentage); 
@@ -400,38 +425,43 @@ void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_
   {
     if (isFocalLengthConstant(itIntrinsic.first))
     {
-      _mapLBAStatePerIntrinsicId[itIntrinsic.first] = EState::constant;
+      _intrinsicsState.set(itIntrinsic.first, EState::constant);
       _parametersCounter.at(std::make_pair(EParameter::intrinsic, EState::constant))++;
     }
     else
     {
-      _mapLBAStatePerIntrinsicId[itIntrinsic.first] = EState::refined;
+      _intrinsicsState.set(itIntrinsic.first, EState::refined);
       _parametersCounter.at(std::make_pair(EParameter::intrinsic, EState::refined))++;
     }
   }
   
   // -- Landmarks
-  for(const auto& itLandmark: sfm_data.structure)
+  // Only the landmarks observed by a refined view can be refined: visit their tracks.
+  for(const auto& x : _mapDistancePerViewId)
   {
-    const IndexT landmarkId = itLandmark.first;
-    const Observations & observations = itLandmark.second.observations;
-    
-    _mapLBAStatePerLandmarkId[landmarkId] = EState::ignored;
-    _parametersCounter.at(std::make_pair(EParameter::landmark, EState::ignored))++;
-    
-    
-    for(const auto& observationIt: observations)
+    const IndexT viewId = x.first;
+    int dist = x.second;
+    if (dist < 0 || dist > _graphDistanceLimit) // not in [0; D]
+      continue;
+
+    const auto tracksIt = map_tracksPerView.find(viewId);
+    if (tracksIt == map_tracksPerView.end())
+      continue;
+
+    for(const std::size_t trackId : tracksIt->second)
     {
-      int dist = getViewDistance(observationIt.first);
-      if(dist >= 0 && dist <= _graphDistanceLimit) // [0; D]
-      {
-        _mapLBAStatePerLandmarkId[landmarkId] = EState::refined;
-        _parametersCounter.at(std::make_pair(EParameter::landmark, EState::refined))++;
-        _parametersCounter.at(std::make_pair(EParameter::landmark, EState::ignored))--;
-        break;
-      }
+      const auto landmarkIt = sfm_data.structure.find(trackId);
+      if (landmarkIt == sfm_data.structure.end() // not reconstructed
+          || _landmarksState.get(trackId) == EState::refined // already visited
+          || landmarkIt->second.observations.find(viewId) == landmarkIt->second.observations.end()) // not observed by the view
+        continue;
+
+      _landmarksState.set(trackId, EState::refined);
+      _parametersCounter.at(std::make_pair(EParameter::landmark, EState::refined))++;
     }
   }
+  _parametersCounter.at(std::make_pair(EParameter::landmark, EState::ignored)) = sfm_data.structure.size()
+      - _parametersCounter.at(std::make_pair(EParameter::landmark, EState::refined));
 }
 
 std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerImagesPair(
@@ -441,30 +471,19 @@ std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerIm
 {
   std::map<Pair, std::size_t> map_imagesPair_nbSharedLandmarks;
   
-  // Get landmarks id. of all the reconstructed 3D points (: landmarks)
-  // TODO: avoid copy and use boost::transform_iterator
-  std::set<IndexT> landmarkIds;
-  std::transform(sfm_data.getLandmarks().begin(), sfm_data.getLandmarks().end(),
-                 std::inserter(landmarkIds, landmarkIds.begin()),
-                 stl::RetrieveKey());
-  
   for(const auto& viewId: newViewsId)
   {
     // Get all the tracks of the new added view
     const aliceVision::track::TrackIdSet& newView_trackIds = map_tracksPerView.at(viewId);
     
-    // Keep the reconstructed tracks (with an associated landmark)
-    std::vector<IndexT> newView_landmarks; // all landmarks (already reconstructed) visible from the new view
-    
-    newView_landmarks.reserve(newView_trackIds.size());
-    std::set_intersection(newView_trackIds.begin(), newView_trackIds.end(),
-                          landmarkIds.begin(), landmarkIds.end(),
-                          std::back_inserter(newView_landmarks));
-    
-    // Retrieve the common track Ids
-    for(const auto& landmarkId: newView_landmarks)
+    // Retrieve the common track Ids of the reconstructed tracks (with an associated landmark)
+    for(const auto& trackId: newView_trackIds)
     {
-      for(const auto& observations: sfm_data.structure.at(landmarkId).observations)
+      const auto landmarkIt = sfm_data.structure.find(trackId);
+      if (landmarkIt == sfm_data.structure.end())
+        continue;
+
+      for(const auto& observations: landmarkIt->second.observations)
       {
         if (observations.first == viewId) continue; // do not compare an observation with itself
         
@@ -589,8 +608,8 @@ void LocalBundleAdjustmentData::drawGraph(const SfMData& sfm_data, const std::st
   dotStream << "  node [ shape=ellipse, penwidth=5.0, fontname=Helvetica, fontsize=40 ];" << "\n";
   for(lemon::ListGraph::NodeIt n(_graph); n!=lemon::INVALID; ++n)
   {
-    IndexT viewId = _mapViewIdPerNode[n];
-    int viewDist = _mapDistancePerViewId[viewId];
+    IndexT viewId = _viewIdPerNode[_graph.id(n)];
+    int viewDist = getViewDistance(viewId);
     
     std::string color = ", color=";
     if (viewDist == 0) color += "red";
@@ -613,7 +632,7 @@ void LocalBundleAdjustmentData::drawGraph(const SfMData& sfm_data, const std::st
   }
   dotStream << "}" << "\n";
   
-  const std::string dotFilepath = (fs::path(dir) / ("graph_" + std::to_string(_mapViewIdPerNode.size())  + "_" + nameComplement + ".dot")).string();
+  const std::string dotFilepath = (fs::path(dir) / ("graph_" + std::to_string(_mapNodePerViewId.size())  + "_" + nameComplement + ".dot")).string();
   std::ofstream dotFile;
   dotFile.open(dotFilepath);
   dotFile.write(dotStream.str().c_str(), dotStream.str().length());
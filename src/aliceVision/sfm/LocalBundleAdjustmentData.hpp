@@ -10,6 +10,8 @@
 #include <aliceVision/track/Track.hpp>
 #include <aliceVision/sfm/SfMData.hpp>
 
+#include <lemon/list_graph.h>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -32,13 +34,16 @@ public:
   std::map<int, std::size_t> getDistancesHistogram() const;
     
   /// Return the \c EState for a specific pose.
-  EState getPosestate(const IndexT poseId) const           {return _mapLBAStatePerPoseId.at(poseId);}
+  EState getPosestate(const IndexT poseId) const           {return _posesState.get(poseId);}
  
   /// Return the \c EState for a specific intrinsic.
-  EState getIntrinsicstate(const IndexT intrinsicId) const {return _mapLBAStatePerIntrinsicId.at(intrinsicId);}
+  EState getIntrinsicstate(const IndexT intrinsicId) const {return _intrinsicsState.get(intrinsicId);}
 
   /// Return the \c EState for a specific landmark.
-  EState getLandmarkState(const IndexT landmarkId) const   {return _mapLBAStatePerLandmarkId.at(landmarkId);}
+  EState getLandmarkState(const IndexT landmarkId) const   {return _landmarksState.get(landmarkId);}
+
+  /// Return the landmarks not \c ignored (refined or constant) by the Local BA.
+  const std::vector<IndexT>& getActiveLandmarks() const    {return _landmarksState.getNotIgnored();}
   
   /// Return the number of refined poses.
   std::size_t getNumOfRefinedPoses() const        {return getNumberOf(EParameter::pose, EState::refined);}
@@ -108,7 +113,8 @@ public:
   
   /// @brief Compute the intragraph-distance between all the nodes of the graph (posed views) and the newly resected
   /// views.
-  /// @details The graph-distances are computed using a Breadth-first Search (BFS) method.
+  /// @details The graph-distances are computed using a Breadth-first Search (BFS) method, stopped at the
+  /// distance D+1 (\c _graphDistanceLimit + 1): the farther views are not visited and their distance is -1.
   /// @param[in] sfm_data contains all the information about the reconstruction, notably the posed views
   /// @param[in] newReconstructedViews The list of the newly resected views used (used as source in the BFS algorithm)
   void computeGraphDistances(const SfMData& sfm_data, const std::set<IndexT> &newReconstructedViews);
@@ -131,9 +137,10 @@ public:
   ///     - a Landmarks is set to:
   ///       - \a Ignored by default
   ///       - \a Refined <=> its connected to a refined camera
+  /// @details Only the poses and the landmarks of the views reached by \c computeGraphDistances are visited.
   /// @param[in] sfm_data
-  /// @param[in] kLimitDistance the distance of the active region
-  void convertDistancesToLBAStates(const SfMData & sfm_data);
+  /// @param[in] map_tracksPerView A map giving the tracks for each view
+  void convertDistancesToLBAStates(const SfMData & sfm_data, const track::TracksPerView& map_tracksPerView);
    
 private:
    
@@ -168,6 +175,51 @@ private:
   /// @param[in] nameComplement 
   void drawGraph(const SfMData &sfm_data, const std::string& dir, const std::string& nameComplement = "");
 
+  /// @brief Flat storage of the \c EState of one type of parameter.
+  /// @details Each parameter id is associated, once, to a slot in a contiguous array.
+  /// The parameters without state are \c ignored, so it only needs to be reset on the parameters that are not ignored.
+  class ParameterStates
+  {
+  public:
+    /// Return the state of a parameter (\c ignored by default).
+    EState get(IndexT id) const
+    {
+      const auto it = _slotPerId.find(id);
+      return (it == _slotPerId.end()) ? EState::ignored : _states[it->second];
+    }
+
+    /// Set the state of a parameter.
+    void set(IndexT id, EState state)
+    {
+      const auto it = _slotPerId.emplace(id, _states.size());
+      if(it.second)
+        _states.push_back(EState::ignored);
+      EState& currentState = _states[it.first->second];
+      if(currentState == EState::ignored && state != EState::ignored)
+        _notIgnored.push_back(id);
+      currentState = state;
+    }
+
+    /// Set all the parameters as \c ignored.
+    void reset()
+    {
+      for(IndexT id : _notIgnored)
+        _states[_slotPerId.at(id)] = EState::ignored;
+      _notIgnored.clear();
+    }
+
+    /// Return the parameters set as refined or constant since the last reset.
+    const std::vector<IndexT>& getNotIgnored() const {return _notIgnored;}
+
+  private:
+    HashMap<IndexT, std::size_t> _slotPerId;
+    std::vector<EState> _states;
+    std::vector<IndexT> _notIgnored;
+  };
+
+  /// @brief Set all the states to \c ignored and all the counters to 0.
+  void resetStates();
+
   /// Return the number of parameters \c EParameter being in the \c EState state.
   std::size_t getNumberOf(EParameter param, EState state) const {return _parametersCounter.at(std::make_pair(param, state));}
   
@@ -225,21 +277,26 @@ private:
   std::size_t _graphDistanceLimit = 1;
   
   /// Associates each view (indexed by its viewId) to its corresponding node in the graph.
-  std::map<IndexT, lemon::ListGraph::Node> _mapNodePerViewId;
-  /// Associates each node (in the graph) to its corresponding view.
-  std::map<lemon::ListGraph::Node, IndexT> _mapViewIdPerNode;
+  HashMap<IndexT, lemon::ListGraph::Node> _mapNodePerViewId;
+  /// Associates each node (indexed by its lemon id) to its corresponding view (UndefinedIndexT: erased node).
+  std::vector<IndexT> _viewIdPerNode;
+
+  /// Store the graph-distance of each node (indexed by its lemon id, -1: not reached)
+  std::vector<int> _distancePerNode;
+  /// The nodes (lemon id) reached by the last graph-distances computation
+  std::vector<int> _reachedNodes;
     
-  /// Store the graph-distances from the new views (0: is a new view, -1: is not connected to the new views)
-  std::map<IndexT, int> _mapDistancePerViewId;
-  /// Store the graph-distances from the new poses (0: is a new pose, -1: is not connected to the new poses)
-  std::map<IndexT, int> _mapDistancePerPoseId;
+  /// Store the graph-distances from the new views of the reached views (0: is a new view)
+  HashMap<IndexT, int> _mapDistancePerViewId;
+  /// Store the graph-distances from the new poses of the reached poses (0: is a new pose)
+  HashMap<IndexT, int> _mapDistancePerPoseId;
   
   /// Store the \c EState of each pose in the scene.
-  std::map<IndexT, EState> _mapLBAStatePerPoseId;
+  ParameterStates _posesState;
   /// Store the \c EState of each intrinsic in the scene.
-  std::map<IndexT, EState> _mapLBAStatePerIntrinsicId;
+  ParameterStates _intrinsicsState;
   /// Store the \c EState of each landmark in the scene.
-  std::map<IndexT, EState> _mapLBAStatePerLandmarkId;
+  ParameterStates _landmarksState;
   
   /// Store the number of parameter \c EParameter in a specific state \c EState
   std::map<std::pair<EParameter, EState>, int> _parametersCounter;
@@ -0,0 +1,391 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/PartitionedBundleAdjustmentCeres.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+/// Submap estimate of a landmark or an intrinsic, weighted by its num. of observations
+struct WeightedParams
+{
+  std::vector<double> sum;
+  double weight = 0.0;
+
+  void add(const double* params, std::size_t size, double w)
+  {
+    if(sum.empty())
+      sum.assign(size, 0.0);
+    for(std::size_t i = 0; i < size; ++i)
+      sum[i] += w * params[i];
+    weight += w;
+  }
+};
+
+/// Root mean square of the reprojection errors of the scene
+double computeRMSE(const SfMData& sfmData)
+{
+  double squaredErrors = 0.0;
+  std::size_t nbObservations = 0;
+
+  for(const auto& landmarkIt : sfmData.getLandmarks())
+  {
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const View* view = sfmData.getViews().at(observationIt.first).get();
+      if(!sfmData.isPoseAndIntrinsicDefined(view))
+        continue;
+
+      const camera::IntrinsicBase* intrinsic = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
+      squaredErrors += intrinsic->residual(sfmData.getPose(*view).getTransform(), landmarkIt.second.X, observationIt.second.x).squaredNorm();
+      ++nbObservations;
+    }
+  }
+  return (nbObservations == 0) ? 0.0 : std::sqrt(squaredErrors / nbObservations);
+}
+
+/// Recursive median bisection of the camera centers along their largest extent
+void bisectPoses(std::vector<std::pair<IndexT, Vec3>>::iterator begin,
+                 std::vector<std::pair<IndexT, Vec3>>::iterator end,
+                 std::size_t maxNbPoses,
+                 std::vector<std::vector<IndexT>>& out_submaps)
+{
+  const std::size_t nbPoses = std::distance(begin, end);
+  if(nbPoses <= maxNbPoses)
+  {
+    out_submaps.emplace_back();
+    for(auto it = begin; it != end; ++it)
+      out_submaps.back().push_back(it->first);
+    return;
+  }
+
+  Vec3 minCenter = begin->second;
+  Vec3 maxCenter = begin->second;
+  for(auto it = begin; it != end; ++it)
+  {
+    minCenter = minCenter.cwiseMin(it->second);
+    maxCenter = maxCenter.cwiseMax(it->second);
+  }
+  int axis;
+  (maxCenter - minCenter).maxCoeff(&axis);
+
+  const auto middle = begin + nbPoses / 2;
+  std::nth_element(begin, middle, end, [axis](const std::pair<IndexT, Vec3>& a, const std::pair<IndexT, Vec3>& b)
+  {
+    return a.second(axis) < b.second(axis);
+  });
+
+  bisectPoses(begin, middle, maxNbPoses, out_submaps);
+  bisectPoses(middle, end, maxNbPoses, out_submaps);
+}
+
+/**
+ * @brief Scene data shared by all the submaps
+ */
+struct SceneIndex
+{
+  explicit SceneIndex(const SfMData& sfmData)
+  {
+    for(const auto& viewIt : sfmData.getViews())
+    {
+      if(sfmData.isPoseAndIntrinsicDefined(viewIt.second.get()))
+        viewsPerPose[viewIt.second->getPoseId()].push_back(viewIt.first);
+    }
+
+    for(const auto& landmarkIt : sfmData.getLandmarks())
+    {
+      for(const auto& observationIt : landmarkIt.second.observations)
+      {
+        const View* view = sfmData.getViews().at(observationIt.first).get();
+        if(sfmData.isPoseAndIntrinsicDefined(view))
+          landmarksPerPose[view->getPoseId()].push_back(landmarkIt.first);
+      }
+    }
+    // a landmark can be seen by several views of a rig pose
+    for(auto& landmarksIt : landmarksPerPose)
+    {
+      std::vector<IndexT>& landmarks = landmarksIt.second;
+      std::sort(landmarks.begin(), landmarks.end());
+      landmarks.erase(std::unique(landmarks.begin(), landmarks.end()), landmarks.end());
+    }
+  }
+
+  HashMap<IndexT, std::size_t> submapPerPose;
+  HashMap<IndexT, std::vector<IndexT>> viewsPerPose;
+  HashMap<IndexT, std::vector<IndexT>> landmarksPerPose;
+};
+
+/**
+ * @brief Build the scene of a submap: its poses, its most covisible separator poses (constant)
+ *        and the landmarks seen by its poses with at least 2 observations in the submap.
+ * @param[in] sfmData The whole scene
+ * @param[in] sceneIndex The scene index
+ * @param[in] submapIndex The submap index
+ * @param[in] corePoses The poses refined in the submap
+ * @param[in] maxNbSeparatorPoses The max. num. of separator poses
+ * @param[out] out_submap The submap scene
+ * @param[out] out_weights The num. of observations of the landmarks from the submap poses
+ */
+void buildSubmap(const SfMData& sfmData,
+                 const SceneIndex& sceneIndex,
+                 std::size_t submapIndex,
+                 const std::vector<IndexT>& corePoses,
+                 std::size_t maxNbSeparatorPoses,
+                 SfMData& out_submap,
+                 HashMap<IndexT, std::size_t>& out_weights)
+{
+  // landmarks seen by the submap poses
+  std::vector<IndexT> landmarkIds;
+  for(IndexT poseId : corePoses)
+  {
+    const auto it = sceneIndex.landmarksPerPose.find(poseId);
+    if(it != sceneIndex.landmarksPerPose.end())
+      landmarkIds.insert(landmarkIds.end(), it->second.begin(), it->second.end());
+  }
+  std::sort(landmarkIds.begin(), landmarkIds.end());
+  landmarkIds.erase(std::unique(landmarkIds.begin(), landmarkIds.end()), landmarkIds.end());
+
+  // separator poses, ranked by their num. of observations of these landmarks
+  HashMap<IndexT, std::size_t> separatorScores;
+  for(IndexT landmarkId : landmarkIds)
+  {
+    for(const auto& observationIt : sfmData.getLandmarks().at(landmarkId).observations)
+    {
+      const View* view = sfmData.getViews().at(observationIt.first).get();
+      if(sfmData.isPoseAndIntrinsicDefined(view) && sceneIndex.submapPerPose.at(view->getPoseId()) != submapIndex)
+        ++separatorScores[view->getPoseId()];
+    }
+  }
+  std::vector<std::pair<std::size_t, IndexT>> separators;
+  separators.reserve(separatorScores.size());
+  for(const auto& scoreIt : separatorScores)
+    separators.emplace_back(scoreIt.second, scoreIt.first);
+  const std::size_t nbSeparators = std::min(maxNbSeparatorPoses, separators.size());
+  std::partial_sort(separators.begin(), separators.begin() + nbSeparators, separators.end(), std::greater<std::pair<std::size_t, IndexT>>());
+  separators.resize(nbSeparators);
+
+  // poses, views & intrinsics
+  auto addPose = [&](IndexT poseId, bool isSeparator)
+  {
+    const CameraPose& pose = sfmData.getPoses().at(poseId);
+    out_submap.getPoses()[poseId] = CameraPose(pose.getTransform(), pose.isLocked() || isSeparator);
+
+    for(IndexT viewId : sceneIndex.viewsPerPose.at(poseId))
+    {
+      const std::shared_ptr<View>& view = sfmData.getViews().at(viewId);
+      out_submap.views[viewId] = view;
+      if(out_submap.intrinsics.find(view->getIntrinsicId()) == out_submap.intrinsics.end())
+        out_submap.intrinsics[view->getIntrinsicId()].reset(sfmData.getIntrinsics().at(view->getIntrinsicId())->clone());
+    }
+  };
+  for(IndexT poseId : corePoses)
+    addPose(poseId, false);
+  for(const auto& separator : separators)
+    addPose(separator.second, true);
+
+  // the rig sub-poses are shared by all the submaps
+  out_submap.getRigs() = sfmData.getRigs();
+  for(auto& rigIt : out_submap.getRigs())
+  {
+    for(std::size_t subPoseId = 0; subPoseId < rigIt.second.getNbSubPoses(); ++subPoseId)
+    {
+      RigSubPose& subPose = rigIt.second.getSubPose(subPoseId);
+      if(subPose.status != ERigSubPoseStatus::UNINITIALIZED)
+        subPose.status = ERigSubPoseStatus::CONSTANT;
+    }
+  }
+
+  // landmarks
+  for(IndexT landmarkId : landmarkIds)
+  {
+    const Landmark& landmark = sfmData.getLandmarks().at(landmarkId);
+    Landmark submapLandmark = landmark;
+    submapLandmark.observations.clear();
+    std::size_t nbCoreObservations = 0;
+
+    for(const auto& observationIt : landmark.observations)
+    {
+      const auto viewIt = out_submap.views.find(observationIt.first);
+      if(viewIt == out_submap.views.end())
+        continue;
+      submapLandmark.observations[observationIt.first] = observationIt.second;
+      if(sceneIndex.submapPerPose.at(viewIt->second->getPoseId()) == submapIndex)
+        ++nbCoreObservations;
+    }
+
+    if(submapLandmark.observations.size() < 2)
+      continue;
+
+    out_submap.structure[landmarkId] = std::move(submapLandmark);
+    out_weights[landmarkId] = nbCoreObservations;
+  }
+}
+
+} // namespace
+
+std::vector<std::vector<IndexT>> PartitionedBundleAdjustmentCeres::partitionPoses(const SfMData& sfmData, std::size_t maxNbPoses)
+{
+  std::vector<std::pair<IndexT, Vec3>> centers;
+  centers.reserve(sfmData.getPoses().size());
+  for(const auto& poseIt : sfmData.getPoses())
+    centers.emplace_back(poseIt.first, poseIt.second.getTransform().center());
+
+  // deterministic partition
+  std::sort(centers.begin(), centers.end(), [](const std::pair<IndexT, Vec3>& a, const std::pair<IndexT, Vec3>& b)
+  {
+    return a.first < b.first;
+  });
+
+  std::vector<std::vector<IndexT>> submaps;
+  if(!centers.empty())
+    bisectPoses(centers.begin(), centers.end(), std::max<std::size_t>(1, maxNbPoses), submaps);
+  return submaps;
+}
+
+bool PartitionedBundleAdjustmentCeres::Adjust(SfMData& sfmData, BA_Refine refineOptions)
+{
+  if(sfmData.getPoses().size() <= _options._maxNbPosesPerSubmap)
+  {
+    // a single submap: classic bundle adjustment
+    BundleAdjustmentCeres::BA_options options = _options._submapOptions;
+    options.setAdaptiveBA(BundleAdjustmentCeres::BA_problemSize(sfmData));
+    BundleAdjustmentCeres bundleAdjustment(options);
+    return bundleAdjustment.Adjust(sfmData, refineOptions);
+  }
+
+  system::Timer timer;
+
+  const std::vector<std::vector<IndexT>> submaps = partitionPoses(sfmData, _options._maxNbPosesPerSubmap);
+
+  SceneIndex sceneIndex(sfmData);
+  for(std::size_t i = 0; i < submaps.size(); ++i)
+  {
+    for(IndexT poseId : submaps[i])
+      sceneIndex.submapPerPose[poseId] = i;
+  }
+
+  double rmse = computeRMSE(sfmData);
+
+  if(_options._bVerbose)
+    ALICEVISION_LOG_DEBUG("Partitioned Bundle Adjustment: " << submaps.size() << " submaps of at most "
+                          << _options._maxNbPosesPerSubmap << " poses, initial RMSE: " << rmse);
+
+  bool isAdjusted = false;
+
+  for(std::size_t iteration = 0; iteration < _options._maxNbIterations; ++iteration)
+  {
+    // consensus of the submaps estimates
+    HashMap<IndexT, geometry::Pose3> refinedPoses;
+    HashMap<IndexT, WeightedParams> refinedLandmarks;
+    HashMap<IndexT, WeightedParams> refinedIntrinsics;
+    std::size_t nbAdjustedSubmaps = 0;
+
+    #pragma omp parallel for schedule(dynamic) num_threads(_options._nbParallelSubmaps)
+    for(int i = 0; i < static_cast<int>(submaps.size()); ++i)
+    {
+      SfMData submap;
+      HashMap<IndexT, std::size_t> landmarkWeights;
+      buildSubmap(sfmData, sceneIndex, i, submaps[i], _options._maxNbSeparatorPoses, submap, landmarkWeights);
+
+      BundleAdjustmentCeres::BA_options options = _options._submapOptions;
+      options.setAdaptiveBA(BundleAdjustmentCeres::BA_problemSize(submap));
+      BundleAdjustmentCeres bundleAdjustment(options);
+
+      if(!bundleAdjustment.Adjust(submap, refineOptions))
+      {
+        ALICEVISION_LOG_WARNING("Partitioned Bundle Adjustment: submap " << i << " failed.");
+        continue;
+      }
+
+      // num. of observations of each intrinsic from the submap poses
+      HashMap<IndexT, std::size_t> intrinsicWeights;
+      for(IndexT poseId : submaps[i])
+      {
+        for(IndexT viewId : sceneIndex.viewsPerPose.at(poseId))
+          intrinsicWeights[submap.views.at(viewId)->getIntrinsicId()] += sceneIndex.landmarksPerPose.count(poseId) ? sceneIndex.landmarksPerPose.at(poseId).size() : 0;
+      }
+
+      #pragma omp critical
+      {
+        ++nbAdjustedSubmaps;
+
+        for(IndexT poseId : submaps[i])
+          refinedPoses[poseId] = submap.getPoses().at(poseId).getTransform();
+
+        for(const auto& weightIt : landmarkWeights)
+        {
+          if(weightIt.second > 0)
+            refinedLandmarks[weightIt.first].add(submap.structure.at(weightIt.first).X.data(), 3, weightIt.second);
+        }
+
+        for(const auto& weightIt : intrinsicWeights)
+        {
+          if(weightIt.second > 0)
+          {
+            const std::vector<double> params = submap.intrinsics.at(weightIt.first)->getParams();
+            refinedIntrinsics[weightIt.first].add(params.data(), params.size(), weightIt.second);
+          }
+        }
+      }
+    }
+
+    if(nbAdjustedSubmaps == 0)
+      break;
+
+    isAdjusted = true;
+
+    // reconciliation
+    for(const auto& poseIt : refinedPoses)
+    {
+      CameraPose& pose = sfmData.getPoses().at(poseIt.first);
+      if(!pose.isLocked())
+        pose.setTransform(poseIt.second);
+    }
+    for(const auto& landmarkIt : refinedLandmarks)
+    {
+      const WeightedParams& params = landmarkIt.second;
+      sfmData.structure.at(landmarkIt.first).X = Vec3(params.sum[0], params.sum[1], params.sum[2]) / params.weight;
+    }
+    for(const auto& intrinsicIt : refinedIntrinsics)
+    {
+      camera::IntrinsicBase& intrinsic = *sfmData.intrinsics.at(intrinsicIt.first);
+      if(intrinsic.isLocked())
+        continue;
+      std::vector<double> params = intrinsicIt.second.sum;
+      for(double& param : params)
+        param /= intrinsicIt.second.weight;
+      intrinsic.updateFromParams(params);
+    }
+
+    const double previousRMSE = rmse;
+    rmse = computeRMSE(sfmData);
+
+    if(_options._bVerbose)
+      ALICEVISION_LOG_DEBUG("Partitioned Bundle Adjustment: iteration " << iteration << ", "
+                            << nbAdjustedSubmaps << "/" << submaps.size() << " submaps adjusted, RMSE: " << rmse);
+
+    if(previousRMSE <= 0.0 || (previousRMSE - rmse) / previousRMSE < _options._minRMSEDecrease)
+      break;
+  }
+
+  if(_options._bVerbose)
+    ALICEVISION_LOG_DEBUG("Partitioned Bundle Adjustment: final RMSE: " << rmse << ", time (s): " << timer.elapsed());
+
+  return isAdjusted;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,72 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Bundle adjustment of large scenes by overlapping submaps.
+ *
+ * The poses are split into spatially coherent submaps (recursive median bisection of the camera
+ * centers). Each submap is extended with its most covisible separator poses, set constant, and
+ * with all the landmarks seen by its own poses. The submaps are solved independently (and in parallel)
+ * then reconciled: each pose comes from its submap, the landmarks and the intrinsics shared by
+ * several submaps are averaged, weighted by their number of observations. This is iterated until
+ * the reprojection error of the whole scene stops decreasing.
+ *
+ * Only one submap problem per parallel task lives in memory, so the solver memory is bounded
+ * by the submap size instead of the scene size.
+ *
+ * @note The rig sub-poses are kept constant.
+ */
+class PartitionedBundleAdjustmentCeres : public BundleAdjustment
+{
+public:
+  struct PBA_options
+  {
+    PBA_options(const bool bVerbose = true, bool bmultithreaded = true)
+      : _submapOptions(false, bmultithreaded)
+      , _bVerbose(bVerbose)
+    {}
+
+    BundleAdjustmentCeres::BA_options _submapOptions; ///< The options of the submap bundle adjustments (the solver is selected for each submap)
+    bool _bVerbose;
+    std::size_t _maxNbPosesPerSubmap = 500;   ///< Max. num. of poses refined in a submap
+    std::size_t _maxNbSeparatorPoses = 250;   ///< Max. num. of constant separator poses added to a submap
+    std::size_t _maxNbIterations = 10;        ///< Max. num. of submaps solving / reconciliation iterations
+    double _minRMSEDecrease = 1e-3;           ///< Min. relative decrease of the scene RMSE to continue iterating
+    int _nbParallelSubmaps = 1;               ///< Num. of submaps solved at the same time
+  };
+
+  explicit PartitionedBundleAdjustmentCeres(const PBA_options& options = PBA_options())
+    : _options(options)
+  {}
+
+  /**
+   * @brief Partition the reconstructed poses in submaps of at most maxNbPoses poses
+   * @param[in] sfmData The scene
+   * @param[in] maxNbPoses The max. num. of poses per submap
+   * @return the pose ids of each submap
+   */
+  static std::vector<std::vector<IndexT>> partitionPoses(const SfMData& sfmData, std::size_t maxNbPoses);
+
+  /**
+   * @see BundleAdjustment::Adjust
+   */
+  bool Adjust(SfMData& sfmData, BA_Refine refineOptions = BA_REFINE_ALL) override;
+
+private:
+  PBA_options _options;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,445 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <ceres/ceres.h>
+
+#include <cmath>
+#include <limits>
+
+// Define ceres cost functions with analytic Jacobians for each AliceVision camera model,
+// they compute the same residuals as the cost functors of ResidualErrorFunctor.hpp
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Distortion models of the cost functions.
+ *
+ * Each model applies the distortion on the undistorted normalized coordinates x_u and computes
+ * the Jacobians of the distorted coordinates x_d with respect to x_u and to the intrinsics block
+ * [focal, principal point x, principal point y, distortion parameters] (the first 3 columns are 0).
+ */
+struct Distortion_None
+{
+  static const int nbIntrinsics = 3;
+
+  /// [focal, principal point x, principal point y]
+  static void apply(const double* const,
+                    const Vec2& x_u,
+                    Vec2& x_d,
+                    Eigen::Matrix2d& dXd_dXu,
+                    Eigen::Matrix<double, 2, nbIntrinsics>& dXd_dK)
+  {
+    x_d = x_u;
+    dXd_dXu.setIdentity();
+    dXd_dK.setZero();
+  }
+};
+
+struct Distortion_RadialK1
+{
+  static const int nbIntrinsics = 4;
+
+  /// [focal, principal point x, principal point y, K1]
+  static void apply(const double* const cam_K,
+                    const Vec2& x_u,
+                    Vec2& x_d,
+                    Eigen::Matrix2d& dXd_dXu,
+                    Eigen::Matrix<double, 2, nbIntrinsics>& dXd_dK)
+  {
+    const double k1 = cam_K[3];
+    const double r2 = x_u.squaredNorm();
+    const double r_coeff = 1.0 + k1 * r2;
+    const double dRcoeff_dR2 = k1;
+
+    x_d = x_u * r_coeff;
+    dXd_dXu = r_coeff * Eigen::Matrix2d::Identity() + 2.0 * dRcoeff_dR2 * x_u * x_u.transpose();
+    dXd_dK.setZero();
+    dXd_dK.col(3) = x_u * r2;
+  }
+};
+
+struct Distortion_RadialK3
+{
+  static const int nbIntrinsics = 6;
+
+  /// [focal, principal point x, principal point y, K1, K2, K3]
+  static void apply(const double* const cam_K,
+                    const Vec2& x_u,
+                    Vec2& x_d,
+                    Eigen::Matrix2d& dXd_dXu,
+                    Eigen::Matrix<double, 2, nbIntrinsics>& dXd_dK)
+  {
+    const double k1 = cam_K[3];
+    const double k2 = cam_K[4];
+    const double k3 = cam_K[5];
+    const double r2 = x_u.squaredNorm();
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double dRcoeff_dR2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+
+    x_d = x_u * r_coeff;
+    dXd_dXu = r_coeff * Eigen::Matrix2d::Identity() + 2.0 * dRcoeff_dR2 * x_u * x_u.transpose();
+    dXd_dK.setZero();
+    dXd_dK.col(3) = x_u * r2;
+    dXd_dK.col(4) = x_u * r4;
+    dXd_dK.col(5) = x_u * r6;
+  }
+};
+
+struct Distortion_BrownT2
+{
+  static const int nbIntrinsics = 8;
+
+  /// [focal, principal point x, principal point y, K1, K2, K3, T1, T2]
+  static void apply(const double* const cam_K,
+                    const Vec2& x_u,
+                    Vec2& x_d,
+                    Eigen::Matrix2d& dXd_dXu,
+                    Eigen::Matrix<double, 2, nbIntrinsics>& dXd_dK)
+  {
+    const double k1 = cam_K[3];
+    const double k2 = cam_K[4];
+    const double k3 = cam_K[5];
+    const double t1 = cam_K[6];
+    const double t2 = cam_K[7];
+    const double x = x_u(0);
+    const double y = x_u(1);
+    const double r2 = x_u.squaredNorm();
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double dRcoeff_dR2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+
+    const double t_x = t2 * (r2 + 2.0 * x * x) + 2.0 * t1 * x * y;
+    const double t_y = t1 * (r2 + 2.0 * y * y) + 2.0 * t2 * x * y;
+
+    x_d(0) = x * r_coeff + t_x;
+    x_d(1) = y * r_coeff + t_y;
+
+    dXd_dXu = r_coeff * Eigen::Matrix2d::Identity() + 2.0 * dRcoeff_dR2 * x_u * x_u.transpose();
+    dXd_dXu(0, 0) += 6.0 * t2 * x + 2.0 * t1 * y;
+    dXd_dXu(0, 1) += 2.0 * t2 * y + 2.0 * t1 * x;
+    dXd_dXu(1, 0) += 2.0 * t1 * x + 2.0 * t2 * y;
+    dXd_dXu(1, 1) += 6.0 * t1 * y + 2.0 * t2 * x;
+
+    dXd_dK.setZero();
+    dXd_dK.col(3) = x_u * r2;
+    dXd_dK.col(4) = x_u * r4;
+    dXd_dK.col(5) = x_u * r6;
+    dXd_dK(0, 6) = 2.0 * x * y;
+    dXd_dK(1, 6) = r2 + 2.0 * y * y;
+    dXd_dK(0, 7) = r2 + 2.0 * x * x;
+    dXd_dK(1, 7) = 2.0 * x * y;
+  }
+};
+
+struct Distortion_Fisheye
+{
+  static const int nbIntrinsics = 7;
+
+  /// [focal, principal point x, principal point y, K1, K2, K3, K4]
+  static void apply(const double* const cam_K,
+                    const Vec2& x_u,
+                    Vec2& x_d,
+                    Eigen::Matrix2d& dXd_dXu,
+                    Eigen::Matrix<double, 2, nbIntrinsics>& dXd_dK)
+  {
+    const double k1 = cam_K[3];
+    const double k2 = cam_K[4];
+    const double k3 = cam_K[5];
+    const double k4 = cam_K[6];
+    const double r = x_u.norm();
+
+    dXd_dK.setZero();
+
+    // same threshold as ResidualErrorFunctor_PinholeFisheye, the distortion is constant around the center
+    if(r <= 1e-8)
+    {
+      x_d = x_u;
+      dXd_dXu.setIdentity();
+      return;
+    }
+
+    const double theta = std::atan(r);
+    const double theta2 = theta * theta, theta3 = theta2 * theta, theta4 = theta2 * theta2, theta5 = theta4 * theta,
+                 theta6 = theta3 * theta3, theta7 = theta6 * theta, theta8 = theta4 * theta4, theta9 = theta8 * theta;
+    const double theta_dist = theta + k1 * theta3 + k2 * theta5 + k3 * theta7 + k4 * theta9;
+    const double dThetaDist_dTheta = 1.0 + 3.0 * k1 * theta2 + 5.0 * k2 * theta4 + 7.0 * k3 * theta6 + 9.0 * k4 * theta8;
+    const double dTheta_dR = 1.0 / (1.0 + r * r);
+    const double inv_r = 1.0 / r;
+    const double cdist = theta_dist * inv_r;
+    const double dCdist_dR = (dThetaDist_dTheta * dTheta_dR - cdist) * inv_r;
+
+    x_d = x_u * cdist;
+    dXd_dXu = cdist * Eigen::Matrix2d::Identity() + (dCdist_dR * inv_r) * x_u * x_u.transpose();
+    dXd_dK.col(3) = x_u * (theta3 * inv_r);
+    dXd_dK.col(4) = x_u * (theta5 * inv_r);
+    dXd_dK.col(5) = x_u * (theta7 * inv_r);
+    dXd_dK.col(6) = x_u * (theta9 * inv_r);
+  }
+};
+
+struct Distortion_Fisheye1
+{
+  static const int nbIntrinsics = 4;
+
+  /// [focal, principal point x, principal point y, K1]
+  static void apply(const double* const cam_K,
+                    const Vec2& x_u,
+                    Vec2& x_d,
+                    Eigen::Matrix2d& dXd_dXu,
+                    Eigen::Matrix<double, 2, nbIntrinsics>& dXd_dK)
+  {
+    const double k1 = cam_K[3];
+    const double r = x_u.norm();
+    const double tanHalfK1 = std::tan(0.5 * k1);
+    const double a = 2.0 * tanHalfK1;
+    const double dA_dK1 = 1.0 + tanHalfK1 * tanHalfK1;
+    const double ar = a * r;
+    const double atanAr = std::atan(ar);
+    const double invDenom = 1.0 / (1.0 + ar * ar);
+    const double r_coeff = atanAr / (k1 * r);
+    const double dRcoeff_dR = (ar * invDenom - atanAr) / (k1 * r * r);
+    const double dRcoeff_dK1 = dA_dK1 * invDenom / k1 - r_coeff / k1;
+
+    x_d = x_u * r_coeff;
+    dXd_dXu = r_coeff * Eigen::Matrix2d::Identity() + (dRcoeff_dR / r) * x_u * x_u.transpose();
+    dXd_dK.setZero();
+    dXd_dK.col(3) = x_u * dRcoeff_dK1;
+  }
+};
+
+/**
+ * @brief Rotate a point by an angle axis rotation and compute the Jacobian of the rotated point
+ *        with respect to the angle axis, as ceres::AngleAxisRotatePoint (first order approximation
+ *        near the zero rotation).
+ * @param[in] angleAxis The angle axis rotation
+ * @param[in] pt The point to rotate
+ * @param[out] R The rotation matrix (Jacobian of the rotated point with respect to the point)
+ * @param[out] dRpt_dAngleAxis The Jacobian of the rotated point with respect to the angle axis
+ * @return the rotated point
+ */
+inline Vec3 angleAxisRotatePoint(const double* const angleAxis, const Vec3& pt, Mat3& R, Mat3& dRpt_dAngleAxis)
+{
+  const Vec3 w(angleAxis[0], angleAxis[1], angleAxis[2]);
+  const double theta2 = w.squaredNorm();
+  const Mat3 wx = CrossProductMatrix(w);
+
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    const double sinTheta = std::sin(theta);
+    const double cosTheta = std::cos(theta);
+
+    R = Mat3::Identity() + (sinTheta / theta) * wx + ((1.0 - cosTheta) / theta2) * wx * wx;
+
+    // d(R.pt)/dw = -R [pt]x Jr(w), Jr being the right Jacobian of SO(3)
+    const Mat3 Jr = Mat3::Identity() - ((1.0 - cosTheta) / theta2) * wx + ((theta - sinTheta) / (theta2 * theta)) * wx * wx;
+    dRpt_dAngleAxis = -R * CrossProductMatrix(pt) * Jr;
+  }
+  else
+  {
+    // R.pt ~ pt + w x pt
+    R = Mat3::Identity() + wx;
+    dRpt_dAngleAxis = -CrossProductMatrix(pt);
+  }
+  return R * pt;
+}
+
+/**
+ * @brief Project a point of the camera frame and compute the residual and the Jacobians of the residual.
+ * @param[in] cam_K The intrinsics block
+ * @param[in] pos_proj The point in the camera frame
+ * @param[in] pos_2dpoint The 2D observation
+ * @param[out] out_residuals The residuals
+ * @param[out] dR_dK The Jacobian with respect to the intrinsics (row-major), can be nullptr
+ * @param[out] dR_dPosProj The Jacobian with respect to the point in the camera frame
+ */
+template <typename Distortion>
+void projectAndDifferentiate(const double* const cam_K,
+                             const Vec3& pos_proj,
+                             const double* const pos_2dpoint,
+                             double* out_residuals,
+                             double* dR_dK,
+                             Mat23& dR_dPosProj)
+{
+  const double focal = cam_K[0];
+
+  // Transform the point from homogeneous to euclidean (undistorted point)
+  const double invZ = 1.0 / pos_proj(2);
+  const Vec2 x_u(pos_proj(0) * invZ, pos_proj(1) * invZ);
+
+  Vec2 x_d;
+  Eigen::Matrix2d dXd_dXu;
+  Eigen::Matrix<double, 2, Distortion::nbIntrinsics> dXd_dK;
+  Distortion::apply(cam_K, x_u, x_d, dXd_dXu, dXd_dK);
+
+  // Apply focal length and principal point to get the final image coordinates
+  out_residuals[0] = cam_K[1] + focal * x_d(0) - pos_2dpoint[0];
+  out_residuals[1] = cam_K[2] + focal * x_d(1) - pos_2dpoint[1];
+
+  if(dR_dK != nullptr)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, Distortion::nbIntrinsics, Eigen::RowMajor>> J(dR_dK);
+    J = focal * dXd_dK;
+    J.col(0) = x_d;
+    J(0, 1) = 1.0;
+    J(1, 2) = 1.0;
+  }
+
+  Mat23 dXu_dPosProj;
+  dXu_dPosProj << invZ, 0.0, -x_u(0) * invZ,
+                  0.0, invZ, -x_u(1) * invZ;
+  dR_dPosProj = focal * dXd_dXu * dXu_dPosProj;
+}
+
+/**
+ * @brief Ceres cost function with analytic Jacobians of a camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,N,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - N => the intrinsic data block (see the Distortion models),
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+template <typename Distortion>
+class ResidualErrorCostFunction : public ceres::SizedCostFunction<2, Distortion::nbIntrinsics, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* out_residuals, double** jacobians) const override
+  {
+    const double* const cam_K = parameters[0];
+    const double* const cam_Rt = parameters[1];
+    const Vec3 pos_3dpoint(parameters[2][0], parameters[2][1], parameters[2][2]);
+
+    // Apply external parameters (Pose)
+    Mat3 R, dP_dR;
+    const Vec3 pos_proj = angleAxisRotatePoint(cam_Rt, pos_3dpoint, R, dP_dR) + Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    // Apply intrinsic parameters
+    Mat23 dR_dP;
+    projectAndDifferentiate<Distortion>(cam_K, pos_proj, m_pos_2dpoint, out_residuals,
+                                        (jacobians != nullptr) ? jacobians[0] : nullptr, dR_dP);
+
+    if(jacobians == nullptr)
+      return true;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = dR_dP * dP_dR;
+      J.rightCols<3>() = dR_dP;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[2]);
+      J = dR_dP * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic Jacobians of a rig camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,N,6,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - N => the intrinsic data block (see the Distortion models),
+ *  - 6 => the rig extrinsic data block (rig orientation and position) [R;t],
+ *  - 6 => the rig sub-pose data block (camera orientation and position in the rig) [R;t],
+ *  - 3 => a 3D point data block.
+ */
+template <typename Distortion>
+class ResidualErrorRigCostFunction : public ceres::SizedCostFunction<2, Distortion::nbIntrinsics, 6, 6, 3>
+{
+public:
+  explicit ResidualErrorRigCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* out_residuals, double** jacobians) const override
+  {
+    const double* const cam_K = parameters[0];
+    const double* const cam_Rt = parameters[1];
+    const double* const subpose_Rt = parameters[2];
+    const Vec3 pos_3dpoint(parameters[3][0], parameters[3][1], parameters[3][2]);
+
+    // Apply RIG pose
+    Mat3 R, dP_dR;
+    const Vec3 pos_rig = angleAxisRotatePoint(cam_Rt, pos_3dpoint, R, dP_dR) + Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    // Apply RIG sub-pose
+    Mat3 subR, dP_dSubR;
+    const Vec3 pos_proj = angleAxisRotatePoint(subpose_Rt, pos_rig, subR, dP_dSubR) + Vec3(subpose_Rt[3], subpose_Rt[4], subpose_Rt[5]);
+
+    // Apply intrinsic parameters
+    Mat23 dR_dP;
+    projectAndDifferentiate<Distortion>(cam_K, pos_proj, m_pos_2dpoint, out_residuals,
+                                        (jacobians != nullptr) ? jacobians[0] : nullptr, dR_dP);
+
+    if(jacobians == nullptr)
+      return true;
+
+    const Mat23 dR_dPosRig = dR_dP * subR;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = dR_dPosRig * dP_dR;
+      J.rightCols<3>() = dR_dPosRig;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[2]);
+      J.leftCols<3>() = dR_dP * dP_dSubR;
+      J.rightCols<3>() = dR_dP;
+    }
+    if(jacobians[3] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[3]);
+      J = dR_dPosRig * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+typedef ResidualErrorCostFunction<Distortion_None> ResidualErrorCostFunction_Pinhole;
+typedef ResidualErrorCostFunction<Distortion_RadialK1> ResidualErrorCostFunction_PinholeRadialK1;
+typedef ResidualErrorCostFunction<Distortion_RadialK3> ResidualErrorCostFunction_PinholeRadialK3;
+typedef ResidualErrorCostFunction<Distortion_BrownT2> ResidualErrorCostFunction_PinholeBrownT2;
+typedef ResidualErrorCostFunction<Distortion_Fisheye> ResidualErrorCostFunction_PinholeFisheye;
+typedef ResidualErrorCostFunction<Distortion_Fisheye1> ResidualErrorCostFunction_PinholeFisheye1;
+
+typedef ResidualErrorRigCostFunction<Distortion_None> ResidualErrorRigCostFunction_Pinhole;
+typedef ResidualErrorRigCostFunction<Distortion_RadialK1> ResidualErrorRigCostFunction_PinholeRadialK1;
+typedef ResidualErrorRigCostFunction<Distortion_RadialK3> ResidualErrorRigCostFunction_PinholeRadialK3;
+typedef ResidualErrorRigCostFunction<Distortion_BrownT2> ResidualErrorRigCostFunction_PinholeBrownT2;
+typedef ResidualErrorRigCostFunction<Distortion_Fisheye> ResidualErrorRigCostFunction_PinholeFisheye;
+typedef ResidualErrorRigCostFunction<Distortion_Fisheye1> ResidualErrorRigCostFunction_PinholeFisheye1;
+
+} // namespace sfm
+} // namespace aliceVision
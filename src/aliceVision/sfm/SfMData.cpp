@@ -8,11 +8,14 @@
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/image/io.hpp>
-#include <aliceVision/stl/stl.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
+#include <exception>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -231,111 +234,86 @@ void SfMData::combine(const SfMData& sfmData)
 /// Find the color of the SfMData Landmarks/structure
 bool colorizeTracks(SfMData& sfmData)
 {
-  // Colorize each track
-  //  Start with the most representative image
-  //    and iterate to provide a color to each 3D point
-
-  std::vector<Vec3> vec_3dPoints;
-  std::vector<Vec3> vec_tracksColor;
-
-  boost::progress_display my_progress_bar(sfmData.getLandmarks().size(),
-                                     std::cout,
-                                     "\nCompute scene structure color\n");
+  // Colorize each track from its most representative view (the view with the most observations),
+  // so that the images of a small number of views give a color to all the 3D points.
+  // The views are chosen in a single pass, then the images are read in parallel.
 
-  vec_3dPoints.resize(sfmData.getLandmarks().size());
+  Landmarks& landmarks = sfmData.getLandmarks();
 
-  //Build a list of contiguous index for the trackIds
-  std::map<IndexT, IndexT> trackIds_to_contiguousIndexes;
-  IndexT cpt = 0;
-  for (Landmarks::const_iterator it = sfmData.getLandmarks().begin();
-    it != sfmData.getLandmarks().end(); ++it, ++cpt)
+  // number of observations of each view
+  std::map<IndexT, std::size_t> nbObservationsPerView;
+  for(const auto& landmarkPair : landmarks)
   {
-    trackIds_to_contiguousIndexes[it->first] = cpt;
-    vec_3dPoints[cpt] = it->second.X;
+    for(const auto& observationPair : landmarkPair.second.observations)
+      ++nbObservationsPerView[observationPair.first];
   }
 
-  // The track list that will be colored (point removed during the process)
-  std::set<IndexT> remainingTrackToColor;
-  std::transform(sfmData.getLandmarks().begin(), sfmData.getLandmarks().end(),
-    std::inserter(remainingTrackToColor, remainingTrackToColor.begin()),
-    stl::RetrieveKey());
-  
-  while( !remainingTrackToColor.empty() )
+  // landmarks to color from each view
+  std::map<IndexT, std::vector<Landmark*>> landmarksPerView;
+  for(auto& landmarkPair : landmarks)
   {
-    // Find the most representative image (for the remaining 3D points)
-    //  a. Count the number of observation per view for each 3Dpoint Index
-    //  b. Sort to find the most representative view index
-
-    std::map<IndexT, IndexT> map_IndexCardinal; // ViewId, Cardinal
-    for (std::set<IndexT>::const_iterator
-      iterT = remainingTrackToColor.begin();
-      iterT != remainingTrackToColor.end();
-      ++iterT)
+    IndexT bestViewId = UndefinedIndexT;
+    std::size_t bestNbObservations = 0;
+    for(const auto& observationPair : landmarkPair.second.observations)
     {
-      const size_t trackId = *iterT;
-      const Observations & observations = sfmData.getLandmarks().at(trackId).observations;
-      for( Observations::const_iterator iterObs = observations.begin();
-        iterObs != observations.end(); ++iterObs)
+      const std::size_t nbObservations = nbObservationsPerView.at(observationPair.first);
+      if(nbObservations > bestNbObservations)
       {
-        const size_t viewId = iterObs->first;
-        if (map_IndexCardinal.find(viewId) == map_IndexCardinal.end())
-          map_IndexCardinal[viewId] = 1;
-        else
-          ++map_IndexCardinal[viewId];
+        bestViewId = observationPair.first;
+        bestNbObservations = nbObservations;
       }
     }
+    if(bestViewId != UndefinedIndexT)
+      landmarksPerView[bestViewId].push_back(&landmarkPair.second);
+  }
 
-    // Find the View index that is the most represented
-    std::vector<IndexT> vec_cardinal;
-    std::transform(map_IndexCardinal.begin(),
-      map_IndexCardinal.end(),
-      std::back_inserter(vec_cardinal),
-      stl::RetrieveValue());
-    using namespace stl::indexed_sort;
-    std::vector< sort_index_packet_descend< IndexT, IndexT> > packet_vec(vec_cardinal.size());
-    sort_index_helper(packet_vec, &vec_cardinal[0], 1);
-
-    // First image index with the most of occurrence
-    std::map<IndexT, IndexT>::const_iterator iterTT = map_IndexCardinal.begin();
-    std::advance(iterTT, packet_vec[0].index);
-    const size_t view_index = iterTT->first;
-    const View * view = sfmData.getViews().at(view_index).get();
-    const std::string sView_filename = view->getImagePath();
-    Image<RGBColor> image;
+  std::vector<const std::pair<const IndexT, std::vector<Landmark*>>*> viewsToRead;
+  viewsToRead.reserve(landmarksPerView.size());
+  for(const auto& viewLandmarks : landmarksPerView)
+    viewsToRead.push_back(&viewLandmarks);
 
-    readImage(sView_filename, image);
+  ALICEVISION_LOG_INFO("Compute scene structure color: " << landmarks.size() << " landmarks from " << viewsToRead.size() << " views.");
 
-    // Iterate through the remaining track to color
-    // - look if the current view is present to color the track
-    std::set<IndexT> set_toRemove;
-    for (std::set<IndexT>::const_iterator
-      iterT = remainingTrackToColor.begin();
-      iterT != remainingTrackToColor.end();
-      ++iterT)
-    {
-      const size_t trackId = *iterT;
-      const Observations & observations = sfmData.getLandmarks().at(trackId).observations;
-      Observations::const_iterator it = observations.find(view_index);
+  boost::progress_display my_progress_bar(landmarks.size(),
+                                     std::cout,
+                                     "\nCompute scene structure color\n");
 
-      if (it != observations.end())
-      {
-        // Color the track
-        Vec2 pt = it->second.x;
-        // Clamp the pixel position if the feature/marker center is outside the image.
-        pt.x() = clamp(pt.x(), 0.0, double(image.Width()-1));
-        pt.y() = clamp(pt.y(), 0.0, double(image.Height()-1));
-        sfmData.structure.at(trackId).rgb = image(pt.y(), pt.x());
-        set_toRemove.insert(trackId);
-        ++my_progress_bar;
-      }
+  std::exception_ptr readError;
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(viewsToRead.size()); ++i)
+  {
+    const IndexT viewId = viewsToRead[i]->first;
+    const std::vector<Landmark*>& viewLandmarks = viewsToRead[i]->second;
+
+    Image<RGBColor> image;
+    try
+    {
+      readImage(sfmData.getViews().at(viewId)->getImagePath(), image);
     }
-    // Remove colored track
-    for (std::set<IndexT>::const_iterator iter = set_toRemove.begin();
-      iter != set_toRemove.end(); ++iter)
+    catch(...)
     {
-      remainingTrackToColor.erase(*iter);
+      #pragma omp critical
+      readError = std::current_exception();
+      continue;
     }
+
+    for(Landmark* landmark : viewLandmarks)
+    {
+      Vec2 pt = landmark->observations.at(viewId).x;
+      // Clamp the pixel position if the feature/marker center is outside the image.
+      pt.x() = clamp(pt.x(), 0.0, double(image.Width()-1));
+      pt.y() = clamp(pt.y(), 0.0, double(image.Height()-1));
+      landmark->rgb = image(pt.y(), pt.x());
+    }
+
+    #pragma omp critical
+    my_progress_bar += viewLandmarks.size();
   }
+
+  if(readError)
+    std::rethrow_exception(readError);
+
   return true;
 }
 
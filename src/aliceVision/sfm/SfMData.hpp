@@ -13,6 +13,7 @@
 #include <aliceVision/sfm/Rig.hpp>
 #include <aliceVision/sfm/Landmark.hpp>
 #include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
 
 #include <stdexcept>
 #include <cassert>
@@ -436,5 +437,17 @@ private:
  */
 bool colorizeTracks(SfMData& sfmData);
 
+/**
+ * @brief Estimated memory used by the landmarks and their observations (bytes), for the system::MemoryAccounting
+ * @note the node overhead of the HashMap is estimated as the one of a std::map
+ */
+inline std::size_t getMemorySize(const Landmarks& landmarks)
+{
+  std::size_t size = landmarks.size() * (sizeof(Landmarks::value_type) + system::mapNodeOverhead);
+  for(const auto& landmark : landmarks)
+    size += landmark.second.observations.capacity() * sizeof(Observations::value_type);
+  return size;
+}
+
 } // namespace sfm
 } // namespace aliceVision
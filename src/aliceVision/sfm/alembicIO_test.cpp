@@ -5,6 +5,7 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include "AlembicExporter.hpp"
 #include "AlembicImporter.hpp"
 #include "SfMData.hpp"
 #include "sfmDataIO.hpp"
@@ -262,3 +263,45 @@ BOOST_AUTO_TEST_CASE(AlembicImporter_importExport) {
     }
 
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a random scene
+// - Export to Alembic with the cameras batch
+// - Import from Alembic
+// - Import only the cameras
+//-----------------
+BOOST_AUTO_TEST_CASE(AlembicImporter_camerasBatch) {
+
+    // Create a random scene
+    SfMData sfmData = createTestScene(5, 50, 2, 3, false);
+    sfmData.getIntrinsics().at(0)->lock();
+    sfmData.getPoses().begin()->second.lock();
+
+    const std::string abcFile = "camerasBatch.abc";
+    {
+        AlembicExporter(abcFile).addSfM(sfmData, ALL, true);
+    }
+
+    // Reload
+    {
+        SfMData sfmAbc;
+        BOOST_CHECK(Load(sfmAbc, abcFile, ALL));
+        BOOST_CHECK(sfmData == sfmAbc);
+        BOOST_CHECK(sfmAbc.getIntrinsics().at(0)->isLocked());
+        BOOST_CHECK(sfmAbc.getPoses().at(sfmData.getPoses().begin()->first).isLocked());
+        BOOST_CHECK(sfmAbc.getViews().at(0)->getMetadata() == sfmData.getViews().at(0)->getMetadata());
+    }
+
+    // Reload (only a subpart: the cameras)
+    {
+        SfMData sfmAbc;
+        BOOST_CHECK(Load(sfmAbc, abcFile, ESfMData(VIEWS | INTRINSICS | EXTRINSICS)));
+        BOOST_CHECK_EQUAL( sfmData.views.size(), sfmAbc.views.size());
+        BOOST_CHECK_EQUAL( sfmData.getPoses().size(), sfmAbc.getPoses().size());
+        BOOST_CHECK_EQUAL( sfmData.getRigs().size(), sfmAbc.getRigs().size());
+        BOOST_CHECK_EQUAL( sfmData.intrinsics.size(), sfmAbc.intrinsics.size());
+        BOOST_CHECK_EQUAL( 0, sfmAbc.structure.size());
+    }
+}
@@ -7,11 +7,13 @@
 
 #include "aliceVision/multiview/NViewDataSet.hpp"
 #include "aliceVision/sfm/sfm.hpp"
+#include "aliceVision/sfm/PartitionedBundleAdjustmentCeres.hpp"
 #include "../camera/cameraCommon.hpp"
 
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <set>
 
 #define BOOST_TEST_MODULE bundleAdjustment
 #include <boost/test/included/unit_test.hpp>
@@ -200,7 +202,7 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   // 2. Compute the graph-distance between each newly reconstructed views and all the reconstructed views
   localBAData.computeGraphDistances(sfmData, newReconstructedViews);
   // 3. Use the graph-distances to assign a LBA state (Refine, Constant & Ignore) for each parameter (poses, intrinsics & landmarks)
-  localBAData.convertDistancesToLBAStates(sfmData); 
+  localBAData.convertDistancesToLBAStates(sfmData, tracksPerView);
 
   BOOST_CHECK( localBAData.getNumOfRefinedPoses() == 2 );     // v0 & v1
   BOOST_CHECK( localBAData.getNumOfConstantPoses() == 1 );    // v2
@@ -208,6 +210,7 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK( localBAData.getNumOfRefinedLandmarks() == 2 ); // p0 & p1
   BOOST_CHECK( localBAData.getNumOfConstantLandmarks() == 0 );
   BOOST_CHECK( localBAData.getNumOfIgnoredLandmarks() == 1 ); // p2
+  BOOST_CHECK( localBAData.getActiveLandmarks().size() == 2 ); // p0 & p1
 
   std::shared_ptr<LocalBundleAdjustmentCeres> lba_object = std::make_shared<LocalBundleAdjustmentCeres>(localBAData, options, newReconstructedViews);
   BOOST_CHECK( lba_object->Adjust(sfmData, localBAData) );
@@ -234,6 +237,87 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK( dResidual_before > dResidual_after);
 }
 
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AdaptiveSolver) {
+
+  const int nviews = 4;
+  const int npoints = 6;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // all the views see all the points
+  const BundleAdjustmentCeres::BA_problemSize problemSize(sfmData);
+  BOOST_CHECK_EQUAL(problemSize._nbPoses, nviews);
+  BOOST_CHECK_EQUAL(problemSize._nbLandmarks, npoints);
+  BOOST_CHECK_EQUAL(problemSize._nbResidualBlocks, nviews * npoints);
+  BOOST_CHECK_EQUAL(problemSize._nbCovisiblePosePairs, nviews * (nviews - 1) / 2);
+  BOOST_CHECK_EQUAL(problemSize.getReducedCameraDensity(), 1.0);
+
+  // small problem: dense Schur complement with a single thread
+  BundleAdjustmentCeres::BA_options options;
+  options.setAdaptiveBA(problemSize);
+  BOOST_CHECK(options._linear_solver_type == ceres::DENSE_SCHUR);
+  BOOST_CHECK_EQUAL(options._nbJacobianThreads, 1);
+  BOOST_CHECK_EQUAL(options._nbLinearSolverThreads, 1);
+
+  // large problem with a dense reduced camera system: iterative Schur
+  BundleAdjustmentCeres::BA_problemSize largeProblemSize;
+  largeProblemSize._nbPoses = 10000;
+  largeProblemSize._nbLandmarks = 1000000;
+  largeProblemSize._nbResidualBlocks = 5000000;
+  largeProblemSize._nbCovisiblePosePairs = 10000 * 2000;
+  options.setAdaptiveBA(largeProblemSize);
+  BOOST_CHECK(options._linear_solver_type == ceres::ITERATIVE_SCHUR);
+  BOOST_CHECK(options._preconditioner_type == ceres::SCHUR_JACOBI);
+  BOOST_CHECK_EQUAL(options._nbJacobianThreads, options._nbThreads);
+
+  // large problem with a sparse reduced camera system (video sequence)
+  largeProblemSize._nbCovisiblePosePairs = 10000 * 10;
+  options.setAdaptiveBA(largeProblemSize);
+  BOOST_CHECK(options._linear_solver_type == ceres::SPARSE_SCHUR ||
+              options._linear_solver_type == ceres::ITERATIVE_SCHUR);
+
+  // the statistics contain the solver iterations
+  BundleAdjustmentCeres ba_object(options);
+  BOOST_CHECK( ba_object.Adjust(sfmData) );
+  const BundleAdjustmentCeres::BA_statistics& statistics = ba_object.getStatistics();
+  BOOST_CHECK(!statistics._iterations.empty());
+  BOOST_CHECK_GE(statistics._time, statistics._linearSolverTime);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned_CamerasRing) {
+
+  const int nviews = 12;
+  const int npoints = 40;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+
+  // the submaps cover all the poses once
+  const std::size_t maxNbPosesPerSubmap = 4;
+  const std::vector<std::vector<IndexT>> submaps = PartitionedBundleAdjustmentCeres::partitionPoses(sfmData, maxNbPosesPerSubmap);
+  BOOST_CHECK_GE(submaps.size(), nviews / maxNbPosesPerSubmap);
+
+  std::set<IndexT> poses;
+  for(const std::vector<IndexT>& submap : submaps)
+  {
+    BOOST_CHECK_LE(submap.size(), maxNbPosesPerSubmap);
+    poses.insert(submap.begin(), submap.end());
+  }
+  BOOST_CHECK_EQUAL(poses.size(), nviews);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  PartitionedBundleAdjustmentCeres::PBA_options options;
+  options._maxNbPosesPerSubmap = maxNbPosesPerSubmap;
+  options._maxNbSeparatorPoses = 2;
+  std::shared_ptr<BundleAdjustment> ba_object = std::make_shared<PartitionedBundleAdjustmentCeres>(options);
+  BOOST_CHECK( ba_object->Adjust(sfmData) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK( dResidual_before > dResidual_after);
+}
+
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfMData & sfm_data)
 {
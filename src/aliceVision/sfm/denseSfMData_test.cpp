@@ -0,0 +1,135 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/sfm/DenseSfMData.hpp"
+#include "aliceVision/sfm/sfmDataFilters.hpp"
+
+#define BOOST_TEST_MODULE denseSfMData
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+// Test summary:
+// - Create a small scene with a rig, a view without pose and landmarks
+// - Check the slots, the view poses and the CSR observations of the dense index
+// - Check the observations removed by RemoveOutliers_PixelResidualError
+
+namespace {
+
+/**
+ * @brief 4 views looking at the Z axis: 2 independent views, 1 rig view and 1 view without pose.
+ *        Each landmark is seen by the 3 posed views.
+ */
+SfMData createScene(std::size_t nbLandmarks)
+{
+  SfMData sfmData;
+  sfmData.intrinsics[0] = std::make_shared<camera::Pinhole>(1000, 1000, 1000.0, 500.0, 500.0);
+
+  for(IndexT viewId = 0; viewId < 4; ++viewId)
+    sfmData.views[viewId] = std::make_shared<View>("", viewId, 0, viewId, 1000, 1000);
+
+  sfmData.setPose(*sfmData.views.at(0), CameraPose(geometry::Pose3(Mat3::Identity(), Vec3(0.0, 0.0, 0.0))));
+  sfmData.setPose(*sfmData.views.at(1), CameraPose(geometry::Pose3(Mat3::Identity(), Vec3(1.0, 0.0, 0.0))));
+
+  // rig view: pose 2 and sub-pose 0
+  sfmData.views.at(2)->setRigAndSubPoseId(0, 0);
+  sfmData.getRigs()[0] = Rig(1);
+  sfmData.getRigs().at(0).setSubPose(0, RigSubPose(geometry::Pose3(Mat3::Identity(), Vec3(0.0, 1.0, 0.0)), ERigSubPoseStatus::CONSTANT));
+  sfmData.getPoses()[2] = CameraPose(geometry::Pose3(Mat3::Identity(), Vec3(0.0, -1.0, 0.0)));
+
+  for(IndexT landmarkId = 0; landmarkId < nbLandmarks; ++landmarkId)
+  {
+    Landmark landmark(Vec3(0.1 * landmarkId, 0.2, 10.0), feature::EImageDescriberType::SIFT);
+    for(IndexT viewId = 0; viewId < 3; ++viewId)
+    {
+      const View& view = *sfmData.views.at(viewId);
+      const Vec2 x = sfmData.intrinsics.at(0)->project(sfmData.getPose(view).getTransform(), landmark.X);
+      landmark.observations[viewId] = Observation(x, 10 * landmarkId + viewId);
+    }
+    sfmData.structure[100 + landmarkId] = landmark;
+  }
+  return sfmData;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(DENSE_SFMDATA_Index)
+{
+  const std::size_t nbLandmarks = 5;
+  const SfMData sfmData = createScene(nbLandmarks);
+  const DenseSfMData denseSfMData(sfmData);
+
+  BOOST_CHECK_EQUAL(denseSfMData.getNbViews(), 4);
+  BOOST_CHECK_EQUAL(denseSfMData.getNbLandmarks(), nbLandmarks);
+  BOOST_CHECK_EQUAL(denseSfMData.getNbObservations(), 3 * nbLandmarks);
+  BOOST_CHECK_EQUAL(denseSfMData.getViewSlot(42), DenseSfMData::UndefinedSlot);
+  BOOST_CHECK_EQUAL(denseSfMData.getLandmarkSlot(42), DenseSfMData::UndefinedSlot);
+
+  // views
+  for(const auto& viewIt : sfmData.getViews())
+  {
+    const std::uint32_t viewSlot = denseSfMData.getViewSlot(viewIt.first);
+    BOOST_REQUIRE(viewSlot != DenseSfMData::UndefinedSlot);
+    BOOST_CHECK_EQUAL(denseSfMData.getViewId(viewSlot), viewIt.first);
+    BOOST_CHECK_EQUAL(denseSfMData.isPoseAndIntrinsicDefined(viewSlot), sfmData.isPoseAndIntrinsicDefined(viewIt.second.get()));
+
+    if(denseSfMData.isPoseAndIntrinsicDefined(viewSlot))
+    {
+      // with the rig sub-pose
+      BOOST_CHECK(denseSfMData.getPose(viewSlot) == sfmData.getPose(*viewIt.second).getTransform());
+      BOOST_CHECK_EQUAL(denseSfMData.getIntrinsic(viewSlot), sfmData.getIntrinsics().at(0).get());
+    }
+  }
+  BOOST_CHECK_SMALL(denseSfMData.getPose(denseSfMData.getViewSlot(2)).center().norm(), 1e-12);
+
+  // landmarks & observations
+  for(const auto& landmarkIt : sfmData.getLandmarks())
+  {
+    const std::uint32_t landmarkSlot = denseSfMData.getLandmarkSlot(landmarkIt.first);
+    BOOST_REQUIRE(landmarkSlot != DenseSfMData::UndefinedSlot);
+    BOOST_CHECK_EQUAL(denseSfMData.getLandmarkId(landmarkSlot), landmarkIt.first);
+    BOOST_CHECK(denseSfMData.getLandmarkPosition(landmarkSlot) == landmarkIt.second.X);
+
+    const Observations& observations = landmarkIt.second.observations;
+    BOOST_REQUIRE_EQUAL(denseSfMData.getObservationsEnd(landmarkSlot) - denseSfMData.getObservationsBegin(landmarkSlot), observations.size());
+
+    std::size_t obs = denseSfMData.getObservationsBegin(landmarkSlot);
+    for(const auto& observationIt : observations)
+    {
+      BOOST_CHECK_EQUAL(denseSfMData.getViewId(denseSfMData.getObservationView(obs)), observationIt.first);
+      BOOST_CHECK(denseSfMData.getObservationPoint(obs) == observationIt.second.x);
+      BOOST_CHECK_EQUAL(denseSfMData.getObservationFeature(obs), observationIt.second.id_feat);
+      ++obs;
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DENSE_SFMDATA_RemoveOutliers_PixelResidualError)
+{
+  const std::size_t nbLandmarks = 5;
+  SfMData sfmData = createScene(nbLandmarks);
+
+  // one outlier observation on the landmark 100 and two on the landmark 101
+  sfmData.structure.at(100).observations.at(2).x += Vec2(10.0, 0.0);
+  sfmData.structure.at(101).observations.at(0).x += Vec2(0.0, 10.0);
+  sfmData.structure.at(101).observations.at(1).x += Vec2(10.0, 10.0);
+
+  BOOST_CHECK_EQUAL(RemoveOutliers_PixelResidualError(sfmData, 4.0, 2), 3);
+
+  // the landmark 101 has a single observation left
+  BOOST_CHECK_EQUAL(sfmData.structure.size(), nbLandmarks - 1);
+  BOOST_CHECK(sfmData.structure.find(101) == sfmData.structure.end());
+
+  const Observations& observations = sfmData.structure.at(100).observations;
+  BOOST_CHECK_EQUAL(observations.size(), 2);
+  BOOST_CHECK(observations.find(2) == observations.end());
+  // the compacted observations are kept sorted with their features
+  BOOST_CHECK_EQUAL(observations.begin()->first, 0);
+  BOOST_CHECK_EQUAL(observations.at(1).id_feat, 1);
+  BOOST_CHECK_EQUAL(sfmData.structure.at(102).observations.size(), 3);
+}
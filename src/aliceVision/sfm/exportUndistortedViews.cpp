@@ -0,0 +1,251 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "exportUndistortedViews.hpp"
+
+#include <aliceVision/camera/cameraUndistortImage.hpp>
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/image/resampling.hpp>
+
+#include <boost/progress.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace aliceVision {
+namespace sfm {
+
+using namespace aliceVision::image;
+
+namespace {
+
+/**
+ * @brief Bounded queue between two stages of the export pipeline.
+ * push() waits while the queue is full, pop() waits while it is empty.
+ */
+template<typename T>
+class StageQueue
+{
+public:
+  explicit StageQueue(std::size_t capacity)
+    : _capacity(capacity)
+  {}
+
+  /// @return false if the pipeline is stopped
+  bool push(T item)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [&]{ return _stopped || _items.size() < _capacity; });
+    if(_stopped)
+      return false;
+    _items.push_back(std::move(item));
+    _notEmpty.notify_one();
+    return true;
+  }
+
+  /// @return false if the pipeline is stopped or if all the producers are done and the queue is empty
+  bool pop(T& item)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [&]{ return _stopped || !_items.empty() || _nbProducers == 0; });
+    if(_stopped || _items.empty())
+      return false;
+    item = std::move(_items.front());
+    _items.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  void addProducers(std::size_t nbProducers)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _nbProducers += nbProducers;
+  }
+
+  /// a producer is done, the consumers stop when the last one is done and the queue is empty
+  void producerDone()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(--_nbProducers == 0)
+      _notEmpty.notify_all();
+  }
+
+  void stop()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+    _notFull.notify_all();
+    _notEmpty.notify_all();
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _notFull;
+  std::condition_variable _notEmpty;
+  std::deque<T> _items;
+  std::size_t _capacity;
+  std::size_t _nbProducers = 0;
+  bool _stopped = false;
+};
+
+/**
+ * @brief Image of a view between the stages of the export pipeline
+ */
+struct ViewImage
+{
+  IndexT viewId = UndefinedIndexT;
+  std::shared_ptr<Image<RGBfColor>> image;
+};
+
+} // namespace
+
+void exportUndistortedViews(const SfMData& sfmData,
+                            const std::vector<IndexT>& viewIds,
+                            const UndistortedViewsExportParams& params,
+                            const EncodeViewFunction& encodeView,
+                            const ExportViewSourceFunction& exportViewSource)
+{
+  if(params.nbDecodeThreads < 1 || params.nbUndistortThreads < 1 || params.nbEncodeThreads < 1)
+    throw std::invalid_argument("Each stage of the export needs at least one thread.");
+
+  boost::progress_display progressBar(viewIds.size(), std::cout, params.progressTitle);
+  std::mutex progressMutex;
+
+  const auto progress = [&]()
+  {
+    std::lock_guard<std::mutex> lock(progressMutex);
+    ++progressBar;
+  };
+
+  StageQueue<ViewImage> decodedQueue(params.nbUndistortThreads + 1);
+  StageQueue<ViewImage> undistortedQueue(params.nbEncodeThreads + 1);
+  decodedQueue.addProducers(params.nbDecodeThreads);
+  undistortedQueue.addProducers(params.nbUndistortThreads);
+
+  std::atomic<std::size_t> nextView(0);
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  // stop all the stages on the first error
+  const auto stop = [&](std::exception_ptr exception)
+  {
+    {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if(!error)
+        error = exception;
+    }
+    decodedQueue.stop();
+    undistortedQueue.stop();
+  };
+
+  const auto decode = [&]()
+  {
+    try
+    {
+      for(std::size_t i = nextView++; i < viewIds.size(); i = nextView++)
+      {
+        const View& view = *sfmData.getViews().at(viewIds[i]);
+        if(exportViewSource && exportViewSource(view))
+        {
+          progress();
+          continue;
+        }
+
+        ViewImage viewImage;
+        viewImage.viewId = viewIds[i];
+        viewImage.image = std::make_shared<Image<RGBfColor>>();
+        readImage(view.getImagePath(), *viewImage.image);
+        if(!decodedQueue.push(std::move(viewImage)))
+          break;
+      }
+    }
+    catch(...)
+    {
+      stop(std::current_exception());
+    }
+    decodedQueue.producerDone();
+  };
+
+  const auto undistort = [&]()
+  {
+    try
+    {
+      ViewImage viewImage;
+      while(decodedQueue.pop(viewImage))
+      {
+        const View& view = *sfmData.getViews().at(viewImage.viewId);
+        const camera::IntrinsicBase* cam = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+
+        if(cam != nullptr && cam->isValid() && cam->have_disto())
+        {
+          // the undistortion map is computed once per intrinsic and image size
+          const std::shared_ptr<const camera::UndistortionMap> map =
+            camera::getUndistortionMap(cam, viewImage.image->Width(), viewImage.image->Height(), params.correctPrincipalPoint);
+          std::shared_ptr<Image<RGBfColor>> image_ud = std::make_shared<Image<RGBfColor>>();
+          camera::UndistortImage(*viewImage.image, *map, *image_ud, FBLACK);
+          viewImage.image = image_ud;
+        }
+
+        for(int scale = 1; scale < params.downscale; scale *= 2)
+        {
+          std::shared_ptr<Image<RGBfColor>> image_half = std::make_shared<Image<RGBfColor>>();
+          ImageBoxHalfSample(*viewImage.image, *image_half);
+          viewImage.image = image_half;
+        }
+
+        if(!undistortedQueue.push(std::move(viewImage)))
+          break;
+      }
+    }
+    catch(...)
+    {
+      stop(std::current_exception());
+    }
+    undistortedQueue.producerDone();
+  };
+
+  const auto encode = [&]()
+  {
+    try
+    {
+      ViewImage viewImage;
+      while(undistortedQueue.pop(viewImage))
+      {
+        encodeView(*sfmData.getViews().at(viewImage.viewId), *viewImage.image);
+        viewImage.image.reset();
+        progress();
+      }
+    }
+    catch(...)
+    {
+      stop(std::current_exception());
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(int i = 0; i < params.nbDecodeThreads; ++i)
+    threads.emplace_back(decode);
+  for(int i = 0; i < params.nbUndistortThreads; ++i)
+    threads.emplace_back(undistort);
+  for(int i = 0; i < params.nbEncodeThreads; ++i)
+    threads.emplace_back(encode);
+
+  for(std::thread& thread : threads)
+    thread.join();
+
+  if(error)
+    std::rethrow_exception(error);
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,69 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Parameters of the undistorted views export
+ */
+struct UndistortedViewsExportParams
+{
+  /// number of threads of the decoding, undistortion and encoding stages
+  int nbDecodeThreads = 2;
+  int nbUndistortThreads = 1;
+  int nbEncodeThreads = 3;
+  /// downscale factor of the exported images (power of 2)
+  int downscale = 1;
+  /// move the principal point of the pinhole cameras to the image center
+  bool correctPrincipalPoint = false;
+  /// title of the progress bar
+  std::string progressTitle = "Exporting the undistorted images\n";
+};
+
+/**
+ * @brief Export a view without decoding its image (e.g. a copy of the source image)
+ * @return false if the image of the view should be decoded, undistorted and encoded
+ */
+using ExportViewSourceFunction = std::function<bool(const View& view)>;
+
+/**
+ * @brief Encode the undistorted image of a view (and its other files)
+ */
+using EncodeViewFunction = std::function<void(const View& view, const image::Image<image::RGBfColor>& image)>;
+
+/**
+ * @brief Export the undistorted images of the views with a pipeline of three thread pools, connected by bounded queues:
+ *   - decoding of the source images
+ *   - undistortion with the cached undistortion map of each intrinsic, and downscale
+ *   - encoding, by the exporter
+ * The queues hold at most one image per thread of the next stage, to bound the memory.
+ * The functions are called concurrently from the threads of their stage.
+ * @param[in] sfmData The views and their intrinsics
+ * @param[in] viewIds The views to export
+ * @param[in] params The export parameters
+ * @param[in] encodeView Encode the undistorted image of a view
+ * @param[in] exportViewSource Optional, export a view without decoding it
+ * @throw the first exception of the stages, all the stages are stopped
+ */
+void exportUndistortedViews(const SfMData& sfmData,
+                            const std::vector<IndexT>& viewIds,
+                            const UndistortedViewsExportParams& params,
+                            const EncodeViewFunction& encodeView,
+                            const ExportViewSourceFunction& exportViewSource = ExportViewSourceFunction());
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,82 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/multiview/NViewDataSet.hpp"
+#include "aliceVision/sfm/sfm.hpp"
+#include "aliceVision/sfm/FrustumFilter.hpp"
+#include "aliceVision/sfm/utils/syntheticScene.hpp"
+
+#include <iostream>
+
+#define BOOST_TEST_MODULE frustumFilter
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+using namespace aliceVision::sfm;
+
+// Test all the pairs of frustums
+PairSet getExhaustiveIntersectionPairs(const FrustumFilter & frustumFilter)
+{
+  PairSet pairs;
+  const FrustumFilter::FrustumsT & frustums = frustumFilter.getFrustums();
+  for (const auto & frustumI : frustums)
+  {
+    for (const auto & frustumJ : frustums)
+    {
+      if (frustumI.first < frustumJ.first && frustumI.second.intersect(frustumJ.second))
+        pairs.insert(std::make_pair(frustumI.first, frustumJ.first));
+    }
+  }
+  return pairs;
+}
+
+// Test summary:
+// - Create a SfMData scene from a synthetic dataset: cameras on a ring looking at the center
+// - Check that the pairs found with the bounding boxes pruning are the pairs of the exhaustive test
+
+BOOST_AUTO_TEST_CASE(FRUSTUM_FILTER_TruncatedFromStructure)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(24, 32, config);
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+
+  const FrustumFilter frustumFilter(sfmData);
+  BOOST_CHECK_EQUAL(frustumFilter.getFrustums().size(), sfmData.getViews().size());
+
+  const PairSet pairs = frustumFilter.getFrustumIntersectionPairs();
+  BOOST_CHECK(!pairs.empty());
+  BOOST_CHECK(pairs == getExhaustiveIntersectionPairs(frustumFilter));
+}
+
+BOOST_AUTO_TEST_CASE(FRUSTUM_FILTER_TruncatedNearFar)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(24, 32, config);
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // short frustums: only the close cameras of the ring intersect
+  const FrustumFilter frustumFilter(sfmData, 0.1, 0.5);
+
+  const PairSet pairs = frustumFilter.getFrustumIntersectionPairs();
+  const PairSet exhaustivePairs = getExhaustiveIntersectionPairs(frustumFilter);
+  BOOST_CHECK(pairs == exhaustivePairs);
+  BOOST_CHECK(pairs.size() < sfmData.getViews().size() * (sfmData.getViews().size() - 1) / 2);
+}
+
+BOOST_AUTO_TEST_CASE(FRUSTUM_FILTER_Infinite)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(12, 32, config);
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+  sfmData.structure.clear();
+
+  const FrustumFilter frustumFilter(sfmData);
+  for (const auto & frustum : frustumFilter.getFrustums())
+    BOOST_CHECK(frustum.second.isInfinite());
+
+  BOOST_CHECK(frustumFilter.getFrustumIntersectionPairs() == getExhaustiveIntersectionPairs(frustumFilter));
+}
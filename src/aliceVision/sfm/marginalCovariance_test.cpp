@@ -0,0 +1,115 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/utils/marginalCovariance.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE marginalCovariance
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+// Random Jacobian with the bundle adjustment structure:
+// 2 rows per observation, with a pose block (6 columns) and a landmark block (3 columns)
+sRMat createRandomJacobian(std::size_t nbPoses, std::size_t nbLandmarks)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  std::size_t row = 0;
+  for(std::size_t p = 0; p < nbLandmarks; ++p)
+  {
+    for(std::size_t i = 0; i < nbPoses; ++i)
+    {
+      if((p + i) % 3 == 0 && i != 0) // partial visibility
+        continue;
+      for(int r = 0; r < 2; ++r, ++row)
+      {
+        for(int c = 0; c < 6; ++c)
+          triplets.emplace_back(row, 6 * i + c, value(generator));
+        for(int c = 0; c < 3; ++c)
+          triplets.emplace_back(row, 6 * nbPoses + 3 * p + c, value(generator));
+      }
+    }
+  }
+  sRMat jacobian(row, 6 * nbPoses + 3 * nbLandmarks);
+  jacobian.setFromTriplets(triplets.begin(), triplets.end());
+  return jacobian;
+}
+
+BOOST_AUTO_TEST_CASE(MarginalCovariance_sameAsDenseInverse)
+{
+  const std::size_t nbPoses = 5;
+  const std::size_t nbLandmarks = 30;
+  const sRMat jacobian = createRandomJacobian(nbPoses, nbLandmarks);
+
+  const MarginalCovariance marginalCovariance(jacobian, nbPoses, nbLandmarks);
+  BOOST_CHECK(marginalCovariance.isValid());
+
+  // Dense reference: remove the gauge columns (first pose and first translation coordinate of the second pose)
+  const Mat J = Mat(jacobian);
+  std::vector<int> freeColumns;
+  for(int c = 6; c < J.cols(); ++c)
+  {
+    if(c != 9)
+      freeColumns.push_back(c);
+  }
+  Mat freeJ(J.rows(), freeColumns.size());
+  for(std::size_t c = 0; c < freeColumns.size(); ++c)
+    freeJ.col(c) = J.col(freeColumns[c]);
+  const Mat covariance = (freeJ.transpose() * freeJ).inverse();
+
+  const auto getDenseColumn = [&freeColumns](int column)
+  {
+    return std::find(freeColumns.begin(), freeColumns.end(), column) - freeColumns.begin();
+  };
+
+  // Poses
+  std::vector<Mat6, Eigen::aligned_allocator<Mat6>> poseCovariances;
+  marginalCovariance.computePoseCovariances(poseCovariances);
+  BOOST_CHECK_EQUAL(poseCovariances.size(), nbPoses);
+  BOOST_CHECK_SMALL(poseCovariances[0].norm(), 1e-12);
+
+  for(std::size_t i = 1; i < nbPoses; ++i)
+  {
+    for(int a = 0; a < 6; ++a)
+    {
+      for(int b = 0; b < 6; ++b)
+      {
+        const int columnA = 6 * i + a;
+        const int columnB = 6 * i + b;
+        const double expected = (columnA == 9 || columnB == 9) ? 0.0 : covariance(getDenseColumn(columnA), getDenseColumn(columnB));
+        BOOST_CHECK_SMALL(poseCovariances[i](a, b) - expected, 1e-8);
+      }
+    }
+  }
+
+  // Landmark subset
+  const std::vector<std::size_t> landmarkIndexes = {0, 7, 29};
+  std::vector<Mat3> landmarkCovariances;
+  std::vector<bool> validLandmarks;
+  marginalCovariance.computeLandmarkCovariances(landmarkIndexes, landmarkCovariances, validLandmarks);
+  BOOST_CHECK_EQUAL(landmarkCovariances.size(), landmarkIndexes.size());
+
+  for(std::size_t l = 0; l < landmarkIndexes.size(); ++l)
+  {
+    BOOST_CHECK(validLandmarks[l]);
+    const int column = getDenseColumn(6 * nbPoses + 3 * landmarkIndexes[l]);
+    const Mat3 expected = covariance.block<3, 3>(column, column);
+    BOOST_CHECK_SMALL((landmarkCovariances[l] - expected).norm(), 1e-8);
+  }
+
+  // All the landmarks
+  marginalCovariance.computeLandmarkCovariances({}, landmarkCovariances, validLandmarks);
+  BOOST_CHECK_EQUAL(landmarkCovariances.size(), nbLandmarks);
+  BOOST_CHECK_SMALL((landmarkCovariances[7] - covariance.block<3, 3>(getDenseColumn(6 * nbPoses + 21), getDenseColumn(6 * nbPoses + 21))).norm(), 1e-8);
+}
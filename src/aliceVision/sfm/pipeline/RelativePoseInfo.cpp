@@ -118,6 +118,45 @@ bool robustRelativePose(
   return true;
 }
 
+bool relativePoseFromEssential(
+  const Mat3 & K1, const Mat3 & K2,
+  const Mat & x1, const Mat & x2,
+  const Mat3 & E,
+  double maxResidual,
+  RelativePoseInfo & relativePose_info)
+{
+  typedef aliceVision::essential::kernel::FivePointKernel SolverType;
+
+  Mat3 F;
+  FundamentalFromEssential(E, K1, K2, &F);
+
+  // inliers of the given model
+  const double maxSquaredResidual = Square(maxResidual);
+  relativePose_info.vec_inliers.clear();
+  for(Mat::Index i = 0; i < x1.cols(); ++i)
+  {
+    if(aliceVision::fundamental::kernel::EpipolarDistanceError::Error(F, x1.col(i), x2.col(i)) <= maxSquaredResidual)
+      relativePose_info.vec_inliers.push_back(i);
+  }
+  relativePose_info.essential_matrix = E;
+  relativePose_info.found_residual_precision = maxResidual;
+
+  if (relativePose_info.vec_inliers.size() < SolverType::MINIMUM_SAMPLES * ALICEVISION_MINIMUM_SAMPLES_COEF )
+    return false; // no sufficient coverage (the model does not support enough samples)
+
+  // estimation of the relative poses
+  Mat3 R;
+  Vec3 t;
+  if (!estimate_Rt_fromE(
+    K1, K2, x1, x2,
+    relativePose_info.essential_matrix, relativePose_info.vec_inliers, &R, &t))
+    return false; // cannot find a valid [R|t] couple that makes the inliers in front of the camera.
+
+  // Store [R|C] for the second camera, since the first camera is [Id|0]
+  relativePose_info.relativePose = geometry::Pose3(R, -R.transpose() * t);
+  return true;
+}
+
 } // namespace sfm
 } // namespace aliceVision
 
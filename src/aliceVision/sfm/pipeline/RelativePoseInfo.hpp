@@ -73,5 +73,28 @@ bool robustRelativePose
   const size_t max_iteration_count = 4096
 );
 
+/**
+ * @brief Estimate the Relative pose between two views from point matches and K matrices
+ *  with an essential matrix already estimated (e.g. by the geometric filtering of the matching),
+ *  without robust estimation: the inliers are the points within the max. residual of the epipolar lines.
+ *
+ * @param[in] K1 camera 1 intrinsics
+ * @param[in] K2 camera 2 intrinsics
+ * @param[in] x1 camera 1 image points
+ * @param[in] x2 camera 2 image points
+ * @param[in] E essential matrix
+ * @param[in] maxResidual max. distance of the inliers to the epipolar lines (in the unit of the image points)
+ * @param[out] relativePose_info relative pose information
+ * @return false if E has not enough inliers or no valid [R|t], the pose should then be estimated robustly
+ */
+bool relativePoseFromEssential
+(
+  const Mat3 & K1, const Mat3 & K2,
+  const Mat & x1, const Mat & x2,
+  const Mat3 & E,
+  double maxResidual,
+  RelativePoseInfo & relativePose_info
+);
+
 } // namespace sfm
 } // namespace aliceVision
@@ -11,7 +11,6 @@
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/pipeline/global/reindexGlobalSfM.hpp>
-#include <aliceVision/sfm/pipeline/global/MutexSet.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/multiview/translationAveraging/common.hpp>
 #include <aliceVision/multiview/translationAveraging/solver.hpp>
@@ -32,12 +31,34 @@
 
 #include <boost/progress.hpp>
 
+#include <array>
+#include <atomic>
+
 namespace aliceVision{
 namespace sfm{
 
 using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
+/// Pairwise matches grouped by pair of poses (sorted pose ids)
+typedef std::map<Pair, std::vector<matching::PairwiseMatches::const_iterator> > PosePairMatches;
+
+/// List the pairwise matches between the views of a triplet of poses
+void getTripletMatches(
+  const PosePairMatches & posePairMatches,
+  const graph::Triplet & triplet,
+  matching::PairwiseMatches & tripletMatches)
+{
+  for (const Pair & posePair : {Pair(triplet.i, triplet.j), Pair(triplet.i, triplet.k), Pair(triplet.j, triplet.k)})
+  {
+    const auto it = posePairMatches.find(posePair);
+    if (it == posePairMatches.end())
+      continue;
+    for (const matching::PairwiseMatches::const_iterator & match_iterator : it->second)
+      tripletMatches.insert(*match_iterator);
+  }
+}
+
 /// Use features in normalized camera frames
 bool GlobalSfMTranslationAveragingSolver::Run(
   ETranslationAveragingMethod eTranslationAveragingMethod,
@@ -213,6 +234,32 @@ bool GlobalSfMTranslationAveragingSolver::Translation_averaging(
       }
       break;
 
+      case TRANSLATION_AVERAGING_IRLS:
+      {
+        std::vector<Vec3> vec_translations;
+        std::vector<bool> vec_inliers;
+        if (!translationAveraging::solve_translations_problem_irls(
+          vec_initialRijTijEstimates_cpy, true, iNview, vec_translations, &vec_inliers))
+        {
+          ALICEVISION_LOG_WARNING("Compute global translations: failed");
+          return false;
+        }
+        ALICEVISION_LOG_DEBUG("Translation averaging IRLS: "
+          << std::count(vec_inliers.begin(), vec_inliers.end(), true) << "/" << vec_inliers.size()
+          << " relative translations kept, timing (s): " << timerLP_translation.elapsed() << ".");
+
+        // A valid solution was found:
+        // - Update the view poses according the found camera translations
+        for (size_t i = 0; i < iNview; ++i)
+        {
+          const Vec3 & t = vec_translations[i];
+          const IndexT pose_id = _reindexBackward[i];
+          const Mat3 & Ri = map_globalR.at(pose_id);
+          sfm_data.setAbsolutePose(pose_id, CameraPose(Pose3(Ri, -Ri.transpose()*t)));
+        }
+      }
+      break;
+
       case TRANSLATION_AVERAGING_L2_DISTANCE_CHORDAL:
       {
         std::vector<int> vec_edges;
@@ -328,9 +375,11 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   std::transform(map_globalR.begin(), map_globalR.end(),
     std::inserter(set_pose_ids, set_pose_ids.begin()), stl::RetrieveKey());
   // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
+  PosePairMatches posePairMatches;
+  for (matching::PairwiseMatches::const_iterator match_iterator = pairwiseMatches.begin();
+    match_iterator != pairwiseMatches.end(); ++match_iterator)
   {
-    const Pair pair = match_iterator.first;
+    const Pair pair = match_iterator->first;
     const View * v1 = sfm_data.getViews().at(pair.first).get();
     const View * v2 = sfm_data.getViews().at(pair.second).get();
 
@@ -341,6 +390,10 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     {
       rotation_pose_id_graph.insert(
         std::make_pair(v1->getPoseId(), v2->getPoseId()));
+      const Pair posePair(
+        std::min(v1->getPoseId(), v2->getPoseId()),
+        std::max(v1->getPoseId(), v2->getPoseId()));
+      posePairMatches[posePair].push_back(match_iterator);
     }
   }
   // List putative triplets (from global rotations Ids)
@@ -348,44 +401,49 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     graph::tripletListing(rotation_pose_id_graph);
   ALICEVISION_LOG_DEBUG("#Triplets: " << vec_triplets.size());
 
+  // Precompute the read-only data of the views used by the triplets,
+  // so the threads do not query the SfMData and the features containers
+  ViewLookups viewLookups;
+  for (const auto & posePairMatchesIt : posePairMatches)
+  {
+    for (const matching::PairwiseMatches::const_iterator & match_iterator : posePairMatchesIt.second)
+    {
+      for (const IndexT viewId : {match_iterator->first.first, match_iterator->first.second})
+      {
+        if (viewLookups.count(viewId))
+          continue;
+        ViewLookup & viewLookup = viewLookups[viewId];
+        viewLookup.features = &normalizedFeaturesPerView.getFeaturesPerDesc(viewId);
+        const View * view = sfm_data.getViews().at(viewId).get();
+        const auto intrinsicIt = sfm_data.getIntrinsics().find(view->getIntrinsicId());
+        if (intrinsicIt == sfm_data.getIntrinsics().end())
+          continue;
+        const camera::Pinhole * intrinsic = dynamic_cast<const camera::Pinhole *>(intrinsicIt->second.get());
+        if (intrinsic && intrinsic->isValid())
+          viewLookup.focal = intrinsic->focal();
+      }
+    }
+  }
+
   {
     // Compute triplets of translations
     // Avoid to cover each edge of the graph by using an edge coverage algorithm
     // An estimated triplets of translation mark three edges as estimated.
 
     //-- precompute the number of track per triplet:
-    HashMap<IndexT, IndexT> map_tracksPerTriplets;
+    std::vector<std::size_t> vec_tracksPerTriplets(vec_triplets.size(), 0);
 
     #pragma omp parallel for schedule(dynamic)
     for (int i = 0; i < (int)vec_triplets.size(); ++i)
     {
       // List matches that belong to the triplet of poses
-      const graph::Triplet & triplet = vec_triplets[i];
       matching::PairwiseMatches map_triplet_matches;
-      const std::set<IndexT> set_triplet_pose_ids = {triplet.i, triplet.j, triplet.k};
-      // List shared correspondences (pairs) between the triplet poses
-      for (const auto & match_iterator : pairwiseMatches)
-      {
-        const Pair pair = match_iterator.first;
-        const View * v1 = sfm_data.getViews().at(pair.first).get();
-        const View * v2 = sfm_data.getViews().at(pair.second).get();
-        if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-            (v1->getPoseId() != v2->getPoseId())
-            && set_triplet_pose_ids.count(v1->getPoseId())
-            && set_triplet_pose_ids.count(v2->getPoseId()))
-        {
-          map_triplet_matches.insert( match_iterator );
-        }
-      }
+      getTripletMatches(posePairMatches, vec_triplets[i], map_triplet_matches);
       // Compute tracks:
-      {
-        aliceVision::track::TracksBuilder tracksBuilder;
-        tracksBuilder.build(map_triplet_matches);
-        tracksBuilder.filter(3);
-
-        #pragma omp critical
-        map_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
-      }
+      aliceVision::track::TracksBuilder tracksBuilder;
+      tracksBuilder.build(map_triplet_matches);
+      tracksBuilder.filter(3);
+      vec_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
     }
 
     typedef Pair myEdge;
@@ -404,26 +462,55 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     std::vector<myEdge > vec_edges;
     std::transform(map_tripletIds_perEdge.begin(), map_tripletIds_perEdge.end(), std::back_inserter(vec_edges), stl::RetrieveKey());
 
-    aliceVision::sfm::MutexSet<myEdge> m_mutexSet;
+    // Index of the three edges of each triplet (vec_edges is sorted)
+    const auto edgeIndex = [&vec_edges](const myEdge & edge)
+    {
+      return std::distance(vec_edges.begin(), std::lower_bound(vec_edges.begin(), vec_edges.end(), edge));
+    };
+    std::vector<std::array<std::size_t, 3> > vec_tripletEdges(vec_triplets.size());
+    #pragma omp parallel for
+    for (int i = 0; i < (int)vec_triplets.size(); ++i)
+    {
+      const graph::Triplet & triplet = vec_triplets[i];
+      vec_tripletEdges[i] = {{
+        static_cast<std::size_t>(edgeIndex(std::make_pair(triplet.i, triplet.j))),
+        static_cast<std::size_t>(edgeIndex(std::make_pair(triplet.j, triplet.k))),
+        static_cast<std::size_t>(edgeIndex(std::make_pair(triplet.i, triplet.k)))}};
+    }
+
+    // Edges already estimated by a triplet, shared by all the threads without lock
+    std::vector<std::atomic<bool> > vec_coveredEdges(vec_edges.size());
+    for (std::atomic<bool> & covered : vec_coveredEdges)
+      covered = false;
+    std::atomic<std::size_t> nbCoveredEdges(0);
 
     boost::progress_display my_progress_bar(
       vec_edges.size(),
       std::cout,
       "\nRelative translations computation (edge coverage algorithm)\n");
 
-    // set number of threads, 1 if openMP is not enabled  
+    // set number of threads, 1 if openMP is not enabled
+    // each thread accumulates its own estimates and matches, they are merged at the end
     std::vector<translationAveraging::RelativeInfoVec> initial_estimates(omp_get_max_threads());
+    std::vector<matching::PairwiseMatches> thread_pairMatches(omp_get_max_threads());
     const bool bVerbose = false;
 
+    // the progress bar is only refreshed by the master thread
+    std::atomic<std::size_t> nbProcessedEdges(0);
+    std::size_t nbDisplayedEdges = 0;
+
     #pragma omp parallel for schedule(dynamic)
     for (int k = 0; k < vec_edges.size(); ++k)
     {
       const myEdge & edge = vec_edges[k];
-      #pragma omp critical
+      ++nbProcessedEdges;
+      if (omp_get_thread_num() == 0)
       {
-        ++my_progress_bar;
+        const std::size_t nbEdges = nbProcessedEdges;
+        my_progress_bar += nbEdges - nbDisplayedEdges;
+        nbDisplayedEdges = nbEdges;
       }
-      if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
+      if (!vec_coveredEdges[k] && nbCoveredEdges != vec_edges.size())
       {
         // Find the triplets that support the given edge
         const auto & vec_possibleTripletIndexes = map_tripletIds_perEdge.at(edge);
@@ -432,7 +519,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         std::vector<size_t> vec_commonTracksPerTriplets;
         for (const size_t triplet_index : vec_possibleTripletIndexes)
         {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
+          vec_commonTracksPerTriplets.push_back(vec_tracksPerTriplets[triplet_index]);
         }
 
         using namespace stl::indexed_sort;
@@ -448,11 +535,12 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         for (const size_t triplet_index : vec_triplet_ordered)
         {
           const graph::Triplet & triplet = vec_triplets[triplet_index];
+          const std::array<std::size_t, 3> & tripletEdges = vec_tripletEdges[triplet_index];
 
           // If the triplet is already estimated by another thread; try the next one
-          if (m_mutexSet.count(Pair(triplet.i, triplet.j)) &&
-              m_mutexSet.count(Pair(triplet.i, triplet.k)) &&
-              m_mutexSet.count(Pair(triplet.j, triplet.k)))
+          if (vec_coveredEdges[tripletEdges[0]] &&
+              vec_coveredEdges[tripletEdges[1]] &&
+              vec_coveredEdges[tripletEdges[2]])
           {
             break;
           }
@@ -466,12 +554,16 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           std::vector<size_t> vec_inliers;
           aliceVision::track::TracksMap pose_triplet_tracks;
 
+          matching::PairwiseMatches map_triplet_matches;
+          getTripletMatches(posePairMatches, triplet, map_triplet_matches);
+
           const std::string sOutDirectory = "./";
           const bool bTriplet_estimation = Estimate_T_triplet(
               sfm_data,
               map_globalR,
               normalizedFeaturesPerView,
-              pairwiseMatches,
+              viewLookups,
+              map_triplet_matches,
               triplet,
               vec_tis,
               dPrecision,
@@ -482,9 +574,14 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           if (bTriplet_estimation)
           {
             // Since new translation edges have been computed, mark their corresponding edges as estimated
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.j));
-            m_mutexSet.insert(std::make_pair(triplet.j, triplet.k));
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.k));
+            for (const std::size_t tripletEdge : tripletEdges)
+            {
+              if (!vec_coveredEdges[tripletEdge].exchange(true))
+                ++nbCoveredEdges;
+            }
+
+            // set number of threads, 1 if openMP is not enabled
+            const int thread_id = omp_get_thread_num();
 
             // Compute the triplet relative motions (IJ, JK, IK)
             {
@@ -509,51 +606,45 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
               Vec3 tik;
               RelativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
 
-              // set number of threads, 1 if openMP is not enabled
-              const int thread_id = omp_get_thread_num();
-
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.j), std::make_pair(Rij, tij));
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.j, triplet.k), std::make_pair(Rjk, tjk));
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.k), std::make_pair(Rik, tik));
+            }
+
+            // Add inliers as valid pairwise matches
+            matching::PairwiseMatches & newThreadPairMatches = thread_pairMatches[thread_id];
+            for (std::vector<size_t>::const_iterator iterInliers = vec_inliers.begin();
+              iterInliers != vec_inliers.end(); ++iterInliers)
+            {
+              using namespace aliceVision::track;
+              TracksMap::iterator it_tracks = pose_triplet_tracks.begin();
+              std::advance(it_tracks, *iterInliers);
+              const Track & track = it_tracks->second;
 
-              //--- ATOMIC
-              #pragma omp critical
+              // create pairwise matches from inlier track
+              for (size_t index_I = 0; index_I < track.featPerView.size() ; ++index_I)
               {
-                // Add inliers as valid pairwise matches
-                for (std::vector<size_t>::const_iterator iterInliers = vec_inliers.begin();
-                  iterInliers != vec_inliers.end(); ++iterInliers)
+                Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin();
+                std::advance(iter_I, index_I);
+
+                // extract camera indexes
+                const size_t id_view_I = iter_I->first;
+                const size_t id_feat_I = iter_I->second;
+
+                // loop on subtracks
+                for (size_t index_J = index_I+1; index_J < track.featPerView.size() ; ++index_J)
                 {
-                  using namespace aliceVision::track;
-                  TracksMap::iterator it_tracks = pose_triplet_tracks.begin();
-                  std::advance(it_tracks, *iterInliers);
-                  const Track & track = it_tracks->second;
-
-                  // create pairwise matches from inlier track
-                  for (size_t index_I = 0; index_I < track.featPerView.size() ; ++index_I)
-                  {
-                    Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin();
-                    std::advance(iter_I, index_I);
-
-                    // extract camera indexes
-                    const size_t id_view_I = iter_I->first;
-                    const size_t id_feat_I = iter_I->second;
-
-                    // loop on subtracks
-                    for (size_t index_J = index_I+1; index_J < track.featPerView.size() ; ++index_J)
-                    {
-                      Track::FeatureIdPerView::const_iterator iter_J = track.featPerView.begin();
-                      std::advance(iter_J, index_J);
-
-                      // extract camera indexes
-                      const size_t id_view_J = iter_J->first;
-                      const size_t id_feat_J = iter_J->second;
-
-                      newpairMatches[std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
-                    }
-                  }
+                  Track::FeatureIdPerView::const_iterator iter_J = track.featPerView.begin();
+                  std::advance(iter_J, index_J);
+
+                  // extract camera indexes
+                  const size_t id_view_J = iter_J->first;
+                  const size_t id_feat_J = iter_J->second;
+
+                  newThreadPairMatches[std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
                 }
               }
             }
@@ -564,14 +655,28 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         }
       }
     }
+    my_progress_bar += vec_edges.size() - nbDisplayedEdges;
+
     // Merge thread estimates
-    for (const auto vec : initial_estimates)
+    for (const auto & vec : initial_estimates)
     {
-      for (const auto val : vec)
+      for (const auto & val : vec)
       {
         vec_initialEstimates.emplace_back(val);
       }
     }
+    // Merge thread matches
+    for (const matching::PairwiseMatches & threadPairMatches : thread_pairMatches)
+    {
+      for (const auto & pairMatches : threadPairMatches)
+      {
+        for (const auto & descMatches : pairMatches.second)
+        {
+          matching::IndMatches & matches = newpairMatches[pairMatches.first][descMatches.first];
+          matches.insert(matches.end(), descMatches.second.begin(), descMatches.second.end());
+        }
+      }
+    }
   }
 
 
@@ -592,7 +697,8 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   const SfMData & sfm_data,
   const HashMap<IndexT, Mat3> & map_globalR,
   const feature::FeaturesPerView & normalizedFeaturesPerView,
-  const matching::PairwiseMatches & pairwiseMatches,
+  const ViewLookups & viewLookups,
+  const matching::PairwiseMatches & map_triplet_matches,
   const graph::Triplet & poses_id,
   std::vector<Vec3> & vec_tis,
   double & dPrecision, // UpperBound of the precision found by the AContrario estimator
@@ -600,24 +706,6 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   aliceVision::track::TracksMap & tracks,
   const std::string & sOutDirectory) const
 {
-  // List matches that belong to the triplet of poses
-  matching::PairwiseMatches map_triplet_matches;
-  const std::set<IndexT> set_pose_ids = {poses_id.i, poses_id.j, poses_id.k};
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
-  {
-    const Pair & pair = match_iterator.first;
-    const View * v1 = sfm_data.getViews().at(pair.first).get();
-    const View * v2 = sfm_data.getViews().at(pair.second).get();
-    if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-        (v1->getPoseId() != v2->getPoseId())
-        && set_pose_ids.count(v1->getPoseId())
-        && set_pose_ids.count(v2->getPoseId()))
-    {
-      map_triplet_matches.insert( match_iterator );
-    }
-  }
-
   aliceVision::track::TracksBuilder tracksBuilder;
   tracksBuilder.build(map_triplet_matches);
   tracksBuilder.filter(3);
@@ -632,7 +720,8 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   Mat x3(2, tracks.size());
 
   Mat* xxx[3] = {&x1, &x2, &x3};
-  std::set<IndexT> intrinsic_ids;
+  // Retrieve the smallest focal value, for threshold normalization
+  double min_focal = std::numeric_limits<double>::max();
   size_t cpt = 0;
   for (track::TracksMap::const_iterator iterTracks = tracks.begin();
     iterTracks != tracks.end(); ++iterTracks, ++cpt)
@@ -641,22 +730,11 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
     size_t index = 0;
     for (track::Track::FeatureIdPerView::const_iterator iter = track.featPerView.begin(); iter != track.featPerView.end(); ++iter, ++index)
     {
-      const size_t idx_view = iter->first;
-      const feature::PointFeature pt = normalizedFeaturesPerView.getFeatures(idx_view, track.descType)[iter->second];
+      const ViewLookup & viewLookup = viewLookups.at(iter->first);
+      const feature::PointFeature & pt = viewLookup.features->at(track.descType)[iter->second];
       xxx[index]->col(cpt) = pt.coords().cast<double>();
-      const View * view = sfm_data.views.at(idx_view).get();
-      intrinsic_ids.insert(view->getIntrinsicId());
-    }
-  }
-  // Retrieve the smallest focal value, for threshold normalization
-  double min_focal = std::numeric_limits<double>::max();
-  for (const auto & ids : intrinsic_ids)
-  {
-    const camera::IntrinsicBase * intrinsicPtr = sfm_data.getIntrinsics().at(ids).get();
-    const camera::Pinhole * intrinsic = dynamic_cast< const camera::Pinhole * > (intrinsicPtr);
-    if (intrinsic && intrinsic->isValid())
-    {
-      min_focal = std::min(min_focal, intrinsic->focal());
+      if (viewLookup.focal > 0.0)
+        min_focal = std::min(min_focal, viewLookup.focal);
     }
   }
   if (min_focal == std::numeric_limits<double>::max())
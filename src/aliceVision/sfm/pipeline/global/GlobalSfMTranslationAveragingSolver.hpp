@@ -21,13 +21,25 @@ enum ETranslationAveragingMethod
 {
   TRANSLATION_AVERAGING_L1 = 1,
   TRANSLATION_AVERAGING_L2_DISTANCE_CHORDAL = 2,
-  TRANSLATION_AVERAGING_SOFTL1 = 3
+  TRANSLATION_AVERAGING_SOFTL1 = 3,
+  TRANSLATION_AVERAGING_IRLS = 4
 };
 
 class GlobalSfMTranslationAveragingSolver
 {
   translationAveraging::RelativeInfoVec m_vec_initialRijTijEstimates;
 
+  /// Data of a view used by the triplet estimation,
+  /// precomputed once and read by all the threads.
+  struct ViewLookup
+  {
+    /// features of the view per describer type (in normalized camera frame)
+    const feature::MapFeaturesPerDesc * features = nullptr;
+    /// focal of the view intrinsic (0 if not a valid pinhole camera)
+    double focal = 0.0;
+  };
+  typedef HashMap<IndexT, ViewLookup> ViewLookups;
+
 public:
 
   /// Use features in normalized camera frames
@@ -66,11 +78,14 @@ private:
     matching::PairwiseMatches & newpairMatches);
 
   // Robust estimation and refinement of a translation and 3D points of an image triplets.
+  // tripletMatches are the matches between the views of the triplet of poses,
+  // viewLookups gives the features and focal of these views without any shared lookup.
   bool Estimate_T_triplet(
     const SfMData & sfm_data,
     const HashMap<IndexT, Mat3> & map_globalR,
     const feature::FeaturesPerView & normalizedFeaturesPerView,
-    const matching::PairwiseMatches & matches_provider,
+    const ViewLookups & viewLookups,
+    const matching::PairwiseMatches & tripletMatches,
     const graph::Triplet & poses_id,
     std::vector<Vec3> & vec_tis,
     double & dPrecision, // UpperBound of the precision found by the AContrario estimator
@@ -11,6 +11,7 @@
 #include "aliceVision/multiview/triangulation/triangulationDLT.hpp"
 #include "aliceVision/multiview/triangulation/Triangulation.hpp"
 #include "aliceVision/graph/connectedComponent.hpp"
+#include "aliceVision/graph/pairSelection.hpp"
 #include "aliceVision/system/Timer.hpp"
 #include "aliceVision/stl/stl.hpp"
 #include "aliceVision/multiview/essential.hpp"
@@ -20,6 +21,8 @@
 
 #include <boost/progress.hpp>
 
+#include <cmath>
+
 #ifdef _MSC_VER
 #pragma warning( once : 4267 ) //warning C4267: 'argument' : conversion from 'size_t' to 'const int', possible loss of data
 #endif
@@ -53,6 +56,8 @@ ReconstructionEngine_globalSfM::ReconstructionEngine_globalSfM(
   // Set default motion Averaging methods
   _eRotationAveragingMethod = ROTATION_AVERAGING_L2;
   _eTranslationAveragingMethod = TRANSLATION_AVERAGING_L1;
+  _usePairPreselection = false;
+  _nbTrianglesPerPreselectedEdge = 2;
 }
 
 ReconstructionEngine_globalSfM::~ReconstructionEngine_globalSfM()
@@ -101,6 +106,11 @@ void ReconstructionEngine_globalSfM::SetMatchesProvider(matching::PairwiseMatche
   _pairwiseMatches = provider;
 }
 
+void ReconstructionEngine_globalSfM::SetGeometricModelsProvider(const matching::PairGeometricModels * provider)
+{
+  _geometricModels = provider;
+}
+
 void ReconstructionEngine_globalSfM::SetRotationAveragingMethod
 (
   ERotationAveragingMethod eRotationAveragingMethod
@@ -117,6 +127,12 @@ void ReconstructionEngine_globalSfM::SetTranslationAveragingMethod
   _eTranslationAveragingMethod = eTranslationAveragingMethod;
 }
 
+void ReconstructionEngine_globalSfM::SetPairPreselection(bool usePairPreselection, std::size_t nbTrianglesPerEdge)
+{
+  _usePairPreselection = usePairPreselection;
+  _nbTrianglesPerPreselectedEdge = nbTrianglesPerEdge;
+}
+
 bool ReconstructionEngine_globalSfM::process() {
 
   //-------------------
@@ -134,10 +150,8 @@ bool ReconstructionEngine_globalSfM::process() {
   }
 
   aliceVision::rotationAveraging::RelativeRotations relatives_R;
-  Compute_Relative_Rotations(relatives_R);
-
   HashMap<IndexT, Mat3> global_rotations;
-  if (!Compute_Global_Rotations(relatives_R, global_rotations))
+  if (!Compute_Rotations(relatives_R, global_rotations))
   {
     ALICEVISION_LOG_WARNING("GlobalSfM:: Rotation Averaging failure!");
     return false;
@@ -181,6 +195,90 @@ bool ReconstructionEngine_globalSfM::process() {
   return true;
 }
 
+/// Compute the relative and the global rotations, with the optional pair pre-selection
+bool ReconstructionEngine_globalSfM::Compute_Rotations
+(
+  rotationAveraging::RelativeRotations & relatives_R,
+  HashMap<IndexT, Mat3> & global_rotations
+)
+{
+  const PoseWiseMatches poseWiseMatches = getPoseWiseMatches();
+
+  PairSet remainingPosePairs;
+  std::map<Pair, std::size_t> nbMatchesPerPosePair;
+  for (const auto & poseWiseMatchesIt : poseWiseMatches)
+  {
+    remainingPosePairs.insert(poseWiseMatchesIt.first);
+    std::size_t nbMatches = 0;
+    for (const Pair & pair : poseWiseMatchesIt.second)
+      nbMatches += _pairwiseMatches->at(pair).getNbAllMatches();
+    nbMatchesPerPosePair[poseWiseMatchesIt.first] = nbMatches;
+  }
+
+  if (!_usePairPreselection)
+  {
+    Compute_Relative_Rotations(poseWiseMatches, remainingPosePairs, relatives_R);
+    return Compute_Global_Rotations(relatives_R, global_rotations);
+  }
+
+  // Relative poses of a maximum spanning subgraph of the pose graph (with redundancy edges)
+  const PairSet selectedPosePairs = graph::selectSpanningPairs(nbMatchesPerPosePair, _nbTrianglesPerPreselectedEdge);
+  for (const Pair & posePair : selectedPosePairs)
+    remainingPosePairs.erase(posePair);
+
+  ALICEVISION_LOG_INFO("Pair pre-selection: " << selectedPosePairs.size() << " / " << poseWiseMatches.size() << " pose pairs selected.");
+
+  Compute_Relative_Rotations(poseWiseMatches, selectedPosePairs, relatives_R);
+  bool hasGlobalRotations = Compute_Global_Rotations(relatives_R, global_rotations);
+
+  if (remainingPosePairs.empty())
+    return hasGlobalRotations;
+
+  // Poses that need more relative poses:
+  // - poses without global rotation,
+  // - poses with less than 2 relative rotations consistent with the global rotations.
+  const double maxAngularError = 5.0; // same threshold as the triplet rotation rejection
+  std::map<IndexT, std::size_t> nbConsistentRelativesPerPose;
+  for (const Pair & posePair : remainingPosePairs)
+  {
+    nbConsistentRelativesPerPose[posePair.first];
+    nbConsistentRelativesPerPose[posePair.second];
+  }
+  if (hasGlobalRotations)
+  {
+    for (const auto & relative_R : relatives_R)
+    {
+      const auto itI = global_rotations.find(relative_R.i);
+      const auto itJ = global_rotations.find(relative_R.j);
+      if (itI == global_rotations.end() || itJ == global_rotations.end())
+        continue;
+      const Mat3 residual = itJ->second * itI->second.transpose() * relative_R.Rij.transpose();
+      if (radianToDegree(getRotationMagnitude(residual)) < maxAngularError)
+      {
+        ++nbConsistentRelativesPerPose[relative_R.i];
+        ++nbConsistentRelativesPerPose[relative_R.j];
+      }
+    }
+  }
+
+  PairSet lazyPosePairs;
+  for (const Pair & posePair : remainingPosePairs)
+  {
+    if (nbConsistentRelativesPerPose.at(posePair.first) < 2 ||
+        nbConsistentRelativesPerPose.at(posePair.second) < 2)
+      lazyPosePairs.insert(posePair);
+  }
+
+  if (lazyPosePairs.empty())
+    return hasGlobalRotations;
+
+  ALICEVISION_LOG_INFO("Pair pre-selection: " << lazyPosePairs.size() << " pose pairs added for the badly constrained poses.");
+
+  Compute_Relative_Rotations(poseWiseMatches, lazyPosePairs, relatives_R);
+  global_rotations.clear();
+  return Compute_Global_Rotations(relatives_R, global_rotations);
+}
+
 /// Compute from relative rotations the global rotations of the camera poses
 bool ReconstructionEngine_globalSfM::Compute_Global_Rotations
 (
@@ -386,7 +484,9 @@ bool ReconstructionEngine_globalSfM::Adjust()
 {
   // Refine sfm_scene (in a 3 iteration process (free the parameters regarding their incertainty order)):
 
-  BundleAdjustmentCeres bundle_adjustment_obj;
+  BundleAdjustmentCeres::BA_options options;
+  options.setAdaptiveBA(BundleAdjustmentCeres::BA_problemSize(_sfmData));
+  BundleAdjustmentCeres bundle_adjustment_obj(options);
   // - refine only Structure and translations
   bool b_BA_Status = bundle_adjustment_obj.Adjust(_sfmData, BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE);
   if (b_BA_Status)
@@ -465,18 +565,11 @@ bool ReconstructionEngine_globalSfM::Adjust()
   return b_BA_Status;
 }
 
-void ReconstructionEngine_globalSfM::Compute_Relative_Rotations
-(
-  rotationAveraging::RelativeRotations & vec_relatives_R
-)
+ReconstructionEngine_globalSfM::PoseWiseMatches ReconstructionEngine_globalSfM::getPoseWiseMatches() const
 {
   //
   // Build the Relative pose graph from matches:
   //
-  /// pairwise view relation between poseIds
-  typedef std::map< Pair, PairSet > PoseWiseMatches;
-
-  // List shared correspondences (pairs) between poses
   PoseWiseMatches poseWiseMatches;
   for (matching::PairwiseMatches::const_iterator iterMatches = _pairwiseMatches->begin();
     iterMatches != _pairwiseMatches->end(); ++iterMatches)
@@ -486,21 +579,37 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations
     const View * v2 = _sfmData.getViews().at(pair.second).get();
     poseWiseMatches[Pair(v1->getPoseId(), v2->getPoseId())].insert(pair);
   }
+  return poseWiseMatches;
+}
 
-  boost::progress_display my_progress_bar( poseWiseMatches.size(),
+void ReconstructionEngine_globalSfM::Compute_Relative_Rotations
+(
+  const PoseWiseMatches & poseWiseMatches,
+  const PairSet & posePairs,
+  rotationAveraging::RelativeRotations & vec_relatives_R
+)
+{
+  std::vector<PoseWiseMatches::const_iterator> poseWiseMatchesToCompute;
+  poseWiseMatchesToCompute.reserve(posePairs.size());
+  for (const Pair & posePair : posePairs)
+  {
+    const PoseWiseMatches::const_iterator iter = poseWiseMatches.find(posePair);
+    if (iter != poseWiseMatches.end())
+      poseWiseMatchesToCompute.push_back(iter);
+  }
+
+  boost::progress_display my_progress_bar( poseWiseMatchesToCompute.size(),
       std::cout, "\n- Relative pose computation -\n" );
   #pragma omp parallel for schedule(dynamic)
   // Compute the relative pose from pairwise point matches:
-  for (int i = 0; i < poseWiseMatches.size(); ++i)
+  for (int i = 0; i < poseWiseMatchesToCompute.size(); ++i)
   {
     #pragma omp critical
     {
       ++my_progress_bar;
     }
     {
-      PoseWiseMatches::const_iterator iter (poseWiseMatches.begin());
-      std::advance(iter, i);
-      const auto & relative_pose_iterator(*iter);
+      const auto & relative_pose_iterator(*poseWiseMatchesToCompute[i]);
       const Pair relative_pose_pair = relative_pose_iterator.first;
       const PairSet & match_pairs = relative_pose_iterator.second;
 
@@ -564,9 +673,33 @@ void ReconstructionEngine_globalSfM::Compute_Relative_Rotations
       const std::pair<size_t, size_t> imageSize(1., 1.);
       const Mat3 K  = Mat3::Identity();
 
-      if(!robustRelativePose(K, K, x1, x2, relativePose_info, imageSize, imageSize, 256))
+      // relative pose from the model of the matching geometric filtering, if it is still valid
+      bool relativePoseSuccess = false;
+      const Pinhole * pinhole_I = dynamic_cast<const Pinhole*>(cam_I);
+      const Pinhole * pinhole_J = dynamic_cast<const Pinhole*>(cam_J);
+      Mat3 E;
+      if(_geometricModels != nullptr && _geometricModels->count(pairIterator) && pinhole_I && pinhole_J &&
+         matching::getEssentialMatrix(_geometricModels->at(pairIterator), pinhole_I->K(), pinhole_J->K(), E))
       {
-        continue;
+        const matching::PairGeometricModel& model = _geometricModels->at(pairIterator);
+        // the features are normalized: the essential matrix relates them directly
+        const double maxResidual = std::isfinite(model.threshold) ?
+          std::sqrt(cam_I->imagePlane_toCameraPlaneError(model.threshold) * cam_J->imagePlane_toCameraPlaneError(model.threshold)) :
+          relativePose_info.initial_residual_tolerance;
+        relativePoseSuccess = relativePoseFromEssential(K, K, x1, x2, E, maxResidual, relativePose_info) &&
+                              relativePose_info.vec_inliers.size() >= model.nbInliers / 2;
+      }
+
+      if(!relativePoseSuccess)
+      {
+        const double initialResidualTolerance = relativePose_info.initial_residual_tolerance;
+        relativePose_info = RelativePoseInfo();
+        relativePose_info.initial_residual_tolerance = initialResidualTolerance;
+
+        if(!robustRelativePose(K, K, x1, x2, relativePose_info, imageSize, imageSize, 256))
+        {
+          continue;
+        }
       }
 
       const bool refineUsingBA = true;
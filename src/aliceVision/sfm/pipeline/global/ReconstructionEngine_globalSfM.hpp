@@ -10,6 +10,7 @@
 #include "aliceVision/sfm/pipeline/ReconstructionEngine.hpp"
 #include "aliceVision/sfm/pipeline/global/GlobalSfMRotationAveragingSolver.hpp"
 #include "aliceVision/sfm/pipeline/global/GlobalSfMTranslationAveragingSolver.hpp"
+#include "aliceVision/matching/GeometricModel.hpp"
 
 #include "dependencies/htmlDoc/htmlDoc.hpp"
 
@@ -32,9 +33,26 @@ public:
   void SetFeaturesProvider(feature::FeaturesPerView * featuresPerView);
   void SetMatchesProvider(matching::PairwiseMatches * provider);
 
+  /**
+   * @brief Set the models of the geometric filtering of the matches,
+   * used to compute the relative rotations without robust estimation
+   */
+  void SetGeometricModelsProvider(const matching::PairGeometricModels * provider);
+
   void SetRotationAveragingMethod(ERotationAveragingMethod eRotationAveragingMethod);
   void SetTranslationAveragingMethod(ETranslationAveragingMethod _eTranslationAveragingMethod);
 
+  /**
+   * @brief Estimate the relative poses only on a sparse selection of the pose pairs:
+   * a maximum spanning tree of the pose graph (weighted by the number of matches),
+   * closed by the triangles of the strongest neighbors.
+   * The remaining pairs of the poses that are missing or badly constrained after
+   * the rotation averaging are estimated afterwards.
+   * @param[in] usePairPreselection enable the pair pre-selection
+   * @param[in] nbTrianglesPerEdge number of triangles used to close each spanning tree edge
+   */
+  void SetPairPreselection(bool usePairPreselection, std::size_t nbTrianglesPerEdge = 2);
+
   virtual bool process();
 
 protected:
@@ -62,12 +80,27 @@ protected:
   bool Adjust();
 
 private:
-  /// Compute relative rotations
+  /// pairwise view relation between poseIds
+  typedef std::map<Pair, PairSet> PoseWiseMatches;
+
+  /// List shared correspondences (pairs) between poses
+  PoseWiseMatches getPoseWiseMatches() const;
+
+  /// Compute relative rotations of the given pose pairs
   void Compute_Relative_Rotations
   (
+    const PoseWiseMatches & poseWiseMatches,
+    const PairSet & posePairs,
     aliceVision::rotationAveraging::RelativeRotations & vec_relatives_R
   );
 
+  /// Compute the relative and the global rotations, with the optional pair pre-selection
+  bool Compute_Rotations
+  (
+    aliceVision::rotationAveraging::RelativeRotations & vec_relatives_R,
+    HashMap<IndexT, Mat3> & map_globalR
+  );
+
   //----
   //-- Data
   //----
@@ -79,10 +112,13 @@ private:
   // Parameter
   ERotationAveragingMethod _eRotationAveragingMethod;
   ETranslationAveragingMethod _eTranslationAveragingMethod;
+  bool _usePairPreselection;
+  std::size_t _nbTrianglesPerPreselectedEdge;
 
   //-- Data provider
   feature::FeaturesPerView  * _featuresPerView;
   matching::PairwiseMatches  * _pairwiseMatches;
+  const matching::PairGeometricModels * _geometricModels = nullptr;
 
   std::shared_ptr<feature::FeaturesPerView> _normalizedFeaturesPerView;
 };
@@ -21,7 +21,8 @@ namespace sfm {
   SfMLocalizationSingle3DTrackObservationDatabase::Init
   (
     const SfMData & sfm_data,
-    const feature::RegionsPerView & regionsPerView
+    const feature::RegionsPerView & regionsPerView,
+    feature::EImageDescriberType describerType
   )
   {
     if (regionsPerView.isEmpty())
@@ -29,44 +30,105 @@ namespace sfm {
       return false;
     }
 
+    // Setup the database
+    // A collection of regions
+    // - each landmark leads to a new region (the descriptor of its first available observation)
+    // - link each region to a landmark id to ease 2D-3D correspondences search
+
+    const feature::Regions& regionsType = regionsPerView.getFirstViewRegions(describerType);
+    landmark_observations_descriptors_.reset(regionsType.EmptyClone());
+    index_to_landmark_id_.clear();
+    for (const auto & landmark : sfm_data.getLandmarks())
+    {
+      if (landmark.second.descType != describerType)
+        continue;
+
+      for (const auto & observation : landmark.second.observations)
+      {
+        if (observation.second.id_feat == UndefinedIndexT || !regionsPerView.viewExist(observation.first))
+          continue;
+
+        // copy the feature/descriptor to landmark_observations_descriptors
+        const feature::Regions& viewRegions = regionsPerView.getRegions(observation.first, describerType);
+        viewRegions.CopyRegion(observation.second.id_feat, landmark_observations_descriptors_.get());
+        // link this descriptor to the track Id
+        index_to_landmark_id_.push_back(landmark.first);
+        break;
+      }
+    }
+    return initMatcher(sfm_data);
+  }
+
+  bool
+  SfMLocalizationSingle3DTrackObservationDatabase::Init
+  (
+    const SfMData & sfm_data,
+    const feature::RegionsPerView & regionsPerView
+  )
+  {
+    if (regionsPerView.isEmpty() || regionsPerView.getData().begin()->second.empty())
+    {
+      return false;
+    }
+    return Init(sfm_data, regionsPerView, regionsPerView.getData().begin()->second.begin()->first);
+  }
+
+  bool
+  SfMLocalizationSingle3DTrackObservationDatabase::Init
+  (
+    const SfMData & sfm_data,
+    std::unique_ptr<feature::Regions> landmarks_descriptors,
+    std::vector<IndexT> landmark_ids
+  )
+  {
+    if (landmarks_descriptors == nullptr || landmarks_descriptors->RegionCount() != landmark_ids.size())
+    {
+      return false;
+    }
+    landmark_observations_descriptors_ = std::move(landmarks_descriptors);
+    index_to_landmark_id_ = std::move(landmark_ids);
+    return initMatcher(sfm_data);
+  }
+
+  bool
+  SfMLocalizationSingle3DTrackObservationDatabase::initMatcher
+  (
+    const SfMData & sfm_data
+  )
+  {
     if (sfm_data.getPoses().empty() || sfm_data.getLandmarks().empty())
     {
       ALICEVISION_LOG_WARNING("The input SfMData file have not 3D content to match with.");
       return false;
     }
-    /*
-    TODO: DELI
-
-    // Setup the database
-    // A collection of regions
-    // - each view observation leads to a new regions
-    // - link each observation region to a track id to ease 2D-3D correspondences search
 
-    const feature::Regions& regionsType = regionsPerView.getFirstViewRegions();
-    landmark_observations_descriptors_.reset(regionsType.EmptyClone());
-    for (const auto & landmark : sfm_data.getLandmarks())
+    // the landmarks removed from the scene since the descriptors were computed can't be matched
+    for (const IndexT landmarkId : index_to_landmark_id_)
     {
-      for (const auto & observation : landmark.second.obs)
+      if (sfm_data.getLandmarks().count(landmarkId) == 0)
       {
-        if (observation.second.id_feat != UndefinedIndexT)
-        {
-          // copy the feature/descriptor to landmark_observations_descriptors
-          const feature::Regions& viewRegions = regionsPerView.getRegions(observation.first, landmark.second.descType);
-          viewRegions.CopyRegion(observation.second.id_feat, landmark_observations_descriptors_.get());
-          // link this descriptor to the track Id
-          index_to_landmark_id_.push_back(landmark.first);
-        }
+        ALICEVISION_LOG_WARNING("The landmark " << landmarkId << " of the retrieval database is not in the SfMData.");
+        return false;
       }
     }
+
+    if (landmark_observations_descriptors_->RegionCount() < 2)
+    {
+      ALICEVISION_LOG_WARNING("Not enough landmark descriptors to build the retrieval database.");
+      return false;
+    }
+
     ALICEVISION_LOG_DEBUG("Init retrieval database ... ");
+    // kd-tree on the scalar descriptors, exhaustive search on the binary ones
+    const matching::EMatcherType matcherType = landmark_observations_descriptors_->IsBinary() ?
+      matching::BRUTE_FORCE_HAMMING : matching::ANN_L2;
     matching_interface_.reset(new
-      matching::Matcher_Regions_Database(matching::ANN_L2, *landmark_observations_descriptors_));
+      matching::RegionsDatabaseMatcher(matcherType, *landmark_observations_descriptors_));
     ALICEVISION_LOG_DEBUG("Retrieval database initialized\n"
       "#landmark: " << sfm_data.getLandmarks().size() << "\n"
       "#descriptor initialized: " << landmark_observations_descriptors_->RegionCount());
 
     sfm_data_ = &sfm_data;
-    */
     return true;
   }
 
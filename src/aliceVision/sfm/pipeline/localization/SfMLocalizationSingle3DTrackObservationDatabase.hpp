@@ -15,10 +15,12 @@ namespace aliceVision {
 namespace sfm {
 
 // Implementation of a naive method:
-// - init the database of descriptor from the structure and the observations.
-// - create a large array with all the used descriptors and init a Matcher with it
+// - init the database of descriptor from the structure and the observations:
+//   one descriptor per landmark of the database describer type.
+// - create a large array with all the used descriptors and init a Matcher (kd-tree) with it
 // - to localize an input image compare it's regions to the database and robust estimate
 //   the pose from found 2d-3D correspondences
+// Once initialized, Localize is const and can be called concurrently.
 
 class SfMLocalizationSingle3DTrackObservationDatabase : public SfMLocalizer
 {
@@ -29,6 +31,25 @@ public:
   /**
   * @brief Build the retrieval database (3D points descriptors)
   *
+  * The descriptor of a landmark is the one of its first observation
+  * in a view with regions.
+  *
+  * @param[in] sfm_data the SfM scene that have to be described
+  * @param[in] regionPerView regions provider
+  * @param[in] describerType the describer type of the database
+  * @return True if the database has been correctly setup
+  */
+  bool Init
+  (
+    const SfMData & sfm_data,
+    const feature::RegionsPerView & regionsPerView,
+    feature::EImageDescriberType describerType
+  );
+
+  /**
+  * @brief Build the retrieval database (3D points descriptors)
+  * with the describer type of the first view regions
+  *
   * @param[in] sfm_data the SfM scene that have to be described
   * @param[in] regionPerView regions provider
   * @return True if the database has been correctly setup
@@ -37,6 +58,22 @@ public:
   (
     const SfMData & sfm_data,
     const feature::RegionsPerView & regionsPerView
+  ) override;
+
+  /**
+  * @brief Build the retrieval database from precomputed landmark descriptors
+  * (e.g. the representative descriptors of a landmarks database)
+  *
+  * @param[in] sfm_data the SfM scene that have to be described
+  * @param[in] landmarks_descriptors one region per landmark (only the descriptors are used)
+  * @param[in] landmark_ids the landmark id of each region
+  * @return True if the database has been correctly setup
+  */
+  bool Init
+  (
+    const SfMData & sfm_data,
+    std::unique_ptr<feature::Regions> landmarks_descriptors,
+    std::vector<IndexT> landmark_ids
   );
 
   /**
@@ -59,6 +96,9 @@ public:
   ) const;
 
 private:
+  /// Check the scene and build the matcher on landmark_observations_descriptors_
+  bool initMatcher(const SfMData & sfm_data);
+
   // Reference to the scene
   const SfMData * sfm_data_;
   /// Association of a regions to a landmark observation
@@ -15,6 +15,7 @@
 #include <aliceVision/robustEstimation/LORansac.hpp>
 #include <aliceVision/robustEstimation/LORansacKernelAdaptor.hpp>
 #include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <aliceVision/config.hpp>
 
@@ -41,6 +42,8 @@ bool SfMLocalizer::Localize
   robustEstimation::ERobustEstimator estimator
 )
 {
+  ALICEVISION_PROFILE_ZONE("SfMLocalizer::localize");
+
   // --
   // Compute the camera pose (resectioning)
   // --
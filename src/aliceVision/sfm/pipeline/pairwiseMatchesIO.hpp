@@ -58,5 +58,32 @@ inline bool loadPairwiseMatches(
   return true;
 }
 
+/**
+ * @brief Load the models of the geometric filtering saved with the matches, if any.
+ * @param[out] out_geometricModels
+ * @param[in] sfmData
+ * @param[in] folders Path(s) to folder(s) in which computed matches are stored.
+ * @param[in] useOnlyMatchesFromFolder If enabled, don't use sfmData matches folders
+ */
+inline bool loadPairGeometricModels(
+    matching::PairGeometricModels& out_geometricModels,
+    const SfMData& sfmData,
+    const std::vector<std::string>& folders,
+    bool useOnlyMatchesFromFolder = false)
+{
+  std::vector<std::string> matchesFolders;
+
+  if(!useOnlyMatchesFromFolder)
+    matchesFolders = sfmData.getMatchesFolders();
+
+  matchesFolders.insert(matchesFolders.end(), folders.begin(), folders.end());
+
+  if(!matching::loadGeometricModels(out_geometricModels, matchesFolders))
+    return false;
+
+  ALICEVISION_LOG_INFO(out_geometricModels.size() << " image pair geometric models reused from the matching.");
+  return true;
+}
+
 } // namespace sfm
 } // namespace aliceVision
@@ -6,6 +6,9 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "regionsIO.hpp"
+#include <aliceVision/feature/RegionsContainer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
@@ -18,6 +21,32 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace sfm {
 
+std::unique_ptr<feature::RegionsContainerReader> openRegionsContainer(const std::vector<std::string>& folders,
+                                                                      feature::EImageDescriberType imageDescriberType)
+{
+  std::unique_ptr<feature::RegionsContainerReader> reader;
+
+  // as for per-view files, the last folder has the priority
+  for(auto it = folders.rbegin(); it != folders.rend(); ++it)
+  {
+    const std::string containerPath = feature::getRegionsContainerPath(*it, imageDescriberType);
+    if(!fs::exists(containerPath))
+      continue;
+
+    try
+    {
+      reader.reset(new feature::RegionsContainerReader(containerPath));
+      ALICEVISION_LOG_INFO("Use regions container: " << containerPath);
+      break;
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING("Invalid regions container, fallback to per-view regions files:\n\t" << e.what());
+    }
+  }
+  return reader;
+}
+
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
                                               const feature::ImageDescriber& imageDescriber)
@@ -116,95 +145,296 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
   return regionsPtr;
 }
 
+feature::PointFeatures loadFeaturePositions(const std::vector<std::string>& folders,
+                                            IndexT viewId,
+                                            feature::EImageDescriberType imageDescriberType)
+{
+  assert(!folders.empty());
+
+  const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
+  const std::string basename = std::to_string(viewId);
+
+  std::string featFilename;
+
+  for(const std::string& folder : folders)
+  {
+    const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
+    if(fs::exists(featPath))
+      featFilename = featPath.string();
+  }
+
+  if(featFilename.empty())
+    throw std::runtime_error("Can't find view " + basename + " features file");
+
+  ALICEVISION_LOG_TRACE("Features filename: " << featFilename);
+
+  feature::PointFeatures positions;
+  feature::loadFeatPositionsFromFile(featFilename, positions);
+
+  ALICEVISION_LOG_TRACE("Feature count: " << positions.size());
+  return positions;
+}
+
+namespace {
+
+struct LoadTask
+{
+  IndexT viewId;
+  std::size_t describerIndex;
+};
+
+/**
+ * @brief Run the load function of each task in parallel, the results are stored in preallocated slots
+ * @param[in] load The function filling the slot of a task, returns false if the task failed
+ * @return false if a task failed
+ */
+template <typename LoadFunction, typename SlotT>
+bool loadInParallel(const std::vector<LoadTask>& tasks,
+                    int nbThreads,
+                    const std::string& message,
+                    LoadFunction load,
+                    std::vector<SlotT>& slots)
+{
+  slots.resize(tasks.size());
+
+  boost::progress_display progressBar(tasks.size(), std::cout, message);
+  std::atomic<std::size_t> nbLoaded(0);
+  std::size_t nbDisplayed = 0;
+  std::atomic_bool invalid(false);
+
+#pragma omp parallel for num_threads(nbThreads > 0 ? nbThreads : omp_get_max_threads()) schedule(dynamic)
+  for(int t = 0; t < static_cast<int>(tasks.size()); ++t)
+  {
+    if(invalid)
+      continue;
+
+    bool loaded = false;
+    try
+    {
+      loaded = load(tasks[t], slots[t]);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Can't load the regions of the view " << tasks[t].viewId << ": " << e.what());
+    }
+    if(!loaded)
+      invalid = true;
+
+    ++nbLoaded;
+
+    // the progress bar is not thread-safe, only the first thread updates it
+    if(omp_get_thread_num() == 0)
+    {
+      for(; nbDisplayed < nbLoaded; ++nbDisplayed)
+        ++progressBar;
+    }
+  }
+  for(; nbDisplayed < nbLoaded; ++nbDisplayed)
+    ++progressBar;
+
+  return !invalid;
+}
+
+std::size_t getMemorySize(const feature::Regions& regions)
+{
+  return regions.RegionCount() * (regions.FeatureByteSize() + regions.DescriptorByteSize());
+}
+
+} // namespace
+
 bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
             const SfMData& sfmData,
             const std::vector<std::string>& folders,
             const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
-            const std::set<IndexT>& viewIdFilter)
+            const std::set<IndexT>& viewIdFilter,
+            int nbThreads,
+            const feature::DescriptorPCA* descriptorPCA)
 {
   std::vector<std::string> featuresFolders = sfmData.getFeaturesFolders(); // add sfm features folders
   featuresFolders.insert(featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
 
-  boost::progress_display progressBar(sfmData.getViews().size() * imageDescriberTypes.size(), std::cout, "Loading regions\n");
-
-  std::atomic_bool invalid(false);
-
   std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
   imageDescribers.resize(imageDescriberTypes.size());
 
+  std::vector<std::unique_ptr<feature::RegionsContainerReader>> containers;
+  containers.resize(imageDescriberTypes.size());
+
   for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
+  {
     imageDescribers.at(i) = createImageDescriber(imageDescriberTypes.at(i));
+    containers.at(i) = openRegionsContainer(featuresFolders, imageDescriberTypes.at(i));
+  }
+
+  std::vector<LoadTask> tasks;
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const IndexT viewId = viewPair.second->getViewId();
+    if(!viewIdFilter.empty() && viewIdFilter.find(viewId) == viewIdFilter.end())
+      continue;
+    for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
+      tasks.push_back({viewId, i});
+  }
+
+  const auto loadTask = [&](const LoadTask& task, std::unique_ptr<feature::Regions>& regionsPtr)
+  {
+    const auto& container = containers.at(task.describerIndex);
+
+    if(container && container->hasView(task.viewId))
+    {
+      imageDescribers.at(task.describerIndex)->allocate(regionsPtr);
+      container->load(task.viewId, *regionsPtr);
+    }
+    else
+    {
+      regionsPtr = loadRegions(featuresFolders, task.viewId, *(imageDescribers.at(task.describerIndex)));
+    }
+
+    if(regionsPtr && descriptorPCA != nullptr && descriptorPCA->isValid())
+      regionsPtr = descriptorPCA->project(*regionsPtr);
 
-#pragma omp parallel num_threads(3)
- for(auto iter = sfmData.getViews().begin(); iter != sfmData.getViews().end() && !invalid; ++iter)
- {
-#pragma omp single nowait
-   {
-     for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
-     {
-       if(viewIdFilter.empty() || viewIdFilter.find(iter->second.get()->getViewId()) != viewIdFilter.end())
-       {
-         std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, iter->second.get()->getViewId(), *(imageDescribers.at(i)));
-         if(regionsPtr)
-         {
-#pragma omp critical
-           {
-             regionsPerView.addRegions(iter->second.get()->getViewId(), imageDescriberTypes.at(i), regionsPtr.release());
-             ++progressBar;
-           }
-         }
-         else
-         {
-           invalid = true;
-         }
-       }
-     }
-   }
- }
- return !invalid;
+    return regionsPtr != nullptr;
+  };
+
+  std::vector<std::unique_ptr<feature::Regions>> regions;
+  if(!loadInParallel(tasks, nbThreads, "Loading regions\n", loadTask, regions))
+    return false;
+
+  for(std::size_t t = 0; t < tasks.size(); ++t)
+    regionsPerView.addRegions(tasks[t].viewId, imageDescriberTypes.at(tasks[t].describerIndex), regions[t].release());
+
+  return true;
 }
 
 
 bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
                       const SfMData& sfmData,
                       const std::vector<std::string>& folders,
-                      const std::vector<feature::EImageDescriberType>& imageDescriberTypes)
+                      const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
+                      int nbThreads)
 {
   std::vector<std::string> featuresFolders = sfmData.getFeaturesFolders(); // add sfm features folders
   featuresFolders.insert(featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
 
-  boost::progress_display progressBar(sfmData.getViews().size(), std::cout, "Loading features\n");
+  std::vector<std::unique_ptr<feature::RegionsContainerReader>> containers;
+  containers.resize(imageDescriberTypes.size());
 
-  // read for each view the corresponding features and store them as PointFeatures
-  std::atomic_bool invalid(false);
+  for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
+    containers.at(i) = openRegionsContainer(featuresFolders, imageDescriberTypes.at(i));
 
-  std::vector< std::unique_ptr<feature::ImageDescriber> > imageDescribers;
-  imageDescribers.resize(imageDescriberTypes.size());
+  std::vector<LoadTask> tasks;
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
+      tasks.push_back({viewPair.second->getViewId(), i});
+  }
 
-  for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
-    imageDescribers.at(i) = createImageDescriber(imageDescriberTypes.at(i));
+  // read for each view only the positions of the corresponding features
+  const auto loadTask = [&](const LoadTask& task, feature::PointFeatures& positions)
+  {
+    const auto& container = containers.at(task.describerIndex);
+
+    if(container && container->hasView(task.viewId))
+      container->loadPositions(task.viewId, positions);
+    else
+      positions = loadFeaturePositions(featuresFolders, task.viewId, imageDescriberTypes.at(task.describerIndex));
+    return true;
+  };
+
+  std::vector<feature::PointFeatures> positions;
+  if(!loadInParallel(tasks, nbThreads, "Loading features\n", loadTask, positions))
+    return false;
+
+  for(std::size_t t = 0; t < tasks.size(); ++t)
+    featuresPerView.addFeatures(tasks[t].viewId, imageDescriberTypes[tasks[t].describerIndex], std::move(positions[t]));
+
+  return true;
+}
+
+RegionsProvider::RegionsProvider(const SfMData& sfmData,
+                                 const std::vector<std::string>& folders,
+                                 const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
+                                 std::size_t maxMemory)
+  : _featuresFolders(sfmData.getFeaturesFolders()) // add sfm features folders
+  , _maxMemory(maxMemory)
+{
+  _featuresFolders.insert(_featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
+
+  for(const feature::EImageDescriberType descType : imageDescriberTypes)
+  {
+    _imageDescribers[descType] = createImageDescriber(descType);
+    _containers[descType] = openRegionsContainer(_featuresFolders, descType);
+  }
+}
 
-#pragma omp parallel
-  for (auto iter = sfmData.getViews().begin(); (iter != sfmData.getViews().end()) && (!invalid); ++iter)
+std::shared_ptr<const feature::Regions> RegionsProvider::getRegions(IndexT viewId, feature::EImageDescriberType descType)
+{
+  const Key key(viewId, descType);
   {
-#pragma omp single nowait
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _cache.find(key);
+    if(it != _cache.end())
     {
-      for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
-      {
-        std::unique_ptr<feature::Regions> regionsPtr = loadFeatures(featuresFolders, iter->second.get()->getViewId(), *imageDescribers.at(i));
-
-#pragma omp critical
-        {
-          // save loaded Features as PointFeature
-          featuresPerView.addFeatures(iter->second.get()->getViewId(), imageDescriberTypes[i], regionsPtr->GetRegionsPositions());
-          ++progressBar;
-        }
-      }
+      _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+      return it->second.regions;
     }
   }
-  return !invalid;
+
+  // load outside of the lock, so the views are read in parallel
+  const auto describerIt = _imageDescribers.find(descType);
+  if(describerIt == _imageDescribers.end())
+    throw std::runtime_error("Regions provider: no " + feature::EImageDescriberType_enumToString(descType) + " regions.");
+
+  std::unique_ptr<feature::Regions> regionsPtr;
+  const auto& container = _containers.at(descType);
+  if(container && container->hasView(viewId))
+  {
+    describerIt->second->allocate(regionsPtr);
+    container->load(viewId, *regionsPtr);
+  }
+  else
+  {
+    regionsPtr = loadRegions(_featuresFolders, viewId, *describerIt->second);
+  }
+  std::shared_ptr<const feature::Regions> regions(std::move(regionsPtr));
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  ++_nbLoads;
+
+  // loaded by another thread in the meantime
+  const auto it = _cache.find(key);
+  if(it != _cache.end())
+  {
+    _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+    return it->second.regions;
+  }
+
+  _lru.push_front(key);
+  const std::size_t memorySize = getMemorySize(*regions);
+  _cache[key] = {regions, memorySize, _lru.begin()};
+  _memoryUsage += memorySize;
+
+  // evict the least recently used regions, the last loaded are kept even if they exceed the budget
+  while(_memoryUsage > _maxMemory && _lru.size() > 1)
+  {
+    const auto evictedIt = _cache.find(_lru.back());
+    _memoryUsage -= evictedIt->second.memorySize;
+    _cache.erase(evictedIt);
+    _lru.pop_back();
+  }
+  return regions;
+}
+
+std::size_t RegionsProvider::getMemoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _memoryUsage;
+}
+
+std::size_t RegionsProvider::getNbLoads() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbLoads;
 }
 
-  
 } // namespace sfm
 } // namespace aliceVision
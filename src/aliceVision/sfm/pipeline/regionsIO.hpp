@@ -13,8 +13,13 @@
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
+#include <aliceVision/feature/RegionsContainer.hpp>
+#include <aliceVision/feature/DescriptorPCA.hpp>
 
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 
 namespace aliceVision {
 namespace sfm {
@@ -37,33 +42,118 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
  */
 std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber);
 
+/**
+ * @brief Load only the feature positions for one view, without allocating the regions.
+ * @param[in] folders The list of featureFolders
+ * @param[in] viewId The view id
+ * @param[in] imageDescriberType The imageDescriber type
+ * @return loaded feature positions
+ */
+feature::PointFeatures loadFeaturePositions(const std::vector<std::string>& folders, IndexT viewId, feature::EImageDescriberType imageDescriberType);
+
+/**
+ * @brief Open the binary regions container of the given describer type, if any.
+ * @param[in] folders The list of featureFolders (the last folder has the priority)
+ * @param[in] imageDescriberType The imageDescriber type
+ * @return the container reader or nullptr if there is no valid container
+ */
+std::unique_ptr<feature::RegionsContainerReader> openRegionsContainer(const std::vector<std::string>& folders,
+                                                                      feature::EImageDescriberType imageDescriberType);
+
 /**
  * @brief Load Regions (Features & Descriptors) for each view of the provided SfMData container.
+ * @note If a binary regions container exists in the folders, the views it contains are read from it.
  * @param[in,out] regionsPerView
  * @param[in] sfmData The provided SfMData container
  * @param[in] folders The feature Folders
  * @param[in] imageDescriberTypes The imageDescriber types
  * @param[in] filter To load Regions only for a sub-set of the views contained in the sfmData
+ * @param[in] nbThreads The number of regions files read in parallel (0: one per core)
+ * @param[in] descriptorPCA If valid, the descriptors are reduced as soon as they are loaded (only the reduced ones stay in memory)
  * @return true if the regions are correctlty loaded
  */
 bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
                         const SfMData& sfmData,
                         const std::vector<std::string>& folders,
                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
-                        const std::set<IndexT>& filter = std::set<IndexT>());
+                        const std::set<IndexT>& filter = std::set<IndexT>(),
+                        int nbThreads = 3,
+                        const feature::DescriptorPCA* descriptorPCA = nullptr);
 
 /**
  * @brief Load Features for each view of the provided SfMData container.
+ * @note Only the feature positions are read: neither the descriptors nor the scale and orientation are loaded.
  * @param[in,out] featuresPerView
  * @param[in] sfmData The provided SfMData container
  * @param[in] folders The feature Folders
  * @param[in] imageDescriberTypes The imageDescriber types
+ * @param[in] nbThreads The number of features files read in parallel (0: one per core)
  * @return true if the features are correctlty loaded
  */
 bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
                          const SfMData& sfmData,
                          const std::vector<std::string>& folders,
-                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes);
+                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
+                         int nbThreads = 0);
+
+/**
+ * @brief Lazy access to the Regions (Features & Descriptors) of the views of a SfMData container.
+ *
+ * The regions of a view are loaded at their first access and kept in a LRU cache under a memory budget,
+ * so all the descriptors don't have to stay in memory. Thread-safe.
+ */
+class RegionsProvider
+{
+public:
+  /**
+   * @param[in] sfmData The provided SfMData container
+   * @param[in] folders The feature Folders
+   * @param[in] imageDescriberTypes The imageDescriber types
+   * @param[in] maxMemory The memory budget of the cached regions (bytes)
+   */
+  RegionsProvider(const SfMData& sfmData,
+                  const std::vector<std::string>& folders,
+                  const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
+                  std::size_t maxMemory);
+
+  /**
+   * @brief Get the regions of a view, loaded if they are not in the cache
+   * @note The regions remain valid while the pointer is held, even if they are evicted from the cache.
+   * @param[in] viewId The view id
+   * @param[in] descType The imageDescriber type (one of the provider types)
+   * @return the regions of the view
+   * @throw std::runtime_error if the regions can't be loaded
+   */
+  std::shared_ptr<const feature::Regions> getRegions(IndexT viewId, feature::EImageDescriberType descType);
+
+  /// Return the memory used by the cached regions (bytes)
+  std::size_t getMemoryUsage() const;
+
+  /// Return the number of regions loaded from the disk (cache misses)
+  std::size_t getNbLoads() const;
+
+private:
+  using Key = std::pair<IndexT, feature::EImageDescriberType>;
+
+  struct Entry
+  {
+    std::shared_ptr<const feature::Regions> regions;
+    std::size_t memorySize;
+    std::list<Key>::iterator lruIt;
+  };
+
+  std::vector<std::string> _featuresFolders;
+  std::map<feature::EImageDescriberType, std::unique_ptr<feature::ImageDescriber>> _imageDescribers;
+  std::map<feature::EImageDescriberType, std::unique_ptr<feature::RegionsContainerReader>> _containers;
+  const std::size_t _maxMemory;
+
+  mutable std::mutex _mutex;
+  std::map<Key, Entry> _cache;
+  /// cached keys, from the most to the least recently used
+  std::list<Key> _lru;
+  std::size_t _memoryUsage = 0;
+  std::size_t _nbLoads = 0;
+};
 
 } // namespace sfm
 } // namespace aliceVision
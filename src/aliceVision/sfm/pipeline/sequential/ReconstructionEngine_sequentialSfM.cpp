@@ -11,7 +11,9 @@
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/PartitionedBundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/sfmDataFilters.hpp>
+#include <aliceVision/sfm/DenseSfMData.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/multiview/essential.hpp>
@@ -22,9 +24,12 @@
 #include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
 #include <aliceVision/graph/connectedComponent.hpp>
 #include <aliceVision/stl/stl.hpp>
+#include <aliceVision/stl/hash.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/cpu.hpp>
+#include <aliceVision/system/Determinism.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
@@ -33,6 +38,7 @@
 #include <boost/format.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <cmath>
 #include <tuple>
 #include <iostream>
 #include <algorithm>
@@ -170,6 +176,7 @@ bool ReconstructionEngine_sequentialSfM::process()
 
   // reconstruction
   const double elapsedTime = incrementalReconstruction();
+  waitCheckpoint();
 
   exportStatistics(elapsedTime);
 
@@ -223,6 +230,8 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
     ALICEVISION_LOG_DEBUG("Build tracks pyramid per view");
     computeTracksPyramidPerView(
             _map_tracksPerView, _map_tracks, _sfmData.views, *_featuresPerView, _pyramidBase, _pyramidDepth, _map_featsPyramidPerView);
+    if(system::MemoryAccounting::isEnabled())
+      _tracksMemory.set(track::getMemorySize(_map_tracks) + track::getMemorySize(_map_tracksPerView));
 
     // display stats
     {
@@ -353,7 +362,7 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
       viewIds.insert(viewId);
 
     if(viewResectionId != UndefinedIndexT &&
-       viewResectionId > resectionId)
+       viewResectionId >= resectionId)
     {
       resectionId = viewResectionId + 1;
     }
@@ -405,8 +414,12 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
   // get reconstructed views before resection
   const std::set<IndexT> prevReconstructedViews = _sfmData.getValidViews();
 
-  // add images to the 3D reconstruction
-#pragma omp parallel for
+  // robust resection of all the candidate views:
+  // each resection only reads the scene, so they can all run in parallel
+  std::vector<ResectionData> resectionDataPerView(bestViewIds.size());
+  std::vector<char> hasResectedPerView(bestViewIds.size(), false);
+
+#pragma omp parallel for schedule(dynamic)
   for(int i = 0; i < bestViewIds.size(); ++i)
   {
     const IndexT viewId = bestViewIds.at(i);
@@ -422,10 +435,6 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
           << "\t- view id: " << viewId << std::endl
           << "\t- rig id: " << view.getRigId() << std::endl
           << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        viewIds.erase(viewId);
-
         continue;
       }
 
@@ -441,32 +450,37 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
           << "\t- view id: " << viewId << std::endl
           << "\t- rig id: " << view.getRigId() << std::endl
           << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        viewIds.erase(viewId);
-
         continue;
       }
     }
 
-    ResectionData newResectionData;
-    const bool hasResected = computeResection(viewId, newResectionData);
+    hasResectedPerView.at(i) = computeResection(viewId, resectionDataPerView.at(i));
+  }
 
-#pragma omp critical
+  // commit the resected views to the scene in the candidates order,
+  // so the result does not depend on the threads scheduling
+  for(std::size_t i = 0; i < bestViewIds.size(); ++i)
+  {
+    const IndexT viewId = bestViewIds.at(i);
+    viewIds.erase(viewId);
+
+    if(!hasResectedPerView.at(i))
     {
-      if(hasResected)
-      {
-        imageAdded |= hasResected;
-        updateScene(viewId, newResectionData);
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
-        _sfmData.getViews().at(viewId)->setResectionId(resectionId);
-      }
-      else
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
-      }
-      viewIds.erase(viewId);
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
+      continue;
     }
+
+    // the view can be indirectly localized by a view of the same rig committed before
+    if(_sfmData.getViews().at(viewId)->isPartOfRig() && _sfmData.isPoseAndIntrinsicDefined(viewId))
+    {
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was skipped, view indirectly localized.");
+      continue;
+    }
+
+    imageAdded = true;
+    updateScene(viewId, resectionDataPerView.at(i));
+    ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
+    _sfmData.getViews().at(viewId)->setResectionId(resectionId);
   }
 
   ALICEVISION_LOG_DEBUG("Resection of " << bestViewIds.size() << " new images took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
@@ -498,7 +512,7 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
 
   if(imageAdded)
   {
-    if((resectionId % 3) == 0)
+    if(_sfmdataInterFileInterval > 0 && (resectionId % _sfmdataInterFileInterval) == 0)
     {
       chrono_start = std::chrono::steady_clock::now();
       // scene logging as ply for visual debug
@@ -558,9 +572,50 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
     ALICEVISION_LOG_DEBUG("eraseUnstablePosesAndObservations took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
   }
 
+  if(system::MemoryAccounting::isEnabled())
+    _structureMemory.set(getMemorySize(_sfmData.getLandmarks()));
+
   ALICEVISION_LOG_INFO("Update Reconstruction complete: " << std::endl
      << "\t- # cameras calibrated: " << _sfmData.getPoses().size() << std::endl
      << "\t- # landmarks: " << _sfmData.getLandmarks().size());
+
+  if(imageAdded && _checkpointInterval > 0 && (resectionId % _checkpointInterval) == 0)
+    saveCheckpoint();
+}
+
+void ReconstructionEngine_sequentialSfM::saveCheckpoint()
+{
+  waitCheckpoint();
+
+  const auto chrono_start = std::chrono::steady_clock::now();
+
+  // the reconstruction goes on while the checkpoint is saved:
+  // copy the views and the intrinsics, they are shared and updated in place
+  std::shared_ptr<SfMData> checkpoint = std::make_shared<SfMData>(_sfmData);
+  for(auto& viewPair : checkpoint->getViews())
+    viewPair.second = std::make_shared<View>(*viewPair.second);
+  for(auto& intrinsicPair : checkpoint->getIntrinsics())
+    intrinsicPair.second.reset(intrinsicPair.second->clone());
+
+  ALICEVISION_LOG_DEBUG("Copy of the checkpoint took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
+
+  // Save writes a temporary file and renames it: an interrupted save keeps the previous checkpoint
+  const std::string filepath = _checkpointFilepath;
+  _checkpointSaving = std::async(std::launch::async, [checkpoint, filepath]()
+  {
+    return Save(*checkpoint, filepath, ESfMData::ALL);
+  });
+}
+
+void ReconstructionEngine_sequentialSfM::waitCheckpoint()
+{
+  if(!_checkpointSaving.valid())
+    return;
+
+  if(_checkpointSaving.get())
+    ALICEVISION_LOG_INFO("Checkpoint saved: " << _checkpointFilepath);
+  else
+    ALICEVISION_LOG_WARNING("Unable to save the checkpoint: " << _checkpointFilepath);
 }
 
 void ReconstructionEngine_sequentialSfM::exportStatistics(double reconstructionTime)
@@ -1124,15 +1179,34 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
       xJ.col(cptIndex) = camJ->get_ud_pixel(feat);
     }
     
-    // Robust estimation of the relative pose
     RelativePoseInfo relativePose_info;
     relativePose_info.initial_residual_tolerance = Square(4.0);
-    
-    const bool relativePoseSuccess = robustRelativePose(
-          camI->K(), camJ->K(),
-          xI, xJ, relativePose_info,
-          std::make_pair(camI->w(), camI->h()), std::make_pair(camJ->w(), camJ->h()),
-          1024);
+
+    // relative pose from the model of the matching geometric filtering, if it is still valid
+    // (the model relates the first view of the pair to the second one)
+    bool relativePoseSuccess = false;
+    Mat3 E;
+    if(_geometricModels != nullptr && current_pair.first == I && _geometricModels->count(current_pair) &&
+       matching::getEssentialMatrix(_geometricModels->at(current_pair), camI->K(), camJ->K(), E))
+    {
+      const matching::PairGeometricModel& model = _geometricModels->at(current_pair);
+      const double maxResidual = std::isfinite(model.threshold) ? model.threshold : 4.0;
+      relativePoseSuccess = relativePoseFromEssential(camI->K(), camJ->K(), xI, xJ, E, maxResidual, relativePose_info) &&
+                            relativePose_info.vec_inliers.size() >= model.nbInliers / 2;
+    }
+
+    // Robust estimation of the relative pose
+    if(!relativePoseSuccess)
+    {
+      relativePose_info = RelativePoseInfo();
+      relativePose_info.initial_residual_tolerance = Square(4.0);
+
+      relativePoseSuccess = robustRelativePose(
+            camI->K(), camJ->K(),
+            xI, xJ, relativePose_info,
+            std::make_pair(camI->w(), camI->h()), std::make_pair(camJ->w(), camJ->h()),
+            1024);
+    }
     
     if (relativePoseSuccess && relativePose_info.vec_inliers.size() > iMin_inliers_count)
     {
@@ -1207,21 +1281,41 @@ double ReconstructionEngine_sequentialSfM::computeResidualsHistogram(Histogram<d
   if (_sfmData.getLandmarks().empty())
     return -1.0;
   
-  // Collect residuals for each observation
-  std::vector<float> vec_residuals;
-  vec_residuals.reserve(_sfmData.structure.size());
-  for(const auto &track : _sfmData.getLandmarks())
+  // Collect residuals for each observation, in parallel over the landmarks of the dense index
+  const DenseSfMData denseSfMData(_sfmData);
+  const int nbLandmarks = static_cast<int>(denseSfMData.getNbLandmarks());
+
+  std::vector<float> vec_residuals(2 * denseSfMData.getNbObservations());
+  std::vector<char> isDefined(denseSfMData.getNbObservations(), 0);
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
   {
-    const Observations & observations = track.second.observations;
-    for(const auto& obs: observations)
+    const Vec3 X = denseSfMData.getLandmarkPosition(landmarkSlot);
+    for(std::size_t obs = denseSfMData.getObservationsBegin(landmarkSlot); obs < denseSfMData.getObservationsEnd(landmarkSlot); ++obs)
     {
-      const View* view = _sfmData.getViews().find(obs.first)->second.get();
-      const Pose3 pose = _sfmData.getPose(*view).getTransform();
-      const std::shared_ptr<IntrinsicBase> intrinsic = _sfmData.getIntrinsics().find(view->getIntrinsicId())->second;
-      const Vec2 residual = intrinsic->residual(pose, track.second.X, obs.second.x);
-      vec_residuals.push_back( fabs(residual(0)) );
-      vec_residuals.push_back( fabs(residual(1)) );
+      const std::uint32_t viewSlot = denseSfMData.getObservationView(obs);
+      if(!denseSfMData.isPoseAndIntrinsicDefined(viewSlot))
+        continue;
+      const Vec2 residual = denseSfMData.getIntrinsic(viewSlot)->residual(denseSfMData.getPose(viewSlot), X, denseSfMData.getObservationPoint(obs));
+      vec_residuals[2 * obs] = fabs(residual(0));
+      vec_residuals[2 * obs + 1] = fabs(residual(1));
+      isDefined[obs] = 1;
+    }
+  }
+
+  // remove the observations of the views without pose or intrinsic
+  if(std::find(isDefined.begin(), isDefined.end(), 0) != isDefined.end())
+  {
+    std::size_t nbResiduals = 0;
+    for(std::size_t obs = 0; obs < isDefined.size(); ++obs)
+    {
+      if(!isDefined[obs])
+        continue;
+      vec_residuals[nbResiduals++] = vec_residuals[2 * obs];
+      vec_residuals[nbResiduals++] = vec_residuals[2 * obs + 1];
     }
+    vec_residuals.resize(nbResiduals);
   }
   
   assert(!vec_residuals.empty());
@@ -1313,6 +1407,7 @@ std::size_t ReconstructionEngine_sequentialSfM::computeImageScore(IndexT viewId,
  */
 bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex, ResectionData& resectionData)
 {
+  ALICEVISION_PROFILE_ZONE("sequentialSfM::resection");
   using namespace track;
 
   // A. Compute 2D/3D matches
@@ -1320,16 +1415,23 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
   const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewIndex);
 
   // A2. intersects the track list with the reconstructed
-  std::set<std::size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
-  
-  // Get the ids of the already reconstructed tracks
-  std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                        reconstructed_trackId.begin(),
-                        reconstructed_trackId.end(),
-                        std::inserter(resectionData.tracksId, resectionData.tracksId.begin()));
+  {
+    // scratch list of all the landmarks, in the arena of the thread
+    stl::monotonic_arena& arena = stl::thread_arena();
+    stl::arena_scope arenaScope(arena);
+    stl::arena_vector<std::size_t> reconstructed_trackId{stl::arena_allocator<std::size_t>(arena)};
+    reconstructed_trackId.reserve(_sfmData.getLandmarks().size());
+    std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
+                   std::back_inserter(reconstructed_trackId),
+                   stl::RetrieveKey());
+    std::sort(reconstructed_trackId.begin(), reconstructed_trackId.end());
+
+    // Get the ids of the already reconstructed tracks
+    std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
+                          reconstructed_trackId.begin(),
+                          reconstructed_trackId.end(),
+                          std::inserter(resectionData.tracksId, resectionData.tracksId.begin()));
+  }
   
   if (resectionData.tracksId.empty())
   {
@@ -1352,7 +1454,12 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
   
   // B. Look if intrinsic data is known or not
   const View * view_I = _sfmData.getViews().at(viewIndex).get();
-  resectionData.optionalIntrinsic = _sfmData.getIntrinsicsharedPtr(view_I->getIntrinsicId());
+  // work on a copy of the intrinsic, it is committed to the scene in updateScene
+  {
+    const std::shared_ptr<camera::IntrinsicBase> intrinsic = _sfmData.getIntrinsicsharedPtr(view_I->getIntrinsicId());
+    if(intrinsic)
+      resectionData.optionalIntrinsic.reset(intrinsic->clone());
+  }
   
   std::size_t cpt = 0;
   std::set<std::size_t>::const_iterator iterTrackId = resectionData.tracksId.begin();
@@ -1378,6 +1485,7 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
     );
 
   if (!_htmlLogFile.empty())
+#pragma omp critical(htmlDocStream)
   {
     using namespace htmlDocument;
     std::ostringstream os;
@@ -1436,9 +1544,11 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
     // If we use a camera intrinsic for the first time we need to refine it.
     const bool intrinsicsFirstUsage = (reconstructedIntrinsics.count(view_I->getIntrinsicId()) == 0);
 
+    resectionData.isRefinedIntrinsic = resectionData.isNewIntrinsic || intrinsicsFirstUsage;
+
     if(!sfm::SfMLocalizer::RefinePose(
       resectionData.optionalIntrinsic.get(), resectionData.pose,
-      resectionData, true, resectionData.isNewIntrinsic || intrinsicsFirstUsage))
+      resectionData, true, resectionData.isRefinedIntrinsic))
     {
       ALICEVISION_LOG_INFO("Resection of view " << viewIndex << " failed during pose refinement.");
       return false;
@@ -1455,6 +1565,15 @@ void ReconstructionEngine_sequentialSfM::updateScene(const IndexT viewIndex, con
   _map_ACThreshold.insert(std::make_pair(viewIndex, resectionData.error_max));
 
   const View& view = *_sfmData.views.at(viewIndex);
+
+  // update the scene intrinsic if it has been estimated by the resection
+  // and not already set by another view of this resection group
+  if(resectionData.isRefinedIntrinsic &&
+     _sfmData.getReconstructedIntrinsics().count(view.getIntrinsicId()) == 0)
+  {
+    _sfmData.intrinsics.at(view.getIntrinsicId())->assign(*resectionData.optionalIntrinsic);
+  }
+
   _sfmData.setPose(view, CameraPose(resectionData.pose));
 
   // B. Update the observations into the global scene structure
@@ -1476,7 +1595,7 @@ void ReconstructionEngine_sequentialSfM::updateScene(const IndexT viewIndex, con
 
 bool ReconstructionEngine_sequentialSfM::checkChieralities(
   const Vec3& pt3D, 
-  const std::set<IndexT> & viewsId, 
+  const stl::arena_set<IndexT> & viewsId, 
   const SfMData& scene)
 {
   for (const IndexT & viewId : viewsId)
@@ -1490,7 +1609,7 @@ bool ReconstructionEngine_sequentialSfM::checkChieralities(
   return true;
 }
 
-bool ReconstructionEngine_sequentialSfM::checkAngles(const Vec3 &pt3D, const std::set<IndexT> &viewsId, const SfMData &scene, const double &kMinAngle)
+bool ReconstructionEngine_sequentialSfM::checkAngles(const Vec3 &pt3D, const stl::arena_set<IndexT> &viewsId, const SfMData &scene, const double &kMinAngle)
 { 
   for (const std::size_t & viewIdA : viewsId)
   {
@@ -1565,10 +1684,31 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
   std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
                  std::inserter(setTracksId, setTracksId.begin()),
                  stl::RetrieveKey());
-                   
-#pragma omp parallel for 
+
+  // -- Prepare the cache entries and the existing landmarks of the tracks:
+  // the scene structure and the cache are not modified in the parallel loop,
+  // each iteration only accesses the elements of its own track.
+  std::vector<TrackTriangulation*> cachePerTrack(setTracksId.size());
+  std::vector<Landmark*> landmarkPerTrack(setTracksId.size(), nullptr);
+  for (std::size_t i = 0; i < setTracksId.size(); ++i)
+  {
+    const IndexT trackId = setTracksId.at(i);
+    cachePerTrack.at(i) = &_triangulationCache[trackId];
+    auto landmarkIt = scene.structure.find(trackId);
+    if (landmarkIt != scene.structure.end())
+      landmarkPerTrack.at(i) = &landmarkIt->second;
+  }
+
+  std::size_t nbSkippedTracks = 0;
+  std::size_t nbExtendedTracks = 0;
+
+#pragma omp parallel for reduction(+:nbSkippedTracks,nbExtendedTracks)
   for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
   {
+    // the scratch containers of the iteration are in the arena of the thread
+    stl::monotonic_arena& arena = stl::thread_arena();
+    stl::arena_scope arenaScope(arena);
+
     const IndexT trackId = setTracksId.at(i);
     bool isValidTrack = true;
     const track::Track& track = _map_tracks.at(trackId);
@@ -1577,9 +1717,64 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
     // The track needs to be seen by a min. number of views to be triangulated
     if (observations.size() < _minNbObservationsForTriangulation)
       continue;
-    
+
+    TrackTriangulation& cache = *cachePerTrack.at(i);
+    Landmark* sceneLandmark = landmarkPerTrack.at(i);
+
+    std::size_t observationsHash = 0;
+    for (const IndexT viewId : observations)
+      stl::hash_combine(observationsHash, viewId);
+
+    // -- Use the cache:
+    //  - same reconstructed views: the landmark is already up to date (or was rejected)
+    //  - new views consistent with the landmark: add them as observations, no need to triangulate again
+    if (cache.observationsHash == observationsHash && (!cache.isValid || sceneLandmark != nullptr))
+    {
+      ++nbSkippedTracks;
+      continue;
+    }
+
+    if (cache.isValid && sceneLandmark != nullptr)
+    {
+      bool isConsistent = true;
+      stl::arena_vector<IndexT> newObservations{stl::arena_allocator<IndexT>(arena)};
+      newObservations.reserve(observations.size());
+      for (const IndexT viewId : observations)
+      {
+        if (sceneLandmark->observations.count(viewId))
+          continue;
+        const View* view = scene.getViews().at(viewId).get();
+        const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
+        const Pose3 pose = scene.getPose(*view).getTransform();
+        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
+        const auto& acThresholdIt = _map_ACThreshold.find(viewId);
+        const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
+
+        if (pose.depth(sceneLandmark->X) < 0 || cam->residual(pose, sceneLandmark->X, x).norm() > acThreshold)
+        {
+          isConsistent = false;
+          break;
+        }
+        newObservations.push_back(viewId);
+      }
+
+      if (isConsistent)
+      {
+        for (const IndexT viewId : newObservations)
+        {
+          const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
+          sceneLandmark->observations[viewId] = Observation(x, track.featPerView.at(viewId));
+          cache.inliers.insert(viewId);
+        }
+        cache.observationsHash = observationsHash;
+        cache.X = sceneLandmark->X;
+        ++nbExtendedTracks;
+        continue;
+      }
+    }
+
     Vec3 X_euclidean = Vec3::Zero();
-    std::set<IndexT> inliers;
+    stl::arena_set<IndexT> inliers{std::less<IndexT>(), stl::arena_allocator<IndexT>(arena)};
     
     if (observations.size() == 2) 
     {
@@ -1587,7 +1782,7 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
        *    2 observations : triangulation using DLT
        * -------------------------------------------- */ 
        
-      inliers = observations;
+      inliers.insert(observations.begin(), observations.end());
       
       // -- Prepare:
       IndexT I =  *(observations.begin());
@@ -1634,6 +1829,7 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
       // -- Prepare:
       Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
       std::vector<Mat34> Ps; // projective matrices (one per pose)
+      Ps.reserve(observations.size());
       {
         const track::Track& track = _map_tracks.at(trackId);
         
@@ -1672,6 +1868,12 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
         isValidTrack = false;
     }  
 
+    cache.observationsHash = observationsHash;
+    cache.X = X_euclidean;
+    cache.inliers.clear();
+    cache.inliers.insert(inliers.begin(), inliers.end());
+    cache.isValid = isValidTrack;
+
     // -- Add the tringulated point to the scene
     if (isValidTrack)
     {
@@ -1697,10 +1899,14 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
       }
     }
   } // for all shared tracks 
+
+  ALICEVISION_LOG_DEBUG("Triangulation cache: " << nbSkippedTracks << " tracks skipped, " << nbExtendedTracks
+                        << " landmarks extended, " << setTracksId.size() - nbSkippedTracks - nbExtendedTracks << " tracks triangulated.");
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
 {
+  ALICEVISION_PROFILE_ZONE("sequentialSfM::triangulate");
   {
     std::vector<IndexT> intersection;
     std::set_intersection(
@@ -1716,8 +1922,12 @@ void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::
   std::set<IndexT> allReconstructedViews;
   allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
   allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
-  
-#pragma omp parallel for schedule(dynamic)
+
+  // a track shared by several pairs is created by the first pair which triangulates it:
+  // in the deterministic mode, the pairs are processed in their serial order
+  const bool deterministic = system::Determinism::isEnabled();
+
+#pragma omp parallel for schedule(dynamic) if(!deterministic)
   for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(allReconstructedViews.size()); ++i)
   {
     std::set<IndexT>::const_iterator iter = allReconstructedViews.begin();
@@ -1860,41 +2070,41 @@ void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::
 /// Bundle adjustment to refine Structure; Motion and Intrinsics
 bool ReconstructionEngine_sequentialSfM::BundleAdjustment(bool fixedIntrinsics)
 {
-  BundleAdjustmentCeres::BA_options options;
-  if (_sfmData.getPoses().size() > 100)
-  {
-    ALICEVISION_LOG_DEBUG("Global BundleAdjustment sparse");
-    options.setSparseBA();
-  }
-  else
-  {
-    ALICEVISION_LOG_DEBUG("Global BundleAdjustment dense");
-    options.setDenseBA();
-  }
-  BundleAdjustmentCeres bundle_adjustment_obj(options);
+  ALICEVISION_PROFILE_ZONE("sequentialSfM::bundleAdjustment");
   BA_Refine refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
   if(!fixedIntrinsics)
     refineOptions |= BA_REFINE_INTRINSICS_ALL;
+
+  if(_maxNbPosesPerSubmap > 0 && _sfmData.getPoses().size() > _maxNbPosesPerSubmap)
+  {
+    // large scene: bundle adjustment by submaps
+    PartitionedBundleAdjustmentCeres::PBA_options options;
+    options._maxNbPosesPerSubmap = _maxNbPosesPerSubmap;
+    options._maxNbSeparatorPoses = _maxNbPosesPerSubmap / 2;
+    PartitionedBundleAdjustmentCeres bundle_adjustment_obj(options);
+    return bundle_adjustment_obj.Adjust(_sfmData, refineOptions);
+  }
+
+  BundleAdjustmentCeres::BA_options options;
+  options.setAdaptiveBA(BundleAdjustmentCeres::BA_problemSize(_sfmData));
+  BundleAdjustmentCeres bundle_adjustment_obj(options);
   return bundle_adjustment_obj.Adjust(_sfmData, refineOptions);
 }
 
 bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<IndexT>& newReconstructedViews)
 {
+  ALICEVISION_PROFILE_ZONE("sequentialSfM::localBundleAdjustment");
   
   // -- Manage Ceres options (parameter ordering, local BA, sparse/dense mode, etc.)
   
   LocalBundleAdjustmentCeres::LocalBA_options options;
   options.enableParametersOrdering();
   
-  if (_sfmData.getPoses().size() > 100) // default value: 100 
-  {
-    options.setSparseBA();
+  BundleAdjustmentCeres::BA_problemSize problemSize(_sfmData);
+  if (problemSize._nbPoses > options._maxNbPosesDenseBA) // default value: 100
     options.enableLocalBA();
-  }
-  else
-  {
-    options.setDenseBA();
-  }
+
+  options.setAdaptiveBA(problemSize);
   
   const std::size_t kMinNbOfMatches = 50; // default value: 50 
   bool isBaSucceed;
@@ -1913,14 +2123,13 @@ bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<In
     _localBA_data->computeGraphDistances(_sfmData, newReconstructedViews);
 
     // Use the graph-distances to assign a LBA state (Refine, Constant & Ignore) for each parameter (poses, intrinsics & landmarks)
-    _localBA_data->convertDistancesToLBAStates(_sfmData); 
+    _localBA_data->convertDistancesToLBAStates(_sfmData, _map_tracksPerView);
 
     // Check Ceres mode: 
-    // Restore the Ceres Dense mode if the number of cameras in the solver is <= 100
-    if (_localBA_data->getNumOfRefinedPoses() + _localBA_data->getNumOfConstantPoses() <= 100)
-    {
-      options.setDenseBA();
-    }
+    // Select the solver according to the number of cameras in the solver (Dense mode if <= 100)
+    problemSize._nbPoses = _localBA_data->getNumOfRefinedPoses() + _localBA_data->getNumOfConstantPoses();
+    problemSize._nbLandmarks = _localBA_data->getNumOfRefinedLandmarks() + _localBA_data->getNumOfConstantLandmarks();
+    options.setAdaptiveBA(problemSize);
     
     localBA_ceres = LocalBundleAdjustmentCeres(*_localBA_data, options, newReconstructedViews);
     
@@ -14,6 +14,8 @@
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/track/Track.hpp>
+#include <aliceVision/stl/MonotonicArena.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 #include <dependencies/histogram/histogram.hpp>
@@ -21,6 +23,8 @@
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <future>
+
 namespace fs = boost::filesystem;
 namespace pt = boost::property_tree;
 
@@ -51,6 +55,15 @@ public:
     _pairwiseMatches = pairwiseMatches;
   }
 
+  /**
+   * @brief Set the models of the geometric filtering of the matches,
+   *        used to choose the initial pair without estimating the relative poses again
+   */
+  void setGeometricModels(const matching::PairGeometricModels* geometricModels)
+  {
+    _geometricModels = geometricModels;
+  }
+
   void setInitialPair(const Pair& initialPair)
   {
     _userInitialImagePair = initialPair;
@@ -111,6 +124,36 @@ public:
     _sfmdataInterFileExtension = interFileExtension;
   }
 
+  /**
+   * @brief Save the intermediate reconstruction every n resections
+   * @param[in] interval The number of resections between two saves (0 to disable)
+   */
+  void setIntermediateFileInterval(std::size_t interval)
+  {
+    _sfmdataInterFileInterval = interval;
+  }
+
+  /**
+   * @brief Save a checkpoint of the reconstruction every n resections, to resume an interrupted reconstruction.
+   *        The checkpoint is saved in background, in the binary SfMData format.
+   * @param[in] filepath The checkpoint file (.sfmb)
+   * @param[in] interval The number of resections between two checkpoints (0 to disable)
+   */
+  void setCheckpoint(const std::string& filepath, std::size_t interval)
+  {
+    _checkpointFilepath = filepath;
+    _checkpointInterval = interval;
+  }
+
+  /**
+   * @brief Use a partitioned bundle adjustment for the global bundle adjustments of large scenes
+   * @param[in] maxNbPoses The max. num. of poses per submap (0 to disable)
+   */
+  void setMaxNbPosesPerSubmap(std::size_t maxNbPoses)
+  {
+    _maxNbPosesPerSubmap = maxNbPoses;
+  }
+
   void setLocalBundleAdjustmentGraphDistance(std::size_t distance)
   {
     if(_uselocalBundleAdjustment)
@@ -181,6 +224,17 @@ public:
    */
   void updateReconstruction(IndexT resectionId, const std::vector<IndexT>& bestViewIds, std::set<IndexT>& viewIds);
 
+  /**
+   * @brief Start saving a checkpoint of the current reconstruction in background.
+   *        Wait for the previous checkpoint first, a single checkpoint is saved at a time.
+   */
+  void saveCheckpoint();
+
+  /**
+   * @brief Wait for the checkpoint being saved in background, if any
+   */
+  void waitCheckpoint();
+
   /**
    * @brief Export and print statistics of a complete reconstruction
    * @param[in] reconstructionTime The duration of the reconstruction
@@ -221,10 +275,12 @@ private:
     std::vector<track::tracksUtilsMap::FeatureId> featuresId;
     /// pose estimated by the resection
     geometry::Pose3 pose;
-    /// intrinsic estimated by resection
+    /// intrinsic estimated by resection (private copy of the scene intrinsic)
     std::shared_ptr<camera::IntrinsicBase> optionalIntrinsic = nullptr;
     /// the instrinsic already exists in the scene or not.
     bool isNewIntrinsic;
+    /// the intrinsic has been refined during the resection
+    bool isRefinedIntrinsic = false;
   };
 
   /**
@@ -280,6 +336,7 @@ private:
    * @param[in] viewIndex: image index to add to the reconstruction.
    * @param[out] resectionData: contains the result (P) and all the data used during the resection.
    * @return false if resection failed
+   * @note The scene is not modified, so resections of multiple views can run in parallel.
    */
   bool computeResection(const IndexT viewIndex, ResectionData& resectionData);
 
@@ -302,6 +359,8 @@ private:
   /**
    * @brief Triangulate new possible 2D tracks
    * List tracks that share content with this view and run a multiview triangulation on them, using the Lo-RANSAC algorithm.
+   * The last triangulation of each track is cached: a track is skipped if its set of reconstructed views
+   * did not change, and the new observations of a landmark are simply added if they are consistent with it.
    * @param[in,out] scene All the data about the 3D reconstruction.
    * @param[in] previousReconstructedViews The list of the old reconstructed views (views index).
    * @param[in] newReconstructedViews The list of the new reconstructed views (views index).
@@ -315,7 +374,7 @@ private:
    * @param[in] scene All the data about the 3D reconstruction. 
    * @return false if the 3D points is located behind one view (or more), else \c true.
    */
-  bool checkChieralities(const Vec3& pt3D, const std::set<IndexT>& viewsId, const SfMData& scene);
+  bool checkChieralities(const Vec3& pt3D, const stl::arena_set<IndexT>& viewsId, const SfMData& scene);
   
   /**
    * @brief Check if the maximal angle formed by a 3D points and 2 views exceeds a min. angle, among a set of views.
@@ -325,7 +384,7 @@ private:
    * @param[in] kMinAngle The angle limit.
    * @return false if the maximal angle does not exceed the limit, else \c true.
    */
-  bool checkAngles(const Vec3& pt3D, const std::set<IndexT>& viewsId, const SfMData& scene, const double& kMinAngle);
+  bool checkAngles(const Vec3& pt3D, const stl::arena_set<IndexT>& viewsId, const SfMData& scene, const double& kMinAngle);
 
   /**
    * @brief Bundle adjustment to refine Structure; Motion and Intrinsics
@@ -371,6 +430,8 @@ private:
   int _minTrackLength = 2;
   int _minPointsPerPose = 30;
   bool _uselocalBundleAdjustment = false;
+  /// max. num. of poses per submap of the partitioned bundle adjustment (0: disabled)
+  std::size_t _maxNbPosesPerSubmap = 0;
   /// minimum number of obersvations to triangulate a 3d point.
   std::size_t _minNbObservationsForTriangulation = 2;
   /// a 3D point must have at least 2 obervations not too much aligned.
@@ -386,6 +447,7 @@ private:
 
   feature::FeaturesPerView* _featuresPerView;
   matching::PairwiseMatches* _pairwiseMatches;
+  const matching::PairGeometricModels* _geometricModels = nullptr;
 
   // Pyramid scoring
 
@@ -406,6 +468,28 @@ private:
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
 
+  /// Last multi-view triangulation of a track
+  struct TrackTriangulation
+  {
+    /// hash of the set of reconstructed views used for the triangulation
+    std::size_t observationsHash = 0;
+    /// triangulated point
+    Vec3 X = Vec3::Zero();
+    /// views validating the point
+    std::set<IndexT> inliers;
+    /// the track passed the triangulation checks
+    bool isValid = false;
+  };
+  /// Per track triangulation cache (see triangulateMultiViews_LORANSAC)
+  std::map<IndexT, TrackTriangulation> _triangulationCache;
+
+  // Memory accounting
+
+  /// Putative tracks and tracks per view
+  system::MemoryCounter _tracksMemory{"track.tracks"};
+  /// Landmarks of the reconstruction, updated after each resection
+  system::MemoryCounter _structureMemory{"sfm.structure"};
+
   // Local Bundle Adjustment data
 
   /// Contains all the data used by the Local BA approach
@@ -415,9 +499,20 @@ private:
 
   /// extension of the intermediate reconstruction files
   std::string _sfmdataInterFileExtension = ".ply";
+  /// number of resections between two intermediate reconstruction files (0: disabled)
+  std::size_t _sfmdataInterFileInterval = 3;
   /// filter for the intermediate reconstruction files
   ESfMData _sfmdataInterFilter = ESfMData(EXTRINSICS | INTRINSICS | STRUCTURE | OBSERVATIONS | CONTROL_POINTS);
 
+  // Checkpoint
+
+  /// checkpoint file to resume an interrupted reconstruction (.sfmb)
+  std::string _checkpointFilepath;
+  /// number of resections between two checkpoints (0: disabled)
+  std::size_t _checkpointInterval = 0;
+  /// checkpoint being saved in background
+  std::future<bool> _checkpointSaving;
+
   // Log
 
   /// HTML logger
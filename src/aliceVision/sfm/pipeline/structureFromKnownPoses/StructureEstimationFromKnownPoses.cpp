@@ -14,10 +14,17 @@
 #include "aliceVision/graph/graph.hpp"
 #include "aliceVision/track/Track.hpp"
 #include "aliceVision/sfm/sfmDataTriangulation.hpp"
+#include <aliceVision/system/Determinism.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -76,36 +83,68 @@ void StructureEstimationFromKnownPoses::match(
   const PairSet & pairs,
   const feature::RegionsPerView& regionsPerView)
 {
+#ifndef EXHAUSTIVE_MATCHING
+  // Index the regions of each view once: the un-distorted positions and the grid
+  // are shared by all the pairs of the view, as left or right view.
+  typedef std::pair<IndexT, feature::EImageDescriberType> ViewDescType;
+  std::map<ViewDescType, std::unique_ptr<robustEstimation::GuidedMatchingIndex> > regionsIndexes;
+  for(const Pair& pair : pairs)
+  {
+    for(feature::EImageDescriberType descType : regionsPerView.getCommonDescTypes(pair))
+    {
+      regionsIndexes[std::make_pair(pair.first, descType)];
+      regionsIndexes[std::make_pair(pair.second, descType)];
+    }
+  }
+  {
+    std::vector<std::pair<const ViewDescType, std::unique_ptr<robustEstimation::GuidedMatchingIndex> >*> indexesToBuild;
+    indexesToBuild.reserve(regionsIndexes.size());
+    for(auto& regionsIndex : regionsIndexes)
+      indexesToBuild.push_back(&regionsIndex);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < static_cast<int>(indexesToBuild.size()); ++i)
+    {
+      const ViewDescType& viewDescType = indexesToBuild[i]->first;
+      const View& view = *sfm_data.getViews().at(viewDescType.first);
+      const IntrinsicBase* intrinsic = sfm_data.getIntrinsicPtr(view.getIntrinsicId());
+      indexesToBuild[i]->second.reset(new robustEstimation::GuidedMatchingIndex(intrinsic, regionsPerView.getRegions(viewDescType.first, viewDescType.second)));
+    }
+  }
+#endif
+
+  const std::vector<Pair> pairsToMatch(pairs.begin(), pairs.end());
+
   boost::progress_display my_progress_bar( pairs.size(), std::cout,
     "Compute pairwise fundamental guided matching:\n" );
 
-  #pragma omp parallel
-  for (PairSet::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(pairsToMatch.size()); ++i)
   {
-    #pragma omp single nowait
-    {
+    const Pair& pair = pairsToMatch[i];
+
     // --
     // Perform GUIDED MATCHING
     // --
     // Use the computed model to check valid correspondences
     // - by considering geometric error and descriptor distance ratio.
 
-    const View * viewL = sfm_data.getViews().at(it->first).get();
+    const View * viewL = sfm_data.getViews().at(pair.first).get();
     const Pose3 poseL = sfm_data.getPose(*viewL).getTransform();
     const Intrinsics::const_iterator iterIntrinsicL = sfm_data.getIntrinsics().find(viewL->getIntrinsicId());
-    const View * viewR = sfm_data.getViews().at(it->second).get();
+    const View * viewR = sfm_data.getViews().at(pair.second).get();
     const Pose3 poseR = sfm_data.getPose(*viewR).getTransform();
     const Intrinsics::const_iterator iterIntrinsicR = sfm_data.getIntrinsics().find(viewR->getIntrinsicId());
 
-    if (sfm_data.getIntrinsics().count(viewL->getIntrinsicId()) != 0 ||
-        sfm_data.getIntrinsics().count(viewR->getIntrinsicId()) != 0)
+    if (iterIntrinsicL != sfm_data.getIntrinsics().end() &&
+        iterIntrinsicR != sfm_data.getIntrinsics().end())
     {
       const Mat34 P_L = iterIntrinsicL->second.get()->get_projective_equivalent(poseL);
       const Mat34 P_R = iterIntrinsicR->second.get()->get_projective_equivalent(poseR);
 
       const Mat3 F_lr = F_from_P(P_L, P_R);
       const double thresholdF = 4.0;
-      std::vector<feature::EImageDescriberType> commonDescTypes = regionsPerView.getCommonDescTypes(*it);
+      std::vector<feature::EImageDescriberType> commonDescTypes = regionsPerView.getCommonDescTypes(pair);
       
       matching::MatchesPerDescType allImagePairMatches;
       for(feature::EImageDescriberType descType: commonDescTypes)
@@ -117,29 +156,32 @@ void StructureEstimationFromKnownPoses::match(
           (
             F_lr,
             iterIntrinsicL->second.get(),
-            regionsPerView.getRegions(it->first),
+            regionsPerView.getRegions(pair.first),
             iterIntrinsicR->second.get(),
-            regionsPerView.getRegions(it->second),
+            regionsPerView.getRegions(pair.second),
             descType,
             Square(thresholdF), Square(0.8),
             matches
           );
       #else
-        const Vec3 epipole2  = epipole_from_P(P_R, poseL);
+        // the candidates of a left feature are the right features of the cells crossed by its epipolar band
+        const robustEstimation::GuidedMatchingIndex& lIndex = *regionsIndexes.at(std::make_pair(pair.first, descType));
+        const robustEstimation::GuidedMatchingIndex& rIndex = *regionsIndexes.at(std::make_pair(pair.second, descType));
+        const double errorTh = Square(thresholdF);
+        const double halfWidth = thresholdF;
 
-        //const feature::Regions& regions = regionsPerView.getRegions(it->first);
-        robustEstimation::GuidedMatching_Fundamental_Fast
-          <fundamental::kernel::EpipolarDistanceError>
+        robustEstimation::GuidedMatchingWithIndex
+          <Mat3, fundamental::kernel::EpipolarDistanceError>
           (
             F_lr,
-            epipole2,
-            iterIntrinsicL->second.get(),
-            regionsPerView.getRegions(it->first, descType),
-            iterIntrinsicR->second.get(),
-            regionsPerView.getRegions(it->second, descType),
-            iterIntrinsicR->second->w(), iterIntrinsicR->second->h(),
-            //descType,
-            Square(thresholdF), Square(0.8),
+            lIndex.getPositions(),
+            lIndex.getRegions(),
+            rIndex,
+            errorTh, Square(0.8),
+            [&](const Vec2& x, std::vector<IndexT>& candidates)
+            {
+              rIndex.getCandidatesAlongLine(F_lr * x.homogeneous(), halfWidth, candidates);
+            },
             matches
           );
       #endif
@@ -149,10 +191,9 @@ void StructureEstimationFromKnownPoses::match(
       #pragma omp critical
       {
         ++my_progress_bar;
-        _putativeMatches[*it] = allImagePairMatches;
+        _putativeMatches[pair] = allImagePairMatches;
       }
     }
-    }
   }
 }
 
@@ -238,6 +279,15 @@ void StructureEstimationFromKnownPoses::filter(
       }
     }
   }
+  // the matches are inserted in the order of the threads:
+  // in the deterministic mode, they are sorted so the tracks don't depend on the thread scheduling
+  if(system::Determinism::isEnabled())
+  {
+    for(auto& matchesPerDesc : _tripletMatches)
+      for(auto& matches : matchesPerDesc.second)
+        std::sort(matches.second.begin(), matches.second.end());
+  }
+
   // Clear putatives matches since they are no longer required
   matching::PairwiseMatches().swap(_putativeMatches);
 }
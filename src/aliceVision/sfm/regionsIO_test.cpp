@@ -0,0 +1,124 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/sfm/sfm.hpp"
+#include "aliceVision/sfm/pipeline/regionsIO.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE regionsIO
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+namespace fs = boost::filesystem;
+
+// Write the SIFT regions of nbViews views with (viewId + 1) * 10 regions
+std::string writeRegions(SfMData& sfmData, std::size_t nbViews)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path("regionsIO_%%%%%%");
+  fs::create_directories(folder);
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    sfmData.views[viewId] = std::make_shared<View>("", viewId);
+
+    feature::SIFT_Regions regions;
+    for(std::size_t i = 0; i < (viewId + 1) * 10; ++i)
+    {
+      regions.Features().emplace_back(i, viewId, 1.f, 0.f);
+      regions.Descriptors().emplace_back(static_cast<unsigned char>(viewId));
+    }
+    const std::string basename = std::to_string(viewId) + ".sift";
+    regions.Save((folder / (basename + ".feat")).string(), (folder / (basename + ".desc")).string());
+  }
+  return folder.string();
+}
+
+std::size_t getRegionsSize(std::size_t nbRegions)
+{
+  const feature::SIFT_Regions regions;
+  return nbRegions * (regions.FeatureByteSize() + regions.DescriptorByteSize());
+}
+
+BOOST_AUTO_TEST_CASE(regionsIO_loadRegionsPerView)
+{
+  SfMData sfmData;
+  const std::string folder = writeRegions(sfmData, 8);
+
+  feature::RegionsPerView regionsPerView;
+  BOOST_CHECK(loadRegionsPerView(regionsPerView, sfmData, {folder}, {feature::EImageDescriberType::SIFT}, {}, 4));
+
+  for(IndexT viewId = 0; viewId < 8; ++viewId)
+  {
+    const feature::Regions& regions = regionsPerView.getRegions(viewId, feature::EImageDescriberType::SIFT);
+    BOOST_CHECK_EQUAL(regions.RegionCount(), (viewId + 1) * 10);
+    BOOST_CHECK_EQUAL(regions.GetRegionsPositions().back().x(), (viewId + 1) * 10 - 1);
+  }
+
+  // missing regions files
+  sfmData.views[8] = std::make_shared<View>("", 8);
+  feature::RegionsPerView incompleteRegionsPerView;
+  BOOST_CHECK(!loadRegionsPerView(incompleteRegionsPerView, sfmData, {folder}, {feature::EImageDescriberType::SIFT}, {}, 4));
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(regionsIO_loadFeaturesPerView)
+{
+  SfMData sfmData;
+  const std::string folder = writeRegions(sfmData, 4);
+
+  feature::FeaturesPerView featuresPerView;
+  BOOST_CHECK(loadFeaturesPerView(featuresPerView, sfmData, {folder}, {feature::EImageDescriberType::SIFT}));
+
+  for(IndexT viewId = 0; viewId < 4; ++viewId)
+  {
+    const feature::PointFeatures& features = featuresPerView.getFeatures(viewId, feature::EImageDescriberType::SIFT);
+    BOOST_CHECK_EQUAL(features.size(), (viewId + 1) * 10);
+    BOOST_CHECK_EQUAL(features.back().x(), (viewId + 1) * 10 - 1);
+    BOOST_CHECK_EQUAL(features.back().y(), viewId);
+  }
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(regionsIO_regionsProvider)
+{
+  SfMData sfmData;
+  const std::string folder = writeRegions(sfmData, 4);
+
+  // room for the regions of the views 2 and 3
+  RegionsProvider provider(sfmData, {folder}, {feature::EImageDescriberType::SIFT}, getRegionsSize(30 + 40));
+  BOOST_CHECK_EQUAL(provider.getMemoryUsage(), 0);
+
+  for(IndexT viewId = 0; viewId < 4; ++viewId)
+  {
+    const auto regions = provider.getRegions(viewId, feature::EImageDescriberType::SIFT);
+    BOOST_CHECK_EQUAL(regions->RegionCount(), (viewId + 1) * 10);
+  }
+  BOOST_CHECK_EQUAL(provider.getNbLoads(), 4);
+  BOOST_CHECK_EQUAL(provider.getMemoryUsage(), getRegionsSize(30 + 40));
+
+  // cached
+  const auto regions3 = provider.getRegions(3, feature::EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(provider.getNbLoads(), 4);
+
+  // evicted, the view 2 is now the least recently used one
+  const auto regions0 = provider.getRegions(0, feature::EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(provider.getNbLoads(), 5);
+  BOOST_CHECK_EQUAL(provider.getMemoryUsage(), getRegionsSize(10 + 40));
+
+  // the evicted regions remain valid while they are held
+  BOOST_CHECK_EQUAL(regions3->RegionCount(), 40);
+
+  BOOST_CHECK_THROW(provider.getRegions(0, feature::EImageDescriberType::AKAZE), std::runtime_error);
+  BOOST_CHECK_THROW(provider.getRegions(10, feature::EImageDescriberType::SIFT), std::runtime_error);
+
+  fs::remove_all(folder);
+}
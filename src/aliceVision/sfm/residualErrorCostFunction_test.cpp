@@ -0,0 +1,180 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/sfm/ResidualErrorFunctor.hpp"
+#include "aliceVision/sfm/ResidualErrorCostFunction.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE residualErrorCostFunction
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+// Test summary:
+// - Evaluate the analytic cost functions and the autodiff cost functors on random cameras and points
+// - Check that the residuals and all the Jacobians are the same
+
+namespace {
+
+const double kTolerance = 1e-8;
+
+/**
+ * @brief Compare the residuals and the Jacobians of two cost functions on the given parameter blocks
+ */
+void checkCostFunctions(const ceres::CostFunction& analytic,
+                        const ceres::CostFunction& autodiff,
+                        const std::vector<std::vector<double>>& parameterBlocks)
+{
+  const std::vector<int>& blockSizes = autodiff.parameter_block_sizes();
+  BOOST_REQUIRE(analytic.parameter_block_sizes() == blockSizes);
+  BOOST_REQUIRE_EQUAL(analytic.num_residuals(), 2);
+
+  std::vector<const double*> parameters;
+  std::vector<std::vector<double>> analyticJacobians, autodiffJacobians;
+  std::vector<double*> analyticJacobiansPtr, autodiffJacobiansPtr;
+  for(std::size_t i = 0; i < parameterBlocks.size(); ++i)
+  {
+    parameters.push_back(parameterBlocks[i].data());
+    analyticJacobians.emplace_back(2 * blockSizes[i]);
+    autodiffJacobians.emplace_back(2 * blockSizes[i]);
+  }
+  for(std::size_t i = 0; i < parameterBlocks.size(); ++i)
+  {
+    analyticJacobiansPtr.push_back(analyticJacobians[i].data());
+    autodiffJacobiansPtr.push_back(autodiffJacobians[i].data());
+  }
+
+  double analyticResiduals[2];
+  double autodiffResiduals[2];
+  BOOST_REQUIRE(analytic.Evaluate(parameters.data(), analyticResiduals, analyticJacobiansPtr.data()));
+  BOOST_REQUIRE(autodiff.Evaluate(parameters.data(), autodiffResiduals, autodiffJacobiansPtr.data()));
+
+  const double scale = 1.0 + std::abs(autodiffResiduals[0]) + std::abs(autodiffResiduals[1]);
+  BOOST_CHECK_SMALL(analyticResiduals[0] - autodiffResiduals[0], kTolerance * scale);
+  BOOST_CHECK_SMALL(analyticResiduals[1] - autodiffResiduals[1], kTolerance * scale);
+
+  for(std::size_t i = 0; i < parameterBlocks.size(); ++i)
+  {
+    for(std::size_t j = 0; j < autodiffJacobians[i].size(); ++j)
+    {
+      const double jacobianScale = 1.0 + std::abs(autodiffJacobians[i][j]);
+      BOOST_CHECK_SMALL(analyticJacobians[i][j] - autodiffJacobians[i][j], kTolerance * jacobianScale);
+    }
+  }
+
+  // residuals only and partial Jacobians
+  BOOST_CHECK(analytic.Evaluate(parameters.data(), analyticResiduals, nullptr));
+  BOOST_CHECK_SMALL(analyticResiduals[0] - autodiffResiduals[0], kTolerance * scale);
+
+  std::vector<double*> partialJacobiansPtr(parameterBlocks.size(), nullptr);
+  partialJacobiansPtr.back() = analyticJacobiansPtr.back();
+  BOOST_CHECK(analytic.Evaluate(parameters.data(), analyticResiduals, partialJacobiansPtr.data()));
+}
+
+/**
+ * @brief Random intrinsics block: focal, principal point and small distortion parameters
+ */
+std::vector<double> randomIntrinsics(std::mt19937& generator, int nbIntrinsics)
+{
+  std::uniform_real_distribution<double> distortion(-0.1, 0.1);
+  std::vector<double> intrinsics = {1000.0, 500.0, 400.0};
+  for(int i = 3; i < nbIntrinsics; ++i)
+    intrinsics.push_back(distortion(generator));
+  return intrinsics;
+}
+
+/**
+ * @brief Random pose block [angle axis; translation], with a zero rotation for some of them
+ */
+std::vector<double> randomPose(std::mt19937& generator, bool zeroRotation)
+{
+  std::uniform_real_distribution<double> rotation(-0.5, 0.5);
+  std::uniform_real_distribution<double> translation(-1.0, 1.0);
+  std::vector<double> pose(6);
+  for(int i = 0; i < 3; ++i)
+    pose[i] = zeroRotation ? 0.0 : rotation(generator);
+  for(int i = 3; i < 6; ++i)
+    pose[i] = translation(generator);
+  return pose;
+}
+
+/**
+ * @brief Random 3D point in front of the cameras
+ */
+std::vector<double> randomPoint(std::mt19937& generator)
+{
+  std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+  return {coordinate(generator), coordinate(generator), 5.0 + coordinate(generator)};
+}
+
+template <typename Functor, typename Distortion>
+void checkCameraModel()
+{
+  const int N = Distortion::nbIntrinsics;
+  std::mt19937 generator(42);
+  const double observation[2] = {480.0, 390.0};
+
+  for(int i = 0; i < 20; ++i)
+  {
+    const bool zeroRotation = (i % 5 == 0);
+
+    // camera
+    {
+      const ResidualErrorCostFunction<Distortion> analytic(observation);
+      const ceres::AutoDiffCostFunction<Functor, 2, N, 6, 3> autodiff(new Functor(observation));
+      checkCostFunctions(analytic, autodiff, {randomIntrinsics(generator, N),
+                                              randomPose(generator, zeroRotation),
+                                              randomPoint(generator)});
+    }
+
+    // rig camera
+    {
+      const ResidualErrorRigCostFunction<Distortion> analytic(observation);
+      const ceres::AutoDiffCostFunction<Functor, 2, N, 6, 6, 3> autodiff(new Functor(observation));
+      checkCostFunctions(analytic, autodiff, {randomIntrinsics(generator, N),
+                                              randomPose(generator, false),
+                                              randomPose(generator, zeroRotation),
+                                              randomPoint(generator)});
+    }
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_Pinhole)
+{
+  checkCameraModel<ResidualErrorFunctor_Pinhole, Distortion_None>();
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeRadialK1)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeRadialK1, Distortion_RadialK1>();
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeRadialK3)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeRadialK3, Distortion_RadialK3>();
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeBrownT2)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeBrownT2, Distortion_BrownT2>();
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeFisheye)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeFisheye, Distortion_Fisheye>();
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeFisheye1)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeFisheye1, Distortion_Fisheye1>();
+}
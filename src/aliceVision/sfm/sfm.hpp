@@ -16,6 +16,7 @@
 #include "aliceVision/sfm/LocalBundleAdjustmentCeres.hpp"
 #include "aliceVision/sfm/LocalBundleAdjustmentData.hpp"
 #include "aliceVision/sfm/generateReport.hpp"
+#include "aliceVision/sfm/exportUndistortedViews.hpp"
 
 // SfM data
 
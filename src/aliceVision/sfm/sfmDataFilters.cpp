@@ -6,8 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "sfmDataFilters.hpp"
+#include <aliceVision/sfm/DenseSfMData.hpp>
 #include <aliceVision/stl/stl.hpp>
+#include <aliceVision/stl/MonotonicArena.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <iterator>
 
@@ -21,71 +24,166 @@ IndexT RemoveOutliers_PixelResidualError
   const unsigned int minTrackLength
 )
 {
-  IndexT outlier_count = 0;
-  Landmarks::iterator iterTracks = sfm_data.structure.begin();
-  while (iterTracks != sfm_data.structure.end())
+  const DenseSfMData denseSfMData(sfm_data);
+  const int nbLandmarks = static_cast<int>(denseSfMData.getNbLandmarks());
+
+  // the scratch buffers are reused by the successive calls (see ReconstructionEngine_sequentialSfM::removeOutliers)
+  stl::monotonic_arena& arena = stl::thread_arena();
+  stl::arena_scope arenaScope(arena);
+
+  const int nbViews = static_cast<int>(denseSfMData.getNbViews());
+  const std::size_t nbObservations = denseSfMData.getNbObservations();
+
+  // Group the observations per view (counting sort), to compute the residuals by batches of the same camera
+  stl::arena_vector<std::size_t> viewObservationsOffsets(nbViews + 1, 0, stl::arena_allocator<std::size_t>(arena));
+  for (std::size_t obs = 0; obs < nbObservations; ++obs)
+    ++viewObservationsOffsets[denseSfMData.getObservationView(obs) + 1];
+  for (int viewSlot = 0; viewSlot < nbViews; ++viewSlot)
+    viewObservationsOffsets[viewSlot + 1] += viewObservationsOffsets[viewSlot];
+
+  stl::arena_vector<std::size_t> viewObservations(nbObservations, 0, stl::arena_allocator<std::size_t>(arena));
+  stl::arena_vector<std::uint32_t> viewObservationsLandmarks(nbObservations, 0, stl::arena_allocator<std::uint32_t>(arena));
   {
-    Observations & observations = iterTracks->second.observations;
-    Observations::iterator itObs = observations.begin();
-    while (itObs != observations.end())
+    stl::arena_vector<std::size_t> viewFill(viewObservationsOffsets.begin(), viewObservationsOffsets.end() - 1, stl::arena_allocator<std::size_t>(arena));
+    for (int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
     {
-      const View * view = sfm_data.views.at(itObs->first).get();
-      const geometry::Pose3 pose = sfm_data.getPose(*view).getTransform();
-      const camera::IntrinsicBase * intrinsic = sfm_data.intrinsics.at(view->getIntrinsicId()).get();
-      const Vec2 residual = intrinsic->residual(pose, iterTracks->second.X, itObs->second.x);
-      if((pose.depth(iterTracks->second.X) < 0) ||
-         (residual.norm() > dThresholdPixel))
+      for (std::size_t obs = denseSfMData.getObservationsBegin(landmarkSlot); obs < denseSfMData.getObservationsEnd(landmarkSlot); ++obs)
       {
-        ++outlier_count;
-        itObs = observations.erase(itObs);
+        const std::size_t i = viewFill[denseSfMData.getObservationView(obs)]++;
+        viewObservations[i] = obs;
+        viewObservationsLandmarks[i] = landmarkSlot;
       }
-      else
-        ++itObs;
     }
-    if (observations.empty() || observations.size() < minTrackLength)
-      iterTracks = sfm_data.structure.erase(iterTracks);
-    else
-      ++iterTracks;
+  }
+
+  // Check the residual of all the observations
+  stl::arena_vector<char> isOutlier(nbObservations, 0, stl::arena_allocator<char>(arena));
+  const double sqThresholdPixel = dThresholdPixel * dThresholdPixel;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int viewSlot = 0; viewSlot < nbViews; ++viewSlot)
+  {
+    if (!denseSfMData.isPoseAndIntrinsicDefined(viewSlot))
+      continue;
+
+    const std::size_t begin = viewObservationsOffsets[viewSlot];
+    const std::size_t nbViewObservations = viewObservationsOffsets[viewSlot + 1] - begin;
+    if (nbViewObservations == 0)
+      continue;
+
+    Mat3X X(3, nbViewObservations);
+    Mat2X x(2, nbViewObservations);
+    for (std::size_t i = 0; i < nbViewObservations; ++i)
+    {
+      X.col(i) = denseSfMData.getLandmarkPosition(viewObservationsLandmarks[begin + i]);
+      x.col(i) = denseSfMData.getObservationPoint(viewObservations[begin + i]);
+    }
+
+    const geometry::Pose3& pose = denseSfMData.getPose(viewSlot);
+    const Mat2X residuals = denseSfMData.getIntrinsic(viewSlot)->residuals(pose, X, x);
+    const Mat3X XCam = pose(X);
+
+    for (std::size_t i = 0; i < nbViewObservations; ++i)
+      isOutlier[viewObservations[begin + i]] = (XCam(2, i) < 0) || (residuals.col(i).squaredNorm() > sqThresholdPixel);
+  }
+
+  // Remove the outliers: the observations of the landmarks are compacted in parallel,
+  // the order of the observations in the index is the order of the flat_map
+  stl::arena_vector<char> isRemoved(nbLandmarks, 0, stl::arena_allocator<char>(arena));
+  IndexT outlier_count = 0;
+
+  #pragma omp parallel for schedule(dynamic, 256) reduction(+:outlier_count)
+  for (int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
+  {
+    const std::size_t obsBegin = denseSfMData.getObservationsBegin(landmarkSlot);
+    const std::size_t obsEnd = denseSfMData.getObservationsEnd(landmarkSlot);
+
+    IndexT nbLandmarkOutliers = 0;
+    for (std::size_t obs = obsBegin; obs < obsEnd; ++obs)
+      nbLandmarkOutliers += static_cast<IndexT>(isOutlier[obs]);
+
+    const std::size_t nbInliers = (obsEnd - obsBegin) - nbLandmarkOutliers;
+    outlier_count += nbLandmarkOutliers;
+
+    if (nbInliers == 0 || nbInliers < minTrackLength)
+    {
+      isRemoved[landmarkSlot] = 1;
+      continue;
+    }
+    if (nbLandmarkOutliers == 0)
+      continue;
+
+    // the landmarks map is not modified in this loop
+    Observations& observations = sfm_data.structure.find(denseSfMData.getLandmarkId(landmarkSlot))->second.observations;
+    Observations inliers;
+    inliers.reserve(nbInliers);
+    std::size_t obs = obsBegin;
+    for (const auto& observation : observations)
+    {
+      if (!isOutlier[obs++])
+        inliers.insert(inliers.end(), observation);
+    }
+    observations.swap(inliers);
+  }
+
+  for (int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
+  {
+    if (isRemoved[landmarkSlot])
+      sfm_data.structure.erase(denseSfMData.getLandmarkId(landmarkSlot));
   }
   return outlier_count;
 }
 
 IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAngle)
 {
-  IndexT removedTrack_count = 0;
-  Landmarks::iterator iterTracks = sfm_data.structure.begin();
-  while (iterTracks != sfm_data.structure.end())
+  const DenseSfMData denseSfMData(sfm_data);
+  const int nbLandmarks = static_cast<int>(denseSfMData.getNbLandmarks());
+
+  stl::monotonic_arena& arena = stl::thread_arena();
+  stl::arena_scope arenaScope(arena);
+
+  // Check the max. angle between the rays of each landmark
+  stl::arena_vector<char> isRemoved(nbLandmarks, 0, stl::arena_allocator<char>(arena));
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
   {
-    Observations & observations = iterTracks->second.observations;
+    const std::size_t obsBegin = denseSfMData.getObservationsBegin(landmarkSlot);
+    const std::size_t obsEnd = denseSfMData.getObservationsEnd(landmarkSlot);
     double max_angle = 0.0;
-    for (Observations::const_iterator itObs1 = observations.begin();
-      itObs1 != observations.end(); ++itObs1)
+    for (std::size_t obs1 = obsBegin; obs1 < obsEnd; ++obs1)
     {
-      const View * view1 = sfm_data.views.at(itObs1->first).get();
-      const geometry::Pose3 pose1 = sfm_data.getPose(*view1).getTransform();
-      const camera::IntrinsicBase * intrinsic1 = sfm_data.intrinsics.at(view1->getIntrinsicId()).get();
+      const std::uint32_t view1 = denseSfMData.getObservationView(obs1);
+      if (!denseSfMData.isPoseAndIntrinsicDefined(view1))
+        continue;
+      const geometry::Pose3& pose1 = denseSfMData.getPose(view1);
+      const camera::IntrinsicBase * intrinsic1 = denseSfMData.getIntrinsic(view1);
 
-      Observations::const_iterator itObs2 = itObs1;
-      ++itObs2;
-      for (; itObs2 != observations.end(); ++itObs2)
+      for (std::size_t obs2 = obs1 + 1; obs2 < obsEnd; ++obs2)
       {
-        const View * view2 = sfm_data.views.at(itObs2->first).get();
-        const geometry::Pose3 pose2 = sfm_data.getPose(*view2).getTransform();
-        const camera::IntrinsicBase * intrinsic2 = sfm_data.intrinsics.at(view2->getIntrinsicId()).get();
+        const std::uint32_t view2 = denseSfMData.getObservationView(obs2);
+        if (!denseSfMData.isPoseAndIntrinsicDefined(view2))
+          continue;
+        const geometry::Pose3& pose2 = denseSfMData.getPose(view2);
+        const camera::IntrinsicBase * intrinsic2 = denseSfMData.getIntrinsic(view2);
 
         const double angle = AngleBetweenRays(
           pose1, intrinsic1, pose2, intrinsic2,
-          itObs1->second.x, itObs2->second.x);
+          denseSfMData.getObservationPoint(obs1), denseSfMData.getObservationPoint(obs2));
         max_angle = std::max(angle, max_angle);
       }
     }
-    if (max_angle < dMinAcceptedAngle)
+    isRemoved[landmarkSlot] = (max_angle < dMinAcceptedAngle);
+  }
+
+  IndexT removedTrack_count = 0;
+  for (int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
+  {
+    if (isRemoved[landmarkSlot])
     {
-      iterTracks = sfm_data.structure.erase(iterTracks);
+      sfm_data.structure.erase(denseSfMData.getLandmarkId(landmarkSlot));
       ++removedTrack_count;
     }
-    else
-      ++iterTracks;
   }
   return removedTrack_count;
 }
@@ -9,6 +9,7 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/stl/mapUtils.hpp>
 #include <aliceVision/sfm/sfmDataIO_json.hpp>
+#include <aliceVision/sfm/sfmDataIO_bin.hpp>
 #include <aliceVision/sfm/sfmDataIO_ply.hpp>
 #include <aliceVision/sfm/sfmDataIO_baf.hpp>
 #include <aliceVision/sfm/sfmDataIO_gt.hpp>
@@ -101,6 +102,10 @@ bool Load(SfMData& sfmData, const std::string& filename, ESfMData partFlag)
   {
     status = loadJSON(sfmData, filename, partFlag);
   }
+  else if(extension == ".sfmb") // Binary File
+  {
+    status = loadBinary(sfmData, filename, partFlag);
+  }
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   else if(extension == ".abc") // Alembic
   {
@@ -139,6 +144,10 @@ bool Save(const SfMData& sfmData, const std::string& filename, ESfMData partFlag
   {
     status = saveJSON(sfmData, tmpPath, partFlag);
   }
+  else if(extension == ".sfmb") // Binary File
+  {
+    status = saveBinary(sfmData, tmpPath, partFlag);
+  }
   else if(extension == ".ply") // Polygon File
   {
     status = savePLY(sfmData, tmpPath, partFlag);
@@ -0,0 +1,669 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "sfmDataIO_bin.hpp"
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+const char binaryMagic[8] = {'A', 'V', 'S', 'F', 'M', 'B', 'I', 'N'};
+const std::uint32_t binaryVersion = 1;
+
+/**
+ * @brief Binary SfMData file sections
+ * @note The values are stored in the file: never change them.
+ */
+enum class EBinarySection : std::uint32_t
+{
+  FOLDERS = 0,
+  VIEWS = 1,
+  INTRINSICS = 2,
+  POSES = 3,
+  RIGS = 4,
+  STRUCTURE = 5,
+  OBSERVATIONS = 6,
+  CONTROL_POINTS = 7,
+  POSES_UNCERTAINTY = 8,
+  LANDMARKS_UNCERTAINTY = 9
+};
+
+struct SectionEntry
+{
+  std::uint64_t offset = 0;
+  std::uint64_t size = 0;
+};
+
+class BinaryWriter
+{
+public:
+  explicit BinaryWriter(std::ostream& stream)
+    : _stream(stream)
+  {}
+
+  template<typename T>
+  void write(const T& value)
+  {
+    _stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeSize(std::size_t size)
+  {
+    write(static_cast<std::uint64_t>(size));
+  }
+
+  void writeString(const std::string& str)
+  {
+    write(static_cast<std::uint32_t>(str.size()));
+    _stream.write(str.data(), str.size());
+  }
+
+  template<typename Derived>
+  void writeMatrix(const Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      write(static_cast<double>(matrix(i)));
+  }
+
+  void writePose3(const geometry::Pose3& pose)
+  {
+    writeMatrix(pose.rotation());
+    writeMatrix(pose.center());
+  }
+
+  std::uint64_t tell()
+  {
+    return static_cast<std::uint64_t>(_stream.tellp());
+  }
+
+private:
+  std::ostream& _stream;
+};
+
+class BinaryReader
+{
+public:
+  explicit BinaryReader(std::istream& stream)
+    : _stream(stream)
+  {}
+
+  template<typename T>
+  T read()
+  {
+    T value;
+    _stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if(!_stream)
+      throw std::runtime_error("Invalid binary SfMData file: unexpected end of file.");
+    return value;
+  }
+
+  std::size_t readSize()
+  {
+    return static_cast<std::size_t>(read<std::uint64_t>());
+  }
+
+  std::string readString()
+  {
+    std::string str(read<std::uint32_t>(), '\0');
+    if(!str.empty())
+      _stream.read(&str[0], str.size());
+    if(!_stream)
+      throw std::runtime_error("Invalid binary SfMData file: unexpected end of file.");
+    return str;
+  }
+
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      matrix(i) = static_cast<typename Derived::Scalar>(read<double>());
+  }
+
+  geometry::Pose3 readPose3()
+  {
+    Mat3 rotation;
+    Vec3 center;
+    readMatrix(rotation);
+    readMatrix(center);
+    return geometry::Pose3(rotation, center);
+  }
+
+  void seek(std::uint64_t offset)
+  {
+    _stream.seekg(static_cast<std::streamoff>(offset));
+  }
+
+private:
+  std::istream& _stream;
+};
+
+void writeView(BinaryWriter& writer, const View& view)
+{
+  writer.write(view.getViewId());
+  writer.write(view.getPoseId());
+  writer.write(view.isPartOfRig() ? view.getRigId() : UndefinedIndexT);
+  writer.write(view.isPartOfRig() ? view.getSubPoseId() : UndefinedIndexT);
+  writer.write(view.getIntrinsicId());
+  writer.write(view.getResectionId());
+  writer.writeString(view.getImagePath());
+  writer.write(static_cast<std::uint64_t>(view.getWidth()));
+  writer.write(static_cast<std::uint64_t>(view.getHeight()));
+
+  writer.writeSize(view.getMetadata().size());
+  for(const auto& metadataPair : view.getMetadata())
+  {
+    writer.writeString(metadataPair.first);
+    writer.writeString(metadataPair.second);
+  }
+}
+
+void readView(BinaryReader& reader, View& view)
+{
+  view.setViewId(reader.read<IndexT>());
+  view.setPoseId(reader.read<IndexT>());
+
+  const IndexT rigId = reader.read<IndexT>();
+  const IndexT subPoseId = reader.read<IndexT>();
+  if(rigId != UndefinedIndexT)
+    view.setRigAndSubPoseId(rigId, subPoseId);
+
+  view.setIntrinsicId(reader.read<IndexT>());
+  view.setResectionId(reader.read<IndexT>());
+  view.setImagePath(reader.readString());
+  view.setWidth(static_cast<std::size_t>(reader.read<std::uint64_t>()));
+  view.setHeight(static_cast<std::size_t>(reader.read<std::uint64_t>()));
+
+  const std::size_t nbMetadata = reader.readSize();
+  for(std::size_t i = 0; i < nbMetadata; ++i)
+  {
+    const std::string key = reader.readString();
+    view.addMetadata(key, reader.readString());
+  }
+}
+
+void writeIntrinsic(BinaryWriter& writer, IndexT intrinsicId, const camera::IntrinsicBase& intrinsic)
+{
+  writer.write(intrinsicId);
+  writer.write(static_cast<std::uint32_t>(intrinsic.getType()));
+  writer.write(static_cast<std::uint32_t>(intrinsic.w()));
+  writer.write(static_cast<std::uint32_t>(intrinsic.h()));
+  writer.writeString(intrinsic.serialNumber());
+  writer.write(intrinsic.initialFocalLengthPix());
+  writer.write(static_cast<std::uint8_t>(intrinsic.isLocked()));
+
+  const std::vector<double> params = intrinsic.getParams();
+  writer.writeSize(params.size());
+  for(double param : params)
+    writer.write(param);
+}
+
+void readIntrinsic(BinaryReader& reader, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  intrinsicId = reader.read<IndexT>();
+  const camera::EINTRINSIC intrinsicType = static_cast<camera::EINTRINSIC>(reader.read<std::uint32_t>());
+  const unsigned int width = reader.read<std::uint32_t>();
+  const unsigned int height = reader.read<std::uint32_t>();
+
+  // check if the camera is a Pinhole model
+  if(!camera::isPinhole(intrinsicType))
+    throw std::out_of_range("Only Pinhole camera model supported");
+
+  std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(intrinsicType, width, height);
+  pinholeIntrinsic->setSerialNumber(reader.readString());
+  pinholeIntrinsic->setInitialFocalLengthPix(reader.read<double>());
+  const bool locked = (reader.read<std::uint8_t>() != 0);
+
+  std::vector<double> params(reader.readSize());
+  for(double& param : params)
+    param = reader.read<double>();
+
+  // ensure that we have the right number of params (focal, principal point, distortion)
+  params.resize(pinholeIntrinsic->getParams().size(), 0.0);
+  pinholeIntrinsic->updateFromParams(params);
+
+  intrinsic = std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic);
+
+  // intrinsic lock
+  if(locked)
+    intrinsic->lock();
+  else
+    intrinsic->unlock();
+}
+
+void writeLandmarkData(BinaryWriter& writer, IndexT landmarkId, const Landmark& landmark)
+{
+  writer.write(landmarkId);
+  writer.write(static_cast<std::uint8_t>(landmark.descType));
+  writer.writeMatrix(landmark.X);
+  for(int i = 0; i < 3; ++i)
+    writer.write(static_cast<std::uint8_t>(landmark.rgb(i)));
+}
+
+void readLandmarkData(BinaryReader& reader, IndexT& landmarkId, Landmark& landmark)
+{
+  landmarkId = reader.read<IndexT>();
+  landmark.descType = static_cast<feature::EImageDescriberType>(reader.read<std::uint8_t>());
+  reader.readMatrix(landmark.X);
+  for(int i = 0; i < 3; ++i)
+    landmark.rgb(i) = reader.read<std::uint8_t>();
+}
+
+void writeObservations(BinaryWriter& writer, const Observations& observations)
+{
+  writer.writeSize(observations.size());
+  for(const auto& obsPair : observations)
+  {
+    writer.write(obsPair.first);
+    writer.write(obsPair.second.id_feat);
+    writer.writeMatrix(obsPair.second.x);
+  }
+}
+
+void readObservations(BinaryReader& reader, Observations& observations)
+{
+  const std::size_t nbObservations = reader.readSize();
+  observations.reserve(nbObservations);
+  for(std::size_t i = 0; i < nbObservations; ++i)
+  {
+    const IndexT viewId = reader.read<IndexT>();
+    Observation observation;
+    observation.id_feat = reader.read<IndexT>();
+    reader.readMatrix(observation.x);
+    observations.emplace_hint(observations.end(), viewId, observation);
+  }
+}
+
+} // namespace
+
+bool saveBinary(const SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool saveLandmarksUncertainty = (partFlag & LANDMARKS_UNCERTAINTY) == LANDMARKS_UNCERTAINTY;
+  const bool savePosesUncertainty = (partFlag & POSES_UNCERTAINTY) == POSES_UNCERTAINTY;
+
+  std::vector<EBinarySection> sections = {EBinarySection::FOLDERS};
+
+  if(saveViews)
+    sections.push_back(EBinarySection::VIEWS);
+  if(saveIntrinsics)
+    sections.push_back(EBinarySection::INTRINSICS);
+  if(saveExtrinsics)
+  {
+    sections.push_back(EBinarySection::POSES);
+    sections.push_back(EBinarySection::RIGS);
+  }
+  if(saveStructure)
+  {
+    sections.push_back(EBinarySection::STRUCTURE);
+    if(saveObservations)
+      sections.push_back(EBinarySection::OBSERVATIONS);
+    if(saveLandmarksUncertainty)
+      sections.push_back(EBinarySection::LANDMARKS_UNCERTAINTY);
+  }
+  if(saveControlPoints)
+    sections.push_back(EBinarySection::CONTROL_POINTS);
+  if(saveExtrinsics && savePosesUncertainty)
+    sections.push_back(EBinarySection::POSES_UNCERTAINTY);
+
+  std::ofstream stream(filename, std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  BinaryWriter writer(stream);
+
+  // header, the section table is written once the sections offsets are known
+  stream.write(binaryMagic, sizeof(binaryMagic));
+  writer.write(binaryVersion);
+  writer.write(static_cast<std::uint32_t>(sections.size()));
+
+  const std::uint64_t tableOffset = writer.tell();
+  for(std::size_t i = 0; i < sections.size(); ++i)
+  {
+    writer.write(std::uint32_t(0));
+    writer.write(std::uint64_t(0));
+    writer.write(std::uint64_t(0));
+  }
+
+  std::vector<SectionEntry> entries(sections.size());
+
+  for(std::size_t s = 0; s < sections.size(); ++s)
+  {
+    entries.at(s).offset = writer.tell();
+
+    switch(sections.at(s))
+    {
+      case EBinarySection::FOLDERS:
+      {
+        writer.writeSize(sfmData.getRelativeFeaturesFolders().size());
+        for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
+          writer.writeString(featuresFolder);
+
+        writer.writeSize(sfmData.getRelativeMatchesFolders().size());
+        for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
+          writer.writeString(matchesFolder);
+      }
+      break;
+      case EBinarySection::VIEWS:
+      {
+        writer.writeSize(sfmData.getViews().size());
+        for(const auto& viewPair : sfmData.getViews())
+          writeView(writer, *(viewPair.second));
+      }
+      break;
+      case EBinarySection::INTRINSICS:
+      {
+        writer.writeSize(sfmData.getIntrinsics().size());
+        for(const auto& intrinsicPair : sfmData.getIntrinsics())
+          writeIntrinsic(writer, intrinsicPair.first, *(intrinsicPair.second));
+      }
+      break;
+      case EBinarySection::POSES:
+      {
+        writer.writeSize(sfmData.getPoses().size());
+        for(const auto& posePair : sfmData.getPoses())
+        {
+          writer.write(posePair.first);
+          writer.writePose3(posePair.second.getTransform());
+          writer.write(static_cast<std::uint8_t>(posePair.second.isLocked()));
+        }
+      }
+      break;
+      case EBinarySection::RIGS:
+      {
+        writer.writeSize(sfmData.getRigs().size());
+        for(const auto& rigPair : sfmData.getRigs())
+        {
+          writer.write(rigPair.first);
+          writer.writeSize(rigPair.second.getSubPoses().size());
+          for(const RigSubPose& subPose : rigPair.second.getSubPoses())
+          {
+            writer.write(static_cast<std::uint8_t>(subPose.status));
+            writer.writePose3(subPose.pose);
+          }
+        }
+      }
+      break;
+      case EBinarySection::STRUCTURE:
+      {
+        writer.writeSize(sfmData.getLandmarks().size());
+        for(const auto& landmarkPair : sfmData.getLandmarks())
+          writeLandmarkData(writer, landmarkPair.first, landmarkPair.second);
+      }
+      break;
+      case EBinarySection::OBSERVATIONS:
+      {
+        writer.writeSize(sfmData.getLandmarks().size());
+        for(const auto& landmarkPair : sfmData.getLandmarks())
+        {
+          writer.write(landmarkPair.first);
+          writeObservations(writer, landmarkPair.second.observations);
+        }
+      }
+      break;
+      case EBinarySection::CONTROL_POINTS:
+      {
+        writer.writeSize(sfmData.getControlPoints().size());
+        for(const auto& landmarkPair : sfmData.getControlPoints())
+        {
+          writeLandmarkData(writer, landmarkPair.first, landmarkPair.second);
+          writeObservations(writer, landmarkPair.second.observations);
+        }
+      }
+      break;
+      case EBinarySection::POSES_UNCERTAINTY:
+      {
+        writer.writeSize(sfmData._posesUncertainty.size());
+        for(const auto& uncertaintyPair : sfmData._posesUncertainty)
+        {
+          writer.write(uncertaintyPair.first);
+          writer.writeMatrix(uncertaintyPair.second);
+        }
+      }
+      break;
+      case EBinarySection::LANDMARKS_UNCERTAINTY:
+      {
+        writer.writeSize(sfmData._landmarksUncertainty.size());
+        for(const auto& uncertaintyPair : sfmData._landmarksUncertainty)
+        {
+          writer.write(uncertaintyPair.first);
+          writer.writeMatrix(uncertaintyPair.second);
+        }
+      }
+      break;
+    }
+
+    entries.at(s).size = writer.tell() - entries.at(s).offset;
+  }
+
+  // section table
+  stream.seekp(static_cast<std::streamoff>(tableOffset));
+  for(std::size_t s = 0; s < sections.size(); ++s)
+  {
+    writer.write(static_cast<std::uint32_t>(sections.at(s)));
+    writer.write(entries.at(s).offset);
+    writer.write(entries.at(s).size);
+  }
+
+  return stream.good();
+}
+
+bool loadBinary(SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool loadLandmarksUncertainty = (partFlag & LANDMARKS_UNCERTAINTY) == LANDMARKS_UNCERTAINTY;
+  const bool loadPosesUncertainty = (partFlag & POSES_UNCERTAINTY) == POSES_UNCERTAINTY;
+
+  std::ifstream stream(filename, std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Unable to open the binary SfMData file: " + filename);
+
+  BinaryReader reader(stream);
+
+  // header
+  char magic[sizeof(binaryMagic)];
+  stream.read(magic, sizeof(magic));
+  if(!stream || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0)
+  {
+    ALICEVISION_LOG_ERROR("Invalid binary SfMData file: '" << filename << "'.");
+    return false;
+  }
+
+  const std::uint32_t version = reader.read<std::uint32_t>();
+  if(version > binaryVersion)
+  {
+    ALICEVISION_LOG_ERROR("Unsupported binary SfMData file version " << version << ": '" << filename << "'.");
+    return false;
+  }
+
+  // section table (unknown sections are ignored)
+  std::map<EBinarySection, SectionEntry> sections;
+  const std::uint32_t nbSections = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbSections; ++i)
+  {
+    const EBinarySection section = static_cast<EBinarySection>(reader.read<std::uint32_t>());
+    SectionEntry& entry = sections[section];
+    entry.offset = reader.read<std::uint64_t>();
+    entry.size = reader.read<std::uint64_t>();
+  }
+
+  // move the reader to the given section, return false if the section is not in the file
+  const auto seekSection = [&](EBinarySection section)
+  {
+    const auto it = sections.find(section);
+    if(it == sections.end())
+      return false;
+    reader.seek(it->second.offset);
+    return true;
+  };
+
+  // folders
+  if(seekSection(EBinarySection::FOLDERS))
+  {
+    const std::size_t nbFeaturesFolders = reader.readSize();
+    for(std::size_t i = 0; i < nbFeaturesFolders; ++i)
+      sfmData.addFeaturesFolder(reader.readString());
+
+    const std::size_t nbMatchesFolders = reader.readSize();
+    for(std::size_t i = 0; i < nbMatchesFolders; ++i)
+      sfmData.addMatchesFolder(reader.readString());
+  }
+
+  // views
+  if(loadViews && seekSection(EBinarySection::VIEWS))
+  {
+    Views& views = sfmData.getViews();
+    const std::size_t nbViews = reader.readSize();
+    for(std::size_t i = 0; i < nbViews; ++i)
+    {
+      std::shared_ptr<View> view = std::make_shared<View>();
+      readView(reader, *view);
+      views.emplace(view->getViewId(), view);
+    }
+  }
+
+  // intrinsics
+  if(loadIntrinsics && seekSection(EBinarySection::INTRINSICS))
+  {
+    Intrinsics& intrinsics = sfmData.getIntrinsics();
+    const std::size_t nbIntrinsics = reader.readSize();
+    for(std::size_t i = 0; i < nbIntrinsics; ++i)
+    {
+      IndexT intrinsicId;
+      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+      readIntrinsic(reader, intrinsicId, intrinsic);
+      intrinsics.emplace(intrinsicId, intrinsic);
+    }
+  }
+
+  // extrinsics
+  if(loadExtrinsics)
+  {
+    // poses
+    if(seekSection(EBinarySection::POSES))
+    {
+      Poses& poses = sfmData.getPoses();
+      const std::size_t nbPoses = reader.readSize();
+      for(std::size_t i = 0; i < nbPoses; ++i)
+      {
+        const IndexT poseId = reader.read<IndexT>();
+        const geometry::Pose3 transform = reader.readPose3();
+        const bool locked = (reader.read<std::uint8_t>() != 0);
+        poses.emplace(poseId, CameraPose(transform, locked));
+      }
+    }
+
+    // rigs
+    if(seekSection(EBinarySection::RIGS))
+    {
+      Rigs& rigs = sfmData.getRigs();
+      const std::size_t nbRigs = reader.readSize();
+      for(std::size_t i = 0; i < nbRigs; ++i)
+      {
+        const IndexT rigId = reader.read<IndexT>();
+        Rig rig(reader.readSize());
+        for(std::size_t subPoseId = 0; subPoseId < rig.getNbSubPoses(); ++subPoseId)
+        {
+          RigSubPose subPose;
+          subPose.status = static_cast<ERigSubPoseStatus>(reader.read<std::uint8_t>());
+          subPose.pose = reader.readPose3();
+          rig.setSubPose(static_cast<IndexT>(subPoseId), subPose);
+        }
+        rigs.emplace(rigId, rig);
+      }
+    }
+
+    // poses uncertainty
+    if(loadPosesUncertainty && seekSection(EBinarySection::POSES_UNCERTAINTY))
+    {
+      const std::size_t nbUncertainties = reader.readSize();
+      for(std::size_t i = 0; i < nbUncertainties; ++i)
+      {
+        const IndexT poseId = reader.read<IndexT>();
+        reader.readMatrix(sfmData._posesUncertainty[poseId]);
+      }
+    }
+  }
+
+  // structure
+  if(loadStructure && seekSection(EBinarySection::STRUCTURE))
+  {
+    Landmarks& landmarks = sfmData.getLandmarks();
+    const std::size_t nbLandmarks = reader.readSize();
+    for(std::size_t i = 0; i < nbLandmarks; ++i)
+    {
+      IndexT landmarkId;
+      Landmark landmark;
+      readLandmarkData(reader, landmarkId, landmark);
+      landmarks.emplace(landmarkId, std::move(landmark));
+    }
+
+    // observations
+    if(loadObservations && seekSection(EBinarySection::OBSERVATIONS))
+    {
+      const std::size_t nbObservations = reader.readSize();
+      for(std::size_t i = 0; i < nbObservations; ++i)
+      {
+        const IndexT landmarkId = reader.read<IndexT>();
+        const auto landmarkIt = landmarks.find(landmarkId);
+        if(landmarkIt == landmarks.end())
+          throw std::runtime_error("Invalid binary SfMData file: observations of an unknown landmark " + std::to_string(landmarkId) + ".");
+        readObservations(reader, landmarkIt->second.observations);
+      }
+    }
+
+    // landmarks uncertainty
+    if(loadLandmarksUncertainty && seekSection(EBinarySection::LANDMARKS_UNCERTAINTY))
+    {
+      const std::size_t nbUncertainties = reader.readSize();
+      for(std::size_t i = 0; i < nbUncertainties; ++i)
+      {
+        const IndexT landmarkId = reader.read<IndexT>();
+        reader.readMatrix(sfmData._landmarksUncertainty[landmarkId]);
+      }
+    }
+  }
+
+  // control points
+  if(loadControlPoints && seekSection(EBinarySection::CONTROL_POINTS))
+  {
+    Landmarks& controlPoints = sfmData.getControlPoints();
+    const std::size_t nbControlPoints = reader.readSize();
+    for(std::size_t i = 0; i < nbControlPoints; ++i)
+    {
+      IndexT landmarkId;
+      Landmark landmark;
+      readLandmarkData(reader, landmarkId, landmark);
+      readObservations(reader, landmark.observations);
+      controlPoints.emplace(landmarkId, std::move(landmark));
+    }
+  }
+
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
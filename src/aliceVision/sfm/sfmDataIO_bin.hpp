@@ -0,0 +1,50 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfm {
+
+// AliceVision binary SfMData file (.sfmb):
+// -- Header
+// magic "AVSFMBIN", version (uint32), #sections (uint32)
+// -- Section table
+// [type (uint32), offset (uint64), size (uint64)] for each section
+// -- Sections
+// folders, views, intrinsics, poses, rigs,
+// structure (landmarks without their observations), observations,
+// control points, poses uncertainty, landmarks uncertainty
+// --
+// Values are stored in little-endian order, strings and collections are prefixed
+// by their size. The loader seeks directly to the requested sections, so the
+// structure is never read when only the cameras are needed.
+
+/**
+ * @brief Save an SfMData in a binary file.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveBinary(const SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file.
+ * @details Only the sections requested by partFlag are read, the others are skipped.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadBinary(SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfm
+} // namespace aliceVision
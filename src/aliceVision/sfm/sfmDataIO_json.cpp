@@ -10,12 +10,449 @@
 
 #include <boost/property_tree/json_parser.hpp>
 
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
 #include <memory>
 #include <cassert>
+#include <sstream>
 
 namespace aliceVision {
 namespace sfm {
 
+namespace {
+
+/**
+ * @brief Minimal JSON pull parser.
+ * @details Reads the stream token by token, so the large sections (landmarks)
+ *          can be loaded without building their property tree.
+ */
+class JsonReader
+{
+public:
+  explicit JsonReader(std::istream& stream)
+    : _buffer(*stream.rdbuf())
+  {}
+
+  /// Skip the whitespaces and return the next character (not consumed)
+  char peek()
+  {
+    int c = _buffer.sgetc();
+    while(c == ' ' || c == '\n' || c == '\r' || c == '\t')
+      c = _buffer.snextc();
+    if(c == std::char_traits<char>::eof())
+      throw std::runtime_error("Invalid JSON file: unexpected end of file.");
+    return static_cast<char>(c);
+  }
+
+  /// Consume the next character, which must be c
+  void expect(char c)
+  {
+    if(peek() != c)
+      throw std::runtime_error(std::string("Invalid JSON file: '") + c + "' expected, '" + peek() + "' found.");
+    _buffer.sbumpc();
+  }
+
+  /// Consume the next character if it is c
+  bool accept(char c)
+  {
+    if(peek() != c)
+      return false;
+    _buffer.sbumpc();
+    return true;
+  }
+
+  /// Read a string
+  const std::string& readString()
+  {
+    expect('"');
+    _token.clear();
+    for(;;)
+    {
+      int c = _buffer.sbumpc();
+      if(c == std::char_traits<char>::eof())
+        throw std::runtime_error("Invalid JSON file: unterminated string.");
+      if(c == '"')
+        break;
+      if(c != '\\')
+      {
+        _token.push_back(static_cast<char>(c));
+        continue;
+      }
+      c = _buffer.sbumpc();
+      switch(c)
+      {
+        case '"':
+        case '\\':
+        case '/': _token.push_back(static_cast<char>(c)); break;
+        case 'b': _token.push_back('\b'); break;
+        case 'f': _token.push_back('\f'); break;
+        case 'n': _token.push_back('\n'); break;
+        case 'r': _token.push_back('\r'); break;
+        case 't': _token.push_back('\t'); break;
+        case 'u': appendCodePoint(readCodePoint()); break;
+        default: throw std::runtime_error("Invalid JSON file: invalid escape sequence.");
+      }
+    }
+    return _token;
+  }
+
+  /// Read a string or a literal (number, true, false, null) as a text
+  const std::string& readScalar()
+  {
+    if(peek() == '"')
+      return readString();
+    _token.clear();
+    int c = _buffer.sgetc();
+    while(c != std::char_traits<char>::eof() && (std::isalnum(c) || c == '-' || c == '+' || c == '.'))
+    {
+      _token.push_back(static_cast<char>(c));
+      c = _buffer.snextc();
+    }
+    if(_token.empty())
+      throw std::runtime_error(std::string("Invalid JSON file: value expected, '") + static_cast<char>(c) + "' found.");
+    return _token;
+  }
+
+  /// Read a floating-point value (written as a number or as a string)
+  double readDouble()
+  {
+    const std::string& str = readScalar();
+    char* end;
+    const double value = std::strtod(str.c_str(), &end);
+    if(end == str.c_str())
+      throw std::runtime_error("Invalid JSON file: number expected, '" + str + "' found.");
+    return value;
+  }
+
+  /// Read an unsigned integer value (written as a number or as a string)
+  unsigned long readUnsigned()
+  {
+    const std::string& str = readScalar();
+    char* end;
+    const unsigned long value = std::strtoul(str.c_str(), &end, 10);
+    if(end == str.c_str())
+      throw std::runtime_error("Invalid JSON file: integer expected, '" + str + "' found.");
+    return value;
+  }
+
+  /**
+   * @brief Read an object, calling onMember(key) for each member: it must read the member value
+   */
+  template<typename OnMember>
+  void readObject(OnMember onMember)
+  {
+    expect('{');
+    if(accept('}'))
+      return;
+    do
+    {
+      const std::string key = readString();
+      expect(':');
+      onMember(key);
+    }
+    while(accept(','));
+    expect('}');
+  }
+
+  /**
+   * @brief Read an array, calling onElement() for each element: it must read the element value
+   * @note The property tree writes the empty arrays as "".
+   */
+  template<typename OnElement>
+  void readArray(OnElement onElement)
+  {
+    if(peek() == '"')
+    {
+      if(!readString().empty())
+        throw std::runtime_error("Invalid JSON file: array expected.");
+      return;
+    }
+    expect('[');
+    if(accept(']'))
+      return;
+    do
+    {
+      onElement();
+    }
+    while(accept(','));
+    expect(']');
+  }
+
+  /// Read a value in a property tree, as boost::property_tree::read_json
+  void readTree(bpt::ptree& tree)
+  {
+    const char c = peek();
+    if(c == '{')
+      readObject([&](const std::string& key) { readTree(tree.push_back(std::make_pair(key, bpt::ptree()))->second); });
+    else if(c == '[')
+      readArray([&]() { readTree(tree.push_back(std::make_pair(std::string(), bpt::ptree()))->second); });
+    else
+      tree.data() = readScalar();
+  }
+
+  /// Skip a value
+  void skipValue()
+  {
+    const char c = peek();
+    if(c == '{')
+      readObject([&](const std::string&) { skipValue(); });
+    else if(c == '[')
+      readArray([&]() { skipValue(); });
+    else
+      readScalar();
+  }
+
+private:
+  unsigned int readHexQuad()
+  {
+    unsigned int value = 0;
+    for(int i = 0; i < 4; ++i)
+    {
+      const int c = _buffer.sbumpc();
+      if(!std::isxdigit(c))
+        throw std::runtime_error("Invalid JSON file: invalid unicode escape sequence.");
+      value = value * 16 + (std::isdigit(c) ? c - '0' : std::tolower(c) - 'a' + 10);
+    }
+    return value;
+  }
+
+  unsigned int readCodePoint()
+  {
+    unsigned int codePoint = readHexQuad();
+    // surrogate pair
+    if(codePoint >= 0xD800 && codePoint < 0xDC00 && _buffer.sgetc() == '\\')
+    {
+      _buffer.sbumpc();
+      if(_buffer.sbumpc() != 'u')
+        throw std::runtime_error("Invalid JSON file: invalid unicode escape sequence.");
+      const unsigned int low = readHexQuad();
+      codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+    }
+    return codePoint;
+  }
+
+  void appendCodePoint(unsigned int codePoint)
+  {
+    // UTF-8 encoding
+    if(codePoint < 0x80)
+    {
+      _token.push_back(static_cast<char>(codePoint));
+    }
+    else if(codePoint < 0x800)
+    {
+      _token.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+      _token.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if(codePoint < 0x10000)
+    {
+      _token.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+      _token.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      _token.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+      _token.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+      _token.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+      _token.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      _token.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+  }
+
+  std::streambuf& _buffer;
+  std::string _token;
+};
+
+/**
+ * @brief Read a fixed size Eigen vector (as loadMatrix)
+ */
+template<typename Derived>
+void readVector(JsonReader& reader, Eigen::MatrixBase<Derived>& vector)
+{
+  int i = 0;
+  reader.readArray([&]()
+  {
+    if(i >= vector.size())
+      throw std::out_of_range("Invalid JSON file: invalid vector size.");
+    vector(i++) = static_cast<typename Derived::Scalar>(reader.readDouble());
+  });
+}
+
+/**
+ * @brief Read a Landmark (as loadLandmark) without building its property tree.
+ */
+void readLandmark(JsonReader& reader, IndexT& landmarkId, Landmark& landmark)
+{
+  landmarkId = UndefinedIndexT;
+
+  reader.readObject([&](const std::string& key)
+  {
+    if(key == "landmarkId")
+    {
+      landmarkId = static_cast<IndexT>(reader.readUnsigned());
+    }
+    else if(key == "descType")
+    {
+      landmark.descType = feature::EImageDescriberType_stringToEnum(reader.readString());
+    }
+    else if(key == "color")
+    {
+      int i = 0;
+      reader.readArray([&]()
+      {
+        if(i >= 3)
+          throw std::out_of_range("Invalid JSON file: invalid color size.");
+        landmark.rgb(i++) = static_cast<unsigned char>(reader.readUnsigned());
+      });
+    }
+    else if(key == "X")
+    {
+      readVector(reader, landmark.X);
+    }
+    else if(key == "observations")
+    {
+      reader.readArray([&]()
+      {
+        IndexT viewId = UndefinedIndexT;
+        Observation observation;
+
+        reader.readObject([&](const std::string& obsKey)
+        {
+          if(obsKey == "observationId")
+            viewId = static_cast<IndexT>(reader.readUnsigned());
+          else if(obsKey == "featureId")
+            observation.id_feat = static_cast<IndexT>(reader.readUnsigned());
+          else if(obsKey == "x")
+            readVector(reader, observation.x);
+          else
+            reader.skipValue();
+        });
+
+        if(viewId == UndefinedIndexT)
+          throw std::runtime_error("Invalid JSON file: observation without observationId.");
+
+        landmark.observations.emplace(viewId, observation);
+      });
+    }
+    else
+    {
+      reader.skipValue();
+    }
+  });
+
+  if(landmarkId == UndefinedIndexT)
+    throw std::runtime_error("Invalid JSON file: landmark without landmarkId.");
+}
+
+/**
+ * @brief Write the landmarks of a section without building their property tree.
+ * @details Same layout as boost::property_tree::write_json: all the values are written
+ *          as strings and the empty arrays as "".
+ */
+class LandmarksWriter
+{
+public:
+  explicit LandmarksWriter(std::ostream& stream)
+    : _stream(stream)
+  {}
+
+  /// Write the section of a landmarks collection (member of the root object)
+  void writeSection(const std::string& name, const Landmarks& landmarks)
+  {
+    _stream << ",\n" << indent(1) << "\"" << name << "\": [\n";
+    bool first = true;
+    for(const auto& landmarkPair : landmarks)
+    {
+      if(!first)
+        _stream << ",\n";
+      first = false;
+      writeLandmark(landmarkPair.first, landmarkPair.second);
+    }
+    _stream << "\n" << indent(1) << "]";
+  }
+
+private:
+  static const char* indent(int level)
+  {
+    static const std::string spaces(4 * 6, ' ');
+    return spaces.c_str() + spaces.size() - 4 * level;
+  }
+
+  template<typename T>
+  void writeValue(const T& value)
+  {
+    _stream << "\"" << value << "\"";
+  }
+
+  void writeValue(double value)
+  {
+    _stream << "\"";
+    _stream.precision(std::numeric_limits<double>::max_digits10);
+    _stream << value << "\"";
+  }
+
+  void writeValue(unsigned char value)
+  {
+    _stream << "\"" << static_cast<int>(value) << "\"";
+  }
+
+  template<typename T>
+  void writeMember(int level, const char* key, const T& value, bool last = false)
+  {
+    _stream << indent(level) << "\"" << key << "\": ";
+    writeValue(value);
+    _stream << (last ? "\n" : ",\n");
+  }
+
+  template<typename Vector>
+  void writeVectorMember(int level, const char* key, const Vector& vector, bool last = false)
+  {
+    _stream << indent(level) << "\"" << key << "\": [\n";
+    for(int i = 0; i < vector.size(); ++i)
+    {
+      _stream << indent(level + 1);
+      writeValue(vector(i));
+      _stream << ((i + 1 < vector.size()) ? ",\n" : "\n");
+    }
+    _stream << indent(level) << "]" << (last ? "\n" : ",\n");
+  }
+
+  void writeLandmark(IndexT landmarkId, const Landmark& landmark)
+  {
+    _stream << indent(2) << "{\n";
+    writeMember(3, "landmarkId", landmarkId);
+    writeMember(3, "descType", feature::EImageDescriberType_enumToString(landmark.descType));
+    writeVectorMember(3, "color", landmark.rgb);
+    writeVectorMember(3, "X", landmark.X);
+
+    _stream << indent(3) << "\"observations\": ";
+    if(landmark.observations.empty())
+    {
+      _stream << "\"\"\n";
+    }
+    else
+    {
+      _stream << "[\n";
+      std::size_t i = 0;
+      for(const auto& obsPair : landmark.observations)
+      {
+        _stream << indent(4) << "{\n";
+        writeMember(5, "observationId", obsPair.first);
+        writeMember(5, "featureId", obsPair.second.id_feat);
+        writeVectorMember(5, "x", obsPair.second.x, true);
+        _stream << indent(4) << ((++i < landmark.observations.size()) ? "},\n" : "}\n");
+      }
+      _stream << indent(3) << "]\n";
+    }
+    _stream << indent(2) << "}";
+  }
+
+  std::ostream& _stream;
+};
+
+} // namespace
+
 void saveView(const std::string& name, const View& view, bpt::ptree& parentTree)
 {
   bpt::ptree viewTree;
@@ -353,36 +790,38 @@ bool saveJSON(const SfMData& sfmData, const std::string& filename, ESfMData part
     }
   }
 
-  // structure
-  if(saveStructure && !sfmData.getLandmarks().empty())
-  {
-    bpt::ptree structureTree;
+  // write the json file with the tree,
+  // then the landmarks sections without building their tree
 
-    for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree);
+  std::ostringstream headerStream;
+  bpt::write_json(headerStream, fileTree);
+  std::string header = headerStream.str();
+  header.erase(header.find_last_of('}'));
+  while(!header.empty() && std::isspace(static_cast<unsigned char>(header.back())))
+    header.pop_back();
 
-    fileTree.add_child("structure", structureTree);
-  }
+  std::ofstream stream(filename);
+  if(!stream.is_open())
+    return false;
 
-  // control points
-  if(saveControlPoints && !sfmData.getControlPoints().empty())
-  {
-    bpt::ptree controlPointTree;
+  stream << header;
 
-    for(const auto& controlPointPair : sfmData.getControlPoints())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
+  LandmarksWriter landmarksWriter(stream);
 
-    fileTree.add_child("controlPoints", controlPointTree);
-  }
+  // structure
+  if(saveStructure && !sfmData.getLandmarks().empty())
+    landmarksWriter.writeSection("structure", sfmData.getLandmarks());
 
-  // write the json file with the tree
+  // control points
+  if(saveControlPoints && !sfmData.getControlPoints().empty())
+    landmarksWriter.writeSection("controlPoints", sfmData.getControlPoints());
 
-  bpt::write_json(filename, fileTree);
+  stream << "\n}\n";
 
-  return true;
+  return stream.good();
 }
 
-bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews)
+bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews, int nbIOThreads)
 {
   Vec3 version;
 
@@ -396,8 +835,45 @@ bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag,
   // main tree
   bpt::ptree fileTree;
 
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+  // read the json file:
+  // - the landmarks sections are loaded directly (or skipped) without building their tree
+  // - the tree is initialized with the other sections
+  {
+    std::ifstream stream(filename, std::ios::binary);
+    if(!stream.is_open())
+      throw std::runtime_error("Unable to open the JSON file: " + filename);
+
+    JsonReader reader(stream);
+
+    reader.readObject([&](const std::string& key)
+    {
+      const bool isStructure = (key == "structure");
+      const bool isControlPoints = (key == "controlPoints");
+
+      if(!isStructure && !isControlPoints)
+      {
+        reader.readTree(fileTree.push_back(std::make_pair(key, bpt::ptree()))->second);
+      }
+      else if((isStructure && loadStructure) || (isControlPoints && loadControlPoints))
+      {
+        Landmarks& landmarks = isStructure ? sfmData.getLandmarks() : sfmData.getControlPoints();
+
+        reader.readArray([&]()
+        {
+          IndexT landmarkId;
+          Landmark landmark;
+
+          readLandmark(reader, landmarkId, landmark);
+
+          landmarks.emplace(landmarkId, std::move(landmark));
+        });
+      }
+      else
+      {
+        reader.skipValue();
+      }
+    });
+  }
 
   // version
   loadMatrix("version", version, fileTree);
@@ -444,13 +920,10 @@ bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag,
         ++viewIndex;
       }
 
-      // update incomplete views
-      #pragma omp parallel for
-      for(int i = 0; i < incompleteViews.size(); ++i)
+      // if we have the intrinsics and the view has an valid associated intrinsics
+      // update the width and height field of View (they are mirrored)
+      for(View& v : incompleteViews)
       {
-        View& v = incompleteViews.at(i);
-        // if we have the intrinsics and the view has an valid associated intrinsics
-        // update the width and height field of View (they are mirrored)
         if (loadIntrinsics && v.getIntrinsicId() != UndefinedIndexT)
         {
           const auto intrinsics = sfmData.getIntrinsicPtr(v.getIntrinsicId());
@@ -466,9 +939,11 @@ bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag,
           v.setWidth(intrinsics->w());
           v.setHeight(intrinsics->h());
         }
-        updateIncompleteView(incompleteViews.at(i));
       }
 
+      // update incomplete views
+      updateIncompleteViews(incompleteViews, nbIOThreads);
+
       // copy complete views in the SfMData views map
       for(const View& view : incompleteViews)
         views.emplace(view.getViewId(), std::make_shared<View>(view));
@@ -521,38 +996,6 @@ bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag,
     }
   }
 
-  // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    Landmarks& structure = sfmData.getLandmarks();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
-    {
-      IndexT landmarkId;
-      Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      structure.emplace(landmarkId, landmark);
-    }
-  }
-
-  // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
-  {
-    Landmarks& controlPoints = sfmData.getControlPoints();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
-    {
-      IndexT landmarkId;
-      Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      controlPoints.emplace(landmarkId, landmark);
-    }
-  }
-
   return true;
 }
 
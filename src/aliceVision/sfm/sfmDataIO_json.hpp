@@ -210,9 +210,10 @@ bool saveJSON(const SfMData& sfmData, const std::string& filename, ESfMData part
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData load flag
  * @param[in] incompleteViews If true, try to load incomplete views
+ * @param[in] nbIOThreads The max. number of image headers read at the same time for the incomplete views (0: number of cores)
  * @return true if completed
  */
-bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews = false);
+bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews = false, int nbIOThreads = 0);
 
 } // namespace sfm
 } // namespace aliceVision
@@ -7,8 +7,10 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/sfmDataIO_json.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
 #include <sstream>
 
@@ -71,7 +73,7 @@ SfMData createTestScene(std::size_t viewsCount = 2, std::size_t observationCount
 
 BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
 
-  const std::vector<std::string> ext_Type = {"sfm","json"};
+  const std::vector<std::string> ext_Type = {"sfm","json","sfmb"};
 
   for(int i = 0; i < ext_Type.size(); ++i)
   {
@@ -172,11 +174,138 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_Landmarks) {
+
+  const std::string filename = "SAVE_LOAD_LANDMARKS.sfm";
+
+  SfMData sfmData = createTestScene(2, 2, true);
+  sfmData.structure[0].rgb = image::RGBColor(255, 0, 128);
+  sfmData.structure[7] = Landmark(Vec3(0.1, -1e-12, 123456.789), feature::EImageDescriberType::AKAZE, Observations(), image::RGBColor(1, 2, 3));
+  sfmData.control_points[3] = Landmark(Vec3(1.0/3.0, 2.0, 3.0), feature::EImageDescriberType::UNKNOWN);
+  sfmData.control_points[3].observations[1] = Observation(Vec2(0.25, 1.0/7.0), 42);
+
+  BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+  // the file is readable by the property tree and its landmarks are unchanged
+  {
+    bpt::ptree fileTree;
+    bpt::read_json(filename, fileTree);
+    BOOST_CHECK_EQUAL( fileTree.get_child("structure").size(), sfmData.structure.size());
+    BOOST_CHECK_EQUAL( fileTree.get_child("controlPoints").size(), sfmData.control_points.size());
+
+    for(bpt::ptree::value_type& landmarkNode : fileTree.get_child("structure"))
+    {
+      IndexT landmarkId;
+      Landmark landmark;
+      loadLandmark(landmarkId, landmark, landmarkNode.second);
+      BOOST_CHECK( landmark == sfmData.structure.at(landmarkId) );
+    }
+  }
+
+  // LOAD (ALL)
+  {
+    SfMData sfm_data_load;
+    BOOST_CHECK( Load(sfm_data_load, filename, ALL) );
+    BOOST_CHECK_EQUAL( sfm_data_load.views.size(), sfmData.views.size());
+    BOOST_REQUIRE_EQUAL( sfm_data_load.structure.size(), sfmData.structure.size());
+    BOOST_REQUIRE_EQUAL( sfm_data_load.control_points.size(), sfmData.control_points.size());
+
+    for(const auto& landmarkPair : sfmData.structure)
+    {
+      const Landmark& landmark = sfm_data_load.structure.at(landmarkPair.first);
+      BOOST_CHECK( landmark == landmarkPair.second );
+      BOOST_CHECK( landmark.X == landmarkPair.second.X ); // exact round trip
+    }
+    BOOST_CHECK( sfm_data_load.control_points.at(3) == sfmData.control_points.at(3) );
+    BOOST_CHECK( sfm_data_load.control_points.at(3).observations.at(1).x == sfmData.control_points.at(3).observations.at(1).x );
+  }
+
+  // LOAD (subparts: CONTROL_POINTS only, the structure is skipped)
+  {
+    SfMData sfm_data_load;
+    BOOST_CHECK( Load(sfm_data_load, filename, CONTROL_POINTS) );
+    BOOST_CHECK_EQUAL( sfm_data_load.views.size(), 0);
+    BOOST_CHECK_EQUAL( sfm_data_load.structure.size(), 0);
+    BOOST_CHECK_EQUAL( sfm_data_load.control_points.size(), sfmData.control_points.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_Binary) {
+
+  const std::string filename = "SAVE_LOAD_BINARY.sfmb";
+
+  SfMData sfmData = createTestScene(3, 4, false);
+  sfmData.addFeaturesFolder("features");
+  sfmData.getViews().at(1)->addMetadata("Make", "Canon");
+  sfmData.getViews().at(2)->setRigAndSubPoseId(0, 1);
+  sfmData.getRigs()[0] = Rig(2);
+  sfmData.getRigs()[0].setSubPose(1, RigSubPose(Pose3(RotationAroundX(0.3), Vec3(1.0, 2.0, 3.0)), ERigSubPoseStatus::CONSTANT));
+  sfmData.getIntrinsics().at(1) = std::make_shared<PinholeRadialK3>(1000, 800, 1200.0, 500.5, 399.5, 0.1, -0.01, 0.001);
+  sfmData.getIntrinsics().at(1)->lock();
+  sfmData.structure[0].rgb = image::RGBColor(255, 0, 128);
+  sfmData.structure[7] = Landmark(Vec3(0.1, -1e-12, 123456.789), feature::EImageDescriberType::AKAZE, Observations(), image::RGBColor(1, 2, 3));
+  sfmData.control_points[3] = Landmark(Vec3(1.0/3.0, 2.0, 3.0), feature::EImageDescriberType::UNKNOWN);
+  sfmData.control_points[3].observations[1] = Observation(Vec2(0.25, 1.0/7.0), 42);
+  sfmData._posesUncertainty[0] = Vec6::Constant(0.5);
+  sfmData._landmarksUncertainty[7] = Vec3(0.1, 0.2, 0.3);
+
+  BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+  // LOAD (ALL)
+  {
+    SfMData sfm_data_load;
+    BOOST_CHECK( Load(sfm_data_load, filename, ALL) );
+    BOOST_CHECK( sfm_data_load == sfmData );
+    BOOST_CHECK( sfm_data_load.getRelativeFeaturesFolders() == sfmData.getRelativeFeaturesFolders() );
+    BOOST_CHECK( sfm_data_load.getViews().at(1)->getMetadata() == sfmData.getViews().at(1)->getMetadata() );
+    BOOST_CHECK( sfm_data_load.getIntrinsics().at(1)->isLocked() );
+    BOOST_CHECK( sfm_data_load.structure.at(7).X == sfmData.structure.at(7).X ); // exact round trip
+    BOOST_CHECK( sfm_data_load.control_points.at(3) == sfmData.control_points.at(3) );
+    BOOST_CHECK( sfm_data_load._posesUncertainty.at(0) == sfmData._posesUncertainty.at(0) );
+    BOOST_CHECK( sfm_data_load._landmarksUncertainty.at(7) == sfmData._landmarksUncertainty.at(7) );
+  }
+
+  // LOAD (subparts: cameras only, the structure is skipped)
+  {
+    SfMData sfm_data_load;
+    BOOST_CHECK( Load(sfm_data_load, filename, ESfMData(VIEWS | INTRINSICS | EXTRINSICS)) );
+    BOOST_CHECK_EQUAL( sfm_data_load.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfm_data_load.getPoses().size(), sfmData.getPoses().size());
+    BOOST_CHECK_EQUAL( sfm_data_load.getRigs().size(), sfmData.getRigs().size());
+    BOOST_CHECK_EQUAL( sfm_data_load.intrinsics.size(), sfmData.intrinsics.size());
+    BOOST_CHECK_EQUAL( sfm_data_load.structure.size(), 0);
+    BOOST_CHECK_EQUAL( sfm_data_load.control_points.size(), 0);
+    BOOST_CHECK_EQUAL( sfm_data_load._posesUncertainty.size(), 0);
+    BOOST_CHECK_EQUAL( sfm_data_load._landmarksUncertainty.size(), 0);
+  }
+
+  // LOAD (subparts: STRUCTURE without OBSERVATIONS)
+  {
+    SfMData sfm_data_load;
+    BOOST_CHECK( Load(sfm_data_load, filename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfm_data_load.views.size(), 0);
+    BOOST_REQUIRE_EQUAL( sfm_data_load.structure.size(), sfmData.structure.size());
+    BOOST_CHECK( sfm_data_load.structure.at(0).X == sfmData.structure.at(0).X );
+    BOOST_CHECK( sfm_data_load.structure.at(0).observations.empty() );
+  }
+
+  // SAVE (subparts: the sections which are not saved cannot be loaded)
+  {
+    BOOST_CHECK( Save(sfmData, filename, ESfMData(VIEWS | STRUCTURE)) );
+    SfMData sfm_data_load;
+    BOOST_CHECK( Load(sfm_data_load, filename, ALL) );
+    BOOST_CHECK_EQUAL( sfm_data_load.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfm_data_load.getPoses().size(), 0);
+    BOOST_CHECK_EQUAL( sfm_data_load.structure.size(), sfmData.structure.size());
+    BOOST_CHECK( sfm_data_load.structure.at(0).observations.empty() );
+  }
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
   const int nbObservationPerView = 100000;
-  std::vector<std::string> ext_Type = {"sfm","json"};
+  std::vector<std::string> ext_Type = {"sfm","json","sfmb"};
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   ext_Type.push_back("abc");
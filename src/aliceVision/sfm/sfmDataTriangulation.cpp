@@ -7,14 +7,19 @@
 
 #include "sfmDataTriangulation.hpp"
 
+#include <aliceVision/sfm/DenseSfMData.hpp>
 #include <aliceVision/multiview/triangulation/Triangulation.hpp>
-#include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/system/Determinism.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/progress.hpp>
 
-#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <memory>
+#include <random>
 
 namespace aliceVision {
 namespace sfm {
@@ -22,170 +27,133 @@ namespace sfm {
 using namespace aliceVision::geometry;
 using namespace aliceVision::camera;
 
-StructureComputation_basis::StructureComputation_basis(bool bConsoleVerbose)
-  :_bConsoleVerbose(bConsoleVerbose)
-{
-}
+namespace {
 
-StructureComputation_blind::StructureComputation_blind(bool bConsoleVerbose)
-  :StructureComputation_basis(bConsoleVerbose)
+/**
+ * @brief Observations of a track gathered for its triangulation.
+ * One instance is kept per thread and reused from one track to the other,
+ * so no allocation is done once the buffers are large enough.
+ */
+struct TrackObservations
 {
-}
+  std::vector<const Mat34*> projections;
+  std::vector<const Pose3*> poses;
+  std::vector<const IntrinsicBase*> intrinsics;
+  std::vector<Vec2> points;
+  std::vector<Vec2> udPoints;
 
-void StructureComputation_blind::triangulate(SfMData & sfm_data) const
-{
-  std::deque<IndexT> rejectedId;
-  std::unique_ptr<boost::progress_display> my_progress_bar;
-  if (_bConsoleVerbose)
-    my_progress_bar.reset( new boost::progress_display(
-    sfm_data.structure.size(),
-    std::cout,
-    "Blind triangulation progress:\n" ));
-  #pragma omp parallel
-  for(Landmarks::iterator iterTracks = sfm_data.structure.begin();
-    iterTracks != sfm_data.structure.end();
-    ++iterTracks)
+  // RANSAC scratch
+  std::vector<std::size_t> samples;
+  std::vector<const Mat34*> sampleProjections;
+  std::vector<Vec2> sampleUdPoints;
+
+  std::size_t size() const {return points.size();}
+
+  void clear()
   {
-    #pragma omp single nowait
-    {
-      if (_bConsoleVerbose)
-      {
-        #pragma omp critical
-        ++(*my_progress_bar);
-      }
-      // Triangulate each landmark
-      Triangulation trianObj;
-      const Observations & observations = iterTracks->second.observations;
-      for(const auto& itObs : observations)
-      {
-        const View * view = sfm_data.views.at(itObs.first).get();
-        if (sfm_data.isPoseAndIntrinsicDefined(view))
-        {
-          const IntrinsicBase * cam = sfm_data.getIntrinsics().at(view->getIntrinsicId()).get();
-          const Pose3 pose = sfm_data.getPose(*view).getTransform();
-          trianObj.add(
-            cam->get_projective_equivalent(pose),
-            cam->get_ud_pixel(itObs.second.x));
-        }
-      }
-      if (trianObj.size() < 2)
-      {
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
-      }
-      else
-      {
-        // Compute the 3D point
-        const Vec3 X = trianObj.compute();
-        if (trianObj.minDepth() > 0) // Keep the point only if it have a positive depth
-        {
-          iterTracks->second.X = X;
-        }
-        else
-        {
-          #pragma omp critical
-          {
-            rejectedId.push_front(iterTracks->first);
-          }
-        }
-      }
-    }
+    projections.clear();
+    poses.clear();
+    intrinsics.clear();
+    points.clear();
+    udPoints.clear();
   }
-  // Erase the unsuccessful triangulated tracks
-  for (auto& it : rejectedId)
+
+  void add(const Mat34* projection, const Pose3* pose, const IntrinsicBase* intrinsic, const Vec2& point)
   {
-    sfm_data.structure.erase(it);
+    projections.push_back(projection);
+    poses.push_back(pose);
+    intrinsics.push_back(intrinsic);
+    points.push_back(point);
+    udPoints.push_back(intrinsic->get_ud_pixel(point));
   }
-}
+};
 
-StructureComputation_robust::StructureComputation_robust(bool bConsoleVerbose)
-  :StructureComputation_basis(bConsoleVerbose)
+/**
+ * @brief Gather the observations of a landmark slot with a defined pose and intrinsic
+ */
+void gatherTrackObservations(const DenseSfMData& denseSfmData,
+                             const std::vector<Mat34>& projectionPerView,
+                             std::uint32_t landmarkSlot,
+                             TrackObservations& track)
 {
+  track.clear();
+  for(std::size_t o = denseSfmData.getObservationsBegin(landmarkSlot); o < denseSfmData.getObservationsEnd(landmarkSlot); ++o)
+  {
+    const std::uint32_t viewSlot = denseSfmData.getObservationView(o);
+    if(!denseSfmData.isPoseAndIntrinsicDefined(viewSlot))
+      continue;
+    track.add(&projectionPerView[viewSlot], &denseSfmData.getPose(viewSlot), denseSfmData.getIntrinsic(viewSlot), denseSfmData.getObservationPoint(o));
+  }
 }
 
-void StructureComputation_robust::triangulate(SfMData & sfm_data) const
+/**
+ * @brief Projection matrix of each view slot with a defined pose and intrinsic
+ */
+std::vector<Mat34> computeProjectionPerView(const DenseSfMData& denseSfmData)
 {
-  robust_triangulation(sfm_data);
+  std::vector<Mat34> projectionPerView(denseSfmData.getNbViews(), Mat34::Zero());
+  for(std::uint32_t viewSlot = 0; viewSlot < denseSfmData.getNbViews(); ++viewSlot)
+  {
+    if(denseSfmData.isPoseAndIntrinsicDefined(viewSlot))
+      projectionPerView[viewSlot] = denseSfmData.getIntrinsic(viewSlot)->get_projective_equivalent(denseSfmData.getPose(viewSlot));
+  }
+  return projectionPerView;
 }
 
-/// Robust triangulation of track data contained in the structure
-/// All observations must have View with valid Intrinsic and Pose data
-/// Invalid landmark are removed.
-void StructureComputation_robust::robust_triangulation(SfMData & sfm_data) const
+/**
+ * @brief Draw numSamples unique indices in [0, upperBound) (Robert Floyd's algorithm)
+ */
+void drawSamples(std::size_t numSamples, std::size_t upperBound, std::mt19937& generator, std::vector<std::size_t>& samples)
 {
-  std::deque<IndexT> rejectedId;
-  std::unique_ptr<boost::progress_display> my_progress_bar;
-  if (_bConsoleVerbose)
-    my_progress_bar.reset( new boost::progress_display(
-    sfm_data.structure.size(),
-    std::cout,
-    "Robust triangulation progress:\n" ));
-  #pragma omp parallel
-  for(Landmarks::iterator iterTracks = sfm_data.structure.begin();
-    iterTracks != sfm_data.structure.end();
-    ++iterTracks)
+  samples.clear();
+  for(std::size_t d = upperBound - numSamples; d < upperBound; ++d)
   {
-    #pragma omp single nowait
-    {
-      if (_bConsoleVerbose)
-      {
-        #pragma omp critical
-        ++(*my_progress_bar);
-      }
-      Vec3 X;
-      if (robust_triangulation(sfm_data, iterTracks->second.observations, X)) {
-        iterTracks->second.X = X;
-      }
-      else {
-        iterTracks->second.X = Vec3::Zero();
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
-      }
-    }
-  }
-  // Erase the unsuccessful triangulated tracks
-  for (auto& it : rejectedId)
-  {
-    sfm_data.structure.erase(it);
+    const std::size_t t = std::uniform_int_distribution<std::size_t>(0, d)(generator);
+    if(std::find(samples.begin(), samples.end(), t) == samples.end())
+      samples.push_back(t);
+    else
+      samples.push_back(d);
   }
 }
 
-/// Robustly try to estimate the best 3D point using a ransac Scheme
-/// A point must be seen in at least 3 views
-/// Return true for a successful triangulation
-bool StructureComputation_robust::robust_triangulation(
-  const SfMData & sfm_data,
-  const Observations & observations,
-  Vec3 & X,
-  const IndexT min_required_inliers,
-  const IndexT min_sample_index) const
+/**
+ * @brief Robustly estimate the 3D point of a track using a RANSAC scheme
+ * @see StructureComputation_robust::robust_triangulation
+ */
+bool robustTrackTriangulation(TrackObservations& track,
+                              std::mt19937& generator,
+                              Vec3& X,
+                              const IndexT min_required_inliers,
+                              const IndexT min_sample_index)
 {
-  if (observations.size() < 3)
-  {
+  const std::size_t nbObservations = track.size();
+
+  if(nbObservations < 3)
     return false;
-  }
 
   const double dThresholdPixel = 4.0; // TODO: make this parameter customizable
 
-  const IndexT nbIter = observations.size(); // TODO: automatic computation of the number of iterations?
+  const std::size_t nbIter = nbObservations; // TODO: automatic computation of the number of iterations?
+  const std::size_t nbSamples = std::min(std::size_t(min_sample_index), nbObservations);
 
   // - Ransac variables
-  Vec3 best_model;
-  std::set<IndexT> best_inlier_set;
+  std::size_t best_nb_inliers = 0;
   double best_error = std::numeric_limits<double>::max();
 
   // - Ransac loop
-  for (IndexT i = 0; i < nbIter; ++i)
+  for(std::size_t i = 0; i < nbIter; ++i)
   {
-    std::set<IndexT> samples;
-    robustEstimation::UniformSample(std::min(std::size_t(min_sample_index), observations.size()), observations.size(), samples);
+    drawSamples(nbSamples, nbObservations, generator, track.samples);
 
     // Hypothesis generation.
-    const Vec3 current_model = track_sample_triangulation(sfm_data, observations, samples);
+    track.sampleProjections.clear();
+    track.sampleUdPoints.clear();
+    for(const std::size_t s : track.samples)
+    {
+      track.sampleProjections.push_back(track.projections[s]);
+      track.sampleUdPoints.push_back(track.udPoints[s]);
+    }
+    const Vec3 current_model = TriangulateIterative(track.sampleProjections.data(), track.sampleUdPoints.data(), nbSamples);
 
     // Test validity of the hypothesis
     // - chierality (for the samples)
@@ -193,36 +161,23 @@ bool StructureComputation_robust::robust_triangulation(
 
     // Chierality (Check the point is in front of the sampled cameras)
     bool bChierality = true;
+    for(const std::size_t s : track.samples)
+      bChierality &= track.poses[s]->depth(current_model) > 0; // TODO: cam->depth(pose(X));
 
-    for (auto& it : samples)
-    {
-      Observations::const_iterator itObs = observations.begin();
-      std::advance(itObs, it);
-      const View * view = sfm_data.views.at(itObs->first).get();
-      const IntrinsicBase * cam = sfm_data.getIntrinsics().at(view->getIntrinsicId()).get();
-      const Pose3 pose = sfm_data.getPose(*view).getTransform();
-      const double z = pose.depth(current_model); // TODO: cam->depth(pose(X));
-      bChierality &= z > 0;
-    }
-
-    if (!bChierality)
+    if(!bChierality)
       continue;
 
-    std::set<IndexT> inlier_set;
+    std::size_t nb_inliers = 0;
     double current_error = 0.0;
-    
+
     // Classification as inlier/outlier according pixel residual errors.
-    for (const auto& itObs : observations)
+    for(std::size_t o = 0; o < nbObservations; ++o)
     {
-      const View * view = sfm_data.views.at(itObs.first).get();
-      const IntrinsicBase * intrinsic = sfm_data.getIntrinsics().at(view->getIntrinsicId()).get();
-      const Pose3 pose = sfm_data.getPose(*view).getTransform();
-      const Vec2 residual = intrinsic->residual(pose, current_model, itObs.second.x);
-      const double residual_d = residual.norm();
+      const double residual_d = track.intrinsics[o]->residual(*track.poses[o], current_model, track.points[o]).norm();
 
-      if (residual_d < dThresholdPixel)
+      if(residual_d < dThresholdPixel)
       {
-        inlier_set.insert(itObs.first);
+        ++nb_inliers;
         current_error += residual_d;
       }
       else
@@ -231,37 +186,179 @@ bool StructureComputation_robust::robust_triangulation(
       }
     }
     // Does the hypothesis is the best one we have seen and have sufficient inliers.
-    if (current_error < best_error && inlier_set.size() >= min_required_inliers)
+    if(current_error < best_error && nb_inliers >= min_required_inliers)
     {
-      X = best_model = current_model;
-      best_inlier_set = inlier_set;
+      X = current_model;
+      best_nb_inliers = nb_inliers;
       best_error = current_error;
     }
   }
-  return !best_inlier_set.empty();
+  return best_nb_inliers > 0;
 }
 
+/**
+ * @brief Triangulate all the landmarks of the scene in parallel.
+ *
+ * The projection matrices are computed once per view, each thread keeps its own observation
+ * buffers and random generator, and the landmarks are dispatched by slot.
+ * In the deterministic mode, the generator is seeded by the landmark id.
+ * The valid points are written back and the other landmarks are removed afterwards.
+ *
+ * @param[in] triangulateTrack Functor (TrackObservations&, std::mt19937&, Vec3&) -> bool
+ */
+template<typename TriangulateTrackFunc>
+void triangulateLandmarks(SfMData& sfmData, bool verbose, const char* progressMessage, const TriangulateTrackFunc& triangulateTrack)
+{
+  const DenseSfMData denseSfmData(sfmData);
+  const std::vector<Mat34> projectionPerView = computeProjectionPerView(denseSfmData);
+  const int nbLandmarks = static_cast<int>(denseSfmData.getNbLandmarks());
+
+  Mat3X points(3, nbLandmarks);
+  std::vector<char> isValid(nbLandmarks, 0);
+
+  std::unique_ptr<boost::progress_display> my_progress_bar;
+  if(verbose)
+    my_progress_bar.reset(new boost::progress_display(nbLandmarks, std::cout, progressMessage));
+  std::atomic<int> nbProcessed(0);
+
+  // in the deterministic mode, the random sequence of a landmark doesn't depend on the thread which triangulates it
+  const bool deterministic = system::Determinism::isEnabled();
 
-/// Triangulate a given track from a selection of observations
-Vec3 StructureComputation_robust::track_sample_triangulation(
+  #pragma omp parallel
+  {
+    TrackObservations track;
+    std::random_device rd;
+    std::mt19937 generator(rd());
+
+    #pragma omp for schedule(dynamic, 64)
+    for(int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
+    {
+      if(deterministic)
+        generator.seed(denseSfmData.getLandmarkId(landmarkSlot));
+
+      gatherTrackObservations(denseSfmData, projectionPerView, landmarkSlot, track);
+
+      Vec3 X;
+      if(triangulateTrack(track, generator, X))
+      {
+        points.col(landmarkSlot) = X;
+        isValid[landmarkSlot] = 1;
+      }
+
+      ++nbProcessed;
+      if(verbose && omp_get_thread_num() == 0)
+      {
+        const unsigned long nbDone = nbProcessed.load();
+        if(nbDone > my_progress_bar->count())
+          (*my_progress_bar) += nbDone - my_progress_bar->count();
+      }
+    }
+  }
+
+  if(verbose && my_progress_bar->count() < my_progress_bar->expected_count())
+    (*my_progress_bar) += my_progress_bar->expected_count() - my_progress_bar->count();
+
+  // Update the successfully triangulated tracks and erase the others
+  for(int landmarkSlot = 0; landmarkSlot < nbLandmarks; ++landmarkSlot)
+  {
+    const IndexT landmarkId = denseSfmData.getLandmarkId(landmarkSlot);
+    if(isValid[landmarkSlot])
+      sfmData.structure.at(landmarkId).X = points.col(landmarkSlot);
+    else
+      sfmData.structure.erase(landmarkId);
+  }
+}
+
+} // namespace
+
+StructureComputation_basis::StructureComputation_basis(bool bConsoleVerbose)
+  :_bConsoleVerbose(bConsoleVerbose)
+{
+}
+
+StructureComputation_blind::StructureComputation_blind(bool bConsoleVerbose)
+  :StructureComputation_basis(bConsoleVerbose)
+{
+}
+
+void StructureComputation_blind::triangulate(SfMData & sfm_data) const
+{
+  triangulateLandmarks(sfm_data, _bConsoleVerbose, "Blind triangulation progress:\n",
+    [](TrackObservations& track, std::mt19937&, Vec3& X)
+    {
+      if(track.size() < 2)
+        return false;
+
+      // Compute the 3D point using all the observations
+      double minDepth = 0.0;
+      X = TriangulateIterative(track.projections.data(), track.udPoints.data(), track.size(), &minDepth);
+      return minDepth > 0; // Keep the point only if it have a positive depth
+    });
+}
+
+StructureComputation_robust::StructureComputation_robust(bool bConsoleVerbose)
+  :StructureComputation_basis(bConsoleVerbose)
+{
+}
+
+void StructureComputation_robust::triangulate(SfMData & sfm_data) const
+{
+  robust_triangulation(sfm_data);
+}
+
+/// Robust triangulation of track data contained in the structure
+/// All observations must have View with valid Intrinsic and Pose data
+/// Invalid landmark are removed.
+void StructureComputation_robust::robust_triangulation(SfMData & sfm_data) const
+{
+  triangulateLandmarks(sfm_data, _bConsoleVerbose, "Robust triangulation progress:\n",
+    [](TrackObservations& track, std::mt19937& generator, Vec3& X)
+    {
+      return robustTrackTriangulation(track, generator, X, 3, 3);
+    });
+}
+
+/// Robustly try to estimate the best 3D point using a ransac Scheme
+/// A point must be seen in at least 3 views
+/// Return true for a successful triangulation
+bool StructureComputation_robust::robust_triangulation(
   const SfMData & sfm_data,
   const Observations & observations,
-  const std::set<IndexT> & samples) const
+  Vec3 & X,
+  const IndexT min_required_inliers,
+  const IndexT min_sample_index) const
 {
-  Triangulation trianObj;
-  for (const IndexT idx : samples)
+  if (observations.size() < 3)
+  {
+    return false;
+  }
+
+  std::vector<Mat34> projections;
+  std::vector<Pose3> poses;
+  projections.reserve(observations.size());
+  poses.reserve(observations.size());
+
+  for (const auto& itObs : observations)
   {
-    assert(idx < observations.size());
-    Observations::const_iterator itObs = observations.begin();
-    std::advance(itObs, idx);
-    const View * view = sfm_data.views.at(itObs->first).get();
+    const View * view = sfm_data.views.at(itObs.first).get();
     const IntrinsicBase * cam = sfm_data.getIntrinsics().at(view->getIntrinsicId()).get();
-    const Pose3 pose = sfm_data.getPose(*view).getTransform();
-    trianObj.add(
-      cam->get_projective_equivalent(pose),
-      cam->get_ud_pixel(itObs->second.x));
+    poses.push_back(sfm_data.getPose(*view).getTransform());
+    projections.push_back(cam->get_projective_equivalent(poses.back()));
   }
-  return trianObj.compute();
+
+  TrackObservations track;
+  std::size_t i = 0;
+  for (const auto& itObs : observations)
+  {
+    const View * view = sfm_data.views.at(itObs.first).get();
+    const IntrinsicBase * cam = sfm_data.getIntrinsics().at(view->getIntrinsicId()).get();
+    track.add(&projections[i], &poses[i], cam, itObs.second.x);
+    ++i;
+  }
+
+  std::random_device rd;
+  std::mt19937 generator(rd());
+  return robustTrackTriangulation(track, generator, X, min_required_inliers, min_sample_index);
 }
 
 } // namespace sfm
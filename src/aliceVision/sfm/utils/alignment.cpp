@@ -7,15 +7,13 @@
 
 #include <aliceVision/sfm/utils/alignment.hpp>
 #include <aliceVision/geometry/rigidTransformation3D.hpp>
-
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/min.hpp>
-#include <boost/accumulators/statistics/max.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <algorithm>
-
-namespace bacc = boost::accumulators;
+#include <limits>
+#include <random>
+#include <vector>
 
 namespace aliceVision {
 namespace sfm {
@@ -42,7 +40,8 @@ bool computeSimilarity(const SfMData & sfmDataA,
   // Move input point in appropriate container
   Mat xA(3, commonViewIds.size());
   Mat xB(3, commonViewIds.size());
-  for (size_t i = 0; i  < commonViewIds.size(); ++i)
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(commonViewIds.size()); ++i)
   {
     IndexT viewId = commonViewIds[i];
     xA.col(i) = sfmDataA.getAbsolutePose(sfmDataA.getViews().at(viewId)->getPoseId()).getTransform().center();
@@ -65,6 +64,125 @@ bool computeSimilarity(const SfMData & sfmDataA,
   return true;
 }
 
+bool computeSimilarityFromCommonLandmarks(const SfMData& sfmDataA,
+                                          const SfMData& sfmDataB,
+                                          double* out_S,
+                                          Mat3* out_R,
+                                          Vec3* out_t,
+                                          std::size_t maxNbCorrespondences)
+{
+  assert(out_S != nullptr);
+  assert(out_R != nullptr);
+  assert(out_t != nullptr);
+
+  std::vector<const Landmark*> landmarksA;
+  std::vector<IndexT> landmarkIds;
+  landmarksA.reserve(sfmDataA.getLandmarks().size());
+  landmarkIds.reserve(sfmDataA.getLandmarks().size());
+  for(const auto& landmark : sfmDataA.getLandmarks())
+  {
+    landmarksA.push_back(&landmark.second);
+    landmarkIds.push_back(landmark.first);
+  }
+
+  // find the landmarks with the same id in B
+  std::vector<const Landmark*> landmarksB(landmarksA.size(), nullptr);
+  const Landmarks& structureB = sfmDataB.getLandmarks();
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(landmarksA.size()); ++i)
+  {
+    const auto it = structureB.find(landmarkIds[i]);
+    if(it != structureB.end())
+      landmarksB[i] = &it->second;
+  }
+
+  std::vector<std::size_t> commonLandmarks;
+  for(std::size_t i = 0; i < landmarksB.size(); ++i)
+  {
+    if(landmarksB[i] != nullptr)
+      commonLandmarks.push_back(i);
+  }
+  if(commonLandmarks.size() < 3)
+  {
+    ALICEVISION_LOG_WARNING("Cannot compute similarities. Need at least 3 common landmarks.");
+    return false;
+  }
+  ALICEVISION_LOG_DEBUG("Found " << commonLandmarks.size() << " common landmarks.");
+
+  // the robust estimation is done on a random subset of the common landmarks
+  if(commonLandmarks.size() > maxNbCorrespondences)
+  {
+    std::mt19937 generator;
+    for(std::size_t i = 0; i < maxNbCorrespondences; ++i)
+    {
+      std::uniform_int_distribution<std::size_t> distribution(i, commonLandmarks.size() - 1);
+      std::swap(commonLandmarks[i], commonLandmarks[distribution(generator)]);
+    }
+    commonLandmarks.resize(maxNbCorrespondences);
+  }
+
+  Mat xA(3, commonLandmarks.size());
+  Mat xB(3, commonLandmarks.size());
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(commonLandmarks.size()); ++i)
+  {
+    xA.col(i) = landmarksA[commonLandmarks[i]]->X;
+    xB.col(i) = landmarksB[commonLandmarks[i]]->X;
+  }
+
+  // Compute rigid transformation p'i = S R pi + t
+  double S;
+  Vec3 t;
+  Mat3 R;
+  std::vector<std::size_t> inliers;
+  if(!aliceVision::geometry::ACRansac_FindRTS(xA, xB, S, t, R, inliers, true, true))
+    return false;
+
+  ALICEVISION_LOG_DEBUG(inliers.size() << " of the " << commonLandmarks.size() << " selected common landmarks were used to compute the similarity transform.");
+
+  *out_S = S;
+  *out_R = R;
+  *out_t = t;
+  return true;
+}
+
+void applyTransform(SfMData& sfmData,
+                    const double S,
+                    const Mat3& R,
+                    const Vec3& t,
+                    bool transformControlPoints)
+{
+  for(auto& viewPair: sfmData.views)
+  {
+    const View& view = *viewPair.second;
+    if(sfmData.existsPose(view))
+    {
+      geometry::Pose3 pose = sfmData.getPose(view).getTransform();
+      pose = pose.transformSRt(S, R, t);
+      sfmData.setPose(view, CameraPose(pose));
+    }
+  }
+
+  std::vector<Landmark*> landmarks;
+  landmarks.reserve(sfmData.structure.size() + (transformControlPoints ? sfmData.control_points.size() : 0));
+  for(auto& landmark: sfmData.structure)
+    landmarks.push_back(&landmark.second);
+
+  if(transformControlPoints)
+  {
+    for(auto& controlPts: sfmData.control_points)
+      landmarks.push_back(&controlPts.second);
+  }
+
+  const Mat3 SR = S * R;
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(landmarks.size()); ++i)
+    landmarks[i]->X = SR * landmarks[i]->X + t;
+}
+
 void computeNewCoordinateSystemFromCameras(const SfMData& sfmData,
                                            double& out_S,
                                            Mat3& out_R,
@@ -142,47 +260,77 @@ void computeNewCoordinateSystemFromLandmarks(const SfMData& sfmData,
                                     Mat3& out_R,
                                     Vec3& out_t)
 {
-    const std::size_t nbLandmarks = sfmData.getLandmarks().size();
+    std::vector<const Landmark*> landmarks;
+    landmarks.reserve(sfmData.getLandmarks().size());
+    for(const auto& landmark : sfmData.getLandmarks())
+      landmarks.push_back(&landmark.second);
 
-    Mat3X vX(3,nbLandmarks);
+    const int nbLandmarks = static_cast<int>(landmarks.size());
+    std::vector<bool> isMeanLandmark(nbLandmarks, true);
 
-    std::size_t i = 0;
+    if(!imageDescriberTypes.empty())
+    {
+      for(int i = 0; i < nbLandmarks; ++i)
+        isMeanLandmark[i] = (std::find(imageDescriberTypes.begin(), imageDescriberTypes.end(), landmarks[i]->descType) != imageDescriberTypes.end());
+    }
 
-    Vec3 meanPoints = Vec3::Zero(3,1);
+    // Compute the mean of the point cloud and its bounding box
+    Vec3 meanPoints = Vec3::Zero();
     std::size_t nbMeanLandmarks = 0;
+    Vec3 minPoint = Vec3::Constant(std::numeric_limits<double>::max());
+    Vec3 maxPoint = Vec3::Constant(std::numeric_limits<double>::lowest());
 
-    bacc::accumulator_set<double, bacc::stats<bacc::tag::min, bacc::tag::max> > accX, accY, accZ;
-
-    for(const auto & landmark : sfmData.getLandmarks())
+    #pragma omp parallel
     {
-      const Vec3& position = landmark.second.X;
+      Vec3 threadSum = Vec3::Zero();
+      std::size_t threadNbMeanLandmarks = 0;
+      Vec3 threadMin = Vec3::Constant(std::numeric_limits<double>::max());
+      Vec3 threadMax = Vec3::Constant(std::numeric_limits<double>::lowest());
 
-      vX.col(i) = position;
-
-      // Compute the mean of the point cloud
-      if(imageDescriberTypes.empty() ||
-         std::find(imageDescriberTypes.begin(), imageDescriberTypes.end(), landmark.second.descType) != imageDescriberTypes.end())
+      #pragma omp for nowait
+      for(int i = 0; i < nbLandmarks; ++i)
       {
-        meanPoints += position;
-        ++nbMeanLandmarks;
+        const Vec3& position = landmarks[i]->X;
+        if(isMeanLandmark[i])
+        {
+          threadSum += position;
+          ++threadNbMeanLandmarks;
+        }
+        threadMin = threadMin.cwiseMin(position);
+        threadMax = threadMax.cwiseMax(position);
       }
 
-      accX(position(0));
-      accY(position(1));
-      accZ(position(2));
-      ++i;
+      #pragma omp critical
+      {
+        meanPoints += threadSum;
+        nbMeanLandmarks += threadNbMeanLandmarks;
+        minPoint = minPoint.cwiseMin(threadMin);
+        maxPoint = maxPoint.cwiseMax(threadMax);
+      }
     }
 
     meanPoints /= nbMeanLandmarks;
 
-    // Center the point cloud in [0;0;0]
-    for(int i=0 ; i < nbLandmarks ; ++i)
+    // Perform an svd over the var-covar of the point cloud centered in [0;0;0]
+    Mat3 dum = Mat3::Zero();
+
+    #pragma omp parallel
     {
-      vX.col(i) -= meanPoints;
+      Mat3 threadDum = Mat3::Zero();
+
+      #pragma omp for nowait
+      for(int i = 0; i < nbLandmarks; ++i)
+      {
+        if(!isMeanLandmark[i])
+          continue;
+        const Vec3 centered = landmarks[i]->X - meanPoints;
+        threadDum += centered * centered.transpose();
+      }
+
+      #pragma omp critical
+      dum += threadDum;
     }
 
-    // Perform an svd over vX*vXT (var-covar)
-    Mat3 dum = vX.leftCols(nbMeanLandmarks) * vX.leftCols(nbMeanLandmarks).transpose();
     Eigen::JacobiSVD<Mat3> svd(dum,Eigen::ComputeFullV|Eigen::ComputeFullU);
     Mat3 U = svd.matrixU();
 
@@ -193,7 +341,7 @@ void computeNewCoordinateSystemFromLandmarks(const SfMData& sfmData,
       U.col(2) = -U.col(2);
     }
 
-    out_S = 1.0 / std::max({bacc::max(accX) - bacc::min(accX), bacc::max(accY) - bacc::min(accY), bacc::max(accZ) - bacc::min(accZ)});
+    out_S = 1.0 / (maxPoint - minPoint).maxCoeff();
     out_R = U.transpose();
     out_R = Eigen::AngleAxisd(degreeToRadian(90.0),  Vec3(1,0,0)) * out_R;
     out_t = - out_S * out_R * meanPoints;
@@ -63,7 +63,28 @@ bool computeSimilarity(const SfMData& sfmDataA,
 
 
 /**
- * @brief Apply a transformation the given SfMData
+ * @brief Compute a similarity between the landmarks with the same id in the two scenes.
+ *
+ * The landmarks are paired in parallel. The similarity is robustly estimated on a random
+ * subset of the pairs, the models unlikely to be better than the best one are rejected early.
+ *
+ * @param[in] sfmDataA
+ * @param[in] sfmDataB
+ * @param[out] out_S output scale factor
+ * @param[out] out_R output rotation 3x3 matrix
+ * @param[out] out_t output translation vector
+ * @param[in] maxNbCorrespondences max. number of landmarks used for the robust estimation
+ * @return true if it finds a similarity transformation
+ */
+bool computeSimilarityFromCommonLandmarks(const SfMData& sfmDataA,
+                                          const SfMData& sfmDataB,
+                                          double* out_S,
+                                          Mat3* out_R,
+                                          Vec3* out_t,
+                                          std::size_t maxNbCorrespondences = 100000);
+
+/**
+ * @brief Apply a transformation the given SfMData, the landmarks are transformed in parallel
  *
  * @param sfmData The goiven SfMData
  * @param S scale
@@ -71,36 +92,11 @@ bool computeSimilarity(const SfMData& sfmDataA,
  * @param t translation
  * @param transformControlPoints
  */
-inline void applyTransform(SfMData& sfmData,
-                           const double S,
-                           const Mat3& R,
-                           const Vec3& t,
-                           bool transformControlPoints = false)
-{
-  for(auto& viewPair: sfmData.views)
-  {
-    const View& view = *viewPair.second;
-    if(sfmData.existsPose(view))
-    {
-      geometry::Pose3 pose = sfmData.getPose(view).getTransform();
-      pose = pose.transformSRt(S, R, t);
-      sfmData.setPose(view, CameraPose(pose));
-    }
-  }
-  
-  for(auto& landmark: sfmData.structure)
-  {
-    landmark.second.X = S * R * landmark.second.X + t;
-  }
-  
-  if(!transformControlPoints)
-    return;
-  
-  for(auto& controlPts: sfmData.control_points)
-  {
-    controlPts.second.X = S * R * controlPts.second.X + t;
-  }
-}
+void applyTransform(SfMData& sfmData,
+                    const double S,
+                    const Mat3& R,
+                    const Vec3& t,
+                    bool transformControlPoints = false);
 
 /**
  * @brief Compute the new coordinate system in the given reconstruction so that the mean
@@ -0,0 +1,208 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "marginalCovariance.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+namespace aliceVision {
+namespace sfm {
+
+MarginalCovariance::MarginalCovariance(const sRMat& jacobian, std::size_t nbPoses, std::size_t nbLandmarks, const std::vector<geometry::Pose3>& poses)
+  : _nbPoses(nbPoses)
+  , _nbLandmarks(nbLandmarks)
+{
+  const std::size_t nbCameraParams = 6 * nbPoses;
+  const std::size_t nbLandmarkParams = 3 * nbLandmarks;
+
+  if(jacobian.cols() != nbCameraParams + nbLandmarkParams)
+  {
+    ALICEVISION_LOG_ERROR("Marginal covariance: the Jacobian has " << jacobian.cols() << " columns, "
+                          << nbCameraParams + nbLandmarkParams << " expected (" << nbPoses << " poses, " << nbLandmarks << " landmarks).");
+    return;
+  }
+  if(nbPoses < 2)
+  {
+    ALICEVISION_LOG_ERROR("Marginal covariance: at least 2 poses are required.");
+    return;
+  }
+
+  // Information matrix blocks
+  const sMat J(jacobian);
+  const sMat Jc = J.leftCols(nbCameraParams);
+  const sMat Jp = J.rightCols(nbLandmarkParams);
+
+  const sMat U = Jc.transpose() * Jc;
+  _W = Jc.transpose() * Jp;
+  const sMat V = Jp.transpose() * Jp; // block diagonal
+
+  // Invert the landmark blocks
+  _invV.resize(nbLandmarks);
+  _isLandmarkValid.resize(nbLandmarks);
+
+  #pragma omp parallel for
+  for(int p = 0; p < nbLandmarks; ++p)
+  {
+    Mat3 Vp = Mat3::Zero();
+    for(int c = 0; c < 3; ++c)
+    {
+      for(sMat::InnerIterator it(V, 3 * p + c); it; ++it)
+        Vp(it.row() - 3 * p, c) = it.value();
+    }
+    bool isInvertible = false;
+    Vp.computeInverseWithCheck(_invV[p], isInvertible, 1e-12);
+    _isLandmarkValid[p] = isInvertible;
+    if(!isInvertible)
+      _invV[p].setZero();
+  }
+
+  // Reduced camera system
+  sMat invV(nbLandmarkParams, nbLandmarkParams);
+  {
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(9 * nbLandmarks);
+    for(std::size_t p = 0; p < nbLandmarks; ++p)
+      for(int r = 0; r < 3; ++r)
+        for(int c = 0; c < 3; ++c)
+          triplets.emplace_back(3 * p + r, 3 * p + c, _invV[p](r, c));
+    invV.setFromTriplets(triplets.begin(), triplets.end());
+  }
+  const sMat S = U - sMat(_W * invV * _W.transpose());
+
+  // Gauge: reference pose and scale
+  std::size_t scaleParam = 6 + 3;
+  if(poses.size() == nbPoses)
+  {
+    const Vec3 referenceCenter = poses.front().center();
+    double maxDistance = 0.0;
+    for(std::size_t i = 1; i < nbPoses; ++i)
+    {
+      // sensitivity of the translation t_i = -R_i * c_i to a scaling around the reference center
+      const Vec3 dt = poses[i].rotation() * (poses[i].center() - referenceCenter);
+      const double distance = dt.norm();
+      if(distance <= maxDistance)
+        continue;
+      int axis;
+      dt.cwiseAbs().maxCoeff(&axis);
+      maxDistance = distance;
+      scaleParam = 6 * i + 3 + axis;
+    }
+  }
+
+  _freeColumnPerCameraParam.assign(nbCameraParams, -1);
+  _nbFreeColumns = 0;
+  for(std::size_t param = 6; param < nbCameraParams; ++param)
+  {
+    if(param != scaleParam && U.coeff(param, param) > 0.0)
+      _freeColumnPerCameraParam[param] = _nbFreeColumns++;
+  }
+
+  sMat selection(nbCameraParams, _nbFreeColumns);
+  {
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(_nbFreeColumns);
+    for(std::size_t param = 0; param < nbCameraParams; ++param)
+    {
+      if(_freeColumnPerCameraParam[param] >= 0)
+        triplets.emplace_back(param, _freeColumnPerCameraParam[param], 1.0);
+    }
+    selection.setFromTriplets(triplets.begin(), triplets.end());
+  }
+
+  const sMat freeS = selection.transpose() * S * selection;
+  _reducedCameraSystem.compute(freeS);
+  _isValid = (_reducedCameraSystem.info() == Eigen::Success);
+
+  if(!_isValid)
+    ALICEVISION_LOG_ERROR("Marginal covariance: the reduced camera system cannot be factorized.");
+}
+
+void MarginalCovariance::computePoseCovariances(std::vector<Mat6, Eigen::aligned_allocator<Mat6>>& poseCovariances) const
+{
+  poseCovariances.assign(_nbPoses, Mat6::Zero());
+
+  if(!_isValid)
+    return;
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < _nbPoses; ++i)
+  {
+    // free parameters of the pose
+    std::vector<int> params;
+    std::vector<int> columns;
+    for(int a = 0; a < 6; ++a)
+    {
+      const int column = getFreeColumn(6 * i + a);
+      if(column < 0)
+        continue;
+      params.push_back(a);
+      columns.push_back(column);
+    }
+    if(params.empty())
+      continue;
+
+    Mat E = Mat::Zero(_nbFreeColumns, params.size());
+    for(std::size_t a = 0; a < params.size(); ++a)
+      E(columns[a], a) = 1.0;
+
+    const Mat X = _reducedCameraSystem.solve(E);
+
+    Mat6& covariance = poseCovariances[i];
+    for(std::size_t a = 0; a < params.size(); ++a)
+      for(std::size_t b = 0; b < params.size(); ++b)
+        covariance(params[a], params[b]) = X(columns[a], b);
+  }
+}
+
+void MarginalCovariance::computeLandmarkCovariances(const std::vector<std::size_t>& landmarkIndexes,
+                                                    std::vector<Mat3>& landmarkCovariances,
+                                                    std::vector<bool>& validLandmarks) const
+{
+  const bool allLandmarks = landmarkIndexes.empty();
+  const std::size_t nbRequested = allLandmarks ? _nbLandmarks : landmarkIndexes.size();
+
+  landmarkCovariances.assign(nbRequested, Mat3::Zero());
+  validLandmarks.assign(nbRequested, false);
+
+  if(!_isValid)
+    return;
+
+  #pragma omp parallel
+  {
+    Mat B(_nbFreeColumns, 3);
+
+    #pragma omp for schedule(dynamic)
+    for(int l = 0; l < nbRequested; ++l)
+    {
+      const std::size_t p = allLandmarks ? l : landmarkIndexes[l];
+      if(!_isLandmarkValid[p])
+        continue;
+
+      // B_p = W_p * V_p^-1 (on the free camera parameters)
+      B.setZero();
+      for(int c = 0; c < 3; ++c)
+      {
+        for(sMat::InnerIterator it(_W, 3 * p + c); it; ++it)
+        {
+          const int column = getFreeColumn(it.row());
+          if(column >= 0)
+            B(column, c) = it.value();
+        }
+      }
+      B = B * _invV[p];
+
+      const Mat Y = _reducedCameraSystem.solve(B);
+      landmarkCovariances[l] = _invV[p] + B.transpose() * Y;
+    }
+  }
+
+  for(std::size_t l = 0; l < nbRequested; ++l)
+    validLandmarks[l] = _isLandmarkValid[allLandmarks ? l : landmarkIndexes[l]];
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,90 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/geometry/Pose3.hpp>
+
+#include <Eigen/SparseCholesky>
+
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+typedef Eigen::Matrix<double, 6, 6> Mat6;
+
+/**
+ * @brief Marginal covariances of a bundle adjustment problem, computed block per block.
+ *
+ * The Jacobian is expected with the pose parameters first (6 per pose, angle-axis and translation)
+ * and the landmark parameters afterwards (3 per landmark), as given by BundleAdjustmentCeres::createJacobian
+ * with BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE on a scene without rig.
+ *
+ * With H = J^T J = [U W; W^T V], the landmarks are eliminated (V is block diagonal) and the
+ * reduced camera system S = U - W V^-1 W^T is factorized once (sparse Cholesky).
+ * Only the requested blocks of H^-1 are then computed, in parallel:
+ * - pose i: the 6x6 diagonal block of S^-1 (6 solves)
+ * - landmark p: V_p^-1 + B_p^T S^-1 B_p, with B_p = W_p V_p^-1 (3 solves)
+ *
+ * The gauge freedom is removed by fixing the reference pose (the first one) and, for the scale,
+ * the translation coordinate of the pose the farthest from it which is the most sensitive to the scale.
+ * The camera parameters without any information (constant poses) are fixed too.
+ */
+class MarginalCovariance
+{
+public:
+  /**
+   * @brief Factorize the reduced camera system
+   * @param[in] jacobian The bundle adjustment Jacobian
+   * @param[in] nbPoses The num. of poses
+   * @param[in] nbLandmarks The num. of landmarks
+   * @param[in] poses The poses (in the Jacobian order), used to select the scale gauge (the first translation coordinate of the second pose if empty)
+   */
+  MarginalCovariance(const sRMat& jacobian, std::size_t nbPoses, std::size_t nbLandmarks, const std::vector<geometry::Pose3>& poses = {});
+
+  /// Return true if the reduced camera system has been factorized
+  bool isValid() const {return _isValid;}
+
+  /**
+   * @brief Compute the covariances of the poses
+   * @param[out] poseCovariances The 6x6 covariance of each pose (zero for the reference pose)
+   */
+  void computePoseCovariances(std::vector<Mat6, Eigen::aligned_allocator<Mat6>>& poseCovariances) const;
+
+  /**
+   * @brief Compute the covariances of a subset of the landmarks
+   * @param[in] landmarkIndexes The indexes of the landmarks in the Jacobian (all the landmarks if empty)
+   * @param[out] landmarkCovariances The 3x3 covariance of each requested landmark
+   * @param[out] validLandmarks False for the landmarks with a singular information matrix
+   */
+  void computeLandmarkCovariances(const std::vector<std::size_t>& landmarkIndexes,
+                                  std::vector<Mat3>& landmarkCovariances,
+                                  std::vector<bool>& validLandmarks) const;
+
+private:
+  /// Column of a camera parameter in the reduced camera system (-1 if fixed by the gauge)
+  int getFreeColumn(std::size_t cameraParam) const {return _freeColumnPerCameraParam[cameraParam];}
+
+  std::size_t _nbPoses;
+  std::size_t _nbLandmarks;
+  bool _isValid = false;
+
+  /// W = J_c^T J_p (camera parameters x landmark parameters), column major to extract the landmark blocks
+  sMat _W;
+  /// V_p^-1 for each landmark
+  std::vector<Mat3> _invV;
+  /// False for the landmarks with a singular information matrix
+  std::vector<char> _isLandmarkValid;
+
+  std::vector<int> _freeColumnPerCameraParam;
+  std::size_t _nbFreeColumns = 0;
+  Eigen::SimplicialLDLT<sMat> _reducedCameraSystem;
+};
+
+} // namespace sfm
+} // namespace aliceVision
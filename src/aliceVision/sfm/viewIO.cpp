@@ -10,9 +10,11 @@
 #include <aliceVision/sfm/utils/uid.hpp>
 #include <aliceVision/camera/camera.hpp>
 #include <aliceVision/image/io.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <exception>
 #include <stdexcept>
 
 namespace fs = boost::filesystem;
@@ -30,17 +32,22 @@ void updateIncompleteView(View& view)
      view.getWidth() >  0)
     return;
 
-  int width, height;
-  std::map<std::string, std::string> metadata;
+  // metadata-only fast path: the image size and metadata are already known,
+  // don't open the image
+  if(view.getWidth() <= 0 || view.getHeight() <= 0 || view.getMetadata().empty())
+  {
+    int width, height;
+    std::map<std::string, std::string> metadata;
 
-  image::readImageMetadata(view.getImagePath(), width, height, metadata);
+    image::readImageMetadata(view.getImagePath(), width, height, metadata);
 
-  view.setWidth(width);
-  view.setHeight(height);
+    view.setWidth(width);
+    view.setHeight(height);
 
-  // reset metadata
-  if(view.getMetadata().empty())
-    view.setMetadata(metadata);
+    // reset metadata
+    if(view.getMetadata().empty())
+      view.setMetadata(metadata);
+  }
 
   // reset viewId
   view.setViewId(computeUID(view));
@@ -63,6 +70,31 @@ void updateIncompleteView(View& view)
   }
 }
 
+void updateIncompleteViews(std::vector<View>& views, int nbIOThreads)
+{
+  if(nbIOThreads <= 0)
+    nbIOThreads = omp_get_max_threads();
+
+  std::exception_ptr updateException;
+
+  #pragma omp parallel for num_threads(nbIOThreads) schedule(dynamic)
+  for(int i = 0; i < views.size(); ++i)
+  {
+    try
+    {
+      updateIncompleteView(views.at(i));
+    }
+    catch(...)
+    {
+      #pragma omp critical
+      updateException = std::current_exception();
+    }
+  }
+
+  if(updateException)
+    std::rethrow_exception(updateException);
+}
+
 std::shared_ptr<camera::IntrinsicBase> getViewIntrinsic(const View& view,
                                                         double mmFocalLength,
                                                         double sensorWidth,
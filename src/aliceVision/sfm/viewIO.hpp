@@ -11,6 +11,7 @@
 #include <aliceVision/camera/IntrinsicBase.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace aliceVision {
 namespace sfm {
@@ -21,6 +22,15 @@ namespace sfm {
  */
 void updateIncompleteView(View& view);
 
+/**
+ * @brief update incomplete views, reading the image headers concurrently
+ * @note Reading the headers is latency bound on network filesystems:
+ *       more concurrent reads than cores can be used.
+ * @param[in,out] views The given incomplete views
+ * @param[in] nbIOThreads The max. number of image headers read at the same time (0: number of cores)
+ */
+void updateIncompleteViews(std::vector<View>& views, int nbIOThreads = 0);
+
 /**
  * @brief create an intrinsic for the given View
  * @param[in] view The given view
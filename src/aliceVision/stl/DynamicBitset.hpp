@@ -9,6 +9,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <vector>
 #include <cassert>
@@ -75,8 +76,52 @@ namespace stl
     }
 
     const BlockType * data() const { return &vec_bits[0]; }
+    BlockType * data() { return &vec_bits[0]; }
+
+    // return the number of bits set to 1
+    size_t count() const
+    {
+      return xor_count_blocks(data(), nullptr, num_blocks());
+    }
+
+    // return the number of bits set to 1 in (a ^ b): their Hamming distance
+    friend size_t xor_count(const dynamic_bitset & a, const dynamic_bitset & b)
+    {
+      assert(a.num_blocks() == b.num_blocks());
+      return xor_count_blocks(a.data(), b.data(), a.num_blocks());
+    }
+
+    // return the number of bits set to 1 in (a ^ b) over a span of blocks (a if b is null)
+    static size_t xor_count_blocks(const BlockType * a, const BlockType * b, size_t num_blocks)
+    {
+      size_t result = 0;
+      size_t i = 0;
+      // 64 bits words, the unused bits of the last block are always 0
+      for(; i + sizeof(std::uint64_t) <= num_blocks; i += sizeof(std::uint64_t))
+      {
+        std::uint64_t va, vb = 0;
+        std::memcpy(&va, a + i, sizeof(std::uint64_t));
+        if(b != nullptr)
+          std::memcpy(&vb, b + i, sizeof(std::uint64_t));
+        result += popcount(va ^ vb);
+      }
+      for(; i < num_blocks; ++i)
+        result += popcount(static_cast<std::uint64_t>(a[i] ^ (b != nullptr ? b[i] : 0)));
+      return result;
+    }
 
   private:
+    static size_t popcount(std::uint64_t n)
+    {
+#if defined __GNUC__ || defined __clang__
+      return __builtin_popcountll(n);
+#else
+      n -= ((n >> 1) & 0x5555555555555555ULL);
+      n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+      return (((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56;
+#endif
+    }
+
     inline size_t calc_num_blocks(size_t num_bits)
     {
       return num_bits / bits_per_block
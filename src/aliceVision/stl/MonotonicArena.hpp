@@ -0,0 +1,239 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <new>
+#include <set>
+#include <vector>
+
+namespace stl
+{
+
+  /**
+   * Monotonic memory arena for short-lived scratch containers.
+   *
+   * The allocations only move a cursor in the current block, deallocations do nothing:
+   * the memory is reclaimed all at once by rewinding to a previous position (see arena_scope).
+   * When the arena is rewound to its beginning, the blocks are merged in a single block of
+   * their total size, so the next iterations of a loop don't allocate anymore.
+   */
+  class monotonic_arena
+  {
+  public:
+    /// Position in the arena, everything allocated after it is reclaimed by rewind()
+    struct marker
+    {
+      std::size_t block;
+      std::size_t offset;
+    };
+
+    explicit monotonic_arena(std::size_t initial_block_size = 64 * 1024)
+      : m_next_block_size(initial_block_size)
+    {}
+
+    ~monotonic_arena()
+    {
+      release();
+    }
+
+    monotonic_arena(const monotonic_arena &) = delete;
+    monotonic_arena & operator=(const monotonic_arena &) = delete;
+
+    void * allocate(std::size_t bytes, std::size_t alignment)
+    {
+      for(; m_current < m_blocks.size(); ++m_current, m_offset = 0)
+      {
+        void * ptr = allocate_in(m_blocks[m_current], bytes, alignment);
+        if(ptr != nullptr)
+          return ptr;
+      }
+
+      // no space left in the existing blocks
+      while(m_next_block_size < bytes + alignment)
+        m_next_block_size *= 2;
+      block new_block;
+      new_block.data = static_cast<unsigned char *>(std::malloc(m_next_block_size));
+      if(new_block.data == nullptr)
+        throw std::bad_alloc();
+      new_block.size = m_next_block_size;
+      m_blocks.push_back(new_block);
+      m_next_block_size *= 2;
+      m_offset = 0;
+      return allocate_in(m_blocks.back(), bytes, alignment);
+    }
+
+    marker position() const
+    {
+      return marker{m_current, m_offset};
+    }
+
+    /// Reuse the memory allocated after the given position
+    void rewind(const marker & position)
+    {
+      if(position.block == 0 && position.offset == 0)
+      {
+        reset();
+        return;
+      }
+      m_current = position.block;
+      m_offset = position.offset;
+    }
+
+    /// Reuse all the memory, the blocks are merged for the next allocations
+    void reset()
+    {
+      if(m_blocks.size() > 1)
+      {
+        const std::size_t total_size = capacity();
+        release();
+        block merged;
+        merged.data = static_cast<unsigned char *>(std::malloc(total_size));
+        if(merged.data != nullptr)
+        {
+          merged.size = total_size;
+          m_blocks.push_back(merged);
+        }
+      }
+      m_current = 0;
+      m_offset = 0;
+    }
+
+    /// Free all the blocks
+    void release()
+    {
+      for(const block & b : m_blocks)
+        std::free(b.data);
+      m_blocks.clear();
+      m_current = 0;
+      m_offset = 0;
+    }
+
+    /// Total size of the blocks
+    std::size_t capacity() const
+    {
+      std::size_t size = 0;
+      for(const block & b : m_blocks)
+        size += b.size;
+      return size;
+    }
+
+  private:
+    struct block
+    {
+      unsigned char * data = nullptr;
+      std::size_t size = 0;
+    };
+
+    void * allocate_in(const block & b, std::size_t bytes, std::size_t alignment)
+    {
+      const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(b.data) + m_offset;
+      const std::size_t padding = (alignment - address % alignment) % alignment;
+      if(m_offset + padding + bytes > b.size)
+        return nullptr;
+      m_offset += padding;
+      void * ptr = b.data + m_offset;
+      m_offset += bytes;
+      return ptr;
+    }
+
+    std::vector<block> m_blocks;
+    std::size_t m_current = 0;
+    std::size_t m_offset = 0;
+    std::size_t m_next_block_size;
+  };
+
+  /**
+   * Rewind an arena at the end of the scope.
+   * The scopes can be nested: an inner scope only reclaims its own allocations.
+   */
+  class arena_scope
+  {
+  public:
+    explicit arena_scope(monotonic_arena & arena)
+      : m_arena(arena)
+      , m_position(arena.position())
+    {}
+
+    ~arena_scope()
+    {
+      m_arena.rewind(m_position);
+    }
+
+    arena_scope(const arena_scope &) = delete;
+    arena_scope & operator=(const arena_scope &) = delete;
+
+  private:
+    monotonic_arena & m_arena;
+    const monotonic_arena::marker m_position;
+  };
+
+  /**
+   * Standard allocator in a monotonic_arena.
+   * The containers using it must not outlive the arena_scope they were created in.
+   */
+  template<typename T>
+  class arena_allocator
+  {
+  public:
+    typedef T value_type;
+
+    explicit arena_allocator(monotonic_arena & arena) noexcept
+      : m_arena(&arena)
+    {}
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U> & other) noexcept
+      : m_arena(other.arena())
+    {}
+
+    T * allocate(std::size_t n)
+    {
+      if(n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        throw std::bad_alloc();
+      return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, std::size_t) noexcept
+    {}
+
+    monotonic_arena * arena() const noexcept { return m_arena; }
+
+  private:
+    monotonic_arena * m_arena;
+  };
+
+  template<typename T, typename U>
+  bool operator==(const arena_allocator<T> & a, const arena_allocator<U> & b) noexcept
+  {
+    return a.arena() == b.arena();
+  }
+
+  template<typename T, typename U>
+  bool operator!=(const arena_allocator<T> & a, const arena_allocator<U> & b) noexcept
+  {
+    return a.arena() != b.arena();
+  }
+
+  template<typename T>
+  using arena_vector = std::vector<T, arena_allocator<T> >;
+
+  template<typename T, typename Compare = std::less<T> >
+  using arena_set = std::set<T, Compare, arena_allocator<T> >;
+
+  /// Arena of the calling thread, for the scratch containers of the parallel loops
+  inline monotonic_arena & thread_arena()
+  {
+    static thread_local monotonic_arena arena;
+    return arena;
+  }
+
+} // namespace stl
@@ -0,0 +1,408 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace stl
+{
+
+  /**
+   * Open-addressing hash map for integer (or enum) keys.
+   *
+   * The values are stored in a single array with linear probing, so a lookup reads
+   * a few contiguous slots and an insertion doesn't allocate a node.
+   * The erased slots are marked as deleted until the next rehash: erase() doesn't
+   * move any value, the other iterators remain valid (as with std::map).
+   * The insertions invalidate the iterators and references if the map is rehashed.
+   *
+   * The API is the subset of std::map used for the IndexT containers,
+   * but the iteration order is unspecified.
+   */
+  template<typename K, typename V, typename Alloc = std::allocator<std::pair<const K, V> > >
+  class open_hash_map
+  {
+  public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+    typedef std::size_t size_type;
+    typedef value_type & reference;
+    typedef const value_type & const_reference;
+
+  private:
+    typedef typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type slot_type;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<slot_type> slot_allocator;
+
+    enum : std::uint8_t { EMPTY = 0, FULL = 1, DELETED = 2 };
+
+    template<bool IsConst>
+    class iterator_impl
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef typename open_hash_map::value_type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef typename std::conditional<IsConst, const value_type *, value_type *>::type pointer;
+      typedef typename std::conditional<IsConst, const value_type &, value_type &>::type reference;
+
+      iterator_impl() {}
+
+      // iterator to const_iterator
+      template<bool OtherConst, typename = typename std::enable_if<IsConst && !OtherConst>::type>
+      iterator_impl(const iterator_impl<OtherConst> & other)
+        : m_map(other.m_map)
+        , m_index(other.m_index)
+      {}
+
+      reference operator*() const { return m_map->value(m_index); }
+      pointer operator->() const { return &m_map->value(m_index); }
+
+      iterator_impl & operator++()
+      {
+        m_index = m_map->next_full(m_index + 1);
+        return *this;
+      }
+
+      iterator_impl operator++(int)
+      {
+        iterator_impl it = *this;
+        ++(*this);
+        return it;
+      }
+
+      bool operator==(const iterator_impl & other) const { return m_index == other.m_index; }
+      bool operator!=(const iterator_impl & other) const { return m_index != other.m_index; }
+
+    private:
+      friend class open_hash_map;
+      template<bool> friend class iterator_impl;
+
+      typedef typename std::conditional<IsConst, const open_hash_map *, open_hash_map *>::type map_pointer;
+
+      iterator_impl(map_pointer map, size_type index)
+        : m_map(map)
+        , m_index(index)
+      {}
+
+      map_pointer m_map = nullptr;
+      size_type m_index = 0;
+    };
+
+  public:
+    typedef iterator_impl<false> iterator;
+    typedef iterator_impl<true> const_iterator;
+
+    open_hash_map() {}
+
+    open_hash_map(const open_hash_map & other)
+    {
+      reserve(other.size());
+      for(const value_type & value : other)
+        insert(value);
+    }
+
+    open_hash_map(open_hash_map && other) noexcept
+    {
+      swap(other);
+    }
+
+    ~open_hash_map()
+    {
+      destroy();
+    }
+
+    open_hash_map & operator=(const open_hash_map & other)
+    {
+      if(this != &other)
+      {
+        open_hash_map copy(other);
+        swap(copy);
+      }
+      return *this;
+    }
+
+    open_hash_map & operator=(open_hash_map && other) noexcept
+    {
+      swap(other);
+      return *this;
+    }
+
+    void swap(open_hash_map & other) noexcept
+    {
+      std::swap(m_slots, other.m_slots);
+      std::swap(m_states, other.m_states);
+      std::swap(m_capacity, other.m_capacity);
+      std::swap(m_shift, other.m_shift);
+      std::swap(m_size, other.m_size);
+      std::swap(m_nb_deleted, other.m_nb_deleted);
+    }
+
+    iterator begin() { return iterator(this, next_full(0)); }
+    iterator end() { return iterator(this, m_capacity); }
+    const_iterator begin() const { return const_iterator(this, next_full(0)); }
+    const_iterator end() const { return const_iterator(this, m_capacity); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool empty() const { return m_size == 0; }
+    size_type size() const { return m_size; }
+
+    void clear()
+    {
+      for(size_type i = 0; i < m_capacity; ++i)
+      {
+        if(m_states[i] == FULL)
+          value(i).~value_type();
+        m_states[i] = EMPTY;
+      }
+      m_size = 0;
+      m_nb_deleted = 0;
+    }
+
+    /// Allocate the slots for count values, so they can be inserted without rehash
+    void reserve(size_type count)
+    {
+      size_type capacity = 8;
+      while(capacity * max_load_numerator < count * max_load_denominator)
+        capacity *= 2;
+      if(capacity > m_capacity)
+        rehash(capacity);
+    }
+
+    iterator find(const K & key) { return iterator(this, find_index(key)); }
+    const_iterator find(const K & key) const { return const_iterator(this, find_index(key)); }
+
+    size_type count(const K & key) const { return find_index(key) != m_capacity ? 1 : 0; }
+
+    V & at(const K & key)
+    {
+      const size_type index = find_index(key);
+      if(index == m_capacity)
+        throw std::out_of_range("open_hash_map::at: key not found");
+      return value(index).second;
+    }
+
+    const V & at(const K & key) const
+    {
+      const size_type index = find_index(key);
+      if(index == m_capacity)
+        throw std::out_of_range("open_hash_map::at: key not found");
+      return value(index).second;
+    }
+
+    V & operator[](const K & key)
+    {
+      return try_emplace(key).first->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type & value)
+    {
+      return try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type && value)
+    {
+      return try_emplace(value.first, std::move(value.second));
+    }
+
+    template<typename P, typename = typename std::enable_if<std::is_constructible<value_type, P&&>::value>::type>
+    std::pair<iterator, bool> insert(P && value)
+    {
+      return emplace(std::forward<P>(value));
+    }
+
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      for(; first != last; ++first)
+        insert(*first);
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+      value_type value(std::forward<Args>(args)...);
+      return try_emplace(value.first, std::move(value.second));
+    }
+
+    /// Insert the value constructed from args if the key is not in the map
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const K & key, Args&&... args)
+    {
+      size_type index = find_index(key);
+      if(index != m_capacity)
+        return std::make_pair(iterator(this, index), false);
+
+      if(m_capacity == 0)
+      {
+        rehash(8);
+      }
+      else if((m_size + m_nb_deleted + 1) * max_load_denominator > m_capacity * max_load_numerator)
+      {
+        // only clean the deleted slots if they are numerous enough
+        rehash(m_size + 1 > m_capacity / 2 ? m_capacity * 2 : m_capacity);
+      }
+
+      index = insert_index(key);
+      if(m_states[index] == DELETED)
+        --m_nb_deleted;
+      ::new(static_cast<void *>(&m_slots[index])) value_type(std::piecewise_construct,
+                                                            std::forward_as_tuple(key),
+                                                            std::forward_as_tuple(std::forward<Args>(args)...));
+      m_states[index] = FULL;
+      ++m_size;
+      return std::make_pair(iterator(this, index), true);
+    }
+
+    /// Erase a value, the next iterator is returned and the other iterators remain valid
+    iterator erase(const_iterator pos)
+    {
+      assert(m_states[pos.m_index] == FULL);
+      value(pos.m_index).~value_type();
+      m_states[pos.m_index] = DELETED;
+      --m_size;
+      ++m_nb_deleted;
+      return iterator(this, next_full(pos.m_index + 1));
+    }
+
+    iterator erase(iterator pos)
+    {
+      return erase(const_iterator(pos));
+    }
+
+    size_type erase(const K & key)
+    {
+      const size_type index = find_index(key);
+      if(index == m_capacity)
+        return 0;
+      erase(const_iterator(this, index));
+      return 1;
+    }
+
+    bool operator==(const open_hash_map & other) const
+    {
+      if(m_size != other.m_size)
+        return false;
+      for(const value_type & value : *this)
+      {
+        const const_iterator it = other.find(value.first);
+        if(it == other.end() || !(it->second == value.second))
+          return false;
+      }
+      return true;
+    }
+
+    bool operator!=(const open_hash_map & other) const { return !(*this == other); }
+
+  private:
+    // maximum load factor (including the deleted slots): 7/8
+    static const size_type max_load_numerator = 7;
+    static const size_type max_load_denominator = 8;
+
+    value_type & value(size_type index) { return *reinterpret_cast<value_type *>(&m_slots[index]); }
+    const value_type & value(size_type index) const { return *reinterpret_cast<const value_type *>(&m_slots[index]); }
+
+    // Fibonacci hashing: the high bits of the product mix all the key bits
+    size_type hash(const K & key) const
+    {
+      return static_cast<size_type>((static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+    }
+
+    size_type next_full(size_type index) const
+    {
+      while(index < m_capacity && m_states[index] != FULL)
+        ++index;
+      return index;
+    }
+
+    /// Return the slot of the key, or m_capacity if it is not in the map
+    size_type find_index(const K & key) const
+    {
+      if(m_capacity == 0)
+        return m_capacity;
+      const size_type mask = m_capacity - 1;
+      for(size_type index = hash(key);; index = (index + 1) & mask)
+      {
+        if(m_states[index] == EMPTY)
+          return m_capacity;
+        if(m_states[index] == FULL && value(index).first == key)
+          return index;
+      }
+    }
+
+    /// Return the first free slot (empty or deleted) of the probe sequence of a key
+    size_type insert_index(const K & key) const
+    {
+      const size_type mask = m_capacity - 1;
+      size_type index = hash(key);
+      while(m_states[index] == FULL)
+        index = (index + 1) & mask;
+      return index;
+    }
+
+    void rehash(size_type capacity)
+    {
+      assert((capacity & (capacity - 1)) == 0);
+
+      open_hash_map other;
+      other.allocate(capacity);
+      for(size_type i = 0; i < m_capacity; ++i)
+      {
+        if(m_states[i] != FULL)
+          continue;
+        const size_type index = other.insert_index(value(i).first);
+        ::new(static_cast<void *>(&other.m_slots[index])) value_type(std::move(value(i)));
+        other.m_states[index] = FULL;
+        ++other.m_size;
+      }
+      swap(other);
+    }
+
+    void allocate(size_type capacity)
+    {
+      assert(m_capacity == 0);
+      slot_allocator allocator;
+      m_slots = allocator.allocate(capacity);
+      m_states = new std::uint8_t[capacity]();
+      m_capacity = capacity;
+      m_shift = 64;
+      for(size_type c = capacity; c > 1; c /= 2)
+        --m_shift;
+    }
+
+    void destroy()
+    {
+      if(m_capacity == 0)
+        return;
+      clear();
+      slot_allocator allocator;
+      allocator.deallocate(m_slots, m_capacity);
+      delete[] m_states;
+      m_slots = nullptr;
+      m_states = nullptr;
+      m_capacity = 0;
+    }
+
+    slot_type * m_slots = nullptr;
+    std::uint8_t * m_states = nullptr;
+    size_type m_capacity = 0;
+    unsigned int m_shift = 64;
+    size_type m_size = 0;
+    size_type m_nb_deleted = 0;
+  };
+
+} // namespace stl
@@ -0,0 +1,96 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace stl
+{
+
+  /**
+   * Lock-free union-find (disjoint sets) over the indexes [0, size[.
+   *
+   * find() and join() can be called concurrently from any number of threads:
+   * the roots are linked with a compare-and-swap and the paths are shortened with
+   * path halving. The sets are linked by index (the root with the largest index is
+   * attached to the other one), so the root of each set is its smallest index,
+   * whatever the order of the joins.
+   */
+  template<typename IndexT = std::uint32_t>
+  class concurrent_union_find
+  {
+  public:
+    explicit concurrent_union_find(std::size_t size)
+      : m_size(size)
+      , m_parent(new std::atomic<IndexT>[size])
+    {
+      for(std::size_t i = 0; i < size; ++i)
+        m_parent[i].store(static_cast<IndexT>(i), std::memory_order_relaxed);
+    }
+
+    std::size_t size() const { return m_size; }
+
+    /// Return the root of the set of x: the smallest index of the set once all the joins are done
+    IndexT find(IndexT x)
+    {
+      for(;;)
+      {
+        IndexT parent = m_parent[x].load(std::memory_order_relaxed);
+        const IndexT grandParent = m_parent[parent].load(std::memory_order_relaxed);
+        if(parent == grandParent)
+          return parent;
+        // path halving, may fail if another thread already changed the parent
+        m_parent[x].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+        x = grandParent;
+      }
+    }
+
+    /**
+     * Merge the sets of x and y.
+     * @return true if x and y were in different sets
+     */
+    bool join(IndexT x, IndexT y)
+    {
+      for(;;)
+      {
+        x = find(x);
+        y = find(y);
+        if(x == y)
+          return false;
+        if(x < y)
+          std::swap(x, y);
+        // x is the root with the largest index, retry if it is not a root anymore
+        IndexT expected = x;
+        if(m_parent[x].compare_exchange_strong(expected, y, std::memory_order_acq_rel))
+          return true;
+      }
+    }
+
+    bool same_set(IndexT x, IndexT y)
+    {
+      for(;;)
+      {
+        x = find(x);
+        y = find(y);
+        if(x == y)
+          return true;
+        // x and y are in different sets only if x is still a root
+        if(m_parent[x].load(std::memory_order_acquire) == x)
+          return false;
+      }
+    }
+
+  private:
+    std::size_t m_size;
+    std::unique_ptr<std::atomic<IndexT>[]> m_parent;
+  };
+
+} // namespace stl
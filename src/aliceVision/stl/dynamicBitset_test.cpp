@@ -69,3 +69,26 @@ BOOST_AUTO_TEST_CASE(DYNAMIC_BITSET_InitAndReset_4)
     BOOST_CHECK_EQUAL(false, mybitset[i]);
   }
 }
+
+BOOST_AUTO_TEST_CASE(DYNAMIC_BITSET_Count)
+{
+  using namespace stl;
+
+  // more than one 64 bits word, and a partial last block
+  const int nbBits = 131;
+  dynamic_bitset a(nbBits);
+  dynamic_bitset b(nbBits);
+  BOOST_CHECK_EQUAL(0, a.count());
+
+  for (int i = 0; i < nbBits; i += 3)
+    a[i] = true;
+  for (int i = 0; i < nbBits; i += 2)
+    b[i] = true;
+
+  BOOST_CHECK_EQUAL(44, a.count());
+  BOOST_CHECK_EQUAL(66, b.count());
+
+  // bits set in only one of them: a + b - 2 * (multiples of 6)
+  BOOST_CHECK_EQUAL(44 + 66 - 2 * 22, xor_count(a, b));
+  BOOST_CHECK_EQUAL(0, xor_count(a, a));
+}
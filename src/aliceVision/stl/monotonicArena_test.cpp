@@ -0,0 +1,80 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MonotonicArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+
+#define BOOST_TEST_MODULE stlMonotonicArena
+#include <boost/test/included/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(MONOTONIC_ARENA_Alignment)
+{
+  stl::monotonic_arena arena(256);
+  for(std::size_t alignment : {1, 2, 8, 16, 64})
+  {
+    arena.allocate(3, 1);
+    const void* ptr = arena.allocate(100, alignment);
+    BOOST_CHECK_EQUAL(0, reinterpret_cast<std::uintptr_t>(ptr) % alignment);
+  }
+  // larger than a block
+  BOOST_CHECK(arena.allocate(10000, 8) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(MONOTONIC_ARENA_Scopes)
+{
+  stl::monotonic_arena arena(1024);
+  {
+    stl::arena_scope scope(arena);
+    void* outer = arena.allocate(100, 8);
+    void* inner = nullptr;
+    {
+      stl::arena_scope innerScope(arena);
+      inner = arena.allocate(100, 8);
+      BOOST_CHECK(inner != outer);
+    }
+    // the memory of the inner scope is reused, not the one of the outer scope
+    BOOST_CHECK(arena.allocate(100, 8) == inner);
+  }
+
+  // the blocks are merged at the end of the outermost scope
+  for(int iteration = 0; iteration < 3; ++iteration)
+  {
+    stl::arena_scope scope(arena);
+    for(int i = 0; i < 20; ++i)
+      arena.allocate(1000, 8);
+  }
+  const std::size_t capacity = arena.capacity();
+  {
+    stl::arena_scope scope(arena);
+    for(int i = 0; i < 20; ++i)
+      arena.allocate(1000, 8);
+  }
+  BOOST_CHECK_EQUAL(capacity, arena.capacity());
+}
+
+BOOST_AUTO_TEST_CASE(MONOTONIC_ARENA_Containers)
+{
+  stl::monotonic_arena& arena = stl::thread_arena();
+  stl::arena_scope scope(arena);
+
+  stl::arena_vector<double> values{stl::arena_allocator<double>(arena)};
+  stl::arena_set<int> ids{std::less<int>(), stl::arena_allocator<int>(arena)};
+  for(int i = 0; i < 1000; ++i)
+  {
+    values.push_back(i * 0.5);
+    ids.insert(999 - i);
+  }
+  BOOST_CHECK_EQUAL(1000, values.size());
+  BOOST_CHECK_EQUAL(499.5, values.back());
+  BOOST_CHECK_EQUAL(1000, ids.size());
+  BOOST_CHECK_EQUAL(0, *ids.begin());
+
+  std::set<int> copy(ids.begin(), ids.end());
+  BOOST_CHECK(std::equal(copy.begin(), copy.end(), ids.begin()));
+}
@@ -0,0 +1,123 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+/**
+ * Benchmark of the containers for IndexT keys (std::map, std::unordered_map and
+ * stl::open_hash_map) on the SfMData landmarks access patterns: insertion of the
+ * triangulated landmarks, random lookups, iteration and erasure of the outliers.
+ */
+
+#include "OpenHashMap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// Value of the size of a Landmark (position, color, a few observations)
+struct LandmarkLike
+{
+  std::array<double, 3> X;
+  std::array<unsigned char, 3> rgb;
+  std::vector<std::uint32_t> observations;
+};
+
+class Chrono
+{
+public:
+  double elapsedMs() const
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+};
+
+template<typename MapT>
+void benchmark(const std::string& name, const std::vector<std::uint32_t>& keys)
+{
+  MapT map;
+  double checksum = 0.0;
+
+  Chrono insertChrono;
+  for(const std::uint32_t key : keys)
+  {
+    LandmarkLike& landmark = map[key];
+    landmark.X = {{double(key), 0.0, 0.0}};
+    landmark.observations.assign(3, key);
+  }
+  const double insertTime = insertChrono.elapsedMs();
+
+  std::vector<std::uint32_t> lookups(keys);
+  std::shuffle(lookups.begin(), lookups.end(), std::mt19937(1));
+  Chrono findChrono;
+  for(const std::uint32_t key : lookups)
+    checksum += map.find(key)->second.X[0];
+  const double findTime = findChrono.elapsedMs();
+
+  Chrono iterateChrono;
+  for(const auto& landmark : map)
+    checksum += landmark.second.observations.size();
+  const double iterateTime = iterateChrono.elapsedMs();
+
+  // remove one landmark in 10, as sfm::RemoveOutliers
+  Chrono eraseChrono;
+  for(auto it = map.begin(); it != map.end();)
+  {
+    if(it->first % 10 == 0)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  const double eraseTime = eraseChrono.elapsedMs();
+
+  std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << insertTime
+            << std::setw(12) << findTime
+            << std::setw(12) << iterateTime
+            << std::setw(12) << eraseTime
+            << "   (" << map.size() << ", " << checksum << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const std::size_t nbLandmarks = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  // landmark ids are increasing, with holes from the rejected tracks
+  std::vector<std::uint32_t> keys;
+  keys.reserve(nbLandmarks);
+  std::mt19937 generator(0);
+  std::uint32_t key = 0;
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+  {
+    key += 1 + generator() % 3;
+    keys.push_back(key);
+  }
+
+  std::cout << "Landmarks: " << nbLandmarks << " (times in ms)" << std::endl;
+  std::cout << std::left << std::setw(22) << "Container" << std::right
+            << std::setw(12) << "insert" << std::setw(12) << "find"
+            << std::setw(12) << "iterate" << std::setw(12) << "erase" << std::endl;
+
+  benchmark<std::map<std::uint32_t, LandmarkLike>>("std::map", keys);
+  benchmark<std::unordered_map<std::uint32_t, LandmarkLike>>("std::unordered_map", keys);
+  benchmark<stl::open_hash_map<std::uint32_t, LandmarkLike>>("stl::open_hash_map", keys);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "OpenHashMap.hpp"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+#define BOOST_TEST_MODULE stlOpenHashMap
+#include <boost/test/included/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(OPEN_HASH_MAP_InsertFindErase)
+{
+  stl::open_hash_map<std::uint32_t, std::string> map;
+  BOOST_CHECK(map.empty());
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK(map.find(3) == map.end());
+  BOOST_CHECK_THROW(map.at(3), std::out_of_range);
+
+  BOOST_CHECK(map.insert(std::make_pair(3u, std::string("three"))).second);
+  BOOST_CHECK(map.emplace(5u, "five").second);
+  map[7] = "seven";
+  BOOST_CHECK(!map.emplace(5u, "other").second);
+
+  BOOST_CHECK_EQUAL(3, map.size());
+  BOOST_CHECK_EQUAL("three", map.at(3));
+  BOOST_CHECK_EQUAL("five", map.find(5)->second);
+  BOOST_CHECK_EQUAL("seven", map[7]);
+  BOOST_CHECK_EQUAL(1, map.count(7));
+  BOOST_CHECK_EQUAL(0, map.count(4));
+
+  BOOST_CHECK_EQUAL(1, map.erase(5));
+  BOOST_CHECK_EQUAL(0, map.erase(5));
+  BOOST_CHECK_EQUAL(2, map.size());
+  BOOST_CHECK(map.find(5) == map.end());
+
+  // the erased slot is reused
+  map[5] = "five again";
+  BOOST_CHECK_EQUAL("five again", map.at(5));
+
+  const stl::open_hash_map<std::uint32_t, std::string> copy(map);
+  BOOST_CHECK(copy == map);
+  map.clear();
+  BOOST_CHECK(map.empty());
+  BOOST_CHECK(copy != map);
+  BOOST_CHECK_EQUAL(3, copy.size());
+}
+
+// Compare with std::map on random insertions and erasures (with rehashes and deleted slots)
+BOOST_AUTO_TEST_CASE(OPEN_HASH_MAP_CompareStdMap)
+{
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<std::uint32_t> keyDistribution(0, 5000);
+
+  stl::open_hash_map<std::uint32_t, std::shared_ptr<int>> map;
+  std::map<std::uint32_t, int> reference;
+
+  for(int i = 0; i < 50000; ++i)
+  {
+    const std::uint32_t key = keyDistribution(generator);
+    if(generator() % 3 == 0)
+    {
+      BOOST_CHECK_EQUAL(reference.erase(key), map.erase(key));
+    }
+    else
+    {
+      reference[key] = i;
+      map[key] = std::make_shared<int>(i);
+    }
+  }
+
+  BOOST_CHECK_EQUAL(reference.size(), map.size());
+  std::size_t nbValues = 0;
+  for(const auto& value : map)
+  {
+    BOOST_CHECK_EQUAL(reference.at(value.first), *value.second);
+    ++nbValues;
+  }
+  BOOST_CHECK_EQUAL(reference.size(), nbValues);
+
+  // erase while iterating
+  for(auto it = map.begin(); it != map.end();)
+  {
+    if(*it->second % 2)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  for(const auto& value : reference)
+    BOOST_CHECK_EQUAL(value.second % 2 == 0, map.count(value.first) == 1);
+}
@@ -0,0 +1,80 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "UnionFind.hpp"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE stlUnionFind
+#include <boost/test/included/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(UNION_FIND_Join)
+{
+  stl::concurrent_union_find<> unionFind(10);
+  BOOST_CHECK_EQUAL(10, unionFind.size());
+
+  for(std::uint32_t i = 0; i < 10; ++i)
+    BOOST_CHECK_EQUAL(i, unionFind.find(i));
+
+  // sets {1, 3, 5, 7, 9} and {2, 4, 6, 8}
+  BOOST_CHECK(unionFind.join(9, 7));
+  BOOST_CHECK(unionFind.join(5, 3));
+  BOOST_CHECK(unionFind.join(7, 5));
+  BOOST_CHECK(unionFind.join(1, 9));
+  BOOST_CHECK(unionFind.join(8, 6));
+  BOOST_CHECK(unionFind.join(2, 4));
+  BOOST_CHECK(unionFind.join(4, 6));
+  BOOST_CHECK(!unionFind.join(3, 1));
+
+  // the root is the smallest index of the set
+  for(std::uint32_t i = 1; i < 10; ++i)
+    BOOST_CHECK_EQUAL(i % 2 ? 1 : 2, unionFind.find(i));
+  BOOST_CHECK_EQUAL(0, unionFind.find(0));
+
+  BOOST_CHECK(unionFind.same_set(3, 9));
+  BOOST_CHECK(!unionFind.same_set(3, 8));
+  BOOST_CHECK(!unionFind.same_set(0, 1));
+}
+
+BOOST_AUTO_TEST_CASE(UNION_FIND_ConcurrentJoin)
+{
+  // random edges between the indexes of the same residue modulo nbSets
+  const std::uint32_t nbElements = 100000;
+  const std::uint32_t nbSets = 7;
+  const std::size_t nbEdges = 400000;
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<std::uint32_t> distribution(0, nbElements / nbSets - 1);
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges(nbEdges);
+  for(std::size_t e = 0; e < nbEdges; ++e)
+  {
+    const std::uint32_t set = static_cast<std::uint32_t>(e % nbSets);
+    edges[e] = std::make_pair(distribution(generator) * nbSets + set, distribution(generator) * nbSets + set);
+  }
+  // make sure each set is connected
+  for(std::uint32_t i = nbSets; i < nbElements; ++i)
+    edges.emplace_back(i - nbSets, i);
+
+  stl::concurrent_union_find<> unionFind(nbElements);
+
+  const std::size_t nbThreads = 8;
+  std::vector<std::thread> threads;
+  for(std::size_t t = 0; t < nbThreads; ++t)
+  {
+    threads.emplace_back([&, t]()
+    {
+      for(std::size_t e = t; e < edges.size(); e += nbThreads)
+        unionFind.join(edges[e].first, edges[e].second);
+    });
+  }
+  for(std::thread& thread : threads)
+    thread.join();
+
+  for(std::uint32_t i = 0; i < nbElements; ++i)
+    BOOST_CHECK_EQUAL(i % nbSets, unionFind.find(i));
+}
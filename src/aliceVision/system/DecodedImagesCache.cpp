@@ -0,0 +1,229 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DecodedImagesCache.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+/// identifies the cache files (and their version)
+const char cacheMagic[8] = {'A', 'V', 'I', 'M', 'C', 'A', 'C', '1'};
+const std::string cacheExtension = ".avcache";
+
+} // namespace
+
+DecodedImagesCache& DecodedImagesCache::get()
+{
+  static DecodedImagesCache cache(
+    std::getenv("ALICEVISION_IMAGE_CACHE") ? std::getenv("ALICEVISION_IMAGE_CACHE") : "",
+    (std::getenv("ALICEVISION_IMAGE_CACHE_SIZE") ? std::strtoul(std::getenv("ALICEVISION_IMAGE_CACHE_SIZE"), nullptr, 10) : 4096)
+      * std::size_t(1024 * 1024));
+  return cache;
+}
+
+DecodedImagesCache::DecodedImagesCache(const std::string& folder, std::size_t maxSize)
+  : _folder(folder)
+  , _maxSize(maxSize)
+{
+  if(_folder.empty())
+    return;
+
+  boost::system::error_code ec;
+  fs::create_directories(_folder, ec);
+  if(!fs::is_directory(_folder))
+  {
+    ALICEVISION_LOG_WARNING("Cannot create the images cache folder '" << _folder << "', the images cache is disabled.");
+    _folder.clear();
+    return;
+  }
+  ALICEVISION_LOG_DEBUG("Images cache: " << _folder << " (" << _maxSize / (1024 * 1024) << " MB)");
+}
+
+std::string DecodedImagesCache::getKey(const std::string& path, int downscale, const std::string& format) const
+{
+  boost::system::error_code ec;
+  const fs::path absolutePath = fs::canonical(path, ec);
+  if(ec)
+    return "";
+  const std::uintmax_t fileSize = fs::file_size(absolutePath, ec);
+  if(ec)
+    return "";
+  const std::time_t lastWrite = fs::last_write_time(absolutePath, ec);
+  if(ec)
+    return "";
+
+  std::stringstream key;
+  key << absolutePath.string() << "|" << fileSize << "|" << lastWrite << "|" << downscale << "|" << format;
+  return key.str();
+}
+
+std::string DecodedImagesCache::getEntryPath(const std::string& key) const
+{
+  std::stringstream filename;
+  filename << std::hex << std::setfill('0') << std::setw(16) << std::hash<std::string>()(key) << cacheExtension;
+  return (fs::path(_folder) / filename.str()).string();
+}
+
+bool DecodedImagesCache::loadBytes(const std::string& path, int downscale, const std::string& format, std::size_t pixelSize,
+                                   int& width, int& height, std::vector<char>& bytes) const
+{
+  if(!isEnabled())
+    return false;
+
+  const std::string key = getKey(path, downscale, format);
+  if(key.empty())
+    return false;
+
+  const std::string entryPath = getEntryPath(key);
+  std::ifstream file(entryPath, std::ios::binary);
+  if(!file.is_open())
+    return false;
+
+  char magic[sizeof(cacheMagic)];
+  std::uint32_t keySize = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+  if(!file || !std::equal(magic, magic + sizeof(magic), cacheMagic) || keySize != key.size())
+    return false;
+
+  // check the key, in case of hash collision
+  std::string entryKey(keySize, '\0');
+  file.read(&entryKey[0], keySize);
+  if(!file || entryKey != key)
+    return false;
+
+  std::int32_t entryWidth = 0;
+  std::int32_t entryHeight = 0;
+  std::uint64_t nbBytes = 0;
+  file.read(reinterpret_cast<char*>(&entryWidth), sizeof(entryWidth));
+  file.read(reinterpret_cast<char*>(&entryHeight), sizeof(entryHeight));
+  file.read(reinterpret_cast<char*>(&nbBytes), sizeof(nbBytes));
+  if(!file || nbBytes % pixelSize != 0)
+    return false;
+
+  bytes.resize(nbBytes);
+  file.read(bytes.data(), nbBytes);
+  if(!file)
+    return false;
+
+  width = entryWidth;
+  height = entryHeight;
+
+  // the modification time is the last use, for the eviction
+  boost::system::error_code ec;
+  fs::last_write_time(entryPath, std::time(nullptr), ec);
+
+  ALICEVISION_LOG_TRACE("Images cache: load '" << path << "' (downscale: " << downscale << ", " << format << ")");
+  return true;
+}
+
+void DecodedImagesCache::store(const std::string& path, int downscale, const std::string& format,
+                               int width, int height, const void* data, std::size_t nbBytes) const
+{
+  if(!isEnabled())
+    return;
+
+  const std::string key = getKey(path, downscale, format);
+  if(key.empty())
+    return;
+
+  const std::size_t entrySize = sizeof(cacheMagic) + sizeof(std::uint32_t) + key.size() +
+                                2 * sizeof(std::int32_t) + sizeof(std::uint64_t) + nbBytes;
+  if(entrySize > _maxSize)
+    return;
+
+  makeRoom(entrySize);
+
+  // write in a temporary file then rename it, so another process never reads a partial entry
+  const std::string entryPath = getEntryPath(key);
+  const std::string tmpPath = entryPath + "." + fs::unique_path().string();
+  {
+    std::ofstream file(tmpPath, std::ios::binary);
+    const std::uint32_t keySize = key.size();
+    const std::int32_t entryWidth = width;
+    const std::int32_t entryHeight = height;
+    const std::uint64_t entryBytes = nbBytes;
+    file.write(cacheMagic, sizeof(cacheMagic));
+    file.write(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+    file.write(key.data(), key.size());
+    file.write(reinterpret_cast<const char*>(&entryWidth), sizeof(entryWidth));
+    file.write(reinterpret_cast<const char*>(&entryHeight), sizeof(entryHeight));
+    file.write(reinterpret_cast<const char*>(&entryBytes), sizeof(entryBytes));
+    file.write(static_cast<const char*>(data), nbBytes);
+    if(!file)
+    {
+      file.close();
+      boost::system::error_code ec;
+      fs::remove(tmpPath, ec);
+      ALICEVISION_LOG_WARNING("Images cache: cannot write '" << tmpPath << "'.");
+      return;
+    }
+  }
+
+  boost::system::error_code ec;
+  fs::rename(tmpPath, entryPath, ec);
+  if(ec)
+    fs::remove(tmpPath, ec);
+}
+
+void DecodedImagesCache::makeRoom(std::size_t nbBytes) const
+{
+  struct Entry
+  {
+    fs::path path;
+    std::time_t lastUse;
+    std::uintmax_t size;
+  };
+
+  std::vector<Entry> entries;
+  std::size_t totalSize = 0;
+  boost::system::error_code ec;
+  for(fs::directory_iterator it(_folder, ec), end; !ec && it != end; it.increment(ec))
+  {
+    if(it->path().extension() != cacheExtension)
+      continue;
+    boost::system::error_code entryEc;
+    const std::uintmax_t size = fs::file_size(it->path(), entryEc);
+    const std::time_t lastUse = fs::last_write_time(it->path(), entryEc);
+    if(entryEc)
+      continue;
+    entries.push_back({it->path(), lastUse, size});
+    totalSize += size;
+  }
+
+  if(totalSize + nbBytes <= _maxSize)
+    return;
+
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+
+  for(const Entry& entry : entries)
+  {
+    if(totalSize + nbBytes <= _maxSize)
+      break;
+    // another process may have removed it
+    if(fs::remove(entry.path, ec))
+      totalSize -= entry.size;
+  }
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,101 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief On-disk cache of the downscaled decoded images, shared by all the processes of a pipeline.
+ *
+ * The cache is enabled by the ALICEVISION_IMAGE_CACHE environment variable (cache folder),
+ * its size is limited by ALICEVISION_IMAGE_CACHE_SIZE (in MB, 4096 by default).
+ * An entry is identified by the source image (path, size and modification time),
+ * the downscale factor and the pixel format, so a modified source image is decoded again.
+ * The least recently used entries are removed when the size limit is reached.
+ */
+class DecodedImagesCache
+{
+public:
+  /**
+   * @brief Get the cache configured by the environment
+   */
+  static DecodedImagesCache& get();
+
+  /**
+   * @param[in] folder The cache folder (empty to disable the cache)
+   * @param[in] maxSize The maximal size of the cache on disk (in bytes)
+   */
+  DecodedImagesCache(const std::string& folder, std::size_t maxSize);
+
+  bool isEnabled() const
+  {
+    return !_folder.empty();
+  }
+
+  /**
+   * @brief Load a decoded image from the cache.
+   * @param[in] path The source image path
+   * @param[in] downscale The downscale factor
+   * @param[in] format The pixel format name (type and channels)
+   * @param[out] width The image width
+   * @param[out] height The image height
+   * @param[out] buffer The image pixels
+   * @return false if the image is not in the cache
+   */
+  template<typename T>
+  bool load(const std::string& path, int downscale, const std::string& format,
+            int& width, int& height, std::vector<T>& buffer) const
+  {
+    std::vector<char> bytes;
+    if(!loadBytes(path, downscale, format, sizeof(T), width, height, bytes))
+      return false;
+    buffer.resize(bytes.size() / sizeof(T));
+    std::copy(bytes.begin(), bytes.end(), reinterpret_cast<char*>(buffer.data()));
+    return true;
+  }
+
+  /**
+   * @brief Store a decoded image in the cache.
+   * @param[in] path The source image path
+   * @param[in] downscale The downscale factor
+   * @param[in] format The pixel format name (type and channels)
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @param[in] data The image pixels
+   * @param[in] nbBytes The size of the image pixels
+   */
+  void store(const std::string& path, int downscale, const std::string& format,
+             int width, int height, const void* data, std::size_t nbBytes) const;
+
+private:
+  bool loadBytes(const std::string& path, int downscale, const std::string& format, std::size_t pixelSize,
+                 int& width, int& height, std::vector<char>& bytes) const;
+
+  /**
+   * @brief Get the key of an entry, empty if the source image doesn't exist
+   */
+  std::string getKey(const std::string& path, int downscale, const std::string& format) const;
+
+  std::string getEntryPath(const std::string& key) const;
+
+  /**
+   * @brief Remove the least recently used entries until nbBytes more fit in the cache
+   */
+  void makeRoom(std::size_t nbBytes) const;
+
+  std::string _folder;
+  std::size_t _maxSize;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,44 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Determinism.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+// not a static member: the data symbols are not exported from the Windows DLLs
+std::atomic<bool> enabled(false);
+
+bool enableFromEnvironment()
+{
+    const char* value = std::getenv("ALICEVISION_DETERMINISTIC");
+    if(value != nullptr && value[0] != '\0' && std::string(value) != "0")
+        Determinism::setEnabled(true);
+    return true;
+}
+
+const bool initialized = enableFromEnvironment();
+
+} // namespace
+
+bool Determinism::isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Determinism::setEnabled(bool isEnabled)
+{
+    enabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,29 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Deterministic mode of the parallel computations, for bit-exact regression runs on all the cores.
+ *
+ * The parallel reductions whose result depends on the thread scheduling (floating-point accumulations,
+ * random sequences per thread, order of insertion) are replaced by ordered merges that reproduce
+ * the order of the serial computation, whatever the number of threads.
+ * It is enabled at startup if the ALICEVISION_DETERMINISTIC environment variable is set.
+ */
+class Determinism
+{
+public:
+    static bool isEnabled();
+
+    static void setEnabled(bool enabled);
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -11,6 +11,9 @@
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/async_frontend.hpp>
+#include <boost/log/sinks/bounded_fifo_queue.hpp>
+#include <boost/log/sinks/block_on_overflow.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
 #include <boost/log/sources/severity_logger.hpp>
 #include <boost/log/sources/record_ostream.hpp>
@@ -20,6 +23,10 @@
 #include <boost/log/expressions/message.hpp>
 #include <boost/log/support/date_time.hpp>
 
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
 #if BOOST_VERSION >= 105600
 #include <boost/core/null_deleter.hpp>
 #elif BOOST_VERSION >= 105500
@@ -31,13 +38,44 @@
 namespace aliceVision {
 namespace system {
 
+namespace {
+
+// most verbose enabled level, checked before creating the records
+// no filtering until the Logger is created, as boost.log
+std::atomic<int> enabledLevel(static_cast<int>(EVerboseLevel::Trace));
+
+// size of the queue of the asynchronous sink (records)
+const std::size_t asyncQueueSize = 4096;
+
+template <class SinkT>
+boost::shared_ptr<SinkT> createSink(const boost::shared_ptr<boost::log::sinks::text_ostream_backend>& backend)
+{
+  namespace expr = boost::log::expressions;
+
+  boost::shared_ptr<SinkT> sink = boost::make_shared<SinkT>(backend);
+
+  sink->reset_formatter();
+
+  // specify format of the log records
+  sink->set_formatter(expr::stream
+         << "[" << expr::format_date_time<boost::posix_time::ptime>("TimeStamp","%H:%M:%S.%f") << "]"
+         << "[" << boost::log::trivial::severity << "]"
+         << " " << expr::smessage);
+
+  return sink;
+}
+
+} // namespace
+
 std::shared_ptr<Logger> Logger::_instance = nullptr;
 
 Logger::Logger()
+  : _core(boost::log::core::get())
 {
-  namespace expr = boost::log::expressions;
   namespace sinks = boost::log::sinks;
-  using sink_t = sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>;
+  using sync_sink_t = sinks::synchronous_sink<sinks::text_ostream_backend>;
+  using async_sink_t = sinks::asynchronous_sink<sinks::text_ostream_backend,
+                                                sinks::bounded_fifo_queue<asyncQueueSize, sinks::block_on_overflow>>;
 
 #if BOOST_VERSION >= 105600
   using boost::null_deleter;
@@ -46,8 +84,6 @@ Logger::Logger()
 #else
   using null_deleter = boost::log::empty_deleter;
 #endif
-  boost::shared_ptr<sink_t> sink;
-
   {
     // create a backend and attach a stream to it
     boost::shared_ptr<sinks::text_ostream_backend> backend = boost::make_shared<sinks::text_ostream_backend>();
@@ -57,20 +93,17 @@ Logger::Logger()
     // enable auto-flushing after each log record written
     backend->auto_flush(true);
 
-    // wrap it into the frontend and register in the core.
-    sink = boost::make_shared<sink_t>(backend);
-  }
+    // wrap it into the frontend: the asynchronous one formats and writes the records in its own thread
+    const char* envAsync = std::getenv("ALICEVISION_LOG_ASYNC");
 
-  sink->reset_formatter();
-
-  // specify format of the log records
-  sink->set_formatter(expr::stream   
-         << "[" << expr::format_date_time<boost::posix_time::ptime>("TimeStamp","%H:%M:%S.%f") << "]"
-         << "[" << boost::log::trivial::severity << "]"
-         << " " << expr::smessage);
+    if(envAsync != NULL && std::strcmp(envAsync, "1") == 0)
+      _sink = createSink<async_sink_t>(backend);
+    else
+      _sink = createSink<sync_sink_t>(backend);
+  }
 
   // register the sink in the logging core
-  boost::log::core::get()->add_sink(sink);
+  _core->add_sink(_sink);
 
   boost::log::add_common_attributes();
 
@@ -82,6 +115,13 @@ Logger::Logger()
     setLogLevel(envLevel);
 }
 
+Logger::~Logger()
+{
+  // write the records still queued by the asynchronous sink
+  _core->remove_sink(_sink);
+  _sink->flush();
+}
+
 std::shared_ptr<Logger> Logger::get()
 {
   if(_instance == nullptr)
@@ -89,6 +129,11 @@ std::shared_ptr<Logger> Logger::get()
   return _instance;
 }
 
+bool Logger::isEnabled(const EVerboseLevel level)
+{
+  return static_cast<int>(level) <= enabledLevel.load(std::memory_order_relaxed);
+}
+
 EVerboseLevel Logger::getDefaultVerboseLevel()
 {
   return EVerboseLevel::Info;
@@ -116,10 +161,16 @@ void Logger::setLogLevel(const std::string& level)
   setLogLevel(EVerboseLevel_stringToEnum(level));
 }
 
-void Logger::setLogLevel(const boost::log::trivial::severity_level level)
+void Logger::flush()
 {
-  boost::log::core::get()->set_filter(boost::log::trivial::severity >= level);
+  _sink->flush();
+}
 
+void Logger::setLogLevel(const boost::log::trivial::severity_level level)
+{
+  // boost severity levels are in the reverse order (trace: 0, fatal: 5)
+  enabledLevel.store(static_cast<int>(boost::log::trivial::fatal) - static_cast<int>(level), std::memory_order_relaxed);
+  _core->set_filter(boost::log::trivial::severity >= level);
 }
 
 } // namespace system
@@ -11,6 +11,9 @@
 
 #define BOOST_LOG_DYN_LINK 1
 #include <boost/log/trivial.hpp>
+#include <boost/log/core/core.hpp>
+#include <boost/log/sinks/sink.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <memory>
 #include <iostream>
@@ -18,11 +21,20 @@
 #define ALICEVISION_COUT(x) std::cout << x << std::endl
 #define ALICEVISION_CERR(x) std::cerr << x << std::endl
 
-#define ALICEVISION_LOG_TRACE_OBJ BOOST_LOG_TRIVIAL(trace)
-#define ALICEVISION_LOG_DEBUG_OBJ BOOST_LOG_TRIVIAL(debug)
-#define ALICEVISION_LOG_INFO_OBJ BOOST_LOG_TRIVIAL(info)
-#define ALICEVISION_LOG_WARNING_OBJ BOOST_LOG_TRIVIAL(warning)
-#define ALICEVISION_LOG_ERROR_OBJ BOOST_LOG_TRIVIAL(error)
+// A log record is only created if its level is compiled in (ALICEVISION_LOG_MAX_LEVEL() of the build configuration)
+// and enabled at runtime (Logger::setLogLevel), otherwise the streamed arguments are not evaluated.
+// (a for statement, as in boost.log, to be safe in an unbraced if/else)
+#define ALICEVISION_LOG_OBJ_IMPL(LEVEL, SEVERITY) \
+  for(bool aliceVisionLogEnabled = ALICEVISION_LOG_MAX_LEVEL() >= static_cast<int>(::aliceVision::system::EVerboseLevel::LEVEL) && \
+                                   ::aliceVision::system::Logger::isEnabled(::aliceVision::system::EVerboseLevel::LEVEL); \
+      aliceVisionLogEnabled; aliceVisionLogEnabled = false) \
+    BOOST_LOG_TRIVIAL(SEVERITY)
+
+#define ALICEVISION_LOG_TRACE_OBJ ALICEVISION_LOG_OBJ_IMPL(Trace, trace)
+#define ALICEVISION_LOG_DEBUG_OBJ ALICEVISION_LOG_OBJ_IMPL(Debug, debug)
+#define ALICEVISION_LOG_INFO_OBJ ALICEVISION_LOG_OBJ_IMPL(Info, info)
+#define ALICEVISION_LOG_WARNING_OBJ ALICEVISION_LOG_OBJ_IMPL(Warning, warning)
+#define ALICEVISION_LOG_ERROR_OBJ ALICEVISION_LOG_OBJ_IMPL(Error, error)
 #define ALICEVISION_LOG_FATAL_OBJ BOOST_LOG_TRIVIAL(fatal)
 #define ALICEVISION_LOG(MODE, ...) MODE << __VA_ARGS__
 
@@ -100,10 +112,27 @@ inline std::istream& operator>>(std::istream& in, EVerboseLevel& verboseLevel)
   return in;
 }
 
+/**
+ * @brief Logger setup: severity filter and output sink of the ALICEVISION_LOG macros.
+ *
+ * The records are written to std::clog by the calling thread. If the ALICEVISION_LOG_ASYNC environment variable
+ * is set to 1, they are pushed to a bounded queue and formatted and written by a dedicated thread instead,
+ * the queue is flushed at the destruction of the logger (the last records are lost if the process crashes).
+ */
 class Logger
 {
 public:
 
+  ~Logger();
+
+  /**
+   * @brief check whether the records of a level are written
+   * @note the records are not filtered until the Logger is created
+   * @param level EVerboseLevel enum
+   * @return true if the level is enabled
+   */
+  static bool isEnabled(const EVerboseLevel level);
+
   /**
    * @brief get Logger instance
    * @return instance
@@ -128,6 +157,11 @@ public:
    */
   void setLogLevel(const std::string& level);
 
+  /**
+   * @brief wait until the pending records are written
+   */
+  void flush();
+
 private:
 
   /**
@@ -142,6 +176,9 @@ private:
   void setLogLevel(const boost::log::trivial::severity_level level);
 
   static std::shared_ptr<Logger> _instance;
+  /// kept alive until the destruction of the logger, after the boost.log singletons
+  boost::log::core_ptr _core;
+  boost::shared_ptr<boost::log::sinks::sink> _sink;
 };
 
 } // namespace system
@@ -0,0 +1,109 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MemoryAccounting.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+struct Counter
+{
+    long long liveBytes = 0;
+    long long peakBytes = 0;
+};
+
+// not a static member: the data symbols are not exported from the Windows DLLs
+std::atomic<bool> enabled(false);
+
+std::mutex& getMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, Counter>& getCounters()
+{
+    static std::map<std::string, Counter> counters;
+    return counters;
+}
+
+bool enableFromEnvironment()
+{
+    const char* value = std::getenv("ALICEVISION_MEMORY_ACCOUNTING");
+    if(value != nullptr && value[0] != '\0' && std::string(value) != "0")
+        MemoryAccounting::setEnabled(true);
+    return true;
+}
+
+const bool initialized = enableFromEnvironment();
+
+} // namespace
+
+bool MemoryAccounting::isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void MemoryAccounting::setEnabled(bool isEnabled)
+{
+    enabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void MemoryAccounting::add(const std::string& subsystem, long long bytes)
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+    Counter& counter = getCounters()[subsystem];
+    counter.liveBytes += bytes;
+    counter.peakBytes = std::max(counter.peakBytes, counter.liveBytes);
+}
+
+std::vector<MemoryAccounting::Subsystem> MemoryAccounting::getSubsystems()
+{
+    std::lock_guard<std::mutex> lock(getMutex());
+    std::vector<Subsystem> subsystems;
+    subsystems.reserve(getCounters().size());
+    for(const auto& counter : getCounters())
+    {
+        Subsystem subsystem;
+        subsystem.name = counter.first;
+        subsystem.liveBytes = static_cast<std::size_t>(std::max(counter.second.liveBytes, 0LL));
+        subsystem.peakBytes = static_cast<std::size_t>(counter.second.peakBytes);
+        subsystems.push_back(subsystem);
+    }
+    return subsystems;
+}
+
+void MemoryAccounting::log()
+{
+    const std::vector<Subsystem> subsystems = getSubsystems();
+    if(subsystems.empty())
+        return;
+
+    std::ostringstream report;
+    report << "Memory accounting (live / peak MB):";
+    for(const Subsystem& subsystem : subsystems)
+    {
+        report << "\n\t- " << std::left << std::setw(32) << subsystem.name << std::right << std::fixed << std::setprecision(1)
+               << std::setw(10) << subsystem.liveBytes / (1024.0 * 1024.0) << " / " << std::setw(10)
+               << subsystem.peakBytes / (1024.0 * 1024.0);
+    }
+    ALICEVISION_LOG_INFO(report.str());
+}
+
+} // namespace system
+} // namespace aliceVision
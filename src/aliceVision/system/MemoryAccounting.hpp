@@ -0,0 +1,89 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Accounting of the memory used by the major data structures, per subsystem
+ *        ("matching.pairwiseMatches", "track.tracks", "sfm.structure", "fuseCut.delaunayGraphCut", "mesh.adjacency"...).
+ *
+ * The structures report their size through MemoryCounter, the accounting keeps the live and the peak bytes
+ * of each subsystem. The sizes are estimated from the containers sizes (elements and nodes), not from the allocator.
+ * It is enabled at startup if the ALICEVISION_MEMORY_ACCOUNTING environment variable is set,
+ * the counters only read a flag otherwise. StageTelemetry reports the counters at the end of the stage.
+ */
+class MemoryAccounting
+{
+public:
+    struct Subsystem
+    {
+        std::string name;
+        std::size_t liveBytes = 0;
+        std::size_t peakBytes = 0;
+    };
+
+    static bool isEnabled();
+
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief Add (or remove if negative) live bytes to a subsystem
+     * @param[in] subsystem The subsystem name
+     * @param[in] bytes The number of bytes
+     */
+    static void add(const std::string& subsystem, long long bytes);
+
+    /// Live and peak bytes of the subsystems, sorted by name
+    static std::vector<Subsystem> getSubsystems();
+
+    /// Log the live and peak bytes of the subsystems
+    static void log();
+};
+
+/**
+ * @brief Bytes of a data structure reported to a subsystem of the MemoryAccounting,
+ *        removed at the destruction of the counter.
+ */
+class MemoryCounter
+{
+public:
+    explicit MemoryCounter(const char* subsystem)
+      : _subsystem(subsystem)
+    {}
+
+    ~MemoryCounter() { set(0); }
+
+    MemoryCounter(const MemoryCounter&) = delete;
+    MemoryCounter& operator=(const MemoryCounter&) = delete;
+
+    /// Set the current size of the data structure
+    void set(std::size_t bytes)
+    {
+        if(bytes == _bytes || !MemoryAccounting::isEnabled())
+            return;
+        MemoryAccounting::add(_subsystem, static_cast<long long>(bytes) - static_cast<long long>(_bytes));
+        _bytes = bytes;
+    }
+
+    std::size_t bytes() const { return _bytes; }
+
+private:
+    const char* _subsystem;
+    std::size_t _bytes = 0;
+};
+
+/// Estimated overhead of a node of a std::map or std::set (color, parent and children)
+constexpr std::size_t mapNodeOverhead = 4 * sizeof(void*);
+
+} // namespace system
+} // namespace aliceVision
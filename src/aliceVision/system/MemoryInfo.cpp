@@ -13,11 +13,16 @@
 
 #if defined(__WINDOWS__)
 #include <windows.h>
+#include <psapi.h>
 #elif defined(__LINUX__)
 #include <sys/sysinfo.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
 #elif defined(__APPLE__)
 #include <sys/types.h>
 #include <sys/sysctl.h>
+#include <sys/resource.h>
 #include <mach/vm_statistics.h>
 #include <mach/mach_types.h>
 #include <mach/mach_init.h>
@@ -46,6 +51,11 @@ MemoryInfo getMemoryInfo()
     // memory.dwAvailPageFile;
     infos.totalSwap = memory.dwTotalVirtual;
     infos.freeSwap = memory.dwAvailVirtual;
+
+    PROCESS_MEMORY_COUNTERS processMemory;
+    const bool hasProcessMemory = GetProcessMemoryInfo(GetCurrentProcess(), &processMemory, sizeof(processMemory));
+    infos.processPeakRss = hasProcessMemory ? processMemory.PeakWorkingSetSize : 0;
+    infos.processRss = hasProcessMemory ? processMemory.WorkingSetSize : 0;
 #elif defined(__LINUX__)
     struct sysinfo sys_info;
     sysinfo(&sys_info);
@@ -56,6 +66,17 @@ MemoryInfo getMemoryInfo()
     // infos.bufferRam = sys_info.bufferram * sys_info.mem_unit;
     infos.totalSwap = sys_info.totalswap * sys_info.mem_unit;
     infos.freeSwap = sys_info.freeswap * sys_info.mem_unit;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    infos.processPeakRss = static_cast<std::size_t>(usage.ru_maxrss) * 1024; // kilobytes
+
+    // resident pages (second field)
+    infos.processRss = 0;
+    std::ifstream statm("/proc/self/statm");
+    std::size_t sizePages = 0, residentPages = 0;
+    if(statm >> sizePages >> residentPages)
+        infos.processRss = residentPages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
 #elif defined(__APPLE__)
     uint64_t physmem;
     size_t len = sizeof physmem;
@@ -90,10 +111,17 @@ MemoryInfo getMemoryInfo()
         // infos.freeRam = infos.totalRam - used;
         infos.freeRam = (int64_t)vm_stat.free_count * (int64_t)page_size;
     }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    infos.processPeakRss = static_cast<std::size_t>(usage.ru_maxrss); // bytes
+    infos.processRss = 0;
 #else
     // TODO: could be done on FreeBSD too
     // see https://github.com/xbmc/xbmc/blob/master/xbmc/linux/XMemUtils.cpp
     infos.totalRam = infos.freeRam = infos.totalSwap = infos.freeSwap = std::numeric_limits<std::size_t>::max();
+    infos.processPeakRss = 0;
+    infos.processRss = 0;
 #endif
 
     return infos;
@@ -106,7 +134,9 @@ std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos)
      << "\t- Total RAM:  " << (infos.totalRam  / convertionGb) << " GB" << std::endl
      << "\t- Free RAM:   " << (infos.freeRam   / convertionGb) << " GB" << std::endl
      << "\t- Total swap: " << (infos.totalSwap / convertionGb) << " GB" << std::endl
-     << "\t- Free swap:  " << (infos.freeSwap  / convertionGb) << " GB" << std::endl;
+     << "\t- Free swap:  " << (infos.freeSwap  / convertionGb) << " GB" << std::endl
+     << "\t- Process RAM: " << (infos.processRss / convertionGb) << " GB" << std::endl
+     << "\t- Process peak RAM: " << (infos.processPeakRss / convertionGb) << " GB" << std::endl;
   return os;
 }
 
@@ -20,6 +20,10 @@ struct MemoryInfo
     //	std::size_t bufferRam;
     std::size_t totalSwap;
     std::size_t freeSwap;
+    /// peak resident memory of the current process
+    std::size_t processPeakRss;
+    /// resident memory of the current process (0 if unknown)
+    std::size_t processRss;
 };
 
 MemoryInfo getMemoryInfo();
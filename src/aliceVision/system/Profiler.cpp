@@ -0,0 +1,201 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__WINDOWS__)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+// not a static member: the data symbols are not exported from the Windows DLLs
+std::atomic<bool> enabled(false);
+
+struct ZoneRecord
+{
+    const char* name;
+    std::int64_t start;
+    std::int64_t end;
+};
+
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(int threadId)
+      : threadId(threadId)
+    {}
+
+    const int threadId;
+    /// only contended while the trace is written
+    std::mutex mutex;
+    std::vector<ZoneRecord> zones;
+};
+
+class ProfilerState
+{
+public:
+    ProfilerState()
+      : _startTime(std::chrono::steady_clock::now())
+    {
+        const char* filepath = std::getenv("ALICEVISION_PROFILING_FILE");
+        if(filepath != nullptr && filepath[0] != '\0')
+        {
+            _filepath = filepath;
+            Profiler::setEnabled(true);
+        }
+    }
+
+    ~ProfilerState()
+    {
+        Profiler::setEnabled(false);
+        if(!_filepath.empty() && !Profiler::writeChromeTrace(_filepath))
+            std::cerr << "Can't write the profiling trace to: " << _filepath << std::endl;
+    }
+
+    std::int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _startTime).count();
+    }
+
+    ThreadBuffer* registerThread()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.emplace_back(new ThreadBuffer(static_cast<int>(_buffers.size())));
+        return _buffers.back().get();
+    }
+
+    std::mutex& mutex() { return _mutex; }
+    const std::vector<std::unique_ptr<ThreadBuffer>>& buffers() const { return _buffers; }
+
+private:
+    const std::chrono::steady_clock::time_point _startTime;
+    std::string _filepath;
+    /// protects the list of buffers, the buffers are kept after the end of their thread
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+};
+
+ProfilerState& getState()
+{
+    static ProfilerState state;
+    return state;
+}
+
+// read the environment variable at startup
+const bool stateInitialized = (getState(), true);
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+void writeJsonString(std::ostream& stream, const char* str)
+{
+    stream << '"';
+    for(; *str != '\0'; ++str)
+    {
+        if(*str == '"' || *str == '\\')
+            stream << '\\';
+        if(static_cast<unsigned char>(*str) >= 0x20)
+            stream << *str;
+    }
+    stream << '"';
+}
+
+} // namespace
+
+bool Profiler::isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setEnabled(bool isEnabled)
+{
+    enabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void Profiler::clear()
+{
+    ProfilerState& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex());
+    for(const auto& buffer : state.buffers())
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->zones.clear();
+    }
+}
+
+bool Profiler::writeChromeTrace(const std::string& filepath)
+{
+    std::ofstream file(filepath);
+    if(!file.is_open())
+        return false;
+
+#if defined(__WINDOWS__)
+    const int pid = _getpid();
+#else
+    const int pid = getpid();
+#endif
+
+    // the trace times are in microseconds
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+    bool first = true;
+    ProfilerState& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex());
+    for(const auto& buffer : state.buffers())
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if(buffer->zones.empty())
+            continue;
+
+        file << (first ? "\n" : ",\n")
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << buffer->threadId
+             << ", \"args\": {\"name\": \"thread " << buffer->threadId << "\"}}";
+        first = false;
+
+        for(const ZoneRecord& zone : buffer->zones)
+        {
+            file << ",\n{\"name\": ";
+            writeJsonString(file, zone.name);
+            file << ", \"cat\": \"aliceVision\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << buffer->threadId
+                 << ", \"ts\": " << zone.start * 1e-3 << ", \"dur\": " << (zone.end - zone.start) * 1e-3 << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
+
+std::int64_t Profiler::now()
+{
+    return getState().now();
+}
+
+void Profiler::addZone(const char* name, std::int64_t start, std::int64_t end)
+{
+    if(threadBuffer == nullptr)
+        threadBuffer = getState().registerThread();
+
+    std::lock_guard<std::mutex> lock(threadBuffer->mutex);
+    threadBuffer->zones.push_back({name, start, end});
+}
+
+} // namespace system
+} // namespace aliceVision
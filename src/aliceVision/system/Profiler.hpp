@@ -0,0 +1,96 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/config.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Scoped profiler.
+ *
+ * The zones are declared with ALICEVISION_PROFILE_ZONE("name") and measure the time until the end
+ * of the enclosing scope. Each thread records its zones in its own buffer, the zones of a thread
+ * are nested by their times.
+ *
+ * The macros are empty if AliceVision is built without ALICEVISION_BUILD_PROFILING.
+ * Otherwise the profiler is enabled at startup if the ALICEVISION_PROFILING_FILE environment variable
+ * is set, and the trace of the process is written to this file at exit.
+ * The trace uses the Chrome trace event format: it can be opened in chrome://tracing or Perfetto,
+ * and converted for Tracy with its import-chrome tool.
+ */
+class Profiler
+{
+public:
+    static bool isEnabled();
+
+    /// Start or stop the recording of the zones in all the threads
+    static void setEnabled(bool enabled);
+
+    /// Remove the recorded zones
+    static void clear();
+
+    /**
+     * @brief Write the recorded zones in the Chrome trace event format (JSON)
+     * @param[in] filepath The output file path
+     * @return false if the file can't be written
+     */
+    static bool writeChromeTrace(const std::string& filepath);
+
+    /// Current time (ns) since the profiler start
+    static std::int64_t now();
+
+    /**
+     * @brief Record a zone in the buffer of the calling thread
+     * @param[in] name The zone name, it must outlive the profiler (string literal)
+     * @param[in] start The zone start time (ns)
+     * @param[in] end The zone end time (ns)
+     */
+    static void addZone(const char* name, std::int64_t start, std::int64_t end);
+};
+
+/**
+ * @brief Profiling zone from its construction to its destruction.
+ * Only reads a flag if the profiler is disabled.
+ */
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+      : _name(Profiler::isEnabled() ? name : nullptr)
+      , _start(_name != nullptr ? Profiler::now() : 0)
+    {}
+
+    ~ProfileZone()
+    {
+        if(_name != nullptr)
+            Profiler::addZone(_name, _start, Profiler::now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* _name;
+    std::int64_t _start;
+};
+
+} // namespace system
+} // namespace aliceVision
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_PROFILING)
+#define ALICEVISION_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ALICEVISION_PROFILE_CONCAT(a, b) ALICEVISION_PROFILE_CONCAT_IMPL(a, b)
+#define ALICEVISION_PROFILE_ZONE(name) \
+    ::aliceVision::system::ProfileZone ALICEVISION_PROFILE_CONCAT(aliceVisionProfileZone_, __LINE__)(name)
+#else
+#define ALICEVISION_PROFILE_ZONE(name)
+#endif
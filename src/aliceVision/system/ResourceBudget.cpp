@@ -0,0 +1,189 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ResourceBudget.hpp"
+#include "MemoryInfo.hpp"
+#include "system.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+/// value of an environment variable in MB, converted in bytes (0 if not set)
+std::size_t getEnvMemory(const char* name)
+{
+  const char* value = std::getenv(name);
+  return value ? std::strtoull(value, nullptr, 10) * std::size_t(1024 * 1024) : 0;
+}
+
+/**
+ * @brief Get the memory limit of the cgroup of the process (job limit of the cluster schedulers)
+ * @return the limit in bytes, 0 if not limited
+ */
+std::size_t getCgroupMemoryLimit()
+{
+#ifdef __LINUX__
+  // cgroup v2, then v1
+  const char* limitFiles[] = {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"};
+  for(const char* limitFile : limitFiles)
+  {
+    std::ifstream file(limitFile);
+    std::string limit;
+    if(!(file >> limit) || limit == "max")
+      continue;
+
+    const std::size_t limitBytes = std::strtoull(limit.c_str(), nullptr, 10);
+    // no limit in cgroup v1 is a huge value
+    if(limitBytes > 0 && limitBytes < getMemoryInfo().totalRam)
+      return limitBytes;
+  }
+#endif
+  return 0;
+}
+
+std::size_t subtractOrZero(std::size_t a, std::size_t b)
+{
+  return (a > b) ? a - b : 0;
+}
+
+} // namespace
+
+ResourceBudget& ResourceBudget::get()
+{
+  static ResourceBudget budget(
+    std::getenv("ALICEVISION_MAX_THREADS") ? std::atoi(std::getenv("ALICEVISION_MAX_THREADS")) : 0,
+    std::getenv("ALICEVISION_MAX_MEMORY") ? getEnvMemory("ALICEVISION_MAX_MEMORY") : getCgroupMemoryLimit(),
+    getEnvMemory("ALICEVISION_MAX_GPU_MEMORY"));
+  return budget;
+}
+
+ResourceBudget::ResourceBudget(int maxThreads, std::size_t maxMemory, std::size_t maxGpuMemory)
+  : _maxThreads(maxThreads)
+  , _maxMemory(maxMemory)
+  , _maxGpuMemory(maxGpuMemory)
+{
+  if(_maxMemory > 0)
+    ALICEVISION_LOG_DEBUG("Resource budget: max memory: " << _maxMemory / (1024 * 1024) << " MB");
+}
+
+void ResourceBudget::setMaxThreads(int maxThreads)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxThreads = maxThreads;
+}
+
+void ResourceBudget::setMaxMemory(std::size_t maxMemory)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxMemory = maxMemory;
+}
+
+void ResourceBudget::setMaxGpuMemory(std::size_t maxGpuMemory)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _maxGpuMemory = maxGpuMemory;
+}
+
+int ResourceBudget::getMaxThreads() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const int nbCores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  return (_maxThreads > 0) ? _maxThreads : nbCores;
+}
+
+std::size_t ResourceBudget::getMaxMemory() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxMemory;
+}
+
+std::size_t ResourceBudget::getMaxGpuMemory() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _maxGpuMemory;
+}
+
+int ResourceBudget::getNbThreads(int requested) const
+{
+  const int maxThreads = getMaxThreads();
+  return (requested > 0) ? std::min(requested, maxThreads) : maxThreads;
+}
+
+std::size_t ResourceBudget::getAvailableMemory() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return getAvailableMemoryLocked();
+}
+
+std::size_t ResourceBudget::getAvailableGpuMemory(std::size_t deviceFreeMemory) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return getAvailableGpuMemoryLocked(deviceFreeMemory);
+}
+
+bool ResourceBudget::reserveMemory(std::size_t nbBytes, bool force)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!force && nbBytes > getAvailableMemoryLocked())
+    return false;
+  _reservedMemory += nbBytes;
+  return true;
+}
+
+void ResourceBudget::releaseMemory(std::size_t nbBytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _reservedMemory = subtractOrZero(_reservedMemory, nbBytes);
+}
+
+bool ResourceBudget::reserveGpuMemory(std::size_t nbBytes, std::size_t deviceFreeMemory, bool force)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!force && nbBytes > getAvailableGpuMemoryLocked(deviceFreeMemory))
+    return false;
+  _reservedGpuMemory += nbBytes;
+  return true;
+}
+
+void ResourceBudget::releaseGpuMemory(std::size_t nbBytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _reservedGpuMemory = subtractOrZero(_reservedGpuMemory, nbBytes);
+}
+
+std::size_t ResourceBudget::getAvailableMemoryLocked() const
+{
+  const MemoryInfo memoryInfo = getMemoryInfo();
+  std::size_t available = memoryInfo.freeRam;
+
+  // the memory already used by the process counts in its budget
+  if(_maxMemory > 0)
+    available = std::min(available, subtractOrZero(_maxMemory, memoryInfo.processRss));
+
+  // the reserved memory may not be allocated yet
+  return subtractOrZero(available, _reservedMemory);
+}
+
+std::size_t ResourceBudget::getAvailableGpuMemoryLocked(std::size_t deviceFreeMemory) const
+{
+  // the reserved memory is allocated on the device, it is already out of the free memory
+  std::size_t available = deviceFreeMemory;
+  if(_maxGpuMemory > 0)
+    available = std::min(available, subtractOrZero(_maxGpuMemory, _reservedGpuMemory));
+  return available;
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,113 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Threads, RAM and GPU memory a process may use, shared by all its stages.
+ *
+ * The stages query the budget before sizing their caches, batches and thread counts,
+ * and reserve the memory of the work they start, so two stages don't count on the same free memory.
+ *
+ * The budget of the process is configured by the environment:
+ * - ALICEVISION_MAX_THREADS: max. number of threads (the number of cores by default)
+ * - ALICEVISION_MAX_MEMORY: max. RAM in MB (the memory limit of the cgroup of the process by default,
+ *   as set by the cluster schedulers for each job)
+ * - ALICEVISION_MAX_GPU_MEMORY: max. GPU memory in MB per device (no limit by default)
+ * and may be overridden by the command line of the software.
+ */
+class ResourceBudget
+{
+public:
+  /**
+   * @brief Get the budget of the process, configured by the environment
+   */
+  static ResourceBudget& get();
+
+  /**
+   * @param[in] maxThreads The max. number of threads (0: the number of cores)
+   * @param[in] maxMemory The max. RAM in bytes (0: no limit other than the free RAM)
+   * @param[in] maxGpuMemory The max. GPU memory per device in bytes (0: no limit other than the free device memory)
+   */
+  ResourceBudget(int maxThreads, std::size_t maxMemory, std::size_t maxGpuMemory);
+
+  void setMaxThreads(int maxThreads);
+  void setMaxMemory(std::size_t maxMemory);
+  void setMaxGpuMemory(std::size_t maxGpuMemory);
+
+  /// The max. number of threads
+  int getMaxThreads() const;
+
+  /// The max. RAM in bytes, 0 if not limited
+  std::size_t getMaxMemory() const;
+
+  /// The max. GPU memory per device in bytes, 0 if not limited
+  std::size_t getMaxGpuMemory() const;
+
+  /**
+   * @brief Get the number of threads of a stage
+   * @param[in] requested The number of threads asked by the user (0 or negative: automatic)
+   * @return The requested number of threads within the budget
+   */
+  int getNbThreads(int requested = 0) const;
+
+  /**
+   * @brief Get the RAM available for new allocations.
+   * The free RAM and the resident memory of the process are read live, so the value follows the memory pressure.
+   * @return The free RAM, within the budget left by the process, minus the reserved memory (0 if unknown)
+   */
+  std::size_t getAvailableMemory() const;
+
+  /**
+   * @brief Get the GPU memory available for new allocations on a device.
+   * @param[in] deviceFreeMemory The free memory of the device in bytes
+   * @return The free memory of the device, within the budget left by the reserved GPU memory
+   */
+  std::size_t getAvailableGpuMemory(std::size_t deviceFreeMemory) const;
+
+  /**
+   * @brief Reserve RAM for the work about to start, if available.
+   * @param[in] nbBytes The memory needed by the work
+   * @param[in] force Reserve even if not available (a stage must progress)
+   * @return false if not available (nothing is reserved)
+   */
+  bool reserveMemory(std::size_t nbBytes, bool force = false);
+
+  /// Release the RAM reserved by reserveMemory, when the work is done
+  void releaseMemory(std::size_t nbBytes);
+
+  /**
+   * @brief Reserve GPU memory for the buffers about to be allocated, if available.
+   * @param[in] nbBytes The memory needed by the buffers
+   * @param[in] deviceFreeMemory The free memory of the device in bytes
+   * @param[in] force Reserve even if not available
+   * @return false if not available (nothing is reserved)
+   */
+  bool reserveGpuMemory(std::size_t nbBytes, std::size_t deviceFreeMemory, bool force = false);
+
+  /// Release the GPU memory reserved by reserveGpuMemory, when the buffers are freed
+  void releaseGpuMemory(std::size_t nbBytes);
+
+private:
+  std::size_t getAvailableMemoryLocked() const;
+  std::size_t getAvailableGpuMemoryLocked(std::size_t deviceFreeMemory) const;
+
+  int _maxThreads;
+  std::size_t _maxMemory;
+  std::size_t _maxGpuMemory;
+  std::size_t _reservedMemory = 0;
+  std::size_t _reservedGpuMemory = 0;
+  mutable std::mutex _mutex;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,292 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TaskScheduler.hpp"
+#include "ResourceBudget.hpp"
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+/// scheduler and queue of the current worker thread
+thread_local const TaskScheduler* currentScheduler = nullptr;
+thread_local std::size_t currentQueue = 0;
+
+} // namespace
+
+TaskScheduler& TaskScheduler::get()
+{
+  static TaskScheduler scheduler(ResourceBudget::get().getMaxThreads());
+  return scheduler;
+}
+
+TaskScheduler::TaskScheduler(int nbThreads)
+{
+  startWorkers(nbThreads);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  stopWorkers();
+}
+
+void TaskScheduler::setNbThreads(int nbThreads)
+{
+  stopWorkers();
+  startWorkers(nbThreads);
+}
+
+void TaskScheduler::setThreadPinning(EThreadPinning pinning)
+{
+  const int nbThreads = getNbThreads();
+  stopWorkers();
+  _threadPinning = pinning;
+  startWorkers(nbThreads);
+}
+
+void TaskScheduler::startWorkers(int nbThreads)
+{
+  if(nbThreads <= 0)
+    nbThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+  // one queue per worker and a last one shared by the other threads
+  _queues.clear();
+  for(int i = 0; i < nbThreads; ++i)
+    _queues.emplace_back(new TaskQueue);
+
+  _stop = false;
+  for(int i = 0; i < nbThreads - 1; ++i)
+    _workers.emplace_back(&TaskScheduler::workerLoop, this, static_cast<std::size_t>(i));
+}
+
+void TaskScheduler::stopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+    _stop = true;
+  }
+  _wakeUp.notify_all();
+
+  for(std::thread& worker : _workers)
+    worker.join();
+  _workers.clear();
+}
+
+void TaskScheduler::workerLoop(std::size_t workerIndex)
+{
+  currentScheduler = this;
+  currentQueue = workerIndex;
+
+  const int cpu = getPinnedCpu(_threadPinning, workerIndex);
+  if(cpu >= 0)
+    pinCurrentThread(cpu);
+
+  while(true)
+  {
+    if(runOneTask())
+      continue;
+
+    std::unique_lock<std::mutex> lock(_sleepMutex);
+    _wakeUp.wait(lock, [this]{ return _stop || _nbQueuedTasks > 0; });
+    if(_stop)
+      return;
+  }
+}
+
+void TaskScheduler::push(Task&& task)
+{
+  TaskQueue& queue = *_queues.at(currentScheduler == this ? currentQueue : _queues.size() - 1);
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+    ++_nbQueuedTasks;
+  }
+  _wakeUp.notify_one();
+}
+
+bool TaskScheduler::runOneTask()
+{
+  if(_nbQueuedTasks == 0)
+    return false;
+
+  const std::size_t nbQueues = _queues.size();
+  const std::size_t self = (currentScheduler == this) ? currentQueue : nbQueues - 1;
+
+  Task task;
+  bool found = false;
+
+  // the last task of its own queue: its data is still in the cache
+  {
+    TaskQueue& queue = *_queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(!queue.tasks.empty())
+    {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      found = true;
+    }
+  }
+
+  // or steal the oldest task of another queue
+  for(std::size_t k = 1; !found && k < nbQueues; ++k)
+  {
+    TaskQueue& queue = *_queues[(self + k) % nbQueues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(!queue.tasks.empty())
+    {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      found = true;
+    }
+  }
+
+  if(!found)
+    return false;
+
+  --_nbQueuedTasks;
+
+  std::exception_ptr exception;
+  try
+  {
+    task.func();
+  }
+  catch(...)
+  {
+    exception = std::current_exception();
+  }
+  task.group->taskDone(exception);
+  return true;
+}
+
+TaskGroup::~TaskGroup()
+{
+  try
+  {
+    wait();
+  }
+  catch(...)
+  {
+    // the exception is lost if wait() has not been called
+  }
+}
+
+void TaskGroup::run(std::function<void()> func)
+{
+  ++_nbRemainingTasks;
+
+  TaskScheduler::Task task;
+  task.func = std::move(func);
+  task.group = this;
+  _scheduler.push(std::move(task));
+}
+
+void TaskGroup::wait()
+{
+  while(_nbRemainingTasks > 0)
+  {
+    // help instead of blocking: nested parallelism doesn't need more threads
+    if(_scheduler.runOneTask())
+      continue;
+
+    // the remaining tasks are running on other threads
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]{ return _nbRemainingTasks == 0; });
+  }
+
+  std::exception_ptr exception;
+  {
+    // the last taskDone() has released the group
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::swap(exception, _exception);
+  }
+  if(exception)
+    std::rethrow_exception(exception);
+}
+
+void TaskGroup::taskDone(std::exception_ptr exception)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(exception && !_exception)
+    _exception = exception;
+  if(--_nbRemainingTasks == 0)
+    _done.notify_all();
+}
+
+void parallelFor(int begin, int end, const std::function<void(int)>& func, int maxParallelism)
+{
+  if(end <= begin)
+    return;
+
+  TaskScheduler& scheduler = TaskScheduler::get();
+
+  int nbTasks = std::min(end - begin, scheduler.getNbThreads());
+  if(maxParallelism > 0)
+    nbTasks = std::min(nbTasks, maxParallelism);
+
+  if(nbTasks <= 1)
+  {
+    for(int i = begin; i < end; ++i)
+      func(i);
+    return;
+  }
+
+  std::atomic<int> nextIndex(begin);
+  std::atomic<bool> failed(false);
+
+  // each task takes the next index until the end, or the first exception
+  const auto body = [&]()
+  {
+    for(int i = nextIndex++; i < end && !failed; i = nextIndex++)
+    {
+      try
+      {
+        func(i);
+      }
+      catch(...)
+      {
+        failed = true;
+        throw;
+      }
+    }
+  };
+
+  TaskGroup group(scheduler);
+  for(int t = 0; t < nbTasks - 1; ++t)
+    group.run(body);
+
+  // the calling thread is the last task
+  std::exception_ptr exception;
+  try
+  {
+    body();
+  }
+  catch(...)
+  {
+    exception = std::current_exception();
+  }
+
+  try
+  {
+    group.wait();
+  }
+  catch(...)
+  {
+    if(!exception)
+      exception = std::current_exception();
+  }
+
+  if(exception)
+    std::rethrow_exception(exception);
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,169 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/numa.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+class TaskGroup;
+
+/**
+ * @brief Work-stealing pool of threads shared by all the parallel algorithms of the library.
+ *
+ * The pool has a single thread budget: (budget - 1) worker threads, the last thread being
+ * the caller waiting for its tasks. Each worker has its own queue of tasks: it runs the last
+ * task it pushed and steals the oldest tasks of the other queues when its queue is empty.
+ *
+ * Nested parallelism is safe: a thread waiting for a TaskGroup runs queued tasks instead
+ * of blocking, so nested parallel loops share the same threads and never oversubscribe
+ * the cores (unlike nested OpenMP parallel regions).
+ *
+ * The budget is the max. number of threads of the ResourceBudget of the process.
+ */
+class TaskScheduler
+{
+public:
+  /**
+   * @brief Get the scheduler of the library
+   */
+  static TaskScheduler& get();
+
+  /**
+   * @param[in] nbThreads The thread budget, including the waiting thread (0: number of cores)
+   */
+  explicit TaskScheduler(int nbThreads = 0);
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  /**
+   * @brief Change the thread budget
+   * @param[in] nbThreads The thread budget, including the waiting thread (0: number of cores)
+   * @note No task must be running.
+   */
+  void setNbThreads(int nbThreads);
+
+  /// Thread budget, including the waiting thread
+  int getNbThreads() const { return static_cast<int>(_queues.size()); }
+
+  /**
+   * @brief Pin the worker threads on the CPUs, e.g. to keep them next to their memory
+   * @param[in] pinning The thread pinning
+   * @note No task must be running.
+   */
+  void setThreadPinning(EThreadPinning pinning);
+
+  EThreadPinning getThreadPinning() const { return _threadPinning; }
+
+private:
+  friend class TaskGroup;
+
+  struct Task
+  {
+    std::function<void()> func;
+    TaskGroup* group = nullptr;
+  };
+
+  struct TaskQueue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void startWorkers(int nbThreads);
+  void stopWorkers();
+  void workerLoop(std::size_t workerIndex);
+
+  /// Queue a task, in the queue of the current worker if any
+  void push(Task&& task);
+
+  /// Run one queued task of the current thread queue or stolen from another queue
+  bool runOneTask();
+
+  std::vector<std::unique_ptr<TaskQueue>> _queues;
+  std::vector<std::thread> _workers;
+
+  std::mutex _sleepMutex;
+  std::condition_variable _wakeUp;
+  std::atomic<std::size_t> _nbQueuedTasks{0};
+  bool _stop = false;
+  EThreadPinning _threadPinning = EThreadPinning::NONE;
+};
+
+/**
+ * @brief Set of tasks run by the TaskScheduler, waited together.
+ *
+ * The first exception thrown by a task is rethrown by wait().
+ */
+class TaskGroup
+{
+public:
+  explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::get())
+    : _scheduler(scheduler)
+  {}
+
+  /// Wait for the tasks still running
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /**
+   * @brief Queue a task
+   * @param[in] func The task function
+   */
+  void run(std::function<void()> func);
+
+  /**
+   * @brief Wait for all the tasks of the group, running queued tasks meanwhile
+   * @throw the first exception thrown by a task
+   */
+  void wait();
+
+private:
+  friend class TaskScheduler;
+
+  void taskDone(std::exception_ptr exception);
+
+  TaskScheduler& _scheduler;
+  std::atomic<std::size_t> _nbRemainingTasks{0};
+  std::mutex _mutex;
+  std::condition_variable _done;
+  std::exception_ptr _exception;
+};
+
+/**
+ * @brief Run func(i) for i in [begin, end) on the TaskScheduler
+ *
+ * The indexes are given one by one to the tasks (dynamic scheduling), so it suits
+ * iterations of uneven durations. Can be called from a task (nested parallel loops).
+ *
+ * @param[in] begin The first index
+ * @param[in] end The index after the last one
+ * @param[in] func The loop body
+ * @param[in] maxParallelism The max. number of indexes run at the same time (0: thread budget),
+ *            e.g. to bound the memory of the iterations
+ * @throw the first exception thrown by func
+ */
+void parallelFor(int begin, int end, const std::function<void(int)>& func, int maxParallelism = 0);
+
+} // namespace system
+} // namespace aliceVision
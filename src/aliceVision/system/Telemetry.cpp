@@ -0,0 +1,162 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Telemetry.hpp"
+
+#include <aliceVision/system/system.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/version.hpp>
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#if defined(__WINDOWS__)
+#include <windows.h>
+#include <process.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+std::string jsonEscape(const std::string& str)
+{
+    std::string escaped;
+    escaped.reserve(str.size());
+    for(const char c : str)
+    {
+        if(c == '"' || c == '\\')
+            escaped += '\\';
+        if(static_cast<unsigned char>(c) >= 0x20)
+            escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+ProcessUsage getProcessUsage()
+{
+    ProcessUsage usage;
+
+#if defined(__WINDOWS__)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if(GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        // 100 ns units
+        const auto toSeconds = [](const FILETIME& time) {
+            return ((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;
+        };
+        usage.cpuTime = toSeconds(kernelTime) + toSeconds(userTime);
+    }
+    IO_COUNTERS ioCounters;
+    if(GetProcessIoCounters(GetCurrentProcess(), &ioCounters))
+    {
+        usage.readBytes = ioCounters.ReadTransferCount;
+        usage.writtenBytes = ioCounters.WriteTransferCount;
+    }
+#else
+    struct rusage resourceUsage;
+    if(getrusage(RUSAGE_SELF, &resourceUsage) == 0)
+    {
+        usage.cpuTime = resourceUsage.ru_utime.tv_sec + resourceUsage.ru_utime.tv_usec * 1e-6 +
+                        resourceUsage.ru_stime.tv_sec + resourceUsage.ru_stime.tv_usec * 1e-6;
+    }
+#endif
+
+#if defined(__LINUX__)
+    std::ifstream ioFile("/proc/self/io");
+    std::string key;
+    std::size_t value;
+    while(ioFile >> key >> value)
+    {
+        if(key == "rchar:")
+            usage.readBytes = value;
+        else if(key == "wchar:")
+            usage.writtenBytes = value;
+    }
+#endif
+
+    return usage;
+}
+
+StageTelemetry::StageTelemetry(const std::string& stageName)
+  : _stageName(stageName)
+{
+    const char* filepath = std::getenv("ALICEVISION_TELEMETRY_FILE");
+    if(filepath != nullptr)
+        _filepath = filepath;
+
+    if(isEnabled())
+        _startUsage = getProcessUsage();
+}
+
+bool StageTelemetry::write() const
+{
+    if(MemoryAccounting::isEnabled())
+        MemoryAccounting::log();
+
+    if(!isEnabled())
+        return true;
+
+    const double wallTime = _timer.elapsed();
+    const ProcessUsage usage = getProcessUsage();
+    const MemoryInfo memoryInfo = getMemoryInfo();
+
+#if defined(__WINDOWS__)
+    const int pid = _getpid();
+#else
+    const int pid = getpid();
+#endif
+
+    std::ostringstream report;
+    report << "{\"stage\": \"" << jsonEscape(_stageName) << "\""
+           << ", \"version\": \"" << ALICEVISION_VERSION_STRING << "\""
+           << ", \"pid\": " << pid
+           << ", \"endTime\": " << std::time(nullptr)
+           << ", \"wallTime\": " << wallTime
+           << ", \"cpuTime\": " << usage.cpuTime - _startUsage.cpuTime
+           << ", \"peakRss\": " << memoryInfo.processPeakRss
+           << ", \"gpuPeakMemory\": " << _gpuPeakMemory
+           << ", \"readBytes\": " << usage.readBytes - _startUsage.readBytes
+           << ", \"writtenBytes\": " << usage.writtenBytes - _startUsage.writtenBytes
+           << ", \"nbItems\": " << _nbItems
+           << ", \"itemsName\": \"" << jsonEscape(_itemsName) << "\""
+           << ", \"itemsPerSecond\": " << ((wallTime > 0.0) ? _nbItems / wallTime : 0.0);
+
+    if(MemoryAccounting::isEnabled())
+    {
+        report << ", \"memory\": {";
+        const std::vector<MemoryAccounting::Subsystem> subsystems = MemoryAccounting::getSubsystems();
+        for(std::size_t i = 0; i < subsystems.size(); ++i)
+        {
+            report << ((i == 0) ? "" : ", ") << "\"" << jsonEscape(subsystems[i].name) << "\": {\"liveBytes\": "
+                   << subsystems[i].liveBytes << ", \"peakBytes\": " << subsystems[i].peakBytes << "}";
+        }
+        report << "}";
+    }
+    report << "}\n";
+
+    // one write per report, so the stages running in parallel can share the file
+    std::ofstream file(_filepath, std::ios::app);
+    if(!file.is_open() || !(file << report.str() << std::flush))
+    {
+        ALICEVISION_LOG_WARNING("Can't write the telemetry report to: " << _filepath);
+        return false;
+    }
+    return true;
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,78 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/Timer.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Resource usage of the current process since its start
+ */
+struct ProcessUsage
+{
+    /// user and system CPU time of all the threads (s)
+    double cpuTime = 0.0;
+    /// bytes read through the read system calls (Linux only)
+    std::size_t readBytes = 0;
+    /// bytes written through the write system calls (Linux only)
+    std::size_t writtenBytes = 0;
+};
+
+ProcessUsage getProcessUsage();
+
+/**
+ * @brief Telemetry of a pipeline stage.
+ *
+ * Measures the wall time, the CPU time and the I/O bytes from its construction to the call of write(),
+ * and the peak RSS of the process, with the live and peak bytes of the subsystems if the MemoryAccounting is enabled.
+ * write() appends the report as one JSON line to the file given by the ALICEVISION_TELEMETRY_FILE
+ * environment variable, nothing is measured nor written if the variable is not set.
+ */
+class StageTelemetry
+{
+public:
+    explicit StageTelemetry(const std::string& stageName);
+
+    bool isEnabled() const { return !_filepath.empty(); }
+
+    /**
+     * @brief Set the number of items processed by the stage, for the items/s rate
+     * @param[in] nbItems The number of items
+     * @param[in] itemsName The kind of items (images, pairs, views...)
+     */
+    void setNbItems(std::size_t nbItems, const std::string& itemsName)
+    {
+        _nbItems = nbItems;
+        _itemsName = itemsName;
+    }
+
+    /// Set the peak of used GPU memory (bytes) for the stages using the GPU
+    void setGpuPeakMemory(std::size_t bytes) { _gpuPeakMemory = bytes; }
+
+    /**
+     * @brief Log the memory accounting (if enabled) and append the report to the telemetry file
+     * @return false if the telemetry is enabled and the file can't be written
+     */
+    bool write() const;
+
+private:
+    std::string _stageName;
+    std::string _filepath;
+    std::string _itemsName = "items";
+    std::size_t _nbItems = 0;
+    std::size_t _gpuPeakMemory = 0;
+    ProcessUsage _startUsage;
+    Timer _timer;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,310 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "numa.hpp"
+#include "system.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __LINUX__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace system {
+
+std::string ENumaMemoryPolicy_informations()
+{
+  return "NUMA placement of the big shared data structures:\n"
+         "* default: on the node of the thread touching them first\n"
+         "* interleave: pages interleaved on all the nodes";
+}
+
+ENumaMemoryPolicy ENumaMemoryPolicy_stringToEnum(const std::string& policy)
+{
+  const std::string p = boost::to_lower_copy(policy);
+
+  if(p == "default")    return ENumaMemoryPolicy::DEFAULT;
+  if(p == "interleave") return ENumaMemoryPolicy::INTERLEAVE;
+
+  throw std::out_of_range("Invalid NUMA memory policy : " + policy);
+}
+
+std::string ENumaMemoryPolicy_enumToString(ENumaMemoryPolicy policy)
+{
+  switch(policy)
+  {
+    case ENumaMemoryPolicy::DEFAULT:    return "default";
+    case ENumaMemoryPolicy::INTERLEAVE: return "interleave";
+  }
+  throw std::out_of_range("Invalid ENumaMemoryPolicy enum");
+}
+
+std::ostream& operator<<(std::ostream& os, ENumaMemoryPolicy policy)
+{
+  return os << ENumaMemoryPolicy_enumToString(policy);
+}
+
+std::istream& operator>>(std::istream& in, ENumaMemoryPolicy& policy)
+{
+  std::string token;
+  in >> token;
+  policy = ENumaMemoryPolicy_stringToEnum(token);
+  return in;
+}
+
+std::string EThreadPinning_informations()
+{
+  return "Pinning of the worker threads on the CPUs:\n"
+         "* none: the OS moves the threads\n"
+         "* compact: fill the CPUs of a NUMA node before the next one\n"
+         "* scatter: spread the threads on the NUMA nodes";
+}
+
+EThreadPinning EThreadPinning_stringToEnum(const std::string& pinning)
+{
+  const std::string p = boost::to_lower_copy(pinning);
+
+  if(p == "none")    return EThreadPinning::NONE;
+  if(p == "compact") return EThreadPinning::COMPACT;
+  if(p == "scatter") return EThreadPinning::SCATTER;
+
+  throw std::out_of_range("Invalid thread pinning : " + pinning);
+}
+
+std::string EThreadPinning_enumToString(EThreadPinning pinning)
+{
+  switch(pinning)
+  {
+    case EThreadPinning::NONE:    return "none";
+    case EThreadPinning::COMPACT: return "compact";
+    case EThreadPinning::SCATTER: return "scatter";
+  }
+  throw std::out_of_range("Invalid EThreadPinning enum");
+}
+
+std::ostream& operator<<(std::ostream& os, EThreadPinning pinning)
+{
+  return os << EThreadPinning_enumToString(pinning);
+}
+
+std::istream& operator>>(std::istream& in, EThreadPinning& pinning)
+{
+  std::string token;
+  in >> token;
+  pinning = EThreadPinning_stringToEnum(token);
+  return in;
+}
+
+namespace {
+
+struct NumaTopology
+{
+  std::vector<int> nodeIds;
+  std::vector<std::vector<int>> nodesCpus;
+};
+
+/// parse a sysfs CPU list, e.g. "0-7,16-23"
+std::vector<int> parseCpuList(const std::string& cpuList)
+{
+  std::vector<int> cpus;
+  std::vector<std::string> ranges;
+  boost::split(ranges, cpuList, boost::is_any_of(","));
+
+  for(std::string range : ranges)
+  {
+    boost::trim(range);
+    if(range.empty())
+      continue;
+
+    const std::size_t dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+    for(int cpu = first; cpu <= last; ++cpu)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+NumaTopology readNumaTopology()
+{
+  NumaTopology topology;
+
+#ifdef __LINUX__
+  try
+  {
+    std::map<int, std::vector<int>> nodes;
+    const fs::path nodesFolder("/sys/devices/system/node");
+
+    if(fs::is_directory(nodesFolder))
+    {
+      for(fs::directory_iterator it(nodesFolder), end; it != end; ++it)
+      {
+        const std::string name = it->path().filename().string();
+        if(name.size() <= 4 || name.compare(0, 4, "node") != 0 || !std::all_of(name.begin() + 4, name.end(), ::isdigit))
+          continue;
+
+        std::ifstream file((it->path() / "cpulist").string());
+        std::string cpuList;
+        if(!std::getline(file, cpuList))
+          continue;
+
+        std::vector<int> cpus = parseCpuList(cpuList);
+        if(!cpus.empty())
+          nodes[std::stoi(name.substr(4))] = std::move(cpus);
+      }
+    }
+
+    for(auto& node : nodes)
+    {
+      topology.nodeIds.push_back(node.first);
+      topology.nodesCpus.push_back(std::move(node.second));
+    }
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Can't read the NUMA topology: " << e.what());
+    topology = NumaTopology();
+  }
+#endif
+
+  if(topology.nodesCpus.empty())
+  {
+    // unknown topology: a single node
+    topology.nodeIds.push_back(0);
+    topology.nodesCpus.emplace_back();
+    for(int cpu = 0; cpu < std::max(1, static_cast<int>(std::thread::hardware_concurrency())); ++cpu)
+      topology.nodesCpus.back().push_back(cpu);
+  }
+  return topology;
+}
+
+const NumaTopology& getNumaTopology()
+{
+  static const NumaTopology topology = readNumaTopology();
+  return topology;
+}
+
+std::atomic<int> numaMemoryPolicy(static_cast<int>(ENumaMemoryPolicy::DEFAULT));
+
+#ifdef __LINUX__
+// from linux/mempolicy.h
+const int mpolDefault = 0;
+const int mpolInterleave = 3;
+
+bool setThreadMemoryPolicy(int mode, const std::vector<int>& nodeIds)
+{
+  const std::size_t bitsPerWord = 8 * sizeof(unsigned long);
+  const int maxNodeId = nodeIds.empty() ? 0 : *std::max_element(nodeIds.begin(), nodeIds.end());
+  std::vector<unsigned long> nodeMask(maxNodeId / bitsPerWord + 1, 0);
+  for(int nodeId : nodeIds)
+    nodeMask[nodeId / bitsPerWord] |= 1ul << (nodeId % bitsPerWord);
+
+  const unsigned long* mask = (mode == mpolDefault) ? nullptr : nodeMask.data();
+  const unsigned long maxNode = (mode == mpolDefault) ? 0 : nodeMask.size() * bitsPerWord + 1;
+  return syscall(SYS_set_mempolicy, mode, mask, maxNode) == 0;
+}
+#endif
+
+} // namespace
+
+const std::vector<std::vector<int>>& getNumaNodesCpus()
+{
+  return getNumaTopology().nodesCpus;
+}
+
+int getPinnedCpu(EThreadPinning pinning, std::size_t threadIndex)
+{
+  const std::vector<std::vector<int>>& nodesCpus = getNumaNodesCpus();
+
+  switch(pinning)
+  {
+    case EThreadPinning::NONE:
+      return -1;
+    case EThreadPinning::COMPACT:
+    {
+      std::size_t nbCpus = 0;
+      for(const auto& cpus : nodesCpus)
+        nbCpus += cpus.size();
+
+      std::size_t index = threadIndex % nbCpus;
+      for(const auto& cpus : nodesCpus)
+      {
+        if(index < cpus.size())
+          return cpus[index];
+        index -= cpus.size();
+      }
+      return -1;
+    }
+    case EThreadPinning::SCATTER:
+    {
+      // thread i on node (i % nbNodes), on the next CPU of this node
+      const std::vector<int>& cpus = nodesCpus.at(threadIndex % nodesCpus.size());
+      return cpus.at((threadIndex / nodesCpus.size()) % cpus.size());
+    }
+  }
+  return -1;
+}
+
+bool pinCurrentThread(int cpu)
+{
+#ifdef __LINUX__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(cpu, &cpuSet);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+  return false;
+#endif
+}
+
+void setNumaMemoryPolicy(ENumaMemoryPolicy policy)
+{
+  numaMemoryPolicy = static_cast<int>(policy);
+
+  if(policy == ENumaMemoryPolicy::INTERLEAVE && getNumaTopology().nodeIds.size() < 2)
+    ALICEVISION_LOG_INFO("Single NUMA node: the interleave memory policy has no effect.");
+}
+
+ENumaMemoryPolicy getNumaMemoryPolicy()
+{
+  return static_cast<ENumaMemoryPolicy>(numaMemoryPolicy.load());
+}
+
+NumaInterleaveScope::NumaInterleaveScope()
+{
+#ifdef __LINUX__
+  const NumaTopology& topology = getNumaTopology();
+  if(getNumaMemoryPolicy() == ENumaMemoryPolicy::INTERLEAVE && topology.nodeIds.size() > 1)
+    _active = setThreadMemoryPolicy(mpolInterleave, topology.nodeIds);
+#endif
+}
+
+NumaInterleaveScope::~NumaInterleaveScope()
+{
+#ifdef __LINUX__
+  if(_active)
+    setThreadMemoryPolicy(mpolDefault, {});
+#endif
+}
+
+} // namespace system
+} // namespace aliceVision
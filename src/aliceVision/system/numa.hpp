@@ -0,0 +1,103 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Placement of the big shared data structures on the NUMA nodes
+ */
+enum class ENumaMemoryPolicy
+{
+  /// the memory is allocated on the node of the thread touching it first
+  DEFAULT = 0,
+  /// the pages of the shared read-mostly data are interleaved on all the nodes (see NumaInterleaveScope)
+  INTERLEAVE
+};
+
+std::string ENumaMemoryPolicy_informations();
+ENumaMemoryPolicy ENumaMemoryPolicy_stringToEnum(const std::string& policy);
+std::string ENumaMemoryPolicy_enumToString(ENumaMemoryPolicy policy);
+std::ostream& operator<<(std::ostream& os, ENumaMemoryPolicy policy);
+std::istream& operator>>(std::istream& in, ENumaMemoryPolicy& policy);
+
+/**
+ * @brief Pinning of the TaskScheduler worker threads on the CPUs
+ */
+enum class EThreadPinning
+{
+  /// the OS moves the threads
+  NONE = 0,
+  /// fill the CPUs of the first NUMA node, then the next one
+  COMPACT,
+  /// spread the threads on the NUMA nodes in round robin
+  SCATTER
+};
+
+std::string EThreadPinning_informations();
+EThreadPinning EThreadPinning_stringToEnum(const std::string& pinning);
+std::string EThreadPinning_enumToString(EThreadPinning pinning);
+std::ostream& operator<<(std::ostream& os, EThreadPinning pinning);
+std::istream& operator>>(std::istream& in, EThreadPinning& pinning);
+
+/**
+ * @brief Get the CPUs of each NUMA node
+ * @return The CPU ids per node (a single node with all the CPUs if the topology is unknown)
+ */
+const std::vector<std::vector<int>>& getNumaNodesCpus();
+
+/**
+ * @brief Get the CPU of a thread for the given pinning
+ * @param[in] pinning The thread pinning
+ * @param[in] threadIndex The thread index
+ * @return The CPU id, -1 if the thread is not pinned
+ */
+int getPinnedCpu(EThreadPinning pinning, std::size_t threadIndex);
+
+/**
+ * @brief Pin the current thread on a CPU
+ * @param[in] cpu The CPU id
+ * @return false if not supported by the platform
+ */
+bool pinCurrentThread(int cpu);
+
+/**
+ * @brief Set the process-wide placement of the big shared data structures
+ * @param[in] policy The NUMA memory policy
+ */
+void setNumaMemoryPolicy(ENumaMemoryPolicy policy);
+
+ENumaMemoryPolicy getNumaMemoryPolicy();
+
+/**
+ * @brief Interleave on the NUMA nodes the pages first touched by the current thread in the scope,
+ *        if the NUMA memory policy is INTERLEAVE and the machine has several nodes.
+ *
+ * To use around the allocation and initialization of big data read by all the threads,
+ * which would be on the node of the initializing thread otherwise.
+ */
+class NumaInterleaveScope
+{
+public:
+  NumaInterleaveScope();
+  ~NumaInterleaveScope();
+
+  NumaInterleaveScope(const NumaInterleaveScope&) = delete;
+  NumaInterleaveScope& operator=(const NumaInterleaveScope&) = delete;
+
+private:
+  bool _active = false;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,251 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CompactTracks.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace aliceVision {
+namespace track {
+
+CompactTracks::CompactTracks(const TracksMap& tracks)
+{
+  // tracks -> observations
+  _trackIds.reserve(tracks.size());
+  _descTypes.reserve(tracks.size());
+  _trackOffsets.reserve(tracks.size() + 1);
+  _trackOffsets.push_back(0);
+
+  std::size_t nbObservations = 0;
+  for(const auto& trackPair : tracks)
+    nbObservations += trackPair.second.featPerView.size();
+  _observations.reserve(nbObservations);
+
+  // TracksMap and FeatureIdPerView are flat maps: tracks ids and view ids are already sorted
+  for(const auto& trackPair : tracks)
+  {
+    _trackIds.push_back(trackPair.first);
+    _descTypes.push_back(trackPair.second.descType);
+    for(const auto& featPair : trackPair.second.featPerView)
+    {
+      Observation observation;
+      observation.viewId = static_cast<IndexT>(featPair.first);
+      observation.featureId = static_cast<IndexT>(featPair.second);
+      _observations.push_back(observation);
+    }
+    _trackOffsets.push_back(static_cast<std::uint32_t>(_observations.size()));
+  }
+
+  // views -> tracks (counting sort by view)
+  for(const Observation& observation : _observations)
+    _viewIds.push_back(observation.viewId);
+  std::sort(_viewIds.begin(), _viewIds.end());
+  _viewIds.erase(std::unique(_viewIds.begin(), _viewIds.end()), _viewIds.end());
+
+  _viewOffsets.assign(_viewIds.size() + 1, 0);
+  for(const Observation& observation : _observations)
+    ++_viewOffsets[getViewIndex(observation.viewId) + 1];
+  for(std::size_t i = 0; i < _viewIds.size(); ++i)
+    _viewOffsets[i + 1] += _viewOffsets[i];
+
+  // fill in increasing track index order, so the tracks of each view are sorted
+  std::vector<std::uint32_t> cursor(_viewOffsets.begin(), _viewOffsets.end() - 1);
+  _viewTracks.resize(_observations.size());
+  for(std::size_t trackIndex = 0; trackIndex < _trackIds.size(); ++trackIndex)
+  {
+    for(const Observation* it = trackBegin(trackIndex); it != trackEnd(trackIndex); ++it)
+      _viewTracks[cursor[getViewIndex(it->viewId)]++] = static_cast<std::uint32_t>(trackIndex);
+  }
+}
+
+std::size_t CompactTracks::getTrackIndex(std::size_t trackId) const
+{
+  const auto it = std::lower_bound(_trackIds.begin(), _trackIds.end(), trackId);
+  if(it == _trackIds.end() || *it != trackId)
+    return _trackIds.size();
+  return std::distance(_trackIds.begin(), it);
+}
+
+std::size_t CompactTracks::getViewIndex(IndexT viewId) const
+{
+  const auto it = std::lower_bound(_viewIds.begin(), _viewIds.end(), viewId);
+  if(it == _viewIds.end() || *it != viewId)
+    return _viewIds.size();
+  return std::distance(_viewIds.begin(), it);
+}
+
+bool CompactTracks::getFeatureId(std::size_t trackIndex, IndexT viewId, IndexT& featureId) const
+{
+  const Observation* begin = trackBegin(trackIndex);
+  const Observation* end = trackEnd(trackIndex);
+  const Observation* it = std::lower_bound(begin, end, viewId,
+    [](const Observation& observation, IndexT v)
+    {
+      return observation.viewId < v;
+    });
+
+  if(it == end || it->viewId != viewId)
+    return false;
+
+  featureId = it->featureId;
+  return true;
+}
+
+bool CompactTracks::getViewTracks(IndexT viewId, const std::uint32_t*& begin, const std::uint32_t*& end) const
+{
+  const std::size_t viewIndex = getViewIndex(viewId);
+  if(viewIndex == _viewIds.size())
+  {
+    begin = end = nullptr;
+    return false;
+  }
+  begin = _viewTracks.data() + _viewOffsets[viewIndex];
+  end = _viewTracks.data() + _viewOffsets[viewIndex + 1];
+  return true;
+}
+
+void CompactTracks::getCommonTrackIndexes(const std::set<std::size_t>& viewIds, std::vector<std::uint32_t>& trackIndexes) const
+{
+  trackIndexes.clear();
+
+  if(viewIds.empty())
+    return;
+
+  const std::uint32_t* begin = nullptr;
+  const std::uint32_t* end = nullptr;
+
+  auto viewIt = viewIds.begin();
+  if(!getViewTracks(static_cast<IndexT>(*viewIt), begin, end))
+    return;
+
+  trackIndexes.assign(begin, end);
+
+  std::vector<std::uint32_t> intersection;
+  for(++viewIt; viewIt != viewIds.end() && !trackIndexes.empty(); ++viewIt)
+  {
+    if(!getViewTracks(static_cast<IndexT>(*viewIt), begin, end))
+    {
+      trackIndexes.clear();
+      return;
+    }
+    intersection.clear();
+    std::set_intersection(trackIndexes.begin(), trackIndexes.end(), begin, end, std::back_inserter(intersection));
+    trackIndexes.swap(intersection);
+  }
+}
+
+void CompactTracks::exportToTracksMap(TracksMap& tracks) const
+{
+  tracks.clear();
+  tracks.reserve(_trackIds.size());
+
+  for(std::size_t trackIndex = 0; trackIndex < _trackIds.size(); ++trackIndex)
+  {
+    Track& track = tracks[_trackIds[trackIndex]];
+    track.descType = _descTypes[trackIndex];
+    track.featPerView.reserve(getTrackLength(trackIndex));
+    for(const Observation* it = trackBegin(trackIndex); it != trackEnd(trackIndex); ++it)
+      track.featPerView.insert(track.featPerView.end(), std::make_pair(static_cast<std::size_t>(it->viewId), static_cast<std::size_t>(it->featureId)));
+  }
+}
+
+void CompactTracks::exportToTracksPerView(TracksPerView& tracksPerView) const
+{
+  tracksPerView.clear();
+  tracksPerView.reserve(_viewIds.size());
+
+  for(std::size_t viewIndex = 0; viewIndex < _viewIds.size(); ++viewIndex)
+  {
+    TrackIdSet& trackIds = tracksPerView[_viewIds[viewIndex]];
+    trackIds.reserve(_viewOffsets[viewIndex + 1] - _viewOffsets[viewIndex]);
+    for(std::uint32_t i = _viewOffsets[viewIndex]; i < _viewOffsets[viewIndex + 1]; ++i)
+      trackIds.push_back(_trackIds[_viewTracks[i]]);
+  }
+}
+
+namespace tracksUtilsMap {
+
+void getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
+                             const CompactTracks& tracks,
+                             std::set<std::size_t>& visibleTracks)
+{
+  assert(!imageIndexes.empty());
+  visibleTracks.clear();
+
+  std::vector<std::uint32_t> trackIndexes;
+  tracks.getCommonTrackIndexes(imageIndexes, trackIndexes);
+
+  for(const std::uint32_t trackIndex : trackIndexes)
+    visibleTracks.insert(visibleTracks.end(), tracks.getTrackId(trackIndex));
+}
+
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const CompactTracks& tracks,
+                                 TracksMap& tracksOut)
+{
+  assert(!imageIndexes.empty());
+  tracksOut.clear();
+
+  std::vector<std::uint32_t> trackIndexes;
+  tracks.getCommonTrackIndexes(imageIndexes, trackIndexes);
+  tracksOut.reserve(trackIndexes.size());
+
+  for(const std::uint32_t trackIndex : trackIndexes)
+  {
+    Track& track = tracksOut[tracks.getTrackId(trackIndex)];
+    track.descType = tracks.getDescType(trackIndex);
+    track.featPerView.reserve(imageIndexes.size());
+
+    for(const std::size_t viewId : imageIndexes)
+    {
+      IndexT featureId = UndefinedIndexT;
+      tracks.getFeatureId(trackIndex, static_cast<IndexT>(viewId), featureId);
+      track.featPerView.insert(track.featPerView.end(), std::make_pair(viewId, static_cast<std::size_t>(featureId)));
+    }
+  }
+  return !tracksOut.empty();
+}
+
+void getTracksInImagesFast(const std::set<IndexT>& imagesId,
+                           const CompactTracks& tracks,
+                           std::set<IndexT>& tracksIds)
+{
+  for(const IndexT viewId : imagesId)
+  {
+    const std::uint32_t* begin = nullptr;
+    const std::uint32_t* end = nullptr;
+    if(!tracks.getViewTracks(viewId, begin, end))
+      continue;
+    for(const std::uint32_t* it = begin; it != end; ++it)
+      tracksIds.insert(static_cast<IndexT>(tracks.getTrackId(*it)));
+  }
+}
+
+bool getFeatureIdInViewPerTrack(const CompactTracks& tracks,
+                                const std::set<std::size_t>& trackIds,
+                                IndexT viewId,
+                                std::vector<FeatureId>* out_featId)
+{
+  for(const std::size_t trackId : trackIds)
+  {
+    const std::size_t trackIndex = tracks.getTrackIndex(trackId);
+
+    // ignore it if the track doesn't exist
+    if(trackIndex == tracks.nbTracks())
+      continue;
+
+    IndexT featureId;
+    if(tracks.getFeatureId(trackIndex, viewId, featureId))
+      out_featId->emplace_back(tracks.getDescType(trackIndex), featureId);
+  }
+  return !out_featId->empty();
+}
+
+} // namespace tracksUtilsMap
+} // namespace track
+} // namespace aliceVision
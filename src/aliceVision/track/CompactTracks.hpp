@@ -0,0 +1,179 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/track/Track.hpp>
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Immutable, compact storage of a set of tracks (CSR layout).
+ *
+ * - tracks -> (viewId, featureId): the observations of all the tracks are stored in one
+ *   flat array, sorted by viewId inside each track.
+ * - views -> tracks: the track indexes visible in each view are stored in one flat array,
+ *   sorted by track index inside each view.
+ *
+ * Tracks are addressed by their position in the store (track index), the original
+ * track ids are kept sorted, so track indexes and track ids have the same order.
+ */
+class CompactTracks
+{
+public:
+
+  /// Observation of a track in a view
+  struct Observation
+  {
+    IndexT viewId;
+    IndexT featureId;
+  };
+
+  CompactTracks() = default;
+
+  /**
+   * @brief Build the compact tracks from a TracksMap
+   * @param[in] tracks The tracks
+   */
+  explicit CompactTracks(const TracksMap& tracks);
+
+  /// Return the number of tracks
+  std::size_t nbTracks() const { return _trackIds.size(); }
+
+  /// Return the number of views with at least one track
+  std::size_t nbViews() const { return _viewIds.size(); }
+
+  /// Return the track id of the given track index
+  std::size_t getTrackId(std::size_t trackIndex) const { return _trackIds[trackIndex]; }
+
+  /// Return the track index of a track id (or nbTracks() if it doesn't exist)
+  std::size_t getTrackIndex(std::size_t trackId) const;
+
+  /// Return the describer type of the given track index
+  feature::EImageDescriberType getDescType(std::size_t trackIndex) const { return _descTypes[trackIndex]; }
+
+  /// Return the length of the given track index
+  std::size_t getTrackLength(std::size_t trackIndex) const
+  {
+    return _trackOffsets[trackIndex + 1] - _trackOffsets[trackIndex];
+  }
+
+  /// Observations of the given track index, sorted by viewId
+  const Observation* trackBegin(std::size_t trackIndex) const { return _observations.data() + _trackOffsets[trackIndex]; }
+  const Observation* trackEnd(std::size_t trackIndex) const { return _observations.data() + _trackOffsets[trackIndex + 1]; }
+
+  /**
+   * @brief Get the feature id of a track in a view.
+   * @param[in] trackIndex The track index
+   * @param[in] viewId The view id
+   * @param[out] featureId The feature id
+   * @return false if the track is not visible in the view
+   */
+  bool getFeatureId(std::size_t trackIndex, IndexT viewId, IndexT& featureId) const;
+
+  /**
+   * @brief Get the sorted track indexes visible in a view.
+   * @param[in] viewId The view id
+   * @param[out] begin First track index
+   * @param[out] end Past the end track index
+   * @return false if the view has no track
+   */
+  bool getViewTracks(IndexT viewId, const std::uint32_t*& begin, const std::uint32_t*& end) const;
+
+  /**
+   * @brief Compute the track indexes visible in all the given views (sorted intersection).
+   * @param[in] viewIds The views
+   * @param[out] trackIndexes The common track indexes (sorted)
+   */
+  void getCommonTrackIndexes(const std::set<std::size_t>& viewIds, std::vector<std::uint32_t>& trackIndexes) const;
+
+  /**
+   * @brief Export the compact tracks as a TracksMap
+   * @param[out] tracks The tracks
+   */
+  void exportToTracksMap(TracksMap& tracks) const;
+
+  /**
+   * @brief Export the view to track ids table as a TracksPerView
+   * @param[out] tracksPerView The track ids per view
+   */
+  void exportToTracksPerView(TracksPerView& tracksPerView) const;
+
+private:
+  /// Return the position of a view in _viewIds (or nbViews() if it doesn't exist)
+  std::size_t getViewIndex(IndexT viewId) const;
+
+  /// Sorted track ids (one per track index)
+  std::vector<std::size_t> _trackIds;
+  /// Describer type per track index
+  std::vector<feature::EImageDescriberType> _descTypes;
+  /// Offsets of the tracks in _observations (size: nbTracks + 1)
+  std::vector<std::uint32_t> _trackOffsets;
+  /// Observations of all the tracks
+  std::vector<Observation> _observations;
+
+  /// Sorted view ids
+  std::vector<IndexT> _viewIds;
+  /// Offsets of the views in _viewTracks (size: nbViews + 1)
+  std::vector<std::uint32_t> _viewOffsets;
+  /// Track indexes visible in each view
+  std::vector<std::uint32_t> _viewTracks;
+};
+
+namespace tracksUtilsMap {
+
+/**
+ * @brief Find common tracks among a set of images.
+ * @param[in] imageIndexes: set of images we are looking for common tracks.
+ * @param[in] tracks: all the tracks of the scene.
+ * @param[out] visibleTracks: output with only the common track ids.
+ */
+void getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
+                             const CompactTracks& tracks,
+                             std::set<std::size_t>& visibleTracks);
+
+/**
+ * @brief Find common tracks among images.
+ * @param[in] imageIndexes: set of images we are looking for common tracks.
+ * @param[in] tracks: all the tracks of the scene.
+ * @param[out] tracksOut: output with only the common tracks.
+ */
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const CompactTracks& tracks,
+                                 TracksMap& tracksOut);
+
+/**
+ * @brief Find all the visible tracks from a set of images.
+ * @param[in] imagesId set of images we are looking for tracks.
+ * @param[in] tracks all the tracks of the scene.
+ * @param[out] tracksIds the track ids in the images
+ */
+void getTracksInImagesFast(const std::set<IndexT>& imagesId,
+                           const CompactTracks& tracks,
+                           std::set<IndexT>& tracksIds);
+
+/**
+ * @brief Get feature id (with associated describer type) in the specified view for each TrackId
+ * @param[in] tracks all the tracks of the scene.
+ * @param[in] trackIds
+ * @param[in] viewId
+ * @param[out] out_featId
+ * @return
+ */
+bool getFeatureIdInViewPerTrack(const CompactTracks& tracks,
+                                const std::set<std::size_t>& trackIds,
+                                IndexT viewId,
+                                std::vector<FeatureId>* out_featId);
+
+} // namespace tracksUtilsMap
+} // namespace track
+} // namespace aliceVision
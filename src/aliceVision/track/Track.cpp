@@ -7,133 +7,283 @@
 
 #include "Track.hpp"
 
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
 namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
 void TracksBuilder::build(const PairwiseMatches& pairwiseMatches)
 {
-  typedef std::set<IndexedFeaturePair> SetIndexedPair;
-
-  // set of all features of all images: (imageIndex, featureIndex)
-  SetIndexedPair allFeatures;
+  build([&pairwiseMatches](const MatchesFileReader::PairVisitor& visitor)
+  {
+    for(const auto& matchesPerDescIt: pairwiseMatches)
+      visitor(matchesPerDescIt.first, matchesPerDescIt.second);
+  });
+}
 
-  // for each couple of images make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+void TracksBuilder::build(const std::vector<const MatchesFileReader*>& matchesReaders,
+                          const std::set<IndexT>& viewsKeysFilter,
+                          const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                          int maxNbMatches)
+{
+  build([&](const MatchesFileReader::PairVisitor& visitor)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    for(const MatchesFileReader* reader : matchesReaders)
+      reader->visitPairs(visitor, viewsKeysFilter, descTypesFilter, maxNbMatches);
+  });
+}
+
+void TracksBuilder::build(const std::function<void(const MatchesFileReader::PairVisitor&)>& visitPairs)
+{
+  typedef std::pair<std::size_t, feature::EImageDescriberType> ViewDesc;
 
+  // first pass: number of features referenced for each view and describer type
+  std::map<ViewDesc, std::size_t> nbFeaturesPerViewDesc;
+
+  visitPairs([&nbFeaturesPerViewDesc](const Pair& pair, const MatchesPerDescType& matchesPerDesc)
+  {
     for(const auto& matchesIt: matchesPerDesc)
     {
       const feature::EImageDescriberType descType = matchesIt.first;
       const IndMatches& matches = matchesIt.second;
-      // we have correspondences between I and J image index.
+
+      if(matches.empty())
+        continue;
+
+      std::size_t maxI = 0;
+      std::size_t maxJ = 0;
       for(const IndMatch& m: matches)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        allFeatures.insert(pairI);
-        allFeatures.insert(pairJ);
+        maxI = std::max(maxI, static_cast<std::size_t>(m._i));
+        maxJ = std::max(maxJ, static_cast<std::size_t>(m._j));
       }
+
+      std::size_t& nbFeaturesI = nbFeaturesPerViewDesc[ViewDesc(pair.first, descType)];
+      nbFeaturesI = std::max(nbFeaturesI, maxI + 1);
+      std::size_t& nbFeaturesJ = nbFeaturesPerViewDesc[ViewDesc(pair.second, descType)];
+      nbFeaturesJ = std::max(nbFeaturesJ, maxJ + 1);
     }
-  }
+  });
 
-  // build the node indirection for each referenced feature
-  MapIndexToNode map_indexToNode;
-  map_indexToNode.reserve(allFeatures.size());
-  _map_nodeToIndex.reserve(allFeatures.size());
+  // build the dense index ranges, in (viewId, descType) order
+  _ranges.clear();
+  _ranges.reserve(nbFeaturesPerViewDesc.size());
 
-  for(const IndexedFeaturePair& featPair: allFeatures)
+  std::size_t nbNodes = 0;
+  for(const auto& viewDescIt : nbFeaturesPerViewDesc)
   {
-    lemon::ListDigraph::Node node = _graph.addNode();
-    map_indexToNode.insert(std::make_pair(featPair, node));
-    _map_nodeToIndex.insert(std::make_pair(node, featPair));
+    ViewDescRange range;
+    range.viewId = viewDescIt.first.first;
+    range.descType = viewDescIt.first.second;
+    range.offset = static_cast<NodeIndex>(nbNodes);
+    range.count = static_cast<NodeIndex>(viewDescIt.second);
+    _ranges.push_back(range);
+    nbNodes += viewDescIt.second;
   }
 
-  // add the element of myset to the UnionFind insert method.
-  _index = std::unique_ptr<IndexMap>( new IndexMap(_graph) );
-  _tracksUF = std::unique_ptr<UnionFindObject>(new UnionFindObject(*_index));
+  if(nbNodes >= std::numeric_limits<NodeIndex>::max())
+    throw std::runtime_error("Too many features to build tracks (" + std::to_string(nbNodes) + ").");
 
-  for(ListDigraph::NodeIt it(_graph); it != INVALID; ++it)
-  {
-    _tracksUF->insert(it);
-  }
+  _parent.resize(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    _parent[i] = static_cast<NodeIndex>(i);
+  _setSize.assign(nbNodes, 1);
+  _isUsed.assign(nbNodes, false);
 
-  // make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  // second pass: make the union according the pair matches
+  visitPairs([this](const Pair& pair, const MatchesPerDescType& matchesPerDesc)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
-
     for(const auto& matchesIt: matchesPerDesc)
     {
       const feature::EImageDescriberType descType = matchesIt.first;
       const IndMatches& matches = matchesIt.second;
+
+      if(matches.empty())
+        continue;
+
+      const NodeIndex offsetI = getNode(pair.first, descType, 0);
+      const NodeIndex offsetJ = getNode(pair.second, descType, 0);
+
       // we have correspondences between I and J image index.
       for(const IndMatch& m: matches)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        _tracksUF->join(map_indexToNode[pairI], map_indexToNode[pairJ]);
+        const NodeIndex nodeI = offsetI + m._i;
+        const NodeIndex nodeJ = offsetJ + m._j;
+        _isUsed[nodeI] = true;
+        _isUsed[nodeJ] = true;
+        join(nodeI, nodeJ);
       }
     }
+  });
+}
+
+TracksBuilder::NodeIndex TracksBuilder::getNode(std::size_t viewId, feature::EImageDescriberType descType, std::size_t featIndex) const
+{
+  const auto it = std::lower_bound(_ranges.begin(), _ranges.end(), std::make_pair(viewId, descType),
+    [](const ViewDescRange& range, const std::pair<std::size_t, feature::EImageDescriberType>& viewDesc)
+    {
+      return (range.viewId < viewDesc.first) || (range.viewId == viewDesc.first && range.descType < viewDesc.second);
+    });
+
+  assert(it != _ranges.end() && it->viewId == viewId && it->descType == descType);
+  assert(featIndex < it->count || (featIndex == 0));
+  return it->offset + static_cast<NodeIndex>(featIndex);
+}
+
+TracksBuilder::IndexedFeaturePair TracksBuilder::getFeature(NodeIndex node) const
+{
+  // last range with offset <= node
+  const auto it = std::upper_bound(_ranges.begin(), _ranges.end(), node,
+    [](NodeIndex n, const ViewDescRange& range)
+    {
+      return n < range.offset;
+    }) - 1;
+
+  return IndexedFeaturePair(it->viewId, KeypointId(it->descType, node - it->offset));
+}
+
+TracksBuilder::NodeIndex TracksBuilder::find(NodeIndex node) const
+{
+  while(_parent[node] != node)
+  {
+    _parent[node] = _parent[_parent[node]];
+    node = _parent[node];
+  }
+  return node;
+}
+
+void TracksBuilder::join(NodeIndex a, NodeIndex b)
+{
+  NodeIndex rootA = find(a);
+  NodeIndex rootB = find(b);
+
+  if(rootA == rootB)
+    return;
+
+  if(_setSize[rootA] < _setSize[rootB])
+    std::swap(rootA, rootB);
+
+  _parent[rootB] = rootA;
+  _setSize[rootA] += _setSize[rootB];
+}
+
+void TracksBuilder::computeTracksNodes(std::vector<NodeIndex>& trackOffsets, std::vector<NodeIndex>& trackNodes) const
+{
+  const std::size_t nbNodes = _parent.size();
+  const NodeIndex undefined = std::numeric_limits<NodeIndex>::max();
+
+  // track index of each root, tracks are numbered by their first node
+  std::vector<NodeIndex> trackPerRoot(nbNodes, undefined);
+  std::vector<NodeIndex> nodeTrack(nbNodes, undefined);
+  std::vector<NodeIndex> trackSizes;
+
+  for(std::size_t node = 0; node < nbNodes; ++node)
+  {
+    if(!_isUsed[node])
+      continue;
+
+    const NodeIndex root = find(static_cast<NodeIndex>(node));
+    if(trackPerRoot[root] == undefined)
+    {
+      trackPerRoot[root] = static_cast<NodeIndex>(trackSizes.size());
+      trackSizes.push_back(0);
+    }
+    nodeTrack[node] = trackPerRoot[root];
+    ++trackSizes[trackPerRoot[root]];
+  }
+
+  trackOffsets.resize(trackSizes.size() + 1);
+  trackOffsets[0] = 0;
+  for(std::size_t i = 0; i < trackSizes.size(); ++i)
+    trackOffsets[i + 1] = trackOffsets[i] + trackSizes[i];
+
+  // fill in increasing node order, so the nodes of each track are sorted
+  std::vector<NodeIndex> cursor(trackOffsets.begin(), trackOffsets.end() - 1);
+  trackNodes.resize(trackOffsets.back());
+  for(std::size_t node = 0; node < nbNodes; ++node)
+  {
+    if(nodeTrack[node] != undefined)
+      trackNodes[cursor[nodeTrack[node]]++] = static_cast<NodeIndex>(node);
   }
 }
 
+std::size_t TracksBuilder::nbTracks() const
+{
+  std::size_t cpt = 0;
+  for(std::size_t node = 0; node < _parent.size(); ++node)
+  {
+    if(_isUsed[node] && _parent[node] == node)
+      ++cpt;
+  }
+  return cpt;
+}
+
 void TracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
 {
   // remove bad tracks:
   // - track that are too short,
   // - track with id conflicts (many times the same image index)
 
-  std::set<int> set_classToErase;
+  std::vector<NodeIndex> trackOffsets;
+  std::vector<NodeIndex> trackNodes;
+  computeTracksNodes(trackOffsets, trackNodes);
 
-#pragma omp parallel if(multithreaded)
-  for(lemon::UnionFindEnum<IndexMap>::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  const std::ptrdiff_t nbTracks = static_cast<std::ptrdiff_t>(trackOffsets.size()) - 1;
+  std::vector<char> isTrackToErase(std::max(nbTracks, std::ptrdiff_t(0)), 0);
+
+  #pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t t = 0; t < nbTracks; ++t)
   {
+    const std::size_t trackLength = trackOffsets[t + 1] - trackOffsets[t];
 
-#pragma omp single nowait
+    if(trackLength < minTrackLength)
     {
-      std::size_t cpt = 0;
-      std::set<std::size_t> myset;
-      for(lemon::UnionFindEnum<IndexMap>::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-      {
-        myset.insert(_map_nodeToIndex[iit].first);
-        ++cpt;
-      }
-      if(myset.size() != cpt || myset.size() < minTrackLength)
+      isTrackToErase[t] = 1;
+      continue;
+    }
+
+    // nodes are sorted by viewId in the track, so a conflict is between consecutive nodes
+    std::size_t previousViewId = getFeature(trackNodes[trackOffsets[t]]).first;
+    for(std::size_t i = trackOffsets[t] + 1; i < trackOffsets[t + 1]; ++i)
+    {
+      const std::size_t viewId = getFeature(trackNodes[i]).first;
+      if(viewId == previousViewId)
       {
-#pragma omp critical
-        set_classToErase.insert(cit.operator int());
+        isTrackToErase[t] = 1;
+        break;
       }
+      previousViewId = viewId;
     }
   }
 
-  std::for_each(set_classToErase.begin(), set_classToErase.end(),
-    std::bind1st(std::mem_fun(&UnionFindObject::eraseClass), _tracksUF.get()));
+  for(std::ptrdiff_t t = 0; t < nbTracks; ++t)
+  {
+    if(!isTrackToErase[t])
+      continue;
+    for(std::size_t i = trackOffsets[t]; i < trackOffsets[t + 1]; ++i)
+      _isUsed[trackNodes[i]] = false;
+  }
 }
 
 bool TracksBuilder::exportToStream(std::ostream& os)
 {
-  std::size_t cpt = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  std::vector<NodeIndex> trackOffsets;
+  std::vector<NodeIndex> trackNodes;
+  computeTracksNodes(trackOffsets, trackNodes);
+
+  for(std::size_t t = 0; t + 1 < trackOffsets.size(); ++t)
   {
-    os << "Class: " << cpt++ << std::endl;
-    std::size_t cptTrackLength = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-    {
-      ++cptTrackLength;
-    }
-    os << "\t" << "track length: " << cptTrackLength << std::endl;
+    os << "Class: " << t << std::endl;
+    os << "\t" << "track length: " << (trackOffsets[t + 1] - trackOffsets[t]) << std::endl;
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::size_t i = trackOffsets[t]; i < trackOffsets[t + 1]; ++i)
     {
-      os << _map_nodeToIndex[ iit ].first << "  " << _map_nodeToIndex[ iit ].second << std::endl;
+      const IndexedFeaturePair feature = getFeature(trackNodes[i]);
+      os << feature.first << "  " << feature.second << std::endl;
     }
   }
   return os.good();
@@ -143,17 +293,23 @@ void TracksBuilder::exportToSTL(TracksMap& allTracks) const
 {
   allTracks.clear();
 
-  std::size_t trackIndex = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit, ++trackIndex)
+  std::vector<NodeIndex> trackOffsets;
+  std::vector<NodeIndex> trackNodes;
+  computeTracksNodes(trackOffsets, trackNodes);
+
+  allTracks.reserve(trackOffsets.size() - 1);
+
+  for(std::size_t trackIndex = 0; trackIndex + 1 < trackOffsets.size(); ++trackIndex)
   {
     // create the output track
     std::pair<TracksMap::iterator, bool> ret = allTracks.insert(std::make_pair(trackIndex, Track()));
 
     Track& outTrack = ret.first->second;
+    outTrack.featPerView.reserve(trackOffsets[trackIndex + 1] - trackOffsets[trackIndex]);
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::size_t i = trackOffsets[trackIndex]; i < trackOffsets[trackIndex + 1]; ++i)
     {
-      const IndexedFeaturePair & currentPair = _map_nodeToIndex.at(iit);
+      const IndexedFeaturePair currentPair = getFeature(trackNodes[i]);
       // all descType inside the track will be the same
       outTrack.descType = currentPair.second.descType;
       outTrack.featPerView[currentPair.first] = currentPair.second.featIndex;
@@ -10,13 +10,12 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/matching/io.hpp>
 #include <aliceVision/stl/FlatMap.hpp>
 #include <aliceVision/stl/FlatSet.hpp>
 
-#include <lemon/list_graph.h>
-#include <lemon/unionfind.h>
-
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <functional>
 #include <vector>
@@ -28,7 +27,6 @@ namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
 /**
  * @brief A Track is a feature visible accross multiple views.
@@ -73,6 +71,24 @@ typedef stl::flat_map<std::size_t, stl::flat_map<std::size_t, std::size_t> > Tra
  */
 typedef stl::flat_map<std::size_t, TrackIdSet > TracksPerView;
 
+/// Estimated memory used by the tracks (bytes), for the system::MemoryAccounting
+inline std::size_t getMemorySize(const TracksMap& tracks)
+{
+  std::size_t size = tracks.capacity() * sizeof(TracksMap::value_type);
+  for(const auto& track : tracks)
+    size += track.second.featPerView.capacity() * sizeof(Track::FeatureIdPerView::value_type);
+  return size;
+}
+
+/// Estimated memory used by the tracks per view (bytes), for the system::MemoryAccounting
+inline std::size_t getMemorySize(const TracksPerView& tracksPerView)
+{
+  std::size_t size = tracksPerView.capacity() * sizeof(TracksPerView::value_type);
+  for(const auto& viewTracks : tracksPerView)
+    size += viewTracks.second.capacity() * sizeof(TrackIdSet::value_type);
+  return size;
+}
+
 /**
  * @brief KeypointId is a unique ID for a feature in a view.
  */
@@ -115,6 +131,9 @@ inline std::ostream& operator<<(std::ostream& os, const KeypointId& k)
  *
  * From map< [imageI,ImageJ], [indexed matches array] > it builds tracks.
  *
+ * The union-find is stored in flat arrays over a dense index of the features
+ * (viewId, descType, featIndex), so no per-feature node or map is allocated.
+ *
  * Usage:
  * @code{.cpp}
  *  PairWiseMatches matches;
@@ -131,28 +150,20 @@ struct TracksBuilder
 {
   /// IndexedFeaturePair is: map<viewId, keypointId>
   typedef std::pair<std::size_t, KeypointId> IndexedFeaturePair;
-  typedef ListDigraph::NodeMap<std::size_t> IndexMap;
-  typedef lemon::UnionFindEnum< IndexMap > UnionFindObject;
+  /// Dense index of a feature in the union-find arrays
+  typedef std::uint32_t NodeIndex;
 
-  typedef stl::flat_map< lemon::ListDigraph::Node, IndexedFeaturePair> MapNodeToIndex;
-  typedef stl::flat_map< IndexedFeaturePair, lemon::ListDigraph::Node > MapIndexToNode;
-
-  /// graph container to create the node
-  lemon::ListDigraph _graph;
-  /// node to index map
-  MapNodeToIndex _map_nodeToIndex;
-  std::unique_ptr<IndexMap> _index;
-  std::unique_ptr<UnionFindObject> _tracksUF;
-
-  const UnionFindObject& getUnionFindEnum() const
-  {
-    return *_tracksUF;
-  }
-
-  const MapNodeToIndex& getReverseMap() const
+  /**
+   * @brief Contiguous range of dense node indexes of the features of one view and one describer type:
+   *        node = offset + featIndex, for featIndex in [0, count[
+   */
+  struct ViewDescRange
   {
-    return _map_nodeToIndex;
-  }
+    std::size_t viewId;
+    feature::EImageDescriberType descType;
+    NodeIndex offset;
+    NodeIndex count;
+  };
 
   /**
    * @brief Build tracks for a given series of pairWise matches
@@ -160,6 +171,27 @@ struct TracksBuilder
    */
   void build(const PairwiseMatches& pairwiseMatches);
 
+  /**
+   * @brief Build tracks from binary matches files, reading the matches pair by pair
+   *        without loading all the PairwiseMatches in memory.
+   * @param[in] matchesReaders The binary matches files
+   * @param[in] viewsKeysFilter Use only pairs with both views in this set (all if empty)
+   * @param[in] descTypesFilter Use only these describer types (all if empty)
+   * @param[in] maxNbMatches Use only the N first matches for each describer type (all if 0)
+   */
+  void build(const std::vector<const matching::MatchesFileReader*>& matchesReaders,
+             const std::set<IndexT>& viewsKeysFilter = std::set<IndexT>(),
+             const std::vector<feature::EImageDescriberType>& descTypesFilter = std::vector<feature::EImageDescriberType>(),
+             int maxNbMatches = 0);
+
+  /**
+   * @brief Build tracks from a function visiting all the pairwise matches.
+   * @note The visit function is called twice: the first pass only computes the dense
+   *       feature index ranges, the second one makes the unions. The matches are never stored.
+   * @param[in] visitPairs Function calling the given visitor on each image pair matches
+   */
+  void build(const std::function<void(const matching::MatchesFileReader::PairVisitor&)>& visitPairs);
+
   /**
    * @brief Remove bad tracks (too short or track with ids collision)
    * @param[in] minTrackLength
@@ -184,13 +216,38 @@ struct TracksBuilder
    * @brief Return the number of connected set in the UnionFind structure (tree forest)
    * @return number of connected set in the UnionFind structure
    */
-  std::size_t nbTracks() const
-  {
-    std::size_t cpt = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
-      ++cpt;
-    return cpt;
-  }
+  std::size_t nbTracks() const;
+
+private:
+
+  /// Return the dense node index of a feature
+  NodeIndex getNode(std::size_t viewId, feature::EImageDescriberType descType, std::size_t featIndex) const;
+
+  /// Return the feature corresponding to a dense node index
+  IndexedFeaturePair getFeature(NodeIndex node) const;
+
+  /// Find the root of a node (with path halving)
+  NodeIndex find(NodeIndex node) const;
+
+  /// Union by size of the sets of the two nodes
+  void join(NodeIndex a, NodeIndex b);
+
+  /**
+   * @brief Compute for each track the list of its nodes (CSR layout, nodes sorted in each track).
+   *        Tracks are sorted by their first node.
+   * @param[out] trackOffsets Offsets of the tracks nodes in trackNodes (size: nbTracks + 1)
+   * @param[out] trackNodes Nodes of all the tracks
+   */
+  void computeTracksNodes(std::vector<NodeIndex>& trackOffsets, std::vector<NodeIndex>& trackNodes) const;
+
+  /// Features ranges sorted by (viewId, descType)
+  std::vector<ViewDescRange> _ranges;
+  /// Union-find parent of each node (mutable for path compression)
+  mutable std::vector<NodeIndex> _parent;
+  /// Union-find size of each root set
+  std::vector<NodeIndex> _setSize;
+  /// True if the node belongs to a valid track
+  std::vector<bool> _isUsed;
 };
 
 namespace tracksUtilsMap {
@@ -6,7 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/track/Track.hpp"
+#include "aliceVision/track/CompactTracks.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/matching/io.hpp"
+
+#include <boost/filesystem.hpp>
 
 #include <vector>
 #include <utility>
@@ -15,6 +19,7 @@
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
+using namespace aliceVision;
 using namespace aliceVision::feature;
 using namespace aliceVision::track;
 using namespace aliceVision::matching;
@@ -84,6 +89,49 @@ BOOST_AUTO_TEST_CASE(Track_Simple) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Track_BinaryMatchesFile) {
+
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //2 -> 3
+
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[ std::make_pair(0,1) ][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  map_pairwisematches[ std::make_pair(1,2) ][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,6)};
+
+  const std::string testFolder = "trackBinTest";
+  boost::filesystem::create_directory(testFolder);
+  BOOST_CHECK(Save(map_pairwisematches, testFolder, "bin", false));
+
+  TracksMap map_tracksRef;
+  {
+    TracksBuilder trackBuilder;
+    trackBuilder.build(map_pairwisematches);
+    trackBuilder.exportToSTL(map_tracksRef);
+  }
+
+  //-- Build tracks reading the matches pair by pair
+  const MatchesFileReader reader(testFolder + "/matches.bin");
+  TracksBuilder trackBuilder;
+  trackBuilder.build({&reader});
+  BOOST_CHECK_EQUAL(3, trackBuilder.nbTracks());
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  BOOST_CHECK_EQUAL(map_tracksRef.size(), map_tracks.size());
+  for(const auto& trackPair : map_tracksRef)
+    BOOST_CHECK(trackPair.second.featPerView == map_tracks.at(trackPair.first).featPerView);
+
+  //-- Keep only the first match of each pair
+  TracksBuilder trackBuilderTop;
+  trackBuilderTop.build({&reader}, {}, {}, 1);
+  BOOST_CHECK_EQUAL(1, trackBuilderTop.nbTracks());
+
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(Track_filter_3viewAtLeast) {
 
   //
@@ -226,3 +274,75 @@ BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
     BOOST_CHECK_EQUAL(base.size(), set_visibleTracks.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(Track_CompactTracks)
+{
+  //A    B    C    D
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6 -> 2
+  //2 -> 3
+  //          5 -> 4
+  TracksMap map_tracks;
+  map_tracks[0].featPerView = {{0, 0}, {1, 0}, {2, 0}};
+  map_tracks[1].featPerView = {{0, 1}, {1, 1}, {2, 6}, {3, 2}};
+  map_tracks[2].featPerView = {{0, 2}, {1, 3}};
+  map_tracks[5].featPerView = {{2, 5}, {3, 4}};
+  map_tracks[5].descType = EImageDescriberType::SIFT;
+
+  const CompactTracks compactTracks(map_tracks);
+  BOOST_CHECK_EQUAL(4, compactTracks.nbTracks());
+  BOOST_CHECK_EQUAL(4, compactTracks.nbViews());
+  BOOST_CHECK_EQUAL(3, compactTracks.getTrackIndex(5));
+  BOOST_CHECK_EQUAL(compactTracks.nbTracks(), compactTracks.getTrackIndex(3));
+  BOOST_CHECK_EQUAL(4, compactTracks.getTrackLength(1));
+  BOOST_CHECK(compactTracks.getDescType(3) == EImageDescriberType::SIFT);
+
+  IndexT featureId;
+  BOOST_CHECK(compactTracks.getFeatureId(1, 2, featureId));
+  BOOST_CHECK_EQUAL(6, featureId);
+  BOOST_CHECK(!compactTracks.getFeatureId(2, 3, featureId));
+
+  // round trip
+  TracksMap map_tracksOut;
+  compactTracks.exportToTracksMap(map_tracksOut);
+  BOOST_CHECK_EQUAL(map_tracks.size(), map_tracksOut.size());
+  for(const auto& trackPair : map_tracks)
+  {
+    BOOST_CHECK(trackPair.second.featPerView == map_tracksOut.at(trackPair.first).featPerView);
+    BOOST_CHECK(trackPair.second.descType == map_tracksOut.at(trackPair.first).descType);
+  }
+
+  TracksPerView map_tracksPerView;
+  tracksUtilsMap::computeTracksPerView(map_tracks, map_tracksPerView);
+  TracksPerView map_tracksPerViewOut;
+  compactTracks.exportToTracksPerView(map_tracksPerViewOut);
+  BOOST_CHECK(map_tracksPerView == map_tracksPerViewOut);
+
+  // adapters give the same results as the TracksMap / TracksPerView versions
+  const std::vector<std::set<std::size_t>> imageSets = {{0, 1}, {1, 2}, {2, 3}, {0, 3}, {0, 1, 2}, {3, 4}};
+  for(const std::set<std::size_t>& images : imageSets)
+  {
+    std::set<std::size_t> visibleTracks;
+    std::set<std::size_t> visibleTracksCompact;
+    tracksUtilsMap::getCommonTracksInImages(images, map_tracksPerView, visibleTracks);
+    tracksUtilsMap::getCommonTracksInImages(images, compactTracks, visibleTracksCompact);
+    BOOST_CHECK(visibleTracks == visibleTracksCompact);
+
+    TracksMap commonTracks;
+    TracksMap commonTracksCompact;
+    tracksUtilsMap::getCommonTracksInImagesFast(images, map_tracks, map_tracksPerView, commonTracks);
+    tracksUtilsMap::getCommonTracksInImagesFast(images, compactTracks, commonTracksCompact);
+    BOOST_CHECK_EQUAL(commonTracks.size(), commonTracksCompact.size());
+    for(const auto& trackPair : commonTracks)
+      BOOST_CHECK(trackPair.second.featPerView == commonTracksCompact.at(trackPair.first).featPerView);
+  }
+
+  std::set<IndexT> tracksIds;
+  tracksUtilsMap::getTracksInImagesFast({3}, compactTracks, tracksIds);
+  BOOST_CHECK(tracksIds == std::set<IndexT>({1, 5}));
+
+  std::vector<tracksUtilsMap::FeatureId> featIds;
+  BOOST_CHECK(tracksUtilsMap::getFeatureIdInViewPerTrack(compactTracks, {0, 1, 5}, 2, &featIds));
+  BOOST_CHECK_EQUAL(3, featIds.size());
+  BOOST_CHECK_EQUAL(5, featIds.back().second);
+}
@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <aliceVision/config.hpp>
+#include <aliceVision/stl/OpenHashMap.hpp>
+
 #include <Eigen/Core>
 
 #include <cstdint>
@@ -14,7 +17,7 @@
 #include <set>
 #include <vector>
 
-#ifdef ALICEVISION_STD_UNORDERED_MAP
+#ifdef ALICEVISION_UNORDERED_MAP
 #include <unordered_map>
 #endif
 
@@ -30,6 +33,10 @@ typedef std::vector<Pair> PairVec;
 #ifdef ALICEVISION_UNORDERED_MAP
 template<typename Key, typename Value>
 struct HashMap : std::unordered_map<Key, Value> {};
+#elif ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPEN_HASH_MAP)
+template<typename K, typename V>
+struct HashMap : stl::open_hash_map<K, V,
+ Eigen::aligned_allocator<std::pair<const K,V> > > {};
 #else
 template<typename K, typename V>
 struct HashMap : std::map<K, V, std::less<K>,
@@ -5,12 +5,14 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/tail.hpp>
-#include <boost/progress.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
+#include <unordered_map>
 #include <boost/format.hpp>
 
 namespace aliceVision{
@@ -26,15 +28,122 @@ std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)
 	return os;
 }
 
+namespace {
+
+/// identifies the database files (and their version)
+const char databaseMagic[8] = {'A', 'V', 'V', 'O', 'C', 'D', 'B', '1'};
+const std::uint32_t databaseVersion = 1;
+const std::size_t databaseAlignment = 16;
+
+std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + databaseAlignment - 1) / databaseAlignment * databaseAlignment;
+}
+
+void writeBlock(std::ofstream& out, std::uint64_t offset, const void* data, std::size_t size)
+{
+  out.seekp(offset);
+  if(size > 0)
+    out.write(static_cast<const char*>(data), size);
+}
+
+/// distance methods scored from the inverted files
+enum class EInvertedFileDistance
+{
+  CLASSIC,
+  COMMON_POINTS,
+  STRONG_COMMON_POINTS,
+  INVERSED_WEIGHTED_COMMON_POINTS,
+  NONE
+};
+
+EInvertedFileDistance getInvertedFileDistance(const std::string& distanceMethod)
+{
+  if(distanceMethod == "classic")
+    return EInvertedFileDistance::CLASSIC;
+  if(distanceMethod == "commonPoints")
+    return EInvertedFileDistance::COMMON_POINTS;
+  if(distanceMethod == "strongCommonPoints")
+    return EInvertedFileDistance::STRONG_COMMON_POINTS;
+  if(distanceMethod == "inversedWeightedCommonPoints")
+    return EInvertedFileDistance::INVERSED_WEIGHTED_COMMON_POINTS;
+  if(distanceMethod == "weightedStrongCommonPoints")
+    return EInvertedFileDistance::NONE;
+  throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
+}
+
+/// max size of the scores of the queries scored together
+const std::size_t maxScoresSize = 32 * 1024 * 1024;
+/// min number of inverted file entries processed by the queries before the next words
+const std::size_t minWordRangeSize = 32 * 1024;
+
+/// strict order of the matches: best score first, then smallest id
+struct DocMatchBetter
+{
+  bool operator()(const DocMatch& a, const DocMatch& b) const
+  {
+    return (a.score < b.score) || (a.score == b.score && a.id < b.id);
+  }
+};
+
+/// Keep the N best matches in a heap (the worst of them on top)
+void addMatch(const DocMatch& match, std::size_t N, DocMatches& bestMatches)
+{
+  const DocMatchBetter better;
+  if(bestMatches.size() < N)
+  {
+    bestMatches.push_back(match);
+    std::push_heap(bestMatches.begin(), bestMatches.end(), better);
+  }
+  else if(better(match, bestMatches.front()))
+  {
+    std::pop_heap(bestMatches.begin(), bestMatches.end(), better);
+    bestMatches.back() = match;
+    std::push_heap(bestMatches.begin(), bestMatches.end(), better);
+  }
+}
+
+/// Sort the heap of the best matches, best first
+void sortMatches(DocMatches& bestMatches)
+{
+  std::sort_heap(bestMatches.begin(), bestMatches.end(), DocMatchBetter());
+}
+
+} // namespace
+
 Database::Database(uint32_t num_words)
-: word_files_(num_words),
-word_weights_( num_words, 1.0f ) { }
+: num_words_(num_words),
+word_files_(num_words),
+word_weights_( num_words, 1.0f ),
+weights_mutex_(std::make_shared<std::mutex>()) { }
+
+void Database::unmap()
+{
+  if(!mapped_file_)
+    return;
+
+  if(mapped_weights_)
+    word_weights_.assign(mapped_weights_, mapped_weights_ + num_words_);
+  if(mapped_word_files_)
+  {
+    word_files_.assign(num_words_, InvertedFile());
+    for(uint32_t word = 0; word < num_words_; ++word)
+      word_files_[word].assign(mapped_word_frequencies_ + mapped_word_files_[word], mapped_word_frequencies_ + mapped_word_files_[word + 1]);
+  }
+  mapped_file_.reset();
+  mapped_weights_ = nullptr;
+  mapped_word_files_ = nullptr;
+  mapped_word_frequencies_ = nullptr;
+}
 
 DocId Database::insert(DocId doc_id, const SparseHistogram& document)
 {
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
+  // The memory-mapped inverted files are read-only
+  unmap();
+
   // For each word, retrieve its inverted file and increment the count for doc_id.
   for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
   {
@@ -48,9 +157,53 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
 
   database_[doc_id] = document;
 
+  if(incremental_weights_)
+    outdated_weights_ = true;
+
   return doc_id;
 }
 
+void Database::insert(const SparseHistogramPerImage& documents)
+{
+  if(documents.empty())
+    return;
+
+  // The memory-mapped inverted files are read-only
+  unmap();
+
+  // Each range of words is updated by a thread, from all the documents in the order of their ids
+  const int nbRanges = static_cast<int>(std::max<std::size_t>(1, std::min<std::size_t>(num_words_, 8 * omp_get_max_threads())));
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int r = 0; r < nbRanges; ++r)
+  {
+    const Word wordBegin = static_cast<Word>(std::size_t(num_words_) * r / nbRanges);
+    const Word wordEnd = static_cast<Word>(std::size_t(num_words_) * (r + 1) / nbRanges);
+    for(const auto& document : documents)
+    {
+      const DocId doc_id = document.first;
+      for(SparseHistogram::const_iterator it = document.second.lower_bound(wordBegin), end = document.second.end(); it != end && it->first < wordEnd; ++it)
+      {
+        InvertedFile& file = word_files_[it->first];
+        if(file.empty() || file.back().id != doc_id)
+          file.push_back(WordFrequency(doc_id, it->second.size()));
+        else
+          file.back().count += it->second.size();
+      }
+    }
+  }
+
+  for(const auto& document : documents)
+  {
+    // Ensure that the new document to insert is not already there.
+    assert(database_.find(document.first) == database_.end());
+    database_[document.first] = document.second;
+  }
+
+  if(incremental_weights_)
+    outdated_weights_ = true;
+}
+
 void Database::sanityCheck(size_t N, std::map<size_t, DocMatches>& matches) const
 {
   // if N is equal to zero
@@ -59,27 +212,20 @@ void Database::sanityCheck(size_t N, std::map<size_t, DocMatches>& matches) cons
     // retrieve all the matchings
     N = this->size();
   }
-  else
-  {
-    // otherwise always take the min between N and the number of documents
-    // in the database
-    N = std::min(N, this->size());
-  }
+
+  // query all the documents of the database together
+  std::vector<const SparseHistogram*> queries;
+  queries.reserve(database_.size());
+  for(const auto& doc : database_)
+    queries.push_back(&doc.second);
+
+  std::vector<DocMatches> queriesMatches;
+  find(queries, N, queriesMatches);
 
   matches.clear();
-  // since we already know the size of the vectors, in order to parallelize the 
-  // query allocate the whole memory
-  boost::progress_display display(database_.size());
-  
-  //#pragma omp parallel for default(none) shared(database_)
-  for(const auto &doc : database_)
-  {
-    std::vector<DocMatch> m;
-    find(doc.second, N, m);
-    //		matches.emplace_back( m );
-    matches[doc.first] = m;
-    ++display;
-  }
+  std::size_t i = 0;
+  for(const auto& doc : database_)
+    matches[doc.first].swap(queriesMatches[i++]);
 }
 
 /**
@@ -110,23 +256,230 @@ void Database::find(const std::vector<Word>& document, size_t N, std::vector<Doc
  */
 void Database::find( const SparseHistogram& query, size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-  // Accumulate the best N matches
-  using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
-  boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> > acc(bestN_tag::cache_size = N);
+  const std::vector<const SparseHistogram*> queries(1, &query);
+  std::vector<DocMatches> queriesMatches;
+  find(queries, N, queriesMatches, distanceMethod);
+  matches.swap(queriesMatches.front());
+}
+
+void Database::find(const std::vector<SparseHistogram>& queries, size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod) const
+{
+  std::vector<const SparseHistogram*> queriesPtr;
+  queriesPtr.reserve(queries.size());
+  for(const SparseHistogram& query : queries)
+    queriesPtr.push_back(&query);
+  find(queriesPtr, N, matches, distanceMethod);
+}
+
+void Database::find(const std::vector<const SparseHistogram*>& queries, size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod) const
+{
+  const EInvertedFileDistance distance = getInvertedFileDistance(distanceMethod);
+
+  matches.assign(queries.size(), DocMatches());
+  N = std::min(N, database_.size());
+  if(queries.empty() || N == 0)
+    return;
 
-  /// @todo Try only computing distances against documents sharing at least one word
-  for(const auto& document: database_)
+  if(distance == EInvertedFileDistance::NONE)
   {
-    // for each document/image in the database compute the distance between the 
-    // histograms of the query image and the others
-    float distance = sparseDistance(query, document.second, distanceMethod, word_weights_);
-    acc(DocMatch(document.first, distance));
+    findBruteForce(queries, N, matches, distanceMethod);
+    return;
   }
 
-  // extract the best N
-  boost::accumulators::extractor<bestN_tag> bestN;
-  matches.resize(std::min(N, database_.size()));
-  std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
+  const float* wordWeights = weights();
+
+  // dense indexes of the documents, and their number of features
+  const std::size_t nbDocuments = database_.size();
+  std::vector<DocId> documentIds;
+  std::vector<std::size_t> documentSizes;
+  std::unordered_map<DocId, std::uint32_t> documentIndexes;
+  std::size_t nbDocumentWords = 0;
+  documentIds.reserve(nbDocuments);
+  documentSizes.reserve(nbDocuments);
+  documentIndexes.reserve(nbDocuments);
+  for(const auto& document : database_)
+  {
+    std::size_t size = 0;
+    for(const auto& word : document.second)
+      size += word.second.size();
+    documentIndexes[document.first] = documentIds.size();
+    documentIds.push_back(document.first);
+    documentSizes.push_back(size);
+    nbDocumentWords += document.second.size();
+  }
+
+  // inverted files of the words of the queries, with the dense document indexes
+  struct Posting
+  {
+    std::uint32_t document;
+    std::uint32_t count;
+  };
+  std::vector<char> isQueryWord(num_words_, 0);
+  for(const SparseHistogram* query : queries)
+  {
+    for(const auto& word : *query)
+    {
+      if(word.first >= 0 && std::uint32_t(word.first) < num_words_)
+        isQueryWord[word.first] = 1;
+    }
+  }
+  std::size_t nbInvertedFilesEntries = 0;
+  std::vector<std::uint64_t> postingsOffsets(std::size_t(num_words_) + 1, 0);
+  for(uint32_t word = 0; word < num_words_; ++word)
+  {
+    nbInvertedFilesEntries += invertedFileSize(word);
+    postingsOffsets[word + 1] = postingsOffsets[word] + (isQueryWord[word] ? invertedFileSize(word) : 0);
+  }
+  std::vector<Posting> postings(postingsOffsets.back());
+  bool isConsistent = (nbInvertedFilesEntries == nbDocumentWords);
+
+  #pragma omp parallel for schedule(dynamic, 1024) reduction(&&:isConsistent)
+  for(int word = 0; word < static_cast<int>(num_words_); ++word)
+  {
+    const WordFrequency* file = invertedFile(word);
+    Posting* wordPostings = postings.data() + postingsOffsets[word];
+    for(std::uint64_t i = 0; i < postingsOffsets[word + 1] - postingsOffsets[word]; ++i)
+    {
+      const auto it = documentIndexes.find(file[i].id);
+      isConsistent = isConsistent && (it != documentIndexes.end());
+      wordPostings[i].document = (it != documentIndexes.end()) ? it->second : 0;
+      wordPostings[i].count = file[i].count;
+    }
+  }
+
+  if(!isConsistent)
+  {
+    ALICEVISION_LOG_WARNING("The inverted files of the database don't match its documents, the queries are compared to all the documents.");
+    findBruteForce(queries, N, matches, distanceMethod);
+    return;
+  }
+
+  // the queries are scored by chunks, every query of a chunk has its scores of all the documents
+  const std::size_t chunkSize = std::min(queries.size(), std::max<std::size_t>(omp_get_max_threads(), maxScoresSize / (nbDocuments * sizeof(double))));
+
+  // ranges of words: the queries of a chunk all process a range before the next one
+  std::vector<Word> wordRangesEnd;
+  if(chunkSize > 1)
+  {
+    std::size_t rangeSize = 0;
+    for(uint32_t word = 0; word < num_words_; ++word)
+    {
+      rangeSize += postingsOffsets[word + 1] - postingsOffsets[word];
+      if(rangeSize >= minWordRangeSize)
+      {
+        wordRangesEnd.push_back(word + 1);
+        rangeSize = 0;
+      }
+    }
+  }
+  if(wordRangesEnd.empty() || wordRangesEnd.back() != Word(num_words_))
+    wordRangesEnd.push_back(num_words_);
+
+  std::vector<double> scores;
+  std::vector<SparseHistogram::const_iterator> queriesWord(chunkSize);
+
+  for(std::size_t chunkBegin = 0; chunkBegin < queries.size(); chunkBegin += chunkSize)
+  {
+    const int nbChunkQueries = static_cast<int>(std::min(chunkSize, queries.size() - chunkBegin));
+    scores.assign(nbChunkQueries * nbDocuments, 0.0);
+    for(int q = 0; q < nbChunkQueries; ++q)
+    {
+      queriesWord[q] = queries[chunkBegin + q]->begin();
+      // the negative words are not in the vocabulary
+      while(queriesWord[q] != queries[chunkBegin + q]->end() && queriesWord[q]->first < 0)
+        ++queriesWord[q];
+    }
+
+    for(const Word wordRangeEnd : wordRangesEnd)
+    {
+      #pragma omp parallel for schedule(dynamic) if(nbChunkQueries > 1)
+      for(int q = 0; q < nbChunkQueries; ++q)
+      {
+        const SparseHistogram::const_iterator queryEnd = queries[chunkBegin + q]->end();
+        SparseHistogram::const_iterator& queryWord = queriesWord[q];
+        double* queryScores = scores.data() + q * nbDocuments;
+
+        for(; queryWord != queryEnd && queryWord->first < wordRangeEnd; ++queryWord)
+        {
+          const Word word = queryWord->first;
+          const std::size_t queryCount = queryWord->second.size();
+          const Posting* wordPostingsBegin = postings.data() + postingsOffsets[word];
+          const Posting* wordPostingsEnd = postings.data() + postingsOffsets[word + 1];
+
+          // accumulate the contribution of the common words (see sparseDistance)
+          switch(distance)
+          {
+            case EInvertedFileDistance::CLASSIC:
+            case EInvertedFileDistance::COMMON_POINTS:
+              for(const Posting* p = wordPostingsBegin; p != wordPostingsEnd; ++p)
+                queryScores[p->document] += std::min<std::size_t>(queryCount, p->count);
+              break;
+            case EInvertedFileDistance::STRONG_COMMON_POINTS:
+              if(queryCount == 1)
+              {
+                for(const Posting* p = wordPostingsBegin; p != wordPostingsEnd; ++p)
+                  queryScores[p->document] += (p->count == 1);
+              }
+              break;
+            case EInvertedFileDistance::INVERSED_WEIGHTED_COMMON_POINTS:
+            {
+              const double weight = wordWeights[word];
+              for(const Posting* p = wordPostingsBegin; p != wordPostingsEnd; ++p)
+                queryScores[p->document] += (1.0 / std::min<std::size_t>(queryCount, p->count)) * weight;
+              break;
+            }
+            case EInvertedFileDistance::NONE:
+              break;
+          }
+        }
+      }
+    }
+
+    #pragma omp parallel for
+    for(int q = 0; q < nbChunkQueries; ++q)
+    {
+      const double* queryScores = scores.data() + q * nbDocuments;
+      std::size_t querySize = 0;
+      if(distance == EInvertedFileDistance::CLASSIC)
+      {
+        for(const auto& word : *queries[chunkBegin + q])
+          querySize += word.second.size();
+      }
+
+      DocMatches& bestMatches = matches[chunkBegin + q];
+      bestMatches.reserve(N);
+      for(std::size_t d = 0; d < nbDocuments; ++d)
+      {
+        float score;
+        if(distance == EInvertedFileDistance::CLASSIC)
+          score = static_cast<float>(querySize + documentSizes[d] - 2.0 * queryScores[d]);
+        else
+          score = static_cast<float>(- queryScores[d]);
+        addMatch(DocMatch(documentIds[d], score), N, bestMatches);
+      }
+      sortMatches(bestMatches);
+    }
+  }
+}
+
+void Database::findBruteForce(const std::vector<const SparseHistogram*>& queries, size_t N, std::vector<DocMatches>& matches, const std::string& distanceMethod) const
+{
+  const float* wordWeights = weights();
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int q = 0; q < static_cast<int>(queries.size()); ++q)
+  {
+    DocMatches& bestMatches = matches[q];
+    bestMatches.reserve(N);
+    for(const auto& document: database_)
+    {
+      // for each document/image in the database compute the distance between the
+      // histograms of the query image and the others
+      const float distance = sparseDistance(*queries[q], document.second, distanceMethod, wordWeights);
+      addMatch(DocMatch(document.first, distance), N, bestMatches);
+    }
+    sortMatches(bestMatches);
+  }
 }
 
 /**
@@ -134,47 +487,222 @@ void Database::find( const SparseHistogram& query, size_t N, std::vector<DocMatc
  * training examples into the database.
  *
  * @param default_weight The default weight of a word that appears in none of the training documents.
+ * @param incremental Keep the weights up to date with the documents inserted afterwards.
  */
-void Database::computeTfIdfWeights(float default_weight)
+void Database::computeTfIdfWeights(float default_weight, bool incremental)
 {
-  float N = (float) database_.size();
-  size_t num_words = word_files_.size();
-  for(size_t i = 0; i < num_words; ++i)
+  unmap();
+  default_weight_ = default_weight;
+  incremental_weights_ = incremental;
+  outdated_weights_ = false;
+  word_weights_.resize(num_words_);
+  computeWeights(word_weights_.data());
+}
+
+void Database::computeWeights(float* weights) const
+{
+  // the document frequency of a word is the size of its inverted file
+  const float N = (float) database_.size();
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(num_words_); ++i)
   {
-    size_t Ni = word_files_[i].size();
+    const std::size_t Ni = invertedFileSize(i);
     if(Ni != 0)
-      word_weights_[i] = std::log(N / Ni);
+      weights[i] = std::log(N / Ni);
     else
-      word_weights_[i] = default_weight;
+      weights[i] = default_weight_;
   }
 }
 
+void Database::updateWeights() const
+{
+  std::lock_guard<std::mutex> lock(*weights_mutex_);
+  if(!outdated_weights_)
+    return;
+  computeWeights(word_weights_.data());
+  outdated_weights_ = false;
+}
+
 void Database::saveWeights(const std::string& file) const
 {
   std::ofstream out(file.c_str(), std::ios_base::binary);
-  uint32_t num_words = word_weights_.size();
+  uint32_t num_words = num_words_;
   out.write((char*) (&num_words), sizeof (uint32_t));
-  out.write((char*) (&word_weights_[0]), num_words * sizeof (float));
+  out.write((char*) (weights()), num_words * sizeof (float));
 }
 
 void Database::loadWeights(const std::string& file)
 {
-  std::ifstream in;
-  in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
-
+  // file layout: number of words (uint32) then the weights
+  std::shared_ptr<boost::iostreams::mapped_file_source> mappedFile;
+  uint32_t num_words = 0;
   try
   {
-    in.open(file.c_str(), std::ios_base::binary);
-    uint32_t num_words = 0;
-    in.read((char*) (&num_words), sizeof (uint32_t));
-    word_files_.resize(num_words); // Inverted files start out empty
-    word_weights_.resize(num_words);
-    in.read((char*) (&word_weights_[0]), num_words * sizeof (float));
+    mappedFile = std::make_shared<boost::iostreams::mapped_file_source>(file);
   }
-  catch(std::ifstream::failure& e)
+  catch(std::exception& e)
   {
     throw std::runtime_error((boost::format("Failed to load vocabulary weights file '%s'") % file).str());
   }
+  if(mappedFile->size() >= sizeof(uint32_t))
+    std::memcpy(&num_words, mappedFile->data(), sizeof(uint32_t));
+  if(mappedFile->size() < sizeof(uint32_t) + std::size_t(num_words) * sizeof(float))
+    throw std::runtime_error((boost::format("Failed to load vocabulary weights file '%s'") % file).str());
+
+  unmap();
+  incremental_weights_ = false;
+  outdated_weights_ = false;
+  num_words_ = num_words;
+  word_files_.clear();
+  word_files_.resize(num_words); // Inverted files start out empty
+  word_weights_.clear();
+  mapped_file_ = mappedFile;
+  mapped_weights_ = reinterpret_cast<const float*>(mappedFile->data() + sizeof(uint32_t));
+}
+
+void Database::save(const std::string& file) const
+{
+  DatabaseFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, databaseMagic, sizeof(databaseMagic));
+  header.version = databaseVersion;
+  header.numWords = num_words_;
+  header.nbDocuments = database_.size();
+
+  // inverted files offsets
+  std::vector<std::uint64_t> wordFiles(std::size_t(num_words_) + 1, 0);
+  for(uint32_t word = 0; word < num_words_; ++word)
+    wordFiles[word + 1] = wordFiles[word] + invertedFileSize(word);
+  header.nbWordFrequencies = wordFiles.back();
+
+  // documents
+  std::vector<DatabaseFileDocument> documents;
+  std::vector<DatabaseFileDocumentWord> documentWords;
+  std::vector<std::uint32_t> features;
+  documents.reserve(database_.size());
+  for(const auto& document : database_)
+  {
+    documents.push_back({document.first, static_cast<std::uint32_t>(document.second.size())});
+    for(const auto& word : document.second)
+    {
+      documentWords.push_back({word.first, static_cast<std::uint32_t>(word.second.size())});
+      features.insert(features.end(), word.second.begin(), word.second.end());
+    }
+  }
+  header.nbDocumentWords = documentWords.size();
+  header.nbFeatures = features.size();
+
+  header.weightsOffset = alignOffset(sizeof(header));
+  header.wordFilesOffset = alignOffset(header.weightsOffset + std::uint64_t(num_words_) * sizeof(float));
+  header.wordFrequenciesOffset = alignOffset(header.wordFilesOffset + wordFiles.size() * sizeof(std::uint64_t));
+  header.documentsOffset = alignOffset(header.wordFrequenciesOffset + header.nbWordFrequencies * sizeof(WordFrequency));
+  header.documentWordsOffset = alignOffset(header.documentsOffset + documents.size() * sizeof(DatabaseFileDocument));
+  header.featuresOffset = alignOffset(header.documentWordsOffset + documentWords.size() * sizeof(DatabaseFileDocumentWord));
+
+  std::ofstream out(file.c_str(), std::ios_base::binary);
+  if(!out.is_open())
+    throw std::runtime_error((boost::format("Failed to write database file '%s'") % file).str());
+
+  writeBlock(out, 0, &header, sizeof(header));
+  writeBlock(out, header.weightsOffset, weights(), std::size_t(num_words_) * sizeof(float));
+  writeBlock(out, header.wordFilesOffset, wordFiles.data(), wordFiles.size() * sizeof(std::uint64_t));
+  out.seekp(header.wordFrequenciesOffset);
+  for(uint32_t word = 0; word < num_words_; ++word)
+  {
+    if(mapped_word_files_)
+      out.write((const char*) (mapped_word_frequencies_ + mapped_word_files_[word]), invertedFileSize(word) * sizeof(WordFrequency));
+    else if(!word_files_[word].empty())
+      out.write((const char*) (word_files_[word].data()), word_files_[word].size() * sizeof(WordFrequency));
+  }
+  writeBlock(out, header.documentsOffset, documents.data(), documents.size() * sizeof(DatabaseFileDocument));
+  writeBlock(out, header.documentWordsOffset, documentWords.data(), documentWords.size() * sizeof(DatabaseFileDocumentWord));
+  writeBlock(out, header.featuresOffset, features.data(), features.size() * sizeof(std::uint32_t));
+
+  if(!out)
+    throw std::runtime_error((boost::format("Failed to write database file '%s'") % file).str());
+}
+
+void Database::load(const std::string& file)
+{
+  const std::string errorMessage = (boost::format("Failed to load database file '%s'") % file).str();
+
+  std::shared_ptr<boost::iostreams::mapped_file_source> mappedFile;
+  try
+  {
+    mappedFile = std::make_shared<boost::iostreams::mapped_file_source>(file);
+  }
+  catch(std::exception& e)
+  {
+    throw std::runtime_error(errorMessage);
+  }
+
+  DatabaseFileHeader header;
+  if(mappedFile->size() < sizeof(header))
+    throw std::runtime_error(errorMessage);
+  std::memcpy(&header, mappedFile->data(), sizeof(header));
+  if(!std::equal(header.magic, header.magic + sizeof(databaseMagic), databaseMagic) || header.version != databaseVersion)
+    throw std::runtime_error(errorMessage + ": invalid header");
+
+  // check that all the blocks are in the file
+  const std::uint64_t fileSize = mappedFile->size();
+  const auto checkBlock = [&](std::uint64_t offset, std::uint64_t size)
+  {
+    if(offset % databaseAlignment != 0 || offset > fileSize || size > fileSize - offset)
+      throw std::runtime_error(errorMessage + ": truncated file");
+  };
+  checkBlock(header.weightsOffset, std::uint64_t(header.numWords) * sizeof(float));
+  checkBlock(header.wordFilesOffset, (std::uint64_t(header.numWords) + 1) * sizeof(std::uint64_t));
+  checkBlock(header.wordFrequenciesOffset, header.nbWordFrequencies * sizeof(WordFrequency));
+  checkBlock(header.documentsOffset, header.nbDocuments * sizeof(DatabaseFileDocument));
+  checkBlock(header.documentWordsOffset, header.nbDocumentWords * sizeof(DatabaseFileDocumentWord));
+  checkBlock(header.featuresOffset, header.nbFeatures * sizeof(std::uint32_t));
+
+  const char* data = mappedFile->data();
+  const std::uint64_t* wordFiles = reinterpret_cast<const std::uint64_t*>(data + header.wordFilesOffset);
+  if(wordFiles[0] != 0 || wordFiles[header.numWords] != header.nbWordFrequencies)
+    throw std::runtime_error(errorMessage + ": invalid inverted files");
+  for(uint32_t word = 0; word < header.numWords; ++word)
+  {
+    if(wordFiles[word + 1] < wordFiles[word])
+      throw std::runtime_error(errorMessage + ": invalid inverted files");
+  }
+
+  // the documents are copied in the sparse histograms
+  SparseHistogramPerImage database;
+  {
+    const DatabaseFileDocument* documents = reinterpret_cast<const DatabaseFileDocument*>(data + header.documentsOffset);
+    const DatabaseFileDocumentWord* documentWords = reinterpret_cast<const DatabaseFileDocumentWord*>(data + header.documentWordsOffset);
+    const std::uint32_t* features = reinterpret_cast<const std::uint32_t*>(data + header.featuresOffset);
+    std::uint64_t wordIndex = 0;
+    std::uint64_t featureIndex = 0;
+    for(std::uint64_t i = 0; i < header.nbDocuments; ++i)
+    {
+      SparseHistogram& histogram = database[documents[i].id];
+      for(std::uint32_t j = 0; j < documents[i].nbWords; ++j, ++wordIndex)
+      {
+        if(wordIndex >= header.nbDocumentWords ||
+           documentWords[wordIndex].word < 0 || std::uint32_t(documentWords[wordIndex].word) >= header.numWords ||
+           documentWords[wordIndex].nbFeatures > header.nbFeatures - featureIndex)
+          throw std::runtime_error(errorMessage + ": invalid documents");
+        const std::uint32_t* wordFeatures = features + featureIndex;
+        histogram[documentWords[wordIndex].word].assign(wordFeatures, wordFeatures + documentWords[wordIndex].nbFeatures);
+        featureIndex += documentWords[wordIndex].nbFeatures;
+      }
+    }
+  }
+
+  mapped_file_.reset();
+  incremental_weights_ = false;
+  outdated_weights_ = false;
+  num_words_ = header.numWords;
+  word_files_.clear();
+  word_weights_.clear();
+  database_.swap(database);
+  mapped_file_ = mappedFile;
+  mapped_weights_ = reinterpret_cast<const float*>(data + header.weightsOffset);
+  mapped_word_files_ = wordFiles;
+  mapped_word_frequencies_ = reinterpret_cast<const WordFrequency*>(data + header.wordFrequenciesOffset);
 }
 
 ///**
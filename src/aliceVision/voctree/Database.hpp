@@ -9,8 +9,13 @@
 #include "VocabularyTree.hpp"
 #include <aliceVision/types.hpp>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
 #include <map>
+#include <memory>
+#include <mutex>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace aliceVision{
@@ -51,6 +56,49 @@ struct DocMatch
 
 typedef std::vector<DocMatch> DocMatches;
 
+/**
+ * @brief Binary database file layout (version 1, native little-endian):
+ *
+ *   DatabaseFileHeader
+ *   float * numWords (word weights)
+ *   uint64 * (numWords + 1) (offset of the inverted file of each word)
+ *   (uint32 document id, uint32 count) * nbWordFrequencies (inverted files, sorted by word then document)
+ *   DatabaseFileDocument * nbDocuments
+ *   DatabaseFileDocumentWord * nbDocumentWords (words of the documents)
+ *   uint32 * nbFeatures (feature indexes of the document words)
+ *
+ * Each block is 16 bytes aligned, the weights and the inverted files are used in place
+ * in the memory-mapped file.
+ */
+struct DatabaseFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t numWords;
+  std::uint64_t nbWordFrequencies;
+  std::uint64_t nbDocuments;
+  std::uint64_t nbDocumentWords;
+  std::uint64_t nbFeatures;
+  std::uint64_t weightsOffset;
+  std::uint64_t wordFilesOffset;
+  std::uint64_t wordFrequenciesOffset;
+  std::uint64_t documentsOffset;
+  std::uint64_t documentWordsOffset;
+  std::uint64_t featuresOffset;
+};
+
+struct DatabaseFileDocument
+{
+  std::uint32_t id;
+  std::uint32_t nbWords;
+};
+
+struct DatabaseFileDocumentWord
+{
+  std::int32_t word;
+  std::uint32_t nbFeatures;
+};
+
 /**
  * @brief Class for efficiently matching a bag-of-words representation of a document (image) against
  * a database of known documents.
@@ -75,6 +123,14 @@ public:
    */
   DocId insert(DocId doc_id, const SparseHistogram& document);
 
+  /**
+   * @brief Insert new documents.
+   * The inverted files are updated in parallel, by ranges of words.
+   *
+   * @param documents The sets of quantized words of the new documents, by unique ID
+   */
+  void insert(const SparseHistogramPerImage& documents);
+
   /**
    * @brief Perform a sanity check of the database by querying each document
    * of the database and finding its top N matches
@@ -104,13 +160,38 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for each query document of a batch.
+   *
+   * The queries are scored in parallel from the inverted files: only the documents sharing words
+   * with a query are visited. The words are processed by ranges, so the inverted files of a range
+   * are reused from the cache by all the queries of the batch.
+   * The "weightedStrongCommonPoints" method compares the histograms one by one.
+   *
+   * @param[in] queries The query documents, sets of quantized words.
+   * @param[in] N The number of matches to return for each query.
+   * @param[out] matches IDs and scores for the top N matching database documents of each query, best first.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void find(const std::vector<SparseHistogram>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
+  /**
+   * @brief Find the top N matches in the database for each query document of a batch.
+   * @see find
+   * @param[in] queries The query documents, they are not copied.
+   */
+  void find(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
    *
    * @param default_weight The default weight of a word that appears in none of the training documents.
+   * @param incremental Keep the weights up to date with the documents inserted afterwards:
+   *        the weights are computed again from the document frequencies of the words
+   *        (the sizes of their inverted files) before their next use, not at each insertion.
    */
-  void computeTfIdfWeights(float default_weight = 1.0f);
+  void computeTfIdfWeights(float default_weight = 1.0f, bool incremental = false);
 
   /**
    * @brief Return the size of the database in terms of number of documents
@@ -120,12 +201,39 @@ public:
 
   /// Save the vocabulary word weights to a file.
   void saveWeights(const std::string& file) const;
-  /// Load the vocabulary word weights from a file.
+  /**
+   * @brief Load the vocabulary word weights from a file.
+   * The file is memory-mapped and the weights are used in place.
+   */
   void loadWeights(const std::string& file);
 
-  // Save weights and documents
-  //void save(const std::string& file) const;
-  //void load(const std::string& file);
+  /**
+   * @brief Save the weights, the inverted files and the documents in a binary database file.
+   * @see DatabaseFileHeader
+   */
+  void save(const std::string& file) const;
+
+  /**
+   * @brief Load a binary database file.
+   * The file is memory-mapped and the weights and inverted files are used in place,
+   * they are copied only if new documents are inserted.
+   * @throw std::runtime_error if the file is not valid
+   */
+  void load(const std::string& file);
+
+  /// Return the number of words of the vocabulary
+  std::size_t numWords() const
+  {
+    return num_words_;
+  }
+
+  /// Return the word weights (numWords() values)
+  const float* weights() const
+  {
+    if(incremental_weights_)
+      updateWeights();
+    return mapped_weights_ ? mapped_weights_ : word_weights_.data();
+  }
 
   const SparseHistogramPerImage& getSparseHistogramPerImage() const
   {
@@ -134,6 +242,7 @@ public:
   
 private:
 
+  /// a document containing a word, and the word count in the document
   struct WordFrequency
   {
     DocId id;
@@ -154,10 +263,49 @@ private:
   
   friend std::ostream& operator<<(std::ostream& os, const SparseHistogram& dv);
 
+  /// Return the number of documents containing the word
+  std::size_t invertedFileSize(Word word) const
+  {
+    return mapped_word_files_ ? (mapped_word_files_[word + 1] - mapped_word_files_[word]) : word_files_[word].size();
+  }
+
+  /// Return the inverted file of the word (invertedFileSize(word) values)
+  const WordFrequency* invertedFile(Word word) const
+  {
+    return mapped_word_files_ ? (mapped_word_frequencies_ + mapped_word_files_[word]) : word_files_[word].data();
+  }
+
+  /// Find the top N matches of the queries by comparing them to all the documents
+  void findBruteForce(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string& distanceMethod) const;
+
+  /// Copy the memory-mapped weights and inverted files, to modify them
+  void unmap();
+
+  /// Compute the TF-IDF weights of all the words in parallel
+  void computeWeights(float* weights) const;
+
+  /// Compute the weights again if documents were inserted since the last time (incremental weights)
+  void updateWeights() const;
+
+  uint32_t num_words_;
   std::vector<InvertedFile> word_files_;
-  std::vector<float> word_weights_;
+  mutable std::vector<float> word_weights_;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
 
+  /// the memory-mapped file of the weights or of the database, used in place
+  std::shared_ptr<boost::iostreams::mapped_file_source> mapped_file_;
+  const float* mapped_weights_ = nullptr;
+  const std::uint64_t* mapped_word_files_ = nullptr;
+  const WordFrequency* mapped_word_frequencies_ = nullptr;
+
+  /// the TF-IDF weights follow the inserted documents (see computeTfIdfWeights)
+  bool incremental_weights_ = false;
+  float default_weight_ = 1.0f;
+  /// documents were inserted since the incremental weights were computed
+  mutable bool outdated_weights_ = false;
+  /// protects the lazy update of the incremental weights by concurrent queries
+  std::shared_ptr<std::mutex> weights_mutex_;
+
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
    * @param[in/out] v the unnormalized histogram of visual words
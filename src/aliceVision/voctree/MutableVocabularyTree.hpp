@@ -28,6 +28,12 @@ public:
   {
   }
 
+  /// Load vocabulary from a file, the centers are copied to be editable.
+  void load(const std::string& file) override
+  {
+    BaseClass::load(file, false);
+  }
+
   void setSize(uint32_t levels, uint32_t splits)
   {
     this->levels_ = levels;
@@ -10,12 +10,15 @@
 #include "DefaultAllocator.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <numeric>
+#include <type_traits>
 #include <vector>
 #include <limits>
 #include <stdio.h>
@@ -253,10 +256,31 @@ bool checkVectorElements(const std::vector<Feature, FeatureAllocator> &f, const
   return correct;
 }
 
+namespace detail {
+
+/// Check if the distance is the Hamming distance of binary descriptors, clustered with k-majority
+template<class Distance>
+struct IsHamming : std::false_type {};
+
+template<class DescriptorA, class DescriptorB>
+struct IsHamming< Hamming<DescriptorA, DescriptorB> > : std::true_type {};
+
+} // namespace detail
+
 /**
  * @brief Class for performing K-means clustering, optimized for a particular feature type and metric.
  *
  * The standard Lloyd's algorithm is used. By default, cluster centers are initialized randomly.
+ * With a mini-batch size, the mini-batch k-means is used instead:
+ *
+ *  Sculley, D. (2010). "Web-scale k-means clustering" Proceedings of the 19th
+ *  international conference on World Wide Web. ACM. pp. 1177-1178.
+ *
+ * With the Hamming distance, the binary features are clustered with k-majority instead:
+ * each bit of a center is the majority bit of the features of its cluster.
+ *
+ *  Grana, C. et al. (2013). "A Fast Approach for Integrating ORB Descriptors
+ *  in the Bag of Words Model" Proceedings of SPIE-IS&T Electronic Imaging.
  */
 template<class Feature,
          class Distance = L2<Feature, Feature>,
@@ -304,6 +328,20 @@ public:
     restarts_ = restarts;
   }
 
+  size_t getMiniBatchSize() const
+  {
+    return mini_batch_size_;
+  }
+
+  /**
+   * @brief Set the number of features randomly drawn at each iteration (mini-batch k-means),
+   * 0 to use all the features at each iteration (Lloyd's algorithm).
+   */
+  void setMiniBatchSize(size_t miniBatchSize)
+  {
+    mini_batch_size_ = miniBatchSize;
+  }
+
   int getVerbose() const
   {
     return verbose_;
@@ -347,11 +385,40 @@ private:
                                     std::vector<Feature, FeatureAllocator>& centers,
                                     std::vector<unsigned int>& membership) const;
 
+  squared_distance_type clusterOnceMiniBatch(const std::vector<Feature*>& features, size_t k,
+                                             std::vector<Feature, FeatureAllocator>& centers,
+                                             std::vector<unsigned int>& membership) const;
+
+  /**
+   * @brief k-majority clustering of binary features (Hamming distance).
+   *        The features are stored in place, the bits of each byte from the lowest.
+   */
+  squared_distance_type clusterOnceKMajority(const std::vector<Feature*>& features, size_t k,
+                                             std::vector<Feature, FeatureAllocator>& centers,
+                                             std::vector<unsigned int>& membership) const;
+
+  /// Find the nearest cluster center to a feature
+  unsigned int nearestCenter(const Feature& feature, const std::vector<Feature, FeatureAllocator>& centers, size_t k) const;
+
+  /**
+   * @brief Sum the per thread accumulators of the cluster centers and their membership counts.
+   */
+  void mergeAccumulators(const std::vector<std::vector<Feature, FeatureAllocator> >& thread_centers,
+                         const std::vector<std::vector<size_t> >& thread_counts,
+                         std::vector<Feature, FeatureAllocator>& sum_centers,
+                         std::vector<size_t>& sum_counts) const;
+
+  /// Compute the sum squared error of the clustering
+  squared_distance_type computeSSE(const std::vector<Feature*>& features,
+                                   const std::vector<Feature, FeatureAllocator>& centers,
+                                   const std::vector<unsigned int>& membership) const;
+
   Feature zero_;
   Distance distance_;
   Initializer choose_centers_;
   size_t max_iterations_;
   size_t restarts_;
+  size_t mini_batch_size_;
   int verbose_;
 };
 
@@ -362,8 +429,9 @@ distance_(d),
 //    choose_centers_( InitRandom( ) ),
 choose_centers_(InitKmeanspp()),
 max_iterations_(100),
-verbose_(verbose),
-restarts_(1)
+restarts_(1),
+mini_batch_size_(0),
+verbose_(verbose)
 {
 }
 
@@ -411,79 +479,125 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::ve
   return least_sse;
 }
 
+template < class Feature, class Distance, class FeatureAllocator >
+unsigned int SimpleKmeans<Feature, Distance, FeatureAllocator>::nearestCenter(const Feature& feature,
+                                                                            const std::vector<Feature, FeatureAllocator>& centers,
+                                                                            size_t k) const
+{
+  squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
+  unsigned int nearest = 0;
+  bool found = false;
+
+  // @todo if k is large, let's say k>100 use FLAAN to retrieve the 
+  // cluster center
+  for(unsigned int j = 0; j < k; ++j)
+  {
+    squared_distance_type distance = distance_(feature, centers[j]);
+    if(distance < d_min)
+    {
+      d_min = distance;
+      nearest = j;
+      found = true;
+    }
+  }
+  assert(found);
+  return nearest;
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+void SimpleKmeans<Feature, Distance, FeatureAllocator>::mergeAccumulators(const std::vector<std::vector<Feature, FeatureAllocator> >& thread_centers,
+                                                                          const std::vector<std::vector<size_t> >& thread_counts,
+                                                                          std::vector<Feature, FeatureAllocator>& sum_centers,
+                                                                          std::vector<size_t>& sum_counts) const
+{
+  std::fill(sum_centers.begin(), sum_centers.end(), zero_);
+  std::fill(sum_counts.begin(), sum_counts.end(), 0);
+  for(size_t t = 0; t < thread_centers.size(); ++t)
+  {
+    for(size_t j = 0; j < sum_centers.size(); ++j)
+    {
+      if(thread_counts[t][j] == 0)
+        continue;
+      sum_centers[j] += thread_centers[t][j];
+      sum_counts[j] += thread_counts[t][j];
+    }
+  }
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::computeSSE(const std::vector<Feature*>& features,
+                                                              const std::vector<Feature, FeatureAllocator>& centers,
+                                                              const std::vector<unsigned int>& membership) const
+{
+  /// @todo Kahan summation?
+  squared_distance_type sse = squared_distance_type(0);
+  assert(features.size() > 0);
+  #pragma omp parallel for reduction(+:sse)
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+  {
+    sse += distance_(*features[i], centers[membership[i]]);
+  }
+  return sse;
+}
+
 template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector<Feature*>& features, size_t k,
                                                                std::vector<Feature, FeatureAllocator>& centers,
                                                                std::vector<unsigned int>& membership) const
 {
-  typedef typename std::vector<Feature, FeatureAllocator>::value_type centerType;
-  typedef typename Distance::value_type feature_value_type;
+  if(detail::IsHamming<Distance>::value)
+    return clusterOnceKMajority(features, k, centers, membership);
+
+  if(mini_batch_size_ > 0 && mini_batch_size_ < features.size())
+    return clusterOnceMiniBatch(features, k, centers, membership);
 
   std::vector<size_t> new_center_counts(k);
   std::vector<Feature, FeatureAllocator> new_centers(k);
   squared_distance_type max_center_shift = std::numeric_limits<squared_distance_type>::max();
 
+  // per thread accumulators of the new centers
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::vector<Feature, FeatureAllocator> > thread_centers(nbThreads, std::vector<Feature, FeatureAllocator>(k, zero_));
+  std::vector<std::vector<size_t> > thread_counts(nbThreads, std::vector<size_t>(k));
+
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Iterations");
   for(size_t iter = 0; iter < max_iterations_; ++iter)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
     // Zero out new centers and counts
-    std::fill(new_center_counts.begin(), new_center_counts.end(), 0);
-    //		for(size_t i = 0; i < k; checkElements(new_centers[i++], "bef"));
-    std::fill(new_centers.begin(), new_centers.end(), zero_);
-    //		for(size_t i = 0; i < k; checkElements(new_centers[i++], "aft"));
-    assert(checkVectorElements(new_centers, "newcenters init"));
-    bool is_stable = true;
-
+    for(int t = 0; t < nbThreads; ++t)
+    {
+      std::fill(thread_centers[t].begin(), thread_centers[t].end(), zero_);
+      std::fill(thread_counts[t].begin(), thread_counts[t].end(), 0);
+    }
+    int is_stable = 1;
 
     // Assign data objects to current centers
-    #pragma omp parallel for shared( new_centers, new_center_counts, features, centers, membership)
+    #pragma omp parallel for reduction(&&:is_stable)
     for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
     {
-      squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
-      unsigned int nearest = 0;
-      bool found = false;
-
-      // @todo if k is large, let's say k>100 use FLAAN to retrieve the 
-      // cluster center
-
       // Find the nearest cluster center to feature i
-      for(unsigned int j = 0; j < k; ++j)
-      {
-        squared_distance_type distance = distance_(*features[i], centers[j]);
-        //		printf("\t\tdistance %f\n", (float)distance);
-        //		PrintFeat(*features[i] );
-        if(distance < d_min)
-        {
-          d_min = distance;
-          nearest = j;
-          found = true;
-        }
-        //		 printf("\t distance %f %f\n", (double)distance, (double)d_min);
-      }
-      assert(found);
+      const unsigned int nearest = nearestCenter(*features[i], centers, k);
+
       // Assign feature i to the cluster it is nearest to
       if(membership[i] != nearest)
       {
-        is_stable = false;
+        is_stable = 0;
         membership[i] = nearest;
       }
       // Accumulate the cluster center and its membership count
-      //	  printf("\t nearest %d\n", nearest);
-      //			checkElements(*features[i], "feat");
-      #pragma omp critical
-      {
-        new_centers[nearest] += *features[i];
-        //			checkElements(new_centers[nearest], "sum");
-        //	  printf("\t new_centers[nearest] += *features[i];\n");
-        ++new_center_counts[nearest];
-        //	  printf("\taccumulate\n");
-      }
+      const int thread = omp_get_thread_num();
+      thread_centers[thread][nearest] += *features[i];
+      ++thread_counts[thread][nearest];
     }//for
 
     if(is_stable) break;
 
+    mergeAccumulators(thread_centers, thread_counts, new_centers, new_center_counts);
+    assert(checkVectorElements(new_centers, "newcenters"));
+
     if(iter > 0)
       max_center_shift = 0;
     // Assign new centers
@@ -491,9 +605,6 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
     {
       if(new_center_counts[i] > 0)
       {
-        //		  printf("%d - %d\n", i, new_center_counts[i] );
-        //		  PrintFeat(new_centers[i] );
-        //		checkElements(new_centers[i], "bef");
         new_centers[i] = new_centers[i] / new_center_counts[i];
 
         squared_distance_type shift = distance_(new_centers[i], centers[i]);
@@ -501,9 +612,6 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
         max_center_shift = std::max(max_center_shift, shift);
 
         centers[i] = new_centers[i];
-        //					centers[i] = new_centers[i] / new_center_counts[i];
-        //		checkElements(new_centers[i], "aft");
-        //		PrintFeat(centers[i] );
       }
       else
       {
@@ -520,14 +628,177 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
 
   // Return the sum squared error
-  /// @todo Kahan summation?
-  squared_distance_type sse = squared_distance_type(0);
-  assert(features.size() > 0);
-  for(size_t i = 0; i < features.size(); ++i)
+  return computeSSE(features, centers, membership);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnceMiniBatch(const std::vector<Feature*>& features, size_t k,
+                                                                        std::vector<Feature, FeatureAllocator>& centers,
+                                                                        std::vector<unsigned int>& membership) const
+{
+  typedef typename Distance::value_type feature_value_type;
+
+  // number of features assigned to each center since the beginning (the inverse of the learning rate)
+  std::vector<size_t> center_counts(k, 0);
+  std::vector<size_t> batch_counts(k);
+  std::vector<Feature, FeatureAllocator> batch_centers(k);
+  std::vector<size_t> batch(mini_batch_size_);
+
+  // per thread accumulators of the batch centers
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::vector<Feature, FeatureAllocator> > thread_centers(nbThreads, std::vector<Feature, FeatureAllocator>(k, zero_));
+  std::vector<std::vector<size_t> > thread_counts(nbThreads, std::vector<size_t>(k));
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Mini-batch iterations (batch size: " << mini_batch_size_ << ")");
+  for(size_t iter = 0; iter < max_iterations_; ++iter)
   {
-    sse += distance_(*features[i], centers[membership[i]]);
+    if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
+    // Draw the features of the batch
+    for(size_t b = 0; b < batch.size(); ++b)
+      batch[b] = rand() % features.size();
+
+    for(int t = 0; t < nbThreads; ++t)
+    {
+      std::fill(thread_centers[t].begin(), thread_centers[t].end(), zero_);
+      std::fill(thread_counts[t].begin(), thread_counts[t].end(), 0);
+    }
+
+    // Assign the batch features to the current centers
+    #pragma omp parallel for
+    for(ptrdiff_t b = 0; b < static_cast<ptrdiff_t>(batch.size()); ++b)
+    {
+      const Feature& feature = *features[batch[b]];
+      const unsigned int nearest = nearestCenter(feature, centers, k);
+      const int thread = omp_get_thread_num();
+      thread_centers[thread][nearest] += feature;
+      ++thread_counts[thread][nearest];
+    }
+
+    mergeAccumulators(thread_centers, thread_counts, batch_centers, batch_counts);
+
+    // Move each center towards its batch features, with a learning rate
+    // of 1 / (number of features assigned to the center so far)
+    squared_distance_type max_center_shift = 0;
+    for(size_t j = 0; j < k; ++j)
+    {
+      if(batch_counts[j] == 0)
+        continue;
+      center_counts[j] += batch_counts[j];
+
+      Feature new_center = centers[j];
+      new_center *= static_cast<feature_value_type>(center_counts[j] - batch_counts[j]);
+      new_center += batch_centers[j];
+      new_center = new_center / center_counts[j];
+
+      max_center_shift = std::max(max_center_shift, distance_(new_center, centers[j]));
+      centers[j] = new_center;
+    }
+    if(max_center_shift <= 10e-10) break;
   }
-  return sse;
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
+
+  // Assign all the features to the final centers
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+  {
+    membership[i] = nearestCenter(*features[i], centers, k);
+  }
+
+  // Return the sum squared error
+  return computeSSE(features, centers, membership);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnceKMajority(const std::vector<Feature*>& features, size_t k,
+                                                                        std::vector<Feature, FeatureAllocator>& centers,
+                                                                        std::vector<unsigned int>& membership) const
+{
+  const std::size_t nbBytes = sizeof(Feature);
+  const std::size_t nbBits = 8 * nbBytes;
+
+  // per thread accumulators of the number of features with each bit set, for each center
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::vector<uint32_t> > thread_bit_counts(nbThreads, std::vector<uint32_t>(k * nbBits));
+  std::vector<std::vector<size_t> > thread_counts(nbThreads, std::vector<size_t>(k));
+  std::vector<uint32_t> bit_counts(k * nbBits);
+  std::vector<size_t> center_counts(k);
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("k-majority iterations");
+  for(size_t iter = 0; iter < max_iterations_; ++iter)
+  {
+    if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
+    for(int t = 0; t < nbThreads; ++t)
+    {
+      std::fill(thread_bit_counts[t].begin(), thread_bit_counts[t].end(), 0);
+      std::fill(thread_counts[t].begin(), thread_counts[t].end(), 0);
+    }
+    int is_stable = 1;
+
+    // Assign data objects to current centers
+    #pragma omp parallel for reduction(&&:is_stable)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+    {
+      const unsigned int nearest = nearestCenter(*features[i], centers, k);
+      if(membership[i] != nearest)
+      {
+        is_stable = 0;
+        membership[i] = nearest;
+      }
+      // Accumulate the bits of the feature in its cluster
+      const int thread = omp_get_thread_num();
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(features[i]);
+      uint32_t* counts = thread_bit_counts[thread].data() + nearest * nbBits;
+      for(std::size_t b = 0; b < nbBytes; ++b)
+      {
+        for(unsigned int bit = 0; bit < 8; ++bit)
+          counts[8 * b + bit] += (bytes[b] >> bit) & 1;
+      }
+      ++thread_counts[thread][nearest];
+    }
+
+    if(is_stable) break;
+
+    std::fill(bit_counts.begin(), bit_counts.end(), 0);
+    std::fill(center_counts.begin(), center_counts.end(), 0);
+    for(int t = 0; t < nbThreads; ++t)
+    {
+      for(std::size_t j = 0; j < bit_counts.size(); ++j)
+        bit_counts[j] += thread_bit_counts[t][j];
+      for(std::size_t j = 0; j < k; ++j)
+        center_counts[j] += thread_counts[t][j];
+    }
+
+    // Assign new centers: the majority bits of their cluster
+    for(size_t j = 0; j < k; ++j)
+    {
+      if(center_counts[j] == 0)
+      {
+        // Choose a new center randomly from the input features
+        unsigned int index = rand() % features.size();
+        centers[j] = *features[index];
+        ALICEVISION_LOG_DEBUG("Choosing a new center: " << index);
+        continue;
+      }
+      unsigned char* center = reinterpret_cast<unsigned char*>(&centers[j]);
+      const uint32_t* counts = bit_counts.data() + j * nbBits;
+      for(std::size_t b = 0; b < nbBytes; ++b)
+      {
+        unsigned char byte = 0;
+        for(unsigned int bit = 0; bit < 8; ++bit)
+        {
+          if(2 * counts[8 * b + bit] > center_counts[j])
+            byte |= static_cast<unsigned char>(1 << bit);
+        }
+        center[b] = byte;
+      }
+    }
+  }
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
+
+  // Return the sum of the distances
+  return computeSSE(features, centers, membership);
 }
 
 }
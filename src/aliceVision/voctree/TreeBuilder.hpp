@@ -8,7 +8,10 @@
 
 #include "MutableVocabularyTree.hpp"
 #include "SimpleKmeans.hpp"
-#include <deque>
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <vector>
 //#include <cstdio> //DEBUG
 
 namespace aliceVision {
@@ -105,29 +108,39 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
   tree_.centers().reserve(tree_.nodes());
   tree_.validCenters().reserve(tree_.nodes());
 
-  // We keep a queue of disjoint feature subsets to cluster.
+  // We keep the disjoint feature subsets to cluster at the current level,
+  // in the order of their nodes in the tree.
   // Feature* is used to avoid copying features.
-  std::deque< std::vector<Feature*> > subset_queue(1);
+  std::vector< std::vector<Feature*> > subsets(1);
 
   {
-    // At first the queue contains one "subset" containing all the features.
-    std::vector<Feature*> &feature_ptrs = subset_queue.front();
+    // At first there is one "subset" containing all the features.
+    std::vector<Feature*> &feature_ptrs = subsets.front();
     feature_ptrs.reserve(training_features.size());
     for(const Feature& f: training_features)
     {
       feature_ptrs.push_back(const_cast<Feature*> (&f));
     }
   }
-  FeatureVector centers; // always size k
   for(uint32_t level = 0; level < levels; ++level)
   {
     if(verbose_) printf("# Level %u\n", level);
-    std::vector<unsigned int> membership;
 
-    for(size_t i = 0, ie = subset_queue.size(); i < ie; ++i)
+    const std::size_t nbSubsets = subsets.size();
+    const std::size_t firstCenter = tree_.centers().size();
+    tree_.centers().resize(firstCenter + nbSubsets * k, zero_);
+    tree_.validCenters().resize(firstCenter + nbSubsets * k, 0);
+    // the k children subsets of each subset
+    std::vector< std::vector<Feature*> > new_subsets(nbSubsets * k);
+
+    // The subsets are clustered in parallel when there are enough of them,
+    // otherwise the k-means of each subset is parallel.
+    #pragma omp parallel for schedule(dynamic) if(nbSubsets >= static_cast<std::size_t>(omp_get_max_threads()))
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbSubsets); ++i)
     {
-      std::vector<Feature*> &subset = subset_queue.front();
-      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, ie, subset.size());
+      std::vector<Feature*> &subset = subsets[i];
+      const std::size_t subsetFirstCenter = firstCenter + i * k;
+      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, nbSubsets, subset.size());
 
       // If the subset already has k or fewer elements, just use those as the centers.
       if(subset.size() <= k)
@@ -135,39 +148,33 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
         if(verbose_ > 2) printf("#\tno need to cluster %lu elements\n", subset.size());
         for(size_t j = 0; j < subset.size(); ++j)
         {
-          tree_.centers().push_back(*subset[j]);
-          tree_.validCenters().push_back(1);
+          tree_.centers()[subsetFirstCenter + j] = *subset[j];
+          tree_.validCenters()[subsetFirstCenter + j] = 1;
         }
-        // Mark non-existent centers as invalid.
-        tree_.centers().insert(tree_.centers().end(), k - subset.size(), zero_);
-        tree_.validCenters().insert(tree_.validCenters().end(), k - subset.size(), 0);
-
-        // Push k empty subsets into the queue so all children get marked invalid.
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), k, std::vector<Feature*>());
+        // The non-existent centers stay invalid and all the children subsets are empty.
       }
       else
       {
         // Cluster the current subset into k centers.
         if(verbose_ > 2) printf("#\tclustering the current subset of %lu elements into %d centers\n", subset.size(), k);
+        FeatureVector centers; // always size k
+        std::vector<unsigned int> membership;
         kmeans_.clusterPointers(subset, k, centers, membership);
         // Add the centers and mark them as valid.
-        tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
-        tree_.validCenters().insert(tree_.validCenters().end(), k, 1);
+        std::copy(centers.begin(), centers.end(), tree_.centers().begin() + subsetFirstCenter);
+        std::fill(tree_.validCenters().begin() + subsetFirstCenter, tree_.validCenters().begin() + subsetFirstCenter + k, 1);
         // Partition the current subset into k new subsets based on the cluster assignments.
-        std::vector< std::vector<Feature*> > new_subsets(k);
         assert(membership.size() >= subset.size());
         for(size_t j = 0; j < subset.size(); ++j)
         {
           assert(membership[j] < k);
-          assert(membership[j] < new_subsets.size());
-          new_subsets[ membership[j] ].push_back(subset[j]);
+          new_subsets[i * k + membership[j]].push_back(subset[j]);
         }
-        // Update the queue
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), new_subsets.begin(), new_subsets.end());
       }
+      // Release the subset, its features are now in the children subsets.
+      std::vector<Feature*>().swap(subset);
     }
+    subsets.swap(new_subsets);
     if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
   }
 }
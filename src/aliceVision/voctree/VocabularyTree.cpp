@@ -6,10 +6,12 @@
 
 #include "VocabularyTree.hpp"
 
+#include <cmath>
+
 namespace aliceVision {
 namespace voctree {
 
-float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const float* word_weights)
 {
 
   float distance = 0.0f;
@@ -34,7 +36,7 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
       }
       else
       {
-        distance += fabs(i1->second.size() - i2->second.size());
+        distance += std::fabs(double(i1->second.size()) - double(i2->second.size()));
         ++i1;
         ++i2;
       }
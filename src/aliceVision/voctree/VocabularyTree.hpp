@@ -16,14 +16,27 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/system/Logger.hpp>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <Eigen/Core>
+
 #include <stdint.h>
+#include <algorithm>
 #include <vector>
 #include <map>
+#include <memory>
 #include <cassert>
+#include <cstring>
 #include <limits>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <type_traits>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ALICEVISION_VOCTREE_SSE2
+#endif
 
 
 namespace aliceVision {
@@ -88,6 +101,71 @@ public:
 
 inline IVocabularyTree::~IVocabularyTree() {}
 
+namespace detail {
+
+/// number of children centers compared together by the flat quantizer
+const uint32_t flatLanes = 4;
+
+/**
+ * @brief Check if the distance between DescriptorT and Feature is the generic L2 functor,
+ * which the flat quantizer computes lane by lane with the same operations.
+ */
+template<class DescriptorT, class Feature, template<typename, typename> class Distance>
+struct IsFlatL2
+{
+  static const bool value = std::is_same<Distance<DescriptorT, Feature>, L2<DescriptorT, Feature> >::value &&
+                            !std::is_base_of<Eigen::EigenBase<DescriptorT>, DescriptorT>::value &&
+                            !std::is_base_of<Eigen::EigenBase<Feature>, Feature>::value;
+};
+
+/**
+ * @brief Accumulate the L2 distances of a feature to Lanes children centers.
+ * @param[in] centers The first component of the first child, the components are paddedSplits apart
+ * @param[out] distances The distances of the children
+ */
+template<uint32_t Lanes, class DescriptorT, class T>
+inline void flatL2(const DescriptorT& feature, const T* centers, std::size_t dimension, uint32_t paddedSplits, double* distances)
+{
+  double result[Lanes] = {};
+  for(std::size_t i = 0; i < dimension; ++i, centers += paddedSplits)
+  {
+    const double value = (double)feature[i];
+    for(uint32_t lane = 0; lane < Lanes; ++lane)
+    {
+      const double diff = value - (double)centers[lane];
+      result[lane] += diff * diff;
+    }
+  }
+  std::copy(result, result + Lanes, distances);
+}
+
+#ifdef ALICEVISION_VOCTREE_SSE2
+template<uint32_t Lanes, class DescriptorT>
+inline void flatL2(const DescriptorT& feature, const float* centers, std::size_t dimension, uint32_t paddedSplits, double* distances)
+{
+  static_assert(Lanes % flatLanes == 0, "the lanes are processed by groups of 4");
+  __m128d result[Lanes / 2];
+  for(uint32_t j = 0; j < Lanes / 2; ++j)
+    result[j] = _mm_setzero_pd();
+  for(std::size_t i = 0; i < dimension; ++i, centers += paddedSplits)
+  {
+    const __m128d value = _mm_set1_pd((double)feature[i]);
+    for(uint32_t j = 0; j < Lanes / 4; ++j)
+    {
+      const __m128 c = _mm_loadu_ps(centers + 4 * j);
+      const __m128d diffLow = _mm_sub_pd(value, _mm_cvtps_pd(c));
+      const __m128d diffHigh = _mm_sub_pd(value, _mm_cvtps_pd(_mm_movehl_ps(c, c)));
+      result[2 * j] = _mm_add_pd(result[2 * j], _mm_mul_pd(diffLow, diffLow));
+      result[2 * j + 1] = _mm_add_pd(result[2 * j + 1], _mm_mul_pd(diffHigh, diffHigh));
+    }
+  }
+  for(uint32_t j = 0; j < Lanes / 2; ++j)
+    _mm_storeu_pd(distances + 2 * j, result[j]);
+}
+#endif
+
+} // namespace detail
+
 /**
  * @brief Optimized vocabulary tree quantizer, templated on feature type and distance metric
  * for maximum efficiency.
@@ -99,6 +177,14 @@ inline IVocabularyTree::~IVocabularyTree() {}
  * a metric; distances simply need to be comparable.
  *
  * \c FeatureAllocator is an STL-compatible allocator used to allocate Features internally.
+ *
+ * The vocabulary file is memory-mapped by load() and the centers are used in place when their
+ * alignment allows it, so the processes using the same vocabulary share its pages.
+ *
+ * load() also stores the children centers of each node component-major (flat centers),
+ * so the distances of a feature to several children are computed together with SIMD.
+ * Every child distance is accumulated in the same order as the Distance functor,
+ * so the flat quantizer gives the same words.
  */
 template<class Feature, template<typename, typename> class Distance = L2, // TODO: rename Feature into Descriptor
 class FeatureAllocator = typename DefaultAllocator<Feature>::type>
@@ -148,8 +234,9 @@ public:
 
   bool operator==(const VocabularyTree& other) const
   {
-    return (centers_ == other.centers_) &&
-        (valid_centers_ == other.valid_centers_) &&
+    return (nbCenters() == other.nbCenters()) &&
+        std::equal(centersData(), centersData() + nbCenters(), other.centersData()) &&
+        std::equal(validCentersData(), validCentersData() + nbCenters(), other.validCentersData()) &&
         (k_ == other.k_) &&
         (levels_ == other.levels_) &&
         (num_words_ == other.num_words_) &&
@@ -160,6 +247,19 @@ protected:
   std::vector<Feature, FeatureAllocator> centers_;
   std::vector<uint8_t> valid_centers_; /// @todo Consider bit-vector
 
+  /// the memory-mapped vocabulary file, if the centers are read in place
+  std::shared_ptr<boost::iostreams::mapped_file_source> mapped_file_;
+  const Feature* mapped_centers_ = nullptr;
+  const uint8_t* mapped_valid_centers_ = nullptr;
+  std::size_t mapped_size_ = 0;
+
+  /// children centers of each node: component-major, padded to flat_splits_ children (empty if not used)
+  std::vector<typename Feature::value_type> flat_centers_;
+  /// number of valid children of each node
+  std::vector<uint32_t> flat_nb_children_;
+  uint32_t flat_splits_ = 0;
+  std::size_t flat_dimension_ = 0;
+
   uint32_t k_; // splits, or branching factor
   uint32_t levels_;
   uint32_t num_words_; // number of leaf nodes
@@ -170,6 +270,40 @@ protected:
     return num_words_ != 0;
   }
 
+  std::size_t nbCenters() const
+  {
+    return mapped_centers_ ? mapped_size_ : centers_.size();
+  }
+
+  const Feature* centersData() const
+  {
+    return mapped_centers_ ? mapped_centers_ : centers_.data();
+  }
+
+  const uint8_t* validCentersData() const
+  {
+    return mapped_centers_ ? mapped_valid_centers_ : valid_centers_.data();
+  }
+
+  /**
+   * @brief Load vocabulary from a file.
+   * @param[in] file The vocabulary file path
+   * @param[in] allowMapping Use the centers in place in the memory-mapped file if possible,
+   *                         otherwise they are copied in centers_ and valid_centers_
+   */
+  void load(const std::string& file, bool allowMapping);
+
+  /// Build the flat centers from the centers, if the distance allows it
+  void setFlatCenters();
+
+  /// Find the child of the node closest to the feature with the flat centers
+  template<class DescriptorT>
+  int32_t flatBestChild(const DescriptorT& feature, int32_t index) const;
+
+  /// Quantize the features level by level with the flat centers
+  template<class DescriptorT>
+  void flatQuantize(const std::vector<DescriptorT>& features, std::vector<Word>& words) const;
+
   void setNodeCounts();
 };
 
@@ -195,6 +329,16 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
   //	printf("asserting\n");
   assert(initialized());
   //	printf("initialized\n");
+  if(detail::IsFlatL2<DescriptorT, Feature, Distance>::value && !flat_centers_.empty())
+  {
+    int32_t index = -1;
+    for(unsigned level = 0; level < levels_; ++level)
+      index = flatBestChild(feature, index);
+    return index - word_start_;
+  }
+
+  const Feature* centers = centersData();
+  const uint8_t* valid_centers = validCentersData();
   int32_t index = -1; // virtual "root" index, which has no associated center.
   for(unsigned level = 0; level < levels_; ++level)
   {
@@ -205,9 +349,9 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
     distance_type best_distance = std::numeric_limits<distance_type>::max();
     for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
     {
-      if(!valid_centers_[child])
+      if(!valid_centers[child])
         break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
+      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers[child]);
       if(child_distance < best_distance)
       {
         best_child = child;
@@ -227,6 +371,12 @@ std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(
   // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
   std::vector<Word> imgVisualWords(features.size(), 0);
 
+  if(detail::IsFlatL2<DescriptorT, Feature, Distance>::value && !flat_centers_.empty())
+  {
+    flatQuantize(features, imgVisualWords);
+    return imgVisualWords;
+  }
+
   // quantize the features
   #pragma omp parallel for
   for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
@@ -249,6 +399,94 @@ SparseHistogram VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeToS
   return histo;
 }
 
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+int32_t VocabularyTree<Feature, Distance, FeatureAllocator>::flatBestChild(const DescriptorT& feature, int32_t index) const
+{
+  // the node ordinal is index + 1, the virtual root being 0
+  const std::size_t node = index + 1;
+  const auto* centers = flat_centers_.data() + node * flat_dimension_ * flat_splits_;
+  const uint32_t nbChildren = flat_nb_children_[node];
+
+  double distances[2 * detail::flatLanes];
+  int32_t best_child = node * splits();
+  double best_distance = std::numeric_limits<double>::max();
+  for(uint32_t first = 0; first < nbChildren; first += 2 * detail::flatLanes)
+  {
+    // children by groups of 8 (or of 4 for the last ones)
+    uint32_t nbLanes = 2 * detail::flatLanes;
+    if(first + detail::flatLanes >= nbChildren || first + 2 * detail::flatLanes > flat_splits_)
+    {
+      nbLanes = detail::flatLanes;
+      detail::flatL2<detail::flatLanes>(feature, centers + first, flat_dimension_, flat_splits_, distances);
+    }
+    else
+      detail::flatL2<2 * detail::flatLanes>(feature, centers + first, flat_dimension_, flat_splits_, distances);
+
+    // same comparisons as quantize(), in the children order
+    for(uint32_t lane = 0; lane < nbLanes && first + lane < nbChildren; ++lane)
+    {
+      if(distances[lane] < best_distance)
+      {
+        best_child = node * splits() + first + lane;
+        best_distance = distances[lane];
+      }
+    }
+  }
+  return best_child;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::flatQuantize(const std::vector<DescriptorT>& features, std::vector<Word>& words) const
+{
+  std::vector<int32_t> indexes(features.size(), -1);
+
+  // all the features descend one level at a time, so the centers of the upper levels are shared in cache
+  for(unsigned level = 0; level < levels_; ++level)
+  {
+    #pragma omp parallel for
+    for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
+      indexes[j] = flatBestChild(features[j], indexes[j]);
+  }
+
+  for(std::size_t j = 0; j < features.size(); ++j)
+    words[j] = indexes[j] - word_start_;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::setFlatCenters()
+{
+  flat_centers_.clear();
+  flat_nb_children_.clear();
+  flat_splits_ = 0;
+  flat_dimension_ = 0;
+  if(!detail::IsFlatL2<Feature, Feature, Distance>::value || !initialized() || nbCenters() == 0)
+    return;
+
+  const Feature* centers = centersData();
+  const uint8_t* valid_centers = validCentersData();
+  const std::size_t nbNodes = nbCenters() / splits();
+  flat_splits_ = (splits() + detail::flatLanes - 1) / detail::flatLanes * detail::flatLanes;
+  flat_dimension_ = centers[0].size();
+  flat_centers_.assign(nbNodes * flat_dimension_ * flat_splits_, 0);
+  flat_nb_children_.assign(nbNodes, 0);
+
+  for(std::size_t node = 0; node < nbNodes; ++node)
+  {
+    auto* nodeCenters = flat_centers_.data() + node * flat_dimension_ * flat_splits_;
+    for(uint32_t c = 0; c < splits(); ++c)
+    {
+      const std::size_t child = node * splits() + c;
+      if(!valid_centers[child])
+        break; // Fewer than splits() children.
+      for(std::size_t i = 0; i < flat_dimension_; ++i)
+        nodeCenters[i * flat_splits_ + c] = centers[child][i];
+      ++flat_nb_children_[node];
+    }
+  }
+}
+
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 uint32_t VocabularyTree<Feature, Distance, FeatureAllocator>::levels() const
 {
@@ -272,6 +510,14 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::clear()
 {
   centers_.clear();
   valid_centers_.clear();
+  mapped_file_.reset();
+  mapped_centers_ = nullptr;
+  mapped_valid_centers_ = nullptr;
+  mapped_size_ = 0;
+  flat_centers_.clear();
+  flat_nb_children_.clear();
+  flat_splits_ = 0;
+  flat_dimension_ = 0;
   k_ = levels_ = num_words_ = word_start_ = 0;
 }
 
@@ -285,37 +531,66 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::save(const std::string
   std::ofstream out(file.c_str(), std::ios_base::binary);
   out.write((char*) (&k_), sizeof (uint32_t));
   out.write((char*) (&levels_), sizeof (uint32_t));
-  uint32_t size = centers_.size();
+  uint32_t size = nbCenters();
   out.write((char*) (&size), sizeof (uint32_t));
-  out.write((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
-  out.write((char*) (&valid_centers_[0]), valid_centers_.size());
+  out.write((char*) (centersData()), size * sizeof (Feature));
+  out.write((char*) (validCentersData()), size);
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string& file)
 {
-  clear();
+  load(file, true);
+  setFlatCenters();
+}
 
-  std::ifstream in;
-  in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string& file, bool allowMapping)
+{
+  clear();
 
-  uint32_t size;
+  // file layout: k, levels, number of centers (uint32), the centers then the valid flags
+  const std::size_t headerSize = 3 * sizeof(uint32_t);
+  std::shared_ptr<boost::iostreams::mapped_file_source> mappedFile;
   try
   {
-    in.open(file.c_str(), std::ios_base::binary);
-    in.read((char*) (&k_), sizeof (uint32_t));
-    in.read((char*) (&levels_), sizeof (uint32_t));
-    in.read((char*) (&size), sizeof (uint32_t));
-    centers_.resize(size);
-    valid_centers_.resize(size);
-    in.read((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
-    in.read((char*) (&valid_centers_[0]), valid_centers_.size());
+    mappedFile = std::make_shared<boost::iostreams::mapped_file_source>(file);
   }
-  catch(std::ifstream::failure& e)
+  catch(std::exception& e)
   {
     throw std::runtime_error("Failed to load vocabulary tree file" + file);
   }
 
+  uint32_t size = 0;
+  if(mappedFile->size() < headerSize)
+    throw std::runtime_error("Failed to load vocabulary tree file" + file);
+  std::memcpy(&k_, mappedFile->data(), sizeof(uint32_t));
+  std::memcpy(&levels_, mappedFile->data() + sizeof(uint32_t), sizeof(uint32_t));
+  std::memcpy(&size, mappedFile->data() + 2 * sizeof(uint32_t), sizeof(uint32_t));
+  if(mappedFile->size() < headerSize + std::size_t(size) * (sizeof(Feature) + 1))
+  {
+    k_ = levels_ = 0;
+    throw std::runtime_error("Failed to load vocabulary tree file" + file);
+  }
+
+  const char* centers = mappedFile->data() + headerSize;
+  const char* validCenters = centers + std::size_t(size) * sizeof(Feature);
+
+  if(allowMapping && reinterpret_cast<std::uintptr_t>(centers) % alignof(Feature) == 0)
+  {
+    mapped_file_ = mappedFile;
+    mapped_centers_ = reinterpret_cast<const Feature*>(centers);
+    mapped_valid_centers_ = reinterpret_cast<const uint8_t*>(validCenters);
+    mapped_size_ = size;
+  }
+  else
+  {
+    centers_.resize(size);
+    valid_centers_.resize(size);
+    std::memcpy((char*) (centers_.data()), centers, std::size_t(size) * sizeof(Feature));
+    std::memcpy((char*) (valid_centers_.data()), validCenters, size);
+  }
+
   setNodeCounts();
   assert(size == num_words_ + word_start_);
 }
@@ -338,10 +613,10 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::setNodeCounts()
  * @param v1 The first sparse histogram
  * @param v2 The second sparse histogram
  * @param distanceMethod distance method (norm L1, etc.)
- * @param word_weights 
+ * @param word_weights The weights of the words (required by the weighted distance methods)
  * @return the distance of the two histograms
  */
-float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod = "classic", const std::vector<float>& word_weights = std::vector<float>());
+float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod = "classic", const float* word_weights = nullptr);
 
 inline std::unique_ptr<IVocabularyTree> createVoctreeForDescriberType(feature::EImageDescriberType imageDescriberType)
 {
@@ -353,7 +628,7 @@ inline std::unique_ptr<IVocabularyTree> createVoctreeForDescriberType(feature::E
     case EImageDescriberType::SIFT:       res.reset(new VocabularyTree<SIFT_Regions::DescriptorT>); break;
     case EImageDescriberType::SIFT_FLOAT: res.reset(new VocabularyTree<SIFT_Float_Regions::DescriptorT>); break;
     case EImageDescriberType::AKAZE:      res.reset(new VocabularyTree<AKAZE_Float_Regions::DescriptorT>); break;
-    case EImageDescriberType::AKAZE_MLDB: res.reset(new VocabularyTree<AKAZE_BinaryRegions::DescriptorT>); break;
+    case EImageDescriberType::AKAZE_MLDB: res.reset(new VocabularyTree<AKAZE_BinaryRegions::DescriptorT, Hamming>); break;
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
     case EImageDescriberType::CCTAG3:
@@ -8,6 +8,10 @@
 
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
+#include <aliceVision/voctree/sparseHistogramIO.hpp>
+
+#include <cstdint>
+#include <map>
 
 #include <string>
 #include <vector>
@@ -20,6 +24,23 @@ class SfMData;
 
 namespace voctree {
 
+/**
+ * @brief Quantize the descriptors of each image in parallel
+ *
+ * @param[in] descriptorsFiles The descriptor file of each image
+ * @param[in] tree The vocabulary tree to be used for feature quantization
+ * @param[out] histograms The sparse histogram of each image
+ * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0, all the descriptors are loaded.
+ * @param[in] treeSignature If not 0, the histograms are cached next to the descriptor files (see getVocabularyTreeSignature)
+ * @return the number of overall features read
+ */
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
+std::size_t computeSparseHistograms(const std::map<IndexT, std::string>& descriptorsFiles,
+                                    const VocabularyTree<VocDescriptorT, VocDistance>& tree,
+                                    SparseHistogramPerImage& histograms,
+                                    const int Nmax = 0,
+                                    std::uint64_t treeSignature = 0);
+
 /**
  * @brief Given a vocabulary tree and a set of features it builds a database
  *
@@ -29,14 +50,18 @@ namespace voctree {
  * @param[out] db The built database
  * @param[out] documents A map containing for each image the list of associated visual words
  * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0 (default), all the descriptors are loaded.
+ * @param[in] treeSignature If not 0, the histograms are cached next to the descriptor files (see getVocabularyTreeSignature)
+ * @param[in] descType The describer type of the descriptor files
  * @return the number of overall features read
  */
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 std::size_t populateDatabase(const sfm::SfMData& sfmData,
                              const std::vector<std::string>& featuresFolders,
-                             const VocabularyTree<VocDescriptorT>& tree,
+                             const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                              Database& db,
-                             const int Nmax = 0);
+                             const int Nmax = 0,
+                             std::uint64_t treeSignature = 0,
+                             feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT);
 
 /**
  * @brief Given an non empty database, it queries the database with a set of images
@@ -53,10 +78,10 @@ std::size_t populateDatabase(const sfm::SfMData& sfmData,
  * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0 (default), all the descriptors are loaded. 
  * @see queryDatabase()
  */
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 void queryDatabase(const sfm::SfMData& sfmData,
                    const std::vector<std::string>& featuresFolders,
-                   const VocabularyTree<VocDescriptorT>& tree,
+                   const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                    const Database& db,
                    size_t numResults,
                    std::map<size_t, DocMatches>& allMatches,
@@ -78,10 +103,10 @@ void queryDatabase(const sfm::SfMData& sfmData,
  * @param[in] distanceMethod The distance method used to create the pair list
  * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0 (default), all the descriptors are loaded.
  */
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 void queryDatabase(const sfm::SfMData& sfmData,
                    const std::vector<std::string>& featuresFolders,
-                   const VocabularyTree<VocDescriptorT>& tree,
+                   const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                    const Database& db,
                    size_t numResults,
                    std::map<size_t, DocMatches>& allMatches,
@@ -100,10 +125,10 @@ void queryDatabase(const sfm::SfMData& sfmData,
  * @param[in/out] globalHistogram The histogram of the "population" of voctree leaves. 
  * @see queryDatabase()
  */
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 void voctreeStatistics(const sfm::SfMData& sfmData,
                        const std::vector<std::string>& featuresFolders,
-                       const VocabularyTree<VocDescriptorT>& tree,
+                       const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                        const Database& db,
                        const std::string& distanceMethod,
                        std::map<int, int>& globalHistogram);
@@ -9,6 +9,7 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
@@ -21,50 +22,84 @@
 namespace aliceVision {
 namespace voctree {
 
-template<class DescriptorT, class VocDescriptorT>
-std::size_t populateDatabase(const sfm::SfMData& sfmData,
-                             const std::vector<std::string>& featuresFolders,
-                             const VocabularyTree<VocDescriptorT>& tree,
-                             Database& db,
-                             const int Nmax)
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
+std::size_t computeSparseHistograms(const std::map<IndexT, std::string>& descriptorsFiles,
+                                    const VocabularyTree<VocDescriptorT, VocDistance>& tree,
+                                    SparseHistogramPerImage& histograms,
+                                    const int Nmax,
+                                    std::uint64_t treeSignature)
 {
-  std::map<IndexT, std::string> descriptorsFiles;
-  getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
+  const std::vector<std::pair<IndexT, std::string>> files(descriptorsFiles.begin(), descriptorsFiles.end());
+  std::vector<SparseHistogram> computedHistograms(files.size());
   std::size_t numDescriptors = 0;
-  
-  // Read the descriptors
-  ALICEVISION_LOG_DEBUG("Reading the descriptors from " << descriptorsFiles.size() <<" files...");
-  boost::progress_display display(descriptorsFiles.size());
+  std::size_t nbCachedHistograms = 0;
 
-  // Run through the path vector and read the descriptors
-  for(const auto &currentFile : descriptorsFiles)
+  ALICEVISION_LOG_DEBUG("Reading the descriptors from " << files.size() <<" files...");
+  boost::progress_display display(files.size());
+
+  #pragma omp parallel for schedule(dynamic) reduction(+:numDescriptors,nbCachedHistograms)
+  for(int i = 0; i < static_cast<int>(files.size()); ++i)
   {
-    
-    std::vector<DescriptorT> descriptors;
+    const std::string& descriptorsFilepath = files[i].second;
+    std::size_t nbDescriptors = 0;
 
-    // Read the descriptors
-    loadDescsFromBinFile(currentFile.second, descriptors, false, Nmax);
-    size_t result = descriptors.size();
-    
-    SparseHistogram newDoc =  tree.quantizeToSparse(descriptors);
+    if(treeSignature != 0 && loadSparseHistogram(descriptorsFilepath, treeSignature, Nmax, computedHistograms[i], nbDescriptors))
+    {
+      ++nbCachedHistograms;
+    }
+    else
+    {
+      std::vector<DescriptorT> descriptors;
+      loadDescsFromBinFile(descriptorsFilepath, descriptors, false, Nmax);
+      nbDescriptors = descriptors.size();
+      computedHistograms[i] = tree.quantizeToSparse(descriptors);
 
-    // Insert document in database
-    db.insert(currentFile.first, newDoc);
+      if(treeSignature != 0 && !saveSparseHistogram(descriptorsFilepath, treeSignature, Nmax, computedHistograms[i], nbDescriptors))
+        ALICEVISION_LOG_WARNING("Can't write the cached histogram of: " << descriptorsFilepath);
+    }
+    numDescriptors += nbDescriptors;
 
-    // Update the overall counter
-    numDescriptors += result;
-    
-    ++display;
+    #pragma omp critical(computeSparseHistogramsProgress)
+    {
+      ++display;
+    }
   }
 
+  if(treeSignature != 0)
+    ALICEVISION_LOG_INFO(nbCachedHistograms << " / " << files.size() << " sparse histograms read from the cache.");
+
+  for(std::size_t i = 0; i < files.size(); ++i)
+    histograms[files[i].first].swap(computedHistograms[i]);
+
+  return numDescriptors;
+}
+
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
+std::size_t populateDatabase(const sfm::SfMData& sfmData,
+                             const std::vector<std::string>& featuresFolders,
+                             const VocabularyTree<VocDescriptorT, VocDistance>& tree,
+                             Database& db,
+                             const int Nmax,
+                             std::uint64_t treeSignature,
+                             feature::EImageDescriberType descType)
+{
+  std::map<IndexT, std::string> descriptorsFiles;
+  getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles, descType);
+
+  SparseHistogramPerImage histograms;
+  const std::size_t numDescriptors = computeSparseHistograms<DescriptorT>(descriptorsFiles, tree, histograms, Nmax, treeSignature);
+
+  // Insert the documents in the database
+  db.insert(histograms);
+
   // Return the result
   return numDescriptors;
 }
 
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 std::size_t populateDatabase(const sfm::SfMData& sfmData,
                              const std::vector<std::string>& featuresFolders,
-                             const VocabularyTree<VocDescriptorT>& tree,
+                             const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                              Database& db,
                              std::map<size_t, std::vector<DescriptorT>>& allDescriptors,
                              const int Nmax)
@@ -103,9 +138,9 @@ std::size_t populateDatabase(const sfm::SfMData& sfmData,
   return numDescriptors;
 }
 
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 void queryDatabase(const sfm::SfMData& sfmData,
-                   const VocabularyTree<VocDescriptorT>& tree,
+                   const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                    const Database& db,
                    size_t numResults,
                    std::map<size_t, DocMatches>& allDocMatches,
@@ -131,10 +166,10 @@ void queryDatabase(const sfm::SfMData& sfmData,
  * @param[in] distanceMethod The method used to compute distance between histograms.
  * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0 (default), all the descriptors are loaded.
  */
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 void queryDatabase(const sfm::SfMData& sfmData,
                    const std::vector<std::string>& featuresFolders,
-                   const VocabularyTree<VocDescriptorT>& tree,
+                   const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                    const Database& db,
                    size_t numResults,
                    std::map<size_t, DocMatches>& allDocMatches,
@@ -149,6 +184,8 @@ void queryDatabase(const sfm::SfMData& sfmData,
   ALICEVISION_LOG_DEBUG("queryDatabase: Reading the descriptors from " << descriptorsFiles.size() << " files...");
   boost::progress_display display(descriptorsFiles.size());
 
+  std::vector<SparseHistogram> queries(descriptorsFiles.size());
+
   #pragma omp parallel for
   // Run through the path vector and read the descriptors
   for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
@@ -161,28 +198,33 @@ void queryDatabase(const sfm::SfMData& sfmData,
     loadDescsFromBinFile(currentFileIt->second, descriptors, false, Nmax);
 
     // quantize the descriptors
-    SparseHistogram query = tree.quantizeToSparse(descriptors);
+    queries[i] = tree.quantizeToSparse(descriptors);
 
-    aliceVision::voctree::DocMatches docMatches;
-    // query the database
-    db.find(query, numResults, docMatches, distanceMethod);
     #pragma omp critical
     {
-      // add the vector to the documents
-      documents[currentFileIt->first] = query;
-
-      // add the matches to the result vector
-      allDocMatches[currentFileIt->first] = docMatches;
-
       ++display;
     }
   }
+
+  // query the database with all the documents together
+  std::vector<DocMatches> queriesMatches;
+  db.find(queries, numResults, queriesMatches, distanceMethod);
+
+  std::size_t i = 0;
+  for(const auto& currentFile : descriptorsFiles)
+  {
+    // add the matches to the result vector
+    allDocMatches[currentFile.first].swap(queriesMatches[i]);
+    // add the vector to the documents
+    documents[currentFile.first].swap(queries[i]);
+    ++i;
+  }
 }
 
-template<class DescriptorT, class VocDescriptorT>
+template<class DescriptorT, class VocDescriptorT, template<typename, typename> class VocDistance>
 void voctreeStatistics(const sfm::SfMData& sfmData,
                        const std::vector<std::string>& featuresFolders,
-                       const VocabularyTree<VocDescriptorT>& tree,
+                       const VocabularyTree<VocDescriptorT, VocDistance>& tree,
                        const Database& db,
                        const std::string& distanceMethod,
                        std::map<int, int>& globalHistogram)
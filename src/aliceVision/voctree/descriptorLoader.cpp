@@ -55,7 +55,21 @@ void getInfoBinFile(const std::string &path, int dim, size_t &numDescriptors, in
   }
 }
 
-void getListOfDescriptorFiles(const sfm::SfMData& sfmData, const std::vector<std::string>& featuresFolders, std::map<IndexT, std::string>& descriptorsFiles)
+std::size_t getNumDescriptorsBinFile(const std::string& path)
+{
+  std::ifstream fs(path, std::ios::in | std::ios::binary);
+  if(!fs.is_open())
+    throw std::runtime_error("Can't load descriptor binary file, can't open '" + path + "' !");
+
+  std::size_t numDescriptors = 0;
+  fs.read((char*) &numDescriptors, sizeof(std::size_t));
+  if(!fs.good())
+    throw std::runtime_error("Can't load descriptor binary file, '" + path + "' is incorrect !");
+
+  return numDescriptors;
+}
+
+void getListOfDescriptorFiles(const sfm::SfMData& sfmData, const std::vector<std::string>& featuresFolders, std::map<IndexT, std::string>& descriptorsFiles, feature::EImageDescriberType descType)
 {
   namespace bfs = boost::filesystem;
 
@@ -72,7 +86,7 @@ void getListOfDescriptorFiles(const sfm::SfMData& sfmData, const std::vector<std
     for(const std::string& featureFolder : featuresFolders)
     {
       // generate the equivalent .desc file path
-      const std::string filepath = bfs::path(bfs::path(featureFolder) / (std::to_string(view.first) + "." + feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT) + ".desc")).string();
+      const std::string filepath = bfs::path(bfs::path(featureFolder) / (std::to_string(view.first) + "." + feature::EImageDescriberType_enumToString(descType) + ".desc")).string();
 
       if(bfs::exists(filepath))
       {
@@ -87,7 +101,7 @@ void getListOfDescriptorFiles(const sfm::SfMData& sfmData, const std::vector<std
 
     for(const std::string& featureFolder : sfmData.getFeaturesFolders())
     {
-      const std::string filepath = bfs::path(bfs::path(featureFolder) / (std::to_string(view.first) + "." + feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT) + ".desc")).string();
+      const std::string filepath = bfs::path(bfs::path(featureFolder) / (std::to_string(view.first) + "." + feature::EImageDescriberType_enumToString(descType) + ".desc")).string();
 
       if(bfs::exists(filepath))
       {
@@ -27,15 +27,25 @@ namespace voctree {
  */
 void getInfoBinFile(const std::string& path, int dim, size_t& numDescriptors, int& bytesPerElement);
 
+/**
+ * @brief Get the number of descriptors contained inside a .desc file, reading only its header
+ * @param[in] path The .desc filename
+ * @return The number of descriptors stored in the file
+ * @throw std::runtime_error if the file can't be read
+ */
+std::size_t getNumDescriptorsBinFile(const std::string& path);
+
 /**
  * @brief Extract a list of decriptor files from a sfmData.
  * @param[in] sfmDataPath The input sfmData
  * @param[in] featuresFolders The folder(s) containing the descriptor files
  * @param[out] descriptorsFiles A list of descriptor files 
+ * @param[in] descType The describer type of the descriptor files
  */
 void getListOfDescriptorFiles(const sfm::SfMData& sfmData,
                               const std::vector<std::string>& featuresFolders,
-                              std::map<IndexT, std::string>& descriptorsFiles);
+                              std::map<IndexT, std::string>& descriptorsFiles,
+                              feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT);
 
 /**
  * @brief Read a set of descriptors from a file containing the path to the descriptor files.
@@ -43,14 +53,23 @@ void getListOfDescriptorFiles(const sfm::SfMData& sfmData,
  * @param[in] featuresFolders The folder(s) containing the descriptor files (optional)
  * @param[in,out] descriptors the vector to which append all the read descriptors
  * @param[in,out] numFeatures a vector collecting for each file read the number of features read
+ * @param[in] maxDescriptorsPerImage If not 0, max. number of descriptors read per file, randomly drawn
+ *            (with a fixed seed per file: the result does not depend on the number of threads)
+ * @param[in] nbThreads The number of files read in parallel (0: one per core)
+ * @param[in] descType The describer type of the descriptor files
  * @return the total number of features read
  *
+ * @note The number of descriptors of each file is read first, so the memory is allocated once
+ * and each file is read directly at its place in \p descriptors.
  */
 template<class DescriptorT, class FileDescriptorT>
 size_t readDescFromFiles(const sfm::SfMData& sfmData,
                          const std::vector<std::string>& featuresFolders,
                          std::vector<DescriptorT>& descriptors,
-                         std::vector<size_t>& numFeatures);
+                         std::vector<size_t>& numFeatures,
+                         std::size_t maxDescriptorsPerImage = 0,
+                         int nbThreads = 0,
+                         feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT);
 
 } // namespace voctree
 } // namespace aliceVision
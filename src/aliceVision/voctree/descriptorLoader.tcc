@@ -6,13 +6,20 @@
 
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
 #include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace voctree {
@@ -21,69 +28,127 @@ template<class DescriptorT, class FileDescriptorT>
 size_t readDescFromFiles(const sfm::SfMData& sfmData,
                          const std::vector<std::string>& featuresFolders,
                          std::vector<DescriptorT>& descriptors,
-                         std::vector<size_t> &numFeatures)
+                         std::vector<size_t> &numFeatures,
+                         std::size_t maxDescriptorsPerImage,
+                         int nbThreads,
+                         feature::EImageDescriberType descType)
 {
-  namespace bfs = boost::filesystem;
   std::map<IndexT, std::string> descriptorsFiles;
-  getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
-  std::size_t numDescriptors = 0;
+  getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles, descType);
+
+  std::vector<std::string> files;
+  files.reserve(descriptorsFiles.size());
+  for(const auto& currentFile : descriptorsFiles)
+    files.push_back(currentFile.second);
 
-  // Allocate the memory by reading in a first time the files to get the number
-  // of descriptors
-  int bytesPerElement = 0;
+  const int nbFiles = static_cast<int>(files.size());
+  const int nbLoadingThreads = (nbThreads > 0) ? nbThreads : omp_get_max_threads();
+  std::exception_ptr loadingError = nullptr;
 
-  // Display infos and progress bar
+  // Read the number of descriptors of each file to allocate the memory once
   ALICEVISION_LOG_DEBUG("Pre-computing the memory needed...");
-  boost::progress_display display(descriptorsFiles.size());
+  std::vector<std::size_t> fileNumDescriptors(nbFiles, 0);
 
-  // Read all files and get the number of descriptors to load
-  for(const auto &currentFile : descriptorsFiles)
+  #pragma omp parallel for num_threads(nbLoadingThreads)
+  for(int i = 0; i < nbFiles; ++i)
   {
-    // if it is the first one read the number of descriptors and the type of data (we are assuming the the feat are all the same...)
-    // bytesPerElement could be 0 even after the first element (eg it has 0 descriptors...), so do it until we get the correct info
-    if(bytesPerElement == 0)
+    try
     {
-      getInfoBinFile(currentFile.second, DescriptorT::static_size, numDescriptors, bytesPerElement);
+      fileNumDescriptors[i] = getNumDescriptorsBinFile(files[i]);
     }
-    else
+    catch(...)
     {
-      // get the file size in byte and estimate the number of features without opening the file
-      numDescriptors += (bfs::file_size(currentFile.second) / bytesPerElement) / DescriptorT::static_size;
+      #pragma omp critical
+      loadingError = std::current_exception();
     }
-    ++display;
   }
+  if(loadingError)
+    std::rethrow_exception(loadingError);
+
+  // Offset of the descriptors of each file in the output vector
+  std::vector<std::size_t> fileOffsets(nbFiles, 0);
+  std::vector<std::size_t> fileNumLoaded(nbFiles, 0);
+  std::size_t numDescriptors = 0;
+  for(int i = 0; i < nbFiles; ++i)
+  {
+    fileNumLoaded[i] = (maxDescriptorsPerImage > 0) ? std::min(fileNumDescriptors[i], maxDescriptorsPerImage) : fileNumDescriptors[i];
+    fileOffsets[i] = descriptors.size() + numDescriptors;
+    numDescriptors += fileNumLoaded[i];
+  }
+
   ALICEVISION_LOG_DEBUG("Found " << numDescriptors << " descriptors overall, allocating memory...");
-  if(bytesPerElement == 0)
+  if(numDescriptors == 0)
   {
     ALICEVISION_LOG_WARNING("No descriptor file found");
     return 0;
   }
 
   // Allocate the memory
-  descriptors.reserve(numDescriptors);
-  size_t numDescriptorsCheck = numDescriptors; // for later check
-  numDescriptors = 0;
+  descriptors.resize(descriptors.size() + numDescriptors);
 
   // Read the descriptors
   ALICEVISION_LOG_DEBUG("Reading the descriptors...");
-  display.restart(descriptorsFiles.size());
+  boost::progress_display display(files.size());
 
-  // Run through the path vector and read the descriptors
-  for(const auto &currentFile : descriptorsFiles)
-  {
-    // Read the descriptors and append them in the vector
-    feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, descriptors, true);
-    size_t result = descriptors.size();
-
-    // Add the number of descriptors from this file
-    numFeatures.push_back(result - numDescriptors);
+  std::atomic<bool> hasError(false);
 
-    // Update the overall counter
-    numDescriptors = result;
+  #pragma omp parallel num_threads(nbLoadingThreads)
+  {
+    std::vector<FileDescriptorT> fileDescriptors;
+    std::vector<std::size_t> selectedIndexes;
 
-    ++display;
+    #pragma omp for schedule(dynamic)
+    for(int i = 0; i < nbFiles; ++i)
+    {
+      if(hasError)
+        continue;
+
+      try
+      {
+        feature::loadDescsFromBinFile<FileDescriptorT, FileDescriptorT>(files[i], fileDescriptors, false);
+        if(fileDescriptors.size() != fileNumDescriptors[i])
+          throw std::runtime_error("Can't load descriptor binary file, '" + files[i] + "' is incorrect !");
+
+        DescriptorT* out = descriptors.data() + fileOffsets[i];
+
+        if(fileNumLoaded[i] == fileNumDescriptors[i])
+        {
+          for(std::size_t k = 0; k < fileDescriptors.size(); ++k)
+            feature::convertDesc<FileDescriptorT, DescriptorT>(fileDescriptors[k], out[k]);
+        }
+        else
+        {
+          // random subset of the descriptors of the file, kept in the file order
+          std::mt19937 randomNumberGenerator(static_cast<std::mt19937::result_type>(i));
+          selectedIndexes.resize(fileDescriptors.size());
+          std::iota(selectedIndexes.begin(), selectedIndexes.end(), 0);
+          for(std::size_t k = 0; k < fileNumLoaded[i]; ++k)
+          {
+            std::uniform_int_distribution<std::size_t> distribution(k, selectedIndexes.size() - 1);
+            std::swap(selectedIndexes[k], selectedIndexes[distribution(randomNumberGenerator)]);
+          }
+          std::sort(selectedIndexes.begin(), selectedIndexes.begin() + fileNumLoaded[i]);
+
+          for(std::size_t k = 0; k < fileNumLoaded[i]; ++k)
+            feature::convertDesc<FileDescriptorT, DescriptorT>(fileDescriptors[selectedIndexes[k]], out[k]);
+        }
+      }
+      catch(...)
+      {
+        hasError = true;
+        #pragma omp critical
+        loadingError = std::current_exception();
+      }
+
+      #pragma omp critical
+      ++display;
+    }
   }
-  assert(numDescriptors == numDescriptorsCheck);
+  if(loadingError)
+    std::rethrow_exception(loadingError);
+
+  // Add the number of descriptors of each file
+  numFeatures.insert(numFeatures.end(), fileNumLoaded.begin(), fileNumLoaded.end());
 
   // Return the result
   return numDescriptors;
@@ -0,0 +1,109 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/voctree/descriptorLoader.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <vector>
+
+#define BOOST_TEST_MODULE descriptorLoader
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace fs = boost::filesystem;
+
+typedef feature::Descriptor<float, 128> DescriptorFloat;
+typedef feature::Descriptor<unsigned char, 128> DescriptorUChar;
+
+// Write the SIFT descriptors of nbViews views with (viewId + 1) * 10 descriptors,
+// the first element is the view id and the second one the index of the descriptor
+std::string writeDescriptors(sfm::SfMData& sfmData, std::size_t nbViews)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path("descriptorLoader_%%%%%%");
+  fs::create_directories(folder);
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    sfmData.views[viewId] = std::make_shared<sfm::View>("", viewId);
+
+    std::vector<DescriptorUChar> descriptors((viewId + 1) * 10, DescriptorUChar(0));
+    for(std::size_t i = 0; i < descriptors.size(); ++i)
+    {
+      descriptors[i][0] = static_cast<unsigned char>(viewId);
+      descriptors[i][1] = static_cast<unsigned char>(i);
+    }
+    feature::saveDescsToBinFile((folder / (std::to_string(viewId) + ".sift.desc")).string(), descriptors);
+  }
+  return folder.string();
+}
+
+BOOST_AUTO_TEST_CASE(descriptorLoader_readAll)
+{
+  sfm::SfMData sfmData;
+  const std::string folder = writeDescriptors(sfmData, 4);
+
+  std::vector<DescriptorFloat> descriptors;
+  std::vector<std::size_t> numFeatures;
+  const std::size_t nbRead = voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, {folder}, descriptors, numFeatures, 0, 3);
+
+  BOOST_CHECK_EQUAL(nbRead, 100);
+  BOOST_CHECK_EQUAL(descriptors.size(), 100);
+  BOOST_REQUIRE_EQUAL(numFeatures.size(), 4);
+
+  // the descriptors are in the order of the views
+  std::size_t offset = 0;
+  for(std::size_t viewId = 0; viewId < numFeatures.size(); ++viewId)
+  {
+    BOOST_CHECK_EQUAL(numFeatures[viewId], (viewId + 1) * 10);
+    for(std::size_t i = 0; i < numFeatures[viewId]; ++i)
+    {
+      BOOST_CHECK_EQUAL(descriptors[offset + i][0], viewId);
+      BOOST_CHECK_EQUAL(descriptors[offset + i][1], i);
+    }
+    offset += numFeatures[viewId];
+  }
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(descriptorLoader_subsampling)
+{
+  sfm::SfMData sfmData;
+  const std::string folder = writeDescriptors(sfmData, 4);
+
+  std::vector<DescriptorFloat> descriptors;
+  std::vector<std::size_t> numFeatures;
+  const std::size_t nbRead = voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, {folder}, descriptors, numFeatures, 15, 3);
+
+  // 10 + 15 + 15 + 15
+  BOOST_CHECK_EQUAL(nbRead, 55);
+  BOOST_REQUIRE_EQUAL(numFeatures.size(), 4);
+
+  // distinct descriptors of the view, in the file order
+  std::size_t offset = 0;
+  for(std::size_t viewId = 0; viewId < numFeatures.size(); ++viewId)
+  {
+    BOOST_CHECK_EQUAL(numFeatures[viewId], std::min<std::size_t>((viewId + 1) * 10, 15));
+    for(std::size_t i = 0; i < numFeatures[viewId]; ++i)
+    {
+      BOOST_CHECK_EQUAL(descriptors[offset + i][0], viewId);
+      if(i > 0)
+        BOOST_CHECK_LT(descriptors[offset + i - 1][1], descriptors[offset + i][1]);
+    }
+    offset += numFeatures[viewId];
+  }
+
+  // the same subset whatever the number of threads
+  std::vector<DescriptorFloat> descriptorsSingleThread;
+  std::vector<std::size_t> numFeaturesSingleThread;
+  voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, {folder}, descriptorsSingleThread, numFeaturesSingleThread, 15, 1);
+  BOOST_CHECK(descriptorsSingleThread == descriptors);
+
+  fs::remove_all(folder);
+}
@@ -6,10 +6,14 @@
 
 #pragma once
 
+#include <aliceVision/feature/Descriptor.hpp>
+
 #include <stdint.h>
 //#include <iostream>
 #include <Eigen/Core>
 
+#include <cstring>
+
 namespace aliceVision {
 namespace voctree {
 
@@ -57,5 +61,79 @@ struct L2< Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>, Eigen::
   }
 };
 
+
+/// Number of bits set in a 64 bits word
+inline unsigned int popcount64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_popcountll(x));
+#else
+  // parallel bit count
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<unsigned int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * @brief Number of different bits between two binary strings, compared 64 bits at a time
+ * @param[in] a The first binary string
+ * @param[in] b The second binary string
+ * @param[in] nbBytes The size of the binary strings in bytes
+ */
+inline std::size_t hammingDistance(const unsigned char* a, const unsigned char* b, std::size_t nbBytes)
+{
+  std::size_t distance = 0;
+  std::size_t i = 0;
+  for(; i + sizeof(uint64_t) <= nbBytes; i += sizeof(uint64_t))
+  {
+    uint64_t wordA, wordB;
+    std::memcpy(&wordA, a + i, sizeof(uint64_t));
+    std::memcpy(&wordB, b + i, sizeof(uint64_t));
+    distance += popcount64(wordA ^ wordB);
+  }
+  for(; i < nbBytes; ++i)
+    distance += popcount64(a[i] ^ b[i]);
+  return distance;
+}
+
+/**
+ * \brief Hamming distance metric of binary descriptors (e.g. AKAZE_MLDB),
+ * stored in containers of bytes: the number of different bits.
+ *
+ * The vocabulary trees using this distance are trained with k-majority clustering (see SimpleKmeans).
+ */
+template<class DescriptorA, class DescriptorB=DescriptorA>
+struct Hamming
+{
+  typedef typename DescriptorA::value_type value_type;
+  typedef double result_type;
+
+  result_type operator()(const DescriptorA& a, const DescriptorB& b) const
+  {
+    static_assert(sizeof(value_type) == 1, "Hamming distance of binary descriptors stored in bytes");
+    std::size_t result = 0;
+    for(std::size_t i = 0; i < a.size(); ++i)
+      result += popcount64(static_cast<unsigned char>(a[i] ^ b[i]));
+    return static_cast<result_type>(result);
+  }
+};
+
+/// Specialization for feature::Descriptor types, on their raw memory.
+
+template<std::size_t N>
+struct Hamming< feature::Descriptor<unsigned char, N>, feature::Descriptor<unsigned char, N> >
+{
+  typedef feature::Descriptor<unsigned char, N> feature_type;
+  typedef unsigned char value_type;
+  typedef double result_type;
+
+  result_type operator()(const feature_type& a, const feature_type& b) const
+  {
+    return static_cast<result_type>(hammingDistance(a.getData(), b.getData(), N));
+  }
+};
+
 }
 }
@@ -6,6 +6,7 @@
 
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/voctree/SimpleKmeans.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 
 #include <iostream>
 #include <fstream>
@@ -290,3 +291,122 @@ BOOST_AUTO_TEST_CASE(kmeanVarying)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(kmeanMiniBatch)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing mini-batch kmeans...");
+
+  const std::size_t DIMENSION = 32;
+  const std::size_t FEATURENUMBER = 1000;
+  const std::size_t K = 10;
+  const std::size_t STEP = 5 * K;
+
+  typedef Eigen::RowVectorXf FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // generate k clusters well far away
+  FeatureFloatVector features;
+  FeatureFloatVector centers;
+  std::vector<unsigned int> membership;
+  features.reserve(FEATURENUMBER * K);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+    {
+      features.push_back((FeatureFloat::Random(DIMENSION) + FeatureFloat::Constant(DIMENSION, STEP * i) - FeatureFloat::Constant(DIMENSION, STEP * (K - 1) / 2)) / ((STEP * (K - 1) / 2) * sqrt(DIMENSION)));
+    }
+  }
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat::Zero(DIMENSION));
+  kmeans.setVerbose(0);
+  kmeans.setRestarts(3);
+  kmeans.setMiniBatchSize(500);
+
+  kmeans.cluster(features, K, centers, membership);
+
+  // each feature is assigned to the center of its cluster
+  BOOST_CHECK_EQUAL(membership.size(), features.size());
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 1; j < FEATURENUMBER; ++j)
+      BOOST_CHECK_EQUAL(membership[i * FEATURENUMBER + j], membership[i * FEATURENUMBER]);
+  }
+  std::vector<std::size_t> h(K, 0);
+  for(std::size_t i = 0; i < membership.size(); ++i)
+    ++h[membership[i]];
+  for(std::size_t i = 0; i < h.size(); ++i)
+    BOOST_CHECK_EQUAL(h[i], FEATURENUMBER);
+}
+
+BOOST_AUTO_TEST_CASE(kmeanBinaryKMajority)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing binary k-majority...");
+
+  const std::size_t NBBYTES = 64;
+  const std::size_t FEATURENUMBER = 200;
+  const std::size_t K = 8;
+
+  typedef feature::Descriptor<unsigned char, NBBYTES> FeatureBinary;
+  typedef voctree::Hamming<FeatureBinary> Distance;
+  typedef std::vector<FeatureBinary> FeatureBinaryVector;
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> byteDistribution(0, 255);
+  std::uniform_int_distribution<int> bitDistribution(0, NBBYTES * 8 - 1);
+
+  // generate k random centers and their clusters, with a few bits flipped per feature
+  FeatureBinaryVector centersGT(K);
+  for(FeatureBinary& center : centersGT)
+  {
+    for(std::size_t b = 0; b < NBBYTES; ++b)
+      center[b] = static_cast<unsigned char>(byteDistribution(generator));
+  }
+
+  FeatureBinaryVector features;
+  features.reserve(FEATURENUMBER * K);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+    {
+      FeatureBinary feature = centersGT[i];
+      for(int f = 0; f < 16; ++f)
+      {
+        const int bit = bitDistribution(generator);
+        feature[bit / 8] ^= static_cast<unsigned char>(1 << (bit % 8));
+      }
+      features.push_back(feature);
+    }
+  }
+
+  FeatureBinary zero;
+  std::fill(zero.getData(), zero.getData() + NBBYTES, 0);
+
+  voctree::SimpleKmeans<FeatureBinary, Distance> kmeans(zero);
+  kmeans.setVerbose(0);
+  kmeans.setRestarts(3);
+
+  FeatureBinaryVector centers;
+  std::vector<unsigned int> membership;
+  kmeans.cluster(features, K, centers, membership);
+
+  // each feature is assigned to the center of its cluster
+  BOOST_CHECK_EQUAL(membership.size(), features.size());
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 1; j < FEATURENUMBER; ++j)
+      BOOST_CHECK_EQUAL(membership[i * FEATURENUMBER + j], membership[i * FEATURENUMBER]);
+  }
+
+  // the majority of the bits recovers the generating centers
+  Distance distance;
+  for(std::size_t i = 0; i < K; ++i)
+    BOOST_CHECK_EQUAL(distance(centers[membership[i * FEATURENUMBER]], centersGT[i]), 0.0);
+
+  // the Hamming distance counts the different bits
+  FeatureBinary other = zero;
+  other[0] = 0x0F;
+  other[NBBYTES - 1] = 0x80;
+  BOOST_CHECK_EQUAL(distance(zero, other), 5.0);
+}
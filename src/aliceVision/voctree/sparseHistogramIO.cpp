@@ -0,0 +1,162 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "sparseHistogramIO.hpp"
+
+#include <aliceVision/stl/hash.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const char sparseHistogramMagic[8] = {'A', 'V', 'S', 'H', 'I', 'S', 'T', '1'};
+const std::uint32_t sparseHistogramVersion = 1;
+
+/// size and modification time of the descriptors file
+bool getDescriptorsFileStatus(const std::string& descriptorsFilepath, std::uint64_t& size, std::int64_t& time)
+{
+  boost::system::error_code ec;
+  size = bfs::file_size(descriptorsFilepath, ec);
+  if(ec)
+    return false;
+  time = static_cast<std::int64_t>(bfs::last_write_time(descriptorsFilepath, ec));
+  return !ec;
+}
+
+} // namespace
+
+std::uint64_t getVocabularyTreeSignature(const std::string& treeFilepath)
+{
+  boost::system::error_code ec;
+  std::size_t signature = 0;
+  stl::hash_combine(signature, bfs::canonical(treeFilepath, ec).string());
+  stl::hash_combine(signature, static_cast<std::uint64_t>(bfs::file_size(treeFilepath, ec)));
+  stl::hash_combine(signature, static_cast<std::int64_t>(bfs::last_write_time(treeFilepath, ec)));
+  return signature != 0 ? signature : 1;
+}
+
+std::string getSparseHistogramFilepath(const std::string& descriptorsFilepath)
+{
+  return bfs::path(descriptorsFilepath).replace_extension(".hist").string();
+}
+
+bool loadSparseHistogram(const std::string& descriptorsFilepath,
+                         std::uint64_t treeSignature,
+                         std::size_t nbMaxDescriptors,
+                         SparseHistogram& histogram,
+                         std::size_t& nbDescriptors)
+{
+  std::uint64_t descriptorsFileSize = 0;
+  std::int64_t descriptorsFileTime = 0;
+  if(!getDescriptorsFileStatus(descriptorsFilepath, descriptorsFileSize, descriptorsFileTime))
+    return false;
+
+  std::ifstream file(getSparseHistogramFilepath(descriptorsFilepath), std::ios::binary);
+  if(!file.is_open())
+    return false;
+
+  SparseHistogramFileHeader header;
+  if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+     !std::equal(header.magic, header.magic + sizeof(sparseHistogramMagic), sparseHistogramMagic) ||
+     header.version != sparseHistogramVersion ||
+     header.treeSignature != treeSignature ||
+     header.nbMaxDescriptors != nbMaxDescriptors ||
+     header.descriptorsFileSize != descriptorsFileSize ||
+     header.descriptorsFileTime != descriptorsFileTime)
+    return false;
+
+  // at most one word and one feature per descriptor
+  if(header.nbWords > header.nbDescriptors || header.nbFeatures > header.nbDescriptors)
+    return false;
+
+  std::vector<SparseHistogramFileWord> words(header.nbWords);
+  std::vector<std::uint32_t> features(header.nbFeatures);
+  if(!file.read(reinterpret_cast<char*>(words.data()), words.size() * sizeof(SparseHistogramFileWord)) ||
+     !file.read(reinterpret_cast<char*>(features.data()), features.size() * sizeof(std::uint32_t)))
+    return false;
+
+  histogram.clear();
+  std::size_t featureIndex = 0;
+  for(const SparseHistogramFileWord& word : words)
+  {
+    if(word.nbFeatures > features.size() - featureIndex)
+      return false;
+    std::vector<IndexT>& wordFeatures = histogram[word.word];
+    wordFeatures.assign(features.begin() + featureIndex, features.begin() + featureIndex + word.nbFeatures);
+    featureIndex += word.nbFeatures;
+  }
+  nbDescriptors = header.nbDescriptors;
+  return true;
+}
+
+bool saveSparseHistogram(const std::string& descriptorsFilepath,
+                         std::uint64_t treeSignature,
+                         std::size_t nbMaxDescriptors,
+                         const SparseHistogram& histogram,
+                         std::size_t nbDescriptors)
+{
+  SparseHistogramFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, sparseHistogramMagic, sizeof(sparseHistogramMagic));
+  header.version = sparseHistogramVersion;
+  header.nbMaxDescriptors = static_cast<std::uint32_t>(nbMaxDescriptors);
+  header.treeSignature = treeSignature;
+  header.nbDescriptors = nbDescriptors;
+  if(!getDescriptorsFileStatus(descriptorsFilepath, header.descriptorsFileSize, header.descriptorsFileTime))
+    return false;
+
+  std::vector<SparseHistogramFileWord> words;
+  std::vector<std::uint32_t> features;
+  words.reserve(histogram.size());
+  for(const auto& word : histogram)
+  {
+    words.push_back({word.first, static_cast<std::uint32_t>(word.second.size())});
+    features.insert(features.end(), word.second.begin(), word.second.end());
+  }
+  header.nbWords = words.size();
+  header.nbFeatures = features.size();
+
+  // write a temporary file then rename it, so a concurrent reader never sees a partial file
+  const std::string filepath = getSparseHistogramFilepath(descriptorsFilepath);
+  const std::string tmpFilepath = bfs::unique_path(filepath + ".%%%%%%%%").string();
+  {
+    std::ofstream file(tmpFilepath, std::ios::binary);
+    if(!file.is_open())
+      return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(SparseHistogramFileWord));
+    file.write(reinterpret_cast<const char*>(features.data()), features.size() * sizeof(std::uint32_t));
+    if(!file)
+    {
+      file.close();
+      boost::system::error_code ec;
+      bfs::remove(tmpFilepath, ec);
+      return false;
+    }
+  }
+
+  boost::system::error_code ec;
+  bfs::rename(tmpFilepath, filepath, ec);
+  if(ec)
+  {
+    bfs::remove(tmpFilepath, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace voctree
+} // namespace aliceVision
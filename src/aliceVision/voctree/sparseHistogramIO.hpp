@@ -0,0 +1,87 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/voctree/VocabularyTree.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Binary cached sparse histogram file layout (version 1, native little-endian):
+ *
+ *   SparseHistogramFileHeader
+ *   SparseHistogramFileWord * nbWords
+ *   uint32 * nbFeatures (feature indexes of the words)
+ *
+ * The file is stored next to the descriptors file, it is valid as long as the
+ * vocabulary tree, the maximum number of descriptors and the descriptors file are unchanged.
+ */
+struct SparseHistogramFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t nbMaxDescriptors;
+  std::uint64_t treeSignature;
+  std::uint64_t descriptorsFileSize;
+  std::int64_t descriptorsFileTime;
+  std::uint64_t nbDescriptors;
+  std::uint64_t nbWords;
+  std::uint64_t nbFeatures;
+};
+
+struct SparseHistogramFileWord
+{
+  std::int32_t word;
+  std::uint32_t nbFeatures;
+};
+
+/**
+ * @brief Signature of a vocabulary tree file, to invalidate the cached histograms
+ * when the tree changes.
+ * @param[in] treeFilepath The vocabulary tree file
+ * @return a non zero signature
+ */
+std::uint64_t getVocabularyTreeSignature(const std::string& treeFilepath);
+
+/**
+ * @brief Path of the cached sparse histogram of a descriptors file: <viewId>.<describerType>.hist
+ */
+std::string getSparseHistogramFilepath(const std::string& descriptorsFilepath);
+
+/**
+ * @brief Load the cached sparse histogram of a descriptors file.
+ * @param[in] descriptorsFilepath The descriptors file
+ * @param[in] treeSignature The signature of the vocabulary tree (see getVocabularyTreeSignature)
+ * @param[in] nbMaxDescriptors The maximum number of descriptors quantized in the histogram
+ * @param[out] histogram The sparse histogram
+ * @param[out] nbDescriptors The number of descriptors quantized in the histogram
+ * @return false if there is no valid cached histogram
+ */
+bool loadSparseHistogram(const std::string& descriptorsFilepath,
+                         std::uint64_t treeSignature,
+                         std::size_t nbMaxDescriptors,
+                         SparseHistogram& histogram,
+                         std::size_t& nbDescriptors);
+
+/**
+ * @brief Save the sparse histogram of a descriptors file next to it.
+ * @return false if the file can't be written
+ * @see loadSparseHistogram
+ */
+bool saveSparseHistogram(const std::string& descriptorsFilepath,
+                         std::uint64_t treeSignature,
+                         std::size_t nbMaxDescriptors,
+                         const SparseHistogram& histogram,
+                         std::size_t nbDescriptors);
+
+} // namespace voctree
+} // namespace aliceVision
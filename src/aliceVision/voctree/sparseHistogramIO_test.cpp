@@ -0,0 +1,57 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/voctree/sparseHistogramIO.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <string>
+
+#define BOOST_TEST_MODULE sparseHistogramIO
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision::voctree;
+namespace bfs = boost::filesystem;
+
+BOOST_AUTO_TEST_CASE(sparseHistogramCache)
+{
+  const bfs::path folder = bfs::temp_directory_path() / bfs::unique_path();
+  bfs::create_directories(folder);
+  const std::string descriptorsFilepath = (folder / "12.sift.desc").string();
+  {
+    std::ofstream file(descriptorsFilepath, std::ios::binary);
+    file << std::string(1000, 'd');
+  }
+
+  SparseHistogram histogram;
+  histogram[3] = {0, 4};
+  histogram[7] = {1};
+  histogram[42] = {2, 3, 5};
+
+  const std::uint64_t signature = 1234;
+  BOOST_CHECK_EQUAL(getSparseHistogramFilepath(descriptorsFilepath), (folder / "12.sift.hist").string());
+  BOOST_CHECK(saveSparseHistogram(descriptorsFilepath, signature, 500, histogram, 6));
+
+  SparseHistogram loaded;
+  std::size_t nbDescriptors = 0;
+  BOOST_CHECK(loadSparseHistogram(descriptorsFilepath, signature, 500, loaded, nbDescriptors));
+  BOOST_CHECK(loaded == histogram);
+  BOOST_CHECK_EQUAL(nbDescriptors, 6);
+
+  // another vocabulary tree or maximum number of descriptors
+  BOOST_CHECK(!loadSparseHistogram(descriptorsFilepath, signature + 1, 500, loaded, nbDescriptors));
+  BOOST_CHECK(!loadSparseHistogram(descriptorsFilepath, signature, 0, loaded, nbDescriptors));
+
+  // the descriptors have changed
+  {
+    std::ofstream file(descriptorsFilepath, std::ios::binary | std::ios::app);
+    file << "new descriptors";
+  }
+  BOOST_CHECK(!loadSparseHistogram(descriptorsFilepath, signature, 500, loaded, nbDescriptors));
+
+  bfs::remove_all(folder);
+}
@@ -5,12 +5,14 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/TreeBuilder.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <Eigen/Core>
 
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE voctreeBuilder
@@ -81,5 +83,64 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   {
     BOOST_CHECK_SMALL(distance(centerOrig[i],centerLoad[i]), kepsf);
   }
+
+  // the read-only tree uses the centers in the mapped file
+  voctree::VocabularyTree<FeatureFloat> mappedTree(treeName);
+  BOOST_CHECK_EQUAL(mappedTree.words(), builder.tree().words());
+  BOOST_CHECK(mappedTree == builder.tree());
+  for(std::size_t i = 0; i < features.size(); i += 7)
+    BOOST_CHECK_EQUAL(mappedTree.quantize(features[i]), builder.tree().quantize(features[i]));
 //  voctree::printFeatVector( features ); 
 }
+
+template<typename CenterT, typename QueryT>
+void checkFlatQuantizer(uint32_t levels, uint32_t splits)
+{
+  using namespace aliceVision;
+
+  typedef feature::Descriptor<CenterT, 20> Center;
+  typedef feature::Descriptor<QueryT, 20> Query;
+  const std::string treeName = "testFlat.tree";
+
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  // random centers, some nodes have fewer children
+  voctree::MutableVocabularyTree<Center> tree;
+  tree.setSize(levels, splits);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().assign(tree.nodes(), 1);
+  for(Center& center : tree.centers())
+  {
+    for(std::size_t i = 0; i < center.size(); ++i)
+      center[i] = CenterT(distribution(randomNumberGenerator));
+  }
+  for(std::size_t node = 0; node < tree.nodes() / splits; node += 3)
+    tree.validCenters()[node * splits + splits - 1 - node % (splits - 1)] = 0;
+  tree.save(treeName);
+
+  voctree::VocabularyTree<Center> flatTree(treeName);
+
+  std::vector<Query> queries(500);
+  for(Query& query : queries)
+  {
+    for(std::size_t i = 0; i < query.size(); ++i)
+      query[i] = QueryT(distribution(randomNumberGenerator));
+  }
+  // ties between children
+  queries[0] = Query(QueryT(0));
+
+  // the mutable tree uses the Distance functor
+  const std::vector<voctree::Word> words = flatTree.quantize(queries);
+  BOOST_CHECK(words == tree.quantize(queries));
+  for(std::size_t i = 0; i < queries.size(); i += 11)
+    BOOST_CHECK_EQUAL(flatTree.quantize(queries[i]), words[i]);
+}
+
+BOOST_AUTO_TEST_CASE(voctreeFlatQuantizer)
+{
+  checkFlatQuantizer<float, float>(3, 10);
+  checkFlatQuantizer<float, unsigned char>(4, 4);
+  checkFlatQuantizer<unsigned char, unsigned char>(3, 5);
+  checkFlatQuantizer<unsigned char, float>(2, 13);
+}
@@ -6,8 +6,10 @@
 
 #include <aliceVision/voctree/Database.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -57,3 +59,175 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(databaseIO)
+{
+  const int cardDocuments = 10;
+  const int cardWords = 12;
+  const int numWords = 50;
+
+  // Create the database, the documents share some words
+  Database db(numWords);
+  vector<vector<Word>> documents(cardDocuments);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    for(int j = 0; j < cardWords; ++j)
+      documents[i].push_back((7 * i + 3 * j) % numWords);
+    SparseHistogram histo;
+    computeSparseHistogram(documents[i], histo);
+    db.insert(i, histo);
+  }
+  db.computeTfIdfWeights();
+
+  db.save("test.db");
+  db.saveWeights("test.weights");
+
+  Database loadedDb;
+  loadedDb.load("test.db");
+
+  BOOST_CHECK_EQUAL(loadedDb.size(), db.size());
+  BOOST_CHECK_EQUAL(loadedDb.numWords(), db.numWords());
+  BOOST_CHECK(loadedDb.getSparseHistogramPerImage() == db.getSparseHistogramPerImage());
+  for(int i = 0; i < numWords; ++i)
+    BOOST_CHECK_EQUAL(loadedDb.weights()[i], db.weights()[i]);
+
+  Database loadedWeights;
+  loadedWeights.loadWeights("test.weights");
+  BOOST_CHECK_EQUAL(loadedWeights.numWords(), db.numWords());
+  for(int i = 0; i < numWords; ++i)
+    BOOST_CHECK_EQUAL(loadedWeights.weights()[i], db.weights()[i]);
+
+  // same matches with the loaded database
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<DocMatch> matches;
+    vector<DocMatch> loadedMatches;
+    db.find(documents[i], 3, matches, "inversedWeightedCommonPoints");
+    loadedDb.find(documents[i], 3, loadedMatches, "inversedWeightedCommonPoints");
+    BOOST_CHECK(matches == loadedMatches);
+  }
+
+  // the loaded database can be modified
+  SparseHistogram histo;
+  computeSparseHistogram(documents[0], histo);
+  loadedDb.insert(cardDocuments, histo);
+  loadedDb.computeTfIdfWeights();
+  BOOST_CHECK_EQUAL(loadedDb.size(), cardDocuments + 1);
+
+  BOOST_CHECK_THROW(loadedDb.load("test.weights"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(databaseBatchFind)
+{
+  const int cardDocuments = 40;
+  const int numWords = 200;
+  const std::size_t N = 7;
+
+  // Create the database, the words appear one or several times in the documents
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> wordDistribution(0, numWords - 1);
+  Database db(numWords);
+  vector<SparseHistogram> documents(cardDocuments);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> words;
+    for(int j = 0; j < 60; ++j)
+      words.push_back(wordDistribution(randomNumberGenerator));
+    computeSparseHistogram(words, documents[i]);
+    // sparse document ids
+    db.insert(1000 + 7 * i, documents[i]);
+  }
+  db.computeTfIdfWeights();
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    vector<DocMatches> matches;
+    db.find(documents, N, matches, distanceMethod);
+    BOOST_CHECK_EQUAL(matches.size(), documents.size());
+
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      // the best matches of the distance of the query to every document
+      DocMatches expected;
+      for(const auto& document : db.getSparseHistogramPerImage())
+        expected.push_back(DocMatch(document.first, sparseDistance(documents[i], document.second, distanceMethod, db.weights())));
+      std::sort(expected.begin(), expected.end(), [](const DocMatch& a, const DocMatch& b)
+      {
+        return (a.score < b.score) || (a.score == b.score && a.id < b.id);
+      });
+      expected.resize(N);
+      BOOST_CHECK(matches[i] == expected);
+
+      // same matches for a single query
+      DocMatches singleMatches;
+      db.find(documents[i], N, singleMatches, distanceMethod);
+      BOOST_CHECK(singleMatches == expected);
+    }
+  }
+
+  // all the documents are returned at most
+  vector<DocMatches> matches;
+  db.find(documents, cardDocuments + 10, matches);
+  BOOST_CHECK_EQUAL(matches.front().size(), cardDocuments);
+
+  BOOST_CHECK_THROW(db.find(documents, N, matches, "unknown"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(databaseIncrementalWeights)
+{
+  const int cardDocuments = 30;
+  const int numWords = 150;
+
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> wordDistribution(0, numWords - 1);
+  SparseHistogramPerImage documents;
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> words;
+    for(int j = 0; j < 40; ++j)
+      words.push_back(wordDistribution(randomNumberGenerator));
+    computeSparseHistogram(words, documents[100 + 3 * i]);
+  }
+
+  // all the documents inserted together before the weights
+  Database db(numWords);
+  db.insert(documents);
+  db.computeTfIdfWeights();
+
+  // a database growing after its weights are computed
+  Database incrementalDb(numWords);
+  SparseHistogramPerImage firstDocuments;
+  SparseHistogramPerImage nextDocuments;
+  for(const auto& document : documents)
+    (document.first < 100 + 3 * cardDocuments / 2 ? firstDocuments : nextDocuments).insert(document);
+  incrementalDb.insert(firstDocuments);
+  incrementalDb.computeTfIdfWeights(1.0f, true);
+  const std::vector<float> firstWeights(incrementalDb.weights(), incrementalDb.weights() + numWords);
+
+  auto it = nextDocuments.begin();
+  incrementalDb.insert(it->first, it->second);
+  nextDocuments.erase(it);
+  incrementalDb.insert(nextDocuments);
+
+  BOOST_CHECK(incrementalDb.getSparseHistogramPerImage() == db.getSparseHistogramPerImage());
+  bool isUpdated = false;
+  for(int i = 0; i < numWords; ++i)
+  {
+    BOOST_CHECK_CLOSE(incrementalDb.weights()[i], db.weights()[i], 1e-4);
+    isUpdated = isUpdated || (firstWeights[i] != db.weights()[i]);
+  }
+  BOOST_CHECK(isUpdated);
+
+  // same matches as the database built at once
+  for(const std::string distanceMethod : {"commonPoints", "inversedWeightedCommonPoints", "weightedStrongCommonPoints"})
+  {
+    for(const auto& document : documents)
+    {
+      vector<DocMatch> matches;
+      vector<DocMatch> incrementalMatches;
+      db.find(document.second, 5, matches, distanceMethod);
+      incrementalDb.find(document.second, 5, incrementalMatches, distanceMethod);
+      BOOST_CHECK(matches == incrementalMatches);
+    }
+  }
+}
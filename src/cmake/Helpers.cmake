@@ -231,3 +231,43 @@ function(alicevision_add_test test_file)
            COMMAND $<TARGET_FILE:${TEST_EXECUTABLE_NAME}> --catch_system_error=yes --log_level=all
   )
 endfunction()
+
+# Add benchmark function
+function(alicevision_add_benchmark benchmark_file)
+  set(options "")
+  set(singleValues NAME)
+  set(multipleValues LINKS INCLUDE_DIRS)
+
+  cmake_parse_arguments(BENCHMARK "${options}" "${singleValues}" "${multipleValues}" ${ARGN})
+
+  if(NOT benchmark_file)
+    message(FATAL_ERROR "You must provide the benchmark file in 'alicevision_add_benchmark'")
+  endif()
+
+  if(NOT BENCHMARK_NAME)
+    message(FATAL_ERROR "You must provide the NAME in 'alicevision_add_benchmark'")
+  endif()
+
+  if(NOT ALICEVISION_BUILD_BENCHMARKS)
+    return()
+  endif()
+
+  set(BENCHMARK_EXECUTABLE_NAME "aliceVision_benchmark_${BENCHMARK_NAME}")
+
+  add_executable(${BENCHMARK_EXECUTABLE_NAME} ${benchmark_file})
+
+  target_link_libraries(${BENCHMARK_EXECUTABLE_NAME}
+    PUBLIC ${BENCHMARK_LINKS}
+           ${ALICEVISION_LIBRARY_DEPENDENCIES}
+           ${Boost_LIBRARIES}
+  )
+
+  target_include_directories(${BENCHMARK_EXECUTABLE_NAME}
+    PUBLIC ${BENCHMARK_INCLUDE_DIRS}
+           ${Boost_INCLUDE_DIRS}
+  )
+
+  set_property(TARGET ${BENCHMARK_EXECUTABLE_NAME}
+    PROPERTY FOLDER Benchmark
+  )
+endfunction()
@@ -15,6 +15,7 @@
 #include <aliceVision/feature/svgVisualization.hpp>
 
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Timer.hpp>
 #include <boost/program_options.hpp>
 #include "dependencies/vectorGraphics/svgDrawer.hpp"
 
@@ -282,6 +283,7 @@ int main(int argc, char **argv)
   // First sort the putative matches by increasing distance ratio value
   sortMatches_byDistanceRatio(vec_PutativeMatches);
 
+  system::Timer timer;
   matchingImageCollection::filterMatchesByHGrowing(siofeatures_I->Features(),
                                                    siofeatures_J->Features(),
                                                    vec_PutativeMatches,
@@ -291,7 +293,8 @@ int main(int argc, char **argv)
   {
     // Display statistics
     std::cout << "After matching by growing homography we found: "
-              << outGeometricInliers.size() << " #matches validated by " << homographiesAndMatches.size() << " homographies" << std::endl;
+              << outGeometricInliers.size() << " #matches validated by " << homographiesAndMatches.size() << " homographies"
+              << " in " << timer.elapsedMs() << " ms" << std::endl;
     std::size_t count{0};
     for(const auto& p : homographiesAndMatches)
     {
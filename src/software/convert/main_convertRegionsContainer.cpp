@@ -0,0 +1,148 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/sfm/sfmDataIO.hpp>
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/RegionsContainer.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/progress.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+int main(int argc, char** argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::string outputFolder;
+  std::vector<std::string> featuresFolders;
+
+  // user optional parameters
+
+  std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+
+  po::options_description allParams("This program is used to gather the per-view regions files (*.feat, *.desc)\n"
+                                    "of a SfMData in one binary regions container per describer type (*.regions)\n"
+                                    "AliceVision convertRegionsContainer");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder that stores the regions containers.")
+    ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken()->required(),
+      "Path to folder(s) containing the extracted features.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str());
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  sfm::SfMData sfmData;
+  if(!sfm::Load(sfmData, sfmDataFilename, sfm::ESfMData(sfm::VIEWS)))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" << sfmDataFilename << "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  // if the folder does not exist create it (recursively)
+  if(!fs::exists(outputFolder))
+    fs::create_directories(outputFolder);
+
+  std::vector<std::string> folders = sfmData.getFeaturesFolders();
+  folders.insert(folders.end(), featuresFolders.begin(), featuresFolders.end());
+
+  const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+
+  for(const feature::EImageDescriberType describerType : describerTypes)
+  {
+    const std::string containerPath = feature::getRegionsContainerPath(outputFolder, describerType);
+    std::unique_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(describerType);
+
+    ALICEVISION_LOG_INFO("Write regions container: " << containerPath);
+
+    try
+    {
+      feature::RegionsContainerWriter writer(containerPath, describerType);
+      boost::progress_display progressBar(sfmData.getViews().size(), std::cout, "Gather " + feature::EImageDescriberType_enumToString(describerType) + " regions\n");
+
+      for(const auto& viewPair : sfmData.getViews())
+      {
+        std::unique_ptr<feature::Regions> regions = sfm::loadRegions(folders, viewPair.first, *imageDescriber);
+        writer.add(viewPair.first, *regions);
+        ++progressBar;
+      }
+      writer.close();
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Can't write the regions container '" << containerPath << "':\n" << e.what());
+      return EXIT_FAILURE;
+    }
+  }
+
+  ALICEVISION_LOG_INFO("Converted " << sfmData.getViews().size() << " views for " << describerTypes.size() << " describer type(s).");
+  return EXIT_SUCCESS;
+}
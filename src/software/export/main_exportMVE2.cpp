@@ -10,7 +10,6 @@
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/progress.hpp>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -21,7 +20,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -57,7 +56,8 @@ create_thumbnail
 
 bool exportToMVE2Format(
   const SfMData & sfm_data,
-  const std::string & sOutDirectory // Output MVE2 files folder
+  const std::string & sOutDirectory, // Output MVE2 files folder
+  const UndistortedViewsExportParams& exportParams
   )
 {
   bool bOk = true;
@@ -101,15 +101,14 @@ bool exportToMVE2Format(
     out << "drews 1.0\n";  // MVE expects this header
     out << cameraCount << " " << featureCount << "\n";
 
-    // Export (calibrated) views as undistorted images
-    boost::progress_display my_progress_bar(sfm_data.getViews().size());
-    std::pair<int,int> w_h_image_size;
-    Image<RGBColor> image, image_ud, thumbnail;
+    // Export the cameras of the (calibrated) views
     std::string sOutViewIteratorDirectory;
     std::size_t view_index = 0;
     std::map<std::size_t, IndexT> viewIdToviewIndex;
+    std::map<IndexT, std::string> viewIdToDirectory;
+    std::vector<IndexT> viewIds;
     for(Views::const_iterator iter = sfm_data.getViews().begin();
-      iter != sfm_data.getViews().end(); ++iter, ++my_progress_bar)
+      iter != sfm_data.getViews().end(); ++iter)
     {
       const View * view = iter->second.get();
 
@@ -128,33 +127,12 @@ bool exportToMVE2Format(
         fs::create_directory(sOutViewIteratorDirectory);
       }
 
+      viewIds.push_back(view->getViewId());
+      viewIdToDirectory[view->getViewId()] = sOutViewIteratorDirectory;
+
       // We have a valid view with a corresponding camera & pose
       const std::string srcImage = view->getImagePath();
-      const std::string dstImage = (fs::path(sOutViewIteratorDirectory) / "undistorted.png").string();
-
-      Intrinsics::const_iterator iterIntrinsic = sfm_data.getIntrinsics().find(view->getIntrinsicId());
-      const IntrinsicBase * cam = iterIntrinsic->second.get();
-      if (cam->isValid() && cam->have_disto())
-      {
-        // Undistort and save the image
-        readImage(srcImage, image);
-        UndistortImage(image, cam, image_ud, BLACK);
-        writeImage(dstImage, image_ud);
-      }
-      else // (no distortion)
-      {
-        // If extensions match, copy the PNG image
-        if (fs::extension(srcImage) == ".PNG" ||
-          fs::extension(srcImage) == ".png")
-        {
-          fs::copy_file(srcImage, dstImage);
-        }
-        else
-        {
-          readImage( srcImage, image);
-          writeImage( dstImage, image);
-        }
-      }
+      const IntrinsicBase * cam = sfm_data.getIntrinsicPtr(view->getIntrinsicId());
 
       // Prepare to write an MVE 'meta.ini' file for the current view
       const Pose3 pose = sfm_data.getPose(*view).getTransform();
@@ -202,14 +180,25 @@ bool exportToMVE2Format(
         << rotation(2, 0) << " " << rotation(2, 1) << " " << rotation(2, 2) << "\n"
         << translation[0] << " " << translation[1] << " " << translation[2] << "\n";
 
-      // Save a thumbnail image "thumbnail.png", 50x50 pixels
-      thumbnail = create_thumbnail(image, 50, 50);
-      const std::string dstThumbnailImage = (fs::path(sOutViewIteratorDirectory) / "thumbnail.png").string();
-      writeImage(dstThumbnailImage, thumbnail);
-      
       ++view_index;
     }
 
+    // Export (calibrated) views as undistorted images, with a thumbnail image "thumbnail.png", 50x50 pixels
+    try
+    {
+      exportUndistortedViews(sfm_data, viewIds, exportParams, [&](const View& view, const Image<RGBfColor>& image)
+      {
+        const fs::path viewDirectory(viewIdToDirectory.at(view.getViewId()));
+        writeImage((viewDirectory / "undistorted.png").string(), image);
+        writeImage((viewDirectory / "thumbnail.png").string(), create_thumbnail(image, 50, 50));
+      });
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Failed to export the undistorted images: " << e.what());
+      return false;
+    }
+
     // For each feature, write to bundle:  position XYZ[0-3], color RGB[0-2], all ref.view_id & ref.feature_id
     // The following method is adapted from Simon Fuhrmann's MVE project:
     // https://github.com/simonfuhrmann/mve/blob/e3db7bc60ce93fe51702ba77ef480e151f927c23/libs/mve/bundle_io.cc
@@ -246,6 +235,7 @@ int main(int argc, char *argv[])
   std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
   std::string sfmDataFilename;
   std::string outDirectory;
+  UndistortedViewsExportParams exportParams;
 
   po::options_description allParams("AliceVision exportMVE2");
 
@@ -257,12 +247,21 @@ int main(int argc, char *argv[])
       "Output folder.\n"
       "Note:  this program writes output in MVE file format");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("nbDecodeThreads", po::value<int>(&exportParams.nbDecodeThreads)->default_value(exportParams.nbDecodeThreads),
+      "Number of threads decoding the source images.")
+    ("nbUndistortThreads", po::value<int>(&exportParams.nbUndistortThreads)->default_value(exportParams.nbUndistortThreads),
+      "Number of threads undistorting the images (each one uses all the cores).")
+    ("nbEncodeThreads", po::value<int>(&exportParams.nbEncodeThreads)->default_value(exportParams.nbEncodeThreads),
+      "Number of threads encoding the exported images.");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal,  error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -304,7 +303,7 @@ int main(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
-  if (exportToMVE2Format(sfm_data, (fs::path(outDirectory) / "MVE").string()))
+  if (exportToMVE2Format(sfm_data, (fs::path(outDirectory) / "MVE").string(), exportParams))
     return( EXIT_SUCCESS );
   else
     return( EXIT_FAILURE );
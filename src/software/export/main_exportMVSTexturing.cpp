@@ -8,6 +8,7 @@
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/image/all.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
@@ -16,11 +17,12 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
+using namespace aliceVision::image;
 using namespace aliceVision::sfm;
 
 namespace po = boost::program_options;
@@ -33,6 +35,9 @@ int main(int argc, char **argv)
   std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
   std::string sfmDataFilename;
   std::string outDirectory;
+  std::string outImageFileTypeName = EImageFileType_enumToString(EImageFileType::JPEG);
+  bool exportImages = true;
+  UndistortedViewsExportParams exportParams;
 
   po::options_description allParams("AliceVision exportMVSTexturing");
 
@@ -43,12 +48,25 @@ int main(int argc, char **argv)
     ("output,o", po::value<std::string>(&outDirectory)->required(),
       "Output folder.");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("exportImages", po::value<bool>(&exportImages)->default_value(exportImages),
+      "Export the undistorted images next to their camera files.")
+    ("outputFileType", po::value<std::string>(&outImageFileTypeName)->default_value(outImageFileTypeName),
+      EImageFileType_informations().c_str())
+    ("nbDecodeThreads", po::value<int>(&exportParams.nbDecodeThreads)->default_value(exportParams.nbDecodeThreads),
+      "Number of threads decoding the source images.")
+    ("nbUndistortThreads", po::value<int>(&exportParams.nbUndistortThreads)->default_value(exportParams.nbUndistortThreads),
+      "Number of threads undistorting the images (each one uses all the cores).")
+    ("nbEncodeThreads", po::value<int>(&exportParams.nbEncodeThreads)->default_value(exportParams.nbEncodeThreads),
+      "Number of threads encoding the exported images.");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal,  error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -78,7 +96,9 @@ int main(int argc, char **argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  const std::string outputExtension = "." + EImageFileType_enumToString(EImageFileType_stringToEnum(outImageFileTypeName));
   bool bOneHaveDisto = false;
+  std::vector<IndexT> viewIds;
   
   // Create output dir
   if (!fs::exists(outDirectory))
@@ -133,8 +153,46 @@ int main(int argc, char **argv)
     
     if(cam->have_disto())
       bOneHaveDisto = true;
+    viewIds.push_back(view->getViewId());
   }
-  
+
+  if(exportImages)
+  {
+    // the images are named as their camera files
+    const auto getDstImage = [&](const View& view)
+    {
+      return (fs::path(outDirectory) / (fs::path(view.getImagePath()).stem().string() + outputExtension)).string();
+    };
+
+    // the images without distortion are copied if they are already in the output file type
+    const auto copyImage = [&](const View& view)
+    {
+      const std::string& srcImage = view.getImagePath();
+      if(sfm_data.getIntrinsicPtr(view.getIntrinsicId())->have_disto() ||
+         boost::algorithm::to_lower_copy(fs::path(srcImage).extension().string()) != outputExtension)
+        return false;
+      fs::copy_file(srcImage, getDstImage(view), fs::copy_option::overwrite_if_exists);
+      return true;
+    };
+
+    try
+    {
+      exportUndistortedViews(sfm_data, viewIds, exportParams, [&](const View& view, const Image<RGBfColor>& image)
+      {
+        writeImage(getDstImage(view), image);
+      }, copyImage);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Failed to export the undistorted images: " << e.what());
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Your SfMData file was succesfully converted!\n"
+              << "Now you can run MVS Texturing on the \"" << outDirectory << "\" folder" << std::endl;
+    return EXIT_SUCCESS;
+  }
+
   const std::string sUndistMsg = bOneHaveDisto ? "undistorded" : "";
   const std::string sQuitMsg = std::string("Your SfMData file was succesfully converted!\n") +
     "Now you can copy your " + sUndistMsg + " images in the \"" + outDirectory + "\" folder and run MVS Texturing";
@@ -12,6 +12,8 @@
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 #include <aliceVision/feature/svgVisualization.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
+#include <aliceVision/system/TaskScheduler.hpp>
 #include <aliceVision/system/cmdline.hpp>
 
 #include <dependencies/vectorGraphics/svgDrawer.hpp>
@@ -25,11 +27,13 @@
 #include <vector>
 #include <fstream>
 #include <map>
+#include <mutex>
+#include <random>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::feature;
@@ -81,6 +85,9 @@ int main(int argc, char ** argv)
   // user optional parameters
 
   std::string describerTypesName = EImageDescriberType_enumToString(EImageDescriberType::SIFT);
+  bool exportSvg = true;
+  bool exportCsv = false;
+  int maxThreads = 0;
 
   po::options_description allParams("AliceVision exportMatches");
 
@@ -98,7 +105,14 @@ int main(int argc, char ** argv)
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
     ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
-      EImageDescriberType_informations().c_str());
+      EImageDescriberType_informations().c_str())
+    ("exportSvg", po::value<bool>(&exportSvg)->default_value(exportSvg),
+      "Export one SVG file per image pair.")
+    ("exportCsv", po::value<bool>(&exportCsv)->default_value(exportCsv),
+      "Export all the matches in a CSV file (matches.csv), one line per match: "
+      "viewIdI,viewIdJ,describerType,featureI,featureJ,xI,yI,xJ,yJ (image pairs in any order).")
+    ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
+      "Max number of threads (0: automatic).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -177,12 +191,25 @@ int main(int argc, char ** argv)
 
   fs::create_directory(outputFolder);
   ALICEVISION_LOG_INFO("Export pairwise matches");
-  const PairSet pairs = matching::getImagePairs(pairwiseMatches);
+  const PairSet pairSet = matching::getImagePairs(pairwiseMatches);
+  const std::vector<Pair> pairs(pairSet.begin(), pairSet.end());
+
+  std::ofstream csvFile;
+  if(exportCsv)
+  {
+    csvFile.open((fs::path(outputFolder) / "matches.csv").string());
+    csvFile << "viewIdI,viewIdJ,describerType,featureI,featureJ,xI,yI,xJ,yJ\n";
+  }
+
+  std::mutex outputMutex;
   boost::progress_display myProgressBar(pairs.size());
-  for (PairSet::const_iterator iter = pairs.begin(); iter != pairs.end(); ++iter, ++myProgressBar)
+
+  // the output of each pair is written as soon as it is built, so the memory is bounded by the running pairs
+  const int nbThreads = system::ResourceBudget::get().getNbThreads(maxThreads);
+  system::parallelFor(0, pairs.size(), [&](int p)
   {
-    const std::size_t I = iter->first;
-    const std::size_t J = iter->second;
+    const std::size_t I = pairs[p].first;
+    const std::size_t J = pairs[p].second;
 
     const View* viewI = sfmData.getViews().at(I).get();
     const View* viewJ = sfmData.getViews().at(J).get();
@@ -193,60 +220,94 @@ int main(int argc, char ** argv)
     const std::pair<size_t, size_t> dimImageI = std::make_pair(viewI->getWidth(), viewI->getHeight());
     const std::pair<size_t, size_t> dimImageJ = std::make_pair(viewJ->getWidth(), viewJ->getHeight());
 
-    svgDrawer svgStream(dimImageI.first + dimImageJ.first, max(dimImageI.second, dimImageJ.second));
-
-    svgStream.drawImage(viewImagePathI, dimImageI.first, dimImageI.second);
-    svgStream.drawImage(viewImagePathJ, dimImageJ.first, dimImageJ.second, dimImageI.first);
+    const matching::MatchesPerDescType& filteredMatches = pairwiseMatches.at(pairs[p]);
 
-    const matching::MatchesPerDescType& filteredMatches = pairwiseMatches.at(*iter);
+    ALICEVISION_LOG_DEBUG("nb describer: " << filteredMatches.size());
 
-    ALICEVISION_LOG_INFO("nb describer: " << filteredMatches.size());
+    if(!filteredMatches.empty())
+    {
+      svgDrawer svgStream(dimImageI.first + dimImageJ.first, std::max(dimImageI.second, dimImageJ.second));
+      std::ostringstream csvStream;
 
-    if(filteredMatches.empty())
-      continue;
+      if(exportSvg)
+      {
+        svgStream.drawImage(viewImagePathI, dimImageI.first, dimImageI.second);
+        svgStream.drawImage(viewImagePathJ, dimImageJ.first, dimImageJ.second, dimImageI.first);
+      }
 
-    for(const auto& matchesIt: filteredMatches)
-    {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      assert(descType != feature::EImageDescriberType::UNINITIALIZED);
-      const matching::IndMatches& matches = matchesIt.second;
-      ALICEVISION_LOG_INFO(EImageDescriberType_enumToString(matchesIt.first) << ": " << matches.size() << " matches");
+      // colours of a pair are the same from a run to another, whatever the thread
+      std::minstd_rand randomNumberGenerator(static_cast<unsigned int>(I * 73856093 ^ J * 19349663));
 
-      const PointFeatures& featuresI = featuresPerView.getFeatures(viewI->getViewId(), descType);
-      const PointFeatures& featuresJ = featuresPerView.getFeatures(viewJ->getViewId(), descType);
+      for(const auto& matchesIt: filteredMatches)
+      {
+        const feature::EImageDescriberType descType = matchesIt.first;
+        assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+        const matching::IndMatches& matches = matchesIt.second;
+        ALICEVISION_LOG_DEBUG(EImageDescriberType_enumToString(matchesIt.first) << ": " << matches.size() << " matches");
+
+        const PointFeatures& featuresI = featuresPerView.getFeatures(viewI->getViewId(), descType);
+        const PointFeatures& featuresJ = featuresPerView.getFeatures(viewJ->getViewId(), descType);
+
+        if(exportCsv)
+        {
+          const std::string descTypeName = EImageDescriberType_enumToString(descType);
+          for(const matching::IndMatch& match : matches)
+          {
+            const PointFeature& imaA = featuresI[match._i];
+            const PointFeature& imaB = featuresJ[match._j];
+            csvStream << I << ',' << J << ',' << descTypeName << ',' << match._i << ',' << match._j << ','
+                      << imaA.x() << ',' << imaA.y() << ',' << imaB.x() << ',' << imaB.y() << '\n';
+          }
+        }
+
+        if(!exportSvg)
+          continue;
+
+        // draw link between features :
+        for(std::size_t i = 0; i < matches.size(); ++i)
+        {
+          const PointFeature& imaA = featuresI[matches[i]._i];
+          const PointFeature& imaB = featuresJ[matches[i]._j];
+
+          // compute a flashy colour for the correspondence
+          unsigned char r,g,b;
+          hslToRgb( (randomNumberGenerator() % 360) / 360., 1.0, .5, r, g, b);
+          std::ostringstream osCol;
+          osCol << "rgb(" << (int)r <<',' << (int)g << ',' << (int)b <<")";
+          svgStream.drawLine(imaA.x(), imaA.y(),
+            imaB.x()+dimImageI.first, imaB.y(), svgStyle().stroke(osCol.str(), 2.0));
+        }
+
+        const std::string featColor = describerTypeColor(descType);
+        // draw features (in two loop, in order to have the features upper the link, svg layer order):
+        for(std::size_t i=0; i< matches.size(); ++i)
+        {
+          const PointFeature& imaA = featuresI[matches[i]._i];
+          const PointFeature& imaB = featuresJ[matches[i]._j];
+          svgStream.drawCircle(imaA.x(), imaA.y(), 5.0,
+            svgStyle().stroke(featColor, 2.0));
+          svgStream.drawCircle(imaB.x() + dimImageI.first, imaB.y(), 5.0,
+            svgStyle().stroke(featColor, 2.0));
+        }
+      }
 
-      // draw link between features :
-      for(std::size_t i = 0; i < matches.size(); ++i)
+      if(exportSvg)
       {
-        const PointFeature& imaA = featuresI[matches[i]._i];
-        const PointFeature& imaB = featuresJ[matches[i]._j];
-
-        // compute a flashy colour for the correspondence
-        unsigned char r,g,b;
-        hslToRgb( (rand() % 360) / 360., 1.0, .5, r, g, b);
-        std::ostringstream osCol;
-        osCol << "rgb(" << (int)r <<',' << (int)g << ',' << (int)b <<")";
-        svgStream.drawLine(imaA.x(), imaA.y(),
-          imaB.x()+dimImageI.first, imaB.y(), svgStyle().stroke(osCol.str(), 2.0));
+        fs::path outputFilename = fs::path(outputFolder) / std::string(std::to_string(I) + "_" + std::to_string(J) + "_" + std::to_string(filteredMatches.getNbAllMatches()) + ".svg");
+        std::ofstream svgFile(outputFilename.string());
+        svgFile << svgStream.closeSvgFile().str();
       }
 
-      const std::string featColor = describerTypeColor(descType);
-      // draw features (in two loop, in order to have the features upper the link, svg layer order):
-      for(std::size_t i=0; i< matches.size(); ++i)
+      if(exportCsv)
       {
-        const PointFeature& imaA = featuresI[matches[i]._i];
-        const PointFeature& imaB = featuresJ[matches[i]._j];
-        svgStream.drawCircle(imaA.x(), imaA.y(), 5.0,
-          svgStyle().stroke(featColor, 2.0));
-        svgStream.drawCircle(imaB.x() + dimImageI.first, imaB.y(), 5.0,
-          svgStyle().stroke(featColor, 2.0));
+        std::lock_guard<std::mutex> lock(outputMutex);
+        csvFile << csvStream.str();
       }
     }
 
-    fs::path outputFilename = fs::path(outputFolder) / std::string(std::to_string(iter->first) + "_" + std::to_string(iter->second) + "_" + std::to_string(filteredMatches.getNbAllMatches()) + ".svg");
-    ofstream svgFile(outputFilename.string());
-    svgFile << svgStream.closeSvgFile().str();
-    svgFile.close();
-  }
+    std::lock_guard<std::mutex> lock(outputMutex);
+    ++myProgressBar;
+  }, nbThreads);
+
   return EXIT_SUCCESS;
 }
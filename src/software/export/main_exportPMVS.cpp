@@ -21,7 +21,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -37,6 +37,7 @@ bool exportToPMVSFormat(
   const std::string & sOutDirectory,  //Output PMVS files folder
   const int downsampling_factor,
   const int CPU_core_count,
+  const UndistortedViewsExportParams& exportParams,
   const bool b_VisData = true
   )
 {
@@ -65,7 +66,7 @@ bool exportToPMVSFormat(
 
   if (bOk)
   {
-    boost::progress_display my_progress_bar( sfm_data.getViews().size()*2 );
+    boost::progress_display my_progress_bar( sfm_data.getViews().size() );
 
     // Since PMVS requires contiguous camera index, and that some views can have some missing poses,
     // we reindex the poses to ensure a contiguous pose list.
@@ -96,43 +97,41 @@ bool exportToPMVSFormat(
     }
 
     // Export (calibrated) views as undistorted images
-    Image<RGBColor> image, image_ud;
-    for(Views::const_iterator iter = sfm_data.getViews().begin();
-      iter != sfm_data.getViews().end(); ++iter, ++my_progress_bar)
+    const auto getDstImage = [&](const View& view)
     {
-      const View * view = iter->second.get();
-      if (!sfm_data.isPoseAndIntrinsicDefined(view))
-        continue;
+      std::ostringstream os;
+      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous.at(view.getViewId());
+      return (fs::path(sOutDirectory) / std::string("visualize") / (os.str() + ".jpg")).string();
+    };
 
-      Intrinsics::const_iterator iterIntrinsic = sfm_data.getIntrinsics().find(view->getIntrinsicId());
+    // copy the images without distortion if extension match
+    const auto copyImage = [&](const View& view)
+    {
+      const IntrinsicBase * cam = sfm_data.getIntrinsicPtr(view.getIntrinsicId());
+      const std::string srcImage = view.getImagePath();
+      if ((cam->isValid() && cam->have_disto()) ||
+        (fs::extension(srcImage) != ".JPG" && fs::extension(srcImage) != ".jpg"))
+        return false;
+      fs::copy_file(srcImage, getDstImage(view), fs::copy_option::overwrite_if_exists);
+      return true;
+    };
 
-      // We have a valid view with a corresponding camera & pose
-      const std::string srcImage = view->getImagePath();
-      std::ostringstream os;
-      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous[view->getViewId()];
-      const std::string dstImage = (fs::path(sOutDirectory) / std::string("visualize") / (os.str() + ".jpg")).string();
-      const IntrinsicBase * cam = iterIntrinsic->second.get();
-      if (cam->isValid() && cam->have_disto())
-      {
-        // undistort the image and save it
-        readImage( srcImage, image);
-        UndistortImage(image, cam, image_ud, BLACK);
-        writeImage(dstImage, image_ud);
-      }
-      else // (no distortion)
+    std::vector<IndexT> viewIds;
+    viewIds.reserve(map_viewIdToContiguous.size());
+    for(const auto& viewIdToContiguous : map_viewIdToContiguous)
+      viewIds.push_back(viewIdToContiguous.first);
+
+    try
+    {
+      exportUndistortedViews(sfm_data, viewIds, exportParams, [&](const View& view, const Image<RGBfColor>& image)
       {
-        // copy the image if extension match
-        if (fs::extension(srcImage) == ".JPG" ||
-          fs::extension(srcImage) == ".jpg")
-        {
-          fs::copy_file(srcImage, dstImage);
-        }
-        else
-        {
-          readImage(srcImage, image);
-          writeImage(dstImage, image);
-        }
-      }
+        writeImage(getDstImage(view), image);
+      }, copyImage);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Failed to export the undistorted images: " << e.what());
+      return false;
     }
 
     //pmvs_options.txt
@@ -314,6 +313,7 @@ int main(int argc, char *argv[])
   int resolution = 1;
   int nbCore = 8;
   bool useVisData = true;
+  UndistortedViewsExportParams exportParams;
 
   po::options_description allParams("AliceVision exportPMVS");
 
@@ -331,7 +331,13 @@ int main(int argc, char *argv[])
     ("nbCore", po::value<int>(&nbCore)->default_value(nbCore),
       "Nb core")
     ("useVisData", po::value<bool>(&useVisData)->default_value(useVisData),
-      "Use visibility information.");
+      "Use visibility information.")
+    ("nbDecodeThreads", po::value<int>(&exportParams.nbDecodeThreads)->default_value(exportParams.nbDecodeThreads),
+      "Number of threads decoding the source images.")
+    ("nbUndistortThreads", po::value<int>(&exportParams.nbUndistortThreads)->default_value(exportParams.nbUndistortThreads),
+      "Number of threads undistorting the images (each one uses all the cores).")
+    ("nbEncodeThreads", po::value<int>(&exportParams.nbEncodeThreads)->default_value(exportParams.nbEncodeThreads),
+      "Number of threads encoding the exported images.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -380,11 +386,13 @@ int main(int argc, char *argv[])
   }
 
   {
-    exportToPMVSFormat(sfm_data,
+    if(!exportToPMVSFormat(sfm_data,
       (fs::path(outputFolder) / std::string("PMVS")).string(),
       resolution,
       nbCore,
-      useVisData);
+      exportParams,
+      useVisData))
+      return EXIT_FAILURE;
 
     exportToBundlerFormat(sfm_data,
       (fs::path(outputFolder) /
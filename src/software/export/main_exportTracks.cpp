@@ -14,6 +14,8 @@
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 #include <aliceVision/feature/svgVisualization.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
+#include <aliceVision/system/TaskScheduler.hpp>
 #include <aliceVision/system/cmdline.hpp>
 
 #include <software/utils/sfmHelper/sfmIOHelper.hpp>
@@ -24,10 +26,13 @@
 #include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
+#include <fstream>
+#include <mutex>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::feature;
@@ -52,6 +57,9 @@ int main(int argc, char ** argv)
   // user optional parameters
 
   std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  bool exportSvg = true;
+  bool exportCsv = false;
+  int maxThreads = 0;
 
   po::options_description allParams("AliceVision exportTracks");
 
@@ -69,7 +77,14 @@ int main(int argc, char ** argv)
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
     ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
-      feature::EImageDescriberType_informations().c_str());
+      feature::EImageDescriberType_informations().c_str())
+    ("exportSvg", po::value<bool>(&exportSvg)->default_value(exportSvg),
+      "Export one SVG file per image pair.")
+    ("exportCsv", po::value<bool>(&exportCsv)->default_value(exportCsv),
+      "Export the common tracks of the image pairs in a CSV file (tracks.csv), one line per track and pair: "
+      "viewIdI,viewIdJ,trackId,describerType,featureI,featureJ,xI,yI,xJ,yJ (image pairs in any order).")
+    ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
+      "Max number of threads (0: automatic).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -157,23 +172,37 @@ int main(int argc, char ** argv)
     ALICEVISION_LOG_INFO("# tracks: " << tracksBuilder.nbTracks());
   }
 
+  // visible tracks of each view, to find the common tracks of a pair without going through all the tracks
+  track::TracksPerView tracksPerView;
+  track::tracksUtilsMap::computeTracksPerView(mapTracks, tracksPerView);
+
   // for each pair, export the matches
   fs::create_directory(outputFolder);
-  boost::progress_display myProgressBar( (viewCount*(viewCount-1)) / 2.0 , std::cout, "Export pairwise tracks\n");
 
-  for(std::size_t I = 0; I < viewCount; ++I)
+  std::vector<const View*> views;
+  views.reserve(viewCount);
+  for(const auto& viewIt : sfmData.getViews())
+    views.push_back(viewIt.second.get());
+
+  std::ofstream csvFile;
+  if(exportCsv)
   {
-    auto itI = sfmData.getViews().begin();
-    std::advance(itI, I);
+    csvFile.open((fs::path(outputFolder) / "tracks.csv").string());
+    csvFile << "viewIdI,viewIdJ,trackId,describerType,featureI,featureJ,xI,yI,xJ,yJ\n";
+  }
 
-    const View* viewI = itI->second.get();
+  std::mutex outputMutex;
+  boost::progress_display myProgressBar( (viewCount*(viewCount-1)) / 2.0 , std::cout, "Export pairwise tracks\n");
 
-    for(std::size_t J = I+1; J < viewCount; ++J, ++myProgressBar)
-    {
-      auto itJ = sfmData.getViews().begin();
-      std::advance(itJ, J);
+  // the output of each pair is written as soon as it is built, so the memory is bounded by the running pairs
+  const int nbThreads = system::ResourceBudget::get().getNbThreads(maxThreads);
+  system::parallelFor(0, viewCount, [&](int I)
+  {
+    const View* viewI = views[I];
 
-      const View* viewJ = itJ->second.get();
+    for(std::size_t J = I+1; J < viewCount; ++J)
+    {
+      const View* viewJ = views[J];
 
       const std::string& viewImagePathI = viewI->getImagePath();
       const std::string& viewImagePathJ = viewJ->getImagePath();
@@ -188,7 +217,8 @@ int main(int argc, char ** argv)
       setImageIndex.insert(viewI->getViewId());
       setImageIndex.insert(viewJ->getViewId());
 
-      tracksUtilsMap::getCommonTracksInImages(setImageIndex, mapTracks, mapTracksCommon);
+      if(tracksPerView.count(viewI->getViewId()) && tracksPerView.count(viewJ->getViewId()))
+        tracksUtilsMap::getCommonTracksInImagesFast(setImageIndex, mapTracks, tracksPerView, mapTracksCommon);
 
       if(mapTracksCommon.empty())
       {
@@ -196,7 +226,34 @@ int main(int argc, char ** argv)
       }
       else
       {
-        svgDrawer svgStream(dimImageI.first + dimImageJ.first, max(dimImageI.second, dimImageJ.second));
+        if(exportCsv)
+        {
+          std::ostringstream csvStream;
+          for(const auto& trackIt : mapTracksCommon)
+          {
+            const feature::EImageDescriberType descType = trackIt.second.descType;
+            track::Track::FeatureIdPerView::const_iterator obsIt = trackIt.second.featPerView.begin();
+
+            const std::size_t featureI = obsIt->second;
+            ++obsIt;
+            const std::size_t featureJ = obsIt->second;
+
+            const PointFeature& imaA = featuresPerView.getFeatures(viewI->getViewId(), descType)[featureI];
+            const PointFeature& imaB = featuresPerView.getFeatures(viewJ->getViewId(), descType)[featureJ];
+
+            csvStream << viewI->getViewId() << ',' << viewJ->getViewId() << ',' << trackIt.first << ','
+                      << feature::EImageDescriberType_enumToString(descType) << ',' << featureI << ',' << featureJ << ','
+                      << imaA.x() << ',' << imaA.y() << ',' << imaB.x() << ',' << imaB.y() << '\n';
+          }
+
+          std::lock_guard<std::mutex> lock(outputMutex);
+          csvFile << csvStream.str();
+        }
+
+        if(!exportSvg)
+          continue;
+
+        svgDrawer svgStream(dimImageI.first + dimImageJ.first, std::max(dimImageI.second, dimImageJ.second));
         svgStream.drawImage(viewImagePathI, dimImageI.first, dimImageI.second);
         svgStream.drawImage(viewImagePathJ, dimImageJ.first, dimImageJ.second, dimImageI.first);
 
@@ -241,10 +298,13 @@ int main(int argc, char ** argv)
 
         fs::path outputFilename = fs::path(outputFolder) / std::string(std::to_string(viewI->getViewId()) + "_" + std::to_string(viewJ->getViewId()) + "_" + std::to_string(mapTracksCommon.size()) + ".svg");
 
-        ofstream svgFile(outputFilename.string());
+        std::ofstream svgFile(outputFilename.string());
         svgFile << svgStream.closeSvgFile().str();
       }
     }
-  }
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+    myProgressBar += viewCount - I - 1;
+  }, nbThreads);
   return EXIT_SUCCESS;
 }
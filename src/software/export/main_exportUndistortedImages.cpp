@@ -8,16 +8,16 @@
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/image/all.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/progress.hpp>
 
 #include <stdlib.h>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -36,6 +36,8 @@ int main(int argc, char *argv[])
   std::string sfmDataFilename;
   std::string outDirectory;
   std::string outImageFileTypeName = image::EImageFileType_enumToString(image::EImageFileType::JPEG);
+  std::string storageDataTypeName = image::EStorageDataType_enumToString(image::EStorageDataType::Float);
+  UndistortedViewsExportParams params;
 
   po::options_description allParams(
     "Export undistorted images related to a sfmData file.\n"
@@ -51,7 +53,15 @@ int main(int argc, char *argv[])
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
     ("outputFileType", po::value<std::string>(&outImageFileTypeName)->default_value(outImageFileTypeName),
-      image::EImageFileType_informations().c_str());
+      image::EImageFileType_informations().c_str())
+    ("storageDataType", po::value<std::string>(&storageDataTypeName)->default_value(storageDataTypeName),
+      image::EStorageDataType_informations().c_str())
+    ("nbDecodeThreads", po::value<int>(&params.nbDecodeThreads)->default_value(params.nbDecodeThreads),
+      "Number of threads decoding the source images.")
+    ("nbUndistortThreads", po::value<int>(&params.nbUndistortThreads)->default_value(params.nbUndistortThreads),
+      "Number of threads undistorting the images (each one uses all the cores).")
+    ("nbEncodeThreads", po::value<int>(&params.nbEncodeThreads)->default_value(params.nbEncodeThreads),
+      "Number of threads encoding the exported images.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -89,7 +99,15 @@ int main(int argc, char *argv[])
   system::Logger::get()->setLogLevel(verboseLevel);
 
   // set output file type
-  image::EImageFileType outputFileType = image::EImageFileType_stringToEnum(outImageFileTypeName);
+  const image::EImageFileType outputFileType = image::EImageFileType_stringToEnum(outImageFileTypeName);
+  const image::EStorageDataType storageDataType = image::EStorageDataType_stringToEnum(storageDataTypeName);
+  const std::string outputExtension = "." + image::EImageFileType_enumToString(outputFileType);
+
+  if(params.nbDecodeThreads < 1 || params.nbUndistortThreads < 1 || params.nbEncodeThreads < 1)
+  {
+    ALICEVISION_LOG_ERROR("Each stage of the export needs at least one thread.");
+    return EXIT_FAILURE;
+  }
 
   // Create output dir
   if (!fs::exists(outDirectory))
@@ -102,35 +120,46 @@ int main(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
-  // Export views as undistorted images (those with valid Intrinsics)
-  Image<RGBfColor> image, image_ud;
-  boost::progress_display my_progress_bar( sfmData.getViews().size() );
-  for(Views::const_iterator iter = sfmData.getViews().begin();
-    iter != sfmData.getViews().end(); ++iter, ++my_progress_bar)
+  const auto getDstImage = [&](const View& view)
   {
-    const View* view = iter->second.get();
-    bool bIntrinsicDefined = view->getIntrinsicId() != UndefinedIndexT &&
-      sfmData.getIntrinsics().find(view->getIntrinsicId()) != sfmData.getIntrinsics().end();
+    return (fs::path(outDirectory) / (fs::path(view.getImagePath()).stem().string() + outputExtension)).string();
+  };
 
-    Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
+  // the images without distortion are copied if they are already in the output file type
+  const auto copyImage = [&](const View& view)
+  {
+    const IntrinsicBase* cam = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+    if(cam != nullptr && cam->isValid() && cam->have_disto())
+      return false;
 
-    const std::string srcImage = view->getImagePath();
-    const std::string dstImage = (fs::path(outDirectory) / (fs::path(srcImage).stem().string() + "." + image::EImageFileType_enumToString(outputFileType))).string();
+    const std::string& srcImage = view.getImagePath();
+    if(boost::algorithm::to_lower_copy(fs::path(srcImage).extension().string()) != outputExtension)
+      return false;
 
-    const IntrinsicBase * cam = iterIntrinsic->second.get();
-    if (cam->isValid() && cam->have_disto())
-    {
-      // undistort the image and save it
-      readImage(srcImage, image);
-      UndistortImage(image, cam, image_ud, FBLACK);
-      writeImage(dstImage, image_ud);
-    }
-    else // (no distortion)
-    {
-      // copy the image since there is no distortion
-      fs::copy_file(srcImage, dstImage);
-    }
+    fs::copy_file(srcImage, getDstImage(view), fs::copy_option::overwrite_if_exists);
+    return true;
+  };
+
+  const auto writeUndistortedImage = [&](const View& view, const Image<RGBfColor>& image)
+  {
+    writeImage(getDstImage(view), image, storageDataType);
+  };
+
+  std::vector<IndexT> viewIds;
+  viewIds.reserve(sfmData.getViews().size());
+  for(const auto& viewPair : sfmData.getViews())
+    viewIds.push_back(viewPair.first);
+
+  // Export views as undistorted images
+  try
+  {
+    exportUndistortedViews(sfmData, viewIds, params, writeUndistortedImage, copyImage);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Failed to export the undistorted images: " << e.what());
+    return EXIT_FAILURE;
   }
 
-  return EXIT_SUCCESS ;
+  return EXIT_SUCCESS;
 }
@@ -16,6 +16,7 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -192,48 +193,78 @@ int main(int argc, char** argv)
   aliceVision::system::Timer durationAlgo;
   aliceVision::system::Timer duration;
   
+  // the frames are read by batches and the pattern is detected in parallel in the frames of a batch
+  // (the CCTag detection is not run concurrently)
+  const bool parallelDetection = (patternType == aliceVision::calibration::Pattern::CHESSBOARD ||
+                                  patternType == aliceVision::calibration::Pattern::CIRCLES_GRID ||
+                                  patternType == aliceVision::calibration::Pattern::ASYMMETRIC_CIRCLES_GRID);
+  const std::size_t batchSize = parallelDetection ? omp_get_max_threads() : 1;
+  std::vector<cv::Mat> batchViews;
+  std::vector<std::size_t> batchFrames;
+
   std::size_t currentFrame = 0;
-  while (feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+  bool hasFrame = true;
+  while (hasFrame)
   {
-    cv::Mat viewGray;
-    cv::eigen2cv(imageGrey.GetMat(), viewGray);
+    batchViews.clear();
+    batchFrames.clear();
 
-    // Check image is correctly loaded
-    if (viewGray.size() == cv::Size(0, 0))
-    {
-      throw std::runtime_error(std::string("Invalid image: ") + currentImgName);
-    }
-    // Check image size is always the same
-    if (imageSize == cv::Size(0, 0))
+    while (batchViews.size() < batchSize &&
+           (hasFrame = feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics)))
     {
-      // First image: initialize the image size.
-      imageSize = viewGray.size();
-    }
-    // Check image resolutions are always the same
-    else if (imageSize != viewGray.size())
-    {
-      throw std::runtime_error(std::string("You cannot mix multiple image resolutions during the camera calibration. See image file: ") + currentImgName);
+      cv::Mat viewGray;
+      cv::eigen2cv(imageGrey.GetMat(), viewGray);
+
+      // Check image is correctly loaded
+      if (viewGray.size() == cv::Size(0, 0))
+      {
+        throw std::runtime_error(std::string("Invalid image: ") + currentImgName);
+      }
+      // Check image size is always the same
+      if (imageSize == cv::Size(0, 0))
+      {
+        // First image: initialize the image size.
+        imageSize = viewGray.size();
+      }
+      // Check image resolutions are always the same
+      else if (imageSize != viewGray.size())
+      {
+        throw std::runtime_error(std::string("You cannot mix multiple image resolutions during the camera calibration. See image file: ") + currentImgName);
+      }
+
+      ALICEVISION_CERR("[" << currentFrame << "/" << nbFrames << "] (" << iInputFrame << "/" << nbFramesToProcess << ")");
+
+      batchViews.push_back(viewGray);
+      batchFrames.push_back(currentFrame);
+
+      ++iInputFrame;
+      currentFrame = std::floor(iInputFrame * step);
+      feed.goToFrame(currentFrame);
     }
 
-    std::vector<cv::Point2f> pointbuf;
-    std::vector<int> detectedId;
-    ALICEVISION_CERR("[" << currentFrame << "/" << nbFrames << "] (" << iInputFrame << "/" << nbFramesToProcess << ")");
+    const int nbBatchViews = static_cast<int>(batchViews.size());
+    std::vector<std::vector<cv::Point2f> > batchPoints(nbBatchViews);
+    std::vector<std::vector<int> > batchDetectedIds(nbBatchViews);
+    std::vector<char> batchFound(nbBatchViews, 0);
 
     // Find the chosen pattern in images
-    const bool found = aliceVision::calibration::findPattern(patternType, viewGray, boardSize, detectedId, pointbuf);
-    
-    if (found)
+    #pragma omp parallel for schedule(dynamic) if(parallelDetection)
+    for (int i = 0; i < nbBatchViews; ++i)
     {
-      validFrames.push_back(currentFrame);
-      detectedIdPerFrame.push_back(detectedId);
-      imagePoints.push_back(pointbuf);
+      batchFound[i] = aliceVision::calibration::findPattern(patternType, batchViews[i], boardSize, batchDetectedIds[i], batchPoints[i]);
     }
 
-    ++iInputFrame;
-    currentFrame = std::floor(iInputFrame * step);
-    feed.goToFrame(currentFrame);
+    // keep the frames order
+    for (int i = 0; i < nbBatchViews; ++i)
+    {
+      if (batchFound[i])
+      {
+        validFrames.push_back(batchFrames[i]);
+        detectedIdPerFrame.push_back(batchDetectedIds[i]);
+        imagePoints.push_back(batchPoints[i]);
+      }
+    }
   }
-
   
   ALICEVISION_CERR("find points duration: " << aliceVision::system::prettyTime(duration.elapsedMs()));
   ALICEVISION_CERR("Grid detected in " << imagePoints.size() << " images on " << iInputFrame << " input images.");
@@ -84,7 +84,7 @@ int main(int argc, char* argv[])
     mvsUtils::MultiViewParams mp(iniFilepath);
     mvsUtils::PreMatchCams pc(&mp);
 
-    ALICEVISION_LOG_INFO("Compute camera pairs.");
+    ALICEVISION_LOG_INFO("Compute camera neighbors.");
     pc.precomputeIncidentMatrixCamsFromSeeds();
 
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
@@ -27,7 +27,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::sfm;
@@ -143,6 +143,7 @@ int main(int argc, char **argv)
   int groupCameraModel = 2;
   bool allowIncompleteOutput = false;
   bool allowSingleView = false;
+  int nbIOThreads = 0;
 
   po::options_description allParams("AliceVision cameraInit");
 
@@ -176,7 +177,10 @@ int main(int argc, char **argv)
       "Warning: if incomplete the output file can't be use in another program and should be post-process.")
     ("allowSingleView", po::value<bool>(&allowSingleView)->default_value(allowSingleView),
       "Allow the program to process a single view.\n"
-      "Warning: if a single view is process, the output file can't be use in many other programs.");
+      "Warning: if a single view is process, the output file can't be use in many other programs.")
+    ("nbIOThreads", po::value<int>(&nbIOThreads)->default_value(nbIOThreads),
+      "Max. number of image headers read at the same time (0: number of cores).\n"
+      "Reading the metadata is latency bound on network filesystems: use more threads than cores.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -300,10 +304,10 @@ int main(int argc, char **argv)
   }
 
   // check sensor database
-  std::vector<sensorDB::Datasheet> sensorDatabase;
+  sensorDB::SensorDatabase sensorDatabase;
   if(!sensorDatabasePath.empty())
   {
-    if(!sensorDB::parseDatabase(sensorDatabasePath, sensorDatabase))
+    if(!sensorDatabase.load(sensorDatabasePath))
     {
       ALICEVISION_LOG_ERROR("Invalid input database '" << sensorDatabasePath << "', please specify a valid file.");
       return EXIT_FAILURE;
@@ -326,7 +330,7 @@ int main(int argc, char **argv)
   if(imageFolder.empty())
   {
     // fill SfMData from the JSON file
-    sfm::loadJSON(sfmData, sfmFilePath, ESfMData(VIEWS|INTRINSICS|EXTRINSICS), true);
+    sfm::loadJSON(sfmData, sfmFilePath, ESfMData(VIEWS|INTRINSICS|EXTRINSICS), true, nbIOThreads);
   }
   else
   {
@@ -338,13 +342,10 @@ int main(int argc, char **argv)
     {
       std::vector<View> incompleteViews(imagePaths.size());
 
-      #pragma omp parallel for
       for(int i = 0; i < incompleteViews.size(); ++i)
-      {
-        View& view = incompleteViews.at(i);
-        view.setImagePath(imagePaths.at(i));
-        sfm::updateIncompleteView(view);
-      }
+        incompleteViews.at(i).setImagePath(imagePaths.at(i));
+
+      sfm::updateIncompleteViews(incompleteViews, nbIOThreads);
 
       for(const auto& view : incompleteViews)
         views.emplace(view.getViewId(), std::make_shared<View>(view));
@@ -395,7 +396,7 @@ int main(int argc, char **argv)
           // intrinsic px focal length is undefined
           // check if it is because the sensor is not in the database
           aliceVision::sensorDB::Datasheet datasheet;
-          if(hasCameraMetadata && !getInfo(make, model, sensorDatabase, datasheet))
+          if(hasCameraMetadata && !sensorDatabase.getInfo(make, model, datasheet))
           {
             #pragma omp critical
             unknownSensors.emplace(std::make_pair(make, model), view.getImagePath()); // will throw an error message
@@ -412,7 +413,7 @@ int main(int argc, char **argv)
       if(hasCameraMetadata)
       {
         aliceVision::sensorDB::Datasheet datasheet;
-        if(getInfo(make, model, sensorDatabase, datasheet))
+        if(sensorDatabase.getInfo(make, model, datasheet))
         {
           // sensor is in the database
           ALICEVISION_LOG_DEBUG("Sensor width found in database: " << std::endl
@@ -421,7 +422,10 @@ int main(int argc, char **argv)
                                 << "\t- sensor width: " << datasheet._sensorSize << " mm");
 
           if(datasheet._model != model) // the camera model in database is slightly different
+          {
+            #pragma omp critical
             unsureSensors.emplace(std::make_pair(make, model), std::make_pair(view.getImagePath(), datasheet)); // will throw a warning message
+          }
 
           sensorWidth = datasheet._sensorSize;
         }
@@ -11,7 +11,9 @@
 #include <aliceVision/localization/CCTagLocalizer.hpp>
 #endif
 #include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/localization/LocalizationPipeline.hpp>
 #include <aliceVision/localization/optimization.hpp>
+#include <aliceVision/localization/SequenceRefiner.hpp>
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
@@ -32,6 +34,7 @@
 #include <boost/accumulators/statistics/max.hpp>
 #include <boost/accumulators/statistics/sum.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -45,7 +48,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 5
 
 using namespace aliceVision;
 
@@ -103,16 +106,26 @@ int main(int argc, char** argv)
   std::string vocTreeFilepath;
   /// the vocabulary tree weights file
   std::string weightsFilepath;
+  /// the landmarks database folder to load
+  std::string landmarksDatabaseFolder;
+  /// the folder where to export the landmarks database
+  std::string exportLandmarksDatabaseFolder;
   /// Number of previous frame of the sequence to use for matching
   std::size_t nbFrameBufferMatching = 10;
   /// enable/disable the robust matching (geometric validation) when matching query image
   /// and databases images
   bool robustMatching = true;
+  /// match the query image once against the merged covisible database images
+  bool covisibilityMatching = false;
+  /// minimum number of common landmarks of the merged database images
+  std::size_t minCovisibleLandmarks = 30;
   
   /// the Alembic export file
   std::string exportAlembicFile = "trackedcameras.abc";
   /// the JSON export file
   std::string exportJsonFile = "";
+  /// the binary export file, written frame by frame
+  std::string exportBinaryFile = "";
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
   // parameters for cctag localizer
@@ -128,10 +141,19 @@ int main(int argc, char** argv)
   /// remove the points that does not have a minimum visibility over the sequence
   /// ie that are seen at least by minPointVisibility frames of the sequence
   std::size_t minPointVisibility = 0;
+  /// number of last frames refined while localizing the sequence (0: disabled)
+  std::size_t refineWindowSize = 0;
+  /// number of frames before the refined window with a constant pose
+  std::size_t refineWindowLockedFrames = 2;
   
   /// whether to save visual debug info
   std::string visualDebug = "";
 
+  /// run the decoding, the feature extraction and the localization of the frames concurrently
+  bool usePipeline = false;
+  /// the number of feature extraction threads of the pipeline (0 = number of cores)
+  std::size_t nbExtractionThreads = 0;
+
   po::options_description allParams(
       "This program takes as input a media (image, image sequence, video) and a database (vocabulary tree, 3D scene data) \n"
       "and returns for each frame a pose estimation for the camera.");
@@ -166,7 +188,12 @@ int main(int argc, char** argv)
           "Enable/Disable camera intrinsics refinement for each localized image")
       ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax), 
           "Maximum reprojection error (in pixels) allowed for resectioning. If set "
-          "to 0 it lets the ACRansac select an optimal value.");
+          "to 0 it lets the ACRansac select an optimal value.")
+      ("pipeline", po::value<bool>(&usePipeline)->default_value(usePipeline),
+          "Decode the frames, extract their features and localize them concurrently, "
+          "the frames are still localized in order.")
+      ("nbExtractionThreads", po::value<std::size_t>(&nbExtractionThreads)->default_value(nbExtractionThreads),
+          "Number of feature extraction threads for --pipeline (0 = number of cores).");
   
 // voctree specific options
   po::options_description voctreeParams("Parameters specific for the vocabulary tree-based localizer");
@@ -183,6 +210,12 @@ int main(int argc, char** argv)
           "[voctree] Filename for the vocabulary tree")
       ("voctreeWeights", po::value<std::string>(&weightsFilepath), 
           "[voctree] Filename for the vocabulary tree weights")
+      ("landmarksDatabase", po::value<std::string>(&landmarksDatabaseFolder),
+          "[voctree] Folder of a landmarks database exported with --exportLandmarksDatabase, "
+          "the localizer is initialized from it instead of the descriptors of the images")
+      ("exportLandmarksDatabase", po::value<std::string>(&exportLandmarksDatabaseFolder),
+          "[voctree] Folder where to export the landmarks database of the localizer "
+          "(one descriptor per landmark and the voctree database)")
       ("algorithm", po::value<std::string>(&algostring)->default_value(algostring), 
           "[voctree] Algorithm type: FirstBest, AllResults" )
       ("matchingError", po::value<double>(&matchingErrorMax)->default_value(matchingErrorMax), 
@@ -195,6 +228,13 @@ int main(int argc, char** argv)
       ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching), 
           "[voctree] Enable/Disable the robust matching between query and database images, "
           "all putative matches will be considered.")
+      ("covisibilityMatching", po::value<bool>(&covisibilityMatching)->default_value(covisibilityMatching),
+          "[voctree] For AllResults, group the similar database images by covisibility and match "
+          "the query image once per group. While tracking, the similar images are restricted to "
+          "the ones seeing the frustum of the previous frame.")
+      ("minCovisibleLandmarks", po::value<std::size_t>(&minCovisibleLandmarks)->default_value(minCovisibleLandmarks),
+          "[voctree] Minimum number of common landmarks for two database images to be grouped, "
+          "and of landmarks of a database image in the frustum of the previous frame.")
 // cctag specific options
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
       ("nNearestKeyFrames", po::value<size_t>(&nNearestKeyFrames)->default_value(nNearestKeyFrames), 
@@ -215,7 +255,12 @@ int main(int argc, char** argv)
           "[bundle adjustment] It does not refine intrinsics during BA")
       ("minPointVisibility", po::value<size_t>(&minPointVisibility)->default_value(minPointVisibility), 
           "[bundle adjustment] Minimum number of observation that a point must "
-          "have in order to be considered for bundle adjustment");
+          "have in order to be considered for bundle adjustment")
+      ("refineWindowSize", po::value<std::size_t>(&refineWindowSize)->default_value(refineWindowSize),
+          "[bundle adjustment] Refine the poses of the last N frames and their 3D points "
+          "in a background thread while localizing the sequence (0 to disable)")
+      ("refineWindowLockedFrames", po::value<std::size_t>(&refineWindowLockedFrames)->default_value(refineWindowLockedFrames),
+          "[bundle adjustment] Number of frames before the refined window with a constant pose");
   
 // output options
   po::options_description outputParams("Options for the output of the localizer");
@@ -232,6 +277,9 @@ int main(int argc, char** argv)
 #endif
       ("outputJSON", po::value<std::string>(&exportJsonFile)->default_value(exportJsonFile),
           "Filename for the localization results (raw data) as .json")
+      ("outputBinary", po::value<std::string>(&exportBinaryFile)->default_value(exportBinaryFile),
+          "Filename for the localization results (raw data) in binary, "
+          "each frame is appended as soon as it is localized")
 
       ;
   
@@ -339,9 +387,16 @@ int main(int argc, char** argv)
                                                    descriptorsFolder,
                                                    vocTreeFilepath,
                                                    weightsFilepath,
-                                                   matchDescTypes);
+                                                   matchDescTypes,
+                                                   landmarksDatabaseFolder);
 
     localizer.reset(tmpLoc);
+
+    if(tmpLoc->isInit() && !exportLandmarksDatabaseFolder.empty())
+    {
+      ALICEVISION_COUT("Exporting the landmarks database in " << exportLandmarksDatabaseFolder);
+      tmpLoc->exportLandmarksDatabase(exportLandmarksDatabaseFolder);
+    }
     
     localization::VoctreeLocalizer::Parameters *tmpParam = new localization::VoctreeLocalizer::Parameters();
     param.reset(tmpParam);
@@ -353,6 +408,8 @@ int main(int argc, char** argv)
     tmpParam->_matchingError = matchingErrorMax;
     tmpParam->_nbFrameBufferMatching = nbFrameBufferMatching;
     tmpParam->_useRobustMatching = robustMatching;
+    tmpParam->_useCovisibilityMatching = covisibilityMatching;
+    tmpParam->_minCovisibleLandmarks = minCovisibleLandmarks;
   }
   
   assert(localizer);
@@ -405,46 +462,121 @@ int main(int argc, char** argv)
   bacc::accumulator_set<double, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::sum > > stats;
   
   std::vector<localization::LocalizationResult> vec_localizationResults;
-  
-  while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+
+  std::unique_ptr<localization::LocalizationResultWriter> binaryWriter;
+  if(!exportBinaryFile.empty())
+    binaryWriter.reset(new localization::LocalizationResultWriter(exportBinaryFile));
+
+  // sliding window refinement of the sequence
+  std::unique_ptr<localization::SequenceRefiner> refiner;
+  if(refineWindowSize > 0)
+    refiner.reset(new localization::SequenceRefiner(refineWindowSize, refineWindowLockedFrames, std::max<std::size_t>(minPointVisibility, 2)));
+
+  // update the results with the poses refined since the last frame
+  const auto updateRefinedPoses = [&]()
+  {
+    if(!refiner)
+      return;
+    std::vector<std::pair<std::size_t, geometry::Pose3>> refinedPoses;
+    refiner->getRefinedPoses(refinedPoses);
+    for(const auto& refinedPose : refinedPoses)
+      vec_localizationResults.at(refinedPose.first).setPose(refinedPose.second);
+  };
+
+  // save the result of a frame
+  const auto addResult = [&](const localization::LocalizationResult& localizationResult,
+                             camera::PinholeRadialK3& frameIntrinsics,
+                             const std::string& frameName)
   {
-    ALICEVISION_COUT("******************************");
-    ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
-    ALICEVISION_COUT("******************************");
-    localization::LocalizationResult localizationResult;
-    auto detect_start = std::chrono::steady_clock::now();
-    localizer->localize(imageGrey, 
-                       param.get(),
-                       hasIntrinsics /*useInputIntrinsics*/,
-                       queryIntrinsics,
-                       localizationResult,
-                       currentImgName);
-    auto detect_end = std::chrono::steady_clock::now();
-    auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-    ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
-    stats(detect_elapsed.count());
-    
     vec_localizationResults.emplace_back(localizationResult);
 
+    if(binaryWriter)
+      binaryWriter->append(localizationResult);
+
+    if(refiner)
+    {
+      refiner->addFrame(localizationResult);
+      updateRefinedPoses();
+    }
+
     // save data
     if(localizationResult.isValid())
     {
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
-      exporter.addCameraKeyframe(localizationResult.getPose(), &queryIntrinsics, currentImgName, frameCounter, frameCounter);
+      exporter.addCameraKeyframe(localizationResult.getPose(), &frameIntrinsics, frameName, frameCounter, frameCounter);
 #endif
       
       goodFrameCounter++;
-      goodFrameList.push_back(currentImgName + " : " + std::to_string(localizationResult.getIndMatch3D2D().size()) );
+      goodFrameList.push_back(frameName + " : " + std::to_string(localizationResult.getIndMatch3D2D().size()) );
     }
     else
     {
       ALICEVISION_CERR("Unable to localize frame " << frameCounter);
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
-      exporter.jumpKeyframe(currentImgName);
+      exporter.jumpKeyframe(frameName);
 #endif
     }
     ++frameCounter;
-    feed.goToNextFrame();
+  };
+
+  if(usePipeline)
+  {
+    localization::LocalizationPipeline pipeline(*localizer, *param, matchDescTypes, nbExtractionThreads);
+
+    pipeline.run(
+      [&](image::Image<float>& frameImage, camera::PinholeRadialK3& frameIntrinsics, std::string& frameName, bool& frameHasIntrinsics)
+      {
+        if(!feed.readImage(frameImage, frameIntrinsics, frameName, frameHasIntrinsics))
+          return false;
+        feed.goToNextFrame();
+        return true;
+      },
+      [&](const localization::PipelineFrame& frame)
+      {
+        ALICEVISION_COUT("FRAME " << myToString(frame.frameId, 4) << ": pose latency " << frame.poseLatency << " [ms]");
+        stats(frame.localizationLatency);
+        currentImgName = frame.imagePath;
+        queryIntrinsics = frame.intrinsics;
+        addResult(frame.localizationResult, queryIntrinsics, currentImgName);
+      });
+
+    ALICEVISION_COUT("\n\n******************************");
+    ALICEVISION_COUT("Latencies of the pipeline stages:");
+    ALICEVISION_COUT("Decoding:           " << pipeline.getDecodeLatencies());
+    ALICEVISION_COUT("Feature extraction: " << pipeline.getExtractionLatencies());
+    ALICEVISION_COUT("Localization:       " << pipeline.getLocalizationLatencies());
+    ALICEVISION_COUT("Pose:               " << pipeline.getPoseLatencies());
+  }
+  else
+  {
+    while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+    {
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
+      ALICEVISION_COUT("******************************");
+      localization::LocalizationResult localizationResult;
+      auto detect_start = std::chrono::steady_clock::now();
+      localizer->localize(imageGrey, 
+                         param.get(),
+                         hasIntrinsics /*useInputIntrinsics*/,
+                         queryIntrinsics,
+                         localizationResult,
+                         currentImgName);
+      auto detect_end = std::chrono::steady_clock::now();
+      auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+      ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
+      stats(detect_elapsed.count());
+
+      addResult(localizationResult, queryIntrinsics, currentImgName);
+      feed.goToNextFrame();
+    }
+  }
+
+  if(refiner)
+  {
+    refiner->flush();
+    updateRefinedPoses();
+    ALICEVISION_COUT("Sequence refined " << refiner->getNbRefinements() << " times with a window of " << refineWindowSize << " frames");
   }
 
   if(wantsJsonOutput)
@@ -0,0 +1,332 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Telemetry.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/gpu.hpp>
+#include <aliceVision/imageIO/MemoryImages.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/depthMap/RefineRc.hpp>
+#include <aliceVision/depthMap/SemiGlobalMatchingRc.hpp>
+#include <aliceVision/mesh/meshPostProcessing.hpp>
+#include <aliceVision/fuseCut/Fuser.hpp>
+#include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace bfs = boost::filesystem;
+namespace po = boost::program_options;
+
+int main(int argc, char* argv[])
+{
+    system::Timer timer;
+
+    std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+    std::string iniFilepath;
+    std::string outputMesh;
+
+    // depth maps estimation
+    int downscale = 2;
+    int nbGPUs = 0;
+
+    // depth maps filtering
+    int minNumOfConsistensCams = 3;
+    int minNumOfConsistensCamsWithLowSimilarity = 4;
+    int pixSizeBall = 0;
+    int pixSizeBallWithLowSimilarity = 0;
+    int nNearestCams = 10;
+
+    // meshing
+    fuseCut::FuseParams fuseParams;
+    fuseParams.streamingFuse = true;
+
+    bool writeDepthMaps = false;
+
+    po::options_description allParams("AliceVision denseReconstruction\n"
+                                      "Estimate, filter and fuse the depth maps in a mesh, "
+                                      "the depth maps are kept in memory between the steps");
+
+    po::options_description requiredParams("Required parameters");
+    requiredParams.add_options()
+        ("ini", po::value<std::string>(&iniFilepath)->required(),
+            "Configuration file (mvs.ini).")
+        ("output,o", po::value<std::string>(&outputMesh)->required(),
+            "Output mesh (OBJ, PLY or BIN file format, from the extension).");
+
+    po::options_description optionalParams("Optional parameters");
+    optionalParams.add_options()
+        ("downscale", po::value<int>(&downscale)->default_value(downscale),
+            "Image downscale factor of the depth maps.")
+        ("nbGPUs", po::value<int>(&nbGPUs)->default_value(nbGPUs),
+            "Number of GPUs to use (0 means use all available GPUs).")
+        ("minNumOfConsistensCams", po::value<int>(&minNumOfConsistensCams)->default_value(minNumOfConsistensCams),
+            "Filtering: Minimal number of consistent cameras to consider the pixel.")
+        ("minNumOfConsistensCamsWithLowSimilarity", po::value<int>(&minNumOfConsistensCamsWithLowSimilarity)->default_value(minNumOfConsistensCamsWithLowSimilarity),
+            "Filtering: Minimal number of consistent cameras to consider the pixel when the similarity is weak or ambiguous.")
+        ("pixSizeBall", po::value<int>(&pixSizeBall)->default_value(pixSizeBall),
+            "Filtering: Filter ball size (in px).")
+        ("pixSizeBallWithLowSimilarity", po::value<int>(&pixSizeBallWithLowSimilarity)->default_value(pixSizeBallWithLowSimilarity),
+            "Filtering: Filter ball size (in px) when the similarity is weak or ambiguous.")
+        ("nNearestCams", po::value<int>(&nNearestCams)->default_value(nNearestCams),
+            "Filtering: Number of nearest cameras.")
+        ("maxInputPoints", po::value<int>(&fuseParams.maxInputPoints)->default_value(fuseParams.maxInputPoints),
+            "Meshing: Max input points loaded from the depth maps.")
+        ("maxPoints", po::value<int>(&fuseParams.maxPoints)->default_value(fuseParams.maxPoints),
+            "Meshing: Max points at the end of the depth maps fusion.")
+        ("minStep", po::value<int>(&fuseParams.minStep)->default_value(fuseParams.minStep),
+            "Meshing: Minimal step used to load the depth values from the depth maps.")
+        ("nbCamerasPerBatch", po::value<int>(&fuseParams.nbCamerasPerBatch)->default_value(fuseParams.nbCamerasPerBatch),
+            "Meshing: Number of depth maps loaded in parallel by the streaming fusion.")
+        ("writeDepthMaps", po::value<bool>(&writeDepthMaps)->default_value(writeDepthMaps),
+            "Also write the depth maps and the filtered depth maps next to the output mesh (debug).");
+
+    po::options_description logParams("Log parameters");
+    logParams.add_options()
+      ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+        "verbosity level (fatal, error, warning, info, debug, trace).");
+
+    allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+    po::variables_map vm;
+
+    try
+    {
+      po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+      if(vm.count("help") || (argc == 1))
+      {
+        ALICEVISION_COUT(allParams);
+        return EXIT_SUCCESS;
+      }
+
+      po::notify(vm);
+    }
+    catch(boost::program_options::required_option& e)
+    {
+      ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+      ALICEVISION_COUT("Usage:\n\n" << allParams);
+      return EXIT_FAILURE;
+    }
+    catch(boost::program_options::error& e)
+    {
+      ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+      ALICEVISION_COUT("Usage:\n\n" << allParams);
+      return EXIT_FAILURE;
+    }
+
+    ALICEVISION_COUT("Program called with the following parameters:");
+    ALICEVISION_COUT(vm);
+
+    // set verbose level
+    system::Logger::get()->setLogLevel(verboseLevel);
+
+    system::StageTelemetry telemetry("denseReconstruction");
+
+    // print GPU Information
+    ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
+
+    // check if the gpu suppport CUDA compute capability 2.0
+    if(!system::gpuSupportCUDA(2,0))
+    {
+      ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capablility 2.0).");
+      return EXIT_FAILURE;
+    }
+
+    if(nbGPUs < 0)
+    {
+      ALICEVISION_LOG_ERROR("Invalid value for nbGPUs parameter. Should be positive or 0 to use all available GPUs.");
+      return EXIT_FAILURE;
+    }
+
+    if(downscale < 1)
+    {
+      ALICEVISION_LOG_ERROR("Invalid value for downscale parameter. Should be at least 1.");
+      return EXIT_FAILURE;
+    }
+
+    const bfs::path outDirectory = bfs::path(outputMesh).parent_path();
+    const std::string depthMapFolder = (outDirectory / "depthMap").string();
+    const std::string depthMapFilterFolder = (outDirectory / "depthMapFilter").string();
+
+    // the small text files of the estimation (neighbour cameras, depths) are still written there
+    bfs::create_directories(depthMapFolder);
+    bfs::create_directories(depthMapFilterFolder);
+
+    imageIO::MemoryImages& memoryImages = imageIO::MemoryImages::get();
+    memoryImages.addFolder(depthMapFolder);
+    memoryImages.addFolder(depthMapFilterFolder);
+    memoryImages.setWriteFiles(writeDepthMaps);
+
+    // .ini and files parsing
+    // the cameras are read from the images, as the depth maps metadata don't exist yet
+    mvsUtils::MultiViewParams mp(iniFilepath, depthMapFolder, depthMapFilterFolder, false, downscale);
+    mvsUtils::PreMatchCams pc(&mp);
+
+    mp._ini.put("semiGlobalMatching.num_gpus_to_use", nbGPUs);
+    mp._ini.put("refineRc.num_gpus_to_use", nbGPUs);
+
+    StaticVector<int> cams;
+    cams.reserve(mp.ncams);
+    for(int rc = 0; rc < mp.ncams; rc++)
+        cams.push_back(rc);
+
+    // the depth maps are filtered as soon as they and the depth maps of their nearest cameras are estimated
+    ALICEVISION_LOG_INFO("Create and filter depth maps.");
+    {
+        std::exception_ptr estimationException;
+        std::thread estimationThread([&]()
+        {
+            try
+            {
+                depthMap::computeDepthMapsPSSGM(&mp, &pc, cams);
+                depthMap::refineDepthMaps(&mp, &pc, cams);
+            }
+            catch(...)
+            {
+                estimationException = std::current_exception();
+            }
+            // wake up the filtering of the missing depth maps
+            memoryImages.setWriting(false);
+        });
+
+        fuseCut::Fuser fs(&mp, &pc);
+        std::atomic<int> nextCam(0);
+        std::atomic<int> nbFilteredCams(0);
+        std::vector<std::exception_ptr> filteringExceptions(std::max(1, omp_get_max_threads()));
+        std::vector<std::thread> filteringThreads;
+
+        for(std::size_t t = 0; t < filteringExceptions.size(); ++t)
+        {
+            filteringThreads.emplace_back([&, t]()
+            {
+                try
+                {
+                    for(int c = nextCam++; c < cams.size(); c = nextCam++)
+                    {
+                        const int rc = cams[c];
+
+                        // the sim map is written after the depth map
+                        if(!memoryImages.waitImage(mvsUtils::mv_getFileName(&mp, rc, mvsUtils::EFileType::simMap, 1)))
+                        {
+                            ALICEVISION_LOG_WARNING("No depth map for camera " << mp.getViewId(rc) << ".");
+                            continue;
+                        }
+                        const StaticVector<int> tcams = pc.findNearestCamsFromSeeds(rc, nNearestCams);
+                        for(int tc : tcams)
+                            memoryImages.waitImage(mvsUtils::mv_getFileName(&mp, tc, mvsUtils::EFileType::simMap, 1));
+
+                        fs.filterGroupsRC(rc, pixSizeBall, pixSizeBallWithLowSimilarity, nNearestCams);
+                        fs.filterDepthMapsRC(rc, minNumOfConsistensCams, minNumOfConsistensCamsWithLowSimilarity);
+                        ++nbFilteredCams;
+                    }
+                }
+                catch(...)
+                {
+                    filteringExceptions[t] = std::current_exception();
+                }
+            });
+        }
+
+        estimationThread.join();
+        for(std::thread& thread : filteringThreads)
+            thread.join();
+
+        if(estimationException)
+            std::rethrow_exception(estimationException);
+        for(const std::exception_ptr& filteringException : filteringExceptions)
+        {
+            if(filteringException)
+                std::rethrow_exception(filteringException);
+        }
+
+        ALICEVISION_LOG_INFO(nbFilteredCams << " filtered depth maps (" << memoryImages.getSize() / (1024 * 1024) << " MB in memory).");
+    }
+
+    // only the filtered depth maps are used by the meshing
+    memoryImages.removeFolder(depthMapFolder);
+
+    ALICEVISION_LOG_INFO("Meshing.");
+    {
+        const int ocTreeDim = mp._ini.get<int>("LargeScale.gridLevel0", 1024);
+
+        fuseCut::DelaunayGraphCut delaunayGC(&mp, &pc);
+        std::array<Point3d, 8> hexah;
+
+        float minPixSize;
+        fuseCut::Fuser fs(&mp, &pc);
+        fs.divideSpace(&hexah[0], minPixSize);
+        Voxel dimensions = fs.estimateDimensions(&hexah[0], &hexah[0], 0, ocTreeDim);
+        StaticVector<Point3d>* voxels = mvsUtils::computeVoxels(&hexah[0], dimensions);
+
+        StaticVector<int> voxelNeighs;
+        voxelNeighs.resize(voxels->size() / 8);
+        for(int i = 0; i < voxelNeighs.size(); ++i)
+            voxelNeighs[i] = i;
+        Point3d spaceSteps;
+        {
+            Point3d vx = hexah[1] - hexah[0];
+            Point3d vy = hexah[3] - hexah[0];
+            Point3d vz = hexah[4] - hexah[0];
+            spaceSteps.x = (vx.size() / (double)dimensions.x) / (double)ocTreeDim;
+            spaceSteps.y = (vy.size() / (double)dimensions.y) / (double)ocTreeDim;
+            spaceSteps.z = (vz.size() / (double)dimensions.z) / (double)ocTreeDim;
+        }
+        delaunayGC.reconstructVoxel(&hexah[0], &voxelNeighs, outDirectory.string()+"/", outDirectory.string()+"/SpaceCamsTracks/", false,
+                                    nullptr, spaceSteps, fuseParams);
+
+        // the points are fused, free the filtered depth maps before the graph cut
+        memoryImages.removeFolder(depthMapFilterFolder);
+
+        delaunayGC.graphCutPostProcessing();
+
+        mesh::Mesh* mesh = delaunayGC.createMesh();
+        if(mesh->pts->empty() || mesh->tris->empty())
+            throw std::runtime_error("Empty mesh");
+
+        StaticVector<StaticVector<int>*>* ptsCams = delaunayGC.createPtsCams();
+        StaticVector<int> usedCams = delaunayGC.getSortedUsedCams();
+
+        StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = nullptr;
+        mesh::meshPostProcessing(mesh, ptsCams, usedCams, mp, pc, outDirectory.string()+"/", hexahsToExcludeFromResultingMesh, &hexah[0]);
+        mesh->saveToBin((outDirectory/"denseReconstruction.bin").string());
+
+        saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
+        deleteArrayOfArrays<int>(&ptsCams);
+        delete voxels;
+
+        mesh->save(outputMesh);
+
+        delete mesh;
+    }
+
+    telemetry.setNbItems(mp.ncams, "cameras");
+    telemetry.write();
+
+    ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,7 @@
 
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Telemetry.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
@@ -13,7 +14,10 @@
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/depthMap/RefineRc.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingRc.hpp>
+#include <aliceVision/depthMap/cuda/DeviceMemoryPool.hpp>
+#include <aliceVision/depthMap/cuda/DeviceProfiler.hpp>
 #include <aliceVision/system/gpu.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -21,7 +25,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 6
 
 using namespace aliceVision;
 
@@ -42,22 +46,36 @@ int main(int argc, char* argv[])
     // image downscale factor during process
     int downscale = 2;
 
+    // number of CUDA devices to use (0: all the detected devices)
+    int nbGPUs = 0;
+
     // semiGlobalMatching
     int sgmMaxTCams = 10;
     int sgmWSH = 4;
     double sgmGammaC = 5.5;
     double sgmGammaP = 8.0;
+    int sgmTileSize = 0;
+    int sgmTileMargin = 32;
+    bool sgmTileDepthsFromSeeds = false;
 
     // refineRc
     int refineNSamplesHalf = 150;
     int refineNDepthsToRefine = 31;
     int refineNiters = 100;
+    double refineConvergenceThreshold = 0.0;
     int refineWSH = 3;
     int refineMaxTCams = 6;
     double refineSigma = 15.0;
     double refineGammaC = 15.5;
     double refineGammaP = 8.0;
     bool refineUseTcOrRcPixSize = false;
+    bool refineUseHalfPrecision = false;
+    bool refineAdaptiveDepthBand = false;
+    int refineAdaptiveMinDepthsToRefine = 7;
+    std::string gpuProfilingReport;
+    bool gpuUseCudaGraphs = false;
+    std::size_t maxMemory = 0;
+    std::size_t maxGpuMemory = 0;
 
     po::options_description allParams("AliceVision depthMapEstimation\n"
                                       "Estimate depth map for each input image");
@@ -77,6 +95,8 @@ int main(int argc, char* argv[])
             "Compute a sub-range of N images (N=rangeSize).")
         ("downscale", po::value<int>(&downscale)->default_value(downscale),
             "Image downscale factor.")
+        ("nbGPUs", po::value<int>(&nbGPUs)->default_value(nbGPUs),
+            "Number of GPUs to use (0 means use all available GPUs).")
         ("sgmMaxTCams", po::value<int>(&sgmMaxTCams)->default_value(sgmMaxTCams),
             "Semi Global Matching: Number of neighbour cameras.")
         ("sgmWSH", po::value<int>(&sgmWSH)->default_value(sgmWSH),
@@ -85,12 +105,20 @@ int main(int argc, char* argv[])
             "Semi Global Matching: GammaC threshold.")
         ("sgmGammaP", po::value<double>(&sgmGammaP)->default_value(sgmGammaP),
             "Semi Global Matching: GammaP threshold.")
+        ("sgmTileSize", po::value<int>(&sgmTileSize)->default_value(sgmTileSize),
+            "Semi Global Matching: Process the volume per tiles of this size (0 means no tiling).")
+        ("sgmTileMargin", po::value<int>(&sgmTileMargin)->default_value(sgmTileMargin),
+            "Semi Global Matching: Overlap on each side of the tiles.")
+        ("sgmTileDepthsFromSeeds", po::value<bool>(&sgmTileDepthsFromSeeds)->default_value(sgmTileDepthsFromSeeds),
+            "Semi Global Matching: Sweep each tile only in the depth range of the sparse SfM points seen in it.")
         ("refineNSamplesHalf", po::value<int>(&refineNSamplesHalf)->default_value(refineNSamplesHalf),
             "Refine: Number of samples.")
         ("refineNDepthsToRefine", po::value<int>(&refineNDepthsToRefine)->default_value(refineNDepthsToRefine),
             "Refine: Number of depths.")
         ("refineNiters", po::value<int>(&refineNiters)->default_value(refineNiters),
             "Refine: Number of iterations.")
+        ("refineConvergenceThreshold", po::value<double>(&refineConvergenceThreshold)->default_value(refineConvergenceThreshold),
+            "Refine: Stop optimizing the blocks of pixels whose depths move less than this ratio of the pixel size (0 means always run all the iterations).")
         ("refineWSH", po::value<int>(&refineWSH)->default_value(refineWSH),
             "Refine: Size of the patch used to compute the similarity.")
         ("refineMaxTCams", po::value<int>(&refineMaxTCams)->default_value(refineMaxTCams),
@@ -102,7 +130,22 @@ int main(int argc, char* argv[])
         ("refineGammaP", po::value<double>(&refineGammaP)->default_value(refineGammaP),
             "Refine: GammaP threshold.")
         ("refineUseTcOrRcPixSize", po::value<bool>(&refineUseTcOrRcPixSize)->default_value(refineUseTcOrRcPixSize),
-            "Refine: Use current camera pixel size or minimum pixel size of neighbour cameras.");
+            "Refine: Use current camera pixel size or minimum pixel size of neighbour cameras.")
+        ("refineUseHalfPrecision", po::value<bool>(&refineUseHalfPrecision)->default_value(refineUseHalfPrecision),
+            "Refine: Fuse the depth maps of the neighbour cameras in half precision (faster on recent GPUs).")
+        ("refineAdaptiveDepthBand", po::value<bool>(&refineAdaptiveDepthBand)->default_value(refineAdaptiveDepthBand),
+            "Refine: Narrow the number of depths to refine around the pixels confidently resolved by the Semi Global Matching.")
+        ("refineAdaptiveMinDepthsToRefine", po::value<int>(&refineAdaptiveMinDepthsToRefine)->default_value(refineAdaptiveMinDepthsToRefine),
+            "Refine: Number of depths to refine around the most confident pixels (refineAdaptiveDepthBand).")
+        ("gpuProfilingReport", po::value<std::string>(&gpuProfilingReport)->default_value(gpuProfilingReport),
+            "Write the GPU time, transfers and device memory of each step per image in this file (.json or .csv).")
+        ("gpuUseCudaGraphs", po::value<bool>(&gpuUseCudaGraphs)->default_value(gpuUseCudaGraphs),
+            "Replay the per-slice kernel launches of the similarity volumes as CUDA graphs (CUDA 10.2 or later), "
+            "reduces the CPU launch overhead on fast GPUs.")
+        ("maxMemory", po::value<std::size_t>(&maxMemory)->default_value(maxMemory),
+            "Maximum RAM of the process in MB (0: ALICEVISION_MAX_MEMORY environment variable or memory limit of the job).")
+        ("maxGpuMemory", po::value<std::size_t>(&maxGpuMemory)->default_value(maxGpuMemory),
+            "Maximum memory used on each GPU in MB (0: ALICEVISION_MAX_GPU_MEMORY environment variable or free device memory).");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -144,6 +187,8 @@ int main(int argc, char* argv[])
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
 
+    system::StageTelemetry telemetry("depthMapEstimation");
+
     // print GPU Information
     ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
 
@@ -154,6 +199,12 @@ int main(int argc, char* argv[])
       return EXIT_FAILURE;
     }
 
+    if(nbGPUs < 0)
+    {
+      ALICEVISION_LOG_ERROR("Invalid value for nbGPUs parameter. Should be positive or 0 to use all available GPUs.");
+      return EXIT_FAILURE;
+    }
+
     // check if the scale is correct
     if(downscale < 1)
     {
@@ -167,21 +218,38 @@ int main(int argc, char* argv[])
     // set params in bpt
 
     // semiGlobalMatching
+    mp._ini.put("semiGlobalMatching.num_gpus_to_use", nbGPUs);
     mp._ini.put("semiGlobalMatching.maxTCams", sgmMaxTCams);
     mp._ini.put("semiGlobalMatching.wsh", sgmWSH);
     mp._ini.put("semiGlobalMatching.gammaC", sgmGammaC);
     mp._ini.put("semiGlobalMatching.gammaP", sgmGammaP);
+    mp._ini.put("semiGlobalMatching.tileSize", sgmTileSize);
+    mp._ini.put("semiGlobalMatching.tileMargin", sgmTileMargin);
+    mp._ini.put("semiGlobalMatching.tileDepthsFromSeeds", sgmTileDepthsFromSeeds);
 
     // refineRc
+    mp._ini.put("refineRc.num_gpus_to_use", nbGPUs);
     mp._ini.put("refineRc.nSamplesHalf", refineNSamplesHalf);
     mp._ini.put("refineRc.ndepthsToRefine", refineNDepthsToRefine);
     mp._ini.put("refineRc.niters", refineNiters);
+    mp._ini.put("refineRc.convergenceThreshold", refineConvergenceThreshold);
     mp._ini.put("refineRc.wsh", refineWSH);
     mp._ini.put("refineRc.maxTCams", refineMaxTCams);
     mp._ini.put("refineRc.sigma", refineSigma);
     mp._ini.put("refineRc.gammaC", refineGammaC);
     mp._ini.put("refineRc.gammaP", refineGammaP);
     mp._ini.put("refineRc.useTcOrRcPixSize", refineUseTcOrRcPixSize);
+    mp._ini.put("refineRc.useHalfPrecision", refineUseHalfPrecision);
+    mp._ini.put("refineRc.adaptiveDepthBand", refineAdaptiveDepthBand);
+    mp._ini.put("refineRc.adaptiveMinDepthsToRefine", refineAdaptiveMinDepthsToRefine);
+
+    mp._ini.put("global.useCudaGraphs", gpuUseCudaGraphs);
+
+    // memory budget of the process, used to size the images caches and the volumes
+    if(maxMemory > 0)
+        system::ResourceBudget::get().setMaxMemory(maxMemory * 1024 * 1024);
+    if(maxGpuMemory > 0)
+        system::ResourceBudget::get().setMaxGpuMemory(maxGpuMemory * 1024 * 1024);
 
     mvsUtils::PreMatchCams pc(&mp);
 
@@ -210,11 +278,23 @@ int main(int argc, char* argv[])
 
     ALICEVISION_LOG_INFO("Create depth maps.");
 
+    // the profiler also tracks the peak of used device memory for the telemetry
+    depthMap::DeviceProfiler::setEnabled(!gpuProfilingReport.empty() || telemetry.isEnabled());
+
     {
         depthMap::computeDepthMapsPSSGM(&mp, &pc, cams);
         depthMap::refineDepthMaps(&mp, &pc, cams);
     }
 
+    if(!gpuProfilingReport.empty())
+        depthMap::DeviceProfiler::writeReport(gpuProfilingReport);
+
+    depthMap::DeviceMemoryPool::logStatistics();
+
+    telemetry.setNbItems(cams.size(), "depthMaps");
+    telemetry.setGpuPeakMemory(static_cast<std::size_t>(depthMap::DeviceProfiler::getPeakUsedMemoryMB() * 1024.0 * 1024.0));
+    telemetry.write();
+
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
     return EXIT_SUCCESS;
 }
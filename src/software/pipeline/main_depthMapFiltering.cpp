@@ -4,6 +4,7 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
@@ -12,6 +13,10 @@
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/fuseCut/Fuser.hpp>
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/system/gpu.hpp>
+#include <aliceVision/depthMap/cuda/DepthMapFilteringCuda.hpp>
+#endif
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -42,6 +47,7 @@ int main(int argc, char* argv[])
     int pixSizeBall = 0;
     int pixSizeBallWithLowSimilarity = 0;
     int nNearestCams = 10;
+    bool useGPU = false;
 
     po::options_description allParams("AliceVision depthMapFiltering\n"
                                       "Filter depth map to remove values that are not consistent with other depth maps");
@@ -70,7 +76,9 @@ int main(int argc, char* argv[])
         ("pixSizeBallWithLowSimilarity", po::value<int>(&pixSizeBallWithLowSimilarity)->default_value(pixSizeBallWithLowSimilarity),
             "Filter ball size (in px) when the similarity is weak or ambiguous.")
         ("nNearestCams", po::value<int>(&nNearestCams)->default_value(nNearestCams),
-            "Number of nearest cameras.");
+            "Number of nearest cameras.")
+        ("useGPU", po::value<bool>(&useGPU)->default_value(useGPU),
+            "Compute the depth maps consistency on the GPU (if available).");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -143,6 +151,17 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Filter depth maps.");
 
     {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+        if(useGPU && system::gpuSupportCUDA(2,0))
+        {
+            // the nmodMap files are written here, the CPU filterGroups below skips them
+            depthMap::DepthMapFilteringCuda dfs(0, &mp, &pc, 2 * nNearestCams);
+            dfs.filterGroups(cams, pixSizeBall, pixSizeBallWithLowSimilarity, nNearestCams);
+        }
+#else
+        if(useGPU)
+            ALICEVISION_LOG_WARNING("AliceVision is built without CUDA, the depth maps consistency is computed on the CPU.");
+#endif
         fuseCut::Fuser fs(&mp, &pc);
         fs.filterGroups(cams, pixSizeBall, pixSizeBallWithLowSimilarity, nNearestCams);
         fs.filterDepthMaps(cams, minNumOfConsistensCams, minNumOfConsistensCamsWithLowSimilarity);
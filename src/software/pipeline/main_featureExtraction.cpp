@@ -8,15 +8,21 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/image/all.hpp>
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_NVJPEG)
+#include <aliceVision/image/cuda/JpegDecoderCUDA.hpp>
+#endif
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/feature.hpp>
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_POPSIFT) \
- || ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
+ || ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG) \
+ || ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
 #define ALICEVISION_HAVE_GPU_FEATURES
 #include <aliceVision/system/gpu.hpp>
 #endif
 #include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/ResourceBudget.hpp>
+#include <aliceVision/system/Telemetry.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
@@ -32,11 +38,18 @@
 #include <functional>
 #include <memory>
 #include <limits>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 
@@ -48,7 +61,8 @@ class FeatureExtractor
   struct ViewJob
   {
     const sfm::View& view;
-    std::size_t memoryConsuption = 0;
+    /// memory needed by the CPU image describers
+    std::size_t cpuMemoryConsuption = 0;
     std::string outputBasename;
     std::vector<std::size_t> cpuImageDescriberIndexes;
     std::vector<std::size_t> gpuImageDescriberIndexes;
@@ -90,16 +104,30 @@ class FeatureExtractor
            fs::exists(getDescriptorPath(imageDescriberType)))
           continue;
 
-        memoryConsuption += imageDescriber->getMemoryConsumption(view.getWidth(), view.getHeight());
-
         if(imageDescriber->useCuda())
+        {
           gpuImageDescriberIndexes.push_back(i);
+        }
         else
+        {
           cpuImageDescriberIndexes.push_back(i);
+          cpuMemoryConsuption += imageDescriber->getMemoryConsumption(view.getWidth(), view.getHeight());
+        }
       }
     }
   };
 
+  /**
+   * @brief The CPU or GPU part of a view job, with its decoded image.
+   * The image is shared by the CPU and GPU parts of a view, so it is decoded only once.
+   */
+  struct ViewTask
+  {
+    const ViewJob* job;
+    std::shared_ptr<image::Image<float>> imageGrayFloat;
+    bool useGPU;
+  };
+
 public:
 
   explicit FeatureExtractor(const sfm::SfMData& sfmData)
@@ -122,6 +150,11 @@ public:
     _outputFolder = folder;
   }
 
+  void setGpuImageDecoding(bool gpuImageDecoding)
+  {
+    _gpuImageDecoding = gpuImageDecoding;
+  }
+
   void addImageDescriber(std::shared_ptr<feature::ImageDescriber>& imageDescriber)
   {
     _imageDescribers.push_back(imageDescriber);
@@ -142,6 +175,8 @@ public:
     }
 
     std::size_t jobMaxMemoryConsuption = 0;
+    std::size_t nbCpuJobs = 0;
+    std::size_t nbGpuJobs = 0;
 
     for(auto it = itViewBegin; it != itViewEnd; ++it)
     {
@@ -149,16 +184,24 @@ public:
       ViewJob viewJob(view, _outputFolder);
 
       viewJob.setImageDescribers(_imageDescribers);
-      jobMaxMemoryConsuption = std::max(jobMaxMemoryConsuption, viewJob.memoryConsuption);
+      jobMaxMemoryConsuption = std::max(jobMaxMemoryConsuption, viewJob.cpuMemoryConsuption);
 
       if(viewJob.useCPU())
-        _cpuJobs.push_back(viewJob);
+        ++nbCpuJobs;
 
       if(viewJob.useGPU())
-        _gpuJobs.push_back(viewJob);
+        ++nbGpuJobs;
+
+      if(viewJob.useCPU() || viewJob.useGPU())
+        _jobs.push_back(viewJob);
     }
 
-    if(!_cpuJobs.empty())
+    if(_jobs.empty())
+      return;
+
+    std::size_t nbCpuThreads = 0;
+
+    if(nbCpuJobs > 0)
     {
       system::MemoryInfo memoryInformation = system::getMemoryInfo();
 
@@ -168,50 +211,222 @@ public:
       if(jobMaxMemoryConsuption == 0)
         throw std::runtime_error("Cannot compute feature extraction job max memory consumption.");
 
-      std::size_t nbThreads =  (0.9 * memoryInformation.freeRam) / jobMaxMemoryConsuption;
-
       if(memoryInformation.freeRam == 0)
       {
         ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
                                 "Use only one thread for CPU feature extraction.");
-        nbThreads = 1;
+        nbCpuThreads = 1;
+      }
+      else
+      {
+        // the number of concurrent CPU jobs is limited by the memory admission control,
+        // the thread number is only limited by the user, the thread budget of the process and the jobs
+        nbCpuThreads = system::ResourceBudget::get().getNbThreads(_maxThreads);
+      }
+
+      // nbThreads should not be higher than the job number
+      nbCpuThreads = std::min(nbCpuJobs, nbCpuThreads);
+    }
+
+    // the GPU workers share the GPU image describers,
+    // up to the number of images they can describe at the same time
+    std::size_t nbGpuThreads = 0;
+    if(nbGpuJobs > 0)
+    {
+      nbGpuThreads = nbGpuJobs;
+      for(const auto& imageDescriber : _imageDescribers)
+      {
+        if(imageDescriber->useCuda())
+          nbGpuThreads = std::min(nbGpuThreads, imageDescriber->getMaxConcurrentDescriptions());
       }
+    }
 
-      // nbThreads should not be higher than user maxThreads param
-      if(_maxThreads > 0)
-        nbThreads = std::min(static_cast<std::size_t>(_maxThreads), nbThreads);
+    ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbCpuThreads << " cpu, " << nbGpuThreads << " gpu");
 
-      // nbThreads should not be higher than the core number
-      nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+    // the decoded images wait at most one per worker in the queue
+    _maxQueuedCpuTasks = nbCpuThreads + 1;
+    _maxQueuedGpuTasks = nbGpuThreads + 1;
 
-      // nbThreads should not be higher than the job number
-      nbThreads = std::min(_cpuJobs.size(), nbThreads);
+    std::vector<std::thread> threads;
+    threads.emplace_back(&FeatureExtractor::decodeImages, this);
+    for(std::size_t i = 0; i < nbCpuThreads; ++i)
+      threads.emplace_back(&FeatureExtractor::runWorker, this, false);
+    for(std::size_t i = 0; i < nbGpuThreads; ++i)
+      threads.emplace_back(&FeatureExtractor::runWorker, this, true);
+
+    for(std::thread& thread : threads)
+      thread.join();
+
+    if(_exception)
+      std::rethrow_exception(_exception);
+  }
+
+private:
 
-      ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbThreads);
-      omp_set_nested(1);
+  /**
+   * @brief Decode the images ahead of the workers, in the job order.
+   * The decoding waits while the queue of the worker type needed by the next view is full.
+   * The JPEG images of the views extracted on the GPU are decoded on the GPU if enabled,
+   * the other images and the ones nvJPEG can't decode are read on the CPU.
+   */
+  void decodeImages()
+  {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_NVJPEG)
+    std::unique_ptr<image::JpegDecoderCUDA> jpegDecoder;
+    if(_gpuImageDecoding && std::any_of(_jobs.begin(), _jobs.end(), [](const ViewJob& job) { return job.useGPU(); }))
+      jpegDecoder.reset(new image::JpegDecoderCUDA());
+#endif
+
+    for(const ViewJob& job : _jobs)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _taskDone.wait(lock, [&]{
+          return _stopped ||
+                 ((!job.useCPU() || _nbQueuedCpuTasks < _maxQueuedCpuTasks) &&
+                  (!job.useGPU() || _nbQueuedGpuTasks < _maxQueuedGpuTasks));
+        });
+        if(_stopped)
+          break;
+      }
 
-#pragma omp parallel for num_threads(nbThreads)
-      for(int i = 0; i < _cpuJobs.size(); ++i)
-        computeViewJob(_cpuJobs.at(i));
+      std::shared_ptr<image::Image<float>> imageGrayFloat = std::make_shared<image::Image<float>>();
+      try
+      {
+        bool decoded = false;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_NVJPEG)
+        if(jpegDecoder && job.useGPU() && image::JpegDecoderCUDA::isJpegFile(job.view.getImagePath()))
+          decoded = jpegDecoder->decodeGray(job.view.getImagePath(), *imageGrayFloat);
+#endif
+        if(!decoded)
+          image::readImage(job.view.getImagePath(), *imageGrayFloat);
+      }
+      catch(...)
+      {
+        stop(std::current_exception());
+        break;
+      }
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(job.useGPU())
+      {
+        _tasks.push_back(ViewTask{&job, imageGrayFloat, true});
+        ++_nbQueuedGpuTasks;
+      }
+      if(job.useCPU())
+      {
+        _tasks.push_back(ViewTask{&job, imageGrayFloat, false});
+        ++_nbQueuedCpuTasks;
+      }
+      _taskQueued.notify_all();
     }
 
-    if(!_gpuJobs.empty())
+    std::lock_guard<std::mutex> lock(_mutex);
+    _decodingDone = true;
+    _taskQueued.notify_all();
+  }
+
+  /**
+   * @brief Check if a CPU view task can start without exceeding the available memory of the process budget.
+   * The available memory is read live, as it is consumed by the running jobs and the other processes.
+   * A task is always admitted when no other CPU task is running, to ensure the progression.
+   */
+  bool isAdmitted(const ViewTask& task) const
+  {
+    if(task.useGPU || _nbRunningCpuTasks == 0)
+      return true;
+
+    // the memory of the running tasks is reserved in the budget but may not be allocated yet,
+    // no available memory if the system memory is unknown: the CPU tasks are serialized
+    const std::size_t availableMemory = 0.9 * system::ResourceBudget::get().getAvailableMemory();
+    return task.job->cpuMemoryConsuption <= availableMemory;
+  }
+
+  /**
+   * @brief Extract the CPU or the GPU image describers of the queued views.
+   * @param[in] useGPU The type of the worker
+   */
+  void runWorker(bool useGPU)
+  {
+    while(true)
     {
-      for(const auto& job : _gpuJobs)
-        computeViewJob(job, true);
+      ViewTask task;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::deque<ViewTask>::iterator itTask;
+        while(true)
+        {
+          if(_stopped)
+            return;
+
+          itTask = std::find_if(_tasks.begin(), _tasks.end(), [&](const ViewTask& t) { return t.useGPU == useGPU; });
+
+          if(itTask != _tasks.end() && isAdmitted(*itTask))
+            break;
+
+          if(itTask == _tasks.end() && _decodingDone)
+            return;
+
+          // the free memory is checked again after a while, even if no task is done
+          _taskQueued.wait_for(lock, std::chrono::milliseconds(200));
+        }
+
+        task = *itTask;
+        _tasks.erase(itTask);
+
+        if(useGPU)
+        {
+          --_nbQueuedGpuTasks;
+        }
+        else
+        {
+          --_nbQueuedCpuTasks;
+          ++_nbRunningCpuTasks;
+          system::ResourceBudget::get().reserveMemory(task.job->cpuMemoryConsuption, true);
+        }
+        _taskDone.notify_all();
+      }
+
+      try
+      {
+        computeViewJob(*task.job, *task.imageGrayFloat, useGPU);
+      }
+      catch(...)
+      {
+        stop(std::current_exception());
+        return;
+      }
+      task.imageGrayFloat.reset();
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(!useGPU)
+      {
+        --_nbRunningCpuTasks;
+        system::ResourceBudget::get().releaseMemory(task.job->cpuMemoryConsuption);
+      }
+      _taskQueued.notify_all(); // memory released, the waiting workers can check their admission again
     }
   }
 
-private:
+  /**
+   * @brief Stop the decoding and the workers on the first error.
+   * @param[in] exception The error rethrown by process()
+   */
+  void stop(std::exception_ptr exception)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!_exception)
+      _exception = exception;
+    _stopped = true;
+    _taskQueued.notify_all();
+    _taskDone.notify_all();
+  }
 
-  void computeViewJob(const ViewJob& job, bool useGPU = false)
+  void computeViewJob(const ViewJob& job, const image::Image<float>& imageGrayFloat, bool useGPU = false) const
   {
-    image::Image<float> imageGrayFloat;
     image::Image<unsigned char> imageGrayUChar;
 
-    image::readImage(job.view.getImagePath(), imageGrayFloat);
-
-    const auto imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
+    const auto& imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
 
     for(auto& imageDescriberIndex : imageDescriberIndexes)
     {
@@ -246,8 +461,24 @@ private:
   int _rangeStart = -1;
   int _rangeSize = -1;
   int _maxThreads = -1;
-  std::vector<ViewJob> _cpuJobs;
-  std::vector<ViewJob> _gpuJobs;
+  bool _gpuImageDecoding = true;
+  std::vector<ViewJob> _jobs;
+
+  // scheduler state, protected by _mutex
+  std::mutex _mutex;
+  /// notified when a task is queued, when the decoding is done and when memory is released
+  std::condition_variable _taskQueued;
+  /// notified when a task is taken by a worker
+  std::condition_variable _taskDone;
+  std::deque<ViewTask> _tasks;
+  std::size_t _nbQueuedCpuTasks = 0;
+  std::size_t _nbQueuedGpuTasks = 0;
+  std::size_t _maxQueuedCpuTasks = 1;
+  std::size_t _maxQueuedGpuTasks = 1;
+  std::size_t _nbRunningCpuTasks = 0;
+  bool _decodingDone = false;
+  bool _stopped = false;
+  std::exception_ptr _exception;
 };
 
 
@@ -268,7 +499,9 @@ int main(int argc, char **argv)
   int rangeStart = -1;
   int rangeSize = 1;
   int maxThreads = 0;
+  std::size_t maxMemory = 0;
   bool forceCpuExtraction = false;
+  bool gpuImageDecoding = true;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -288,12 +521,16 @@ int main(int argc, char **argv)
       "Configuration 'ultra' can take long time !")
     ("forceCpuExtraction", po::value<bool>(&forceCpuExtraction)->default_value(forceCpuExtraction),
       "Use only CPU feature extraction methods.")
+    ("gpuImageDecoding", po::value<bool>(&gpuImageDecoding)->default_value(gpuImageDecoding),
+      "Decode the JPEG images of the GPU feature extraction on the GPU (if built with nvJPEG).")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
-      "Specifies the maximum number of threads to run simultaneously (0 for automatic mode).");
+      "Specifies the maximum number of threads to run simultaneously (0 for automatic mode).")
+    ("maxMemory", po::value<std::size_t>(&maxMemory)->default_value(maxMemory),
+      "Maximum RAM of the process in MB (0: ALICEVISION_MAX_MEMORY environment variable or memory limit of the job).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -333,6 +570,8 @@ int main(int argc, char **argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  system::StageTelemetry telemetry("featureExtraction");
+
   if(describerTypesName.empty())
   {
     ALICEVISION_LOG_ERROR("--describerTypes option is empty.");
@@ -369,6 +608,12 @@ int main(int argc, char **argv)
   // set maxThreads
   extractor.setMaxThreads(maxThreads);
 
+  extractor.setGpuImageDecoding(gpuImageDecoding && !forceCpuExtraction);
+
+  // set the memory budget of the process
+  if(maxMemory > 0)
+    system::ResourceBudget::get().setMaxMemory(maxMemory * 1024 * 1024);
+
   // set extraction range
   if(rangeStart != -1)
   {
@@ -411,5 +656,9 @@ int main(int argc, char **argv)
 
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
   }
+
+  telemetry.setNbItems((rangeStart == -1) ? sfmData.getViews().size() : rangeSize, "images");
+  telemetry.write();
+
   return EXIT_SUCCESS;
 }
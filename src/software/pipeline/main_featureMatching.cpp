@@ -13,6 +13,7 @@
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/DescriptorPCA.hpp>
 #include <aliceVision/matchingImageCollection/matchingCommon.hpp>
 #include <aliceVision/matchingImageCollection/ImageCollectionMatcher_generic.hpp>
 #include <aliceVision/matchingImageCollection/ImageCollectionMatcher_cascadeHashing.hpp>
@@ -24,6 +25,9 @@
 #include <aliceVision/matchingImageCollection/GeometricFilterType.hpp>
 #include <aliceVision/matching/pairwiseAdjacencyDisplay.hpp>
 #include <aliceVision/matching/io.hpp>
+#include <aliceVision/matching/metricSimd.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
+#include <aliceVision/system/Telemetry.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/feature/selection.hpp>
@@ -40,7 +44,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 8
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -101,6 +105,8 @@ int main(int argc, char **argv)
   std::string predefinedPairList;
   int rangeStart = -1;
   int rangeSize = 0;
+  bool shardOutput = false;
+  bool mergeShards = false;
   std::string nearestMatchingMethod = "ANN_L2";
   std::string geometricEstimatorName = robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC);
   double geometricErrorMax = 0.0; //< the maximum reprojection error allowed for image matching with geometric validation
@@ -111,7 +117,11 @@ int main(int argc, char **argv)
   size_t numMatchesToKeep = 0;
   bool useGridSort = true;
   bool exportDebugFiles = false;
-  const std::string fileExtension = "txt";
+  std::string fileExtension = "txt";
+  std::string cascadeHashingFolder;
+  std::string descriptorPCAFilename;
+  std::vector<IndexT> newViewIds;
+  std::vector<std::string> previousMatchesFolders;
 
   po::options_description allParams(
      "Compute corresponding features between a series of views:\n"
@@ -141,12 +151,17 @@ int main(int argc, char **argv)
     ("photometricMatchingMethod,p", po::value<std::string>(&nearestMatchingMethod)->default_value(nearestMatchingMethod),
       "For Scalar based regions descriptor:\n"
       "* BRUTE_FORCE_L2: L2 BruteForce matching\n"
+      "* BLOCKED_BRUTE_FORCE_L2: L2 BruteForce matching computed by blocks of descriptors\n"
+      "(same matches as BRUTE_FORCE_L2, faster on large sets of features)\n"
       "* ANN_L2: L2 Approximate Nearest Neighbor matching\n"
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
       "(faster than CASCADE_HASHING_L2 but use more memory)\n"
+      "* CUDA_BRUTE_FORCE_L2: L2 BruteForce matching on GPU (CUDA builds only)\n"
+      "* HNSW_L2: L2 Approximate Nearest Neighbor matching on a navigable small world graph\n"
       "For Binary based descriptor:\n"
-      "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching")
+      "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching\n"
+      "* HNSW_HAMMING: Hamming Approximate Nearest Neighbor matching on a navigable small world graph")
     ("geometricEstimator", po::value<std::string>(&geometricEstimatorName)->default_value(geometricEstimatorName),
       "Geometric estimator:\n"
       "* acransac: A-Contrario Ransac\n"
@@ -160,6 +175,15 @@ int main(int argc, char **argv)
       "Use the found model to improve the pairwise correspondences.")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("matchesFileFormat", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Matches file format:\n"
+      "* txt: text file, one line per match\n"
+      "* bin: binary file with an image pair index table (faster to load)")
+    ("cascadeHashingFolder", po::value<std::string>(&cascadeHashingFolder)->default_value(cascadeHashingFolder),
+      "Folder to save and reuse the hashed descriptors of FAST_CASCADE_HASHING_L2 between runs (disabled if empty).")
+    ("descriptorPCA", po::value<std::string>(&descriptorPCAFilename)->default_value(descriptorPCAFilename),
+      "PCA basis (see aliceVision_utils_descriptorPCA) used to reduce the descriptors to 64 dimensions on 8 bits as soon as they are loaded, "
+      "to match more images in the same memory (disabled if empty).")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
@@ -173,7 +197,17 @@ int main(int argc, char **argv)
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
-      "Range size.");
+      "Range size.")
+    ("shardOutput", po::value<bool>(&shardOutput)->default_value(shardOutput),
+      "Save the matches of the range in a binary shard of the output folder, read as is by the SfM or merged with --mergeShards. "
+      "A range whose shard already exists is skipped, so an interrupted chunked matching can be resumed.")
+    ("mergeShards", po::value<bool>(&mergeShards)->default_value(mergeShards),
+      "Merge the binary shards of the output folder in a single binary matches file, without matching.")
+    ("newViewIds", po::value<std::vector<IndexT>>(&newViewIds)->multitoken(),
+      "Incremental matching: only match the pairs involving these new views.")
+    ("previousMatchesFolders", po::value<std::vector<std::string>>(&previousMatchesFolders)->multitoken(),
+      "Incremental matching: folder(s) of the existing geometric matches, "
+      "merged with the matches of the new views in the output.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -217,6 +251,8 @@ int main(int argc, char **argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  system::StageTelemetry telemetry("featureMatching");
+
   // check and set input options
   if(matchesFolder.empty() || !fs::is_directory(matchesFolder))
   {
@@ -224,6 +260,68 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(fileExtension != "txt" && fileExtension != "bin")
+  {
+    ALICEVISION_LOG_ERROR("Invalid matches file format: " << fileExtension);
+    return EXIT_FAILURE;
+  }
+
+  if(mergeShards)
+  {
+    const std::vector<std::string> shardFiles = getMatchesShardFiles(matchesFolder);
+    if(shardFiles.empty())
+    {
+      ALICEVISION_LOG_ERROR("No matches shard to merge in: " << matchesFolder);
+      return EXIT_FAILURE;
+    }
+
+    ALICEVISION_LOG_INFO("Merge " << shardFiles.size() << " matches shards.");
+    try
+    {
+      mergeBinaryMatchFiles(shardFiles, (fs::path(matchesFolder) / "matches.bin").string());
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR(e.what());
+      return EXIT_FAILURE;
+    }
+
+    // the merged file is loaded instead of the shards
+    for(const std::string& shardFile : shardFiles)
+      fs::remove(shardFile);
+    return EXIT_SUCCESS;
+  }
+
+  // base name of the output match files
+  std::string matchesBasename = "matches";
+
+  if(shardOutput)
+  {
+    if(rangeStart < 0)
+    {
+      ALICEVISION_LOG_ERROR("Matches shards need a range (--rangeStart).");
+      return EXIT_FAILURE;
+    }
+
+    // shards are binary global files
+    fileExtension = "bin";
+    matchFilePerImage = false;
+    matchesBasename = getMatchesShardBasename(rangeStart);
+
+    // a shard is renamed when fully written, an existing shard is complete
+    if(fs::exists(fs::path(matchesFolder) / (matchesBasename + ".bin")))
+    {
+      ALICEVISION_LOG_INFO("Matches shard of the range " << rangeStart << " already computed, skipped.");
+      return EXIT_SUCCESS;
+    }
+  }
+
+  if(!cascadeHashingFolder.empty() && !fs::exists(cascadeHashingFolder) && !fs::create_directory(cascadeHashingFolder))
+  {
+    ALICEVISION_LOG_ERROR("Can't create the cascade hashing folder: " << cascadeHashingFolder);
+    return EXIT_FAILURE;
+  }
+
   const matchingImageCollection::EGeometricFilterType geometricFilterType = matchingImageCollection::EGeometricFilterType_stringToEnum(geometricFilterTypeName);
 
   if(describerTypesName.empty())
@@ -273,6 +371,23 @@ int main(int argc, char **argv)
     return rangeSize ? EXIT_SUCCESS : EXIT_FAILURE;
   }
 
+  // incremental matching: new x (old + new) pairs only
+  if(!newViewIds.empty())
+  {
+    const std::set<IndexT> newViews(newViewIds.begin(), newViewIds.end());
+    pairs = filterPairsWithViews(pairs, newViews);
+    ALICEVISION_LOG_INFO("Incremental matching of " << newViews.size() << " new views.");
+
+    if(previousMatchesFolders.empty())
+      ALICEVISION_LOG_WARNING("No previous matches folder, only the matches of the new views will be saved.");
+
+    if(pairs.empty())
+    {
+      ALICEVISION_LOG_INFO("No image pair involving the new views.");
+      return EXIT_FAILURE;
+    }
+  }
+
   ALICEVISION_LOG_INFO("Number of pairs: " << pairs.size());
 
   // filter creation
@@ -283,20 +398,37 @@ int main(int argc, char **argv)
   }
 
   ALICEVISION_LOG_INFO("Putative matches");
+  ALICEVISION_LOG_INFO("Distance kernels instruction set: " << matching::simd::ESimdLevel_enumToString(matching::simd::getSimdLevel()));
 
   PairwiseMatches mapPutativesMatches;
 
   // allocate the right Matcher according the Matching requested method
   EMatcherType collectionMatcherType = EMatcherType_stringToEnum(nearestMatchingMethod);
-  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio);
+  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio, cascadeHashingFolder);
 
   const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
 
   ALICEVISION_LOG_INFO("There are " + std::to_string(sfmData.getViews().size()) + " views and " + std::to_string(pairs.size()) + " image pairs.");
 
+  feature::DescriptorPCA descriptorPCA;
+  if(!descriptorPCAFilename.empty())
+  {
+    try
+    {
+      descriptorPCA.load(descriptorPCAFilename);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR(e.what());
+      return EXIT_FAILURE;
+    }
+    ALICEVISION_LOG_INFO("Descriptors reduced from " << descriptorPCA.descriptorLength() << " to " << feature::DescriptorPCA::reducedLength
+                         << " dimensions (explained variance: " << descriptorPCA.getExplainedVariance() << ").");
+  }
+
   // load the corresponding view regions
   RegionsPerView regionPerView;
-  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter))
+  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter, 3, &descriptorPCA))
   {
     ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
     return EXIT_FAILURE;
@@ -317,6 +449,9 @@ int main(int argc, char **argv)
     // if(!guided_matching) regionPerView.clearDescriptors()
   }
 
+  system::MemoryCounter putativeMatchesMemory("matching.putativeMatches");
+  putativeMatchesMemory.set(matching::getMemorySize(mapPutativesMatches));
+
   if(mapPutativesMatches.empty())
   {
     ALICEVISION_LOG_INFO("No putative matches.");
@@ -346,7 +481,7 @@ int main(int argc, char **argv)
 
   // export putative matches
   if(savePutativeMatches)
-    Save(mapPutativesMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage);
+    Save(mapPutativesMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage, matchesBasename);
 
   ALICEVISION_LOG_INFO("Task (Regions Matching) done in (s): " + std::to_string(timer.elapsed()));
 
@@ -388,6 +523,8 @@ int main(int argc, char **argv)
   timer.reset();
 
   matching::PairwiseMatches geometricMatches;
+  // models of the geometric filtering, saved for the SfM
+  matching::PairGeometricModels geometricModels;
 
   ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
 
@@ -405,7 +542,9 @@ int main(int argc, char **argv)
         regionPerView,
         GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
         mapPutativesMatches,
-        guidedMatching);
+        guidedMatching,
+        0.6,
+        &geometricModels);
     }
     break;
 
@@ -416,7 +555,9 @@ int main(int argc, char **argv)
         regionPerView,
         GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration),
         mapPutativesMatches,
-        guidedMatching);
+        guidedMatching,
+        0.6,
+        &geometricModels);
 
       // perform an additional check to remove pairs with poor overlap
       std::vector<PairwiseMatches::key_type> toRemoveVec;
@@ -445,7 +586,8 @@ int main(int argc, char **argv)
         regionPerView,
         GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration),
         mapPutativesMatches, guidedMatching,
-        onlyGuidedMatching ? -1.0 : 0.6);
+        onlyGuidedMatching ? -1.0 : 0.6,
+        &geometricModels);
     }
     break;
 
@@ -461,6 +603,9 @@ int main(int argc, char **argv)
     break;
   }
 
+  system::MemoryCounter geometricMatchesMemory("matching.geometricMatches");
+  geometricMatchesMemory.set(matching::getMemorySize(geometricMatches));
+
   ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
   for(const auto& matchGeo: geometricMatches)
     ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
@@ -519,9 +664,55 @@ int main(int argc, char **argv)
       ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
   }
 
+  // incremental matching: keep the previous matches of the pairs that were not recomputed
+  if(!previousMatchesFolders.empty())
+  {
+    std::set<IndexT> viewIds;
+    for(const auto& view : sfmData.getViews())
+      viewIds.insert(view.first);
+
+    PairwiseMatches previousMatches;
+    if(!Load(previousMatches, viewIds, previousMatchesFolders, describerTypes))
+    {
+      ALICEVISION_LOG_ERROR("Can't load the previous matches.");
+      return EXIT_FAILURE;
+    }
+
+    matching::PairGeometricModels previousGeometricModels;
+    loadGeometricModels(previousGeometricModels, previousMatchesFolders);
+
+    std::size_t nbPreviousPairs = 0;
+    for(auto& previousPairMatches : previousMatches)
+    {
+      if(pairs.count(previousPairMatches.first))
+        continue; // recomputed
+      finalMatches[previousPairMatches.first] = std::move(previousPairMatches.second);
+      ++nbPreviousPairs;
+
+      const auto previousModelIt = previousGeometricModels.find(previousPairMatches.first);
+      if(previousModelIt != previousGeometricModels.end())
+        geometricModels[previousModelIt->first] = previousModelIt->second;
+    }
+    ALICEVISION_LOG_INFO(nbPreviousPairs << " image pairs reused from the previous matches.");
+  }
+
+  system::MemoryCounter finalMatchesMemory("matching.finalMatches");
+  finalMatchesMemory.set(matching::getMemorySize(finalMatches));
+
   // export geometric filtered matches
   ALICEVISION_LOG_INFO("Save geometric matches.");
-  Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage);
+  Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage, matchesBasename);
+
+  // keep the models of the saved pairs only
+  for(auto modelIt = geometricModels.begin(); modelIt != geometricModels.end();)
+  {
+    if(finalMatches.count(modelIt->first))
+      ++modelIt;
+    else
+      modelIt = geometricModels.erase(modelIt);
+  }
+  if(!geometricModels.empty() && !saveGeometricModels(geometricModels, matchesFolder, matchesBasename))
+    ALICEVISION_LOG_WARNING("Can't save the geometric models of the image pairs.");
   ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
 
   // d. Export some statistics
@@ -553,5 +744,8 @@ int main(int argc, char **argv)
   }
 #endif
 
+  telemetry.setNbItems(pairs.size(), "pairs");
+  telemetry.write();
+
   return EXIT_SUCCESS;
 }
@@ -47,6 +47,7 @@ int main(int argc, char **argv)
   int rotationAveragingMethod = static_cast<int>(ROTATION_AVERAGING_L2);
   int translationAveragingMethod = static_cast<int>(TRANSLATION_AVERAGING_SOFTL1);
   bool refineIntrinsics = true;
+  bool pairPreselection = false;
 
   po::options_description allParams("Implementation of the paper\n"
     "\"Global Fusion of Relative Motions for "
@@ -76,7 +77,12 @@ int main(int argc, char **argv)
       "* 2: L2 minimization")
     ("translationAveraging", po::value<int>(&translationAveragingMethod)->default_value(translationAveragingMethod),
       "* 1: L1 minimization\n"
-      "* 2: L2 minimization of sum of squared Chordal distances")
+      "* 2: L2 minimization of sum of squared Chordal distances\n"
+      "* 3: SoftL1 minimization\n"
+      "* 4: 1DSfM outlier filtering and IRLS on a sparse linear system (no LP solver)")
+    ("pairPreselection", po::value<bool>(&pairPreselection)->default_value(pairPreselection),
+      "Estimate the relative poses only on a maximum spanning subgraph of the pose graph (with redundancy edges), "
+      "the other pairs are estimated only for the poses badly constrained by the rotation averaging.")
     ("refineIntrinsics", po::value<bool>(&refineIntrinsics)->default_value(refineIntrinsics),
       "Refine intrinsic parameters.");
 
@@ -126,7 +132,7 @@ int main(int argc, char **argv)
   }
 
   if (translationAveragingMethod < TRANSLATION_AVERAGING_L1 ||
-      translationAveragingMethod > TRANSLATION_AVERAGING_SOFTL1 )
+      translationAveragingMethod > TRANSLATION_AVERAGING_IRLS )
   {
     ALICEVISION_LOG_ERROR("Translation averaging method is invalid");
     return EXIT_FAILURE;
@@ -172,6 +178,10 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  // models of the matching geometric filtering, to avoid estimating them again
+  matching::PairGeometricModels geometricModels;
+  sfm::loadPairGeometricModels(geometricModels, sfmData, matchesFolders);
+
   if (outDirectory.empty())
   {
     ALICEVISION_LOG_ERROR("It is an invalid output folder");
@@ -191,6 +201,7 @@ int main(int argc, char **argv)
   // configure the featuresPerView & the matches_provider
   sfmEngine.SetFeaturesProvider(&featuresPerView);
   sfmEngine.SetMatchesProvider(&pairwiseMatches);
+  sfmEngine.SetGeometricModelsProvider(&geometricModels);
 
   // configure reconstruction parameters
   sfmEngine.setFixedIntrinsics(!refineIntrinsics);
@@ -198,6 +209,7 @@ int main(int argc, char **argv)
   // configure motion averaging method
   sfmEngine.SetRotationAveragingMethod(ERotationAveragingMethod(rotationAveragingMethod));
   sfmEngine.SetTranslationAveragingMethod(ETranslationAveragingMethod(translationAveragingMethod));
+  sfmEngine.SetPairPreselection(pairPreselection);
 
   if(!sfmEngine.process())
     return EXIT_FAILURE;
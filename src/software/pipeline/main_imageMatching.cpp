@@ -21,12 +21,14 @@
 #include <ostream>
 #include <string>
 #include <set>
+#include <sstream>
 #include <chrono>
+#include <cstdint>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 static const int DIMENSION = 128;
 
@@ -38,6 +40,8 @@ namespace fs = boost::filesystem;
 
 typedef aliceVision::feature::Descriptor<float, DIMENSION> DescriptorFloat;
 typedef aliceVision::feature::Descriptor<unsigned char, DIMENSION> DescriptorUChar;
+/// AKAZE_MLDB binary descriptors (486 bits in 64 bytes)
+typedef aliceVision::feature::Descriptor<unsigned char, 64> DescriptorBinary;
 
 typedef std::size_t ImageID;
 
@@ -95,6 +99,33 @@ std::ostream& operator<<(std::ostream& os, const OrderedPairList & pl)
   return os;
 }
 
+/**
+ * @brief Read a pair list file written with operator<<(std::ostream&, const OrderedPairList&)
+ * @param[in] filepath The pair list file
+ * @param[out] pl The pair list
+ * @return false if the file can't be read
+ */
+bool loadPairList(const std::string& filepath, OrderedPairList& pl)
+{
+  std::ifstream file(filepath);
+  if(!file.is_open())
+    return false;
+
+  std::string line;
+  while(std::getline(file, line))
+  {
+    std::istringstream lineStream(line);
+    ImageID imageId;
+    if(!(lineStream >> imageId))
+      continue;
+    OrderedListOfImageID& matches = pl[imageId];
+    ImageID matchId;
+    while(lineStream >> matchId)
+      matches.insert(matchId);
+  }
+  return true;
+}
+
 /**
  * @brief Mode to combine image matching between two SfMDatas
  */
@@ -208,12 +239,15 @@ void convertAllMatchesToPairList(const PairList &allMatches, const std::size_t n
 
       // if the currMatchId ID is lower than the current image ID and
       // the current image ID is not already in the list of currMatchId
+      // (or currMatchId is not a query image: image of the other SfMData or previous image)
       //BOOST_ASSERT( ( currMatchId < currImageId ) && ( outPairList.find( currMatchId ) != outPairList.end() ) );
       if(currMatchId < currImageId)
       {
         OrderedPairList::const_iterator currMatches = outPairList.find(currMatchId);
-        if(currMatches != outPairList.end() &&
-                currMatches->second.find(currImageId) == currMatches->second.end())
+        const bool isQueryImage = (allMatches.find(currMatchId) != allMatches.end());
+        if((currMatches != outPairList.end() &&
+                currMatches->second.find(currImageId) == currMatches->second.end()) ||
+           (currMatches == outPairList.end() && !isQueryImage))
         {
           // then add it to the list
           bestMatches.insert(currMatchId);
@@ -287,13 +321,15 @@ void generateAllMatchesBetweenTwoMap(const std::map<IndexT, std::string>& descri
 }
 
 
+template<class FileDescriptorT, class VocabularyTreeT>
 void generateFromVoctree(PairList& allMatches,
                          const std::map<IndexT, std::string>& descriptorsFiles,
                          const aliceVision::voctree::Database& db,
-                         const aliceVision::voctree::VocabularyTree<DescriptorFloat>& tree,
+                         const VocabularyTreeT& tree,
                          EImageMatchingMode modeMultiSfM,
                          std::size_t nbMaxDescriptors,
-                         std::size_t numImageQuery)
+                         std::size_t numImageQuery,
+                         std::uint64_t treeSignature)
 {
   ALICEVISION_LOG_INFO("Generate matches in mode: " + EImageMatchingMode_enumToString(modeMultiSfM));
 
@@ -311,43 +347,202 @@ void generateFromVoctree(PairList& allMatches,
       allMatches[descriptorPair.first] = {};
   }
 
-  // query each document
-  #pragma omp parallel for
-  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
+  // sparse histogram of each document
+  aliceVision::voctree::SparseHistogramPerImage computedSH;
+  std::vector<const aliceVision::voctree::SparseHistogram*> imagesSH;
+  imagesSH.reserve(descriptorsFiles.size());
+
+  if(modeMultiSfM == EImageMatchingMode::A_B)
   {
-    auto itA = descriptorsFiles.cbegin();
-    std::advance(itA, i);
-    const IndexT viewIdA = itA->first;
-    const std::string featuresPathA = itA->second;
+    // compute the sparse histogram of each image A
+    aliceVision::voctree::computeSparseHistograms<FileDescriptorT>(descriptorsFiles, tree, computedSH, nbMaxDescriptors, treeSignature);
+  }
 
-    aliceVision::voctree::SparseHistogram imageSH;
+  for(const auto& descriptorPair : descriptorsFiles)
+  {
+    // in modes A_A and A_AB, the sparse histogram of A is already computed in the DB
+    const aliceVision::voctree::SparseHistogramPerImage& histograms = (modeMultiSfM == EImageMatchingMode::A_B) ? computedSH : db.getSparseHistogramPerImage();
+    imagesSH.push_back(&histograms.at(descriptorPair.first));
+  }
+
+  // query all the documents together
+  std::vector<aliceVision::voctree::DocMatches> allDocMatches;
+  db.find(imagesSH, numImageQuery, allDocMatches);
+
+  std::size_t i = 0;
+  for(const auto& descriptorPair : descriptorsFiles)
+  {
+    const std::vector<aliceVision::voctree::DocMatch>& matches = allDocMatches[i++];
+
+    ListOfImageID& imgMatches = allMatches.at(descriptorPair.first);
+    imgMatches.reserve(imgMatches.size() + matches.size());
 
-    if(modeMultiSfM != EImageMatchingMode::A_B)
+    for(const aliceVision::voctree::DocMatch& m : matches)
     {
-      // sparse histogram of A is already computed in the DB
-      imageSH = db.getSparseHistogramPerImage().at(viewIdA);
+      imgMatches.push_back(m.id);
     }
-    else // mode AB
+  }
+}
+
+/**
+ * @brief Select the image pairs with a vocabulary tree
+ * @tparam TreeDescriptorT The descriptor type of the tree
+ * @tparam DistanceT The distance of the tree (L2 for SIFT, Hamming for the binary descriptors)
+ * @tparam FileDescriptorT The descriptor type of the descriptor files
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+template<class TreeDescriptorT, template<typename, typename> class DistanceT, class FileDescriptorT>
+int generatePairsFromVoctree(OrderedPairList& selectedPairs,
+                             const std::string& treeName,
+                             const std::string& weightsName,
+                             bool withWeights,
+                             bool useHistogramsCache,
+                             EImageMatchingMode matchingMode,
+                             bool useMultiSfM,
+                             const sfm::SfMData& sfmDataA,
+                             const sfm::SfMData& sfmDataB,
+                             const std::string& sfmDataFilenameA,
+                             const std::string& sfmDataFilenameB,
+                             const std::vector<std::string>& featuresFolders,
+                             const std::map<IndexT, std::string>& queryDescriptorsFilesA,
+                             feature::EImageDescriberType descType,
+                             std::size_t nbMaxDescriptors,
+                             std::size_t numImageQuery)
+{
+  // load vocabulary tree
+  ALICEVISION_LOG_INFO("Loading vocabulary tree");
+
+  auto loadVoctree_start = std::chrono::steady_clock::now();
+  aliceVision::voctree::VocabularyTree<TreeDescriptorT, DistanceT> tree(treeName);
+  auto loadVoctree_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - loadVoctree_start);
+  {
+    std::stringstream ss;
+    ss << "tree loaded with:" << std::endl << "\t- " << tree.levels() << " levels" << std::endl;
+    ss << "\t- " << tree.splits() << " branching factor" << std::endl;
+    ss << "\tin " << loadVoctree_elapsed.count() << " seconds" << std::endl;
+    ALICEVISION_LOG_INFO(ss.str());
+  }
+
+  // signature of the tree to validate the cached histograms
+  const std::uint64_t treeSignature = useHistogramsCache ? aliceVision::voctree::getVocabularyTreeSignature(treeName) : 0;
+
+  // create the databases
+  ALICEVISION_LOG_INFO("Creating the databases...");
+
+  // add each object (document) to the database
+  aliceVision::voctree::Database db(tree.words());
+  aliceVision::voctree::Database db2;
+
+  if(withWeights)
+  {
+    ALICEVISION_LOG_INFO("Loading weights...");
+    db.loadWeights(weightsName);
+  }
+  else
+  {
+    ALICEVISION_LOG_INFO("No weights specified, skipping...");
+  }
+
+  if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
+    db2 = db; // initialize database2 with database1 initialization
+
+  // read the descriptors and populate the databases
+  {
+    std::stringstream ss;
+
+    for(const std::string& featuresFolder : featuresFolders)
+      ss << "\t- " << featuresFolder << std::endl;
+
+    ALICEVISION_LOG_INFO("Reading descriptors from: " << std::endl << ss.str());
+
+    std::size_t nbFeaturesLoadedInputA = 0;
+    std::size_t nbFeaturesLoadedInputB = 0;
+    std::size_t nbSetDescriptors = 0;
+
+    auto detect_start = std::chrono::steady_clock::now();
     {
-      // compute the sparse histogram of each image A
-      std::vector<DescriptorUChar> descriptors;
-      // read the descriptors
-      loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-      imageSH = tree.quantizeToSparse(descriptors);
+
+      if((matchingMode == EImageMatchingMode::A_A_AND_A_B) ||
+         (matchingMode == EImageMatchingMode::A_AB) ||
+         (matchingMode == EImageMatchingMode::A_A))
+      {
+        nbFeaturesLoadedInputA = aliceVision::voctree::populateDatabase<FileDescriptorT>(sfmDataA, featuresFolders, tree, db, nbMaxDescriptors, treeSignature, descType);
+        nbSetDescriptors = db.getSparseHistogramPerImage().size();
+
+        if(nbFeaturesLoadedInputA == 0)
+        {
+          ALICEVISION_LOG_ERROR("No descriptors loaded in '" + sfmDataFilenameA + "'");
+          return EXIT_FAILURE;
+        }
+      }
+
+      if((matchingMode == EImageMatchingMode::A_AB) ||
+         (matchingMode == EImageMatchingMode::A_B))
+      {
+        nbFeaturesLoadedInputB = aliceVision::voctree::populateDatabase<FileDescriptorT>(sfmDataB, featuresFolders, tree, db, nbMaxDescriptors, treeSignature, descType);
+        nbSetDescriptors = db.getSparseHistogramPerImage().size();
+      }
+
+      if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
+      {
+        nbFeaturesLoadedInputB = aliceVision::voctree::populateDatabase<FileDescriptorT>(sfmDataB, featuresFolders, tree, db2, nbMaxDescriptors, treeSignature, descType);
+        nbSetDescriptors += db2.getSparseHistogramPerImage().size();
+      }
+
+      if(useMultiSfM && (nbFeaturesLoadedInputB == 0))
+      {
+        ALICEVISION_LOG_ERROR("No descriptors loaded in '" + sfmDataFilenameB + "'");
+        return EXIT_FAILURE;
+      }
     }
 
-    std::vector<aliceVision::voctree::DocMatch> matches;
+    auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
 
-    db.find(imageSH, numImageQuery, matches);
+    ALICEVISION_LOG_INFO("Read " << nbSetDescriptors << " sets of descriptors for a total of " << (nbFeaturesLoadedInputA + nbFeaturesLoadedInputB) << " features");
+    ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec.");
+  }
 
-    ListOfImageID& imgMatches = allMatches.at(viewIdA);
-    imgMatches.reserve(imgMatches.size() + matches.size());
+  if(!withWeights)
+  {
+    // compute and save the word weights
+    ALICEVISION_LOG_INFO("Computing weights...");
 
-    for(const aliceVision::voctree::DocMatch& m : matches)
+    db.computeTfIdfWeights();
+
+    if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
+      db2.computeTfIdfWeights();
+  }
+
+  {
+    PairList allMatches;
+
+    ALICEVISION_LOG_INFO("Query all documents");
+
+    auto detect_start = std::chrono::steady_clock::now();
+
+    if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
     {
-      imgMatches.push_back(m.id);
+      generateFromVoctree<FileDescriptorT>(allMatches, queryDescriptorsFilesA, db,  tree, EImageMatchingMode::A_A, nbMaxDescriptors, numImageQuery, treeSignature);
+      generateFromVoctree<FileDescriptorT>(allMatches, queryDescriptorsFilesA, db2, tree, EImageMatchingMode::A_B, nbMaxDescriptors, numImageQuery, treeSignature);
     }
+    else
+    {
+      generateFromVoctree<FileDescriptorT>(allMatches, queryDescriptorsFilesA, db, tree, matchingMode,  nbMaxDescriptors, numImageQuery, treeSignature);
+    }
+
+    auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
+    ALICEVISION_LOG_INFO("Query all documents took " << detect_elapsed.count() << " sec.");
+
+    // process pair list
+    detect_start = std::chrono::steady_clock::now();
+
+    ALICEVISION_LOG_INFO("Convert all matches to pairList");
+    convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
+    detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
+    ALICEVISION_LOG_INFO("Convert all matches to pairList took " << detect_elapsed.count() << " sec.");
   }
+
+  return EXIT_SUCCESS;
 }
 
 int main(int argc, char** argv)
@@ -362,6 +557,8 @@ int main(int argc, char** argv)
   std::vector<std::string> featuresFolders;
   /// the filename of the voctree
   std::string treeName;
+  /// the describer type of the descriptors quantized by the voctree
+  std::string describerTypeName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
   /// the file in which to save the results
   std::string outputFile;
 
@@ -377,6 +574,10 @@ int main(int argc, char** argv)
   std::string weightsName;
   /// flag for the optional weights file
   bool withWeights = false;
+  /// cache the sparse histograms next to the descriptors
+  bool useHistogramsCache = true;
+  /// the pair list of a previous run, only the new images are queried
+  std::string previousPairListFilepath;
 
   // multiple SfM parameters
 
@@ -410,6 +611,8 @@ int main(int argc, char** argv)
 
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
+    ("describerType,d", po::value<std::string>(&describerTypeName)->default_value(describerTypeName),
+      "Describer type of the descriptors quantized by the vocabulary tree: sift or akaze_mldb (binary tree, see voctreeCreation).")
     ("minNbImages", po::value<std::size_t>(&minNbImages)->default_value(minNbImages),
       "Minimal number of images to use the vocabulary tree. If we have less images than this threshold, we will compute all matching combinations.")
     ("maxDescriptors", po::value<std::size_t>(&nbMaxDescriptors)->default_value(nbMaxDescriptors),
@@ -418,7 +621,13 @@ int main(int argc, char** argv)
       "The number of matches to retrieve for each image (If 0 it will "
       "retrieve all the matches).")
     ("weights,w", po::value<std::string>(&weightsName),
-      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.");
+      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.")
+    ("useHistogramsCache", po::value<bool>(&useHistogramsCache)->default_value(useHistogramsCache),
+      "Save the quantized descriptors of each image next to its descriptors file (<viewId>.<describerType>.hist) "
+      "and reuse them in the next runs with the same vocabulary tree.")
+    ("previousPairList", po::value<std::string>(&previousPairListFilepath)->default_value(previousPairListFilepath),
+      "Pair list of a previous run on a subset of the images: its pairs are kept and only the images "
+      "that are not in it are queried in the vocabulary tree database.");
 
   po::options_description multiSfMParams("Multiple SfM");
   multiSfMParams.add_options()
@@ -470,6 +679,7 @@ int main(int argc, char** argv)
   // multiple SfM
   const bool useMultiSfM = !sfmDataFilenameB.empty();
   const EImageMatchingMode matchingMode = EImageMatchingMode_stringToEnum(matchingModeName);
+  const feature::EImageDescriberType descType = feature::EImageDescriberType_stringToEnum(describerTypeName);
 
   if(useMultiSfM == (matchingMode == EImageMatchingMode::A_A))
   {
@@ -508,10 +718,39 @@ int main(int argc, char** argv)
   std::map<IndexT, std::string> descriptorsFilesA, descriptorsFilesB;
 
   // load descriptor filenames
-  aliceVision::voctree::getListOfDescriptorFiles(sfmDataA, featuresFolders, descriptorsFilesA);
+  aliceVision::voctree::getListOfDescriptorFiles(sfmDataA, featuresFolders, descriptorsFilesA, descType);
 
   if(useMultiSfM)
-    aliceVision::voctree::getListOfDescriptorFiles(sfmDataB, featuresFolders, descriptorsFilesB);
+    aliceVision::voctree::getListOfDescriptorFiles(sfmDataB, featuresFolders, descriptorsFilesB, descType);
+
+  // incremental pair generation: the images of the previous pair list are not queried again
+  OrderedPairList previousPairs;
+  std::map<IndexT, std::string> queryDescriptorsFilesA = descriptorsFilesA;
+
+  if(!previousPairListFilepath.empty())
+  {
+    if(!loadPairList(previousPairListFilepath, previousPairs))
+    {
+      ALICEVISION_LOG_ERROR("The previous pair list file '" + previousPairListFilepath + "' cannot be read.");
+      return EXIT_FAILURE;
+    }
+
+    std::set<ImageID> previousImages;
+    for(const auto& previousPair : previousPairs)
+    {
+      previousImages.insert(previousPair.first);
+      previousImages.insert(previousPair.second.begin(), previousPair.second.end());
+    }
+    for(auto it = queryDescriptorsFilesA.begin(); it != queryDescriptorsFilesA.end();)
+    {
+      if(previousImages.count(it->first))
+        it = queryDescriptorsFilesA.erase(it);
+      else
+        ++it;
+    }
+    ALICEVISION_LOG_INFO("Previous pair list: " << previousImages.size() << " images, "
+                         << queryDescriptorsFilesA.size() << " new images to query.");
+  }
 
   if(treeName.empty() && (descriptorsFilesA.size() + descriptorsFilesB.size()) > 200)
     ALICEVISION_LOG_WARNING("No vocabulary tree argument, so it will use the brute force approach which can be compute intensive for aliceVision_featureMatching.");
@@ -533,136 +772,41 @@ int main(int argc, char** argv)
 
   // if selectedPairs is not already computed by a brute force approach,
   // we compute it with the vocabulary tree approach.
-  if(selectedPairs.empty())
+  if(selectedPairs.empty() && !queryDescriptorsFilesA.empty())
   {
-    // load vocabulary tree
-    ALICEVISION_LOG_INFO("Loading vocabulary tree");
-
-    auto loadVoctree_start = std::chrono::steady_clock::now();
-    aliceVision::voctree::VocabularyTree<DescriptorFloat> tree(treeName);
-    auto loadVoctree_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - loadVoctree_start);
-    {
-      std::stringstream ss;
-      ss << "tree loaded with:" << std::endl << "\t- " << tree.levels() << " levels" << std::endl;
-      ss << "\t- " << tree.splits() << " branching factor" << std::endl;
-      ss << "\tin " << loadVoctree_elapsed.count() << " seconds" << std::endl;
-      ALICEVISION_LOG_INFO(ss.str());
-    }
+    int status = EXIT_FAILURE;
 
-    // create the databases
-    ALICEVISION_LOG_INFO("Creating the databases...");
-
-    // add each object (document) to the database
-    aliceVision::voctree::Database db(tree.words());
-    aliceVision::voctree::Database db2;
-
-    if(withWeights)
-    {
-      ALICEVISION_LOG_INFO("Loading weights...");
-      db.loadWeights(weightsName);
-    }
-    else
+    switch(descType)
     {
-      ALICEVISION_LOG_INFO("No weights specified, skipping...");
-    }
-
-    if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
-      db2 = db; // initialize database2 with database1 initialization
-
-    // read the descriptors and populate the databases
-    {
-      std::stringstream ss;
-
-      for(const std::string& featuresFolder : featuresFolders)
-        ss << "\t- " << featuresFolder << std::endl;
-
-      ALICEVISION_LOG_INFO("Reading descriptors from: " << std::endl << ss.str());
-
-      std::size_t nbFeaturesLoadedInputA = 0;
-      std::size_t nbFeaturesLoadedInputB = 0;
-      std::size_t nbSetDescriptors = 0;
-
-      auto detect_start = std::chrono::steady_clock::now();
-      {
-
-        if((matchingMode == EImageMatchingMode::A_A_AND_A_B) ||
-           (matchingMode == EImageMatchingMode::A_AB) ||
-           (matchingMode == EImageMatchingMode::A_A))
-        {
-          nbFeaturesLoadedInputA = aliceVision::voctree::populateDatabase<DescriptorUChar>(sfmDataA, featuresFolders, tree, db, nbMaxDescriptors);
-          nbSetDescriptors = db.getSparseHistogramPerImage().size();
-
-          if(nbFeaturesLoadedInputA == 0)
-          {
-            ALICEVISION_LOG_ERROR("No descriptors loaded in '" + sfmDataFilenameA + "'");
-            return EXIT_FAILURE;
-          }
-        }
-
-        if((matchingMode == EImageMatchingMode::A_AB) ||
-           (matchingMode == EImageMatchingMode::A_B))
-        {
-          nbFeaturesLoadedInputB = aliceVision::voctree::populateDatabase<DescriptorUChar>(sfmDataB, featuresFolders, tree, db, nbMaxDescriptors);
-          nbSetDescriptors = db.getSparseHistogramPerImage().size();
-        }
-
-        if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
-        {
-          nbFeaturesLoadedInputB = aliceVision::voctree::populateDatabase<DescriptorUChar>(sfmDataB, featuresFolders, tree, db2, nbMaxDescriptors);
-          nbSetDescriptors += db2.getSparseHistogramPerImage().size();
-        }
-
-        if(useMultiSfM && (nbFeaturesLoadedInputB == 0))
-        {
-          ALICEVISION_LOG_ERROR("No descriptors loaded in '" + sfmDataFilenameB + "'");
-          return EXIT_FAILURE;
-        }
-      }
-
-      auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
-
-      ALICEVISION_LOG_INFO("Read " << nbSetDescriptors << " sets of descriptors for a total of " << (nbFeaturesLoadedInputA + nbFeaturesLoadedInputB) << " features");
-      ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec.");
+      case feature::EImageDescriberType::SIFT:
+        status = generatePairsFromVoctree<DescriptorFloat, aliceVision::voctree::L2, DescriptorUChar>(
+                   selectedPairs, treeName, weightsName, withWeights, useHistogramsCache, matchingMode, useMultiSfM,
+                   sfmDataA, sfmDataB, sfmDataFilenameA, sfmDataFilenameB, featuresFolders, queryDescriptorsFilesA,
+                   descType, nbMaxDescriptors, numImageQuery);
+        break;
+      case feature::EImageDescriberType::AKAZE_MLDB:
+        status = generatePairsFromVoctree<DescriptorBinary, aliceVision::voctree::Hamming, DescriptorBinary>(
+                   selectedPairs, treeName, weightsName, withWeights, useHistogramsCache, matchingMode, useMultiSfM,
+                   sfmDataA, sfmDataB, sfmDataFilenameA, sfmDataFilenameB, featuresFolders, queryDescriptorsFilesA,
+                   descType, nbMaxDescriptors, numImageQuery);
+        break;
+      default:
+        ALICEVISION_LOG_ERROR("No vocabulary tree for the describer type: " << describerTypeName);
     }
 
-    if(!withWeights)
-    {
-      // compute and save the word weights
-      ALICEVISION_LOG_INFO("Computing weights...");
-
-      db.computeTfIdfWeights();
-
-      if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
-        db2.computeTfIdfWeights();
-    }
+    if(status != EXIT_SUCCESS)
+      return status;
+  }
 
+  // keep the previous pairs of the images still in the inputs
+  for(const auto& previousPair : previousPairs)
+  {
+    if(!descriptorsFilesA.count(previousPair.first) && !descriptorsFilesB.count(previousPair.first))
+      continue;
+    for(const ImageID matchId : previousPair.second)
     {
-      PairList allMatches;
-
-      ALICEVISION_LOG_INFO("Query all documents");
-
-      auto detect_start = std::chrono::steady_clock::now();
-
-      if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
-      {
-        generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A, nbMaxDescriptors, numImageQuery);
-        generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B, nbMaxDescriptors, numImageQuery);
-      }
-      else
-      {
-        generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,  nbMaxDescriptors, numImageQuery);
-      }
-
-      auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
-      ALICEVISION_LOG_INFO("Query all documents took " << detect_elapsed.count() << " sec.");
-
-      // process pair list
-      detect_start = std::chrono::steady_clock::now();
-
-      ALICEVISION_LOG_INFO("Convert all matches to pairList");
-      convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
-      detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
-      ALICEVISION_LOG_INFO("Convert all matches to pairList took " << detect_elapsed.count() << " sec.");
+      if(descriptorsFilesA.count(matchId) || descriptorsFilesB.count(matchId))
+        selectedPairs[previousPair.first].insert(matchId);
     }
   }
 
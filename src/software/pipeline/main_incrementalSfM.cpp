@@ -8,6 +8,8 @@
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/system/MemoryAccounting.hpp>
+#include <aliceVision/system/Telemetry.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
@@ -20,7 +22,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 3
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -82,6 +84,9 @@ int main(int argc, char **argv)
   std::string extraInfoFolder;
   std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
   std::string outInterFileExtension = ".ply";
+  std::size_t outInterFileInterval = 3;
+  std::string checkpointFilepath;
+  std::size_t checkpointInterval = 10;
   std::pair<std::string,std::string> initialPairString("","");
   int maxNbMatches = 0;
   int minInputTrackLength = 2;
@@ -97,6 +102,7 @@ int main(int argc, char **argv)
   bool useTrackFiltering = true;
   bool lockScenePreviouslyReconstructed = true;
   std::size_t localBundelAdjustementGraphDistanceLimit = 1;
+  std::size_t maxNbPosesPerSubmap = 0;
   std::string localizerEstimatorName = robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC);
 
   po::options_description allParams(
@@ -125,6 +131,13 @@ int main(int argc, char **argv)
       feature::EImageDescriberType_informations().c_str())
     ("interFileExtension", po::value<std::string>(&outInterFileExtension)->default_value(outInterFileExtension),
       "Extension of the intermediate file export.")
+    ("interFileInterval", po::value<std::size_t>(&outInterFileInterval)->default_value(outInterFileInterval),
+      "Number of resections between two intermediate file exports (0 to disable them).")
+    ("checkpoint", po::value<std::string>(&checkpointFilepath)->default_value(checkpointFilepath),
+      "Checkpoint file of the reconstruction (.sfmb), saved in background during the reconstruction. "
+      "If the file exists, the interrupted reconstruction is resumed from it instead of the input SfMData.")
+    ("checkpointInterval", po::value<std::size_t>(&checkpointInterval)->default_value(checkpointInterval),
+      "Number of resections between two checkpoints (0 to disable them).")
     ("maxNumberOfMatches", po::value<int>(&maxNbMatches)->default_value(maxNbMatches),
       "Maximum number of matches per image pair (and per feature type). "
       "This can be useful to have a quick reconstruction overview. 0 means no limit.")
@@ -155,6 +168,9 @@ int main(int argc, char **argv)
       "It reduces the reconstruction time, especially for big datasets (500+ images).")
     ("localBAGraphDistance", po::value<std::size_t>(&localBundelAdjustementGraphDistanceLimit)->default_value(localBundelAdjustementGraphDistanceLimit),
       "Graph-distance limit setting the Active region in the Local Bundle Adjustment strategy.")
+    ("maxNbPosesPerSubmap", po::value<std::size_t>(&maxNbPosesPerSubmap)->default_value(maxNbPosesPerSubmap),
+      "Max. number of poses per submap of the partitioned bundle adjustment, used for the global bundle adjustments\n"
+      "of the scenes with more poses. It bounds the memory of the solver for very large datasets (0 to disable).")
     ("localizerEstimator", po::value<std::string>(&localizerEstimatorName)->default_value(localizerEstimatorName),
       "Estimator type used to localize cameras (acransac (default), ransac, lsmeds, loransac, maxconsensus)")
     ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
@@ -203,6 +219,16 @@ int main(int argc, char **argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  system::StageTelemetry telemetry("incrementalSfM");
+
+  // resume an interrupted reconstruction from its checkpoint
+  const bool resume = !checkpointFilepath.empty() && fs::exists(checkpointFilepath);
+  if(resume)
+  {
+    ALICEVISION_LOG_INFO("Resume the reconstruction from the checkpoint: " << checkpointFilepath);
+    sfmDataFilename = checkpointFilepath;
+  }
+
   // load input SfMData scene
   SfMData sfmData;
   if(!Load(sfmData, sfmDataFilename, ESfMData::ALL))
@@ -212,7 +238,8 @@ int main(int argc, char **argv)
   }
 
   // lock scene previously reconstructed
-  if(lockScenePreviouslyReconstructed)
+  // (the checkpoint keeps the locks of the input scene, the poses reconstructed since are still refined)
+  if(lockScenePreviouslyReconstructed && !resume)
   {
     // lock all reconstructed camera poses
     for(auto& cameraPosePair : sfmData.getPoses())
@@ -245,6 +272,12 @@ int main(int argc, char **argv)
     ALICEVISION_LOG_ERROR("Unable to load matches.");
     return EXIT_FAILURE;
   }
+  system::MemoryCounter pairwiseMatchesMemory("matching.pairwiseMatches");
+  pairwiseMatchesMemory.set(matching::getMemorySize(pairwiseMatches));
+
+  // models of the matching geometric filtering, to avoid estimating them again
+  matching::PairGeometricModels geometricModels;
+  sfm::loadPairGeometricModels(geometricModels, sfmData, matchesFolders, useOnlyMatchesFromInputFolder);
 
   if(extraInfoFolder.empty())
   {
@@ -264,6 +297,7 @@ int main(int argc, char **argv)
   // configure the featuresPerView & the matches_provider
   sfmEngine.setFeatures(&featuresPerView);
   sfmEngine.setMatches(&pairwiseMatches);
+  sfmEngine.setGeometricModels(&geometricModels);
 
   // configure reconstruction parameters
   sfmEngine.setFixedIntrinsics(!refineIntrinsics);
@@ -274,8 +308,12 @@ int main(int argc, char **argv)
   sfmEngine.setMinAngleInitialPair(minAngleInitialPair);
   sfmEngine.setMaxAngleInitialPair(maxAngleInitialPair);
   sfmEngine.setIntermediateFileExtension(outInterFileExtension);
+  sfmEngine.setIntermediateFileInterval(outInterFileInterval);
+  if(!checkpointFilepath.empty())
+    sfmEngine.setCheckpoint(checkpointFilepath, checkpointInterval);
   sfmEngine.setUseLocalBundleAdjustmentStrategy(useLocalBundleAdjustment);
   sfmEngine.setLocalBundleAdjustmentGraphDistance(localBundelAdjustementGraphDistanceLimit);
+  sfmEngine.setMaxNbPosesPerSubmap(maxNbPosesPerSubmap);
   sfmEngine.setLocalizerEstimator(robustEstimation::ERobustEstimator_stringToEnum(localizerEstimatorName));
   sfmEngine.useTrackFiltering(useTrackFiltering);
 
@@ -347,5 +385,8 @@ int main(int argc, char **argv)
     << "\t- # cameras calibrated: " << sfmEngine.getSfMData().getPoses().size() << std::endl
     << "\t- # landmarks: " << sfmEngine.getSfMData().getLandmarks().size());
 
+  telemetry.setNbItems(sfmEngine.getSfMData().getViews().size(), "views");
+  telemetry.write();
+
   return EXIT_SUCCESS;
 }
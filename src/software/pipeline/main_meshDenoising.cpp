@@ -8,6 +8,7 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
 
 #include <EigenTypes.h>
 #include <MeshTypes.h>
@@ -15,10 +16,6 @@
 #include <MeshNormalFilter.h>
 #include <MeshNormalDenoising.h>
 
-#include <OpenMesh/Core/IO/reader/OBJReader.hh>
-#include <OpenMesh/Core/IO/writer/OBJWriter.hh>
-#include <OpenMesh/Core/IO/IOManager.hh>
-
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
@@ -54,9 +51,9 @@ int main(int argc, char* argv[])
     po::options_description requiredParams("Required parameters");
     requiredParams.add_options()
         ("input,i", po::value<std::string>(&inputMeshPath)->required(),
-            "Input Mesh (OBJ file format).")
+            "Input Mesh (OBJ, PLY or BIN file format).")
         ("output,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ, PLY or BIN file format, from the extension).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -123,10 +120,29 @@ int main(int argc, char* argv[])
 
 
     TriMesh inMesh;
-    if(!OpenMesh::IO::read_mesh(inMesh, inputMeshPath.c_str()))
     {
-        ALICEVISION_LOG_ERROR("Unable to read input mesh from the file: " << inputMeshPath);
-        return EXIT_FAILURE;
+        mesh::Mesh mesh;
+        if(!mesh.load(inputMeshPath))
+        {
+            ALICEVISION_LOG_ERROR("Unable to read input mesh from the file: " << inputMeshPath);
+            return EXIT_FAILURE;
+        }
+
+        std::vector<TriMesh::VertexHandle> vertices(mesh.pts->size());
+        for(int i = 0; i < mesh.pts->size(); ++i)
+        {
+            const Point3d& p = (*mesh.pts)[i];
+            vertices[i] = inMesh.add_vertex(TriMesh::Point(p.x, p.y, p.z));
+        }
+        int nbInvalidFacets = 0;
+        for(int i = 0; i < mesh.tris->size(); ++i)
+        {
+            const mesh::Mesh::triangle& t = (*mesh.tris)[i];
+            if(!inMesh.add_face(vertices[t.v[0]], vertices[t.v[1]], vertices[t.v[2]]).is_valid())
+                ++nbInvalidFacets;
+        }
+        if(nbInvalidFacets > 0)
+            ALICEVISION_LOG_WARNING(nbInvalidFacets << " non-manifold facets skipped.");
     }
     if(inMesh.n_vertices() == 0 || inMesh.n_faces() == 0)
     {
@@ -203,10 +219,26 @@ int main(int argc, char* argv[])
 
     ALICEVISION_LOG_INFO("Save mesh.");
     // Save output mesh
-    if(!OpenMesh::IO::write_mesh(outMesh, outputMeshPath))
     {
-        ALICEVISION_LOG_ERROR("Failed to save mesh file: \"" << outputMeshPath << "\".");
-        return EXIT_FAILURE;
+        mesh::Mesh mesh;
+        mesh.pts = new StaticVector<Point3d>();
+        mesh.pts->reserve(outMesh.n_vertices());
+        for(TriMesh::VertexIter vIt = outMesh.vertices_begin(); vIt != outMesh.vertices_end(); ++vIt)
+        {
+            const TriMesh::Point& p = outMesh.point(*vIt);
+            mesh.pts->push_back(Point3d(p[0], p[1], p[2]));
+        }
+        mesh.tris = new StaticVector<mesh::Mesh::triangle>();
+        mesh.tris->reserve(outMesh.n_faces());
+        for(TriMesh::FaceIter fIt = outMesh.faces_begin(); fIt != outMesh.faces_end(); ++fIt)
+        {
+            int v[3];
+            int k = 0;
+            for(TriMesh::FaceVertexIter fvIt = outMesh.fv_iter(*fIt); fvIt.is_valid() && k < 3; ++fvIt)
+                v[k++] = fvIt->idx();
+            mesh.tris->push_back(mesh::Mesh::triangle(v[0], v[1], v[2]));
+        }
+        mesh.save(outputMeshPath);
     }
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << outputMeshPath << "\" saved.");
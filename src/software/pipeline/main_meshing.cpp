@@ -4,8 +4,12 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/numa.hpp>
+#include <aliceVision/system/TaskScheduler.hpp>
+#include <aliceVision/system/Telemetry.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
@@ -24,7 +28,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -78,7 +82,35 @@ inline std::istream& operator>>(std::istream& in, ERepartitionMode& out_mode)
     out_mode = ERepartitionMode_stringToEnum(s);
     return in;
 }
+enum ELargeScaleStep
+{
+    eLargeScaleStepUndefined = 0,
+    eLargeScaleStepAll = 1,
+    eLargeScaleStepPlan = 2,
+    eLargeScaleStepReconstruct = 3,
+    eLargeScaleStepJoin = 4,
+};
+
+ELargeScaleStep ELargeScaleStep_stringToEnum(const std::string& s)
+{
+    if(s == "all")
+        return eLargeScaleStepAll;
+    if(s == "plan")
+        return eLargeScaleStepPlan;
+    if(s == "reconstruct")
+        return eLargeScaleStepReconstruct;
+    if(s == "join")
+        return eLargeScaleStepJoin;
+    return eLargeScaleStepUndefined;
+}
 
+inline std::istream& operator>>(std::istream& in, ELargeScaleStep& out_step)
+{
+    std::string s;
+    in >> s;
+    out_step = ELargeScaleStep_stringToEnum(s);
+    return in;
+}
 
 int main(int argc, char* argv[])
 {
@@ -94,6 +126,14 @@ int main(int argc, char* argv[])
     ERepartitionMode repartitionMode = eRepartitionMultiResolution;
     po::options_description inputParams;
     int maxPtsPerVoxel = 6000000;
+    bool parallelDelaunay = false;
+    int nbThreads = 0;
+    bool parallelMaxflow = false;
+    system::ENumaMemoryPolicy numaMemoryPolicy = system::ENumaMemoryPolicy::DEFAULT;
+    system::EThreadPinning threadPinning = system::EThreadPinning::NONE;
+    ELargeScaleStep largeScaleStep = eLargeScaleStepAll;
+    int rangeStart = -1;
+    int rangeSize = -1;
 
     fuseCut::FuseParams fuseParams;
 
@@ -108,7 +148,7 @@ int main(int argc, char* argv[])
         ("depthMapFilterFolder", po::value<std::string>(&depthMapFilterFolder)->required(),
             "Input filtered depth maps folder.")
         ("output,o", po::value<std::string>(&outputMesh)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ, PLY or BIN file format, from the extension).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -128,7 +168,24 @@ int main(int argc, char* argv[])
         ("partitioning", po::value<EPartitioningMode>(&partitioningMode)->default_value(partitioningMode),
             "Partitioning: 'singleBlock' or 'auto'.")
         ("repartition", po::value<ERepartitionMode>(&repartitionMode)->default_value(repartitionMode),
-            "Repartition: 'multiResolution' or 'regularGrid'.");
+            "Repartition: 'multiResolution' or 'regularGrid'.")
+        ("parallelDelaunay", po::value<bool>(&parallelDelaunay)->default_value(parallelDelaunay),
+            "Use the multi-threaded Delaunay tetrahedralization of geogram (PDEL) for large point sets.")
+        ("nbThreads", po::value<int>(&nbThreads)->default_value(nbThreads),
+            "Number of threads of the parallel Delaunay tetrahedralization (0 means all the cores).")
+        ("parallelMaxflow", po::value<bool>(&parallelMaxflow)->default_value(parallelMaxflow),
+            "Use the multi-threaded push-relabel maxflow instead of the Boykov-Kolmogorov one for the graph cut.")
+        ("numaMemoryPolicy", po::value<system::ENumaMemoryPolicy>(&numaMemoryPolicy)->default_value(numaMemoryPolicy),
+            system::ENumaMemoryPolicy_informations().c_str())
+        ("threadPinning", po::value<system::EThreadPinning>(&threadPinning)->default_value(threadPinning),
+            system::EThreadPinning_informations().c_str())
+        ("largeScaleStep", po::value<ELargeScaleStep>(&largeScaleStep)->default_value(largeScaleStep),
+            "Step of the regular grid auto partitioning: 'all', 'plan' (compute the voxels and write the jobs file), "
+            "'reconstruct' (reconstruct the voxels of the range) or 'join' (join the reconstructed voxels).")
+        ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+            "Reconstruct a sub-range of voxels from index rangeStart to rangeStart+rangeSize.")
+        ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+            "Reconstruct a sub-range of N voxels (N=rangeSize).");
 
     po::options_description advancedParams("Advanced parameters");
     advancedParams.add_options()
@@ -147,7 +204,11 @@ int main(int argc, char* argv[])
             ("minAngleThreshold", po::value<double>(&fuseParams.minAngleThreshold)->default_value(fuseParams.minAngleThreshold),
                 "minAngleThreshold")
             ("refineFuse", po::value<bool>(&fuseParams.refineFuse)->default_value(fuseParams.refineFuse),
-                "refineFuse");
+                "refineFuse")
+            ("streamingFuse", po::value<bool>(&fuseParams.streamingFuse)->default_value(fuseParams.streamingFuse),
+                "Filter the points as the depth maps are loaded, to bound the memory used by the fusion.")
+            ("nbCamerasPerBatch", po::value<int>(&fuseParams.nbCamerasPerBatch)->default_value(fuseParams.nbCamerasPerBatch),
+                "Number of depth maps loaded in parallel by the streaming fusion.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -189,10 +250,27 @@ int main(int argc, char* argv[])
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
 
+    system::StageTelemetry telemetry("meshing");
+
+    // NUMA placement of the tetrahedralization and pinning of the threads next to it
+    system::setNumaMemoryPolicy(numaMemoryPolicy);
+    if(threadPinning != system::EThreadPinning::NONE)
+    {
+        system::TaskScheduler::get().setThreadPinning(threadPinning);
+
+        // the OpenMP threads are reused by the next parallel regions
+        #pragma omp parallel
+        system::pinCurrentThread(system::getPinnedCpu(threadPinning, omp_get_thread_num()));
+    }
+
     // .ini and files parsing
     mvsUtils::MultiViewParams mp(iniFilepath, depthMapFolder, depthMapFilterFolder, true);
     mvsUtils::PreMatchCams pc(&mp);
 
+    mp._ini.put("delaunaycut.parallelDelaunay", parallelDelaunay);
+    mp._ini.put("delaunaycut.nbThreads", nbThreads);
+    mp._ini.put("delaunaycut.parallelMaxflow", parallelMaxflow);
+
     int ocTreeDim = mp._ini.get<int>("LargeScale.gridLevel0", 1024);
     const auto baseDir = mp._ini.get<std::string>("LargeScale.baseDirName", "root01024");
 
@@ -214,24 +292,67 @@ int main(int argc, char* argv[])
                 case ePartitioningAuto:
                 {
                     ALICEVISION_LOG_INFO("Meshing mode: regular Grid, partitioning: auto.");
+                    if(largeScaleStep == eLargeScaleStepUndefined)
+                        throw std::invalid_argument("Large scale step is not defined");
+
                     fuseCut::LargeScale lsbase(&mp, &pc, tmpDirectory.string() + "/");
-                    lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
                     std::string voxelsArrayFileName = lsbase.spaceFolderName + "hexahsToReconstruct.bin";
-                    StaticVector<Point3d>* voxelsArray = nullptr;
-                    if(bfs::exists(voxelsArrayFileName))
+
+                    if(largeScaleStep == eLargeScaleStepAll || largeScaleStep == eLargeScaleStepPlan)
                     {
-                        // If already computed reload it.
-                        ALICEVISION_LOG_INFO("Voxels array already computed, reload from file: " << voxelsArrayFileName);
-                        voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+                        lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
+                        if(bfs::exists(voxelsArrayFileName))
+                        {
+                            ALICEVISION_LOG_INFO("Voxels array already computed: " << voxelsArrayFileName);
+                        }
+                        else
+                        {
+                            ALICEVISION_LOG_INFO("Compute voxels array.");
+                            fuseCut::ReconstructionPlan rp(lsbase.dimensions, &lsbase.space[0], lsbase.mp, lsbase.pc, lsbase.spaceVoxelsFolderName);
+                            StaticVector<Point3d>* voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints);
+                            saveArrayToFile<Point3d>(voxelsArrayFileName, voxelsArray);
+                            delete voxelsArray;
+                        }
+                        if(largeScaleStep == eLargeScaleStepPlan)
+                        {
+                            fuseCut::exportVoxelsReconstructionJobs(voxelsArrayFileName, &lsbase, (outDirectory/"voxelsJobs.json").string());
+                            break;
+                        }
                     }
                     else
                     {
-                        ALICEVISION_LOG_INFO("Compute voxels array.");
-                        fuseCut::ReconstructionPlan rp(lsbase.dimensions, &lsbase.space[0], lsbase.mp, lsbase.pc, lsbase.spaceVoxelsFolderName);
-                        voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints);
-                        saveArrayToFile<Point3d>(voxelsArrayFileName, voxelsArray);
+                        // the space and the voxels array are computed by the plan step
+                        if(!lsbase.isSpaceSaved() || !bfs::exists(voxelsArrayFileName))
+                            throw std::runtime_error("Missing large scale space, the 'plan' step should be computed first: " + lsbase.spaceFolderName);
+                        lsbase.loadSpaceFromFile();
                     }
-                    fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase);
+
+                    if(largeScaleStep == eLargeScaleStepAll || largeScaleStep == eLargeScaleStepReconstruct)
+                    {
+                        if(rangeSize != -1 && rangeStart < 0)
+                        {
+                            ALICEVISION_LOG_ERROR("invalid subrange of voxels to reconstruct.");
+                            return EXIT_FAILURE;
+                        }
+                        fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase, std::max(rangeStart, 0), rangeSize);
+                        if(largeScaleStep == eLargeScaleStepReconstruct)
+                            break;
+                    }
+
+                    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+                    const std::vector<std::string> recsDirs = lsbase.getRecsDirs(voxelsArray);
+                    delete voxelsArray;
+
+                    const std::vector<int> missingVoxels = fuseCut::getMissingVoxelsReconstructions(recsDirs);
+                    if(!missingVoxels.empty())
+                    {
+                        std::string missingVoxelsStr;
+                        for(int i : missingVoxels)
+                            missingVoxelsStr += " " + mvsUtils::num2str(i);
+                        throw std::runtime_error("Missing reconstruction of " + mvsUtils::num2str(static_cast<int>(missingVoxels.size())) +
+                                                 " voxel(s):" + missingVoxelsStr);
+                    }
+
                     // Join meshes
                     mesh::Mesh* mesh = fuseCut::joinMeshes(voxelsArrayFileName, &lsbase);
 
@@ -243,13 +364,13 @@ int main(int argc, char* argv[])
                     bfs::path spaceBinFileName = outDirectory/"denseReconstruction.bin";
                     mesh->saveToBin(spaceBinFileName.string());
 
-                    // Export joined mesh to obj
-                    mesh->saveToObj(outputMesh);
+                    // Export joined mesh
+                    mesh->save(outputMesh);
 
                     delete mesh;
 
                     // Join ptsCams
-                    StaticVector<StaticVector<int>*>* ptsCams = fuseCut::loadLargeScalePtsCams(lsbase.getRecsDirs(voxelsArray));
+                    StaticVector<StaticVector<int>*>* ptsCams = fuseCut::loadLargeScalePtsCams(recsDirs);
                     saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
                     deleteArrayOfArrays<int>(&ptsCams);
                     break;
@@ -311,7 +432,7 @@ int main(int argc, char* argv[])
                     saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
                     deleteArrayOfArrays<int>(&ptsCams);
 
-                    mesh->saveToObj(outputMesh);
+                    mesh->save(outputMesh);
 
                     delete mesh;
                     break;
@@ -378,7 +499,7 @@ int main(int argc, char* argv[])
                     deleteArrayOfArrays<int>(&ptsCams);
                     delete voxels;
 
-                    mesh->saveToObj(outputMesh);
+                    mesh->save(outputMesh);
 
                     delete mesh;
                     break;
@@ -394,6 +515,9 @@ int main(int argc, char* argv[])
             throw std::invalid_argument("Repartition mode is not defined");
     }
 
+    telemetry.setNbItems(mp.ncams, "cameras");
+    telemetry.write();
+
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
     return EXIT_SUCCESS;
 }
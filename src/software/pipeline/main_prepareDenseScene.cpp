@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -12,11 +13,12 @@
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/progress.hpp>
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <cmath>
+#include <exception>
+#include <memory>
 #include <vector>
 #include <set>
 #include <iterator>
@@ -25,7 +27,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -105,55 +107,242 @@ void retrieveSeedsPerView(
     SeedsPerView& outSeedsPerView)
 {
   static const double minAngle = 3.0;
+
+  // pose and intrinsic of the exported views, by index in viewIds
+  std::vector<geometry::Pose3> poses;
+  std::vector<const IntrinsicBase*> intrinsics;
+  HashMap<IndexT, unsigned short> viewIndexes;
+  poses.reserve(viewIds.size());
+  intrinsics.reserve(viewIds.size());
+  for(const IndexT viewId : viewIds)
+  {
+    const View& view = *sfmData.getViews().at(viewId).get();
+    viewIndexes[viewId] = poses.size();
+    poses.push_back(sfmData.getPose(view).getTransform());
+    intrinsics.push_back(sfmData.getIntrinsicPtr(view.getIntrinsicId()));
+  }
+
+  std::vector<const Landmark*> landmarks;
+  std::vector<IndexT> landmarkIds;
+  landmarks.reserve(sfmData.structure.size());
+  landmarkIds.reserve(sfmData.structure.size());
   for(const auto& s: sfmData.structure)
   {
-    const IndexT landmarkId = s.first;
-    const Landmark& landmark = s.second;
-    // For each observation of a 3D landmark, we will export
-    // all other observations with an angle > minAngle.
-    for(const auto& obsA: landmark.observations)
+    landmarkIds.push_back(s.first);
+    landmarks.push_back(&s.second);
+  }
+
+  // seeds of each thread, by view index
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::vector<SeedVector>> seedsPerThread(nbThreads, std::vector<SeedVector>(viewIds.size()));
+
+  #pragma omp parallel num_threads(nbThreads)
+  {
+    std::vector<SeedVector>& threadSeeds = seedsPerThread.at(omp_get_thread_num());
+    std::vector<unsigned short> obsViewIndexes;
+    std::vector<Vec3> obsRays;
+
+    // static schedule: each thread processes a contiguous range of landmarks, in the thread order
+    #pragma omp for schedule(static)
+    for(int i = 0; i < landmarks.size(); ++i)
     {
-      const auto& obsACamId_it = viewIds.find(obsA.first);
-      if(obsACamId_it == viewIds.end())
-        continue; // this view cannot be exported to mvs, so we skip the observation
-      const View& viewA = *sfmData.getViews().at(obsA.first).get();
-      const geometry::Pose3 poseA = sfmData.getPose(viewA).getTransform();
-      const Pinhole * intrinsicsA = dynamic_cast<const Pinhole*>(sfmData.getIntrinsics().at(viewA.getIntrinsicId()).get());
-      
-      for(const auto& obsB: landmark.observations)
+      const Landmark& landmark = *landmarks.at(i);
+
+      // bearing vector of each observation that can be exported to mvs
+      obsViewIndexes.clear();
+      obsRays.clear();
+      for(const auto& obs: landmark.observations)
       {
-        // don't export itself
-        if(obsA.first == obsB.first)
-          continue;
-        const auto& obsBCamId_it = viewIds.find(obsB.first);
-        if(obsBCamId_it == viewIds.end())
+        const auto viewIndexIt = viewIndexes.find(obs.first);
+        if(viewIndexIt == viewIndexes.end())
           continue; // this view cannot be exported to mvs, so we skip the observation
-        const unsigned short indexB = std::distance(viewIds.begin(), obsBCamId_it);
-        const View& viewB = *sfmData.getViews().at(obsB.first).get();
-        const geometry::Pose3 poseB = sfmData.getPose(viewB).getTransform();
-        const Pinhole * intrinsicsB = dynamic_cast<const Pinhole*>(sfmData.getIntrinsics().at(viewB.getIntrinsicId()).get());
-
-        const double angle = AngleBetweenRays(
-          poseA, intrinsicsA, poseB, intrinsicsB, obsA.second.x, obsB.second.x);
- 
-        if(angle < minAngle)
-          continue;
-
-        Seed seed;
-        seed.camId = indexB;
-        seed.s.ncams = 1;
-        seed.s.segId = landmarkId;
-        seed.s.op.p.x = landmark.X(0);
-        seed.s.op.p.y = landmark.X(1);
-        seed.s.op.p.z = landmark.X(2);
-
-        outSeedsPerView[obsA.first].push_back(seed);
+        const unsigned short viewIndex = viewIndexIt->second;
+        obsViewIndexes.push_back(viewIndex);
+        obsRays.push_back((poses[viewIndex].rotation().transpose() * intrinsics[viewIndex]->operator()(obs.second.x)).normalized());
       }
+
+      // For each observation of a 3D landmark, we will export
+      // all other observations with an angle > minAngle.
+      for(std::size_t a = 0; a < obsViewIndexes.size(); ++a)
+      {
+        for(std::size_t b = 0; b < obsViewIndexes.size(); ++b)
+        {
+          // don't export itself
+          if(a == b)
+            continue;
+
+          const double angle = AngleBetweenRays(obsRays[a], obsRays[b]);
+
+          if(angle < minAngle)
+            continue;
+
+          Seed seed;
+          seed.camId = obsViewIndexes[b];
+          seed.s.ncams = 1;
+          seed.s.segId = landmarkIds[i];
+          seed.s.op.p.x = landmark.X(0);
+          seed.s.op.p.y = landmark.X(1);
+          seed.s.op.p.z = landmark.X(2);
+
+          threadSeeds[obsViewIndexes[a]].push_back(seed);
+        }
+      }
+    }
+  }
+
+  // concatenate the seeds of the threads, in the landmarks order
+  outSeedsPerView.clear();
+  for(const IndexT viewId : viewIds)
+    outSeedsPerView[viewId];
+
+  #pragma omp parallel for
+  for(int v = 0; v < viewIds.size(); ++v)
+  {
+    auto itView = viewIds.begin();
+    std::advance(itView, v);
+    SeedVector& seeds = outSeedsPerView.at(*itView);
+
+    std::size_t nbSeeds = 0;
+    for(const auto& threadSeeds : seedsPerThread)
+      nbSeeds += threadSeeds[v].size();
+    seeds.reserve(nbSeeds);
+
+    for(auto& threadSeeds : seedsPerThread)
+    {
+      seeds.insert(seeds.end(), threadSeeds[v].begin(), threadSeeds[v].end());
+      SeedVector().swap(threadSeeds[v]);
+    }
+  }
+}
+
+/**
+ * @brief Export parameters of the images
+ */
+struct ExportParams : public UndistortedViewsExportParams
+{
+  ExportParams()
+  {
+    progressTitle = "Exporting Scene Data\n";
+  }
+
+  /// EXR pixel data type
+  EStorageDataType storageDataType = EStorageDataType::Half;
+  /// write the MIP levels of the images, read by the stages working at reduced resolution
+  bool pyramid = true;
+};
+
+/**
+ * @brief Export the camera files and the seeds of a view:
+ *   - viewId_P.txt (Pose of the reconstructed camera)
+ *   - viewId_KRt.txt
+ *   - viewId_seeds.bin (3d points visible in this image)
+ * @param[out] metadata The camera metadata of the view image
+ */
+void exportCameraAndSeeds(const SfMData& sfmData,
+                          const View& view,
+                          const SeedVector& seeds,
+                          int downscale,
+                          const std::string& outFolder,
+                          oiio::ParamValueList& metadata)
+{
+  const IndexT viewId = view.getViewId();
+  const IntrinsicBase* intrinsic = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+
+  // We have a valid view with a corresponding camera & pose
+  const std::string baseFilename = std::to_string(viewId);
+
+  // Export camera
+  {
+    // Export camera pose
+    const Pose3 pose = sfmData.getPose(view).getTransform();
+    Mat34 P = intrinsic->get_projective_equivalent(pose);
+    std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
+    fileP << std::setprecision(10)
+         << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
+         << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
+         << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
+    fileP.close();
+
+    Mat4 projectionMatrix;
+
+    projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
+                        P(1, 0), P(1, 1), P(1, 2), P(1, 3),
+                        P(2, 0), P(2, 1), P(2, 2), P(2, 3),
+                              0,       0,       0,       1;
+
+    // Export camera intrinsics
+    const Mat3 K = dynamic_cast<const Pinhole*>(intrinsic)->K();
+    const Mat3& R = pose.rotation();
+    const Vec3& t = pose.translation();
+    std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
+    fileKRt << std::setprecision(10)
+         << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
+         << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
+         << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
+         << "\n"
+         << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
+         << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
+         << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
+         << "\n"
+         << t(0) << " " << t(1) << " " << t(2) << "\n";
+    fileKRt.close();
+
+
+    // convert matrices to rowMajor
+    std::vector<double> vP(projectionMatrix.size());
+    std::vector<double> vK(K.size());
+    std::vector<double> vR(R.size());
+
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
+    Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
+    Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
+    Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
+
+    // add metadata, the matrices are at full resolution
+    metadata.push_back(oiio::ParamValue("AliceVision:downscale", downscale));
+    metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
+    metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
+    metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
+    metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
+  }
+
+  // Export Seeds
+  {
+    const std::string seedsFilepath = (fs::path(outFolder) / (baseFilename + "_seeds.bin")).string();
+    std::ofstream seedsFile(seedsFilepath, std::ios::binary);
+
+    const int nbSeeds = seeds.size();
+    seedsFile.write((char*)&nbSeeds, sizeof(int));
+
+    for(const Seed& seed: seeds)
+    {
+      seedsFile.write((char*)&seed, sizeof(seed_io_block) + sizeof(unsigned short) + 2 * sizeof(point2d)); //sizeof(Seed));
     }
+    seedsFile.close();
   }
 }
 
-bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder)
+/**
+ * @brief Export the views with the undistorted views export pipeline,
+ *        the encoding stage writes viewId.exr (with its MIP levels if requested), the camera files and the seeds of the view
+ */
+void exportViews(const SfMData& sfmData,
+                 const std::vector<IndexT>& viewIds,
+                 const SeedsPerView& seedsPerView,
+                 const ExportParams& params,
+                 const std::string& outFolder)
+{
+  exportUndistortedViews(sfmData, viewIds, params, [&](const View& view, const Image<RGBfColor>& image)
+  {
+    oiio::ParamValueList metadata;
+    exportCameraAndSeeds(sfmData, view, seedsPerView.at(view.getViewId()), params.downscale, outFolder, metadata);
+
+    const std::string dstColorImage = (fs::path(outFolder) / (std::to_string(view.getViewId()) + ".exr")).string();
+    writeImage(dstColorImage, image, params.storageDataType, metadata, params.pyramid);
+  });
+}
+
+bool prepareDenseScene(const SfMData& sfmData, const ExportParams& params, const std::string& outFolder)
 {
   // defined view Ids
   std::set<IndexT> viewIds;
@@ -168,126 +357,20 @@ bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder)
 
   SeedsPerView seedsPerView;
   retrieveSeedsPerView(sfmData, viewIds, seedsPerView);
-  
-  // Export data
-  boost::progress_display my_progress_bar(viewIds.size(), std::cout, "Exporting Scene Data\n");
 
   // Export views:
   //   - viewId_P.txt (Pose of the reconstructed camera)
+  //   - viewId_KRt.txt
   //   - viewId.exr (undistorted colored image)
   //   - viewId_seeds.bin (3d points visible in this image)
-
-#pragma omp parallel for num_threads(3)
-  for(int i = 0; i < viewIds.size(); ++i)
+  try
   {
-    auto itView = viewIds.begin();
-    std::advance(itView, i);
-
-    const IndexT viewId = *itView;
-    const View* view = sfmData.getViews().at(viewId).get();
-
-    assert(view->getViewId() == viewId);
-    Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
-
-    // We have a valid view with a corresponding camera & pose
-    const std::string baseFilename = std::to_string(viewId);
-
-    oiio::ParamValueList metadata;
-
-    // Export camera
-    {
-      // Export camera pose
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-      Mat34 P = iterIntrinsic->second.get()->get_projective_equivalent(pose);
-      std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
-      fileP << std::setprecision(10)
-           << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
-           << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
-           << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
-      fileP.close();
-
-      Mat4 projectionMatrix;
-
-      projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
-                          P(1, 0), P(1, 1), P(1, 2), P(1, 3),
-                          P(2, 0), P(2, 1), P(2, 2), P(2, 3),
-                                0,       0,       0,       1;
-
-      // Export camera intrinsics
-      const Mat3 K = dynamic_cast<const Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()))->K();
-      const Mat3& R = pose.rotation();
-      const Vec3& t = pose.translation();
-      std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
-      fileKRt << std::setprecision(10)
-           << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
-           << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
-           << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
-           << "\n"
-           << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
-           << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
-           << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
-           << "\n"
-           << t(0) << " " << t(1) << " " << t(2) << "\n";
-      fileKRt.close();
-
-
-      // convert matrices to rowMajor
-      std::vector<double> vP(projectionMatrix.size());
-      std::vector<double> vK(K.size());
-      std::vector<double> vR(R.size());
-
-      typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
-      Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
-      Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
-      Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
-
-      // add metadata
-      metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
-      metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
-      metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
-      metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
-      metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
-    }
-    
-    // Export undistort image
-    {
-      const std::string srcImage = view->getImagePath();
-      std::string dstColorImage = (fs::path(outFolder) / (baseFilename + ".exr")).string();
-
-      const IntrinsicBase* cam = iterIntrinsic->second.get();
-      Image<RGBfColor> image, image_ud;
-
-      readImage(srcImage, image);
-      
-      // Undistort
-      if(cam->isValid() && cam->have_disto())
-      {
-        // undistort the image and save it
-        UndistortImage(image, cam, image_ud, FBLACK);
-        writeImage(dstColorImage, image_ud, metadata);
-      }
-      else
-      {
-        writeImage(dstColorImage, image, metadata);
-      }
-    }
-    
-    // Export Seeds
-    {
-      const std::string seedsFilepath = (fs::path(outFolder) / (baseFilename + "_seeds.bin")).string();
-      std::ofstream seedsFile(seedsFilepath, std::ios::binary);
-      
-      const int nbSeeds = seedsPerView[viewId].size();
-      seedsFile.write((char*)&nbSeeds, sizeof(int));
-      
-      for(const Seed& seed: seedsPerView.at(viewId))
-      {
-        seedsFile.write((char*)&seed, sizeof(seed_io_block) + sizeof(unsigned short) + 2 * sizeof(point2d)); //sizeof(Seed));
-      }
-      seedsFile.close();
-    }
-   #pragma omp critical
-    ++my_progress_bar;
+    exportViews(sfmData, std::vector<IndexT>(viewIds.begin(), viewIds.end()), seedsPerView, params, outFolder);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Failed to export the views: " << e.what());
+    return false;
   }
 
   // Write the mvs ini file
@@ -319,6 +402,8 @@ int main(int argc, char *argv[])
   std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
   std::string sfmDataFilename;
   std::string outFolder;
+  std::string storageDataType = EStorageDataType_enumToString(EStorageDataType::Half);
+  ExportParams params;
 
   po::options_description allParams("AliceVision prepareDenseScene");
 
@@ -329,12 +414,27 @@ int main(int argc, char *argv[])
     ("output,o", po::value<std::string>(&outFolder)->required(),
       "Output folder.");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("storageDataType", po::value<std::string>(&storageDataType)->default_value(storageDataType),
+      EStorageDataType_informations().c_str())
+    ("downscale", po::value<int>(&params.downscale)->default_value(params.downscale),
+      "Downscale factor of the exported images (1, 2, 4, 8...), the cameras remain at full resolution.")
+    ("pyramid", po::value<bool>(&params.pyramid)->default_value(params.pyramid),
+      "Write the images as tiled EXR with all their MIP levels, so the downscaled images are read directly by the next stages.")
+    ("nbDecodeThreads", po::value<int>(&params.nbDecodeThreads)->default_value(params.nbDecodeThreads),
+      "Number of threads decoding the source images.")
+    ("nbUndistortThreads", po::value<int>(&params.nbUndistortThreads)->default_value(params.nbUndistortThreads),
+      "Number of threads undistorting the images (each one uses all the cores).")
+    ("nbEncodeThreads", po::value<int>(&params.nbEncodeThreads)->default_value(params.nbEncodeThreads),
+      "Number of threads encoding the exported images.");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal, error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -367,6 +467,20 @@ int main(int argc, char *argv[])
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  params.storageDataType = EStorageDataType_stringToEnum(storageDataType);
+
+  if(params.downscale < 1 || (params.downscale & (params.downscale - 1)) != 0)
+  {
+    ALICEVISION_LOG_ERROR("Invalid downscale factor: " << params.downscale << ", it should be a power of 2.");
+    return EXIT_FAILURE;
+  }
+
+  if(params.nbDecodeThreads < 1 || params.nbUndistortThreads < 1 || params.nbEncodeThreads < 1)
+  {
+    ALICEVISION_LOG_ERROR("Each stage of the export needs at least one thread.");
+    return EXIT_FAILURE;
+  }
+
   // export
   {
     // Create output dir
@@ -381,7 +495,7 @@ int main(int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-    if(!prepareDenseScene(sfmData, outFolder))
+    if(!prepareDenseScene(sfmData, params, outFolder))
       return EXIT_FAILURE;
   }
 
@@ -6,6 +6,7 @@
 
 #include <aliceVision/config.hpp>
 #include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/localization/LocalizationResult.hpp>
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
 #include <aliceVision/localization/CCTagLocalizer.hpp>
 #endif
@@ -43,7 +44,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -115,6 +116,8 @@ int main(int argc, char** argv)
 
   /// the Alembic export file
   std::string exportAlembicFile = "trackedcameras.abc";
+  /// the binary export file, written frame by frame
+  std::string exportBinaryFile = "";
 
   std::size_t numCameras = 0;
   po::options_description allParams("This program is used to localize a camera rig composed of internally calibrated cameras");
@@ -195,6 +198,9 @@ int main(int argc, char** argv)
           "Filename for the SfMData export file (where camera poses will be stored). "
           "Default : trackedcameras.abc.")
 #endif
+      ("outputBinary", po::value<std::string>(&exportBinaryFile)->default_value(exportBinaryFile),
+          "Filename for the localization results (raw data) in binary, "
+          "the results of the cameras of each frame are appended as soon as it is localized")
           ;
 
   allParams.add(inputParams).add(outputParams).add(commonParams).add(voctreeParams);
@@ -375,6 +381,11 @@ int main(int argc, char** argv)
 
   // store the result
   std::vector< std::vector<localization::LocalizationResult> > rigResultPerFrame;
+
+  // one record per camera and frame, the result of the camera c for the frame f is the record f * numCameras + c
+  std::unique_ptr<localization::LocalizationResultWriter> binaryWriter;
+  if(!exportBinaryFile.empty())
+    binaryWriter.reset(new localization::LocalizationResultWriter(exportBinaryFile));
   
   while(haveImage)
   {
@@ -441,6 +452,12 @@ int main(int argc, char** argv)
     stats(detect_elapsed.count());
     
     rigResultPerFrame.push_back(localizationResults);
+
+    if(binaryWriter)
+    {
+      for(std::size_t camIDX = 0; camIDX < numCameras; ++camIDX)
+        binaryWriter->append((camIDX < localizationResults.size()) ? localizationResults[camIDX] : localization::LocalizationResult());
+    }
     
     if(isLocalized)
     {
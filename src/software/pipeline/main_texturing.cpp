@@ -6,6 +6,7 @@
 
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Telemetry.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsData/image.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
@@ -65,6 +66,8 @@ int main(int argc, char* argv[])
             "Output texture size")
         ("downscale", po::value<unsigned int>(&texParams.downscale)->default_value(texParams.downscale),
             "Texture downscale factor")
+        ("nbLods", po::value<unsigned int>(&texParams.nbLods)->default_value(texParams.nbLods),
+            "Number of additional downscaled textures (each one half the size of the previous one) written in the same pass.")
         ("unwrapMethod", po::value<std::string>(&unwrapMethod)->default_value(unwrapMethod),
             "Method to unwrap input mesh if it does not have UV coordinates.\n"
             " * Basic (> 600k faces) fast and simple. Can generate multiple atlases.\n"
@@ -74,8 +77,13 @@ int main(int argc, char* argv[])
             "Fill texture holes with plausible values.")
         ("padding", po::value<unsigned int>(&texParams.padding)->default_value(texParams.padding),
             "Texture edge padding size in pixel")
+        ("nbParallelAtlases", po::value<unsigned int>(&texParams.nbParallelAtlases)->default_value(texParams.nbParallelAtlases),
+            "Max number of texture atlases generated at the same time (each source image is decoded once for all of them). "
+            "0 to deduce it from the free memory.")
+        ("useCuda", po::value<bool>(&texParams.useCuda)->default_value(texParams.useCuda),
+            "Rasterize the triangles and sample the images on the GPU if a CUDA device is available.")
         ("inputMesh", po::value<std::string>(&inputMeshFilepath),
-            "Optional input mesh to texture. By default, it will texture the inputReconstructionMesh.")
+            "Optional input mesh to texture (OBJ, PLY or BIN file format). By default, it will texture the inputReconstructionMesh.")
         ("flipNormals", po::value<bool>(&flipNormals)->default_value(flipNormals),
             "Option to flip face normals. It can be needed as it depends on the vertices order in triangles and the convention change from one software to another.");
 
@@ -119,6 +127,8 @@ int main(int argc, char* argv[])
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
 
+    system::StageTelemetry telemetry("texturing");
+
     // set output texture file type
     const EImageFileType outputTextureFileType = EImageFileType_stringToEnum(outTextureFileTypeName);
 
@@ -154,6 +164,9 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Generate textures.");
     mesh.generateTextures(mp, outputFolder, outputTextureFileType);
 
+    telemetry.setNbItems(mesh._atlases.size(), "textures");
+    telemetry.write();
+
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
     return EXIT_SUCCESS;
 }
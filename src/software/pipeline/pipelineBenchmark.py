@@ -0,0 +1,204 @@
+#!/usr/bin/env python
+# This file is part of the AliceVision project.
+# Copyright (c) 2019 AliceVision contributors.
+# This Source Code Form is subject to the terms of the Mozilla Public License,
+# v. 2.0. If a copy of the MPL was not distributed with this file,
+# You can obtain one at https://mozilla.org/MPL/2.0/.
+
+"""
+Run the photogrammetry pipeline on a set of images and report the resources used by each stage.
+
+The instrumented softwares (featureExtraction, featureMatching, incrementalSfM, depthMapEstimation,
+meshing, texturing) append their telemetry (see aliceVision/system/Telemetry.hpp) to the file given
+by the ALICEVISION_TELEMETRY_FILE environment variable. This script runs the pipeline with this
+variable set, then writes a JSON report with one entry per stage and prints a summary.
+
+Example:
+  python pipelineBenchmark.py --binFolder <install>/bin --output /tmp/benchmark
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+SRC_FOLDER = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+DEFAULT_IMAGE_FOLDER = os.path.join(SRC_FOLDER, 'samples', 'imageData', 'sceauxCastle')
+DEFAULT_SENSOR_DATABASE = os.path.join(SRC_FOLDER, 'aliceVision', 'sensorDB', 'sensor_width_camera_database.txt')
+
+
+def getPipelineCommands(args):
+    """Return the list of (stage name, command line) of the pipeline."""
+    out = lambda *path: os.path.join(args.output, *path)
+    ini = out('prepareDenseScene', 'mvs.ini')
+
+    commands = [
+        ('cameraInit', ['aliceVision_cameraInit',
+                        '--imageFolder', args.imageFolder,
+                        '--sensorDatabase', args.sensorDatabase,
+                        '--output', out('cameraInit.sfm')]),
+        ('featureExtraction', ['aliceVision_featureExtraction',
+                               '--input', out('cameraInit.sfm'),
+                               '--output', out('features')]),
+        ('featureMatching', ['aliceVision_featureMatching',
+                             '--input', out('cameraInit.sfm'),
+                             '--featuresFolders', out('features'),
+                             '--output', out('matches')]),
+        ('incrementalSfM', ['aliceVision_incrementalSfM',
+                            '--input', out('cameraInit.sfm'),
+                            '--featuresFolders', out('features'),
+                            '--matchesFolders', out('matches'),
+                            '--output', out('sfm', 'sfm.sfm')]),
+    ]
+
+    if args.sfmOnly:
+        return commands
+
+    commands += [
+        ('prepareDenseScene', ['aliceVision_prepareDenseScene',
+                               '--input', out('sfm', 'sfm.sfm'),
+                               '--output', out('prepareDenseScene')]),
+        ('cameraConnection', ['aliceVision_cameraConnection',
+                              '--ini', ini]),
+        ('depthMapEstimation', ['aliceVision_depthMapEstimation',
+                                '--ini', ini,
+                                '--output', out('depthMap')]),
+        ('depthMapFiltering', ['aliceVision_depthMapFiltering',
+                               '--ini', ini,
+                               '--depthMapFolder', out('depthMap'),
+                               '--output', out('depthMapFilter')]),
+        ('meshing', ['aliceVision_meshing',
+                     '--ini', ini,
+                     '--depthMapFolder', out('depthMap'),
+                     '--depthMapFilterFolder', out('depthMapFilter'),
+                     '--output', out('meshing', 'mesh.obj')]),
+        ('texturing', ['aliceVision_texturing',
+                       '--ini', ini,
+                       '--inputDenseReconstruction', out('meshing', 'denseReconstruction.bin'),
+                       '--output', out('texturing')]),
+    ]
+    return commands
+
+
+def readTelemetry(filepath):
+    """Read the telemetry file and merge the reports of each stage (a stage may run in several chunks)."""
+    stages = {}
+    if not os.path.isfile(filepath):
+        return stages
+
+    with open(filepath) as telemetryFile:
+        for line in telemetryFile:
+            line = line.strip()
+            if not line:
+                continue
+            report = json.loads(line)
+            stage = stages.setdefault(report['stage'], {
+                'version': report['version'],
+                'nbRuns': 0,
+                'wallTime': 0.0,
+                'cpuTime': 0.0,
+                'peakRss': 0,
+                'gpuPeakMemory': 0,
+                'readBytes': 0,
+                'writtenBytes': 0,
+                'nbItems': 0,
+                'itemsName': report['itemsName'],
+            })
+            stage['nbRuns'] += 1
+            for key in ('wallTime', 'cpuTime', 'readBytes', 'writtenBytes', 'nbItems'):
+                stage[key] += report[key]
+            for key in ('peakRss', 'gpuPeakMemory'):
+                stage[key] = max(stage[key], report[key])
+
+    for stage in stages.values():
+        stage['itemsPerSecond'] = stage['nbItems'] / stage['wallTime'] if stage['wallTime'] > 0 else 0.0
+    return stages
+
+
+def printSummary(report):
+    mb = 1024.0 * 1024.0
+    print('-' * 118)
+    print('{:<20}{:>12}{:>12}{:>14}{:>14}{:>14}{:>14}{:>18}'.format(
+        'Stage', 'Wall (s)', 'CPU (s)', 'Peak RSS (MB)', 'GPU (MB)', 'Read (MB)', 'Written (MB)', 'Items/s'))
+    print('-' * 118)
+    for stage in report['stages']:
+        if 'telemetry' not in stage:
+            print('{:<20}{:>12.2f}{:>86}'.format(stage['name'], stage['processTime'], '(no telemetry)'))
+            continue
+        t = stage['telemetry']
+        print('{:<20}{:>12.2f}{:>12.2f}{:>14.1f}{:>14.1f}{:>14.1f}{:>14.1f}{:>18}'.format(
+            stage['name'], t['wallTime'], t['cpuTime'], t['peakRss'] / mb, t['gpuPeakMemory'] / mb,
+            t['readBytes'] / mb, t['writtenBytes'] / mb,
+            '{:.2f} {}'.format(t['itemsPerSecond'], t['itemsName'])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pipeline performance benchmark with per-stage telemetry.')
+    parser.add_argument('--binFolder', default='',
+                        help='Folder of the AliceVision softwares (default: use the PATH).')
+    parser.add_argument('--imageFolder', default=DEFAULT_IMAGE_FOLDER,
+                        help='Input images folder (default: samples/imageData/sceauxCastle).')
+    parser.add_argument('--sensorDatabase', default=DEFAULT_SENSOR_DATABASE,
+                        help='Camera sensor width database path.')
+    parser.add_argument('--output', required=True,
+                        help='Output folder for the intermediate results and the report.')
+    parser.add_argument('--report', default='',
+                        help='Output report file (default: <output>/benchmarkReport.json).')
+    parser.add_argument('--sfmOnly', action='store_true',
+                        help='Stop after the structure from motion (no CUDA required).')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.output):
+        os.makedirs(args.output)
+
+    telemetryFilepath = os.path.join(args.output, 'telemetry.jsonl')
+    if os.path.exists(telemetryFilepath):
+        os.remove(telemetryFilepath)
+
+    env = dict(os.environ)
+    env['ALICEVISION_TELEMETRY_FILE'] = telemetryFilepath
+
+    processTimes = []
+    failedStage = None
+    for stageName, command in getPipelineCommands(args):
+        command[0] = os.path.join(args.binFolder, command[0]) if args.binFolder else command[0]
+        print('[{}] {}'.format(stageName, ' '.join(command)))
+        start = time.time()
+        returnCode = subprocess.call(command, env=env)
+        processTimes.append((stageName, time.time() - start))
+        if returnCode != 0:
+            failedStage = stageName
+            print('Stage {} failed with code {}.'.format(stageName, returnCode), file=sys.stderr)
+            break
+
+    telemetry = readTelemetry(telemetryFilepath)
+
+    report = {
+        'dataset': os.path.abspath(args.imageFolder),
+        'nbImages': len([f for f in os.listdir(args.imageFolder) if f.lower().endswith(('.jpg', '.jpeg', '.png', '.tif', '.tiff'))]),
+        'date': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'failedStage': failedStage,
+        'stages': [],
+    }
+    for stageName, processTime in processTimes:
+        stage = {'name': stageName, 'processTime': processTime}
+        if stageName in telemetry:
+            stage['telemetry'] = telemetry[stageName]
+        report['stages'].append(stage)
+
+    reportFilepath = args.report or os.path.join(args.output, 'benchmarkReport.json')
+    with open(reportFilepath, 'w') as reportFile:
+        json.dump(report, reportFile, indent=2, sort_keys=True)
+
+    printSummary(report)
+    print('Report written: ' + reportFilepath)
+
+    return 1 if failedStage else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -5,6 +5,7 @@
 
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/utils/marginalCovariance.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/config.hpp>
 
@@ -32,6 +33,9 @@ int main(int argc, char **argv)
   std::string outputStats;
   std::string algorithm = cov::EAlgorithm_enumToString(cov::eAlgorithmSvdTaylorExpansion);
   bool debug = false;
+  bool sparseMarginals = true;
+  bool computeLandmarksUncertainty = true;
+  std::vector<IndexT> landmarkIds;
 
   po::options_description params("AliceVision Uncertainty");
   params.add_options()
@@ -42,7 +46,14 @@ int main(int argc, char **argv)
   ("outputCov,c", po::value<std::string>(&outputStats),
     "Output covariances file.")
   ("algorithm,a", po::value<std::string>(&algorithm)->default_value(algorithm),
-    "Algorithm.")
+    "Algorithm (uncertaintyTE).")
+  ("sparseMarginals", po::value<bool>(&sparseMarginals)->default_value(sparseMarginals),
+    "Compute only the marginal covariance blocks of the poses and the landmarks on the reduced camera system, in parallel, "
+    "instead of the uncertaintyTE covariance of the whole problem.")
+  ("computeLandmarksUncertainty", po::value<bool>(&computeLandmarksUncertainty)->default_value(computeLandmarksUncertainty),
+    "Compute the uncertainty of the landmarks (sparseMarginals only).")
+  ("landmarks", po::value<std::vector<IndexT>>(&landmarkIds)->multitoken(),
+    "Ids of the landmarks to compute the uncertainty of, all the landmarks if empty (sparseMarginals only).")
   ("debug,d", po::value<bool>(&debug)->default_value(debug),
     "Enable creation of debug files in the current folder.")
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
@@ -100,6 +111,73 @@ int main(int argc, char **argv)
     bundleAdjustmentObj.createJacobian(sfmData, refineOptions, jacobian);
   }
 
+  if(sparseMarginals)
+  {
+    // Pose & landmark order of the Jacobian
+    std::vector<geometry::Pose3> poses;
+    poses.reserve(sfmData.getPoses().size());
+    for(const auto& poseIt : sfmData.getPoses())
+      poses.push_back(poseIt.second.getTransform());
+
+    std::map<IndexT, std::size_t> landmarkIndexPerId;
+    for(const auto& landmarkIt : sfmData.getLandmarks())
+      landmarkIndexPerId.emplace(landmarkIt.first, landmarkIndexPerId.size());
+
+    const Eigen::Map<const sRMat> jacobianMap(jacobian.num_rows, jacobian.num_cols, jacobian.values.size(),
+                                              jacobian.rows.data(), jacobian.cols.data(), jacobian.values.data());
+
+    const MarginalCovariance marginalCovariance(sRMat(jacobianMap), poses.size(), landmarkIndexPerId.size(), poses);
+    if(!marginalCovariance.isValid())
+    {
+      ALICEVISION_LOG_ERROR("Unable to compute the marginal covariances.");
+      return EXIT_FAILURE;
+    }
+
+    {
+      std::vector<Mat6, Eigen::aligned_allocator<Mat6>> poseCovariances;
+      marginalCovariance.computePoseCovariances(poseCovariances);
+
+      std::size_t indexPose = 0;
+      for (Poses::const_iterator itPose = sfmData.getPoses().begin(); itPose != sfmData.getPoses().end(); ++itPose, ++indexPose)
+      {
+        const IndexT idPose = itPose->first;
+        sfmData._posesUncertainty[idPose] = Eigen::SelfAdjointEigenSolver<Mat6>(poseCovariances[indexPose], Eigen::EigenvaluesOnly).eigenvalues();
+      }
+    }
+
+    if(computeLandmarksUncertainty)
+    {
+      if(landmarkIds.empty())
+      {
+        for(const auto& landmarkIt : landmarkIndexPerId)
+          landmarkIds.push_back(landmarkIt.first);
+      }
+
+      std::vector<std::size_t> landmarkIndexes;
+      landmarkIndexes.reserve(landmarkIds.size());
+      for(const IndexT landmarkId : landmarkIds)
+      {
+        const auto landmarkIt = landmarkIndexPerId.find(landmarkId);
+        if(landmarkIt == landmarkIndexPerId.end())
+        {
+          ALICEVISION_LOG_ERROR("Unknown landmark id: " << landmarkId);
+          return EXIT_FAILURE;
+        }
+        landmarkIndexes.push_back(landmarkIt->second);
+      }
+
+      std::vector<Mat3> landmarkCovariances;
+      std::vector<bool> validLandmarks;
+      marginalCovariance.computeLandmarkCovariances(landmarkIndexes, landmarkCovariances, validLandmarks);
+
+      for(std::size_t i = 0; i < landmarkIds.size(); ++i)
+      {
+        if(validLandmarks[i])
+          sfmData._landmarksUncertainty[landmarkIds[i]] = Eigen::SelfAdjointEigenSolver<Mat3>(landmarkCovariances[i], Eigen::EigenvaluesOnly).eigenvalues();
+      }
+    }
+  }
+  else
   {
     cov::Options options;
     // Configure covariance engine (find the indexes of the most distatnt points etc.)
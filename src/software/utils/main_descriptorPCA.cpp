@@ -0,0 +1,236 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/sfm/sfmDataIO.hpp>
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/feature/DescriptorPCA.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/matching/RegionsMatcher.hpp>
+#include <aliceVision/matching/matcherType.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+int main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::vector<std::string> featuresFolders;
+  std::string outputFilename;
+  std::string inputPCAFilename;
+  std::string describerTypeName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  std::size_t maxNbViews = 100;
+  std::size_t maxNbDescriptors = 100000;
+  std::size_t nbEvaluationPairs = 20;
+  std::string matcherTypeName = matching::EMatcherType_enumToString(matching::BRUTE_FORCE_L2);
+  float distRatio = 0.8f;
+
+  po::options_description allParams(
+    "Learn a PCA basis reducing the descriptors to 64 dimensions on 8 bits (see featureMatching --descriptorPCA)\n"
+    "and measure the recall of the matches with the reduced descriptors, against the matches with the full ones.\n"
+    "AliceVision descriptorPCA");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file.")
+    ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken()->required(),
+      "Path to folder(s) containing the extracted features.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("output,o", po::value<std::string>(&outputFilename)->default_value(outputFilename),
+      "Output PCA basis file.")
+    ("inputPCA", po::value<std::string>(&inputPCAFilename)->default_value(inputPCAFilename),
+      "Existing PCA basis file: only evaluated, not learned.")
+    ("describerTypes,d", po::value<std::string>(&describerTypeName)->default_value(describerTypeName),
+      feature::EImageDescriberType_informations().c_str())
+    ("maxNbViews", po::value<std::size_t>(&maxNbViews)->default_value(maxNbViews),
+      "Max. number of views loaded, evenly sampled in the views of the SfMData.")
+    ("maxNbDescriptors", po::value<std::size_t>(&maxNbDescriptors)->default_value(maxNbDescriptors),
+      "Max. number of descriptors used to learn the PCA basis.")
+    ("nbEvaluationPairs", po::value<std::size_t>(&nbEvaluationPairs)->default_value(nbEvaluationPairs),
+      "Number of pairs of consecutive loaded views matched to measure the recall (0: no evaluation).")
+    ("photometricMatchingMethod,p", po::value<std::string>(&matcherTypeName)->default_value(matcherTypeName),
+      "Matcher used for the evaluation: BRUTE_FORCE_L2, ANN_L2, CASCADE_HASHING_L2.")
+    ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
+      "Distance ratio to discard non meaningful matches.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(outputFilename.empty() && inputPCAFilename.empty())
+  {
+    ALICEVISION_LOG_ERROR("Nothing to do: set an output file to learn a PCA basis, or an input PCA basis to evaluate.");
+    return EXIT_FAILURE;
+  }
+
+  sfm::SfMData sfmData;
+  if(!sfm::Load(sfmData, sfmDataFilename, sfm::ESfMData(sfm::VIEWS|sfm::INTRINSICS)))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" << sfmDataFilename << "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  const feature::EImageDescriberType describerType = feature::EImageDescriberType_stringToEnum(describerTypeName);
+
+  // evenly sample the views
+  std::vector<IndexT> viewIds;
+  for(const auto& viewPair : sfmData.getViews())
+    viewIds.push_back(viewPair.first);
+
+  if(viewIds.empty())
+  {
+    ALICEVISION_LOG_ERROR("No view in '" << sfmDataFilename << "'.");
+    return EXIT_FAILURE;
+  }
+
+  std::vector<IndexT> selectedViewIds;
+  const std::size_t nbSelectedViews = std::min(viewIds.size(), std::max<std::size_t>(maxNbViews, 1));
+  for(std::size_t i = 0; i < nbSelectedViews; ++i)
+    selectedViewIds.push_back(viewIds.at(i * viewIds.size() / nbSelectedViews));
+
+  feature::RegionsPerView regionsPerView;
+  if(!sfm::loadRegionsPerView(regionsPerView, sfmData, featuresFolders, {describerType},
+                              std::set<IndexT>(selectedViewIds.begin(), selectedViewIds.end())))
+  {
+    ALICEVISION_LOG_ERROR("Invalid regions in '" << sfmDataFilename << "'.");
+    return EXIT_FAILURE;
+  }
+
+  feature::DescriptorPCA descriptorPCA;
+  try
+  {
+    if(inputPCAFilename.empty())
+    {
+      std::vector<const feature::Regions*> regions;
+      for(const IndexT viewId : selectedViewIds)
+        regions.push_back(&regionsPerView.getRegions(viewId, describerType));
+
+      descriptorPCA.learn(regions, maxNbDescriptors);
+    }
+    else
+    {
+      descriptorPCA.load(inputPCAFilename);
+    }
+
+    if(!outputFilename.empty())
+      descriptorPCA.save(outputFilename);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+    return EXIT_FAILURE;
+  }
+
+  const std::size_t fullByteSize = regionsPerView.getRegions(selectedViewIds.front(), describerType).DescriptorByteSize();
+
+  ALICEVISION_LOG_INFO("Descriptor PCA: " << descriptorPCA.descriptorLength() << " -> " << feature::DescriptorPCA::reducedLength << " dimensions" << std::endl
+                       << "\t- explained variance: " << descriptorPCA.getExplainedVariance() << std::endl
+                       << "\t- descriptor size: " << fullByteSize << " -> " << feature::DescriptorPCA::reducedLength << " bytes");
+
+  // recall of the matches of consecutive views
+  const matching::EMatcherType matcherType = matching::EMatcherType_stringToEnum(matcherTypeName);
+  const std::size_t nbPairs = std::min(nbEvaluationPairs, selectedViewIds.size() - 1);
+
+  std::size_t nbFullMatches = 0;
+  std::size_t nbReducedMatches = 0;
+  std::size_t nbCommonMatches = 0;
+
+  for(std::size_t p = 0; p < nbPairs; ++p)
+  {
+    const feature::Regions& regionsI = regionsPerView.getRegions(selectedViewIds.at(p), describerType);
+    const feature::Regions& regionsJ = regionsPerView.getRegions(selectedViewIds.at(p + 1), describerType);
+    if(regionsI.RegionCount() == 0 || regionsJ.RegionCount() == 0)
+      continue;
+
+    matching::IndMatches fullMatches;
+    matching::DistanceRatioMatch(distRatio, matcherType, regionsI, regionsJ, fullMatches);
+
+    const std::unique_ptr<feature::Regions> reducedI = descriptorPCA.project(regionsI);
+    const std::unique_ptr<feature::Regions> reducedJ = descriptorPCA.project(regionsJ);
+
+    matching::IndMatches reducedMatches;
+    matching::DistanceRatioMatch(distRatio, matcherType, *reducedI, *reducedJ, reducedMatches);
+
+    const std::set<matching::IndMatch> fullMatchesSet(fullMatches.begin(), fullMatches.end());
+    std::size_t nbCommon = 0;
+    for(const matching::IndMatch& match : reducedMatches)
+      nbCommon += fullMatchesSet.count(match);
+
+    ALICEVISION_LOG_DEBUG("Pair (" << selectedViewIds.at(p) << ", " << selectedViewIds.at(p + 1) << "): "
+                          << fullMatches.size() << " full matches, " << reducedMatches.size() << " reduced matches, " << nbCommon << " common.");
+
+    nbFullMatches += fullMatches.size();
+    nbReducedMatches += reducedMatches.size();
+    nbCommonMatches += nbCommon;
+  }
+
+  if(nbPairs > 0)
+  {
+    ALICEVISION_LOG_INFO("Evaluation on " << nbPairs << " pairs:" << std::endl
+                         << "\t- matches with the full descriptors: " << nbFullMatches << std::endl
+                         << "\t- matches with the reduced descriptors: " << nbReducedMatches << std::endl
+                         << "\t- recall: " << (nbFullMatches > 0 ? double(nbCommonMatches) / nbFullMatches : 0.0) << std::endl
+                         << "\t- precision: " << (nbReducedMatches > 0 ? double(nbCommonMatches) / nbReducedMatches : 0.0));
+  }
+
+  return EXIT_SUCCESS;
+}
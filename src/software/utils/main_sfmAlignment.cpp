@@ -12,19 +12,60 @@
 
 #include <boost/program_options.hpp>
 
+#include <algorithm>
+#include <stdexcept>
 #include <string>
 #include <sstream>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::sfm;
 
 namespace po = boost::program_options;
 
+/**
+ * @brief Alignment method enum
+ */
+enum class EAlignmentMethod: unsigned char
+{
+  FROM_CAMERAS = 0
+  , FROM_LANDMARKS
+};
+
+/**
+ * @brief Convert an EAlignmentMethod enum to its corresponding string
+ * @param[in] alignmentMethod The given EAlignmentMethod enum
+ * @return string
+ */
+std::string EAlignmentMethod_enumToString(EAlignmentMethod alignmentMethod)
+{
+  switch(alignmentMethod)
+  {
+    case EAlignmentMethod::FROM_CAMERAS:   return "from_cameras";
+    case EAlignmentMethod::FROM_LANDMARKS: return "from_landmarks";
+  }
+  throw std::out_of_range("Invalid EAlignmentMethod enum");
+}
+
+/**
+ * @brief Convert a string to its corresponding EAlignmentMethod enum
+ * @param[in] alignmentMethod The given string
+ * @return EAlignmentMethod enum
+ */
+EAlignmentMethod EAlignmentMethod_stringToEnum(const std::string& alignmentMethod)
+{
+  std::string method = alignmentMethod;
+  std::transform(method.begin(), method.end(), method.begin(), ::tolower); //tolower
+
+  if(method == "from_cameras")   return EAlignmentMethod::FROM_CAMERAS;
+  if(method == "from_landmarks") return EAlignmentMethod::FROM_LANDMARKS;
+  throw std::out_of_range("Invalid SfM alignment method : " + alignmentMethod);
+}
+
 int main(int argc, char **argv)
 {
   // command-line parameters
@@ -33,6 +74,8 @@ int main(int argc, char **argv)
   std::string sfmDataFilename;
   std::string outSfMDataFilename;
   std::string sfmDataReferenceFilename;
+  std::string alignmentMethodName = EAlignmentMethod_enumToString(EAlignmentMethod::FROM_CAMERAS);
+  std::size_t maxNbLandmarks = 100000;
 
   po::options_description allParams("AliceVision sfmAlignment");
 
@@ -45,12 +88,21 @@ int main(int argc, char **argv)
     ("reference,r", po::value<std::string>(&sfmDataReferenceFilename)->required(),
       "Path to the scene used as the reference coordinate system.");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("method", po::value<std::string>(&alignmentMethodName)->default_value(alignmentMethodName),
+      "Alignment method:\n"
+      "* from_cameras: the camera centers of the common views\n"
+      "* from_landmarks: the landmarks with the same id in both scenes")
+    ("maxNbLandmarks", po::value<std::size_t>(&maxNbLandmarks)->default_value(maxNbLandmarks),
+      "Max. number of common landmarks used for the robust estimation ('from_landmarks' method).");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal,  error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -104,7 +156,17 @@ int main(int argc, char **argv)
   double S;
   Mat3 R;
   Vec3 t;
-  bool hasValidSimilarity = computeSimilarity(sfmDataIn, sfmDataInRef, &S, &R, &t);
+  bool hasValidSimilarity = false;
+
+  switch(EAlignmentMethod_stringToEnum(alignmentMethodName))
+  {
+    case EAlignmentMethod::FROM_CAMERAS:
+      hasValidSimilarity = computeSimilarity(sfmDataIn, sfmDataInRef, &S, &R, &t);
+      break;
+    case EAlignmentMethod::FROM_LANDMARKS:
+      hasValidSimilarity = computeSimilarityFromCommonLandmarks(sfmDataIn, sfmDataInRef, &S, &R, &t, maxNbLandmarks);
+      break;
+  }
 
   if(!hasValidSimilarity)
   {
@@ -9,19 +9,25 @@
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 #include <aliceVision/feature/feature.hpp>
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/dataio/ImageFeed.hpp>
+#include <aliceVision/localization/LandmarksDatabase.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
+#include <mutex>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::sfm;
@@ -30,11 +36,98 @@ using namespace std;
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
 
+/**
+ * @brief Build the retrieval database of the localizer from the representative landmark
+ * descriptors of a landmarks database, the database is created from the features if needed.
+ */
+bool initFromLandmarksDatabase(sfm::SfMLocalizationSingle3DTrackObservationDatabase& localizer,
+                               const SfMData& sfmData,
+                               const std::vector<std::string>& featuresFolders,
+                               feature::EImageDescriberType describerType,
+                               const feature::ImageDescriber& imageDescriber,
+                               const std::string& landmarksDatabaseFolder)
+{
+  const std::string databasePath = localization::getLandmarksDatabasePath(landmarksDatabaseFolder, describerType);
+
+  if(!fs::exists(databasePath))
+  {
+    ALICEVISION_LOG_INFO("Create the landmarks database: " << databasePath);
+
+    feature::RegionsPerView regionsPerView;
+    if(!sfm::loadRegionsPerView(regionsPerView, sfmData, featuresFolders, {describerType}))
+    {
+      ALICEVISION_LOG_ERROR("Invalid regions.");
+      return false;
+    }
+
+    // the reconstructed regions of each view
+    std::map<IndexT, std::vector<feature::FeatureInImage>> featuresInImagePerView;
+    for(const auto& landmark : sfmData.getLandmarks())
+    {
+      if(landmark.second.descType != describerType)
+        continue;
+      for(const auto& observation : landmark.second.observations)
+        featuresInImagePerView[observation.first].emplace_back(observation.second.id_feat, landmark.first);
+    }
+
+    feature::RegionsPerView reconstructedRegionsPerView;
+    localization::ReconstructedRegionsMappingPerView mappingPerView;
+    for(auto& featuresInImage : featuresInImagePerView)
+    {
+      if(!regionsPerView.viewExist(featuresInImage.first))
+        continue;
+      std::sort(featuresInImage.second.begin(), featuresInImage.second.end());
+      localization::ReconstructedRegionsMapping& mapping = mappingPerView[featuresInImage.first][describerType];
+      std::unique_ptr<feature::Regions> regions = localization::createFilteredRegions(
+            regionsPerView.getRegions(featuresInImage.first, describerType), featuresInImage.second, mapping);
+      reconstructedRegionsPerView.addRegions(featuresInImage.first, describerType, regions.release());
+    }
+
+    if(!fs::exists(landmarksDatabaseFolder))
+      fs::create_directories(landmarksDatabaseFolder);
+    localization::saveLandmarksDatabase(databasePath, describerType, reconstructedRegionsPerView, mappingPerView);
+  }
+
+  const localization::LandmarksDatabaseReader reader(databasePath);
+  if(reader.getDescriberType() != describerType)
+  {
+    ALICEVISION_LOG_ERROR("The landmarks database '" << databasePath << "' has an invalid describer type.");
+    return false;
+  }
+
+  const std::size_t nbLandmarks = reader.getNbLandmarks();
+  std::unique_ptr<feature::Regions> landmarksDescriptors;
+  imageDescriber.allocate(landmarksDescriptors);
+
+  // only the descriptors are used for the matching, the features are left empty
+  const std::vector<char> features(nbLandmarks * landmarksDescriptors->FeatureByteSize(), 0);
+  landmarksDescriptors->setRawData(nbLandmarks, features.data(), reader.getDescriptorsData());
+
+  const std::uint32_t* landmarkIds = reader.getLandmarkIds();
+  return localizer.Init(sfmData, std::move(landmarksDescriptors), std::vector<IndexT>(landmarkIds, landmarkIds + nbLandmarks));
+}
+
+/**
+ * @brief Escape a string for a JSON value
+ */
+std::string jsonEscape(const std::string& str)
+{
+  std::string escaped;
+  escaped.reserve(str.size());
+  for(const char c : str)
+  {
+    if(c == '"' || c == '\\')
+      escaped.push_back('\\');
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+
 // Image localization API sample:
-// - Allow to locate an image to an existing SfM_reconstruction
+// - Allow to locate images to an existing SfM_reconstruction
 //   if 3D-2D matches are found
-// - A demonstration mode (default):
-//   - try to locate all the view of the SfM_Data reconstruction
+// - The retrieval database is built once, the query images are localized in parallel
+//   and the results are written as soon as each image is processed
 int main(int argc, char **argv)
 {
   // command-line parameters
@@ -43,12 +136,13 @@ int main(int argc, char **argv)
   std::string sfmDataFilename;
   std::vector<std::string> featuresFolders;
   std::string outputFolder;
-  std::string queryImage;
+  std::vector<std::string> queryImages;
 
   // user optional parameters
 
   std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
   double maxResidualError = std::numeric_limits<double>::infinity();
+  std::string landmarksDatabaseFolder;
 
   po::options_description allParams(
     "Image localization in an existing SfM reconstruction\n"
@@ -62,15 +156,18 @@ int main(int argc, char **argv)
       "Output path.")
     ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken()->required(),
       "Path to folder(s) containing the extracted features.")
-    ("queryImage", po::value<std::string>(&queryImage)->required(),
-      "Path to the image that must be localized.");
+    ("queryImage", po::value<std::vector<std::string>>(&queryImages)->multitoken()->required(),
+      "Path(s) to the image(s) that must be localized or to folder(s) of images.");
 
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
     ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
       feature::EImageDescriberType_informations().c_str())
     ("maxResidualError", po::value<double>(&maxResidualError)->default_value(maxResidualError),
-      "Upper bound of the residual error tolerance.");
+      "Upper bound of the residual error tolerance.")
+    ("landmarksDatabase", po::value<std::string>(&landmarksDatabaseFolder)->default_value(landmarksDatabaseFolder),
+      "Folder of the landmarks database. The representative descriptors of the landmarks are used for the matching. "
+      "If the database of the describer type doesn't exist, it is created from the features.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -137,97 +234,191 @@ int main(int argc, char **argv)
   // Get imageDecriber fom type
   std::unique_ptr<ImageDescriber> imageDescribers = createImageDescriber(describerType);
 
-  // Load the SfM_Data region's views
+  if(outputFolder.empty())
+  {
+    ALICEVISION_LOG_ERROR("It is an invalid output folder");
+    return EXIT_FAILURE;
+  }
+
+  if(!fs::exists(outputFolder))
+    fs::create_directory(outputFolder);
+
+  // the query images, the folders are expanded
+  std::vector<std::string> queryImagePaths;
+  for(const std::string& queryImage : queryImages)
+  {
+    if(!fs::is_directory(queryImage))
+    {
+      queryImagePaths.push_back(queryImage);
+      continue;
+    }
+    std::vector<std::string> folderImages;
+    for(fs::directory_iterator it(queryImage); it != fs::directory_iterator(); ++it)
+    {
+      if(fs::is_regular_file(it->status()) && dataio::ImageFeed::isSupported(it->path().extension().string()))
+        folderImages.push_back(it->path().string());
+    }
+    std::sort(folderImages.begin(), folderImages.end());
+    queryImagePaths.insert(queryImagePaths.end(), folderImages.begin(), folderImages.end());
+  }
+
   //-
   //-- Localization
-  // - init the retrieval database
-  // - Go along the sfm_data view
-  // - extract the regions of the view
-  // - try to locate the image
+  // - init the retrieval database (once for all the query images)
+  // - for each query image in parallel:
+  //   - extract the regions of the image
+  //   - try to locate the image
+  //   - write the result
   //-
+  system::Timer timer;
   sfm::SfMLocalizationSingle3DTrackObservationDatabase localizer;
+  if(!landmarksDatabaseFolder.empty())
   {
-    RegionsPerView regionsPerView;
-    if (!sfm::loadRegionsPerView(regionsPerView, sfmData, featuresFolders, {describerType}))
+    if(!initFromLandmarksDatabase(localizer, sfmData, featuresFolders, describerType, *imageDescribers, landmarksDatabaseFolder))
     {
-      ALICEVISION_LOG_ERROR("Invalid regions.");
+      ALICEVISION_LOG_ERROR("Cannot initialize the SfM localizer");
       return EXIT_FAILURE;
     }
-
-    if (outputFolder.empty())
+  }
+  else
+  {
+    RegionsPerView regionsPerView;
+    if(!sfm::loadRegionsPerView(regionsPerView, sfmData, featuresFolders, {describerType}))
     {
-      ALICEVISION_LOG_ERROR("It is an invalid output folder");
+      ALICEVISION_LOG_ERROR("Invalid regions.");
       return EXIT_FAILURE;
     }
 
-    if (!fs::exists(outputFolder))
-      fs::create_directory(outputFolder);
-    
-    if(!localizer.Init(sfmData, regionsPerView))
+    // the descriptors are copied in the retrieval database, the regions can be released
+    if(!localizer.Init(sfmData, regionsPerView, describerType))
     {
       ALICEVISION_LOG_ERROR("Cannot initialize the SfM localizer");
+      return EXIT_FAILURE;
     }
   }
-  
-  std::vector<Vec3> vec_found_poses;
+  ALICEVISION_LOG_INFO("Retrieval database initialized in " << timer.elapsed() << " s");
 
-  ALICEVISION_LOG_INFO("SfM::localization => try with image: " << queryImage);
-  std::unique_ptr<Regions> query_regions;
-  image::Image<unsigned char> imageGray;
+  // the results are appended to the file as soon as an image is processed (one JSON object per line)
+  const std::string resultsFilename = (fs::path(outputFolder) / "localization.jsonl").string();
+  std::ofstream resultsFile(resultsFilename);
+  if(!resultsFile.is_open())
   {
-    image::readImage(queryImage, imageGray);
-
-    // Compute features and descriptors
-    imageDescribers->describe(imageGray, query_regions);
-    ALICEVISION_LOG_INFO("# regions detected in query image: " << query_regions->RegionCount());
+    ALICEVISION_LOG_ERROR("Cannot write the localization results file '" << resultsFilename << "'");
+    return EXIT_FAILURE;
   }
 
-  // Suppose intrinsic as unknown
-  std::shared_ptr<camera::IntrinsicBase> optional_intrinsic (nullptr);
+  std::mutex resultsMutex;
+  std::vector<Vec3> vec_found_poses;
+
+  // per-thread image describers, the retrieval database is shared (read-only)
+  std::vector<std::unique_ptr<ImageDescriber>> threadImageDescribers(omp_get_max_threads());
+  threadImageDescribers.front() = std::move(imageDescribers);
+  for(std::size_t i = 1; i < threadImageDescribers.size(); ++i)
+    threadImageDescribers.at(i) = createImageDescriber(describerType);
 
-  geometry::Pose3 pose;
-  sfm::ImageLocalizerMatchData matching_data;
-  matching_data.error_max = maxResidualError;
+  timer.reset();
 
-  // Try to localize the image in the database thanks to its regions
-  if (!localizer.Localize(
-    Pair(imageGray.Width(), imageGray.Height()),
-    optional_intrinsic.get(),
-    *(query_regions.get()),
-    pose,
-    &matching_data))
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(queryImagePaths.size()); ++i)
   {
-    ALICEVISION_LOG_ERROR("Cannot locate the image");
-  }
-  else
-  {
-    const bool b_new_intrinsic = (optional_intrinsic == nullptr);
-    // A valid pose has been found (try to refine it):
-    // If not intrinsic as input:
-    //  init a new one from the projection matrix decomposition
-    // Else use the existing one and consider as static.
-    if (b_new_intrinsic)
+    const std::string& queryImage = queryImagePaths.at(i);
+    ImageDescriber& imageDescriber = *threadImageDescribers.at(omp_get_thread_num());
+
+    ALICEVISION_LOG_INFO("SfM::localization => try with image: " << queryImage);
+
+    // per-image resection workspace
+    std::unique_ptr<Regions> query_regions;
+    image::Image<unsigned char> imageGray;
+    try
     {
-      // setup a default camera model from the found projection matrix
-      Mat3 K, R;
-      Vec3 t;
-      KRt_From_P(matching_data.projection_matrix, &K, &R, &t);
-
-      const double focal = (K(0,0) + K(1,1))/2.0;
-      const Vec2 principal_point(K(0,2), K(1,2));
-      optional_intrinsic = std::make_shared<camera::PinholeRadialK3>(
-        imageGray.Width(), imageGray.Height(),
-        focal, principal_point(0), principal_point(1));
+      image::readImage(queryImage, imageGray);
+
+      // Compute features and descriptors
+      imageDescriber.describe(imageGray, query_regions);
+      ALICEVISION_LOG_INFO("# regions detected in query image: " << query_regions->RegionCount());
     }
-    sfm::SfMLocalizer::RefinePose
-    (
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Cannot describe the image '" << queryImage << "': " << e.what());
+      continue;
+    }
+
+    // Suppose intrinsic as unknown
+    std::shared_ptr<camera::IntrinsicBase> optional_intrinsic (nullptr);
+
+    geometry::Pose3 pose;
+    sfm::ImageLocalizerMatchData matching_data;
+    matching_data.error_max = maxResidualError;
+
+    // Try to localize the image in the database thanks to its regions
+    const bool localized = localizer.Localize(
+      Pair(imageGray.Width(), imageGray.Height()),
       optional_intrinsic.get(),
-      pose, matching_data,
-      true, b_new_intrinsic
-    );
+      *(query_regions.get()),
+      pose,
+      &matching_data);
 
-    vec_found_poses.push_back(pose.center());
+    if(!localized)
+    {
+      ALICEVISION_LOG_WARNING("Cannot locate the image: " << queryImage);
+    }
+    else
+    {
+      const bool b_new_intrinsic = (optional_intrinsic == nullptr);
+      // A valid pose has been found (try to refine it):
+      // If not intrinsic as input:
+      //  init a new one from the projection matrix decomposition
+      // Else use the existing one and consider as static.
+      if (b_new_intrinsic)
+      {
+        // setup a default camera model from the found projection matrix
+        Mat3 K, R;
+        Vec3 t;
+        KRt_From_P(matching_data.projection_matrix, &K, &R, &t);
+
+        const double focal = (K(0,0) + K(1,1))/2.0;
+        const Vec2 principal_point(K(0,2), K(1,2));
+        optional_intrinsic = std::make_shared<camera::PinholeRadialK3>(
+          imageGray.Width(), imageGray.Height(),
+          focal, principal_point(0), principal_point(1));
+      }
+      sfm::SfMLocalizer::RefinePose
+      (
+        optional_intrinsic.get(),
+        pose, matching_data,
+        true, b_new_intrinsic
+      );
+    }
+
+    std::ostringstream result;
+    result << "{\"image\": \"" << jsonEscape(fs::path(queryImage).generic_string()) << "\", "
+           << "\"localized\": " << (localized ? "true" : "false") << ", "
+           << "\"nbMatches\": " << matching_data.pt2D.cols() << ", "
+           << "\"nbInliers\": " << matching_data.vec_inliers.size();
+    if(localized)
+    {
+      const Vec3 center = pose.center();
+      const Mat3& rotation = pose.rotation();
+      result.precision(17);
+      result << ", \"center\": [" << center(0) << ", " << center(1) << ", " << center(2) << "]"
+             << ", \"rotation\": [";
+      for(int r = 0; r < 3; ++r)
+        for(int c = 0; c < 3; ++c)
+          result << rotation(r, c) << ((r == 2 && c == 2) ? "]" : ", ");
+    }
+    result << "}\n";
+
+    {
+      std::lock_guard<std::mutex> lock(resultsMutex);
+      resultsFile << result.str() << std::flush;
+      if(localized)
+        vec_found_poses.push_back(pose.center());
+    }
   }
+  resultsFile.close();
+
+  ALICEVISION_LOG_INFO("Localized " << vec_found_poses.size() << " / " << queryImagePaths.size()
+                       << " images in " << timer.elapsed() << " s");
 
   // export the found camera position
   const std::string out_file_name = (fs::path(outputFolder) / "found_pose_centers.ply").string();
@@ -253,5 +444,5 @@ int main(int argc, char **argv)
       outfile.close();
     }
   }
-  return EXIT_FAILURE;
+  return EXIT_SUCCESS;
 }
@@ -10,6 +10,7 @@
 #include <aliceVision/image/Sampler.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <dependencies/vectorGraphics/svgDrawer.hpp>
 
@@ -20,6 +21,14 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <iostream>
 #include <iterator>
@@ -177,53 +186,189 @@ bool splitDualFisheye(const std::string& imagePath, const std::string& outputFol
   return true;
 }
 
-bool splitEquirectangular(const std::string& imagePath, const std::string& outputFolder, std::size_t nbSplits, std::size_t splitResolution)
+/**
+ * @brief Precomputed bilinear sampling of the equirectangular image for each pixel of a split image.
+ * It gives the same result as image::Sampler2d<image::SamplerLinear> (up to the rounding of the
+ * fixed-point weights), and is computed once for all the panoramas of the same size.
+ */
+class EquirectangularRemap
 {
-  oiio::ImageBuf inBuffer(imagePath);
+public:
+  EquirectangularRemap(const PinholeCameraR& camera, int splitResolution, int inWidth, int inHeight)
+    : _resolution(splitResolution)
+    , _samples(static_cast<std::size_t>(splitResolution) * splitResolution)
+  {
+    assert(static_cast<std::uint64_t>(inWidth) * inHeight <= std::numeric_limits<std::uint32_t>::max());
 
-  if(!inBuffer.initialized())
-    return false;
+    #pragma omp parallel for
+    for(int j = 0; j < splitResolution; ++j)
+    {
+      for(int i = 0; i < splitResolution; ++i)
+      {
+        const Vec2 pt = SphericalMapping::get2DPoint(camera.getRay(i, j), inWidth, inHeight);
+        initSample(static_cast<float>(pt(0)), static_cast<float>(pt(1)), inWidth, inHeight, _samples[static_cast<std::size_t>(j) * splitResolution + i]);
+      }
+    }
+  }
 
-  const oiio::ImageSpec& inSpec = inBuffer.spec();
+  /**
+   * @brief Sample the equirectangular image for each pixel of the split image
+   * @param[in] source The equirectangular image, of the size given to the constructor
+   * @param[out] output The split image
+   */
+  void apply(const image::Image<image::RGBColor>& source, image::Image<image::RGBColor>& output) const
+  {
+    output.resize(_resolution, _resolution);
+    const unsigned char* sourceData = reinterpret_cast<const unsigned char*>(source.data());
 
-  image::Image<image::RGBColor> imageSource;
-  image::readImage(imagePath, imageSource);
+    #pragma omp parallel for
+    for(int j = 0; j < _resolution; ++j)
+    {
+      const Sample* sample = &_samples[static_cast<std::size_t>(j) * _resolution];
+      unsigned char* outRow = reinterpret_cast<unsigned char*>(&output(j, 0));
 
-  const int inWidth = imageSource.Width();
-  const int inHeight = imageSource.Height();
+      for(int i = 0; i < _resolution; ++i, ++sample)
+      {
+        for(int c = 0; c < 3; ++c)
+        {
+          std::uint32_t value = weightRounding;
+          for(int k = 0; k < 4; ++k)
+            value += sample->weight[k] * sourceData[3 * std::size_t(sample->index[k]) + c];
+          outRow[3 * i + c] = static_cast<unsigned char>(value >> weightBits);
+        }
+      }
+    }
+  }
 
-  std::vector<PinholeCameraR> cameras;
+private:
+  /// fixed-point bilinear weights, their sum is 1 << weightBits (or 0 outside of the image)
+  static const int weightBits = 15;
+  static const std::uint32_t weightRounding = 1u << (weightBits - 1);
 
-  const double twoPi = M_PI * 2.0;
-  const double alpha = twoPi / static_cast<double>(nbSplits);
-  const double focal = focalFromPinholeHeight(inHeight, degreeToRadian(60.0));
+  struct Sample
+  {
+    std::uint32_t index[4];
+    std::uint16_t weight[4];
+  };
 
-  double angle = 0.0;
-  for(std::size_t i = 0; i < nbSplits; ++i)
+  static void initSample(float x, float y, int width, int height, Sample& sample)
   {
-    cameras.emplace_back(focal, splitResolution, splitResolution, RotationAroundY(angle));
-    angle += alpha;
+    const double dx = static_cast<double>(x) - std::floor(x);
+    const double dy = static_cast<double>(y) - std::floor(y);
+    const int gridX = static_cast<int>(std::floor(x));
+    const int gridY = static_cast<int>(std::floor(y));
+    const double coefsX[2] = {1.0 - dx, dx};
+    const double coefsY[2] = {1.0 - dy, dy};
+
+    // same weights as Sampler2d: the neighbors out of the image are ignored
+    double weights[4];
+    double totalWeight = 0.0;
+    for(int k = 0; k < 4; ++k)
+    {
+      const int row = gridY + k / 2;
+      const int col = gridX + k % 2;
+      const bool isInside = (row >= 0 && row < height && col >= 0 && col < width);
+      weights[k] = isInside ? coefsX[k % 2] * coefsY[k / 2] : 0.0;
+      sample.index[k] = isInside ? static_cast<std::uint32_t>(row * width + col) : 0;
+      totalWeight += weights[k];
+    }
+
+    // too unstable, black pixel
+    if(totalWeight <= 0.2)
+    {
+      std::fill(sample.weight, sample.weight + 4, 0);
+      return;
+    }
+
+    // normalized weights, the largest one absorbs the rounding error
+    int total = 0;
+    int largest = 0;
+    for(int k = 0; k < 4; ++k)
+    {
+      sample.weight[k] = static_cast<std::uint16_t>(std::lround(weights[k] / totalWeight * (1 << weightBits)));
+      total += sample.weight[k];
+      if(weights[k] > weights[largest])
+        largest = k;
+    }
+    sample.weight[largest] = static_cast<std::uint16_t>(sample.weight[largest] + (1 << weightBits) - total);
   }
 
-  const image::Sampler2d<image::SamplerLinear> sampler;
-  image::Image<image::RGBColor> imaOut(splitResolution, splitResolution, image::BLACK);
+  int _resolution;
+  std::vector<Sample> _samples;
+};
 
-  size_t index = 0;
-  for(const PinholeCameraR& camera : cameras)
+/**
+ * @brief Split cameras and their remap tables for each panorama size,
+ * shared by the threads splitting the images.
+ */
+class EquirectangularSplitter
+{
+public:
+  struct Split
   {
-    imaOut.fill(image::BLACK);
+    double focal;
+    std::vector<EquirectangularRemap> remaps;
+  };
 
-    // Backward mapping:
-    // - Find for each pixels of the pinhole image where it comes from the panoramic image
-    for(int j = 0; j < splitResolution; ++j)
+  EquirectangularSplitter(std::size_t nbSplits, std::size_t splitResolution)
+    : _nbSplits(nbSplits)
+    , _splitResolution(splitResolution)
+  {}
+
+  std::shared_ptr<const Split> get(int inWidth, int inHeight)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<const Split>& split = _splits[std::make_pair(inWidth, inHeight)];
+    if(!split)
     {
-      for(int i = 0; i < splitResolution; ++i)
+      ALICEVISION_LOG_INFO("Compute the remap tables for the " << inWidth << "x" << inHeight << " images.");
+      std::shared_ptr<Split> newSplit = std::make_shared<Split>();
+      newSplit->focal = focalFromPinholeHeight(inHeight, degreeToRadian(60.0));
+
+      const double twoPi = M_PI * 2.0;
+      const double alpha = twoPi / static_cast<double>(_nbSplits);
+      double angle = 0.0;
+      for(std::size_t i = 0; i < _nbSplits; ++i)
       {
-        const Vec3 ray = camera.getRay(i, j);
-        const Vec2 x = SphericalMapping::get2DPoint(ray, inWidth, inHeight);
-        imaOut(j,i) = sampler(imageSource, x(1), x(0));
+        const PinholeCameraR camera(newSplit->focal, _splitResolution, _splitResolution, RotationAroundY(angle));
+        newSplit->remaps.emplace_back(camera, _splitResolution, inWidth, inHeight);
+        angle += alpha;
       }
+      split = newSplit;
     }
+    return split;
+  }
+
+private:
+  const std::size_t _nbSplits;
+  const std::size_t _splitResolution;
+  std::mutex _mutex;
+  std::map<std::pair<int, int>, std::shared_ptr<const Split>> _splits;
+};
+
+bool splitEquirectangular(const std::string& imagePath, const std::string& outputFolder, EquirectangularSplitter& splitter, std::size_t splitResolution)
+{
+  oiio::ImageBuf inBuffer(imagePath);
+
+  if(!inBuffer.initialized())
+    return false;
+
+  const oiio::ImageSpec& inSpec = inBuffer.spec();
+
+  image::Image<image::RGBColor> imageSource;
+  image::readImage(imagePath, imageSource);
+
+  const std::shared_ptr<const EquirectangularSplitter::Split> split = splitter.get(imageSource.Width(), imageSource.Height());
+
+  image::Image<image::RGBColor> imaOut(splitResolution, splitResolution, image::BLACK);
+
+  size_t index = 0;
+  for(const EquirectangularRemap& remap : split->remaps)
+  {
+    // Backward mapping:
+    // - Find for each pixels of the pinhole image where it comes from the panoramic image
+    remap.apply(imageSource, imaOut);
+
     //-- save image
     const oiio::ImageSpec outSpec(splitResolution, splitResolution, inSpec.nchannels,inSpec.format);
     oiio::ImageBuf outBuffer(outSpec, (void*)imaOut.data());
@@ -233,7 +378,7 @@ bool splitEquirectangular(const std::string& imagePath, const std::string& outpu
     //Override make and model in order to force camera model in SfM
     outMetadataSpec.attribute("Make",  "Custom");
     outMetadataSpec.attribute("Model", "Pinhole");
-    outMetadataSpec.attribute("Exif:FocalLength", static_cast<float>(focal));
+    outMetadataSpec.attribute("Exif:FocalLength", static_cast<float>(split->focal));
 
     boost::filesystem::path path(imagePath);
     outBuffer.write(outputFolder + std::string("/") + path.stem().string() + std::string("_") + std::to_string(index) + path.extension().string());
@@ -450,8 +595,13 @@ int main(int argc, char** argv)
     }
   }
 
-  for(const std::string& imagePath : imagePaths)
+  EquirectangularSplitter equirectangularSplitter(equirectangularNbSplits, equirectangularSplitResolution);
+
+  // the images are split and written in parallel, the remap tables are shared by the threads
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(imagePaths.size()); ++i)
   {
+    const std::string& imagePath = imagePaths[i];
     bool hasCorrectPath = true;
 
     if(splitMode == "equirectangular")
@@ -459,7 +609,7 @@ int main(int argc, char** argv)
       if(equirectangularDemoMode)
         hasCorrectPath = splitEquirectangularDemo(imagePath, outputFolder, equirectangularNbSplits, equirectangularSplitResolution);
       else
-        hasCorrectPath = splitEquirectangular(imagePath, outputFolder, equirectangularNbSplits, equirectangularSplitResolution);
+        hasCorrectPath = splitEquirectangular(imagePath, outputFolder, equirectangularSplitter, equirectangularSplitResolution);
     }
     else if(splitMode == "dualfisheye")
     {
@@ -471,13 +621,16 @@ int main(int argc, char** argv)
     }
 
     if(!hasCorrectPath)
+    {
+      #pragma omp critical(split360BadPaths)
       badPaths.push_back(imagePath);
+    }
   }
 
   if(!badPaths.empty())
   {
     ALICEVISION_LOG_ERROR("Error: Can't open image file(s) below");
-    for(const std::string& imagePath : imagePaths)
+    for(const std::string& imagePath : badPaths)
        ALICEVISION_LOG_ERROR("\t - " << imagePath);
   }
 
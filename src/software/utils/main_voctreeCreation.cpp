@@ -9,6 +9,7 @@
 #include <aliceVision/voctree/VocabularyTree.hpp>
 #include <aliceVision/voctree/descriptorLoader.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -26,7 +27,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 3
 
 static const int DIMENSION = 128;
 
@@ -38,96 +39,36 @@ namespace po = boost::program_options;
 
 typedef aliceVision::feature::Descriptor<float, DIMENSION> DescriptorFloat;
 typedef aliceVision::feature::Descriptor<unsigned char, DIMENSION> DescriptorUChar;
-
-/*
- * This program is used to load the sift descriptors from a list of files and create a vocabulary tree
+/// AKAZE_MLDB binary descriptors (486 bits in 64 bytes), clustered with k-majority
+typedef aliceVision::feature::Descriptor<unsigned char, 64> DescriptorBinary;
+
+/**
+ * @brief Build the vocabulary tree of the descriptors of a describer type, save it with its weights
+ * @tparam DescriptorT The descriptor type of the tree
+ * @tparam DistanceT The distance of the tree (L2 for SIFT, Hamming for the binary descriptors)
+ * @tparam FileDescriptorT The descriptor type of the descriptor files
  */
-int main(int argc, char** argv)
+template<class DescriptorT, template<typename, typename> class DistanceT, class FileDescriptorT>
+int createVoctree(const sfm::SfMData& sfmData,
+                  const std::string& sfmDataFilename,
+                  const std::vector<std::string>& featuresFolders,
+                  feature::EImageDescriberType descType,
+                  std::size_t maxDescriptorsPerImage,
+                  std::uint32_t K,
+                  std::uint32_t LEVELS,
+                  std::uint32_t restart,
+                  std::size_t miniBatchSize,
+                  int tbVerbosity,
+                  const std::string& treeName,
+                  const std::string& weightName,
+                  bool sanityCheck)
 {
-  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
-  int tbVerbosity = 2;
-  std::string weightName;
-  std::string treeName;
-  std::string sfmDataFilename;
-  std::vector<std::string> featuresFolders;
-  std::uint32_t K = 10;
-  std::uint32_t restart = 5;
-  std::uint32_t LEVELS = 6;
-  bool sanityCheck = true;
-
-  po::options_description allParams("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree\n"
-                                    "It takes as input either a list.txt file containing the a simple list of images (bundler format and older AliceVision version format)\n"
-                                    "or a sfm_data file (JSON) containing the list of images. In both cases it is assumed that the .desc to load are in the same folder as the input file\n"
-                                    "AliceVision voctreeCreation");
-
-  po::options_description requiredParams("Required parameters");
-  requiredParams.add_options()
-    ("input,i", po::value<std::string>(&sfmDataFilename)->required(), "a SfMData file.")
-    ("weights,w", po::value<string>(&weightName)->required(), "Output name for the weight file")
-    ("tree,t", po::value<string>(&treeName)->required(), "Output name for the tree file");
-
-  po::options_description optionalParams("Optional parameters");
-  optionalParams.add_options()
-    ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken(),
-      "Path to folder(s) containing the extracted features.")
-    (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
-    ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
-    (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
-    ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
-
-  po::options_description logParams("Log parameters");
-  logParams.add_options()
-    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
-      "verbosity level (fatal, error, warning, info, debug, trace).")
-    ("tbVerbose", po::value<int>(&tbVerbosity)->default_value(tbVerbosity), "Tree builder verbosity level, 3 should be just enough, 0 to mute");
-
-  allParams.add(requiredParams).add(optionalParams).add(logParams);
-
-  po::variables_map vm;
-  try
-  {
-    po::store(po::parse_command_line(argc, argv, allParams), vm);
-
-    if(vm.count("help") || (argc == 1))
-    {
-      ALICEVISION_COUT(allParams);
-      return EXIT_SUCCESS;
-    }
-    po::notify(vm);
-  }
-  catch(boost::program_options::required_option& e)
-  {
-    ALICEVISION_CERR("ERROR: " << e.what());
-    ALICEVISION_COUT("Usage:\n\n" << allParams);
-    return EXIT_FAILURE;
-  }
-  catch(boost::program_options::error& e)
-  {
-    ALICEVISION_CERR("ERROR: " << e.what());
-    ALICEVISION_COUT("Usage:\n\n" << allParams);
-    return EXIT_FAILURE;
-  }
-
-  ALICEVISION_COUT("Program called with the following parameters:");
-  ALICEVISION_COUT(vm);
-
-  // set verbose level
-  system::Logger::get()->setLogLevel(verboseLevel);
-
-  // load SfMData
-  sfm::SfMData sfmData;
-  if(!sfm::Load(sfmData, sfmDataFilename, sfm::ESfMData::ALL))
-  {
-    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
-    return EXIT_FAILURE;
-  }
-
-  std::vector<DescriptorFloat> descriptors;
+  std::vector<DescriptorT> descriptors;
 
   std::vector<size_t> descRead;
   ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
   auto detect_start = std::chrono::steady_clock::now();
-  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorT, FileDescriptorT>(sfmData, featuresFolders, descriptors, descRead, maxDescriptorsPerImage, 0, descType);
   auto detect_end = std::chrono::steady_clock::now();
   auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   if(descriptors.size() == 0)
@@ -140,9 +81,10 @@ int main(int argc, char** argv)
   ALICEVISION_COUT("Reading took " << detect_elapsed.count() << " sec");
 
   // Create tree
-  aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
+  aliceVision::voctree::TreeBuilder<DescriptorT, DistanceT> builder(DescriptorT(0));
   builder.setVerbose(tbVerbosity);
   builder.kmeans().setRestarts(restart);
+  builder.kmeans().setMiniBatchSize(miniBatchSize);
   ALICEVISION_COUT("Building a tree of L=" << LEVELS << " levels with a branching factor of k=" << K);
   detect_start = std::chrono::steady_clock::now();
   builder.build(descriptors, K, LEVELS);
@@ -192,10 +134,7 @@ int main(int argc, char** argv)
   // Add each object (document) to the database
   aliceVision::voctree::Database db(builder.tree().words());
   ALICEVISION_COUT("\tfound " << allSparseHistograms.size() << " documents");
-  for(const auto &doc : allSparseHistograms)
-  {
-    db.insert(doc.first, doc.second);
-  }
+  db.insert(allSparseHistograms);
   ALICEVISION_COUT("Database created!");
 
   // Compute and save the word weights
@@ -258,3 +197,111 @@ int main(int argc, char** argv)
 
   return EXIT_SUCCESS;
 }
+
+/*
+ * This program is used to load the sift descriptors from a list of files and create a vocabulary tree
+ */
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  int tbVerbosity = 2;
+  std::string weightName;
+  std::string treeName;
+  std::string sfmDataFilename;
+  std::vector<std::string> featuresFolders;
+  std::string describerTypeName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  std::uint32_t K = 10;
+  std::uint32_t restart = 5;
+  std::uint32_t LEVELS = 6;
+  std::size_t miniBatchSize = 0;
+  std::size_t maxDescriptorsPerImage = 0;
+  bool sanityCheck = true;
+
+  po::options_description allParams("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree\n"
+                                    "It takes as input either a list.txt file containing the a simple list of images (bundler format and older AliceVision version format)\n"
+                                    "or a sfm_data file (JSON) containing the list of images. In both cases it is assumed that the .desc to load are in the same folder as the input file\n"
+                                    "AliceVision voctreeCreation");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(), "a SfMData file.")
+    ("weights,w", po::value<string>(&weightName)->required(), "Output name for the weight file")
+    ("tree,t", po::value<string>(&treeName)->required(), "Output name for the tree file");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken(),
+      "Path to folder(s) containing the extracted features.")
+    ("describerType,d", po::value<std::string>(&describerTypeName)->default_value(describerTypeName),
+      "Describer type of the descriptors: sift (L2 k-means) or akaze_mldb (binary, Hamming k-majority).")
+    (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
+    ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
+    (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
+    ("miniBatchSize", po::value<std::size_t>(&miniBatchSize)->default_value(miniBatchSize), "Number of descriptors randomly drawn at each kmeans iteration (mini-batch kmeans), 0 to use all the descriptors of the cluster at each iteration")
+    ("maxDescriptorsPerImage", po::value<std::size_t>(&maxDescriptorsPerImage)->default_value(maxDescriptorsPerImage), "Max. number of descriptors randomly drawn in each image to build the tree, to bound the training memory (0: all the descriptors)")
+    ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).")
+    ("tbVerbose", po::value<int>(&tbVerbosity)->default_value(tbVerbosity), "Tree builder verbosity level, 3 should be just enough, 0 to mute");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // load SfMData
+  sfm::SfMData sfmData;
+  if(!sfm::Load(sfmData, sfmDataFilename, sfm::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  const feature::EImageDescriberType descType = feature::EImageDescriberType_stringToEnum(describerTypeName);
+
+  switch(descType)
+  {
+    case feature::EImageDescriberType::SIFT:
+      return createVoctree<DescriptorFloat, aliceVision::voctree::L2, DescriptorUChar>(
+               sfmData, sfmDataFilename, featuresFolders, descType, maxDescriptorsPerImage,
+               K, LEVELS, restart, miniBatchSize, tbVerbosity, treeName, weightName, sanityCheck);
+    case feature::EImageDescriberType::AKAZE_MLDB:
+      return createVoctree<DescriptorBinary, aliceVision::voctree::Hamming, DescriptorBinary>(
+               sfmData, sfmDataFilename, featuresFolders, descType, maxDescriptorsPerImage,
+               K, LEVELS, restart, miniBatchSize, tbVerbosity, treeName, weightName, sanityCheck);
+    default:
+      ALICEVISION_LOG_ERROR("No vocabulary tree for the describer type: " << describerTypeName);
+      return EXIT_FAILURE;
+  }
+}
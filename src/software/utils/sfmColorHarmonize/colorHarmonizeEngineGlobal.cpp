@@ -193,125 +193,86 @@ bool ColorHarmonizationEngineGlobal::Process()
   map_relativeHistograms[1].resize(_pairwiseMatches.size());
   map_relativeHistograms[2].resize(_pairwiseMatches.size());
 
-  for (size_t i = 0; i < _pairwiseMatches.size(); ++i)
-  {
-    matching::PairwiseMatches::const_iterator iter = _pairwiseMatches.begin();
-    std::advance(iter, i);
+  // edges (random access) and edges of each view (edge index, true if the view is the left image of the edge)
+  std::vector<matching::PairwiseMatches::const_iterator> edges;
+  std::map<size_t, std::vector<std::pair<size_t, bool> > > map_viewEdges;
+  edges.reserve(_pairwiseMatches.size());
 
+  for (matching::PairwiseMatches::const_iterator iter = _pairwiseMatches.begin(); iter != _pairwiseMatches.end(); ++iter)
+  {
+    const size_t edgeIndex = edges.size();
     const size_t viewI = iter->first.first;
     const size_t viewJ = iter->first.second;
 
-    //
-    const MatchesPerDescType& matchesPerDesc = iter->second;
-
-    //-- Edges names:
-    std::pair< std::string, std::string > p_imaNames;
-    p_imaNames = make_pair( _fileNames[ viewI ], _fileNames[ viewJ ] );
-    std::cout << "Current edge : "
-      << fs::path(p_imaNames.first).filename().string() << "\t"
-      << fs::path(p_imaNames.second).filename().string() << std::endl;
+    edges.push_back(iter);
+    map_viewEdges[viewI].emplace_back(edgeIndex, true);
+    map_viewEdges[viewJ].emplace_back(edgeIndex, false);
 
-    //-- Compute the masks from the data selection:
-    Image< unsigned char > maskI ( _imageSize[ viewI ].first, _imageSize[ viewI ].second );
-    Image< unsigned char > maskJ ( _imageSize[ viewJ ].first, _imageSize[ viewJ ].second );
-
-    switch(_selectionMethod)
+    for(int channelIndex = 0; channelIndex < 3; ++channelIndex)
     {
-      case eHistogramHarmonizeFullFrame:
-      {
-        colorHarmonization::CommonDataByPair_fullFrame  dataSelector(
-          p_imaNames.first,
-          p_imaNames.second);
-        dataSelector.computeMask( maskI, maskJ );
-      }
-      break;
-      case eHistogramHarmonizeMatchedPoints:
-      {
-        int circleSize = 10;
-        colorHarmonization::CommonDataByPair_matchedPoints dataSelector(
-          p_imaNames.first,
-          p_imaNames.second,
-          matchesPerDesc,
-          _regionsPerView.getRegionsPerDesc(viewI),
-          _regionsPerView.getRegionsPerDesc(viewJ),
-          circleSize);
-        dataSelector.computeMask( maskI, maskJ );
-      }
-      break;
-      case eHistogramHarmonizeVLDSegment:
-      {
-        maskI.fill(0);
-        maskJ.fill(0);
-
-        for(const auto& matchesIt: matchesPerDesc)
-        {
-          const feature::EImageDescriberType descType = matchesIt.first;
-          const IndMatches& matches = matchesIt.second;
-          colorHarmonization::CommonDataByPair_vldSegment dataSelector(
-            p_imaNames.first,
-            p_imaNames.second,
-            matches,
-            feature::getSIOPointFeatures(_regionsPerView.getRegions(viewI, descType)),
-            feature::getSIOPointFeatures(_regionsPerView.getRegions(viewJ, descType)));
-
-          dataSelector.computeMask( maskI, maskJ );
-        }
-      }
-      break;
-      default:
-        std::cout << "Selection method unsupported" << std::endl;
-        return false;
+      relativeColorHistogramEdge & edge = map_relativeHistograms[channelIndex][edgeIndex];
+      edge.I = map_cameraNodeToCameraIndex[viewI];
+      edge.J = map_cameraNodeToCameraIndex[viewJ];
     }
+  }
 
-    //-- Export the masks
-    bool bExportMask = false;
-    if (bExportMask)
+  // Set the RED, GREEN and BLUE histograms of a side of an edge
+  const auto setEdgeHistograms = [&](size_t edgeIndex, bool isLeft,
+                                     const Image< unsigned char >& mask, const Image< RGBColor >& image)
+  {
+    std::vector<size_t> histos[3];
+    colorHarmonization::CommonDataByPair::computeHistoRGB( histos, mask, image );
+    for(int channelIndex = 0; channelIndex < 3; ++channelIndex)
     {
-      string sEdge = _fileNames[ viewI ] + "_" + _fileNames[ viewJ ];
-      sEdge = (fs::path(_outputDirectory) / sEdge ).string();
+      relativeColorHistogramEdge & edge = map_relativeHistograms[channelIndex][edgeIndex];
+      (isLeft ? edge.histoI : edge.histoJ).swap(histos[channelIndex]);
+    }
+  };
 
-      if( !fs::exists(sEdge) )
-        fs::create_directory(sEdge);
+  std::cout << "Compute the histograms of " << edges.size() << " edges" << std::endl;
 
-      string out_filename_I = "00_mask_I.png";
-      out_filename_I = (fs::path(sEdge) / out_filename_I).string();
+  if(_selectionMethod == eHistogramHarmonizeVLDSegment)
+  {
+    // the KVLD selection is costly and computed once per edge: the edges are processed in parallel
+    #pragma omp parallel for schedule(dynamic)
+    for (int edgeIndex = 0; edgeIndex < static_cast<int>(edges.size()); ++edgeIndex)
+    {
+      const size_t viewI = edges[edgeIndex]->first.first;
+      const size_t viewJ = edges[edgeIndex]->first.second;
 
-      string out_filename_J = "00_mask_J.png";
-      out_filename_J = (fs::path(sEdge) / out_filename_J).string();
-      writeImage(out_filename_I, maskI);
-      writeImage(out_filename_J, maskJ);
+      Image< unsigned char > maskI, maskJ;
+      computeMasks(*edges[edgeIndex], maskI, maskJ);
+
+      Image< RGBColor > image;
+      readImage(_fileNames[ viewI ], image);
+      setEdgeHistograms(edgeIndex, true, maskI, image);
+      readImage(_fileNames[ viewJ ], image);
+      setEdgeHistograms(edgeIndex, false, maskJ, image);
     }
+  }
+  else
+  {
+    // the masks are cheap to compute: the views are processed in parallel, each image is read once
+    std::vector<size_t> views;
+    views.reserve(map_viewEdges.size());
+    for(const auto& viewEdgesIt : map_viewEdges)
+      views.push_back(viewEdgesIt.first);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int viewIndex = 0; viewIndex < static_cast<int>(views.size()); ++viewIndex)
+    {
+      const size_t viewId = views[viewIndex];
+
+      Image< RGBColor > image;
+      readImage(_fileNames[ viewId ], image);
 
-    //-- Compute the histograms
-    Image< RGBColor > imageI, imageJ;
-    readImage(p_imaNames.first, imageI);
-    readImage(p_imaNames.second, imageJ);
-
-    Histogram< double > histoI( minvalue, maxvalue, bin);
-    Histogram< double > histoJ( minvalue, maxvalue, bin);
-
-    int channelIndex = 0; // RED channel
-    colorHarmonization::CommonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    colorHarmonization::CommonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeR = map_relativeHistograms[channelIndex][i];
-    edgeR = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[viewI], map_cameraNodeToCameraIndex[viewJ],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 1; // GREEN channel
-    colorHarmonization::CommonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    colorHarmonization::CommonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeG = map_relativeHistograms[channelIndex][i];
-    edgeG = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[viewI], map_cameraNodeToCameraIndex[viewJ],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 2; // BLUE channel
-    colorHarmonization::CommonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    colorHarmonization::CommonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeB = map_relativeHistograms[channelIndex][i];
-    edgeB = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[viewI], map_cameraNodeToCameraIndex[viewJ],
-      histoI.GetHist(), histoJ.GetHist());
+      Image< unsigned char > maskI, maskJ;
+      for(const std::pair<size_t, bool>& viewEdge : map_viewEdges.at(viewId))
+      {
+        computeMasks(*edges[viewEdge.first], maskI, maskJ);
+        setEdgeHistograms(viewEdge.first, viewEdge.second, (viewEdge.second ? maskI : maskJ), image);
+      }
+    }
   }
 
   std::cout << "\n -- \n SOLVE for color consistency with linear programming\n --" << std::endl;
@@ -435,6 +396,65 @@ bool ColorHarmonizationEngineGlobal::Process()
   return true;
 }
 
+bool ColorHarmonizationEngineGlobal::computeMasks(const matching::PairwiseMatches::value_type& pairMatches,
+                                                  image::Image<unsigned char>& maskI,
+                                                  image::Image<unsigned char>& maskJ) const
+{
+  const size_t viewI = pairMatches.first.first;
+  const size_t viewJ = pairMatches.first.second;
+  const MatchesPerDescType& matchesPerDesc = pairMatches.second;
+
+  maskI.resize( _imageSize[ viewI ].first, _imageSize[ viewI ].second );
+  maskJ.resize( _imageSize[ viewJ ].first, _imageSize[ viewJ ].second );
+
+  switch(_selectionMethod)
+  {
+    case eHistogramHarmonizeFullFrame:
+    {
+      colorHarmonization::CommonDataByPair_fullFrame  dataSelector(
+        _fileNames[ viewI ],
+        _fileNames[ viewJ ]);
+      return dataSelector.computeMask( maskI, maskJ );
+    }
+    case eHistogramHarmonizeMatchedPoints:
+    {
+      int circleSize = 10;
+      colorHarmonization::CommonDataByPair_matchedPoints dataSelector(
+        _fileNames[ viewI ],
+        _fileNames[ viewJ ],
+        matchesPerDesc,
+        _regionsPerView.getRegionsPerDesc(viewI),
+        _regionsPerView.getRegionsPerDesc(viewJ),
+        circleSize);
+      return dataSelector.computeMask( maskI, maskJ );
+    }
+    case eHistogramHarmonizeVLDSegment:
+    {
+      maskI.fill(0);
+      maskJ.fill(0);
+
+      bool hasMask = false;
+      for(const auto& matchesIt: matchesPerDesc)
+      {
+        const feature::EImageDescriberType descType = matchesIt.first;
+        const IndMatches& matches = matchesIt.second;
+        colorHarmonization::CommonDataByPair_vldSegment dataSelector(
+          _fileNames[ viewI ],
+          _fileNames[ viewJ ],
+          matches,
+          feature::getSIOPointFeatures(_regionsPerView.getRegions(viewI, descType)),
+          feature::getSIOPointFeatures(_regionsPerView.getRegions(viewJ, descType)));
+
+        hasMask = dataSelector.computeMask( maskI, maskJ ) || hasMask;
+      }
+      return hasMask;
+    }
+    default:
+      std::cout << "Selection method unsupported" << std::endl;
+  }
+  return false;
+}
+
 bool ColorHarmonizationEngineGlobal::ReadInputData()
 {
   if(!fs::is_directory( _outputDirectory))
@@ -10,6 +10,8 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/feature/feature.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/track/Track.hpp>
 
 #include <memory>
@@ -75,6 +77,17 @@ private:
   /// Clean graph
   bool CleanGraph();
 
+  /**
+   * @brief Compute the selection masks of the two images of a pair, depending on the selection method
+   * @param[in] pairMatches the pair and its matches
+   * @param[out] maskI the mask of the left image
+   * @param[out] maskJ the mask of the right image
+   * @return true if the masks are not empty
+   */
+  bool computeMasks(const matching::PairwiseMatches::value_type& pairMatches,
+                    image::Image<unsigned char>& maskI,
+                    image::Image<unsigned char>& maskJ) const;
+
   /// Read input data (point correspondences)
   bool ReadInputData();
 };